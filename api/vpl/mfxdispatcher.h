@@ -79,6 +79,52 @@ mfxConfig MFX_CDECL MFXCreateConfig(mfxLoader loader);
 */
 mfxStatus MFX_CDECL MFXSetConfigFilterProperty(mfxConfig config, const mfxU8* name, mfxVariant value);
 
+MFX_PACK_BEGIN_STRUCT_W_L_TYPE()
+/*! The mfxConfigFilterProperty structure holds a filter property with a name that was already resolved
+    with MFXResolveConfigFilterProperty(). */
+typedef struct {
+    mfxU32     PropertyID;   /*!< Property ID returned by MFXResolveConfigFilterProperty(). */
+    mfxU32     reserved;     /*!< Reserved for future use. */
+    mfxVariant Value;        /*!< Value of the property. */
+} mfxConfigFilterProperty;
+MFX_PACK_END()
+
+/*!
+   @brief Resolves a filter property name, as passed to MFXSetConfigFilterProperty(), to a property ID.
+          The ID may be reused with MFXSetConfigFilterProperties() for any mfxConfig, so that the name string is
+          only parsed once.
+          @note Property IDs are only valid for the dispatcher library that returned them and must not be stored.
+
+   @param[in]  name Name of the parameter (see mfxImplDescription structure and example).
+   @param[out] propertyID Pointer to the property ID.
+   @return
+      MFX_ERR_NONE        The function completed successfully. \n
+      MFX_ERR_NULL_PTR    If name or propertyID is NULL. \n
+      MFX_ERR_NOT_FOUND   If name contains unknown parameter name.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXResolveConfigFilterProperty(const mfxU8* name, mfxU32* propertyID);
+
+/*!
+   @brief Adds several filter properties to the configuration of the loader object in one call.
+          Each property is handled as with MFXSetConfigFilterProperty(), in array order. The list of valid implementations
+          is updated once after all properties are set.
+          @note If an error is returned, properties before the failing one remain set.
+
+   @param[in] config Config handle.
+   @param[in] props Array of properties with IDs returned by MFXResolveConfigFilterProperty().
+   @param[in] numProps Number of entries in props.
+   @return
+      MFX_ERR_NONE        The function completed successfully. \n
+      MFX_ERR_NULL_PTR    If config or props is NULL. \n
+      MFX_ERR_NOT_FOUND   If a property ID is unknown. \n
+      MFX_ERR_UNSUPPORTED If value data type does not equal the parameter with provided ID.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXSetConfigFilterProperties(mfxConfig config, const mfxConfigFilterProperty* props, mfxU32 numProps);
+
 /*!
    @brief Iterates over filtered out implementations to gather their details. This function allocates memory to store
           mfxImplDescription structure instance. Use the MFXDispReleaseImplDescription function to free memory allocated to the mfxImplDescription structure.
@@ -147,6 +193,213 @@ mfxStatus MFX_CDECL MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession* ses
 */
 mfxStatus MFX_CDECL MFXDispReleaseImplDescription(mfxLoader loader, mfxHDL hdl);
 
+/*!
+   @brief
+      Creates a pool of initialized sessions for implementation i. Sessions in the pool are handed
+      out by MFXAcquireSession and returned with MFXReleaseSession, avoiding the cost of
+      MFXCreateSession for every new stream. The pool may be grown by calling this function again.
+      Idle sessions are closed by MFXUnload.
+
+   @param[in] loader      Loader handle.
+   @param[in] i           Index of the implementation.
+   @param[in] numSessions Number of sessions to add to the pool.
+
+   @return
+      MFX_ERR_NONE        The function completed successfully. \n
+      MFX_ERR_NULL_PTR    If loader is NULL. \n
+      MFX_ERR_NOT_FOUND   Provided index is out of possible range. \n
+      Any error returned by MFXCreateSession for the first session which could not be created.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXCreateSessionPool(mfxLoader loader, mfxU32 i, mfxU32 numSessions);
+
+/*!
+   @brief
+      Takes an idle session from the pool of implementation i. If the pool is empty or was not
+      created, a new session is created and will join the pool when released.
+
+   @param[in]  loader  Loader handle.
+   @param[in]  i       Index of the implementation.
+   @param[out] session Pointer to the session handle.
+
+   @return
+      MFX_ERR_NONE        The function completed successfully. \n
+      MFX_ERR_NULL_PTR    If loader or session is NULL. \n
+      MFX_ERR_NOT_FOUND   Provided index is out of possible range.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXAcquireSession(mfxLoader loader, mfxU32 i, mfxSession* session);
+
+/*!
+   @brief
+      Returns a session obtained from MFXAcquireSession to its pool. Any initialized decode, encode
+      or VPP components are closed so the session is ready for the next stream. The application
+      must not use the session after this call.
+
+   @param[in] loader  Loader handle.
+   @param[in] session Session handle.
+
+   @return
+      MFX_ERR_NONE           The function completed successfully. \n
+      MFX_ERR_NULL_PTR       If loader or session is NULL. \n
+      MFX_ERR_INVALID_HANDLE Provided session was not acquired from this loader.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXReleaseSession(mfxLoader loader, mfxSession session);
+
+#define MFX_DISPATCHERTIMING_VERSION MFX_STRUCT_VERSION(1, 0)
+
+MFX_PACK_BEGIN_STRUCT_W_L_TYPE()
+/*! The mfxDispatcherTiming structure reports the time spent by the loader in each startup stage.
+    All times are in microseconds and accumulate over the lifetime of the loader. */
+typedef struct {
+    mfxStructVersion Version;              /*!< Version of the structure. */
+    mfxU16           reserved1;            /*!< Reserved for future use. */
+    mfxU32           NumSearchDirs;        /*!< Number of directories searched for runtime libraries. */
+    mfxU32           NumLibsLoaded;        /*!< Number of runtime libraries opened. */
+    mfxU32           reserved2;            /*!< Reserved for future use. */
+    mfxU64           SearchPathsTime;      /*!< Time spent enumerating search directories. */
+    mfxU64           LoadLibsTime;         /*!< Time spent opening runtime libraries. */
+    mfxU64           QueryCapsTime;        /*!< Time spent querying capabilities of runtime libraries. */
+    mfxU64           UpdateValidImplsTime; /*!< Time spent applying filter properties, including prioritization. */
+    mfxU64           PrioritizeImplsTime;  /*!< Time spent sorting implementations by priority. */
+    mfxU64           CreateSessionTime;    /*!< Time spent creating sessions. */
+    mfxU64           reserved[8];          /*!< Reserved for future use. */
+} mfxDispatcherTiming;
+MFX_PACK_END()
+
+/*!
+   @brief
+      Returns the time spent by the loader in each startup stage. Per-library and per-directory
+      times are printed to the dispatcher log when the ONEVPL_DISPATCHER_LOG environment variable
+      is set to "ON" or "TIMING".
+
+   @param[in]  loader Loader handle.
+   @param[out] timing Pointer to the mfxDispatcherTiming structure.
+
+   @return
+      MFX_ERR_NONE        The function completed successfully. \n
+      MFX_ERR_NULL_PTR    If loader or timing is NULL.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXDispQueryTiming(mfxLoader loader, mfxDispatcherTiming* timing);
+
+/*! The mfxDispatcherStatsFunction enumerator itemizes the session functions counted by
+    MFXDispGetSessionStats. */
+typedef enum {
+    MFX_DISPSTATS_DECODE_FRAME_ASYNC       = 0, /*!< MFXVideoDECODE_DecodeFrameAsync. */
+    MFX_DISPSTATS_ENCODE_FRAME_ASYNC       = 1, /*!< MFXVideoENCODE_EncodeFrameAsync. */
+    MFX_DISPSTATS_RUN_FRAME_VPP_ASYNC      = 2, /*!< MFXVideoVPP_RunFrameVPPAsync. */
+    MFX_DISPSTATS_SYNC_OPERATION           = 3, /*!< MFXVideoCORE_SyncOperation. */
+    MFX_DISPSTATS_GET_SURFACE_FOR_VPP      = 4, /*!< MFXMemory_GetSurfaceForVPP. */
+    MFX_DISPSTATS_GET_SURFACE_FOR_VPP_OUT  = 5, /*!< MFXMemory_GetSurfaceForVPPOut. */
+    MFX_DISPSTATS_GET_SURFACE_FOR_ENCODE   = 6, /*!< MFXMemory_GetSurfaceForEncode. */
+    MFX_DISPSTATS_GET_SURFACE_FOR_DECODE   = 7, /*!< MFXMemory_GetSurfaceForDecode. */
+
+    MFX_DISPSTATS_NUM_FUNCTIONS            = 8  /*!< Number of counted functions. */
+} mfxDispatcherStatsFunction;
+
+#define MFX_DISPSTATS_NUM_BUCKETS 16
+
+MFX_PACK_BEGIN_STRUCT_W_L_TYPE()
+/*! The mfxDispatcherCallStats structure reports the calls made to one session function.
+    Latency bucket 0 counts calls shorter than 1 microsecond, bucket k counts calls taking
+    from 2^(k-1) up to 2^k microseconds, and the last bucket also counts all longer calls. */
+typedef struct {
+    mfxU64 NumCalls;                             /*!< Number of calls. */
+    mfxU64 TotalTime;                            /*!< Cumulative latency of all calls in nanoseconds. */
+    mfxU64 NumDeviceBusy;                        /*!< Number of calls which returned MFX_WRN_DEVICE_BUSY. */
+    mfxU64 NumMoreData;                          /*!< Number of calls which returned MFX_ERR_MORE_DATA. */
+    mfxU64 Histogram[MFX_DISPSTATS_NUM_BUCKETS]; /*!< Number of calls in each latency bucket. */
+    mfxU64 reserved[4];                          /*!< Reserved for future use. */
+} mfxDispatcherCallStats;
+MFX_PACK_END()
+
+#define MFX_DISPATCHERSESSIONSTATS_VERSION MFX_STRUCT_VERSION(1, 0)
+
+MFX_PACK_BEGIN_STRUCT_W_L_TYPE()
+/*! The mfxDispatcherSessionStats structure reports the calls made through the dispatcher to one
+    session since it was created. */
+typedef struct {
+    mfxStructVersion       Version;                            /*!< Version of the structure. */
+    mfxU16                 reserved1;                          /*!< Reserved for future use. */
+    mfxU32                 NumFunctions;                       /*!< Number of valid entries in Calls. */
+    mfxDispatcherCallStats Calls[MFX_DISPSTATS_NUM_FUNCTIONS]; /*!< Statistics indexed by mfxDispatcherStatsFunction. */
+    mfxU64                 reserved[8];                        /*!< Reserved for future use. */
+} mfxDispatcherSessionStats;
+MFX_PACK_END()
+
+/*!
+   @brief
+      Returns the call statistics collected by the dispatcher for a session. Statistics are
+      collected only for sessions created while the ONEVPL_DISPATCHER_SESSION_STATS
+      environment variable is set to "ON".
+
+   @param[in]  session Session handle.
+   @param[out] stats   Pointer to the mfxDispatcherSessionStats structure.
+
+   @return
+      MFX_ERR_NONE           The function completed successfully. \n
+      MFX_ERR_NULL_PTR       If stats is NULL. \n
+      MFX_ERR_INVALID_HANDLE If session is NULL. \n
+      MFX_ERR_UNSUPPORTED    Statistics are not collected for this session.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXDispGetSessionStats(mfxSession session, mfxDispatcherSessionStats* stats);
+
+/*!
+   @brief Callback invoked by the loader when loading started with MFXLoadAsync has finished.
+   @param[in] loader   Loader handle returned by MFXLoadAsync.
+   @param[in] sts      MFX_ERR_NONE if one or more implementations were found, MFX_ERR_NOT_FOUND otherwise.
+   @param[in] userData Pointer passed to MFXLoadAsync.
+
+   The callback is called on the loader's background thread. It may call MFXEnumImplementations
+   and MFXCreateSession but must not call MFXUnload or MFXLoadWait for the same loader.
+
+   @since This type is available since API version 2.8.
+*/
+typedef void(MFX_CDECL* mfxLoadCallback)(mfxLoader loader, mfxStatus sts, mfxHDL userData);
+
+/*!
+   @brief
+      Creates the loader and starts searching for and querying the capabilities of all
+      implementations on a background thread, so that the application can overlap runtime
+      discovery with its own initialization. The application may create configs and set filter
+      properties at any time, but functions which modify or query the loader wait for the
+      background load to finish. Filter properties do not switch the loader to low-latency mode.
+
+   @param[in] callback Function called once loading has finished. Can be equal to NULL.
+   @param[in] userData Pointer passed to callback.
+
+   @return Loader handle or NULL if failed.
+
+   @since This function is available since API version 2.8.
+*/
+mfxLoader MFX_CDECL MFXLoadAsync(mfxLoadCallback callback, mfxHDL userData);
+
+/*!
+   @brief
+      Waits for loading started with MFXLoadAsync to finish. Returns immediately for loaders
+      created with MFXLoad.
+
+   @param[in] loader Loader handle.
+   @param[in] waitMs Maximum time to wait in milliseconds, or MFX_INFINITE.
+
+   @return
+      MFX_ERR_NONE          Loading has finished and one or more implementations were found. \n
+      MFX_ERR_NULL_PTR      If loader is NULL. \n
+      MFX_ERR_NOT_FOUND     Loading has finished and no implementations were found. \n
+      MFX_WRN_IN_EXECUTION  Loading has not finished within waitMs.
+
+   @since This function is available since API version 2.8.
+*/
+mfxStatus MFX_CDECL MFXLoadWait(mfxLoader loader, mfxU32 waitMs);
+
 /* Helper macro definitions to add config filter properties. */
 
 /*! Adds single property of mfxU32 type.
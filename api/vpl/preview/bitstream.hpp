@@ -9,7 +9,10 @@
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <utility>
+#include <vector>
 
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/exception.hpp"
@@ -70,6 +73,22 @@ public:
     /// @brief default ctor
     virtual ~bitstream() {}
 
+protected:
+    /// @brief Constructs bitstream object on top of the given buffer. Buffer ownership is managed by the
+    /// derived class.
+    /// @param[in] codecID codec's fourCC code
+    /// @param[in] data buffer
+    /// @param[in] buffersize buffer size in bytes
+    bitstream(codec_format_fourcc codecID, uint8_t* data, uint32_t buffersize) : bits_() {
+        bits_.TimeStamp       = MFX_TIMESTAMP_UNKNOWN;
+        bits_.DecodeTimeStamp = MFX_TIMESTAMP_UNKNOWN;
+        bits_.Data            = data;
+        bits_.MaxLength       = buffersize;
+        bits_.CodecId         = (uint32_t)codecID;
+    }
+
+public:
+
     /// @brief Reallocs internal buffer with the given buffer size increase value. Valid data is copied into new buffer
     /// @param[in] bufferinc Number of bytes to increase the buffer.
     void realloc(uint32_t bufferinc = buffer_len::DEFAULT_LENGHT) {
@@ -175,40 +194,354 @@ inline std::ostream& operator<<(std::ostream& out, const bitstream& b) {
 /// @brief Defines the circular buffer that holds compressed video data. Used as the input to decoder.
 class bitstream_as_src : public bitstream {
 public:
+    /// @brief Modes of the buffer refill.
+    enum class refill_mode {
+        /// Unconsumed data is moved to the head of the buffer before each refill.
+        compact,
+        /// New data is appended into the free space at the tail of the buffer and unconsumed data is
+        /// consumed in place. Data is moved to the head only when the tail is exhausted and consumer stopped
+        /// taking data, which is the remainder of the frame wrapping around the end of the buffer.
+        wrap
+    };
+
     /// @brief Default ctor
-    bitstream_as_src() : bitstream() {}
+    bitstream_as_src()
+            : bitstream(),
+              own_data_(nullptr),
+              own_max_length_(0),
+              mode_(refill_mode::compact),
+              bytes_moved_(0),
+              last_offset_(0),
+              last_length_(0) {}
     /// @brief Constructs bitstream object with given codec ID and default buffer length
     /// @param[in] codecID codec's fourCC code
-    explicit bitstream_as_src(codec_format_fourcc codecID) : bitstream(codecID) {}
+    /// @param[in] mode Buffer refill mode
+    explicit bitstream_as_src(codec_format_fourcc codecID, refill_mode mode = refill_mode::compact)
+            : bitstream(codecID),
+              own_data_(nullptr),
+              own_max_length_(0),
+              mode_(mode),
+              bytes_moved_(0),
+              last_offset_(0),
+              last_length_(0) {}
     /// @brief Constructs bitstream object with given codec ID and given buffer length
     /// @param[in] codecID codec's fourCC code
     /// @param[in] buffersize circular buffer size in bytes
-    bitstream_as_src(codec_format_fourcc codecID, uint32_t buffersize)
-            : bitstream(codecID, buffersize) {}
+    /// @param[in] mode Buffer refill mode
+    bitstream_as_src(codec_format_fourcc codecID,
+                     uint32_t buffersize,
+                     refill_mode mode = refill_mode::compact)
+            : bitstream(codecID, buffersize),
+              own_data_(nullptr),
+              own_max_length_(0),
+              mode_(mode),
+              bytes_moved_(0),
+              last_offset_(0),
+              last_length_(0) {}
+
+    /// @brief Sets buffer refill mode.
+    /// @param[in] mode Buffer refill mode
+    void set_refill_mode(refill_mode mode) {
+        mode_ = mode;
+    }
+
+    /// @brief Returns buffer refill mode.
+    /// @return Buffer refill mode.
+    refill_mode get_refill_mode() const {
+        return mode_;
+    }
+
+    /// @brief Returns number of bytes moved inside the buffer by refills since construction.
+    /// @return Number of bytes.
+    uint64_t get_bytes_moved() const {
+        return bytes_moved_;
+    }
+
+    /// @brief Points bitstream at the externally owned memory, so data is consumed in place without copy
+    /// into the internal buffer. Memory must stay valid while bitstream refers to it. Internal buffer is kept
+    /// and restored by detach.
+    /// @param[in] ptr Pointer to the first valid byte.
+    /// @param[in] length Length of the valid data in bytes.
+    void attach(const uint8_t* ptr, uint32_t length) {
+        if (!own_data_) {
+            own_data_       = bits_.Data;
+            own_max_length_ = bits_.MaxLength;
+        }
+        // decoder doesn't modify input data
+        bits_.Data       = const_cast<uint8_t*>(ptr);
+        bits_.DataOffset = 0;
+        bits_.DataLength = length;
+        bits_.MaxLength  = length;
+    }
+
+    /// @brief Restores internal buffer after attach. Valid data is dropped.
+    void detach() {
+        if (own_data_) {
+            bits_.Data      = own_data_;
+            bits_.MaxLength = own_max_length_;
+            own_data_       = nullptr;
+            own_max_length_ = 0;
+        }
+        reset();
+    }
+
+    /// @brief Checks if bitstream refers to the external memory.
+    /// @return True if bitstream refers to the external memory.
+    bool is_attached() const {
+        return own_data_ != nullptr;
+    }
 
     /// @brief Stores maximum possible portion of data in the circular buffer. Data is strored after
     /// unused portion of the buffer in the length of avialable space in the buffer.
     /// @param[in] reader source reader callback.
     void pull_in(std::function<uint32_t(uint8_t*, uint32_t, bool&)> reader) {
         bool eosFlag = false;
+        if (is_attached())
+            detach();
+        if (mode_ == refill_mode::wrap) {
+            bool tail_is_full = bits_.DataOffset + bits_.DataLength == bits_.MaxLength;
+            bool consumed     = bits_.DataOffset != last_offset_ || bits_.DataLength != last_length_;
+            if (tail_is_full && consumed && bits_.DataLength) {
+                last_offset_ = bits_.DataOffset;
+                last_length_ = bits_.DataLength;
+                return;
+            }
+            if (tail_is_full)
+                compact();
+        }
+        else {
+            compact();
+        }
+        uint32_t tail = bits_.DataOffset + bits_.DataLength;
+        bits_.DataLength += (uint32_t)reader(bits_.Data + tail, bits_.MaxLength - tail, eosFlag);
+        last_offset_ = bits_.DataOffset;
+        last_length_ = bits_.DataLength;
+        // if(eosFlag) bits_.DataFlag = MFX_BITSTREAM_EOS;
+    }
+
+protected:
+    /// @brief Moves unconsumed data to the head of the buffer.
+    void compact() {
         if (bits_.DataOffset) {
             std::copy(bits_.Data + bits_.DataOffset,
                       bits_.Data + bits_.DataOffset + bits_.DataLength,
                       bits_.Data);
             bits_.DataOffset = 0;
+            bytes_moved_ += bits_.DataLength;
         }
-        bits_.DataLength += (uint32_t)reader(bits_.Data + bits_.DataLength,
-                                             bits_.MaxLength - bits_.DataLength,
-                                             eosFlag);
-        // if(eosFlag) bits_.DataFlag = MFX_BITSTREAM_EOS;
     }
+
+    /// Internal buffer saved while bitstream refers to the external memory.
+    uint8_t* own_data_;
+    /// Length of the saved internal buffer.
+    uint32_t own_max_length_;
+    /// Buffer refill mode.
+    refill_mode mode_;
+    /// Number of bytes moved by refills.
+    uint64_t bytes_moved_;
+    /// Data offset after the last refill.
+    uint32_t last_offset_;
+    /// Data length after the last refill.
+    uint32_t last_length_;
+};
+
+/// @brief Thread safe pool of the fixed size bitstream buffers. Buffers are recycled between output bitstreams
+/// and bitstream payloads, so steady state encoding doesn't allocate and touch fresh buffer for each frame.
+class bitstream_buffer_pool {
+public:
+    /// @brief Constructs pool
+    /// @param[in] capacity Size of each buffer in bytes
+    /// @param[in] max_cached Maximum number of free buffers to keep
+    explicit bitstream_buffer_pool(uint32_t capacity, std::size_t max_cached = 16)
+            : lock_(),
+              buffers_(),
+              capacity_(capacity ? capacity : bitstream::buffer_len::DEFAULT_LENGHT),
+              max_cached_(max_cached) {}
+
+    bitstream_buffer_pool(const bitstream_buffer_pool&)            = delete;
+    bitstream_buffer_pool& operator=(const bitstream_buffer_pool&) = delete;
+
+    /// @brief Dtor. Frees cached buffers.
+    ~bitstream_buffer_pool() {
+        for (auto b : buffers_)
+            delete[] b;
+    }
+
+    /// @brief Provides free buffer of capacity size.
+    /// @return Pointer to the buffer. Must be returned with release.
+    uint8_t* acquire() {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!buffers_.empty()) {
+                uint8_t* b = buffers_.back();
+                buffers_.pop_back();
+                return b;
+            }
+        }
+        return new uint8_t[capacity_];
+    }
+
+    /// @brief Returns buffer to the pool. Buffers of other size are freed.
+    /// @param[in] b Pointer to the buffer
+    /// @param[in] size Size of the buffer in bytes
+    void release(uint8_t* b, uint32_t size) {
+        if (!b)
+            return;
+        if (size == capacity_) {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (buffers_.size() < max_cached_) {
+                buffers_.push_back(b);
+                return;
+            }
+        }
+        delete[] b;
+    }
+
+    /// @brief Provides size of each buffer.
+    /// @return Size in bytes.
+    uint32_t get_capacity() const {
+        return capacity_;
+    }
+
+    /// @brief Provides number of free buffers.
+    /// @return Number of free buffers.
+    std::size_t cached() {
+        std::lock_guard<std::mutex> lock(lock_);
+        return buffers_.size();
+    }
+
+protected:
+    /// Lock for the pool.
+    std::mutex lock_;
+    /// Free buffers.
+    std::vector<uint8_t*> buffers_;
+    /// Size of each buffer.
+    uint32_t capacity_;
+    /// Maximum number of free buffers to keep.
+    std::size_t max_cached_;
+};
+
+/// @brief Move-only handle to the encoded data taken out of the bitstream without copy. Buffer is returned to
+/// the pool when handle is destroyed.
+class bitstream_payload {
+public:
+    /// @brief Default ctor. Creates empty handle.
+    bitstream_payload()
+            : pool_(),
+              buffer_(nullptr),
+              capacity_(0),
+              offset_(0),
+              length_(0),
+              time_stamp_(MFX_TIMESTAMP_UNKNOWN),
+              decode_time_stamp_(MFX_TIMESTAMP_UNKNOWN),
+              frame_type_(0) {}
+
+    /// @brief Constructs handle which owns the buffer
+    /// @param[in] pool Pool to return buffer to. May be empty.
+    /// @param[in] bits Bitstream structure which describes the data in the buffer
+    bitstream_payload(std::shared_ptr<bitstream_buffer_pool> pool, const mfxBitstream& bits)
+            : pool_(std::move(pool)),
+              buffer_(bits.Data),
+              capacity_(bits.MaxLength),
+              offset_(bits.DataOffset),
+              length_(bits.DataLength),
+              time_stamp_(bits.TimeStamp),
+              decode_time_stamp_(bits.DecodeTimeStamp),
+              frame_type_(bits.FrameType) {}
+
+    /// @brief Move ctor
+    /// @param[in] other another object to use as data source
+    bitstream_payload(bitstream_payload&& other) noexcept : bitstream_payload() {
+        swap(other);
+    }
+
+    /// @brief Move operator
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    bitstream_payload& operator=(bitstream_payload&& other) noexcept {
+        bitstream_payload tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    bitstream_payload(const bitstream_payload&)            = delete;
+    bitstream_payload& operator=(const bitstream_payload&) = delete;
+
+    /// @brief Dtor. Returns buffer to the pool.
+    ~bitstream_payload() {
+        if (pool_)
+            pool_->release(buffer_, capacity_);
+        else
+            delete[] buffer_;
+    }
+
+    /// @brief Returns pointer to the first valid byte.
+    /// @return Pointer to the data.
+    const uint8_t* data() const {
+        return buffer_ ? buffer_ + offset_ : nullptr;
+    }
+
+    /// @brief Returns length of the valid data.
+    /// @return Length in bytes.
+    uint32_t size() const {
+        return length_;
+    }
+
+    /// @brief Returns presentation time stamp of the encoded frame.
+    /// @return Time stamp.
+    uint64_t get_TimeStamp() const {
+        return time_stamp_;
+    }
+
+    /// @brief Returns decode time stamp of the encoded frame.
+    /// @return Time stamp.
+    int64_t get_DecodeTimeStamp() const {
+        return decode_time_stamp_;
+    }
+
+    /// @brief Returns frame type of the encoded frame.
+    /// @return Frame type.
+    uint16_t get_FrameType() const {
+        return frame_type_;
+    }
+
+protected:
+    /// @brief Exchanges state with other handle.
+    /// @param[in] other another object
+    void swap(bitstream_payload& other) noexcept {
+        std::swap(pool_, other.pool_);
+        std::swap(buffer_, other.buffer_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(offset_, other.offset_);
+        std::swap(length_, other.length_);
+        std::swap(time_stamp_, other.time_stamp_);
+        std::swap(decode_time_stamp_, other.decode_time_stamp_);
+        std::swap(frame_type_, other.frame_type_);
+    }
+
+    /// Pool to return buffer to.
+    std::shared_ptr<bitstream_buffer_pool> pool_;
+    /// Owned buffer.
+    uint8_t* buffer_;
+    /// Size of the buffer.
+    uint32_t capacity_;
+    /// Offset of the valid data.
+    uint32_t offset_;
+    /// Length of the valid data.
+    uint32_t length_;
+    /// Presentation time stamp.
+    uint64_t time_stamp_;
+    /// Decode time stamp.
+    int64_t decode_time_stamp_;
+    /// Frame type.
+    uint16_t frame_type_;
 };
 
 /// @brief Defines the buffer that holds compressed video data. Used as the output from encoder.
 class bitstream_as_dst : public bitstream {
 public:
     /// @brief Default ctor
-    bitstream_as_dst() : bitstream(), sp_(nullptr), session_(nullptr), valid_(false) {}
+    bitstream_as_dst() : bitstream(), sp_(nullptr), session_(nullptr), valid_(false), pool_() {}
     /// @brief Constructs bitstream object with given codec ID and given buffer length
     /// @param[in] codecID codec's fourCC code
     /// @param[in] buffersize circular buffer size in bytes
@@ -216,7 +549,41 @@ public:
             : bitstream(codecID, buffersize),
               sp_(nullptr),
               session_(nullptr),
-              valid_(false) {}
+              valid_(false),
+              pool_() {}
+    /// @brief Constructs bitstream object with the buffer taken from the pool. Buffer is returned to the pool
+    /// on destruction.
+    /// @param[in] codecID codec's fourCC code
+    /// @param[in] pool Buffer pool
+    bitstream_as_dst(codec_format_fourcc codecID, std::shared_ptr<bitstream_buffer_pool> pool)
+            : bitstream(codecID, pool->acquire(), pool->get_capacity()),
+              sp_(nullptr),
+              session_(nullptr),
+              valid_(false),
+              pool_(std::move(pool)) {}
+
+    bitstream_as_dst(const bitstream_as_dst&)            = delete;
+    bitstream_as_dst& operator=(const bitstream_as_dst&) = delete;
+
+    /// @brief Dtor. Returns buffer to the pool if it was taken from it.
+    virtual ~bitstream_as_dst() {
+        if (pool_)
+            pool_->release(bits_.Data, bits_.MaxLength);
+    }
+
+    /// @brief Waits for the operation completion and moves encoded data out of the bitstream without copy.
+    /// Bitstream continues with the fresh buffer of the same size taken from the pool.
+    /// @return Handle to the encoded data.
+    bitstream_payload take_payload() {
+        wait();
+        bitstream_payload payload(pool_, bits_);
+
+        bits_.Data      = pool_ ? pool_->acquire() : new uint8_t[bits_.MaxLength];
+        bits_.MaxLength = pool_ ? pool_->get_capacity() : bits_.MaxLength;
+        reset();
+        sp_ = nullptr;
+        return payload;
+    }
 
     /// @brief Indefinitely waits for operation completion.
     void wait() {
@@ -295,6 +662,66 @@ protected:
     mfxSession session_;
     /// @todo Remove it nafik.
     bool valid_;
+    /// Pool of the buffers, if any.
+    std::shared_ptr<bitstream_buffer_pool> pool_;
+};
+
+/// @brief Ring of pre-sized output bitstreams. Slots are reused once the caller released all references to
+/// them, so steady state encoding doesn't allocate bitstream buffers. Ring grows if all slots are still in
+/// use.
+class bitstream_ring {
+public:
+    /// @brief Constructs ring with given number of slots
+    /// @param[in] size Initial number of slots
+    /// @param[in] capacity Buffer size of each slot in bytes
+    /// @param[in] codecID codec's fourCC code
+    bitstream_ring(std::size_t size, uint32_t capacity, codec_format_fourcc codecID)
+            : slots_(),
+              next_(0),
+              capacity_(capacity ? capacity : bitstream::buffer_len::DEFAULT_LENGHT),
+              codec_(codecID) {
+        for (std::size_t i = 0; i < size; i++)
+            slots_.push_back(std::make_shared<bitstream_as_dst>(codec_, capacity_));
+    }
+
+    /// @brief Provides next free slot. Slot data is reset.
+    /// @return Shared pointer to the bitstream.
+    std::shared_ptr<bitstream_as_dst> acquire() {
+        for (std::size_t i = 0; i < slots_.size(); i++) {
+            auto& slot = slots_[(next_ + i) % slots_.size()];
+            if (slot.use_count() == 1) {
+                next_ = (next_ + i + 1) % slots_.size();
+                slot->reset();
+                return slot;
+            }
+        }
+
+        slots_.push_back(std::make_shared<bitstream_as_dst>(codec_, capacity_));
+        next_ = 0;
+        return slots_.back();
+    }
+
+    /// @brief Provides number of slots in the ring.
+    /// @return Number of slots.
+    std::size_t size() const {
+        return slots_.size();
+    }
+
+    /// @brief Provides buffer size of each slot.
+    /// @return Buffer size in bytes.
+    uint32_t get_capacity() const {
+        return capacity_;
+    }
+
+protected:
+    /// Slots of the ring.
+    std::vector<std::shared_ptr<bitstream_as_dst>> slots_;
+    /// Index of the slot to check first.
+    std::size_t next_;
+    /// Buffer size of each slot.
+    uint32_t capacity_;
+    /// Codec ID of the slots.
+    codec_format_fourcc codec_;
 };
 
 } // namespace vpl
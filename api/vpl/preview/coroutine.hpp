@@ -0,0 +1,280 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+// Coroutine support requires C++20. Header is empty for older language versions.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+    #include <chrono>
+    #include <coroutine>
+    #include <exception>
+    #include <functional>
+    #include <memory>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+    #include "vpl/preview/defs.hpp"
+    #include "vpl/preview/future.hpp"
+    #include "vpl/preview/session.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Interface of the executor used to resume suspended coroutines. Executor owns the posted tasks and
+/// periodically runs them until each of them reports completion.
+class executor {
+public:
+    /// @brief Default dtor
+    virtual ~executor() {}
+
+    /// @brief Posts task to the executor.
+    /// @param[in] task Task function. Returns true when it is done and must not be called again. Returns false
+    /// when the awaited operation is still in progress.
+    virtual void post(std::function<bool()> task) = 0;
+};
+
+/// @brief Single threaded executor. Runs all posted tasks from the thread which calls run or run_once.
+/// Intended to drive many decode, VPP and encode chains from one event loop. Not thread safe.
+class polling_executor : public executor {
+public:
+    /// @brief Default ctor
+    polling_executor() : tasks_() {}
+
+    /// @brief Posts task to the executor.
+    /// @param[in] task Task function. Returns true when it is done.
+    void post(std::function<bool()> task) override {
+        tasks_.push_back(std::move(task));
+    }
+
+    /// @brief Runs every posted task once. Tasks posted while running are run on the next call.
+    /// @return Number of tasks which are done.
+    std::size_t run_once() {
+        std::vector<std::function<bool()>> tasks;
+        tasks.swap(tasks_);
+
+        std::size_t n_done = 0;
+        for (auto &task : tasks) {
+            if (task())
+                n_done++;
+            else
+                tasks_.push_back(std::move(task));
+        }
+        return n_done;
+    }
+
+    /// @brief Runs posted tasks until all of them are done. Sleeps for the poll period when no task made
+    /// progress to not spin on the busy device.
+    void run() {
+        while (!tasks_.empty()) {
+            if (run_once() == 0)
+                std::this_thread::sleep_for(detail::completion_poll_period);
+        }
+    }
+
+    /// @brief Provides number of tasks which are not done yet.
+    /// @return Number of pending tasks.
+    std::size_t pending() const {
+        return tasks_.size();
+    }
+
+protected:
+    /// Posted tasks.
+    std::vector<std::function<bool()>> tasks_;
+};
+
+/// @brief Awaitable for single processing operation. Submits the operation, suspends the coroutine if the
+/// device is busy or the result is not ready yet and resumes it through the executor once the operation is
+/// completed. Operation is resubmitted while its scheduling status is status::DeviceBusy.
+/// @tparam data frame_surface class or bitstream_as_dst class
+template <typename data>
+class operation_awaiter {
+public:
+    /// @brief Future type produced by the operation.
+    using future_type = future<data>;
+
+    /// @brief Constructs awaitable for the operation which is not submitted yet.
+    /// @param[in] exec Executor to resume coroutine with.
+    /// @param[in] submit Function which submits the operation and returns future object.
+    operation_awaiter(executor &exec, std::function<std::shared_ptr<future_type>()> submit)
+            : exec_(exec),
+              submit_(std::move(submit)),
+              f_(nullptr) {}
+
+    /// @brief Constructs awaitable for already submitted operation.
+    /// @param[in] exec Executor to resume coroutine with.
+    /// @param[in] f Future object of the submitted operation.
+    operation_awaiter(executor &exec, std::shared_ptr<future_type> f)
+            : exec_(exec),
+              submit_(),
+              f_(std::move(f)) {}
+
+    /// @brief Submits operation and checks its completion without blocking.
+    /// @return true if coroutine doesn't need to be suspended.
+    bool await_ready() {
+        return step();
+    }
+
+    /// @brief Suspends coroutine and posts the completion check to the executor.
+    /// @param[in] h Handle of the suspended coroutine.
+    void await_suspend(std::coroutine_handle<> h) {
+        exec_.post([this, h]() {
+            if (!step())
+                return false;
+            h.resume();
+            return true;
+        });
+    }
+
+    /// @brief Provides future object of the completed operation. Check its last scheduling status before
+    /// accessing the data.
+    /// @return Future object.
+    std::shared_ptr<future_type> await_resume() {
+        return f_;
+    }
+
+protected:
+    /// @brief Submits operation if needed and checks its completion.
+    /// @return true if operation is completed.
+    bool step() {
+        if (!f_) {
+            f_ = submit_();
+            if (f_->get_last_schedule_status() == status::DeviceBusy) {
+                f_.reset();
+                return false;
+            }
+        }
+        return f_->poll() != async_op_status::timeout;
+    }
+
+    /// Executor to resume coroutine with.
+    executor &exec_;
+    /// Function to submit the operation.
+    std::function<std::shared_ptr<future_type>()> submit_;
+    /// Future object of the submitted operation.
+    std::shared_ptr<future_type> f_;
+};
+
+/// @brief Coroutine return type for the processing chains driven by the executor. Coroutine starts
+/// immediately and runs until the first suspension. Exception thrown from the coroutine is rethrown by get.
+class task {
+public:
+    /// @brief Coroutine promise.
+    struct promise_type {
+        /// Exception thrown from the coroutine.
+        std::exception_ptr exception_ = nullptr;
+
+        task get_return_object() {
+            return task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() {
+            exception_ = std::current_exception();
+        }
+    };
+
+    /// @brief Move ctor
+    /// @param[in] other another object to use as data source
+    task(task &&other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+
+    task(const task &)            = delete;
+    task &operator=(const task &) = delete;
+
+    /// @brief Dtor. Destroys coroutine state.
+    ~task() {
+        if (h_)
+            h_.destroy();
+    }
+
+    /// @brief Checks if coroutine finished.
+    /// @return true if coroutine finished.
+    bool done() const {
+        return !h_ || h_.done();
+    }
+
+    /// @brief Rethrows exception thrown from the finished coroutine, if any.
+    void get() const {
+        if (h_ && h_.done() && h_.promise().exception_)
+            std::rethrow_exception(h_.promise().exception_);
+    }
+
+protected:
+    /// @brief Ctor
+    /// @param[in] h Coroutine handle.
+    explicit task(std::coroutine_handle<promise_type> h) : h_(h) {}
+
+    /// Coroutine handle.
+    std::coroutine_handle<promise_type> h_;
+};
+
+/// @brief Awaits completion of already submitted operation.
+/// @param[in] exec Executor to resume coroutine with.
+/// @param[in] f Future object of the operation.
+/// @return Awaitable object. co_await returns future object.
+/// @tparam data frame_surface class or bitstream_as_dst class
+template <typename data>
+operation_awaiter<data> async_wait(executor &exec, std::shared_ptr<future<data>> f) {
+    return operation_awaiter<data>(exec, std::move(f));
+}
+
+/// @brief Decodes frame asynchronously.
+/// @param[in] exec Executor to resume coroutine with.
+/// @param[in] s Decode session.
+/// @param[in] list List of extension buffers to attach to bitstream
+/// @return Awaitable object. co_await returns future object with decoded data.
+/// @tparam Reader Type of the bitstream reader.
+template <typename Reader>
+operation_awaiter<std::shared_ptr<frame_surface>> async_decode_frame(executor &exec,
+                                                                     decode_session<Reader> &s,
+                                                                     decoder_process_list list = {}) {
+    return operation_awaiter<std::shared_ptr<frame_surface>>(exec, [&s, list]() {
+        return s.process(list);
+    });
+}
+
+/// @brief Encodes frame asynchronously. Input future object must be completed, for example by awaiting
+/// the previous operation in the chain.
+/// @param[in] exec Executor to resume coroutine with.
+/// @param[in] s Encode session.
+/// @param[in] in_future Future object with the surface from the previous operation.
+/// @param[in] list List of extension buffers to use
+/// @return Awaitable object. co_await returns future object with the bitstream.
+inline operation_awaiter<std::shared_ptr<bitstream_as_dst>> async_encode_frame(
+    executor &exec,
+    encode_session &s,
+    std::shared_ptr<future_surface_t> in_future,
+    encoder_process_list list = {}) {
+    return operation_awaiter<std::shared_ptr<bitstream_as_dst>>(exec, [&s, in_future, list]() {
+        return s.process(in_future, list);
+    });
+}
+
+/// @brief Processes frame asynchronously. Input future object must be completed, for example by awaiting
+/// the previous operation in the chain.
+/// @param[in] exec Executor to resume coroutine with.
+/// @param[in] s VPP session.
+/// @param[in] in_future Future object with the surface from the previous operation.
+/// @return Awaitable object. co_await returns future object with the surface.
+inline operation_awaiter<std::shared_ptr<frame_surface>> async_process(
+    executor &exec,
+    vpp_session &s,
+    std::shared_ptr<future_surface_t> in_future) {
+    return operation_awaiter<std::shared_ptr<frame_surface>>(exec, [&s, in_future]() {
+        return s.process(in_future);
+    });
+}
+
+} // namespace vpl
+} // namespace oneapi
+
+#endif // __cpp_impl_coroutine
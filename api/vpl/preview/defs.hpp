@@ -463,5 +463,48 @@ inline std::ostream &operator<<(std::ostream &out, const implementation_type &r)
     return out;
 }
 
+/// @brief Type of the OS handle used to share surface memory between processes.
+enum class shared_handle_type : uint32_t {
+    none      = 0, ///< Surface isn't shared.
+    dma_buf   = 1, ///< DMA-BUF file descriptors on Linux.
+    nt_handle = 2, ///< Shared NT handle of the D3D11 texture on Windows.
+};
+
+/// @brief Description of the surface memory exported to another process. Structure is trivially
+/// copyable, so it can be sent over any IPC channel. OS handles are valid in the process they were
+/// exported to or duplicated to.
+struct shared_surface_desc {
+    /// Limits of the surface layout.
+    enum : uint32_t {
+        MAX_OBJECTS = 4, ///< Maximum number of memory objects.
+        MAX_PLANES  = 4, ///< Maximum number of planes.
+    };
+
+    /// @brief Memory object backing one or several planes.
+    struct object {
+        int64_t handle;    ///< File descriptor or NT handle value.
+        uint64_t size;     ///< Size of the object in bytes. 0 if unknown.
+        uint64_t modifier; ///< DRM format modifier. 0 for NT handles.
+    };
+
+    /// @brief Plane layout inside the memory object.
+    struct plane {
+        uint32_t object_index; ///< Index of the memory object.
+        uint32_t offset;       ///< Offset of the plane in bytes.
+        uint32_t pitch;        ///< Pitch of the plane in bytes.
+    };
+
+    uint64_t id;                 ///< Exporter assigned ID to report surface release with.
+    shared_handle_type type;     ///< Type of the handles.
+    uint32_t fourcc;             ///< Color format in the form of MFX_FOURCC_ code.
+    uint32_t drm_format;         ///< DRM format code. 0 for NT handles.
+    uint32_t width;              ///< Width in pixels.
+    uint32_t height;             ///< Height in pixels.
+    uint32_t num_objects;        ///< Number of valid memory objects.
+    object objects[MAX_OBJECTS]; ///< Memory objects.
+    uint32_t num_planes;         ///< Number of valid planes.
+    plane planes[MAX_PLANES];    ///< Planes.
+};
+
 } // namespace vpl
 } // namespace oneapi
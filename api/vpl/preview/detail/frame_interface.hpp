@@ -10,6 +10,23 @@
 
 #include "vpl/mfxvideo.h"
 
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/video_param.hpp"
+
+#include "vpl/preview/detail/sdk_callable.hpp"
+
+#if defined(_WIN32)
+    #include <d3d11.h>
+    #include <dxgi1_2.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifdef LIBVA_SUPPORT
+    #include "va/va.h"
+    #include "va/va_drmcommon.h"
+#endif
+
 namespace oneapi {
 namespace vpl {
 namespace detail {
@@ -146,6 +163,137 @@ inline auto alloc_bgra(const frame_info& info, mfxFrameSurface1* data) {
     return deleter_B;
 }
 
+/// @brief Closes OS handles of the exported surface memory.
+/// @param[inout] desc Description of the exported surface. Number of objects is set to 0 on output.
+inline void close_shared_handles(shared_surface_desc& desc) {
+    for (uint32_t i = 0; i < desc.num_objects; i++) {
+#if defined(_WIN32)
+        if (desc.type == shared_handle_type::nt_handle)
+            CloseHandle(reinterpret_cast<HANDLE>(desc.objects[i].handle));
+#else
+        if (desc.type == shared_handle_type::dma_buf)
+            close(static_cast<int>(desc.objects[i].handle));
+#endif
+    }
+    desc.num_objects = 0;
+}
+
+#ifdef LIBVA_SUPPORT
+/// @brief Exports VA surface as DMA-BUF file descriptors with composed layers layout.
+/// @param[in] dpy VA display the surface belongs to.
+/// @param[in] id VA surface ID.
+/// @param[out] desc Description of the exported surface.
+/// @return MFX_ERR_NONE on success.
+inline mfxStatus export_va_surface(VADisplay dpy, VASurfaceID id, shared_surface_desc& desc) {
+    if (VA_STATUS_SUCCESS != vaSyncSurface(dpy, id))
+        return MFX_ERR_DEVICE_FAILED;
+
+    VADRMPRIMESurfaceDescriptor prime = {};
+    if (VA_STATUS_SUCCESS !=
+        vaExportSurfaceHandle(dpy,
+                              id,
+                              VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                              VA_EXPORT_SURFACE_READ_ONLY | VA_EXPORT_SURFACE_COMPOSED_LAYERS,
+                              &prime))
+        return MFX_ERR_UNSUPPORTED;
+
+    desc.type        = shared_handle_type::dma_buf;
+    desc.num_objects = prime.num_objects;
+    for (uint32_t i = 0; i < prime.num_objects; i++)
+        desc.objects[i].handle = prime.objects[i].fd;
+
+    if (prime.num_objects > shared_surface_desc::MAX_OBJECTS ||
+        prime.layers[0].num_planes > shared_surface_desc::MAX_PLANES) {
+        close_shared_handles(desc);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    desc.drm_format = prime.layers[0].drm_format;
+    desc.width      = prime.width;
+    desc.height     = prime.height;
+    for (uint32_t i = 0; i < prime.num_objects; i++) {
+        desc.objects[i].size     = prime.objects[i].size;
+        desc.objects[i].modifier = prime.objects[i].drm_format_modifier;
+    }
+    desc.num_planes = prime.layers[0].num_planes;
+    for (uint32_t i = 0; i < desc.num_planes; i++) {
+        desc.planes[i].object_index = prime.layers[0].object_index[i];
+        desc.planes[i].offset       = prime.layers[0].offset[i];
+        desc.planes[i].pitch        = prime.layers[0].pitch[i];
+    }
+    return MFX_ERR_NONE;
+}
+#endif
+
+#if defined(_WIN32)
+/// @brief Exports D3D11 texture as shared NT handle. Texture must be created with
+/// D3D11_RESOURCE_MISC_SHARED_NTHANDLE flag.
+/// @param[in] texture D3D11 texture.
+/// @param[out] desc Description of the exported surface.
+/// @return MFX_ERR_NONE on success.
+inline mfxStatus export_d3d11_texture(ID3D11Texture2D* texture, shared_surface_desc& desc) {
+    IDXGIResource1* resource = nullptr;
+    if (FAILED(texture->QueryInterface(__uuidof(IDXGIResource1), (void**)&resource)))
+        return MFX_ERR_UNSUPPORTED;
+
+    HANDLE handle = nullptr;
+    HRESULT hr    = resource->CreateSharedHandle(nullptr,
+                                              DXGI_SHARED_RESOURCE_READ,
+                                              nullptr,
+                                              &handle);
+    resource->Release();
+    if (FAILED(hr))
+        return MFX_ERR_UNSUPPORTED;
+
+    D3D11_TEXTURE2D_DESC td = {};
+    texture->GetDesc(&td);
+
+    desc.type                = shared_handle_type::nt_handle;
+    desc.drm_format          = 0;
+    desc.width               = td.Width;
+    desc.height              = td.Height;
+    desc.num_objects         = 1;
+    desc.objects[0].handle   = reinterpret_cast<int64_t>(handle);
+    desc.objects[0].size     = 0;
+    desc.objects[0].modifier = 0;
+    desc.num_planes          = 1;
+    desc.planes[0]           = { 0, 0, 0 };
+    return MFX_ERR_NONE;
+}
+#endif
+
+/// @brief Exports video memory of the surface via its frame interface. Surface must be
+/// synchronized.
+/// @param[in] surface Surface allocated in video memory.
+/// @param[out] desc Description of the exported surface.
+/// @return MFX_ERR_NONE on success, MFX_ERR_UNSUPPORTED if memory type can't be shared.
+inline mfxStatus export_surface(mfxFrameSurface1* surface, shared_surface_desc& desc) {
+    mfxHDL resource      = nullptr;
+    mfxResourceType type = MFX_RESOURCE_SYSTEM_SURFACE;
+    mfxStatus sts        = surface->FrameInterface->GetNativeHandle(surface, &resource, &type);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    mfxHDL device             = nullptr;
+    mfxHandleType device_type = MFX_HANDLE_VA_DISPLAY;
+    sts = surface->FrameInterface->GetDeviceHandle(surface, &device, &device_type);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    desc.fourcc = surface->Info.FourCC;
+#ifdef LIBVA_SUPPORT
+    if (type == MFX_RESOURCE_VA_SURFACE_PTR && device_type == MFX_HANDLE_VA_DISPLAY)
+        return export_va_surface(reinterpret_cast<VADisplay>(device),
+                                 *reinterpret_cast<VASurfaceID*>(resource),
+                                 desc);
+#endif
+#if defined(_WIN32)
+    if (type == MFX_RESOURCE_DX11_TEXTURE)
+        return export_d3d11_texture(reinterpret_cast<ID3D11Texture2D*>(resource), desc);
+#endif
+    return MFX_ERR_UNSUPPORTED;
+}
+
 } // namespace detail
 } // namespace vpl
 } // namespace oneapi
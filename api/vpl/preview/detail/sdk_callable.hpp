@@ -20,6 +20,8 @@ namespace detail {
 struct sdk_c_api {
     /// @brief MFXVideo***_Query function
     std::function<mfxStatus(mfxSession, mfxVideoParam*, mfxVideoParam*)> query;
+    /// @brief MFXVideo***_QueryIOSurf function
+    std::function<mfxStatus(mfxSession, mfxVideoParam*, mfxFrameAllocRequest*)> query_iosurf;
     /// @brief MFXVideo***_Init function
     std::function<mfxStatus(mfxSession, mfxVideoParam*)> init;
     /// @brief MFXVideo***_Reset function
@@ -33,18 +35,21 @@ struct sdk_c_api {
 template <class T = void>
 struct CAPI {
     static inline sdk_c_api Decoder = { MFXVideoDECODE_Query,
+                                        MFXVideoDECODE_QueryIOSurf,
                                         MFXVideoDECODE_Init,
                                         MFXVideoDECODE_Reset,
                                         MFXVideoDECODE_GetVideoParam,
                                         MFXVideoDECODE_Close };
 
     static inline sdk_c_api Encoder = { MFXVideoENCODE_Query,
+                                        MFXVideoENCODE_QueryIOSurf,
                                         MFXVideoENCODE_Init,
                                         MFXVideoENCODE_Reset,
                                         MFXVideoENCODE_GetVideoParam,
                                         MFXVideoENCODE_Close };
 
     static inline sdk_c_api VPP = { MFXVideoVPP_Query,
+                                    MFXVideoVPP_QueryIOSurf,
                                     MFXVideoVPP_Init,
                                     MFXVideoVPP_Reset,
                                     MFXVideoVPP_GetVideoParam,
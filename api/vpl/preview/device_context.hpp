@@ -0,0 +1,184 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "vpl/mfxvideo.h"
+
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/exception.hpp"
+
+#include "vpl/preview/detail/sdk_callable.hpp"
+
+#ifdef LIBVA_SUPPORT
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include "va/va.h"
+    #include "va/va_drm.h"
+#endif
+
+#if defined(_WIN32)
+    #include <d3d11.h>
+    #include <dxgi.h>
+#endif
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Holds native device handle shared by several sessions. Sessions constructed with the same
+/// context use one VADisplay or D3D11 device, so surfaces allocated by one of them can be passed to
+/// another one without cross device copies. Each session keeps shared ownership of the context, so
+/// the device is released after the last session which uses it is closed.
+class device_context {
+public:
+    /// @brief Wraps device handle owned by the application. Handle must stay valid while any session
+    /// bound to this context exists.
+    /// @param[in] type Type of the handle.
+    /// @param[in] handle Native device handle.
+    device_context(handle_type type, void *handle) : type_(type), handle_(handle), release_() {}
+
+    device_context(const device_context &)            = delete;
+    device_context &operator=(const device_context &) = delete;
+
+    /// @brief Dtor. Releases the device if it was created by this object.
+    ~device_context() {
+        if (release_)
+            release_(handle_);
+    }
+
+    /// @brief Provides type of the native device handle.
+    /// @return Type of the handle.
+    handle_type get_type() const {
+        return type_;
+    }
+
+    /// @brief Provides native device handle.
+    /// @return Native device handle.
+    void *get_handle() const {
+        return handle_;
+    }
+
+    /// @brief Sets device handle to the session. Must be called before any session component
+    /// is initialized.
+    /// @param[in] session Session handle.
+    /// @return Ok or warning.
+    status bind(mfxSession session) const {
+        detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoCORE_SetHandle,
+                                session,
+                                (mfxHandleType)type_,
+                                handle_);
+        return (status)e.sts_;
+    }
+
+#ifdef LIBVA_SUPPORT
+    /// @brief Opens DRM render node and creates VADisplay on top of it.
+    /// @param[in] path Path to the DRM render node.
+    /// @return Shared pointer to the context owning the display.
+    static std::shared_ptr<device_context> create_va_display(
+        const std::string &path = "/dev/dri/renderD128") {
+        int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0)
+            throw file_exception(std::string("Couldn't open ") + path);
+
+        VADisplay va_dpy = vaGetDisplayDRM(fd);
+        int major = 0, minor = 0;
+        if (!va_dpy || VA_STATUS_SUCCESS != vaInitialize(va_dpy, &major, &minor)) {
+            close(fd);
+            throw base_exception("VADisplay initialization failed", MFX_ERR_DEVICE_FAILED);
+        }
+
+        return std::shared_ptr<device_context>(
+            new device_context(handle_type::va_display, va_dpy, [fd](void *handle) {
+                vaTerminate((VADisplay)handle);
+                close(fd);
+            }));
+    }
+#endif
+
+#if defined(_WIN32)
+    /// @brief Creates D3D11 device with video support on the given adapter. Device is multithread
+    /// protected, as it is used by several sessions concurrently.
+    /// @param[in] adapter Index of the DXGI adapter.
+    /// @return Shared pointer to the context owning the device.
+    static std::shared_ptr<device_context> create_d3d11_device(uint32_t adapter = 0) {
+        IDXGIFactory1 *factory = nullptr;
+        if (FAILED(CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void **)&factory)))
+            throw base_exception("CreateDXGIFactory1 failed", MFX_ERR_DEVICE_FAILED);
+
+        IDXGIAdapter1 *dxgi_adapter = nullptr;
+        HRESULT hr                  = factory->EnumAdapters1(adapter, &dxgi_adapter);
+        factory->Release();
+        if (FAILED(hr))
+            throw base_exception("DXGI adapter not found", MFX_ERR_NOT_FOUND);
+
+        ID3D11Device *device = nullptr;
+
+        hr = D3D11CreateDevice(dxgi_adapter,
+                               D3D_DRIVER_TYPE_UNKNOWN,
+                               nullptr,
+                               D3D11_CREATE_DEVICE_VIDEO_SUPPORT,
+                               nullptr,
+                               0,
+                               D3D11_SDK_VERSION,
+                               &device,
+                               nullptr,
+                               nullptr);
+        dxgi_adapter->Release();
+        if (FAILED(hr))
+            throw base_exception("D3D11CreateDevice failed", MFX_ERR_DEVICE_FAILED);
+
+        ID3D10Multithread *mt = nullptr;
+        if (SUCCEEDED(device->QueryInterface(__uuidof(ID3D10Multithread), (void **)&mt))) {
+            mt->SetMultithreadProtected(TRUE);
+            mt->Release();
+        }
+
+        return std::shared_ptr<device_context>(
+            new device_context(handle_type::d3d11_device_manager, device, [](void *handle) {
+                reinterpret_cast<ID3D11Device *>(handle)->Release();
+            }));
+    }
+#endif
+
+    /// @brief Creates context with the native device of the platform: VADisplay on Linux or
+    /// D3D11 device on Windows.
+    /// @return Shared pointer to the context owning the device.
+    static std::shared_ptr<device_context> create() {
+#if defined(LIBVA_SUPPORT)
+        return create_va_display();
+#elif defined(_WIN32)
+        return create_d3d11_device();
+#else
+        throw base_exception("Device creation is not supported on this platform", MFX_ERR_UNSUPPORTED);
+#endif
+    }
+
+protected:
+    /// @brief Wraps device handle created by this object.
+    /// @param[in] type Type of the handle.
+    /// @param[in] handle Native device handle.
+    /// @param[in] release Function to release the device.
+    device_context(handle_type type, void *handle, std::function<void(void *)> release)
+            : type_(type),
+              handle_(handle),
+              release_(std::move(release)) {}
+
+    /// @brief Type of the native device handle.
+    handle_type type_;
+    /// @brief Native device handle.
+    void *handle_;
+    /// @brief Function to release the device. Empty when device is owned by the application.
+    std::function<void(void *)> release_;
+};
+
+} // namespace vpl
+} // namespace oneapi
@@ -73,6 +73,9 @@ protected:
     };
 
 public:
+    /// @brief Buffer ID in the form of FourCC code, available at compile time.
+    static constexpr uint32_t buffer_id = ID;
+
     /// @brief Default ctor
     template <
         typename check = typename std::enable_if<is_extension_buffer::value, mfxExtBuffer>::type>
@@ -1792,6 +1795,14 @@ public:
         return *this;
     }
 
+    /// @brief Provides access to the payload attached to the controller. Use it to update referencing
+    /// payload with the data of the next frame without constructing new controller.
+    /// @param[in] idx Index of the payload
+    /// @return Reference to the payload
+    payload& get_payload(std::size_t idx) {
+        return payload_.at(idx);
+    }
+
 protected:
     /// @brief Set payload
     void set_payload() {
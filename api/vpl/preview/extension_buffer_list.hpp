@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <exception>
 #include <map>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #include "vpl/preview/extension_buffer.hpp"
@@ -147,6 +151,128 @@ protected:
     mfxExtBuffer** mfxBuffers_;
 };
 
+namespace detail {
+
+/// @brief Checks that all IDs in the array are unique.
+/// @param[in] ids Array of IDs.
+/// @return true if all IDs are unique.
+template <std::size_t N>
+constexpr bool unique_ids(const std::array<uint32_t, N>& ids) {
+    for (std::size_t i = 0; i < N; i++) {
+        for (std::size_t j = i + 1; j < N; j++) {
+            if (ids[i] == ids[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/// @brief List of extension buffers with inline storage. Buffers are members of the list and the array of
+/// pointers to them is built once at construction, so assembling parameters or per-frame controls doesn't
+/// allocate memory. Buffer types and IDs are known at compile time, every buffer type may appear once.
+/// EncodeCtrl, if present, is not put into the array and is provided separately by get_encode_ctrl.
+/// @tparam Buffers Extension buffer classes.
+template <typename... Buffers>
+class static_buffer_list {
+    static_assert(std::conjunction<std::is_base_of<extension_buffer_base, Buffers>...>::value,
+                  "static_buffer_list accepts extension buffer classes only");
+
+public:
+    /// @brief Number of buffers in the list.
+    static constexpr std::size_t capacity = sizeof...(Buffers);
+    /// @brief IDs of the buffers in the list in the form of FourCC codes.
+    static constexpr std::array<uint32_t, capacity> ids = { { Buffers::buffer_id... } };
+
+    static_assert(detail::unique_ids(ids), "static_buffer_list can't hold two buffers with the same ID");
+
+    /// @brief Default ctor. Buffers are default constructed.
+    static_buffer_list() : buffers_(), raw_(), size_(0), ctrl_(nullptr) {
+        bind();
+    }
+
+    /// @brief Copy ctor
+    /// @param[in] other another object to use as data source
+    static_buffer_list(const static_buffer_list& other)
+            : buffers_(other.buffers_),
+              raw_(),
+              size_(0),
+              ctrl_(nullptr) {
+        bind();
+    }
+
+    /// @brief Copy operator
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    static_buffer_list& operator=(const static_buffer_list& other) {
+        buffers_ = other.buffers_;
+        bind();
+        return *this;
+    }
+
+    /// @brief Provides access to the buffer of given type.
+    /// @tparam T Extension buffer class.
+    /// @return Reference to the buffer.
+    template <typename T>
+    T& get() {
+        return std::get<T>(buffers_);
+    }
+
+    /// @brief Returns number of extension buffers attached to the parameters.
+    /// @return Number of extension buffers.
+    std::size_t get_size() const {
+        return size_;
+    }
+
+    /// @brief Returns pair of array of pointers to the extension buffer and number of buffers
+    /// @return pair of array of pointers to the extension buffer and number of buffers
+    auto get_raw_ext_buffers() {
+        return std::pair(raw_.data(), size_);
+    }
+
+    /// @brief Returns encode control structure if EncodeCtrl is in the list.
+    /// @return Pointer to the encode control structure or nullptr.
+    mfxEncodeCtrl* get_encode_ctrl() {
+        return ctrl_;
+    }
+
+protected:
+    /// @brief Fills array of pointers to the buffers.
+    void bind() {
+        size_ = 0;
+        ctrl_ = nullptr;
+        std::apply(
+            [this](Buffers&... b) {
+                (bind_one(b), ...);
+            },
+            buffers_);
+    }
+
+    /// @brief Adds pointer to the buffer into the array unless it is ignored.
+    /// @param[in] b Extension buffer.
+    void bind_one(extension_buffer_base& b) {
+        uint32_t id = b.get_ID();
+        if (id == 0) {
+            ctrl_ = reinterpret_cast<mfxEncodeCtrl*>(b.get_base_ptr());
+            return;
+        }
+        if (std::find(ignore_ID_list, ignore_ID_list + IGNORE_LIST_LEN, id) !=
+            ignore_ID_list + IGNORE_LIST_LEN)
+            return;
+        raw_[size_++] = b.get_base_ptr();
+    }
+
+    /// Buffers.
+    std::tuple<Buffers...> buffers_;
+    /// Pointers to the buffers.
+    std::array<mfxExtBuffer*, capacity ? capacity : 1> raw_;
+    /// Number of the pointers in the array.
+    std::size_t size_;
+    /// Encode control structure.
+    mfxEncodeCtrl* ctrl_;
+};
+
 /// @brief This class hold list of extension buffers used during decoder's initialization stage
 /// Those buffers are attached to the mfxVideoParam structure before Init call.
 class decoder_init_reset_list : public buffer_list {
@@ -201,6 +327,7 @@ public:
             case MFX_EXTBUFF_DECODED_FRAME_INFO:
             case MFX_EXTBUFF_VP9_PARAM:
             case MFX_EXTBUFF_DEVICE_AFFINITY_MASK:
+            case MFX_EXTBUFF_ALLOCATION_HINTS:
                 buffer_list::add_buffer(o);
                 return;
         }
@@ -456,6 +583,7 @@ public:
             case MFX_EXTBUFF_VP9_PARAM:
             case MFX_EXTBUFF_PARTIAL_BITSTREAM_PARAM:
             case MFX_EXTBUFF_DEVICE_AFFINITY_MASK:
+            case MFX_EXTBUFF_ALLOCATION_HINTS:
             case MFX_EXTBUFF_AV1_BITSTREAM_PARAM:
             case MFX_EXTBUFF_AV1_RESOLUTION_PARAM:
             case MFX_EXTBUFF_AV1_TILE_PARAM:
@@ -893,6 +1021,7 @@ public:
             case MFX_EXTBUFF_VPP_COLOR_CONVERSION:
             case MFX_EXTBUFF_VPP_MCTF:
             case MFX_EXTBUFF_DEVICE_AFFINITY_MASK:
+            case MFX_EXTBUFF_ALLOCATION_HINTS:
                 buffer_list::add_buffer(o);
                 return;
         }
@@ -7,9 +7,12 @@
 #pragma once
 
 #include <chrono>
+#include <mutex>
+#include <new>
 #include <string>
 #include <utility>
 #include <memory>
+#include <vector>
 
 #include "vpl/mfxstructures.h"
 
@@ -104,18 +107,31 @@ public:
     /// @param[in] n_times Reference counter increment.
     /// @param[in] lazy_sync Do lazy sync or not.
     void inject(mfxFrameSurface1* surface, unsigned int n_times, bool lazy_sync = false) {
-        if (!surface_) {
-            uint32_t c;
-            surface_   = surface;
-            lazy_sync_ = lazy_sync;
-            surface_->FrameInterface->GetRefCounter(surface_, &c);
-            for (unsigned int i = 0; i < n_times; i++) {
-                detail::c_api_invoker(detail::default_checker,
-                                        surface_->FrameInterface->AddRef,
-                                        surface_);
-            }
-            surface_->FrameInterface->GetRefCounter(surface_, &c);
+        mfxStatus sts = inject(std::nothrow, surface, n_times, lazy_sync);
+        if (sts < 0)
+            throw base_exception(sts);
+    }
+
+    /// @brief Attaches mfxFrameSurface1 object to the empty frame_surface object without throwing.
+    /// @param[in] surface Pointer to the mfxFrameSurface1 object
+    /// @param[in] n_times Number of times to increment the reference counter.
+    /// @param[in] lazy_sync Temporal flag indicating that lazy sync technique must be used.
+    /// @return Status of the reference counter increment.
+    mfxStatus inject(std::nothrow_t,
+                     mfxFrameSurface1* surface,
+                     unsigned int n_times,
+                     bool lazy_sync = false) noexcept {
+        if (surface_)
+            return MFX_ERR_NONE;
+
+        surface_   = surface;
+        lazy_sync_ = lazy_sync;
+        for (unsigned int i = 0; i < n_times; i++) {
+            mfxStatus sts = surface_->FrameInterface->AddRef(surface_);
+            if (sts < 0)
+                return sts;
         }
+        return MFX_ERR_NONE;
     }
 
     /// @brief Indefinetely wait for operation completion.
@@ -313,5 +329,171 @@ inline std::ostream& operator<<(std::ostream& out, const frame_surface& f) {
     return out;
 }
 
+namespace detail {
+
+/// @brief Thread safe list of free memory blocks of the same size. Block size is defined by the first
+/// allocation, allocations of other sizes are forwarded to the global operator new.
+class block_free_list {
+public:
+    /// @brief Ctor
+    /// @param[in] max_cached Maximum number of free blocks to keep.
+    explicit block_free_list(std::size_t max_cached)
+            : lock_(),
+              blocks_(),
+              block_size_(0),
+              max_cached_(max_cached) {}
+
+    block_free_list(const block_free_list&)            = delete;
+    block_free_list& operator=(const block_free_list&) = delete;
+
+    /// @brief Dtor. Frees cached blocks.
+    ~block_free_list() {
+        for (auto b : blocks_)
+            ::operator delete(b);
+    }
+
+    /// @brief Allocates block of the given size.
+    /// @param[in] size Size in bytes.
+    /// @return Pointer to the block.
+    void* allocate(std::size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (!block_size_)
+                block_size_ = size;
+            if (size == block_size_ && !blocks_.empty()) {
+                void* b = blocks_.back();
+                blocks_.pop_back();
+                return b;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    /// @brief Returns block to the list.
+    /// @param[in] b Pointer to the block.
+    /// @param[in] size Size in bytes.
+    void deallocate(void* b, std::size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (size == block_size_ && blocks_.size() < max_cached_) {
+                blocks_.push_back(b);
+                return;
+            }
+        }
+        ::operator delete(b);
+    }
+
+    /// @brief Provides number of cached free blocks.
+    /// @return Number of cached free blocks.
+    std::size_t cached() {
+        std::lock_guard<std::mutex> lock(lock_);
+        return blocks_.size();
+    }
+
+protected:
+    /// Lock for the list.
+    std::mutex lock_;
+    /// Free blocks.
+    std::vector<void*> blocks_;
+    /// Size of the block.
+    std::size_t block_size_;
+    /// Maximum number of free blocks to keep.
+    std::size_t max_cached_;
+};
+
+/// @brief Allocator which takes single objects from the shared block_free_list.
+/// @tparam T Type of the object.
+template <typename T>
+class pool_allocator {
+public:
+    /// Type of the object.
+    using value_type = T;
+
+    /// @brief Ctor
+    /// @param[in] list Free list to use.
+    explicit pool_allocator(std::shared_ptr<block_free_list> list) : list_(std::move(list)) {}
+
+    /// @brief Rebind ctor
+    /// @param[in] other Allocator to share free list with.
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& other) : list_(other.list_) {}
+
+    /// @brief Allocates memory for n objects.
+    /// @param[in] n Number of objects.
+    /// @return Pointer to the memory.
+    T* allocate(std::size_t n) {
+        if (n != 1)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(list_->allocate(sizeof(T)));
+    }
+
+    /// @brief Deallocates memory for n objects.
+    /// @param[in] p Pointer to the memory.
+    /// @param[in] n Number of objects.
+    void deallocate(T* p, std::size_t n) {
+        if (n != 1)
+            ::operator delete(p);
+        else
+            list_->deallocate(p, sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U>& other) const {
+        return list_ == other.list_;
+    }
+
+    template <typename U>
+    bool operator!=(const pool_allocator<U>& other) const {
+        return list_ != other.list_;
+    }
+
+    /// Shared free list.
+    std::shared_ptr<block_free_list> list_;
+};
+
+} // namespace detail
+
+/// @brief Recycles frame_surface wrappers. Wrapper object and shared pointer control block are placed in
+/// single memory block, which returns to the pool once the last reference to the wrapper is released, so
+/// steady state processing doesn't touch the heap. Pool memory stays valid while any wrapper allocated
+/// from it exists, so wrappers may outlive the pool object.
+class frame_surface_pool {
+public:
+    /// Default number of cached wrappers.
+    enum : std::size_t { DEFAULT_MAX_CACHED = 64 };
+
+    /// @brief Ctor
+    /// @param[in] max_cached Maximum number of free wrappers to keep.
+    explicit frame_surface_pool(std::size_t max_cached = DEFAULT_MAX_CACHED)
+            : list_(std::make_shared<detail::block_free_list>(max_cached)) {}
+
+    /// @brief Creates empty wrapper.
+    /// @return Shared pointer to the wrapper.
+    std::shared_ptr<frame_surface> make() {
+        return std::allocate_shared<frame_surface>(detail::pool_allocator<frame_surface>(list_));
+    }
+
+    /// @brief Creates wrapper on top of mfxFrameSurface1 object.
+    /// Increments mfxFrameSurface1 reference counter value.
+    /// @param[in] surface Pointer to the mfxFrameSurface1 object
+    /// @param[in] lazy_sync Flag indicating that lazy sync technique must be used.
+    /// @return Shared pointer to the wrapper.
+    std::shared_ptr<frame_surface> make(mfxFrameSurface1* surface, bool lazy_sync = false) {
+        return std::allocate_shared<frame_surface>(detail::pool_allocator<frame_surface>(list_),
+                                                   surface,
+                                                   lazy_sync);
+    }
+
+    /// @brief Provides number of free wrappers ready for reuse.
+    /// @return Number of free wrappers.
+    std::size_t cached() const {
+        return list_->cached();
+    }
+
+protected:
+    /// Shared free list.
+    std::shared_ptr<detail::block_free_list> list_;
+};
+
 } // namespace vpl
 } // namespace oneapi
@@ -6,11 +6,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "vpl/preview/bitstream.hpp"
 #include "vpl/preview/defs.hpp"
@@ -76,12 +79,21 @@ class future {
 public:
     /// @brief Default ctor
     /// @param[in] future_data Data object to take care about.
-    explicit future(data future_data) : data_(future_data), fatal_happened_(false) {}
+    explicit future(data future_data)
+            : data_(future_data),
+              fatal_happened_(false),
+              completed_(false),
+              completion_status_(async_op_status::unknown),
+              callbacks_() {}
 
-    /// @brief Indefinitely waits for operation completion.
+    /// @brief Indefinitely waits for operation completion. Invokes registered completion callbacks.
     void wait() {
         if (have_to_wait() && data_) {
             data_->wait();
+            complete(async_op_status::ready);
+        }
+        else {
+            complete(async_op_status::cancelled);
         }
     }
 
@@ -103,6 +115,45 @@ public:
         return async_op_status::cancelled;
     }
 
+    /// @brief Registers callback to be invoked once the operation completes. Callback receives the final
+    /// status of the operation. Callbacks are invoked from the thread which observed the completion: the one
+    /// calling wait, get or poll. If the operation is already completed, callback is invoked immediately.
+    /// @param[in] callback Callback function.
+    void on_complete(std::function<void(async_op_status)> callback) {
+        if (completed_)
+            callback(completion_status_);
+        else
+            callbacks_.push_back(std::move(callback));
+    }
+
+    /// @brief Checks operation completion without blocking. Invokes registered completion callbacks once the
+    /// operation is completed.
+    /// @return async_op_status::timeout if the operation is still in progress, final status otherwise.
+    async_op_status poll() {
+        return poll_for(std::chrono::milliseconds(0));
+    }
+
+    /// @brief Waits for the operation completion up to the given timeout. Same as wait_for, but
+    /// invokes registered completion callbacks once the operation is completed.
+    /// @param timeout_duration Maximum duration to block for.
+    /// @return async_op_status::timeout if the operation is still in progress, final status otherwise.
+    template <class Rep, class Period>
+    async_op_status poll_for(const std::chrono::duration<Rep, Period> &timeout_duration) {
+        if (completed_)
+            return completion_status_;
+
+        async_op_status sts = wait_for(timeout_duration);
+        if (sts != async_op_status::timeout)
+            complete(sts);
+        return sts;
+    }
+
+    /// @brief Checks if the operation completion was already observed.
+    /// @return true if the operation is completed.
+    bool is_completed() const {
+        return completed_;
+    }
+
     /// @brief add current operation scheduling status into the history of the future.
     /// @param[in] op Operation's status
     void add_operation(operation_status op) {
@@ -167,6 +218,30 @@ protected:
     /// Global fatal flag. Updated when first operation in the pipeline provided fatal status code.
     bool fatal_happened_;
 
+    /// Flag indicating that operation completion was observed and callbacks were invoked.
+    bool completed_;
+
+    /// Final status of the operation. Valid when completed_ is true.
+    async_op_status completion_status_;
+
+    /// Callbacks to invoke on operation completion.
+    std::vector<std::function<void(async_op_status)>> callbacks_;
+
+    /// @brief Marks operation as completed and invokes registered callbacks. Does nothing if the completion
+    /// was already observed.
+    /// @param[in] sts Final status of the operation.
+    void complete(async_op_status sts) {
+        if (completed_)
+            return;
+        completed_         = true;
+        completion_status_ = sts;
+
+        std::vector<std::function<void(async_op_status)>> callbacks;
+        callbacks.swap(callbacks_);
+        for (auto &cb : callbacks)
+            cb(sts);
+    }
+
     /// @brief Friend operator to print out state of the class in human readable form.
     /// @param[inout] out Reference to the stream to write.
     /// @param[in] p Reference to the future instance to dump the state.
@@ -192,5 +267,167 @@ protected:
 using future_surface_t   = future<std::shared_ptr<frame_surface>>;
 using future_bitstream_t = future<std::shared_ptr<bitstream_as_dst>>;
 
+namespace detail {
+
+/// @brief Maximum time to block on single pending operation while waiting for the group of operations.
+/// Runtime doesn't expose waitable handle for the sync point, so group wait blocks inside the runtime on one
+/// pending operation at a time with this period and then re-checks remaining operations without blocking.
+constexpr std::chrono::milliseconds completion_poll_period(1);
+
+/// @brief Blocks on single pending operation for one poll period or less.
+/// @param[in] wait_op Function which waits for the operation completion up to the given period.
+/// @param[in] remaining Remaining time to wait.
+/// @tparam W Type of the wait function.
+template <typename W>
+void block_on_pending(W &wait_op, std::chrono::steady_clock::duration remaining) {
+    auto period = std::min<std::chrono::steady_clock::duration>(completion_poll_period, remaining);
+    if (period.count() > 0)
+        wait_op(std::chrono::duration_cast<std::chrono::milliseconds>(period));
+}
+
+} // namespace detail
+
+/// @brief Waits until any of the given operations completes or timeout expires, whichever comes first.
+/// Single thread may wait for many operations at once this way. Completion callbacks of the completed
+/// operations are invoked.
+/// @param[in] futures List of the future objects to wait for.
+/// @param timeout_duration Maximum duration to block for.
+/// @return Pair of the final status and the index of the first completed future object in the list, or pair of
+/// async_op_status::timeout and list size if nothing completed before the timeout.
+template <typename data, class Rep, class Period>
+std::pair<async_op_status, std::size_t> when_any(
+    const std::vector<std::shared_ptr<future<data>>> &futures,
+    const std::chrono::duration<Rep, Period> &timeout_duration) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout_duration);
+
+    while (true) {
+        std::size_t first_pending = futures.size();
+        for (std::size_t i = 0; i < futures.size(); i++) {
+            if (!futures[i])
+                continue;
+            async_op_status sts = futures[i]->poll();
+            if (sts != async_op_status::timeout)
+                return std::pair(sts, i);
+            if (first_pending == futures.size())
+                first_pending = i;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (first_pending == futures.size() || now >= deadline)
+            return std::pair(async_op_status::timeout, futures.size());
+
+        auto wait_op = [&](std::chrono::milliseconds period) {
+            futures[first_pending]->poll_for(period);
+        };
+        detail::block_on_pending(wait_op, deadline - now);
+    }
+}
+
+/// @brief Waits until all of the given operations complete or timeout expires, whichever comes first.
+/// Completion callbacks of the completed operations are invoked.
+/// @param[in] futures List of the future objects to wait for.
+/// @param timeout_duration Maximum duration to block for.
+/// @return async_op_status::timeout if some operations still in progress, async_op_status::ready if all
+/// operations completed successfully, final status of the first unsuccessful operation otherwise.
+template <typename data, class Rep, class Period>
+async_op_status when_all(const std::vector<std::shared_ptr<future<data>>> &futures,
+                         const std::chrono::duration<Rep, Period> &timeout_duration) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout_duration);
+
+    while (true) {
+        async_op_status result    = async_op_status::ready;
+        std::size_t first_pending = futures.size();
+        for (std::size_t i = 0; i < futures.size(); i++) {
+            if (!futures[i])
+                continue;
+            async_op_status sts = futures[i]->poll();
+            if (sts == async_op_status::timeout) {
+                if (first_pending == futures.size())
+                    first_pending = i;
+            }
+            else if (sts != async_op_status::ready && result == async_op_status::ready) {
+                result = sts;
+            }
+        }
+
+        if (first_pending == futures.size())
+            return result;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return async_op_status::timeout;
+
+        auto wait_op = [&](std::chrono::milliseconds period) {
+            futures[first_pending]->poll_for(period);
+        };
+        detail::block_on_pending(wait_op, deadline - now);
+    }
+}
+
+/// @brief Dispatches completion callbacks of many in-flight operations from single thread. Both frame and
+/// bitstream future objects can be registered. Intended to be driven by the application's event loop: call
+/// run_for periodically or from the dedicated reactor thread. Not thread safe.
+class completion_reactor {
+public:
+    /// @brief Default ctor
+    completion_reactor() : ops_() {}
+
+    /// @brief Registers future object and its completion callback.
+    /// @param[in] f Future object to track. Reactor holds reference to it until completion.
+    /// @param[in] callback Callback function. Invoked from run_for once the operation completes.
+    /// @tparam data frame_surface class or bitstream_as_dst class
+    template <typename data>
+    void add(std::shared_ptr<future<data>> f, std::function<void(async_op_status)> callback) {
+        if (!f)
+            return;
+        f->on_complete(std::move(callback));
+        if (f->is_completed())
+            return;
+        ops_.push_back([f](std::chrono::milliseconds period) {
+            return f->poll_for(period);
+        });
+    }
+
+    /// @brief Dispatches completions until all registered operations complete or timeout expires, whichever
+    /// comes first.
+    /// @param timeout_duration Maximum duration to block for.
+    /// @return Number of operations completed during this call.
+    template <class Rep, class Period>
+    std::size_t run_for(const std::chrono::duration<Rep, Period> &timeout_duration) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout_duration);
+        std::size_t n_completed = 0;
+
+        while (true) {
+            auto it = std::remove_if(ops_.begin(), ops_.end(), [](poll_op &op) {
+                return op(std::chrono::milliseconds(0)) != async_op_status::timeout;
+            });
+            n_completed += std::distance(it, ops_.end());
+            ops_.erase(it, ops_.end());
+
+            auto now = std::chrono::steady_clock::now();
+            if (ops_.empty() || now >= deadline)
+                return n_completed;
+
+            detail::block_on_pending(ops_.front(), deadline - now);
+        }
+    }
+
+    /// @brief Provides number of operations which are still in progress.
+    /// @return Number of pending operations.
+    std::size_t pending() const {
+        return ops_.size();
+    }
+
+protected:
+    /// Completion check function. Waits up to the given period and returns operation status.
+    using poll_op = std::function<async_op_status(std::chrono::milliseconds)>;
+
+    /// Pending operations.
+    std::vector<poll_op> ops_;
+};
+
 } // namespace vpl
 } // namespace oneapi
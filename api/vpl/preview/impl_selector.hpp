@@ -7,6 +7,8 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -19,6 +21,29 @@
 namespace oneapi {
 namespace vpl {
 
+/// @brief Loader handle shared by the sessions created from it. Loader is unloaded with the last
+/// session.
+using shared_loader = std::shared_ptr<std::remove_pointer_t<mfxLoader>>;
+
+namespace detail {
+
+/// @brief Result of the implementation selection. Keeps loader with applied properties, description
+/// of the selected implementation and its parsed capabilities.
+struct selection_cache {
+    /// Guards the cache.
+    std::mutex mutex_;
+    /// Loader the implementation was found in.
+    shared_loader loader_;
+    /// Description of the selected implementation. Released before the loader.
+    std::shared_ptr<void> handle_;
+    /// Parsed capabilities of the selected implementation.
+    std::shared_ptr<base_implementation_capabilities> caps_;
+    /// Index of the selected implementation.
+    uint32_t idx_ = 0;
+};
+
+} // namespace detail
+
 /// @brief Selects oneVPL implementation according to the specified properties.
 /// @details This object iterates over the available implementations and selects an appropriate one
 /// based on the @p list of properties. API user can create an instance of that class. If user
@@ -29,7 +54,8 @@ protected:
     /// @brief Protected ctor.
     /// @param list List of properties
     implementation_selector()
-            : format_(MFX_IMPLCAPS_IMPLDESCSTRUCTURE) {}
+            : format_(MFX_IMPLCAPS_IMPLDESCSTRUCTURE),
+              cache_(std::make_shared<detail::selection_cache>()) {}
 
     virtual std::vector<std::pair<std::string, detail::variant>> get_properties() const = 0;
 
@@ -38,13 +64,54 @@ public:
     virtual ~implementation_selector() {}
 
     /// @brief Creates session which has the requested properties. Session class object calls
-    /// this method at the ctor and takes care on deletion of loader and session handles.
-    /// @return Pair of loader handle and associated session handle.
-    auto session() const {
-        mfxStatus sts;
-        implementation_capabilities_factory factory;
-        auto loader = MFXLoad();
+    /// this method at the ctor and takes care on deletion of session handle. Loader and capabilities
+    /// of the selected implementation are cached, so subsequent calls only create new session from the
+    /// same loader without enumeration of the implementations.
+    /// @return Pair of shared loader handle and associated session handle.
+    std::pair<shared_loader, mfxSession> session() const {
+        std::lock_guard<std::mutex> lock(cache_->mutex_);
+        if (!cache_->caps_)
+            select();
+
+        mfxSession s;
+        detail::c_api_invoker e(detail::default_checker,
+                                MFXCreateSession,
+                                cache_->loader_.get(),
+                                cache_->idx_,
+                                &s);
+        return std::pair(cache_->loader_, s);
+    }
+
+    /// @brief Provides capabilities of the selected implementation. Selection is done on the first
+    /// call if no session was created yet.
+    /// @return Pointer to the capabilities information.
+    std::shared_ptr<base_implementation_capabilities> get_selected_capabilities() const {
+        std::lock_guard<std::mutex> lock(cache_->mutex_);
+        if (!cache_->caps_)
+            select();
+        return cache_->caps_;
+    }
+
+    /// @brief Drops cached selection result. Next session is created from the new loader. Sessions
+    /// already created keep their loader.
+    void reset_cache() {
+        std::lock_guard<std::mutex> lock(cache_->mutex_);
+        cache_->caps_.reset();
+        cache_->handle_.reset();
+        cache_->loader_.reset();
+        cache_->idx_ = 0;
+    }
+
+protected:
+    /// @brief This operator is applyed to any found oneVPL implementation. If operator returns true, a session based
+    /// on found implementation is created. Otherwise, search is continued.
+    /// @param caps Pointer to the session capabilities information in the requested format.
+    /// @return True, if implementation is good to go, false if search must continue.
+    virtual bool operator()(std::shared_ptr<base_implementation_capabilities> caps) const = 0;
 
+    /// @brief Applies properties to the loader as dispatcher filter properties.
+    /// @param[in] loader Loader handle.
+    virtual void configure(mfxLoader loader) const {
         // convert options to mfxConfig
         auto opts = get_properties();
 
@@ -56,15 +123,23 @@ public:
                                     (const uint8_t *)opt.first.c_str(),
                                     opt.second.get_variant());
         });
+    }
+
+    /// @brief Loads implementations matching the properties and selects one of them with operator().
+    /// Must be called with the cache locked.
+    void select() const {
+        mfxStatus sts;
+        implementation_capabilities_factory factory;
+        shared_loader loader(MFXLoad(), [](mfxLoader l) {
+            MFXUnload(l);
+        });
+
+        configure(loader.get());
 
         uint32_t idx = 0;
         while (true) {
             void *h;
-            sts = MFXEnumImplementations(loader, idx, format_, &h);
-
-            std::shared_ptr<void> handle(h, [&] (void *p) {
-                MFXDispReleaseImplDescription(loader, p);
-            });
+            sts = MFXEnumImplementations(loader.get(), idx, format_, &h);
 
             // break if no idx
             if (sts == MFX_ERR_NOT_FOUND)
@@ -72,29 +147,30 @@ public:
             if (sts < 0)
                 throw base_exception(sts);
 
+            mfxLoader l = loader.get();
+            std::shared_ptr<void> handle(h, [l](void *p) {
+                MFXDispReleaseImplDescription(l, p);
+            });
+
             std::shared_ptr<base_implementation_capabilities> caps = factory.create(format_, h);
 
             if (this->operator()(caps)) {
-                mfxSession s;
-                detail::c_api_invoker e(detail::default_checker, MFXCreateSession, loader, idx, &s);
-                return std::pair(loader, s);
+                cache_->loader_ = loader;
+                cache_->handle_ = handle;
+                cache_->caps_   = caps;
+                cache_->idx_    = idx;
+                return;
             }
             idx++;
         }
-        MFXUnload(loader);
         throw base_exception(MFX_ERR_NOT_INITIALIZED);
     }
 
-protected:
-    /// @brief This operator is applyed to any found oneVPL implementation. If operator returns true, a session based
-    /// on found implementation is created. Otherwise, search is continued.
-    /// @param caps Pointer to the session capabilities information in the requested format.
-    /// @return True, if implementation is good to go, false if search must continue.
-    virtual bool operator()(std::shared_ptr<base_implementation_capabilities> caps) const = 0;
-
     /// @brief Implementation capabilities report format
     /// @todo Replace either with enum or typename
     mfxImplCapsDeliveryFormat format_;
+    /// @brief Cached selection result
+    std::shared_ptr<detail::selection_cache> cache_;
 };
 
 /// @brief Default implementation selector. It accepts first implementation matching provided properties.
@@ -124,6 +200,48 @@ protected:
     property_collection props_;
 };
 
+/// @brief Implementation selector with the list of typed properties. It accepts first implementation
+/// matching provided properties. Properties are applied to the loader directly from the inline storage
+/// of the list without building property paths.
+/// @tparam Props Typed properties from the @p sprops namespace.
+template <typename... Props>
+class static_selector : public implementation_selector {
+public:
+    /// @brief Constructs selector.
+    /// @param[in] props Properties to match.
+    explicit static_selector(const Props &... props) : implementation_selector(), props_(props...) {}
+
+    /// @brief Acccept first found implementation.
+    /// @return True if implementation found.
+    bool operator()(std::shared_ptr<base_implementation_capabilities>) const override {
+        return true;
+    }
+
+    /// @brief Returns list of C-based properties in a form of pair: property path
+    /// and property value.
+    /// @return List of C-based properties
+    std::vector<std::pair<std::string, detail::variant>> get_properties() const override {
+        return props_.get_properties();
+    }
+
+protected:
+    /// @brief Applies properties to the loader as dispatcher filter properties.
+    /// @param[in] loader Loader handle.
+    void configure(mfxLoader loader) const override {
+        for (auto &f : props_.get_filter()) {
+            auto cfg = MFXCreateConfig(loader);
+            [[maybe_unused]] detail::c_api_invoker e(detail::default_checker,
+                                                     MFXSetConfigFilterProperty,
+                                                     cfg,
+                                                     (const uint8_t *)f.name_,
+                                                     f.value_.get_variant());
+        }
+    }
+
+    /// @brief List of properties
+    static_property_list<Props...> props_;
+};
+
 /// @brief Default SW based implementation selector. It accepts first implementation with SW based acceleration.
 class cpu_selector : public default_selector<property_list>{
 public:
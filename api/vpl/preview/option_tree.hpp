@@ -740,6 +740,9 @@ public:
     /// @brief dxgi_adapter_index property
     VPL_OPT_TREE_PROPERTY(uint32_t, uint32_t, dxgi_adapter_index)
 
+    /// @brief num_thread property
+    VPL_OPT_TREE_PROPERTY(uint32_t, uint32_t, num_thread)
+
     /// @brief implemented_function property
     VPL_OPT_TREE_LIST_PROPERTY(std::string, std::string, implemented_function)
 
@@ -772,6 +775,7 @@ public:
         , vendor_id("vendor_id", "mfxImplDescription.VendorID")
         , vendor_impl_id("vendor_impl_id", "mfxImplDescription.VendorImplID")
         , dxgi_adapter_index("dxgi_adapter_index", "DXGIAdapterIndex")
+        , num_thread("num_thread", "NumThread")
         , implemented_function("implemented_function", "mfxImplementedFunctions.FunctionsName")
         , pool_alloc_properties("pool_alloc_properties", "mfxImplDescription.mfxSurfacePoolMode")
         , handle("handle", "mfxHandleType", "mfxHDL")
@@ -800,6 +804,7 @@ protected:
         vendor_id.write(prefix, dest);
         vendor_impl_id.write(prefix, dest);
         dxgi_adapter_index.write(prefix, dest);
+        num_thread.write(prefix, dest);
         implemented_function.write(prefix, dest);
         pool_alloc_properties.write(prefix, dest);
         handle.write(prefix, dest);
@@ -822,6 +827,7 @@ protected:
         vendor_id.print(out, indent);
         vendor_impl_id.print(out, indent);
         dxgi_adapter_index.print(out, indent);
+        num_thread.print(out, indent);
         implemented_function.print(out, indent);
         pool_alloc_properties.print(out, indent);
         handle.print(out, indent);
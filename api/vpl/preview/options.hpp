@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include <array>
 #include <exception>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 
@@ -324,6 +326,22 @@ class dxgi_adapter_index : public property {
     }
 };
 
+/// @brief Holds "number of threads" property. This is first level property.
+/// Passed to the implementation as mfxExtThreadsParam::NumThread, applicable to the CPU
+/// implementation.
+class num_thread : public property {
+  public:
+    /// @brief Property value type
+    typedef uint32_t value_type;
+
+    /// @brief Constructs property.
+    /// @param[in] num Number of the implementation's worker threads.
+    num_thread(uint32_t num) {
+        add_property("NumThread", num);
+        property_name_ = "num_thread";
+    }
+};
+
 /// @brief Holds "implemented function" property. This is first level property.
 class implemented_function : public property {
   public:
@@ -670,7 +688,7 @@ static const std::vector<std::string> first_class_options = { "impl_name", "impl
                                                               "acceleration_mode", "api_version",
                                                               "license", "keywords",
                                                               "vendor_id", "vendor_impl_id",
-                                                              "dxgi_adapter_index",
+                                                              "dxgi_adapter_index", "num_thread",
                                                               "implemented_function",
                                                               "pool_alloc_properties",
                                                               "set_handle", "decoder", "encoder",
@@ -693,5 +711,218 @@ class property_list : public dprops::container {
     }
 };
 
+namespace detail {
+
+/// @brief Dispatcher filter property with the path known at compile time.
+struct filter_property {
+    /// Full property path. Points to the string literal.
+    const char *name_ = nullptr;
+    /// Property value.
+    variant value_;
+};
+
+} // namespace detail
+
+/// @brief Typed properties for the @p static_property_list list. Each property knows its full
+/// dispatcher path and number of dispatcher filter properties at compile time, so no strings are
+/// built and no memory is allocated.
+namespace sprops {
+
+/// @brief Base class of the typed properties.
+/// @tparam N Number of dispatcher filter properties.
+template <std::size_t N>
+class static_property {
+  public:
+    /// @brief Number of dispatcher filter properties.
+    static constexpr std::size_t size = N;
+
+    /// @brief Returns dispatcher filter properties.
+    /// @return Array of dispatcher filter properties.
+    const std::array<detail::filter_property, N> &get_filter() const {
+        return filter_;
+    }
+
+  protected:
+    /// Dispatcher filter properties.
+    std::array<detail::filter_property, N> filter_;
+};
+
+/// @brief Holds "implementation type" property.
+class impl : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] implType Type of the implementation.
+    explicit impl(implementation_type implType) {
+        filter_ = { { { "mfxImplDescription.Impl", detail::variant((uint32_t)implType) } } };
+    }
+};
+
+/// @brief Holds "acceleration" property.
+class acceleration_mode : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] implVia Acceleration mode.
+    explicit acceleration_mode(implementation_via implVia) {
+        filter_ = { { { "mfxImplDescription.AccelerationMode",
+                        detail::variant((uint32_t)implVia) } } };
+    }
+};
+
+/// @brief Holds API version property.
+class api_version : public static_property<2> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] major Major API version.
+    /// @param[in] minor Minor API version.
+    api_version(uint16_t major, uint16_t minor) {
+        filter_ = { { { "mfxImplDescription.ApiVersion.Major", detail::variant(major) },
+                      { "mfxImplDescription.ApiVersion.Minor", detail::variant(minor) } } };
+    }
+};
+
+/// @brief Holds "implementation name" property.
+class impl_name : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] implName Name of the implementation. Must stay valid while the list is used.
+    explicit impl_name(std::string_view implName) {
+        filter_ = { { { "mfxImplDescription.ImplName", detail::variant(implName) } } };
+    }
+};
+
+/// @brief Holds "vendor ID" property.
+class vendor_id : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] VendorID vendor ID.
+    explicit vendor_id(uint32_t VendorID) {
+        filter_ = { { { "mfxImplDescription.VendorID", detail::variant(VendorID) } } };
+    }
+};
+
+/// @brief Holds "vendor implementation ID" property.
+class vendor_impl_id : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] VendorImplID vendor's implementation ID.
+    explicit vendor_impl_id(uint32_t VendorImplID) {
+        filter_ = { { { "mfxImplDescription.VendorImplID", detail::variant(VendorImplID) } } };
+    }
+};
+
+/// @brief Holds surface "pool allocation mode" property.
+class pool_alloc_properties : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] policy Pool allocation mode.
+    explicit pool_alloc_properties(pool_alloction_policy policy) {
+        filter_ = { { { "mfxImplDescription.mfxSurfacePoolMode",
+                        detail::variant((uint32_t)policy) } } };
+    }
+};
+
+/// @brief Holds "number of threads" property.
+class num_thread : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] num Number of the implementation's worker threads.
+    explicit num_thread(uint32_t num) {
+        filter_ = { { { "NumThread", detail::variant(num) } } };
+    }
+};
+
+/// @brief Holds "codec ID" property of the decoder.
+class decoder_codec_id : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] codecID Codec ID.
+    explicit decoder_codec_id(codec_format_fourcc codecID) {
+        filter_ = { { { "mfxImplDescription.mfxDecoderDescription.decoder.CodecID",
+                        detail::variant((uint32_t)codecID) } } };
+    }
+};
+
+/// @brief Holds "codec ID" property of the encoder.
+class encoder_codec_id : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] codecID Codec ID.
+    explicit encoder_codec_id(codec_format_fourcc codecID) {
+        filter_ = { { { "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+                        detail::variant((uint32_t)codecID) } } };
+    }
+};
+
+/// @brief Holds "filter ID" property of the VPP.
+class filter_id : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] fourcc Filter ID.
+    explicit filter_id(uint32_t fourcc) {
+        filter_ = { { { "mfxImplDescription.mfxVPPDescription.filter.FilterFourCC",
+                        detail::variant(fourcc) } } };
+    }
+};
+
+/// @brief Holds media adapter property.
+class media_adapter : public static_property<1> {
+  public:
+    /// @brief Constructs property.
+    /// @param[in] type Media adapter type.
+    explicit media_adapter(media_adapter_type type) {
+        filter_ = { { { "mfxImplDescription.mfxDeviceDescription.device.MediaAdapterType",
+                        detail::variant((uint16_t)type) } } };
+    }
+};
+
+} // namespace sprops
+
+/// @brief List of typed properties for the @p static_selector class. Properties are stored inline
+/// as dispatcher filter properties with compile time paths, so the list doesn't allocate memory and
+/// is applied to the loader without any conversion.
+/// @tparam Props Typed properties from the @p sprops namespace.
+template <typename... Props>
+class static_property_list {
+  public:
+    /// @brief Number of dispatcher filter properties.
+    static constexpr std::size_t size = (Props::size + ... + 0);
+
+    /// @brief Constructs list.
+    /// @param[in] props Properties to add.
+    explicit static_property_list(const Props &... props) : filter_() {
+        [[maybe_unused]] std::size_t idx = 0;
+        (append(idx, props), ...);
+    }
+
+    /// @brief Returns dispatcher filter properties.
+    /// @return Array of dispatcher filter properties.
+    const std::array<detail::filter_property, size> &get_filter() const {
+        return filter_;
+    }
+
+    /// @brief Returns list of C-based properties in a form of pair: property path
+    /// and property value.
+    /// @return List of C-based properties
+    std::vector<std::pair<std::string, detail::variant>> get_properties() const {
+        std::vector<std::pair<std::string, detail::variant>> out;
+        for (auto &f : filter_)
+            out.push_back(std::pair(std::string(f.name_), f.value_));
+        return out;
+    }
+
+  protected:
+    /// @brief Copies filter properties of the typed property.
+    /// @param[inout] idx Position to copy to.
+    /// @param[in] prop Typed property.
+    template <typename P>
+    void append(std::size_t &idx, const P &prop) {
+        for (auto &f : prop.get_filter())
+            filter_[idx++] = f;
+    }
+
+    /// Dispatcher filter properties.
+    std::array<detail::filter_property, size> filter_;
+};
+
 } // namespace vpl
 } // namespace oneapi
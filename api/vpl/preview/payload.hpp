@@ -7,8 +7,11 @@
 #pragma once
 
 #include <algorithm>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "vpl/preview/bitstream.hpp"
 #include "vpl/preview/defs.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/mfxstructures.h"
@@ -20,6 +23,8 @@ namespace vpl {
 /// inserted into the bitstream. The payload buffer must contain a valid formatted payload.
 /// For decoding, these payloads can be retrieved as the decoder parses the bitstream and
 /// caches them in an internal buffer.
+/// Payload either owns a copy of the data or references memory of the caller. Referencing payloads
+/// aren't copied, so creating them for every frame doesn't allocate memory.
 class payload {
 public:
     /// @brief Specialized contructor for the MPEG-2 codec's payload data.
@@ -27,7 +32,8 @@ public:
     /// @param[in] numBit Payload data length in bits
     payload(const std::vector<uint8_t> &data, uint32_t numBit)
             : payload_(),
-              codec_id_(codec_format_fourcc::mpeg2) {
+              codec_id_(codec_format_fourcc::mpeg2),
+              owned_(true) {
         ctor_helper(data, numBit);
     }
 
@@ -37,7 +43,8 @@ public:
     /// @param[in] type SEI message type
     payload(const std::vector<uint8_t> &data, uint32_t numBit, uint16_t type)
             : payload_(),
-              codec_id_(codec_format_fourcc::avc) {
+              codec_id_(codec_format_fourcc::avc),
+              owned_(true) {
         ctor_helper(data, numBit, type);
     }
 
@@ -49,24 +56,69 @@ public:
     /// @param[in] suffix Boolean flag to attach data as suffix.
     payload(const std::vector<uint8_t> &data, uint32_t numBit, uint16_t type, bool suffix)
             : payload_(),
-              codec_id_(codec_format_fourcc::hevc) {
+              codec_id_(codec_format_fourcc::hevc),
+              owned_(true) {
         ctor_helper(data, numBit, type, suffix);
     }
 
+    /// @brief Specialized contructor for the MPEG-2 codec's payload which references caller's memory.
+    /// @param[in] data Payload data. Must stay valid while the payload is used.
+    /// @param[in] size Payload data size in bytes
+    /// @param[in] numBit Payload data length in bits
+    payload(const uint8_t *data, uint16_t size, uint32_t numBit)
+            : payload_(),
+              codec_id_(codec_format_fourcc::mpeg2),
+              owned_(false) {
+        view_helper(data, size, numBit);
+    }
+
+    /// @brief Specialized contructor for the AVC codec's payload which references caller's memory.
+    /// @param[in] data Payload data. Must stay valid while the payload is used.
+    /// @param[in] size Payload data size in bytes
+    /// @param[in] numBit Payload data length in bits
+    /// @param[in] type SEI message type
+    payload(const uint8_t *data, uint16_t size, uint32_t numBit, uint16_t type)
+            : payload_(),
+              codec_id_(codec_format_fourcc::avc),
+              owned_(false) {
+        view_helper(data, size, numBit, type);
+    }
+
+    /// @brief Specialized contructor for the HEVC codec's payload which references caller's memory.
+    /// @param[in] data Payload data. Must stay valid while the payload is used.
+    /// @param[in] size Payload data size in bytes
+    /// @param[in] numBit Payload data length in bits
+    /// @param[in] type SEI message type
+    /// @param[in] suffix Boolean flag to attach data as suffix.
+    payload(const uint8_t *data, uint16_t size, uint32_t numBit, uint16_t type, bool suffix)
+            : payload_(),
+              codec_id_(codec_format_fourcc::hevc),
+              owned_(false) {
+        view_helper(data, size, numBit, type, suffix);
+    }
+
     /// @brief Dtor
     virtual ~payload() {
-        delete[] payload_.Data;
+        if (owned_)
+            delete[] payload_.Data;
         payload_.Data = 0;
     }
 
-    /// @brief Copy ctor.
+    /// @brief Copy ctor. Copy of the referencing payload references the same memory.
     /// @param[in] other Object to copy.
     payload(const payload& other) :
-        codec_id_(other.codec_id_) {
-        ctor_helper(other.get_payload_data(),
-                    other.payload_.NumBit,
-                    other.payload_.Type,
-                    other.payload_.CtrlFlags);
+        payload_(),
+        codec_id_(other.codec_id_),
+        owned_(other.owned_) {
+        if (owned_) {
+            ctor_helper(other.get_payload_data(),
+                        other.payload_.NumBit,
+                        other.payload_.Type,
+                        other.payload_.CtrlFlags);
+        }
+        else {
+            payload_ = other.payload_;
+        }
     }
 
     /// @brief Move ctor.
@@ -78,6 +130,7 @@ public:
         payload_.BufSize   = other.payload_.BufSize;
         payload_.Data      = other.payload_.Data;
         codec_id_ = other.codec_id_;
+        owned_    = other.owned_;
 
         other.payload_.Data = 0;
     }
@@ -89,14 +142,20 @@ public:
         if (&other == this)
             return *this;
 
-        if (this->payload_.Data)
+        if (owned_ && this->payload_.Data)
             delete[] this->payload_.Data;
 
-        ctor_helper(other.get_payload_data(),
-                    other.payload_.NumBit,
-                    other.payload_.Type,
-                    other.payload_.CtrlFlags);
+        if (other.owned_) {
+            ctor_helper(other.get_payload_data(),
+                        other.payload_.NumBit,
+                        other.payload_.Type,
+                        other.payload_.CtrlFlags);
+        }
+        else {
+            payload_ = other.payload_;
+        }
         codec_id_ = other.codec_id_;
+        owned_    = other.owned_;
         return *this;
     }
 
@@ -107,7 +166,7 @@ public:
         if (&other == this)
             return *this;
 
-        if (this->payload_.Data)
+        if (owned_ && this->payload_.Data)
             delete[] this->payload_.Data;
 
         payload_.Type      = other.payload_.Type;
@@ -116,6 +175,7 @@ public:
         payload_.BufSize   = other.payload_.BufSize;
         payload_.Data      = other.payload_.Data;
         codec_id_ = other.codec_id_;
+        owned_    = other.owned_;
         other.payload_.Data = 0;
         return *this;
     }
@@ -157,6 +217,37 @@ public:
         return std::vector<uint8_t>(payload_.Data, payload_.Data + payload_.BufSize);
     }
 
+    /// @brief Returns pointer to the payload data without copy
+    /// @return Pointer to the payload data
+    const uint8_t* get_data() const {
+        return payload_.Data;
+    }
+
+    /// @brief Returns payload data size in bytes
+    /// @return Payload data size in bytes
+    uint16_t get_size() const {
+        return payload_.BufSize;
+    }
+
+    /// @brief Checks that payload references caller's memory.
+    /// @return true if payload doesn't own the data.
+    bool is_view() const {
+        return !owned_;
+    }
+
+    /// @brief Makes referencing payload to reference other memory, for example data of the next frame.
+    /// Throws base_exception with MFX_ERR_UNDEFINED_BEHAVIOR status for payload which owns the data.
+    /// @param[in] data Payload data. Must stay valid while the payload is used.
+    /// @param[in] size Payload data size in bytes
+    /// @param[in] numBit Payload data length in bits
+    void set_data(const uint8_t *data, uint16_t size, uint32_t numBit) {
+        if (owned_)
+            throw(base_exception(MFX_ERR_UNDEFINED_BEHAVIOR));
+        payload_.Data    = const_cast<uint8_t *>(data);
+        payload_.BufSize = size;
+        payload_.NumBit  = numBit;
+    }
+
     /// @brief Returns pointer to the raw data
     /// @return Pointer to the raw data
     mfxPayload* get_raw_ptr() {
@@ -182,11 +273,156 @@ protected:
         payload_.Data    = new uint8_t[payload_.BufSize];
         std::copy(data.begin(), data.end(), payload_.Data);
     }
+
+    /// @brief Internal helper function for ctor of the referencing payload.
+    /// @param[in] data Payload data
+    /// @param[in] size Payload data size in bytes
+    /// @param[in] numBit Payload data length in bits
+    /// @param[in] type SEI message type
+    /// @param[in] suffix Boolean flag to attach data as suffix.
+    void view_helper(const uint8_t *data,
+                     uint16_t size,
+                     uint32_t numBit,
+                     uint16_t type = 0x01B2,
+                     bool suffix   = false) {
+        payload_.Type = type;
+        if (suffix) {
+            payload_.CtrlFlags = MFX_PAYLOAD_CTRL_SUFFIX;
+        }
+        payload_.NumBit  = numBit;
+        payload_.BufSize = size;
+        payload_.Data    = const_cast<uint8_t *>(data);
+    }
+
     /// @brief Raw data
     mfxPayload payload_;
 
     /// @brief Codec FourCC code
     codec_format_fourcc codec_id_;
+
+    /// @brief Payload owns the data
+    bool owned_;
+};
+
+/// @brief Move-only handle to the payload retrieved from the decoder. Decoder writes the payload into the buffer
+/// of the pool, so retrieving payloads of every frame doesn't allocate memory. Buffer is returned to the pool
+/// when handle is destroyed.
+class decoded_payload {
+public:
+    /// @brief Largest payload the decoder can return.
+    static constexpr uint32_t max_size = 0xFFFF;
+
+    /// @brief Default ctor. Creates empty handle.
+    decoded_payload() : pool_(), payload_(), capacity_(0), time_stamp_(MFX_TIMESTAMP_UNKNOWN) {}
+
+    /// @brief Constructs handle with the buffer from the pool.
+    /// @param[in] pool Pool to take buffer from. Buffers of max_size fit any payload, payloads larger than
+    /// the buffer aren't retrieved.
+    explicit decoded_payload(std::shared_ptr<bitstream_buffer_pool> pool)
+            : pool_(std::move(pool)),
+              payload_(),
+              capacity_(pool_->get_capacity()),
+              time_stamp_(MFX_TIMESTAMP_UNKNOWN) {
+        payload_.Data    = pool_->acquire();
+        payload_.BufSize = static_cast<uint16_t>(std::min(capacity_, max_size));
+    }
+
+    /// @brief Move ctor
+    /// @param[in] other another object to use as data source
+    decoded_payload(decoded_payload&& other) noexcept : decoded_payload() {
+        swap(other);
+    }
+
+    /// @brief Move operator
+    /// @param[in] other another object to use as data source
+    /// @returns Reference to this object
+    decoded_payload& operator=(decoded_payload&& other) noexcept {
+        decoded_payload tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    decoded_payload(const decoded_payload&)            = delete;
+    decoded_payload& operator=(const decoded_payload&) = delete;
+
+    /// @brief Dtor. Returns buffer to the pool.
+    ~decoded_payload() {
+        if (pool_)
+            pool_->release(payload_.Data, capacity_);
+    }
+
+    /// @brief Checks that decoder returned payload.
+    /// @return true if there is no payload.
+    bool empty() const {
+        return payload_.NumBit == 0;
+    }
+
+    /// @brief Returns pointer to the payload data.
+    /// @return Pointer to the payload data.
+    const uint8_t* data() const {
+        return payload_.Data;
+    }
+
+    /// @brief Returns payload data size in bytes.
+    /// @return Payload data size in bytes.
+    uint32_t size() const {
+        return (payload_.NumBit + 7) / 8;
+    }
+
+    /// @brief Returns number of bits in the payload
+    /// @return Number of bits in the payload
+    uint32_t get_num_bits() const {
+        return payload_.NumBit;
+    }
+
+    /// @brief Returns SEI message type for AVC and HEVC codecs.
+    /// @return SEI message type.
+    uint16_t get_type() const {
+        return payload_.Type;
+    }
+
+    /// @brief Returns boolean suffix flag for HEVC codec.
+    /// @return boolean suffix flag.
+    bool is_suffix() const {
+        return payload_.CtrlFlags == MFX_PAYLOAD_CTRL_SUFFIX;
+    }
+
+    /// @brief Returns time stamp of the frame with the payload.
+    /// @return Time stamp.
+    uint64_t get_TimeStamp() const {
+        return time_stamp_;
+    }
+
+    /// @brief Returns pointer to the raw data
+    /// @return Pointer to the raw data
+    mfxPayload* get_raw_ptr() {
+        return &payload_;
+    }
+
+    /// @brief Returns pointer to the time stamp to fill
+    /// @return Pointer to the time stamp
+    mfxU64* get_raw_time_stamp_ptr() {
+        return &time_stamp_;
+    }
+
+protected:
+    /// @brief Exchanges state with other handle.
+    /// @param[in] other another object
+    void swap(decoded_payload& other) noexcept {
+        std::swap(pool_, other.pool_);
+        std::swap(payload_, other.payload_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(time_stamp_, other.time_stamp_);
+    }
+
+    /// Pool to return buffer to.
+    std::shared_ptr<bitstream_buffer_pool> pool_;
+    /// Raw data.
+    mfxPayload payload_;
+    /// Size of the buffer.
+    uint32_t capacity_;
+    /// Time stamp of the frame.
+    mfxU64 time_stamp_;
 };
 
 } // namespace vpl
@@ -0,0 +1,351 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "vpl/preview/bitstream.hpp"
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/exception.hpp"
+#include "vpl/preview/frame_surface.hpp"
+#include "vpl/preview/future.hpp"
+#include "vpl/preview/session.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Connects decode session, optional chain of VPP sessions and optional encode session into the
+/// pipeline. Frames are passed between stages without syncronization, so GPU work of different stages
+/// overlaps. Synchronization happens only at the sink, when the number of frames in flight exceeds the
+/// configured async depth. Sessions must outlive the pipeline object.
+/// @tparam Reader Type of the bitstream reader of the decode session.
+template <typename Reader>
+class pipeline {
+public:
+    /// @brief Callback to receive processed frames when pipeline has no encoder.
+    using frame_sink = std::function<void(std::shared_ptr<frame_surface>)>;
+    /// @brief Callback to receive encoded bitstream portions.
+    using bitstream_sink = std::function<void(std::shared_ptr<bitstream_as_dst>)>;
+
+    /// @brief Constructs pipeline with the decoder as the source.
+    /// @param[in] decoder Initialized decode session.
+    /// @param[in] async_depth Maximum number of frames in flight.
+    explicit pipeline(decode_session<Reader> &decoder, std::size_t async_depth = 4)
+            : decoder_(decoder),
+              vpps_(),
+              encoder_(nullptr),
+              encoder_list_(),
+              frame_sink_(),
+              bitstream_sink_(),
+              async_depth_(async_depth ? async_depth : 1),
+              in_flight_(),
+              joined_(false),
+              done_(false),
+              n_delivered_(0),
+              wrapper_pool_() {}
+
+    pipeline(const pipeline &)            = delete;
+    pipeline &operator=(const pipeline &) = delete;
+
+    /// @brief Dtor. Disjoins sessions if they were joined.
+    ~pipeline() {
+        if (joined_) {
+            try {
+                disjoin_sessions();
+            }
+            catch (base_exception &) {
+            }
+        }
+    }
+
+    /// @brief Appends VPP session to the chain of VPP stages.
+    /// @param[in] vpp Initialized VPP session.
+    /// @return Reference to this object.
+    pipeline &add_vpp(vpp_session &vpp) {
+        if (joined_)
+            throw base_exception("Can't add stage to the joined pipeline", MFX_ERR_UNDEFINED_BEHAVIOR);
+        vpps_.push_back(&vpp);
+        return *this;
+    }
+
+    /// @brief Sets encoder as the last stage of the pipeline.
+    /// @param[in] encoder Initialized encode session.
+    /// @param[in] sink Callback to receive encoded bitstream portions.
+    /// @param[in] list List of extension buffers to use for each frame.
+    /// @return Reference to this object.
+    pipeline &set_encoder(encode_session &encoder,
+                          bitstream_sink sink,
+                          encoder_process_list list = {}) {
+        if (joined_)
+            throw base_exception("Can't add stage to the joined pipeline", MFX_ERR_UNDEFINED_BEHAVIOR);
+        encoder_        = &encoder;
+        bitstream_sink_ = std::move(sink);
+        encoder_list_   = list;
+        return *this;
+    }
+
+    /// @brief Sets callback to receive processed frames. Used when pipeline has no encoder.
+    /// @param[in] sink Callback to receive frames. Frames are synchronized before delivery.
+    /// @return Reference to this object.
+    pipeline &set_frame_sink(frame_sink sink) {
+        frame_sink_ = std::move(sink);
+        return *this;
+    }
+
+    /// @brief Joins VPP and encode sessions to the decode session, so all stages share one scheduler.
+    /// @return Status of the join operation.
+    status join_sessions() {
+        if (joined_)
+            return status::Ok;
+        for (auto vpp : vpps_)
+            decoder_.join(*vpp);
+        if (encoder_)
+            decoder_.join(*encoder_);
+        joined_ = true;
+        return status::Ok;
+    }
+
+    /// @brief Disjoins sessions joined by join_sessions.
+    /// @return Status of the disjoin operation.
+    status disjoin_sessions() {
+        if (!joined_)
+            return status::Ok;
+        joined_ = false;
+        for (auto vpp : vpps_)
+            vpp->disjoin();
+        if (encoder_)
+            encoder_->disjoin();
+        return status::Ok;
+    }
+
+    /// @brief Decodes one portion of the input and pushes resulting frame through all stages. Delivers oldest
+    /// outputs to the sink when more than async depth frames are in flight.
+    /// @return status::Ok when there is more data to process, status::EndOfStreamReached when the pipeline is
+    /// drained and all outputs are delivered, or warning reported by the stage.
+    status process() {
+        if (done_)
+            return status::EndOfStreamReached;
+
+        std::shared_ptr<frame_surface> surface = wrapper_pool_.make();
+        status sts = submit([&]() {
+            return decoder_.decode_frame(surface);
+        });
+
+        switch (sts) {
+            case status::Ok:
+                return push_to_stage(0, surface);
+            case status::NotEnoughData:
+                return status::Ok;
+            case status::EndOfStreamReached:
+                sts = drain();
+                if (sts != status::Ok)
+                    return sts;
+                flush();
+                done_ = true;
+                return status::EndOfStreamReached;
+            default:
+                return sts;
+        }
+    }
+
+    /// @brief Processes all input data and delivers all outputs.
+    /// @return status::EndOfStreamReached on success or warning reported by the stage.
+    status run() {
+        status sts;
+        do {
+            sts = process();
+        } while (sts == status::Ok);
+        return sts;
+    }
+
+    /// @brief Syncronizes and delivers all outputs which are in flight.
+    void flush() {
+        while (!in_flight_.empty())
+            deliver_oldest();
+    }
+
+    /// @brief Provides number of outputs delivered to the sink.
+    /// @return Number of delivered outputs.
+    std::size_t get_delivered_count() const {
+        return n_delivered_;
+    }
+
+protected:
+    /// @brief Output of the pipeline which is not synchronized yet.
+    struct pending_output {
+        /// Frame when pipeline has no encoder.
+        std::shared_ptr<frame_surface> frame_;
+        /// Bitstream portion otherwise.
+        std::shared_ptr<bitstream_as_dst> bits_;
+    };
+
+    /// @brief Calls processing function while device is busy. Oldest output in flight is synchronized to
+    /// free device resources before the retry.
+    /// @param[in] fn Processing function.
+    /// @return Status of the processing function.
+    template <typename F>
+    status submit(F fn) {
+        status sts;
+        while ((sts = fn()) == status::DeviceBusy) {
+            if (!in_flight_.empty())
+                deliver_oldest();
+            else
+                std::this_thread::sleep_for(detail::completion_poll_period);
+        }
+        return sts;
+    }
+
+    /// @brief Pushes frame to the given stage. Stage after VPP chain is encoder or sink.
+    /// @param[in] idx Index of the VPP stage.
+    /// @param[in] surface Frame to process.
+    /// @return status::Ok or warning reported by the stage.
+    status push_to_stage(std::size_t idx, std::shared_ptr<frame_surface> surface) {
+        if (idx == vpps_.size()) {
+            if (encoder_)
+                return encode(surface);
+            enqueue({ surface, nullptr });
+            return status::Ok;
+        }
+        return process_vpp(idx, surface);
+    }
+
+    /// @brief Runs VPP stage and pushes all of its outputs to the next stage.
+    /// @param[in] idx Index of the VPP stage.
+    /// @param[in] surface Frame to process. nullptr to drain the stage.
+    /// @return status::Ok or warning reported by the stage.
+    status process_vpp(std::size_t idx, std::shared_ptr<frame_surface> surface) {
+        while (true) {
+            std::shared_ptr<frame_surface> out = wrapper_pool_.make();
+            status sts = submit([&]() {
+                return vpps_[idx]->process_frame(surface, out);
+            });
+
+            switch (sts) {
+                case status::Ok:
+                    sts = push_to_stage(idx + 1, out);
+                    // in drain mode each call returns single buffered frame
+                    if (sts != status::Ok || surface)
+                        return sts;
+                    break;
+                case status::NotEnoughSurface:
+                    // more output is available for the same input
+                    sts = push_to_stage(idx + 1, out);
+                    if (sts != status::Ok)
+                        return sts;
+                    break;
+                case status::NotEnoughData:
+                case status::EndOfStreamReached:
+                    return status::Ok;
+                default:
+                    return sts;
+            }
+        }
+    }
+
+    /// @brief Runs encoder and stores its outputs in flight.
+    /// @param[in] surface Frame to encode. nullptr to drain the encoder.
+    /// @return status::Ok or warning reported by the encoder.
+    status encode(std::shared_ptr<frame_surface> surface) {
+        std::shared_ptr<bitstream_as_dst> bits = std::make_shared<bitstream_as_dst>();
+
+        while (true) {
+            status sts = submit([&]() {
+                return encoder_->encode_frame(surface, bits, encoder_list_);
+            });
+
+            switch (sts) {
+                case status::Ok:
+                    enqueue({ nullptr, bits });
+                    // in drain mode each call returns single buffered bitstream portion
+                    if (surface)
+                        return status::Ok;
+                    bits = std::make_shared<bitstream_as_dst>();
+                    break;
+                case status::NotEnoughBuffer:
+                    bits->realloc();
+                    break;
+                case status::NotEnoughData:
+                case status::EndOfStreamReached:
+                    return status::Ok;
+                default:
+                    return sts;
+            }
+        }
+    }
+
+    /// @brief Drains stages one by one starting from the first VPP stage.
+    /// @return status::Ok or warning reported by the stage.
+    status drain() {
+        for (std::size_t idx = 0; idx < vpps_.size(); idx++) {
+            status sts = process_vpp(idx, nullptr);
+            if (sts != status::Ok)
+                return sts;
+        }
+        if (encoder_)
+            return encode(nullptr);
+        return status::Ok;
+    }
+
+    /// @brief Stores output in flight and delivers oldest ones above async depth.
+    /// @param[in] out Output to store.
+    void enqueue(pending_output out) {
+        in_flight_.push_back(std::move(out));
+        while (in_flight_.size() > async_depth_)
+            deliver_oldest();
+    }
+
+    /// @brief Syncronizes oldest output and delivers it to the sink.
+    void deliver_oldest() {
+        pending_output out = std::move(in_flight_.front());
+        in_flight_.pop_front();
+
+        if (out.bits_) {
+            out.bits_->wait();
+            if (bitstream_sink_)
+                bitstream_sink_(out.bits_);
+        }
+        else {
+            out.frame_->wait();
+            if (frame_sink_)
+                frame_sink_(out.frame_);
+        }
+        n_delivered_++;
+    }
+
+    /// Source of the pipeline.
+    decode_session<Reader> &decoder_;
+    /// Chain of VPP stages.
+    std::vector<vpp_session *> vpps_;
+    /// Optional encoder stage.
+    encode_session *encoder_;
+    /// List of extension buffers for the encoder.
+    encoder_process_list encoder_list_;
+    /// Sink for the frames.
+    frame_sink frame_sink_;
+    /// Sink for the bitstream portions.
+    bitstream_sink bitstream_sink_;
+    /// Maximum number of outputs in flight.
+    std::size_t async_depth_;
+    /// Outputs in flight, oldest first.
+    std::deque<pending_output> in_flight_;
+    /// Flag indicating that sessions are joined.
+    bool joined_;
+    /// Flag indicating that all data is processed.
+    bool done_;
+    /// Number of outputs delivered to the sink.
+    std::size_t n_delivered_;
+    /// Pool of the frame wrappers passed between stages.
+    frame_surface_pool wrapper_pool_;
+};
+
+} // namespace vpl
+} // namespace oneapi
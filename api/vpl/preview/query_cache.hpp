@@ -0,0 +1,198 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vpl/mfxstructures.h"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Cache of Query and QueryIOSurf results shared by the sessions which are created with identical
+/// parameters. Cache is opt-in: it is used by the sessions it is attached to with session::set_query_cache.
+/// Results are keyed by the component, implementation, API version and contents of the video params
+/// together with their extension buffers. Extension buffers are compared byte by byte in the order of
+/// buffer IDs, so buffers which hold pointers are matched by the pointer values. Only successful calls
+/// are cached.
+class query_cache {
+public:
+    /// @brief Constructs empty cache.
+    query_cache() : lock_(), entries_() {}
+
+    query_cache(const query_cache &)            = delete;
+    query_cache &operator=(const query_cache &) = delete;
+
+    /// @brief Builds canonical key of the call.
+    /// @param[in] domain Component ID.
+    /// @param[in] impl Implementation of the session.
+    /// @param[in] version API version of the implementation.
+    /// @param[in] in Input parameters.
+    /// @param[in] out Output parameters of the Query call, only layout of their extension buffers is
+    /// taken. Can be nullptr.
+    /// @return Key of the call.
+    static std::string make_key(uint32_t domain,
+                                mfxIMPL impl,
+                                mfxVersion version,
+                                const mfxVideoParam *in,
+                                const mfxVideoParam *out = nullptr) {
+        std::string key;
+        append(key, &domain, sizeof(domain));
+        append(key, &impl, sizeof(impl));
+        append(key, &version.Version, sizeof(version.Version));
+
+        mfxVideoParam par = *in;
+        par.ExtParam      = nullptr;
+        par.NumExtParam   = 0;
+        append(key, &par, sizeof(par));
+
+        std::vector<const mfxExtBuffer *> buffers;
+        for (uint16_t i = 0; in->ExtParam && i < in->NumExtParam; i++) {
+            if (in->ExtParam[i])
+                buffers.push_back(in->ExtParam[i]);
+        }
+        std::stable_sort(buffers.begin(),
+                         buffers.end(),
+                         [](const mfxExtBuffer *a, const mfxExtBuffer *b) {
+                             return a->BufferId < b->BufferId;
+                         });
+        for (const mfxExtBuffer *buffer : buffers)
+            append(key, buffer, buffer->BufferSz);
+
+        uint16_t num_out = (out && out->ExtParam) ? out->NumExtParam : 0;
+        append(key, &num_out, sizeof(num_out));
+        for (uint16_t i = 0; i < num_out; i++) {
+            const mfxExtBuffer *buffer = out->ExtParam[i];
+            mfxExtBuffer header        = buffer ? *buffer : mfxExtBuffer{};
+            append(key, &header, sizeof(header));
+        }
+        return key;
+    }
+
+    /// @brief Looks for the cached Query result and copies it to the output parameters.
+    /// @param[in] key Key of the call.
+    /// @param[out] out Output parameters, extension buffers attached to them are filled as well.
+    /// @param[out] sts Status of the cached call.
+    /// @return True if the result is found.
+    bool find_query(const std::string &key, mfxVideoParam *out, mfxStatus &sts) const {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = entries_.find(key);
+        if (it == entries_.end() || !it->second.has_query)
+            return false;
+
+        const entry &e     = it->second;
+        mfxExtBuffer **ext = out->ExtParam;
+        uint16_t num_ext   = out->NumExtParam;
+        *out               = e.query_out;
+        out->ExtParam      = ext;
+        out->NumExtParam   = num_ext;
+        for (uint16_t i = 0; ext && i < num_ext && i < e.query_ext.size(); i++) {
+            if (ext[i])
+                std::memcpy(ext[i], e.query_ext[i].data(), e.query_ext[i].size());
+        }
+        sts = e.query_sts;
+        return true;
+    }
+
+    /// @brief Stores Query result.
+    /// @param[in] key Key of the call.
+    /// @param[in] out Output parameters of the call.
+    /// @param[in] sts Status of the call.
+    void store_query(const std::string &key, const mfxVideoParam *out, mfxStatus sts) {
+        if (sts < MFX_ERR_NONE)
+            return;
+
+        std::lock_guard<std::mutex> lock(lock_);
+        entry &e    = entries_[key];
+        e.has_query = true;
+        e.query_sts = sts;
+        e.query_out = *out;
+        e.query_ext.clear();
+        for (uint16_t i = 0; out->ExtParam && i < out->NumExtParam; i++) {
+            const mfxExtBuffer *buffer = out->ExtParam[i];
+            e.query_ext.emplace_back();
+            if (buffer)
+                append(e.query_ext.back(), buffer, buffer->BufferSz);
+        }
+    }
+
+    /// @brief Looks for the cached QueryIOSurf result.
+    /// @param[in] key Key of the call.
+    /// @param[out] request Frame allocation requests.
+    /// @param[out] sts Status of the cached call.
+    /// @return True if the result is found.
+    bool find_alloc_request(const std::string &key,
+                            std::vector<mfxFrameAllocRequest> &request,
+                            mfxStatus &sts) const {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto it = entries_.find(key);
+        if (it == entries_.end() || it->second.request.empty())
+            return false;
+
+        request = it->second.request;
+        sts     = it->second.request_sts;
+        return true;
+    }
+
+    /// @brief Stores QueryIOSurf result.
+    /// @param[in] key Key of the call.
+    /// @param[in] request Frame allocation requests returned by the call.
+    /// @param[in] sts Status of the call.
+    void store_alloc_request(const std::string &key,
+                             const std::vector<mfxFrameAllocRequest> &request,
+                             mfxStatus sts) {
+        if (sts < MFX_ERR_NONE)
+            return;
+
+        std::lock_guard<std::mutex> lock(lock_);
+        entry &e      = entries_[key];
+        e.request     = request;
+        e.request_sts = sts;
+    }
+
+    /// @brief Retrieves number of cached parameter sets.
+    /// @return Number of cached parameter sets.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(lock_);
+        return entries_.size();
+    }
+
+    /// @brief Drops all cached results, e.g. after the device is changed.
+    void clear() {
+        std::lock_guard<std::mutex> lock(lock_);
+        entries_.clear();
+    }
+
+protected:
+    /// @brief Results of the calls with one set of parameters.
+    struct entry {
+        bool has_query                            = false;
+        mfxStatus query_sts                       = MFX_ERR_NONE;
+        mfxVideoParam query_out                   = {};
+        std::vector<std::string> query_ext        = {};
+        std::vector<mfxFrameAllocRequest> request = {};
+        mfxStatus request_sts                     = MFX_ERR_NONE;
+    };
+
+    /// @brief Appends raw bytes to the key.
+    static void append(std::string &key, const void *data, size_t size) {
+        key.append(static_cast<const char *>(data), size);
+    }
+
+    /// @brief Guards the entries.
+    mutable std::mutex lock_;
+    /// @brief Cached results, hashed by contents of the keys.
+    std::unordered_map<std::string, entry> entries_;
+};
+
+} // namespace vpl
+} // namespace oneapi
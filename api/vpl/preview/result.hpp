@@ -0,0 +1,77 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include "vpl/mfxdefs.h"
+
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/exception.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Result of the operation which doesn't throw. Holds either the status of the successful operation,
+/// including warnings and statuses like status::NotEnoughData, or the error code of the failed one.
+class operation_result {
+public:
+    /// @brief Constructs result of the successful operation.
+    /// @param[in] sts Operation status.
+    constexpr operation_result(status sts = status::Ok) noexcept
+            : status_(sts),
+              error_(MFX_ERR_NONE) {}
+
+    /// @brief Constructs result of the failed operation.
+    /// @param[in] err Error code.
+    /// @return Result object.
+    static constexpr operation_result error(mfxStatus err) noexcept {
+        operation_result r(status::Unknown);
+        r.error_ = err;
+        return r;
+    }
+
+    /// @brief Checks that operation didn't fail.
+    /// @return True if operation succeeded.
+    explicit constexpr operator bool() const noexcept {
+        return error_ == MFX_ERR_NONE;
+    }
+
+    /// @brief Checks that operation failed.
+    /// @return True if operation failed.
+    constexpr bool has_error() const noexcept {
+        return error_ != MFX_ERR_NONE;
+    }
+
+    /// @brief Provides status of the operation.
+    /// @return Operation status or status::Unknown if operation failed.
+    constexpr status get_status() const noexcept {
+        return status_;
+    }
+
+    /// @brief Provides error code of the failed operation.
+    /// @return Error code or MFX_ERR_NONE if operation succeeded.
+    constexpr mfxStatus get_error() const noexcept {
+        return error_;
+    }
+
+    /// @brief Provides status of the successful operation. Throws base_exception with the error code if
+    /// operation failed.
+    /// @return Operation status.
+    status value() const {
+        if (has_error())
+            throw base_exception(error_);
+        return status_;
+    }
+
+protected:
+    /// @brief Operation status
+    status status_;
+    /// @brief Error code
+    mfxStatus error_;
+};
+
+} // namespace vpl
+} // namespace oneapi
@@ -10,28 +10,29 @@
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <new>
+#include <thread>
+#include <vector>
 
 #include "vpl/preview/defs.hpp"
+#include "vpl/preview/device_context.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/preview/extension_buffer_list.hpp"
 #include "vpl/preview/frame_surface.hpp"
 #include "vpl/preview/future.hpp"
 #include "vpl/preview/impl_selector.hpp"
+#include "vpl/preview/payload.hpp"
+#include "vpl/preview/query_cache.hpp"
+#include "vpl/preview/result.hpp"
 #include "vpl/preview/source_reader.hpp"
 #include "vpl/preview/stat.hpp"
+#include "vpl/preview/surface_pool.hpp"
 #include "vpl/preview/video_param.hpp"
 
 #include "vpl/mfxvideo.h"
 
 #include "vpl/preview/detail/sdk_callable.hpp"
 
-#ifdef LIBVA_SUPPORT
-  #include "va/va.h"
-  #include "va/va_drm.h"
-  #include <fcntl.h>
-  #include <unistd.h>
-#endif
-
 namespace oneapi {
 namespace vpl {
 
@@ -53,11 +54,17 @@ protected:
     /// @brief Protected ctor. Creates session by using supplyed implementation selector.
     /// @param[in] sel Implementation selector
     /// @param[in] callable C API functions table
-    session(const implementation_selector &sel, detail::sdk_c_api callable)
+    /// @param[in] ctx Device context to share with other sessions. If nullptr, session creates own
+    /// device when implementation requires it.
+    session(const implementation_selector &sel,
+            detail::sdk_c_api callable,
+            std::shared_ptr<device_context> ctx = nullptr)
             : c_api_callable_(callable),
               state_(state::Processing),
               component_(component::unknown),
-              accelerator_handle(nullptr) {
+              latency_(std::make_shared<latency_stat>()),
+              device_(ctx),
+              query_cache_() {
         auto [l_, s_]  = sel.session();
         this->loader_  = l_;
         this->session_ = s_;        
@@ -71,16 +78,23 @@ protected:
         if (sts != MFX_ERR_NONE) {
             this->version_ = { { 0, 0 } };
         }
-        init_accelerator_handle();
+        try {
+            init_accelerator_handle();
+        }
+        catch (...) {
+            MFXClose(this->session_);
+            throw;
+        }
     }
 
 public:
-    /// @brief Dtor. Additionaly it closes loader.
+    /// @brief Dtor. Additionaly it releases loader. Loader is unloaded with the last session created
+    /// from it.
     virtual ~session() {
         c_api_callable_.close(session_);
         MFXClose(session_);
-        MFXUnload(loader_);
-        free_accelerator_handle();
+        loader_.reset();
+        device_.reset();
     }
 
     /// @brief Returns implementation capabilities.
@@ -100,12 +114,69 @@ public:
     /// @return Corrected implementation capabilities.
     std::shared_ptr<VideoParams> Verify(VideoParams *param) {
         std::shared_ptr<VideoParams> out = std::make_shared<VideoParams>();
-        [[maybe_unused]] detail::c_api_invoker e(
+        std::string key;
+        if (query_cache_) {
+            key = query_cache::make_key((uint32_t)component_,
+                                        selected_impl_,
+                                        version_,
+                                        param->getMfx(),
+                                        out->getMfx());
+            mfxStatus sts;
+            if (query_cache_->find_query(key, out->getMfx(), sts))
+                return out;
+        }
+        detail::c_api_invoker e(
             detail::default_checker,
             std::bind(c_api_callable_.query, session_, param->getMfx(), out->getMfx()));
+        if (query_cache_)
+            query_cache_->store_query(key, out->getMfx(), e.sts_);
         return out;
     }
 
+    /// @brief Queries minimum and suggested number of surfaces the component needs with the given parameters.
+    /// @param[in] par Parameters.
+    /// @param[in] list List of extension buffers for Init stage.
+    /// @return Frame allocation requests. VPP returns requests for input and output surfaces.
+    std::vector<mfxFrameAllocRequest> query_frame_alloc_request(VideoParams *par, InitList list = {}) {
+        if (list.get_size()) {
+            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+                par->set_extension_buffers(buffers, static_cast<uint16_t>(size));
+            }
+        }
+
+        std::vector<mfxFrameAllocRequest> request(component_ == component::vpp ? 2 : 1);
+        std::string key;
+        mfxStatus sts;
+        if (query_cache_) {
+            key = query_cache::make_key((uint32_t)component_, selected_impl_, version_, par->getMfx());
+            if (query_cache_->find_alloc_request(key, request, sts)) {
+                par->clear_extension_buffers();
+                return request;
+            }
+        }
+
+        sts = c_api_callable_.query_iosurf(session_, par->getMfx(), request.data());
+        par->clear_extension_buffers();
+        if (detail::default_checker(sts))
+            throw base_exception(sts);
+        if (query_cache_)
+            query_cache_->store_alloc_request(key, request, sts);
+        return request;
+    }
+
+    /// @brief Attaches cache of Query and QueryIOSurf results. Sessions created with identical parameters
+    /// share one cache to skip repeated validation calls.
+    /// @param[in] cache Cache to attach, nullptr detaches it.
+    void set_query_cache(std::shared_ptr<query_cache> cache) {
+        query_cache_ = cache;
+    }
+
+    /// @brief Provides cache of Query and QueryIOSurf results attached to the session.
+    /// @return Shared pointer to the cache or nullptr.
+    std::shared_ptr<query_cache> get_query_cache() const {
+        return query_cache_;
+    }
+
     /// @brief Initializes the session by using provided parameters
     /// @param[in] par Init parameters
     /// @param[in] list List of extension buffers.
@@ -171,7 +242,86 @@ public:
         return version_;
     }
 
+    /// @brief Retrieves latency and throughput statistic of the operations submitted by the process
+    /// method. Statistic is updated while the returned future objects complete.
+    /// @return Latency statistic
+    std::shared_ptr<latency_stat> get_latency_stat() const {
+        return latency_;
+    }
+
+    /// @brief Provides device context the session is bound to.
+    /// @return Shared pointer to the device context or nullptr if implementation doesn't use one.
+    std::shared_ptr<device_context> get_device_context() const {
+        return device_;
+    }
+
+    /// @brief Restarts latency statistic with the new throughput window.
+    /// @param[in] window Duration of the sliding window to calculate throughput over.
+    void set_latency_window(std::chrono::milliseconds window) {
+        latency_ = std::make_shared<latency_stat>(window);
+    }
+
+    /// @brief Joins other session to this one. Joined sessions share single scheduler, so processing in
+    /// one session may overlap processing in another one without syncronization between them.
+    /// @param[in] child Session to join. Must be disjoined before it or this session is destroyed.
+    /// @return Status of the join operation.
+    template <typename V, typename I, typename R>
+    status join(session<V, I, R> &child) {
+        detail::c_api_invoker e(detail::default_checker,
+                                MFXJoinSession,
+                                session_,
+                                child.session_);
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+    /// @brief Disjoins this session from the session it was joined to.
+    /// @return Status of the disjoin operation.
+    status disjoin() {
+        detail::c_api_invoker e(detail::default_checker, MFXDisjoinSession, session_);
+        return mfxstatus_to_onevplstatus(e.sts_);
+    }
+
 protected:
+    template <typename V, typename I, typename R>
+    friend class session;
+
+    /// @brief Obtains surface pool of the component via surface allocated from it.
+    /// @param[in] alloc C API function to allocate surface from the pool.
+    /// @return Shared pointer to the pool object.
+    template <typename F>
+    std::shared_ptr<surface_pool> query_surface_pool(F alloc) {
+        mfxFrameSurface1 *surface = nullptr;
+        detail::c_api_invoker e(detail::default_checker, alloc, session_, &surface);
+
+        std::shared_ptr<surface_pool> pool;
+        try {
+            pool = std::make_shared<surface_pool>(surface);
+        }
+        catch (base_exception &) {
+            surface->FrameInterface->Release(surface);
+            throw;
+        }
+        surface->FrameInterface->Release(surface);
+        return pool;
+    }
+
+    /// @brief Records latency of the submitted operation once its future object completes.
+    /// @param[in] f Future object of the operation.
+    /// @param[in] op Status of the operation.
+    /// @param[in] start Time of the submission.
+    template <typename T>
+    void track_latency(std::shared_ptr<future<T>> f,
+                       const operation_status &op,
+                       std::chrono::steady_clock::time_point start) {
+        if (op.schedule_status_ != status::Ok)
+            return;
+        std::shared_ptr<latency_stat> stat = latency_;
+        f->on_complete([stat, start](async_op_status sts) {
+            if (sts == async_op_status::ready)
+                stat->record(std::chrono::steady_clock::now() - start);
+        });
+    }
+
     /// @brief Session handle.
     mfxSession session_;
     /// @brief Functions table.
@@ -187,48 +337,45 @@ protected:
     /// @brief Version of implementation
     mfxVersion version_;
 
-    /// @brief accelorator file handle
-    int fd_;
+    /// @brief Pool of the frame_surface wrappers created by the session
+    frame_surface_pool wrapper_pool_;
+
+    /// @brief Latency statistic of the operations submitted by process method
+    std::shared_ptr<latency_stat> latency_;
+
+    /// @brief Device context the session is bound to
+    std::shared_ptr<device_context> device_;
 
+    /// @brief Cache of Query and QueryIOSurf results, nullptr if not attached
+    std::shared_ptr<query_cache> query_cache_;
+
+    /// @brief Binds session to the device context. Context provided by the user is mandatory, so
+    /// errors are thrown. Otherwise session creates own VADisplay for VAAPI implementations and
+    /// leaves device selection to the implementation if it fails.
     void init_accelerator_handle() {
+        if (device_) {
+            device_->bind(session_);
+            return;
+        }
+
+#ifdef LIBVA_SUPPORT
         mfxIMPL impl;
         mfxStatus sts = MFXQueryIMPL(session_, &impl);
         if (sts != MFX_ERR_NONE)
             return;
 
-        #ifdef LIBVA_SUPPORT
         if ((impl & MFX_IMPL_VIA_VAAPI) == MFX_IMPL_VIA_VAAPI) {
-            VADisplay va_dpy = NULL;
-            // initialize VAAPI context and set session handle (req in Linux)
-            fd_ = open("/dev/dri/renderD128", O_RDWR);
-            if (fd_ >= 0) {
-                va_dpy = vaGetDisplayDRM(fd_);
-                if (va_dpy) {
-                    int major_version = 0, minor_version = 0;
-                    if (VA_STATUS_SUCCESS == vaInitialize(va_dpy, &major_version, &minor_version)) {
-                        MFXVideoCORE_SetHandle(session_,
-                                            static_cast<mfxHandleType>(MFX_HANDLE_VA_DISPLAY),
-                                            va_dpy);
-                    }
-                }
+            try {
+                device_ = device_context::create_va_display();
+                device_->bind(session_);
+            }
+            catch (std::exception &) {
+                device_.reset();
             }
-            accelerator_handle = va_dpy;
         }
-        #endif
-    }
-
-    void free_accelerator_handle() {
-        #ifdef LIBVA_SUPPORT
-            vaTerminate((VADisplay)accelerator_handle);
-            accelerator_handle = nullptr;
-            close(fd_);
-        #endif
+#endif
     }
 
-
-    /// @brief Accelerator handle
-    void *accelerator_handle;
-
     /// @brief Convert MFX_ return codes to oneVPL status
     /// @return oneVPL status code
     static status mfxstatus_to_onevplstatus(mfxStatus s) {
@@ -270,7 +417,7 @@ protected:
     }
 
 private:
-    mfxLoader loader_;
+    shared_loader loader_;
 };
 
 /// @brief Manages decoder's sessions.
@@ -284,8 +431,12 @@ public:
     /// @param[in] sel Implementation selector
     /// @param[in] codecID Codec ID
     /// @param[in] rdr Bitstream reader
-    decode_session(const implementation_selector &sel, codec_format_fourcc codecID, Reader *rdr)
-            : session(sel, detail::CAPI<>::Decoder),
+    /// @param[in] ctx Device context to share with other sessions
+    decode_session(const implementation_selector &sel,
+                   codec_format_fourcc codecID,
+                   Reader *rdr,
+                   std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::Decoder, ctx),
               bits_(codecID),
               rdr_(rdr),
               params_() {
@@ -298,10 +449,12 @@ public:
     /// @param[in] sel Implementation selector
     /// @param[in] params Video params
     /// @param[in] rdr Bitstream reader
+    /// @param[in] ctx Device context to share with other sessions
     decode_session(const implementation_selector &sel,
                    const decoder_video_param &params,
-                   Reader *rdr)
-            : session(sel, detail::CAPI<>::Decoder),
+                   Reader *rdr,
+                   std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::Decoder, ctx),
               bits_((codec_format_fourcc)params.get_CodecId()),
               rdr_(rdr),
               params_(params) {
@@ -363,61 +516,28 @@ public:
     /// @return Ok or warning
     status decode_frame(std::shared_ptr<frame_surface> out_surface,
                         decoder_process_list list = {}) {
-        mfxSyncPoint syncp;
-        mfxFrameSurface1 *surf = NULL;
-
-        rdr_->get_data(&bits_);
+        return submit_bitstream(next_bitstream(list), out_surface).value();
+    }
 
+    /// @brief Decodes frame without throwing exceptions. Errors, including the ones of the bitstream reader,
+    /// are returned in the result.
+    /// @param[out] out_surface Future object with decoded data.
+    /// @param[in] list List of extension buffers to attach to bitstream.
+    /// @return Ok or warning, or error code
+    operation_result decode_frame(std::nothrow_t,
+                                  std::shared_ptr<frame_surface> out_surface,
+                                  decoder_process_list list = {}) noexcept {
         mfxBitstream *bts;
-        if (bits_.get_DataLength() == 0 && rdr_->is_EOS()) {
-            bts    = nullptr;
-            state_ = state::Draining;
+        try {
+            bts = next_bitstream(list);
         }
-        else {
-            bts = bits_();
-            if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-                bts->NumExtParam = static_cast<uint16_t>(size);
-                bts->ExtParam    = buffers;
-            }
-            else {
-                bts->NumExtParam = 0;
-                bts->ExtParam    = nullptr;
-            }
+        catch (base_exception &e) {
+            return operation_result::error(e.get_status());
         }
-
-        detail::c_api_invoker e({ [](mfxStatus s) {
-                                    switch (s) {
-                                        case MFX_ERR_MORE_DATA:
-                                            return false;
-                                        case MFX_ERR_MORE_SURFACE:
-                                            return false;
-                                        default:
-                                            break;
-                                    }
-
-                                    bool ret = (s < 0) ? true : false;
-                                    return ret;
-                                } },
-                                MFXVideoDECODE_DecodeFrameAsync,
-                                session_,
-                                bts,
-                                nullptr,
-                                &surf,
-                                &syncp);
-
-        if (surf) {
-            // out_surface = std::make_shared<frame_surface>(surf);
-            // out_surface.reset(new frame_surface(surf));
-            // std::shared_ptr<frame_surface> tmp = std::make_shared<frame_surface>(surf);
-            // out_surface.swap(tmp);
-            out_surface->inject(surf, out_surface.use_count() + 1);
-        }
-
-        if (e.sts_ == MFX_ERR_MORE_DATA && state_ == state::Draining) {
-            state_ = state::Done;
-            return status::EndOfStreamReached;
+        catch (...) {
+            return operation_result::error(MFX_ERR_UNKNOWN);
         }
-        return mfxstatus_to_onevplstatus(e.sts_);
+        return submit_bitstream(bts, out_surface);
     }
 
     /// @brief Decodes frame
@@ -425,21 +545,21 @@ public:
     /// @return Future object with decoded data
     std::shared_ptr<future<std::shared_ptr<frame_surface>>> process(
         decoder_process_list list = {}) {
-        std::shared_ptr<frame_surface> surface = std::make_shared<frame_surface>();
+        std::shared_ptr<frame_surface> surface = wrapper_pool_.make();
         std::shared_ptr<future_surface_t> f;
+        auto start = std::chrono::steady_clock::now();
 
         operation_status op(component_, this);
 
         if (state_ != state::Done) {
-            try {
-                status schedule_status;
-                schedule_status     = decode_frame(surface, list);
+            operation_result res = decode_frame(std::nothrow, surface, list);
+            if (res) {
                 f                   = std::make_shared<future_surface_t>(surface);
-                op.schedule_status_ = schedule_status;
+                op.schedule_status_ = res.get_status();
             }
-            catch (base_exception &e) {
+            else {
                 f                   = std::make_shared<future_surface_t>(nullptr);
-                op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
+                op.schedule_status_ = mfxstatus_to_onevplstatus(res.get_error());
                 op.fatal_           = true;
             }
         }
@@ -449,8 +569,23 @@ public:
         }
 
         f->add_operation(op);
+        track_latency(f, op, start);
         return f;
     }
+
+    /// @brief Decodes frame without throwing exceptions. Decoding errors are reported by the schedule status
+    /// of the future object.
+    /// @param[in] list List of extension buffers to attach to bitstream
+    /// @return Future object with decoded data or nullptr if the object can't be allocated
+    std::shared_ptr<future_surface_t> process(std::nothrow_t, decoder_process_list list = {}) noexcept {
+        try {
+            return process(std::move(list));
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
     /// @brief Retrieve decoder statistic
     /// @return Decoder statistic
     std::shared_ptr<decode_stat> getStat() {
@@ -469,7 +604,90 @@ public:
         return params_;
     }
 
+    /// @brief Provides decoder's output surface pool. Session must be initialized.
+    /// @return Shared pointer to the pool object.
+    std::shared_ptr<surface_pool> get_surface_pool() {
+        return query_surface_pool(MFXMemory_GetSurfaceForDecode);
+    }
+
+    /// @brief Sets refill mode of the input bitstream buffer. Use bitstream_as_src::refill_mode::wrap for high
+    /// bitrate streams to avoid moving unconsumed data before every read.
+    /// @param[in] mode Buffer refill mode
+    void set_refill_mode(bitstream_as_src::refill_mode mode) {
+        bits_.set_refill_mode(mode);
+    }
+
+    /// @brief Returns number of bytes moved inside the input bitstream buffer by refills.
+    /// @return Number of bytes.
+    uint64_t get_bitstream_bytes_moved() const {
+        return bits_.get_bytes_moved();
+    }
+
+    /// @brief Retrieves next user payload, for example SEI message, of the decoded frames. Payload is written
+    /// into the buffer taken from the pool.
+    /// @param[in] pool Pool of the payload buffers. Use buffers of decoded_payload::max_size to fit any payload.
+    /// @return Payload or empty object if there are no more payloads.
+    decoded_payload get_payload(const std::shared_ptr<bitstream_buffer_pool> &pool) {
+        decoded_payload out(pool);
+        detail::c_api_invoker e(detail::default_checker,
+                                MFXVideoDECODE_GetPayload,
+                                session_,
+                                out.get_raw_time_stamp_ptr(),
+                                out.get_raw_ptr());
+        return out;
+    }
+
 protected:
+    /// @brief Reads next portion of the bitstream and attaches extension buffers to it. Switches session
+    /// to the draining state at the end of stream.
+    /// @param[in] list List of extension buffers to attach to bitstream.
+    /// @return Bitstream to decode or nullptr to drain the decoder.
+    mfxBitstream *next_bitstream(decoder_process_list &list) {
+        rdr_->get_data(&bits_);
+
+        if (bits_.get_DataLength() == 0 && rdr_->is_EOS()) {
+            state_ = state::Draining;
+            return nullptr;
+        }
+
+        mfxBitstream *bts = bits_();
+        if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
+            bts->NumExtParam = static_cast<uint16_t>(size);
+            bts->ExtParam    = buffers;
+        }
+        else {
+            bts->NumExtParam = 0;
+            bts->ExtParam    = nullptr;
+        }
+        return bts;
+    }
+
+    /// @brief Submits bitstream to the decoder and attaches decoded surface to the output object.
+    /// @param[in] bts Bitstream to decode or nullptr to drain the decoder.
+    /// @param[out] out_surface Future object with decoded data.
+    /// @return Ok or warning, or error code
+    operation_result submit_bitstream(mfxBitstream *bts,
+                                      const std::shared_ptr<frame_surface> &out_surface) noexcept {
+        mfxSyncPoint syncp;
+        mfxFrameSurface1 *surf = nullptr;
+        mfxStatus sts = MFXVideoDECODE_DecodeFrameAsync(session_, bts, nullptr, &surf, &syncp);
+
+        if (sts < 0 && sts != MFX_ERR_MORE_DATA && sts != MFX_ERR_MORE_SURFACE)
+            return operation_result::error(sts);
+
+        if (surf) {
+            mfxStatus inject_sts = out_surface->inject(std::nothrow, surf, out_surface.use_count() + 1);
+            if (inject_sts < 0)
+                return operation_result::error(inject_sts);
+        }
+
+        if (sts == MFX_ERR_MORE_DATA && state_ == state::Draining) {
+            state_ = state::Done;
+            return status::EndOfStreamReached;
+        }
+        return mfxstatus_to_onevplstatus(sts);
+    }
+
     /// @brief Bitstream keeper
     bitstream_as_src bits_;
     /// @brief Bitstream reader
@@ -478,24 +696,184 @@ protected:
     decoder_video_param params_;
 };
 
+/// @brief Manages fused decode and VPP sessions. Each decoded frame is delivered together with the outputs
+/// of all VPP channels, for example several scaled renditions, in one call without separate VPP session.
+/// Channels must be added before the session is initialized.
+/// @tparam Reader Bitstream reader class
+template <typename Reader>
+class decode_vpp_session : public decode_session<Reader> {
+public:
+    /// @brief Constructs fused decode and VPP session
+    /// @param[in] sel Implementation selector
+    /// @param[in] codecID Codec ID
+    /// @param[in] rdr Bitstream reader
+    /// @param[in] ctx Device context to share with other sessions
+    decode_vpp_session(const implementation_selector &sel,
+                       codec_format_fourcc codecID,
+                       Reader *rdr,
+                       std::shared_ptr<device_context> ctx = nullptr)
+            : decode_session<Reader>(sel, codecID, rdr, ctx),
+              channels_(),
+              channel_lists_(),
+              channel_ptrs_() {
+        bind_c_api();
+    }
+
+    /// @brief Constructs fused decode and VPP session
+    /// @param[in] sel Implementation selector
+    /// @param[in] params Video params
+    /// @param[in] rdr Bitstream reader
+    /// @param[in] ctx Device context to share with other sessions
+    decode_vpp_session(const implementation_selector &sel,
+                       const decoder_video_param &params,
+                       Reader *rdr,
+                       std::shared_ptr<device_context> ctx = nullptr)
+            : decode_session<Reader>(sel, params, rdr, ctx),
+              channels_(),
+              channel_lists_(),
+              channel_ptrs_() {
+        bind_c_api();
+    }
+
+    decode_vpp_session(const decode_vpp_session &)            = delete;
+    decode_vpp_session &operator=(const decode_vpp_session &) = delete;
+
+    /// @brief Dtor
+    ~decode_vpp_session() {}
+
+    /// @brief Adds VPP output channel.
+    /// @param[in] out Output frame parameters: size, crop and color format.
+    /// @param[in] pattern Input and output memory pattern.
+    /// @param[in] list List of extension buffers to configure channel's filters. Buffers must stay valid
+    /// until the session is initialized.
+    /// @return Channel ID. Surfaces of the channel have this ID in frame_info. Channel ID of the decoder
+    /// output is 0.
+    uint16_t add_channel(const frame_info &out,
+                         io_pattern pattern       = io_pattern::io_system_memory,
+                         vpp_init_reset_list list = {}) {
+        mfxVideoChannelParam ch = {};
+        ch.VPP                  = out();
+        ch.VPP.ChannelId        = (uint16_t)(channels_.size() + 1);
+        ch.IOPattern            = (uint16_t)pattern;
+        channels_.push_back(ch);
+        channel_lists_.push_back(list);
+        return ch.VPP.ChannelId;
+    }
+
+    /// @brief Provides number of VPP channels.
+    /// @return Number of VPP channels.
+    std::size_t get_num_channels() const {
+        return channels_.size();
+    }
+
+    /// @brief Decodes frame and processes it by all VPP channels.
+    /// @param[out] out_surfaces Decoded frame followed by the outputs of the channels. Channel of each
+    /// surface is available through frame_info::get_ChannelId.
+    /// @param[in] list List of extension buffers to attach to bitstream.
+    /// @param[in] skip_channels IDs of the channels to skip for this frame.
+    /// @return Ok or warning
+    status decode_frame(std::vector<std::shared_ptr<frame_surface>> &out_surfaces,
+                        decoder_process_list list                  = {},
+                        const std::vector<uint32_t> &skip_channels = {}) {
+        mfxSurfaceArray *arr = nullptr;
+        mfxBitstream *bts    = this->next_bitstream(list);
+
+        out_surfaces.clear();
+        detail::c_api_invoker e({ [](mfxStatus s) {
+                                    switch (s) {
+                                        case MFX_ERR_MORE_DATA:
+                                            return false;
+                                        case MFX_ERR_MORE_SURFACE:
+                                            return false;
+                                        default:
+                                            break;
+                                    }
+
+                                    bool ret = (s < 0) ? true : false;
+                                    return ret;
+                                } },
+                                MFXVideoDECODE_VPP_DecodeFrameAsync,
+                                this->session_,
+                                bts,
+                                skip_channels.empty() ? nullptr
+                                                      : const_cast<mfxU32 *>(skip_channels.data()),
+                                (mfxU32)skip_channels.size(),
+                                &arr);
+
+        if (arr) {
+            for (mfxU32 i = 0; i < arr->NumSurfaces; i++)
+                out_surfaces.push_back(this->wrapper_pool_.make(arr->Surfaces[i]));
+            arr->Release(arr);
+        }
+
+        if (e.sts_ == MFX_ERR_MORE_DATA && this->state_ == session_state::Draining) {
+            this->state_ = session_state::Done;
+            return status::EndOfStreamReached;
+        }
+        return this->mfxstatus_to_onevplstatus(e.sts_);
+    }
+
+protected:
+    /// @brief Processing state type of the base session.
+    using session_state = typename decode_session<Reader>::state;
+
+    /// @brief Replaces decoder's C API functions with the fused decode and VPP ones.
+    void bind_c_api() {
+        this->c_api_callable_.init  = [this](mfxSession s, mfxVideoParam *par) {
+            return MFXVideoDECODE_VPP_Init(s, par, bind_channels(), (mfxU32)channels_.size());
+        };
+        this->c_api_callable_.reset = [this](mfxSession s, mfxVideoParam *par) {
+            return MFXVideoDECODE_VPP_Reset(s, par, bind_channels(), (mfxU32)channels_.size());
+        };
+        this->c_api_callable_.close = MFXVideoDECODE_VPP_Close;
+    }
+
+    /// @brief Attaches extension buffers to the channel parameters and builds array of pointers to them.
+    /// @return Array of pointers to the channel parameters.
+    mfxVideoChannelParam **bind_channels() {
+        channel_ptrs_.clear();
+        for (std::size_t i = 0; i < channels_.size(); i++) {
+            auto [buffers, size]     = channel_lists_[i].get_raw_ext_buffers();
+            channels_[i].ExtParam    = size ? buffers : nullptr;
+            channels_[i].NumExtParam = (uint16_t)size;
+            channel_ptrs_.push_back(&channels_[i]);
+        }
+        return channel_ptrs_.data();
+    }
+
+    /// @brief Parameters of the VPP channels.
+    std::vector<mfxVideoChannelParam> channels_;
+    /// @brief Extension buffers of the VPP channels.
+    std::vector<vpp_init_reset_list> channel_lists_;
+    /// @brief Pointers to the parameters of the VPP channels.
+    std::vector<mfxVideoChannelParam *> channel_ptrs_;
+};
+
 /// @brief Manages encoder's sessions.
 /// @todo SFINAE it
 class encode_session : public session<encoder_video_param, encoder_init_list, encoder_reset_list> {
 public:
     /// @brief Constructs encoder session
     /// @param[in] sel Implementation selector
-    explicit encode_session(const implementation_selector &sel)
-            : session(sel, detail::CAPI<>::Encoder),
-              rdr_(nullptr) {
+    /// @param[in] ctx Device context to share with other sessions
+    explicit encode_session(const implementation_selector &sel,
+                            std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::Encoder, ctx),
+              rdr_(nullptr),
+              ctrl_() {
         component_ = component::encoder;
     }
 
     /// @brief Constructs encoder session
     /// @param[in] sel Implementation selector
     /// @param[in] rdr Pointer to the raw frame reader
-    encode_session(const implementation_selector &sel, frame_source_reader *rdr)
-            : session(sel, detail::CAPI<>::Encoder),
-              rdr_(rdr) {
+    /// @param[in] ctx Device context to share with other sessions
+    encode_session(const implementation_selector &sel,
+                   frame_source_reader *rdr,
+                   std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::Encoder, ctx),
+              rdr_(rdr),
+              ctrl_() {
         component_ = component::encoder;
     }
 
@@ -512,7 +890,13 @@ public:
                                 session_,
                                 &surface);
 
-        return std::make_shared<frame_surface>(surface);
+        return wrapper_pool_.make(surface);
+    }
+
+    /// @brief Provides encoder's input surface pool. Session must be initialized.
+    /// @return Shared pointer to the pool object.
+    std::shared_ptr<surface_pool> get_surface_pool() {
+        return query_surface_pool(MFXMemory_GetSurfaceForEncode);
     }
 
     /// @brief Temporal method to sync the surface's data.
@@ -536,62 +920,91 @@ public:
     status encode_frame(std::shared_ptr<frame_surface> in_surface,
                         std::shared_ptr<bitstream_as_dst> bs,
                         encoder_process_list list = {}) {
-        mfxSyncPoint sp;
+        return encode_frame(std::nothrow, std::move(in_surface), std::move(bs), std::move(list)).value();
+    }
+
+    /// @brief Encodes single frame without throwing exceptions. Encode control structure isn't allocated per
+    /// call: if the list has no EncodeCtrl, the one owned by the session is used to pass extension buffers.
+    /// @param[in] in_surface Object with the data to encode.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list List of extension buffers to use
+    /// @return Ok or warning, or error code
+    operation_result encode_frame(std::nothrow_t,
+                                  std::shared_ptr<frame_surface> in_surface,
+                                  std::shared_ptr<bitstream_as_dst> bs,
+                                  encoder_process_list list = {}) noexcept {
         mfxFrameSurface1 *surf = in_surface.get() ? in_surface.get()->get_raw_ptr() : nullptr;
-        std::shared_ptr<mfxEncodeCtrl> ctrl = nullptr;
-        bool alocated_ctrl                  = false;
+        mfxEncodeCtrl *ctrl    = nullptr;
 
         if (nullptr == surf) {
             state_ = state::Draining;
         }
-        if(list.get_size() && list.has_buffer<0>()) {
-            ctrl.reset(list.get_buffer<mfxEncodeCtrl, 0>(), [](mfxEncodeCtrl *p) { p = nullptr; });
-            std::cout << "enc ctrl from the list" << std::endl;
-        } else {
-            ctrl = std::make_shared<mfxEncodeCtrl>();
-            *ctrl = {0};
-            alocated_ctrl = true;
-        }
-        
-        // Asumption: Encoder will copy-in all extension buffers.
-        if (auto [buffers, size] = list.get_raw_ext_buffers(); size) {
-            ctrl->ExtParam = buffers;
-            ctrl->NumExtParam = (mfxU16)size;
-        } else {
-            if (alocated_ctrl) {
-                ctrl.reset();
-            } else {
-                ctrl->ExtParam = 0;
-                ctrl->NumExtParam = 0;
+        if (list.get_size()) {
+            try {
+                // Asumption: Encoder will copy-in all extension buffers.
+                auto [buffers, size] = list.get_raw_ext_buffers();
+                ctrl                 = list.get_buffer<mfxEncodeCtrl, 0>();
+                if (!ctrl && size) {
+                    ctrl_ = {};
+                    ctrl  = &ctrl_;
+                }
+                if (ctrl) {
+                    ctrl->ExtParam    = size ? buffers : nullptr;
+                    ctrl->NumExtParam = (mfxU16)size;
+                }
+            }
+            catch (...) {
+                return operation_result::error(MFX_ERR_MEMORY_ALLOC);
             }
         }
-        detail::c_api_invoker e({ [](mfxStatus s) {
-                                    switch (s) {
-                                        case MFX_ERR_MORE_DATA:
-                                            return false;
-                                        case MFX_ERR_NOT_ENOUGH_BUFFER:
-                                            return false;
-                                        default:
-                                            break;
-                                    }
+        return submit_frame(std::nothrow, ctrl, surf, bs);
+    }
 
-                                    bool ret = (s < 0) ? true : false;
-                                    return ret;
-                                } },
-                                MFXVideoENCODE_EncodeFrameAsync,
-                                session_,
-                                ctrl.get(),
-                                surf,
-                                (*bs.get())(),
-                                &sp);
-        bs->associate_context({ session_, sp });
+    /// @brief Encodes single frame with extension buffers from the list with inline storage. Neither the
+    /// list nor the encode control structure is allocated per call, so the list is intended to be created
+    /// once and updated in place for every frame.
+    /// @param[in] in_surface Surface with data to encode.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list List of extension buffers to use. Must stay valid until encoder copies buffers in.
+    /// @return Ok or warning
+    /// @tparam Buffers Extension buffer classes.
+    template <typename... Buffers>
+    status encode_frame(std::shared_ptr<frame_surface> in_surface,
+                        std::shared_ptr<bitstream_as_dst> bs,
+                        static_buffer_list<Buffers...> &list) {
+        return encode_frame(std::nothrow, std::move(in_surface), std::move(bs), list).value();
+    }
 
-        if (e.sts_ == MFX_ERR_MORE_DATA && state_ == state::Draining) {
-            state_ = state::Done;
-            return status::EndOfStreamReached;
+    /// @brief Encodes single frame with extension buffers from the list with inline storage without
+    /// throwing exceptions.
+    /// @param[in] in_surface Surface with data to encode.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @param[in] list List of extension buffers to use. Must stay valid until encoder copies buffers in.
+    /// @return Ok or warning, or error code
+    /// @tparam Buffers Extension buffer classes.
+    template <typename... Buffers>
+    operation_result encode_frame(std::nothrow_t,
+                                  std::shared_ptr<frame_surface> in_surface,
+                                  std::shared_ptr<bitstream_as_dst> bs,
+                                  static_buffer_list<Buffers...> &list) noexcept {
+        mfxFrameSurface1 *surf = in_surface.get() ? in_surface.get()->get_raw_ptr() : nullptr;
+        mfxEncodeCtrl *ctrl    = list.get_encode_ctrl();
+
+        if (nullptr == surf) {
+            state_ = state::Draining;
         }
 
-        return mfxstatus_to_onevplstatus(e.sts_);
+        auto [buffers, size] = list.get_raw_ext_buffers();
+        if (!ctrl && size) {
+            ctrl_ = {};
+            ctrl  = &ctrl_;
+        }
+        if (ctrl) {
+            ctrl->ExtParam    = size ? buffers : nullptr;
+            ctrl->NumExtParam = (mfxU16)size;
+        }
+
+        return submit_frame(std::nothrow, ctrl, surf, bs);
     }
 
     /// @brief Encodes frame by using provided source reader to get data to encode
@@ -649,6 +1062,7 @@ public:
 
         /// @todo add smart wait with status propagation
         std::shared_ptr<frame_surface> in_surface = in_future->get();
+        auto start                                = std::chrono::steady_clock::now();
 
         if (state_ == state::Done) {
             op.schedule_status_ = status::EndOfStreamReached;
@@ -657,18 +1071,14 @@ public:
             switch (in_future->get_last_schedule_status()) {
                 case status::Ok:
                 case status::EndOfStreamReached: {
-                    try {
-                        status schedule_status;
-
-                        bits            = std::make_shared<bitstream_as_dst>();
-                        schedule_status = encode_frame(in_surface, bits, list);
-                        f_out           = std::make_shared<future_bitstream_t>(bits);
-                        f_out.reset(new future_bitstream_t(bits));
-                        op.schedule_status_ = schedule_status;
+                    bits                 = std::make_shared<bitstream_as_dst>();
+                    operation_result res = encode_frame(std::nothrow, in_surface, bits, list);
+                    if (res) {
+                        f_out               = std::make_shared<future_bitstream_t>(bits);
+                        op.schedule_status_ = res.get_status();
                     }
-                    catch (base_exception &e) {
-                        std::cout << "encoder gonna die" << std::endl << std::flush;
-                        op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
+                    else {
+                        op.schedule_status_ = mfxstatus_to_onevplstatus(res.get_error());
                         op.fatal_           = true;
                     }
                 } break;
@@ -680,9 +1090,100 @@ public:
 
         f_out->add_operation(op);
         f_out->propagate_history(*(in_future.get()));
+        track_latency(f_out, op, start);
         return f_out;
     }
 
+    /// @brief Encode frame without throwing exceptions. Encoding errors are reported by the schedule status
+    /// of the future object.
+    /// @param[in] in_future Future object with the surface from the previous operation.
+    /// @param[in] list List of extension buffers to use
+    /// @return Future object with the bitstream or nullptr if the object can't be allocated.
+    std::shared_ptr<future_bitstream_t> process(std::nothrow_t,
+                                                std::shared_ptr<future_surface_t> in_future,
+                                                encoder_process_list list = {}) noexcept {
+        try {
+            return process(std::move(in_future), std::move(list));
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    /// @brief Creates ring of output bitstreams sized for the current encoder configuration.
+    /// @param[in] size Number of slots. Use AsyncDepth of the session or more.
+    /// @param[in] capacity Buffer size of each slot in bytes. If 0, size is derived from the BufferSizeInKB
+    /// value of the working parameters.
+    /// @return Ring of the bitstreams.
+    bitstream_ring make_bitstream_ring(std::size_t size, uint32_t capacity = 0) {
+        std::shared_ptr<encoder_video_param> par = working_params();
+        return bitstream_ring(size, capacity ? capacity : output_capacity(*par), par->get_CodecId());
+    }
+
+    /// @brief Creates pool of output bitstream buffers sized for the current encoder configuration. Use it to
+    /// construct bitstream_as_dst objects and move encoded data out of them with take_payload.
+    /// @param[in] max_cached Maximum number of free buffers to keep.
+    /// @param[in] capacity Size of each buffer in bytes. If 0, size is derived from the BufferSizeInKB value
+    /// of the working parameters.
+    /// @return Shared pointer to the pool.
+    std::shared_ptr<bitstream_buffer_pool> make_bitstream_pool(std::size_t max_cached = 16,
+                                                               uint32_t capacity      = 0) {
+        if (!capacity)
+            capacity = output_capacity(*working_params());
+        return std::make_shared<bitstream_buffer_pool>(capacity, max_cached);
+    }
+
+    /// @brief Encodes batch of frames. Output bitstreams are taken from the ring. Each input produces
+    /// one future object in the same order: frames which were buffered by the encoder produce future object
+    /// with status::NotEnoughData schedule status and no data. Pass nullptr surfaces to drain the encoder.
+    /// @param[in] surfaces Frames to encode.
+    /// @param[in] ring Ring of the output bitstreams.
+    /// @param[in] list List of extension buffers to use for each frame.
+    /// @return Future objects with the bitstreams.
+    std::vector<std::shared_ptr<future_bitstream_t>> encode_frames(
+        const std::vector<std::shared_ptr<frame_surface>> &surfaces,
+        bitstream_ring &ring,
+        encoder_process_list list = {}) {
+        std::vector<std::shared_ptr<future_bitstream_t>> out;
+        out.reserve(surfaces.size());
+
+        for (auto &surface : surfaces) {
+            std::shared_ptr<bitstream_as_dst> bits = ring.acquire();
+            operation_status op(component_, this);
+
+            if (state_ == state::Done) {
+                op.schedule_status_ = status::EndOfStreamReached;
+                bits.reset();
+            }
+            else {
+                operation_result res;
+                while (true) {
+                    res = encode_frame(std::nothrow, surface, bits, list);
+                    if (res.get_status() == status::DeviceBusy)
+                        std::this_thread::sleep_for(detail::completion_poll_period);
+                    else if (res.get_status() == status::NotEnoughBuffer)
+                        bits->realloc();
+                    else
+                        break;
+                }
+                if (res) {
+                    op.schedule_status_ = res.get_status();
+                }
+                else {
+                    op.schedule_status_ = mfxstatus_to_onevplstatus(res.get_error());
+                    op.fatal_           = true;
+                }
+                if (op.schedule_status_ != status::Ok)
+                    bits.reset();
+            }
+
+            std::shared_ptr<future_bitstream_t> f = std::make_shared<future_bitstream_t>(bits);
+            f->add_operation(op);
+            out.push_back(f);
+        }
+        return out;
+    }
+
     /// @brief Retrieve encoder statistic
     /// @return Encoder statistic
     std::shared_ptr<encode_stat> getStat() {
@@ -696,8 +1197,42 @@ public:
     }
 
 protected:
+    /// @brief Calculates output buffer size required by the encoder configuration.
+    /// @param[in] par Encoder parameters.
+    /// @return Size in bytes.
+    static uint32_t output_capacity(const encoder_video_param &par) {
+        uint32_t multiplier = par.get_BRCParamMultiplier() ? par.get_BRCParamMultiplier() : 1;
+        return par.get_BufferSizeInKB() * multiplier * 1000;
+    }
+
+    /// @brief Submits frame to the encoder and associates bitstream with the sync point.
+    /// @param[in] ctrl Encode control structure or nullptr.
+    /// @param[in] surf Surface with data to encode or nullptr to drain the encoder.
+    /// @param[out] bs Future object with bitstream portion.
+    /// @return Ok or warning, or error code
+    operation_result submit_frame(std::nothrow_t,
+                                  mfxEncodeCtrl *ctrl,
+                                  mfxFrameSurface1 *surf,
+                                  const std::shared_ptr<bitstream_as_dst> &bs) noexcept {
+        mfxSyncPoint sp;
+        mfxStatus sts = MFXVideoENCODE_EncodeFrameAsync(session_, ctrl, surf, (*bs.get())(), &sp);
+
+        if (sts < 0 && sts != MFX_ERR_MORE_DATA && sts != MFX_ERR_NOT_ENOUGH_BUFFER)
+            return operation_result::error(sts);
+        bs->associate_context({ session_, sp });
+
+        if (sts == MFX_ERR_MORE_DATA && state_ == state::Draining) {
+            state_ = state::Done;
+            return status::EndOfStreamReached;
+        }
+
+        return mfxstatus_to_onevplstatus(sts);
+    }
+
     /// @brief Raw freames reader
     frame_source_reader *rdr_;
+    /// @brief Encode control structure reused for the lists without EncodeCtrl
+    mfxEncodeCtrl ctrl_;
 };
 
 /// @brief Manages VPP's sessions.
@@ -706,8 +1241,10 @@ class vpp_session : public session<vpp_video_param, vpp_init_reset_list, vpp_ini
 public:
     /// @brief Constructs encoder session
     /// @param[in] sel Implementation selector
-    explicit vpp_session(const implementation_selector &sel)
-            : session(sel, detail::CAPI<>::VPP),
+    /// @param[in] ctx Device context to share with other sessions
+    explicit vpp_session(const implementation_selector &sel,
+                         std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::VPP, ctx),
               rdr_(nullptr) {
         component_ = component::vpp;
     }
@@ -715,8 +1252,11 @@ public:
     /// @brief Constructs encoder session
     /// @param[in] sel Implementation selector
     /// @param[in] rdr Pointer to the raw frame reader
-    vpp_session(const implementation_selector &sel, frame_source_reader *rdr)
-            : session(sel, detail::CAPI<>::VPP),
+    /// @param[in] ctx Device context to share with other sessions
+    vpp_session(const implementation_selector &sel,
+                frame_source_reader *rdr,
+                std::shared_ptr<device_context> ctx = nullptr)
+            : session(sel, detail::CAPI<>::VPP, ctx),
               rdr_(rdr) {
         component_ = component::vpp;
     }
@@ -734,7 +1274,7 @@ public:
                                 session_,
                                 &surface);
 
-        return std::make_shared<frame_surface>(surface);
+        return wrapper_pool_.make(surface);
     }
 
     /// @brief Allocate internal raw surface and attach it to the output surface
@@ -752,6 +1292,15 @@ public:
         return;
     }
 
+    /// @brief Provides VPP's input or output surface pool. Session must be initialized.
+    /// @param[in] type Pool type.
+    /// @return Shared pointer to the pool object.
+    std::shared_ptr<surface_pool> get_surface_pool(vppl_pool_type type) {
+        if (type == vppl_pool_type::input_pool)
+            return query_surface_pool(MFXMemory_GetSurfaceForVPP);
+        return query_surface_pool(MFXMemory_GetSurfaceForVPPOut);
+    }
+
     /// @brief Initializes session with given parameters and extention buffers.
     /// @param[in] par Pointer to the parameters.
     /// @param[in] list List of extention buffers.
@@ -782,40 +1331,42 @@ public:
     /// @return Ok or warning
     status process_frame(std::shared_ptr<frame_surface> in_surface,
                          std::shared_ptr<frame_surface>& out_surface) {
+        return process_frame(std::nothrow, std::move(in_surface), out_surface).value();
+    }
+
+    /// @brief Process frame without throwing exceptions. User need to sync up the surface data before
+    /// accessing.
+    /// @param[in] in_surface Pointer to the input surface.
+    /// @param[out] out_surface Placeholder for the allocated output surface.
+    /// @return Ok or warning, or error code
+    operation_result process_frame(std::nothrow_t,
+                                   std::shared_ptr<frame_surface> in_surface,
+                                   std::shared_ptr<frame_surface>& out_surface) noexcept {
         mfxSyncPoint sp;
         mfxFrameSurface1 *surf = in_surface.get() ? in_surface->get_raw_ptr() : nullptr;
+        mfxFrameSurface1 *out  = nullptr;
 
         if (nullptr == surf) {
             state_ = state::Draining;
         }
-        alloc_output(out_surface);
-        detail::c_api_invoker e({ [](mfxStatus s) {
-                                    switch (s) {
-                                        case MFX_ERR_MORE_DATA:
-                                            return false;
-                                        case MFX_ERR_MORE_SURFACE:
-                                            return false;
-                                        default:
-                                            break;
-                                    }
-
-                                    bool ret = (s < 0) ? true : false;
-                                    return ret;
-                                } },
-                                MFXVideoVPP_RunFrameVPPAsync,
-                                session_,
-                                surf,
-                                out_surface->get_raw_ptr(),
-                                nullptr,
-                                &sp);
-
-        if (e.sts_ == MFX_ERR_MORE_DATA && state_ == state::Draining) {
+        mfxStatus sts = MFXMemory_GetSurfaceForVPPOut(session_, &out);
+        if (sts < 0)
+            return operation_result::error(sts);
+        sts = out_surface->inject(std::nothrow, out, out_surface.use_count() + 1);
+        if (sts < 0)
+            return operation_result::error(sts);
+
+        sts = MFXVideoVPP_RunFrameVPPAsync(session_, surf, out_surface->get_raw_ptr(), nullptr, &sp);
+        if (sts < 0 && sts != MFX_ERR_MORE_DATA && sts != MFX_ERR_MORE_SURFACE)
+            return operation_result::error(sts);
+
+        if (sts == MFX_ERR_MORE_DATA && state_ == state::Draining) {
             state_ = state::Done;
             out_surface.reset();
             return status::EndOfStreamReached;
         }
 
-        return mfxstatus_to_onevplstatus(e.sts_);
+        return mfxstatus_to_onevplstatus(sts);
     }
 
     /// @brief Process frame. Function returns the surface which will hold processed data. User need to sync up the
@@ -860,12 +1411,13 @@ public:
     /// @param[in] in_future Future object with the surface from the previouse operation.
     /// @return Future object with the surface.
     std::shared_ptr<future_surface_t> process(std::shared_ptr<future_surface_t> in_future) {
-        std::shared_ptr<frame_surface> surface;
+        std::shared_ptr<frame_surface> surface = wrapper_pool_.make();
         std::shared_ptr<future_surface_t> f_out = std::make_shared<future_surface_t>(nullptr);
         operation_status op(component_, this);
 
         /// @todo add smart wait with status propagation
         std::shared_ptr<frame_surface> in_surface = in_future->get();
+        auto start                                = std::chrono::steady_clock::now();
 
         if (state_ == state::Done) {
             op.schedule_status_ = status::EndOfStreamReached;
@@ -874,14 +1426,13 @@ public:
             switch (in_future->get_last_schedule_status()) {
                 case status::Ok:
                 case status::EndOfStreamReached: {
-                    try {
-                        status schedule_status;
-                        schedule_status = process_frame(in_surface, surface);
+                    operation_result res = process_frame(std::nothrow, in_surface, surface);
+                    if (res) {
                         f_out.reset(new future_surface_t(surface));
-                        op.schedule_status_ = schedule_status;
+                        op.schedule_status_ = res.get_status();
                     }
-                    catch (base_exception &e) {
-                        op.schedule_status_ = mfxstatus_to_onevplstatus(e.get_status());
+                    else {
+                        op.schedule_status_ = mfxstatus_to_onevplstatus(res.get_error());
                         op.fatal_           = true;
                     }
                 } break;
@@ -893,10 +1444,25 @@ public:
 
         f_out->add_operation(op);
         f_out->propagate_history(*(in_future.get()));
+        track_latency(f_out, op, start);
 
         return f_out;
     }
 
+    /// @brief Process frame without throwing exceptions. Processing errors are reported by the schedule status
+    /// of the future object.
+    /// @param[in] in_future Future object with the surface from the previouse operation.
+    /// @return Future object with the surface or nullptr if the object can't be allocated.
+    std::shared_ptr<future_surface_t> process(std::nothrow_t,
+                                              std::shared_ptr<future_surface_t> in_future) noexcept {
+        try {
+            return process(std::move(in_future));
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
     /// @brief Retrieve encoder statistic
     /// @return VPP statistic
     std::shared_ptr<vpp_stat> getStat() {
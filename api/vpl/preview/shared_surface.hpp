@@ -0,0 +1,290 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/exception.hpp"
+#include "vpl/preview/frame_surface.hpp"
+
+#include "vpl/preview/detail/frame_interface.hpp"
+#include "vpl/preview/detail/sdk_callable.hpp"
+
+#if !defined(_WIN32)
+    #include <sys/socket.h>
+    #include <sys/types.h>
+#endif
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Video memory of the surface exported to another process: DMA-BUF file descriptors on Linux or
+/// shared NT handle on Windows. Object keeps reference to the surface, so the component doesn't reuse it
+/// while another process reads the data. OS handles are closed with the object.
+class exported_surface {
+public:
+    /// @brief Synchronizes surface and exports its memory.
+    /// @param[in] surface Surface allocated in video memory.
+    /// @param[in] id ID to assign to the exported surface.
+    exported_surface(std::shared_ptr<frame_surface> surface, uint64_t id)
+            : surface_(std::move(surface)),
+              desc_() {
+        if (!surface_ || !surface_->get_raw_ptr())
+            throw base_exception("Can't export empty surface", MFX_ERR_NULL_PTR);
+        surface_->wait();
+        desc_.id = id;
+        detail::c_api_invoker e(detail::default_checker,
+                                detail::export_surface,
+                                surface_->get_raw_ptr(),
+                                desc_);
+    }
+
+    exported_surface(const exported_surface &)            = delete;
+    exported_surface &operator=(const exported_surface &) = delete;
+
+    /// @brief Dtor. Closes exported handles and releases the surface.
+    ~exported_surface() {
+        detail::close_shared_handles(desc_);
+    }
+
+    /// @brief Provides description of the exported memory. Handles are valid in this process.
+    /// @return Description of the exported memory.
+    const shared_surface_desc &get_desc() const {
+        return desc_;
+    }
+
+    /// @brief Provides exported surface.
+    /// @return Shared pointer to the surface.
+    std::shared_ptr<frame_surface> get_surface() const {
+        return surface_;
+    }
+
+#if defined(_WIN32)
+    /// @brief Duplicates NT handles into the target process.
+    /// @param[in] process Handle of the target process with PROCESS_DUP_HANDLE access right.
+    /// @return Description with handles valid in the target process.
+    shared_surface_desc duplicate_to(HANDLE process) const {
+        shared_surface_desc out = desc_;
+        for (uint32_t i = 0; i < desc_.num_objects; i++) {
+            HANDLE dup = nullptr;
+            if (!DuplicateHandle(GetCurrentProcess(),
+                                 reinterpret_cast<HANDLE>(desc_.objects[i].handle),
+                                 process,
+                                 &dup,
+                                 0,
+                                 FALSE,
+                                 DUPLICATE_SAME_ACCESS))
+                throw base_exception("DuplicateHandle failed", MFX_ERR_ABORTED);
+            out.objects[i].handle = reinterpret_cast<int64_t>(dup);
+        }
+        return out;
+    }
+#endif
+
+protected:
+    /// @brief Exported surface.
+    std::shared_ptr<frame_surface> surface_;
+    /// @brief Description of the exported memory.
+    shared_surface_desc desc_;
+};
+
+/// @brief Surface memory received from another process. Object owns OS handles from the description and
+/// closes them with the destruction. Release callback reports surface ID back to the exporter, so it can
+/// return the surface to the component.
+class imported_surface {
+public:
+    /// @brief Takes ownership of the handles in the description.
+    /// @param[in] desc Description with handles valid in this process.
+    /// @param[in] on_release Function to call with surface ID once the object is destroyed.
+    explicit imported_surface(const shared_surface_desc &desc,
+                              std::function<void(uint64_t)> on_release = {})
+            : desc_(desc),
+              on_release_(std::move(on_release)) {}
+
+    imported_surface(const imported_surface &)            = delete;
+    imported_surface &operator=(const imported_surface &) = delete;
+
+    /// @brief Dtor. Closes handles and notifies exporter.
+    ~imported_surface() {
+        detail::close_shared_handles(desc_);
+        if (on_release_)
+            on_release_(desc_.id);
+    }
+
+    /// @brief Provides description of the imported memory to create API specific object on top of it.
+    /// @return Description of the imported memory.
+    const shared_surface_desc &get_desc() const {
+        return desc_;
+    }
+
+    /// @brief Provides exporter assigned ID of the surface.
+    /// @return ID of the surface.
+    uint64_t get_id() const {
+        return desc_.id;
+    }
+
+protected:
+    /// @brief Description of the imported memory.
+    shared_surface_desc desc_;
+    /// @brief Function to notify exporter.
+    std::function<void(uint64_t)> on_release_;
+};
+
+/// @brief Exports surfaces and keeps them referenced until another process reports their release. This
+/// way reference counting spans process boundary: component reuses the surface only after all processes
+/// are done with it. Thread safe.
+class surface_exporter {
+public:
+    /// @brief Default ctor
+    surface_exporter() : mutex_(), next_id_(1), exported_() {}
+
+    surface_exporter(const surface_exporter &)            = delete;
+    surface_exporter &operator=(const surface_exporter &) = delete;
+
+    /// @brief Exports surface memory.
+    /// @param[in] surface Surface allocated in video memory.
+    /// @return Exported surface. Its ID must be passed to release once the receiver is done.
+    std::shared_ptr<exported_surface> export_surface(std::shared_ptr<frame_surface> surface) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto exported = std::make_shared<exported_surface>(std::move(surface), next_id_);
+        exported_.emplace(next_id_++, exported);
+        return exported;
+    }
+
+    /// @brief Releases surface reported by the receiver.
+    /// @param[in] id ID of the exported surface.
+    /// @return True if surface was exported by this object and not released yet.
+    bool release(uint64_t id) {
+        std::shared_ptr<exported_surface> exported;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = exported_.find(id);
+            if (it == exported_.end())
+                return false;
+            exported = std::move(it->second);
+            exported_.erase(it);
+        }
+        // surface is returned to the component outside of the lock
+        return true;
+    }
+
+    /// @brief Releases all exported surfaces, for example when receiver process terminates.
+    void release_all() {
+        std::map<uint64_t, std::shared_ptr<exported_surface>> exported;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            exported.swap(exported_);
+        }
+    }
+
+    /// @brief Provides number of surfaces not released by the receiver.
+    /// @return Number of exported surfaces.
+    std::size_t get_exported_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return exported_.size();
+    }
+
+protected:
+    /// @brief Guards the map of exported surfaces.
+    mutable std::mutex mutex_;
+    /// @brief ID to assign to the next exported surface.
+    uint64_t next_id_;
+    /// @brief Exported surfaces by ID.
+    std::map<uint64_t, std::shared_ptr<exported_surface>> exported_;
+};
+
+#if !defined(_WIN32)
+/// @brief Sends description and DMA-BUF file descriptors of the exported surface over the Unix domain
+/// socket. Receiver gets its own copies of the descriptors.
+/// @param[in] socket Connected Unix domain socket.
+/// @param[in] desc Description of the exported surface.
+inline void send_shared_surface(int socket, const shared_surface_desc &desc) {
+    if (desc.type != shared_handle_type::dma_buf || desc.num_objects > shared_surface_desc::MAX_OBJECTS)
+        throw base_exception("Surface isn't exported as DMA-BUF", MFX_ERR_UNSUPPORTED);
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * shared_surface_desc::MAX_OBJECTS)];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    struct iovec iov   = { const_cast<shared_surface_desc *>(&desc), sizeof(desc) };
+    struct msghdr msg  = {};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * desc.num_objects);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level     = SOL_SOCKET;
+    cmsg->cmsg_type      = SCM_RIGHTS;
+    cmsg->cmsg_len       = CMSG_LEN(sizeof(int) * desc.num_objects);
+    int *fds             = reinterpret_cast<int *>(CMSG_DATA(cmsg));
+    for (uint32_t i = 0; i < desc.num_objects; i++)
+        fds[i] = static_cast<int>(desc.objects[i].handle);
+
+    if (sendmsg(socket, &msg, 0) != static_cast<ssize_t>(sizeof(desc)))
+        throw base_exception("Can't send shared surface", MFX_ERR_ABORTED);
+}
+
+/// @brief Receives surface sent by send_shared_surface.
+/// @param[in] socket Connected Unix domain socket.
+/// @param[in] on_release Function to call with surface ID once the imported surface is destroyed.
+/// @return Imported surface or nullptr if the peer closed the connection.
+inline std::shared_ptr<imported_surface> receive_shared_surface(
+    int socket,
+    std::function<void(uint64_t)> on_release = {}) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * shared_surface_desc::MAX_OBJECTS)];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    shared_surface_desc desc = {};
+    struct iovec iov         = { &desc, sizeof(desc) };
+    struct msghdr msg        = {};
+    msg.msg_iov              = &iov;
+    msg.msg_iovlen           = 1;
+    msg.msg_control          = control.buf;
+    msg.msg_controllen       = sizeof(control.buf);
+
+    ssize_t n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    if (n == 0)
+        return nullptr;
+
+    // take ownership of the received descriptors first, so they are closed on any error
+    uint32_t num_fds = 0;
+    int fds[shared_surface_desc::MAX_OBJECTS];
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            num_fds = static_cast<uint32_t>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            std::memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * num_fds);
+        }
+    }
+
+    if (n != static_cast<ssize_t>(sizeof(desc)) || (msg.msg_flags & MSG_CTRUNC) ||
+        num_fds != desc.num_objects) {
+        for (uint32_t i = 0; i < num_fds; i++)
+            close(fds[i]);
+        throw base_exception("Can't receive shared surface", MFX_ERR_ABORTED);
+    }
+
+    for (uint32_t i = 0; i < num_fds; i++)
+        desc.objects[i].handle = fds[i];
+    return std::make_shared<imported_surface>(desc, std::move(on_release));
+}
+#endif
+
+} // namespace vpl
+} // namespace oneapi
@@ -0,0 +1,527 @@
+/*############################################################################
+  # Copyright Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "vpl/preview/bitstream.hpp"
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/frame_surface.hpp"
+#include "vpl/preview/future.hpp"
+#include "vpl/preview/source_reader.hpp"
+
+namespace oneapi {
+namespace vpl {
+
+/// @brief Write mode of the raw frame writers
+enum class raw_frame_write_mode {
+    line, ///< Each line of each plane is written to the stream separately.
+    frame ///< Planes are packed into the write buffer and written together with the neighbour frames.
+};
+
+namespace detail {
+
+/// @brief Copies pitched plane into the continuous blob. Single copy is used when plane has no padding.
+/// Inverse of copy_blob.
+/// @param[in] dst Pointer to the continuous blob
+/// @param[in] src Pointer to the plane
+/// @param[in] pitch Pitch of the plane
+/// @param[in] b_width Width of the blob
+/// @param[in] b_height Height of the blob
+inline void pack_blob(uint8_t* dst,
+                      const uint8_t* src,
+                      uint32_t pitch,
+                      uint16_t b_width,
+                      uint16_t b_height) {
+    if (pitch == b_width) {
+        std::memcpy(dst, src, (size_t)b_width * b_height);
+        return;
+    }
+    for (uint16_t i = 0; i < b_height; i++)
+        std::memcpy(dst + (size_t)i * b_width, src + (size_t)i * pitch, b_width);
+}
+
+/// @brief File writer with the dedicated I/O thread. Jobs are queued by the submission thread and executed
+/// by the I/O thread in the submission order. Data appended by the jobs is gathered in the write buffer and
+/// written to the file once the buffer is full, so the file gets few large writes. Queue is bounded: queueing
+/// blocks while it is full. Error raised by the job is stored and rethrown by the next push or flush call.
+class async_file_writer {
+public:
+    /// @brief Job executed by the I/O thread.
+    using job = std::function<void(async_file_writer&)>;
+
+    /// @brief Opens the file and starts I/O thread.
+    /// @param[in] name Name of the file to write to.
+    /// @param[in] queue_len Maximum number of queued jobs.
+    /// @param[in] chunk_size Size of the write buffer in bytes.
+    async_file_writer(const std::string& name, size_t queue_len, size_t chunk_size)
+            : of_(),
+              name_(name),
+              queue_len_(queue_len ? queue_len : 1),
+              chunk_(),
+              chunk_capacity_(chunk_size ? chunk_size : 1),
+              chunk_fill_(0),
+              lock_(),
+              cv_queued_(),
+              cv_done_(),
+              jobs_(),
+              busy_(false),
+              stop_(false),
+              error_(),
+              thread_() {
+        of_.open(name, std::ios_base::out | std::ios_base::binary);
+        if (!of_) {
+            throw file_exception(std::string("Couldn't open ") + name);
+        }
+        chunk_.reset(new uint8_t[chunk_capacity_]);
+        thread_ = std::thread([this]() {
+            routine();
+        });
+    }
+
+    async_file_writer(const async_file_writer&)            = delete;
+    async_file_writer& operator=(const async_file_writer&) = delete;
+
+    /// @brief Executes queued jobs, writes buffered data and stops I/O thread. Errors are ignored, use flush
+    /// to get them.
+    ~async_file_writer() {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            stop_ = true;
+        }
+        cv_queued_.notify_all();
+        thread_.join();
+        try {
+            write_chunk();
+        }
+        catch (std::exception&) {
+        }
+    }
+
+    /// @brief Queues the job. Blocks while the queue is full.
+    /// @param[in] j Job to execute.
+    void push(job j) {
+        std::unique_lock<std::mutex> lock(lock_);
+        cv_done_.wait(lock, [this]() {
+            return jobs_.size() < queue_len_ || error_;
+        });
+        rethrow();
+        jobs_.push_back(std::move(j));
+        lock.unlock();
+        cv_queued_.notify_one();
+    }
+
+    /// @brief Waits until all queued jobs are executed and writes buffered data to the file.
+    void flush() {
+        push([](async_file_writer& w) {
+            w.write_chunk();
+            w.of_.flush();
+            if (!w.of_)
+                throw file_exception(std::string("Error writing ") + w.name_);
+        });
+        std::unique_lock<std::mutex> lock(lock_);
+        cv_done_.wait(lock, [this]() {
+            return (jobs_.empty() && !busy_) || error_;
+        });
+        rethrow();
+    }
+
+    /// @brief Appends data to the write buffer. Must be called by the job only.
+    /// @param[in] data Pointer to the data.
+    /// @param[in] size Size of the data in bytes.
+    void append(const uint8_t* data, size_t size) {
+        if (size >= chunk_capacity_) {
+            write_chunk();
+            write(data, size);
+            return;
+        }
+        std::memcpy(reserve(size), data, size);
+    }
+
+    /// @brief Reserves continuous space at the end of the write buffer, so the job can pack data in
+    /// place. Must be called by the job only.
+    /// @param[in] size Size of the space in bytes.
+    /// @return Pointer to the reserved space.
+    uint8_t* reserve(size_t size) {
+        if (chunk_fill_ + size > chunk_capacity_) {
+            write_chunk();
+            if (size > chunk_capacity_) {
+                chunk_.reset(new uint8_t[size]);
+                chunk_capacity_ = size;
+            }
+        }
+        uint8_t* ptr = chunk_.get() + chunk_fill_;
+        chunk_fill_ += size;
+        return ptr;
+    }
+
+    /// @brief Writes data to the file directly, bypassing the write buffer. Buffered data must be written
+    /// first with write_chunk. Must be called by the job only.
+    /// @param[in] data Pointer to the data.
+    /// @param[in] size Size of the data in bytes.
+    void write(const uint8_t* data, size_t size) {
+        of_.write(reinterpret_cast<const char*>(data), size);
+        if (!of_)
+            throw file_exception(std::string("Error writing ") + name_);
+    }
+
+    /// @brief Writes content of the write buffer to the file. Must be called by the job only.
+    void write_chunk() {
+        if (!chunk_fill_)
+            return;
+        size_t size = chunk_fill_;
+        chunk_fill_ = 0;
+        write(chunk_.get(), size);
+    }
+
+protected:
+    /// @brief I/O thread routine.
+    void routine() {
+        std::unique_lock<std::mutex> lock(lock_);
+        for (;;) {
+            cv_queued_.wait(lock, [this]() {
+                return !jobs_.empty() || stop_;
+            });
+            if (jobs_.empty())
+                break;
+
+            job j = std::move(jobs_.front());
+            jobs_.pop_front();
+            bool failed = (error_ != nullptr);
+            busy_       = true;
+            lock.unlock();
+            cv_done_.notify_all();
+
+            std::exception_ptr error;
+            if (!failed) {
+                try {
+                    j(*this);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            lock.lock();
+            busy_ = false;
+            if (error)
+                error_ = error;
+            cv_done_.notify_all();
+        }
+    }
+
+    /// @brief Rethrows stored error. Must be called under the lock.
+    void rethrow() {
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_                   = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    /// @brief File handle.
+    std::ofstream of_;
+    /// @brief Name of the file.
+    std::string name_;
+    /// @brief Maximum number of queued jobs.
+    size_t queue_len_;
+    /// @brief Write buffer.
+    std::unique_ptr<uint8_t[]> chunk_;
+    /// @brief Size of the write buffer.
+    size_t chunk_capacity_;
+    /// @brief Number of bytes in the write buffer.
+    size_t chunk_fill_;
+    /// @brief Guards the queue and the state.
+    std::mutex lock_;
+    /// @brief Signaled when the job is queued or the thread needs to stop.
+    std::condition_variable cv_queued_;
+    /// @brief Signaled when the job is taken from the queue or completed.
+    std::condition_variable cv_done_;
+    /// @brief Queued jobs.
+    std::deque<job> jobs_;
+    /// @brief Job is in execution.
+    bool busy_;
+    /// @brief Thread needs to stop.
+    bool stop_;
+    /// @brief Error raised by the job and not reported yet.
+    std::exception_ptr error_;
+    /// @brief I/O thread.
+    std::thread thread_;
+};
+
+} // namespace detail
+
+/// @brief Interface for the sink data writer
+class sink_writer {
+public:
+    /// @brief Default ctor
+    sink_writer() {}
+
+    /// @brief Default dtor
+    virtual ~sink_writer() {}
+
+    /// @brief Waits until all submitted data is written to the destination
+    virtual void flush() = 0;
+};
+
+/// @brief Interface for the bitstream sink data writer
+class bitstream_sink_writer : public sink_writer {
+public:
+    /// @brief Default ctor
+    bitstream_sink_writer() {}
+
+    /// @brief Default dtor
+    virtual ~bitstream_sink_writer() {}
+
+    /// @brief Submits encoded data to write. Bitstream must not be reused until the writer releases it.
+    /// @param[in] bits Synchronized bitstream.
+    virtual void put(std::shared_ptr<bitstream_as_dst> bits) = 0;
+
+    /// @brief Submits encoded data to write. Future is synchronized by the writer.
+    /// @param[in] bits Future of the encode operation.
+    virtual void put(future<std::shared_ptr<bitstream_as_dst>> bits) = 0;
+};
+
+/// @brief Interface for the frame sink data writer
+class frame_sink_writer : public sink_writer {
+public:
+    /// @brief Default ctor
+    frame_sink_writer() {}
+
+    /// @brief Default dtor
+    virtual ~frame_sink_writer() {}
+
+    /// @brief Submits frame to write. Surface must not be reused until the writer releases it.
+    /// @param[in] frame Frame to write.
+    virtual void put(std::shared_ptr<frame_surface> frame) = 0;
+
+    /// @brief Submits frame to write. Future is synchronized by the writer.
+    /// @param[in] frame Future of the decode or VPP operation.
+    virtual void put(future<std::shared_ptr<frame_surface>> frame) = 0;
+};
+
+/// @brief File based writer of the encoded data. Synchronization and writing are done by the I/O thread, so
+/// the submission thread is blocked only when the queue is full. Bitstreams are held until they are written,
+/// so the bitstream_ring slots are reused right after that.
+class bitstream_file_writer : public bitstream_sink_writer {
+public:
+    /// @brief Constructs writer with given file name
+    /// @param[in] name Name of the file to write to.
+    /// @param[in] queue_len Maximum number of bitstreams waiting to be written.
+    /// @param[in] chunk_size Size of the write buffer in bytes.
+    explicit bitstream_file_writer(const std::string& name,
+                                   size_t queue_len  = 16,
+                                   size_t chunk_size = 4 * 1024 * 1024)
+            : bitstream_sink_writer(),
+              writer_(name, queue_len, chunk_size) {}
+
+    /// @brief Writes all submitted data. Errors are ignored, use flush to get them.
+    virtual ~bitstream_file_writer() {}
+
+    /// @brief Submits encoded data to write. Bitstream must not be reused until the writer releases it.
+    /// @param[in] bits Synchronized bitstream.
+    void put(std::shared_ptr<bitstream_as_dst> bits) {
+        writer_.push([bits](detail::async_file_writer& w) {
+            store(w, *bits);
+        });
+    }
+
+    /// @brief Submits encoded data to write. Future is synchronized by the writer, nothing is written if
+    /// the operation didn't produce data.
+    /// @param[in] bits Future of the encode operation.
+    void put(future<std::shared_ptr<bitstream_as_dst>> bits) {
+        auto f = std::make_shared<future<std::shared_ptr<bitstream_as_dst>>>(std::move(bits));
+        writer_.push([f](detail::async_file_writer& w) {
+            async_op_status sts = async_op_status::unknown;
+            f->on_complete([&](async_op_status s) {
+                sts = s;
+            });
+            auto& bits = f->get();
+            if (sts == async_op_status::ready && bits)
+                store(w, *bits);
+        });
+    }
+
+    /// @brief Waits until all submitted data is written to the file
+    void flush() {
+        writer_.flush();
+    }
+
+protected:
+    /// @brief Appends valid data of the bitstream to the write buffer
+    /// @param[in] w I/O thread writer
+    /// @param[in] bits Synchronized bitstream
+    static void store(detail::async_file_writer& w, bitstream_as_dst& bits) {
+        auto [ptr, length] = bits.get_valid_data();
+        if (ptr && length)
+            w.append(ptr, length);
+    }
+
+    /// @brief I/O thread writer.
+    detail::async_file_writer writer_;
+};
+
+/// @brief File based writer of uncomressed frames. Frames are synchronized, mapped and written by the I/O
+/// thread. In the frame write mode planes are packed without padding directly into the write buffer, so
+/// several frames are written with single write.
+class raw_frame_file_writer : public frame_sink_writer {
+public:
+    /// @brief Constructs writer with given file name
+    /// @param[in] width Width of the frames.
+    /// @param[in] heigth Heigh of the frames.
+    /// @param[in] format Color format of the frames.
+    /// @param[in] name Name of the file to write to.
+    /// @param[in] mode Write mode.
+    /// @param[in] queue_len Maximum number of frames waiting to be written.
+    /// @param[in] chunk_size Size of the write buffer in bytes.
+    raw_frame_file_writer(uint16_t width,
+                          uint16_t heigth,
+                          color_format_fourcc format,
+                          const std::string& name,
+                          raw_frame_write_mode mode = raw_frame_write_mode::frame,
+                          size_t queue_len          = 4,
+                          size_t chunk_size         = 8 * 1024 * 1024)
+            : frame_sink_writer(),
+              width_(width),
+              heigth_(heigth),
+              format_(format),
+              frame_size_(detail::raw_frame_size(format, width, heigth)),
+              mode_(mode),
+              staging_(nullptr),
+              writer_(name, queue_len, chunk_size) {}
+
+    /// @brief Writes all submitted frames. Errors are ignored, use flush to get them.
+    virtual ~raw_frame_file_writer() {}
+
+    /// @brief Submits frame to write. Surface must not be reused until the writer releases it.
+    /// @param[in] frame Frame to write.
+    void put(std::shared_ptr<frame_surface> frame) {
+        writer_.push([this, frame](detail::async_file_writer& w) {
+            store(w, *frame);
+        });
+    }
+
+    /// @brief Submits frame to write. Future is synchronized by the writer, nothing is written if the
+    /// operation didn't produce the frame.
+    /// @param[in] frame Future of the decode or VPP operation.
+    void put(future<std::shared_ptr<frame_surface>> frame) {
+        auto f = std::make_shared<future<std::shared_ptr<frame_surface>>>(std::move(frame));
+        writer_.push([this, f](detail::async_file_writer& w) {
+            async_op_status sts = async_op_status::unknown;
+            f->on_complete([&](async_op_status s) {
+                sts = s;
+            });
+            auto& frame = f->get();
+            if (sts == async_op_status::ready && frame)
+                store(w, *frame);
+        });
+    }
+
+    /// @brief Waits until all submitted frames are written to the file
+    void flush() {
+        writer_.flush();
+    }
+
+protected:
+    /// @brief Maps frame and writes its planes
+    /// @param[in] w I/O thread writer
+    /// @param[in] frame Frame to write
+    void store(detail::async_file_writer& w, frame_surface& frame) {
+        auto data = frame.map_data(memory_access::read);
+
+        if (mode_ == raw_frame_write_mode::frame)
+            staging_ = w.reserve(frame_size_);
+        else
+            w.write_chunk();
+
+        uint32_t pitch = data.get_pitch();
+        switch (format_) {
+            case oneapi::vpl::color_format_fourcc::i420: {
+                auto [Y, U, V] = data.get_plane_ptrs_3();
+
+                // write luminance plane (Y)
+                write_plane(w, Y, pitch, width_, heigth_);
+
+                // write chrominance (U, V)
+                write_plane(w, U, pitch / 2, width_ / 2, heigth_ / 2);
+                write_plane(w, V, pitch / 2, width_ / 2, heigth_ / 2);
+                break;
+            }
+            case oneapi::vpl::color_format_fourcc::nv12: {
+                auto [Y, UV] = data.get_plane_ptrs_2();
+
+                // write luminance plane (Y)
+                write_plane(w, Y, pitch, width_, heigth_);
+
+                // write chrominance (UV)
+                write_plane(w, UV, pitch, width_, heigth_ / 2);
+                break;
+            }
+            case oneapi::vpl::color_format_fourcc::bgra: {
+                auto B = data.get_plane_ptrs_1_BGRA();
+
+                write_plane(w, B, pitch, width_ * 4, heigth_);
+                break;
+            }
+            default:
+                frame.unmap();
+                throw base_exception("raw_frame_file_writer unsupported format",
+                                     MFX_ERR_NOT_IMPLEMENTED);
+        }
+        frame.unmap();
+    }
+
+    /// @brief Writes plane of the frame
+    /// @param[in] w I/O thread writer
+    /// @param[in] ptr Pointer to the plane
+    /// @param[in] pitch Pitch of the plane
+    /// @param[in] b_width Width of the plane
+    /// @param[in] b_height Height of the plane
+    void write_plane(detail::async_file_writer& w,
+                     const uint8_t* ptr,
+                     uint32_t pitch,
+                     uint16_t b_width,
+                     uint16_t b_height) {
+        if (mode_ == raw_frame_write_mode::frame) {
+            detail::pack_blob(staging_, ptr, pitch, b_width, b_height);
+            staging_ += (size_t)b_width * b_height;
+        }
+        else {
+            for (uint16_t i = 0; i < b_height; i++)
+                w.write(ptr + (size_t)i * pitch, b_width);
+        }
+    }
+
+    /// @brief Width of frame.
+    uint16_t width_;
+    /// @brief Height of frame.
+    uint16_t heigth_;
+    /// @brief Color format of frame.
+    color_format_fourcc format_;
+    /// @brief Size of the frame in the file.
+    size_t frame_size_;
+    /// @brief Write mode.
+    raw_frame_write_mode mode_;
+    /// @brief Write position in the write buffer, used by the I/O thread only.
+    uint8_t* staging_;
+    /// @brief I/O thread writer. Declared last, so the I/O thread is stopped before other members are
+    /// destroyed.
+    detail::async_file_writer writer_;
+};
+
+} // namespace vpl
+} // namespace oneapi
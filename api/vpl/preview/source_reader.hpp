@@ -6,10 +6,24 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #include "vpl/preview/bitstream.hpp"
 #include "vpl/preview/defs.hpp"
@@ -48,6 +62,53 @@ public:
     virtual bool get_data(std::shared_ptr<frame_surface> frame) = 0;
 };
 
+/// @brief Read mode of the raw frame readers
+enum class raw_frame_read_mode {
+    line, ///< Each line of each plane is read from the stream separately.
+    frame ///< Whole frame is read with single read into the staging buffer and then copied into the planes.
+};
+
+namespace detail {
+
+/// @brief Calculates size of the frame stored in the file without padding
+/// @param[in] format Color format of the frame.
+/// @param[in] width Width of the frame.
+/// @param[in] height Height of the frame.
+/// @return Size of the frame in bytes.
+inline size_t raw_frame_size(color_format_fourcc format, uint16_t width, uint16_t height) {
+    switch (format) {
+        case color_format_fourcc::i420:
+            return (size_t)width * height + 2 * ((size_t)(width / 2) * (height / 2));
+        case color_format_fourcc::nv12:
+            return (size_t)width * height + (size_t)width * (height / 2);
+        case color_format_fourcc::bgra:
+            return (size_t)width * 4 * height;
+        default:
+            throw base_exception("raw frame reader unsupported format", MFX_ERR_NOT_IMPLEMENTED);
+    }
+}
+
+/// @brief Copies continuous blob into the pitched plane. Single copy is used when plane has no padding.
+/// @param[in] dst Pointer to the plane
+/// @param[in] pitch Pitch of the plane
+/// @param[in] src Pointer to the continuous blob
+/// @param[in] b_width Width of the blob
+/// @param[in] b_height Height of the blob
+inline void copy_blob(uint8_t* dst,
+                      uint32_t pitch,
+                      const uint8_t* src,
+                      uint16_t b_width,
+                      uint16_t b_height) {
+    if (pitch == b_width) {
+        std::memcpy(dst, src, (size_t)b_width * b_height);
+        return;
+    }
+    for (uint16_t i = 0; i < b_height; i++)
+        std::memcpy(dst + (size_t)i * pitch, src + (size_t)i * b_width, b_width);
+}
+
+} // namespace detail
+
 /// @brief File based reader of uncomressed frames
 class raw_frame_file_reader : public frame_source_reader {
 public:
@@ -56,16 +117,21 @@ public:
     /// @param[in] heigth Heigh of the frames.
     /// @param[in] format Color format of the frames.
     /// @param[in] ifl Input stream to read from.
+    /// @param[in] mode Read mode.
     raw_frame_file_reader(uint16_t width,
                           uint16_t heigth,
                           color_format_fourcc format,
-                          std::ifstream& ifl)
+                          std::ifstream& ifl,
+                          raw_frame_read_mode mode = raw_frame_read_mode::line)
             : frame_source_reader(),
               width_(width),
               heigth_(heigth),
               format_(format),
               ifl_(ifl),
-              eof_(false) {}
+              eof_(false),
+              mode_(mode),
+              staging_(),
+              staging_pos_(0) {}
 
     /// @brief Default dtor
     virtual ~raw_frame_file_reader() {}
@@ -76,6 +142,9 @@ public:
     virtual bool get_data(std::shared_ptr<frame_surface> frame) {
         auto data = frame->map_data(memory_access::write);
 
+        if (mode_ == raw_frame_read_mode::frame)
+            load_frame();
+
         /// @todo verify buffer availability
 
         uint32_t pitch = 0;
@@ -85,11 +154,11 @@ public:
                 auto [Y, U, V] = data.get_plane_ptrs_3();
 
                 // read luminance plane (Y)
-                read_blob(Y, pitch, width_, heigth_);
+                read_plane(Y, pitch, width_, heigth_);
 
                 // read chrominance (U, V)
-                read_blob(U, pitch / 2, width_ / 2, heigth_ / 2);
-                read_blob(V, pitch / 2, width_ / 2, heigth_ / 2);
+                read_plane(U, pitch / 2, width_ / 2, heigth_ / 2);
+                read_plane(V, pitch / 2, width_ / 2, heigth_ / 2);
                 break;
             }
             case oneapi::vpl::color_format_fourcc::nv12: {
@@ -97,17 +166,18 @@ public:
                 auto [Y, UV]   = data.get_plane_ptrs_2();
 
                 // read luminance plane (Y)
-                read_blob(Y, pitch, width_, heigth_);
+                read_plane(Y, pitch, width_, heigth_);
 
                 // read chrominance (UV)
-                read_blob(UV, pitch, width_, heigth_ / 2);
+                read_plane(UV, pitch, width_, heigth_ / 2);
                 break;
             }
             case oneapi::vpl::color_format_fourcc::bgra: {
                 pitch    = data.get_pitch();
                 auto B = data.get_plane_ptrs_1_BGRA();
 
-                read_blob(B, pitch, width_ * 4, heigth_);
+                read_plane(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader unsupported format",
@@ -136,6 +206,32 @@ protected:
                 eof_ = true;
         }
     }
+
+    /// @brief Reads whole frame from the stream into the staging buffer with single read
+    void load_frame() {
+        size_t size = detail::raw_frame_size(format_, width_, heigth_);
+        if (staging_.size() != size)
+            staging_.resize(size);
+        ifl_.read(reinterpret_cast<char*>(staging_.data()), size);
+        if ((size_t)ifl_.gcount() != size)
+            eof_ = true;
+        staging_pos_ = 0;
+    }
+
+    /// @brief Stores plane of the frame into the buffer
+    /// @param[in] ptr Pointer to the buffer to store the data
+    /// @param[in] pitch Pitch in the buffer
+    /// @param[in] b_width Width of the plane
+    /// @param[in] b_height Height of the plane
+    void read_plane(uint8_t* ptr, uint32_t pitch, uint16_t b_width, uint16_t b_height) {
+        if (mode_ == raw_frame_read_mode::frame) {
+            detail::copy_blob(ptr, pitch, staging_.data() + staging_pos_, b_width, b_height);
+            staging_pos_ += (size_t)b_width * b_height;
+        }
+        else {
+            read_blob(ptr, pitch, b_width, b_height);
+        }
+    }
     /// @brief Width of frame.
     uint16_t width_;
     /// @brief Height of frame.
@@ -146,6 +242,12 @@ protected:
     std::ifstream& ifl_;
     /// @brief End of stream flag.
     bool eof_;
+    /// @brief Read mode.
+    raw_frame_read_mode mode_;
+    /// @brief Staging buffer for the whole frame read mode.
+    std::vector<uint8_t> staging_;
+    /// @brief Read position in the staging buffer.
+    size_t staging_pos_;
 };
 
 /// @brief File based reder of uncomressed frames
@@ -155,16 +257,21 @@ public:
     /// @param[in] width Width of the frames.
     /// @param[in] heigth Heigh of the frames.
     /// @param[in] format Color format of the frames.
-    /// @param[in] ifl Input stream to read from.
+    /// @param[in] name Name of the file to read from.
+    /// @param[in] mode Read mode.
     raw_frame_file_reader_by_name(uint16_t width,
                                   uint16_t heigth,
                                   color_format_fourcc format,
-                                  const std::string& name)
+                                  const std::string& name,
+                                  raw_frame_read_mode mode = raw_frame_read_mode::line)
             : frame_source_reader(),
               width_(width),
               heigth_(heigth),
               format_(format),
-              eof_(false) {
+              eof_(false),
+              mode_(mode),
+              staging_(),
+              staging_pos_(0) {
         if_.open(name, std::ios_base::in | std::ios_base::binary);
         if (!if_) {
             throw file_exception(std::string("Couldn't open ") + name);
@@ -183,6 +290,9 @@ public:
     virtual bool get_data(std::shared_ptr<frame_surface> frame) {
         auto data = frame->map_data(memory_access::write);
 
+        if (mode_ == raw_frame_read_mode::frame)
+            load_frame();
+
         /// @todo verify buffer avialability
         uint32_t pitch = 0;
         switch (format_) {
@@ -191,11 +301,11 @@ public:
                 auto [Y, U, V] = data.get_plane_ptrs_3();
 
                 // read luminance plane (Y)
-                read_blob(Y, pitch, width_, heigth_);
+                read_plane(Y, pitch, width_, heigth_);
 
                 // read chrominance (U, V)
-                read_blob(U, pitch / 2, width_ / 2, heigth_ / 2);
-                read_blob(V, pitch / 2, width_ / 2, heigth_ / 2);
+                read_plane(U, pitch / 2, width_ / 2, heigth_ / 2);
+                read_plane(V, pitch / 2, width_ / 2, heigth_ / 2);
                 break;
             }
             case oneapi::vpl::color_format_fourcc::nv12: {
@@ -203,17 +313,18 @@ public:
                 auto [Y, UV]   = data.get_plane_ptrs_2();
 
                 // read luminance plane (Y)
-                read_blob(Y, pitch, width_, heigth_);
+                read_plane(Y, pitch, width_, heigth_);
 
                 // read chrominance (UV)
-                read_blob(UV, pitch, width_, heigth_ / 2);
+                read_plane(UV, pitch, width_, heigth_ / 2);
                 break;
             }
             case oneapi::vpl::color_format_fourcc::bgra: {
                 pitch    = data.get_pitch();
                 auto B = data.get_plane_ptrs_1_BGRA();
 
-                read_blob(B, pitch, width_ * 4, heigth_);
+                read_plane(B, pitch, width_ * 4, heigth_);
+                break;
             }
             default:
                 throw base_exception("raw_frame_file_reader_by_name unsupported format",
@@ -242,6 +353,32 @@ protected:
                 eof_ = true;
         }
     }
+
+    /// @brief Reads whole frame from the stream into the staging buffer with single read
+    void load_frame() {
+        size_t size = detail::raw_frame_size(format_, width_, heigth_);
+        if (staging_.size() != size)
+            staging_.resize(size);
+        if_.read(reinterpret_cast<char*>(staging_.data()), size);
+        if ((size_t)if_.gcount() != size)
+            eof_ = true;
+        staging_pos_ = 0;
+    }
+
+    /// @brief Stores plane of the frame into the buffer
+    /// @param[in] ptr Pointer to the buffer to store the data
+    /// @param[in] pitch Pitch in the buffer
+    /// @param[in] b_width Width of the plane
+    /// @param[in] b_height Height of the plane
+    void read_plane(uint8_t* ptr, uint32_t pitch, uint16_t b_width, uint16_t b_height) {
+        if (mode_ == raw_frame_read_mode::frame) {
+            detail::copy_blob(ptr, pitch, staging_.data() + staging_pos_, b_width, b_height);
+            staging_pos_ += (size_t)b_width * b_height;
+        }
+        else {
+            read_blob(ptr, pitch, b_width, b_height);
+        }
+    }
     /// @brief Width of frame.
     uint16_t width_;
     /// @brief Height of frame.
@@ -252,6 +389,12 @@ protected:
     std::ifstream if_;
     /// @brief End of stream flag.
     bool eof_;
+    /// @brief Read mode.
+    raw_frame_read_mode mode_;
+    /// @brief Staging buffer for the whole frame read mode.
+    std::vector<uint8_t> staging_;
+    /// @brief Read position in the staging buffer.
+    size_t staging_pos_;
 };
 
 /// @brief Interface for the bitstream source data reader
@@ -340,5 +483,161 @@ protected:
     std::ifstream if_;
 };
 
+/// @brief Zero-copy source data reader over the memory buffer. Bitstream is pointed at the buffer directly,
+/// so the data is consumed in place without copying into the bitstream's internal buffer. Buffer must stay
+/// valid while the reader is in use.
+class bitstream_memory_reader : public bitstream_source_reader {
+public:
+    /// @brief Constructs reader over the given buffer
+    /// @param[in] data Pointer to the buffer
+    /// @param[in] size Size of the buffer in bytes
+    /// @param[in] window Maximum number of bytes exposed to the bitstream at once
+    bitstream_memory_reader(const uint8_t* data,
+                            size_t size,
+                            uint32_t window = bitstream::buffer_len::DEFAULT_LENGHT)
+            : bitstream_source_reader(),
+              data_(data),
+              size_(size),
+              window_(window ? window : bitstream::buffer_len::DEFAULT_LENGHT),
+              window_start_(0),
+              eos_(size == 0) {}
+
+    /// @brief Default dtor
+    virtual ~bitstream_memory_reader() {}
+
+    /// @brief Points @p bitstream object at the next portion of the buffer. Data consumed by the decoder is
+    /// skipped by moving the window, no data is copied.
+    /// @param[out] bits data storage
+    /// @return True if data was read
+    bool get_data(bitstream_as_src* bits) {
+        mfxBitstream* b = (*bits)();
+
+        if (bits->is_attached() && b->Data == data_ + window_start_)
+            window_start_ += b->DataOffset;
+        else
+            window_start_ = 0;
+
+        size_t length = std::min<size_t>(size_ - window_start_, window_);
+        bits->attach(data_ + window_start_, (uint32_t)length);
+        eos_ = (window_start_ + length == size_);
+        return true;
+    }
+
+    /// @brief Checks and retrieve end of stream status
+    /// @return True if EOS reached
+    bool is_EOS() const {
+        return eos_;
+    }
+
+protected:
+    /// @brief Rebinds reader to the new buffer
+    /// @param[in] data Pointer to the buffer
+    /// @param[in] size Size of the buffer in bytes
+    void set_buffer(const uint8_t* data, size_t size) {
+        data_         = data;
+        size_         = size;
+        window_start_ = 0;
+        eos_          = (size == 0);
+    }
+
+    /// @brief Pointer to the buffer
+    const uint8_t* data_;
+    /// @brief Size of the buffer
+    size_t size_;
+    /// @brief Maximum number of bytes exposed to the bitstream at once
+    uint32_t window_;
+    /// @brief Offset of the data exposed to the bitstream
+    size_t window_start_;
+    /// @brief End of stream flag
+    bool eos_;
+};
+
+/// @brief Zero-copy source data reader over the memory-mapped file. Pages are read by the decoder directly
+/// from the page cache.
+class bitstream_mapped_file_reader : public bitstream_memory_reader {
+public:
+    /// @brief Maps given file to the memory
+    /// @param[in] name File name
+    /// @param[in] window Maximum number of bytes exposed to the bitstream at once
+    explicit bitstream_mapped_file_reader(const std::string& name,
+                                          uint32_t window = bitstream::buffer_len::DEFAULT_LENGHT)
+            : bitstream_memory_reader(nullptr, 0, window),
+              map_(nullptr),
+              map_size_(0) {
+#if defined(_WIN32) || defined(_WIN64)
+        HANDLE file = CreateFileA(name.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN,
+                                  nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw file_exception(std::string("Couldn't open ") + name);
+
+        LARGE_INTEGER file_size = {};
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            throw file_exception(std::string("Error opening ") + name);
+        }
+        map_size_ = (size_t)file_size.QuadPart;
+
+        if (map_size_) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping)
+                map_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            // view keeps the mapping alive
+            if (mapping)
+                CloseHandle(mapping);
+        }
+        CloseHandle(file);
+#else
+        int fd = open(name.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw file_exception(std::string("Couldn't open ") + name);
+
+        struct stat st = {};
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw file_exception(std::string("Error opening ") + name);
+        }
+        map_size_ = (size_t)st.st_size;
+
+        if (map_size_) {
+            void* ptr = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED) {
+                map_ = ptr;
+                madvise(map_, map_size_, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+#endif
+        if (map_size_ && !map_)
+            throw file_exception(std::string("Couldn't map ") + name);
+
+        set_buffer(reinterpret_cast<const uint8_t*>(map_), map_size_);
+    }
+
+    bitstream_mapped_file_reader(const bitstream_mapped_file_reader&)            = delete;
+    bitstream_mapped_file_reader& operator=(const bitstream_mapped_file_reader&) = delete;
+
+    /// @brief Unmaps the file
+    virtual ~bitstream_mapped_file_reader() {
+        if (map_) {
+#if defined(_WIN32) || defined(_WIN64)
+            UnmapViewOfFile(map_);
+#else
+            munmap(map_, map_size_);
+#endif
+        }
+    }
+
+protected:
+    /// @brief Mapped file view
+    void* map_;
+    /// @brief Size of the mapped file view
+    size_t map_size_;
+};
+
 } // namespace vpl
 } // namespace oneapi
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include "vpl/mfxstructures.h"
 namespace oneapi {
@@ -143,5 +146,174 @@ protected:
     mfxVPPStat stat_;
 };
 
+/// @brief Session's latency and throughput statistic. Latency of the operation is the time from its
+/// submission till the moment its completion is observed by wait, get or poll of the future object.
+/// Latencies are collected to the histogram with logarithmic buckets, four buckets per power of two, so
+/// percentiles have up to 25% error. Throughput is calculated over sliding window. Recording is lock-free
+/// and may be done from any thread.
+class latency_stat {
+public:
+    /// @brief Number of sub-buckets per power of two.
+    static constexpr uint32_t SUB_BUCKETS = 4;
+    /// @brief Number of histogram buckets. Covers latencies up to 2^32 microseconds.
+    static constexpr uint32_t NUM_BUCKETS = 32 * SUB_BUCKETS;
+    /// @brief Number of slots in the sliding window.
+    static constexpr uint32_t NUM_SLOTS = 16;
+
+    /// @brief Constructs statistic with given throughput window.
+    /// @param[in] window Duration of the sliding window to calculate throughput over.
+    explicit latency_stat(std::chrono::milliseconds window = std::chrono::milliseconds(1000))
+            : window_(window.count() > 0 ? window : std::chrono::milliseconds(1)),
+              slot_length_(std::chrono::duration_cast<std::chrono::nanoseconds>(window_).count() /
+                           NUM_SLOTS),
+              num_samples_(0),
+              buckets_(),
+              slot_epochs_(),
+              slot_counts_() {
+        if (slot_length_ == 0)
+            slot_length_ = 1;
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++)
+            buckets_[i] = 0;
+        for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+            slot_epochs_[i] = -1;
+            slot_counts_[i] = 0;
+        }
+    }
+
+    latency_stat(const latency_stat &)            = delete;
+    latency_stat &operator=(const latency_stat &) = delete;
+
+    /// @brief Records latency of the completed operation.
+    /// @param[in] latency Latency of the operation.
+    template <class Rep, class Period>
+    void record(const std::chrono::duration<Rep, Period> &latency) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        buckets_[bucket_index(us > 0 ? (uint64_t)us : 0)].fetch_add(1, std::memory_order_relaxed);
+        num_samples_.fetch_add(1, std::memory_order_relaxed);
+
+        int64_t epoch = now_ns() / slot_length_;
+        auto &slot    = slot_epochs_[epoch % NUM_SLOTS];
+        int64_t old   = slot.load(std::memory_order_relaxed);
+        if (old != epoch && slot.compare_exchange_strong(old, epoch, std::memory_order_relaxed))
+            slot_counts_[epoch % NUM_SLOTS].store(0, std::memory_order_relaxed);
+        slot_counts_[epoch % NUM_SLOTS].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// @brief Retrieves number of recorded operations
+    /// @return Number of recorded operations
+    uint64_t get_num_samples() const {
+        return num_samples_.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Retrieves latency percentile.
+    /// @param[in] percentile Percentile in the range [0, 100].
+    /// @return Lower bound of the histogram bucket which contains the percentile, or zero if nothing is
+    /// recorded.
+    std::chrono::microseconds get_percentile(double percentile) const {
+        uint64_t total = 0;
+        std::array<uint64_t, NUM_BUCKETS> counts;
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+            counts[i] = buckets_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (!total)
+            return std::chrono::microseconds(0);
+
+        percentile      = percentile < 0 ? 0 : (percentile > 100 ? 100 : percentile);
+        uint64_t rank   = (uint64_t)(percentile / 100.0 * (double)(total - 1)) + 1;
+        uint64_t passed = 0;
+        for (uint32_t i = 0; i < NUM_BUCKETS; i++) {
+            passed += counts[i];
+            if (passed >= rank)
+                return std::chrono::microseconds(bucket_lower_bound(i));
+        }
+        return std::chrono::microseconds(bucket_lower_bound(NUM_BUCKETS - 1));
+    }
+
+    /// @brief Retrieves median latency
+    /// @return Median latency
+    std::chrono::microseconds get_p50() const {
+        return get_percentile(50);
+    }
+
+    /// @brief Retrieves 95th percentile of latency
+    /// @return 95th percentile of latency
+    std::chrono::microseconds get_p95() const {
+        return get_percentile(95);
+    }
+
+    /// @brief Retrieves 99th percentile of latency
+    /// @return 99th percentile of latency
+    std::chrono::microseconds get_p99() const {
+        return get_percentile(99);
+    }
+
+    /// @brief Retrieves number of operations completed per second over the sliding window
+    /// @return Operations per second
+    double get_fps() const {
+        int64_t now     = now_ns();
+        int64_t epoch   = now / slot_length_;
+        uint64_t counts = 0;
+        for (uint32_t i = 0; i < NUM_SLOTS; i++) {
+            int64_t e = slot_epochs_[i].load(std::memory_order_relaxed);
+            if (e >= 0 && e > epoch - NUM_SLOTS && e <= epoch)
+                counts += slot_counts_[i].load(std::memory_order_relaxed);
+        }
+        double span = (double)((NUM_SLOTS - 1) * slot_length_ + now % slot_length_) / 1e9;
+        return (double)counts / span;
+    }
+
+    /// @brief Retrieves duration of the sliding window
+    /// @return Duration of the sliding window
+    std::chrono::milliseconds get_window() const {
+        return window_;
+    }
+
+protected:
+    /// @brief Maps latency to the histogram bucket.
+    /// @param[in] us Latency in microseconds.
+    /// @return Bucket index.
+    static uint32_t bucket_index(uint64_t us) {
+        if (us < SUB_BUCKETS)
+            return (uint32_t)us;
+        uint32_t exp = 63;
+        while (!(us >> exp))
+            exp--;
+        uint32_t idx = SUB_BUCKETS * (exp - 1) + (uint32_t)((us >> (exp - 2)) & (SUB_BUCKETS - 1));
+        return idx < NUM_BUCKETS ? idx : NUM_BUCKETS - 1;
+    }
+
+    /// @brief Provides smallest latency which falls into the bucket.
+    /// @param[in] idx Bucket index.
+    /// @return Latency in microseconds.
+    static uint64_t bucket_lower_bound(uint32_t idx) {
+        if (idx < SUB_BUCKETS)
+            return idx;
+        uint32_t exp = idx / SUB_BUCKETS + 1;
+        return (uint64_t)(SUB_BUCKETS + idx % SUB_BUCKETS) << (exp - 2);
+    }
+
+    /// @brief Provides monotonic time.
+    /// @return Time in nanoseconds.
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// @brief Duration of the sliding window.
+    std::chrono::milliseconds window_;
+    /// @brief Duration of the window slot in nanoseconds.
+    int64_t slot_length_;
+    /// @brief Number of recorded operations.
+    std::atomic<uint64_t> num_samples_;
+    /// @brief Latency histogram.
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_;
+    /// @brief Epoch of each window slot.
+    std::array<std::atomic<int64_t>, NUM_SLOTS> slot_epochs_;
+    /// @brief Number of completed operations in each window slot.
+    std::array<std::atomic<uint64_t>, NUM_SLOTS> slot_counts_;
+};
+
 } // namespace vpl
 } // namespace oneapi
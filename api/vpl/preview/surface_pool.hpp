@@ -7,19 +7,171 @@
 #pragma once
 
 #include <cinttypes>
+#include <memory>
+
 #include "vpl/mfxsurfacepool.h"
 #include "extension_buffer.hpp"
+
+#include "vpl/preview/defs.hpp"
+#include "vpl/preview/exception.hpp"
+#include "vpl/preview/frame_surface.hpp"
+
+#include "vpl/preview/detail/sdk_callable.hpp"
+
 namespace oneapi {
 namespace vpl {
 
 enum class vppl_pool_type : uint32_t {
-    input_pool,
-    output_pool,
+    input_pool  = MFX_VPP_POOL_IN,
+    output_pool = MFX_VPP_POOL_OUT,
+};
+
+/*! @brief Instantiation of the extension_buffer template class for given C structure and ID.*/
+/*! Attach to the init parameters of the session to define its surface pool management policy.*/
+class ExtAllocationHints
+        : public extension_buffer_trival<mfxExtAllocationHints, MFX_EXTBUFF_ALLOCATION_HINTS> {
+public:
+    /*! @brief Default ctor. */
+    ExtAllocationHints() : extension_buffer_trival() {}
+
+    /*! @brief Constructs allocation hints. */
+    /*! @param[in] policy Allocation policy. */
+    /*! @param[in] preallocate Number of surfaces to allocate during Init. */
+    /*! @param[in] delta Number of surfaces allowed to be allocated on the fly in addition to preallocated
+        ones. Used with limited policy only. */
+    ExtAllocationHints(pool_alloction_policy policy, uint32_t preallocate, uint32_t delta = 0)
+            : extension_buffer_trival() {
+        set_allocation_policy(policy);
+        set_number_to_preallocate(preallocate);
+        set_delta_to_allocate_on_the_fly(delta);
+    }
+
+    /*! @brief Sets allocation policy. */
+    /*! @param[in] policy Allocation policy. */
+    void set_allocation_policy(pool_alloction_policy policy) {
+        this->buffer_.AllocationPolicy = (mfxPoolAllocationPolicy)policy;
+    }
+
+    /*! @brief Sets number of surfaces to allocate during Init. */
+    /*! @param[in] num Number of surfaces. */
+    void set_number_to_preallocate(uint32_t num) {
+        this->buffer_.NumberToPreAllocate = num;
+    }
+
+    /*! @brief Sets number of surfaces allowed to be allocated on the fly in limited policy. */
+    /*! @param[in] num Number of surfaces. */
+    void set_delta_to_allocate_on_the_fly(uint32_t num) {
+        this->buffer_.DeltaToAllocateOnTheFly = num;
+    }
+
+    /*! @brief Sets targeted VPP pool. Ignored for other components. */
+    /*! @param[in] type Pool type. */
+    void set_vpp_pool_type(vppl_pool_type type) {
+        this->buffer_.VPPPoolType = (mfxVPPPoolType)type;
+    }
+
+    /*! @brief Sets time to wait for the free surface when pool reached its maximum size. */
+    /*! @param[in] wait_ms Time in milliseconds. */
+    void set_wait(uint32_t wait_ms) {
+        this->buffer_.Wait = wait_ms;
+    }
 };
 
-REGISTER_TRIVIAL_EXT_BUFFER(ExtAllocationHints,
-                            mfxExtAllocationHints,
-                            MFX_EXTBUFF_ALLOCATION_HINTS)
+/// @brief Manages surface pool of the session component. Pool is obtained from the surface allocated by the
+/// component and stays valid while this object exists. Pool management policy is defined at session
+/// initialization via ExtAllocationHints.
+class surface_pool {
+public:
+    /// @brief Obtains pool which the surface belongs to.
+    /// @param[in] surface Surface allocated by the session component.
+    explicit surface_pool(mfxFrameSurface1 *surface) : pool_(nullptr) {
+        mfxHDL pool = nullptr;
+        detail::c_api_invoker e(detail::default_checker,
+                                surface->FrameInterface->QueryInterface,
+                                surface,
+                                MFX_GUID_SURFACE_POOL,
+                                &pool);
+        pool_ = reinterpret_cast<mfxSurfacePoolInterface *>(pool);
+    }
+
+    /// @brief Obtains pool which the surface belongs to.
+    /// @param[in] surface Surface allocated by the session component.
+    explicit surface_pool(std::shared_ptr<frame_surface> surface)
+            : surface_pool(surface->get_raw_ptr()) {}
+
+    /// @brief Copy ctor. Increments pool reference counter value.
+    /// @param[in] other another object to use as data source
+    surface_pool(const surface_pool &other) : pool_(other.pool_) {
+        detail::c_api_invoker e(detail::default_checker, pool_->AddRef, pool_);
+    }
+
+    surface_pool &operator=(const surface_pool &) = delete;
+
+    /// @brief Dtor. Decrements pool reference counter value.
+    ~surface_pool() {
+        if (pool_)
+            pool_->Release(pool_);
+    }
+
+    /// @brief Returns current allocation policy.
+    /// @return Allocation policy.
+    pool_alloction_policy get_allocation_policy() const {
+        mfxPoolAllocationPolicy policy;
+        detail::c_api_invoker e(detail::default_checker,
+                                pool_->GetAllocationPolicy,
+                                pool_,
+                                &policy);
+        return (pool_alloction_policy)policy;
+    }
+
+    /// @brief Returns maximum pool size. 0xFFFFFFFF is returned for unlimited policy.
+    /// @return Maximum number of surfaces in the pool.
+    uint32_t get_maximum_size() const {
+        mfxU32 size;
+        detail::c_api_invoker e(detail::default_checker,
+                                pool_->GetMaximumPoolSize,
+                                pool_,
+                                &size);
+        return size;
+    }
+
+    /// @brief Returns current pool size, i.e. number of surfaces allocated in the pool so far.
+    /// @return Number of surfaces in the pool.
+    uint32_t get_current_size() const {
+        mfxU32 size;
+        detail::c_api_invoker e(detail::default_checker,
+                                pool_->GetCurrentPoolSize,
+                                pool_,
+                                &size);
+        return size;
+    }
+
+    /// @brief Specifies number of surfaces used concurrently. Applicable for optimal policy only.
+    /// @param[in] num Number of surfaces.
+    /// @return Ok or warning.
+    status set_num_surfaces(uint32_t num) {
+        detail::c_api_invoker e(detail::default_checker, pool_->SetNumSurfaces, pool_, num);
+        return (status)e.sts_;
+    }
+
+    /// @brief Revokes surfaces requested by set_num_surfaces. Applicable for optimal policy only.
+    /// @param[in] num Number of surfaces. Must be the same as requested by set_num_surfaces.
+    /// @return Ok or warning.
+    status revoke_surfaces(uint32_t num) {
+        detail::c_api_invoker e(detail::default_checker, pool_->RevokeSurfaces, pool_, num);
+        return (status)e.sts_;
+    }
+
+    /// @brief Provides pointer to the raw pool interface.
+    /// @return Pointer to the raw pool interface.
+    mfxSurfacePoolInterface *get_raw_ptr() {
+        return pool_;
+    }
+
+protected:
+    /// @brief Pool interface.
+    mfxSurfacePoolInterface *pool_;
+};
 
 } // namespace vpl
 } // namespace oneapi
@@ -179,6 +179,7 @@ public:
     DECLARE_MEMBER_ACCESS(frame_info, uint16_t, BitDepthChroma)
     DECLARE_MEMBER_ACCESS(frame_info, uint16_t, Shift)
     DECLARE_MEMBER_ACCESS(frame_info, mfxFrameId, FrameId)
+    DECLARE_MEMBER_ACCESS(frame_info, uint16_t, ChannelId)
 
     /// @brief Returns color format fourCC value.
     /// @return color format fourCC value.
@@ -7,7 +7,9 @@
 #pragma once
 
 #include "vpl/preview/bitstream.hpp"
+#include "vpl/preview/coroutine.hpp"
 #include "vpl/preview/defs.hpp"
+#include "vpl/preview/device_context.hpp"
 #include "vpl/preview/exception.hpp"
 #include "vpl/preview/extension_buffer.hpp"
 #include "vpl/preview/extension_buffer_list.hpp"
@@ -18,7 +20,12 @@
 #include "vpl/preview/options.hpp"
 #include "vpl/preview/option_tree.hpp"
 #include "vpl/preview/payload.hpp"
+#include "vpl/preview/pipeline.hpp"
+#include "vpl/preview/query_cache.hpp"
+#include "vpl/preview/result.hpp"
 #include "vpl/preview/session.hpp"
+#include "vpl/preview/shared_surface.hpp"
+#include "vpl/preview/sink_writer.hpp"
 #include "vpl/preview/source_reader.hpp"
 #include "vpl/preview/stat.hpp"
 #include "vpl/preview/video_param.hpp"
@@ -6,20 +6,27 @@
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "vpl/mfxdispatcher.h"
 #include "vpl/mfxvideo.h"
 
 #include "linux/device_ids.h"
 #include "linux/mfxloader.h"
+#include "vpl/mfx_dispatcher_vpl_admission.h"
 
 namespace MFX {
 
@@ -68,6 +75,92 @@ enum Function2 {
     eFunctionsNum2,
 };
 
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+// per-frame functions which are called through LoaderCtx::m_directCalls
+//   instead of the shared function table (see BUILD_DISPATCHER_DIRECT_CALLS)
+enum DirectFunction {
+    eDirectDecodeFrameAsync,
+    eDirectEncodeFrameAsync,
+    eDirectRunFrameVPPAsync,
+    eDirectSyncOperation,
+
+    eDirectFunctionsNum,
+    eNoDirectFunction = -1,
+};
+
+constexpr int GetDirectFunction(Function func) {
+    return (func == eMFXVideoDECODE_DecodeFrameAsync)  ? eDirectDecodeFrameAsync
+           : (func == eMFXVideoENCODE_EncodeFrameAsync) ? eDirectEncodeFrameAsync
+           : (func == eMFXVideoVPP_RunFrameVPPAsync)    ? eDirectRunFrameVPPAsync
+           : (func == eMFXVideoCORE_SyncOperation)      ? eDirectSyncOperation
+                                                        : eNoDirectFunction;
+}
+#endif
+
+// map session function to its entry in mfxDispatcherSessionStats
+constexpr int GetStatsFunction(Function func) {
+    return (func == eMFXVideoDECODE_DecodeFrameAsync)  ? MFX_DISPSTATS_DECODE_FRAME_ASYNC
+           : (func == eMFXVideoENCODE_EncodeFrameAsync) ? MFX_DISPSTATS_ENCODE_FRAME_ASYNC
+           : (func == eMFXVideoVPP_RunFrameVPPAsync)    ? MFX_DISPSTATS_RUN_FRAME_VPP_ASYNC
+           : (func == eMFXVideoCORE_SyncOperation)      ? MFX_DISPSTATS_SYNC_OPERATION
+                                                        : -1;
+}
+
+// per-session call counters, allocated only if ONEVPL_DISPATCHER_SESSION_STATS=ON
+// functions may be called from several threads on one session, so all counters are atomic
+struct CallStats {
+    std::atomic<mfxU64> numCalls{ 0 };
+    std::atomic<mfxU64> totalTime{ 0 };
+    std::atomic<mfxU64> numDeviceBusy{ 0 };
+    std::atomic<mfxU64> numMoreData{ 0 };
+    std::atomic<mfxU64> histogram[MFX_DISPSTATS_NUM_BUCKETS]{};
+};
+
+struct SessionStats {
+    CallStats calls[MFX_DISPSTATS_NUM_FUNCTIONS];
+
+    void AddCall(int func, mfxU64 timeNs, mfxStatus sts) {
+        CallStats &c = calls[func];
+
+        c.numCalls.fetch_add(1, std::memory_order_relaxed);
+        c.totalTime.fetch_add(timeNs, std::memory_order_relaxed);
+
+        if (sts == MFX_WRN_DEVICE_BUSY)
+            c.numDeviceBusy.fetch_add(1, std::memory_order_relaxed);
+        else if (sts == MFX_ERR_MORE_DATA)
+            c.numMoreData.fetch_add(1, std::memory_order_relaxed);
+
+        // bucket 0 is < 1 usec, bucket k is [2^(k-1), 2^k) usec
+        mfxU64 timeUs = timeNs / 1000;
+        int bucket    = 0;
+        while (timeUs && bucket < MFX_DISPSTATS_NUM_BUCKETS - 1) {
+            timeUs >>= 1;
+            bucket++;
+        }
+        c.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+template <typename F>
+inline mfxStatus CallWithStats(SessionStats *stats, int func, F call) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    mfxStatus sts = call();
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    stats->AddCall(
+        func,
+        (mfxU64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        sts);
+
+    return sts;
+}
+
+static bool IsSessionStatsEnabled() {
+    const char *envVal = getenv("ONEVPL_DISPATCHER_SESSION_STATS");
+    return (envVal && std::string(envVal) == "ON");
+}
+
 struct FunctionsTable {
     Function id;
     const char *name;
@@ -115,6 +208,109 @@ static const FunctionsTable2 g_mfxFuncTable2[] = {
     { eMFXVideoVPP_ProcessFrameAsync, "MFXVideoVPP_ProcessFrameAsync", VERSION(2, 1) },
 };
 
+// exports resolved from one library, shared by all sessions loaded from it
+// entries are never modified after the table is created
+struct LibFuncTable {
+    std::shared_ptr<void> dlh;
+    void *table[eFunctionsNum]{};
+    void *table2[eFunctionsNum2]{};
+    void *cloneSession = nullptr;
+};
+
+std::shared_ptr<void> make_dlopen(const char *filename, int flags) {
+    return std::shared_ptr<void>(dlopen(filename, flags), [](void *handle) {
+        if (handle)
+            dlclose(handle);
+    });
+}
+
+// return the function table for the library, resolving exports only if no
+//   live session is already using it (library is closed with the last reference)
+static std::shared_ptr<const LibFuncTable> GetLibFuncTable(const std::string &lib) {
+    static std::mutex tableMutex;
+    static std::list<std::pair<std::string, std::weak_ptr<const LibFuncTable>>> tableList;
+
+    std::lock_guard<std::mutex> lock(tableMutex);
+
+    auto it = tableList.begin();
+    while (it != tableList.end()) {
+        std::shared_ptr<const LibFuncTable> funcs = it->second.lock();
+        if (funcs && it->first == lib)
+            return funcs;
+
+        if (!funcs)
+            it = tableList.erase(it);
+        else
+            it++;
+    }
+
+    std::shared_ptr<void> hdl = make_dlopen(lib.c_str(), RTLD_LOCAL | RTLD_NOW);
+    if (!hdl)
+        return nullptr;
+
+    std::shared_ptr<LibFuncTable> funcs = std::make_shared<LibFuncTable>();
+    for (int i = 0; i < eFunctionsNum; ++i) {
+        assert(i == g_mfxFuncTable[i].id);
+        funcs->table[i] = dlsym(hdl.get(), g_mfxFuncTable[i].name);
+    }
+
+    for (int i = 0; i < eFunctionsNum2; ++i) {
+        assert(i == g_mfxFuncTable2[i].id);
+        funcs->table2[i] = dlsym(hdl.get(), g_mfxFuncTable2[i].name);
+    }
+
+    // MFXCloneSession is optional (not included in version check)
+    funcs->cloneSession = dlsym(hdl.get(), "MFXCloneSession");
+    funcs->dlh          = std::move(hdl);
+
+    tableList.emplace_back(lib, funcs);
+
+    return funcs;
+}
+
+// library found by the search of the legacy MFXInit(Ex) path for an implementation and
+//   requested API version
+typedef std::pair<mfxIMPL, mfxU32> ResolvedLibKey;
+
+struct ResolvedLib {
+    std::string lib;
+    mfxU16 deviceID;
+    std::shared_ptr<const LibFuncTable> funcs;
+};
+
+// the search result is kept for the process, so next sessions of the implementation skip
+//   the device query, the library search and symbol resolution, and the library stays
+//   loaded until exit (the cache is never destroyed to not unload it from static destructors)
+static std::mutex &GetResolvedLibMutex() {
+    static std::mutex *resolvedLibMutex = new std::mutex;
+    return *resolvedLibMutex;
+}
+
+static std::map<ResolvedLibKey, ResolvedLib> &GetResolvedLibs() {
+    static auto *resolvedLibs = new std::map<ResolvedLibKey, ResolvedLib>;
+    return *resolvedLibs;
+}
+
+static bool FindResolvedLib(const ResolvedLibKey &key, ResolvedLib &resolved) {
+    std::lock_guard<std::mutex> lock(GetResolvedLibMutex());
+
+    auto it = GetResolvedLibs().find(key);
+    if (it == GetResolvedLibs().end())
+        return false;
+
+    resolved = it->second;
+    return true;
+}
+
+static void SetResolvedLib(const ResolvedLibKey &key, const ResolvedLib *resolved) {
+    std::lock_guard<std::mutex> lock(GetResolvedLibMutex());
+
+    if (resolved)
+        GetResolvedLibs()[key] = *resolved;
+    else
+        GetResolvedLibs().erase(key);
+}
+
 class LoaderCtx {
 public:
     mfxStatus Init(mfxInitParam &par,
@@ -125,13 +321,30 @@ public:
     mfxStatus Close();
 
     inline void *getFunction(Function func) const {
-        return m_table[func];
+        return m_funcs ? m_funcs->table[func] : nullptr;
     }
 
+    // 2.x functions are only exposed to sessions created with API >= 2.0
     inline void *getFunction2(Function2 func) const {
-        return m_table2[func];
+        return (m_funcs && m_bTable2) ? m_funcs->table2[func] : nullptr;
+    }
+
+    inline void *getCloneSession() const {
+        return m_funcs ? m_funcs->cloneSession : nullptr;
     }
 
+    // nullptr unless stats are enabled for this session
+    inline SessionStats *getStats() const {
+        return m_stats.get();
+    }
+
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+    // only valid after successful Init()
+    inline void *getDirectFunction(int func) const {
+        return m_directCalls[func];
+    }
+#endif
+
     inline mfxSession getSession() const {
         return m_session;
     }
@@ -145,7 +358,7 @@ public:
     }
 
     inline void *getHandle() const {
-        return m_dlh.get();
+        return m_funcs ? m_funcs->dlh.get() : nullptr;
     }
 
     inline const char *getLibPath() const {
@@ -162,22 +375,18 @@ public:
     }
 
 private:
-    std::shared_ptr<void> m_dlh;
+    std::shared_ptr<const LibFuncTable> m_funcs;
+    bool m_bTable2 = false;
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+    void *m_directCalls[eDirectFunctionsNum]{};
+#endif
     mfxVersion m_version{};
     mfxIMPL m_implementation{};
     mfxSession m_session = nullptr;
-    void *m_table[eFunctionsNum]{};
-    void *m_table2[eFunctionsNum2]{};
     std::string m_libToLoad;
+    std::unique_ptr<SessionStats> m_stats;
 };
 
-std::shared_ptr<void> make_dlopen(const char *filename, int flags) {
-    return std::shared_ptr<void>(dlopen(filename, flags), [](void *handle) {
-        if (handle)
-            dlclose(handle);
-    });
-}
-
 mfxStatus LoaderCtx::Init(mfxInitParam &par,
                           mfxInitializationParam &vplParam,
                           mfxU16 *pDeviceID,
@@ -187,36 +396,44 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
 
     std::vector<std::string> libs;
     std::vector<Device> devices;
-    eMFXHWType msdk_platform;
-
-    // query graphics device_id
-    // if it is found on list of legacy devices, load MSDK RT
-    // otherwise load oneVPL RT
-    mfxU16 deviceID = 0;
-    mfx_res         = get_devices(devices);
-    if (mfx_res == MFX_ERR_NOT_FOUND) {
-        // query failed
-        msdk_platform = MFX_HW_UNKNOWN;
+    eMFXHWType msdk_platform = MFX_HW_UNKNOWN;
+    mfxIMPL implType         = MFX_IMPL_BASETYPE(par.Implementation);
+    mfxU16 deviceID          = 0;
+
+    // the library found for the implementation before is the only candidate
+    ResolvedLibKey resolvedKey(implType, par.Version.Version);
+    ResolvedLib resolved;
+    bool bResolved = !dllName && FindResolvedLib(resolvedKey, resolved);
+    if (bResolved) {
+        deviceID = resolved.deviceID;
     }
     else {
-        // query succeeded:
-        //   may be a valid platform from listLegalDevIDs[] or MFX_HW_UNKNOWN
-        //   if underlying device_id is unrecognized (i.e. new platform)
-        msdk_platform = devices[0].platform;
-        deviceID      = devices[0].device_id;
+        // query graphics device_id
+        // if it is found on list of legacy devices, load MSDK RT
+        // otherwise load oneVPL RT
+        mfx_res = get_devices(devices);
+        if (mfx_res != MFX_ERR_NOT_FOUND) {
+            // query succeeded:
+            //   may be a valid platform from listLegalDevIDs[] or MFX_HW_UNKNOWN
+            //   if underlying device_id is unrecognized (i.e. new platform)
+            msdk_platform = devices[0].platform;
+            deviceID      = devices[0].device_id;
+        }
     }
 
     if (pDeviceID)
         *pDeviceID = deviceID;
 
-    if (dllName) {
+    if (bResolved) {
+        libs.emplace_back(resolved.lib);
+    }
+    else if (dllName) {
         // attempt to load only this DLL, fail if unsuccessful
         // this may also be used later by MFXCloneSession()
         m_libToLoad = dllName;
         libs.emplace_back(m_libToLoad);
     }
     else {
-        mfxIMPL implType = MFX_IMPL_BASETYPE(par.Implementation);
         // add HW lib
         if (implType == MFX_IMPL_AUTO || implType == MFX_IMPL_AUTO_ANY ||
             (implType & MFX_IMPL_HARDWARE) || (implType & MFX_IMPL_HARDWARE_ANY)) {
@@ -243,26 +460,26 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
     mfx_res = MFX_ERR_UNSUPPORTED;
 
     for (auto &lib : libs) {
-        std::shared_ptr<void> hdl = make_dlopen(lib.c_str(), RTLD_LOCAL | RTLD_NOW);
-        if (hdl) {
+        std::shared_ptr<const LibFuncTable> funcs =
+            bResolved ? resolved.funcs : GetLibFuncTable(lib);
+        if (funcs) {
+            m_funcs   = std::move(funcs);
+            m_bTable2 = (par.Version.Major >= 2);
+
             do {
-                /* Loading functions table */
+                /* Checking functions table */
                 bool wrong_version = false;
                 for (int i = 0; i < eFunctionsNum; ++i) {
-                    assert(i == g_mfxFuncTable[i].id);
-                    m_table[i] = dlsym(hdl.get(), g_mfxFuncTable[i].name);
-                    if (!m_table[i] && ((g_mfxFuncTable[i].version <= par.Version))) {
+                    if (!m_funcs->table[i] && ((g_mfxFuncTable[i].version <= par.Version))) {
                         wrong_version = true;
                         break;
                     }
                 }
 
-                // if version >= 2.0, load these functions as well
-                if (par.Version.Major >= 2) {
+                // if version >= 2.0, check these functions as well
+                if (m_bTable2 && !wrong_version) {
                     for (int i = 0; i < eFunctionsNum2; ++i) {
-                        assert(i == g_mfxFuncTable2[i].id);
-                        m_table2[i] = dlsym(hdl.get(), g_mfxFuncTable2[i].name);
-                        if (!m_table2[i] && (g_mfxFuncTable2[i].version <= par.Version)) {
+                        if (!m_funcs->table2[i] && (g_mfxFuncTable2[i].version <= par.Version)) {
                             wrong_version = true;
                             break;
                         }
@@ -282,19 +499,19 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
 
                 if (par.Version.Major >= 2) {
                     // for API >= 2.0 call MFXInitialize instead of MFXInitEx
-                    mfx_res =
-                        ((decltype(MFXInitialize) *)m_table2[eMFXInitialize])(vplParam, &m_session);
+                    auto proc = (decltype(MFXInitialize) *)getFunction2(eMFXInitialize);
+                    mfx_res   = (*proc)(vplParam, &m_session);
                 }
                 else {
-                    if (m_table[eMFXInitEx]) {
+                    if (getFunction(eMFXInitEx)) {
                         // initialize with MFXInitEx if present (API >= 1.14)
-                        mfx_res = ((decltype(MFXInitEx) *)m_table[eMFXInitEx])(par, &m_session);
+                        mfx_res = ((decltype(MFXInitEx) *)getFunction(eMFXInitEx))(par, &m_session);
                     }
                     else {
                         // initialize with MFXInit for API < 1.14
-                        mfx_res = ((decltype(MFXInit) *)m_table[eMFXInit])(par.Implementation,
-                                                                           &(par.Version),
-                                                                           &m_session);
+                        mfx_res = ((decltype(MFXInit) *)getFunction(eMFXInit))(par.Implementation,
+                                                                              &(par.Version),
+                                                                              &m_session);
                     }
                 }
 
@@ -304,8 +521,8 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
 
                 // Below we just get some data and double check that we got what we have expected
                 // to get. Some of these checks are done inside mediasdk init function
-                mfx_res =
-                    ((decltype(MFXQueryVersion) *)m_table[eMFXQueryVersion])(m_session, &m_version);
+                auto procVersion = (decltype(MFXQueryVersion) *)getFunction(eMFXQueryVersion);
+                mfx_res          = (*procVersion)(m_session, &m_version);
                 if (MFX_ERR_NONE != mfx_res) {
                     break;
                 }
@@ -315,8 +532,8 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
                     break;
                 }
 
-                mfx_res = ((decltype(MFXQueryIMPL) *)m_table[eMFXQueryIMPL])(m_session,
-                                                                             &m_implementation);
+                mfx_res = ((decltype(MFXQueryIMPL) *)getFunction(eMFXQueryIMPL))(m_session,
+                                                                                &m_implementation);
                 if (MFX_ERR_NONE != mfx_res) {
                     mfx_res = MFX_ERR_UNSUPPORTED;
                     break;
@@ -324,7 +541,26 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
             } while (false);
 
             if (MFX_ERR_NONE == mfx_res) {
-                m_dlh = std::move(hdl);
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+                // all direct functions are API 1.0 so they passed the version check above
+                //   (clone sessions reuse the table already checked for the parent session)
+                m_directCalls[eDirectDecodeFrameAsync] =
+                    m_funcs->table[eMFXVideoDECODE_DecodeFrameAsync];
+                m_directCalls[eDirectEncodeFrameAsync] =
+                    m_funcs->table[eMFXVideoENCODE_EncodeFrameAsync];
+                m_directCalls[eDirectRunFrameVPPAsync] =
+                    m_funcs->table[eMFXVideoVPP_RunFrameVPPAsync];
+                m_directCalls[eDirectSyncOperation] = m_funcs->table[eMFXVideoCORE_SyncOperation];
+#endif
+                if (IsSessionStatsEnabled())
+                    m_stats.reset(new SessionStats{});
+
+                if (!dllName && !bResolved) {
+                    resolved = { lib, deviceID, m_funcs };
+                    SetResolvedLib(resolvedKey, &resolved);
+                }
+                // MFXCloneSession() loads the same library
+                m_libToLoad = lib;
                 break;
             }
             else {
@@ -333,17 +569,30 @@ mfxStatus LoaderCtx::Init(mfxInitParam &par,
         }
     }
 
+    // the library doesn't fit (e.g. newer API is requested) or can't initialize anymore,
+    //   so the search is repeated
+    if (bResolved && MFX_ERR_NONE != mfx_res) {
+        SetResolvedLib(resolvedKey, nullptr);
+        return Init(par, vplParam, pDeviceID, dllName, bCloneSession);
+    }
+
     return mfx_res;
 }
 
 mfxStatus LoaderCtx::Close() {
-    auto proc         = (decltype(MFXClose) *)m_table[eMFXClose];
+    auto proc         = (decltype(MFXClose) *)getFunction(eMFXClose);
     mfxStatus mfx_res = (proc) ? (*proc)(m_session) : MFX_ERR_NONE;
 
     m_implementation = {};
     m_version        = {};
     m_session        = nullptr;
-    std::fill(std::begin(m_table), std::end(m_table), nullptr);
+    m_bTable2        = false;
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+    std::fill(std::begin(m_directCalls), std::end(m_directCalls), nullptr);
+#endif
+
+    // drop reference to shared function table (library is closed with the last session)
+    m_funcs.reset();
     return mfx_res;
 }
 
@@ -483,6 +732,10 @@ mfxStatus MFXClose(mfxSession session) {
             // Can't unload library in this case.
             loader.release();
         }
+        else {
+            // return the cost of the session to the budget of its adapter
+            ReleaseSessionAdmission(session);
+        }
         return mfx_res;
     }
     catch (...) {
@@ -503,6 +756,13 @@ mfxStatus MFXMemory_GetSurfaceForVPP(mfxSession session, mfxFrameSurface1 **surf
         return MFX_ERR_INVALID_HANDLE;
     }
 
+    MFX::SessionStats *stats = loader->getStats();
+    if (stats) {
+        return MFX::CallWithStats(stats, MFX_DISPSTATS_GET_SURFACE_FOR_VPP, [&]() {
+            return (*proc)(loader->getSession(), surface);
+        });
+    }
+
     return (*proc)(loader->getSession(), surface);
 }
 
@@ -518,6 +778,13 @@ mfxStatus MFXMemory_GetSurfaceForVPPOut(mfxSession session, mfxFrameSurface1 **s
         return MFX_ERR_INVALID_HANDLE;
     }
 
+    MFX::SessionStats *stats = loader->getStats();
+    if (stats) {
+        return MFX::CallWithStats(stats, MFX_DISPSTATS_GET_SURFACE_FOR_VPP_OUT, [&]() {
+            return (*proc)(loader->getSession(), surface);
+        });
+    }
+
     return (*proc)(loader->getSession(), surface);
 }
 
@@ -533,6 +800,13 @@ mfxStatus MFXMemory_GetSurfaceForEncode(mfxSession session, mfxFrameSurface1 **s
         return MFX_ERR_INVALID_HANDLE;
     }
 
+    MFX::SessionStats *stats = loader->getStats();
+    if (stats) {
+        return MFX::CallWithStats(stats, MFX_DISPSTATS_GET_SURFACE_FOR_ENCODE, [&]() {
+            return (*proc)(loader->getSession(), surface);
+        });
+    }
+
     return (*proc)(loader->getSession(), surface);
 }
 
@@ -548,6 +822,13 @@ mfxStatus MFXMemory_GetSurfaceForDecode(mfxSession session, mfxFrameSurface1 **s
         return MFX_ERR_INVALID_HANDLE;
     }
 
+    MFX::SessionStats *stats = loader->getStats();
+    if (stats) {
+        return MFX::CallWithStats(stats, MFX_DISPSTATS_GET_SURFACE_FOR_DECODE, [&]() {
+            return (*proc)(loader->getSession(), surface);
+        });
+    }
+
     return (*proc)(loader->getSession(), surface);
 }
 
@@ -735,10 +1016,9 @@ mfxStatus MFXCloneSession(mfxSession session, mfxSession *clone) {
     else if (version.Major == 2) {
         MFX::LoaderCtx *loader = (MFX::LoaderCtx *)session;
 
-        // MFXCloneSession not included in function pointer search during init
+        // MFXCloneSession not included in version check during init
         // for bwd-compat, check for it here and fail gracefully if missing
-        void *libHandle = loader->getHandle();
-        auto proc       = (decltype(MFXCloneSession) *)(dlsym(libHandle, "MFXCloneSession"));
+        auto proc = (decltype(MFXCloneSession) *)loader->getCloneSession();
         if (!proc)
             return MFX_ERR_UNSUPPORTED;
 
@@ -778,25 +1058,94 @@ mfxStatus MFXCloneSession(mfxSession session, mfxSession *clone) {
     return MFX_ERR_NONE;
 }
 
-#undef FUNCTION
-#define FUNCTION(return_value, func_name, formal_param_list, actual_param_list)    \
-    return_value MFX_CDECL func_name formal_param_list {                           \
-        /* get the function's address and make a call */                           \
-        if (!session)                                                              \
-            return MFX_ERR_INVALID_HANDLE;                                         \
-                                                                                   \
-        MFX::LoaderCtx *loader = (MFX::LoaderCtx *)session;                        \
-                                                                                   \
-        auto proc = (decltype(func_name) *)loader->getFunction(MFX::e##func_name); \
-        if (!proc)                                                                 \
-            return MFX_ERR_INVALID_HANDLE;                                         \
-                                                                                   \
-        /* get the real session pointer */                                         \
-        session = loader->getSession();                                            \
-        /* pass down the call */                                                   \
-        return (*proc)actual_param_list;                                           \
+mfxStatus MFXDispGetSessionStats(mfxSession session, mfxDispatcherSessionStats *stats) {
+    if (!session)
+        return MFX_ERR_INVALID_HANDLE;
+
+    if (!stats)
+        return MFX_ERR_NULL_PTR;
+
+    MFX::LoaderCtx *loader      = (MFX::LoaderCtx *)session;
+    MFX::SessionStats *sesStats = loader->getStats();
+    if (!sesStats)
+        return MFX_ERR_UNSUPPORTED;
+
+    *stats                 = {};
+    stats->Version.Version = MFX_DISPATCHERSESSIONSTATS_VERSION;
+    stats->NumFunctions    = MFX_DISPSTATS_NUM_FUNCTIONS;
+
+    for (int i = 0; i < MFX_DISPSTATS_NUM_FUNCTIONS; i++) {
+        const MFX::CallStats &c = sesStats->calls[i];
+
+        stats->Calls[i].NumCalls      = c.numCalls.load(std::memory_order_relaxed);
+        stats->Calls[i].TotalTime     = c.totalTime.load(std::memory_order_relaxed);
+        stats->Calls[i].NumDeviceBusy = c.numDeviceBusy.load(std::memory_order_relaxed);
+        stats->Calls[i].NumMoreData   = c.numMoreData.load(std::memory_order_relaxed);
+        for (int j = 0; j < MFX_DISPSTATS_NUM_BUCKETS; j++)
+            stats->Calls[i].Histogram[j] = c.histogram[j].load(std::memory_order_relaxed);
     }
 
+    return MFX_ERR_NONE;
+}
+
+#undef FUNCTION
+#ifdef ONEVPL_DISPATCHER_DIRECT_CALLS
+    // per-frame functions call the entry point saved at init without table lookup or null check
+    // GetDirectFunction() is evaluated at compile time, so other functions are unchanged
+    #define FUNCTION(return_value, func_name, formal_param_list, actual_param_list)         \
+        return_value MFX_CDECL func_name formal_param_list {                                \
+            if (!session)                                                                   \
+                return MFX_ERR_INVALID_HANDLE;                                              \
+                                                                                            \
+            MFX::LoaderCtx *loader = (MFX::LoaderCtx *)session;                             \
+                                                                                            \
+            constexpr int directFunc = MFX::GetDirectFunction(MFX::e##func_name);           \
+            constexpr int statsFunc  = MFX::GetStatsFunction(MFX::e##func_name);            \
+            if (directFunc != MFX::eNoDirectFunction) {                                     \
+                auto proc = (decltype(func_name) *)loader->getDirectFunction(directFunc);   \
+                session   = loader->getSession();                                           \
+                if (statsFunc >= 0 && loader->getStats())                                   \
+                    return MFX::CallWithStats(loader->getStats(), statsFunc, [&]() {        \
+                        return (*proc)actual_param_list;                                    \
+                    });                                                                     \
+                return (*proc)actual_param_list;                                            \
+            }                                                                               \
+                                                                                            \
+            auto proc = (decltype(func_name) *)loader->getFunction(MFX::e##func_name);      \
+            if (!proc)                                                                      \
+                return MFX_ERR_INVALID_HANDLE;                                              \
+                                                                                            \
+            session = loader->getSession();                                                 \
+            return (*proc)actual_param_list;                                                \
+        }
+#else
+    #define FUNCTION(return_value, func_name, formal_param_list, actual_param_list)    \
+        return_value MFX_CDECL func_name formal_param_list {                           \
+            /* get the function's address and make a call */                           \
+            if (!session)                                                              \
+                return MFX_ERR_INVALID_HANDLE;                                         \
+                                                                                       \
+            MFX::LoaderCtx *loader = (MFX::LoaderCtx *)session;                        \
+                                                                                       \
+            auto proc = (decltype(func_name) *)loader->getFunction(MFX::e##func_name); \
+            if (!proc)                                                                 \
+                return MFX_ERR_INVALID_HANDLE;                                         \
+                                                                                       \
+            /* get the real session pointer */                                         \
+            session = loader->getSession();                                            \
+                                                                                       \
+            /* count per-frame calls if stats are enabled for this session */          \
+            constexpr int statsFunc = MFX::GetStatsFunction(MFX::e##func_name);        \
+            if (statsFunc >= 0 && loader->getStats())                                  \
+                return MFX::CallWithStats(loader->getStats(), statsFunc, [&]() {       \
+                    return (*proc)actual_param_list;                                   \
+                });                                                                    \
+                                                                                       \
+            /* pass down the call */                                                   \
+            return (*proc)actual_param_list;                                           \
+        }
+#endif
+
 #include "linux/mfxvideo_functions.h" // NOLINT(build/include)
 
 #ifdef __cplusplus
@@ -0,0 +1,324 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+// latency simulating runtime for pipeline load tests without a GPU
+// decode, VPP and encode do no real work - each task is given a completion time from the
+//   configured latency and the availability of the simulated engines, and synchronization
+//   sleeps until that time, so the application sees the timing behavior of a loaded device:
+//   - per-operation latency with jitter
+//   - a limited number of engines shared by all the sessions of the process
+//   - MFX_WRN_DEVICE_BUSY once AsyncDepth tasks of a component are in flight
+//   - internal surface pools with a limited size (MFX_WRN_ALLOC_TIMEOUT_EXPIRED)
+
+#ifndef DISPATCHER_TEST_RUNTIMES_SIM_SRC_SIM_H_
+#define DISPATCHER_TEST_RUNTIMES_SIM_SRC_SIM_H_
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "vpl/mfx.h"
+
+#define SIM_IMPL_NAME "Simulation Implementation"
+
+typedef struct mfxDecoderDescription::decoder DecCodec;
+typedef struct mfxDecoderDescription::decoder::decprofile DecProfile;
+typedef struct mfxDecoderDescription::decoder::decprofile::decmemdesc DecMemDesc;
+
+typedef struct mfxEncoderDescription::encoder EncCodec;
+typedef struct mfxEncoderDescription::encoder::encprofile EncProfile;
+typedef struct mfxEncoderDescription::encoder::encprofile::encmemdesc EncMemDesc;
+
+typedef struct mfxVPPDescription::filter VPPFilter;
+typedef struct mfxVPPDescription::filter::memdesc VPPMemDesc;
+typedef struct mfxVPPDescription::filter::memdesc::format VPPFormat;
+
+typedef std::chrono::steady_clock SimClock;
+typedef SimClock::time_point SimTime;
+
+enum SimEngine {
+    SIM_ENGINE_DECODE = 0,
+    SIM_ENGINE_VPP,
+    SIM_ENGINE_ENCODE,
+
+    SIM_ENGINE_COUNT
+};
+
+// latency of one operation in microseconds
+// jitter is the standard deviation for a normal distribution or the half width for a
+//   uniform one, samples are never negative
+struct SimLatency {
+    mfxU32 mean;
+    mfxU32 jitter;
+    bool bUniform;
+};
+
+// set once from the ONEVPL_SIMRT_* environment variables (see sim_device.cpp)
+struct SimConfig {
+    mfxImplType implType;
+    SimLatency latency[SIM_ENGINE_COUNT];
+    mfxU32 numEngines[SIM_ENGINE_COUNT]; // 0 = unlimited
+    mfxU32 asyncDepth; // tasks in flight per component if AsyncDepth is 0
+    mfxU32 poolSize; // surfaces per internal pool without allocation hints, 0 = unlimited
+    mfxU16 width; // stream resolution returned by DecodeHeader
+    mfxU16 height;
+    mfxU32 decFrameBytes; // bitstream bytes consumed by each decoded frame
+    mfxU32 encFrameBytes; // bitstream bytes written for each encoded frame, 0 = from bitrate
+    mfxU32 seed;
+};
+
+// process-wide state: the configuration, the capabilities and the simulated engines
+class SimDevice {
+public:
+    static SimDevice &Get();
+
+    const SimConfig &GetConfig() const {
+        return m_config;
+    }
+
+    mfxImplDescription *GetImplDescription() {
+        return &m_implDesc;
+    }
+
+    // reserves the engine which is free first for a task whose input is ready at readyAt
+    // returns the completion time of the task
+    SimTime Schedule(SimEngine engine, SimTime readyAt);
+
+private:
+    SimDevice();
+
+    void ReadConfig();
+    void InitImplDescription();
+    mfxU32 SampleLatency(const SimLatency &latency);
+
+    SimConfig m_config;
+
+    // one profile and memory type per codec or filter
+    mfxImplDescription m_implDesc;
+    mfxAccelerationMode m_accelMode;
+    std::vector<DecCodec> m_decCodecs;
+    std::vector<DecProfile> m_decProfiles;
+    std::vector<DecMemDesc> m_decMemDesc;
+    std::vector<EncCodec> m_encCodecs;
+    std::vector<EncProfile> m_encProfiles;
+    std::vector<EncMemDesc> m_encMemDesc;
+    std::vector<VPPFilter> m_vppFilters;
+    std::vector<VPPMemDesc> m_vppMemDesc;
+    std::vector<VPPFormat> m_vppFormats;
+
+    std::mutex m_mutex;
+    std::mt19937 m_rng;
+    std::vector<SimTime> m_engineFree[SIM_ENGINE_COUNT];
+
+    SimDevice(const SimDevice &);
+    SimDevice &operator=(const SimDevice &);
+};
+
+// internal pools of GetSurfaceForXXX
+enum SimPoolType {
+    SIM_POOL_DECODE = 0,
+    SIM_POOL_VPP_IN,
+    SIM_POOL_VPP_OUT,
+    SIM_POOL_ENCODE,
+};
+
+class SimSurfacePool;
+
+struct SimSurface {
+    mfxFrameSurface1 surface; // MUST be the first element
+    mfxFrameSurfaceInterface iface;
+
+    std::atomic<mfxU32> refCount;
+    std::atomic<SimClock::rep> readyAt; // time since epoch when the last task writing it is done
+    std::vector<mfxU8> data; // allocated on the first Map
+
+    SimSurfacePool *pool;
+};
+
+// surfaces allocated by the runtime and returned to the pool when the last reference is
+//   released, the pool owns the memory so it must outlive the references held by the app
+class SimSurfacePool {
+public:
+    SimSurfacePool(const mfxFrameInfo &info, mfxU32 limit, mfxU32 waitMsec);
+
+    // returns a surface with one reference, or nullptr if limit surfaces are in use
+    mfxFrameSurface1 *Acquire();
+
+    // used for the surfaces acquired from now on, after Reset
+    void SetFrameInfo(const mfxFrameInfo &info);
+
+    mfxU32 GetWaitMsec() const {
+        return m_waitMsec;
+    }
+
+    // nullptr if the surface was not allocated by a pool of this runtime
+    static SimSurface *FromSurface(mfxFrameSurface1 *surface);
+
+    static void SetReadyTime(mfxFrameSurface1 *surface, SimTime readyAt);
+    static SimTime GetReadyTime(mfxFrameSurface1 *surface);
+
+private:
+    mfxFrameInfo m_info;
+    mfxU32 m_limit;
+    mfxU32 m_waitMsec;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<SimSurface>> m_surfaces;
+
+    SimSurfacePool(const SimSurfacePool &);
+    SimSurfacePool &operator=(const SimSurfacePool &);
+};
+
+// state of one of decode, VPP, encode or the channels of decode+VPP
+struct SimComponent {
+    SimComponent()
+            : bInit(false),
+              par(),
+              depth(0),
+              frameBytes(0),
+              numFrames(0),
+              numBytes(0),
+              pools() {}
+
+    bool bInit;
+    mfxVideoParam par; // without the ext buffers
+    mfxU32 depth; // tasks in flight before MFX_WRN_DEVICE_BUSY
+    mfxU32 frameBytes; // bitstream bytes read (decode) or written (encode) per frame
+    mfxU32 numFrames;
+    mfxU64 numBytes;
+
+    // decode: output, VPP: input and output, encode: input
+    std::unique_ptr<SimSurfacePool> pools[2];
+};
+
+struct SimTask {
+    mfxU64 id; // also the sync point
+    SimComponent *component;
+    SimTime doneAt;
+
+    // references (or Data.Locked for surfaces of the app) released on completion
+    std::vector<mfxFrameSurface1 *> surfaces;
+};
+
+class SimSession {
+public:
+    SimSession();
+    ~SimSession();
+
+    static SimSession *FromHandle(mfxSession session);
+
+    // returns the parameters unchanged if the codec is supported
+    static mfxStatus Query(SimEngine engine, mfxVideoParam *in, mfxVideoParam *out);
+
+    mfxStatus SetHandle(mfxHandleType type, mfxHDL hdl);
+    mfxStatus GetHandle(mfxHandleType type, mfxHDL *hdl);
+    mfxStatus SyncOperation(mfxSyncPoint syncp, mfxU32 wait);
+
+    mfxStatus DecodeHeader(mfxBitstream *bs, mfxVideoParam *par);
+    mfxStatus DecodeQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request);
+    mfxStatus DecodeInit(mfxVideoParam *par);
+    mfxStatus DecodeReset(mfxVideoParam *par);
+    mfxStatus DecodeClose();
+    mfxStatus DecodeGetVideoParam(mfxVideoParam *par);
+    mfxStatus DecodeGetStat(mfxDecodeStat *stat);
+    mfxStatus DecodeFrameAsync(mfxBitstream *bs,
+                               mfxFrameSurface1 *surface_work,
+                               mfxFrameSurface1 **surface_out,
+                               mfxSyncPoint *syncp);
+
+    mfxStatus VPPQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest request[2]);
+    mfxStatus VPPInit(mfxVideoParam *par);
+    mfxStatus VPPReset(mfxVideoParam *par);
+    mfxStatus VPPClose();
+    mfxStatus VPPGetVideoParam(mfxVideoParam *par);
+    mfxStatus VPPGetStat(mfxVPPStat *stat);
+    mfxStatus RunFrameVPPAsync(mfxFrameSurface1 *in,
+                               mfxFrameSurface1 *out,
+                               mfxSyncPoint *syncp);
+    mfxStatus ProcessFrameAsync(mfxFrameSurface1 *in, mfxFrameSurface1 **out);
+
+    mfxStatus EncodeQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request);
+    mfxStatus EncodeInit(mfxVideoParam *par);
+    mfxStatus EncodeReset(mfxVideoParam *par);
+    mfxStatus EncodeClose();
+    mfxStatus EncodeGetVideoParam(mfxVideoParam *par);
+    mfxStatus EncodeGetStat(mfxEncodeStat *stat);
+    mfxStatus EncodeFrameAsync(mfxEncodeCtrl *ctrl,
+                               mfxFrameSurface1 *surface,
+                               mfxBitstream *bs,
+                               mfxSyncPoint *syncp);
+
+    mfxStatus DecodeVPPInit(mfxVideoParam *decode_par,
+                            mfxVideoChannelParam **vpp_par_array,
+                            mfxU32 num_vpp_par);
+    mfxStatus DecodeVPPReset(mfxVideoParam *decode_par,
+                             mfxVideoChannelParam **vpp_par_array,
+                             mfxU32 num_vpp_par);
+    mfxStatus DecodeVPPGetChannelParam(mfxVideoChannelParam *par, mfxU32 channel_id);
+    mfxStatus DecodeVPPClose();
+    mfxStatus DecodeVPPFrameAsync(mfxBitstream *bs,
+                                  mfxU32 *skip_channels,
+                                  mfxU32 num_skip_channels,
+                                  mfxSurfaceArray **surf_array_out);
+
+    mfxStatus GetSurface(SimPoolType poolType, mfxFrameSurface1 **surface);
+
+private:
+    struct Channel {
+        mfxVideoChannelParam par; // without the ext buffers
+        SimComponent vpp;
+    };
+
+    mfxStatus InitComponent(SimComponent &component,
+                            mfxVideoParam *par,
+                            const mfxFrameInfo *poolInfo0,
+                            const mfxFrameInfo *poolInfo1 = nullptr);
+    mfxStatus InitDecode(mfxVideoParam *par);
+    // drops the tasks of the component, the surfaces it allocated stay valid until MFXClose
+    void CloseComponent(SimComponent &component);
+    mfxStatus ResetComponent(SimComponent &component, mfxVideoParam *par);
+
+    // releases the surfaces of the tasks which are done
+    void Retire(SimTime now);
+    bool IsBusy(const SimComponent &component) const;
+    mfxSyncPoint AddTask(SimComponent *component,
+                         SimTime doneAt,
+                         mfxFrameSurface1 *surf0,
+                         mfxFrameSurface1 *surf1 = nullptr);
+
+    // waits up to the wait time of the pool for a free surface, unlocks the session meanwhile
+    mfxStatus AcquireSurface(std::unique_lock<std::mutex> &lock,
+                             SimSurfacePool *pool,
+                             mfxFrameSurface1 **surface);
+
+    mfxU32 m_magic;
+    std::mutex m_mutex;
+
+    SimComponent m_decode;
+    SimComponent m_vpp;
+    SimComponent m_encode;
+    // decode+VPP uses m_decode for decoding
+    bool m_bDecodeVPP;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+
+    mfxU64 m_nextTaskId;
+    std::deque<SimTask> m_tasks;
+
+    // pools of the components which were closed, kept for the surfaces the app still holds
+    std::vector<std::unique_ptr<SimSurfacePool>> m_closedPools;
+
+    std::map<mfxHandleType, mfxHDL> m_handles;
+
+    SimSession(const SimSession &);
+    SimSession &operator=(const SimSession &);
+};
+
+#endif // DISPATCHER_TEST_RUNTIMES_SIM_SRC_SIM_H_
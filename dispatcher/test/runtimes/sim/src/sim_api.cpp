@@ -0,0 +1,484 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "src/sim.h"
+
+#define NUM_SIM_IMPLS 1
+
+// leave table formatting alone
+// clang-format off
+
+// should match libvplsimrt.def
+static const mfxChar *simImplFuncsNames[] = {
+    "MFXInit",
+    "MFXClose",
+    "MFXQueryIMPL",
+    "MFXQueryVersion",
+    "MFXJoinSession",
+    "MFXDisjoinSession",
+    "MFXCloneSession",
+    "MFXSetPriority",
+    "MFXGetPriority",
+    "MFXVideoCORE_SetFrameAllocator",
+    "MFXVideoCORE_SetHandle",
+    "MFXVideoCORE_GetHandle",
+    "MFXVideoCORE_QueryPlatform",
+    "MFXVideoCORE_SyncOperation",
+    "MFXVideoENCODE_Query",
+    "MFXVideoENCODE_QueryIOSurf",
+    "MFXVideoENCODE_Init",
+    "MFXVideoENCODE_Reset",
+    "MFXVideoENCODE_Close",
+    "MFXVideoENCODE_GetVideoParam",
+    "MFXVideoENCODE_GetEncodeStat",
+    "MFXVideoENCODE_EncodeFrameAsync",
+    "MFXVideoDECODE_Query",
+    "MFXVideoDECODE_DecodeHeader",
+    "MFXVideoDECODE_QueryIOSurf",
+    "MFXVideoDECODE_Init",
+    "MFXVideoDECODE_Reset",
+    "MFXVideoDECODE_Close",
+    "MFXVideoDECODE_GetVideoParam",
+    "MFXVideoDECODE_GetDecodeStat",
+    "MFXVideoDECODE_SetSkipMode",
+    "MFXVideoDECODE_GetPayload",
+    "MFXVideoDECODE_DecodeFrameAsync",
+    "MFXVideoVPP_Query",
+    "MFXVideoVPP_QueryIOSurf",
+    "MFXVideoVPP_Init",
+    "MFXVideoVPP_Reset",
+    "MFXVideoVPP_Close",
+    "MFXVideoVPP_GetVideoParam",
+    "MFXVideoVPP_GetVPPStat",
+    "MFXVideoVPP_RunFrameVPPAsync",
+    "MFXInitEx",
+    "MFXQueryImplsDescription",
+    "MFXReleaseImplDescription",
+    "MFXMemory_GetSurfaceForVPP",
+    "MFXMemory_GetSurfaceForEncode",
+    "MFXMemory_GetSurfaceForDecode",
+    "MFXInitialize",
+    "MFXMemory_GetSurfaceForVPPOut",
+    "MFXVideoDECODE_VPP_Init",
+    "MFXVideoDECODE_VPP_DecodeFrameAsync",
+    "MFXVideoDECODE_VPP_Reset",
+    "MFXVideoDECODE_VPP_GetChannelParam",
+    "MFXVideoDECODE_VPP_Close",
+    "MFXVideoVPP_ProcessFrameAsync",
+};
+
+static const mfxImplementedFunctions simImplFuncs = {
+    sizeof(simImplFuncsNames) / sizeof(mfxChar *),
+    (mfxChar**)simImplFuncsNames
+};
+
+static const mfxImplementedFunctions *simImplFuncsArray[NUM_SIM_IMPLS] = {
+    &simImplFuncs,
+};
+
+// end table formatting
+// clang-format on
+
+static mfxStatus CreateSession(mfxSession *session) {
+    if (!session)
+        return MFX_ERR_NULL_PTR;
+
+    *session = (mfxSession) new SimSession();
+
+    return MFX_ERR_NONE;
+}
+
+// query and release are independent of session
+mfxHDL *MFXQueryImplsDescription(mfxImplCapsDeliveryFormat format, mfxU32 *num_impls) {
+    static mfxImplDescription *simImplDescArray[NUM_SIM_IMPLS] = {
+        SimDevice::Get().GetImplDescription(),
+    };
+
+    if (!num_impls)
+        return nullptr;
+    *num_impls = NUM_SIM_IMPLS;
+
+    if (format == MFX_IMPLCAPS_IMPLDESCSTRUCTURE)
+        return (mfxHDL *)simImplDescArray;
+    else if (format == MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS)
+        return (mfxHDL *)simImplFuncsArray;
+
+    return nullptr;
+}
+
+mfxStatus MFXReleaseImplDescription(mfxHDL hdl) {
+    if (!hdl)
+        return MFX_ERR_NULL_PTR;
+
+    // nothing to do - caps live as long as the library
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXInitialize(mfxInitializationParam par, mfxSession *session) {
+    return CreateSession(session);
+}
+
+mfxStatus MFXInitEx(mfxInitParam par, mfxSession *session) {
+    return CreateSession(session);
+}
+
+mfxStatus MFXInit(mfxIMPL implParam, mfxVersion *ver, mfxSession *session) {
+    return CreateSession(session);
+}
+
+mfxStatus MFXClose(mfxSession session) {
+    SimSession *sim = SimSession::FromHandle(session);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+
+    delete sim;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXQueryVersion(mfxSession session, mfxVersion *pVersion) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!pVersion)
+        return MFX_ERR_NULL_PTR;
+
+    pVersion->Major = MFX_VERSION_MAJOR;
+    pVersion->Minor = MFX_VERSION_MINOR;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXQueryIMPL(mfxSession session, mfxIMPL *impl) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!impl)
+        return MFX_ERR_NULL_PTR;
+
+    if (SimDevice::Get().GetConfig().implType == MFX_IMPL_TYPE_HARDWARE) {
+#if defined(_WIN32) || defined(_WIN64)
+        *impl = MFX_IMPL_HARDWARE | MFX_IMPL_VIA_D3D11;
+#else
+        *impl = MFX_IMPL_HARDWARE | MFX_IMPL_VIA_VAAPI;
+#endif
+    }
+    else {
+        *impl = MFX_IMPL_SOFTWARE;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+// sessions are independent, they only share the engines
+mfxStatus MFXJoinSession(mfxSession session, mfxSession child) {
+    if (!SimSession::FromHandle(session) || !SimSession::FromHandle(child))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXDisjoinSession(mfxSession session) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXCloneSession(mfxSession session, mfxSession *clone) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return CreateSession(clone);
+}
+
+mfxStatus MFXSetPriority(mfxSession session, mfxPriority priority) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXGetPriority(mfxSession session, mfxPriority *priority) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!priority)
+        return MFX_ERR_NULL_PTR;
+
+    *priority = MFX_PRIORITY_NORMAL;
+
+    return MFX_ERR_NONE;
+}
+
+// the surfaces of the app are never accessed, so the allocator is not used
+mfxStatus MFXVideoCORE_SetFrameAllocator(mfxSession session, mfxFrameAllocator *allocator) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoCORE_SetHandle(mfxSession session, mfxHandleType type, mfxHDL hdl) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->SetHandle(type, hdl) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoCORE_GetHandle(mfxSession session, mfxHandleType type, mfxHDL *hdl) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->GetHandle(type, hdl) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoCORE_QueryPlatform(mfxSession session, mfxPlatform *platform) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!platform)
+        return MFX_ERR_NULL_PTR;
+
+    *platform                  = {};
+    platform->CodeName         = MFX_PLATFORM_UNKNOWN;
+    platform->MediaAdapterType = SimDevice::Get().GetImplDescription()->Dev.MediaAdapterType;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoCORE_SyncOperation(mfxSession session, mfxSyncPoint syncp, mfxU32 wait) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->SyncOperation(syncp, wait) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_Query(mfxSession session, mfxVideoParam *in, mfxVideoParam *out) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return SimSession::Query(SIM_ENGINE_DECODE, in, out);
+}
+
+mfxStatus MFXVideoDECODE_DecodeHeader(mfxSession session, mfxBitstream *bs, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeHeader(bs, par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_QueryIOSurf(mfxSession session,
+                                     mfxVideoParam *par,
+                                     mfxFrameAllocRequest *request) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeQueryIOSurf(par, request) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_Init(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeInit(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_Reset(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeReset(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_Close(mfxSession session) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeClose() : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeGetVideoParam(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_GetDecodeStat(mfxSession session, mfxDecodeStat *stat) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeGetStat(stat) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_SetSkipMode(mfxSession session, mfxSkipMode mode) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_GetPayload(mfxSession session, mfxU64 *ts, mfxPayload *payload) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!ts || !payload)
+        return MFX_ERR_NULL_PTR;
+
+    // the streams have no SEI
+    payload->NumBit = 0;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus MFXVideoDECODE_DecodeFrameAsync(mfxSession session,
+                                          mfxBitstream *bs,
+                                          mfxFrameSurface1 *surface_work,
+                                          mfxFrameSurface1 **surface_out,
+                                          mfxSyncPoint *syncp) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeFrameAsync(bs, surface_work, surface_out, syncp)
+               : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_VPP_Init(mfxSession session,
+                                  mfxVideoParam *decode_par,
+                                  mfxVideoChannelParam **vpp_par_array,
+                                  mfxU32 num_vpp_par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeVPPInit(decode_par, vpp_par_array, num_vpp_par)
+               : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_VPP_DecodeFrameAsync(mfxSession session,
+                                              mfxBitstream *bs,
+                                              mfxU32 *skip_channels,
+                                              mfxU32 num_skip_channels,
+                                              mfxSurfaceArray **surf_array_out) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeVPPFrameAsync(bs, skip_channels, num_skip_channels, surf_array_out)
+               : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_VPP_Reset(mfxSession session,
+                                   mfxVideoParam *decode_par,
+                                   mfxVideoChannelParam **vpp_par_array,
+                                   mfxU32 num_vpp_par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeVPPReset(decode_par, vpp_par_array, num_vpp_par)
+               : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_VPP_GetChannelParam(mfxSession session,
+                                             mfxVideoChannelParam *par,
+                                             mfxU32 channel_id) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeVPPGetChannelParam(par, channel_id) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoDECODE_VPP_Close(mfxSession session) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->DecodeVPPClose() : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_Query(mfxSession session, mfxVideoParam *in, mfxVideoParam *out) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return SimSession::Query(SIM_ENGINE_ENCODE, in, out);
+}
+
+mfxStatus MFXVideoENCODE_QueryIOSurf(mfxSession session,
+                                     mfxVideoParam *par,
+                                     mfxFrameAllocRequest *request) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeQueryIOSurf(par, request) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_Init(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeInit(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_Close(mfxSession session) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeClose() : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_EncodeFrameAsync(mfxSession session,
+                                          mfxEncodeCtrl *ctrl,
+                                          mfxFrameSurface1 *surface,
+                                          mfxBitstream *bs,
+                                          mfxSyncPoint *syncp) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeFrameAsync(ctrl, surface, bs, syncp) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_Reset(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeReset(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeGetVideoParam(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoENCODE_GetEncodeStat(mfxSession session, mfxEncodeStat *stat) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->EncodeGetStat(stat) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_Query(mfxSession session, mfxVideoParam *in, mfxVideoParam *out) {
+    if (!SimSession::FromHandle(session))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return SimSession::Query(SIM_ENGINE_VPP, in, out);
+}
+
+mfxStatus MFXVideoVPP_QueryIOSurf(mfxSession session,
+                                  mfxVideoParam *par,
+                                  mfxFrameAllocRequest *request) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPQueryIOSurf(par, request) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_Init(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPInit(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_Close(mfxSession session) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPClose() : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_GetVideoParam(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPGetVideoParam(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_RunFrameVPPAsync(mfxSession session,
+                                       mfxFrameSurface1 *in,
+                                       mfxFrameSurface1 *out,
+                                       mfxExtVppAuxData *aux,
+                                       mfxSyncPoint *syncp) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->RunFrameVPPAsync(in, out, syncp) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_Reset(mfxSession session, mfxVideoParam *par) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPReset(par) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_GetVPPStat(mfxSession session, mfxVPPStat *stat) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->VPPGetStat(stat) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXVideoVPP_ProcessFrameAsync(mfxSession session,
+                                        mfxFrameSurface1 *in,
+                                        mfxFrameSurface1 **out) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->ProcessFrameAsync(in, out) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXMemory_GetSurfaceForVPP(mfxSession session, mfxFrameSurface1 **surface) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->GetSurface(SIM_POOL_VPP_IN, surface) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXMemory_GetSurfaceForVPPOut(mfxSession session, mfxFrameSurface1 **surface) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->GetSurface(SIM_POOL_VPP_OUT, surface) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXMemory_GetSurfaceForEncode(mfxSession session, mfxFrameSurface1 **surface) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->GetSurface(SIM_POOL_ENCODE, surface) : MFX_ERR_INVALID_HANDLE;
+}
+
+mfxStatus MFXMemory_GetSurfaceForDecode(mfxSession session, mfxFrameSurface1 **surface) {
+    SimSession *sim = SimSession::FromHandle(session);
+    return sim ? sim->GetSurface(SIM_POOL_DECODE, surface) : MFX_ERR_INVALID_HANDLE;
+}
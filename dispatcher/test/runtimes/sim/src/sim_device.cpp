@@ -0,0 +1,386 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "vpl/mfxjpeg.h"
+
+#include "src/sim.h"
+
+// environment variables, read once when the runtime is first used:
+//   ONEVPL_SIMRT_IMPL               "hw" reports a hardware implementation, default software
+//   ONEVPL_SIMRT_DECODE_LATENCY     "mean[,jitter[,normal|uniform]]" in usec
+//   ONEVPL_SIMRT_VPP_LATENCY        same for VPP
+//   ONEVPL_SIMRT_ENCODE_LATENCY     same for encode
+//   ONEVPL_SIMRT_ENGINES            "n" for all or "dec,vpp,enc", 0 = unlimited
+//   ONEVPL_SIMRT_ASYNC_DEPTH        tasks in flight per component if AsyncDepth is 0
+//   ONEVPL_SIMRT_POOL_SIZE          surfaces per internal pool without allocation hints
+//   ONEVPL_SIMRT_RESOLUTION         "WxH" reported by DecodeHeader
+//   ONEVPL_SIMRT_DEC_FRAME_BYTES    bitstream bytes consumed per decoded frame
+//   ONEVPL_SIMRT_ENC_FRAME_BYTES    bytes written per encoded frame, default from TargetKbps
+//   ONEVPL_SIMRT_SEED               seed of the jitter generator
+
+#define DEF_LATENCY_DECODE 2000
+#define DEF_LATENCY_VPP    1000
+#define DEF_LATENCY_ENCODE 4000
+
+#define DEF_NUM_ENGINES     1
+#define DEF_ASYNC_DEPTH     4
+#define DEF_WIDTH           1920
+#define DEF_HEIGHT          1080
+#define DEF_DEC_FRAME_BYTES 4096
+#define DEF_SEED            1
+
+#define DEF_RANGE_MIN  64
+#define DEF_RANGE_MAX  8192
+#define DEF_RANGE_STEP 16
+
+struct SimCodecCaps {
+    mfxU32 codecID;
+    mfxU32 profile;
+    bool bHighBitDepth; // P010 in addition to NV12
+};
+
+static const SimCodecCaps decCodecCaps[] = {
+    { MFX_CODEC_AVC, MFX_PROFILE_AVC_MAIN, false },
+    { MFX_CODEC_HEVC, MFX_PROFILE_HEVC_MAIN, true },
+    { MFX_CODEC_AV1, MFX_PROFILE_AV1_MAIN, true },
+    { MFX_CODEC_VP9, MFX_PROFILE_VP9_0, true },
+    { MFX_CODEC_MPEG2, MFX_PROFILE_MPEG2_MAIN, false },
+    { MFX_CODEC_JPEG, MFX_PROFILE_JPEG_BASELINE, false },
+};
+
+static const SimCodecCaps encCodecCaps[] = {
+    { MFX_CODEC_AVC, MFX_PROFILE_AVC_MAIN, false },
+    { MFX_CODEC_HEVC, MFX_PROFILE_HEVC_MAIN, true },
+    { MFX_CODEC_AV1, MFX_PROFILE_AV1_MAIN, true },
+    { MFX_CODEC_JPEG, MFX_PROFILE_JPEG_BASELINE, false },
+};
+
+static const mfxU32 vppFilterCaps[] = {
+    MFX_EXTBUFF_VPP_SCALING,
+    MFX_EXTBUFF_VPP_COLOR_CONVERSION,
+};
+
+static const mfxU32 colorFormats[] = {
+    MFX_FOURCC_NV12,
+    MFX_FOURCC_P010,
+};
+
+static const mfxU32 vppInFormats[] = {
+    MFX_FOURCC_NV12,
+    MFX_FOURCC_I420,
+    MFX_FOURCC_P010,
+    MFX_FOURCC_BGRA,
+};
+
+static const mfxU32 vppOutFormats[] = {
+    MFX_FOURCC_NV12,
+    MFX_FOURCC_P010,
+    MFX_FOURCC_BGRA,
+};
+
+#define NUM_ITEMS(arr) (sizeof(arr) / sizeof(arr[0]))
+
+static bool GetEnv(const char *name, std::string &value) {
+#if defined(_WIN32) || defined(_WIN64)
+    char *buf  = nullptr;
+    size_t len = 0;
+    if (_dupenv_s(&buf, &len, name) || !buf)
+        return false;
+    value = buf;
+    free(buf);
+#else
+    const char *buf = getenv(name);
+    if (!buf)
+        return false;
+    value = buf;
+#endif
+    return !value.empty();
+}
+
+static void GetEnvU32(const char *name, mfxU32 &value) {
+    std::string str;
+    if (GetEnv(name, str))
+        value = (mfxU32)strtoul(str.c_str(), nullptr, 10);
+}
+
+// "mean[,jitter[,normal|uniform]]"
+static void GetEnvLatency(const char *name, SimLatency &latency) {
+    std::string str;
+    if (!GetEnv(name, str))
+        return;
+
+    char *end      = nullptr;
+    latency.mean   = (mfxU32)strtoul(str.c_str(), &end, 10);
+    latency.jitter = 0;
+    if (*end == ',')
+        latency.jitter = (mfxU32)strtoul(end + 1, &end, 10);
+    if (*end == ',')
+        latency.bUniform = !strcmp(end + 1, "uniform");
+}
+
+// "count" for all the engine types or "decode,vpp,encode"
+static void GetEnvEngines(const char *name, mfxU32 numEngines[SIM_ENGINE_COUNT]) {
+    std::string str;
+    if (!GetEnv(name, str))
+        return;
+
+    const char *pos = str.c_str();
+    for (mfxU32 i = 0; i < SIM_ENGINE_COUNT; i++) {
+        char *end     = nullptr;
+        numEngines[i] = (mfxU32)strtoul(pos, &end, 10);
+        if (*end != ',') {
+            // single value
+            if (i == 0)
+                std::fill(numEngines + 1, numEngines + SIM_ENGINE_COUNT, numEngines[0]);
+            break;
+        }
+        pos = end + 1;
+    }
+}
+
+SimDevice &SimDevice::Get() {
+    // created on the first caps query and shared by all the sessions of the process
+    static SimDevice device;
+    return device;
+}
+
+SimDevice::SimDevice()
+        : m_config(),
+          m_implDesc(),
+          m_accelMode(MFX_ACCEL_MODE_NA),
+          m_decCodecs(),
+          m_decProfiles(),
+          m_decMemDesc(),
+          m_encCodecs(),
+          m_encProfiles(),
+          m_encMemDesc(),
+          m_vppFilters(),
+          m_vppMemDesc(),
+          m_vppFormats(),
+          m_mutex(),
+          m_rng(),
+          m_engineFree() {
+    ReadConfig();
+    InitImplDescription();
+
+    m_rng.seed(m_config.seed);
+    for (mfxU32 i = 0; i < SIM_ENGINE_COUNT; i++)
+        m_engineFree[i].resize(m_config.numEngines[i]);
+}
+
+void SimDevice::ReadConfig() {
+    // default jitter is 10% of the mean
+    m_config.implType                      = MFX_IMPL_TYPE_SOFTWARE;
+    m_config.latency[SIM_ENGINE_DECODE]    = { DEF_LATENCY_DECODE, DEF_LATENCY_DECODE / 10, false };
+    m_config.latency[SIM_ENGINE_VPP]       = { DEF_LATENCY_VPP, DEF_LATENCY_VPP / 10, false };
+    m_config.latency[SIM_ENGINE_ENCODE]    = { DEF_LATENCY_ENCODE, DEF_LATENCY_ENCODE / 10, false };
+    m_config.numEngines[SIM_ENGINE_DECODE] = DEF_NUM_ENGINES;
+    m_config.numEngines[SIM_ENGINE_VPP]    = DEF_NUM_ENGINES;
+    m_config.numEngines[SIM_ENGINE_ENCODE] = DEF_NUM_ENGINES;
+    m_config.asyncDepth                    = DEF_ASYNC_DEPTH;
+    m_config.poolSize                      = 0;
+    m_config.width                         = DEF_WIDTH;
+    m_config.height                        = DEF_HEIGHT;
+    m_config.decFrameBytes                 = DEF_DEC_FRAME_BYTES;
+    m_config.encFrameBytes                 = 0;
+    m_config.seed                          = DEF_SEED;
+
+    std::string str;
+    if (GetEnv("ONEVPL_SIMRT_IMPL", str) && (str == "hw" || str == "HW"))
+        m_config.implType = MFX_IMPL_TYPE_HARDWARE;
+
+    GetEnvLatency("ONEVPL_SIMRT_DECODE_LATENCY", m_config.latency[SIM_ENGINE_DECODE]);
+    GetEnvLatency("ONEVPL_SIMRT_VPP_LATENCY", m_config.latency[SIM_ENGINE_VPP]);
+    GetEnvLatency("ONEVPL_SIMRT_ENCODE_LATENCY", m_config.latency[SIM_ENGINE_ENCODE]);
+    GetEnvEngines("ONEVPL_SIMRT_ENGINES", m_config.numEngines);
+
+    GetEnvU32("ONEVPL_SIMRT_ASYNC_DEPTH", m_config.asyncDepth);
+    if (!m_config.asyncDepth)
+        m_config.asyncDepth = 1;
+    GetEnvU32("ONEVPL_SIMRT_POOL_SIZE", m_config.poolSize);
+
+    // "WxH"
+    if (GetEnv("ONEVPL_SIMRT_RESOLUTION", str)) {
+        char *end     = nullptr;
+        mfxU32 width  = (mfxU32)strtoul(str.c_str(), &end, 10);
+        mfxU32 height = (*end == 'x') ? (mfxU32)strtoul(end + 1, nullptr, 10) : 0;
+        if (width && width <= 0xFFFF && height && height <= 0xFFFF) {
+            m_config.width  = (mfxU16)width;
+            m_config.height = (mfxU16)height;
+        }
+    }
+
+    GetEnvU32("ONEVPL_SIMRT_DEC_FRAME_BYTES", m_config.decFrameBytes);
+    if (!m_config.decFrameBytes)
+        m_config.decFrameBytes = 1;
+    GetEnvU32("ONEVPL_SIMRT_ENC_FRAME_BYTES", m_config.encFrameBytes);
+    GetEnvU32("ONEVPL_SIMRT_SEED", m_config.seed);
+}
+
+void SimDevice::InitImplDescription() {
+    bool bHW = (m_config.implType == MFX_IMPL_TYPE_HARDWARE);
+    if (bHW) {
+#if defined(_WIN32) || defined(_WIN64)
+        m_accelMode = MFX_ACCEL_MODE_VIA_D3D11;
+#else
+        m_accelMode = MFX_ACCEL_MODE_VIA_VAAPI;
+#endif
+    }
+
+    // the surfaces are always in system memory
+    DecMemDesc decMemDesc    = {};
+    decMemDesc.MemHandleType = MFX_RESOURCE_SYSTEM_SURFACE;
+    decMemDesc.Width         = { DEF_RANGE_MIN, DEF_RANGE_MAX, DEF_RANGE_STEP };
+    decMemDesc.Height        = { DEF_RANGE_MIN, DEF_RANGE_MAX, DEF_RANGE_STEP };
+    decMemDesc.ColorFormats  = (mfxU32 *)colorFormats;
+    EncMemDesc encMemDesc    = {};
+    encMemDesc.MemHandleType = MFX_RESOURCE_SYSTEM_SURFACE;
+    encMemDesc.Width         = decMemDesc.Width;
+    encMemDesc.Height        = decMemDesc.Height;
+    encMemDesc.ColorFormats  = (mfxU32 *)colorFormats;
+    VPPMemDesc vppMemDesc    = {};
+    vppMemDesc.MemHandleType = MFX_RESOURCE_SYSTEM_SURFACE;
+    vppMemDesc.Width         = decMemDesc.Width;
+    vppMemDesc.Height        = decMemDesc.Height;
+    vppMemDesc.NumInFormats  = (mfxU16)NUM_ITEMS(vppInFormats);
+
+    // fill the vectors first, the pointers are set once they are not resized anymore
+    for (const SimCodecCaps &caps : decCodecCaps) {
+        decMemDesc.NumColorFormats = caps.bHighBitDepth ? 2 : 1;
+        m_decMemDesc.push_back(decMemDesc);
+
+        DecProfile profile  = {};
+        profile.Profile     = caps.profile;
+        profile.NumMemTypes = 1;
+        m_decProfiles.push_back(profile);
+
+        DecCodec codec    = {};
+        codec.CodecID     = caps.codecID;
+        codec.NumProfiles = 1;
+        m_decCodecs.push_back(codec);
+    }
+
+    for (const SimCodecCaps &caps : encCodecCaps) {
+        encMemDesc.NumColorFormats = caps.bHighBitDepth ? 2 : 1;
+        m_encMemDesc.push_back(encMemDesc);
+
+        EncProfile profile  = {};
+        profile.Profile     = caps.profile;
+        profile.NumMemTypes = 1;
+        m_encProfiles.push_back(profile);
+
+        EncCodec codec    = {};
+        codec.CodecID     = caps.codecID;
+        codec.NumProfiles = 1;
+        m_encCodecs.push_back(codec);
+    }
+
+    for (mfxU32 inFormat : vppInFormats) {
+        VPPFormat format    = {};
+        format.InFormat     = inFormat;
+        format.NumOutFormat = (mfxU16)NUM_ITEMS(vppOutFormats);
+        format.OutFormats   = (mfxU32 *)vppOutFormats;
+        m_vppFormats.push_back(format);
+    }
+
+    for (mfxU32 filterFourCC : vppFilterCaps) {
+        m_vppMemDesc.push_back(vppMemDesc);
+
+        VPPFilter filter    = {};
+        filter.FilterFourCC = filterFourCC;
+        filter.NumMemTypes  = 1;
+        m_vppFilters.push_back(filter);
+    }
+
+    for (size_t i = 0; i < m_decCodecs.size(); i++) {
+        m_decProfiles[i].MemDesc = &m_decMemDesc[i];
+        m_decCodecs[i].Profiles  = &m_decProfiles[i];
+    }
+    for (size_t i = 0; i < m_encCodecs.size(); i++) {
+        m_encProfiles[i].MemDesc = &m_encMemDesc[i];
+        m_encCodecs[i].Profiles  = &m_encProfiles[i];
+    }
+    for (size_t i = 0; i < m_vppFilters.size(); i++) {
+        m_vppMemDesc[i].Formats = m_vppFormats.data();
+        m_vppFilters[i].MemDesc = &m_vppMemDesc[i];
+    }
+
+    m_implDesc.Version.Version  = MFX_IMPLDESCRIPTION_VERSION;
+    m_implDesc.Impl             = m_config.implType;
+    m_implDesc.AccelerationMode = m_accelMode;
+    m_implDesc.ApiVersion.Major = MFX_VERSION_MAJOR;
+    m_implDesc.ApiVersion.Minor = MFX_VERSION_MINOR;
+    m_implDesc.VendorID         = 0x8086;
+    m_implDesc.VendorImplID     = 0xFFFE;
+    snprintf(m_implDesc.ImplName, sizeof(m_implDesc.ImplName), "%s", SIM_IMPL_NAME);
+    snprintf(m_implDesc.License, sizeof(m_implDesc.License), "MIT");
+    snprintf(m_implDesc.Keywords, sizeof(m_implDesc.Keywords), "VPL,Simulation");
+
+    m_implDesc.Dev.Version.Version  = MFX_DEVICEDESCRIPTION_VERSION;
+    m_implDesc.Dev.MediaAdapterType = bHW ? MFX_MEDIA_INTEGRATED : MFX_MEDIA_UNKNOWN;
+    snprintf(m_implDesc.Dev.DeviceID, sizeof(m_implDesc.Dev.DeviceID), "0000");
+
+    m_implDesc.Dec.Version.Version = MFX_DECODERDESCRIPTION_VERSION;
+    m_implDesc.Dec.NumCodecs       = (mfxU16)m_decCodecs.size();
+    m_implDesc.Dec.Codecs          = m_decCodecs.data();
+
+    m_implDesc.Enc.Version.Version = MFX_ENCODERDESCRIPTION_VERSION;
+    m_implDesc.Enc.NumCodecs       = (mfxU16)m_encCodecs.size();
+    m_implDesc.Enc.Codecs          = m_encCodecs.data();
+
+    m_implDesc.VPP.Version.Version = MFX_VPPDESCRIPTION_VERSION;
+    m_implDesc.VPP.NumFilters      = (mfxU16)m_vppFilters.size();
+    m_implDesc.VPP.Filters         = m_vppFilters.data();
+
+    m_implDesc.AccelerationModeDescription.Version.Version =
+        MFX_ACCELERATIONMODESCRIPTION_VERSION;
+    m_implDesc.AccelerationModeDescription.NumAccelerationModes = 1;
+    m_implDesc.AccelerationModeDescription.Mode                 = &m_accelMode;
+}
+
+mfxU32 SimDevice::SampleLatency(const SimLatency &latency) {
+    if (!latency.jitter)
+        return latency.mean;
+
+    double sample = 0;
+    if (latency.bUniform) {
+        std::uniform_real_distribution<double> dist((double)latency.mean - latency.jitter,
+                                                    (double)latency.mean + latency.jitter);
+        sample = dist(m_rng);
+    }
+    else {
+        std::normal_distribution<double> dist((double)latency.mean, (double)latency.jitter);
+        sample = dist(m_rng);
+    }
+
+    return (sample > 0) ? (mfxU32)sample : 0;
+}
+
+SimTime SimDevice::Schedule(SimEngine engine, SimTime readyAt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SimTime start = std::max(SimClock::now(), readyAt);
+
+    // tasks are not reordered, so an engine runs its tasks in submission order
+    std::vector<SimTime> &engineFree = m_engineFree[engine];
+    std::vector<SimTime>::iterator it =
+        std::min_element(engineFree.begin(), engineFree.end());
+    if (it != engineFree.end())
+        start = std::max(start, *it);
+
+    SimTime done = start + std::chrono::microseconds(SampleLatency(m_config.latency[engine]));
+    if (it != engineFree.end())
+        *it = done;
+
+    return done;
+}
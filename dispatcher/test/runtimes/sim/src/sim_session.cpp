@@ -0,0 +1,1074 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "src/sim.h"
+
+#define SIM_SESSION_MAGIC 0x5349524D
+
+// bitstream bytes per encoded frame if there is no bitrate (CQP, JPEG)
+#define DEF_ENC_FRAME_BYTES 4096
+
+#define ALIGN16(val) ((mfxU16)(((val) + 15) & ~15))
+
+// surfaces returned by decode+VPP, the array holds one reference to each of them
+struct SimSurfaceArray {
+    mfxSurfaceArray array; // MUST be the first element
+    std::atomic<mfxU32> refCount;
+    std::vector<mfxFrameSurface1 *> surfaces;
+};
+
+static mfxStatus MFX_CDECL SimArrayAddRef(mfxSurfaceArray *surface_array) {
+    if (!surface_array)
+        return MFX_ERR_NULL_PTR;
+    if (!surface_array->Context)
+        return MFX_ERR_INVALID_HANDLE;
+
+    ((SimSurfaceArray *)surface_array->Context)->refCount++;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimArrayRelease(mfxSurfaceArray *surface_array) {
+    if (!surface_array)
+        return MFX_ERR_NULL_PTR;
+    if (!surface_array->Context)
+        return MFX_ERR_INVALID_HANDLE;
+
+    SimSurfaceArray *sim = (SimSurfaceArray *)surface_array->Context;
+    if (--sim->refCount)
+        return MFX_ERR_NONE;
+
+    for (mfxFrameSurface1 *surface : sim->surfaces)
+        surface->FrameInterface->Release(surface);
+    delete sim;
+
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimArrayGetRefCounter(mfxSurfaceArray *surface_array,
+                                                 mfxU32 *counter) {
+    if (!surface_array || !counter)
+        return MFX_ERR_NULL_PTR;
+    if (!surface_array->Context)
+        return MFX_ERR_INVALID_HANDLE;
+
+    *counter = ((SimSurfaceArray *)surface_array->Context)->refCount.load();
+    return MFX_ERR_NONE;
+}
+
+// copies the parameters without the ext buffers, dst keeps its own
+static void CopyVideoParam(mfxVideoParam &dst, const mfxVideoParam &src) {
+    mfxExtBuffer **extParam = dst.ExtParam;
+    mfxU16 numExtParam      = dst.NumExtParam;
+
+    dst             = src;
+    dst.ExtParam    = extParam;
+    dst.NumExtParam = numExtParam;
+}
+
+static mfxExtBuffer *FindExtBuffer(mfxExtBuffer **extParam, mfxU16 numExtParam, mfxU32 id) {
+    if (!extParam)
+        return nullptr;
+
+    for (mfxU16 i = 0; i < numExtParam; i++) {
+        if (extParam[i] && extParam[i]->BufferId == id)
+            return extParam[i];
+    }
+
+    return nullptr;
+}
+
+static bool IsDecoderSupported(mfxU32 codecID) {
+    const mfxDecoderDescription &dec = SimDevice::Get().GetImplDescription()->Dec;
+    for (mfxU16 i = 0; i < dec.NumCodecs; i++) {
+        if (dec.Codecs[i].CodecID == codecID)
+            return true;
+    }
+    return false;
+}
+
+static bool IsEncoderSupported(mfxU32 codecID) {
+    const mfxEncoderDescription &enc = SimDevice::Get().GetImplDescription()->Enc;
+    for (mfxU16 i = 0; i < enc.NumCodecs; i++) {
+        if (enc.Codecs[i].CodecID == codecID)
+            return true;
+    }
+    return false;
+}
+
+static mfxU32 GetAsyncDepth(const mfxVideoParam &par) {
+    return par.AsyncDepth ? par.AsyncDepth : SimDevice::Get().GetConfig().asyncDepth;
+}
+
+// surfaces of the runtime are referenced, the ones of the app are locked
+static void HoldSurface(mfxFrameSurface1 *surface) {
+    if (SimSurfacePool::FromSurface(surface))
+        surface->FrameInterface->AddRef(surface);
+    else
+        surface->Data.Locked++;
+}
+
+static void ReleaseSurface(mfxFrameSurface1 *surface) {
+    if (SimSurfacePool::FromSurface(surface))
+        surface->FrameInterface->Release(surface);
+    else if (surface->Data.Locked)
+        surface->Data.Locked--;
+}
+
+// the input of a task is ready once the task writing it is done
+static SimTime GetReadyTime(mfxFrameSurface1 *surface) {
+    return std::max(SimSurfacePool::GetReadyTime(surface), SimClock::now());
+}
+
+SimSession::SimSession()
+        : m_magic(SIM_SESSION_MAGIC),
+          m_mutex(),
+          m_decode(),
+          m_vpp(),
+          m_encode(),
+          m_bDecodeVPP(false),
+          m_channels(),
+          m_nextTaskId(1),
+          m_tasks(),
+          m_closedPools(),
+          m_handles() {}
+
+SimSession::~SimSession() {
+    // the surfaces of the pools are freed with the session
+    m_magic = 0;
+}
+
+SimSession *SimSession::FromHandle(mfxSession session) {
+    SimSession *sim = (SimSession *)session;
+    if (!sim || sim->m_magic != SIM_SESSION_MAGIC)
+        return nullptr;
+    return sim;
+}
+
+mfxStatus SimSession::Query(SimEngine engine, mfxVideoParam *in, mfxVideoParam *out) {
+    if (!out)
+        return MFX_ERR_NULL_PTR;
+    if (!in)
+        return MFX_ERR_NONE;
+
+    if (engine == SIM_ENGINE_DECODE && !IsDecoderSupported(in->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+    if (engine == SIM_ENGINE_ENCODE && !IsEncoderSupported(in->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+
+    CopyVideoParam(*out, *in);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::SetHandle(mfxHandleType type, mfxHDL hdl) {
+    if (!hdl)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handles[type] = hdl;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::GetHandle(mfxHandleType type, mfxHDL *hdl) {
+    if (!hdl)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::map<mfxHandleType, mfxHDL>::iterator it = m_handles.find(type);
+    if (it == m_handles.end())
+        return MFX_ERR_NOT_FOUND;
+
+    *hdl = it->second;
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::SyncOperation(mfxSyncPoint syncp, mfxU32 wait) {
+    if (!syncp)
+        return MFX_ERR_NULL_PTR;
+
+    mfxU64 id = (mfxU64)(uintptr_t)syncp;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    SimTime now = SimClock::now();
+    Retire(now);
+
+    std::deque<SimTask>::iterator it =
+        std::find_if(m_tasks.begin(), m_tasks.end(), [id](const SimTask &task) {
+            return task.id == id;
+        });
+    if (it == m_tasks.end()) {
+        // already done and retired
+        return (id < m_nextTaskId) ? MFX_ERR_NONE : MFX_ERR_UNDEFINED_BEHAVIOR;
+    }
+
+    SimTime doneAt  = it->doneAt;
+    SimTime timeout = now + std::chrono::milliseconds(wait);
+    lock.unlock();
+
+    if (doneAt > timeout) {
+        std::this_thread::sleep_until(timeout);
+        return MFX_WRN_IN_EXECUTION;
+    }
+    std::this_thread::sleep_until(doneAt);
+
+    lock.lock();
+    Retire(SimClock::now());
+
+    return MFX_ERR_NONE;
+}
+
+void SimSession::Retire(SimTime now) {
+    std::deque<SimTask>::iterator it = m_tasks.begin();
+    while (it != m_tasks.end()) {
+        if (it->doneAt > now) {
+            it++;
+            continue;
+        }
+
+        for (mfxFrameSurface1 *surface : it->surfaces)
+            ReleaseSurface(surface);
+        it = m_tasks.erase(it);
+    }
+}
+
+bool SimSession::IsBusy(const SimComponent &component) const {
+    size_t numTasks = std::count_if(m_tasks.begin(), m_tasks.end(), [&](const SimTask &task) {
+        return task.component == &component;
+    });
+
+    return numTasks >= component.depth;
+}
+
+mfxSyncPoint SimSession::AddTask(SimComponent *component,
+                                 SimTime doneAt,
+                                 mfxFrameSurface1 *surf0,
+                                 mfxFrameSurface1 *surf1) {
+    SimTask task   = {};
+    task.id        = m_nextTaskId++;
+    task.component = component;
+    task.doneAt    = doneAt;
+
+    for (mfxFrameSurface1 *surface : { surf0, surf1 }) {
+        if (surface) {
+            HoldSurface(surface);
+            task.surfaces.push_back(surface);
+        }
+    }
+    m_tasks.push_back(task);
+
+    component->numFrames++;
+
+    return (mfxSyncPoint)(uintptr_t)task.id;
+}
+
+mfxStatus SimSession::AcquireSurface(std::unique_lock<std::mutex> &lock,
+                                     SimSurfacePool *pool,
+                                     mfxFrameSurface1 **surface) {
+    SimTime deadline = SimClock::now() + std::chrono::milliseconds(pool->GetWaitMsec());
+
+    while (1) {
+        SimTime now = SimClock::now();
+        Retire(now);
+
+        *surface = pool->Acquire();
+        if (*surface)
+            return MFX_ERR_NONE;
+        if (now >= deadline)
+            return MFX_WRN_ALLOC_TIMEOUT_EXPIRED;
+
+        // surfaces are returned when a task is done, or at any time by the app
+        SimTime wakeAt = std::min(deadline, now + std::chrono::milliseconds(1));
+        for (const SimTask &task : m_tasks)
+            wakeAt = std::min(wakeAt, task.doneAt);
+
+        lock.unlock();
+        std::this_thread::sleep_until(wakeAt);
+        lock.lock();
+    }
+}
+
+mfxStatus SimSession::InitComponent(SimComponent &component,
+                                    mfxVideoParam *par,
+                                    const mfxFrameInfo *poolInfo0,
+                                    const mfxFrameInfo *poolInfo1) {
+    if (component.bInit)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    const SimConfig &config = SimDevice::Get().GetConfig();
+
+    component.par = {};
+    CopyVideoParam(component.par, *par);
+    component.depth          = GetAsyncDepth(*par);
+    component.par.AsyncDepth = (mfxU16)component.depth;
+    component.numFrames      = 0;
+    component.numBytes       = 0;
+
+    // allocation hints select the VPP pool if there are two
+    mfxExtAllocationHints *hints = (mfxExtAllocationHints *)
+        FindExtBuffer(par->ExtParam, par->NumExtParam, MFX_EXTBUFF_ALLOCATION_HINTS);
+
+    const mfxFrameInfo *poolInfo[2] = { poolInfo0, poolInfo1 };
+    for (mfxU32 i = 0; i < 2; i++) {
+        if (!poolInfo[i])
+            continue;
+
+        mfxU32 limit = config.poolSize;
+        mfxU32 wait  = 0;
+        if (hints && (!poolInfo0 || !poolInfo1 || hints->VPPPoolType == (mfxVPPPoolType)i)) {
+            if (hints->AllocationPolicy == MFX_ALLOCATION_LIMITED)
+                limit = hints->NumberToPreAllocate + hints->DeltaToAllocateOnTheFly;
+            else if (hints->AllocationPolicy == MFX_ALLOCATION_UNLIMITED)
+                limit = 0;
+            wait = hints->Wait;
+        }
+
+        component.pools[i].reset(new SimSurfacePool(*poolInfo[i], limit, wait));
+    }
+
+    component.bInit = true;
+
+    return MFX_ERR_NONE;
+}
+
+void SimSession::CloseComponent(SimComponent &component) {
+    std::deque<SimTask>::iterator it = m_tasks.begin();
+    while (it != m_tasks.end()) {
+        if (it->component != &component) {
+            it++;
+            continue;
+        }
+
+        for (mfxFrameSurface1 *surface : it->surfaces)
+            ReleaseSurface(surface);
+        it = m_tasks.erase(it);
+    }
+
+    for (std::unique_ptr<SimSurfacePool> &pool : component.pools) {
+        if (pool)
+            m_closedPools.push_back(std::move(pool));
+    }
+
+    component.bInit = false;
+}
+
+mfxStatus SimSession::ResetComponent(SimComponent &component, mfxVideoParam *par) {
+    if (!component.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CopyVideoParam(component.par, *par);
+    component.par.AsyncDepth = (mfxU16)component.depth;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeHeader(mfxBitstream *bs, mfxVideoParam *par) {
+    if (!bs || !par)
+        return MFX_ERR_NULL_PTR;
+    if (!bs->DataLength)
+        return MFX_ERR_MORE_DATA;
+    if (!IsDecoderSupported(par->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+
+    // the stream is not parsed, it always has the configured resolution
+    const SimConfig &config = SimDevice::Get().GetConfig();
+    mfxFrameInfo &info      = par->mfx.FrameInfo;
+
+    info.FourCC         = MFX_FOURCC_NV12;
+    info.ChromaFormat   = MFX_CHROMAFORMAT_YUV420;
+    info.BitDepthLuma   = 8;
+    info.BitDepthChroma = 8;
+    info.Shift          = 0;
+    info.Width          = ALIGN16(config.width);
+    info.Height         = ALIGN16(config.height);
+    info.CropX          = 0;
+    info.CropY          = 0;
+    info.CropW          = config.width;
+    info.CropH          = config.height;
+    info.FrameRateExtN  = 30;
+    info.FrameRateExtD  = 1;
+    info.AspectRatioW   = 1;
+    info.AspectRatioH   = 1;
+    info.PicStruct      = MFX_PICSTRUCT_PROGRESSIVE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request) {
+    if (!par || !request)
+        return MFX_ERR_NULL_PTR;
+    if (!IsDecoderSupported(par->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+
+    // the frames in flight and a few references
+    mfxU32 depth = GetAsyncDepth(*par);
+
+    *request                   = {};
+    request->Info              = par->mfx.FrameInfo;
+    request->NumFrameMin       = (mfxU16)(depth + 1);
+    request->NumFrameSuggested = (mfxU16)(depth + 4);
+    request->Type =
+        MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_EXTERNAL_FRAME | MFX_MEMTYPE_FROM_DECODE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::InitDecode(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!IsDecoderSupported(par->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+    if (!par->mfx.FrameInfo.Width || !par->mfx.FrameInfo.Height)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    mfxStatus sts = InitComponent(m_decode, par, &par->mfx.FrameInfo);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    m_decode.frameBytes = SimDevice::Get().GetConfig().decFrameBytes;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeInit(mfxVideoParam *par) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return InitDecode(par);
+}
+
+mfxStatus SimSession::DecodeReset(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    mfxStatus sts = ResetComponent(m_decode, par);
+    if (sts == MFX_ERR_NONE)
+        m_decode.pools[0]->SetFrameInfo(par->mfx.FrameInfo);
+
+    return sts;
+}
+
+mfxStatus SimSession::DecodeClose() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_decode.bInit || m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CloseComponent(m_decode);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeGetVideoParam(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_decode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CopyVideoParam(*par, m_decode.par);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeGetStat(mfxDecodeStat *stat) {
+    if (!stat)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_decode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    *stat          = {};
+    stat->NumFrame = m_decode.numFrames;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeFrameAsync(mfxBitstream *bs,
+                                       mfxFrameSurface1 *surface_work,
+                                       mfxFrameSurface1 **surface_out,
+                                       mfxSyncPoint *syncp) {
+    if (!surface_out || !syncp)
+        return MFX_ERR_NULL_PTR;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_decode.bInit || m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Retire(SimClock::now());
+
+    // frames are output as soon as they are submitted, so nothing is left to drain
+    if (!bs || !bs->DataLength)
+        return MFX_ERR_MORE_DATA;
+    if (IsBusy(m_decode))
+        return MFX_WRN_DEVICE_BUSY;
+
+    mfxFrameSurface1 *out = surface_work;
+    if (out) {
+        // surface_out is a reference of its own
+        if (SimSurfacePool::FromSurface(out))
+            out->FrameInterface->AddRef(out);
+    }
+    else {
+        mfxStatus sts = AcquireSurface(lock, m_decode.pools[0].get(), &out);
+        if (sts != MFX_ERR_NONE)
+            return sts;
+    }
+
+    mfxU32 bytes = std::min(bs->DataLength, m_decode.frameBytes);
+    bs->DataOffset += bytes;
+    bs->DataLength -= bytes;
+    m_decode.numBytes += bytes;
+
+    SimTime doneAt = SimDevice::Get().Schedule(SIM_ENGINE_DECODE, SimClock::now());
+
+    out->Data.TimeStamp  = bs->TimeStamp;
+    out->Data.FrameOrder = m_decode.numFrames;
+    SimSurfacePool::SetReadyTime(out, doneAt);
+
+    *surface_out = out;
+    *syncp       = AddTask(&m_decode, doneAt, out);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::VPPQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest request[2]) {
+    if (!par || !request)
+        return MFX_ERR_NULL_PTR;
+
+    mfxU32 depth = GetAsyncDepth(*par);
+
+    request[0]      = {};
+    request[0].Info = par->vpp.In;
+    request[0].Type =
+        MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_EXTERNAL_FRAME | MFX_MEMTYPE_FROM_VPPIN;
+    request[1]      = {};
+    request[1].Info = par->vpp.Out;
+    request[1].Type =
+        MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_EXTERNAL_FRAME | MFX_MEMTYPE_FROM_VPPOUT;
+
+    for (mfxU32 i = 0; i < 2; i++) {
+        request[i].NumFrameMin       = (mfxU16)depth;
+        request[i].NumFrameSuggested = (mfxU16)(depth + 1);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::VPPInit(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!par->vpp.In.Width || !par->vpp.In.Height || !par->vpp.Out.Width || !par->vpp.Out.Height)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return InitComponent(m_vpp, par, &par->vpp.In, &par->vpp.Out);
+}
+
+mfxStatus SimSession::VPPReset(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mfxStatus sts = ResetComponent(m_vpp, par);
+    if (sts == MFX_ERR_NONE) {
+        m_vpp.pools[0]->SetFrameInfo(par->vpp.In);
+        m_vpp.pools[1]->SetFrameInfo(par->vpp.Out);
+    }
+
+    return sts;
+}
+
+mfxStatus SimSession::VPPClose() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_vpp.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CloseComponent(m_vpp);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::VPPGetVideoParam(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_vpp.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CopyVideoParam(*par, m_vpp.par);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::VPPGetStat(mfxVPPStat *stat) {
+    if (!stat)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_vpp.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    *stat          = {};
+    stat->NumFrame = m_vpp.numFrames;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::RunFrameVPPAsync(mfxFrameSurface1 *in,
+                                       mfxFrameSurface1 *out,
+                                       mfxSyncPoint *syncp) {
+    if (!syncp)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_vpp.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Retire(SimClock::now());
+
+    // no frame rate conversion, nothing is buffered
+    if (!in)
+        return MFX_ERR_MORE_DATA;
+    if (!out)
+        return MFX_ERR_NULL_PTR;
+    if (IsBusy(m_vpp))
+        return MFX_WRN_DEVICE_BUSY;
+
+    SimTime doneAt = SimDevice::Get().Schedule(SIM_ENGINE_VPP, GetReadyTime(in));
+
+    out->Data.TimeStamp  = in->Data.TimeStamp;
+    out->Data.FrameOrder = in->Data.FrameOrder;
+    SimSurfacePool::SetReadyTime(out, doneAt);
+
+    *syncp = AddTask(&m_vpp, doneAt, in, out);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::ProcessFrameAsync(mfxFrameSurface1 *in, mfxFrameSurface1 **out) {
+    if (!out)
+        return MFX_ERR_NULL_PTR;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_vpp.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Retire(SimClock::now());
+
+    if (!in)
+        return MFX_ERR_MORE_DATA;
+    if (IsBusy(m_vpp))
+        return MFX_WRN_DEVICE_BUSY;
+
+    mfxFrameSurface1 *surface = nullptr;
+    mfxStatus sts             = AcquireSurface(lock, m_vpp.pools[1].get(), &surface);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    SimTime doneAt = SimDevice::Get().Schedule(SIM_ENGINE_VPP, GetReadyTime(in));
+
+    surface->Data.TimeStamp  = in->Data.TimeStamp;
+    surface->Data.FrameOrder = in->Data.FrameOrder;
+    SimSurfacePool::SetReadyTime(surface, doneAt);
+
+    // synchronized with the surface
+    AddTask(&m_vpp, doneAt, in, surface);
+    *out = surface;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeQueryIOSurf(mfxVideoParam *par, mfxFrameAllocRequest *request) {
+    if (!par || !request)
+        return MFX_ERR_NULL_PTR;
+    if (!IsEncoderSupported(par->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+
+    mfxU32 depth = GetAsyncDepth(*par);
+
+    *request                   = {};
+    request->Info              = par->mfx.FrameInfo;
+    request->NumFrameMin       = (mfxU16)depth;
+    request->NumFrameSuggested = (mfxU16)(depth + 1);
+    request->Type =
+        MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_EXTERNAL_FRAME | MFX_MEMTYPE_FROM_ENCODE;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeInit(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+    if (!IsEncoderSupported(par->mfx.CodecId))
+        return MFX_ERR_UNSUPPORTED;
+    if (!par->mfx.FrameInfo.Width || !par->mfx.FrameInfo.Height)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mfxStatus sts = InitComponent(m_encode, par, &par->mfx.FrameInfo);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    // constant frame size matching the bitrate
+    mfxInfoMFX &mfx     = m_encode.par.mfx;
+    mfxU32 multiplier   = mfx.BRCParamMultiplier ? mfx.BRCParamMultiplier : 1;
+    m_encode.frameBytes = SimDevice::Get().GetConfig().encFrameBytes;
+    if (!m_encode.frameBytes) {
+        bool bBitrate =
+            mfx.CodecId != MFX_CODEC_JPEG && mfx.RateControlMethod != MFX_RATECONTROL_CQP;
+        if (bBitrate && mfx.TargetKbps && mfx.FrameInfo.FrameRateExtN) {
+            mfxU64 bytes = (mfxU64)mfx.TargetKbps * multiplier * 1000 / 8 *
+                           mfx.FrameInfo.FrameRateExtD / mfx.FrameInfo.FrameRateExtN;
+            m_encode.frameBytes = (mfxU32)std::max<mfxU64>(bytes, 1);
+        }
+        else {
+            m_encode.frameBytes = DEF_ENC_FRAME_BYTES;
+        }
+    }
+
+    // room for two frames
+    if (mfx.CodecId != MFX_CODEC_JPEG && !mfx.BufferSizeInKB) {
+        mfxU64 sizeInKB    = ((mfxU64)m_encode.frameBytes * 2 + 999) / 1000 / multiplier + 1;
+        mfx.BufferSizeInKB = (mfxU16)std::min<mfxU64>(sizeInKB, 0xFFFF);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeReset(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mfxU16 bufferSizeInKB = m_encode.par.mfx.BufferSizeInKB;
+    mfxStatus sts         = ResetComponent(m_encode, par);
+    if (sts == MFX_ERR_NONE) {
+        if (!m_encode.par.mfx.BufferSizeInKB)
+            m_encode.par.mfx.BufferSizeInKB = bufferSizeInKB;
+        m_encode.pools[0]->SetFrameInfo(par->mfx.FrameInfo);
+    }
+
+    return sts;
+}
+
+mfxStatus SimSession::EncodeClose() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_encode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CloseComponent(m_encode);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeGetVideoParam(mfxVideoParam *par) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_encode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CopyVideoParam(*par, m_encode.par);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeGetStat(mfxEncodeStat *stat) {
+    if (!stat)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_encode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    *stat          = {};
+    stat->NumFrame = m_encode.numFrames;
+    stat->NumBit   = m_encode.numBytes * 8;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::EncodeFrameAsync(mfxEncodeCtrl *ctrl,
+                                       mfxFrameSurface1 *surface,
+                                       mfxBitstream *bs,
+                                       mfxSyncPoint *syncp) {
+    if (!syncp)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_encode.bInit)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Retire(SimClock::now());
+
+    // no B-frames, nothing is buffered
+    if (!surface)
+        return MFX_ERR_MORE_DATA;
+    if (!bs || !bs->Data)
+        return MFX_ERR_NULL_PTR;
+    if ((mfxU64)bs->MaxLength < (mfxU64)bs->DataOffset + bs->DataLength + m_encode.frameBytes)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+    if (IsBusy(m_encode))
+        return MFX_WRN_DEVICE_BUSY;
+
+    SimTime doneAt = SimDevice::Get().Schedule(SIM_ENGINE_ENCODE, GetReadyTime(surface));
+
+    // the contents are not encoded, a start code followed by zeros
+    mfxU8 *data = bs->Data + bs->DataOffset + bs->DataLength;
+    memset(data, 0, m_encode.frameBytes);
+    if (m_encode.frameBytes >= 4)
+        data[3] = 0x01;
+    bs->DataLength += m_encode.frameBytes;
+    m_encode.numBytes += m_encode.frameBytes;
+
+    mfxU16 gopPicSize = m_encode.par.mfx.GopPicSize;
+    bool bIDR         = !m_encode.numFrames || (gopPicSize && !(m_encode.numFrames % gopPicSize)) ||
+                (ctrl && (ctrl->FrameType & MFX_FRAMETYPE_I));
+
+    bs->TimeStamp       = surface->Data.TimeStamp;
+    bs->DecodeTimeStamp = surface->Data.TimeStamp;
+    bs->PicStruct       = MFX_PICSTRUCT_PROGRESSIVE;
+    bs->FrameType       = bIDR ? (MFX_FRAMETYPE_I | MFX_FRAMETYPE_REF | MFX_FRAMETYPE_IDR)
+                               : (MFX_FRAMETYPE_P | MFX_FRAMETYPE_REF);
+
+    *syncp = AddTask(&m_encode, doneAt, surface);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeVPPInit(mfxVideoParam *decode_par,
+                                    mfxVideoChannelParam **vpp_par_array,
+                                    mfxU32 num_vpp_par) {
+    if (!decode_par || (num_vpp_par && !vpp_par_array))
+        return MFX_ERR_NULL_PTR;
+    for (mfxU32 i = 0; i < num_vpp_par; i++) {
+        if (!vpp_par_array[i])
+            return MFX_ERR_NULL_PTR;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mfxStatus sts = InitDecode(decode_par);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    for (mfxU32 i = 0; i < num_vpp_par; i++) {
+        std::unique_ptr<Channel> channel(new Channel());
+        channel->par             = *vpp_par_array[i];
+        channel->par.ExtParam    = nullptr;
+        channel->par.NumExtParam = 0;
+
+        // each channel scales the decoded frame
+        mfxVideoParam vppPar = {};
+        vppPar.AsyncDepth    = (mfxU16)m_decode.depth;
+        vppPar.IOPattern     = vpp_par_array[i]->IOPattern;
+        vppPar.vpp.In        = decode_par->mfx.FrameInfo;
+        vppPar.vpp.Out       = vpp_par_array[i]->VPP;
+        vppPar.ExtParam      = vpp_par_array[i]->ExtParam;
+        vppPar.NumExtParam   = vpp_par_array[i]->NumExtParam;
+        InitComponent(channel->vpp, &vppPar, nullptr, &vpp_par_array[i]->VPP);
+
+        m_channels.push_back(std::move(channel));
+    }
+    m_bDecodeVPP = true;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeVPPReset(mfxVideoParam *decode_par,
+                                     mfxVideoChannelParam **vpp_par_array,
+                                     mfxU32 num_vpp_par) {
+    if (!decode_par || (num_vpp_par && !vpp_par_array))
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    // channels can be changed but not added
+    for (mfxU32 i = 0; i < num_vpp_par; i++) {
+        if (!vpp_par_array[i])
+            return MFX_ERR_NULL_PTR;
+
+        std::vector<std::unique_ptr<Channel>>::iterator it =
+            std::find_if(m_channels.begin(),
+                         m_channels.end(),
+                         [&](const std::unique_ptr<Channel> &channel) {
+                             return channel->par.VPP.ChannelId == vpp_par_array[i]->VPP.ChannelId;
+                         });
+        if (it == m_channels.end())
+            return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+    }
+
+    ResetComponent(m_decode, decode_par);
+    m_decode.pools[0]->SetFrameInfo(decode_par->mfx.FrameInfo);
+
+    for (mfxU32 i = 0; i < num_vpp_par; i++) {
+        for (std::unique_ptr<Channel> &channel : m_channels) {
+            if (channel->par.VPP.ChannelId != vpp_par_array[i]->VPP.ChannelId)
+                continue;
+
+            channel->par             = *vpp_par_array[i];
+            channel->par.ExtParam    = nullptr;
+            channel->par.NumExtParam = 0;
+            channel->vpp.par.vpp.In  = decode_par->mfx.FrameInfo;
+            channel->vpp.par.vpp.Out = vpp_par_array[i]->VPP;
+            channel->vpp.pools[1]->SetFrameInfo(vpp_par_array[i]->VPP);
+        }
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeVPPGetChannelParam(mfxVideoChannelParam *par, mfxU32 channel_id) {
+    if (!par)
+        return MFX_ERR_NULL_PTR;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    for (std::unique_ptr<Channel> &channel : m_channels) {
+        if (channel->par.VPP.ChannelId != channel_id)
+            continue;
+
+        mfxExtBuffer **extParam = par->ExtParam;
+        mfxU16 numExtParam      = par->NumExtParam;
+        *par                    = channel->par;
+        par->ExtParam           = extParam;
+        par->NumExtParam        = numExtParam;
+
+        return MFX_ERR_NONE;
+    }
+
+    return MFX_ERR_NOT_FOUND;
+}
+
+mfxStatus SimSession::DecodeVPPClose() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    CloseComponent(m_decode);
+    for (std::unique_ptr<Channel> &channel : m_channels)
+        CloseComponent(channel->vpp);
+    m_channels.clear();
+    m_bDecodeVPP = false;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::DecodeVPPFrameAsync(mfxBitstream *bs,
+                                          mfxU32 *skip_channels,
+                                          mfxU32 num_skip_channels,
+                                          mfxSurfaceArray **surf_array_out) {
+    if (!surf_array_out || (num_skip_channels && !skip_channels))
+        return MFX_ERR_NULL_PTR;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_bDecodeVPP)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    Retire(SimClock::now());
+
+    if (!bs || !bs->DataLength)
+        return MFX_ERR_MORE_DATA;
+    if (IsBusy(m_decode))
+        return MFX_WRN_DEVICE_BUSY;
+
+    // the decoded frame first, then one surface per channel which is not skipped
+    std::vector<SimComponent *> components(1, &m_decode);
+    for (std::unique_ptr<Channel> &channel : m_channels) {
+        mfxU32 *skipEnd = skip_channels + num_skip_channels;
+        if (std::find(skip_channels, skipEnd, channel->par.VPP.ChannelId) == skipEnd)
+            components.push_back(&channel->vpp);
+    }
+
+    std::vector<mfxFrameSurface1 *> surfaces;
+    for (SimComponent *component : components) {
+        SimSurfacePool *pool      = component->pools[0] ? component->pools[0].get()
+                                                        : component->pools[1].get();
+        mfxFrameSurface1 *surface = nullptr;
+        mfxStatus sts             = AcquireSurface(lock, pool, &surface);
+        if (sts != MFX_ERR_NONE) {
+            for (mfxFrameSurface1 *acquired : surfaces)
+                acquired->FrameInterface->Release(acquired);
+            return sts;
+        }
+        surfaces.push_back(surface);
+    }
+
+    mfxU32 bytes = std::min(bs->DataLength, m_decode.frameBytes);
+    bs->DataOffset += bytes;
+    bs->DataLength -= bytes;
+    m_decode.numBytes += bytes;
+
+    mfxU32 frameOrder = m_decode.numFrames;
+    SimTime decodedAt = SimDevice::Get().Schedule(SIM_ENGINE_DECODE, SimClock::now());
+
+    for (size_t i = 0; i < surfaces.size(); i++) {
+        SimTime doneAt = decodedAt;
+        if (i)
+            doneAt = SimDevice::Get().Schedule(SIM_ENGINE_VPP, decodedAt);
+
+        surfaces[i]->Data.TimeStamp  = bs->TimeStamp;
+        surfaces[i]->Data.FrameOrder = frameOrder;
+        SimSurfacePool::SetReadyTime(surfaces[i], doneAt);
+        AddTask(components[i], doneAt, surfaces[i]);
+    }
+
+    SimSurfaceArray *sim       = new SimSurfaceArray();
+    sim->refCount              = 1;
+    sim->surfaces              = surfaces;
+    sim->array.Context         = sim;
+    sim->array.Version.Version = MFX_SURFACEARRAY_VERSION;
+    sim->array.AddRef          = SimArrayAddRef;
+    sim->array.Release         = SimArrayRelease;
+    sim->array.GetRefCounter   = SimArrayGetRefCounter;
+    sim->array.Surfaces        = sim->surfaces.data();
+    sim->array.NumSurfaces     = (mfxU32)sim->surfaces.size();
+
+    *surf_array_out = &sim->array;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus SimSession::GetSurface(SimPoolType poolType, mfxFrameSurface1 **surface) {
+    if (!surface)
+        return MFX_ERR_NULL_PTR;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    SimSurfacePool *pool = nullptr;
+    switch (poolType) {
+        case SIM_POOL_DECODE:
+            pool = m_decode.pools[0].get();
+            break;
+        case SIM_POOL_VPP_IN:
+            pool = m_vpp.pools[0].get();
+            break;
+        case SIM_POOL_VPP_OUT:
+            pool = m_vpp.pools[1].get();
+            break;
+        case SIM_POOL_ENCODE:
+            pool = m_encode.pools[0].get();
+            break;
+    }
+    if (!pool)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    return AcquireSurface(lock, pool, surface);
+}
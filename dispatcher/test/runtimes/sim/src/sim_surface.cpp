@@ -0,0 +1,305 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string.h>
+
+#include <thread>
+
+#include "src/sim.h"
+
+#define SIM_SURFACE_ALIGN 16
+
+#define ALIGN_UP(val, align) (((val) + (align)-1) & ~((align)-1))
+
+// plane layout of the surface formats, anything else is handled as NV12
+struct SimFrameLayout {
+    mfxU32 pitch;
+    mfxU32 height;
+    size_t size;
+};
+
+static SimFrameLayout GetFrameLayout(const mfxFrameInfo &info) {
+    SimFrameLayout layout = {};
+    mfxU32 width          = ALIGN_UP((mfxU32)info.Width, SIM_SURFACE_ALIGN);
+
+    layout.height = ALIGN_UP((mfxU32)info.Height, SIM_SURFACE_ALIGN);
+    switch (info.FourCC) {
+        case MFX_FOURCC_P010:
+        case MFX_FOURCC_I010:
+            layout.pitch = width * 2;
+            layout.size  = (size_t)layout.pitch * layout.height * 3 / 2;
+            break;
+        case MFX_FOURCC_YUY2:
+            layout.pitch = width * 2;
+            layout.size  = (size_t)layout.pitch * layout.height;
+            break;
+        case MFX_FOURCC_RGB4:
+        case MFX_FOURCC_BGR4:
+            layout.pitch = width * 4;
+            layout.size  = (size_t)layout.pitch * layout.height;
+            break;
+        default:
+            layout.pitch = width;
+            layout.size  = (size_t)layout.pitch * layout.height * 3 / 2;
+            break;
+    }
+
+    return layout;
+}
+
+// sets the plane pointers of Data to the frame at base, or clears them if base is null
+static void SetFramePointers(mfxFrameSurface1 *surface, mfxU8 *base) {
+    mfxFrameData &data    = surface->Data;
+    SimFrameLayout layout = GetFrameLayout(surface->Info);
+    mfxU8 *chroma         = base ? base + (size_t)layout.pitch * layout.height : nullptr;
+
+    data.Y = data.U = data.V = data.A = nullptr;
+    data.PitchHigh                    = (mfxU16)(layout.pitch >> 16);
+    data.PitchLow                     = (mfxU16)(layout.pitch & 0xFFFF);
+
+    switch (surface->Info.FourCC) {
+        case MFX_FOURCC_I420:
+        case MFX_FOURCC_I010:
+            data.Y = base;
+            data.U = chroma;
+            data.V = chroma ? chroma + (size_t)layout.pitch / 2 * layout.height / 2 : nullptr;
+            break;
+        case MFX_FOURCC_YUY2:
+            data.Y = base;
+            data.U = base ? base + 1 : nullptr;
+            data.V = base ? base + 3 : nullptr;
+            break;
+        case MFX_FOURCC_RGB4:
+            data.B = base;
+            data.G = base ? base + 1 : nullptr;
+            data.R = base ? base + 2 : nullptr;
+            data.A = base ? base + 3 : nullptr;
+            break;
+        case MFX_FOURCC_BGR4:
+            data.R = base;
+            data.G = base ? base + 1 : nullptr;
+            data.B = base ? base + 2 : nullptr;
+            data.A = base ? base + 3 : nullptr;
+            break;
+        default:
+            data.Y  = base;
+            data.UV = chroma;
+            break;
+    }
+}
+
+static SimSurface *GetSimSurface(mfxFrameSurface1 *surface) {
+    return (surface && surface->FrameInterface) ? (SimSurface *)surface->FrameInterface->Context
+                                                : nullptr;
+}
+
+// waits until the tasks writing the surface are done or wait msec have passed
+static mfxStatus WaitReady(mfxFrameSurface1 *surface, mfxU32 wait) {
+    SimTime readyAt = SimSurfacePool::GetReadyTime(surface);
+    SimTime timeout = SimClock::now() + std::chrono::milliseconds(wait);
+
+    if (readyAt > timeout) {
+        std::this_thread::sleep_until(timeout);
+        return MFX_WRN_IN_EXECUTION;
+    }
+
+    std::this_thread::sleep_until(readyAt);
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimAddRef(mfxFrameSurface1 *surface) {
+    SimSurface *sim = GetSimSurface(surface);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+
+    sim->refCount++;
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimRelease(mfxFrameSurface1 *surface) {
+    SimSurface *sim = GetSimSurface(surface);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+
+    // once the counter is 0 the surface may be handed out again by the pool
+    mfxU32 refCount = sim->refCount.load();
+    do {
+        if (!refCount)
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+    } while (!sim->refCount.compare_exchange_weak(refCount, refCount - 1));
+
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimGetRefCounter(mfxFrameSurface1 *surface, mfxU32 *counter) {
+    SimSurface *sim = GetSimSurface(surface);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+    if (!counter)
+        return MFX_ERR_NULL_PTR;
+
+    *counter = sim->refCount.load();
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimMap(mfxFrameSurface1 *surface, mfxU32 flags) {
+    SimSurface *sim = GetSimSurface(surface);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+    if (!(flags & MFX_MAP_READ_WRITE))
+        return MFX_ERR_UNSUPPORTED;
+
+    // reading waits for the surface like Synchronize
+    if (flags & MFX_MAP_READ) {
+        if (flags & MFX_MAP_NOWAIT) {
+            if (SimSurfacePool::GetReadyTime(surface) > SimClock::now())
+                return MFX_WRN_IN_EXECUTION;
+        }
+        else {
+            WaitReady(surface, MFX_INFINITE);
+        }
+    }
+
+    if (sim->data.empty())
+        sim->data.resize(GetFrameLayout(surface->Info).size);
+
+    SetFramePointers(surface, sim->data.data());
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimUnmap(mfxFrameSurface1 *surface) {
+    SimSurface *sim = GetSimSurface(surface);
+    if (!sim)
+        return MFX_ERR_INVALID_HANDLE;
+
+    SetFramePointers(surface, nullptr);
+    return MFX_ERR_NONE;
+}
+
+static mfxStatus MFX_CDECL SimGetNativeHandle(mfxFrameSurface1 *surface,
+                                              mfxHDL *resource,
+                                              mfxResourceType *resource_type) {
+    if (!GetSimSurface(surface))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!resource || !resource_type)
+        return MFX_ERR_NULL_PTR;
+
+    // system memory surfaces have no native handle
+    return MFX_ERR_UNSUPPORTED;
+}
+
+static mfxStatus MFX_CDECL SimGetDeviceHandle(mfxFrameSurface1 *surface,
+                                              mfxHDL *device_handle,
+                                              mfxHandleType *device_type) {
+    if (!GetSimSurface(surface))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!device_handle || !device_type)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
+static mfxStatus MFX_CDECL SimSynchronize(mfxFrameSurface1 *surface, mfxU32 wait) {
+    if (!GetSimSurface(surface))
+        return MFX_ERR_INVALID_HANDLE;
+
+    return WaitReady(surface, wait);
+}
+
+static mfxStatus MFX_CDECL SimQueryInterface(mfxFrameSurface1 *surface,
+                                             mfxGUID guid,
+                                             mfxHDL *iface) {
+    if (!GetSimSurface(surface))
+        return MFX_ERR_INVALID_HANDLE;
+    if (!iface)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
+SimSurfacePool::SimSurfacePool(const mfxFrameInfo &info, mfxU32 limit, mfxU32 waitMsec)
+        : m_info(info),
+          m_limit(limit),
+          m_waitMsec(waitMsec),
+          m_mutex(),
+          m_surfaces() {}
+
+mfxFrameSurface1 *SimSurfacePool::Acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SimSurface *sim = nullptr;
+    for (std::unique_ptr<SimSurface> &surface : m_surfaces) {
+        mfxU32 refCount = 0;
+        if (surface->refCount.compare_exchange_strong(refCount, 1)) {
+            sim = surface.get();
+            break;
+        }
+    }
+
+    if (!sim) {
+        if (m_limit && m_surfaces.size() >= m_limit)
+            return nullptr;
+
+        m_surfaces.emplace_back(new SimSurface());
+        sim = m_surfaces.back().get();
+        sim->refCount.store(1);
+        sim->pool = this;
+
+        sim->iface.Context         = sim;
+        sim->iface.Version.Version = MFX_FRAMESURFACEINTERFACE_VERSION;
+        sim->iface.AddRef          = SimAddRef;
+        sim->iface.Release         = SimRelease;
+        sim->iface.GetRefCounter   = SimGetRefCounter;
+        sim->iface.Map             = SimMap;
+        sim->iface.Unmap           = SimUnmap;
+        sim->iface.GetNativeHandle = SimGetNativeHandle;
+        sim->iface.GetDeviceHandle = SimGetDeviceHandle;
+        sim->iface.Synchronize     = SimSynchronize;
+        sim->iface.QueryInterface  = SimQueryInterface;
+    }
+
+    // same state as a newly allocated surface
+    mfxFrameSurface1 *surface = &sim->surface;
+    memset(surface, 0, sizeof(mfxFrameSurface1));
+    surface->Version.Version = MFX_FRAMESURFACE1_VERSION;
+    surface->FrameInterface  = &sim->iface;
+    surface->Info            = m_info;
+    surface->Data.TimeStamp  = MFX_TIMESTAMP_UNKNOWN;
+    surface->Data.FrameOrder = MFX_FRAMEORDER_UNKNOWN;
+    SetFramePointers(surface, nullptr);
+    sim->readyAt.store(SimTime().time_since_epoch().count());
+
+    return surface;
+}
+
+void SimSurfacePool::SetFrameInfo(const mfxFrameInfo &info) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_info = info;
+}
+
+SimSurface *SimSurfacePool::FromSurface(mfxFrameSurface1 *surface) {
+    SimSurface *sim = GetSimSurface(surface);
+
+    // surfaces of other runtimes or of the app may have a FrameInterface too
+    if (!sim || surface->FrameInterface->AddRef != SimAddRef)
+        return nullptr;
+
+    return sim;
+}
+
+void SimSurfacePool::SetReadyTime(mfxFrameSurface1 *surface, SimTime readyAt) {
+    SimSurface *sim = FromSurface(surface);
+    if (sim)
+        sim->readyAt.store(readyAt.time_since_epoch().count());
+}
+
+SimTime SimSurfacePool::GetReadyTime(mfxFrameSurface1 *surface) {
+    SimSurface *sim = FromSurface(surface);
+    if (!sim)
+        return SimTime();
+
+    return SimTime(SimClock::duration(sim->readyAt.load()));
+}
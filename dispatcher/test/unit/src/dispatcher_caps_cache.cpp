@@ -0,0 +1,149 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the persistent capability cache (ONEVPL_DISPATCHER_CACHE_FILE).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "src/dispatcher_common.h"
+
+#define CAPS_CACHE_TEST_FILE "dispatcher_caps_cache_test.bin"
+
+static void SetCapsCacheFile(const char *fileName) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_CACHE_FILE", fileName);
+#else
+    if (fileName)
+        setenv("ONEVPL_DISPATCHER_CACHE_FILE", fileName, 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_CACHE_FILE");
+#endif
+}
+
+// summary of stub description, compared between cached and uncached runs
+struct CapsCacheTestResult {
+    std::string implName;
+    mfxU32 vendorImplID;
+    mfxU16 numDecCodecs;
+    mfxU16 numEncCodecs;
+    mfxU16 numVPPFilters;
+    mfxU16 numFunctions;
+    std::string outputLog;
+};
+
+// load stub, enumerate first implementation, and create session
+static void RunStubWithCapsCache(CapsCacheTestResult &result) {
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplementedFunctions *implFuncs = nullptr;
+    sts                                = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                 (mfxHDL *)&implFuncs);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (implDesc) {
+        result.implName      = implDesc->ImplName;
+        result.vendorImplID  = implDesc->VendorImplID;
+        result.numDecCodecs  = implDesc->Dec.NumCodecs;
+        result.numEncCodecs  = implDesc->Enc.NumCodecs;
+        result.numVPPFilters = implDesc->VPP.NumFilters;
+        MFXDispReleaseImplDescription(loader, implDesc);
+    }
+
+    if (implFuncs) {
+        result.numFunctions = implFuncs->NumFunctions;
+        MFXDispReleaseImplDescription(loader, implFuncs);
+    }
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader);
+
+    GetOutputLog(result.outputLog);
+}
+
+TEST(Dispatcher_Stub_CapsCache, SecondLoadUsesCache) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    remove(CAPS_CACHE_TEST_FILE);
+    SetCapsCacheFile(CAPS_CACHE_TEST_FILE);
+
+    CapsCacheTestResult first = {};
+    RunStubWithCapsCache(first);
+    CheckOutputLog(first.outputLog, "caps cache add");
+    CheckOutputLog(first.outputLog, "caps cache hit", false);
+
+    CapsCacheTestResult second = {};
+    RunStubWithCapsCache(second);
+    CheckOutputLog(second.outputLog, "caps cache hit");
+    CheckOutputLog(second.outputLog, "caps cache add", false);
+
+    // description restored from cache must match the one reported by the runtime
+    EXPECT_EQ(first.implName, second.implName);
+    EXPECT_EQ(first.vendorImplID, second.vendorImplID);
+    EXPECT_EQ(first.numDecCodecs, second.numDecCodecs);
+    EXPECT_EQ(first.numEncCodecs, second.numEncCodecs);
+    EXPECT_EQ(first.numVPPFilters, second.numVPPFilters);
+    EXPECT_EQ(first.numFunctions, second.numFunctions);
+
+    SetCapsCacheFile(nullptr);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+TEST(Dispatcher_Stub_CapsCache, InvalidCacheFileIsRebuilt) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    {
+        std::ofstream f(CAPS_CACHE_TEST_FILE, std::ios::out | std::ios::binary | std::ios::trunc);
+        f << "not a valid cache file";
+    }
+    SetCapsCacheFile(CAPS_CACHE_TEST_FILE);
+
+    CapsCacheTestResult result = {};
+    RunStubWithCapsCache(result);
+    CheckOutputLog(result.outputLog, "caps cache empty or invalid");
+    CheckOutputLog(result.outputLog, "caps cache add");
+    EXPECT_EQ(result.implName, "Stub Implementation");
+
+    // rebuilt file should now be used
+    RunStubWithCapsCache(result);
+    CheckOutputLog(result.outputLog, "caps cache hit");
+
+    SetCapsCacheFile(nullptr);
+    remove(CAPS_CACHE_TEST_FILE);
+}
+
+TEST(Dispatcher_Stub_CapsCache, DisabledByDefault) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetCapsCacheFile(nullptr);
+
+    CapsCacheTestResult result = {};
+    RunStubWithCapsCache(result);
+    CheckOutputLog(result.outputLog, "caps cache", false);
+}
@@ -365,3 +365,85 @@ TEST(Dispatcher_LowLatency, Get_ImplDesc_MFXEnumImplementations_AfterSessionCrea
     MFXClose(session);
     MFXUnload(loader);
 }
+
+#if defined(_WIN32) || defined(_WIN64)
+    #if defined _DEBUG
+        #define FAST_START_STUB_RT "libvplstubrt64d.dll"
+    #else
+        #define FAST_START_STUB_RT "libvplstubrt64.dll"
+    #endif
+#else
+    #define FAST_START_STUB_RT "libvplstubrt64.so"
+#endif
+
+// fast start - explicit runtime path, remaining filters are not validated against runtime caps
+TEST(Dispatcher_LowLatency, FastStartPath_CreatesSessionWithoutQuery) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    // stub runtime is located in ONEVPL_SEARCH_PATH, see CMakeLists.txt
+    const char *searchPath = std::getenv("ONEVPL_SEARCH_PATH");
+    if (!searchPath)
+        GTEST_SKIP();
+
+    std::string libPath = searchPath;
+    libPath += PATH_SEPARATOR;
+    libPath += FAST_START_STUB_RT;
+
+    // capture dispatcher log
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxConfig cfg       = MFXCreateConfig(loader);
+    mfxVariant var      = {};
+    var.Version.Version = MFX_VARIANT_VERSION;
+
+    var.Type      = MFX_VARIANT_TYPE_PTR;
+    var.Data.Ptr  = (mfxHDL)libPath.c_str();
+    mfxStatus sts = MFXSetConfigFilterProperty(cfg, (const mfxU8 *)"FastStartPath", var);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // expected caps - would disable low latency mode without FastStartPath
+    var.Type     = MFX_VARIANT_TYPE_U32;
+    var.Data.U32 = MFX_CODEC_HEVC;
+    sts          = MFXSetConfigFilterProperty(
+        cfg,
+        (const mfxU8 *)"mfxImplDescription.mfxDecoderDescription.decoder.CodecID",
+        var);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_NE(session, nullptr);
+
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "message:  low latency mode enabled");
+    CheckOutputLog(outputLog, "message:  fast start -- VPL runtime loaded");
+}
+
+TEST(Dispatcher_LowLatency, FastStartPath_InvalidPathReturnsNotFound) {
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxConfig cfg       = MFXCreateConfig(loader);
+    mfxVariant var      = {};
+    var.Version.Version = MFX_VARIANT_VERSION;
+    var.Type            = MFX_VARIANT_TYPE_PTR;
+    var.Data.Ptr        = (mfxHDL) "not_a_runtime_library";
+
+    mfxStatus sts = MFXSetConfigFilterProperty(cfg, (const mfxU8 *)"FastStartPath", var);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    MFXUnload(loader);
+}
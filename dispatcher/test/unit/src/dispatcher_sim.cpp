@@ -0,0 +1,366 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+///
+/// Unit tests for the latency simulating runtime (dispatcher/test/runtimes/sim).
+///
+/// @file
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/dispatcher_common.h"
+
+#define SIM_IMPL_NAME "Simulation Implementation"
+
+static const char *simEnvNames[] = {
+    "ONEVPL_SIMRT_DECODE_LATENCY",
+    "ONEVPL_SIMRT_ENCODE_LATENCY",
+    "ONEVPL_SIMRT_ENGINES",
+    "ONEVPL_SIMRT_ENC_FRAME_BYTES",
+};
+
+static void SetEnv(const char *name, const char *value) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable(name, value);
+#else
+    if (value)
+        setenv(name, value, 1);
+    else
+        unsetenv(name);
+#endif
+}
+
+static bool GetEnv(const char *name, std::string &value) {
+#if defined(_WIN32) || defined(_WIN64)
+    char buf[MAX_PATH] = {};
+    if (!GetEnvironmentVariable(name, buf, MAX_PATH))
+        return false;
+    value = buf;
+#else
+    const char *buf = getenv(name);
+    if (!buf)
+        return false;
+    value = buf;
+#endif
+    return true;
+}
+
+// creates a session on the simulation runtime, which is not in the search path of the other
+//   tests, the ONEVPL_SIMRT_* variables must be set before as they are read when it is loaded
+static mfxSession CreateSimSession(mfxLoader &loader) {
+    std::string searchPath;
+    bool bSearchPath = GetEnv("ONEVPL_SEARCH_PATH", searchPath);
+    SetEnv("ONEVPL_SEARCH_PATH", SIMRT_DIR);
+
+    loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigFilterProperty<mfxHDL>(loader,
+                                                    "mfxImplDescription.ImplName",
+                                                    const_cast<char *>(SIM_IMPL_NAME));
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    SetEnv("ONEVPL_SEARCH_PATH", bSearchPath ? searchPath.c_str() : nullptr);
+
+    return session;
+}
+
+static void CloseSimSession(mfxLoader loader, mfxSession session) {
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    for (const char *name : simEnvNames)
+        SetEnv(name, nullptr);
+}
+
+static mfxStatus InitSimDecode(mfxSession session,
+                               mfxU16 asyncDepth,
+                               mfxExtAllocationHints *hints = nullptr) {
+    mfxVideoParam par          = {};
+    mfxExtBuffer *extParam[1]  = { (mfxExtBuffer *)hints };
+    par.mfx.CodecId            = MFX_CODEC_HEVC;
+    par.mfx.FrameInfo.FourCC   = MFX_FOURCC_NV12;
+    par.mfx.FrameInfo.Width    = 1920;
+    par.mfx.FrameInfo.Height   = 1088;
+    par.mfx.FrameInfo.CropW    = 1920;
+    par.mfx.FrameInfo.CropH    = 1080;
+    par.IOPattern              = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    par.AsyncDepth             = asyncDepth;
+    par.ExtParam               = hints ? extParam : nullptr;
+    par.NumExtParam            = hints ? 1 : 0;
+
+    return MFXVideoDECODE_Init(session, &par);
+}
+
+// large enough for a few frames of the default size consumed per frame
+struct SimBitstream {
+    SimBitstream() : data(1 << 20, 0), bs() {
+        bs.Data       = data.data();
+        bs.MaxLength  = (mfxU32)data.size();
+        bs.DataLength = (mfxU32)data.size();
+    }
+
+    std::vector<mfxU8> data;
+    mfxBitstream bs;
+};
+
+TEST(Dispatcher_Sim_Decode, SyncWaitsForLatency) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetEnv("ONEVPL_SIMRT_DECODE_LATENCY", "20000,0");
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    EXPECT_EQ(InitSimDecode(session, 1), MFX_ERR_NONE);
+
+    SimBitstream input;
+    mfxFrameSurface1 *surface = nullptr;
+    mfxSyncPoint syncp        = nullptr;
+    mfxStatus sts = MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &surface, &syncp);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_LT(input.bs.DataLength, (mfxU32)input.data.size());
+
+    // not done before the latency has passed
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp, 0), MFX_WRN_IN_EXECUTION);
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp, 1000), MFX_ERR_NONE);
+    EXPECT_EQ(surface->FrameInterface->Synchronize(surface, 0), MFX_ERR_NONE);
+
+    surface->FrameInterface->Release(surface);
+    MFXVideoDECODE_Close(session);
+
+    CloseSimSession(loader, session);
+}
+
+TEST(Dispatcher_Sim_Decode, DeviceBusyAtAsyncDepth) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetEnv("ONEVPL_SIMRT_DECODE_LATENCY", "20000,0");
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    EXPECT_EQ(InitSimDecode(session, 2), MFX_ERR_NONE);
+
+    SimBitstream input;
+    mfxFrameSurface1 *surfaces[3] = {};
+    mfxSyncPoint syncp[3]         = {};
+    for (mfxU32 i = 0; i < 2; i++) {
+        mfxStatus sts =
+            MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &surfaces[i], &syncp[i]);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+    }
+
+    mfxStatus sts =
+        MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &surfaces[2], &syncp[2]);
+    EXPECT_EQ(sts, MFX_WRN_DEVICE_BUSY);
+
+    // room for one more task once the first one is done
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp[0], 1000), MFX_ERR_NONE);
+    sts = MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &surfaces[2], &syncp[2]);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    for (mfxFrameSurface1 *surface : surfaces) {
+        if (surface)
+            surface->FrameInterface->Release(surface);
+    }
+    MFXVideoDECODE_Close(session);
+
+    CloseSimSession(loader, session);
+}
+
+TEST(Dispatcher_Sim_Decode, EnginesLimitConcurrency) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetEnv("ONEVPL_SIMRT_DECODE_LATENCY", "20000,0");
+    SetEnv("ONEVPL_SIMRT_ENGINES", "2");
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    EXPECT_EQ(InitSimDecode(session, 4), MFX_ERR_NONE);
+
+    SimBitstream input;
+    mfxFrameSurface1 *surfaces[3] = {};
+    mfxSyncPoint syncp[3]         = {};
+    for (mfxU32 i = 0; i < 3; i++) {
+        mfxStatus sts =
+            MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &surfaces[i], &syncp[i]);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+    }
+
+    // the first two frames run in parallel, the third one waits for an engine
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp[0], 1000), MFX_ERR_NONE);
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp[1], 5), MFX_ERR_NONE);
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp[2], 5), MFX_WRN_IN_EXECUTION);
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp[2], 1000), MFX_ERR_NONE);
+
+    for (mfxFrameSurface1 *surface : surfaces)
+        surface->FrameInterface->Release(surface);
+    MFXVideoDECODE_Close(session);
+
+    CloseSimSession(loader, session);
+}
+
+TEST(Dispatcher_Sim_Decode, LimitedPoolTimesOut) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    mfxExtAllocationHints hints = {};
+    hints.Header.BufferId       = MFX_EXTBUFF_ALLOCATION_HINTS;
+    hints.Header.BufferSz       = sizeof(mfxExtAllocationHints);
+    hints.AllocationPolicy      = MFX_ALLOCATION_LIMITED;
+    hints.NumberToPreAllocate   = 2;
+    EXPECT_EQ(InitSimDecode(session, 4, &hints), MFX_ERR_NONE);
+
+    mfxFrameSurface1 *surfaces[3] = {};
+    EXPECT_EQ(MFXMemory_GetSurfaceForDecode(session, &surfaces[0]), MFX_ERR_NONE);
+    EXPECT_EQ(MFXMemory_GetSurfaceForDecode(session, &surfaces[1]), MFX_ERR_NONE);
+    EXPECT_EQ(MFXMemory_GetSurfaceForDecode(session, &surfaces[2]), MFX_WRN_ALLOC_TIMEOUT_EXPIRED);
+
+    // decoding needs a surface of the pool too
+    SimBitstream input;
+    mfxFrameSurface1 *output = nullptr;
+    mfxSyncPoint syncp       = nullptr;
+    mfxStatus sts = MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &output, &syncp);
+    EXPECT_EQ(sts, MFX_WRN_ALLOC_TIMEOUT_EXPIRED);
+
+    surfaces[1]->FrameInterface->Release(surfaces[1]);
+    sts = MFXVideoDECODE_DecodeFrameAsync(session, &input.bs, nullptr, &output, &syncp);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_EQ(output, surfaces[1]);
+
+    EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp, 1000), MFX_ERR_NONE);
+    output->FrameInterface->Release(output);
+    surfaces[0]->FrameInterface->Release(surfaces[0]);
+    MFXVideoDECODE_Close(session);
+
+    CloseSimSession(loader, session);
+}
+
+TEST(Dispatcher_Sim_DecodeVPP, ReturnsSurfacePerChannel) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    mfxVideoParam decodePar            = {};
+    decodePar.mfx.CodecId              = MFX_CODEC_AVC;
+    decodePar.mfx.FrameInfo.FourCC     = MFX_FOURCC_NV12;
+    decodePar.mfx.FrameInfo.Width      = 1920;
+    decodePar.mfx.FrameInfo.Height     = 1088;
+    decodePar.IOPattern                = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    mfxVideoChannelParam channels[2]   = {};
+    mfxVideoChannelParam *channelPar[] = { &channels[0], &channels[1] };
+    for (mfxU16 i = 0; i < 2; i++) {
+        channels[i].VPP.FourCC    = MFX_FOURCC_BGRA;
+        channels[i].VPP.Width     = 640;
+        channels[i].VPP.Height    = 368;
+        channels[i].VPP.ChannelId = i + 1;
+        channels[i].IOPattern     = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    }
+    EXPECT_EQ(MFXVideoDECODE_VPP_Init(session, &decodePar, channelPar, 2), MFX_ERR_NONE);
+
+    SimBitstream input;
+    mfxSurfaceArray *output = nullptr;
+    mfxStatus sts = MFXVideoDECODE_VPP_DecodeFrameAsync(session, &input.bs, nullptr, 0, &output);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_FALSE(output == nullptr);
+
+    // decoded frame first
+    ASSERT_EQ(output->NumSurfaces, 3u);
+    EXPECT_EQ(output->Surfaces[0]->Info.Width, 1920);
+    EXPECT_EQ(output->Surfaces[1]->Info.ChannelId, 1);
+    EXPECT_EQ(output->Surfaces[2]->Info.ChannelId, 2);
+    EXPECT_EQ(output->Surfaces[2]->Info.Width, 640);
+
+    mfxFrameSurface1 *surface = output->Surfaces[2];
+    EXPECT_EQ(surface->FrameInterface->Synchronize(surface, 1000), MFX_ERR_NONE);
+    EXPECT_EQ(surface->FrameInterface->Map(surface, MFX_MAP_READ), MFX_ERR_NONE);
+    EXPECT_FALSE(surface->Data.B == nullptr);
+    EXPECT_EQ(surface->Data.PitchLow, 640 * 4);
+    EXPECT_EQ(surface->FrameInterface->Unmap(surface), MFX_ERR_NONE);
+    output->Release(output);
+
+    mfxU32 skipChannels[] = { 1 };
+    sts = MFXVideoDECODE_VPP_DecodeFrameAsync(session, &input.bs, skipChannels, 1, &output);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    ASSERT_EQ(output->NumSurfaces, 2u);
+    EXPECT_EQ(output->Surfaces[1]->Info.ChannelId, 2);
+    output->Release(output);
+
+    MFXVideoDECODE_VPP_Close(session);
+
+    CloseSimSession(loader, session);
+}
+
+TEST(Dispatcher_Sim_Encode, WritesConfiguredFrameSize) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetEnv("ONEVPL_SIMRT_ENC_FRAME_BYTES", "1000");
+
+    mfxLoader loader   = nullptr;
+    mfxSession session = CreateSimSession(loader);
+    ASSERT_FALSE(session == nullptr);
+
+    mfxVideoParam par        = {};
+    par.mfx.CodecId          = MFX_CODEC_AVC;
+    par.mfx.GopPicSize       = 2;
+    par.mfx.FrameInfo.FourCC = MFX_FOURCC_NV12;
+    par.mfx.FrameInfo.Width  = 1920;
+    par.mfx.FrameInfo.Height = 1088;
+    par.IOPattern            = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+    EXPECT_EQ(MFXVideoENCODE_Init(session, &par), MFX_ERR_NONE);
+
+    std::vector<mfxU8> data(4000);
+    mfxBitstream bs = {};
+    bs.Data         = data.data();
+    bs.MaxLength    = (mfxU32)data.size();
+
+    mfxU16 expectedTypes[] = { MFX_FRAMETYPE_IDR, 0, MFX_FRAMETYPE_IDR };
+    for (mfxU16 expectedType : expectedTypes) {
+        mfxFrameSurface1 *surface = nullptr;
+        EXPECT_EQ(MFXMemory_GetSurfaceForEncode(session, &surface), MFX_ERR_NONE);
+
+        mfxSyncPoint syncp = nullptr;
+        EXPECT_EQ(MFXVideoENCODE_EncodeFrameAsync(session, nullptr, surface, &bs, &syncp),
+                  MFX_ERR_NONE);
+        surface->FrameInterface->Release(surface);
+
+        EXPECT_EQ(MFXVideoCORE_SyncOperation(session, syncp, 1000), MFX_ERR_NONE);
+        EXPECT_EQ(bs.DataLength, 1000u);
+        EXPECT_EQ(bs.FrameType & MFX_FRAMETYPE_IDR, expectedType);
+        bs.DataLength = 0;
+    }
+
+    // no room for a frame
+    bs.MaxLength       = 500;
+    mfxSyncPoint syncp = nullptr;
+    mfxFrameSurface1 *surface = nullptr;
+    EXPECT_EQ(MFXMemory_GetSurfaceForEncode(session, &surface), MFX_ERR_NONE);
+    EXPECT_EQ(MFXVideoENCODE_EncodeFrameAsync(session, nullptr, surface, &bs, &syncp),
+              MFX_ERR_NOT_ENOUGH_BUFFER);
+    surface->FrameInterface->Release(surface);
+
+    MFXVideoENCODE_Close(session);
+
+    CloseSimSession(loader, session);
+}
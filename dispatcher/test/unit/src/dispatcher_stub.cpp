@@ -6,6 +6,9 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <vector>
+
 #include "src/dispatcher_common.h"
 
 TEST(Dispatcher_Stub_CreateSession, SimpleConfigCanCreateSession) {
@@ -1104,3 +1107,943 @@ TEST(Dispatcher_Stub_CreateSession, EncodeStatsTwoCodecsInvalid) {
 }
 
 #endif // ONEVPL_EXPERIMENTAL
+
+// list of implemented functions is only queried from the runtime when required
+TEST(Dispatcher_Stub_EnumImpls, ImplementedFunctionsQueriedOnDemand) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_FALSE(implDesc == nullptr);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "deferred caps query", false);
+
+    CaptureOutputLog(true);
+
+    mfxImplementedFunctions *implFuncs = nullptr;
+    sts                                = MFXEnumImplementations(loader,
+                                 0,
+                                 MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                 (mfxHDL *)&implFuncs);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_FALSE(implFuncs == nullptr);
+
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "deferred caps query", true);
+
+    if (implDesc)
+        MFXDispReleaseImplDescription(loader, implDesc);
+    if (implFuncs)
+        MFXDispReleaseImplDescription(loader, implFuncs);
+
+    // free internal resources
+    MFXUnload(loader);
+}
+
+// candidate libraries may be loaded on multiple threads
+TEST(Dispatcher_Stub_CreateSession, ParallelProbeCreatesSession) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_PROBE_THREADS", "4");
+#else
+    setenv("ONEVPL_DISPATCHER_PROBE_THREADS", "4", 1);
+#endif
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // create session with first implementation
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // free internal resources
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_PROBE_THREADS", NULL);
+#else
+    unsetenv("ONEVPL_DISPATCHER_PROBE_THREADS");
+#endif
+
+    // stub and stub1x runtimes are in the search path
+    CheckOutputLog(outputLog, "message:  probing");
+}
+
+TEST(Dispatcher_Stub_CreateSession, QueryTimingReportsStartup) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxDispatcherTiming timing = {};
+    sts                        = MFXDispQueryTiming(loader, &timing);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    EXPECT_EQ(timing.Version.Version, (mfxU16)MFX_DISPATCHERTIMING_VERSION);
+    EXPECT_GT(timing.NumSearchDirs, 0u);
+    EXPECT_GT(timing.NumLibsLoaded, 0u);
+
+    sts = MFXDispQueryTiming(loader, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_NULL_PTR);
+
+    // free internal resources
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_CreateSession, TimingLogLevelPrintsOnlyTiming) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_LOG", "TIMING");
+#else
+    setenv("ONEVPL_DISPATCHER_LOG", "TIMING", 1);
+#endif
+
+    CaptureOutputLog();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // free internal resources
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+
+    CheckOutputLog(outputLog, "timing:   search dir");
+    CheckOutputLog(outputLog, "timing:   load library");
+    CheckOutputLog(outputLog, "timing:   query caps");
+    CheckOutputLog(outputLog, "timing:   UpdateValidImplList");
+    CheckOutputLog(outputLog, "timing:   CreateSession");
+    CheckOutputLog(outputLog, "function:", false);
+    CheckOutputLog(outputLog, "message:", false);
+}
+
+TEST(Dispatcher_Stub_CreateSession, AsyncLogWritesAllMessages) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_LOG_ASYNC", "ON");
+#else
+    setenv("ONEVPL_DISPATCHER_LOG_ASYNC", "ON", 1);
+#endif
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // free internal resources, queued messages are written by MFXUnload
+    if (session)
+        MFXClose(session);
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_LOG_ASYNC", NULL);
+#else
+    unsetenv("ONEVPL_DISPATCHER_LOG_ASYNC");
+#endif
+
+    CheckOutputLog(outputLog, "] function: ");
+    CheckOutputLog(outputLog, "message:");
+    CheckOutputLog(outputLog, "timing:   CreateSession");
+    CheckOutputLog(outputLog, "messages dropped", false);
+}
+
+TEST(Dispatcher_Stub_CreateSession, SessionPoolReusesSessions) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXCreateSessionPool(loader, 0, 2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // invalid index
+    sts = MFXCreateSessionPool(loader, 99, 1);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    mfxSession session1 = nullptr, session2 = nullptr, session3 = nullptr;
+    sts = MFXAcquireSession(loader, 0, &session1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXAcquireSession(loader, 0, &session2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_FALSE(session1 == nullptr);
+    EXPECT_NE(session1, session2);
+
+    // released session is handed out again
+    sts = MFXReleaseSession(loader, session1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXAcquireSession(loader, 0, &session3);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_EQ(session1, session3);
+
+    // pool is empty, new session is created
+    mfxSession session4 = nullptr;
+    sts                 = MFXAcquireSession(loader, 0, &session4);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_FALSE(session4 == nullptr);
+
+    // double release and unknown sessions are rejected
+    sts = MFXReleaseSession(loader, session2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXReleaseSession(loader, session2);
+    EXPECT_EQ(sts, MFX_ERR_INVALID_HANDLE);
+
+    mfxSession session5 = nullptr;
+    sts                 = MFXCreateSession(loader, 0, &session5);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXReleaseSession(loader, session5);
+    EXPECT_EQ(sts, MFX_ERR_INVALID_HANDLE);
+
+    sts = MFXReleaseSession(loader, session3);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXReleaseSession(loader, session4);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // idle pooled sessions are closed by MFXUnload
+    if (session5)
+        MFXClose(session5);
+    MFXUnload(loader);
+}
+
+static void SetSharedLoader(bool bEnable) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_SHARED_LOADER", bEnable ? "ON" : nullptr);
+#else
+    if (bEnable)
+        setenv("ONEVPL_DISPATCHER_SHARED_LOADER", "ON", 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_SHARED_LOADER");
+#endif
+}
+
+TEST(Dispatcher_Stub_CreateSession, SharedLoaderReusesCaps) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetSharedLoader(true);
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader1 = MFXLoad();
+    EXPECT_FALSE(loader1 == nullptr);
+    mfxLoader loader2 = MFXLoad();
+    EXPECT_FALSE(loader2 == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader1, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = SetConfigImpl(loader2, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc1 = nullptr, *implDesc2 = nullptr;
+    sts = MFXEnumImplementations(loader1, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXEnumImplementations(loader2, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // caps were queried once and are shared by both handles
+    EXPECT_FALSE(implDesc1 == nullptr);
+    EXPECT_EQ(implDesc1, implDesc2);
+
+    MFXDispReleaseImplDescription(loader1, implDesc1);
+    MFXDispReleaseImplDescription(loader2, implDesc2);
+
+    // each handle can create sessions after the other one is unloaded
+    MFXUnload(loader1);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader2, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader2);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "shared loader created");
+    CheckOutputLog(outputLog, "shared loader reused");
+
+    SetSharedLoader(false);
+}
+
+TEST(Dispatcher_Stub_CreateSession, SharedLoaderKeepsFiltersPerHandle) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetSharedLoader(true);
+
+    mfxLoader loader1 = MFXLoad();
+    EXPECT_FALSE(loader1 == nullptr);
+    mfxLoader loader2 = MFXLoad();
+    EXPECT_FALSE(loader2 == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader1, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // filter on second handle does not match any implementation
+    mfxConfig cfg = MFXCreateConfig(loader2);
+    mfxVariant var;
+    var.Type     = MFX_VARIANT_TYPE_U32;
+    var.Data.U32 = 0xFFFFFFFF;
+    sts          = MFXSetConfigFilterProperty(cfg, (const mfxU8 *)"mfxImplDescription.VendorID", var);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader2, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    sts = MFXCreateSession(loader1, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader2);
+    MFXUnload(loader1);
+
+    SetSharedLoader(false);
+}
+
+TEST(Dispatcher_Stub_CreateSession, ConcurrentEnumAndCreateSession) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // first call from each thread may need to load and filter libraries
+    const int numThreads = 4;
+    std::vector<mfxStatus> enumSts(numThreads, MFX_ERR_UNKNOWN);
+    std::vector<mfxStatus> createSts(numThreads, MFX_ERR_UNKNOWN);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+            mfxImplementedFunctions *implFuncs = nullptr;
+            enumSts[t]                         = MFXEnumImplementations(loader,
+                                                0,
+                                                MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                                (mfxHDL *)&implFuncs);
+            if (implFuncs)
+                MFXDispReleaseImplDescription(loader, implFuncs);
+
+            mfxSession session = nullptr;
+            createSts[t]       = MFXCreateSession(loader, 0, &session);
+            if (session)
+                MFXClose(session);
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int t = 0; t < numThreads; t++) {
+        EXPECT_EQ(enumSts[t], MFX_ERR_NONE);
+        EXPECT_EQ(createSts[t], MFX_ERR_NONE);
+    }
+
+    MFXUnload(loader);
+}
+
+TEST(Dispatcher_Stub_CreateSession, AdapterRoundRobinPolicy) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_ADAPTER_POLICY", "ROUNDROBIN");
+#else
+    setenv("ONEVPL_DISPATCHER_ADAPTER_POLICY", "ROUNDROBIN", 1);
+#endif
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // stub does not report more than one adapter, so the order is unchanged
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "adapter policy -- round robin");
+    CheckOutputLog(outputLog, "adapter round robin --", false);
+
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable("ONEVPL_DISPATCHER_ADAPTER_POLICY", nullptr);
+#else
+    unsetenv("ONEVPL_DISPATCHER_ADAPTER_POLICY");
+#endif
+}
+
+TEST(Dispatcher_Stub_CreateSession, SetConfigFilterPropertiesBatch) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxU32 idImplName = 0, idCodec = 0, idDeviceID = 0;
+    mfxStatus sts =
+        MFXResolveConfigFilterProperty((const mfxU8 *)"mfxImplDescription.ImplName", &idImplName);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXResolveConfigFilterProperty(
+        (const mfxU8 *)"mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+        &idCodec);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    sts = MFXResolveConfigFilterProperty(
+        (const mfxU8 *)"mfxImplDescription.mfxDeviceDescription.DeviceID",
+        &idDeviceID);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_NE(idImplName, idCodec);
+
+    mfxU32 idUnknown = 0;
+    sts = MFXResolveConfigFilterProperty((const mfxU8 *)"mfxImplDescription.Unknown", &idUnknown);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxConfig cfg = MFXCreateConfig(loader);
+    EXPECT_FALSE(cfg == nullptr);
+
+    mfxConfigFilterProperty props[2] = {};
+    props[0].PropertyID     = idImplName;
+    props[0].Value.Type     = MFX_VARIANT_TYPE_PTR;
+    props[0].Value.Data.Ptr = (mfxHDL) "Stub Implementation";
+    props[1].PropertyID     = idCodec;
+    props[1].Value.Type     = MFX_VARIANT_TYPE_U32;
+    props[1].Value.Data.U32 = MFX_CODEC_HEVC;
+
+    sts = MFXSetConfigFilterProperties(cfg, props, 2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    // wrong type and unknown ID are rejected
+    props[1].PropertyID = idImplName;
+    props[1].Value.Type = MFX_VARIANT_TYPE_U16;
+    sts                 = MFXSetConfigFilterProperties(cfg, &props[1], 1);
+    EXPECT_EQ(sts, MFX_ERR_UNSUPPORTED);
+
+    props[0].PropertyID = 0xFFFFFFFF;
+    sts                 = MFXSetConfigFilterProperties(cfg, props, 1);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    sts = MFXSetConfigFilterProperties(cfg, nullptr, 1);
+    EXPECT_EQ(sts, MFX_ERR_NULL_PTR);
+
+    // DeviceID accepts both U16 and string values with the same ID
+    props[0].PropertyID     = idDeviceID;
+    props[0].Value.Type     = MFX_VARIANT_TYPE_PTR;
+    props[0].Value.Data.Ptr = (mfxHDL) "0000";
+    sts                     = MFXSetConfigFilterProperties(cfg, props, 1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    props[0].Value.Type     = MFX_VARIANT_TYPE_U16;
+    props[0].Value.Data.U16 = 0;
+    sts                     = MFXSetConfigFilterProperties(cfg, props, 1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    MFXUnload(loader);
+}
+
+// only the config which changed since the last enumeration should be checked again
+TEST(Dispatcher_Stub_EnumImpls, RevalidateOnlyChangedConfig) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxConfig cfg = MFXCreateConfig(loader);
+    EXPECT_FALSE(cfg == nullptr);
+
+    sts = SetConfigFilterProperty<mfxU32>(loader,
+                                          cfg,
+                                          "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+                                          MFX_CODEC_AVC);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxImplDescription *implDesc = nullptr;
+    sts = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (implDesc)
+        MFXDispReleaseImplDescription(loader, implDesc);
+
+    std::string outputLogFirst;
+    GetOutputLog(outputLogFirst);
+
+    // change the codec filter - Impl filter in the first config is unchanged
+    CaptureOutputLog(true);
+
+    sts = SetConfigFilterProperty<mfxU32>(loader,
+                                          cfg,
+                                          "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+                                          MFX_CODEC_HEVC);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    implDesc = nullptr;
+    sts = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (implDesc)
+        MFXDispReleaseImplDescription(loader, implDesc);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+
+    // changed config must still be applied
+    sts = SetConfigFilterProperty<mfxU32>(loader,
+                                          cfg,
+                                          "mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+                                          MFX_CODEC_VP9);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    implDesc = nullptr;
+    sts = MFXEnumImplementations(loader, 0, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL *)&implDesc);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    MFXUnload(loader);
+
+    CheckOutputLog(outputLogFirst, ", 0 unchanged");
+    CheckOutputLog(outputLog, "revalidated");
+    CheckOutputLog(outputLog, ", 0 unchanged", false);
+}
+
+struct AsyncLoadResult {
+    mfxLoader loader;
+    mfxStatus sts;
+    mfxU32 numCalls;
+};
+
+static void MFX_CDECL OnAsyncLoadDone(mfxLoader loader, mfxStatus sts, mfxHDL userData) {
+    AsyncLoadResult *result = (AsyncLoadResult *)userData;
+
+    result->loader = loader;
+    result->sts    = sts;
+    result->numCalls++;
+}
+
+TEST(Dispatcher_Stub_CreateSession, LoadAsyncCallsCallbackAndCreatesSession) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    AsyncLoadResult result = {};
+    result.sts             = MFX_ERR_UNKNOWN;
+
+    mfxLoader loader = MFXLoadAsync(OnAsyncLoadDone, &result);
+    EXPECT_FALSE(loader == nullptr);
+
+    // filters may be set while loading, these wait for the background thread
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXLoadWait(loader, MFX_INFINITE);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // callback has returned once MFXLoadWait() succeeds
+    EXPECT_EQ(result.numCalls, 1u);
+    EXPECT_EQ(result.sts, MFX_ERR_NONE);
+    EXPECT_EQ(result.loader, loader);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader);
+
+    // loader created without the callback, unloaded without waiting
+    loader = MFXLoadAsync(nullptr, nullptr);
+    EXPECT_FALSE(loader == nullptr);
+    MFXUnload(loader);
+
+    // loaders created with MFXLoad() do not wait
+    loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+    sts = MFXLoadWait(loader, 0);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    MFXUnload(loader);
+
+    sts = MFXLoadWait(nullptr, 0);
+    EXPECT_EQ(sts, MFX_ERR_NULL_PTR);
+}
+
+TEST(Dispatcher_Stub_CreateSession, SessionsShareLibraryFunctionTable) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    const int numSessions = 8;
+    std::vector<mfxSession> sessions(numSessions, nullptr);
+    for (int i = 0; i < numSessions; i++) {
+        sts = MFXCreateSession(loader, 0, &sessions[i]);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+    }
+
+    // closing sessions in creation order must keep the library usable by the others
+    for (int i = 0; i < numSessions; i++) {
+        if (!sessions[i])
+            continue;
+
+        for (int j = i; j < numSessions; j++) {
+            mfxVersion ver = {};
+            sts            = MFXQueryVersion(sessions[j], &ver);
+            EXPECT_EQ(sts, MFX_ERR_NONE);
+            EXPECT_GE(ver.Major, 2);
+        }
+
+        sts = MFXClose(sessions[i]);
+        EXPECT_EQ(sts, MFX_ERR_NONE);
+    }
+
+    // library is reloaded after the last session was closed
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader);
+}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+static void SetSessionStats(bool bEnable) {
+    if (bEnable)
+        setenv("ONEVPL_DISPATCHER_SESSION_STATS", "ON", 1);
+    else
+        unsetenv("ONEVPL_DISPATCHER_SESSION_STATS");
+}
+
+TEST(Dispatcher_Stub_CreateSession, SessionStatsCountCalls) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    SetSessionStats(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    const mfxU32 numEncodeCalls = 5;
+    for (mfxU32 i = 0; i < numEncodeCalls; i++)
+        MFXVideoENCODE_EncodeFrameAsync(session, nullptr, nullptr, nullptr, nullptr);
+    MFXVideoCORE_SyncOperation(session, nullptr, 0);
+
+    mfxFrameSurface1 *surface = nullptr;
+    MFXMemory_GetSurfaceForEncode(session, &surface);
+
+    mfxDispatcherSessionStats stats = {};
+    sts                             = MFXDispGetSessionStats(session, &stats);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    EXPECT_EQ(stats.NumFunctions, (mfxU32)MFX_DISPSTATS_NUM_FUNCTIONS);
+
+    const mfxDispatcherCallStats &enc = stats.Calls[MFX_DISPSTATS_ENCODE_FRAME_ASYNC];
+    EXPECT_EQ(enc.NumCalls, numEncodeCalls);
+
+    mfxU64 numHistCalls = 0;
+    for (mfxU32 i = 0; i < MFX_DISPSTATS_NUM_BUCKETS; i++)
+        numHistCalls += enc.Histogram[i];
+    EXPECT_EQ(numHistCalls, numEncodeCalls);
+
+    EXPECT_EQ(stats.Calls[MFX_DISPSTATS_SYNC_OPERATION].NumCalls, 1u);
+    EXPECT_EQ(stats.Calls[MFX_DISPSTATS_GET_SURFACE_FOR_ENCODE].NumCalls, 1u);
+    EXPECT_EQ(stats.Calls[MFX_DISPSTATS_DECODE_FRAME_ASYNC].NumCalls, 0u);
+
+    sts = MFXDispGetSessionStats(session, nullptr);
+    EXPECT_EQ(sts, MFX_ERR_NULL_PTR);
+
+    MFXClose(session);
+
+    // sessions created without the environment variable do not collect stats
+    SetSessionStats(false);
+
+    sts = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    sts = MFXDispGetSessionStats(session, &stats);
+    EXPECT_EQ(sts, MFX_ERR_UNSUPPORTED);
+
+    MFXClose(session);
+    MFXUnload(loader);
+}
+#endif
+
+#ifdef ONEVPL_EXPERIMENTAL
+// return true if the log reports that the 2.x stub library was skipped by the device prefilter
+// the 1.x stub does not report an extended device ID, so it is skipped in both cases
+static bool StubSkippedByDevicePrefilter(const std::string &outputLog) {
+    const std::string msg = "device prefilter -- no matching device in ";
+
+    size_t pos = outputLog.find(msg);
+    while (pos != std::string::npos) {
+        std::string line = outputLog.substr(pos, outputLog.find('\n', pos) - pos);
+        if (line.find("vplstubrt64") != std::string::npos)
+            return true;
+        pos = outputLog.find(msg, pos + 1);
+    }
+
+    return false;
+}
+
+TEST(Dispatcher_Stub_CreateSession, DevicePrefilterSkipsUnmatchedLibrary) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    CaptureOutputLog(true);
+
+    // stub reports DRMRenderNodeNum = 130
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    SetConfigFilterProperty<mfxU32>(loader, "mfxExtendedDeviceId.DRMRenderNodeNum", 131);
+
+    mfxSession session = nullptr;
+    sts                = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NOT_FOUND);
+
+    MFXUnload(loader);
+
+    std::string outputLogSkipped;
+    GetOutputLog(outputLogSkipped);
+
+    // matching device is found with the prefilter and the session is created
+    CaptureOutputLog(true);
+
+    loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    SetConfigFilterProperty<mfxU32>(loader, "mfxExtendedDeviceId.DRMRenderNodeNum", 130);
+
+    sts = MFXCreateSession(loader, 0, &session);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session)
+        MFXClose(session);
+
+    MFXUnload(loader);
+
+    std::string outputLogMatched;
+    GetOutputLog(outputLogMatched);
+
+    EXPECT_TRUE(StubSkippedByDevicePrefilter(outputLogSkipped));
+    EXPECT_FALSE(StubSkippedByDevicePrefilter(outputLogMatched));
+}
+#endif
+
+static void SetAdmissionEnv(const char *name, const char *value) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariable(name, value);
+#else
+    if (value)
+        setenv(name, value, 1);
+    else
+        unsetenv(name);
+#endif
+}
+
+// enable admission control with a ledger private to this test process
+static std::string EnableAdmissionControl(const char *budget, const char *policy) {
+#if defined(_WIN32) || defined(_WIN64)
+    std::string name = "onevpl-admission-test-" + std::to_string(GetCurrentProcessId());
+#else
+    std::string name = "onevpl-admission-test-" + std::to_string(getpid());
+#endif
+
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_BUDGET", budget);
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_POLICY", policy);
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_NAME", name.c_str());
+
+    return name;
+}
+
+static void DisableAdmissionControl(const std::string &name) {
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_BUDGET", nullptr);
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_POLICY", nullptr);
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_NAME", nullptr);
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_TIMEOUT", nullptr);
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    // stub has no known adapter, so all sessions use the shared ledger
+    std::remove(("/dev/shm/" + name + "-any").c_str());
+#endif
+}
+
+// declare 1080p30 AVC sessions, cost 63
+static void SetAdmissionSessionCost(mfxLoader loader) {
+    SetConfigFilterProperty<mfxU32>(loader, "SessionCost.Width", 1920);
+    SetConfigFilterProperty<mfxU32>(loader, "SessionCost.Height", 1080);
+    SetConfigFilterProperty<mfxU32>(loader, "SessionCost.FrameRate", 30);
+    SetConfigFilterProperty<mfxU32>(loader, "SessionCost.CodecID", MFX_CODEC_AVC);
+}
+
+TEST(Dispatcher_Stub_CreateSession, AdmissionControlFailsOverBudget) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    std::string name = EnableAdmissionControl("100", "FAIL");
+
+    CaptureOutputLog(true);
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    SetAdmissionSessionCost(loader);
+
+    mfxSession session1 = nullptr;
+    sts                 = MFXCreateSession(loader, 0, &session1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // second session does not fit into the budget until the first one is closed
+    mfxSession session2 = nullptr;
+    sts                 = MFXCreateSession(loader, 0, &session2);
+    EXPECT_EQ(sts, MFX_ERR_ABORTED);
+
+    if (session1)
+        MFXClose(session1);
+
+    sts = MFXCreateSession(loader, 0, &session2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    if (session2)
+        MFXClose(session2);
+
+    MFXUnload(loader);
+
+    std::string outputLog;
+    GetOutputLog(outputLog);
+    CheckOutputLog(outputLog, "admission control -- budget 100, policy fail");
+    CheckOutputLog(outputLog, "admission control -- adapter -1 used 63 + 63 > 100");
+
+    DisableAdmissionControl(name);
+}
+
+TEST(Dispatcher_Stub_CreateSession, AdmissionControlQueuesUntilSessionCloses) {
+    SKIP_IF_DISP_STUB_DISABLED();
+
+    std::string name = EnableAdmissionControl("100", "QUEUE");
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_TIMEOUT", "50");
+
+    mfxLoader loader = MFXLoad();
+    EXPECT_FALSE(loader == nullptr);
+
+    mfxStatus sts = SetConfigImpl(loader, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    SetAdmissionSessionCost(loader);
+
+    mfxSession session1 = nullptr;
+    sts                 = MFXCreateSession(loader, 0, &session1);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    // nothing is closed, so the queued session times out
+    mfxSession session2 = nullptr;
+    sts                 = MFXCreateSession(loader, 0, &session2);
+    EXPECT_EQ(sts, MFX_ERR_ABORTED);
+
+    // queued session is admitted once the first one is closed by another thread
+    // timeout is read when the loader is created
+    SetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_TIMEOUT", "10000");
+
+    mfxLoader loader2 = MFXLoad();
+    EXPECT_FALSE(loader2 == nullptr);
+
+    sts = SetConfigImpl(loader2, MFX_IMPL_TYPE_STUB);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+    SetAdmissionSessionCost(loader2);
+
+    std::thread closer([session1]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (session1)
+            MFXClose(session1);
+    });
+
+    sts = MFXCreateSession(loader2, 0, &session2);
+    EXPECT_EQ(sts, MFX_ERR_NONE);
+
+    closer.join();
+
+    if (session2)
+        MFXClose(session2);
+
+    MFXUnload(loader2);
+    MFXUnload(loader);
+
+    DisableAdmissionControl(name);
+}
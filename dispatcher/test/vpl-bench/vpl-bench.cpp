@@ -0,0 +1,636 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+// dispatcher benchmark suite based on the stub runtime (hermetic, no HW required)
+// measures:
+//   - MFXLoad / MFXUnload
+//   - creating N configs with filter properties
+//   - MFXEnumImplementations with K copies of the stub runtime in the search path
+//   - MFXCreateSession, cold (first session from a new loader) and warm
+//   - per-call overhead of the dispatcher for per-frame functions, compared against
+//     calling the same runtime entry points directly
+// stub runtime must be in ONEVPL_SEARCH_PATH (all its functions return immediately)
+// results can be printed as text, CSV, or JSON
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <Windows.h>
+#else
+    #include <dlfcn.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "vpl/mfx.h"
+
+#define STUB_IMPL_NAME "Stub Implementation"
+
+#define DEFAULT_NUM_CALLS    10000000
+#define DEFAULT_NUM_ITERS    100
+#define DEFAULT_NUM_CONFIGS  16
+#define DEFAULT_NUM_RUNTIMES 4
+
+// per-frame calls are split into this many samples to report min/max
+#define NUM_CALL_SAMPLES 10
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define PATH_SEPARATOR      "\\"
+    #define SEARCH_PATH_DELIMIT ";"
+#else
+    #define PATH_SEPARATOR      "/"
+    #define SEARCH_PATH_DELIMIT ":"
+#endif
+
+enum OutputFormat {
+    OUTPUT_FORMAT_TEXT = 0,
+    OUTPUT_FORMAT_CSV,
+    OUTPUT_FORMAT_JSON,
+};
+
+// one benchmark result, all times are in nanoseconds per call
+struct BenchResult {
+    std::string name;
+    mfxU32 param; // N configs, K runtimes, or 0 if not applicable
+    mfxU32 numSamples;
+    mfxU32 callsPerSample;
+    double meanTime;
+    double minTime;
+    double maxTime;
+};
+
+// runtime entry points used by the benchmark
+struct BenchFunctions {
+    decltype(MFXInitialize) *pInitialize;
+    decltype(MFXClose) *pClose;
+    decltype(MFXVideoDECODE_DecodeFrameAsync) *pDecodeFrameAsync;
+    decltype(MFXVideoENCODE_EncodeFrameAsync) *pEncodeFrameAsync;
+    decltype(MFXVideoVPP_RunFrameVPPAsync) *pRunFrameVPPAsync;
+    decltype(MFXVideoCORE_SyncOperation) *pSyncOperation;
+};
+
+static void *LoadRuntime(const mfxChar *libPath, BenchFunctions *funcs) {
+#if defined(_WIN32) || defined(_WIN64)
+    HMODULE hLib = LoadLibraryA(libPath);
+    if (!hLib)
+        return nullptr;
+    #define BENCH_GET_ADDR(name) GetProcAddress(hLib, name)
+#else
+    void *hLib = dlopen(libPath, RTLD_LOCAL | RTLD_NOW);
+    if (!hLib)
+        return nullptr;
+    #define BENCH_GET_ADDR(name) dlsym(hLib, name)
+#endif
+
+    funcs->pInitialize = (decltype(MFXInitialize) *)BENCH_GET_ADDR("MFXInitialize");
+    funcs->pClose      = (decltype(MFXClose) *)BENCH_GET_ADDR("MFXClose");
+    funcs->pDecodeFrameAsync = (decltype(MFXVideoDECODE_DecodeFrameAsync) *)BENCH_GET_ADDR(
+        "MFXVideoDECODE_DecodeFrameAsync");
+    funcs->pEncodeFrameAsync = (decltype(MFXVideoENCODE_EncodeFrameAsync) *)BENCH_GET_ADDR(
+        "MFXVideoENCODE_EncodeFrameAsync");
+    funcs->pRunFrameVPPAsync =
+        (decltype(MFXVideoVPP_RunFrameVPPAsync) *)BENCH_GET_ADDR("MFXVideoVPP_RunFrameVPPAsync");
+    funcs->pSyncOperation =
+        (decltype(MFXVideoCORE_SyncOperation) *)BENCH_GET_ADDR("MFXVideoCORE_SyncOperation");
+
+#undef BENCH_GET_ADDR
+
+    return (void *)hLib;
+}
+
+static void UnloadRuntime(void *hLib) {
+#if defined(_WIN32) || defined(_WIN64)
+    FreeLibrary((HMODULE)hLib);
+#else
+    dlclose(hLib);
+#endif
+}
+
+// return elapsed time in nanoseconds
+static double ElapsedTime(std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// run sample() numSamples times, each call returns the average time per call in nanoseconds
+template <typename F>
+static BenchResult RunBench(const char *name,
+                            mfxU32 param,
+                            mfxU32 numSamples,
+                            mfxU32 callsPerSample,
+                            F sample) {
+    BenchResult result    = {};
+    result.name           = name;
+    result.param          = param;
+    result.numSamples     = numSamples;
+    result.callsPerSample = callsPerSample;
+
+    double totalTime = 0;
+    for (mfxU32 i = 0; i < numSamples; i++) {
+        double t = sample();
+
+        totalTime += t;
+        result.minTime = (i == 0 ? t : std::min(result.minTime, t));
+        result.maxTime = (i == 0 ? t : std::max(result.maxTime, t));
+    }
+    result.meanTime = totalTime / numSamples;
+
+    return result;
+}
+
+// return average time per call in nanoseconds
+template <typename F>
+static double TimeCalls(mfxU32 numCalls, F call) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (mfxU32 i = 0; i < numCalls; i++)
+        call();
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    return ElapsedTime(start, end) / numCalls;
+}
+
+static mfxStatus SetStubImplNameFilter(mfxLoader loader) {
+    mfxConfig config = MFXCreateConfig(loader);
+    if (!config)
+        return MFX_ERR_NULL_PTR;
+
+    mfxVariant var      = {};
+    var.Version.Version = MFX_VARIANT_VERSION;
+    var.Type            = MFX_VARIANT_TYPE_PTR;
+    var.Data.Ptr        = (mfxHDL)STUB_IMPL_NAME;
+
+    return MFXSetConfigFilterProperty(config, (const mfxU8 *)"mfxImplDescription.ImplName", var);
+}
+
+// return the number of implementations enumerated
+static mfxU32 EnumAllImplementations(mfxLoader loader) {
+    mfxU32 idx = 0;
+    while (1) {
+        mfxImplDescription *implDesc = nullptr;
+        mfxStatus sts                = MFXEnumImplementations(loader,
+                                               idx,
+                                               MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                               reinterpret_cast<mfxHDL *>(&implDesc));
+        if (sts != MFX_ERR_NONE || implDesc == nullptr)
+            break;
+
+        MFXDispReleaseImplDescription(loader, implDesc);
+        idx++;
+    }
+
+    return idx;
+}
+
+static void SetSearchPath(const char *searchPath) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetEnvironmentVariableA("ONEVPL_SEARCH_PATH", searchPath);
+#else
+    if (searchPath)
+        setenv("ONEVPL_SEARCH_PATH", searchPath, 1);
+    else
+        unsetenv("ONEVPL_SEARCH_PATH");
+#endif
+}
+
+static bool MakeDir(const std::string &dirName) {
+#if defined(_WIN32) || defined(_WIN64)
+    return (CreateDirectoryA(dirName.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS);
+#else
+    return (mkdir(dirName.c_str(), 0700) == 0 || errno == EEXIST);
+#endif
+}
+
+static void RemoveFile(const std::string &fileName) {
+#if defined(_WIN32) || defined(_WIN64)
+    DeleteFileA(fileName.c_str());
+#else
+    unlink(fileName.c_str());
+#endif
+}
+
+static void RemoveDir(const std::string &dirName) {
+#if defined(_WIN32) || defined(_WIN64)
+    RemoveDirectoryA(dirName.c_str());
+#else
+    rmdir(dirName.c_str());
+#endif
+}
+
+static bool CopyRuntimeFile(const std::string &srcName, const std::string &dstName) {
+    FILE *fSrc = fopen(srcName.c_str(), "rb");
+    if (!fSrc)
+        return false;
+
+    FILE *fDst = fopen(dstName.c_str(), "wb");
+    if (!fDst) {
+        fclose(fSrc);
+        return false;
+    }
+
+    bool bSuccess = true;
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fSrc)) > 0) {
+        if (fwrite(buf, 1, n, fDst) != n) {
+            bSuccess = false;
+            break;
+        }
+    }
+
+    fclose(fSrc);
+    fclose(fDst);
+
+    return bSuccess;
+}
+
+// K copies of the stub runtime, each in its own directory, so that the dispatcher
+//   loads and queries every one of them as a separate implementation
+class StagedRuntimes {
+public:
+    StagedRuntimes() : m_rootDir(), m_dirs(), m_files() {}
+
+    ~StagedRuntimes() {
+        Release();
+    }
+
+    bool Create(const std::string &stubPath, mfxU32 numRuntimes) {
+        size_t f            = stubPath.find_last_of("/\\");
+        std::string libName = (f == std::string::npos ? stubPath : stubPath.substr(f + 1));
+
+#if defined(_WIN32) || defined(_WIN64)
+        char tmpPath[MAX_PATH] = {};
+        if (!GetTempPathA(MAX_PATH, tmpPath))
+            return false;
+        m_rootDir = std::string(tmpPath) + "vpl-bench-" + std::to_string(GetCurrentProcessId());
+#else
+        const char *tmpPath = getenv("TMPDIR");
+        m_rootDir =
+            std::string(tmpPath ? tmpPath : "/tmp") + "/vpl-bench-" + std::to_string(getpid());
+#endif
+        if (!MakeDir(m_rootDir)) {
+            m_rootDir.clear();
+            return false;
+        }
+
+        for (mfxU32 i = 0; i < numRuntimes; i++) {
+            std::string dirName = m_rootDir + PATH_SEPARATOR + "rt" + std::to_string(i);
+            if (!MakeDir(dirName))
+                return false;
+            m_dirs.push_back(dirName);
+
+            std::string fileName = dirName + PATH_SEPARATOR + libName;
+            if (!CopyRuntimeFile(stubPath, fileName))
+                return false;
+            m_files.push_back(fileName);
+        }
+
+        return true;
+    }
+
+    std::string GetSearchPath() const {
+        std::string searchPath;
+        for (const std::string &dirName : m_dirs) {
+            if (!searchPath.empty())
+                searchPath += SEARCH_PATH_DELIMIT;
+            searchPath += dirName;
+        }
+
+        return searchPath;
+    }
+
+    void Release() {
+        for (const std::string &fileName : m_files)
+            RemoveFile(fileName);
+        for (const std::string &dirName : m_dirs)
+            RemoveDir(dirName);
+        if (!m_rootDir.empty())
+            RemoveDir(m_rootDir);
+
+        m_files.clear();
+        m_dirs.clear();
+        m_rootDir.clear();
+    }
+
+private:
+    std::string m_rootDir;
+    std::vector<std::string> m_dirs;
+    std::vector<std::string> m_files;
+};
+
+static void PrintResults(const std::vector<BenchResult> &results,
+                         OutputFormat format,
+                         mfxU32 numImplsEnum) {
+    if (format == OUTPUT_FORMAT_CSV) {
+        printf("name,param,samples,calls_per_sample,mean_ns,min_ns,max_ns\n");
+        for (const BenchResult &r : results) {
+            printf("%s,%u,%u,%u,%.2f,%.2f,%.2f\n",
+                   r.name.c_str(),
+                   r.param,
+                   r.numSamples,
+                   r.callsPerSample,
+                   r.meanTime,
+                   r.minTime,
+                   r.maxTime);
+        }
+    }
+    else if (format == OUTPUT_FORMAT_JSON) {
+        printf("{\n");
+        printf("  \"num_impls_enumerated\": %u,\n", numImplsEnum);
+        printf("  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult &r = results[i];
+            printf("    { \"name\": \"%s\", \"param\": %u, \"samples\": %u, "
+                   "\"calls_per_sample\": %u, \"mean_ns\": %.2f, \"min_ns\": %.2f, "
+                   "\"max_ns\": %.2f }%s\n",
+                   r.name.c_str(),
+                   r.param,
+                   r.numSamples,
+                   r.callsPerSample,
+                   r.meanTime,
+                   r.minTime,
+                   r.maxTime,
+                   (i + 1 < results.size() ? "," : ""));
+        }
+        printf("  ]\n");
+        printf("}\n");
+    }
+    else {
+        printf("vpl-bench -- implementations enumerated = %u\n", numImplsEnum);
+        for (const BenchResult &r : results) {
+            printf("vpl-bench -- %-48s : param = %4u, mean = %12.2f ns, min = %12.2f ns, "
+                   "max = %12.2f ns\n",
+                   r.name.c_str(),
+                   r.param,
+                   r.meanTime,
+                   r.minTime,
+                   r.maxTime);
+        }
+    }
+}
+
+static void PrintUsage() {
+    printf("Usage: vpl-bench [options]\n");
+    printf("       -n calls .......... number of calls per per-frame function (default = %d)\n",
+           DEFAULT_NUM_CALLS);
+    printf("       -i iters .......... number of iterations for startup benchmarks (default = "
+           "%d)\n",
+           DEFAULT_NUM_ITERS);
+    printf("       -c configs ........ number of configs to create (default = %d)\n",
+           DEFAULT_NUM_CONFIGS);
+    printf("       -k runtimes ....... number of stub runtimes to enumerate (default = %d)\n",
+           DEFAULT_NUM_RUNTIMES);
+    printf("       -format fmt ....... output format: text, csv, json (default = text)\n");
+}
+
+int main(int argc, char *argv[]) {
+    mfxU32 numCalls    = DEFAULT_NUM_CALLS;
+    mfxU32 numIters    = DEFAULT_NUM_ITERS;
+    mfxU32 numConfigs  = DEFAULT_NUM_CONFIGS;
+    mfxU32 numRuntimes = DEFAULT_NUM_RUNTIMES;
+    OutputFormat fmt   = OUTPUT_FORMAT_TEXT;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            i++;
+            numCalls = (mfxU32)atol(argv[i]);
+        }
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            i++;
+            numIters = (mfxU32)atol(argv[i]);
+        }
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            i++;
+            numConfigs = (mfxU32)atol(argv[i]);
+        }
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            i++;
+            numRuntimes = (mfxU32)atol(argv[i]);
+        }
+        else if (!strcmp(argv[i], "-format") && i + 1 < argc) {
+            i++;
+            if (!strcmp(argv[i], "text")) {
+                fmt = OUTPUT_FORMAT_TEXT;
+            }
+            else if (!strcmp(argv[i], "csv")) {
+                fmt = OUTPUT_FORMAT_CSV;
+            }
+            else if (!strcmp(argv[i], "json")) {
+                fmt = OUTPUT_FORMAT_JSON;
+            }
+            else {
+                printf("Error - invalid output format\n\n");
+                PrintUsage();
+                return -1;
+            }
+        }
+        else {
+            printf("Error - invalid argument\n\n");
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    if (numCalls < NUM_CALL_SAMPLES || numIters == 0) {
+        printf("Error - number of calls must be >= %d and number of iterations must be > 0\n",
+               NUM_CALL_SAMPLES);
+        return -1;
+    }
+
+    std::vector<BenchResult> results;
+
+    // locate stub runtime
+    mfxLoader loader = MFXLoad();
+    if (loader == nullptr) {
+        printf("Error - loader is null - no libraries found\n");
+        return -1;
+    }
+    SetStubImplNameFilter(loader);
+
+    mfxChar *implPath = nullptr;
+    mfxStatus sts     = MFXEnumImplementations(loader,
+                                               0,
+                                               MFX_IMPLCAPS_IMPLPATH,
+                                               reinterpret_cast<mfxHDL *>(&implPath));
+    if (sts != MFX_ERR_NONE || implPath == nullptr) {
+        printf("Error - stub runtime not found (check ONEVPL_SEARCH_PATH)\n");
+        MFXUnload(loader);
+        return -1;
+    }
+
+    std::string stubPath = implPath;
+    MFXDispReleaseImplDescription(loader, implPath);
+    MFXUnload(loader);
+
+    std::chrono::steady_clock::time_point start, end;
+
+    // MFXLoad/MFXUnload
+    results.push_back(RunBench("MFXLoad", 0, numIters, 1, [&]() {
+        start               = std::chrono::steady_clock::now();
+        mfxLoader newLoader = MFXLoad();
+        end                 = std::chrono::steady_clock::now();
+        MFXUnload(newLoader);
+        return ElapsedTime(start, end);
+    }));
+
+    results.push_back(RunBench("MFXUnload", 0, numIters, 1, [&]() {
+        mfxLoader newLoader = MFXLoad();
+        start               = std::chrono::steady_clock::now();
+        MFXUnload(newLoader);
+        end = std::chrono::steady_clock::now();
+        return ElapsedTime(start, end);
+    }));
+
+    // create N configs, each with one filter property
+    results.push_back(RunBench("MFXCreateConfig", numConfigs, numIters, 1, [&]() {
+        mfxLoader newLoader = MFXLoad();
+        start               = std::chrono::steady_clock::now();
+        for (mfxU32 i = 0; i < numConfigs; i++)
+            SetStubImplNameFilter(newLoader);
+        end = std::chrono::steady_clock::now();
+        MFXUnload(newLoader);
+        return ElapsedTime(start, end);
+    }));
+
+    // first session from a new loader (load, query caps, filter, create session)
+    results.push_back(RunBench("MFXCreateSession (cold)", 0, numIters, 1, [&]() {
+        mfxSession session  = nullptr;
+        start               = std::chrono::steady_clock::now();
+        mfxLoader newLoader = MFXLoad();
+        SetStubImplNameFilter(newLoader);
+        MFXCreateSession(newLoader, 0, &session);
+        end = std::chrono::steady_clock::now();
+        if (session)
+            MFXClose(session);
+        MFXUnload(newLoader);
+        return ElapsedTime(start, end);
+    }));
+
+    // additional sessions from a loader which has already enumerated implementations
+    loader = MFXLoad();
+    SetStubImplNameFilter(loader);
+    EnumAllImplementations(loader);
+    results.push_back(RunBench("MFXCreateSession (warm)", 0, numIters, 1, [&]() {
+        mfxSession session = nullptr;
+        start              = std::chrono::steady_clock::now();
+        MFXCreateSession(loader, 0, &session);
+        end = std::chrono::steady_clock::now();
+        if (session)
+            MFXClose(session);
+        return ElapsedTime(start, end);
+    }));
+
+    // per-frame dispatch overhead
+    BenchFunctions funcs = {};
+    void *hLib           = LoadRuntime(stubPath.c_str(), &funcs);
+
+    if (!hLib || !funcs.pInitialize || !funcs.pClose || !funcs.pDecodeFrameAsync ||
+        !funcs.pEncodeFrameAsync || !funcs.pRunFrameVPPAsync || !funcs.pSyncOperation) {
+        printf("Error - failed to load stub runtime entry points\n");
+        if (hLib)
+            UnloadRuntime(hLib);
+        MFXUnload(loader);
+        return -1;
+    }
+
+    mfxSession dispSession = nullptr;
+    sts                    = MFXCreateSession(loader, 0, &dispSession);
+
+    mfxSession directSession        = nullptr;
+    mfxInitializationParam vplParam = {};
+    vplParam.AccelerationMode       = MFX_ACCEL_MODE_NA;
+    if (sts == MFX_ERR_NONE)
+        sts = (*funcs.pInitialize)(vplParam, &directSession);
+
+    if (sts != MFX_ERR_NONE) {
+        printf("Error - failed to create session (sts = %d)\n", sts);
+        if (dispSession)
+            MFXClose(dispSession);
+        UnloadRuntime(hLib);
+        MFXUnload(loader);
+        return -1;
+    }
+
+    mfxU32 callsPerSample = numCalls / NUM_CALL_SAMPLES;
+
+#define BENCH_PER_FRAME(name, dispCall, directCall)                                    \
+    results.push_back(RunBench("dispatch/" name, 0, NUM_CALL_SAMPLES, callsPerSample, [&]() { \
+        return TimeCalls(callsPerSample, [&]() {                                           \
+            dispCall;                                                                      \
+        });                                                                                \
+    }));                                                                                   \
+    results.push_back(RunBench("direct/" name, 0, NUM_CALL_SAMPLES, callsPerSample, [&]() {   \
+        return TimeCalls(callsPerSample, [&]() {                                           \
+            directCall;                                                                    \
+        });                                                                                \
+    }));
+
+    BENCH_PER_FRAME(
+        "MFXVideoDECODE_DecodeFrameAsync",
+        MFXVideoDECODE_DecodeFrameAsync(dispSession, nullptr, nullptr, nullptr, nullptr),
+        (*funcs.pDecodeFrameAsync)(directSession, nullptr, nullptr, nullptr, nullptr));
+
+    BENCH_PER_FRAME(
+        "MFXVideoENCODE_EncodeFrameAsync",
+        MFXVideoENCODE_EncodeFrameAsync(dispSession, nullptr, nullptr, nullptr, nullptr),
+        (*funcs.pEncodeFrameAsync)(directSession, nullptr, nullptr, nullptr, nullptr));
+
+    BENCH_PER_FRAME(
+        "MFXVideoVPP_RunFrameVPPAsync",
+        MFXVideoVPP_RunFrameVPPAsync(dispSession, nullptr, nullptr, nullptr, nullptr),
+        (*funcs.pRunFrameVPPAsync)(directSession, nullptr, nullptr, nullptr, nullptr));
+
+    BENCH_PER_FRAME("MFXVideoCORE_SyncOperation",
+                    MFXVideoCORE_SyncOperation(dispSession, nullptr, 0),
+                    (*funcs.pSyncOperation)(directSession, nullptr, 0));
+
+#undef BENCH_PER_FRAME
+
+    (*funcs.pClose)(directSession);
+    MFXClose(dispSession);
+
+    UnloadRuntime(hLib);
+    MFXUnload(loader);
+
+    // enumerate K copies of the stub runtime (search path is restored afterwards)
+    mfxU32 numImplsEnum = 0;
+    if (numRuntimes > 0) {
+        StagedRuntimes stagedRuntimes;
+        if (!stagedRuntimes.Create(stubPath, numRuntimes)) {
+            printf("Error - failed to copy stub runtime to temporary directory\n");
+            return -1;
+        }
+
+        const char *envSearchPath = getenv("ONEVPL_SEARCH_PATH");
+        std::string origSearchPath(envSearchPath ? envSearchPath : "");
+
+        SetSearchPath(stagedRuntimes.GetSearchPath().c_str());
+
+        results.push_back(RunBench("MFXEnumImplementations", numRuntimes, numIters, 1, [&]() {
+            mfxLoader newLoader = MFXLoad();
+            start               = std::chrono::steady_clock::now();
+            numImplsEnum        = EnumAllImplementations(newLoader);
+            end                 = std::chrono::steady_clock::now();
+            MFXUnload(newLoader);
+            return ElapsedTime(start, end);
+        }));
+
+        SetSearchPath(envSearchPath ? origSearchPath.c_str() : nullptr);
+    }
+
+    PrintResults(results, fmt, numImplsEnum);
+
+    return 0;
+}
@@ -234,6 +234,22 @@ int main(int argc, char *argv[]) {
 
     printf("\n");
 
+    // startup breakdown measured inside the dispatcher
+    mfxDispatcherTiming dispTiming = {};
+    sts                            = MFXDispQueryTiming(loader, &dispTiming);
+    if (sts == MFX_ERR_NONE) {
+        printf("  Dispatcher timing (%d dirs searched, %d libraries loaded):\n",
+               dispTiming.NumSearchDirs,
+               dispTiming.NumLibsLoaded);
+        printf("    SearchPaths        = % 8.2f msec\n", dispTiming.SearchPathsTime / 1000.0);
+        printf("    LoadLibs           = % 8.2f msec\n", dispTiming.LoadLibsTime / 1000.0);
+        printf("    QueryCaps          = % 8.2f msec\n", dispTiming.QueryCapsTime / 1000.0);
+        printf("    UpdateValidImpls   = % 8.2f msec\n", dispTiming.UpdateValidImplsTime / 1000.0);
+        printf("    PrioritizeImpls    = % 8.2f msec\n", dispTiming.PrioritizeImplsTime / 1000.0);
+        printf("    CreateSession      = % 8.2f msec\n", dispTiming.CreateSessionTime / 1000.0);
+        printf("\n");
+    }
+
     mfxVersion actualVersion = {};
 
     sts = MFXQueryVersion(session, &actualVersion);
@@ -24,14 +24,54 @@ mfxLoader MFXLoad() {
     // initialize logging if appropriate environment variables are set
     loaderCtx->InitDispatcherLog();
 
+    // enable caps cache if ONEVPL_DISPATCHER_CACHE_FILE is set
+    loaderCtx->InitCapsCache();
+
+    // enable fast start mode if ONEVPL_DISPATCHER_FAST_START_PATH is set
+    loaderCtx->InitFastStart();
+
+    // share library discovery with other loaders if ONEVPL_DISPATCHER_SHARED_LOADER is set
+    loaderCtx->InitSharedLoader();
+
+    // order hardware implementations by adapter if ONEVPL_DISPATCHER_ADAPTER_POLICY is set
+    loaderCtx->InitAdapterPolicy();
+
+    // limit sessions per adapter if ONEVPL_DISPATCHER_ADMISSION_BUDGET is set
+    loaderCtx->InitAdmissionControl();
+
     return (mfxLoader)loaderCtx;
 }
 
+// create loader and start loading and querying libraries on a background thread
+mfxLoader MFXLoadAsync(mfxLoadCallback callback, mfxHDL userData) {
+    mfxLoader loader = MFXLoad();
+    if (!loader)
+        return nullptr;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+    loaderCtx->StartAsyncLoad(callback, userData);
+
+    return loader;
+}
+
+// wait for load started by MFXLoadAsync() to finish
+mfxStatus MFXLoadWait(mfxLoader loader, mfxU32 waitMs) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    return loaderCtx->WaitAsyncLoad(waitMs);
+}
+
 // unload libraries, destroy all created mfxConfig objects, free other memory
 void MFXUnload(mfxLoader loader) {
     if (loader) {
         LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
 
+        // background load must finish before libraries are unloaded
+        loaderCtx->JoinAsyncLoad();
+
         loaderCtx->UnloadAllLibraries();
 
         loaderCtx->FreeConfigFilters();
@@ -54,6 +94,8 @@ mfxConfig MFXCreateConfig(mfxLoader loader) {
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    std::unique_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     try {
         configCtx = loaderCtx->AddConfigFilter();
     }
@@ -75,6 +117,8 @@ mfxStatus MFXSetConfigFilterProperty(mfxConfig config, const mfxU8 *name, mfxVar
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    std::unique_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     mfxStatus sts = configCtx->SetFilterProperty(name, value);
     if (sts)
         return sts;
@@ -86,20 +130,61 @@ mfxStatus MFXSetConfigFilterProperty(mfxConfig config, const mfxU8 *name, mfxVar
     return sts;
 }
 
-// iterate over available implementations
-// capabilities are returned in idesc
-mfxStatus MFXEnumImplementations(mfxLoader loader,
-                                 mfxU32 i,
-                                 mfxImplCapsDeliveryFormat format,
-                                 mfxHDL *idesc) {
-    if (!loader || !idesc)
+// map property name to ID for use with MFXSetConfigFilterProperties
+mfxStatus MFXResolveConfigFilterProperty(const mfxU8 *name, mfxU32 *propertyID) {
+    if (!name || !propertyID)
         return MFX_ERR_NULL_PTR;
 
-    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+    mfxI32 propIdx = -1;
+
+    mfxStatus sts = ConfigCtxVPL::ResolveFilterProperty(name, propIdx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    *propertyID = (mfxU32)propIdx;
+
+    return MFX_ERR_NONE;
+}
+
+// set several pre-parsed config properties, updating the loader once
+mfxStatus MFXSetConfigFilterProperties(mfxConfig config,
+                                       const mfxConfigFilterProperty *props,
+                                       mfxU32 numProps) {
+    if (!config || !props)
+        return MFX_ERR_NULL_PTR;
+
+    ConfigCtxVPL *configCtx = (ConfigCtxVPL *)config;
+    LoaderCtxVPL *loaderCtx = configCtx->m_parentLoader;
 
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    std::unique_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    mfxStatus sts = MFX_ERR_NONE;
+    for (mfxU32 i = 0; i < numProps && sts == MFX_ERR_NONE; i++)
+        sts = configCtx->SetFilterPropertyById(props[i].PropertyID, props[i].Value);
+
+    // earlier properties were set, so the valid list must be updated in either case
+    loaderCtx->m_bNeedUpdateValidImpls = true;
+
+    mfxStatus stsLowLatency = loaderCtx->UpdateLowLatency();
+
+    return (sts != MFX_ERR_NONE ? sts : stsLowLatency);
+}
+
+// load and query all libraries and update list of valid implementations
+// this only modifies the loader the first time and after a filter property has changed,
+//   so check with shared access and take exclusive access only if needed
+static mfxStatus PrepareEnumImplementations(LoaderCtxVPL *loaderCtx) {
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+        if (!loaderCtx->m_bNeedFullQuery && !loaderCtx->m_bNeedUpdateValidImpls)
+            return MFX_ERR_NONE;
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     mfxStatus sts = MFX_ERR_NONE;
 
     // load and query all libraries
@@ -123,14 +208,16 @@ mfxStatus MFXEnumImplementations(mfxLoader loader,
             return MFX_ERR_NOT_FOUND;
     }
 
-    sts = loaderCtx->QueryImpl(i, format, idesc);
-
-    return sts;
+    return MFX_ERR_NONE;
 }
 
-// create a new session with implementation i
-mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
-    if (!loader || !session)
+// iterate over available implementations
+// capabilities are returned in idesc
+mfxStatus MFXEnumImplementations(mfxLoader loader,
+                                 mfxU32 i,
+                                 mfxImplCapsDeliveryFormat format,
+                                 mfxHDL *idesc) {
+    if (!loader || !idesc)
         return MFX_ERR_NULL_PTR;
 
     LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
@@ -138,11 +225,43 @@ mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    mfxStatus sts = PrepareEnumImplementations(loaderCtx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    sts = loaderCtx->QueryImpl(i, format, idesc);
+
+    return sts;
+}
+
+// load libraries and update list of valid implementations before creating a session
+// as with PrepareEnumImplementations(), exclusive access is only taken if needed
+static mfxStatus PrepareCreateSession(LoaderCtxVPL *loaderCtx) {
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+        if (loaderCtx->m_bLowLatency) {
+            DISP_LOG_MESSAGE(dispLog, "message:  low latency mode enabled");
+            if (!loaderCtx->m_bNeedLowLatencyQuery)
+                return MFX_ERR_NONE;
+        }
+        else {
+            DISP_LOG_MESSAGE(dispLog, "message:  low latency mode disabled");
+            if (!loaderCtx->m_bNeedFullQuery && !loaderCtx->m_bNeedUpdateValidImpls)
+                return MFX_ERR_NONE;
+        }
+    }
+
+    std::unique_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     mfxStatus sts = MFX_ERR_NONE;
 
+    // mode may have changed while the lock was released
     if (loaderCtx->m_bLowLatency) {
-        DISP_LOG_MESSAGE(dispLog, "message:  low latency mode enabled");
-
         if (loaderCtx->m_bNeedLowLatencyQuery) {
             // load low latency libraries
             sts = loaderCtx->LoadLibsLowLatency();
@@ -156,8 +275,6 @@ mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
         }
     }
     else {
-        DISP_LOG_MESSAGE(dispLog, "message:  low latency mode disabled");
-
         // load and query all libraries
         if (loaderCtx->m_bNeedFullQuery) {
             sts = loaderCtx->FullLoadAndQuery();
@@ -174,11 +291,103 @@ mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
         }
     }
 
+    return MFX_ERR_NONE;
+}
+
+// create a new session with implementation i
+mfxStatus MFXCreateSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
+    if (!loader || !session)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+    DISP_LOG_FUNCTION(dispLog);
+
+    mfxStatus sts = PrepareCreateSession(loaderCtx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     sts = loaderCtx->CreateSession(i, session);
 
     return sts;
 }
 
+// create pool of numSessions sessions with implementation i
+mfxStatus MFXCreateSessionPool(mfxLoader loader, mfxU32 i, mfxU32 numSessions) {
+    if (!loader)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+    DISP_LOG_FUNCTION(dispLog);
+
+    mfxStatus sts = PrepareCreateSession(loaderCtx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    sts = loaderCtx->CreateSessionPool(i, numSessions);
+
+    return sts;
+}
+
+// get session from pool for implementation i
+mfxStatus MFXAcquireSession(mfxLoader loader, mfxU32 i, mfxSession *session) {
+    if (!loader || !session)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+    DISP_LOG_FUNCTION(dispLog);
+
+    mfxStatus sts = PrepareCreateSession(loaderCtx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    sts = loaderCtx->AcquireSession(i, session);
+
+    return sts;
+}
+
+// return session to its pool
+mfxStatus MFXReleaseSession(mfxLoader loader, mfxSession session) {
+    if (!loader || !session)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
+    DISP_LOG_FUNCTION(dispLog);
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    mfxStatus sts = loaderCtx->ReleaseSession(session);
+
+    return sts;
+}
+
+// get startup timing of this loader
+mfxStatus MFXDispQueryTiming(mfxLoader loader, mfxDispatcherTiming *timing) {
+    if (!loader || !timing)
+        return MFX_ERR_NULL_PTR;
+
+    LoaderCtxVPL *loaderCtx = (LoaderCtxVPL *)loader;
+
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
+    mfxStatus sts = loaderCtx->QueryTiming(timing);
+
+    return sts;
+}
+
 // release memory associated with implementation description hdl
 mfxStatus MFXDispReleaseImplDescription(mfxLoader loader, mfxHDL hdl) {
     if (!loader)
@@ -189,6 +398,8 @@ mfxStatus MFXDispReleaseImplDescription(mfxLoader loader, mfxHDL hdl) {
     DispatcherLogVPL *dispLog = loaderCtx->GetLogger();
     DISP_LOG_FUNCTION(dispLog);
 
+    std::shared_lock<std::shared_timed_mutex> lock(loaderCtx->m_implListLock);
+
     mfxStatus sts = loaderCtx->ReleaseImpl(hdl);
 
     return sts;
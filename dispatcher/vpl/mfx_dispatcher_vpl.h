@@ -8,16 +8,23 @@
 #define DISPATCHER_VPL_MFX_DISPATCHER_VPL_H_
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdlib>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <shared_mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "vpl/mfxdispatcher.h"
 #include "vpl/mfxvideo.h"
 
+#include "./mfx_dispatcher_vpl_admission.h"
 #include "./mfx_dispatcher_vpl_log.h"
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -67,6 +74,8 @@ typedef char CHAR_TYPE;
 
 #define MAX_ENV_VAR_LEN 32768
 
+#define MAX_PROBE_THREADS 16
+
 #define DEVICE_ID_UNKNOWN   0xffffffff
 #define ADAPTER_IDX_UNKNOWN 0xffffffff
 
@@ -170,7 +179,7 @@ enum PropRanges {
 
 // must match eProp_TotalProps, is checked with static_assert in _config.cpp
 //   (should throw error at compile time if !=)
-#define NUM_TOTAL_FILTER_PROPS 55
+#define NUM_TOTAL_FILTER_PROPS 60
 
 // typedef child structures for easier reading
 typedef struct mfxDecoderDescription::decoder DecCodec;
@@ -220,6 +229,117 @@ struct VPPConfig {
     mfxU32 OutFormat;
 };
 
+// simple bump allocator for data owned by the dispatcher (flattened caps,
+//   descriptions restored from the caps cache)
+// allocations are zero-initialized and are released all at once by Reset()
+//   or when the arena is destroyed, so there is no per-object free
+#define ARENA_VPL_BLOCK_SIZE (16 * 1024)
+
+class ArenaVPL {
+public:
+    ArenaVPL() : m_blocks(), m_blockSize(0), m_blockUsed(0) {}
+
+    template <typename T>
+    T *Alloc(size_t n) {
+        if (n == 0)
+            return nullptr;
+        return reinterpret_cast<T *>(AllocBytes(n * sizeof(T)));
+    }
+
+    void Reset() {
+        m_blocks.clear();
+        m_blockSize = 0;
+        m_blockUsed = 0;
+    }
+
+private:
+    // prevent copies
+    ArenaVPL(const ArenaVPL &);
+    ArenaVPL &operator=(const ArenaVPL &);
+
+    void *AllocBytes(size_t size) {
+        const size_t align = alignof(std::max_align_t);
+        size               = (size + align - 1) & ~(align - 1);
+
+        if (m_blockSize - m_blockUsed < size) {
+            // large requests get a dedicated block so the current one stays usable
+            if (size > ARENA_VPL_BLOCK_SIZE / 4 && !m_blocks.empty()) {
+                m_blocks.emplace(m_blocks.end() - 1, new mfxU8[size]());
+                return (m_blocks.end() - 2)->get();
+            }
+
+            m_blockSize = (std::max)(size, (size_t)ARENA_VPL_BLOCK_SIZE);
+            m_blockUsed = 0;
+            m_blocks.emplace_back(new mfxU8[m_blockSize]());
+        }
+
+        mfxU8 *p = m_blocks.back().get() + m_blockUsed;
+        m_blockUsed += size;
+        return p;
+    }
+
+    std::vector<std::unique_ptr<mfxU8[]>> m_blocks;
+    size_t m_blockSize;
+    size_t m_blockUsed;
+};
+
+// contiguous run of flattened configs sharing the same CodecID (Dec, Enc)
+//   or FilterFourCC (VPP)
+struct FlatCapsRange {
+    mfxU32 key;
+    mfxU32 first;
+    mfxU32 count;
+};
+
+// flattened configs of one type, sorted by key, with one range per key
+template <typename T>
+struct FlatCapsList {
+    T *configs;
+    mfxU32 numConfigs;
+
+    FlatCapsRange *ranges;
+    mfxU32 numRanges;
+};
+
+// flattened Dec/Enc/VPP configs of a single implementation
+// ranges are sorted by key so that filters only scan the entries for
+//   the requested codec or filter
+// each part is built on first use and kept with the implementation, with
+//   storage taken from the arena owned by the loader
+struct FlatCapsVPL {
+    bool bDecFlat;
+    bool bEncFlat;
+    bool bVPPFlat;
+
+    FlatCapsList<DecConfig> dec;
+    FlatCapsList<EncConfig> enc;
+    FlatCapsList<VPPConfig> vpp;
+
+    ArenaVPL *arena;
+
+    FlatCapsVPL()
+            : bDecFlat(false),
+              bEncFlat(false),
+              bVPPFlat(false),
+              dec(),
+              enc(),
+              vpp(),
+              arena(nullptr) {}
+};
+
+// configs which have already been checked against one implementation, with the
+//   value of ConfigCtxVPL::GetPropGeneration() at the time of the check
+// only matches are recorded - a mismatch invalidates the implementation for good
+struct ConfigMatchCache {
+    std::map<const class ConfigCtxVPL *, mfxU32> matchGen;
+
+    // number of per-config checks run and skipped, for logging
+    mfxU32 numChecked;
+    mfxU32 numCached;
+
+    ConfigMatchCache() : matchGen(), numChecked(0), numCached(0) {}
+};
+
 // special props which are passed in via MFXSetConfigProperty()
 // these are updated with every call to ValidateConfig() and may
 //   be used in MFXCreateSession()
@@ -247,6 +367,16 @@ struct SpecialConfig {
 
     bool bIsSet_ExtBuffer;
     std::vector<mfxExtBuffer *> ExtBuffers;
+
+    bool bIsSet_fastStartPath;
+    std::string fastStartPath;
+
+    // declared workload of the session, see GetSessionAdmissionCost()
+    bool bIsSet_SessionCost;
+    mfxU32 SessionCostWidth;
+    mfxU32 SessionCostHeight;
+    mfxU32 SessionCostFrameRate;
+    mfxU32 SessionCostCodecID;
 };
 
 // config class implementation
@@ -258,9 +388,25 @@ public:
     // set a single filter property (KV pair)
     mfxStatus SetFilterProperty(const mfxU8 *name, mfxVariant value);
 
+    // pre-parsed filter properties (MFXResolveConfigFilterProperty)
+    static mfxStatus ResolveFilterProperty(const mfxU8 *name, mfxI32 &propIdx);
+    mfxStatus SetFilterPropertyById(mfxU32 propIdx, mfxVariant value);
+
     static bool CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList,
                                       SpecialConfig *specialConfig);
 
+    // check whether any filter requires caps which are queried on demand
+    static void GetRequestedDeferredCaps(const std::list<ConfigCtxVPL *> &configCtxList,
+                                         bool &bImplFuncs,
+                                         bool &bExtDeviceID);
+
+#ifdef ONEVPL_EXPERIMENTAL
+    // check only the extended device ID filters, used to skip libraries which
+    //   do not expose the requested device before querying their full caps
+    static bool CheckExtDevIDFilters(const std::list<ConfigCtxVPL *> &configCtxList,
+                                     const mfxExtendedDeviceId *libImplExtDevID);
+#endif
+
     // compare library caps vs. set of configuration filters
     static mfxStatus ValidateConfig(const mfxImplDescription *libImplDesc,
                                     const mfxImplementedFunctions *libImplFuncs,
@@ -269,7 +415,14 @@ public:
 #endif
                                     std::list<ConfigCtxVPL *> configCtxList,
                                     LibType libType,
-                                    SpecialConfig *specialConfig);
+                                    SpecialConfig *specialConfig,
+                                    FlatCapsVPL *implFlatCaps    = nullptr,
+                                    ConfigMatchCache *matchCache = nullptr);
+
+    // incremented whenever a filter property is set, invalidates ConfigMatchCache entries
+    mfxU32 GetPropGeneration() const {
+        return m_propGeneration;
+    }
 
     // parse deviceID for x86 devices
     static bool ParseDeviceIDx86(mfxChar *cDeviceID, mfxU32 &deviceID, mfxU32 &adapterIdx);
@@ -289,33 +442,52 @@ private:
     }
 
     mfxStatus ValidateAndSetProp(mfxI32 idx, mfxVariant value);
-    mfxStatus SetFilterPropertyDec(std::list<std::string> &propParsedString, mfxVariant value);
-    mfxStatus SetFilterPropertyEnc(std::list<std::string> &propParsedString, mfxVariant value);
-    mfxStatus SetFilterPropertyVPP(std::list<std::string> &propParsedString, mfxVariant value);
+    static mfxStatus ResolveFilterPropertyDec(std::list<std::string> &propParsedString,
+                                              mfxI32 &propIdx);
+    static mfxStatus ResolveFilterPropertyEnc(std::list<std::string> &propParsedString,
+                                              mfxI32 &propIdx);
+    static mfxStatus ResolveFilterPropertyVPP(std::list<std::string> &propParsedString,
+                                              mfxI32 &propIdx);
 
     static mfxStatus GetFlatDescriptionsDec(const mfxImplDescription *libImplDesc,
-                                            std::list<DecConfig> &decConfigList);
+                                            std::vector<DecConfig> &decConfigList);
 
     static mfxStatus GetFlatDescriptionsEnc(const mfxImplDescription *libImplDesc,
-                                            std::list<EncConfig> &encConfigList);
+                                            std::vector<EncConfig> &encConfigList);
 
     static mfxStatus GetFlatDescriptionsVPP(const mfxImplDescription *libImplDesc,
-                                            std::list<VPPConfig> &vppConfigList);
+                                            std::vector<VPPConfig> &vppConfigList);
+
+    static void BuildFlatCaps(const mfxImplDescription *libImplDesc,
+                              FlatCapsVPL *flatCaps,
+                              bool bDec,
+                              bool bEnc,
+                              bool bVPP);
 
     static mfxStatus CheckPropsGeneral(const mfxVariant cfgPropsAll[],
                                        const mfxImplDescription *libImplDesc);
 
-    static mfxStatus CheckPropsDec(const mfxVariant cfgPropsAll[],
-                                   std::list<DecConfig> decConfigList);
+    static mfxStatus CheckPropsDec(const mfxVariant cfgPropsAll[], const FlatCapsVPL &flatCaps);
 
-    static mfxStatus CheckPropsEnc(const mfxVariant cfgPropsAll[],
-                                   std::list<EncConfig> encConfigList);
+    static mfxStatus CheckPropsEnc(const mfxVariant cfgPropsAll[], const FlatCapsVPL &flatCaps);
 
-    static mfxStatus CheckPropsVPP(const mfxVariant cfgPropsAll[],
-                                   std::list<VPPConfig> vppConfigList);
+    static mfxStatus CheckPropsVPP(const mfxVariant cfgPropsAll[], const FlatCapsVPL &flatCaps);
 
     static mfxStatus CheckPropString(const mfxChar *implString, const std::string filtString);
 
+    static void SetSessionCost(const mfxVariant cfgPropsAll[], SpecialConfig *specialConfig);
+
+    // check the filters of a single config (cfgPropsAll) which depend on the implementation
+    static mfxStatus CheckConfigProps(const ConfigCtxVPL *config,
+                                      const mfxVariant cfgPropsAll[],
+                                      const mfxImplDescription *libImplDesc,
+                                      const mfxImplementedFunctions *libImplFuncs,
+#ifdef ONEVPL_EXPERIMENTAL
+                                      const mfxExtendedDeviceId *libImplExtDevID,
+#endif
+                                      LibType libType,
+                                      FlatCapsVPL *flatCaps);
+
 #ifdef ONEVPL_EXPERIMENTAL
     static mfxStatus CheckPropsExtDevID(const mfxVariant cfgPropsAll[],
                                         const mfxExtendedDeviceId *libImplExtDevID);
@@ -323,6 +495,7 @@ private:
 #endif
 
     mfxVariant m_propVar[NUM_TOTAL_FILTER_PROPS];
+    mfxU32 m_propGeneration;
 
     // special containers for properties which are passed by pointer
     //   (save a copy of the whole object based on property name)
@@ -336,6 +509,8 @@ private:
     mfxU8 m_extDevLUID8U[8];
     std::string m_extDevNameStr;
 
+    std::string m_fastStartPath;
+
     std::vector<mfxU8> m_extBuf;
 
     __inline bool SetExtBuf(mfxExtBuffer *extBuf) {
@@ -376,13 +551,18 @@ public:
 
     // public function to be called by VPL dispatcher
     // do not allocate any new memory here, so no need for a matching Release functions
+    // an adapter is only probed once, later calls return the same description
     mfxStatus QueryMSDKCaps(STRING_TYPE libNameFull,
                             mfxImplDescription **implDesc,
                             mfxImplementedFunctions **implFuncs,
                             mfxU32 adapterID,
                             bool bSkipD3D9Check);
 
-    static mfxStatus QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *msdkVersion);
+    // if msdkCtx is set (array of MAX_NUM_IMPL_MSDK), the adapter whose session returned the
+    //   version is probed with the same session and QueryMSDKCaps() will not open another one
+    static mfxStatus QueryAPIVersion(STRING_TYPE libNameFull,
+                                     mfxVersion *msdkVersion,
+                                     LoaderCtxMSDK *msdkCtx = nullptr);
 
 #ifdef ONEVPL_EXPERIMENTAL
     static mfxStatus QueryExtDeviceID(mfxExtendedDeviceId *extDeviceID,
@@ -416,12 +596,25 @@ private:
     static mfxStatus CheckD3D9Support(mfxU64 luid, STRING_TYPE libNameFull, mfxIMPL *implD3D9);
     static mfxStatus GetRenderNodeDescription(mfxU32 adapterID, mfxU32 &vendorID, mfxU16 &deviceID);
 
+    // probing adapterID, CheckAdapter() is called before a session is opened on it
+    mfxStatus CheckAdapter(mfxU32 adapterID);
+    mfxStatus ProbeAdapter(mfxSession session,
+                           STRING_TYPE libNameFull,
+                           mfxU32 adapterID,
+                           mfxIMPL implDefault,
+                           mfxU64 luid);
+
     // internal state variables
     STRING_TYPE m_libNameFull;
     mfxImplDescription m_id; // base description struct
     mfxAccelerationMode m_accelMode[MAX_MSDK_ACCEL_MODES];
     mfxU16 m_loaderDeviceID;
 
+    // result of ProbeAdapter() for m_libNameFull, reused by QueryMSDKCaps()
+    bool m_bProbed;
+    mfxStatus m_probeSts;
+    bool m_bCheckedD3D9;
+
     __inline bool IsVersionSupported(mfxVersion reqVersion, mfxVersion actualVersion) {
         if (actualVersion.Major > reqVersion.Major) {
             return true;
@@ -455,6 +648,10 @@ struct LibInfo {
     // user-friendly version of path for MFX_IMPLCAPS_IMPLPATH query
     mfxChar implCapsPath[MAX_VPL_SEARCH_PATH];
 
+    // if true, caps were found in the on-disk cache and the library
+    //   has not been loaded (see CapsCacheVPL)
+    bool bCapsCached;
+
     // avoid warnings
     LibInfo()
             : libNameFull(),
@@ -464,7 +661,8 @@ struct LibInfo {
               vplFuncTable(),
               msdkCtx(),
               msdkVersion(),
-              implCapsPath() {}
+              implCapsPath(),
+              bCapsCached(false) {}
 
 private:
     // make this class non-copyable
@@ -486,6 +684,19 @@ struct ImplInfo {
     mfxHDL implExtDeviceID;
 #endif
 
+    // if true, implFuncs and implExtDeviceID have not been queried yet
+    //   (see LoaderCtxVPL::QueryDeferredCaps)
+    bool bCapsDeferred;
+
+    // flattened and indexed caps, reused by every call to ValidateConfig()
+    FlatCapsVPL flatCaps;
+
+    // configs already matched by this implementation, see UpdateValidImplList()
+    ConfigMatchCache configMatch;
+
+    // idle sessions created with MFXCreateSessionPool() or returned by MFXReleaseSession()
+    std::list<mfxSession> sessionPool;
+
     // used for session initialization with this implementation
     mfxInitializationParam vplParam;
     mfxVersion version;
@@ -510,6 +721,10 @@ struct ImplInfo {
 #ifdef ONEVPL_EXPERIMENTAL
               implExtDeviceID(nullptr),
 #endif
+              bCapsDeferred(false),
+              flatCaps(),
+              configMatch(),
+              sessionPool(),
               vplParam(),
               version(),
               msdkImplIdx(0),
@@ -519,6 +734,80 @@ struct ImplInfo {
     }
 };
 
+// capabilities of a single implementation restored from the cache
+// all memory is owned by CapsCacheVPL
+struct CachedImplCaps {
+    mfxU32 libImplIdx;
+
+    mfxImplDescription *implDesc;
+    mfxImplementedFunctions *implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+    mfxExtendedDeviceId *implExtDeviceID;
+#endif
+
+    // legacy MSDK only, libImplIdx is the adapter (LoaderCtxMSDK) index
+    mfxIMPL msdkAdapter;
+    mfxIMPL msdkAdapterD3D9;
+};
+
+// persistent cache of implementation capabilities
+// enabled with ONEVPL_DISPATCHER_CACHE_FILE environment variable
+// each entry is keyed by the full library path and the file identity
+//   (size, modification time, inode) so that a driver update invalidates it
+// legacy MSDK libraries are cached too, restoring them avoids creating a session per adapter
+class CapsCacheVPL {
+public:
+    CapsCacheVPL();
+    ~CapsCacheVPL();
+
+    mfxStatus Init(const STRING_TYPE &cacheFile, DispatcherLogVPL *dispLog);
+    bool IsEnabled() const;
+
+    // returns true if a current entry exists for this library, libType is the type it was
+    //   cached as (VPL or MSDK)
+    bool HasLib(const STRING_TYPE &libNameFull, LibType &libType);
+
+    // restore caps for all implementations in this library
+    mfxStatus GetLib(const STRING_TYPE &libNameFull, std::vector<CachedImplCaps> &implCaps);
+
+    // serialize caps for valid implementations in this library
+    mfxStatus AddLib(const STRING_TYPE &libNameFull, const std::list<ImplInfo *> &implInfoList);
+
+    // write updated cache file (only if new entries were added)
+    mfxStatus Flush();
+
+private:
+    struct CacheEntry {
+        STRING_TYPE libNameFull;
+        mfxU64 fileSize;
+        mfxU64 fileModTime;
+        mfxU64 fileID;
+        mfxU32 libType;
+        std::vector<mfxU8> blob;
+        bool bRestored;
+        std::vector<CachedImplCaps> implCaps;
+    };
+
+    static mfxStatus GetFileKey(const STRING_TYPE &libNameFull, CacheEntry &entry);
+    CacheEntry *FindEntry(const STRING_TYPE &libNameFull);
+    mfxStatus ReadFile();
+    mfxStatus ParseBlob(CacheEntry &entry);
+
+    STRING_TYPE m_cacheFile;
+    std::list<CacheEntry> m_entries;
+
+    // backing store for restored descriptions, freed with the loader
+    ArenaVPL m_arena;
+
+    bool m_bEnabled;
+    bool m_bModified;
+    DispatcherLogVPL *m_dispLog;
+
+    // make this class non-copyable
+    CapsCacheVPL(const CapsCacheVPL &);
+    void operator=(const CapsCacheVPL &);
+};
+
 // loader class implementation
 class LoaderCtxVPL {
 public:
@@ -543,6 +832,11 @@ public:
     // create mfxSession
     mfxStatus CreateSession(mfxU32 idx, mfxSession *session);
 
+    // manage pools of initialized sessions
+    mfxStatus CreateSessionPool(mfxU32 idx, mfxU32 numSessions);
+    mfxStatus AcquireSession(mfxU32 idx, mfxSession *session);
+    mfxStatus ReleaseSession(mfxSession session);
+
     // manage configuration filters
     ConfigCtxVPL *AddConfigFilter();
     mfxStatus FreeConfigFilters();
@@ -550,23 +844,55 @@ public:
     // manage logging
     mfxStatus InitDispatcherLog();
     DispatcherLogVPL *GetLogger();
+    mfxStatus QueryTiming(mfxDispatcherTiming *timing);
+
+    // manage capability cache
+    mfxStatus InitCapsCache();
 
     // low latency initialization
     mfxStatus LoadLibsLowLatency();
     mfxStatus UpdateLowLatency();
 
+    // fast start - low latency mode with explicit runtime path
+    mfxStatus InitFastStart();
+
+    // shared loader - library discovery and caps query done once per process
+    mfxStatus InitSharedLoader();
+
+    // adapter policy - optional load balancing of hardware implementations
+    mfxStatus InitAdapterPolicy();
+
+    // admission control - optional per-adapter budget of session costs shared across processes
+    mfxStatus InitAdmissionControl();
+
+    // async load - load and query libraries on a background thread (MFXLoadAsync)
+    mfxStatus StartAsyncLoad(mfxLoadCallback callback, mfxHDL userData);
+    mfxStatus WaitAsyncLoad(mfxU32 waitMs);
+    void JoinAsyncLoad();
+
     bool m_bLowLatency;
     bool m_bNeedUpdateValidImpls;
     bool m_bNeedFullQuery;
     bool m_bNeedLowLatencyQuery;
     bool m_bPriorityPathEnabled;
 
+    // held exclusively while libraries are loaded or the list of valid implementations is
+    //   updated, and shared by EnumImplementations() and CreateSession() so that several
+    //   threads may query caps and create sessions at the same time
+    std::shared_timed_mutex m_implListLock;
+
 private:
     // helper functions
     mfxStatus LoadSingleLibrary(LibInfo *libInfo);
     mfxStatus UnloadSingleLibrary(LibInfo *libInfo);
     mfxStatus UnloadSingleImplementation(ImplInfo *implInfo);
+    void ClosePooledSessions(ImplInfo *implInfo);
     VPLFunctionPtr GetFunctionAddr(void *hModuleVPL, const char *pName);
+    ImplInfo *GetValidImpl(mfxU32 idx);
+    mfxStatus InitSession(ImplInfo *implInfo, mfxSession *session);
+
+    mfxU32 GetProbeThreadCount();
+    void ProbeLibraries();
 
     mfxU32 GetSearchPathsDriverStore(std::list<STRING_TYPE> &searchDirs, LibType libType);
     mfxU32 GetSearchPathsSystemDefault(std::list<STRING_TYPE> &searchDirs);
@@ -585,7 +911,10 @@ private:
     mfxU32 LoadAPIExports(LibInfo *libInfo, LibType libType);
     mfxStatus ValidateAPIExports(VPLFunctionPtr *vplFuncTable, mfxVersion reportedVersion);
     bool IsValidX86GPU(ImplInfo *implInfo, mfxU32 &deviceID, mfxU32 &adapterIdx);
+    bool IsD3D9Excluded();
     mfxStatus UpdateImplPath(LibInfo *libInfo);
+    mfxStatus AddCachedImpls(LibInfo *libInfo);
+    mfxStatus QueryDeferredCaps(LibInfo *libInfo);
 
     mfxStatus LoadLibsFromDriverStore(mfxU32 numAdapters,
                                       const std::vector<DXGI1DeviceInfo> &adapterInfo,
@@ -594,13 +923,33 @@ private:
     mfxStatus LoadLibsFromMultipleDirs(LibType libType);
 
     LibInfo *AddSingleLibrary(STRING_TYPE libPath, LibType libType);
+    mfxStatus LoadLibsFastStart();
     mfxStatus QuerySessionLowLatency(LibInfo *libInfo, mfxU32 adapterID, mfxVersion *ver);
 
+    mfxStatus LoadFromSharedLoader();
+    void ReleaseSharedLoader();
+
+    void RotateAdapters();
+
+    mfxStatus AdmitSession(ImplInfo *&implInfo, AdmissionTicketVPL &ticket);
+    mfxStatus ReserveAdmission(ImplInfo *implInfo, mfxU64 cost, AdmissionTicketVPL &ticket);
+
+    mfxStatus LoadAndQueryAsync();
+    void RunAsyncLoad(mfxLoadCallback callback, mfxHDL userData);
+
     std::list<LibInfo *> m_libInfoList;
     std::list<ImplInfo *> m_implInfoList;
     std::list<ConfigCtxVPL *> m_configCtxList;
     std::vector<DXGI1DeviceInfo> m_gpuAdapterInfo;
 
+    // all sessions owned by a pool (idle or acquired) and their implementation
+    // m_poolMutex protects the map and the pool of each implementation
+    std::map<mfxSession, ImplInfo *> m_pooledSessions;
+    std::mutex m_poolMutex;
+
+    // serializes QueryDeferredCaps() when called with m_implListLock shared
+    std::mutex m_deferredCapsMutex;
+
     SpecialConfig m_specialConfig;
 
     mfxU32 m_implIdxNext;
@@ -609,6 +958,48 @@ private:
 
     // logger object - enabled with ONEVPL_DISPATCHER_LOG environment variable
     DispatcherLogVPL m_dispLog;
+
+    // startup timing, always collected
+    // m_timingMutex protects values updated with m_implListLock shared (CreateSession)
+    mfxDispatcherTiming m_timing;
+    std::mutex m_timingMutex;
+
+    // storage for flattened caps of all implementations, released in UnloadAllLibraries()
+    ArenaVPL m_capsArena;
+
+    // caps cache - enabled with ONEVPL_DISPATCHER_CACHE_FILE environment variable
+    CapsCacheVPL m_capsCache;
+
+    // fast start runtime path - set with ONEVPL_DISPATCHER_FAST_START_PATH environment variable
+    //   or the FastStartPath filter property (takes precedence)
+    STRING_TYPE m_fastStartPath;
+    bool m_bFastStart;
+
+    // shared loader mode - enabled with ONEVPL_DISPATCHER_SHARED_LOADER environment variable
+    // if m_bSharedLoaderRef is true, LibInfo and caps are owned by the shared loader and
+    //   m_implInfoList only holds per-handle copies of its ImplInfo
+    bool m_bSharedLoader;
+    bool m_bSharedLoaderRef;
+
+    // round robin adapter order - enabled with ONEVPL_DISPATCHER_ADAPTER_POLICY=ROUNDROBIN
+    bool m_bAdapterRoundRobin;
+
+    // admission control - enabled with ONEVPL_DISPATCHER_ADMISSION_BUDGET
+    // budget and costs are in megapixels per second, weighted by codec
+    AdmissionPolicyVPL m_admissionPolicy;
+    mfxU64 m_admissionBudget;
+    mfxU32 m_admissionTimeout;
+    std::string m_admissionName;
+
+    // async load - m_asyncLoadMutex protects m_bAsyncLoadDone and m_asyncLoadStatus
+    // while the background thread runs it holds m_implListLock exclusively, so other
+    //   calls into the loader wait until libraries have been loaded and queried
+    bool m_bAsyncLoad;
+    bool m_bAsyncLoadDone;
+    mfxStatus m_asyncLoadStatus;
+    std::thread m_asyncLoadThread;
+    std::mutex m_asyncLoadMutex;
+    std::condition_variable m_asyncLoadCond;
 };
 
 #endif // DISPATCHER_VPL_MFX_DISPATCHER_VPL_H_
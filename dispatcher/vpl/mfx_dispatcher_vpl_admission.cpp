@@ -0,0 +1,563 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "vpl/mfx_dispatcher_vpl.h"
+#include "vpl/mfxjpeg.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// ledger layout (one per adapter, native byte order):
+//   AdmissionLedgerData
+//   entry is free if id is 0
+// the ledger is created zeroed, its creator sets magic once the lock is initialized
+
+#define ADMISSION_LEDGER_MAGIC   0x4c444d41 // "AMDL"
+#define ADMISSION_LEDGER_VERSION 1
+#define ADMISSION_MAX_ENTRIES    256
+
+#define ADMISSION_QUEUE_POLL_MS   10
+#define ADMISSION_DEFAULT_FPS     30
+#define ADMISSION_DEFAULT_TIMEOUT 10000
+#define ADMISSION_DEFAULT_NAME    "onevpl-admission"
+#define ADMISSION_OPEN_WAIT_MS    1000
+
+struct AdmissionEntryVPL {
+    mfxU64 id; // unique within the process
+    mfxU64 cost;
+    mfxU32 pid;
+    mfxU32 reserved;
+};
+
+struct AdmissionLedgerData {
+    mfxU32 magic;
+    mfxU32 version;
+#if !defined(_WIN32) && !defined(_WIN64)
+    pthread_mutex_t lock; // process-shared, robust
+#endif
+    AdmissionEntryVPL entries[ADMISSION_MAX_ENTRIES];
+};
+
+// mapping of one ledger in this process, kept until the process exits
+struct AdmissionLedgerVPL {
+    AdmissionLedgerData *data;
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE hMapping;
+    HANDLE hMutex;
+#endif
+};
+
+// ledgers opened by this process and reservations of its open sessions
+static std::mutex g_admissionMutex;
+static std::map<std::string, AdmissionLedgerVPL *> g_admissionLedgers;
+static std::map<mfxSession, AdmissionTicketVPL> g_admissionSessions;
+static std::atomic<mfxU64> g_admissionNextId(1);
+
+static mfxU32 GetCurrentPid() {
+#if defined(_WIN32) || defined(_WIN64)
+    return (mfxU32)GetCurrentProcessId();
+#else
+    return (mfxU32)getpid();
+#endif
+}
+
+// entries of processes which are gone are dropped
+static bool IsProcessAlive(mfxU32 pid) {
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (!hProcess)
+        return (GetLastError() == ERROR_ACCESS_DENIED);
+
+    DWORD exitCode = 0;
+    BOOL bRes      = GetExitCodeProcess(hProcess, &exitCode);
+    CloseHandle(hProcess);
+    return (!bRes || exitCode == STILL_ACTIVE);
+#else
+    return (kill((pid_t)pid, 0) == 0 || errno == EPERM);
+#endif
+}
+
+static bool GetAdmissionEnv(const char *name, std::string &value) {
+#if defined(_WIN32) || defined(_WIN64)
+    char envValue[MAX_VPL_SEARCH_PATH] = "";
+    DWORD err = GetEnvironmentVariable(name, envValue, MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return false; // environment variable not defined or string too long
+
+    value = envValue;
+#else
+    const char *envValue = std::getenv(name);
+    if (!envValue)
+        return false;
+
+    value = envValue;
+#endif
+    return true;
+}
+
+static bool LockLedger(AdmissionLedgerVPL *ledger) {
+#if defined(_WIN32) || defined(_WIN64)
+    // an abandoned mutex is acquired, entries of the dead owner are dropped later
+    DWORD res = WaitForSingleObject(ledger->hMutex, INFINITE);
+    return (res == WAIT_OBJECT_0 || res == WAIT_ABANDONED);
+#else
+    int res = pthread_mutex_lock(&ledger->data->lock);
+    if (res == EOWNERDEAD) {
+        // entries are only written under the lock with single stores, so they are consistent
+        pthread_mutex_consistent(&ledger->data->lock);
+        res = 0;
+    }
+    return (res == 0);
+#endif
+}
+
+static void UnlockLedger(AdmissionLedgerVPL *ledger) {
+#if defined(_WIN32) || defined(_WIN64)
+    ReleaseMutex(ledger->hMutex);
+#else
+    pthread_mutex_unlock(&ledger->data->lock);
+#endif
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static AdmissionLedgerVPL *OpenLedger(const std::string &name) {
+    std::string mappingName = "Local\\" + name;
+    std::string mutexName   = "Local\\" + name + "-lock";
+
+    HANDLE hMutex = CreateMutexA(nullptr, FALSE, mutexName.c_str());
+    if (!hMutex)
+        return nullptr;
+
+    // pages of a new mapping are zeroed
+    HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                         nullptr,
+                                         PAGE_READWRITE,
+                                         0,
+                                         sizeof(AdmissionLedgerData),
+                                         mappingName.c_str());
+    if (!hMapping) {
+        CloseHandle(hMutex);
+        return nullptr;
+    }
+
+    AdmissionLedgerData *data = (AdmissionLedgerData *)
+        MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(AdmissionLedgerData));
+    if (!data) {
+        CloseHandle(hMapping);
+        CloseHandle(hMutex);
+        return nullptr;
+    }
+
+    AdmissionLedgerVPL *ledger = new AdmissionLedgerVPL;
+    ledger->data               = data;
+    ledger->hMapping           = hMapping;
+    ledger->hMutex             = hMutex;
+
+    // the first process to take the lock marks the ledger as initialized
+    bool bValid = LockLedger(ledger);
+    if (bValid) {
+        if (data->magic == 0) {
+            data->version = ADMISSION_LEDGER_VERSION;
+            data->magic   = ADMISSION_LEDGER_MAGIC;
+        }
+        bValid = (data->magic == ADMISSION_LEDGER_MAGIC &&
+                  data->version == ADMISSION_LEDGER_VERSION);
+        UnlockLedger(ledger);
+    }
+
+    if (!bValid) {
+        UnmapViewOfFile(data);
+        CloseHandle(hMapping);
+        CloseHandle(hMutex);
+        delete ledger;
+        return nullptr;
+    }
+
+    return ledger;
+}
+#else
+static AdmissionLedgerVPL *OpenLedger(const std::string &name) {
+    // same location as shm_open(), which would need librt with older glibc
+    std::string path = "/dev/shm/" + name;
+
+    bool bCreator = true;
+    int fd        = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        if (errno != EEXIST)
+            return nullptr;
+
+        bCreator = false;
+        fd       = open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+            return nullptr;
+    }
+
+    if (bCreator) {
+        // allow processes of other users to join, regardless of umask
+        fchmod(fd, 0666);
+        if (ftruncate(fd, sizeof(AdmissionLedgerData)) != 0) {
+            close(fd);
+            unlink(path.c_str());
+            return nullptr;
+        }
+    }
+    else {
+        // wait for the creator to size the file
+        struct stat st = {};
+        auto start     = std::chrono::steady_clock::now();
+        while (fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(AdmissionLedgerData) &&
+               std::chrono::steady_clock::now() - start <
+                   std::chrono::milliseconds(ADMISSION_OPEN_WAIT_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if ((size_t)st.st_size < sizeof(AdmissionLedgerData)) {
+            close(fd);
+            return nullptr;
+        }
+    }
+
+    void *ptr =
+        mmap(nullptr, sizeof(AdmissionLedgerData), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+
+    AdmissionLedgerData *data = (AdmissionLedgerData *)ptr;
+
+    if (bCreator) {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&data->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+
+        data->version = ADMISSION_LEDGER_VERSION;
+        __atomic_store_n(&data->magic, ADMISSION_LEDGER_MAGIC, __ATOMIC_RELEASE);
+    }
+    else {
+        // wait for the creator to initialize the lock
+        auto start = std::chrono::steady_clock::now();
+        while (__atomic_load_n(&data->magic, __ATOMIC_ACQUIRE) != ADMISSION_LEDGER_MAGIC &&
+               std::chrono::steady_clock::now() - start <
+                   std::chrono::milliseconds(ADMISSION_OPEN_WAIT_MS)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        mfxU32 magic = __atomic_load_n(&data->magic, __ATOMIC_ACQUIRE);
+        if (magic != ADMISSION_LEDGER_MAGIC || data->version != ADMISSION_LEDGER_VERSION) {
+            // creator died before initializing the ledger, next session creates it again
+            if (magic == 0)
+                unlink(path.c_str());
+            munmap(ptr, sizeof(AdmissionLedgerData));
+            return nullptr;
+        }
+    }
+
+    AdmissionLedgerVPL *ledger = new AdmissionLedgerVPL;
+    ledger->data               = data;
+
+    return ledger;
+}
+#endif
+
+// return ledger of the adapter, opened on first use
+// call with g_admissionMutex held
+static AdmissionLedgerVPL *GetLedger(const std::string &name, mfxU32 adapterIdx) {
+    std::string ledgerName = name + "-";
+    if (adapterIdx == ADAPTER_IDX_UNKNOWN)
+        ledgerName += "any";
+    else
+        ledgerName += std::to_string(adapterIdx);
+
+    auto it = g_admissionLedgers.find(ledgerName);
+    if (it != g_admissionLedgers.end())
+        return it->second;
+
+    // failures are not remembered, so the ledger is opened again by the next session
+    AdmissionLedgerVPL *ledger = OpenLedger(ledgerName);
+    if (ledger)
+        g_admissionLedgers[ledgerName] = ledger;
+
+    return ledger;
+}
+
+mfxU64 GetSessionAdmissionCost(mfxU32 width, mfxU32 height, mfxU32 frameRate, mfxU32 codecID) {
+    if (width == 0 || height == 0)
+        return 0;
+
+    if (frameRate == 0)
+        frameRate = ADMISSION_DEFAULT_FPS;
+
+    // relative cost of the codec in percent of AVC
+    mfxU64 weight = 100;
+    switch (codecID) {
+        case MFX_CODEC_HEVC:
+        case MFX_CODEC_VP9:
+            weight = 150;
+            break;
+        case MFX_CODEC_AV1:
+            weight = 200;
+            break;
+        case MFX_CODEC_MPEG2:
+        case MFX_CODEC_JPEG:
+            weight = 50;
+            break;
+        default:
+            break;
+    }
+
+    mfxU64 pixelRate = (mfxU64)width * height * frameRate * weight;
+    mfxU64 scale     = 1000000ull * 100;
+    return (pixelRate + scale - 1) / scale;
+}
+
+mfxStatus ReserveSessionAdmission(const std::string &name,
+                                  mfxU32 adapterIdx,
+                                  mfxU64 cost,
+                                  mfxU64 budget,
+                                  AdmissionTicketVPL &ticket,
+                                  mfxU64 &usedCost) {
+    ticket   = {};
+    usedCost = 0;
+
+    AdmissionLedgerVPL *ledger = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_admissionMutex);
+        ledger = GetLedger(name, adapterIdx);
+    }
+    if (!ledger || !LockLedger(ledger))
+        return MFX_ERR_UNSUPPORTED;
+
+    AdmissionEntryVPL *entries = ledger->data->entries;
+    AdmissionEntryVPL *freeEntry = nullptr;
+    mfxU32 pid                   = GetCurrentPid();
+
+    for (mfxU32 i = 0; i < ADMISSION_MAX_ENTRIES; i++) {
+        AdmissionEntryVPL &entry = entries[i];
+
+        if (entry.id && entry.pid != pid && !IsProcessAlive(entry.pid))
+            entry = {};
+
+        if (entry.id)
+            usedCost += entry.cost;
+        else if (!freeEntry)
+            freeEntry = &entry;
+    }
+
+    mfxStatus sts = MFX_ERR_ABORTED;
+    if (freeEntry && usedCost + cost <= budget) {
+        freeEntry->cost = cost;
+        freeEntry->pid  = pid;
+        freeEntry->id   = g_admissionNextId++;
+
+        ticket.ledger = ledger;
+        ticket.id     = freeEntry->id;
+        sts           = MFX_ERR_NONE;
+    }
+
+    UnlockLedger(ledger);
+
+    return sts;
+}
+
+void CancelSessionAdmission(AdmissionTicketVPL &ticket) {
+    if (!ticket.ledger)
+        return;
+
+    if (LockLedger(ticket.ledger)) {
+        AdmissionEntryVPL *entries = ticket.ledger->data->entries;
+        mfxU32 pid                 = GetCurrentPid();
+
+        for (mfxU32 i = 0; i < ADMISSION_MAX_ENTRIES; i++) {
+            if (entries[i].id == ticket.id && entries[i].pid == pid) {
+                entries[i] = {};
+                break;
+            }
+        }
+        UnlockLedger(ticket.ledger);
+    }
+
+    ticket = {};
+}
+
+void BindSessionAdmission(const AdmissionTicketVPL &ticket, mfxSession session) {
+    std::lock_guard<std::mutex> lock(g_admissionMutex);
+    g_admissionSessions[session] = ticket;
+}
+
+void ReleaseSessionAdmission(mfxSession session) {
+    AdmissionTicketVPL ticket = {};
+    {
+        std::lock_guard<std::mutex> lock(g_admissionMutex);
+        auto it = g_admissionSessions.find(session);
+        if (it == g_admissionSessions.end())
+            return;
+
+        ticket = it->second;
+        g_admissionSessions.erase(it);
+    }
+
+    CancelSessionAdmission(ticket);
+}
+
+// enable admission control if ONEVPL_DISPATCHER_ADMISSION_BUDGET is set
+mfxStatus LoaderCtxVPL::InitAdmissionControl() {
+    std::string strBudget;
+    if (!GetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_BUDGET", strBudget))
+        return MFX_ERR_UNSUPPORTED;
+
+    mfxU64 budget = std::strtoull(strBudget.c_str(), nullptr, 10);
+    if (budget == 0)
+        return MFX_ERR_UNSUPPORTED;
+
+    AdmissionPolicyVPL policy = ADMISSION_POLICY_FAIL;
+    std::string strPolicy;
+    if (GetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_POLICY", strPolicy)) {
+        if (strPolicy == "QUEUE")
+            policy = ADMISSION_POLICY_QUEUE;
+        else if (strPolicy == "REDIRECT")
+            policy = ADMISSION_POLICY_REDIRECT;
+        else if (strPolicy != "FAIL")
+            return MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxU32 timeout = ADMISSION_DEFAULT_TIMEOUT;
+    std::string strTimeout;
+    if (GetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_TIMEOUT", strTimeout))
+        timeout = (mfxU32)std::strtoul(strTimeout.c_str(), nullptr, 10);
+
+    std::string name = ADMISSION_DEFAULT_NAME;
+    GetAdmissionEnv("ONEVPL_DISPATCHER_ADMISSION_NAME", name);
+    if (name.empty() || name.find_first_of("/\\") != std::string::npos)
+        return MFX_ERR_UNSUPPORTED;
+
+    m_admissionPolicy  = policy;
+    m_admissionBudget  = budget;
+    m_admissionTimeout = timeout;
+    m_admissionName    = name;
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  admission control -- budget %llu, policy %s, ledger %s",
+                     (unsigned long long)budget,
+                     (policy == ADMISSION_POLICY_QUEUE
+                          ? "queue"
+                          : (policy == ADMISSION_POLICY_REDIRECT ? "redirect" : "fail")),
+                     name.c_str());
+
+    return MFX_ERR_NONE;
+}
+
+// reserve cost on the ledger of the adapter of implInfo
+// if the ledger is not available the session is created without admission control
+mfxStatus LoaderCtxVPL::ReserveAdmission(ImplInfo *implInfo,
+                                         mfxU64 cost,
+                                         AdmissionTicketVPL &ticket) {
+    mfxU64 usedCost = 0;
+    mfxStatus sts   = ReserveSessionAdmission(m_admissionName,
+                                            implInfo->adapterIdx,
+                                            cost,
+                                            m_admissionBudget,
+                                            ticket,
+                                            usedCost);
+
+    if (sts == MFX_ERR_UNSUPPORTED) {
+        DISP_LOG_MESSAGE(&m_dispLog, "message:  admission control -- ledger not available");
+        return MFX_ERR_NONE;
+    }
+
+    if (sts == MFX_ERR_ABORTED) {
+        DISP_LOG_MESSAGE(&m_dispLog,
+                         "message:  admission control -- adapter %d used %llu + %llu > %llu",
+                         (int)implInfo->adapterIdx,
+                         (unsigned long long)usedCost,
+                         (unsigned long long)cost,
+                         (unsigned long long)m_admissionBudget);
+    }
+
+    return sts;
+}
+
+// apply admission policy to a new session
+// with REDIRECT implInfo is replaced by the first valid implementation of the same type on
+//   another adapter which has enough budget
+mfxStatus LoaderCtxVPL::AdmitSession(ImplInfo *&implInfo, AdmissionTicketVPL &ticket) {
+    ticket = {};
+
+    mfxU64 cost = 0;
+    if (m_specialConfig.bIsSet_SessionCost) {
+        cost = GetSessionAdmissionCost(m_specialConfig.SessionCostWidth,
+                                       m_specialConfig.SessionCostHeight,
+                                       m_specialConfig.SessionCostFrameRate,
+                                       m_specialConfig.SessionCostCodecID);
+    }
+
+    // sessions without declared cost are not counted
+    if (cost == 0)
+        return MFX_ERR_NONE;
+
+    mfxStatus sts = ReserveAdmission(implInfo, cost, ticket);
+    if (sts != MFX_ERR_ABORTED)
+        return sts;
+
+    if (m_admissionPolicy == ADMISSION_POLICY_QUEUE) {
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(m_admissionTimeout);
+
+        while (sts == MFX_ERR_ABORTED && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ADMISSION_QUEUE_POLL_MS));
+
+            mfxU64 usedCost = 0;
+            sts             = ReserveSessionAdmission(m_admissionName,
+                                          implInfo->adapterIdx,
+                                          cost,
+                                          m_admissionBudget,
+                                          ticket,
+                                          usedCost);
+        }
+
+        if (sts == MFX_ERR_ABORTED)
+            DISP_LOG_MESSAGE(&m_dispLog, "message:  admission control -- queue timeout");
+    }
+    else if (m_admissionPolicy == ADMISSION_POLICY_REDIRECT &&
+             implInfo->adapterIdx != ADAPTER_IDX_UNKNOWN) {
+        mfxImplDescription *implDesc = (mfxImplDescription *)(implInfo->implDesc);
+
+        for (ImplInfo *otherImpl : m_implInfoList) {
+            mfxImplDescription *otherDesc = (mfxImplDescription *)(otherImpl->implDesc);
+            if (otherImpl->validImplIdx < 0 || otherImpl->adapterIdx == ADAPTER_IDX_UNKNOWN ||
+                otherImpl->adapterIdx == implInfo->adapterIdx || !implDesc || !otherDesc ||
+                otherDesc->Impl != implDesc->Impl)
+                continue;
+
+            sts = ReserveAdmission(otherImpl, cost, ticket);
+            if (sts != MFX_ERR_ABORTED) {
+                DISP_LOG_MESSAGE(&m_dispLog,
+                                 "message:  admission control -- redirected to adapter %d",
+                                 (int)otherImpl->adapterIdx);
+                implInfo = otherImpl;
+                break;
+            }
+        }
+    }
+
+    return sts;
+}
@@ -0,0 +1,80 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef DISPATCHER_VPL_MFX_DISPATCHER_VPL_ADMISSION_H_
+#define DISPATCHER_VPL_MFX_DISPATCHER_VPL_ADMISSION_H_
+
+/* oneVPL Dispatcher Session Admission Control
+ * Admission control is enabled with the ONEVPL_DISPATCHER_ADMISSION_BUDGET environment variable,
+ *   which sets the budget of each adapter in megapixels per second (e.g. "500").
+ *
+ * The application declares the workload of the next sessions with the filter properties
+ *   SessionCost.Width, SessionCost.Height, SessionCost.FrameRate (fps, default 30) and
+ *   SessionCost.CodecID (MFX_CODEC_*, optional). The cost of a session is
+ *   width * height * fps * codec weight, see GetSessionAdmissionCost(). Sessions without
+ *   declared width and height are not counted.
+ *
+ * Costs of the sessions admitted on an adapter are kept in a ledger in named shared memory, so
+ *   all processes which use the same ledger name share the budget. Entries of processes which
+ *   exited without closing their sessions are dropped by the next reservation. Implementations
+ *   without a known adapter (e.g. software or low latency mode) share one ledger.
+ *
+ * ONEVPL_DISPATCHER_ADMISSION_POLICY selects what happens if the session does not fit:
+ *   FAIL     - MFXCreateSession() returns MFX_ERR_ABORTED (default)
+ *   QUEUE    - wait until enough sessions are closed, up to ONEVPL_DISPATCHER_ADMISSION_TIMEOUT
+ *              milliseconds (default 10000), then fail
+ *   REDIRECT - create the session with the first valid implementation on another adapter
+ *              which has enough budget, otherwise fail
+ *
+ * ONEVPL_DISPATCHER_ADMISSION_NAME sets the name of the ledgers (default "onevpl-admission"),
+ *   e.g. to keep separate budgets for groups of processes.
+ */
+
+#include <string>
+
+#include "vpl/mfxvideo.h"
+
+enum AdmissionPolicyVPL {
+    ADMISSION_POLICY_OFF = 0,
+    ADMISSION_POLICY_FAIL,
+    ADMISSION_POLICY_QUEUE,
+    ADMISSION_POLICY_REDIRECT,
+};
+
+struct AdmissionLedgerVPL;
+
+// cost reserved on a ledger, ledger is null if nothing was reserved
+struct AdmissionTicketVPL {
+    AdmissionLedgerVPL *ledger;
+    mfxU64 id;
+};
+
+// cost of a session in megapixels per second, weighted by codec (rounded up)
+// returns 0 if width or height is not set
+mfxU64 GetSessionAdmissionCost(mfxU32 width, mfxU32 height, mfxU32 frameRate, mfxU32 codecID);
+
+// reserve cost on the ledger of the adapter if the used cost stays within the budget
+// returns MFX_ERR_ABORTED if the session does not fit and usedCost is set to the cost already
+//   reserved on the adapter
+// returns MFX_ERR_UNSUPPORTED if the ledger cannot be opened
+mfxStatus ReserveSessionAdmission(const std::string &name,
+                                  mfxU32 adapterIdx,
+                                  mfxU64 cost,
+                                  mfxU64 budget,
+                                  AdmissionTicketVPL &ticket,
+                                  mfxU64 &usedCost);
+
+// release reservation for a session which was not created
+void CancelSessionAdmission(AdmissionTicketVPL &ticket);
+
+// keep reservation until the session is closed
+void BindSessionAdmission(const AdmissionTicketVPL &ticket, mfxSession session);
+
+// release reservation of the session, called from MFXClose()
+// no-op for sessions created without admission control
+void ReleaseSessionAdmission(mfxSession session);
+
+#endif // DISPATCHER_VPL_MFX_DISPATCHER_VPL_ADMISSION_H_
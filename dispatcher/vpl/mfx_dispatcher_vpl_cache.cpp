@@ -0,0 +1,678 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "vpl/mfx_dispatcher_vpl.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <process.h>
+#endif
+
+// cache file layout:
+//   CacheFileHeader
+//   for each entry:
+//     mfxU32 nameLen, CHAR_TYPE name[nameLen]
+//     mfxU64 fileSize, fileModTime, fileID
+//     mfxU32 libType
+//     mfxU32 blobLen, mfxU8 blob[blobLen]
+//
+// blob layout (native byte order, structs copied as-is):
+//   mfxU32 numImpls
+//   for each impl:
+//     mfxU32 libImplIdx (adapter index for MSDK)
+//     mfxIMPL msdkAdapter, msdkAdapterD3D9 (MSDK only)
+//     mfxImplDescription followed by each nested array in depth-first order
+//     mfxImplementedFunctions (optional) followed by each function name
+//     mfxExtendedDeviceId (optional, experimental API only)
+//
+// each array is stored as mfxU32 count followed by the elements
+// pointers inside copied structs are not valid and are patched on restore
+
+#define CAPS_CACHE_MAGIC   0x43505643 // "CVPC"
+#define CAPS_CACHE_VERSION 2
+
+#ifdef ONEVPL_EXPERIMENTAL
+    #define CAPS_CACHE_EXPERIMENTAL 1
+#else
+    #define CAPS_CACHE_EXPERIMENTAL 0
+#endif
+
+struct CacheFileHeader {
+    mfxU32 magic;
+    mfxU32 version;
+    mfxU32 sizeImplDesc;
+    mfxU32 sizePtr;
+    mfxU32 sizeChar;
+    mfxU32 experimental;
+};
+
+typedef struct mfxDeviceDescription::subdevices DevSubDevice;
+
+// append arrays to blob
+class CapsBlobWriter {
+public:
+    explicit CapsBlobWriter(std::vector<mfxU8> &blob) : m_blob(blob) {}
+
+    void PutU32(mfxU32 val) {
+        PutBytes(&val, sizeof(val));
+    }
+
+    template <typename T>
+    void PutArray(const T *p, mfxU32 n) {
+        if (!p)
+            n = 0;
+        PutU32(n);
+        if (n)
+            PutBytes(p, n * sizeof(T));
+    }
+
+private:
+    void PutBytes(const void *p, size_t size) {
+        const mfxU8 *b = reinterpret_cast<const mfxU8 *>(p);
+        m_blob.insert(m_blob.end(), b, b + size);
+    }
+
+    std::vector<mfxU8> &m_blob;
+};
+
+// read arrays from blob with bounds checking
+// restored arrays are allocated from the arena owned by the cache
+class CapsBlobReader {
+public:
+    CapsBlobReader(const std::vector<mfxU8> &blob, ArenaVPL &arena)
+            : m_blob(blob),
+              m_pos(0),
+              m_arena(arena),
+              m_bError(false) {}
+
+    bool GetU32(mfxU32 &val) {
+        return GetBytes(&val, sizeof(val));
+    }
+
+    // expected count must match the count field in the parent struct
+    template <typename T>
+    T *GetArray(mfxU32 expected) {
+        mfxU32 n = 0;
+        if (!GetU32(n) || n != expected) {
+            m_bError = true;
+            return nullptr;
+        }
+
+        if (n == 0)
+            return nullptr;
+
+        if ((m_blob.size() - m_pos) / sizeof(T) < n) {
+            m_bError = true;
+            return nullptr;
+        }
+
+        T *p = Alloc<T>(n);
+        GetBytes(p, n * sizeof(T));
+
+        return p;
+    }
+
+    // allocate zero-initialized array from arena
+    template <typename T>
+    T *Alloc(mfxU32 n) {
+        return m_arena.Alloc<T>(n);
+    }
+
+    // read array of unknown size (count is returned)
+    template <typename T>
+    T *GetArrayAny(mfxU32 &n) {
+        size_t pos = m_pos;
+        if (!GetU32(n)) {
+            m_bError = true;
+            return nullptr;
+        }
+        m_pos = pos;
+        return GetArray<T>(n);
+    }
+
+    bool IsError() const {
+        return m_bError;
+    }
+
+    void SetError() {
+        m_bError = true;
+    }
+
+    bool IsEnd() const {
+        return (m_pos == m_blob.size());
+    }
+
+private:
+    bool GetBytes(void *p, size_t size) {
+        if (m_bError || m_blob.size() - m_pos < size) {
+            m_bError = true;
+            return false;
+        }
+        memcpy(p, m_blob.data() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    const std::vector<mfxU8> &m_blob;
+    size_t m_pos;
+    ArenaVPL &m_arena;
+    bool m_bError;
+};
+
+static void WriteImplDesc(CapsBlobWriter &w, const mfxImplDescription *implDesc) {
+    w.PutArray(implDesc, 1);
+
+    w.PutArray(implDesc->Dev.SubDevices, implDesc->Dev.NumSubDevices);
+
+    const DecCodec *decCodecs = implDesc->Dec.Codecs;
+    w.PutArray(decCodecs, implDesc->Dec.NumCodecs);
+    for (mfxU32 c = 0; decCodecs && c < implDesc->Dec.NumCodecs; c++) {
+        const DecProfile *decProfiles = decCodecs[c].Profiles;
+        w.PutArray(decProfiles, decCodecs[c].NumProfiles);
+        for (mfxU32 p = 0; decProfiles && p < decCodecs[c].NumProfiles; p++) {
+            const DecMemDesc *decMemDesc = decProfiles[p].MemDesc;
+            w.PutArray(decMemDesc, decProfiles[p].NumMemTypes);
+            for (mfxU32 m = 0; decMemDesc && m < decProfiles[p].NumMemTypes; m++)
+                w.PutArray(decMemDesc[m].ColorFormats, decMemDesc[m].NumColorFormats);
+        }
+    }
+
+    const EncCodec *encCodecs = implDesc->Enc.Codecs;
+    w.PutArray(encCodecs, implDesc->Enc.NumCodecs);
+    for (mfxU32 c = 0; encCodecs && c < implDesc->Enc.NumCodecs; c++) {
+        const EncProfile *encProfiles = encCodecs[c].Profiles;
+        w.PutArray(encProfiles, encCodecs[c].NumProfiles);
+        for (mfxU32 p = 0; encProfiles && p < encCodecs[c].NumProfiles; p++) {
+            const EncMemDesc *encMemDesc = encProfiles[p].MemDesc;
+            w.PutArray(encMemDesc, encProfiles[p].NumMemTypes);
+            for (mfxU32 m = 0; encMemDesc && m < encProfiles[p].NumMemTypes; m++)
+                w.PutArray(encMemDesc[m].ColorFormats, encMemDesc[m].NumColorFormats);
+        }
+    }
+
+    const VPPFilter *vppFilters = implDesc->VPP.Filters;
+    w.PutArray(vppFilters, implDesc->VPP.NumFilters);
+    for (mfxU32 f = 0; vppFilters && f < implDesc->VPP.NumFilters; f++) {
+        const VPPMemDesc *vppMemDesc = vppFilters[f].MemDesc;
+        w.PutArray(vppMemDesc, vppFilters[f].NumMemTypes);
+        for (mfxU32 m = 0; vppMemDesc && m < vppFilters[f].NumMemTypes; m++) {
+            const VPPFormat *vppFormats = vppMemDesc[m].Formats;
+            w.PutArray(vppFormats, vppMemDesc[m].NumInFormats);
+            for (mfxU32 n = 0; vppFormats && n < vppMemDesc[m].NumInFormats; n++)
+                w.PutArray(vppFormats[n].OutFormats, vppFormats[n].NumOutFormat);
+        }
+    }
+
+    w.PutArray(implDesc->AccelerationModeDescription.Mode,
+               implDesc->AccelerationModeDescription.NumAccelerationModes);
+
+    w.PutArray(implDesc->PoolPolicies.Policy, implDesc->PoolPolicies.NumPoolPolicies);
+}
+
+// null pointers were written as empty arrays, so counts are cleared to match
+template <typename T, typename C>
+static void FixNullArray(const T *p, C &n) {
+    if (!p)
+        n = 0;
+}
+
+static mfxImplDescription *ReadImplDesc(CapsBlobReader &r) {
+    mfxImplDescription *implDesc = r.GetArray<mfxImplDescription>(1);
+    if (!implDesc)
+        return nullptr;
+
+    // extension buffers are reserved and never cached
+    implDesc->NumExtParam          = 0;
+    implDesc->ExtParams.ExtParam   = nullptr;
+    mfxDeviceDescription *dev      = &implDesc->Dev;
+    mfxDecoderDescription *dec     = &implDesc->Dec;
+    mfxEncoderDescription *enc     = &implDesc->Enc;
+    mfxVPPDescription *vpp         = &implDesc->VPP;
+    mfxAccelerationModeDescription *accel = &implDesc->AccelerationModeDescription;
+    mfxPoolPolicyDescription *pool        = &implDesc->PoolPolicies;
+
+    FixNullArray(dev->SubDevices, dev->NumSubDevices);
+    dev->SubDevices = r.GetArray<DevSubDevice>(dev->NumSubDevices);
+
+    FixNullArray(dec->Codecs, dec->NumCodecs);
+    dec->Codecs = r.GetArray<DecCodec>(dec->NumCodecs);
+    for (mfxU32 c = 0; dec->Codecs && c < dec->NumCodecs && !r.IsError(); c++) {
+        DecCodec *codec = &dec->Codecs[c];
+        FixNullArray(codec->Profiles, codec->NumProfiles);
+        codec->Profiles = r.GetArray<DecProfile>(codec->NumProfiles);
+        for (mfxU32 p = 0; codec->Profiles && p < codec->NumProfiles && !r.IsError(); p++) {
+            DecProfile *profile = &codec->Profiles[p];
+            FixNullArray(profile->MemDesc, profile->NumMemTypes);
+            profile->MemDesc = r.GetArray<DecMemDesc>(profile->NumMemTypes);
+            for (mfxU32 m = 0; profile->MemDesc && m < profile->NumMemTypes && !r.IsError(); m++) {
+                DecMemDesc *memDesc = &profile->MemDesc[m];
+                FixNullArray(memDesc->ColorFormats, memDesc->NumColorFormats);
+                memDesc->ColorFormats = r.GetArray<mfxU32>(memDesc->NumColorFormats);
+            }
+        }
+    }
+
+    FixNullArray(enc->Codecs, enc->NumCodecs);
+    enc->Codecs = r.GetArray<EncCodec>(enc->NumCodecs);
+    for (mfxU32 c = 0; enc->Codecs && c < enc->NumCodecs && !r.IsError(); c++) {
+        EncCodec *codec = &enc->Codecs[c];
+        FixNullArray(codec->Profiles, codec->NumProfiles);
+        codec->Profiles = r.GetArray<EncProfile>(codec->NumProfiles);
+        for (mfxU32 p = 0; codec->Profiles && p < codec->NumProfiles && !r.IsError(); p++) {
+            EncProfile *profile = &codec->Profiles[p];
+            FixNullArray(profile->MemDesc, profile->NumMemTypes);
+            profile->MemDesc = r.GetArray<EncMemDesc>(profile->NumMemTypes);
+            for (mfxU32 m = 0; profile->MemDesc && m < profile->NumMemTypes && !r.IsError(); m++) {
+                EncMemDesc *memDesc = &profile->MemDesc[m];
+                FixNullArray(memDesc->ColorFormats, memDesc->NumColorFormats);
+                memDesc->ColorFormats = r.GetArray<mfxU32>(memDesc->NumColorFormats);
+            }
+        }
+    }
+
+    FixNullArray(vpp->Filters, vpp->NumFilters);
+    vpp->Filters = r.GetArray<VPPFilter>(vpp->NumFilters);
+    for (mfxU32 f = 0; vpp->Filters && f < vpp->NumFilters && !r.IsError(); f++) {
+        VPPFilter *filter = &vpp->Filters[f];
+        FixNullArray(filter->MemDesc, filter->NumMemTypes);
+        filter->MemDesc = r.GetArray<VPPMemDesc>(filter->NumMemTypes);
+        for (mfxU32 m = 0; filter->MemDesc && m < filter->NumMemTypes && !r.IsError(); m++) {
+            VPPMemDesc *memDesc = &filter->MemDesc[m];
+            FixNullArray(memDesc->Formats, memDesc->NumInFormats);
+            memDesc->Formats = r.GetArray<VPPFormat>(memDesc->NumInFormats);
+            for (mfxU32 n = 0; memDesc->Formats && n < memDesc->NumInFormats && !r.IsError();
+                 n++) {
+                VPPFormat *format = &memDesc->Formats[n];
+                FixNullArray(format->OutFormats, format->NumOutFormat);
+                format->OutFormats = r.GetArray<mfxU32>(format->NumOutFormat);
+            }
+        }
+    }
+
+    FixNullArray(accel->Mode, accel->NumAccelerationModes);
+    accel->Mode = r.GetArray<mfxAccelerationMode>(accel->NumAccelerationModes);
+
+    FixNullArray(pool->Policy, pool->NumPoolPolicies);
+    pool->Policy = r.GetArray<mfxPoolAllocationPolicy>(pool->NumPoolPolicies);
+
+    return (r.IsError() ? nullptr : implDesc);
+}
+
+static void WriteImplFuncs(CapsBlobWriter &w, const mfxImplementedFunctions *implFuncs) {
+    w.PutArray(implFuncs, 1);
+    if (!implFuncs)
+        return;
+
+    for (mfxU32 i = 0; i < implFuncs->NumFunctions; i++) {
+        const mfxChar *name = (implFuncs->FunctionsName ? implFuncs->FunctionsName[i] : nullptr);
+        w.PutArray(name, (name ? (mfxU32)strlen(name) + 1 : 0));
+    }
+}
+
+static mfxImplementedFunctions *ReadImplFuncs(CapsBlobReader &r) {
+    mfxU32 n                           = 0;
+    mfxImplementedFunctions *implFuncs = r.GetArrayAny<mfxImplementedFunctions>(n);
+    if (!implFuncs)
+        return nullptr;
+
+    implFuncs->FunctionsName = r.Alloc<mfxChar *>(implFuncs->NumFunctions);
+    for (mfxU32 i = 0; implFuncs->FunctionsName && i < implFuncs->NumFunctions; i++) {
+        mfxU32 len = 0;
+        mfxChar *name = r.GetArrayAny<mfxChar>(len);
+
+        // strings must be null-terminated
+        if (!name || name[len - 1] != 0) {
+            r.SetError();
+            return nullptr;
+        }
+        implFuncs->FunctionsName[i] = name;
+    }
+
+    return (r.IsError() ? nullptr : implFuncs);
+}
+
+CapsCacheVPL::CapsCacheVPL()
+        : m_cacheFile(),
+          m_entries(),
+          m_arena(),
+          m_bEnabled(false),
+          m_bModified(false),
+          m_dispLog(nullptr) {}
+
+CapsCacheVPL::~CapsCacheVPL() {}
+
+mfxStatus CapsCacheVPL::Init(const STRING_TYPE &cacheFile, DispatcherLogVPL *dispLog) {
+    m_cacheFile = cacheFile;
+    m_dispLog   = dispLog;
+    m_bEnabled  = true;
+    m_bModified = false;
+
+    // missing or invalid file is not an error - it will be rebuilt on Flush()
+    if (ReadFile() != MFX_ERR_NONE) {
+        DISP_LOG_MESSAGE(m_dispLog, "message:  caps cache empty or invalid, will be rebuilt");
+        m_entries.clear();
+    }
+
+    return MFX_ERR_NONE;
+}
+
+bool CapsCacheVPL::IsEnabled() const {
+    return m_bEnabled;
+}
+
+// file identity used to detect a changed library (e.g. driver update)
+mfxStatus CapsCacheVPL::GetFileKey(const STRING_TYPE &libNameFull, CacheEntry &entry) {
+#if defined(_WIN32) || defined(_WIN64)
+    struct _stat64 st = {};
+    if (_wstat64(libNameFull.c_str(), &st))
+        return MFX_ERR_NOT_FOUND;
+#else
+    struct stat st = {};
+    if (stat(libNameFull.c_str(), &st))
+        return MFX_ERR_NOT_FOUND;
+#endif
+
+    entry.fileSize    = (mfxU64)st.st_size;
+    entry.fileModTime = (mfxU64)st.st_mtime;
+    entry.fileID      = (mfxU64)st.st_ino;
+
+    return MFX_ERR_NONE;
+}
+
+CapsCacheVPL::CacheEntry *CapsCacheVPL::FindEntry(const STRING_TYPE &libNameFull) {
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const CacheEntry &e) {
+        return e.libNameFull == libNameFull;
+    });
+
+    return (it == m_entries.end() ? nullptr : &(*it));
+}
+
+bool CapsCacheVPL::HasLib(const STRING_TYPE &libNameFull, LibType &libType) {
+    if (!m_bEnabled)
+        return false;
+
+    CacheEntry *entry = FindEntry(libNameFull);
+    if (!entry)
+        return false;
+
+    CacheEntry key = {};
+    if (GetFileKey(libNameFull, key))
+        return false;
+
+    libType = (LibType)entry->libType;
+
+    return (entry->fileSize == key.fileSize && entry->fileModTime == key.fileModTime &&
+            entry->fileID == key.fileID);
+}
+
+mfxStatus CapsCacheVPL::GetLib(const STRING_TYPE &libNameFull,
+                               std::vector<CachedImplCaps> &implCaps) {
+    LibType libType = LibTypeUnknown;
+    if (!HasLib(libNameFull, libType))
+        return MFX_ERR_NOT_FOUND;
+
+    CacheEntry *entry = FindEntry(libNameFull);
+
+    // entries are only deserialized when used
+    if (!entry->bRestored) {
+        if (ParseBlob(*entry)) {
+            // corrupt entry - drop it so it is replaced after the normal query
+            m_entries.remove_if([&](const CacheEntry &e) {
+                return e.libNameFull == libNameFull;
+            });
+            m_bModified = true;
+            return MFX_ERR_UNSUPPORTED;
+        }
+        entry->bRestored = true;
+    }
+
+    implCaps = entry->implCaps;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CapsCacheVPL::AddLib(const STRING_TYPE &libNameFull,
+                               const std::list<ImplInfo *> &implInfoList) {
+    if (!m_bEnabled)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    if (implInfoList.empty())
+        return MFX_ERR_UNSUPPORTED;
+
+    CacheEntry entry = {};
+    if (GetFileKey(libNameFull, entry))
+        return MFX_ERR_NOT_FOUND;
+
+    LibInfo *libInfo = implInfoList.front()->libInfo;
+
+    entry.libNameFull = libNameFull;
+    entry.libType     = (mfxU32)libInfo->libType;
+    entry.bRestored   = false;
+
+    CapsBlobWriter w(entry.blob);
+    w.PutU32((mfxU32)implInfoList.size());
+
+    for (ImplInfo *implInfo : implInfoList) {
+        if (!implInfo->implDesc)
+            return MFX_ERR_UNSUPPORTED;
+
+        if (libInfo->libType == LibTypeMSDK) {
+            const LoaderCtxMSDK *msdkCtx = &(libInfo->msdkCtx[implInfo->msdkImplIdx]);
+            w.PutU32(implInfo->msdkImplIdx);
+            w.PutU32((mfxU32)msdkCtx->m_msdkAdapter);
+            w.PutU32((mfxU32)msdkCtx->m_msdkAdapterD3D9);
+        }
+        else {
+            w.PutU32(implInfo->libImplIdx);
+        }
+        WriteImplDesc(w, (mfxImplDescription *)implInfo->implDesc);
+        WriteImplFuncs(w, (mfxImplementedFunctions *)implInfo->implFuncs);
+#ifdef ONEVPL_EXPERIMENTAL
+        w.PutArray((mfxExtendedDeviceId *)implInfo->implExtDeviceID, 1);
+#endif
+    }
+
+    // replace any stale entry for this library
+    m_entries.remove_if([&](const CacheEntry &e) {
+        return e.libNameFull == libNameFull;
+    });
+    m_entries.push_back(entry);
+    m_bModified = true;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CapsCacheVPL::ParseBlob(CacheEntry &entry) {
+    CapsBlobReader r(entry.blob, m_arena);
+
+    mfxU32 numImpls = 0;
+    if (!r.GetU32(numImpls))
+        return MFX_ERR_UNSUPPORTED;
+
+    entry.implCaps.clear();
+    for (mfxU32 i = 0; i < numImpls; i++) {
+        CachedImplCaps caps = {};
+
+        if (!r.GetU32(caps.libImplIdx))
+            return MFX_ERR_UNSUPPORTED;
+
+        if (entry.libType == LibTypeMSDK) {
+            mfxU32 msdkAdapter = 0, msdkAdapterD3D9 = 0;
+            if (caps.libImplIdx >= MAX_NUM_IMPL_MSDK || !r.GetU32(msdkAdapter) ||
+                !r.GetU32(msdkAdapterD3D9))
+                return MFX_ERR_UNSUPPORTED;
+
+            caps.msdkAdapter     = (mfxIMPL)msdkAdapter;
+            caps.msdkAdapterD3D9 = (mfxIMPL)msdkAdapterD3D9;
+        }
+
+        caps.implDesc = ReadImplDesc(r);
+        if (!caps.implDesc)
+            return MFX_ERR_UNSUPPORTED;
+
+        caps.implFuncs = ReadImplFuncs(r);
+#ifdef ONEVPL_EXPERIMENTAL
+        mfxU32 n             = 0;
+        caps.implExtDeviceID = r.GetArrayAny<mfxExtendedDeviceId>(n);
+        if (n > 1)
+            return MFX_ERR_UNSUPPORTED;
+#endif
+        if (r.IsError())
+            return MFX_ERR_UNSUPPORTED;
+
+        entry.implCaps.push_back(caps);
+    }
+
+    if (!r.IsEnd())
+        return MFX_ERR_UNSUPPORTED;
+
+    return MFX_ERR_NONE;
+}
+
+static bool ReadValue(std::ifstream &f, void *p, size_t size) {
+    f.read(reinterpret_cast<char *>(p), size);
+    return (f.gcount() == (std::streamsize)size);
+}
+
+static void WriteValue(std::ofstream &f, const void *p, size_t size) {
+    f.write(reinterpret_cast<const char *>(p), size);
+}
+
+// cache files are not shared across builds with different struct layouts
+static CacheFileHeader GetExpectedHeader() {
+    CacheFileHeader hdr = {};
+
+    hdr.magic        = CAPS_CACHE_MAGIC;
+    hdr.version      = CAPS_CACHE_VERSION;
+    hdr.sizeImplDesc = (mfxU32)sizeof(mfxImplDescription);
+    hdr.sizePtr      = (mfxU32)sizeof(void *);
+    hdr.sizeChar     = (mfxU32)sizeof(CHAR_TYPE);
+    hdr.experimental = CAPS_CACHE_EXPERIMENTAL;
+
+    return hdr;
+}
+
+// sanity limits for data read from the cache file
+#define CAPS_CACHE_MAX_ENTRIES  1024
+#define CAPS_CACHE_MAX_BLOB_LEN (64 * 1024 * 1024)
+
+mfxStatus CapsCacheVPL::ReadFile() {
+    std::ifstream f(m_cacheFile.c_str(), std::ios::in | std::ios::binary);
+    if (!f.is_open())
+        return MFX_ERR_NOT_FOUND;
+
+    CacheFileHeader hdr      = {};
+    CacheFileHeader expected = GetExpectedHeader();
+    if (!ReadValue(f, &hdr, sizeof(hdr)) || memcmp(&hdr, &expected, sizeof(hdr)))
+        return MFX_ERR_UNSUPPORTED;
+
+    mfxU32 numEntries = 0;
+    if (!ReadValue(f, &numEntries, sizeof(numEntries)) || numEntries > CAPS_CACHE_MAX_ENTRIES)
+        return MFX_ERR_UNSUPPORTED;
+
+    for (mfxU32 i = 0; i < numEntries; i++) {
+        CacheEntry entry = {};
+        mfxU32 nameLen   = 0;
+        if (!ReadValue(f, &nameLen, sizeof(nameLen)) || nameLen == 0 ||
+            nameLen > MAX_VPL_SEARCH_PATH)
+            return MFX_ERR_UNSUPPORTED;
+
+        std::vector<CHAR_TYPE> name(nameLen);
+        if (!ReadValue(f, name.data(), nameLen * sizeof(CHAR_TYPE)))
+            return MFX_ERR_UNSUPPORTED;
+        entry.libNameFull.assign(name.data(), nameLen);
+
+        mfxU32 blobLen = 0;
+        if (!ReadValue(f, &entry.fileSize, sizeof(entry.fileSize)) ||
+            !ReadValue(f, &entry.fileModTime, sizeof(entry.fileModTime)) ||
+            !ReadValue(f, &entry.fileID, sizeof(entry.fileID)) ||
+            !ReadValue(f, &entry.libType, sizeof(entry.libType)) ||
+            (entry.libType != LibTypeVPL && entry.libType != LibTypeMSDK) ||
+            !ReadValue(f, &blobLen, sizeof(blobLen)) || blobLen > CAPS_CACHE_MAX_BLOB_LEN)
+            return MFX_ERR_UNSUPPORTED;
+
+        entry.blob.resize(blobLen);
+        if (blobLen && !ReadValue(f, entry.blob.data(), blobLen))
+            return MFX_ERR_UNSUPPORTED;
+
+        entry.bRestored = false;
+        m_entries.push_back(entry);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CapsCacheVPL::Flush() {
+    if (!m_bEnabled || !m_bModified)
+        return MFX_ERR_NONE;
+
+    // write to temporary file then rename, so concurrent processes
+    //   never see a partially written cache
+#if defined(_WIN32) || defined(_WIN64)
+    STRING_TYPE tmpFile = m_cacheFile + L"." + std::to_wstring(_getpid()) + L".tmp";
+#else
+    STRING_TYPE tmpFile = m_cacheFile + "." + std::to_string(getpid()) + ".tmp";
+#endif
+
+    {
+        std::ofstream f(tmpFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!f.is_open())
+            return MFX_ERR_UNSUPPORTED;
+
+        CacheFileHeader hdr = GetExpectedHeader();
+        WriteValue(f, &hdr, sizeof(hdr));
+
+        mfxU32 numEntries = (mfxU32)m_entries.size();
+        WriteValue(f, &numEntries, sizeof(numEntries));
+
+        for (const CacheEntry &entry : m_entries) {
+            mfxU32 nameLen = (mfxU32)entry.libNameFull.size();
+            WriteValue(f, &nameLen, sizeof(nameLen));
+            WriteValue(f, entry.libNameFull.data(), nameLen * sizeof(CHAR_TYPE));
+
+            WriteValue(f, &entry.fileSize, sizeof(entry.fileSize));
+            WriteValue(f, &entry.fileModTime, sizeof(entry.fileModTime));
+            WriteValue(f, &entry.fileID, sizeof(entry.fileID));
+            WriteValue(f, &entry.libType, sizeof(entry.libType));
+
+            mfxU32 blobLen = (mfxU32)entry.blob.size();
+            WriteValue(f, &blobLen, sizeof(blobLen));
+            WriteValue(f, entry.blob.data(), blobLen);
+        }
+
+        if (!f.good()) {
+            f.close();
+#if defined(_WIN32) || defined(_WIN64)
+            _wremove(tmpFile.c_str());
+#else
+            remove(tmpFile.c_str());
+#endif
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    // rename() does not replace an existing file on Windows
+    if (!MoveFileExW(tmpFile.c_str(), m_cacheFile.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        _wremove(tmpFile.c_str());
+        return MFX_ERR_UNSUPPORTED;
+    }
+#else
+    if (rename(tmpFile.c_str(), m_cacheFile.c_str())) {
+        remove(tmpFile.c_str());
+        return MFX_ERR_UNSUPPORTED;
+    }
+#endif
+
+    m_bModified = false;
+
+    return MFX_ERR_NONE;
+}
@@ -16,6 +16,7 @@
 //   based on what they support (codec types, etc.)
 ConfigCtxVPL::ConfigCtxVPL()
         : m_propVar(),
+          m_propGeneration(0),
           m_propRange32U(),
           m_implName(),
           m_implLicense(),
@@ -116,6 +117,11 @@ enum PropIdx {
     ePropSpecial_DeviceCopy,
     ePropSpecial_ExtBuffer,
     ePropSpecial_DXGIAdapterIndex,
+    ePropSpecial_FastStartPath,
+    ePropSpecial_SessionCostWidth,
+    ePropSpecial_SessionCostHeight,
+    ePropSpecial_SessionCostFrameRate,
+    ePropSpecial_SessionCostCodecID,
 
     // functions which must report as implemented
     ePropFunc_FunctionName,
@@ -190,6 +196,11 @@ static const PropVariant PropIdxTab[] = {
     { "ePropSpecial_DeviceCopy",            MFX_VARIANT_TYPE_U16 },
     { "ePropSpecial_ExtBuffer",             MFX_VARIANT_TYPE_PTR },
     { "ePropSpecial_DXGIAdapterIndex",      MFX_VARIANT_TYPE_U32 },
+    { "ePropSpecial_FastStartPath",         MFX_VARIANT_TYPE_PTR },
+    { "ePropSpecial_SessionCostWidth",      MFX_VARIANT_TYPE_U32 },
+    { "ePropSpecial_SessionCostHeight",     MFX_VARIANT_TYPE_U32 },
+    { "ePropSpecial_SessionCostFrameRate",  MFX_VARIANT_TYPE_U32 },
+    { "ePropSpecial_SessionCostCodecID",    MFX_VARIANT_TYPE_U32 },
 
     { "ePropFunc_FunctionName",             MFX_VARIANT_TYPE_PTR },
 };
@@ -204,6 +215,12 @@ static_assert((sizeof(PropIdxTab) / sizeof(PropVariant)) == eProp_TotalProps,
 static_assert(NUM_TOTAL_FILTER_PROPS == eProp_TotalProps,
               "NUM_TOTAL_FILTER_PROPS and eProp_TotalProps are misaligned");
 
+// store index of property matching the parsed name
+static __inline mfxStatus SetResolvedProp(mfxI32 &propIdx, mfxI32 idx) {
+    propIdx = idx;
+    return MFX_ERR_NONE;
+}
+
 mfxStatus ConfigCtxVPL::ValidateAndSetProp(mfxI32 idx, mfxVariant value) {
     if (idx < 0 || idx >= eProp_TotalProps)
         return MFX_ERR_NOT_FOUND;
@@ -284,6 +301,10 @@ mfxStatus ConfigCtxVPL::ValidateAndSetProp(mfxI32 idx, mfxVariant value) {
                 m_extDevNameStr         = (char *)(value.Data.Ptr);
                 m_propVar[idx].Data.Ptr = &(m_extDevNameStr);
                 break;
+            case ePropSpecial_FastStartPath:
+                m_fastStartPath         = (char *)(value.Data.Ptr);
+                m_propVar[idx].Data.Ptr = &(m_fastStartPath);
+                break;
             case ePropSpecial_ExtBuffer:
                 // Don't assume anything about the lifetime of input mfxExtBuffer in Data.Ptr
                 // Instead, we copy the full extBuf into a vector owned by ConfixCtxVPL and will pass this to MFXInitialize()
@@ -304,8 +325,8 @@ mfxStatus ConfigCtxVPL::ValidateAndSetProp(mfxI32 idx, mfxVariant value) {
     return MFX_ERR_NONE;
 }
 
-mfxStatus ConfigCtxVPL::SetFilterPropertyDec(std::list<std::string> &propParsedString,
-                                             mfxVariant value) {
+mfxStatus ConfigCtxVPL::ResolveFilterPropertyDec(std::list<std::string> &propParsedString,
+                                                 mfxI32 &propIdx) {
     std::string nextProp;
 
     nextProp = GetNextProp(propParsedString);
@@ -317,10 +338,10 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyDec(std::list<std::string> &propParsedS
     // parse 'decoder'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "CodecID") {
-        return ValidateAndSetProp(ePropDec_CodecID, value);
+        return SetResolvedProp(propIdx, ePropDec_CodecID);
     }
     else if (nextProp == "MaxcodecLevel") {
-        return ValidateAndSetProp(ePropDec_MaxcodecLevel, value);
+        return SetResolvedProp(propIdx, ePropDec_MaxcodecLevel);
     }
     else if (nextProp != "decprofile") {
         return MFX_ERR_NOT_FOUND;
@@ -329,7 +350,7 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyDec(std::list<std::string> &propParsedS
     // parse 'decprofile'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "Profile") {
-        return ValidateAndSetProp(ePropDec_Profile, value);
+        return SetResolvedProp(propIdx, ePropDec_Profile);
     }
     else if (nextProp != "decmemdesc") {
         return MFX_ERR_NOT_FOUND;
@@ -338,24 +359,24 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyDec(std::list<std::string> &propParsedS
     // parse 'decmemdesc'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "MemHandleType") {
-        return ValidateAndSetProp(ePropDec_MemHandleType, value);
+        return SetResolvedProp(propIdx, ePropDec_MemHandleType);
     }
     else if (nextProp == "Width") {
-        return ValidateAndSetProp(ePropDec_Width, value);
+        return SetResolvedProp(propIdx, ePropDec_Width);
     }
     else if (nextProp == "Height") {
-        return ValidateAndSetProp(ePropDec_Height, value);
+        return SetResolvedProp(propIdx, ePropDec_Height);
     }
     else if (nextProp == "ColorFormat" || nextProp == "ColorFormats") {
-        return ValidateAndSetProp(ePropDec_ColorFormats, value);
+        return SetResolvedProp(propIdx, ePropDec_ColorFormats);
     }
 
     // end of mfxDecoderDescription options
     return MFX_ERR_NOT_FOUND;
 }
 
-mfxStatus ConfigCtxVPL::SetFilterPropertyEnc(std::list<std::string> &propParsedString,
-                                             mfxVariant value) {
+mfxStatus ConfigCtxVPL::ResolveFilterPropertyEnc(std::list<std::string> &propParsedString,
+                                                 mfxI32 &propIdx) {
     std::string nextProp;
 
     nextProp = GetNextProp(propParsedString);
@@ -367,17 +388,17 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyEnc(std::list<std::string> &propParsedS
     // parse 'encoder'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "CodecID") {
-        return ValidateAndSetProp(ePropEnc_CodecID, value);
+        return SetResolvedProp(propIdx, ePropEnc_CodecID);
     }
     else if (nextProp == "MaxcodecLevel") {
-        return ValidateAndSetProp(ePropEnc_MaxcodecLevel, value);
+        return SetResolvedProp(propIdx, ePropEnc_MaxcodecLevel);
     }
     else if (nextProp == "BiDirectionalPrediction") {
-        return ValidateAndSetProp(ePropEnc_BiDirectionalPrediction, value);
+        return SetResolvedProp(propIdx, ePropEnc_BiDirectionalPrediction);
     }
 #ifdef ONEVPL_EXPERIMENTAL
     else if (nextProp == "ReportedStats") {
-        return ValidateAndSetProp(ePropEnc_ReportedStats, value);
+        return SetResolvedProp(propIdx, ePropEnc_ReportedStats);
     }
 #endif
     else if (nextProp != "encprofile") {
@@ -387,7 +408,7 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyEnc(std::list<std::string> &propParsedS
     // parse 'encprofile'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "Profile") {
-        return ValidateAndSetProp(ePropEnc_Profile, value);
+        return SetResolvedProp(propIdx, ePropEnc_Profile);
     }
     else if (nextProp != "encmemdesc") {
         return MFX_ERR_NOT_FOUND;
@@ -396,24 +417,24 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyEnc(std::list<std::string> &propParsedS
     // parse 'encmemdesc'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "MemHandleType") {
-        return ValidateAndSetProp(ePropEnc_MemHandleType, value);
+        return SetResolvedProp(propIdx, ePropEnc_MemHandleType);
     }
     else if (nextProp == "Width") {
-        return ValidateAndSetProp(ePropEnc_Width, value);
+        return SetResolvedProp(propIdx, ePropEnc_Width);
     }
     else if (nextProp == "Height") {
-        return ValidateAndSetProp(ePropEnc_Height, value);
+        return SetResolvedProp(propIdx, ePropEnc_Height);
     }
     else if (nextProp == "ColorFormat" || nextProp == "ColorFormats") {
-        return ValidateAndSetProp(ePropEnc_ColorFormats, value);
+        return SetResolvedProp(propIdx, ePropEnc_ColorFormats);
     }
 
     // end of mfxEncoderDescription options
     return MFX_ERR_NOT_FOUND;
 }
 
-mfxStatus ConfigCtxVPL::SetFilterPropertyVPP(std::list<std::string> &propParsedString,
-                                             mfxVariant value) {
+mfxStatus ConfigCtxVPL::ResolveFilterPropertyVPP(std::list<std::string> &propParsedString,
+                                                 mfxI32 &propIdx) {
     std::string nextProp;
 
     nextProp = GetNextProp(propParsedString);
@@ -425,10 +446,10 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyVPP(std::list<std::string> &propParsedS
     // parse 'filter'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "FilterFourCC") {
-        return ValidateAndSetProp(ePropVPP_FilterFourCC, value);
+        return SetResolvedProp(propIdx, ePropVPP_FilterFourCC);
     }
     else if (nextProp == "MaxDelayInFrames") {
-        return ValidateAndSetProp(ePropVPP_MaxDelayInFrames, value);
+        return SetResolvedProp(propIdx, ePropVPP_MaxDelayInFrames);
     }
     else if (nextProp != "memdesc") {
         return MFX_ERR_NOT_FOUND;
@@ -437,13 +458,13 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyVPP(std::list<std::string> &propParsedS
     // parse 'memdesc'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "MemHandleType") {
-        return ValidateAndSetProp(ePropVPP_MemHandleType, value);
+        return SetResolvedProp(propIdx, ePropVPP_MemHandleType);
     }
     else if (nextProp == "Width") {
-        return ValidateAndSetProp(ePropVPP_Width, value);
+        return SetResolvedProp(propIdx, ePropVPP_Width);
     }
     else if (nextProp == "Height") {
-        return ValidateAndSetProp(ePropVPP_Height, value);
+        return SetResolvedProp(propIdx, ePropVPP_Height);
     }
     else if (nextProp != "format") {
         return MFX_ERR_NOT_FOUND;
@@ -452,10 +473,10 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyVPP(std::list<std::string> &propParsedS
     // parse 'format'
     nextProp = GetNextProp(propParsedString);
     if (nextProp == "InFormat") {
-        return ValidateAndSetProp(ePropVPP_InFormat, value);
+        return SetResolvedProp(propIdx, ePropVPP_InFormat);
     }
     else if (nextProp == "OutFormat" || nextProp == "OutFormats") {
-        return ValidateAndSetProp(ePropVPP_OutFormat, value);
+        return SetResolvedProp(propIdx, ePropVPP_OutFormat);
     }
 
     // end of mfxVPPDescription options
@@ -466,6 +487,33 @@ mfxStatus ConfigCtxVPL::SetFilterPropertyVPP(std::list<std::string> &propParsedS
 //   MFX_ERR_NOT_FOUND - name contains unknown parameter name
 //   MFX_ERR_UNSUPPORTED - value data type != parameter with provided name
 mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
+    mfxI32 propIdx = -1;
+
+    mfxStatus sts = ResolveFilterProperty(name, propIdx);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    return SetFilterPropertyById((mfxU32)propIdx, value);
+}
+
+// set property by index returned from ResolveFilterProperty()
+mfxStatus ConfigCtxVPL::SetFilterPropertyById(mfxU32 propIdx, mfxVariant value) {
+    if (propIdx >= eProp_TotalProps)
+        return MFX_ERR_NOT_FOUND;
+
+    // a failed call may still unset the property, so always treat the config as changed
+    m_propGeneration++;
+
+    // DeviceID string is resolved to the same index as the U16 version
+    if (propIdx == ePropDevice_DeviceID && value.Type == MFX_VARIANT_TYPE_PTR)
+        propIdx = ePropDevice_DeviceIDStr;
+
+    return ValidateAndSetProp((mfxI32)propIdx, value);
+}
+
+// map property name to index in the list of filter properties
+// this only parses the name, value is validated when the property is set
+mfxStatus ConfigCtxVPL::ResolveFilterProperty(const mfxU8 *name, mfxI32 &propIdx) {
     if (!name)
         return MFX_ERR_NULL_PTR;
 
@@ -485,37 +533,53 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
 
     // check for special-case properties, not part of mfxImplDescription
     if (nextProp == "mfxHandleType") {
-        return ValidateAndSetProp(ePropSpecial_HandleType, value);
+        return SetResolvedProp(propIdx, ePropSpecial_HandleType);
     }
     else if (nextProp == "mfxHDL") {
-        return ValidateAndSetProp(ePropSpecial_Handle, value);
+        return SetResolvedProp(propIdx, ePropSpecial_Handle);
     }
     else if (nextProp == "NumThread") {
-        return ValidateAndSetProp(ePropSpecial_NumThread, value);
+        return SetResolvedProp(propIdx, ePropSpecial_NumThread);
     }
 #ifdef ONEVPL_EXPERIMENTAL
     else if (nextProp == "DeviceCopy") {
-        return ValidateAndSetProp(ePropSpecial_DeviceCopy, value);
+        return SetResolvedProp(propIdx, ePropSpecial_DeviceCopy);
     }
 #endif
     else if (nextProp == "ExtBuffer") {
-        return ValidateAndSetProp(ePropSpecial_ExtBuffer, value);
+        return SetResolvedProp(propIdx, ePropSpecial_ExtBuffer);
     }
     else if (nextProp == "DXGIAdapterIndex") {
 #if defined(_WIN32) || defined(_WIN64)
         // this property is only valid on Windows
-        return ValidateAndSetProp(ePropSpecial_DXGIAdapterIndex, value);
+        return SetResolvedProp(propIdx, ePropSpecial_DXGIAdapterIndex);
 #else
         return MFX_ERR_NOT_FOUND;
 #endif
     }
+    else if (nextProp == "FastStartPath") {
+        return SetResolvedProp(propIdx, ePropSpecial_FastStartPath);
+    }
+    else if (nextProp == "SessionCost") {
+        // declared workload of the session, used by admission control
+        nextProp = GetNextProp(propParsedString);
+        if (nextProp == "Width")
+            return SetResolvedProp(propIdx, ePropSpecial_SessionCostWidth);
+        else if (nextProp == "Height")
+            return SetResolvedProp(propIdx, ePropSpecial_SessionCostHeight);
+        else if (nextProp == "FrameRate")
+            return SetResolvedProp(propIdx, ePropSpecial_SessionCostFrameRate);
+        else if (nextProp == "CodecID")
+            return SetResolvedProp(propIdx, ePropSpecial_SessionCostCodecID);
+        return MFX_ERR_NOT_FOUND;
+    }
 
     // to require that a specific function is implemented, use the property name
     //   "mfxImplementedFunctions.FunctionsName"
     if (nextProp == "mfxImplementedFunctions") {
         nextProp = GetNextProp(propParsedString);
         if (nextProp == "FunctionsName") {
-            return ValidateAndSetProp(ePropFunc_FunctionName, value);
+            return SetResolvedProp(propIdx, ePropFunc_FunctionName);
         }
         return MFX_ERR_NOT_FOUND;
     }
@@ -525,37 +589,37 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
     if (nextProp == "mfxExtendedDeviceId") {
         nextProp = GetNextProp(propParsedString);
         if (nextProp == "VendorID") {
-            return ValidateAndSetProp(ePropExtDev_VendorID, value);
+            return SetResolvedProp(propIdx, ePropExtDev_VendorID);
         }
         else if (nextProp == "DeviceID") {
-            return ValidateAndSetProp(ePropExtDev_DeviceID, value);
+            return SetResolvedProp(propIdx, ePropExtDev_DeviceID);
         }
         else if (nextProp == "PCIDomain") {
-            return ValidateAndSetProp(ePropExtDev_PCIDomain, value);
+            return SetResolvedProp(propIdx, ePropExtDev_PCIDomain);
         }
         else if (nextProp == "PCIBus") {
-            return ValidateAndSetProp(ePropExtDev_PCIBus, value);
+            return SetResolvedProp(propIdx, ePropExtDev_PCIBus);
         }
         else if (nextProp == "PCIDevice") {
-            return ValidateAndSetProp(ePropExtDev_PCIDevice, value);
+            return SetResolvedProp(propIdx, ePropExtDev_PCIDevice);
         }
         else if (nextProp == "PCIFunction") {
-            return ValidateAndSetProp(ePropExtDev_PCIFunction, value);
+            return SetResolvedProp(propIdx, ePropExtDev_PCIFunction);
         }
         else if (nextProp == "DeviceLUID") {
-            return ValidateAndSetProp(ePropExtDev_DeviceLUID, value);
+            return SetResolvedProp(propIdx, ePropExtDev_DeviceLUID);
         }
         else if (nextProp == "LUIDDeviceNodeMask") {
-            return ValidateAndSetProp(ePropExtDev_LUIDDeviceNodeMask, value);
+            return SetResolvedProp(propIdx, ePropExtDev_LUIDDeviceNodeMask);
         }
         else if (nextProp == "DRMRenderNodeNum") {
-            return ValidateAndSetProp(ePropExtDev_DRMRenderNodeNum, value);
+            return SetResolvedProp(propIdx, ePropExtDev_DRMRenderNodeNum);
         }
         else if (nextProp == "DRMPrimaryNodeNum") {
-            return ValidateAndSetProp(ePropExtDev_DRMPrimaryNodeNum, value);
+            return SetResolvedProp(propIdx, ePropExtDev_DRMPrimaryNodeNum);
         }
         else if (nextProp == "DeviceName") {
-            return ValidateAndSetProp(ePropExtDev_DeviceName, value);
+            return SetResolvedProp(propIdx, ePropExtDev_DeviceName);
         }
         return MFX_ERR_NOT_FOUND;
     }
@@ -571,40 +635,40 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
 
     // property is a top-level member of mfxImplDescription
     if (nextProp == "Impl") {
-        return ValidateAndSetProp(ePropMain_Impl, value);
+        return SetResolvedProp(propIdx, ePropMain_Impl);
     }
     else if (nextProp == "AccelerationMode") {
-        return ValidateAndSetProp(ePropMain_AccelerationMode, value);
+        return SetResolvedProp(propIdx, ePropMain_AccelerationMode);
     }
     else if (nextProp == "mfxSurfacePoolMode") {
-        return ValidateAndSetProp(ePropMain_PoolAllocationPolicy, value);
+        return SetResolvedProp(propIdx, ePropMain_PoolAllocationPolicy);
     }
     else if (nextProp == "ApiVersion") {
         // ApiVersion may be passed as single U32 (Version) or two U16's (Major, Minor)
         nextProp = GetNextProp(propParsedString);
         if (nextProp == "Version")
-            return ValidateAndSetProp(ePropMain_ApiVersion, value);
+            return SetResolvedProp(propIdx, ePropMain_ApiVersion);
         else if (nextProp == "Major")
-            return ValidateAndSetProp(ePropMain_ApiVersion_Major, value);
+            return SetResolvedProp(propIdx, ePropMain_ApiVersion_Major);
         else if (nextProp == "Minor")
-            return ValidateAndSetProp(ePropMain_ApiVersion_Minor, value);
+            return SetResolvedProp(propIdx, ePropMain_ApiVersion_Minor);
         else
             return MFX_ERR_NOT_FOUND;
     }
     else if (nextProp == "VendorID") {
-        return ValidateAndSetProp(ePropMain_VendorID, value);
+        return SetResolvedProp(propIdx, ePropMain_VendorID);
     }
     else if (nextProp == "ImplName") {
-        return ValidateAndSetProp(ePropMain_ImplName, value);
+        return SetResolvedProp(propIdx, ePropMain_ImplName);
     }
     else if (nextProp == "License") {
-        return ValidateAndSetProp(ePropMain_License, value);
+        return SetResolvedProp(propIdx, ePropMain_License);
     }
     else if (nextProp == "Keywords") {
-        return ValidateAndSetProp(ePropMain_Keywords, value);
+        return SetResolvedProp(propIdx, ePropMain_Keywords);
     }
     else if (nextProp == "VendorImplID") {
-        return ValidateAndSetProp(ePropMain_VendorImplID, value);
+        return SetResolvedProp(propIdx, ePropMain_VendorImplID);
     }
 
     // property is a member of mfxDeviceDescription
@@ -615,16 +679,14 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
             nextProp = GetNextProp(propParsedString);
 
         // special case - deviceID may be passed as U16 (default) or string (since API 2.4)
-        // for compatibility, both are supported (value.Type distinguishes between them)
+        // for compatibility, both are supported (value.Type distinguishes between them
+        //   when the property is set, see SetFilterPropertyById)
         if (nextProp == "DeviceID") {
-            if (value.Type == MFX_VARIANT_TYPE_PTR)
-                return ValidateAndSetProp(ePropDevice_DeviceIDStr, value);
-            else
-                return ValidateAndSetProp(ePropDevice_DeviceID, value);
+            return SetResolvedProp(propIdx, ePropDevice_DeviceID);
         }
 
         if (nextProp == "MediaAdapterType") {
-            return ValidateAndSetProp(ePropDevice_MediaAdapterType, value);
+            return SetResolvedProp(propIdx, ePropDevice_MediaAdapterType);
         }
 
         return MFX_ERR_NOT_FOUND;
@@ -632,15 +694,15 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
 
     // property is a member of mfxDecoderDescription
     if (nextProp == "mfxDecoderDescription") {
-        return SetFilterPropertyDec(propParsedString, value);
+        return ResolveFilterPropertyDec(propParsedString, propIdx);
     }
 
     if (nextProp == "mfxEncoderDescription") {
-        return SetFilterPropertyEnc(propParsedString, value);
+        return ResolveFilterPropertyEnc(propParsedString, propIdx);
     }
 
     if (nextProp == "mfxVPPDescription") {
-        return SetFilterPropertyVPP(propParsedString, value);
+        return ResolveFilterPropertyVPP(propParsedString, propIdx);
     }
 
     return MFX_ERR_NOT_FOUND;
@@ -654,7 +716,7 @@ mfxStatus ConfigCtxVPL::SetFilterProperty(const mfxU8 *name, mfxVariant value) {
     }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsDec(const mfxImplDescription *libImplDesc,
-                                               std::list<DecConfig> &decConfigList) {
+                                               std::vector<DecConfig> &decConfigList) {
     mfxU32 codecIdx   = 0;
     mfxU32 profileIdx = 0;
     mfxU32 memIdx     = 0;
@@ -696,7 +758,7 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsDec(const mfxImplDescription *libImpl
 }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsEnc(const mfxImplDescription *libImplDesc,
-                                               std::list<EncConfig> &encConfigList) {
+                                               std::vector<EncConfig> &encConfigList) {
     mfxU32 codecIdx   = 0;
     mfxU32 profileIdx = 0;
     mfxU32 memIdx     = 0;
@@ -758,7 +820,7 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsEnc(const mfxImplDescription *libImpl
 }
 
 mfxStatus ConfigCtxVPL::GetFlatDescriptionsVPP(const mfxImplDescription *libImplDesc,
-                                               std::list<VPPConfig> &vppConfigList) {
+                                               std::vector<VPPConfig> &vppConfigList) {
     mfxU32 filterIdx = 0;
     mfxU32 memIdx    = 0;
     mfxU32 inFmtIdx  = 0;
@@ -799,6 +861,98 @@ mfxStatus ConfigCtxVPL::GetFlatDescriptionsVPP(const mfxImplDescription *libImpl
     return MFX_ERR_NONE;
 }
 
+// copy flattened configs into the arena, sorted by key, and build one range per key
+// stable sort keeps the original description order within each range
+template <typename T>
+static void StoreFlatCaps(std::vector<T> &configList,
+                          mfxU32 T::*key,
+                          ArenaVPL *arena,
+                          FlatCapsList<T> &flat) {
+    std::stable_sort(configList.begin(), configList.end(), [key](const T &a, const T &b) {
+        return a.*key < b.*key;
+    });
+
+    flat.numConfigs = (mfxU32)configList.size();
+    flat.configs    = arena->Alloc<T>(flat.numConfigs);
+    std::copy(configList.begin(), configList.end(), flat.configs);
+
+    flat.numRanges = 0;
+    for (mfxU32 i = 0; i < flat.numConfigs; i++) {
+        if (i == 0 || flat.configs[i].*key != flat.configs[i - 1].*key)
+            flat.numRanges++;
+    }
+
+    flat.ranges = arena->Alloc<FlatCapsRange>(flat.numRanges);
+    mfxU32 r    = 0;
+    for (mfxU32 i = 0; i < flat.numConfigs; i++) {
+        if (i > 0 && flat.configs[i].*key == flat.configs[i - 1].*key) {
+            flat.ranges[r - 1].count++;
+            continue;
+        }
+        flat.ranges[r].key   = flat.configs[i].*key;
+        flat.ranges[r].first = i;
+        flat.ranges[r].count = 1;
+        r++;
+    }
+}
+
+// generate flattened configs, grouped by CodecID or FilterFourCC
+void ConfigCtxVPL::BuildFlatCaps(const mfxImplDescription *libImplDesc,
+                                 FlatCapsVPL *flatCaps,
+                                 bool bDec,
+                                 bool bEnc,
+                                 bool bVPP) {
+    if (bDec && !flatCaps->bDecFlat) {
+        std::vector<DecConfig> decConfigList;
+        GetFlatDescriptionsDec(libImplDesc, decConfigList);
+        StoreFlatCaps(decConfigList, &DecConfig::CodecID, flatCaps->arena, flatCaps->dec);
+        flatCaps->bDecFlat = true;
+    }
+
+    if (bEnc && !flatCaps->bEncFlat) {
+        std::vector<EncConfig> encConfigList;
+        GetFlatDescriptionsEnc(libImplDesc, encConfigList);
+        StoreFlatCaps(encConfigList, &EncConfig::CodecID, flatCaps->arena, flatCaps->enc);
+        flatCaps->bEncFlat = true;
+    }
+
+    if (bVPP && !flatCaps->bVPPFlat) {
+        std::vector<VPPConfig> vppConfigList;
+        GetFlatDescriptionsVPP(libImplDesc, vppConfigList);
+        StoreFlatCaps(vppConfigList, &VPPConfig::FilterFourCC, flatCaps->arena, flatCaps->vpp);
+        flatCaps->bVPPFlat = true;
+    }
+}
+
+// return range of candidate entries for the requested key (all entries if key is not set)
+// returns false if the key is set but no entries match
+template <typename T>
+static bool GetFlatCapsCandidates(const mfxVariant &keyProp,
+                                  const FlatCapsList<T> &flat,
+                                  mfxU32 &first,
+                                  mfxU32 &count) {
+    first = 0;
+    count = flat.numConfigs;
+    if (keyProp.Type == MFX_VARIANT_TYPE_UNSET)
+        return true;
+
+    const FlatCapsRange *begin = flat.ranges;
+    const FlatCapsRange *end   = flat.ranges + flat.numRanges;
+    const FlatCapsRange *it =
+        std::lower_bound(begin,
+                         end,
+                         keyProp.Data.U32,
+                         [](const FlatCapsRange &range, mfxU32 key) {
+                             return range.key < key;
+                         });
+    if (it == end || it->key != keyProp.Data.U32)
+        return false;
+
+    first = it->first;
+    count = it->count;
+    return true;
+}
+
 #define CHECK_PROP(idx, type, val)                             \
     if ((cfgPropsAll[(idx)].Type != MFX_VARIANT_TYPE_UNSET) && \
         (cfgPropsAll[(idx)].Data.type != val))                 \
@@ -921,11 +1075,14 @@ mfxStatus ConfigCtxVPL::CheckPropsGeneral(const mfxVariant cfgPropsAll[],
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsDec(const mfxVariant cfgPropsAll[],
-                                      std::list<DecConfig> decConfigList) {
-    auto it = decConfigList.begin();
-    while (it != decConfigList.end()) {
-        DecConfig dc      = (DecConfig)(*it);
-        bool isCompatible = true;
+                                      const FlatCapsVPL &flatCaps) {
+    mfxU32 first = 0, count = 0;
+    if (!GetFlatCapsCandidates(cfgPropsAll[ePropDec_CodecID], flatCaps.dec, first, count))
+        return MFX_ERR_UNSUPPORTED;
+
+    for (mfxU32 i = first; i < first + count; i++) {
+        const DecConfig &dc = flatCaps.dec.configs[i];
+        bool isCompatible   = true;
 
         // check if this decode description includes
         //   all of the required decoder properties
@@ -958,19 +1115,20 @@ mfxStatus ConfigCtxVPL::CheckPropsDec(const mfxVariant cfgPropsAll[],
 
         if (isCompatible == true)
             return MFX_ERR_NONE;
-
-        it++;
     }
 
     return MFX_ERR_UNSUPPORTED;
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsEnc(const mfxVariant cfgPropsAll[],
-                                      std::list<EncConfig> encConfigList) {
-    auto it = encConfigList.begin();
-    while (it != encConfigList.end()) {
-        EncConfig ec      = (EncConfig)(*it);
-        bool isCompatible = true;
+                                      const FlatCapsVPL &flatCaps) {
+    mfxU32 first = 0, count = 0;
+    if (!GetFlatCapsCandidates(cfgPropsAll[ePropEnc_CodecID], flatCaps.enc, first, count))
+        return MFX_ERR_UNSUPPORTED;
+
+    for (mfxU32 i = first; i < first + count; i++) {
+        const EncConfig &ec = flatCaps.enc.configs[i];
+        bool isCompatible   = true;
 
         // check if this encode description includes
         //   all of the required encoder properties
@@ -1012,19 +1170,20 @@ mfxStatus ConfigCtxVPL::CheckPropsEnc(const mfxVariant cfgPropsAll[],
 
         if (isCompatible == true)
             return MFX_ERR_NONE;
-
-        it++;
     }
 
     return MFX_ERR_UNSUPPORTED;
 }
 
 mfxStatus ConfigCtxVPL::CheckPropsVPP(const mfxVariant cfgPropsAll[],
-                                      std::list<VPPConfig> vppConfigList) {
-    auto it = vppConfigList.begin();
-    while (it != vppConfigList.end()) {
-        VPPConfig vc      = (VPPConfig)(*it);
-        bool isCompatible = true;
+                                      const FlatCapsVPL &flatCaps) {
+    mfxU32 first = 0, count = 0;
+    if (!GetFlatCapsCandidates(cfgPropsAll[ePropVPP_FilterFourCC], flatCaps.vpp, first, count))
+        return MFX_ERR_UNSUPPORTED;
+
+    for (mfxU32 i = first; i < first + count; i++) {
+        const VPPConfig &vc = flatCaps.vpp.configs[i];
+        bool isCompatible   = true;
 
         // check if this filter description includes
         //   all of the required VPP properties
@@ -1057,8 +1216,6 @@ mfxStatus ConfigCtxVPL::CheckPropsVPP(const mfxVariant cfgPropsAll[],
 
         if (isCompatible == true)
             return MFX_ERR_NONE;
-
-        it++;
     }
 
     return MFX_ERR_UNSUPPORTED;
@@ -1163,6 +1320,87 @@ mfxStatus ConfigCtxVPL::CheckPropString(const mfxChar *implString, const std::st
     return MFX_ERR_NONE;
 }
 
+mfxStatus ConfigCtxVPL::CheckConfigProps(const ConfigCtxVPL *config,
+                                         const mfxVariant cfgPropsAll[],
+                                         const mfxImplDescription *libImplDesc,
+                                         const mfxImplementedFunctions *libImplFuncs,
+#ifdef ONEVPL_EXPERIMENTAL
+                                         const mfxExtendedDeviceId *libImplExtDevID,
+#endif
+                                         LibType libType,
+                                         FlatCapsVPL *flatCaps) {
+    bool decRequested    = false;
+    bool encRequested    = false;
+    bool vppRequested    = false;
+    bool extDevRequested = false;
+
+    for (mfxU32 idx = 0; idx < eProp_TotalProps; idx++) {
+        if (cfgPropsAll[idx].Type == MFX_VARIANT_TYPE_UNSET)
+            continue;
+
+        if (idx >= ePropDec_CodecID && idx <= ePropDec_ColorFormats)
+            decRequested = true;
+        else if (idx >= ePropEnc_CodecID && idx <= ePropEnc_ColorFormats)
+            encRequested = true;
+        else if (idx >= ePropVPP_FilterFourCC && idx <= ePropVPP_OutFormat)
+            vppRequested = true;
+        else if (idx >= ePropExtDev_VendorID && idx <= ePropExtDev_DeviceName)
+            extDevRequested = true;
+    }
+
+    if (CheckPropsGeneral(cfgPropsAll, libImplDesc))
+        return MFX_ERR_UNSUPPORTED;
+
+#ifdef ONEVPL_EXPERIMENTAL
+    if (extDevRequested) {
+        // fail if extDevID is not available (null) or if prop is not supported
+        if (!libImplExtDevID || CheckPropsExtDevID(cfgPropsAll, libImplExtDevID))
+            return MFX_ERR_UNSUPPORTED;
+    }
+#else
+    if (extDevRequested)
+        return MFX_ERR_UNSUPPORTED;
+#endif
+
+    // MSDK RT compatibility mode (1.x) does not provide Dec/Enc/VPP caps
+    // ignore these filters if set (do not use them to _exclude_ the library)
+    if (libType != LibTypeMSDK) {
+        BuildFlatCaps(libImplDesc, flatCaps, decRequested, encRequested, vppRequested);
+
+        if (decRequested && CheckPropsDec(cfgPropsAll, *flatCaps))
+            return MFX_ERR_UNSUPPORTED;
+
+        if (encRequested && CheckPropsEnc(cfgPropsAll, *flatCaps))
+            return MFX_ERR_UNSUPPORTED;
+
+        if (vppRequested && CheckPropsVPP(cfgPropsAll, *flatCaps))
+            return MFX_ERR_UNSUPPORTED;
+    }
+
+    // check whether required function is implemented
+    if (config->m_propVar[ePropFunc_FunctionName].Type != MFX_VARIANT_TYPE_UNSET) {
+        if (!libImplFuncs) {
+            // library did not provide list of implemented functions
+            return MFX_ERR_UNSUPPORTED;
+        }
+
+        mfxU32 fnIdx;
+        for (fnIdx = 0; fnIdx < libImplFuncs->NumFunctions; fnIdx++) {
+            if (config->m_implFunctionName == libImplFuncs->FunctionsName[fnIdx])
+                break;
+        }
+
+        if (fnIdx == libImplFuncs->NumFunctions)
+            return MFX_ERR_UNSUPPORTED;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+// if matchCache is provided, configs which have not changed since they last matched
+//   this implementation are not checked again
+// special (non-filtering) properties and the API version are always collected from
+//   every config since they may be combined across configs
 mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
                                        const mfxImplementedFunctions *libImplFuncs,
 #ifdef ONEVPL_EXPERIMENTAL
@@ -1170,31 +1408,23 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
 #endif
                                        std::list<ConfigCtxVPL *> configCtxList,
                                        LibType libType,
-                                       SpecialConfig *specialConfig) {
+                                       SpecialConfig *specialConfig,
+                                       FlatCapsVPL *implFlatCaps,
+                                       ConfigMatchCache *matchCache) {
     mfxU32 idx;
-    bool decRequested    = false;
-    bool encRequested    = false;
-    bool vppRequested    = false;
-    bool extDevRequested = false;
 
     bool bImplValid = true;
 
     if (!libImplDesc)
         return MFX_ERR_NULL_PTR;
 
-    std::list<DecConfig> decConfigList;
-    std::list<EncConfig> encConfigList;
-    std::list<VPPConfig> vppConfigList;
-
-    // generate "flat" descriptions of each combination
-    //   (e.g. multiple profiles from the same codec)
-    GetFlatDescriptionsDec(libImplDesc, decConfigList);
-    GetFlatDescriptionsEnc(libImplDesc, encConfigList);
-    GetFlatDescriptionsVPP(libImplDesc, vppConfigList);
-
-    // list of functions required to be implemented
-    std::list<std::string> implFunctionList;
-    implFunctionList.clear();
+    // "flat" descriptions of each combination (e.g. multiple profiles from the same codec)
+    // these are only generated if a filter references the corresponding caps
+    // if the caller does not keep them with the implementation, use temporary storage
+    ArenaVPL localArena;
+    FlatCapsVPL localFlatCaps;
+    localFlatCaps.arena   = &localArena;
+    FlatCapsVPL *flatCaps = ((implFlatCaps && implFlatCaps->arena) ? implFlatCaps : &localFlatCaps);
 
     // check requested API version
     mfxVersion reqVersion = {};
@@ -1223,54 +1453,45 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
             if (config->m_propVar[idx].Type == MFX_VARIANT_TYPE_UNSET)
                 continue;
 
-            // if property is required function, add to list which will be checked below
-            if (idx == ePropFunc_FunctionName) {
-                implFunctionList.push_back(config->m_implFunctionName);
+            // required function name is checked against m_implFunctionName
+            if (idx == ePropFunc_FunctionName)
                 continue;
-            }
 
             cfgPropsAll[idx].Type = config->m_propVar[idx].Type;
             cfgPropsAll[idx].Data = config->m_propVar[idx].Data;
-
-            if (idx >= ePropDec_CodecID && idx <= ePropDec_ColorFormats)
-                decRequested = true;
-            else if (idx >= ePropEnc_CodecID && idx <= ePropEnc_ColorFormats)
-                encRequested = true;
-            else if (idx >= ePropVPP_FilterFourCC && idx <= ePropVPP_OutFormat)
-                vppRequested = true;
-            else if (idx >= ePropExtDev_VendorID && idx <= ePropExtDev_DeviceName)
-                extDevRequested = true;
         }
 
         // if already marked invalid, no need to check props again
         // however we still need to iterate over all of the config objects
         //   to get any non-filtering properties (returned in SpecialConfig)
         if (bImplValid == true) {
-            if (CheckPropsGeneral(cfgPropsAll, libImplDesc))
-                bImplValid = false;
+            bool bCachedMatch = false;
+            if (matchCache) {
+                auto cached  = matchCache->matchGen.find(config);
+                bCachedMatch = (cached != matchCache->matchGen.end() &&
+                                cached->second == config->GetPropGeneration());
+            }
 
-#ifdef ONEVPL_EXPERIMENTAL
-            if (extDevRequested) {
-                // fail if extDevID is not available (null) or if prop is not supported
-                if (!libImplExtDevID || CheckPropsExtDevID(cfgPropsAll, libImplExtDevID))
-                    bImplValid = false;
+            if (bCachedMatch) {
+                matchCache->numCached++;
             }
-#else
-            if (extDevRequested)
-                bImplValid = false;
+            else {
+                if (CheckConfigProps(config,
+                                     cfgPropsAll,
+                                     libImplDesc,
+                                     libImplFuncs,
+#ifdef ONEVPL_EXPERIMENTAL
+                                     libImplExtDevID,
 #endif
-
-            // MSDK RT compatibility mode (1.x) does not provide Dec/Enc/VPP caps
-            // ignore these filters if set (do not use them to _exclude_ the library)
-            if (libType != LibTypeMSDK) {
-                if (decRequested && CheckPropsDec(cfgPropsAll, decConfigList))
+                                     libType,
+                                     flatCaps))
                     bImplValid = false;
 
-                if (encRequested && CheckPropsEnc(cfgPropsAll, encConfigList))
-                    bImplValid = false;
-
-                if (vppRequested && CheckPropsVPP(cfgPropsAll, vppConfigList))
-                    bImplValid = false;
+                if (matchCache) {
+                    matchCache->numChecked++;
+                    if (bImplValid)
+                        matchCache->matchGen[config] = config->GetPropGeneration();
+                }
             }
         }
 
@@ -1309,6 +1530,8 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
             specialConfig->bIsSet_accelerationMode = true;
         }
 
+        SetSessionCost(cfgPropsAll, specialConfig);
+
         if (cfgPropsAll[ePropSpecial_ExtBuffer].Type != MFX_VARIANT_TYPE_UNSET) {
             specialConfig->ExtBuffers.push_back(
                 (mfxExtBuffer *)cfgPropsAll[ePropSpecial_ExtBuffer].Data.Ptr);
@@ -1347,30 +1570,52 @@ mfxStatus ConfigCtxVPL::ValidateConfig(const mfxImplDescription *libImplDesc,
     if (bImplValid == false)
         return MFX_ERR_UNSUPPORTED;
 
-    // check whether required functions are implemented
-    if (!implFunctionList.empty()) {
-        if (!libImplFuncs) {
-            // library did not provide list of implemented functions
-            return MFX_ERR_UNSUPPORTED;
-        }
+    return MFX_ERR_NONE;
+}
 
-        auto fn = implFunctionList.begin();
-        while (fn != implFunctionList.end()) {
-            std::string fnName = (*fn++);
-            mfxU32 fnIdx;
+#ifdef ONEVPL_EXPERIMENTAL
+bool ConfigCtxVPL::CheckExtDevIDFilters(const std::list<ConfigCtxVPL *> &configCtxList,
+                                        const mfxExtendedDeviceId *libImplExtDevID) {
+    for (ConfigCtxVPL *config : configCtxList) {
+        mfxVariant cfgPropsAll[eProp_TotalProps] = {};
+        bool extDevRequested                     = false;
 
-            // search for fnName in list of implemented functions
-            for (fnIdx = 0; fnIdx < libImplFuncs->NumFunctions; fnIdx++) {
-                if (fnName == libImplFuncs->FunctionsName[fnIdx])
-                    break;
-            }
+        for (mfxU32 idx = 0; idx < eProp_TotalProps; idx++) {
+            cfgPropsAll[idx].Type = MFX_VARIANT_TYPE_UNSET;
+            if (idx < ePropExtDev_VendorID || idx > ePropExtDev_DeviceName ||
+                config->m_propVar[idx].Type == MFX_VARIANT_TYPE_UNSET)
+                continue;
 
-            if (fnIdx == libImplFuncs->NumFunctions)
-                return MFX_ERR_UNSUPPORTED;
+            cfgPropsAll[idx].Type = config->m_propVar[idx].Type;
+            cfgPropsAll[idx].Data = config->m_propVar[idx].Data;
+            extDevRequested       = true;
         }
+
+        // same rule as ValidateConfig - every config object must match
+        if (extDevRequested &&
+            (!libImplExtDevID || CheckPropsExtDevID(cfgPropsAll, libImplExtDevID)))
+            return false;
     }
 
-    return MFX_ERR_NONE;
+    return true;
+}
+#endif
+
+void ConfigCtxVPL::GetRequestedDeferredCaps(const std::list<ConfigCtxVPL *> &configCtxList,
+                                            bool &bImplFuncs,
+                                            bool &bExtDeviceID) {
+    bImplFuncs   = false;
+    bExtDeviceID = false;
+
+    for (ConfigCtxVPL *config : configCtxList) {
+        if (config->m_propVar[ePropFunc_FunctionName].Type != MFX_VARIANT_TYPE_UNSET)
+            bImplFuncs = true;
+
+        for (mfxU32 idx = ePropExtDev_VendorID; idx <= ePropExtDev_DeviceName; idx++) {
+            if (config->m_propVar[idx].Type != MFX_VARIANT_TYPE_UNSET)
+                bExtDeviceID = true;
+        }
+    }
 }
 
 bool ConfigCtxVPL::CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList,
@@ -1393,6 +1638,9 @@ bool ConfigCtxVPL::CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList
     specialConfig->bIsSet_ExtBuffer = false;
     specialConfig->ExtBuffers.clear();
 
+    specialConfig->bIsSet_fastStartPath = false;
+    specialConfig->fastStartPath.clear();
+
     auto it = configCtxList.begin();
     while (it != configCtxList.end()) {
         ConfigCtxVPL *config = (*it);
@@ -1495,6 +1743,21 @@ bool ConfigCtxVPL::CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList
                 // extBufs were already pushed into the overall list, above
                 break;
 
+            // declared session cost, does not affect low latency
+            case ePropSpecial_SessionCostWidth:
+            case ePropSpecial_SessionCostHeight:
+            case ePropSpecial_SessionCostFrameRate:
+            case ePropSpecial_SessionCostCodecID:
+                break;
+
+            // full path to runtime library for fast start mode
+            case ePropSpecial_FastStartPath:
+                if (cfgPropsAll[idx].Type == MFX_VARIANT_TYPE_PTR && cfgPropsAll[idx].Data.Ptr) {
+                    specialConfig->fastStartPath = *(std::string *)(cfgPropsAll[idx].Data.Ptr);
+                    specialConfig->bIsSet_fastStartPath = true;
+                }
+                break;
+
             // will be passed to RT in MFXInitialize(), if unset will be 0
             case ePropSpecial_DXGIAdapterIndex:
                 if (cfgPropsAll[idx].Type == MFX_VARIANT_TYPE_U32) {
@@ -1512,9 +1775,36 @@ bool ConfigCtxVPL::CheckLowLatencyConfig(std::list<ConfigCtxVPL *> configCtxList
         }
     }
 
+    SetSessionCost(cfgPropsAll, specialConfig);
+
     return bLowLatency;
 }
 
+// copy the declared workload of the session (SessionCost.*) into specialConfig
+// properties may come from separate cfg objects, the last value of each one is used
+void ConfigCtxVPL::SetSessionCost(const mfxVariant cfgPropsAll[], SpecialConfig *specialConfig) {
+    if (cfgPropsAll[ePropSpecial_SessionCostWidth].Type == MFX_VARIANT_TYPE_U32) {
+        specialConfig->SessionCostWidth   = cfgPropsAll[ePropSpecial_SessionCostWidth].Data.U32;
+        specialConfig->bIsSet_SessionCost = true;
+    }
+
+    if (cfgPropsAll[ePropSpecial_SessionCostHeight].Type == MFX_VARIANT_TYPE_U32) {
+        specialConfig->SessionCostHeight  = cfgPropsAll[ePropSpecial_SessionCostHeight].Data.U32;
+        specialConfig->bIsSet_SessionCost = true;
+    }
+
+    if (cfgPropsAll[ePropSpecial_SessionCostFrameRate].Type == MFX_VARIANT_TYPE_U32) {
+        specialConfig->SessionCostFrameRate =
+            cfgPropsAll[ePropSpecial_SessionCostFrameRate].Data.U32;
+        specialConfig->bIsSet_SessionCost = true;
+    }
+
+    if (cfgPropsAll[ePropSpecial_SessionCostCodecID].Type == MFX_VARIANT_TYPE_U32) {
+        specialConfig->SessionCostCodecID = cfgPropsAll[ePropSpecial_SessionCostCodecID].Data.U32;
+        specialConfig->bIsSet_SessionCost = true;
+    }
+}
+
 bool ConfigCtxVPL::ParseDeviceIDx86(mfxChar *cDeviceID, mfxU32 &deviceID, mfxU32 &adapterIdx) {
     std::string strDevID(cDeviceID);
     std::regex reDevIDAll("[0-9a-fA-F]+/[0-9]+");
@@ -5,6 +5,10 @@
   ############################################################################*/
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 #include "vpl/mfx_dispatcher_vpl.h"
 
@@ -41,6 +45,24 @@ static const VPLFunctionDesc MSDKCompatFunctions[NumMSDKFunctions] = {
 // end table formatting
 // clang-format on
 
+// process-wide loader used by all handles in shared loader mode
+//   (ONEVPL_DISPATCHER_SHARED_LOADER=ON), destroyed when the last handle is unloaded
+static std::mutex g_sharedLoaderMutex;
+static LoaderCtxVPL *g_sharedLoader   = nullptr;
+static mfxU32 g_sharedLoaderRefCount = 0;
+
+// first adapter for the next call to RotateAdapters()
+// processes start at an offset based on the process ID so that they are spread
+//   across adapters without any shared state
+static mfxU32 GetNextAdapterRotation() {
+#if defined(_WIN32) || defined(_WIN64)
+    static std::atomic<mfxU32> nextRotation((mfxU32)GetCurrentProcessId());
+#else
+    static std::atomic<mfxU32> nextRotation((mfxU32)getpid());
+#endif
+    return nextRotation++;
+}
+
 // implementation of loader context (mfxLoader)
 // each loader instance will build a list of valid runtimes and allow
 // application to create sessions with them
@@ -49,11 +71,33 @@ LoaderCtxVPL::LoaderCtxVPL()
           m_implInfoList(),
           m_configCtxList(),
           m_gpuAdapterInfo(),
+          m_pooledSessions(),
+          m_poolMutex(),
+          m_deferredCapsMutex(),
           m_specialConfig(),
           m_implIdxNext(0),
           m_bKeepCapsUntilUnload(true),
           m_envVar(),
-          m_dispLog() {
+          m_dispLog(),
+          m_timing(),
+          m_timingMutex(),
+          m_capsArena(),
+          m_capsCache(),
+          m_fastStartPath(),
+          m_bFastStart(false),
+          m_bSharedLoader(false),
+          m_bSharedLoaderRef(false),
+          m_bAdapterRoundRobin(false),
+          m_admissionPolicy(ADMISSION_POLICY_OFF),
+          m_admissionBudget(0),
+          m_admissionTimeout(0),
+          m_admissionName(),
+          m_bAsyncLoad(false),
+          m_bAsyncLoadDone(false),
+          m_asyncLoadStatus(MFX_ERR_NONE),
+          m_asyncLoadThread(),
+          m_asyncLoadMutex(),
+          m_asyncLoadCond() {
     // allow loader to distinguish between property value of 0
     //   and property not set
     m_specialConfig.bIsSet_deviceHandleType = false;
@@ -64,6 +108,12 @@ LoaderCtxVPL::LoaderCtxVPL()
     m_specialConfig.bIsSet_NumThread        = false;
     m_specialConfig.bIsSet_DeviceCopy       = false;
     m_specialConfig.bIsSet_ExtBuffer        = false;
+    m_specialConfig.bIsSet_fastStartPath    = false;
+    m_specialConfig.bIsSet_SessionCost      = false;
+    m_specialConfig.SessionCostWidth        = 0;
+    m_specialConfig.SessionCostHeight       = 0;
+    m_specialConfig.SessionCostFrameRate    = 0;
+    m_specialConfig.SessionCostCodecID      = 0;
 
     // initial state
     m_bLowLatency           = false;
@@ -72,10 +122,15 @@ LoaderCtxVPL::LoaderCtxVPL()
     m_bNeedLowLatencyQuery  = true;
     m_bPriorityPathEnabled  = false;
 
+    m_timing.Version.Version = MFX_DISPATCHERTIMING_VERSION;
+
     return;
 }
 
 LoaderCtxVPL::~LoaderCtxVPL() {
+    // normally already joined by MFXUnload()
+    JoinAsyncLoad();
+
     return;
 }
 
@@ -83,12 +138,41 @@ mfxStatus LoaderCtxVPL::FullLoadAndQuery() {
     // disable low latency mode
     m_bLowLatency = false;
 
+    // reuse libraries and caps from the process-wide loader
+    if (m_bSharedLoader)
+        return LoadFromSharedLoader();
+
     // search directories for candidate implementations based on search order in
     // spec
     mfxStatus sts = BuildListOfCandidateLibs();
     if (MFX_ERR_NONE != sts)
         return sts;
 
+    // libraries with a current entry in the caps cache are not loaded
+    //   until CreateSession() is called
+    if (m_capsCache.IsEnabled()) {
+        for (LibInfo *libInfo : m_libInfoList) {
+            LibType libType = LibTypeUnknown;
+            if (!m_capsCache.HasLib(libInfo->libNameFull, libType))
+                continue;
+
+            if (libType == LibTypeVPL && libInfo->libPriority < LIB_PRIORITY_LEGACY_DRIVERSTORE) {
+                libInfo->libType     = LibTypeVPL;
+                libInfo->bCapsCached = true;
+            }
+            else if (libType == LibTypeMSDK) {
+                // API version is needed to pick the best MSDK library, without a test session
+                std::vector<CachedImplCaps> implCaps;
+                if (m_capsCache.GetLib(libInfo->libNameFull, implCaps) == MFX_ERR_NONE &&
+                    !implCaps.empty()) {
+                    libInfo->libType     = LibTypeMSDK;
+                    libInfo->msdkVersion = implCaps[0].implDesc->ApiVersion;
+                    libInfo->bCapsCached = true;
+                }
+            }
+        }
+    }
+
     // prune libraries which are not actually implementations, filling function
     // ptr table for each library which is
     mfxU32 numLibs = CheckValidLibraries();
@@ -101,6 +185,9 @@ mfxStatus LoaderCtxVPL::FullLoadAndQuery() {
     if (MFX_ERR_NONE != sts)
         return MFX_ERR_NOT_FOUND;
 
+    // save caps for any newly queried libraries
+    m_capsCache.Flush();
+
     m_bNeedFullQuery        = false;
     m_bNeedUpdateValidImpls = true;
 
@@ -152,6 +239,9 @@ mfxStatus LoaderCtxVPL::SearchDirForLibs(STRING_TYPE searchDir,
     if (searchDir.empty())
         return MFX_ERR_NONE;
 
+    DISP_LOG_TIMING(&m_dispLog, nullptr, "search dir", searchDir);
+    m_timing.NumSearchDirs++;
+
 #if defined(_WIN32) || defined(_WIN64)
     HANDLE hTestFile = nullptr;
     WIN32_FIND_DATAW testFileData;
@@ -311,10 +401,10 @@ mfxU32 LoaderCtxVPL::GetSearchPathsDriverStore(std::list<STRING_TYPE> &searchDir
     // get path to Windows driver store (if any) for each adapter
     for (mfxU32 adapterID = 0; adapterID < (mfxU32)m_gpuAdapterInfo.size(); adapterID++) {
         vplPath.clear();
-        sts = MFX::MFXLibraryIterator::GetDriverStoreDir(vplPath,
-                                                         MAX_VPL_SEARCH_PATH,
-                                                         m_gpuAdapterInfo[adapterID].deviceID,
-                                                         storageID);
+        sts = MFX::AdapterCache::GetDriverStoreDir(vplPath,
+                                                   MAX_VPL_SEARCH_PATH,
+                                                   m_gpuAdapterInfo[adapterID].deviceID,
+                                                   storageID);
         if (sts == MFX_ERR_NONE)
             searchDirs.push_back(vplPath);
     }
@@ -431,6 +521,7 @@ mfxU32 LoaderCtxVPL::GetSearchPathsSystemDefault(std::list<STRING_TYPE> &searchD
 //   according to the rules in the spec
 mfxStatus LoaderCtxVPL::BuildListOfCandidateLibs() {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_LOG_TIMING(&m_dispLog, &m_timing.SearchPathsTime, "BuildListOfCandidateLibs");
 
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -456,7 +547,7 @@ mfxStatus LoaderCtxVPL::BuildListOfCandidateLibs() {
     // retrieve list of DX11 graphics adapters (lightweight)
     // used for both VPL and legacy driver store search
     m_gpuAdapterInfo.clear();
-    bool bEnumSuccess = MFX::DXGI1Device::GetAdapterList(m_gpuAdapterInfo);
+    bool bEnumSuccess = MFX::AdapterCache::GetAdapterList(m_gpuAdapterInfo);
 
     // unknown error or no adapters found - clear list
     if (!bEnumSuccess)
@@ -593,19 +684,23 @@ mfxU32 LoaderCtxVPL::CheckValidLibraries() {
     LibInfo *msdkLibBest   = nullptr;
     LibInfo *msdkLibBestDS = nullptr;
 
-    // load all libraries
+    // load all libraries and fill in table of 2.x exports
+    // optionally done on multiple threads (see GetProbeThreadCount)
+    ProbeLibraries();
+
     std::list<LibInfo *>::iterator it = m_libInfoList.begin();
     while (it != m_libInfoList.end()) {
         LibInfo *libInfo = (*it);
         mfxStatus sts    = MFX_ERR_NONE;
 
-        // load DLL
-        sts = LoadSingleLibrary(libInfo);
+        // caps will be restored from cache, library is not loaded
+        if (libInfo->bCapsCached && libInfo->libType == LibTypeVPL) {
+            it++;
+            continue;
+        }
 
-        // load video functions: pointers to exposed functions
-        // not all function pointers may be filled in (depends on API version)
-        if (sts == MFX_ERR_NONE && libInfo->hModuleVPL)
-            LoadAPIExports(libInfo, LibTypeVPL);
+        // DLL was loaded by ProbeLibraries()
+        sts = (libInfo->hModuleVPL ? MFX_ERR_NONE : MFX_ERR_NOT_FOUND);
 
         // all runtime libraries with API >= 2.0 must export MFXInitialize()
         // validation of additional functions vs. API version takes place
@@ -630,8 +725,15 @@ mfxU32 LoaderCtxVPL::CheckValidLibraries() {
 
         // check if all of the required MSDK functions were found
         //   and this is valid library (can create session, query version)
-        if (numFunctions == NumMSDKFunctions) {
-            sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &(libInfo->msdkVersion));
+        // the session is also used to probe the caps of its adapter
+        // MSDK libraries restored from the caps cache were validated before they were cached
+        if (numFunctions == NumMSDKFunctions || libInfo->bCapsCached) {
+            if (libInfo->bCapsCached)
+                sts = MFX_ERR_NONE;
+            else
+                sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull,
+                                                     &(libInfo->msdkVersion),
+                                                     libInfo->msdkCtx);
 
             if (sts == MFX_ERR_NONE) {
                 libInfo->libType = LibTypeMSDK;
@@ -690,6 +792,116 @@ mfxU32 LoaderCtxVPL::CheckValidLibraries() {
     return (mfxU32)m_libInfoList.size();
 }
 
+// number of threads used to load candidate libraries
+// set with ONEVPL_DISPATCHER_PROBE_THREADS environment variable, default is 1 (serial)
+mfxU32 LoaderCtxVPL::GetProbeThreadCount() {
+    mfxU32 numThreads = 1;
+
+#if defined(_WIN32) || defined(_WIN64)
+    char probeThreads[MAX_VPL_SEARCH_PATH] = "";
+    DWORD err =
+        GetEnvironmentVariable("ONEVPL_DISPATCHER_PROBE_THREADS", probeThreads, MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return numThreads;
+#else
+    const char *probeThreads = std::getenv("ONEVPL_DISPATCHER_PROBE_THREADS");
+    if (!probeThreads)
+        return numThreads;
+#endif
+
+    numThreads = (mfxU32)std::strtoul(probeThreads, nullptr, 10);
+    if (numThreads == 0)
+        numThreads = 1;
+    else if (numThreads > MAX_PROBE_THREADS)
+        numThreads = MAX_PROBE_THREADS;
+
+    return numThreads;
+}
+
+// load each candidate library and the table of 2.x exports
+// the handle is kept open for the remaining steps (no reload in QueryLibraryCaps)
+void LoaderCtxVPL::ProbeLibraries() {
+    std::vector<LibInfo *> probeList;
+    for (LibInfo *libInfo : m_libInfoList) {
+        // already loaded by low-latency search, or caps will be restored from cache
+        if (libInfo->hModuleVPL || libInfo->bCapsCached)
+            continue;
+        probeList.push_back(libInfo);
+    }
+
+    // load time is saved per library and logged after all threads are done
+    std::vector<mfxU64> loadTime(probeList.size(), 0);
+
+    auto probeSingleLibrary = [&](size_t idx) {
+        LibInfo *libInfo = probeList[idx];
+
+        // load video functions: pointers to exposed functions
+        // not all function pointers may be filled in (depends on API version)
+        mfxStatus sts;
+        {
+            DISP_LOG_TIMING(nullptr, &loadTime[idx], "load library");
+            sts = LoadSingleLibrary(libInfo);
+        }
+
+        if (sts == MFX_ERR_NONE && libInfo->hModuleVPL)
+            LoadAPIExports(libInfo, LibTypeVPL);
+    };
+
+    auto logLoadTime = [&]() {
+        for (size_t idx = 0; idx < probeList.size(); idx++) {
+            m_timing.LoadLibsTime += loadTime[idx];
+            m_timing.NumLibsLoaded++;
+
+            if (m_dispLog.IsTimingEnabled()) {
+                std::string libName =
+                    DispatcherLogVPLTiming::GetPrintableName(probeList[idx]->libNameFull);
+
+                m_dispLog.LogTiming("timing:   load library %s -- %.3f msec",
+                                    libName.c_str(),
+                                    loadTime[idx] / 1000.0);
+            }
+        }
+    };
+
+    mfxU32 numThreads = std::min(GetProbeThreadCount(), (mfxU32)probeList.size());
+    if (numThreads <= 1) {
+        for (size_t idx = 0; idx < probeList.size(); idx++)
+            probeSingleLibrary(idx);
+        logLoadTime();
+        return;
+    }
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  probing %d libraries on %d threads",
+                     (int)probeList.size(),
+                     (int)numThreads);
+
+    // each thread takes the next unprobed library until none are left
+    // probing only writes to the LibInfo being probed
+    std::atomic<size_t> nextLib(0);
+    auto probeWorker = [&]() {
+        size_t idx;
+        while ((idx = nextLib++) < probeList.size())
+            probeSingleLibrary(idx);
+    };
+
+    std::vector<std::thread> probeThreads;
+    try {
+        for (mfxU32 i = 1; i < numThreads; i++)
+            probeThreads.emplace_back(probeWorker);
+    }
+    catch (...) {
+        // unable to create more threads - continue with the ones already running
+    }
+
+    probeWorker();
+
+    for (auto &t : probeThreads)
+        t.join();
+
+    logLoadTime();
+}
+
 VPLFunctionPtr LoaderCtxVPL::GetFunctionAddr(void *hModuleVPL, const char *pName) {
     VPLFunctionPtr pProc = nullptr;
 
@@ -709,6 +921,10 @@ mfxStatus LoaderCtxVPL::LoadSingleLibrary(LibInfo *libInfo) {
     if (!libInfo)
         return MFX_ERR_NULL_PTR;
 
+    // already loaded (e.g. handle kept from AddSingleLibrary)
+    if (libInfo->hModuleVPL)
+        return MFX_ERR_NONE;
+
 #if defined(_WIN32) || defined(_WIN64)
     libInfo->hModuleVPL = MFX::mfx_dll_load(libInfo->libNameFull.c_str());
 #else
@@ -744,6 +960,13 @@ mfxStatus LoaderCtxVPL::UnloadSingleLibrary(LibInfo *libInfo) {
 mfxStatus LoaderCtxVPL::UnloadAllLibraries() {
     DISP_LOG_FUNCTION(&m_dispLog);
 
+    // only the per-handle copies are freed, libraries stay loaded until the last
+    //   handle using the shared loader is unloaded
+    if (m_bSharedLoaderRef) {
+        ReleaseSharedLoader();
+        return MFX_ERR_NONE;
+    }
+
     std::list<ImplInfo *>::iterator it2 = m_implInfoList.begin();
     while (it2 != m_implInfoList.end()) {
         ImplInfo *implInfo = (*it2);
@@ -769,6 +992,9 @@ mfxStatus LoaderCtxVPL::UnloadAllLibraries() {
     m_libInfoList.clear();
     m_implIdxNext = 0;
 
+    // flattened caps of all implementations are freed together
+    m_capsArena.Reset();
+
     return MFX_ERR_NONE;
 }
 
@@ -779,11 +1005,14 @@ mfxStatus LoaderCtxVPL::UnloadSingleImplementation(ImplInfo *implInfo) {
         LibInfo *libInfo     = implInfo->libInfo;
         VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXReleaseImplDescription];
 
+        ClosePooledSessions(implInfo);
+
         // call MFXReleaseImplDescription() for this implementation if it
         //   was never called by the application
         // this is a valid scenario, e.g. app did not call MFXEnumImplementations()
         //   and just used the first available implementation provided by dispatcher
-        if (libInfo->libType == LibTypeVPL) {
+        // caps restored from cache are owned by m_capsCache
+        if (libInfo->libType == LibTypeVPL && !libInfo->bCapsCached) {
             if (implInfo->implDesc) {
                 // MFX_IMPLCAPS_IMPLDESCSTRUCTURE;
                 (*(mfxStatus(MFX_CDECL *)(mfxHDL))pFunc)(implInfo->implDesc);
@@ -813,6 +1042,22 @@ mfxStatus LoaderCtxVPL::UnloadSingleImplementation(ImplInfo *implInfo) {
     }
 }
 
+// close idle pooled sessions
+// sessions still acquired by the application are no longer tracked and must be
+//   closed with MFXClose()
+void LoaderCtxVPL::ClosePooledSessions(ImplInfo *implInfo) {
+    for (mfxSession session : implInfo->sessionPool)
+        MFXClose(session);
+    implInfo->sessionPool.clear();
+
+    for (auto it = m_pooledSessions.begin(); it != m_pooledSessions.end();) {
+        if (it->second == implInfo)
+            it = m_pooledSessions.erase(it);
+        else
+            it++;
+    }
+}
+
 // return number of functions loaded
 mfxU32 LoaderCtxVPL::LoadAPIExports(LibInfo *libInfo, LibType libType) {
     mfxU32 i, numFunctions = 0;
@@ -895,16 +1140,63 @@ bool LoaderCtxVPL::IsValidX86GPU(ImplInfo *implInfo, mfxU32 &deviceID, mfxU32 &a
 //   and add to list for future calls to EnumImplementations()
 //   as well as filtering by functionality
 // assume MFX_IMPLCAPS_IMPLDESCSTRUCTURE is the only format supported
+// D3D9 sessions can only be created if neither the acceleration mode nor the device handle
+//   type rules them out, e.g. an application which passes a D3D11 device or VA display
+bool LoaderCtxVPL::IsD3D9Excluded() {
+    if (m_specialConfig.bIsSet_accelerationMode &&
+        m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9)
+        return true;
+
+    if (m_specialConfig.bIsSet_deviceHandleType &&
+        m_specialConfig.deviceHandleType != MFX_HANDLE_D3D9_DEVICE_MANAGER)
+        return true;
+
+    return false;
+}
+
 mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
     DISP_LOG_FUNCTION(&m_dispLog);
 
     mfxStatus sts = MFX_ERR_NONE;
 
+#ifdef ONEVPL_EXPERIMENTAL
+    // if a filter selects the device (e.g. DRMRenderNodeNum or PCI address), query the
+    //   extended device ID first and skip the full caps query for libraries without that device
+    bool bNeedImplFuncs = false, bDevicePrefilter = false;
+    if (m_bLowLatency == false)
+        ConfigCtxVPL::GetRequestedDeferredCaps(m_configCtxList, bNeedImplFuncs, bDevicePrefilter);
+#endif
+
     std::list<LibInfo *>::iterator it = m_libInfoList.begin();
     while (it != m_libInfoList.end()) {
         LibInfo *libInfo = (*it);
 
+        // libInfo may be removed from the list, name is saved when timer is created
+        DISP_LOG_TIMING(&m_dispLog,
+                        &m_timing.QueryCapsTime,
+                        "query caps",
+                        libInfo->libNameFull);
+
         if (libInfo->libType == LibTypeVPL) {
+            if (libInfo->bCapsCached) {
+                if (AddCachedImpls(libInfo) == MFX_ERR_NONE) {
+                    it++;
+                    continue;
+                }
+
+                // cache entry is invalid - load library and query it instead
+                libInfo->bCapsCached = false;
+                if (LoadSingleLibrary(libInfo) == MFX_ERR_NONE)
+                    LoadAPIExports(libInfo, LibTypeVPL);
+
+                if (!libInfo->vplFuncTable[IdxMFXInitialize] ||
+                    !libInfo->vplFuncTable[IdxMFXQueryImplsDescription]) {
+                    UnloadSingleLibrary(libInfo);
+                    it = m_libInfoList.erase(it);
+                    continue;
+                }
+            }
+
             VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
 
             // handle to implDesc structure, null in low-latency mode (no query)
@@ -914,6 +1206,39 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 #ifdef ONEVPL_EXPERIMENTAL
             mfxHDL *hImplExtDeviceID   = nullptr;
             mfxU32 numImplsExtDeviceID = 0;
+
+            if (bDevicePrefilter) {
+                hImplExtDeviceID =
+                    (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                         pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &numImplsExtDeviceID);
+
+                bool bDeviceFound = false;
+                for (mfxU32 i = 0; hImplExtDeviceID && i < numImplsExtDeviceID; i++) {
+                    if (ConfigCtxVPL::CheckExtDevIDFilters(
+                            m_configCtxList,
+                            (mfxExtendedDeviceId *)hImplExtDeviceID[i])) {
+                        bDeviceFound = true;
+                        break;
+                    }
+                }
+
+                if (!bDeviceFound) {
+                    UpdateImplPath(libInfo);
+                    DISP_LOG_MESSAGE(&m_dispLog,
+                                     "message:  device prefilter -- no matching device in %s",
+                                     libInfo->implCapsPath);
+
+                    VPLFunctionPtr pRelease = libInfo->vplFuncTable[IdxMFXReleaseImplDescription];
+                    for (mfxU32 i = 0; hImplExtDeviceID && i < numImplsExtDeviceID; i++) {
+                        if (hImplExtDeviceID[i] && pRelease)
+                            (*(mfxStatus(MFX_CDECL *)(mfxHDL))pRelease)(hImplExtDeviceID[i]);
+                    }
+
+                    UnloadSingleLibrary(libInfo);
+                    it = m_libInfoList.erase(it);
+                    continue;
+                }
+            }
 #endif
 
             if (m_bLowLatency == false) {
@@ -944,20 +1269,35 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
                     continue;
                 }
 
+            }
+
+            // in normal mode the list of implemented functions and extended device ID
+            //   are only queried when needed for filtering or MFXEnumImplementations()
+            // entries added to the caps cache must be complete, so query them now
+            bool bCapsDeferred = (m_bLowLatency == false && !m_capsCache.IsEnabled());
+
 #ifdef ONEVPL_EXPERIMENTAL
+            // extended device ID was already queried by the device prefilter, and the filter
+            //   which required it would trigger the deferred query anyway
+            if (bDevicePrefilter)
+                bCapsDeferred = false;
+
+            if (m_bLowLatency == false && !bCapsDeferred && !hImplExtDeviceID) {
                 hImplExtDeviceID =
                     (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
                          pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &numImplsExtDeviceID);
-#endif
             }
+#endif
 
             // query for list of implemented functions
             // prior to API 2.2, this will return null since the format was not defined yet
             //   so we need to check whether the returned handle is valid before attempting to use it
             mfxHDL *hImplFuncs   = nullptr;
             mfxU32 numImplsFuncs = 0;
-            hImplFuncs           = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
-                              pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &numImplsFuncs);
+            if (!bCapsDeferred) {
+                hImplFuncs = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                 pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &numImplsFuncs);
+            }
 
             // only report single impl, but application may still attempt to create session using
             //    any of VendorImplID via the DXGIAdapterIndex filter property
@@ -967,6 +1307,9 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
             // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
             UpdateImplPath(libInfo);
 
+            // valid implementations in this library, saved to caps cache
+            std::list<ImplInfo *> libImplInfoList;
+
             for (mfxU32 i = 0; i < numImpls; i++) {
                 ImplInfo *implInfo = new ImplInfo;
                 if (!implInfo)
@@ -984,6 +1327,8 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
                 if (hImplFuncs && i < numImplsFuncs)
                     implInfo->implFuncs = hImplFuncs[i];
 
+                implInfo->bCapsDeferred = bCapsDeferred;
+
                 // fill out mfxInitializationParam for use in CreateSession (MFXInitialize path)
                 memset(&(implInfo->vplParam), 0, sizeof(mfxInitializationParam));
 
@@ -1037,9 +1382,27 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 
                 // add implementation to overall list
                 m_implInfoList.push_back(implInfo);
+                libImplInfoList.push_back(implInfo);
+            }
+
+            if (m_bLowLatency == false && m_capsCache.IsEnabled() && !libImplInfoList.empty()) {
+                if (m_capsCache.AddLib(libInfo->libNameFull, libImplInfoList) == MFX_ERR_NONE)
+                    DISP_LOG_MESSAGE(&m_dispLog,
+                                     "message:  caps cache add -- %s",
+                                     libInfo->implCapsPath);
             }
         }
         else if (libInfo->libType == LibTypeMSDK) {
+            if (libInfo->bCapsCached) {
+                if (AddCachedImpls(libInfo) == MFX_ERR_NONE) {
+                    it++;
+                    continue;
+                }
+
+                // cache entry is invalid - probe the adapters instead
+                libInfo->bCapsCached = false;
+            }
+
             // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
             UpdateImplPath(libInfo);
 
@@ -1048,7 +1411,9 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
             // call once on adapter 0 to get MSDK API version (same for any adapter)
             mfxVersion queryVersion = {};
             if (m_bLowLatency) {
-                sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull, &queryVersion);
+                sts = LoaderCtxMSDK::QueryAPIVersion(libInfo->libNameFull,
+                                                     &queryVersion,
+                                                     libInfo->msdkCtx);
                 if (sts != MFX_ERR_NONE)
                     queryVersion.Version = 0;
 
@@ -1057,6 +1422,9 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
                 maxImplMSDK = 1;
             }
 
+            // valid adapters, saved to caps cache
+            std::list<ImplInfo *> libImplInfoList;
+
             mfxU32 numImplMSDK = 0;
             for (mfxU32 i = 0; i < maxImplMSDK; i++) {
                 mfxImplDescription *implDesc       = nullptr;
@@ -1067,12 +1435,9 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 
                 LoaderCtxMSDK *msdkCtx = &(libInfo->msdkCtx[i]);
                 if (m_bLowLatency == false) {
-                    // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
-                    bool bSkipD3D9Check = false;
-                    if (m_specialConfig.bIsSet_accelerationMode &&
-                        m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
-                        bSkipD3D9Check = true;
-                    }
+                    // perf. optimization: if filters exclude D3D9, skip testing MSDK for D3D9 support
+                    // entries added to the caps cache must be complete, so test it anyway
+                    bool bSkipD3D9Check = IsD3D9Excluded() && !m_capsCache.IsEnabled();
 
                     sts = msdkCtx->QueryMSDKCaps(libInfo->libNameFull,
                                                  &implDesc,
@@ -1159,11 +1524,19 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 
                 // add implementation to overall list
                 m_implInfoList.push_back(implInfo);
+                libImplInfoList.push_back(implInfo);
 
                 // update number of valid MSDK adapters
                 numImplMSDK++;
             }
 
+            if (m_bLowLatency == false && m_capsCache.IsEnabled() && !libImplInfoList.empty()) {
+                if (m_capsCache.AddLib(libInfo->libNameFull, libImplInfoList) == MFX_ERR_NONE)
+                    DISP_LOG_MESSAGE(&m_dispLog,
+                                     "message:  caps cache add -- %s",
+                                     libInfo->implCapsPath);
+            }
+
             if (numImplMSDK == 0) {
                 // error loading MSDK library in compatibility mode - remove from list
                 UnloadSingleLibrary(libInfo);
@@ -1240,12 +1613,8 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
 
                 LoaderCtxMSDK *msdkCtx = &(implInfo->libInfo->msdkCtx[0]);
 
-                // perf. optimization: if app requested bIsSet_accelerationMode other than D3D9, don't test whether MSDK supports D3D9
-                bool bSkipD3D9Check = false;
-                if (m_specialConfig.bIsSet_accelerationMode &&
-                    m_specialConfig.accelerationMode != MFX_ACCEL_MODE_VIA_D3D9) {
-                    bSkipD3D9Check = true;
-                }
+                // perf. optimization: if filters exclude D3D9, skip testing MSDK for D3D9 support
+                bool bSkipD3D9Check = IsD3D9Excluded();
 
                 sts = msdkCtx->QueryMSDKCaps(implInfo->libInfo->libNameFull,
                                              &implDesc,
@@ -1271,6 +1640,100 @@ mfxStatus LoaderCtxVPL::QueryLibraryCaps() {
     return m_implInfoList.empty() ? MFX_ERR_UNSUPPORTED : MFX_ERR_NONE;
 }
 
+// query caps which were skipped in QueryLibraryCaps() for all implementations in this library
+// the runtime returns one array for the whole library, so every impl is updated at once
+mfxStatus LoaderCtxVPL::QueryDeferredCaps(LibInfo *libInfo) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    if (libInfo->libType != LibTypeVPL)
+        return MFX_ERR_UNSUPPORTED;
+
+    VPLFunctionPtr pFunc = libInfo->vplFuncTable[IdxMFXQueryImplsDescription];
+    if (!pFunc)
+        return MFX_ERR_UNSUPPORTED;
+
+    mfxU32 numImplsFuncs = 0;
+    mfxHDL *hImplFuncs   = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                              pFunc)(MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, &numImplsFuncs);
+
+#ifdef ONEVPL_EXPERIMENTAL
+    mfxU32 numImplsExtDeviceID = 0;
+    mfxHDL *hImplExtDeviceID   = (*(mfxHDL * (MFX_CDECL *)(mfxImplCapsDeliveryFormat, mfxU32 *))
+                                    pFunc)(MFX_IMPLCAPS_DEVICE_ID_EXTENDED, &numImplsExtDeviceID);
+#endif
+
+    DISP_LOG_MESSAGE(&m_dispLog, "message:  deferred caps query -- %s", libInfo->implCapsPath);
+
+    for (ImplInfo *implInfo : m_implInfoList) {
+        if (implInfo->libInfo != libInfo || !implInfo->bCapsDeferred)
+            continue;
+
+        mfxU32 i = implInfo->libImplIdx;
+
+        if (hImplFuncs && i < numImplsFuncs)
+            implInfo->implFuncs = hImplFuncs[i];
+
+#ifdef ONEVPL_EXPERIMENTAL
+        if (hImplExtDeviceID && i < numImplsExtDeviceID)
+            implInfo->implExtDeviceID = hImplExtDeviceID[i];
+#endif
+
+        implInfo->bCapsDeferred = false;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+// create implementations for library using caps restored from cache
+mfxStatus LoaderCtxVPL::AddCachedImpls(LibInfo *libInfo) {
+    std::vector<CachedImplCaps> implCaps;
+
+    mfxStatus sts = m_capsCache.GetLib(libInfo->libNameFull, implCaps);
+    if (sts != MFX_ERR_NONE || implCaps.empty())
+        return MFX_ERR_NOT_FOUND;
+
+    // save user-friendly path for MFX_IMPLCAPS_IMPLPATH query (API >= 2.4)
+    UpdateImplPath(libInfo);
+
+    DISP_LOG_MESSAGE(&m_dispLog, "message:  caps cache hit -- %s", libInfo->implCapsPath);
+
+    for (const CachedImplCaps &caps : implCaps) {
+        ImplInfo *implInfo = new ImplInfo;
+        if (!implInfo)
+            return MFX_ERR_MEMORY_ALLOC;
+
+        implInfo->libInfo   = libInfo;
+        implInfo->implDesc  = caps.implDesc;
+        implInfo->implFuncs = caps.implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+        implInfo->implExtDeviceID = caps.implExtDeviceID;
+#endif
+
+        memset(&(implInfo->vplParam), 0, sizeof(mfxInitializationParam));
+        implInfo->vplParam.AccelerationMode = caps.implDesc->AccelerationMode;
+        implInfo->version                   = caps.implDesc->ApiVersion;
+
+        // exports were validated against the reported API version before caching
+        implInfo->libImplIdx = caps.libImplIdx;
+
+        // MSDK adapter selected by CreateSession, in place of probing the adapter again
+        if (libInfo->libType == LibTypeMSDK) {
+            LoaderCtxMSDK *msdkCtx     = &(libInfo->msdkCtx[caps.libImplIdx]);
+            msdkCtx->m_msdkAdapter     = caps.msdkAdapter;
+            msdkCtx->m_msdkAdapterD3D9 = caps.msdkAdapterD3D9;
+
+            implInfo->msdkImplIdx = caps.libImplIdx;
+            implInfo->libImplIdx  = 0;
+        }
+
+        implInfo->validImplIdx = m_implIdxNext++;
+
+        m_implInfoList.push_back(implInfo);
+    }
+
+    return MFX_ERR_NONE;
+}
+
 // query implementation i
 mfxStatus LoaderCtxVPL::QueryImpl(mfxU32 idx, mfxImplCapsDeliveryFormat format, mfxHDL *idesc) {
     DISP_LOG_FUNCTION(&m_dispLog);
@@ -1281,6 +1744,14 @@ mfxStatus LoaderCtxVPL::QueryImpl(mfxU32 idx, mfxImplCapsDeliveryFormat format,
     while (it != m_implInfoList.end()) {
         ImplInfo *implInfo = (*it);
         if (implInfo->validImplIdx == (mfxI32)idx) {
+            // QueryImpl() may run concurrently on several threads, so the deferred
+            //   query is serialized (it updates every implementation in the library)
+            if (format != MFX_IMPLCAPS_IMPLDESCSTRUCTURE && format != MFX_IMPLCAPS_IMPLPATH) {
+                std::lock_guard<std::mutex> lock(m_deferredCapsMutex);
+                if (implInfo->bCapsDeferred)
+                    QueryDeferredCaps(implInfo->libInfo);
+            }
+
             if (format == MFX_IMPLCAPS_IMPLDESCSTRUCTURE) {
                 *idesc = implInfo->implDesc;
             }
@@ -1359,7 +1830,7 @@ mfxStatus LoaderCtxVPL::ReleaseImpl(mfxHDL idesc) {
             return MFX_ERR_NONE;
 
         // LibTypeMSDK does not require calling a release function
-        if (implInfo->libInfo->libType == LibTypeVPL) {
+        if (implInfo->libInfo->libType == LibTypeVPL && !implInfo->libInfo->bCapsCached) {
             // call MFXReleaseImplDescription() for this implementation
             VPLFunctionPtr pFunc = implInfo->libInfo->vplFuncTable[IdxMFXReleaseImplDescription];
 
@@ -1389,20 +1860,38 @@ mfxStatus LoaderCtxVPL::ReleaseImpl(mfxHDL idesc) {
 }
 
 mfxStatus LoaderCtxVPL::UpdateLowLatency() {
+    // mode was chosen when the async load was started and libraries may already be loaded
+    if (m_bAsyncLoad)
+        return MFX_ERR_NONE;
+
     m_bLowLatency = false;
 
     m_bLowLatency = ConfigCtxVPL::CheckLowLatencyConfig(m_configCtxList, &m_specialConfig);
 
+    // in fast start mode the runtime path is known, so any filter properties are treated
+    //   as the expected caps of that runtime rather than being checked against a query
+    m_bFastStart = (m_specialConfig.bIsSet_fastStartPath || !m_fastStartPath.empty());
+    if (m_bFastStart)
+        m_bLowLatency = true;
+
     return MFX_ERR_NONE;
 }
 
 mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_LOG_TIMING(&m_dispLog, &m_timing.UpdateValidImplsTime, "UpdateValidImplList");
 
     mfxStatus sts = MFX_ERR_NONE;
 
     mfxI32 validImplIdx = 0;
 
+    // per-config checks which were run or skipped (unchanged since last match)
+    mfxU32 numChecked = 0, numCached = 0;
+
+    // query any deferred caps (only if referenced by a filter)
+    bool bNeedImplFuncs = false, bNeedExtDeviceID = false;
+    ConfigCtxVPL::GetRequestedDeferredCaps(m_configCtxList, bNeedImplFuncs, bNeedExtDeviceID);
+
     // iterate over all libraries and update list of those that
     //   meet current current set of config props
     std::list<ImplInfo *>::iterator it = m_implInfoList.begin();
@@ -1415,6 +1904,12 @@ mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
             continue;
         }
 
+        if (implInfo->bCapsDeferred && (bNeedImplFuncs || bNeedExtDeviceID))
+            QueryDeferredCaps(implInfo->libInfo);
+
+        // flattened caps are kept with the implementation and allocated from the loader arena
+        implInfo->flatCaps.arena = &m_capsArena;
+
         // compare caps from this library vs. config filters
         sts = ConfigCtxVPL::ValidateConfig((mfxImplDescription *)implInfo->implDesc,
                                            (mfxImplementedFunctions *)implInfo->implFuncs,
@@ -1423,7 +1918,14 @@ mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
 #endif
                                            m_configCtxList,
                                            implInfo->libInfo->libType,
-                                           &m_specialConfig);
+                                           &m_specialConfig,
+                                           &implInfo->flatCaps,
+                                           &implInfo->configMatch);
+
+        numChecked += implInfo->configMatch.numChecked;
+        numCached += implInfo->configMatch.numCached;
+        implInfo->configMatch.numChecked = 0;
+        implInfo->configMatch.numCached  = 0;
 
         // check special filter properties which are not part of mfxImplDescription
         if (m_specialConfig.bIsSet_dxgiAdapterIdx &&
@@ -1444,6 +1946,11 @@ mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
         it++;
     }
 
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  revalidated %d config filters, %d unchanged",
+                     (int)numChecked,
+                     (int)numCached);
+
     // re-sort valid implementations according to priority rules in spec
     PrioritizeImplList();
 
@@ -1461,6 +1968,7 @@ mfxStatus LoaderCtxVPL::UpdateValidImplList(void) {
 //  4) Search path priority: lower values = higher priority
 mfxStatus LoaderCtxVPL::PrioritizeImplList(void) {
     DISP_LOG_FUNCTION(&m_dispLog);
+    DISP_LOG_TIMING(&m_dispLog, &m_timing.PrioritizeImplsTime, "PrioritizeImplList");
 
     // API 2.6 introduced special search location ONEVPL_PRIORITY_PATH
     // Libs here always have highest priority = LIB_PRIORITY_SPECIAL
@@ -1508,6 +2016,10 @@ mfxStatus LoaderCtxVPL::PrioritizeImplList(void) {
                 implDesc2->AccelerationMode == MFX_ACCEL_MODE_VIA_HDDLUNITE);
     });
 
+    // optional - start hardware implementations at the next adapter
+    if (m_bAdapterRoundRobin)
+        RotateAdapters();
+
     // 1 - sort by implementation type (HW > SW)
     m_implInfoList.sort([](const ImplInfo *impl1, const ImplInfo *impl2) {
         mfxImplDescription *implDesc1 = (mfxImplDescription *)(impl1->implDesc);
@@ -1541,115 +2053,245 @@ mfxStatus LoaderCtxVPL::PrioritizeImplList(void) {
 mfxStatus LoaderCtxVPL::CreateSession(mfxU32 idx, mfxSession *session) {
     DISP_LOG_FUNCTION(&m_dispLog);
 
-    mfxStatus sts = MFX_ERR_NONE;
-
     // find library with given implementation index
     // list of valid implementations (and associated indices) is updated
     //   every time a filter property is added/modified
-    std::list<ImplInfo *>::iterator it = m_implInfoList.begin();
-    while (it != m_implInfoList.end()) {
-        ImplInfo *implInfo = (*it);
+    ImplInfo *implInfo = GetValidImpl(idx);
+    if (!implInfo)
+        return MFX_ERR_NOT_FOUND;
 
-        if (implInfo->validImplIdx == (mfxI32)idx) {
-            LibInfo *libInfo = implInfo->libInfo;
-            mfxU16 deviceID  = 0;
-
-            // pass VendorImplID for this implementation (disambiguate if one
-            //   library contains multiple implementations)
-            // NOTE: implDesc may be null in low latency mode (RT query not called)
-            //   so this value will not be available
-            mfxImplDescription *implDesc = (mfxImplDescription *)(implInfo->implDesc);
-            if (implDesc) {
-                implInfo->vplParam.VendorImplID = implDesc->VendorImplID;
-            }
+    // optional - reserve the declared cost of the session on the ledger of its adapter
+    // implInfo may be replaced by an implementation on another adapter
+    AdmissionTicketVPL ticket = {};
+    if (m_admissionPolicy != ADMISSION_POLICY_OFF) {
+        mfxStatus sts = AdmitSession(implInfo, ticket);
+        if (sts != MFX_ERR_NONE)
+            return sts;
+    }
 
-            // set any special parameters passed in via SetConfigProperty
-            // if application did not specify accelerationMode, use default
-            if (m_specialConfig.bIsSet_accelerationMode)
-                implInfo->vplParam.AccelerationMode = m_specialConfig.accelerationMode;
+    // sessions may be created on several threads at once, so timing is
+    //   accumulated locally and added under m_timingMutex
+    mfxU64 createSessionTime = 0;
+    mfxStatus sts            = MFX_ERR_NONE;
+    {
+        DISP_LOG_TIMING(&m_dispLog, &createSessionTime, "CreateSession");
+        sts = InitSession(implInfo, session);
+    }
+
+    // reservation is released when the session is closed
+    if (ticket.ledger) {
+        if (sts == MFX_ERR_NONE)
+            BindSessionAdmission(ticket, *session);
+        else
+            CancelSessionAdmission(ticket);
+    }
+
+    std::lock_guard<std::mutex> lock(m_timingMutex);
+    m_timing.CreateSessionTime += createSessionTime;
+
+    return sts;
+}
+
+// initialize a new session with this implementation
+// only reads shared loader state - parameters are copied to the stack so this
+//   may be called concurrently for the same implementation
+mfxStatus LoaderCtxVPL::InitSession(ImplInfo *implInfo, mfxSession *session) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    LibInfo *libInfo                = implInfo->libInfo;
+    mfxU16 deviceID                 = 0;
+    mfxInitializationParam vplParam = implInfo->vplParam;
+
+    // pass VendorImplID for this implementation (disambiguate if one
+    //   library contains multiple implementations)
+    // NOTE: implDesc may be null in low latency mode (RT query not called)
+    //   so this value will not be available
+    mfxImplDescription *implDesc = (mfxImplDescription *)(implInfo->implDesc);
+    if (implDesc) {
+        vplParam.VendorImplID = implDesc->VendorImplID;
+    }
+
+    // set any special parameters passed in via SetConfigProperty
+    // if application did not specify accelerationMode, use default
+    if (m_specialConfig.bIsSet_accelerationMode)
+        vplParam.AccelerationMode = m_specialConfig.accelerationMode;
 
 #ifdef ONEVPL_EXPERIMENTAL
-            if (m_specialConfig.bIsSet_DeviceCopy)
-                implInfo->vplParam.DeviceCopy = m_specialConfig.DeviceCopy;
+    if (m_specialConfig.bIsSet_DeviceCopy)
+        vplParam.DeviceCopy = m_specialConfig.DeviceCopy;
 #endif
 
-            // in low latency mode there was no implementation filtering, so check here
-            //   for minimum API version
-            if (m_bLowLatency && m_specialConfig.bIsSet_ApiVersion) {
-                if (implInfo->version.Version < m_specialConfig.ApiVersion.Version)
-                    return MFX_ERR_NOT_FOUND;
-            }
+    // in low latency mode there was no implementation filtering, so check here
+    //   for minimum API version
+    if (m_bLowLatency && m_specialConfig.bIsSet_ApiVersion) {
+        if (implInfo->version.Version < m_specialConfig.ApiVersion.Version)
+            return MFX_ERR_NOT_FOUND;
+    }
 
-            mfxIMPL msdkImpl = 0;
-            if (libInfo->libType == LibTypeMSDK) {
-                if (implInfo->vplParam.AccelerationMode == MFX_ACCEL_MODE_VIA_D3D9)
-                    msdkImpl = libInfo->msdkCtx[implInfo->msdkImplIdx].m_msdkAdapterD3D9;
-                else
-                    msdkImpl = libInfo->msdkCtx[implInfo->msdkImplIdx].m_msdkAdapter;
-            }
+    mfxIMPL msdkImpl = 0;
+    if (libInfo->libType == LibTypeMSDK) {
+        if (vplParam.AccelerationMode == MFX_ACCEL_MODE_VIA_D3D9)
+            msdkImpl = libInfo->msdkCtx[implInfo->msdkImplIdx].m_msdkAdapterD3D9;
+        else
+            msdkImpl = libInfo->msdkCtx[implInfo->msdkImplIdx].m_msdkAdapter;
+    }
 
-            // in low latency mode implDesc is not available, but application may set adapter number via DXGIAdapterIndex filter
-            if (m_bLowLatency) {
-                if (m_specialConfig.bIsSet_dxgiAdapterIdx && libInfo->libType == LibTypeVPL)
-                    implInfo->vplParam.VendorImplID = m_specialConfig.dxgiAdapterIdx;
-                else if (m_specialConfig.bIsSet_dxgiAdapterIdx && libInfo->libType == LibTypeMSDK)
-                    msdkImpl = msdkImplTab[m_specialConfig.dxgiAdapterIdx];
-            }
+    // in low latency mode implDesc is not available, but application may set adapter number via DXGIAdapterIndex filter
+    if (m_bLowLatency) {
+        if (m_specialConfig.bIsSet_dxgiAdapterIdx && libInfo->libType == LibTypeVPL)
+            vplParam.VendorImplID = m_specialConfig.dxgiAdapterIdx;
+        else if (m_specialConfig.bIsSet_dxgiAdapterIdx && libInfo->libType == LibTypeMSDK)
+            msdkImpl = msdkImplTab[m_specialConfig.dxgiAdapterIdx];
+    }
 
-            // add any extension buffers set via special filter properties
-            std::vector<mfxExtBuffer *> extBufs;
+    // add any extension buffers set via special filter properties
+    std::vector<mfxExtBuffer *> extBufs;
 
-            // pass NumThread via mfxExtThreadsParam
-            mfxExtThreadsParam extThreadsParam = {};
-            if (m_specialConfig.bIsSet_NumThread) {
-                DISP_LOG_MESSAGE(&m_dispLog,
-                                 "message:  extBuf enabled -- NumThread (%d)",
-                                 m_specialConfig.NumThread);
+    // pass NumThread via mfxExtThreadsParam
+    mfxExtThreadsParam extThreadsParam = {};
+    if (m_specialConfig.bIsSet_NumThread) {
+        DISP_LOG_MESSAGE(&m_dispLog,
+                         "message:  extBuf enabled -- NumThread (%d)",
+                         m_specialConfig.NumThread);
 
-                extThreadsParam.Header.BufferId = MFX_EXTBUFF_THREADS_PARAM;
-                extThreadsParam.Header.BufferSz = sizeof(mfxExtThreadsParam);
-                extThreadsParam.NumThread       = m_specialConfig.NumThread;
+        extThreadsParam.Header.BufferId = MFX_EXTBUFF_THREADS_PARAM;
+        extThreadsParam.Header.BufferSz = sizeof(mfxExtThreadsParam);
+        extThreadsParam.NumThread       = m_specialConfig.NumThread;
 
-                extBufs.push_back((mfxExtBuffer *)&extThreadsParam);
-            }
+        extBufs.push_back((mfxExtBuffer *)&extThreadsParam);
+    }
 
-            // add extBufs provided via mfxConfig filter property "ExtBuffer"
-            if (m_specialConfig.bIsSet_ExtBuffer) {
-                for (auto extBuf : m_specialConfig.ExtBuffers) {
-                    extBufs.push_back((mfxExtBuffer *)extBuf);
-                }
-            }
+    // add extBufs provided via mfxConfig filter property "ExtBuffer"
+    if (m_specialConfig.bIsSet_ExtBuffer) {
+        for (auto extBuf : m_specialConfig.ExtBuffers) {
+            extBufs.push_back((mfxExtBuffer *)extBuf);
+        }
+    }
 
-            // attach vector of extBufs to mfxInitializationParam
-            implInfo->vplParam.NumExtParam = static_cast<mfxU16>(extBufs.size());
-            implInfo->vplParam.ExtParam =
-                (implInfo->vplParam.NumExtParam ? extBufs.data() : nullptr);
-
-            // initialize this library via MFXInitialize or else fail
-            //   (specify full path to library)
-            sts = MFXInitEx2(implInfo->version,
-                             implInfo->vplParam,
-                             msdkImpl,
-                             session,
-                             &deviceID,
-                             (CHAR_TYPE *)libInfo->libNameFull.c_str());
-
-            // optionally call MFXSetHandle() if present via SetConfigProperty
-            if (sts == MFX_ERR_NONE && m_specialConfig.bIsSet_deviceHandleType &&
-                m_specialConfig.bIsSet_deviceHandle && m_specialConfig.deviceHandleType &&
-                m_specialConfig.deviceHandle) {
-                sts = MFXVideoCORE_SetHandle(*session,
-                                             m_specialConfig.deviceHandleType,
-                                             m_specialConfig.deviceHandle);
-            }
+    // attach vector of extBufs to mfxInitializationParam
+    vplParam.NumExtParam = static_cast<mfxU16>(extBufs.size());
+    vplParam.ExtParam    = (vplParam.NumExtParam ? extBufs.data() : nullptr);
+
+    // initialize this library via MFXInitialize or else fail
+    //   (specify full path to library)
+    sts = MFXInitEx2(implInfo->version,
+                     vplParam,
+                     msdkImpl,
+                     session,
+                     &deviceID,
+                     (CHAR_TYPE *)libInfo->libNameFull.c_str());
+
+    // optionally call MFXSetHandle() if present via SetConfigProperty
+    if (sts == MFX_ERR_NONE && m_specialConfig.bIsSet_deviceHandleType &&
+        m_specialConfig.bIsSet_deviceHandle && m_specialConfig.deviceHandleType &&
+        m_specialConfig.deviceHandle) {
+        sts = MFXVideoCORE_SetHandle(*session,
+                                     m_specialConfig.deviceHandleType,
+                                     m_specialConfig.deviceHandle);
+    }
 
+    return sts;
+}
+
+// return implementation with given index in the list of valid implementations
+ImplInfo *LoaderCtxVPL::GetValidImpl(mfxU32 idx) {
+    auto it = std::find_if(m_implInfoList.begin(), m_implInfoList.end(), [&](ImplInfo *implInfo) {
+        return implInfo->validImplIdx == (mfxI32)idx;
+    });
+
+    return (it == m_implInfoList.end() ? nullptr : *it);
+}
+
+// add numSessions initialized sessions to the pool for implementation idx
+mfxStatus LoaderCtxVPL::CreateSessionPool(mfxU32 idx, mfxU32 numSessions) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    ImplInfo *implInfo = GetValidImpl(idx);
+    if (!implInfo)
+        return MFX_ERR_NOT_FOUND;
+
+    for (mfxU32 i = 0; i < numSessions; i++) {
+        mfxSession session = nullptr;
+
+        mfxStatus sts = CreateSession(idx, &session);
+        if (sts != MFX_ERR_NONE)
             return sts;
+
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        implInfo->sessionPool.push_back(session);
+        m_pooledSessions[session] = implInfo;
+    }
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  session pool %d -- %d idle sessions",
+                     idx,
+                     (int)implInfo->sessionPool.size());
+
+    return MFX_ERR_NONE;
+}
+
+// hand out an idle session from the pool, or create a new one if the pool is empty
+mfxStatus LoaderCtxVPL::AcquireSession(mfxU32 idx, mfxSession *session) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    ImplInfo *implInfo = GetValidImpl(idx);
+    if (!implInfo)
+        return MFX_ERR_NOT_FOUND;
+
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (!implInfo->sessionPool.empty()) {
+            *session = implInfo->sessionPool.front();
+            implInfo->sessionPool.pop_front();
+            return MFX_ERR_NONE;
         }
-        it++;
     }
 
-    // invalid idx
-    return MFX_ERR_NOT_FOUND;
+    // pool lock is not held while the runtime is initialized
+    mfxStatus sts = CreateSession(idx, session);
+    if (sts != MFX_ERR_NONE)
+        return sts;
+
+    // session joins the pool when released
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_pooledSessions[*session] = implInfo;
+
+    return MFX_ERR_NONE;
+}
+
+// reset session and return it to the pool of its implementation
+mfxStatus LoaderCtxVPL::ReleaseSession(mfxSession session) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    ImplInfo *implInfo = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+
+        auto it = m_pooledSessions.find(session);
+        if (it == m_pooledSessions.end())
+            return MFX_ERR_INVALID_HANDLE;
+
+        implInfo = it->second;
+
+        // session was already released
+        if (std::find(implInfo->sessionPool.begin(), implInfo->sessionPool.end(), session) !=
+            implInfo->sessionPool.end())
+            return MFX_ERR_INVALID_HANDLE;
+    }
+
+    // close any components left open by the previous user
+    // MFX_ERR_NOT_INITIALIZED is expected for components which were not used
+    MFXVideoDECODE_VPP_Close(session);
+    MFXVideoDECODE_Close(session);
+    MFXVideoENCODE_Close(session);
+    MFXVideoVPP_Close(session);
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    implInfo->sessionPool.push_back(session);
+
+    return MFX_ERR_NONE;
 }
 
 ConfigCtxVPL *LoaderCtxVPL::AddConfigFilter() {
@@ -1689,7 +2331,7 @@ mfxStatus LoaderCtxVPL::FreeConfigFilters() {
 }
 
 mfxStatus LoaderCtxVPL::InitDispatcherLog() {
-    std::string strLogEnabled, strLogFile;
+    std::string strLogEnabled, strLogFile, strLogAsync;
 
 #if defined(_WIN32) || defined(_WIN64)
     DWORD err;
@@ -1710,6 +2352,11 @@ mfxStatus LoaderCtxVPL::InitDispatcherLog() {
         strLogFile = logFile;
     }
 
+    char logAsync[MAX_VPL_SEARCH_PATH] = "";
+    err = GetEnvironmentVariable("ONEVPL_DISPATCHER_LOG_ASYNC", logAsync, MAX_VPL_SEARCH_PATH);
+    if (err > 0 && err < MAX_VPL_SEARCH_PATH)
+        strLogAsync = logAsync;
+
 #else
     const char *logEnabled = std::getenv("ONEVPL_DISPATCHER_LOG");
     if (!logEnabled)
@@ -1720,14 +2367,23 @@ mfxStatus LoaderCtxVPL::InitDispatcherLog() {
     const char *logFile = std::getenv("ONEVPL_DISPATCHER_LOG_FILE");
     if (logFile)
         strLogFile = logFile;
+
+    const char *logAsync = std::getenv("ONEVPL_DISPATCHER_LOG_ASYNC");
+    if (logAsync)
+        strLogAsync = logAsync;
 #endif
 
-    if (strLogEnabled != "ON")
+    // "TIMING" only prints startup timing messages
+    mfxU32 logLevel = DISP_LOG_LEVEL_NONE;
+    if (strLogEnabled == "ON")
+        logLevel = DISP_LOG_LEVEL_DEFAULT;
+    else if (strLogEnabled == "TIMING")
+        logLevel = DISP_LOG_LEVEL_TIMING;
+    else
         return MFX_ERR_UNSUPPORTED;
 
-    // currently logLevel is either 0 or non-zero
-    // additional levels will be added with future API updates
-    return m_dispLog.Init(1, strLogFile);
+    // "ON" writes the log from a background thread
+    return m_dispLog.Init(logLevel, strLogFile, (strLogAsync == "ON"));
 }
 
 // public function to return logger object
@@ -1735,3 +2391,356 @@ mfxStatus LoaderCtxVPL::InitDispatcherLog() {
 DispatcherLogVPL *LoaderCtxVPL::GetLogger() {
     return &m_dispLog;
 }
+
+mfxStatus LoaderCtxVPL::QueryTiming(mfxDispatcherTiming *timing) {
+    std::lock_guard<std::mutex> lock(m_timingMutex);
+    *timing = m_timing;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus LoaderCtxVPL::InitCapsCache() {
+    STRING_TYPE strCacheFile;
+
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    wchar_t cacheFile[MAX_VPL_SEARCH_PATH] = L"";
+    err = GetEnvironmentVariableW(L"ONEVPL_DISPATCHER_CACHE_FILE", cacheFile, MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    strCacheFile = cacheFile;
+#else
+    const char *cacheFile = std::getenv("ONEVPL_DISPATCHER_CACHE_FILE");
+    if (!cacheFile || !cacheFile[0])
+        return MFX_ERR_UNSUPPORTED;
+
+    strCacheFile = cacheFile;
+#endif
+
+    return m_capsCache.Init(strCacheFile, &m_dispLog);
+}
+
+// read runtime path for fast start mode from ONEVPL_DISPATCHER_FAST_START_PATH
+mfxStatus LoaderCtxVPL::InitFastStart() {
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    wchar_t fastStartPath[MAX_VPL_SEARCH_PATH] = L"";
+    err = GetEnvironmentVariableW(L"ONEVPL_DISPATCHER_FAST_START_PATH",
+                                  fastStartPath,
+                                  MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    m_fastStartPath = fastStartPath;
+#else
+    const char *fastStartPath = std::getenv("ONEVPL_DISPATCHER_FAST_START_PATH");
+    if (!fastStartPath || !fastStartPath[0])
+        return MFX_ERR_UNSUPPORTED;
+
+    m_fastStartPath = fastStartPath;
+#endif
+
+    return UpdateLowLatency();
+}
+
+// enable shared loader mode if ONEVPL_DISPATCHER_SHARED_LOADER is set to ON
+mfxStatus LoaderCtxVPL::InitSharedLoader() {
+    std::string strSharedLoader;
+
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    char sharedLoader[MAX_VPL_SEARCH_PATH] = "";
+    err = GetEnvironmentVariable("ONEVPL_DISPATCHER_SHARED_LOADER",
+                                 sharedLoader,
+                                 MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    strSharedLoader = sharedLoader;
+#else
+    const char *sharedLoader = std::getenv("ONEVPL_DISPATCHER_SHARED_LOADER");
+    if (!sharedLoader)
+        return MFX_ERR_UNSUPPORTED;
+
+    strSharedLoader = sharedLoader;
+#endif
+
+    if (strSharedLoader != "ON")
+        return MFX_ERR_UNSUPPORTED;
+
+    m_bSharedLoader = true;
+
+    return MFX_ERR_NONE;
+}
+
+// take a reference to the process-wide loader, creating it on first use, and
+//   copy its list of implementations
+// the libraries and caps trees are not copied and must be treated as read-only,
+//   while filtering (validImplIdx, flatCaps) and session pools are per-handle
+// search paths and caps cache settings are those in effect when the shared loader
+//   was created
+mfxStatus LoaderCtxVPL::LoadFromSharedLoader() {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    std::lock_guard<std::mutex> lock(g_sharedLoaderMutex);
+
+    bool bCreated = false;
+    if (!g_sharedLoader) {
+        LoaderCtxVPL *sharedLoader = new LoaderCtxVPL;
+        if (!sharedLoader)
+            return MFX_ERR_MEMORY_ALLOC;
+
+        sharedLoader->InitDispatcherLog();
+        sharedLoader->InitCapsCache();
+
+        mfxStatus sts = sharedLoader->FullLoadAndQuery();
+        if (sts != MFX_ERR_NONE) {
+            sharedLoader->UnloadAllLibraries();
+            delete sharedLoader;
+            return sts;
+        }
+
+        // copies are never updated, so query all caps up front
+        for (ImplInfo *implInfo : sharedLoader->m_implInfoList) {
+            if (implInfo->bCapsDeferred)
+                sharedLoader->QueryDeferredCaps(implInfo->libInfo);
+        }
+
+        g_sharedLoader = sharedLoader;
+        bCreated       = true;
+    }
+
+    for (ImplInfo *sharedImpl : g_sharedLoader->m_implInfoList) {
+        ImplInfo *implInfo = new ImplInfo;
+        if (!implInfo)
+            return MFX_ERR_MEMORY_ALLOC;
+
+        implInfo->libInfo   = sharedImpl->libInfo;
+        implInfo->implDesc  = sharedImpl->implDesc;
+        implInfo->implFuncs = sharedImpl->implFuncs;
+#ifdef ONEVPL_EXPERIMENTAL
+        implInfo->implExtDeviceID = sharedImpl->implExtDeviceID;
+#endif
+        implInfo->vplParam     = sharedImpl->vplParam;
+        implInfo->version      = sharedImpl->version;
+        implInfo->msdkImplIdx  = sharedImpl->msdkImplIdx;
+        implInfo->adapterIdx   = sharedImpl->adapterIdx;
+        implInfo->libImplIdx   = sharedImpl->libImplIdx;
+        implInfo->validImplIdx = m_implIdxNext++;
+
+        m_implInfoList.push_back(implInfo);
+    }
+
+    // search and query cost is only reported by the handle which created the shared loader
+    if (bCreated)
+        m_timing = g_sharedLoader->m_timing;
+
+    m_bPriorityPathEnabled = g_sharedLoader->m_bPriorityPathEnabled;
+    m_bSharedLoaderRef     = true;
+    g_sharedLoaderRefCount++;
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  shared loader %s -- %d implementations, %d handles",
+                     (bCreated ? "created" : "reused"),
+                     (int)m_implInfoList.size(),
+                     (int)g_sharedLoaderRefCount);
+
+    m_bNeedFullQuery        = false;
+    m_bNeedUpdateValidImpls = true;
+
+    return (m_implInfoList.empty() ? MFX_ERR_NOT_FOUND : MFX_ERR_NONE);
+}
+
+// free per-handle copies of the shared implementations and drop the reference
+// the shared loader is unloaded along with the last handle
+void LoaderCtxVPL::ReleaseSharedLoader() {
+    for (ImplInfo *implInfo : m_implInfoList) {
+        ClosePooledSessions(implInfo);
+        delete implInfo;
+    }
+
+    m_implInfoList.clear();
+    m_implIdxNext = 0;
+    m_capsArena.Reset();
+
+    m_bSharedLoaderRef = false;
+
+    std::lock_guard<std::mutex> lock(g_sharedLoaderMutex);
+
+    if (g_sharedLoaderRefCount > 0)
+        g_sharedLoaderRefCount--;
+
+    if (g_sharedLoaderRefCount == 0 && g_sharedLoader) {
+        g_sharedLoader->UnloadAllLibraries();
+        delete g_sharedLoader;
+        g_sharedLoader = nullptr;
+    }
+}
+
+// enable adapter load balancing if ONEVPL_DISPATCHER_ADAPTER_POLICY is set to ROUNDROBIN
+mfxStatus LoaderCtxVPL::InitAdapterPolicy() {
+    std::string strAdapterPolicy;
+
+#if defined(_WIN32) || defined(_WIN64)
+    DWORD err;
+
+    char adapterPolicy[MAX_VPL_SEARCH_PATH] = "";
+    err = GetEnvironmentVariable("ONEVPL_DISPATCHER_ADAPTER_POLICY",
+                                 adapterPolicy,
+                                 MAX_VPL_SEARCH_PATH);
+    if (err == 0 || err >= MAX_VPL_SEARCH_PATH)
+        return MFX_ERR_UNSUPPORTED; // environment variable not defined or string too long
+
+    strAdapterPolicy = adapterPolicy;
+#else
+    const char *adapterPolicy = std::getenv("ONEVPL_DISPATCHER_ADAPTER_POLICY");
+    if (!adapterPolicy)
+        return MFX_ERR_UNSUPPORTED;
+
+    strAdapterPolicy = adapterPolicy;
+#endif
+
+    if (strAdapterPolicy != "ROUNDROBIN")
+        return MFX_ERR_UNSUPPORTED;
+
+    m_bAdapterRoundRobin = true;
+
+    DISP_LOG_MESSAGE(&m_dispLog, "message:  adapter policy -- round robin");
+
+    return MFX_ERR_NONE;
+}
+
+// reorder valid implementations so that the ones on the next adapter come first
+// relative order of implementations on the same adapter is kept (stable sort), and
+//   implementations with unknown adapter (SW, non-x86 devices) are placed last
+// called from PrioritizeImplList() before the final HW > SW sort
+void LoaderCtxVPL::RotateAdapters() {
+    std::vector<mfxU32> adapters;
+    for (ImplInfo *implInfo : m_implInfoList) {
+        if (implInfo->validImplIdx < 0 || implInfo->adapterIdx == ADAPTER_IDX_UNKNOWN)
+            continue;
+
+        if (std::find(adapters.begin(), adapters.end(), implInfo->adapterIdx) == adapters.end())
+            adapters.push_back(implInfo->adapterIdx);
+    }
+
+    if (adapters.size() < 2)
+        return;
+
+    std::sort(adapters.begin(), adapters.end());
+
+    mfxU32 numAdapters = (mfxU32)adapters.size();
+    mfxU32 first       = GetNextAdapterRotation() % numAdapters;
+
+    auto getRank = [&](const ImplInfo *implInfo) {
+        auto it = std::find(adapters.begin(), adapters.end(), implInfo->adapterIdx);
+        if (it == adapters.end())
+            return numAdapters;
+
+        mfxU32 pos = (mfxU32)(it - adapters.begin());
+        return (pos + numAdapters - first) % numAdapters;
+    };
+
+    m_implInfoList.sort([&](const ImplInfo *impl1, const ImplInfo *impl2) {
+        return (getRank(impl1) < getRank(impl2));
+    });
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  adapter round robin -- first adapter %d of %d",
+                     adapters[first],
+                     numAdapters);
+}
+
+// same load as the first call to MFXCreateSession() with no filters set, either
+//   low latency (fast start) or full load and query
+// must be called with m_implListLock held exclusively
+mfxStatus LoaderCtxVPL::LoadAndQueryAsync() {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    if (m_bLowLatency) {
+        if (m_bNeedLowLatencyQuery) {
+            sts = LoadLibsLowLatency();
+            if (sts == MFX_ERR_NONE)
+                sts = QueryLibraryCaps();
+        }
+    }
+    else if (m_bNeedFullQuery) {
+        sts = FullLoadAndQuery();
+    }
+
+    if (sts != MFX_ERR_NONE || m_implInfoList.empty())
+        return MFX_ERR_NOT_FOUND;
+
+    return MFX_ERR_NONE;
+}
+
+void LoaderCtxVPL::RunAsyncLoad(mfxLoadCallback callback, mfxHDL userData) {
+    mfxStatus sts = MFX_ERR_NONE;
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(m_implListLock);
+        sts = LoadAndQueryAsync();
+    }
+
+    DISP_LOG_MESSAGE(&m_dispLog,
+                     "message:  async load finished -- sts = %d, %d implementations",
+                     sts,
+                     (int)m_implInfoList.size());
+
+    // callback returns before MFXLoadWait() does, so the app may release userData after waiting
+    if (callback)
+        callback((mfxLoader)this, sts, userData);
+
+    {
+        std::lock_guard<std::mutex> lock(m_asyncLoadMutex);
+        m_asyncLoadStatus = sts;
+        m_bAsyncLoadDone  = true;
+    }
+    m_asyncLoadCond.notify_all();
+}
+
+// called once by MFXLoadAsync(), before the loader handle is returned to the app
+mfxStatus LoaderCtxVPL::StartAsyncLoad(mfxLoadCallback callback, mfxHDL userData) {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    m_bAsyncLoad = true;
+
+    try {
+        m_asyncLoadThread = std::thread(&LoaderCtxVPL::RunAsyncLoad, this, callback, userData);
+    }
+    catch (...) {
+        // thread could not be created - load on the calling thread instead
+        DISP_LOG_MESSAGE(&m_dispLog, "message:  async load -- failed to create thread");
+        RunAsyncLoad(callback, userData);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus LoaderCtxVPL::WaitAsyncLoad(mfxU32 waitMs) {
+    if (!m_bAsyncLoad)
+        return MFX_ERR_NONE;
+
+    std::unique_lock<std::mutex> lock(m_asyncLoadMutex);
+
+    if (waitMs == MFX_INFINITE) {
+        m_asyncLoadCond.wait(lock, [this]() {
+            return m_bAsyncLoadDone;
+        });
+    }
+    else if (!m_asyncLoadCond.wait_for(lock, std::chrono::milliseconds(waitMs), [this]() {
+                 return m_bAsyncLoadDone;
+             })) {
+        return MFX_WRN_IN_EXECUTION;
+    }
+
+    return m_asyncLoadStatus;
+}
+
+void LoaderCtxVPL::JoinAsyncLoad() {
+    if (m_asyncLoadThread.joinable())
+        m_asyncLoadThread.join();
+}
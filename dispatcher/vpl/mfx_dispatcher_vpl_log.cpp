@@ -6,15 +6,34 @@
 
 #include "vpl/mfx_dispatcher_vpl_log.h"
 
-DispatcherLogVPL::DispatcherLogVPL() : m_logLevel(0), m_logFileName(), m_logFile(nullptr) {}
+// longest wait before the writer checks the queue again if a wakeup was missed
+#define DISP_LOG_ASYNC_WAIT_MSEC 10
+
+DispatcherLogVPL::DispatcherLogVPL()
+        : m_logLevel(0),
+          m_logFileName(),
+          m_logFile(nullptr),
+          m_bAsync(false),
+          m_records(),
+          m_tail(0),
+          m_head(0),
+          m_dropped(0),
+          m_bStop(false),
+          m_startTime(),
+          m_writer(),
+          m_writerMutex(),
+          m_writerCV() {}
 
 DispatcherLogVPL::~DispatcherLogVPL() {
+    // write any queued records before the file is closed
+    StopWriter();
+
     if (!m_logFileName.empty() && m_logFile)
         fclose(m_logFile);
     m_logFile = nullptr;
 }
 
-mfxStatus DispatcherLogVPL::Init(mfxU32 logLevel, const std::string &logFileName) {
+mfxStatus DispatcherLogVPL::Init(mfxU32 logLevel, const std::string &logFileName, bool bAsync) {
     // avoid leaking file handle if Init is accidentally called more than once
     if (m_logFile)
         return MFX_ERR_UNSUPPORTED;
@@ -43,21 +62,152 @@ mfxStatus DispatcherLogVPL::Init(mfxU32 logLevel, const std::string &logFileName
                 m_logFileName.clear();
             }
         }
+
+        if (bAsync) {
+            std::vector<LogRecord> records(DISP_LOG_ASYNC_RECORDS);
+            for (size_t i = 0; i < records.size(); i++)
+                records[i].seq.store(i, std::memory_order_relaxed);
+            m_records.swap(records);
+
+            m_startTime = std::chrono::steady_clock::now();
+            m_bStop     = false;
+
+            try {
+                m_writer = std::thread(&DispatcherLogVPL::WriterThread, this);
+                m_bAsync = true;
+            }
+            catch (...) {
+                // unable to start the thread, keep logging synchronously
+                m_records.clear();
+            }
+        }
     }
 
     return MFX_ERR_NONE;
 }
 
+void DispatcherLogVPL::LogMessageV(const char *msg, va_list args) {
+    if (m_bAsync) {
+        if (!PushRecordV(msg, args))
+            m_dropped++;
+        return;
+    }
+
+    vfprintf(m_logFile, msg, args);
+
+    fprintf(m_logFile, "\n");
+}
+
 mfxStatus DispatcherLogVPL::LogMessage(const char *msg, ...) {
-    if (!m_logLevel || !m_logFile)
+    if (m_logLevel != DISP_LOG_LEVEL_DEFAULT || !m_logFile)
         return MFX_ERR_NONE;
 
     va_list args;
     va_start(args, msg);
-    vfprintf(m_logFile, msg, args);
+    LogMessageV(msg, args);
     va_end(args);
 
-    fprintf(m_logFile, "\n");
+    return MFX_ERR_NONE;
+}
+
+mfxStatus DispatcherLogVPL::LogTiming(const char *msg, ...) {
+    if (!IsTimingEnabled() || !m_logFile)
+        return MFX_ERR_NONE;
+
+    va_list args;
+    va_start(args, msg);
+    LogMessageV(msg, args);
+    va_end(args);
 
     return MFX_ERR_NONE;
 }
+
+// bounded multi-producer queue: a slot is free for push number pos when seq == pos, and
+//   written when seq == pos + 1 (the writer sets seq to pos + size once it is printed)
+// returns false if the queue is full
+bool DispatcherLogVPL::PushRecordV(const char *msg, va_list args) {
+    size_t mask    = m_records.size() - 1;
+    size_t pos     = m_tail.load(std::memory_order_relaxed);
+    LogRecord *rec = nullptr;
+
+    while (1) {
+        rec        = &m_records[pos & mask];
+        size_t seq = rec->seq.load(std::memory_order_acquire);
+        intptr_t d = (intptr_t)seq - (intptr_t)pos;
+
+        if (d == 0) {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (d < 0) {
+            return false;
+        }
+        else {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    rec->timestamp = (mfxU64)std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - m_startTime)
+                         .count();
+    vsnprintf(rec->text, sizeof(rec->text), msg, args);
+
+    rec->seq.store(pos + 1, std::memory_order_release);
+    m_writerCV.notify_one();
+
+    return true;
+}
+
+// print the oldest record, returns false if the queue is empty
+bool DispatcherLogVPL::PopRecord() {
+    LogRecord *rec = &m_records[m_head & (m_records.size() - 1)];
+    if (rec->seq.load(std::memory_order_acquire) != m_head + 1)
+        return false;
+
+    fprintf(m_logFile,
+            "[%llu.%06llu] %s\n",
+            (unsigned long long)(rec->timestamp / 1000000),
+            (unsigned long long)(rec->timestamp % 1000000),
+            rec->text);
+
+    rec->seq.store(m_head + m_records.size(), std::memory_order_release);
+    m_head++;
+
+    return true;
+}
+
+void DispatcherLogVPL::WriterThread() {
+    while (1) {
+        while (PopRecord()) {}
+
+        if (m_bStop.load(std::memory_order_acquire))
+            break;
+
+        // a notification sent between the last pop and the wait is only missed for a timeout
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+        m_writerCV.wait_for(lock, std::chrono::milliseconds(DISP_LOG_ASYNC_WAIT_MSEC));
+    }
+
+    // records pushed while stopping
+    while (PopRecord()) {}
+
+    if (m_dropped)
+        fprintf(m_logFile,
+                "Warning - log queue full, %llu messages dropped\n",
+                (unsigned long long)m_dropped.load());
+
+    fflush(m_logFile);
+}
+
+void DispatcherLogVPL::StopWriter() {
+    if (!m_bAsync)
+        return;
+
+    m_bStop.store(true, std::memory_order_release);
+    m_writerCV.notify_one();
+
+    if (m_writer.joinable())
+        m_writer.join();
+
+    m_bAsync = false;
+}
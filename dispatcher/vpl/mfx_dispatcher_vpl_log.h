@@ -14,16 +14,38 @@
  * By default, oneVPL dispatcher prints all log messages to the console.
  * To redirect log output to the desired file, set the ONEVPL_DISPATCHER_LOG_FILE environmental 
  *   variable with the file name of the log file.
+ *
+ * Setting ONEVPL_DISPATCHER_LOG to "TIMING" prints only the startup timing messages, which are
+ *   also included in the full log ("ON").
+ *
+ * Setting ONEVPL_DISPATCHER_LOG_ASYNC to "ON" writes the log from a background thread. Messages
+ *   are formatted into a fixed-size queue by the calling thread and printed with the time since
+ *   the log was opened. Messages are dropped (and counted) rather than blocking if the queue is
+ *   full.
+ *
+ * When built with ITT_SUPPORT the timed startup stages are also reported as ITT tasks, so they
+ *   show up in VTune next to the tasks of the application.
  */
 
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "vpl/mfxdispatcher.h"
 #include "vpl/mfxvideo.h"
 
+#ifdef ITT_SUPPORT
+    #include <ittnotify.h>
+#endif
+
 #ifndef __FUNC_NAME__
     #if defined(_WIN32) || defined(_WIN64)
         #define __FUNC_NAME__ __FUNCTION__
@@ -32,19 +54,66 @@
     #endif
 #endif
 
+// log levels
+#define DISP_LOG_LEVEL_NONE    0 // logging disabled
+#define DISP_LOG_LEVEL_DEFAULT 1 // all messages
+#define DISP_LOG_LEVEL_TIMING  2 // timing messages only
+
+// async log queue, number of records must be a power of 2
+// longer messages are truncated
+#define DISP_LOG_ASYNC_RECORDS    1024
+#define DISP_LOG_ASYNC_RECORD_LEN 256
+
 class DispatcherLogVPL {
 public:
     DispatcherLogVPL();
     ~DispatcherLogVPL();
 
-    mfxStatus Init(mfxU32 logLevel, const std::string &logFileName);
+    mfxStatus Init(mfxU32 logLevel, const std::string &logFileName, bool bAsync = false);
     mfxStatus LogMessage(const char *msdk, ...);
+    mfxStatus LogTiming(const char *msg, ...);
+
+    bool IsTimingEnabled() {
+        return (m_logLevel == DISP_LOG_LEVEL_DEFAULT || m_logLevel == DISP_LOG_LEVEL_TIMING);
+    }
 
     mfxU32 m_logLevel;
 
 private:
+    // slot of the async queue, seq tells whether it is free or written (see PushRecordV)
+    struct LogRecord {
+        std::atomic<size_t> seq;
+        mfxU64 timestamp; // usec since Init
+        char text[DISP_LOG_ASYNC_RECORD_LEN];
+    };
+
+    void LogMessageV(const char *msg, va_list args);
+
+    // async mode - any thread pushes, only the writer thread pops
+    bool PushRecordV(const char *msg, va_list args);
+    bool PopRecord();
+    void WriterThread();
+    void StopWriter();
+
     std::string m_logFileName;
     FILE *m_logFile;
+
+    bool m_bAsync;
+    std::vector<LogRecord> m_records;
+    std::atomic<size_t> m_tail; // next slot to push
+    size_t m_head;              // next slot to pop
+    std::atomic<mfxU64> m_dropped;
+    std::atomic<bool> m_bStop;
+    std::chrono::steady_clock::time_point m_startTime;
+
+    // the writer sleeps between records, pushing never takes the lock
+    std::thread m_writer;
+    std::mutex m_writerMutex;
+    std::condition_variable m_writerCV;
+
+    // make this class non-copyable
+    DispatcherLogVPL(const DispatcherLogVPL &);
+    void operator=(const DispatcherLogVPL &);
 };
 
 class DispatcherLogVPLFunction {
@@ -54,14 +123,14 @@ public:
               m_fnName() {
         m_dispLog = dispLog;
 
-        if (m_dispLog && m_dispLog->m_logLevel) {
+        if (m_dispLog && m_dispLog->m_logLevel == DISP_LOG_LEVEL_DEFAULT) {
             m_fnName = fnName;
             m_dispLog->LogMessage("function: %s (enter)", m_fnName.c_str());
         }
     }
 
     ~DispatcherLogVPLFunction() {
-        if (m_dispLog && m_dispLog->m_logLevel)
+        if (m_dispLog && m_dispLog->m_logLevel == DISP_LOG_LEVEL_DEFAULT)
             m_dispLog->LogMessage("function: %s (return)", m_fnName.c_str());
     }
 
@@ -70,7 +139,95 @@ private:
     std::string m_fnName;
 };
 
+// measure time until end of scope, optionally add it to totalTime (usec)
+// elapsed time is logged if timing messages are enabled
+class DispatcherLogVPLTiming {
+public:
+    DispatcherLogVPLTiming(DispatcherLogVPL *dispLog, mfxU64 *totalTime, const char *stage)
+            : m_dispLog(dispLog),
+              m_totalTime(totalTime),
+              m_stage(stage),
+              m_name(),
+              m_startTime(std::chrono::steady_clock::now()) {
+        BeginTask();
+    }
+
+    // name is converted to printable ASCII only if timing is logged
+    template <typename T>
+    DispatcherLogVPLTiming(DispatcherLogVPL *dispLog,
+                           mfxU64 *totalTime,
+                           const char *stage,
+                           const std::basic_string<T> &name)
+            : m_dispLog(dispLog),
+              m_totalTime(totalTime),
+              m_stage(stage),
+              m_name(),
+              m_startTime(std::chrono::steady_clock::now()) {
+        if (m_dispLog && m_dispLog->IsTimingEnabled())
+            m_name = GetPrintableName(name);
+        BeginTask();
+    }
+
+    // convert path (char or wchar_t) to printable ASCII for logging
+    template <typename T>
+    static std::string GetPrintableName(const std::basic_string<T> &name) {
+        std::string s;
+        for (T c : name)
+            s += ((c >= 0x20 && c < 0x7f) ? (char)c : '?');
+        return s;
+    }
+
+    ~DispatcherLogVPLTiming() {
+#ifdef ITT_SUPPORT
+        __itt_task_end(GetDomain());
+#endif
+        std::chrono::microseconds elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - m_startTime);
+
+        if (m_totalTime)
+            *m_totalTime += (mfxU64)elapsed.count();
+
+        if (m_dispLog && m_dispLog->IsTimingEnabled()) {
+            m_dispLog->LogTiming("timing:   %s%s%s -- %.3f msec",
+                                 m_stage,
+                                 (m_name.empty() ? "" : " "),
+                                 m_name.c_str(),
+                                 elapsed.count() / 1000.0);
+        }
+    }
+
+private:
+    DispatcherLogVPL *m_dispLog;
+    mfxU64 *m_totalTime;
+    const char *m_stage;
+    std::string m_name;
+    std::chrono::steady_clock::time_point m_startTime;
+
+#ifdef ITT_SUPPORT
+    static __itt_domain *GetDomain() {
+        static __itt_domain *domain = __itt_domain_create("oneVPL dispatcher");
+        return domain;
+    }
+
+    // ITT returns the existing handle for a name it has already seen
+    void BeginTask() {
+        __itt_task_begin(GetDomain(),
+                         __itt_null,
+                         __itt_null,
+                         __itt_string_handle_create(m_stage));
+    }
+#else
+    void BeginTask() {}
+#endif
+
+    // make this class non-copyable
+    DispatcherLogVPLTiming(const DispatcherLogVPLTiming &);
+    void operator=(const DispatcherLogVPLTiming &);
+};
+
 #define DISP_LOG_FUNCTION(dispLog) DispatcherLogVPLFunction _dispLogFn(dispLog, __FUNC_NAME__);
+#define DISP_LOG_TIMING(dispLog, totalTime, ...) \
+    DispatcherLogVPLTiming _dispLogTiming(dispLog, totalTime, __VA_ARGS__);
 #define DISP_LOG_MESSAGE(dispLog, ...)          \
     {                                           \
         if (dispLog) {                          \
@@ -33,6 +33,14 @@
 //  VPL - load from system paths in LoadLibsFromMultipleDirs(), look only for libmfx-gen.so.1.2
 //  MSDK - load from system paths in LoadLibsFromMultipleDirs(), look only for libmfxhw64.so.1
 
+// Fast start (all platforms):
+//  The full path to the runtime is given with the filter property "FastStartPath" (mfxChar *)
+//    or the environment variable ONEVPL_DISPATCHER_FAST_START_PATH. Only this library is loaded,
+//    search paths are not enumerated and QueryLibraryCaps() does not query the caps.
+//  Any other filter properties describe the caps the application expects from this runtime and
+//    are not validated. The minimum API version (if set) is still checked in CreateSession().
+//  Calling MFXEnumImplementations() leaves fast start mode and runs the full query.
+
 // library names
 static const CHAR_TYPE *libNameVPL  = LIB_ONEVPL;
 static const CHAR_TYPE *libNameMSDK = LIB_MSDK;
@@ -44,6 +52,9 @@ static const char *reqFuncMSDK = "MFXInitEx";
 LibInfo *LoaderCtxVPL::AddSingleLibrary(STRING_TYPE libPath, LibType libType) {
     LibInfo *libInfo = nullptr;
 
+    DISP_LOG_TIMING(&m_dispLog, &m_timing.LoadLibsTime, "load library", libPath);
+    m_timing.NumLibsLoaded++;
+
 #if defined(_WIN32) || defined(_WIN64)
     // try to open library
     mfxModuleHandle hLib = MFX::mfx_dll_load(libPath.c_str());
@@ -53,11 +64,12 @@ LibInfo *LoaderCtxVPL::AddSingleLibrary(STRING_TYPE libPath, LibType libType) {
     // check for required entrypoint function
     const char *reqFunc  = (libType == LibTypeVPL ? reqFuncVPL : reqFuncMSDK);
     VPLFunctionPtr pProc = (VPLFunctionPtr)MFX::mfx_dll_get_addr(hLib, reqFunc);
-    MFX::mfx_dll_free(hLib);
 
     // entrypoint function missing - invalid library
-    if (!pProc)
+    if (!pProc) {
+        MFX::mfx_dll_free(hLib);
         return nullptr;
+    }
 #else
     // try to open library
     void *hLib = dlopen(libPath.c_str(), RTLD_LOCAL | RTLD_NOW);
@@ -67,18 +79,27 @@ LibInfo *LoaderCtxVPL::AddSingleLibrary(STRING_TYPE libPath, LibType libType) {
     // check for required entrypoint function
     const char *reqFunc  = (libType == LibTypeVPL ? reqFuncVPL : reqFuncMSDK);
     VPLFunctionPtr pProc = (VPLFunctionPtr)dlsym(hLib, reqFunc);
-    dlclose(hLib);
 
     // entrypoint function missing - invalid library
-    if (!pProc)
+    if (!pProc) {
+        dlclose(hLib);
         return nullptr;
+    }
 #endif
 
     // create new LibInfo and add to list
     libInfo = new LibInfo;
-    if (!libInfo)
+    if (!libInfo) {
+#if defined(_WIN32) || defined(_WIN64)
+        MFX::mfx_dll_free(hLib);
+#else
+        dlclose(hLib);
+#endif
         return nullptr;
+    }
 
+    // keep library open, LoadSingleLibrary() will reuse this handle
+    libInfo->hModuleVPL  = hLib;
     libInfo->libNameFull = libPath;
     libInfo->libType     = libType;
     libInfo->libPriority = (libType == LibTypeVPL ? LIB_PRIORITY_01 : LIB_PRIORITY_LEGACY);
@@ -116,10 +137,10 @@ mfxStatus LoaderCtxVPL::LoadLibsFromDriverStore(mfxU32 numAdapters,
     for (adapterID = 0; adapterID < numAdapters; adapterID++) {
         // get driver store path for this adapter
         libPath.clear();
-        sts = MFX::MFXLibraryIterator::GetDriverStoreDir(libPath,
-                                                         MAX_VPL_SEARCH_PATH,
-                                                         adapterInfo[adapterID].deviceID,
-                                                         storageID);
+        sts = MFX::AdapterCache::GetDriverStoreDir(libPath,
+                                                   MAX_VPL_SEARCH_PATH,
+                                                   adapterInfo[adapterID].deviceID,
+                                                   storageID);
         if (sts != MFX_ERR_NONE || libPath.size() == 0)
             continue;
 
@@ -249,9 +270,58 @@ mfxStatus LoaderCtxVPL::LoadLibsFromMultipleDirs(LibType libType) {
 #endif
 }
 
+// fast start - load runtime from the path provided by the application or environment
+//   instead of the default low latency locations
+mfxStatus LoaderCtxVPL::LoadLibsFastStart() {
+    DISP_LOG_FUNCTION(&m_dispLog);
+
+    STRING_TYPE libPath = m_fastStartPath;
+
+    // filter property takes precedence over environment variable
+    if (m_specialConfig.bIsSet_fastStartPath) {
+        const std::string &cfgPath = m_specialConfig.fastStartPath;
+        libPath.assign(cfgPath.begin(), cfgPath.end());
+    }
+
+    if (libPath.empty())
+        return MFX_ERR_UNSUPPORTED;
+
+    // runtime type is determined by the exported entrypoint
+    LibType libTypes[] = { LibTypeVPL, LibTypeMSDK };
+
+    for (LibType libType : libTypes) {
+        LibInfo *libInfo = AddSingleLibrary(libPath, libType);
+        if (!libInfo)
+            continue;
+
+        mfxStatus sts = LoadSingleLibrary(libInfo);
+        if (sts == MFX_ERR_NONE) {
+            mfxU32 numFunctions = LoadAPIExports(libInfo, libType);
+
+            if (libType == LibTypeVPL || numFunctions == NumMSDKFunctions) {
+                DISP_LOG_MESSAGE(&m_dispLog,
+                                 "message:  fast start -- %s runtime loaded",
+                                 (libType == LibTypeVPL ? "VPL" : "MSDK"));
+
+                m_libInfoList.push_back(libInfo);
+                m_bNeedLowLatencyQuery = false;
+                return MFX_ERR_NONE;
+            }
+        }
+        UnloadSingleLibrary(libInfo); // failed - try as next library type
+    }
+
+    DISP_LOG_MESSAGE(&m_dispLog, "message:  fast start -- failed to load runtime");
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
 mfxStatus LoaderCtxVPL::LoadLibsLowLatency() {
     DISP_LOG_FUNCTION(&m_dispLog);
 
+    if (m_bFastStart)
+        return LoadLibsFastStart();
+
 #if defined(_WIN32) || defined(_WIN64)
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -259,7 +329,7 @@ mfxStatus LoaderCtxVPL::LoadLibsLowLatency() {
     mfxU32 numAdapters = 0;
 
     std::vector<DXGI1DeviceInfo> adapterInfo;
-    bool bEnumSuccess = MFX::DXGI1Device::GetAdapterList(adapterInfo);
+    bool bEnumSuccess = MFX::AdapterCache::GetAdapterList(adapterInfo);
     numAdapters       = (mfxU32)adapterInfo.size();
 
     // error - no graphics adapters found
@@ -110,7 +110,10 @@ LoaderCtxMSDK::LoaderCtxMSDK()
           m_libNameFull(),
           m_id(),
           m_accelMode(),
-          m_loaderDeviceID(0) {
+          m_loaderDeviceID(0),
+          m_bProbed(false),
+          m_probeSts(MFX_ERR_UNSUPPORTED),
+          m_bCheckedD3D9(false) {
 }
 
 LoaderCtxMSDK::~LoaderCtxMSDK() {}
@@ -187,7 +190,9 @@ mfxStatus LoaderCtxMSDK::GetDefaultAccelType(mfxU32 adapterID, mfxIMPL *implDefa
 #endif
 }
 
-mfxStatus LoaderCtxMSDK::QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *msdkVersion) {
+mfxStatus LoaderCtxMSDK::QueryAPIVersion(STRING_TYPE libNameFull,
+                                         mfxVersion *msdkVersion,
+                                         LoaderCtxMSDK *msdkCtx) {
     mfxStatus sts;
     mfxSession session = nullptr;
 
@@ -223,6 +228,14 @@ mfxStatus LoaderCtxMSDK::QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *ms
 
         if (sts == MFX_ERR_NONE) {
             sts = MFXQueryVersion(session, msdkVersion);
+
+            // session creation initializes the device, so fill in the caps of this
+            //   adapter now rather than opening a second session in QueryMSDKCaps()
+            if (sts == MFX_ERR_NONE && msdkCtx &&
+                msdkCtx[adapterID].CheckAdapter(adapterID) == MFX_ERR_NONE) {
+                msdkCtx[adapterID].m_loaderDeviceID = deviceID;
+                msdkCtx[adapterID].ProbeAdapter(session, libNameFull, adapterID, implDefault, luid);
+            }
             MFXClose(session);
 
             if (sts == MFX_ERR_NONE)
@@ -233,6 +246,24 @@ mfxStatus LoaderCtxMSDK::QueryAPIVersion(STRING_TYPE libNameFull, mfxVersion *ms
     return MFX_ERR_UNSUPPORTED;
 }
 
+// check that adapterID may be used before opening a session on it
+mfxStatus LoaderCtxMSDK::CheckAdapter(mfxU32 adapterID) {
+    m_deviceID = 0;
+
+#ifdef __linux__
+    mfxU32 vendorID = 0;
+    mfxU16 deviceID = 0;
+    mfxStatus sts   = GetRenderNodeDescription(adapterID, vendorID, deviceID);
+    if (sts != MFX_ERR_NONE)
+        return MFX_ERR_UNSUPPORTED;
+
+    // on Linux read deviceID from the render node path
+    m_deviceID = deviceID;
+#endif
+
+    return MFX_ERR_NONE;
+}
+
 mfxStatus LoaderCtxMSDK::QueryMSDKCaps(STRING_TYPE libNameFull,
                                        mfxImplDescription **implDesc,
                                        mfxImplementedFunctions **implFuncs,
@@ -244,51 +275,95 @@ mfxStatus LoaderCtxMSDK::QueryMSDKCaps(STRING_TYPE libNameFull,
 #endif
 
     mfxStatus sts;
-    mfxSession session = nullptr;
 
-    m_libNameFull = libNameFull;
-    m_deviceID    = 0;
+    // adapter may already have been probed by QueryAPIVersion() or a previous call
+    if (!m_bProbed || m_libNameFull != libNameFull) {
+        mfxSession session = nullptr;
+
+        m_bProbed      = true;
+        m_probeSts     = MFX_ERR_UNSUPPORTED;
+        m_bCheckedD3D9 = false;
+        m_libNameFull  = libNameFull;
 
 #ifdef __linux__
-    // require pthreads to be linked in for MSDK RT to load
-    pthread_key_t pkey;
-    if (pthread_key_create(&pkey, NULL) == 0) {
-        pthread_key_delete(pkey);
-    }
+        // require pthreads to be linked in for MSDK RT to load
+        pthread_key_t pkey;
+        if (pthread_key_create(&pkey, NULL) == 0) {
+            pthread_key_delete(pkey);
+        }
+#endif
 
-    mfxU32 vendorID = 0;
-    mfxU16 deviceID = 0;
-    sts             = GetRenderNodeDescription(adapterID, vendorID, deviceID);
-    if (sts != MFX_ERR_NONE)
-        return MFX_ERR_UNSUPPORTED;
+        if (CheckAdapter(adapterID) != MFX_ERR_NONE)
+            return MFX_ERR_UNSUPPORTED;
 
-    // on Linux read deviceID from the render node path
-    m_deviceID = deviceID;
-#endif
+        // try HW session, default acceleration mode
+        mfxIMPL hwImpl      = msdkImplTab[adapterID];
+        mfxIMPL implDefault = MFX_IMPL_UNSUPPORTED;
+        mfxU64 luid         = 0;
 
-    // try HW session, default acceleration mode
-    mfxIMPL hwImpl      = msdkImplTab[adapterID];
-    mfxIMPL implDefault = MFX_IMPL_UNSUPPORTED;
+        sts = GetDefaultAccelType(adapterID, &implDefault, &luid);
+        if (sts != MFX_ERR_NONE)
+            return MFX_ERR_UNSUPPORTED;
 
-    sts = GetDefaultAccelType(adapterID, &implDefault, &m_luid);
-    if (sts != MFX_ERR_NONE)
-        return MFX_ERR_UNSUPPORTED;
+        mfxAccelerationMode accelMode = CvtAccelType(MFX_IMPL_HARDWARE, implDefault & 0xFF00);
 
-    sts = OpenSession(&session,
-                      m_libNameFull,
-                      (mfxAccelerationMode)CvtAccelType(MFX_IMPL_HARDWARE, implDefault & 0xFF00),
-                      hwImpl);
+        sts = OpenSession(&session, m_libNameFull, accelMode, hwImpl);
 
-    // adapter unsupported
-    if (sts != MFX_ERR_NONE)
-        return MFX_ERR_UNSUPPORTED;
+        // adapter unsupported
+        if (sts != MFX_ERR_NONE)
+            return MFX_ERR_UNSUPPORTED;
+
+        ProbeAdapter(session, m_libNameFull, adapterID, implDefault, luid);
+
+        CloseSession(&session);
+    }
+
+    if (m_probeSts != MFX_ERR_NONE)
+        return m_probeSts;
 
     // return list of implemented functions
     *implFuncs = (mfxImplementedFunctions *)(&msdkImplFuncs);
+    *implDesc  = &m_id;
+
+#if defined(_WIN32) || defined(_WIN64)
+    // D3D9 needs a session of its own, so it is only checked when requested
+    if (bSkipD3D9Check == false && m_bCheckedD3D9 == false) {
+        mfxAccelerationModeDescription *accelDesc = &(m_id.AccelerationModeDescription);
+        mfxIMPL implD3D9;
+        m_msdkAdapterD3D9 = MFX_IMPL_UNSUPPORTED;
+        m_bCheckedD3D9    = true;
+
+        sts = CheckD3D9Support(m_luid, libNameFull, &implD3D9);
+        if (sts == MFX_ERR_NONE) {
+            m_msdkAdapterD3D9 = implD3D9;
+
+            accelDesc->Mode[accelDesc->NumAccelerationModes] = MFX_ACCEL_MODE_VIA_D3D9;
+            accelDesc->NumAccelerationModes++;
+        }
+    }
+#endif
+
+    return MFX_ERR_NONE;
+}
+
+// fill in description of adapterID using a session opened on it
+// m_deviceID must have been set by CheckAdapter()
+mfxStatus LoaderCtxMSDK::ProbeAdapter(mfxSession session,
+                                      STRING_TYPE libNameFull,
+                                      mfxU32 adapterID,
+                                      mfxIMPL implDefault,
+                                      mfxU64 luid) {
+    mfxStatus sts;
+    mfxIMPL hwImpl = msdkImplTab[adapterID];
+
+    m_libNameFull  = libNameFull;
+    m_luid         = luid;
+    m_bProbed      = true;
+    m_probeSts     = MFX_ERR_UNSUPPORTED;
+    m_bCheckedD3D9 = false;
 
     // clear new 2.0 style description struct
     memset(&m_id, 0, sizeof(mfxImplDescription));
-    *implDesc = &m_id;
 
     // fill in top-level capabilities
     m_id.Version.Version = MFX_IMPLDESCRIPTION_VERSION;
@@ -297,7 +372,7 @@ mfxStatus LoaderCtxMSDK::QueryMSDKCaps(STRING_TYPE libNameFull,
     // query API version
     sts = MFXQueryVersion(session, &m_id.ApiVersion);
     if (sts != MFX_ERR_NONE) {
-        CloseSession(&session);
+        m_probeSts = sts;
         return sts;
     }
 
@@ -376,22 +451,7 @@ mfxStatus LoaderCtxMSDK::QueryMSDKCaps(STRING_TYPE libNameFull,
     snprintf(Dev->DeviceID, sizeof(Dev->DeviceID), "%x/%d", m_deviceID, m_id.VendorImplID);
     Dev->NumSubDevices = 0;
 
-    CloseSession(&session);
-
-#if defined(_WIN32) || defined(_WIN64)
-    if (bSkipD3D9Check == false) {
-        mfxIMPL implD3D9;
-        m_msdkAdapterD3D9 = MFX_IMPL_UNSUPPORTED;
-
-        sts = CheckD3D9Support(m_luid, libNameFull, &implD3D9);
-        if (sts == MFX_ERR_NONE) {
-            m_msdkAdapterD3D9 = implD3D9;
-
-            accelDesc->Mode[accelDesc->NumAccelerationModes] = MFX_ACCEL_MODE_VIA_D3D9;
-            accelDesc->NumAccelerationModes++;
-        }
-    }
-#endif
+    m_probeSts = MFX_ERR_NONE;
 
     return MFX_ERR_NONE;
 }
@@ -9,6 +9,7 @@
 
 // headers for Windows legacy dispatcher
 #if defined(_WIN32) || defined(_WIN64)
+    #include "windows/mfx_adapter_cache.h"
     #include "windows/mfx_dispatcher.h"
     #include "windows/mfx_dispatcher_defs.h"
     #include "windows/mfx_dxva2_device.h"
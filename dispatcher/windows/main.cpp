@@ -10,7 +10,9 @@
 
 #include <memory>
 #include <new>
+#include <vector>
 
+#include "windows/mfx_adapter_cache.h"
 #include "windows/mfx_critical_section.h"
 #include "windows/mfx_dispatcher.h"
 #include "windows/mfx_dispatcher_log.h"
@@ -19,6 +21,8 @@
 
 #include "windows/mfx_vector.h"
 
+#include "vpl/mfx_dispatcher_vpl_admission.h"
+
 #if defined(MEDIASDK_UWP_DISPATCHER)
     #include "windows/mfx_driver_store_loader.h"
 #endif
@@ -220,6 +224,41 @@ mfxStatus MFXInitEx(mfxInitParam par, mfxSession *session) {
 
     DISPATCHER_LOG_INFO(
         (("Required API version is %u.%u\n"), requiredVersion.Major, requiredVersion.Minor));
+
+    // libraries of the previous search with the same parameters are loaded in
+    //   their sorted order, the first one loaded is the known-good library
+    std::vector<LibraryCandidate> cachedCandidates;
+    if (AdapterCache::GetLibraryCandidates(par.Implementation, requiredVersion, cachedCandidates)) {
+        for (const LibraryCandidate &cached : cachedCandidates) {
+            DISPATCHER_LOG_INFO((("loading cached library %S\n"), cached.dllPath.c_str()));
+            mfxRes = pHandle->LoadSelectedDLL(cached.dllPath.c_str(),
+                                              cached.implType,
+                                              cached.impl,
+                                              cached.implInterface,
+                                              par,
+                                              vplParam);
+            if (MFX_ERR_NONE != mfxRes && cached.loadStatus != mfxRes) {
+                pHandle->Close();
+                continue;
+            }
+
+            wcscpy_s(pHandle->subkeyName,
+                     sizeof(pHandle->subkeyName) / sizeof(pHandle->subkeyName[0]),
+                     cached.subkeyName);
+            pHandle->storageID        = cached.storageID;
+            pHandle->mediaAdapterType = cached.mediaAdapterType;
+
+            // the session is initialized once, so no device handle is created by
+            //   MFXVideoCORE_QueryPlatform and close-init is not needed
+            *((MFX_DISP_HANDLE_EX **)session) = pHandle;
+            return pHandle->loadStatus;
+        }
+        DISPATCHER_LOG_WRN(("cached libraries failed to load, searching again\n"));
+        AdapterCache::SetLibraryCandidates(par.Implementation,
+                                           requiredVersion,
+                                           std::vector<LibraryCandidate>());
+    }
+
     // particular implementation value
     mfxIMPL curImpl;
 
@@ -431,6 +470,32 @@ mfxStatus MFXInitEx(mfxInitParam par, mfxSession *session) {
                   sizeof(MFX_DISP_HANDLE_EX *),
                   &HandleSort);
     }
+
+    { // remember sorted candidates for the next sessions
+        std::vector<LibraryCandidate> candidates;
+        for (MFX_DISP_HANDLE_EX *loaded : allocatedHandle) {
+            LibraryCandidate candidate;
+            wchar_t dllPath[MFX_MAX_DLL_PATH] = { 0 };
+            if (!GetModuleFileNameW((HMODULE)loaded->hModule,
+                                    dllPath,
+                                    sizeof(dllPath) / sizeof(dllPath[0])))
+                continue;
+
+            candidate.dllPath       = dllPath;
+            candidate.implType      = loaded->implType;
+            candidate.impl          = loaded->impl;
+            candidate.implInterface = loaded->implInterface;
+            candidate.loadStatus    = loaded->loadStatus;
+            wcscpy_s(candidate.subkeyName,
+                     sizeof(candidate.subkeyName) / sizeof(candidate.subkeyName[0]),
+                     loaded->subkeyName);
+            candidate.storageID        = loaded->storageID;
+            candidate.mediaAdapterType = loaded->mediaAdapterType;
+            candidates.push_back(candidate);
+        }
+        AdapterCache::SetLibraryCandidates(par.Implementation, requiredVersion, candidates);
+    }
+
     HandleVector::iterator candidate = allocatedHandle.begin();
     // check the final result of loading
     try {
@@ -611,6 +676,9 @@ mfxStatus MFXClose(mfxSession session) {
             if (MFX_ERR_UNDEFINED_BEHAVIOR != mfxRes) {
                 // release the handle
                 delete pHandle;
+
+                // return the cost of the session to the budget of its adapter
+                ReleaseSessionAdmission(session);
             }
         }
         catch (...) {
@@ -1111,6 +1179,17 @@ mfxStatus MFXVideoVPP_ProcessFrameAsync(mfxSession session,
     return sts;
 }
 
+// per-session call statistics are only collected by the Linux dispatcher
+mfxStatus MFXDispGetSessionStats(mfxSession session, mfxDispatcherSessionStats *stats) {
+    if (!session)
+        return MFX_ERR_INVALID_HANDLE;
+
+    if (!stats)
+        return MFX_ERR_NULL_PTR;
+
+    return MFX_ERR_UNSUPPORTED;
+}
+
 //
 //
 // implement all other calling functions.
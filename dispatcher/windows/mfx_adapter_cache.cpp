@@ -0,0 +1,239 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include <cfgmgr32.h>
+
+#include "windows/mfx_adapter_cache.h"
+#include "windows/mfx_dxva2_device.h"
+#include "windows/mfx_library_iterator.h"
+#include "windows/mfx_load_dll.h"
+
+// CM_Register_Notification requires Windows 8 SDK headers (not available in older MinGW)
+#if defined(CM_NOTIFY_FILTER_FLAG_ALL_INTERFACE_CLASSES) && !defined(MEDIASDK_UWP_DISPATCHER)
+    #define MFX_ADAPTER_CACHE_NOTIFY_ENABLED
+#endif
+
+namespace MFX {
+
+#if defined(MFX_ADAPTER_CACHE_NOTIFY_ENABLED)
+// GUID_DEVINTERFACE_DISPLAY_ADAPTER, declared here to avoid pulling in ntddvdeo.h
+static const GUID guidDisplayAdapterInterface = {
+    0x5b45201d,
+    0xf2f2,
+    0x4f3b,
+    { 0x85, 0xbb, 0x30, 0xff, 0x1f, 0x95, 0x35, 0x99 }
+};
+
+typedef CONFIGRET(WINAPI *Func_CM_Register_Notification)(PCM_NOTIFY_FILTER pFilter,
+                                                         PVOID pContext,
+                                                         PCM_NOTIFY_CALLBACK pCallback,
+                                                         PHCMNOTIFICATION pNotifyContext);
+#endif
+
+// incremented from the PnP notification thread, so kept outside of the
+//   cache state (trivially destructible, valid until process exit)
+static std::atomic<mfxU32> adapterChangeCount(0);
+
+struct AdapterCacheState {
+    AdapterCacheState()
+            : cacheLock(),
+              bNotifyAttempted(false),
+              bNotifyRegistered(false),
+              cachedChangeCount(0),
+              bAdapterListValid(false),
+              bAdapterEnumSuccess(false),
+              adapterInfo(),
+              driverStoreDirs(),
+              libraryCandidates() {}
+
+    std::mutex cacheLock;
+
+    bool bNotifyAttempted;
+    bool bNotifyRegistered;
+    mfxU32 cachedChangeCount;
+
+    bool bAdapterListValid;
+    bool bAdapterEnumSuccess;
+    std::vector<DXGI1DeviceInfo> adapterInfo;
+
+    // key = {deviceID, storageID}, failed lookups are cached as well
+    std::map<std::pair<mfxU32, int>, std::pair<mfxStatus, std::wstring>> driverStoreDirs;
+
+    // key = {implementation, API version}, only successful searches are cached
+    std::map<std::pair<mfxIMPL, mfxU32>, std::vector<LibraryCandidate>> libraryCandidates;
+};
+
+static AdapterCacheState &GetAdapterCacheState() {
+    static AdapterCacheState cacheState;
+    return cacheState;
+}
+
+#if defined(MFX_ADAPTER_CACHE_NOTIFY_ENABLED)
+static DWORD CALLBACK OnAdapterInterfaceChange(HCMNOTIFICATION /* hNotify */,
+                                               PVOID /* pContext */,
+                                               CM_NOTIFY_ACTION action,
+                                               PCM_NOTIFY_EVENT_DATA /* pEventData */,
+                                               DWORD /* eventDataSize */) {
+    if (action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL ||
+        action == CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL)
+        adapterChangeCount++;
+
+    return ERROR_SUCCESS;
+}
+#endif
+
+static bool RegisterAdapterNotification() {
+#if defined(MFX_ADAPTER_CACHE_NOTIFY_ENABLED)
+    mfxModuleHandle hModule = mfx_dll_load(L"cfgmgr32.dll");
+    if (!hModule)
+        return false;
+
+    Func_CM_Register_Notification pRegisterNotification =
+        (Func_CM_Register_Notification)mfx_dll_get_addr(hModule, "CM_Register_Notification");
+    if (!pRegisterNotification) {
+        mfx_dll_free(hModule);
+        return false;
+    }
+
+    // the registration is never removed (unregistering from DllMain may deadlock),
+    //   so pin this module to keep the callback valid until process exit
+    HMODULE hSelf = NULL;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                            (LPCWSTR)&OnAdapterInterfaceChange,
+                            &hSelf)) {
+        mfx_dll_free(hModule);
+        return false;
+    }
+
+    CM_NOTIFY_FILTER filter            = {};
+    filter.cbSize                      = sizeof(filter);
+    filter.FilterType                  = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+    filter.u.DeviceInterface.ClassGuid = guidDisplayAdapterInterface;
+
+    HCMNOTIFICATION hNotify = NULL;
+    CONFIGRET result = pRegisterNotification(&filter, NULL, OnAdapterInterfaceChange, &hNotify);
+    if (result != CR_SUCCESS) {
+        mfx_dll_free(hModule);
+        return false;
+    }
+
+    // cfgmgr32 stays loaded while the notification is registered
+    return true;
+#else
+    return false;
+#endif
+}
+
+// return true if the cache may be used, dropping any entries which were
+//   added before the last adapter change
+// must be called with cacheLock held
+static bool UpdateAdapterCacheState(AdapterCacheState &cacheState) {
+    if (!cacheState.bNotifyAttempted) {
+        cacheState.bNotifyAttempted  = true;
+        cacheState.bNotifyRegistered = RegisterAdapterNotification();
+    }
+
+    if (!cacheState.bNotifyRegistered)
+        return false;
+
+    mfxU32 changeCount = adapterChangeCount.load();
+    if (changeCount != cacheState.cachedChangeCount) {
+        cacheState.bAdapterListValid   = false;
+        cacheState.bAdapterEnumSuccess = false;
+        cacheState.adapterInfo.clear();
+        cacheState.driverStoreDirs.clear();
+        cacheState.libraryCandidates.clear();
+        cacheState.cachedChangeCount = changeCount;
+    }
+
+    return true;
+}
+
+// same semantics as DXGI1Device::GetAdapterList() - adapters are appended to adapterInfo
+bool AdapterCache::GetAdapterList(std::vector<DXGI1DeviceInfo> &adapterInfo) {
+    AdapterCacheState &cacheState = GetAdapterCacheState();
+    std::lock_guard<std::mutex> lock(cacheState.cacheLock);
+
+    if (!UpdateAdapterCacheState(cacheState))
+        return DXGI1Device::GetAdapterList(adapterInfo);
+
+    if (!cacheState.bAdapterListValid) {
+        cacheState.bAdapterEnumSuccess = DXGI1Device::GetAdapterList(cacheState.adapterInfo);
+        cacheState.bAdapterListValid   = true;
+    }
+
+    adapterInfo.insert(adapterInfo.end(),
+                       cacheState.adapterInfo.begin(),
+                       cacheState.adapterInfo.end());
+
+    return cacheState.bAdapterEnumSuccess;
+}
+
+// same semantics as MFXLibraryIterator::GetDriverStoreDir()
+mfxStatus AdapterCache::GetDriverStoreDir(std::wstring &driverStoreDir,
+                                          size_t length,
+                                          mfxU32 deviceID,
+                                          int storageID) {
+    AdapterCacheState &cacheState = GetAdapterCacheState();
+    std::lock_guard<std::mutex> lock(cacheState.cacheLock);
+
+    if (!UpdateAdapterCacheState(cacheState))
+        return MFXLibraryIterator::GetDriverStoreDir(driverStoreDir, length, deviceID, storageID);
+
+    std::pair<mfxU32, int> key(deviceID, storageID);
+
+    auto it = cacheState.driverStoreDirs.find(key);
+    if (it == cacheState.driverStoreDirs.end()) {
+        std::wstring dir;
+        mfxStatus sts = MFXLibraryIterator::GetDriverStoreDir(dir, length, deviceID, storageID);
+        it            = cacheState.driverStoreDirs.emplace(key, std::make_pair(sts, dir)).first;
+    }
+
+    if (it->second.first == MFX_ERR_NONE)
+        driverStoreDir = it->second.second;
+
+    return it->second.first;
+}
+
+bool AdapterCache::GetLibraryCandidates(mfxIMPL implementation,
+                                        mfxVersion version,
+                                        std::vector<LibraryCandidate> &candidates) {
+    AdapterCacheState &cacheState = GetAdapterCacheState();
+    std::lock_guard<std::mutex> lock(cacheState.cacheLock);
+
+    if (!UpdateAdapterCacheState(cacheState))
+        return false;
+
+    auto it = cacheState.libraryCandidates.find(std::make_pair(implementation, version.Version));
+    if (it == cacheState.libraryCandidates.end())
+        return false;
+
+    candidates = it->second;
+    return true;
+}
+
+void AdapterCache::SetLibraryCandidates(mfxIMPL implementation,
+                                        mfxVersion version,
+                                        const std::vector<LibraryCandidate> &candidates) {
+    AdapterCacheState &cacheState = GetAdapterCacheState();
+    std::lock_guard<std::mutex> lock(cacheState.cacheLock);
+
+    if (!UpdateAdapterCacheState(cacheState))
+        return;
+
+    std::pair<mfxIMPL, mfxU32> key(implementation, version.Version);
+    if (candidates.empty())
+        cacheState.libraryCandidates.erase(key);
+    else
+        cacheState.libraryCandidates[key] = candidates;
+}
+
+} // namespace MFX
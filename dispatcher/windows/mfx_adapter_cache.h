@@ -0,0 +1,68 @@
+/*############################################################################
+  # Copyright (C) Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef DISPATCHER_WINDOWS_MFX_ADAPTER_CACHE_H_
+#define DISPATCHER_WINDOWS_MFX_ADAPTER_CACHE_H_
+
+#include <windows.h>
+
+#include <string>
+#include <vector>
+
+#include "vpl/mfx_dispatcher_vpl.h"
+#include "windows/mfx_dispatcher.h"
+
+namespace MFX {
+
+// library which was loaded by the legacy MFXInitEx search, with the
+//   parameters it was loaded with
+struct LibraryCandidate {
+    std::wstring dllPath;
+    eMfxImplType implType;
+    mfxIMPL impl;
+    mfxIMPL implInterface;
+    mfxStatus loadStatus;
+    wchar_t subkeyName[MFX_MAX_REGISTRY_KEY_NAME];
+    int storageID;
+    mfxU16 mediaAdapterType;
+};
+
+// Process-wide cache of the DXGI adapter list, of the DriverStore
+//   paths looked up for each adapter and of the libraries found by the
+//   legacy MFXInitEx search. DXGI enumeration, the cfgmgr32 registry walk
+//   and the library search are only repeated after a display adapter
+//   interface arrives or is removed (driver install/update/disable).
+// If the change notification cannot be registered (pre-Win8 OS, older
+//   SDK headers) nothing is cached and every call goes to the system.
+class AdapterCache {
+public:
+    static bool GetAdapterList(std::vector<DXGI1DeviceInfo> &adapterInfo);
+
+    static mfxStatus GetDriverStoreDir(std::wstring &driverStoreDir,
+                                       size_t length,
+                                       mfxU32 deviceID,
+                                       int storageID);
+
+    // candidates of the last successful search for the requested implementation
+    //   and API version, in the order of preference, the known-good library first
+    static bool GetLibraryCandidates(mfxIMPL implementation,
+                                     mfxVersion version,
+                                     std::vector<LibraryCandidate> &candidates);
+
+    static void SetLibraryCandidates(mfxIMPL implementation,
+                                     mfxVersion version,
+                                     const std::vector<LibraryCandidate> &candidates);
+
+private:
+    // unimplemented by intent to make this class non-instantiable
+    AdapterCache();
+    AdapterCache(const AdapterCache &);
+    void operator=(const AdapterCache &);
+};
+
+} // namespace MFX
+
+#endif // DISPATCHER_WINDOWS_MFX_ADAPTER_CACHE_H_
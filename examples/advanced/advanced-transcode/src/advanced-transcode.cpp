@@ -0,0 +1,467 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// A oneAPI Video Processing Library (oneVPL) transcode application keeping
+/// several frames in flight: decode, VPP and encode are all submitted
+/// asynchronously with internal memory, and only the encoded bitstreams are
+/// synchronized, when they are written. For more information see:
+/// https://software.intel.com/content/www/us/en/develop/articles/upgrading-from-msdk-to-onevpl.html
+/// https://oneapi-src.github.io/oneAPI-spec/elements/oneVPL/source/index.html
+///
+/// @file
+
+#include <chrono>
+
+#include "util.h"
+
+#define TARGETKBPS                 4000
+#define FRAMERATE                  30
+#define OUTPUT_FILE                "out.h265"
+#define BITSTREAM_BUFFER_SIZE      2000000
+#define MAJOR_API_VERSION_REQUIRED 2
+#define MINOR_API_VERSION_REQUIRED 5
+#define MAX_TIMEOUT_COUNT          10
+#define SYNC_TIMEOUT               60000
+#define DEFAULT_ASYNC_DEPTH        4
+
+// Output bitstream of an encode call, syncp is set from the call until the bitstream is written
+typedef struct _EncodeTask {
+    mfxBitstream bs;
+    mfxSyncPoint syncp;
+} EncodeTask;
+
+// Ring of the encode tasks, the busy ones are written in the order they were submitted
+typedef struct _TaskQueue {
+    EncodeTask tasks[MAX_ASYNC_DEPTH];
+    mfxU16 depth;
+    mfxU16 head; // oldest busy task
+    mfxU16 busy;
+} TaskQueue;
+
+// Waits for the oldest busy task and writes its bitstream. This is the only place the pipeline
+// synchronizes, decode and VPP of the next frames go on meanwhile.
+mfxStatus WriteOldestTask(mfxSession session, TaskQueue *queue, FILE *sink, mfxU32 *framenum) {
+    EncodeTask *task = &queue->tasks[queue->head];
+
+    mfxStatus sts = MFXVideoCORE_SyncOperation(session, task->syncp, SYNC_TIMEOUT);
+    if (MFX_ERR_NONE != sts)
+        return sts;
+
+    WriteEncodedStream(task->bs, sink);
+    task->syncp = NULL;
+    queue->head = (queue->head + 1) % queue->depth;
+    queue->busy--;
+    (*framenum)++;
+    return MFX_ERR_NONE;
+}
+
+// Free task for the next encode call, the oldest one is written first when all are busy
+mfxStatus GetFreeTask(mfxSession session,
+                      TaskQueue *queue,
+                      FILE *sink,
+                      mfxU32 *framenum,
+                      EncodeTask **task) {
+    if (queue->busy == queue->depth) {
+        mfxStatus sts = WriteOldestTask(session, queue, sink, framenum);
+        if (MFX_ERR_NONE != sts)
+            return sts;
+    }
+
+    *task = &queue->tasks[(queue->head + queue->busy) % queue->depth];
+    return MFX_ERR_NONE;
+}
+
+void Usage(void) {
+    printf("\n");
+    printf("   Usage  :  advanced-transcode \n\n");
+    printf("     -sw/-hw        use software or hardware implementation\n");
+    printf("     -i             input file name (MJPEG elementary stream)\n");
+    printf("     -w             output width (default: input width)\n");
+    printf("     -h             output height (default: input height)\n");
+    printf("     -async         frames in flight in each stage, 1 to %d (default: %d)\n\n",
+           MAX_ASYNC_DEPTH,
+           DEFAULT_ASYNC_DEPTH);
+    printf("   Example:  advanced-transcode -sw -i in.mjpeg -async 4\n");
+    printf("   To view:  ffplay %s\n\n", OUTPUT_FILE);
+    printf(" * Transcode MJPEG to HEVC/H265 elementary stream in %s\n\n", OUTPUT_FILE);
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    bool isDrainingDec                = false;
+    bool isDrainingVPP                = false;
+    bool isDrainingEnc                = false;
+    bool isStillgoing                 = true;
+    FILE *sink                        = NULL;
+    FILE *source                      = NULL;
+    int accel_fd                      = 0;
+    mfxBitstream bs_dec_in            = {};
+    mfxFrameSurface1 *dec_surface_out = NULL;
+    mfxFrameSurface1 *vpp_surface_out = NULL;
+    mfxSession session                = NULL;
+    mfxStatus sts                     = MFX_ERR_NONE;
+    mfxSyncPoint syncp                = {};
+    mfxU32 framenum                   = 0;
+    mfxU32 bufferSize                 = 0;
+    mfxU16 outWidth                   = 0;
+    mfxU16 outHeight                  = 0;
+    mfxU16 memIn                      = 0;
+    mfxU16 memOut                     = 0;
+    mfxVideoParam decodeParams        = {};
+    mfxVideoParam vppParams           = {};
+    mfxVideoParam encodeParams        = {};
+    Params cliParams                  = {};
+    TaskQueue queue                   = {};
+    EncodeTask *task                  = NULL;
+    void *accelHandle                 = NULL;
+    double seconds                    = 0;
+    std::chrono::steady_clock::time_point start;
+
+    // variables used only in 2.x version
+    mfxConfig cfg[4];
+    mfxVariant cfgVal[4];
+    mfxLoader loader = NULL;
+    mfxU8 timeout_count;
+
+    //Parse command line args to cliParams
+    if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_TRANSCODE) == false) {
+        Usage();
+        return 1; // return 1 as error code
+    }
+
+    queue.depth = cliParams.asyncDepth ? cliParams.asyncDepth : DEFAULT_ASYNC_DEPTH;
+
+    source = fopen(cliParams.infileName, "rb");
+    VERIFY(source, "Could not open input file");
+
+    sink = fopen(OUTPUT_FILE, "wb");
+    VERIFY(sink, "Could not create output file");
+
+    // Initialize VPL session
+    loader = MFXLoad();
+    VERIFY(NULL != loader, "MFXLoad failed -- is implementation in path?");
+
+    // Implementation used must be the type requested from command line
+    cfg[0] = MFXCreateConfig(loader);
+    VERIFY(NULL != cfg[0], "MFXCreateConfig failed")
+
+    sts =
+        MFXSetConfigFilterProperty(cfg[0], (mfxU8 *)"mfxImplDescription.Impl", cliParams.implValue);
+    VERIFY(MFX_ERR_NONE == sts, "MFXSetConfigFilterProperty failed for Impl");
+
+    // Implementation must provide a JPEG decoder
+    cfg[1] = MFXCreateConfig(loader);
+    VERIFY(NULL != cfg[1], "MFXCreateConfig failed")
+    cfgVal[1].Type     = MFX_VARIANT_TYPE_U32;
+    cfgVal[1].Data.U32 = MFX_CODEC_JPEG;
+    sts                = MFXSetConfigFilterProperty(
+        cfg[1],
+        (mfxU8 *)"mfxImplDescription.mfxDecoderDescription.decoder.CodecID",
+        cfgVal[1]);
+    VERIFY(MFX_ERR_NONE == sts, "MFXSetConfigFilterProperty failed for decoder CodecID");
+
+    // Implementation must provide an HEVC encoder
+    cfg[2] = MFXCreateConfig(loader);
+    VERIFY(NULL != cfg[2], "MFXCreateConfig failed")
+    cfgVal[2].Type     = MFX_VARIANT_TYPE_U32;
+    cfgVal[2].Data.U32 = MFX_CODEC_HEVC;
+    sts                = MFXSetConfigFilterProperty(
+        cfg[2],
+        (mfxU8 *)"mfxImplDescription.mfxEncoderDescription.encoder.CodecID",
+        cfgVal[2]);
+    VERIFY(MFX_ERR_NONE == sts, "MFXSetConfigFilterProperty failed for encoder CodecID");
+
+    // Implementation must provide equal to or higher API version than MAJOR_API_VERSION_REQUIRED.MINOR_API_VERSION_REQUIRED
+    cfg[3] = MFXCreateConfig(loader);
+    VERIFY(NULL != cfg[3], "MFXCreateConfig failed")
+    cfgVal[3].Type     = MFX_VARIANT_TYPE_U32;
+    cfgVal[3].Data.U32 = VPLVERSION(MAJOR_API_VERSION_REQUIRED, MINOR_API_VERSION_REQUIRED);
+    sts                = MFXSetConfigFilterProperty(cfg[3],
+                                     (mfxU8 *)"mfxImplDescription.ApiVersion.Version",
+                                     cfgVal[3]);
+    VERIFY(MFX_ERR_NONE == sts, "MFXSetConfigFilterProperty failed for API version");
+
+    sts = MFXCreateSession(loader, 0, &session);
+    VERIFY(MFX_ERR_NONE == sts,
+           "Cannot create session -- no implementations meet selection criteria");
+
+    // Print info about implementation loaded
+    ShowImplementationInfo(loader, 0);
+
+    // Convenience function to initialize available accelerator(s)
+    accelHandle = InitAcceleratorHandle(session, &accel_fd);
+
+    // Frames stay in video memory from decode to encode on the GPU
+    if (MFX_IMPL_TYPE_HARDWARE == cliParams.implValue.Data.U32) {
+        memIn  = MFX_IOPATTERN_IN_VIDEO_MEMORY;
+        memOut = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+    }
+    else {
+        memIn  = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+        memOut = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    }
+
+    // Prepare input bitstream and start decoding
+    bs_dec_in.MaxLength = BITSTREAM_BUFFER_SIZE;
+    bs_dec_in.Data      = (mfxU8 *)calloc(bs_dec_in.MaxLength, sizeof(mfxU8));
+    VERIFY(bs_dec_in.Data, "Not able to allocate input buffer");
+    bs_dec_in.CodecId = MFX_CODEC_JPEG;
+
+    //Pre-parse input stream
+    sts = ReadEncodedStream(bs_dec_in, source);
+    VERIFY(MFX_ERR_NONE == sts, "Error reading bitstream\n");
+
+    // AsyncDepth tells each component how many frames may be in flight, so it sizes its internal
+    // surface pool and task queue for them
+    decodeParams.mfx.CodecId = MFX_CODEC_JPEG;
+    decodeParams.IOPattern   = memOut;
+    decodeParams.AsyncDepth  = queue.depth;
+    sts                      = MFXVideoDECODE_DecodeHeader(session, &bs_dec_in, &decodeParams);
+    VERIFY(MFX_ERR_NONE == sts, "Error decoding header\n");
+
+    sts = MFXVideoDECODE_Init(session, &decodeParams);
+    VERIFY(MFX_ERR_NONE == sts, "Could not initialize Decode");
+
+    // VPP scales the decoded frames to the output size
+    outWidth  = cliParams.srcWidth ? cliParams.srcWidth : decodeParams.mfx.FrameInfo.CropW;
+    outHeight = cliParams.srcHeight ? cliParams.srcHeight : decodeParams.mfx.FrameInfo.CropH;
+
+    vppParams.vpp.In = decodeParams.mfx.FrameInfo;
+    if (0 == vppParams.vpp.In.FrameRateExtN || 0 == vppParams.vpp.In.FrameRateExtD) {
+        vppParams.vpp.In.FrameRateExtN = FRAMERATE;
+        vppParams.vpp.In.FrameRateExtD = 1;
+    }
+    vppParams.vpp.Out        = vppParams.vpp.In;
+    vppParams.vpp.Out.CropX  = 0;
+    vppParams.vpp.Out.CropY  = 0;
+    vppParams.vpp.Out.CropW  = outWidth;
+    vppParams.vpp.Out.CropH  = outHeight;
+    vppParams.vpp.Out.Width  = ALIGN16(outWidth);
+    vppParams.vpp.Out.Height = ALIGN16(outHeight);
+    vppParams.IOPattern      = memIn | memOut;
+    vppParams.AsyncDepth     = queue.depth;
+
+    sts = MFXVideoVPP_Init(session, &vppParams);
+    VERIFY(MFX_ERR_NONE == sts, "Could not initialize VPP");
+
+    encodeParams.mfx.CodecId           = MFX_CODEC_HEVC;
+    encodeParams.mfx.TargetUsage       = MFX_TARGETUSAGE_BALANCED;
+    encodeParams.mfx.TargetKbps        = TARGETKBPS;
+    encodeParams.mfx.RateControlMethod = MFX_RATECONTROL_VBR;
+    encodeParams.mfx.FrameInfo         = vppParams.vpp.Out;
+    encodeParams.IOPattern             = memIn;
+    encodeParams.AsyncDepth            = queue.depth;
+
+    // Initialize the encoder
+    sts = MFXVideoENCODE_Init(session, &encodeParams);
+    VERIFY(MFX_ERR_NONE == sts, "Could not initialize Encode");
+
+    // One output bitstream per frame in flight, sized as the encoder requires
+    sts = MFXVideoENCODE_GetVideoParam(session, &encodeParams);
+    VERIFY(MFX_ERR_NONE == sts, "Could not get Encode parameters");
+    bufferSize = encodeParams.mfx.BufferSizeInKB * 1000 *
+                 (encodeParams.mfx.BRCParamMultiplier ? encodeParams.mfx.BRCParamMultiplier : 1);
+    if (!bufferSize)
+        bufferSize = BITSTREAM_BUFFER_SIZE;
+
+    for (mfxU16 i = 0; i < queue.depth; i++) {
+        queue.tasks[i].bs.MaxLength = bufferSize;
+        queue.tasks[i].bs.Data      = (mfxU8 *)calloc(bufferSize, sizeof(mfxU8));
+        VERIFY(queue.tasks[i].bs.Data, "Not able to allocate output buffer");
+    }
+
+    printf("Transcoding %s -> %s with %d frames in flight\n",
+           cliParams.infileName,
+           OUTPUT_FILE,
+           queue.depth);
+    start = std::chrono::steady_clock::now();
+
+    while (isStillgoing == true) {
+        // Decode MJPEG stream, the decoded surface isn't synchronized, VPP waits for it on the
+        // device
+        if (isDrainingVPP == false) {
+            if (isDrainingDec == false && bs_dec_in.DataLength < bs_dec_in.MaxLength / 2) {
+                sts = ReadEncodedStream(bs_dec_in, source);
+                if (sts != MFX_ERR_NONE) // No more data to read, start decode draining mode
+                    isDrainingDec = true;
+            }
+
+            timeout_count = 0;
+            do {
+                sts = MFXVideoDECODE_DecodeFrameAsync(session,
+                                                      (isDrainingDec == true) ? NULL : &bs_dec_in,
+                                                      NULL,
+                                                      &dec_surface_out,
+                                                      &syncp);
+                // All the surfaces of the pool are in flight, the bitstream of the oldest frame is
+                // written to let the pipeline move. Otherwise wait for the surfaces to be freed.
+                if (sts == MFX_WRN_ALLOC_TIMEOUT_EXPIRED || sts == MFX_WRN_DEVICE_BUSY) {
+                    if (queue.busy) {
+                        sts = WriteOldestTask(session, &queue, sink, &framenum);
+                        VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
+                    }
+                    else if (timeout_count > MAX_TIMEOUT_COUNT) {
+                        sts = MFX_ERR_DEVICE_FAILED;
+                        break;
+                    }
+                    else {
+                        timeout_count++;
+                        sleep(WAIT_5_MILLISECONDS);
+                    }
+                    continue;
+                }
+                break;
+            } while (1);
+
+            switch (sts) {
+                case MFX_ERR_NONE: // Got 1 decoded frame
+                    break;
+                case MFX_ERR_MORE_DATA: // The function requires more bitstream at input before decoding can proceed
+                    if (isDrainingDec == true)
+                        isDrainingVPP = true; // No more data to drain from decoder, drain VPP
+                    else
+                        continue; // read more data
+                    break;
+                case MFX_ERR_MORE_SURFACE:
+                    continue;
+                default:
+                    printf("unknown status %d\n", sts);
+                    isStillgoing = false;
+                    continue;
+            }
+        }
+
+        // Scale the frame into a surface of the VPP output pool
+        if (isDrainingEnc == false) {
+            sts = MFXMemory_GetSurfaceForVPPOut(session, &vpp_surface_out);
+            VERIFY(MFX_ERR_NONE == sts, "Unknown error in MFXMemory_GetSurfaceForVPPOut");
+
+            do {
+                sts = MFXVideoVPP_RunFrameVPPAsync(session,
+                                                   (isDrainingVPP == true) ? NULL : dec_surface_out,
+                                                   vpp_surface_out,
+                                                   NULL,
+                                                   &syncp);
+                if (sts == MFX_WRN_DEVICE_BUSY && queue.busy) {
+                    sts = WriteOldestTask(session, &queue, sink, &framenum);
+                    VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
+                    continue;
+                }
+                break;
+            } while (1);
+
+            // VPP keeps its own reference to the input until it's processed
+            if (dec_surface_out) {
+                dec_surface_out->FrameInterface->Release(dec_surface_out);
+                dec_surface_out = NULL;
+            }
+
+            switch (sts) {
+                case MFX_ERR_NONE: // Got 1 scaled frame
+                    break;
+                case MFX_ERR_MORE_DATA: // VPP needs more input frames before it can output one
+                    vpp_surface_out->FrameInterface->Release(vpp_surface_out);
+                    vpp_surface_out = NULL;
+                    if (isDrainingVPP == true)
+                        isDrainingEnc = true; // No more frames in VPP, drain the encoder
+                    else
+                        continue; // decode the next frame
+                    break;
+                default:
+                    printf("unknown status %d\n", sts);
+                    isStillgoing = false;
+                    continue;
+            }
+        }
+
+        // Encode to H265 stream into the next free bitstream
+        do {
+            sts = GetFreeTask(session, &queue, sink, &framenum, &task);
+            VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
+
+            sts = MFXVideoENCODE_EncodeFrameAsync(session,
+                                                  NULL,
+                                                  (isDrainingEnc == true) ? NULL : vpp_surface_out,
+                                                  &task->bs,
+                                                  &task->syncp);
+            if (sts == MFX_WRN_DEVICE_BUSY && queue.busy) {
+                sts = WriteOldestTask(session, &queue, sink, &framenum);
+                VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
+                continue;
+            }
+            break;
+        } while (1);
+
+        if (vpp_surface_out) {
+            vpp_surface_out->FrameInterface->Release(vpp_surface_out);
+            vpp_surface_out = NULL;
+        }
+
+        switch (sts) {
+            case MFX_ERR_NONE:
+                // MFX_ERR_NONE and syncp indicate output is available, it's synchronized only
+                // once all the tasks are busy
+                if (task->syncp)
+                    queue.busy++;
+                break;
+            case MFX_ERR_MORE_DATA: // The function requires more data to generate any output
+                if (isDrainingEnc == true)
+                    isStillgoing = false; // No more data to drain from encoder, exit loop
+                break;
+            default:
+                printf("unknown status %d\n", sts);
+                isStillgoing = false;
+                break;
+        }
+    }
+
+    // Write the bitstreams still in flight
+    while (queue.busy) {
+        sts = WriteOldestTask(session, &queue, sink, &framenum);
+        VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
+    }
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Transcoded %d frames in %.2f seconds, %.2f fps\n",
+           framenum,
+           seconds,
+           (seconds > 0) ? framenum / seconds : 0);
+
+end:
+    // Clean up resources - It is recommended to close components first, before
+    // releasing allocated surfaces, since some surfaces may still be locked by
+    // internal resources.
+    if (session) {
+        MFXVideoENCODE_Close(session);
+        MFXVideoVPP_Close(session);
+        MFXVideoDECODE_Close(session);
+        MFXClose(session);
+    }
+
+    for (mfxU16 i = 0; i < queue.depth; i++) {
+        if (queue.tasks[i].bs.Data)
+            free(queue.tasks[i].bs.Data);
+    }
+
+    if (bs_dec_in.Data)
+        free(bs_dec_in.Data);
+
+    if (source)
+        fclose(source);
+
+    if (sink)
+        fclose(sink);
+
+    FreeAcceleratorHandle(accelHandle, accel_fd);
+    accelHandle = NULL;
+    accel_fd    = 0;
+
+    if (loader)
+        MFXUnload(loader);
+
+    return 0;
+}
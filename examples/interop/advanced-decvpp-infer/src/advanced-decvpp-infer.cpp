@@ -12,8 +12,10 @@
 /// @file
 
 #include <cldnn/cldnn_config.hpp>
-#include <gpu/gpu_context_api_va.hpp>
 #include <inference_engine.hpp>
+#include <mutex>
+#include "infer_pipeline.h"
+#include "remote_blob.h"
 #include "util.h"
 
 #define VERIFY(x, y)       \
@@ -32,72 +34,80 @@ using namespace InferenceEngine;
 
 #define BITSTREAM_BUFFER_SIZE      2000000
 #define MAX_RESULTS                5
-#define SYNC_TIMEOUT               60000
 #define MAJOR_API_VERSION_REQUIRED 2
 #define MINOR_API_VERSION_REQUIRED 2
+#define DEFAULT_INFER_REQUESTS     4
 
 void Usage(void) {
     printf("\n");
     printf("   Usage  :  advanced-decvpp-infer \n\n");
-    printf("     -i      input file name (HEVC elementary stream)\n\n");
+    printf("     -i      input file name (HEVC elementary stream), repeat for several streams\n\n");
     printf("     -m      input model name (object detection)\n\n");
+    printf("     -b      frames inferred at once, from any of the streams (default 1)\n\n");
+    printf("     -nireq  number of infer requests running at once (default %d)\n\n",
+           DEFAULT_INFER_REQUESTS);
     printf("   Example:  advanced-decvpp-infer -i in.h265 -m mobilenet-ssd.xml\n");
+    printf("             advanced-decvpp-infer -i a.h265 -i b.h265 -b 4 -m mobilenet-ssd.xml\n");
     return;
 }
 
+// Decode and VPP of one input stream
+struct DecVPPStream {
+    FILE *source;
+    mfxSession session;
+    mfxBitstream bitstream;
+    mfxU16 oriImgWidth;
+    mfxU16 oriImgHeight;
+    mfxU32 frameNum;
+    bool isDrainingDec;
+    bool isDrainingVPP;
+    bool isStillGoing;
+};
+
 mfxSession CreateVPLSession(mfxLoader *loader);
-void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height);
+mfxStatus InitStream(DecVPPStream *stream, const char *fileName, mfxU16 outWidth, mfxU16 outHeight);
+bool RunStream(DecVPPStream *stream,
+               mfxU32 streamId,
+               AsyncInferPipeline *pipeline,
+               mfxU16 outWidth,
+               mfxU16 outHeight);
+void CloseStream(DecVPPStream *stream);
+void PrintTopResults(const Blob::Ptr &output, size_t batchIndex, mfxU16 width, mfxU16 height);
 
 int main(int argc, char **argv) {
-    FILE *source = NULL;
-
-    mfxLoader loader                     = NULL;
-    mfxSession session                   = NULL;
-    mfxFrameSurface1 *decSurfaceOut      = NULL;
-    mfxBitstream bitstream               = {};
-    mfxSyncPoint syncp                   = {};
-    mfxVideoParam mfxDecParams           = {};
-    mfxVideoParam mfxVPPParams           = {};
-    mfxFrameSurface1 *pmfxDecOutSurface  = NULL;
-    mfxFrameSurface1 *pmfxVPPSurfacesOut = NULL;
-    mfxU32 frameNum                      = 0;
-    bool isStillGoing                    = true;
-    bool isDrainingDec                   = false;
-    bool isDrainingVPP                   = false;
-    mfxStatus sts                        = MFX_ERR_NONE;
-    Params cliParams                     = {};
+    mfxLoader loader             = NULL;
+    mfxSession session           = NULL;
+    mfxU32 frameNum              = 0;
+    mfxU32 numRunning            = 0;
+    mfxStatus sts                = MFX_ERR_NONE;
+    Params cliParams             = {};
+    DecVPPStream *streams        = NULL;
+    AsyncInferPipeline *pipeline = NULL;
+    size_t batchSize             = 1;
+    size_t numInferRequests      = DEFAULT_INFER_REQUESTS;
+    std::mutex printMutex;
+    AsyncInferPipeline::ResultCallback onResult;
 
     Core ie;
     CNNNetwork network;
     std::string inputName, outputName;
     InputInfo::Ptr inputInfo;
-    gpu::VAContext::Ptr sharedVAContext;
+    RemoteBlobCache remoteBlobs;
     DataPtr outputInfo;
     ExecutableNetwork executableNetwork;
-    InferRequest inferRequest;
     SizeVector inDims;
 
-    VADisplay lvaDisplay;
-    VASurfaceID lvaSurfaceID;
-    mfxHandleType ldeviceType;
-    mfxHDL lresource;
-    mfxResourceType lresourceType;
-    mfxStatus lsts;
-    bool isNetworkLoaded = false;
-
-    mfxU16 oriImgWidth, oriImgHeight;
     mfxU16 inputDimWidth, inputDimHeight;
-    mfxU16 vppInImgWidth, vppInImgHeight;
-    mfxU16 vppOutImgWidth, vppOutImgHeight;
 
     //-- Parse command line args to cliParams
     if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_DECVPP) == false) {
         Usage();
         return 1; // return 1 as error code
     }
-
-    source = fopen(cliParams.infileName, "rb");
-    VERIFY(source, "Could not open input file");
+    if (cliParams.batchSize)
+        batchSize = cliParams.batchSize;
+    if (cliParams.numInferRequests)
+        numInferRequests = cliParams.numInferRequests;
 
     //--- Setup OpenVINO Inference Engine
     // Read network model
@@ -120,180 +130,262 @@ int main(int argc, char **argv) {
     outputInfo->setPrecision(Precision::FP32);
     outputName = network.getOutputsInfo().begin()->first;
 
+    // Frames of all the streams are inferred in batches
+    network.setBatchSize(batchSize);
+
     //---- Setup VPL
-    // Create VPL session
+    // Create VPL session, the sessions of the other streams are its clones, so all the surfaces
+    // belong to one VA display
     session = CreateVPLSession(&loader);
     VERIFY(session != NULL, "Not able to create VPL session");
 
-    //-- Initialize Decode
+    streams = (DecVPPStream *)calloc(cliParams.numInfiles, sizeof(DecVPPStream));
+    VERIFY(streams, "Not able to allocate streams");
+
+    for (mfxU32 i = 0; i < cliParams.numInfiles; i++) {
+        if (0 == i) {
+            streams[i].session = session;
+        }
+        else {
+            sts = MFXCloneSession(session, &streams[i].session);
+            VERIFY(MFX_ERR_NONE == sts, "Not able to clone VPL session");
+        }
+
+        //-- Initialize Decode and VPP
+        // vpp in:  decode output image size
+        // vpp out: network model input size
+        sts = InitStream(&streams[i], cliParams.infileNames[i], inputDimWidth, inputDimHeight);
+        VERIFY(MFX_ERR_NONE == sts, "Not able to initialize stream");
+        numRunning++;
+    }
+
+    //-- Load network model in the shared context
+    // Create the shared context object on the vaapi device of the session
+    VERIFY(remoteBlobs.Init(ie, session), "Not able to create the shared context");
+
+    // Compile network within a shared context
+    executableNetwork = ie.LoadNetwork(
+        network,
+        remoteBlobs.GetContext(),
+        { { InferenceEngine::GPUConfigParams::KEY_GPU_NV12_TWO_INPUTS, PluginConfigParams::YES } });
+
+    // Results come from the inference threads, in the order the requests complete
+    onResult = [&](const InferFrameTag &tag, const Blob::Ptr &output, size_t batchIndex) {
+        std::lock_guard<std::mutex> lock(printMutex);
+        printf("Stream %u, frame %u:\n", tag.stream, tag.frame);
+        PrintTopResults(output,
+                        batchIndex,
+                        streams[tag.stream].oriImgWidth,
+                        streams[tag.stream].oriImgHeight);
+    };
+    pipeline = new AsyncInferPipeline(executableNetwork,
+                                      remoteBlobs,
+                                      inputName,
+                                      outputName,
+                                      batchSize,
+                                      numInferRequests,
+                                      onResult);
+
+    //-- Start processing
+    printf("Decoding VPP, and infering %d stream(s) with %s\n",
+           cliParams.numInfiles,
+           cliParams.inmodelName);
+
+    // Decode runs ahead of inference, it only waits when all the infer requests are busy
+    while (numRunning) {
+        for (mfxU32 i = 0; i < cliParams.numInfiles; i++) {
+            if (!streams[i].isStillGoing)
+                continue;
+            streams[i].isStillGoing =
+                RunStream(&streams[i], i, pipeline, inputDimWidth, inputDimHeight);
+            if (!streams[i].isStillGoing)
+                numRunning--;
+        }
+    }
+    pipeline->Flush();
+
+end:
+    // Surfaces held by the infer requests are released before the sessions are closed
+    delete pipeline;
+    remoteBlobs.Clear();
+
+    if (streams) {
+        // clones first
+        for (mfxU32 i = cliParams.numInfiles; i > 0; i--) {
+            frameNum += streams[i - 1].frameNum;
+            CloseStream(&streams[i - 1]);
+        }
+        free(streams);
+    }
+    printf("Decoded %d frames\n", frameNum);
+
+    if (loader)
+        MFXUnload(loader);
+
+    return 0;
+}
+
+mfxStatus InitStream(DecVPPStream *stream,
+                     const char *fileName,
+                     mfxU16 outWidth,
+                     mfxU16 outHeight) {
+    mfxVideoParam mfxDecParams = {};
+    mfxVideoParam mfxVPPParams = {};
+    mfxStatus sts              = MFX_ERR_NONE;
+
+    stream->source = fopen(fileName, "rb");
+    if (!stream->source) {
+        printf("Could not open input file %s\n", fileName);
+        return MFX_ERR_NOT_FOUND;
+    }
+
     // Prepare input bitstream
-    bitstream.MaxLength = BITSTREAM_BUFFER_SIZE;
-    bitstream.Data      = (mfxU8 *)calloc(bitstream.MaxLength, sizeof(mfxU8));
-    VERIFY(bitstream.Data, "Not able to allocate input buffer");
-    bitstream.CodecId = MFX_CODEC_HEVC;
+    stream->bitstream.MaxLength = BITSTREAM_BUFFER_SIZE;
+    stream->bitstream.Data      = (mfxU8 *)calloc(stream->bitstream.MaxLength, sizeof(mfxU8));
+    if (!stream->bitstream.Data) {
+        printf("Not able to allocate input buffer\n");
+        return MFX_ERR_MEMORY_ALLOC;
+    }
+    stream->bitstream.CodecId = MFX_CODEC_HEVC;
 
-    sts = ReadEncodedStream(bitstream, source);
-    VERIFY(MFX_ERR_NONE == sts, "Error reading bitstream");
+    sts = ReadEncodedStream(stream->bitstream, stream->source);
+    if (MFX_ERR_NONE != sts) {
+        printf("Error reading bitstream\n");
+        return sts;
+    }
 
     // Retrieve the frame information from input stream
     mfxDecParams.mfx.CodecId = MFX_CODEC_HEVC;
     mfxDecParams.IOPattern   = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
-    sts                      = MFXVideoDECODE_DecodeHeader(session, &bitstream, &mfxDecParams);
-    VERIFY(MFX_ERR_NONE == sts, "Error decoding header");
+    sts = MFXVideoDECODE_DecodeHeader(stream->session, &stream->bitstream, &mfxDecParams);
+    if (MFX_ERR_NONE != sts) {
+        printf("Error decoding header\n");
+        return sts;
+    }
 
     // Original image size
-    oriImgWidth  = mfxDecParams.mfx.FrameInfo.Width;
-    oriImgHeight = mfxDecParams.mfx.FrameInfo.Height;
+    stream->oriImgWidth  = mfxDecParams.mfx.FrameInfo.Width;
+    stream->oriImgHeight = mfxDecParams.mfx.FrameInfo.Height;
 
     // Input parameters finished, now initialize decode
-    sts = MFXVideoDECODE_Init(session, &mfxDecParams);
-    VERIFY(MFX_ERR_NONE == sts, "Error initializing Decode");
+    sts = MFXVideoDECODE_Init(stream->session, &mfxDecParams);
+    if (MFX_ERR_NONE != sts) {
+        printf("Error initializing Decode\n");
+        return sts;
+    }
 
-    //-- Initialize VPP
     // Prepare vpp in/out params
-    // vpp in:  decode output image size
-    // vpp out: network model input size
-    vppInImgWidth   = mfxDecParams.mfx.FrameInfo.Width;
-    vppInImgHeight  = mfxDecParams.mfx.FrameInfo.Height;
-    vppOutImgWidth  = inputDimWidth;
-    vppOutImgHeight = inputDimHeight;
-
     mfxVPPParams.vpp.In.FourCC        = mfxDecParams.mfx.FrameInfo.FourCC;
     mfxVPPParams.vpp.In.ChromaFormat  = mfxDecParams.mfx.FrameInfo.ChromaFormat;
-    mfxVPPParams.vpp.In.Width         = vppInImgWidth;
-    mfxVPPParams.vpp.In.Height        = vppInImgHeight;
-    mfxVPPParams.vpp.In.CropW         = vppInImgWidth;
-    mfxVPPParams.vpp.In.CropH         = vppInImgHeight;
+    mfxVPPParams.vpp.In.Width         = mfxDecParams.mfx.FrameInfo.Width;
+    mfxVPPParams.vpp.In.Height        = mfxDecParams.mfx.FrameInfo.Height;
+    mfxVPPParams.vpp.In.CropW         = mfxDecParams.mfx.FrameInfo.Width;
+    mfxVPPParams.vpp.In.CropH         = mfxDecParams.mfx.FrameInfo.Height;
     mfxVPPParams.vpp.In.PicStruct     = MFX_PICSTRUCT_PROGRESSIVE;
     mfxVPPParams.vpp.In.FrameRateExtN = 30;
     mfxVPPParams.vpp.In.FrameRateExtD = 1;
 
     mfxVPPParams.vpp.Out.FourCC        = MFX_FOURCC_NV12;
     mfxVPPParams.vpp.Out.ChromaFormat  = MFX_CHROMAFORMAT_YUV420;
-    mfxVPPParams.vpp.Out.Width         = ALIGN16(vppOutImgWidth);
-    mfxVPPParams.vpp.Out.Height        = ALIGN16(vppOutImgHeight);
-    mfxVPPParams.vpp.Out.CropW         = vppOutImgWidth;
-    mfxVPPParams.vpp.Out.CropH         = vppOutImgHeight;
+    mfxVPPParams.vpp.Out.Width         = ALIGN16(outWidth);
+    mfxVPPParams.vpp.Out.Height        = ALIGN16(outHeight);
+    mfxVPPParams.vpp.Out.CropW         = outWidth;
+    mfxVPPParams.vpp.Out.CropH         = outHeight;
     mfxVPPParams.vpp.Out.PicStruct     = MFX_PICSTRUCT_PROGRESSIVE;
     mfxVPPParams.vpp.Out.FrameRateExtN = 30;
     mfxVPPParams.vpp.Out.FrameRateExtD = 1;
 
     mfxVPPParams.IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
 
-    sts = MFXVideoVPP_Init(session, &mfxVPPParams);
-    VERIFY(MFX_ERR_NONE == sts, "Error initializing VPP");
-
-    //-- Load network model in the shared context
-    // Get the vaapi device handle
-    sts = MFXVideoCORE_GetHandle(session, MFX_HANDLE_VA_DISPLAY, &lvaDisplay);
-    VERIFY(MFX_ERR_NONE == sts, "MFXVideoCore_GetHandle error");
-
-    // Create the shared context object
-    sharedVAContext = gpu::make_shared_context(ie, "GPU", lvaDisplay);
-
-    // Compile network within a shared context
-    executableNetwork = ie.LoadNetwork(
-        network,
-        sharedVAContext,
-        { { InferenceEngine::GPUConfigParams::KEY_GPU_NV12_TWO_INPUTS, PluginConfigParams::YES } });
-    // Create infer request
-    inferRequest = executableNetwork.CreateInferRequest();
-
-    //-- Start processing
-    printf("Decoding VPP, and infering %s with %s\n", cliParams.infileName, cliParams.inmodelName);
+    sts = MFXVideoVPP_Init(stream->session, &mfxVPPParams);
+    if (MFX_ERR_NONE != sts) {
+        printf("Error initializing VPP\n");
+        return sts;
+    }
 
-    while (isStillGoing == true) {
-        if (isDrainingDec == false) {
-            sts = ReadEncodedStream(bitstream, source);
-            if (sts != MFX_ERR_NONE)
-                isDrainingDec = true;
-        }
+    stream->isStillGoing = true;
+    return MFX_ERR_NONE;
+}
 
-        if (!isDrainingVPP) {
-            sts = MFXVideoDECODE_DecodeFrameAsync(session,
-                                                  (isDrainingDec) ? NULL : &bitstream,
-                                                  NULL,
-                                                  &pmfxDecOutSurface,
-                                                  &syncp);
-        }
-        else {
-            sts = MFX_ERR_NONE;
-        }
+// Decodes and resizes the next frame of the stream and passes it to the inference pipeline,
+// returns false when the stream is done
+bool RunStream(DecVPPStream *stream,
+               mfxU32 streamId,
+               AsyncInferPipeline *pipeline,
+               mfxU16 outWidth,
+               mfxU16 outHeight) {
+    mfxFrameSurface1 *pmfxDecOutSurface  = NULL;
+    mfxFrameSurface1 *pmfxVPPSurfacesOut = NULL;
+    mfxSyncPoint syncp                   = {};
+    mfxStatus sts                        = MFX_ERR_NONE;
 
-        switch (sts) {
-            case MFX_ERR_NONE:
-                sts =
-                    MFXVideoVPP_ProcessFrameAsync(session, pmfxDecOutSurface, &pmfxVPPSurfacesOut);
-                if (sts == MFX_ERR_NONE) {
-                    sts = pmfxVPPSurfacesOut->FrameInterface->Synchronize(pmfxVPPSurfacesOut,
-                                                                          SYNC_TIMEOUT);
-                    VERIFY(MFX_ERR_NONE == sts, "MFXVideoCORE_SyncOperation error");
-
-                    frameNum++;
-
-                    sts = pmfxVPPSurfacesOut->FrameInterface->GetNativeHandle(pmfxVPPSurfacesOut,
-                                                                              &lresource,
-                                                                              &lresourceType);
-                    VERIFY(MFX_ERR_NONE == sts, "FrameInterface->GetNativeHandle error");
-                    VERIFY(MFX_RESOURCE_VA_SURFACE == lresourceType,
-                           "Display device is not MFX_HANDLE_VA_DISPLAY");
-
-                    lvaSurfaceID = *(VASurfaceID *)lresource;
-
-                    // Wrap VPP output into remoteblobs and set it as inference input
-                    auto nv12_blob = gpu::make_shared_blob_nv12(vppOutImgHeight,
-                                                                vppOutImgWidth,
-                                                                sharedVAContext,
-                                                                lvaSurfaceID);
-                    inferRequest.SetBlob(inputName, nv12_blob);
-
-                    // Do inference
-                    inferRequest.Infer();
-
-                    // Release surface
-                    sts = pmfxVPPSurfacesOut->FrameInterface->Release(pmfxVPPSurfacesOut);
-                    VERIFY(MFX_ERR_NONE == sts, "ERROR - mfxFrameSurfaceInterface->Release failed");
-
-                    // Process output
-                    Blob::Ptr out_blob = inferRequest.GetBlob(outputName);
-                    PrintTopResults(out_blob, oriImgWidth, oriImgHeight);
-                }
-                else if (sts == MFX_ERR_MORE_DATA) {
-                    if (isDrainingVPP == true)
-                        isStillGoing = false;
-                }
-                else {
-                    if (sts < 0)
-                        isStillGoing = false;
-                }
-                break;
-            case MFX_ERR_MORE_DATA:
-                // The function requires more bitstream at input before decoding can proceed
-                if (isDrainingDec)
-                    isDrainingVPP = true;
-                break;
-            default:
-                isStillGoing = false;
-                break;
-        }
+    if (stream->isDrainingDec == false) {
+        sts = ReadEncodedStream(stream->bitstream, stream->source);
+        if (sts != MFX_ERR_NONE)
+            stream->isDrainingDec = true;
     }
 
-end:
-    printf("Decoded %d frames\n", frameNum);
+    if (!stream->isDrainingVPP) {
+        sts = MFXVideoDECODE_DecodeFrameAsync(stream->session,
+                                              (stream->isDrainingDec) ? NULL : &stream->bitstream,
+                                              NULL,
+                                              &pmfxDecOutSurface,
+                                              &syncp);
+    }
+    else {
+        sts = MFX_ERR_NONE;
+    }
 
-    if (bitstream.Data)
-        free(bitstream.Data);
+    switch (sts) {
+        case MFX_ERR_NONE:
+            sts = MFXVideoVPP_ProcessFrameAsync(stream->session,
+                                                pmfxDecOutSurface,
+                                                &pmfxVPPSurfacesOut);
+            // VPP holds its own reference of the input
+            if (pmfxDecOutSurface)
+                pmfxDecOutSurface->FrameInterface->Release(pmfxDecOutSurface);
+
+            if (sts == MFX_ERR_NONE) {
+                // The pipeline synchronizes and releases the surface
+                InferFrameTag tag = { streamId, stream->frameNum++ };
+                return pipeline->Submit(pmfxVPPSurfacesOut, outWidth, outHeight, tag);
+            }
+            else if (sts == MFX_ERR_MORE_DATA) {
+                if (stream->isDrainingVPP == true)
+                    return false;
+            }
+            else {
+                if (sts < 0)
+                    return false;
+            }
+            break;
+        case MFX_ERR_MORE_DATA:
+            // The function requires more bitstream at input before decoding can proceed
+            if (stream->isDrainingDec)
+                stream->isDrainingVPP = true;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
 
-    if (source)
-        fclose(source);
+void CloseStream(DecVPPStream *stream) {
+    if (stream->session) {
+        MFXVideoVPP_Close(stream->session);
+        MFXVideoDECODE_Close(stream->session);
+        MFXClose(stream->session);
+    }
 
-    if (loader)
-        MFXUnload(loader);
+    if (stream->bitstream.Data)
+        free(stream->bitstream.Data);
 
-    return 0;
+    if (stream->source)
+        fclose(stream->source);
 }
 
-void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height) {
+// Prints the detections of the frame batchIndex of the batch
+void PrintTopResults(const Blob::Ptr &output, size_t batchIndex, mfxU16 width, mfxU16 height) {
     SizeVector outputDims = output->getTensorDesc().getDims();
     if (0 == outputDims.size() || 1 != outputDims[0]) {
         printf("Output blob has incorrect dimensions, skipping\n");
@@ -302,7 +394,6 @@ void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height) {
 
     const int maxProposalCount = outputDims[2];
     const int objectSize       = outputDims[3];
-    size_t batchSize           = 1;
 
     MemoryBlob::CPtr moutput = as<MemoryBlob>(output);
     if (!moutput) {
@@ -315,8 +406,8 @@ void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height) {
     const float *detection =
         moutputHolder.as<const PrecisionTrait<Precision::FP32>::value_type *>();
 
-    std::vector<std::vector<int>> boxes(batchSize);
-    std::vector<std::vector<int>> classes(batchSize);
+    std::vector<int> boxes;
+    std::vector<int> classes;
 
     /* Each detection has image_id that denotes processed image */
     for (int curProposal = 0; curProposal < maxProposalCount; curProposal++) {
@@ -324,6 +415,9 @@ void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height) {
         if (image_id < 0) {
             break;
         }
+        if (static_cast<size_t>(image_id) != batchIndex) {
+            continue;
+        }
 
         float confidence = detection[curProposal * objectSize + 2];
         auto label       = static_cast<int>(detection[curProposal * objectSize + 1]);
@@ -338,11 +432,11 @@ void PrintTopResults(const Blob::Ptr &output, mfxU16 width, mfxU16 height) {
 
         if (confidence > 0.5) {
             /** Drawing only objects with >50% probability **/
-            classes[image_id].push_back(label);
-            boxes[image_id].push_back(xmin);
-            boxes[image_id].push_back(ymin);
-            boxes[image_id].push_back(xmax - xmin);
-            boxes[image_id].push_back(ymax - ymin);
+            classes.push_back(label);
+            boxes.push_back(xmin);
+            boxes.push_back(ymin);
+            boxes.push_back(xmax - xmin);
+            boxes.push_back(ymax - ymin);
             std::cout << " WILL BE PRINTED!";
         }
         std::cout << std::endl;
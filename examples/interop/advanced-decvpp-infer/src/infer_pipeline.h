@@ -0,0 +1,196 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Asynchronous inference stage for the VPP output surfaces of one or several
+/// decode streams. Surfaces are wrapped into remote blobs (zero copy), grouped
+/// into batches and inferred with a pool of infer requests started with
+/// StartAsync, so decode keeps running while the previous batches are inferred.
+///
+/// @file
+
+#ifndef EXAMPLES_INFER_PIPELINE_H_
+#define EXAMPLES_INFER_PIPELINE_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <inference_engine.hpp>
+#include "remote_blob.h"
+#include "util.h"
+
+#define INFER_SYNC_TIMEOUT 60000
+
+// Frame the result belongs to
+struct InferFrameTag {
+    mfxU32 stream;
+    mfxU32 frame;
+};
+
+class AsyncInferPipeline {
+public:
+    // Called on the inference threads for each frame of a completed batch, the output blob holds
+    // the results of the whole batch and batchIndex is the index of the frame in it
+    typedef std::function<void(const InferFrameTag &tag,
+                               const InferenceEngine::Blob::Ptr &output,
+                               size_t batchIndex)>
+        ResultCallback;
+
+    // The network must be loaded in the context of the cache with the batch size set by
+    // CNNNetwork::setBatchSize
+    AsyncInferPipeline(InferenceEngine::ExecutableNetwork &network,
+                       RemoteBlobCache &blobs,
+                       const std::string &inputName,
+                       const std::string &outputName,
+                       size_t batchSize,
+                       size_t numRequests,
+                       ResultCallback onResult)
+            : m_blobs(blobs),
+              m_inputName(inputName),
+              m_outputName(outputName),
+              m_batchSize(batchSize ? batchSize : 1),
+              m_onResult(onResult),
+              m_slots(numRequests ? numRequests : 1),
+              m_free(),
+              m_filling(NULL),
+              m_mutex(),
+              m_cvFree(),
+              m_failed(false) {
+        for (Slot &slot : m_slots) {
+            slot.request = network.CreateInferRequest();
+            slot.request.SetCompletionCallback<
+                std::function<void(InferenceEngine::InferRequest, InferenceEngine::StatusCode)>>(
+                [this, &slot](InferenceEngine::InferRequest, InferenceEngine::StatusCode code) {
+                    OnComplete(slot, code);
+                });
+            m_free.push_back(&slot);
+        }
+    }
+
+    ~AsyncInferPipeline() {
+        Flush();
+    }
+
+    // Takes over the reference of the surface, it's released when its batch is inferred. The
+    // surface is synchronized when its batch starts. Blocks while all the requests are busy.
+    // Returns false once a request has failed.
+    bool Submit(mfxFrameSurface1 *surface, mfxU16 width, mfxU16 height, InferFrameTag tag) {
+        if (!m_filling) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvFree.wait(lock, [this] {
+                return !m_free.empty();
+            });
+            m_filling = m_free.back();
+            m_free.pop_back();
+        }
+
+        m_filling->surfaces.push_back(surface);
+        m_filling->tags.push_back(tag);
+        m_filling->width  = width;
+        m_filling->height = height;
+        if (m_filling->surfaces.size() == m_batchSize)
+            StartBatch();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_failed;
+    }
+
+    // Starts the incomplete batch and waits for all the requests
+    void Flush() {
+        if (m_filling)
+            StartBatch();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cvFree.wait(lock, [this] {
+            return m_free.size() == m_slots.size();
+        });
+    }
+
+private:
+    struct Slot {
+        InferenceEngine::InferRequest request;
+        std::vector<mfxFrameSurface1 *> surfaces;
+        std::vector<InferFrameTag> tags;
+        mfxU16 width;
+        mfxU16 height;
+    };
+
+    void StartBatch() {
+        Slot *slot = m_filling;
+        m_filling  = NULL;
+
+        std::vector<InferenceEngine::Blob::Ptr> blobs;
+        for (mfxFrameSurface1 *surface : slot->surfaces) {
+            InferenceEngine::Blob::Ptr blob;
+            if (MFX_ERR_NONE == surface->FrameInterface->Synchronize(surface, INFER_SYNC_TIMEOUT))
+                blob = m_blobs.GetBlob(surface, slot->width, slot->height);
+            if (!blob) {
+                printf("Cannot share frame %u of stream %u\n",
+                       slot->tags[blobs.size()].frame,
+                       slot->tags[blobs.size()].stream);
+                OnComplete(*slot, InferenceEngine::GENERAL_ERROR);
+                return;
+            }
+            blobs.push_back(blob);
+        }
+
+        if (1 == m_batchSize) {
+            slot->request.SetBlob(m_inputName, blobs[0]);
+        }
+        else {
+            // the network is compiled for the full batch, the frames of an incomplete one are
+            // repeated and their results skipped
+            while (blobs.size() < m_batchSize)
+                blobs.push_back(blobs.back());
+            slot->request.SetBlob(m_inputName,
+                                  InferenceEngine::make_shared_blob<InferenceEngine::BatchedBlob>(
+                                      blobs));
+        }
+        slot->request.StartAsync();
+    }
+
+    void OnComplete(Slot &slot, InferenceEngine::StatusCode code) {
+        if (InferenceEngine::OK == code) {
+            InferenceEngine::Blob::Ptr output = slot.request.GetBlob(m_outputName);
+            for (size_t i = 0; i < slot.tags.size(); i++)
+                m_onResult(slot.tags[i], output, i);
+        }
+
+        for (mfxFrameSurface1 *surface : slot.surfaces)
+            surface->FrameInterface->Release(surface);
+        slot.surfaces.clear();
+        slot.tags.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (InferenceEngine::OK != code)
+                m_failed = true;
+            m_free.push_back(&slot);
+        }
+        m_cvFree.notify_all();
+    }
+
+    RemoteBlobCache &m_blobs;
+    std::string m_inputName;
+    std::string m_outputName;
+    size_t m_batchSize;
+    ResultCallback m_onResult;
+
+    std::vector<Slot> m_slots;
+    std::vector<Slot *> m_free;
+    Slot *m_filling; // batch being collected by Submit
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    bool m_failed;
+
+    AsyncInferPipeline(const AsyncInferPipeline &);
+    AsyncInferPipeline &operator=(const AsyncInferPipeline &);
+};
+
+#endif // EXAMPLES_INFER_PIPELINE_H_
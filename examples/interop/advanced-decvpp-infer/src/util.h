@@ -44,6 +44,9 @@ enum {
 #define MAX_PATH              260
 #define MAX_WIDTH             3840
 #define MAX_HEIGHT            2160
+#define MAX_INPUT_FILES       16
+#define MAX_BATCH_SIZE        32
+#define MAX_INFER_REQUESTS    16
 #define IS_ARG_EQ(a, b)       (!strcmp((a), (b)))
 
 #define VERIFY(x, y)       \
@@ -73,8 +76,13 @@ typedef struct _Params {
 #endif
 
     char *infileName;
+    char *infileNames[MAX_INPUT_FILES];
+    mfxU16 numInfiles;
     char *inmodelName;
 
+    mfxU16 batchSize;
+    mfxU16 numInferRequests;
+
     mfxU16 srcWidth;
     mfxU16 srcHeight;
 } Params;
@@ -128,6 +136,11 @@ bool ParseArgsAndValidate(int argc, char *argv[], Params *params, ParamGroup gro
             if (!params->infileName) {
                 return false;
             }
+            if (params->numInfiles == MAX_INPUT_FILES) {
+                printf("ERROR - up to %d input files are supported\n", MAX_INPUT_FILES);
+                return false;
+            }
+            params->infileNames[params->numInfiles++] = params->infileName;
         }
         else if (IS_ARG_EQ(s, "m")) {
             params->inmodelName = ValidateFileName(argv[idx++]);
@@ -143,6 +156,14 @@ bool ParseArgsAndValidate(int argc, char *argv[], Params *params, ParamGroup gro
             if (!ValidateSize(argv[idx++], &params->srcHeight, MAX_HEIGHT))
                 return false;
         }
+        else if (IS_ARG_EQ(s, "b")) {
+            if (!ValidateSize(argv[idx++], &params->batchSize, MAX_BATCH_SIZE))
+                return false;
+        }
+        else if (IS_ARG_EQ(s, "nireq")) {
+            if (!ValidateSize(argv[idx++], &params->numInferRequests, MAX_INFER_REQUESTS))
+                return false;
+        }
         else if (IS_ARG_EQ(s, "hw")) {
             params->impl = MFX_IMPL_HARDWARE;
 #if (MFX_VERSION >= 2000)
@@ -11,6 +11,9 @@
 /// https://oneapi-src.github.io/oneAPI-spec/elements/oneVPL/source/index.html
 ///
 /// @file
+#include <chrono>
+#include <vector>
+
 #include <CL/sycl.hpp>
 #include "util.h"
 
@@ -20,6 +23,8 @@
 #define BLUR_RADIUS       5
 #define BLUR_SIZE         (float)((BLUR_RADIUS << 1) + 1)
 #define MAX_PLANES_NUMBER 4
+#define BLUR_TILE_WIDTH   16
+#define BLUR_TILE_HEIGHT  16
 
 #ifdef LIBVA_SUPPORT
     #define HAVE_VIDEO_MEMORY_INTEROP
@@ -27,54 +32,346 @@
 
 #ifdef HAVE_VIDEO_MEMORY_INTEROP
     #include <unistd.h>
+    #include <map>
 
     #include <va/va.h>
     #include <va/va_drmcommon.h>
 
     #include <level_zero/ze_api.h>
     #include <CL/sycl/backend/level_zero.hpp>
+
+// VPP output surface imported to Level Zero as device memory
+struct ImportedSurface {
+    void *ptr;
+    size_t pitch;
+    int dma_fd;
+};
+
+// The VPP output pool reuses its surfaces, so each of them is exported and imported only once and
+// the kernel reads it in place on the following frames
+bool ImportSurface(VADisplay va_dpy,
+                   ze_context_handle_t ze_context,
+                   ze_device_handle_t ze_device,
+                   VASurfaceID va_surface_id,
+                   std::map<VASurfaceID, ImportedSurface> &imported,
+                   ImportedSurface **surface) {
+    auto it = imported.find(va_surface_id);
+    if (it != imported.end()) {
+        *surface = &it->second;
+        return true;
+    }
+
+    VADRMPRIMESurfaceDescriptor prime_desc = {};
+
+    // Export DMA buffer file descriptor from libva library
+    VAStatus va_sts = vaExportSurfaceHandle(va_dpy,
+                                            va_surface_id,
+                                            VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                            VA_EXPORT_SURFACE_READ_ONLY,
+                                            &prime_desc);
+    if (VA_STATUS_SUCCESS != va_sts) {
+        printf("error in vaExportHandle\n");
+        return false;
+    }
+
+    // Check memory layout. At this moment we support only linear
+    // memory layout.
+    if (prime_desc.objects[0].drm_format_modifier != 0) {
+        printf("Error. Only linear memory layout is supported by SYCL kernel.\n");
+        close(prime_desc.objects[0].fd);
+        return false;
+    }
+
+    // Import DMA buf file descriptor to L0 to convert it to USM.
+    ImportedSurface entry = { nullptr, prime_desc.layers[0].pitch[0], prime_desc.objects[0].fd };
+
+    ze_external_memory_import_fd_t import_fd = { ZE_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMPORT_FD,
+                                                 nullptr, // pNext
+                                                 ZE_EXTERNAL_MEMORY_TYPE_FLAG_DMA_BUF,
+                                                 entry.dma_fd };
+    ze_device_mem_alloc_desc_t alloc_desc    = {};
+    alloc_desc.stype                         = ZE_STRUCTURE_TYPE_DEVICE_MEM_ALLOC_DESC;
+    alloc_desc.pNext                         = &import_fd;
+
+    ze_result_t ze_res = zeMemAllocDevice(ze_context,
+                                          &alloc_desc,
+                                          prime_desc.objects[0].size,
+                                          0,
+                                          ze_device,
+                                          &entry.ptr);
+    if (ze_res != ZE_RESULT_SUCCESS) {
+        printf("Error: Failed to get USM pointer\n");
+        close(entry.dma_fd);
+        return false;
+    }
+
+    *surface = &(imported[va_surface_id] = entry);
+    return true;
+}
+
+// Unmaps the imported surfaces from L0, before the surfaces are freed by VPP
+void ReleaseImportedSurfaces(ze_context_handle_t ze_context,
+                             std::map<VASurfaceID, ImportedSurface> &imported) {
+    for (auto &it : imported) {
+        zeMemFree(ze_context, it.second.ptr);
+        close(it.second.dma_fd);
+    }
+    imported.clear();
+}
 #endif
 
-// DPC++ kernel for image blurring
-void BlurFrame(sycl::queue q,
-               int width,
-               int height,
-               uint8_t *src_ptr,
-               size_t src_stride,
-               uint8_t *dst_ptr,
-               size_t dst_stride) {
+enum BlurKernel { BLUR_KERNEL_NAIVE = 0, BLUR_KERNEL_TILED, BLUR_KERNEL_SEPARABLE };
+
+const char *blur_kernel_names[] = { "naive", "tiled", "separable" };
+
+// DPC++ kernel for image blurring, each work-item reads its whole window from global memory
+sycl::event BlurFrameNaive(sycl::queue q,
+                           int width,
+                           int height,
+                           uint8_t *src_ptr,
+                           size_t src_stride,
+                           uint8_t *dst_ptr,
+                           size_t dst_stride) {
+    return q.parallel_for(sycl::range<2>(height, width), [=](sycl::id<2> idx) {
+        auto y = idx.get(0);
+        auto x = idx.get(1);
+
+        // Compute average intensity. Skip borders and set to black color
+        float t0 = 0, t1 = 0, t2 = 0;
+
+        if (x >= BLUR_RADIUS && x < (size_t)width - BLUR_RADIUS && y >= BLUR_RADIUS &&
+            y < (size_t)height - BLUR_RADIUS) {
+            for (size_t yy = y - BLUR_RADIUS; yy < y + BLUR_RADIUS; yy++) {
+                for (size_t xx = x - BLUR_RADIUS; xx < x + BLUR_RADIUS; xx++) {
+                    t0 += src_ptr[yy * src_stride + 4 * xx];
+                    t1 += src_ptr[yy * src_stride + 4 * xx + 1];
+                    t2 += src_ptr[yy * src_stride + 4 * xx + 2];
+                }
+            }
+            t0 /= BLUR_SIZE * BLUR_SIZE;
+            t1 /= BLUR_SIZE * BLUR_SIZE;
+            t2 /= BLUR_SIZE * BLUR_SIZE;
+        }
+
+        dst_ptr[y * dst_stride + 4 * x + 0] = t0;
+        dst_ptr[y * dst_stride + 4 * x + 1] = t1;
+        dst_ptr[y * dst_stride + 4 * x + 2] = t2;
+        dst_ptr[y * dst_stride + 4 * x + 3] = src_ptr[y * src_stride + 4 * x + 3];
+    });
+}
+
+// The work-groups cover the frame with whole tiles, the work-items past the right and bottom
+// edges only help loading the halo
+sycl::nd_range<2> GetTiledRange(int width, int height) {
+    return sycl::nd_range<2>(
+        sycl::range<2>((height + BLUR_TILE_HEIGHT - 1) / BLUR_TILE_HEIGHT * BLUR_TILE_HEIGHT,
+                       (width + BLUR_TILE_WIDTH - 1) / BLUR_TILE_WIDTH * BLUR_TILE_WIDTH),
+        sycl::range<2>(BLUR_TILE_HEIGHT, BLUR_TILE_WIDTH));
+}
+
+// Same blur as BlurFrameNaive, the work-group stages its tile and the halo around it in local
+// memory once, then the windows of all its work-items are read from there. This is the pattern
+// to start custom filters from: each source pixel is read from global memory about once per
+// work-group instead of once per window it belongs to.
+sycl::event BlurFrameTiled(sycl::queue q,
+                           int width,
+                           int height,
+                           uint8_t *src_ptr,
+                           size_t src_stride,
+                           uint8_t *dst_ptr,
+                           size_t dst_stride) {
+    return q.submit([&](sycl::handler &h) {
+        const int tile_width  = BLUR_TILE_WIDTH + 2 * BLUR_RADIUS;
+        const int tile_height = BLUR_TILE_HEIGHT + 2 * BLUR_RADIUS;
+
+        sycl::accessor<sycl::uchar4, 1, sycl::access::mode::read_write, sycl::access::target::local>
+            tile(sycl::range<1>(tile_width * tile_height), h);
+
+        h.parallel_for(GetTiledRange(width, height), [=](sycl::nd_item<2> item) {
+            int ly = (int)item.get_local_id(0);
+            int lx = (int)item.get_local_id(1);
+            int y0 = (int)item.get_group(0) * BLUR_TILE_HEIGHT - BLUR_RADIUS;
+            int x0 = (int)item.get_group(1) * BLUR_TILE_WIDTH - BLUR_RADIUS;
+
+            // Load the tile with its halo, a few pixels per work-item. Pixels out of the frame
+            // are clamped to its edge, only the border pixels would use them.
+            for (int ty = ly; ty < tile_height; ty += BLUR_TILE_HEIGHT) {
+                int sy = sycl::clamp(y0 + ty, 0, height - 1);
+                for (int tx = lx; tx < tile_width; tx += BLUR_TILE_WIDTH) {
+                    int sx = sycl::clamp(x0 + tx, 0, width - 1);
+                    tile[ty * tile_width + tx] =
+                        *(sycl::uchar4 *)(src_ptr + sy * src_stride + 4 * sx);
+                }
+            }
+            item.barrier(sycl::access::fence_space::local_space);
+
+            int y = (int)item.get_global_id(0);
+            int x = (int)item.get_global_id(1);
+            if (x >= width || y >= height)
+                return;
+
+            // Compute average intensity. Skip borders and set to black color. The window starting
+            // at x - BLUR_RADIUS in the frame starts at lx in the tile.
+            float t0 = 0, t1 = 0, t2 = 0;
+
+            if (x >= BLUR_RADIUS && x < width - BLUR_RADIUS && y >= BLUR_RADIUS &&
+                y < height - BLUR_RADIUS) {
+                for (int ty = ly; ty < ly + 2 * BLUR_RADIUS; ty++) {
+                    for (int tx = lx; tx < lx + 2 * BLUR_RADIUS; tx++) {
+                        sycl::uchar4 pixel = tile[ty * tile_width + tx];
+                        t0 += pixel.x();
+                        t1 += pixel.y();
+                        t2 += pixel.z();
+                    }
+                }
+                t0 /= BLUR_SIZE * BLUR_SIZE;
+                t1 /= BLUR_SIZE * BLUR_SIZE;
+                t2 /= BLUR_SIZE * BLUR_SIZE;
+            }
+
+            uint8_t *dst = dst_ptr + y * dst_stride + 4 * x;
+            dst[0]       = t0;
+            dst[1]       = t1;
+            dst[2]       = t2;
+            dst[3]       = tile[(ly + BLUR_RADIUS) * tile_width + lx + BLUR_RADIUS].w();
+        });
+    });
+}
+
+// Same blur as BlurFrameNaive split in a horizontal pass to the row sums in tmp_ptr and a
+// vertical pass over them, both staged in local memory like BlurFrameTiled. A window costs
+// 2 * (2 * BLUR_RADIUS) reads instead of (2 * BLUR_RADIUS)^2, which is what makes large radii
+// affordable. The sums are whole numbers, so the output is exactly the one of the 2D kernels.
+void BlurFrameSeparable(sycl::queue q,
+                        int width,
+                        int height,
+                        uint8_t *src_ptr,
+                        size_t src_stride,
+                        uint8_t *dst_ptr,
+                        size_t dst_stride,
+                        sycl::float4 *tmp_ptr,
+                        std::vector<sycl::event> &events) {
+    events.push_back(q.submit([&](sycl::handler &h) {
+        const int tile_width = BLUR_TILE_WIDTH + 2 * BLUR_RADIUS;
+
+        sycl::accessor<sycl::uchar4, 1, sycl::access::mode::read_write, sycl::access::target::local>
+            tile(sycl::range<1>(tile_width * BLUR_TILE_HEIGHT), h);
+
+        h.parallel_for(GetTiledRange(width, height), [=](sycl::nd_item<2> item) {
+            int ly = (int)item.get_local_id(0);
+            int lx = (int)item.get_local_id(1);
+            int y  = (int)item.get_global_id(0);
+            int x  = (int)item.get_global_id(1);
+            int x0 = (int)item.get_group(1) * BLUR_TILE_WIDTH - BLUR_RADIUS;
+            int sy = sycl::min(y, height - 1);
+
+            for (int tx = lx; tx < tile_width; tx += BLUR_TILE_WIDTH) {
+                int sx = sycl::clamp(x0 + tx, 0, width - 1);
+                tile[ly * tile_width + tx] = *(sycl::uchar4 *)(src_ptr + sy * src_stride + 4 * sx);
+            }
+            item.barrier(sycl::access::fence_space::local_space);
+
+            if (x >= width || y >= height)
+                return;
+
+            sycl::float4 sum = { 0, 0, 0, 0 };
+            for (int tx = lx; tx < lx + 2 * BLUR_RADIUS; tx++)
+                sum += tile[ly * tile_width + tx].convert<float>();
+            tmp_ptr[y * width + x] = sum;
+        });
+    }));
+
+    events.push_back(q.submit([&](sycl::handler &h) {
+        const int tile_height = BLUR_TILE_HEIGHT + 2 * BLUR_RADIUS;
+
+        sycl::accessor<sycl::float4, 1, sycl::access::mode::read_write, sycl::access::target::local>
+            tile(sycl::range<1>(tile_height * BLUR_TILE_WIDTH), h);
+
+        h.depends_on(events.back());
+        h.parallel_for(GetTiledRange(width, height), [=](sycl::nd_item<2> item) {
+            int ly = (int)item.get_local_id(0);
+            int lx = (int)item.get_local_id(1);
+            int y  = (int)item.get_global_id(0);
+            int x  = (int)item.get_global_id(1);
+            int y0 = (int)item.get_group(0) * BLUR_TILE_HEIGHT - BLUR_RADIUS;
+            int sx = sycl::min(x, width - 1);
+
+            for (int ty = ly; ty < tile_height; ty += BLUR_TILE_HEIGHT) {
+                int sy = sycl::clamp(y0 + ty, 0, height - 1);
+                tile[ty * BLUR_TILE_WIDTH + lx] = tmp_ptr[sy * width + sx];
+            }
+            item.barrier(sycl::access::fence_space::local_space);
+
+            if (x >= width || y >= height)
+                return;
+
+            // The row sums are only complete away from the left and right borders
+            sycl::float4 sum = { 0, 0, 0, 0 };
+            if (x >= BLUR_RADIUS && x < width - BLUR_RADIUS && y >= BLUR_RADIUS &&
+                y < height - BLUR_RADIUS) {
+                for (int ty = ly; ty < ly + 2 * BLUR_RADIUS; ty++)
+                    sum += tile[ty * BLUR_TILE_WIDTH + lx];
+                sum /= BLUR_SIZE * BLUR_SIZE;
+            }
+
+            uint8_t *dst = dst_ptr + y * dst_stride + 4 * x;
+            dst[0]       = sum.x();
+            dst[1]       = sum.y();
+            dst[2]       = sum.z();
+            dst[3]       = src_ptr[y * src_stride + 4 * x + 3];
+        });
+    }));
+}
+
+// Blurs the frame with the selected kernel and waits for it. Returns the time the kernels ran on
+// the device in nanoseconds when the queue was created with profiling enabled, 0 otherwise.
+uint64_t BlurFrame(sycl::queue q,
+                   BlurKernel kernel,
+                   int width,
+                   int height,
+                   uint8_t *src_ptr,
+                   size_t src_stride,
+                   uint8_t *dst_ptr,
+                   size_t dst_stride,
+                   sycl::float4 *tmp_ptr) {
+    std::vector<sycl::event> events;
+    uint64_t kernel_time = 0;
+
     try {
-        q.parallel_for(sycl::range<2>(height, width), [=](sycl::id<2> idx) {
-             auto y = idx.get(0);
-             auto x = idx.get(1);
-
-             // Compute average intensity. Skip borders and set to black color
-             float t0 = 0, t1 = 0, t2 = 0;
-
-             if (x >= BLUR_RADIUS && x < (size_t)width - BLUR_RADIUS && y >= BLUR_RADIUS &&
-                 y < (size_t)height - BLUR_RADIUS) {
-                 for (size_t yy = y - BLUR_RADIUS; yy < y + BLUR_RADIUS; yy++) {
-                     for (size_t xx = x - BLUR_RADIUS; xx < x + BLUR_RADIUS; xx++) {
-                         t0 += src_ptr[yy * src_stride + 4 * xx];
-                         t1 += src_ptr[yy * src_stride + 4 * xx + 1];
-                         t2 += src_ptr[yy * src_stride + 4 * xx + 2];
-                     }
-                 }
-                 t0 /= BLUR_SIZE * BLUR_SIZE;
-                 t1 /= BLUR_SIZE * BLUR_SIZE;
-                 t2 /= BLUR_SIZE * BLUR_SIZE;
-             }
-
-             dst_ptr[y * dst_stride + 4 * x + 0] = t0;
-             dst_ptr[y * dst_stride + 4 * x + 1] = t1;
-             dst_ptr[y * dst_stride + 4 * x + 2] = t2;
-             dst_ptr[y * dst_stride + 4 * x + 3] = src_ptr[y * src_stride + 4 * x + 3];
-         }).wait_and_throw();
+        switch (kernel) {
+            case BLUR_KERNEL_NAIVE:
+                events.push_back(
+                    BlurFrameNaive(q, width, height, src_ptr, src_stride, dst_ptr, dst_stride));
+                break;
+            case BLUR_KERNEL_TILED:
+                events.push_back(
+                    BlurFrameTiled(q, width, height, src_ptr, src_stride, dst_ptr, dst_stride));
+                break;
+            case BLUR_KERNEL_SEPARABLE:
+                BlurFrameSeparable(q,
+                                   width,
+                                   height,
+                                   src_ptr,
+                                   src_stride,
+                                   dst_ptr,
+                                   dst_stride,
+                                   tmp_ptr,
+                                   events);
+                break;
+        }
+
+        for (sycl::event &e : events) {
+            e.wait_and_throw();
+            if (q.has_property<sycl::property::queue::enable_profiling>()) {
+                kernel_time += e.get_profiling_info<sycl::info::event_profiling::command_end>() -
+                               e.get_profiling_info<sycl::info::event_profiling::command_start>();
+            }
+        }
     }
     catch (std::exception e) {
         std::cout << "  SYCL exception caught: " << e.what() << std::endl;
-        return;
     }
+    return kernel_time;
 }
 
 void Usage(char *app) {
@@ -84,7 +381,9 @@ void Usage(char *app) {
     printf("     -sw        use software implementation\n");
     printf("     -i input file name (sw=I420 raw frames, hw=NV12)\n");
     printf("     -w input width\n");
-    printf("     -h input height\n\n");
+    printf("     -h input height\n");
+    printf("     -kernel naive|tiled|separable  blur kernel (default tiled)\n");
+    printf("     -bench     report the kernel time and the VPP time per frame\n\n");
     printf("   Example:  %s -i in.i420 -w 320 -h 240\n", app);
     printf("   To view:  ffplay -f rawvideo -video_size %dx%d "
            "-pixel_format bgra %s\n\n",
@@ -117,12 +416,21 @@ int main(int argc, char **argv) {
     mfxU32 blur_data_size   = 0;
     mfxU32 framenum         = 0;
     mfxU8 *blur_data        = NULL;
+    mfxU8 *blur_host_data   = NULL;
     mfxVideoParam VPPParams = {};
     Params cliParams        = {};
     size_t blur_pitch       = 0;
     sycl::queue q;
+    sycl::property_list queue_props;
+    BlurKernel blur_kernel      = BLUR_KERNEL_TILED;
+    sycl::float4 *blur_tmp_data = NULL;
+    uint64_t kernel_time        = 0;
+    std::chrono::nanoseconds vpp_time(0);
 #ifdef HAVE_VIDEO_MEMORY_INTEROP
-    VADisplay va_dpy = NULL;
+    VADisplay va_dpy               = NULL;
+    ze_context_handle_t ze_context = NULL;
+    ze_device_handle_t ze_device   = NULL;
+    std::map<VASurfaceID, ImportedSurface> imported;
 #endif
     mfxU32 desiredDevice = 0;
     // Let's make sure that we are searching oneVPL implementation
@@ -140,6 +448,18 @@ int main(int argc, char **argv) {
         return 1; // return 1 as error code
     }
 
+    if (cliParams.kernelName) {
+        int k = BLUR_KERNEL_NAIVE;
+        while (k <= BLUR_KERNEL_SEPARABLE && strcmp(cliParams.kernelName, blur_kernel_names[k]))
+            k++;
+        if (k > BLUR_KERNEL_SEPARABLE) {
+            printf("ERROR - unknown blur kernel: %s\n", cliParams.kernelName);
+            Usage(argv[0]);
+            return 1;
+        }
+        blur_kernel = (BlurKernel)k;
+    }
+
 #ifndef HAVE_VIDEO_MEMORY_INTEROP
     if (MFX_IMPL_TYPE_SOFTWARE != cliParams.implValue.Data.U32) {
         printf("Only software implementation is supported\n");
@@ -147,9 +467,12 @@ int main(int argc, char **argv) {
     }
 #endif
 
-    // Create SYCL execution queue
-    q = (MFX_IMPL_SOFTWARE == cliParams.impl) ? sycl::queue(sycl::cpu_selector())
-                                              : sycl::queue(sycl::gpu_selector());
+    // Create SYCL execution queue, the events of the kernels carry their device time only when
+    // the queue profiles them
+    if (cliParams.benchmark)
+        queue_props = sycl::property_list{ sycl::property::queue::enable_profiling() };
+    q = (MFX_IMPL_SOFTWARE == cliParams.impl) ? sycl::queue(sycl::cpu_selector(), queue_props)
+                                              : sycl::queue(sycl::gpu_selector(), queue_props);
 
     // Print device name selected for this queue.
     printf("Queue initialized on %s\n",
@@ -157,9 +480,9 @@ int main(int argc, char **argv) {
 
 #ifdef HAVE_VIDEO_MEMORY_INTEROP
     // Get Level-zero context and device from the SYCL backend
-    ze_context_handle_t ze_context = q.get_context().get_native<sycl::backend::level_zero>();
+    ze_context = q.get_context().get_native<sycl::backend::level_zero>();
 
-    ze_device_handle_t ze_device = q.get_device().get_native<sycl::backend::level_zero>();
+    ze_device = q.get_device().get_native<sycl::backend::level_zero>();
     if (q.get_device().get_info<sycl::info::device::device_type>() ==
         sycl::info::device_type::gpu) {
         ze_device_properties_t deviceProperties;
@@ -177,7 +500,25 @@ int main(int argc, char **argv) {
     // Allocate memory for blurred frame
     blur_data_size = GetSurfaceSize(MFX_FOURCC_BGRA, OUTPUT_WIDTH, OUTPUT_HEIGHT);
     blur_pitch     = OUTPUT_WIDTH * 4;
-    blur_data      = sycl::malloc_shared<mfxU8>(blur_data_size, q);
+#ifdef HAVE_VIDEO_MEMORY_INTEROP
+    if (MFX_IMPL_SOFTWARE != cliParams.impl) {
+        // The kernel writes to device memory, the frame is copied once to pinned host memory
+        // for the file rather than migrated through shared memory
+        blur_data      = sycl::malloc_device<mfxU8>(blur_data_size, q);
+        blur_host_data = sycl::malloc_host<mfxU8>(blur_data_size, q);
+        VERIFY(blur_data && blur_host_data, "Could not allocate memory for blurred frame");
+    }
+    else
+#endif
+    {
+        blur_data = sycl::malloc_shared<mfxU8>(blur_data_size, q);
+        VERIFY(blur_data, "Could not allocate memory for blurred frame");
+    }
+    if (BLUR_KERNEL_SEPARABLE == blur_kernel) {
+        // Row sums of the horizontal pass, they're never read on the host
+        blur_tmp_data = sycl::malloc_device<sycl::float4>(OUTPUT_WIDTH * OUTPUT_HEIGHT, q);
+        VERIFY(blur_tmp_data, "Could not allocate memory for blurred frame");
+    }
 
     // Initialize oneVPL session
     loader = MFXLoad();
@@ -249,10 +590,14 @@ int main(int argc, char **argv) {
     // Start processing the frames
     //
 
-    printf("Processing %s -> %s\n", cliParams.infileName, OUTPUT_FILE);
+    printf("Processing %s -> %s with the %s blur kernel\n",
+           cliParams.infileName,
+           OUTPUT_FILE,
+           blur_kernel_names[blur_kernel]);
 
     while (isStillGoing == true) {
         mfxFrameSurface1 *inSurface = nullptr, *outSurface = nullptr;
+        std::chrono::steady_clock::time_point vpp_start;
 
         if (isDraining == false) {
             // Allocate input surface for VPP
@@ -283,17 +628,19 @@ int main(int argc, char **argv) {
         VERIFY(MFX_ERR_NONE == sts, "Error in GetSurfaceForVPPOut");
 
         // Schedule resize and color space converion of input frame
-        sts = MFXVideoVPP_RunFrameVPPAsync(session,
-                                           (isDraining == true) ? NULL : inSurface,
-                                           outSurface,
-                                           NULL,
-                                           &syncp);
+        vpp_start = std::chrono::steady_clock::now();
+        sts       = MFXVideoVPP_RunFrameVPPAsync(session,
+                                                     (isDraining == true) ? NULL : inSurface,
+                                                     outSurface,
+                                                     NULL,
+                                                     &syncp);
 
         switch (sts) {
             case MFX_ERR_NONE: {
                 // Wait for the frame processing complition.
                 sts = MFXVideoCORE_SyncOperation(session, syncp, WAIT_100_MILLISECONDS * 1000);
                 VERIFY(MFX_ERR_NONE == sts, "Error in SyncOperation");
+                vpp_time += std::chrono::steady_clock::now() - vpp_start;
 #ifdef HAVE_VIDEO_MEMORY_INTEROP
                 if ((VPPParams.IOPattern & MFX_IOPATTERN_IN_VIDEO_MEMORY) ==
                     MFX_IOPATTERN_IN_VIDEO_MEMORY) {
@@ -315,67 +662,33 @@ int main(int argc, char **argv) {
                            "Error: only MFX_RESOURCE_VA_SURFACE is supported");
 
                     VASurfaceID va_surface_id = *(VASurfaceID *)handle;
+                    ImportedSurface *surface  = nullptr;
 
-                    VADRMPRIMESurfaceDescriptor prime_desc = {};
-
-                    // Export DMA buffer file descriptor from libva library
-                    VAStatus va_sts = vaExportSurfaceHandle(va_dpy,
-                                                            va_surface_id,
-                                                            VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
-                                                            VA_EXPORT_SURFACE_READ_ONLY,
-                                                            &prime_desc);
-                    VERIFY(VA_STATUS_SUCCESS == va_sts, "error in vaExportHandle");
-
-                    // Check memory layout. At this moment we support only linear
-                    // memory layout.
-                    VERIFY(prime_desc.objects[0].drm_format_modifier == 0,
-                           "Error. Only linear memory layout is supported by SYCL kernel.");
-
-                    // Retrieve DMA  buf file descriptor to pass it to L0.
-                    int dma_fd = prime_desc.objects[0].fd;
-
-                    void *ptr = nullptr;
-                    ze_result_t ze_res;
-
-                    // Import DMA  buf file descriptor to L0 o convert it to USM.
-                    ze_device_mem_alloc_desc_t alloc_desc = {};
-                    alloc_desc.stype = ZE_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMPORT_FD;
-                    ze_external_memory_import_fd_t import_fd = {
-                        ZE_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMPORT_FD,
-                        nullptr, // pNext
-                        ZE_EXTERNAL_MEMORY_TYPE_FLAG_DMA_BUF,
-                        dma_fd
-                    };
-                    alloc_desc.pNext = &import_fd;
-                    ze_res           = zeMemAllocDevice(ze_context,
-                                              &alloc_desc,
-                                              prime_desc.objects[0].size,
-                                              0,
-                                              ze_device,
-                                              &ptr);
-
-                    VERIFY(ze_res == ZE_RESULT_SUCCESS, "Error: Failed to get USM pointer");
+                    VERIFY(ImportSurface(va_dpy,
+                                         ze_context,
+                                         ze_device,
+                                         va_surface_id,
+                                         imported,
+                                         &surface),
+                           "Error: Failed to import VPP output to L0");
 
                     // Execute SYCL kernel to blur the frame. Here we assume that
                     // i/o frames are in device memory, so SYCL kernel is executed on GPU.
-                    BlurFrame(q,
-                              OUTPUT_WIDTH,
-                              OUTPUT_HEIGHT,
-                              (uint8_t *)ptr,
-                              prime_desc.layers[0].pitch[0],
-                              blur_data,
-                              blur_pitch);
-
-                    // Store blured frame in the file.
+                    kernel_time += BlurFrame(q,
+                                             blur_kernel,
+                                             OUTPUT_WIDTH,
+                                             OUTPUT_HEIGHT,
+                                             (uint8_t *)surface->ptr,
+                                             surface->pitch,
+                                             blur_data,
+                                             blur_pitch,
+                                             blur_tmp_data);
+
+                    // Copy blured frame from device memory and store it in the file.
+                    q.memcpy(blur_host_data, blur_data, OUTPUT_HEIGHT * blur_pitch).wait();
                     for (int r = 0; r < OUTPUT_HEIGHT; r++) {
-                        fwrite(blur_data + (r * blur_pitch), 1, blur_pitch, sink);
+                        fwrite(blur_host_data + (r * blur_pitch), 1, blur_pitch, sink);
                     }
-
-                    // unmap memory from L0
-                    ze_res = zeMemFree(ze_context, ptr);
-
-                    // close DMA buf file descriptor
-                    close(dma_fd);
                 }
                 else
 #endif
@@ -389,13 +702,15 @@ int main(int argc, char **argv) {
 
                     // Execute SYCL kernel to blur the frame. Here we assume that
                     // i/o frames are in system memory, so SYCL kernel is executed on CPU.
-                    BlurFrame(q,
-                              OUTPUT_WIDTH,
-                              OUTPUT_HEIGHT,
-                              outSurface->Data.B,
-                              outSurface->Data.Pitch,
-                              blur_data,
-                              blur_pitch);
+                    kernel_time += BlurFrame(q,
+                                             blur_kernel,
+                                             OUTPUT_WIDTH,
+                                             OUTPUT_HEIGHT,
+                                             outSurface->Data.B,
+                                             outSurface->Data.Pitch,
+                                             blur_data,
+                                             blur_pitch,
+                                             blur_tmp_data);
 
                     // Store blured frame in the file.
                     for (int r = 0; r < OUTPUT_HEIGHT; r++) {
@@ -448,6 +763,15 @@ int main(int argc, char **argv) {
 
 end:
     printf("Processed %d frames\n", framenum);
+    if (cliParams.benchmark && framenum) {
+        // VPP time runs from RunFrameVPPAsync to the end of SyncOperation
+        printf("Average per frame:\n");
+        printf("  VPP:                 %.3f ms\n",
+               std::chrono::duration<double, std::milli>(vpp_time).count() / framenum);
+        printf("  %-9s blur kernel: %.3f ms\n",
+               blur_kernel_names[blur_kernel],
+               kernel_time / 1e6 / framenum);
+    }
 
     // Close i/o file
     if (source)
@@ -455,6 +779,11 @@ end:
     if (sink)
         fclose(sink);
 
+#ifdef HAVE_VIDEO_MEMORY_INTEROP
+    // Unmap VPP output surfaces from L0
+    ReleaseImportedSurfaces(ze_context, imported);
+#endif
+
     // Release VPL resources
     if (session) {
         MFXVideoVPP_Close(session);
@@ -465,7 +794,12 @@ end:
         MFXUnload(loader);
 
     // Release memory allocated for blured frame.
-    sycl::free(blur_data, q);
+    if (blur_data)
+        sycl::free(blur_data, q);
+    if (blur_host_data)
+        sycl::free(blur_host_data, q);
+    if (blur_tmp_data)
+        sycl::free(blur_tmp_data, q);
 
     // Close the display.
 #ifdef HAVE_VIDEO_MEMORY_INTEROP
@@ -73,9 +73,12 @@ typedef struct _Params {
 
     char *infileName;
     char *inmodelName;
+    char *kernelName;
 
     mfxU16 srcWidth;
     mfxU16 srcHeight;
+
+    bool benchmark;
 } Params;
 
 char *ValidateFileName(char *in) {
@@ -134,6 +137,15 @@ bool ParseArgsAndValidate(int argc, char *argv[], Params *params, ParamGroup gro
                 return false;
             }
         }
+        else if (IS_ARG_EQ(s, "kernel")) {
+            params->kernelName = argv[idx++];
+            if (!params->kernelName) {
+                return false;
+            }
+        }
+        else if (IS_ARG_EQ(s, "bench")) {
+            params->benchmark = true;
+        }
         else if (IS_ARG_EQ(s, "w")) {
             if (!ValidateSize(argv[idx++], &params->srcWidth, MAX_WIDTH))
                 return false;
@@ -12,7 +12,9 @@
 ///
 /// @file
 
+#include <cldnn/cldnn_config.hpp>
 #include <inference_engine.hpp>
+#include "remote_blob.h"
 #include "util.h"
 using namespace InferenceEngine;
 
@@ -21,11 +23,13 @@ using namespace InferenceEngine;
 #define MAJOR_API_VERSION_REQUIRED 2
 #define MINOR_API_VERSION_REQUIRED 5
 #define MAX_TIMEOUT_COUNT          10
+#define SYNC_TIMEOUT               60000
 
 void Usage(void) {
     printf("\n");
     printf("   Usage  :  hello-decode-infer \n\n");
-    printf("     -sw/-hw        use software or hardware implementation\n");
+    printf("     -sw/-hw        use software or hardware implementation, with -hw the frames\n");
+    printf("                    are shared with the GPU plugin without copies\n");
     printf("     -i             input file name (HEVC elementary stream)\n\n");
     printf("     -m             input model name (OpenVINO)\n\n");
     printf("   Example:  hello-decode-infer -sw  -i in.h265 -m alexnet.xml\n");
@@ -106,6 +110,44 @@ void InferFrame(mfxFrameSurface1 *surface,
     PrintTopResults(out_blob);
 }
 
+// Perform classify inference on video memory frame, the frame is resized to the network input by
+// VPP and shared with the GPU plugin as a remote blob
+mfxStatus InferSharedFrame(mfxSession session,
+                           mfxFrameSurface1 *surface,
+                           RemoteBlobCache *remoteBlobs,
+                           InferRequest *infer_request,
+                           std::string input_name,
+                           std::string output_name,
+                           mfxU16 width,
+                           mfxU16 height) {
+    mfxFrameSurface1 *vppSurfaceOut = NULL;
+    Blob::Ptr in_blob, out_blob;
+
+    mfxStatus sts = MFXVideoVPP_ProcessFrameAsync(session, surface, &vppSurfaceOut);
+    if (MFX_ERR_NONE != sts)
+        return sts;
+
+    sts = vppSurfaceOut->FrameInterface->Synchronize(vppSurfaceOut, SYNC_TIMEOUT);
+    if (MFX_ERR_NONE == sts) {
+        // blobs are cached per surface of the VPP output pool
+        in_blob = remoteBlobs->GetBlob(vppSurfaceOut, width, height);
+        if (in_blob) {
+            infer_request->SetBlob(input_name, in_blob);
+            infer_request->Infer();
+            out_blob = infer_request->GetBlob(output_name);
+
+            PrintTopResults(out_blob);
+        }
+        else {
+            printf("Not able to share VPP output with the GPU plugin\n");
+            sts = MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    vppSurfaceOut->FrameInterface->Release(vppSurfaceOut);
+    return sts;
+}
+
 int main(int argc, char *argv[]) {
     FILE *source                    = NULL;
     FILE *sink                      = NULL;
@@ -116,6 +158,7 @@ int main(int argc, char *argv[]) {
     mfxBitstream bitstream          = {};
     mfxSyncPoint syncp              = {};
     mfxVideoParam mfxDecParams      = {};
+    mfxVideoParam mfxVPPParams      = {};
     mfxU32 frameNum                 = 0;
     bool isDraining                 = false;
     bool isStillGoing               = true;
@@ -136,6 +179,12 @@ int main(int argc, char *argv[]) {
     DataPtr output_info;
     ExecutableNetwork executable_network;
     InferRequest infer_request;
+    SizeVector in_dims;
+    mfxU16 in_width = 0, in_height = 0;
+
+    // hardware frames are shared with the GPU plugin, software frames are mapped
+    bool isZeroCopy = false;
+    RemoteBlobCache remoteBlobs;
 
     //Parse command line args to cliParams
     if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_DECODE) == false) {
@@ -199,7 +248,9 @@ int main(int argc, char *argv[]) {
     VERIFY(MFX_ERR_NONE == sts, "Error reading bitstream\n");
 
     mfxDecParams.mfx.CodecId = MFX_CODEC_HEVC;
-    mfxDecParams.IOPattern   = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    isZeroCopy               = (cliParams.impl != MFX_IMPL_SOFTWARE);
+    mfxDecParams.IOPattern =
+        isZeroCopy ? MFX_IOPATTERN_OUT_VIDEO_MEMORY : MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
     sts                      = MFXVideoDECODE_DecodeHeader(session, &bitstream, &mfxDecParams);
     VERIFY(MFX_ERR_NONE == sts, "Error decoding header\n");
 
@@ -213,19 +264,56 @@ int main(int argc, char *argv[]) {
     VERIFY(network.getOutputsInfo().size() == 1, "Sample supports topologies with 1 output only");
 
     input_info = network.getInputsInfo().begin()->second;
-    input_info->getPreProcess().setResizeAlgorithm(RESIZE_BILINEAR);
-    input_info->getPreProcess().setColorFormat(
-        mfxDecParams.mfx.FrameInfo.FourCC == MFX_FOURCC_I420 ? I420 : NV12);
-    input_info->setLayout(Layout::NHWC);
+    if (isZeroCopy) {
+        // NV12 remote blobs of the network input size, VPP does the resize
+        input_info->getPreProcess().setColorFormat(NV12);
+        input_info->setLayout(Layout::NCHW);
+    }
+    else {
+        input_info->getPreProcess().setResizeAlgorithm(RESIZE_BILINEAR);
+        input_info->getPreProcess().setColorFormat(
+            mfxDecParams.mfx.FrameInfo.FourCC == MFX_FOURCC_I420 ? I420 : NV12);
+        input_info->setLayout(Layout::NHWC);
+    }
     input_info->setPrecision(Precision::U8);
     input_name = network.getInputsInfo().begin()->first;
+    in_dims    = input_info->getTensorDesc().getDims();
+    in_height  = (mfxU16)in_dims[2];
+    in_width   = (mfxU16)in_dims[3];
 
     output_info = network.getOutputsInfo().begin()->second;
     output_info->setPrecision(Precision::FP32);
     output_name = network.getOutputsInfo().begin()->first;
 
-    executable_network =
-        ie.LoadNetwork(network, cliParams.impl == MFX_IMPL_SOFTWARE ? "CPU" : "GPU");
+    if (isZeroCopy) {
+        mfxVPPParams.vpp.In            = mfxDecParams.mfx.FrameInfo;
+        mfxVPPParams.vpp.In.CropX      = 0;
+        mfxVPPParams.vpp.In.CropY      = 0;
+        mfxVPPParams.vpp.In.CropW      = mfxDecParams.mfx.FrameInfo.Width;
+        mfxVPPParams.vpp.In.CropH      = mfxDecParams.mfx.FrameInfo.Height;
+        mfxVPPParams.vpp.Out           = mfxVPPParams.vpp.In;
+        mfxVPPParams.vpp.Out.FourCC    = MFX_FOURCC_NV12;
+        mfxVPPParams.vpp.Out.Width     = ALIGN16(in_width);
+        mfxVPPParams.vpp.Out.Height    = ALIGN16(in_height);
+        mfxVPPParams.vpp.Out.CropW     = in_width;
+        mfxVPPParams.vpp.Out.CropH     = in_height;
+        mfxVPPParams.vpp.Out.PicStruct = MFX_PICSTRUCT_PROGRESSIVE;
+        mfxVPPParams.IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+
+        sts = MFXVideoVPP_Init(session, &mfxVPPParams);
+        VERIFY(MFX_ERR_NONE == sts, "Error initializing VPP\n");
+
+        // Compile network within a context shared with the device of the session
+        VERIFY(remoteBlobs.Init(ie, session), "Not able to create the shared context\n");
+        executable_network = ie.LoadNetwork(
+            network,
+            remoteBlobs.GetContext(),
+            { { GPUConfigParams::KEY_GPU_NV12_TWO_INPUTS, PluginConfigParams::YES } });
+    }
+    else {
+        executable_network =
+            ie.LoadNetwork(network, cliParams.impl == MFX_IMPL_SOFTWARE ? "CPU" : "GPU");
+    }
     infer_request = executable_network.CreateInferRequest();
 
     printf("Decoding and infering %s with %s\n", cliParams.infileName, cliParams.inmodelName);
@@ -270,7 +358,23 @@ int main(int argc, char *argv[]) {
                 do {
                     sts = decSurfaceOut->FrameInterface->Synchronize(decSurfaceOut,
                                                                      WAIT_100_MILLISECONDS);
-                    if (MFX_ERR_NONE == sts) {
+                    if (MFX_ERR_NONE == sts && isZeroCopy) {
+                        sts = InferSharedFrame(session,
+                                               decSurfaceOut,
+                                               &remoteBlobs,
+                                               &infer_request,
+                                               input_name,
+                                               output_name,
+                                               in_width,
+                                               in_height);
+                        VERIFY(MFX_ERR_NONE == sts, "InferSharedFrame failed");
+
+                        sts = decSurfaceOut->FrameInterface->Release(decSurfaceOut);
+                        VERIFY(MFX_ERR_NONE == sts, "mfxFrameSurfaceInterface->Release failed");
+
+                        frameNum++;
+                    }
+                    else if (MFX_ERR_NONE == sts) {
                         decSurfaceOut->FrameInterface->Map(decSurfaceOut, MFX_MAP_READ);
                         VERIFY(MFX_ERR_NONE == sts, "mfxFrameSurfaceInterface->Map failed");
 
@@ -333,12 +437,16 @@ end:
     // Clean up resources - It is recommended to close components first, before
     // releasing allocated surfaces, since some surfaces may still be locked by
     // internal resources.
+    remoteBlobs.Clear();
+
     if (loader)
         MFXUnload(loader);
 
     if (sink)
         fclose(sink);
 
+    if (isZeroCopy)
+        MFXVideoVPP_Close(session);
     MFXVideoDECODE_Close(session);
     MFXClose(session);
 
@@ -0,0 +1,117 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Zero copy sharing of oneVPL video memory surfaces with the OpenVINO GPU
+/// plugin: VA surfaces on Linux and D3D11 textures on Windows are wrapped into
+/// NV12 remote blobs of a context shared with the device of the session. The
+/// network must be loaded in the context with KEY_GPU_NV12_TWO_INPUTS.
+///
+/// @file
+
+#ifndef EXAMPLES_REMOTE_BLOB_H_
+#define EXAMPLES_REMOTE_BLOB_H_
+
+#include <map>
+
+#include <inference_engine.hpp>
+#include "util.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <d3d11.h>
+    #include <gpu/gpu_context_api_dx.hpp>
+#elif defined(LIBVA_SUPPORT)
+    #include <gpu/gpu_context_api_va.hpp>
+#endif
+
+// Remote blobs are kept per surface, the pools of oneVPL reuse their surfaces, so a blob is
+// created once for each surface of the pool rather than for each frame
+class RemoteBlobCache {
+public:
+    RemoteBlobCache() : m_context(), m_blobs() {}
+
+    // creates the context on the device of the session, false if the session has none
+    bool Init(InferenceEngine::Core &ie, mfxSession session) {
+        mfxHDL device = NULL;
+#if defined(_WIN32) || defined(_WIN64)
+        if (MFX_ERR_NONE != MFXVideoCORE_GetHandle(session, MFX_HANDLE_D3D11_DEVICE, &device))
+            return false;
+        m_context = InferenceEngine::gpu::make_shared_context(ie, "GPU", (ID3D11Device *)device);
+#elif defined(LIBVA_SUPPORT)
+        if (MFX_ERR_NONE != MFXVideoCORE_GetHandle(session, MFX_HANDLE_VA_DISPLAY, &device))
+            return false;
+        m_context = InferenceEngine::gpu::make_shared_context(ie, "GPU", (VADisplay)device);
+#else
+        return false;
+#endif
+        return m_context != nullptr;
+    }
+
+    InferenceEngine::RemoteContext::Ptr GetContext() const {
+        return m_context;
+    }
+
+    // NV12 remote blob of the width x height part of the synchronized surface, NULL if the
+    // surface isn't a video memory surface of the device
+    InferenceEngine::Blob::Ptr GetBlob(mfxFrameSurface1 *surface, mfxU16 width, mfxU16 height) {
+        mfxHDL resource              = NULL;
+        mfxResourceType resourceType = {};
+        mfxStatus sts = surface->FrameInterface->GetNativeHandle(surface, &resource, &resourceType);
+        if (MFX_ERR_NONE != sts || !m_context)
+            return nullptr;
+
+        uintptr_t key = 0;
+#if defined(_WIN32) || defined(_WIN64)
+        if (MFX_RESOURCE_DX11_TEXTURE != resourceType)
+            return nullptr;
+        key = (uintptr_t)resource;
+#elif defined(LIBVA_SUPPORT)
+        if (MFX_RESOURCE_VA_SURFACE != resourceType)
+            return nullptr;
+        key = *(VASurfaceID *)resource;
+#endif
+
+        Entry &entry = m_blobs[key];
+        if (!entry.blob || entry.width != width || entry.height != height) {
+            entry.width  = width;
+            entry.height = height;
+#if defined(_WIN32) || defined(_WIN64)
+            entry.blob = InferenceEngine::gpu::make_shared_blob_nv12(
+                height,
+                width,
+                std::dynamic_pointer_cast<InferenceEngine::gpu::D3DContext>(m_context),
+                (ID3D11Texture2D *)resource);
+#elif defined(LIBVA_SUPPORT)
+            entry.blob = InferenceEngine::gpu::make_shared_blob_nv12(
+                height,
+                width,
+                std::dynamic_pointer_cast<InferenceEngine::gpu::VAContext>(m_context),
+                *(VASurfaceID *)resource);
+#endif
+        }
+        return entry.blob;
+    }
+
+    // the blobs refer to the surfaces, they are dropped before the surfaces are freed
+    void Clear() {
+        m_blobs.clear();
+    }
+
+private:
+    struct Entry {
+        InferenceEngine::Blob::Ptr blob;
+        mfxU16 width;
+        mfxU16 height;
+    };
+
+    InferenceEngine::RemoteContext::Ptr m_context;
+    std::map<uintptr_t, Entry> m_blobs;
+
+    RemoteBlobCache(const RemoteBlobCache &);
+    RemoteBlobCache &operator=(const RemoteBlobCache &);
+};
+
+#endif // EXAMPLES_REMOTE_BLOB_H_
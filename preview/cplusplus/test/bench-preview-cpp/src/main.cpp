@@ -0,0 +1,672 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+
+///
+/// Measures overhead of the preview C++ API wrappers against the raw C API calls
+/// doing the same work. Results are reported as ns per operation and operations
+/// (frames) per second.
+///
+/// @file
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "vpl/mfx.h"
+#include "vpl/preview/vpl.hpp"
+
+#define ALIGN16(value) (((value + 15) >> 4) << 4)
+
+#define BENCH_WIDTH      320
+#define BENCH_HEIGHT     240
+#define BENCH_FRAMERATE  30
+#define BENCH_ITERATIONS 1000
+#define BENCH_BS_SIZE    (2 * 1024 * 1024)
+#define BENCH_SEI_SIZE   18
+#define BENCH_FRAME_SIZE (100 * 1000)
+#define BENCH_WAIT_MS    1000
+
+namespace vpl = oneapi::vpl;
+
+using bench_clock = std::chrono::steady_clock;
+
+struct Params {
+    vpl::implementation_type impl = vpl::implementation_type::sw;
+    uint32_t iterations           = BENCH_ITERATIONS;
+    uint32_t frames               = 0;
+    const char *infileName        = nullptr;
+};
+
+// Keeps results of the measured code alive, so the compiler can't drop it.
+static volatile uintptr_t g_sink = 0;
+
+template <typename T>
+void Consume(T *ptr) {
+    g_sink = g_sink + reinterpret_cast<uintptr_t>(ptr);
+}
+
+void Usage(void) {
+    std::cout << std::endl;
+    std::cout << "   Usage  :  bench-preview-cpp\n\n";
+    std::cout << "     -hw     use hardware implementation\n";
+    std::cout << "     -sw     use software implementation (default)\n";
+    std::cout << "     -n      number of iterations for API overhead cases (default "
+              << BENCH_ITERATIONS << ")\n";
+    std::cout << "     -f      number of frames for per frame cases (default same as -n)\n";
+    std::cout << "     -i      input HEVC/H265 elementary stream to run decode cases\n\n";
+    std::cout << "   Example:  bench-preview-cpp -sw -n 10000 -i in.h265\n";
+    return;
+}
+
+bool ParseArgs(int argc, char *argv[], Params *params) {
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-hw")) {
+            params->impl = vpl::implementation_type::hw;
+        }
+        else if (!strcmp(argv[i], "-sw")) {
+            params->impl = vpl::implementation_type::sw;
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            params->iterations = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            params->frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) {
+            params->infileName = argv[++i];
+        }
+        else {
+            return false;
+        }
+    }
+    if (!params->iterations)
+        return false;
+    if (!params->frames)
+        params->frames = params->iterations;
+    return true;
+}
+
+// Throws the same exception as the preview API does for the C API errors, so both
+// flavours of every case are reported by the same handler.
+void Check(mfxStatus sts, const char *what) {
+    if (sts < MFX_ERR_NONE)
+        throw vpl::base_exception(what, sts);
+}
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(48) << "case" << std::right << std::setw(10) << "count"
+              << std::setw(14) << "ns/op" << std::setw(14) << "ops/s" << std::endl;
+}
+
+void Report(const std::string &name, uint64_t count, bench_clock::duration elapsed) {
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(10) << count
+              << std::fixed << std::setprecision(1) << std::setw(14)
+              << (count ? ns / count : 0.0) << std::setw(14)
+              << (ns > 0 ? count * 1e9 / ns : 0.0) << std::endl;
+}
+
+// Runs the case and reports it as skipped if the implementation lacks the required
+// functionality.
+void Run(const std::string &name, std::function<void(const std::string &)> bench) {
+    try {
+        bench(name);
+    }
+    catch (std::exception &e) {
+        std::cout << std::left << std::setw(48) << name << " skipped: " << e.what() << std::endl;
+    }
+}
+
+// Calls fn up to n times or until it returns false and reports the time spent.
+template <typename F>
+void Measure(const std::string &name, uint32_t n, F fn) {
+    uint64_t count = 0;
+    auto start     = bench_clock::now();
+    while (count < n && fn())
+        count++;
+    Report(name, count, bench_clock::now() - start);
+}
+
+// Component to filter implementations with.
+enum class Component { any, decoder, encoder };
+
+mfxLoader RawLoad(const Params &params, Component component, mfxU32 codec_id) {
+    mfxLoader loader = MFXLoad();
+    if (!loader)
+        throw vpl::base_exception("MFXLoad failed", MFX_ERR_NULL_PTR);
+
+    mfxVariant val = {};
+    val.Type       = MFX_VARIANT_TYPE_U32;
+    val.Data.U32   = (mfxU32)params.impl;
+    mfxStatus sts  = MFXSetConfigFilterProperty(MFXCreateConfig(loader),
+                                               (const mfxU8 *)"mfxImplDescription.Impl",
+                                               val);
+    if (sts == MFX_ERR_NONE && component != Component::any) {
+        val.Data.U32 = codec_id;
+        sts          = MFXSetConfigFilterProperty(
+            MFXCreateConfig(loader),
+            (const mfxU8 *)(component == Component::decoder
+                                ? "mfxImplDescription.mfxDecoderDescription.decoder.CodecID"
+                                : "mfxImplDescription.mfxEncoderDescription.encoder.CodecID"),
+            val);
+    }
+    if (sts < MFX_ERR_NONE) {
+        MFXUnload(loader);
+        Check(sts, "MFXSetConfigFilterProperty");
+    }
+    return loader;
+}
+
+// Guard to release C API objects if the case throws.
+struct RawSession {
+    mfxLoader loader   = nullptr;
+    mfxSession session = nullptr;
+
+    explicit RawSession(const Params &params,
+                        Component component = Component::any,
+                        mfxU32 codec_id     = 0) {
+        loader        = RawLoad(params, component, codec_id);
+        mfxStatus sts = MFXCreateSession(loader, 0, &session);
+        if (sts < MFX_ERR_NONE) {
+            MFXUnload(loader);
+            Check(sts, "MFXCreateSession");
+        }
+    }
+
+    ~RawSession() {
+        if (session)
+            MFXClose(session);
+        MFXUnload(loader);
+    }
+};
+
+mfxFrameInfo RawFrameInfo(const Params &params) {
+    mfxFrameInfo info  = {};
+    info.FourCC        = (params.impl == vpl::implementation_type::sw) ? MFX_FOURCC_I420
+                                                                       : MFX_FOURCC_NV12;
+    info.ChromaFormat  = MFX_CHROMAFORMAT_YUV420;
+    info.PicStruct     = MFX_PICSTRUCT_PROGRESSIVE;
+    info.FrameRateExtN = BENCH_FRAMERATE;
+    info.FrameRateExtD = 1;
+    info.Width         = ALIGN16(BENCH_WIDTH);
+    info.Height        = ALIGN16(BENCH_HEIGHT);
+    info.CropW         = BENCH_WIDTH;
+    info.CropH         = BENCH_HEIGHT;
+    return info;
+}
+
+vpl::frame_info PreviewFrameInfo(const Params &params) {
+    vpl::frame_info info;
+    info.set_frame_rate({ BENCH_FRAMERATE, 1 });
+    info.set_frame_size({ ALIGN16(BENCH_WIDTH), ALIGN16(BENCH_HEIGHT) });
+    info.set_FourCC((params.impl == vpl::implementation_type::sw)
+                        ? vpl::color_format_fourcc::i420
+                        : vpl::color_format_fourcc::nv12);
+    info.set_ChromaFormat(vpl::chroma_format_idc::yuv420);
+    info.set_ROI({ { 0, 0 }, { BENCH_WIDTH, BENCH_HEIGHT } });
+    info.set_PicStruct(vpl::pic_struct::progressive);
+    return info;
+}
+
+//
+// Session creation
+//
+
+void BenchSessionCreate(const Params &params) {
+    Run("session create: C API", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            RawSession s(params);
+            Consume(s.session);
+            return true;
+        });
+    });
+
+    Run("session create: default_selector", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl) });
+        Measure(name, params.iterations, [&]() {
+            vpl::encode_session s(sel);
+            Consume(&s);
+            return true;
+        });
+    });
+
+    Run("session create: default_selector, no cache", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl) });
+        Measure(name, params.iterations, [&]() {
+            sel.reset_cache();
+            vpl::encode_session s(sel);
+            Consume(&s);
+            return true;
+        });
+    });
+
+    Run("session create: static_selector, no cache", [&](const std::string &name) {
+        vpl::static_selector sel(vpl::sprops::impl(params.impl));
+        Measure(name, params.iterations, [&]() {
+            sel.reset_cache();
+            vpl::encode_session s(sel);
+            Consume(&s);
+            return true;
+        });
+    });
+}
+
+//
+// frame_surface wrapper lifetime
+//
+
+void BenchSurfaceWrapper(const Params &params) {
+    Run("frame_surface: make_shared", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            auto s = std::make_shared<vpl::frame_surface>();
+            Consume(s.get());
+            return true;
+        });
+    });
+
+    Run("frame_surface: frame_surface_pool", [&](const std::string &name) {
+        vpl::frame_surface_pool pool;
+        Measure(name, params.iterations, [&]() {
+            auto s = pool.make();
+            Consume(s.get());
+            return true;
+        });
+    });
+}
+
+//
+// Extension buffers construction
+//
+
+void BenchExtBuffers(const Params &params) {
+    Run("ext buffers: C structures", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            mfxExtCodingOption2 co2 = {};
+            co2.Header.BufferId     = MFX_EXTBUFF_CODING_OPTION2;
+            co2.Header.BufferSz     = sizeof(co2);
+            mfxExtCodingOption3 co3 = {};
+            co3.Header.BufferId     = MFX_EXTBUFF_CODING_OPTION3;
+            co3.Header.BufferSz     = sizeof(co3);
+            mfxExtBuffer *list[2]   = { &co2.Header, &co3.Header };
+            Consume(list[0]);
+            Consume(list[1]);
+            return true;
+        });
+    });
+
+    Run("ext buffers: encoder_process_list", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            vpl::ExtCodingOption2 co2;
+            vpl::ExtCodingOption3 co3;
+            vpl::encoder_process_list list(&co2, &co3);
+            auto [buffers, size] = list.get_raw_ext_buffers();
+            Consume(buffers);
+            return size == 2;
+        });
+    });
+
+    Run("ext buffers: static_buffer_list", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            vpl::static_buffer_list<vpl::ExtCodingOption2, vpl::ExtCodingOption3> list;
+            auto [buffers, size] = list.get_raw_ext_buffers();
+            Consume(buffers);
+            return size == 2;
+        });
+    });
+
+    // timecode sized SEI attached to every frame
+    std::vector<uint8_t> sei(BENCH_SEI_SIZE, 0);
+
+    Run("payload: EncodeCtrl with copied payload", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            vpl::EncodeCtrl ctrl({ vpl::payload(sei, BENCH_SEI_SIZE * 8, 5, false) });
+            Consume(ctrl.get_ptr());
+            return true;
+        });
+    });
+
+    Run("payload: EncodeCtrl with payload view", [&](const std::string &name) {
+        Measure(name, params.iterations, [&]() {
+            vpl::EncodeCtrl ctrl(
+                { vpl::payload(sei.data(), BENCH_SEI_SIZE, BENCH_SEI_SIZE * 8, 5, false) });
+            Consume(ctrl.get_ptr());
+            return true;
+        });
+    });
+
+    Run("payload: reused EncodeCtrl with payload view", [&](const std::string &name) {
+        vpl::EncodeCtrl ctrl(
+            { vpl::payload(sei.data(), BENCH_SEI_SIZE, BENCH_SEI_SIZE * 8, 5, false) });
+        Measure(name, params.iterations, [&]() {
+            ctrl.get_payload(0).set_data(sei.data(), BENCH_SEI_SIZE, BENCH_SEI_SIZE * 8);
+            Consume(ctrl.get_ptr());
+            return true;
+        });
+    });
+}
+
+//
+// Input bitstream refill
+//
+
+void BenchBitstreamRefill(const Params &params) {
+    auto bench = [&](vpl::bitstream_as_src::refill_mode mode, const std::string &name) {
+        vpl::bitstream_as_src bits(vpl::codec_format_fourcc::hevc, BENCH_BS_SIZE, mode);
+        auto reader = [](uint8_t *ptr, uint32_t max, bool &) {
+            Consume(ptr);
+            return max;
+        };
+        // decoder takes one frame per call, the rest of the frame which doesn't fit into the
+        // buffer is left unconsumed
+        Measure(name, params.iterations, [&]() {
+            bits.pull_in(reader);
+            auto [ptr, length] = bits.get_valid_data();
+            Consume(ptr);
+            if (length >= BENCH_FRAME_SIZE) {
+                bits()->DataOffset += BENCH_FRAME_SIZE;
+                bits()->DataLength -= BENCH_FRAME_SIZE;
+            }
+            return true;
+        });
+        std::cout << std::left << std::setw(48) << "  bytes moved" << std::right << std::setw(10)
+                  << bits.get_bytes_moved() << std::endl;
+    };
+
+    Run("bitstream refill: compact", [&](const std::string &name) {
+        bench(vpl::bitstream_as_src::refill_mode::compact, name);
+    });
+
+    Run("bitstream refill: wrap", [&](const std::string &name) {
+        bench(vpl::bitstream_as_src::refill_mode::wrap, name);
+    });
+}
+
+//
+// Encode per frame overhead
+//
+
+void BenchEncode(const Params &params) {
+    Run("encode_frame: C API", [&](const std::string &name) {
+        RawSession s(params, Component::encoder, MFX_CODEC_HEVC);
+
+        mfxVideoParam par         = {};
+        par.mfx.CodecId           = MFX_CODEC_HEVC;
+        par.mfx.RateControlMethod = MFX_RATECONTROL_CQP;
+        par.mfx.FrameInfo         = RawFrameInfo(params);
+        par.IOPattern             = MFX_IOPATTERN_IN_SYSTEM_MEMORY;
+        Check(MFXVideoENCODE_Init(s.session, &par), "MFXVideoENCODE_Init");
+
+        std::vector<mfxU8> data(BENCH_BS_SIZE);
+        mfxBitstream bs = {};
+        bs.Data         = data.data();
+        bs.MaxLength    = (mfxU32)data.size();
+
+        Measure(name, params.frames, [&]() {
+            mfxFrameSurface1 *surface = nullptr;
+            mfxSyncPoint sp           = nullptr;
+            Check(MFXMemory_GetSurfaceForEncode(s.session, &surface), "GetSurfaceForEncode");
+            mfxStatus sts = MFXVideoENCODE_EncodeFrameAsync(s.session, nullptr, surface, &bs, &sp);
+            surface->FrameInterface->Release(surface);
+            if (sts != MFX_ERR_MORE_DATA)
+                Check(sts, "MFXVideoENCODE_EncodeFrameAsync");
+            if (sp) {
+                Check(MFXVideoCORE_SyncOperation(s.session, sp, BENCH_WAIT_MS),
+                      "MFXVideoCORE_SyncOperation");
+                bs.DataLength = 0;
+            }
+            return true;
+        });
+        MFXVideoENCODE_Close(s.session);
+    });
+
+    Run("encode_frame: preview", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl),
+                                    vpl::dprops::encoder({ vpl::dprops::codec_id(
+                                        vpl::codec_format_fourcc::hevc) }) });
+        vpl::encode_session encoder(sel);
+
+        vpl::encoder_video_param par;
+        par.set_RateControlMethod(vpl::rate_control_method::cqp);
+        par.set_frame_info(PreviewFrameInfo(params));
+        par.set_CodecId(vpl::codec_format_fourcc::hevc);
+        par.set_IOPattern(vpl::io_pattern::in_system_memory);
+        encoder.Init(&par);
+
+        auto bits = std::make_shared<vpl::bitstream_as_dst>();
+        Measure(name, params.frames, [&]() {
+            vpl::status sts = encoder.encode_frame(encoder.alloc_input(), bits);
+            if (sts == vpl::status::Ok) {
+                bits->wait();
+                bits->set_DataLength(0);
+            }
+            return sts == vpl::status::Ok || sts == vpl::status::NotEnoughData;
+        });
+    });
+
+    Run("encode_frame: preview nothrow", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl),
+                                    vpl::dprops::encoder({ vpl::dprops::codec_id(
+                                        vpl::codec_format_fourcc::hevc) }) });
+        vpl::encode_session encoder(sel);
+
+        vpl::encoder_video_param par;
+        par.set_RateControlMethod(vpl::rate_control_method::cqp);
+        par.set_frame_info(PreviewFrameInfo(params));
+        par.set_CodecId(vpl::codec_format_fourcc::hevc);
+        par.set_IOPattern(vpl::io_pattern::in_system_memory);
+        encoder.Init(&par);
+
+        auto bits = std::make_shared<vpl::bitstream_as_dst>();
+        Measure(name, params.frames, [&]() {
+            vpl::operation_result res =
+                encoder.encode_frame(std::nothrow, encoder.alloc_input(), bits);
+            if (res.get_status() == vpl::status::Ok) {
+                bits->wait();
+                bits->set_DataLength(0);
+            }
+            return res.get_status() == vpl::status::Ok ||
+                   res.get_status() == vpl::status::NotEnoughData;
+        });
+    });
+}
+
+//
+// VPP per frame overhead
+//
+
+void BenchVPP(const Params &params) {
+    Run("process_frame: C API", [&](const std::string &name) {
+        RawSession s(params);
+
+        mfxVideoParam par = {};
+        par.vpp.In        = RawFrameInfo(params);
+        par.vpp.Out       = par.vpp.In;
+        par.IOPattern     = MFX_IOPATTERN_IN_SYSTEM_MEMORY | MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+        Check(MFXVideoVPP_Init(s.session, &par), "MFXVideoVPP_Init");
+
+        Measure(name, params.frames, [&]() {
+            mfxFrameSurface1 *in  = nullptr;
+            mfxFrameSurface1 *out = nullptr;
+            mfxSyncPoint sp       = nullptr;
+            Check(MFXMemory_GetSurfaceForVPP(s.session, &in), "GetSurfaceForVPP");
+            Check(MFXMemory_GetSurfaceForVPPOut(s.session, &out), "GetSurfaceForVPPOut");
+            mfxStatus sts = MFXVideoVPP_RunFrameVPPAsync(s.session, in, out, nullptr, &sp);
+            if (sts >= MFX_ERR_NONE && sp)
+                sts = MFXVideoCORE_SyncOperation(s.session, sp, BENCH_WAIT_MS);
+            in->FrameInterface->Release(in);
+            out->FrameInterface->Release(out);
+            Check(sts, "MFXVideoVPP_RunFrameVPPAsync");
+            return true;
+        });
+        MFXVideoVPP_Close(s.session);
+    });
+
+    Run("process_frame: preview", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl) });
+        vpl::vpp_session vpp(sel);
+
+        vpl::vpp_video_param par;
+        par.set_in_frame_info(PreviewFrameInfo(params));
+        par.set_out_frame_info(PreviewFrameInfo(params));
+        par.set_IOPattern(vpl::io_pattern::io_system_memory);
+        vpp.Init(&par);
+
+        Measure(name, params.frames, [&]() {
+            auto out        = std::make_shared<vpl::frame_surface>();
+            vpl::status sts = vpp.process_frame(vpp.alloc_input(), out);
+            if (sts == vpl::status::Ok)
+                out->wait();
+            return sts == vpl::status::Ok;
+        });
+    });
+
+    Run("process_frame: preview nothrow", [&](const std::string &name) {
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl) });
+        vpl::vpp_session vpp(sel);
+
+        vpl::vpp_video_param par;
+        par.set_in_frame_info(PreviewFrameInfo(params));
+        par.set_out_frame_info(PreviewFrameInfo(params));
+        par.set_IOPattern(vpl::io_pattern::io_system_memory);
+        vpp.Init(&par);
+
+        Measure(name, params.frames, [&]() {
+            auto out                  = std::make_shared<vpl::frame_surface>();
+            vpl::operation_result res = vpp.process_frame(std::nothrow, vpp.alloc_input(), out);
+            if (res.get_status() == vpl::status::Ok)
+                out->wait();
+            return res.get_status() == vpl::status::Ok;
+        });
+    });
+}
+
+//
+// Decode per frame overhead
+//
+
+void BenchDecode(const Params &params) {
+    Run("decode_frame: C API", [&](const std::string &name) {
+        std::ifstream source(params.infileName, std::ios_base::in | std::ios_base::binary);
+        if (!source)
+            throw vpl::file_exception(std::string("Couldn't open ") + params.infileName);
+
+        RawSession s(params, Component::decoder, MFX_CODEC_HEVC);
+
+        std::vector<mfxU8> data(BENCH_BS_SIZE);
+        mfxBitstream bs = {};
+        bs.Data         = data.data();
+        bs.MaxLength    = (mfxU32)data.size();
+
+        auto read = [&]() {
+            memmove(bs.Data, bs.Data + bs.DataOffset, bs.DataLength);
+            bs.DataOffset = 0;
+            source.read(reinterpret_cast<char *>(bs.Data + bs.DataLength),
+                        bs.MaxLength - bs.DataLength);
+            bs.DataLength += (mfxU32)source.gcount();
+            return source.gcount() > 0;
+        };
+
+        mfxVideoParam par = {};
+        par.mfx.CodecId   = MFX_CODEC_HEVC;
+        par.IOPattern     = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+        read();
+        Check(MFXVideoDECODE_DecodeHeader(s.session, &bs, &par), "MFXVideoDECODE_DecodeHeader");
+        Check(MFXVideoDECODE_Init(s.session, &par), "MFXVideoDECODE_Init");
+
+        bool draining = false;
+        Measure(name, params.frames, [&]() {
+            while (true) {
+                mfxFrameSurface1 *out = nullptr;
+                mfxSyncPoint sp       = nullptr;
+                mfxStatus sts =
+                    MFXVideoDECODE_DecodeFrameAsync(s.session, draining ? nullptr : &bs, nullptr,
+                                                    &out, &sp);
+                if (sts == MFX_ERR_MORE_DATA) {
+                    if (draining)
+                        return false;
+                    draining = !read();
+                    continue;
+                }
+                if (sts == MFX_ERR_MORE_SURFACE || sts == MFX_WRN_DEVICE_BUSY)
+                    continue;
+                Check(sts, "MFXVideoDECODE_DecodeFrameAsync");
+                if (sp)
+                    sts = MFXVideoCORE_SyncOperation(s.session, sp, BENCH_WAIT_MS);
+                if (out)
+                    out->FrameInterface->Release(out);
+                Check(sts, "MFXVideoCORE_SyncOperation");
+                return true;
+            }
+        });
+        MFXVideoDECODE_Close(s.session);
+    });
+
+    Run("decode_frame: preview", [&](const std::string &name) {
+        std::ifstream source(params.infileName, std::ios_base::in | std::ios_base::binary);
+        if (!source)
+            throw vpl::file_exception(std::string("Couldn't open ") + params.infileName);
+
+        vpl::default_selector sel({ vpl::dprops::impl(params.impl),
+                                    vpl::dprops::decoder({ vpl::dprops::codec_id(
+                                        vpl::codec_format_fourcc::hevc) }) });
+        vpl::bitstream_file_reader reader(source);
+
+        vpl::decoder_video_param par;
+        par.set_IOPattern(vpl::io_pattern::out_system_memory);
+        par.set_CodecId(vpl::codec_format_fourcc::hevc);
+        vpl::decode_session<vpl::bitstream_file_reader> decoder(sel, par, &reader);
+
+        vpl::decoder_init_header_list init_list;
+        if (decoder.init_by_header(init_list) != vpl::status::Ok)
+            throw vpl::base_exception("init_by_header failed", MFX_ERR_UNKNOWN);
+
+        vpl::frame_surface_pool pool;
+        Measure(name, params.frames, [&]() {
+            while (true) {
+                auto out        = pool.make();
+                vpl::status sts = decoder.decode_frame(out);
+                switch (sts) {
+                    case vpl::status::Ok:
+                        out->wait();
+                        return true;
+                    case vpl::status::NotEnoughData:
+                    case vpl::status::DeviceBusy:
+                        continue;
+                    default:
+                        return false;
+                }
+            }
+        });
+    });
+}
+
+int main(int argc, char *argv[]) {
+    Params params;
+
+    if (ParseArgs(argc, argv, &params) == false) {
+        Usage();
+        return 1; // return 1 as error code
+    }
+
+    PrintHeader();
+    BenchSessionCreate(params);
+    BenchSurfaceWrapper(params);
+    BenchExtBuffers(params);
+    BenchBitstreamRefill(params);
+    BenchEncode(params);
+    BenchVPP(params);
+    if (params.infileName)
+        BenchDecode(params);
+
+    return 0;
+}
@@ -113,6 +113,7 @@ static int TestProperty() {
     TEST_CASE(vendor_impl_id, 0x1, "mfxImplDescription.VendorImplID");
     TEST_CASE(implemented_function, "MyFunc", "mfxImplementedFunctions.FunctionsName");
     TEST_CASE(dxgi_adapter_index, 1, "DXGIAdapterIndex");
+    TEST_CASE(num_thread, 4, "NumThread");
     TEST_CASE2(set_handle, handle_type::va_display, 0, "mfxHandleType", "mfxHDL");
     TEST_CASE(pool_alloc_properties,
               pool_alloction_policy::optimal,
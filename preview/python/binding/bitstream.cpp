@@ -139,6 +139,7 @@ void init_bitstream(const py::module &m) {
             .def(
                 "pull_in",
                 &vpl::bitstream_as_src::pull_in,
+                py::call_guard<py::gil_scoped_release>(),
                 "Stores maximum possible portion of data in the circular buffer. Data is strored after unused portion of the buffer in the length of avialable space in the buffer.");
 
     auto bitstream_as_dst =
@@ -150,6 +151,7 @@ void init_bitstream(const py::module &m) {
             .def(py::init<vpl::codec_format_fourcc, uint32_t>())
             .def("wait",
                  &vpl::bitstream_as_dst::wait,
+                 py::call_guard<py::gil_scoped_release>(),
                  "Indefinitely waits for operation completion.")
             .def(
                 "wait_for",
@@ -157,5 +159,6 @@ void init_bitstream(const py::module &m) {
                     std::chrono::duration<int, std::milli> waitduration(milliseconds);
                     return (unsigned int)(s.wait_for(waitduration));
                 },
+                py::call_guard<py::gil_scoped_release>(),
                 "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.");
 }
@@ -7,20 +7,116 @@
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
+// View of the single plane of the mapped surface. Exported through the buffer protocol as
+// height x width x channels array which uses surface pitch as the row stride, so no data is copied.
+class frame_plane {
+public:
+    frame_plane(void *base,
+                py::ssize_t item_size,
+                std::string format,
+                py::ssize_t height,
+                py::ssize_t width,
+                py::ssize_t channels,
+                py::ssize_t pitch)
+            : base(base),
+              item_size(item_size),
+              format(format),
+              height(height),
+              width(width),
+              channels(channels),
+              pitch(pitch) {}
+    py::buffer_info buffer_info() {
+        return py::buffer_info(base,
+                               item_size,
+                               format,
+                               3,
+                               { height, width, channels },
+                               { pitch, item_size * channels, item_size });
+    }
+
+private:
+    void *base;
+    py::ssize_t item_size;
+    std::string format;
+    py::ssize_t height;
+    py::ssize_t width;
+    py::ssize_t channels;
+    py::ssize_t pitch;
+};
+
+// Builds view of the plane with given index. Pointers are valid while surface is mapped.
+static frame_plane make_frame_plane(vpl::frame_surface &s, int idx) {
+    vpl::frame_info info = s.get_frame_info();
+    vpl::frame_data data = s.get_frame_data();
+    py::ssize_t pitch    = data.get_pitch();
+    py::ssize_t w        = info.get_width();
+    py::ssize_t h        = info.get_height();
+    std::string u8       = py::format_descriptor<uint8_t>::format();
+    std::string u16      = py::format_descriptor<uint16_t>::format();
+    void *ptr            = nullptr;
+    int planes           = 0;
+    frame_plane plane(nullptr, 0, u8, 0, 0, 0, 0);
+
+    switch (info.get_FourCC()) {
+        case vpl::color_format_fourcc::nv12: {
+            auto [Y, UV] = data.get_plane_ptrs_2();
+            planes       = 2;
+            ptr          = idx ? (void *)UV : (void *)Y;
+            plane        = idx ? frame_plane(ptr, 1, u8, h / 2, w / 2, 2, pitch)
+                               : frame_plane(ptr, 1, u8, h, w, 1, pitch);
+        } break;
+        case vpl::color_format_fourcc::p010: {
+            auto [Y, UV] = data.get_plane_ptrs_2();
+            planes       = 2;
+            ptr          = idx ? (void *)UV : (void *)Y;
+            plane        = idx ? frame_plane(ptr, 2, u16, h / 2, w / 2, 2, pitch)
+                               : frame_plane(ptr, 2, u16, h, w, 1, pitch);
+        } break;
+        case vpl::color_format_fourcc::i420: {
+            auto [Y, U, V]  = data.get_plane_ptrs_3();
+            uint8_t *ptrs[] = { Y, U, V };
+            planes          = 3;
+            ptr             = (idx >= 0 && idx < planes) ? ptrs[idx] : nullptr;
+            plane           = idx ? frame_plane(ptr, 1, u8, h / 2, w / 2, 1, pitch / 2)
+                                  : frame_plane(ptr, 1, u8, h, w, 1, pitch);
+        } break;
+        case vpl::color_format_fourcc::bgra: {
+            planes = 1;
+            ptr    = data.get_plane_ptrs_1_BGRA();
+            plane  = frame_plane(ptr, 1, u8, h, w, 4, pitch);
+        } break;
+        default:
+            throw py::value_error("Color format is not supported by plane view");
+    }
+
+    if (idx < 0 || idx >= planes)
+        throw py::index_error("Plane index is out of range");
+    if (nullptr == ptr)
+        throw py::value_error("Surface is not mapped");
+    return plane;
+}
+
 void init_frame_surface(const py::module &m) {
+    py::class_<frame_plane>(m, "frame_plane", py::buffer_protocol())
+        .def_buffer(&frame_plane::buffer_info);
+
     py::class_<vpl::frame_surface, std::shared_ptr<vpl::frame_surface>>(m, "frame_surface")
         .def(py::init<>())
         .def(
             "inject",
             &vpl::frame_surface::inject,
             "Inject mfxFrameSurface1 object to take care of it. This is temporal method until VPL RT will support all functions for the internal memory allocation")
-        .def("wait", &vpl::frame_surface::wait, "Indefinitely wait for operation completion.")
+        .def("wait",
+             &vpl::frame_surface::wait,
+             py::call_guard<py::gil_scoped_release>(),
+             "Indefinitely wait for operation completion.")
         .def(
             "wait_for",
             [](vpl::frame_surface &s, int milliseconds) {
                 std::chrono::duration<int, std::milli> waitduration(milliseconds);
                 return s.wait_for(waitduration);
             },
+            py::call_guard<py::gil_scoped_release>(),
             "Waits for the operation completion. Waits for the result to become available. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
         .def_property_readonly("frame_info",
                                &vpl::frame_surface::get_frame_info,
@@ -28,8 +124,19 @@ void init_frame_surface(const py::module &m) {
         .def_property_readonly("frame_data",
                                &vpl::frame_surface::get_frame_data,
                                "Provide frame data information.")
-        .def("map", &vpl::frame_surface::map, "Maps data to the system memory.")
-        .def("unmap", &vpl::frame_surface::unmap, "Unmaps data to the system memory.")
+        .def("map",
+             &vpl::frame_surface::map,
+             py::call_guard<py::gil_scoped_release>(),
+             "Maps data to the system memory.")
+        .def("unmap",
+             &vpl::frame_surface::unmap,
+             py::call_guard<py::gil_scoped_release>(),
+             "Unmaps data to the system memory.")
+        .def(
+            "plane",
+            &make_frame_plane,
+            py::keep_alive<0, 1>(),
+            "Zero-copy view of the mapped plane with given index, usable with numpy.asarray. Array shape is height x width x channels, row stride is the surface pitch. Supported formats are NV12, P010, I420 and BGRA. View must not be used after unmap.")
         .def_property_readonly("native_handle",
                                &vpl::frame_surface::get_native_handle,
                                "native surface handle of the surface.")
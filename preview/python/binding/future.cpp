@@ -7,4 +7,48 @@
 #include "vpl_python.hpp"
 namespace vpl = oneapi::vpl;
 
-void init_future(const py::module &m) {}
\ No newline at end of file
+template <typename Data>
+class future_template {
+public:
+    using Class   = vpl::future<Data>;
+    using PyClass = py::class_<Class, std::shared_ptr<Class>>;
+    PyClass pyclass;
+    future_template(const py::module &m, const std::string &typestr)
+            : pyclass(m, typestr.c_str()) {
+        pyclass
+            .def("wait",
+                 &Class::wait,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Indefinitely waits for operation completion.")
+            .def(
+                "get",
+                [](Class &self) {
+                    return self.get();
+                },
+                py::call_guard<py::gil_scoped_release>(),
+                "Provides syncronized data. Waits indefinitely for the synchronization.")
+            .def(
+                "wait_for",
+                [](Class &self, int milliseconds) {
+                    std::chrono::duration<int, std::milli> waitduration(milliseconds);
+                    return self.wait_for(waitduration);
+                },
+                py::call_guard<py::gil_scoped_release>(),
+                "Waits for the operation completion. Blocks until specified timeout_duration has elapsed or the result becomes available, whichever comes first. Returns value identifying the state of the result.")
+            .def("poll",
+                 &Class::poll,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Checks operation completion without blocking.")
+            .def_property_readonly("is_completed",
+                                   &Class::is_completed,
+                                   "Checks if the operation is completed.")
+            .def_property_readonly("last_schedule_status",
+                                   &Class::get_last_schedule_status,
+                                   "Scheduling status of the last operation.");
+    }
+};
+
+void init_future(const py::module &m) {
+    future_template<std::shared_ptr<vpl::frame_surface>>(m, "future_surface");
+    future_template<std::shared_ptr<vpl::bitstream_as_dst>>(m, "future_bitstream");
+}
@@ -29,7 +29,10 @@ void init_impl_selector(const py::module &m) {
                 list.push_back(*prop);
             }
             return new vpl::default_selector<vpl::property_list>(list);
-        }));
+        }))
+        .def("reset_cache",
+             &vpl::implementation_selector::reset_cache,
+             "Drops cached selection result. Next session is created from the new loader.");
 
     py::class_<vpl::cpu_selector, vpl::implementation_selector, std::shared_ptr<vpl::cpu_selector>>(
         m,
@@ -53,6 +53,7 @@ void init_options(py::module &m) { //NOLINT
     DPROP(device_id, std::string);
     DPROP(media_adapter, vpl::media_adapter_type);
     DPROP(dxgi_adapter_index, uint32_t);
+    DPROP(num_thread, uint32_t);
     DPROP(implemented_function, std::string);
     DPROP(pool_alloc_properties, vpl::pool_alloction_policy);
     DPROP(set_handle, vpl::handle_type, void *);
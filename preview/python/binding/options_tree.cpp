@@ -132,6 +132,9 @@ void init_option_tree(const py::module &m) {
         .def_property("dxgi_adapter_index",
                       &vpl::properties::get_dxgi_adapter_index,
                       &vpl::properties::set_dxgi_adapter_index)
+        .def_property("num_thread",
+                      &vpl::properties::get_num_thread,
+                      &vpl::properties::set_num_thread)
         .def_property("implemented_function",
                       &vpl::properties::get_implemented_function,
                       &vpl::properties::set_implemented_function)
@@ -20,8 +20,14 @@ public:
                 "Verify",
                 &Class::Verify,
                 "Verifies that implementation supports such capabilities. On output, corrected capabilities are returned.")
-            .def("Init", &Class::Init, "Initializes the session by using provided parameters.")
-            .def("Reset", &Class::Reset, "Resets the session by using provided parameters.")
+            .def("Init",
+                 &Class::Init,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Initializes the session by using provided parameters.")
+            .def("Reset",
+                 &Class::Reset,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Resets the session by using provided parameters.")
             .def("working_params", &Class::working_params, "Retrieves current session parameters.")
             .def_property_readonly("component_domain",
                                    &Class::get_component_domain,
@@ -34,10 +40,50 @@ public:
                                      (vpl::implementation_via)(impl & 0xFF00));
                 },
                 "Implementation")
-            .def_property_readonly("version", &Class::get_version, "Returns version");
+            .def_property_readonly("version", &Class::get_version, "Returns version")
+            .def_property_readonly("latency_stat",
+                                   &Class::get_latency_stat,
+                                   "Latency and throughput statistic of the process calls.")
+            .def("set_latency_window",
+                 &Class::set_latency_window,
+                 "Restarts latency statistic with the new throughput window.")
+            .def_property("query_cache",
+                          &Class::get_query_cache,
+                          &Class::set_query_cache,
+                          "Cache of Query and QueryIOSurf results shared with other sessions, None if not attached.");
     }
 };
 
+// Awaitable returned by __anext__. Delegates to the awaitable of the executor future and turns None
+// result into StopAsyncIteration.
+class anext_awaitable {
+public:
+    explicit anext_awaitable(py::object awaitable) : awaitable(awaitable), iter() {}
+    anext_awaitable &await() {
+        iter = awaitable.attr("__await__")();
+        return *this;
+    }
+    py::object next() {
+        try {
+            return iter.attr("__next__")();
+        }
+        catch (py::error_already_set &e) {
+            if (!e.matches(PyExc_StopIteration))
+                throw;
+            py::object value = e.value().attr("value");
+            if (value.is_none())
+                PyErr_SetNone(PyExc_StopAsyncIteration);
+            else
+                PyErr_SetObject(PyExc_StopIteration, value.ptr());
+            throw py::error_already_set();
+        }
+    }
+
+private:
+    py::object awaitable;
+    py::object iter;
+};
+
 template <typename Reader>
 class decode_session_template {
 public:
@@ -57,9 +103,16 @@ public:
             .def(
                 "init_by_header",
                 &Class::init_by_header,
+                py::call_guard<py::gil_scoped_release>(),
                 "Initialize the session by using bitream portion. This step can be omitted if the codec ID is known or we don't need to get SSP or PPS data from the bitstream.")
-            .def("decode_frame", &Class::decode_frame, "Decodes frame")
-            .def("process", &Class::process, "Decodes frame")
+            .def("decode_frame",
+                 &Class::decode_frame,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
+            .def("process",
+                 &Class::process,
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Decodes frame")
             .def_property_readonly("Stat", &Class::getStat, "Retrieve decoder statistic")
             .def_property_readonly("Params", &Class::getParams, "Get video params")
             .def("__iter__",
@@ -67,40 +120,110 @@ public:
                      return *self;
                  })
             .def("__next__", [](Class *self) {
-                bool is_stillgoing = true;
-                while (is_stillgoing == true) {
-                    std::shared_ptr<vpl::frame_surface> dec_surface_out =
-                        std::make_shared<vpl::frame_surface>();
-                    vpl::status ret = self->decode_frame(dec_surface_out);
-                    vpl::async_op_status st;
-                    switch (ret) {
-                        case vpl::status::Ok:
-                            do {
-                                std::chrono::duration<int, std::milli> waitduration(100);
-                                st = dec_surface_out->wait_for(waitduration);
-                                if (vpl::async_op_status::ready == st) {
-                                    return dec_surface_out;
-                                }
-                            } while (st == vpl::async_op_status::timeout);
-                            break;
-                        case vpl::status::EndOfStreamReached:
-                            is_stillgoing = false;
-                            break;
-                        case vpl::status::NotEnoughData:
-                            break;
-                        case vpl::status::DeviceBusy:
-                            break;
-                        default:
-                            is_stillgoing = false;
-                            break;
-                    }
+                std::shared_ptr<vpl::frame_surface> out = nullptr;
+                {
+                    py::gil_scoped_release release;
+                    out = next_frame(self);
                 }
-                throw py::stop_iteration();
-            });
+                if (!out)
+                    throw py::stop_iteration();
+                return out;
+            })
+            .def("__aiter__",
+                 [](Class *self) -> Class & {
+                     return *self;
+                 })
+            .def(
+                "__anext__",
+                [](std::shared_ptr<Class> self) {
+                    py::object loop = py::module::import("asyncio").attr("get_running_loop")();
+                    py::object fut  = loop.attr("run_in_executor")(
+                        py::none(),
+                        py::cpp_function([self]() {
+                            py::gil_scoped_release release;
+                            return next_frame(self.get());
+                        }));
+                    return anext_awaitable(fut);
+                },
+                "Decodes and syncronizes next frame in the default executor of the running event loop. The GIL is released while decoding, so the event loop keeps serving other streams.");
+    }
+
+    // Decodes and syncronizes next frame. Called without the GIL, so must not touch Python objects.
+    static std::shared_ptr<vpl::frame_surface> next_frame(Class *self) {
+        bool is_stillgoing = true;
+        while (is_stillgoing == true) {
+            std::shared_ptr<vpl::frame_surface> dec_surface_out =
+                std::make_shared<vpl::frame_surface>();
+            vpl::status ret = self->decode_frame(dec_surface_out);
+            vpl::async_op_status st;
+            switch (ret) {
+                case vpl::status::Ok:
+                    do {
+                        std::chrono::duration<int, std::milli> waitduration(100);
+                        st = dec_surface_out->wait_for(waitduration);
+                        if (vpl::async_op_status::ready == st) {
+                            return dec_surface_out;
+                        }
+                    } while (st == vpl::async_op_status::timeout);
+                    break;
+                case vpl::status::EndOfStreamReached:
+                    is_stillgoing = false;
+                    break;
+                case vpl::status::NotEnoughData:
+                    break;
+                case vpl::status::DeviceBusy:
+                    break;
+                default:
+                    is_stillgoing = false;
+                    break;
+            }
+        }
+        return nullptr;
     }
 };
 
+// Processes and syncronizes next frame. Called without the GIL, so must not touch Python objects.
+static std::shared_ptr<vpl::frame_surface> next_processed_frame(vpl::vpp_session *self) {
+    std::shared_ptr<vpl::frame_surface> proc_surface_out = std::make_shared<vpl::frame_surface>();
+    oneapi::vpl::status wrn                              = oneapi::vpl::status::Ok;
+    bool is_stillgoing                                   = true;
+    while (is_stillgoing == true) {
+        wrn = self->process_frame(proc_surface_out);
+        switch (wrn) {
+            case oneapi::vpl::status::Ok: {
+                oneapi::vpl::async_op_status st;
+                do {
+                    std::chrono::duration<int, std::milli> waitduration(100);
+                    st = proc_surface_out->wait_for(waitduration);
+                    if (oneapi::vpl::async_op_status::ready == st) {
+                        return proc_surface_out;
+                    }
+                } while (st == oneapi::vpl::async_op_status::timeout);
+            } break;
+            case oneapi::vpl::status::NotEnoughBuffer:
+                break;
+            case oneapi::vpl::status::NotEnoughData:
+                return nullptr;
+            case oneapi::vpl::status::DeviceBusy:
+                break;
+            default:
+                return nullptr;
+        }
+    }
+    return nullptr;
+}
+
 void init_session(const py::module &m) {
+    py::class_<anext_awaitable>(m, "anext_awaitable")
+        .def("__await__", &anext_awaitable::await, py::return_value_policy::reference_internal)
+        .def("__iter__", &anext_awaitable::await, py::return_value_policy::reference_internal)
+        .def("__next__", &anext_awaitable::next);
+
+    py::class_<vpl::query_cache, std::shared_ptr<vpl::query_cache>>(m, "query_cache")
+        .def(py::init<>())
+        .def("__len__", &vpl::query_cache::size)
+        .def("clear", &vpl::query_cache::clear, "Drops all cached results.");
+
     session_template<vpl::decoder_video_param,
                      vpl::decoder_init_reset_list,
                      vpl::decoder_init_reset_list>(m, "decode_session_base");
@@ -121,18 +244,24 @@ void init_session(const py::module &m) {
              &vpl::encode_session::alloc_input,
              "Allocate and return shared pointer to the surface")
         //.def("sync", &vpl::encode_session::sync)
+        // encode_frame has template overload, so py::overload_cast can't deduce the member pointer
         .def("encode_frame",
-             py::overload_cast<std::shared_ptr<vpl::frame_surface>,
-                               std::shared_ptr<vpl::bitstream_as_dst>,
-                               vpl::encoder_process_list>(&vpl::encode_session::encode_frame),
+             static_cast<vpl::status (vpl::encode_session::*)(
+                 std::shared_ptr<vpl::frame_surface>,
+                 std::shared_ptr<vpl::bitstream_as_dst>,
+                 vpl::encoder_process_list)>(&vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame")
         .def("encode_frame",
-             py::overload_cast<std::shared_ptr<vpl::bitstream_as_dst>, vpl::encoder_process_list>(
-                 &vpl::encode_session::encode_frame),
+             static_cast<vpl::status (vpl::encode_session::*)(
+                 std::shared_ptr<vpl::bitstream_as_dst>,
+                 vpl::encoder_process_list)>(&vpl::encode_session::encode_frame),
+             py::call_guard<py::gil_scoped_release>(),
              "Encodes frame by using provided source reader to get data to encode")
         .def(
             "process",
             &vpl::encode_session::process,
+            py::call_guard<py::gil_scoped_release>(),
             "Encode frame. Function returns the future object with the bitstream which will hold processed data. User needs to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::encode_session::getStat, "Retrieve encoder statistic")
         .def("__iter__",
@@ -140,24 +269,33 @@ void init_session(const py::module &m) {
                  return *self;
              })
         .def("__next__", [](vpl::encode_session *self) -> std::shared_ptr<vpl::bitstream_as_dst> {
-            std::shared_ptr<vpl::bitstream_as_dst> bits = std::make_shared<vpl::bitstream_as_dst>();
-            while (true) {
-                vpl::status wrn = vpl::status::Ok;
-                wrn             = self->encode_frame(bits);
-                switch (wrn) {
-                    case vpl::status::Ok: {
-                        std::chrono::duration<int, std::milli> waitduration(100);
-                        bits->wait_for(waitduration);
-                        return bits;
-                    } break;
-                    case vpl::status::EndOfStreamReached:
-                        throw py::stop_iteration();
-                    case vpl::status::DeviceBusy:
-                        continue;
-                    default:
-                        throw py::stop_iteration();
+            std::shared_ptr<vpl::bitstream_as_dst> out = nullptr;
+            {
+                py::gil_scoped_release release;
+                std::shared_ptr<vpl::bitstream_as_dst> bits =
+                    std::make_shared<vpl::bitstream_as_dst>();
+                bool is_stillgoing = true;
+                while (is_stillgoing == true) {
+                    vpl::status wrn = vpl::status::Ok;
+                    wrn             = self->encode_frame(bits);
+                    switch (wrn) {
+                        case vpl::status::Ok: {
+                            std::chrono::duration<int, std::milli> waitduration(100);
+                            bits->wait_for(waitduration);
+                            out           = bits;
+                            is_stillgoing = false;
+                        } break;
+                        case vpl::status::DeviceBusy:
+                            continue;
+                        default:
+                            is_stillgoing = false;
+                            break;
+                    }
                 }
             }
+            if (!out)
+                throw py::stop_iteration();
+            return out;
         });
 
     session_template<vpl::vpp_video_param, vpl::vpp_init_reset_list, vpl::vpp_init_reset_list>(
@@ -178,6 +316,7 @@ void init_session(const py::module &m) {
              "Allocate internal raw surface and attach it to the output surface")
         .def("Init",
              &vpl::vpp_session::Init,
+             py::call_guard<py::gil_scoped_release>(),
              "Initializes session with given parameters and extention buffers.")
         //.def("sync", &vpl::vpp_session::sync)
         .def(
@@ -185,15 +324,18 @@ void init_session(const py::module &m) {
             py::overload_cast<std::shared_ptr<vpl::frame_surface>,
                               std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process_frame",
             py::overload_cast<std::shared_ptr<vpl::frame_surface> &>(
                 &vpl::vpp_session::process_frame),
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the surface which will hold processed data. User need to sync up the surface data before accessing.")
         .def(
             "process",
             &vpl::vpp_session::process,
+            py::call_guard<py::gil_scoped_release>(),
             "Process frame. Function returns the future object with the surface which will hold processed data. User need to sync up the future object before accessing.")
         .def_property_readonly("Stat", &vpl::vpp_session::getStat, "Retrieve vpp statistic")
         .def("__iter__",
@@ -201,33 +343,13 @@ void init_session(const py::module &m) {
                  return *self;
              })
         .def("__next__", [](vpl::vpp_session *self) -> std::shared_ptr<vpl::frame_surface> {
-            std::shared_ptr<vpl::frame_surface> proc_surface_out =
-                std::make_shared<vpl::frame_surface>();
-            oneapi::vpl::status wrn = oneapi::vpl::status::Ok;
-            bool is_stillgoing      = true;
-            while (is_stillgoing == true) {
-                wrn = self->process_frame(proc_surface_out);
-                switch (wrn) {
-                    case oneapi::vpl::status::Ok: {
-                        oneapi::vpl::async_op_status st;
-                        do {
-                            std::chrono::duration<int, std::milli> waitduration(100);
-                            st = proc_surface_out->wait_for(waitduration);
-                            if (oneapi::vpl::async_op_status::ready == st) {
-                                return proc_surface_out;
-                            }
-                        } while (st == oneapi::vpl::async_op_status::timeout);
-                    } break;
-                    case oneapi::vpl::status::NotEnoughBuffer:
-                        break;
-                    case oneapi::vpl::status::NotEnoughData:
-                        throw py::stop_iteration();
-                    case oneapi::vpl::status::DeviceBusy:
-                        break;
-                    default:
-                        throw py::stop_iteration();
-                }
+            std::shared_ptr<vpl::frame_surface> out = nullptr;
+            {
+                py::gil_scoped_release release;
+                out = next_processed_frame(self);
             }
-            throw py::stop_iteration();
+            if (!out)
+                throw py::stop_iteration();
+            return out;
         });
 }
\ No newline at end of file
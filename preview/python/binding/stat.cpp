@@ -36,4 +36,24 @@ void init_stat(const py::module &m) {
     py::class_<vpl::vpp_stat, vpl::stat, std::shared_ptr<vpl::vpp_stat>>(m, "vpp_stat")
         .def(py::init<>())
         .def_property_readonly("raw", &vpl::vpp_stat::get_raw, "Retrieves raw data pointer");
+
+    py::class_<vpl::latency_stat, std::shared_ptr<vpl::latency_stat>>(m, "latency_stat")
+        .def_property_readonly("num_samples",
+                               &vpl::latency_stat::get_num_samples,
+                               "Retrieves number of recorded operations")
+        .def("percentile", &vpl::latency_stat::get_percentile, "Retrieves latency percentile")
+        .def_property_readonly("p50", &vpl::latency_stat::get_p50, "Retrieves median latency")
+        .def_property_readonly("p95",
+                               &vpl::latency_stat::get_p95,
+                               "Retrieves 95th percentile of latency")
+        .def_property_readonly("p99",
+                               &vpl::latency_stat::get_p99,
+                               "Retrieves 99th percentile of latency")
+        .def_property_readonly(
+            "fps",
+            &vpl::latency_stat::get_fps,
+            "Retrieves number of operations completed per second over the sliding window")
+        .def_property_readonly("window",
+                               &vpl::latency_stat::get_window,
+                               "Retrieves duration of the sliding window");
 }
\ No newline at end of file
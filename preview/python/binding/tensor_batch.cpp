@@ -0,0 +1,280 @@
+//==============================================================================
+// Copyright Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+//==============================================================================
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vpl/preview/session.hpp"
+#include "vpl_python.hpp"
+namespace vpl = oneapi::vpl;
+
+// DLPack v0.x ABI, declared here to not depend on dlpack.h
+struct DLDevice {
+    int32_t device_type;
+    int32_t device_id;
+};
+
+struct DLDataType {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+};
+
+struct DLTensor {
+    void *data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t *shape;
+    int64_t *strides;
+    uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void *manager_ctx;
+    void (*deleter)(DLManagedTensor *self);
+};
+
+static const int32_t dl_device_cpu = 1;
+static const uint8_t dl_uint       = 1;
+static const uint8_t dl_float      = 2;
+
+// Half precision values of 0..255 scaled to [0, 1], built once.
+static const std::vector<uint16_t> &half_table() {
+    static const std::vector<uint16_t> table = [] {
+        std::vector<uint16_t> t(256, 0);
+        for (int i = 1; i < 256; i++) {
+            float value = i / 255.0f;
+            uint32_t f;
+            std::memcpy(&f, &value, sizeof(f));
+            // normal numbers only, rounded to nearest, carry goes to the exponent
+            uint32_t exp  = ((f >> 23) & 0xFF) - 127 + 15;
+            uint32_t mant = f & 0x7FFFFF;
+            t[i]          = (uint16_t)(((exp << 10) | (mant >> 13)) + ((mant >> 12) & 1));
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Preallocated N x 3 x H x W tensor of RGB planes filled from VPP output surfaces. VPP does the
+// resize and color conversion, the batch only copies planes, so the CPU doesn't touch pixels
+// other than to store them. Storage is shared with DLPack capsules, which may outlive the batch.
+class tensor_batch {
+public:
+    tensor_batch(size_t batch, size_t height, size_t width, const std::string &dtype)
+            : batch(batch),
+              height(height),
+              width(width),
+              is_half(dtype == "float16"),
+              storage() {
+        if (!batch || !height || !width)
+            throw py::value_error("Batch and frame sizes must be positive");
+        if (dtype != "uint8" && dtype != "float16")
+            throw py::value_error("Data type must be uint8 or float16");
+        storage = std::make_shared<std::vector<uint8_t>>(batch * 3 * height * width * item_size());
+    }
+
+    size_t item_size() const {
+        return is_half ? 2 : 1;
+    }
+
+    py::buffer_info buffer_info() {
+        py::ssize_t item  = item_size();
+        py::ssize_t plane = height * width * item;
+        return py::buffer_info(storage->data(),
+                               item,
+                               is_half ? "e" : py::format_descriptor<uint8_t>::format(),
+                               4,
+                               { (py::ssize_t)batch, (py::ssize_t)3, (py::ssize_t)height,
+                                 (py::ssize_t)width },
+                               { 3 * plane, plane, (py::ssize_t)width * item, item });
+    }
+
+    // Stores the RGBP or BGRA surface of the batch size to the slot. Output of the session is
+    // waited for and mapped here.
+    void store(size_t index, vpl::frame_surface &surface) {
+        if (index >= batch)
+            throw py::index_error("Batch index is out of range");
+
+        auto [info, data] = surface.map(vpl::memory_access::read);
+        try {
+            auto roi          = info.get_ROI();
+            size_t pitch      = data.get_pitch();
+            size_t plane_size = height * width;
+            uint8_t *dst      = storage->data() + index * 3 * plane_size * item_size();
+            if ((size_t)roi.second.first != width || (size_t)roi.second.second != height)
+                throw py::value_error("Surface size doesn't match the batch");
+
+            const uint8_t *src[3];
+            size_t step = 1;
+            switch (info.get_FourCC()) {
+                case vpl::color_format_fourcc::rgbp: {
+                    auto [R, G, B] = data.get_plane_ptrs_3();
+                    src[0]         = R;
+                    src[1]         = G;
+                    src[2]         = B;
+                } break;
+                case vpl::color_format_fourcc::bgra: {
+                    const uint8_t *B = data.get_plane_ptrs_1_BGRA();
+                    src[0]           = B + 2;
+                    src[1]           = B + 1;
+                    src[2]           = B;
+                    step             = 4;
+                } break;
+                default:
+                    throw py::value_error("Surface must be RGBP or BGRA");
+            }
+
+            const std::vector<uint16_t> &half = half_table();
+
+            size_t offset = roi.first.second * pitch + roi.first.first * step;
+            for (size_t c = 0; c < 3; c++) {
+                for (size_t y = 0; y < height; y++) {
+                    const uint8_t *s = src[c] + offset + y * pitch;
+                    size_t pos       = c * plane_size + y * width;
+                    if (is_half) {
+                        uint16_t *d = (uint16_t *)dst + pos;
+                        for (size_t x = 0; x < width; x++)
+                            d[x] = half[s[x * step]];
+                    }
+                    else if (step == 1) {
+                        std::memcpy(dst + pos, s, width);
+                    }
+                    else {
+                        for (size_t x = 0; x < width; x++)
+                            dst[pos + x] = s[x * step];
+                    }
+                }
+            }
+        }
+        catch (...) {
+            surface.unmap();
+            throw;
+        }
+        surface.unmap();
+    }
+
+    // Runs VPP of every input surface and stores outputs to the slots starting from first. All
+    // frames are submitted before the first is waited for, so the device converts them together.
+    // One session is used for all surfaces or one per surface, e.g. per stream. Returns the number
+    // of stored frames, fewer if VPP needs more input.
+    size_t convert(const std::vector<std::shared_ptr<vpl::vpp_session>> &sessions,
+                   const std::vector<std::shared_ptr<vpl::frame_surface>> &surfaces,
+                   size_t first) {
+        if (sessions.empty() || (sessions.size() != 1 && sessions.size() != surfaces.size()))
+            throw py::value_error("One session or one session per surface is expected");
+        if (first > batch || surfaces.size() > batch - first)
+            throw py::index_error("Surfaces don't fit into the batch");
+
+        std::vector<std::shared_ptr<vpl::frame_surface>> outputs;
+        for (size_t i = 0; i < surfaces.size(); i++) {
+            auto out = std::make_shared<vpl::frame_surface>();
+            auto sts = sessions[sessions.size() == 1 ? 0 : i]->process_frame(surfaces[i], out);
+            if (sts != vpl::status::Ok)
+                break;
+            outputs.push_back(out);
+        }
+
+        for (size_t i = 0; i < outputs.size(); i++)
+            store(first + i, *outputs[i]);
+        return outputs.size();
+    }
+
+    py::capsule dlpack() {
+        // shape, strides and the storage reference live in the manager context
+        struct context {
+            DLManagedTensor tensor;
+            int64_t shape[4];
+            int64_t strides[4];
+            std::shared_ptr<std::vector<uint8_t>> storage;
+        };
+        context *ctx    = new context();
+        ctx->storage    = storage;
+        int64_t shape[] = { (int64_t)batch, 3, (int64_t)height, (int64_t)width };
+        for (int i = 0; i < 4; i++)
+            ctx->shape[i] = shape[i];
+        ctx->strides[3] = 1;
+        for (int i = 2; i >= 0; i--)
+            ctx->strides[i] = ctx->strides[i + 1] * shape[i + 1];
+
+        DLTensor &t   = ctx->tensor.dl_tensor;
+        t.data        = storage->data();
+        t.device      = { dl_device_cpu, 0 };
+        t.ndim        = 4;
+        t.dtype       = { is_half ? dl_float : dl_uint, (uint8_t)(8 * item_size()), 1 };
+        t.shape       = ctx->shape;
+        t.strides     = ctx->strides;
+        t.byte_offset = 0;
+
+        ctx->tensor.manager_ctx = ctx;
+        ctx->tensor.deleter     = [](DLManagedTensor *self) {
+            delete static_cast<context *>(self->manager_ctx);
+        };
+
+        // consumers rename the capsule to "used_dltensor" and call the deleter themselves
+        return py::capsule(&ctx->tensor, "dltensor", [](PyObject *capsule) {
+            if (PyCapsule_IsValid(capsule, "dltensor")) {
+                auto tensor =
+                    static_cast<DLManagedTensor *>(PyCapsule_GetPointer(capsule, "dltensor"));
+                tensor->deleter(tensor);
+            }
+        });
+    }
+
+    size_t batch;
+    size_t height;
+    size_t width;
+    bool is_half;
+    std::shared_ptr<std::vector<uint8_t>> storage;
+};
+
+void init_tensor_batch(const py::module &m) {
+    py::class_<tensor_batch, std::shared_ptr<tensor_batch>>(m,
+                                                            "tensor_batch",
+                                                            py::buffer_protocol())
+        .def(py::init<size_t, size_t, size_t, const std::string &>(),
+             py::arg("batch"),
+             py::arg("height"),
+             py::arg("width"),
+             py::arg("dtype") = "uint8",
+             "Preallocated batch x 3 x height x width tensor of RGB planes, uint8 or float16 scaled to [0, 1].")
+        .def_buffer(&tensor_batch::buffer_info)
+        .def_property_readonly(
+            "shape",
+            [](const tensor_batch &self) {
+                return py::make_tuple(self.batch, 3, self.height, self.width);
+            },
+            "Shape of the tensor.")
+        .def("__len__", [](const tensor_batch &self) {
+            return self.batch;
+        })
+        .def(
+            "store",
+            &tensor_batch::store,
+            py::call_guard<py::gil_scoped_release>(),
+            "Stores RGBP or BGRA surface of the tensor frame size to the batch slot with given index.")
+        .def(
+            "convert",
+            &tensor_batch::convert,
+            py::arg("sessions"),
+            py::arg("surfaces"),
+            py::arg("first") = 0,
+            py::call_guard<py::gil_scoped_release>(),
+            "Resizes and converts decoded surfaces with VPP sessions configured for RGBP or BGRA output of the tensor frame size and stores them to the slots starting from first. Takes one session for all surfaces or one per surface. All surfaces are submitted before waiting for the first one. Returns the number of stored frames.")
+        .def(
+            "__dlpack__",
+            [](tensor_batch &self, py::object) {
+                return self.dlpack();
+            },
+            py::arg("stream") = py::none(),
+            "DLPack capsule of the tensor in host memory, shares storage without copying.")
+        .def("__dlpack_device__", [](const tensor_batch &self) {
+            return py::make_tuple(dl_device_cpu, 0);
+        });
+}
@@ -30,6 +30,7 @@ void init_payload(const py::module &m);
 void init_session(const py::module &m);
 void init_source_reader(const py::module &m);
 void init_stat(const py::module &m);
+void init_tensor_batch(const py::module &m);
 void init_video_param(const py::module &m);
 
 PYBIND11_MODULE(pyvpl, m) {
@@ -52,6 +53,7 @@ PYBIND11_MODULE(pyvpl, m) {
     init_session(m);
     init_source_reader(m);
     init_stat(m);
+    init_tensor_batch(m);
     init_video_param(m);
 
     py::class_<mfxVersion, std::shared_ptr<mfxVersion>>(m, "mfxVersion")
@@ -6,146 +6,190 @@
 
 ///
 /// A minimal oneAPI Video Processing Library (oneVPL) decode and VPP application,
-/// using 2.x API with internal memory management
+/// using 2.x API with internal memory management. Several inputs are decoded
+/// concurrently, each on its own thread and session of one implementation.
 ///
 /// @file
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "util.hpp"
 
 #define BITSTREAM_BUFFER_SIZE 2000000
 #define SYNC_TIMEOUT          60000
-
-void Usage(void) {
-    printf("\n");
-    printf("   Usage  :  decvpp_tool\n\n");
-    printf("     h265/h264      set codec type to decode\n\n");
-    printf("     -sw/-hw        use software or hardware implementation\n\n");
-    printf("     -i             input file name (video elementary stream)\n\n");
-    printf("     -o             decode out file name\n\n");
-    printf("     -vpp_num       number of vpp channels\n\n");
-    printf("     -vpp_params    vpp params for each vpp channel\n");
-    printf("                    support scale/csc\n");
-    printf("                    ',' separator for each vpp channel\n\n");
-    printf("     -vpp_out       file name for each vpp out\n");
-    printf("                    ',' separator for each vpp channel\n\n");
-    printf("     -vmem          use video memory\n\n");
-    printf("   Example: \n");
-    printf(
-        "     decvpp_tool h265 -sw -i cars_320x240.h265 -o dec.raw -vpp_num 2 -vpp_params 128x96_i420,640x480_bgra -vpp_out o1.raw,o2.raw\n");
-    printf("     or\n");
-    printf(
-        "     decvpp_tool h265 -hw -i cars_320x240.h265 -o dec.raw -vpp_num 2 -vpp_params 128x96_nv12,640x480_bgra -vpp_out o1.raw,o2.raw\n\n");
-    printf("     this will generate 1 decode output file and 2 vpp output files\n");
-    printf("     dec.raw : decode output  : 320 x 240,  (-sw: i420, -hw: nv12)\n");
-    printf("     o1.raw  : 1st vpp output : 128 x 96, (-sw: i420, -hw: nv12)\n");
-    printf("     o2.raw  : 2st vpp output : 640 x 480, bgra\n");
-
-    return;
-}
-
-int main(int argc, char *argv[]) {
-    //Variables used for legacy and 2.x
-    bool isDraining                       = false;
-    bool isStillGoing                     = true;
-    FILE *sinkDec                         = NULL; // for decoded frames
-    FILE **sinkVPP                        = NULL; // for vpp output
-    FILE *source                          = NULL;
-    int accel_fd                          = 0;
-    mfxBitstream bitstream                = {};
-    mfxSession session                    = NULL;
-    mfxStatus sts                         = MFX_ERR_NONE;
-    mfxSurfaceArray *outSurfaces          = nullptr;
-    mfxU32 framenum                       = 0;
-    mfxVideoChannelParam **mfxVPPChParams = nullptr;
-    Params cliParams                      = {};
-    void *accelHandle                     = NULL;
-    mfxVideoParam mfxDecParams            = {};
-    mfxVersion version                    = { 0, 1 };
-    mfxFrameSurface1 *aSurf               = nullptr;
-
-    //variables used only in 2.x version
-    mfxConfig cfg      = NULL;
-    mfxLoader loader   = NULL;
-    mfxVariant inCodec = {};
-
-    //Parse command line args to cliParams
-    if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_DECVPP) == false) {
-        Usage();
-        delete[] cliParams.vppOutConfigs;
-        return 1; // return 1 as error code
+#define WRITER_QUEUE_FRAMES   4
+
+// Synchronizes the output surfaces of a stream and writes them on its own thread, so that decode
+// keeps running while the frames are written. Surfaces without a file are only synchronized.
+class AsyncWriter {
+public:
+    explicit AsyncWriter(size_t maxQueued)
+            : m_maxQueued(maxQueued),
+              m_queue(),
+              m_mutex(),
+              m_cv(),
+              m_bStop(false),
+              m_sts(MFX_ERR_NONE),
+              m_thread() {}
+
+    ~AsyncWriter() {
+        Stop();
     }
 
-    source = fopen(cliParams.inFileName, "rb");
-    VERIFY(source, "ERROR - Could not open input file");
-
-    if (cliParams.decOutFileName) {
-        sinkDec = fopen(cliParams.decOutFileName, "wb");
-        VERIFY(sinkDec, "ERROR - Could not create decode output file");
-    }
-    else {
-        printf(
-            "WARNING - No decode output filename assigned, will skip writing decode output file\n");
+    void Start() {
+        m_thread = std::thread(&AsyncWriter::Run, this);
     }
 
-    if (cliParams.bIsAvailableVPPOutFileName) {
-        sinkVPP = new FILE *[cliParams.vppNum];
-        VERIFY(sinkVPP, "ERROR - Could not create vpp list");
+    // Takes over the reference of the surface. Blocks while maxQueued surfaces are waiting, which
+    // bounds the surfaces held by the writer. Returns the first error of the writer.
+    mfxStatus Push(mfxFrameSurface1 *surface, FILE *sink) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] {
+            return m_queue.size() < m_maxQueued;
+        });
+        m_queue.push_back({ surface, sink });
+        m_cv.notify_all();
+        return m_sts;
+    }
 
-        for (mfxU16 i = 0; i < cliParams.vppNum; i++) {
-            sinkVPP[i] = fopen(cliParams.vppOutConfigs[i].fileName, "wb");
-            VERIFY(sinkVPP[i], "ERROR - Could not create vpp output file");
+    // Writes the queued surfaces and ends the thread
+    mfxStatus Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
         }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+        return m_sts;
     }
-    else {
-        printf("WARNING - No VPP output filename assigned, will skip writing VPP output file\n");
-    }
-
-    // Initialize VPL session for any implementation of decode
-    loader = MFXLoad();
-    VERIFY(NULL != loader, "ERROR - MFXLoad failed -- is implementation in path?");
-
-    cfg = MFXCreateConfig(loader);
-    VERIFY(NULL != cfg, "ERROR - MFXCreateConfig failed")
-
-    // Implementation used must be the type requested from command line
-    sts = MFXSetConfigFilterProperty(cfg,
-                                     reinterpret_cast<const mfxU8 *>("mfxImplDescription.Impl"),
-                                     cliParams.implValue);
-    VERIFY(MFX_ERR_NONE == sts, "ERROR - MFXSetConfigFilterProperty failed for Impl");
-
-    // Implementation must provide a decoder
-    inCodec.Type     = MFX_VARIANT_TYPE_U32;
-    inCodec.Data.U32 = cliParams.inCodec;
-    sts              = MFXSetConfigFilterProperty(
-        cfg,
-        reinterpret_cast<const mfxU8 *>("mfxImplDescription.mfxDecoderDescription.decoder.CodecID"),
-        inCodec);
-    VERIFY(MFX_ERR_NONE == sts, "ERROR - MFXSetConfigFilterProperty failed for decoder CodecID");
 
-    sts = MFXCreateSession(loader, 0, &session);
-    VERIFY(MFX_ERR_NONE == sts, "ERROR - Not able to create VPL session");
+private:
+    struct Item {
+        mfxFrameSurface1 *surface;
+        FILE *sink;
+    };
+
+    void Run() {
+        for (;;) {
+            Item item;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this] {
+                    return m_bStop || !m_queue.empty();
+                });
+                if (m_queue.empty())
+                    return;
+                item = m_queue.front();
+                m_queue.pop_front();
+            }
+            m_cv.notify_all();
+
+            mfxStatus sts = item.surface->FrameInterface->Synchronize(item.surface, SYNC_TIMEOUT);
+            if (MFX_ERR_NONE == sts && item.sink)
+                sts = WriteRawFrame_InternalMem(item.surface, item.sink);
+            item.surface->FrameInterface->Release(item.surface);
+
+            if (MFX_ERR_NONE != sts) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (MFX_ERR_NONE == m_sts)
+                    m_sts = sts;
+            }
+        }
+    }
 
-    // Print info about implementation loaded
-    version = ShowImplInfo(session);
-    VERIFY(version.Major > 1, "ERROR - Sample requires 2.x API implementation, exiting");
+    size_t m_maxQueued;
+    std::deque<Item> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_bStop;
+    mfxStatus m_sts; // first error
+    std::thread m_thread;
+
+    AsyncWriter(const AsyncWriter &);
+    AsyncWriter &operator=(const AsyncWriter &);
+};
+
+// One input with its session, files and writer. params is the command line with the input and
+// output file names of the stream and the decoded frame info.
+struct DecVPPStream {
+    DecVPPStream()
+            : params(),
+              vppOutConfigs(),
+              decOutFileName(),
+              session(NULL),
+              source(NULL),
+              sinkDec(NULL),
+              sinkVPP(),
+              writer(nullptr),
+              thread(),
+              framenum(0),
+              seconds(0),
+              sts(MFX_ERR_NONE) {}
+
+    Params params;
+    std::vector<VPPOutConfigs> vppOutConfigs;
+    std::string decOutFileName;
+
+    mfxSession session;
+    FILE *source;
+    FILE *sinkDec;
+    std::vector<FILE *> sinkVPP;
+    AsyncWriter *writer;
+    std::thread thread;
+
+    mfxU32 framenum;
+    double seconds;
+    mfxStatus sts;
+};
+
+// With several inputs each stream writes its own files, "out.raw" becomes "out_<stream>.raw"
+std::string StreamFileName(const char *name, mfxU16 stream, mfxU16 numStreams) {
+    std::string fileName(name);
+    if (numStreams < 2)
+        return fileName;
+
+    size_t dirEnd = fileName.find_last_of("/\\");
+    size_t extPos = fileName.find_last_of('.');
+    if (extPos == std::string::npos || (dirEnd != std::string::npos && extPos < dirEnd))
+        extPos = fileName.size();
+    return fileName.insert(extPos, "_" + std::to_string(stream));
+}
 
-    // Convenience function to initialize available accelerator(s)
-    sts = InitAcceleratorHandle(session, &accel_fd);
-    VERIFY(MFX_ERR_NONE == sts, "ERROR - Not able to create hw device");
+// Decodes one input with the fused decode and VPP of its session, runs on the thread of the stream
+void RunStream(DecVPPStream *stream) {
+    bool isDraining              = false;
+    bool isStillGoing            = true;
+    Params *params               = &stream->params;
+    mfxBitstream bitstream       = {};
+    mfxSession session           = stream->session;
+    mfxStatus sts                = MFX_ERR_NONE;
+    mfxSurfaceArray *outSurfaces = nullptr;
+    mfxVideoParam mfxDecParams   = {};
+    mfxFrameSurface1 *aSurf      = nullptr;
+    std::vector<mfxVideoChannelParam> vppChParams;
+    std::vector<mfxVideoChannelParam *> mfxVPPChParams;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
     // Prepare input bitstream and start decoding
     bitstream.MaxLength = BITSTREAM_BUFFER_SIZE;
     bitstream.Data      = reinterpret_cast<mfxU8 *>(calloc(bitstream.MaxLength, sizeof(mfxU8)));
     VERIFY(bitstream.Data, "ERROR - Not able to allocate input buffer");
-    bitstream.CodecId = cliParams.inCodec;
+    bitstream.CodecId = params->inCodec;
 
     //Pre-parse input stream
-    sts = ReadEncodedStream(bitstream, source);
+    sts = ReadEncodedStream(bitstream, stream->source);
     VERIFY(MFX_ERR_NONE == sts, "ERROR - Reading bitstream\n");
 
-    mfxDecParams.mfx.CodecId = cliParams.inCodec;
-    mfxDecParams.IOPattern   = (cliParams.bUseVideoMemory) ? MFX_IOPATTERN_OUT_VIDEO_MEMORY
-                                                         : MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+    mfxDecParams.mfx.CodecId = params->inCodec;
+    mfxDecParams.IOPattern   = (params->bUseVideoMemory) ? MFX_IOPATTERN_OUT_VIDEO_MEMORY
+                                                       : MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
     sts = MFXVideoDECODE_DecodeHeader(session, &bitstream, &mfxDecParams);
     VERIFY(MFX_ERR_NONE == sts, "ERROR - Decoding header\n");
 
@@ -158,13 +202,14 @@ int main(int argc, char *argv[]) {
             break;
         default:
             printf("Unsupported color format\n");
+            sts = MFX_ERR_UNSUPPORTED;
             goto end;
             break;
     }
 
-    cliParams.srcFourCC = mfxDecParams.mfx.FrameInfo.FourCC;
-    cliParams.srcWidth  = mfxDecParams.mfx.FrameInfo.CropW;
-    cliParams.srcHeight = mfxDecParams.mfx.FrameInfo.CropH;
+    params->srcFourCC = mfxDecParams.mfx.FrameInfo.FourCC;
+    params->srcWidth  = mfxDecParams.mfx.FrameInfo.CropW;
+    params->srcHeight = mfxDecParams.mfx.FrameInfo.CropH;
 
     // Workaround. For some bitstreams, DecoderHeader can't obtain FrameRate from the header
     // but VPP requires it to be non zero.
@@ -175,39 +220,36 @@ int main(int argc, char *argv[]) {
         mfxDecParams.mfx.FrameInfo.FrameRateExtD = 1;
     }
 
-    mfxVPPChParams = new mfxVideoChannelParam *[cliParams.vppNum];
-    for (mfxU16 i = 0; i < cliParams.vppNum; i++) {
-        mfxVPPChParams[i] = new mfxVideoChannelParam;
-        memset(mfxVPPChParams[i], 0, sizeof(mfxVideoChannelParam));
-
-        // scaled output to 320x240
-        mfxVPPChParams[i]->VPP.FourCC        = cliParams.vppOutConfigs[i].fourcc;
-        mfxVPPChParams[i]->VPP.ChromaFormat  = MFX_CHROMAFORMAT_YUV420;
-        mfxVPPChParams[i]->VPP.PicStruct     = MFX_PICSTRUCT_PROGRESSIVE;
-        mfxVPPChParams[i]->VPP.FrameRateExtN = mfxDecParams.mfx.FrameInfo.FrameRateExtN;
-        mfxVPPChParams[i]->VPP.FrameRateExtD = mfxDecParams.mfx.FrameInfo.FrameRateExtD;
-        mfxVPPChParams[i]->VPP.CropW         = cliParams.vppOutConfigs[i].w;
-        mfxVPPChParams[i]->VPP.CropH         = cliParams.vppOutConfigs[i].h;
-        mfxVPPChParams[i]->VPP.Width         = ALIGN16(mfxVPPChParams[i]->VPP.CropW);
-        mfxVPPChParams[i]->VPP.Height        = ALIGN16(mfxVPPChParams[i]->VPP.CropH);
-        mfxVPPChParams[i]->VPP.ChannelId     = i + 1;
-        mfxVPPChParams[i]->Protected         = 0;
-        if (cliParams.bUseVideoMemory) {
-            mfxVPPChParams[i]->IOPattern =
-                MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+    vppChParams.resize(params->vppNum, mfxVideoChannelParam{});
+    for (mfxU16 i = 0; i < params->vppNum; i++) {
+        mfxVideoChannelParam *chParams = &vppChParams[i];
+
+        chParams->VPP.FourCC        = params->vppOutConfigs[i].fourcc;
+        chParams->VPP.ChromaFormat  = MFX_CHROMAFORMAT_YUV420;
+        chParams->VPP.PicStruct     = MFX_PICSTRUCT_PROGRESSIVE;
+        chParams->VPP.FrameRateExtN = mfxDecParams.mfx.FrameInfo.FrameRateExtN;
+        chParams->VPP.FrameRateExtD = mfxDecParams.mfx.FrameInfo.FrameRateExtD;
+        chParams->VPP.CropW         = params->vppOutConfigs[i].w;
+        chParams->VPP.CropH         = params->vppOutConfigs[i].h;
+        chParams->VPP.Width         = ALIGN16(chParams->VPP.CropW);
+        chParams->VPP.Height        = ALIGN16(chParams->VPP.CropH);
+        chParams->VPP.ChannelId     = i + 1;
+        chParams->Protected         = 0;
+        if (params->bUseVideoMemory) {
+            chParams->IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
         }
         else {
-            mfxVPPChParams[i]->IOPattern =
-                MFX_IOPATTERN_IN_SYSTEM_MEMORY | MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+            chParams->IOPattern = MFX_IOPATTERN_IN_SYSTEM_MEMORY | MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
         }
-        mfxVPPChParams[i]->ExtParam    = NULL;
-        mfxVPPChParams[i]->NumExtParam = 0;
+        chParams->ExtParam    = NULL;
+        chParams->NumExtParam = 0;
+        mfxVPPChParams.push_back(chParams);
     }
 
-    sts = MFXVideoDECODE_VPP_Init(session, &mfxDecParams, mfxVPPChParams, cliParams.vppNum);
+    sts = MFXVideoDECODE_VPP_Init(session, &mfxDecParams, mfxVPPChParams.data(), params->vppNum);
     VERIFY(MFX_ERR_NONE == sts, "ERROR - Initializing decodevpp\n");
 
-    printf("Start decoding and VPP ..\n");
+    stream->writer->Start();
 
     // output frames will be delivered in outSurfaces->Surfaces[]
     // outSurfaces->Surfaces[0]    : decode output
@@ -215,7 +257,7 @@ int main(int argc, char *argv[]) {
     while (isStillGoing == true) {
         // Load encoded stream if not draining
         if (isDraining == false) {
-            sts = ReadEncodedStream(bitstream, source);
+            sts = ReadEncodedStream(bitstream, stream->source);
             if (sts != MFX_ERR_NONE)
                 isDraining = true;
         }
@@ -231,37 +273,26 @@ int main(int argc, char *argv[]) {
                 // decode output
                 if (outSurfaces == nullptr) {
                     printf("ERROR -empty array of surfaces.\n");
+                    sts          = MFX_ERR_NULL_PTR;
                     isStillGoing = false;
                     continue;
                 }
 
+                // the writer synchronizes, writes and releases the surfaces
                 for (mfxU32 i = 0; i < outSurfaces->NumSurfaces; i++) {
+                    FILE *sink = NULL;
+
                     aSurf = outSurfaces->Surfaces[i];
+                    if (aSurf->Info.ChannelId == 0) // decoder output
+                        sink = stream->sinkDec;
+                    else if (aSurf->Info.ChannelId <= stream->sinkVPP.size()) // VPP filter output
+                        sink = stream->sinkVPP[aSurf->Info.ChannelId - 1];
 
-                    sts = aSurf->FrameInterface->Synchronize(aSurf, SYNC_TIMEOUT);
-                    VERIFY(MFX_ERR_NONE == sts, "ERROR - FrameInterface->Synchronizee failed");
-
-                    if (aSurf->Info.ChannelId == 0) { // decoder output
-                        if (cliParams.decOutFileName) {
-                            sts = WriteRawFrame_InternalMem(aSurf, sinkDec);
-                            VERIFY(MFX_ERR_NONE == sts, "ERROR - Could not write decode output");
-                        }
-                    }
-                    else { // VPP filter output
-                        if (cliParams.bIsAvailableVPPOutFileName && sinkVPP) {
-                            if (aSurf->Info.ChannelId <= cliParams.vppNum) {
-                                sts = WriteRawFrame_InternalMem(aSurf,
-                                                                sinkVPP[aSurf->Info.ChannelId - 1]);
-                                VERIFY(MFX_ERR_NONE == sts, "ERROR - Could not write vpp output");
-                            }
-                        }
-                    }
-
-                    sts = aSurf->FrameInterface->Release(aSurf);
-                    VERIFY(MFX_ERR_NONE == sts, "ERROR - mfxFrameSurfaceInterface->Release failed");
+                    sts = stream->writer->Push(aSurf, sink);
+                    VERIFY(MFX_ERR_NONE == sts, "ERROR - Could not write output");
                 }
 
-                framenum++;
+                stream->framenum++;
                 sts = outSurfaces->Release(outSurfaces);
                 VERIFY(MFX_ERR_NONE == sts, "ERROR - mfxSurfaceArray->Release failed");
 
@@ -310,41 +341,223 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (sts == MFX_ERR_NONE) {
-        printf("Decode and VPP processed %d frames\n", framenum);
-        DisplayDecVPPSummary(&cliParams);
+end:
+    // the surfaces held by the writer are released before the session is closed
+    if (MFX_ERR_NONE != stream->writer->Stop() && MFX_ERR_NONE == sts) {
+        printf("ERROR - Could not write output\n");
+        sts = MFX_ERR_UNKNOWN;
     }
+    stream->seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stream->sts = sts;
 
-end:
+    if (bitstream.Data)
+        free(bitstream.Data);
+}
 
-    // Clean up resources - It is recommended to close components first, before
-    // releasing allocated surfaces, since some surfaces may still be locked by
-    // internal resources.
-    if (mfxVPPChParams) {
-        for (mfxU16 i = 0; i < cliParams.vppNum; i++) {
-            if (mfxVPPChParams[i])
-                delete mfxVPPChParams[i];
-        }
-        delete[] mfxVPPChParams;
+void Usage(void) {
+    printf("\n");
+    printf("   Usage  :  decvpp_tool\n\n");
+    printf("     h265/h264      set codec type to decode\n\n");
+    printf("     -sw/-hw        use software or hardware implementation\n\n");
+    printf("     -i             input file name (video elementary stream)\n");
+    printf("                    repeat to decode several inputs at once, each on its own\n");
+    printf("                    thread and session, the output file names of input <n>\n");
+    printf("                    then get a _<n> suffix (dec.raw -> dec_0.raw, dec_1.raw)\n\n");
+    printf("     -o             decode out file name\n\n");
+    printf("     -vpp_num       number of vpp channels\n\n");
+    printf("     -vpp_params    vpp params for each vpp channel\n");
+    printf("                    support scale/csc\n");
+    printf("                    ',' separator for each vpp channel\n\n");
+    printf("     -vpp_out       file name for each vpp out\n");
+    printf("                    ',' separator for each vpp channel\n\n");
+    printf("     -vmem          use video memory\n\n");
+    printf("   Example: \n");
+    printf(
+        "     decvpp_tool h265 -sw -i cars_320x240.h265 -o dec.raw -vpp_num 2 -vpp_params 128x96_i420,640x480_bgra -vpp_out o1.raw,o2.raw\n");
+    printf("     or\n");
+    printf(
+        "     decvpp_tool h265 -hw -i cars_320x240.h265 -o dec.raw -vpp_num 2 -vpp_params 128x96_nv12,640x480_bgra -vpp_out o1.raw,o2.raw\n\n");
+    printf("     this will generate 1 decode output file and 2 vpp output files\n");
+    printf("     dec.raw : decode output  : 320 x 240,  (-sw: i420, -hw: nv12)\n");
+    printf("     o1.raw  : 1st vpp output : 128 x 96, (-sw: i420, -hw: nv12)\n");
+    printf("     o2.raw  : 2st vpp output : 640 x 480, bgra\n");
+    printf("     or\n");
+    printf(
+        "     decvpp_tool h265 -hw -i a.h265 -i b.h265 -vpp_num 2 -vpp_params 1280x720_nv12,640x360_nv12 -vmem\n\n");
+    printf("     this will decode and scale both inputs concurrently without writing outputs\n");
+
+    return;
+}
+
+int main(int argc, char *argv[]) {
+    mfxU16 numStreams     = 0;
+    int accel_fd          = 0;
+    mfxStatus sts         = MFX_ERR_NONE;
+    mfxU32 framenum       = 0;
+    Params cliParams      = {};
+    void *accelHandle     = NULL;
+    mfxVersion version    = { 0, 1 };
+    DecVPPStream *streams = nullptr;
+    std::chrono::steady_clock::time_point start;
+    double seconds = 0;
+
+    //variables used only in 2.x version
+    mfxConfig cfg      = NULL;
+    mfxLoader loader   = NULL;
+    mfxVariant inCodec = {};
+
+    //Parse command line args to cliParams
+    if (ParseArgsAndValidate(argc, argv, &cliParams, PARAMS_DECVPP) == false) {
+        Usage();
+        delete[] cliParams.vppOutConfigs;
+        return 1; // return 1 as error code
     }
 
-    if (source)
-        fclose(source);
+    if (!cliParams.decOutFileName) {
+        printf(
+            "WARNING - No decode output filename assigned, will skip writing decode output file\n");
+    }
+    if (!cliParams.bIsAvailableVPPOutFileName) {
+        printf("WARNING - No VPP output filename assigned, will skip writing VPP output file\n");
+    }
+
+    // Initialize VPL session for any implementation of decode
+    loader = MFXLoad();
+    VERIFY(NULL != loader, "ERROR - MFXLoad failed -- is implementation in path?");
+
+    cfg = MFXCreateConfig(loader);
+    VERIFY(NULL != cfg, "ERROR - MFXCreateConfig failed")
+
+    // Implementation used must be the type requested from command line
+    sts = MFXSetConfigFilterProperty(cfg,
+                                     reinterpret_cast<const mfxU8 *>("mfxImplDescription.Impl"),
+                                     cliParams.implValue);
+    VERIFY(MFX_ERR_NONE == sts, "ERROR - MFXSetConfigFilterProperty failed for Impl");
+
+    // Implementation must provide a decoder
+    inCodec.Type     = MFX_VARIANT_TYPE_U32;
+    inCodec.Data.U32 = cliParams.inCodec;
+    sts              = MFXSetConfigFilterProperty(
+        cfg,
+        reinterpret_cast<const mfxU8 *>("mfxImplDescription.mfxDecoderDescription.decoder.CodecID"),
+        inCodec);
+    VERIFY(MFX_ERR_NONE == sts, "ERROR - MFXSetConfigFilterProperty failed for decoder CodecID");
+
+    // The streams run on sessions of the same implementation, they are all created from the loader
+    // here, the threads only decode
+    numStreams = cliParams.inNum;
+    streams    = new DecVPPStream[numStreams];
+    for (mfxU16 n = 0; n < numStreams; n++) {
+        DecVPPStream *stream = &streams[n];
+
+        stream->vppOutConfigs.assign(cliParams.vppOutConfigs,
+                                     cliParams.vppOutConfigs + cliParams.vppNum);
+        stream->params               = cliParams;
+        stream->params.vppOutConfigs = stream->vppOutConfigs.data();
+        stream->params.inFileName    = cliParams.inFileNames[n];
+
+        stream->writer = new AsyncWriter(WRITER_QUEUE_FRAMES * (cliParams.vppNum + 1));
+
+        stream->source = fopen(stream->params.inFileName, "rb");
+        VERIFY(stream->source, "ERROR - Could not open input file");
+
+        if (cliParams.decOutFileName) {
+            stream->decOutFileName        = StreamFileName(cliParams.decOutFileName, n, numStreams);
+            stream->params.decOutFileName = stream->decOutFileName.c_str();
+            stream->sinkDec               = fopen(stream->params.decOutFileName, "wb");
+            VERIFY(stream->sinkDec, "ERROR - Could not create decode output file");
+        }
+
+        if (cliParams.bIsAvailableVPPOutFileName) {
+            for (mfxU16 i = 0; i < cliParams.vppNum; i++) {
+                VPPOutConfigs *voc   = &stream->vppOutConfigs[i];
+                std::string fileName = StreamFileName(voc->fileName, n, numStreams);
+                snprintf(voc->fileName, sizeof(voc->fileName), "%s", fileName.c_str());
 
-    if (sinkDec)
-        fclose(sinkDec);
+                stream->sinkVPP.push_back(fopen(voc->fileName, "wb"));
+                VERIFY(stream->sinkVPP[i], "ERROR - Could not create vpp output file");
+            }
+        }
+
+        sts = MFXCreateSession(loader, 0, &stream->session);
+        VERIFY(MFX_ERR_NONE == sts, "ERROR - Not able to create VPL session");
+
+        if (n == 0) {
+            // Print info about implementation loaded
+            version = ShowImplInfo(stream->session);
+            VERIFY(version.Major > 1, "ERROR - Sample requires 2.x API implementation, exiting");
 
-    if (cliParams.bIsAvailableVPPOutFileName && sinkVPP) {
-        for (mfxU16 i = 0; i < cliParams.vppNum; i++) {
-            if (sinkVPP[i])
-                fclose(sinkVPP[i]);
+            // Convenience function to initialize available accelerator(s)
+            sts = InitAcceleratorHandle(stream->session, &accel_fd);
+            VERIFY(MFX_ERR_NONE == sts, "ERROR - Not able to create hw device");
         }
+        else {
+            sts = ShareAcceleratorHandle(streams[0].session, stream->session);
+            VERIFY(MFX_ERR_NONE == sts, "ERROR - Not able to set hw device");
+        }
+    }
 
-        delete[] sinkVPP;
+    printf("Start decoding and VPP of %d input(s) ..\n", numStreams);
+
+    start = std::chrono::steady_clock::now();
+    for (mfxU16 n = 0; n < numStreams; n++)
+        streams[n].thread = std::thread(RunStream, &streams[n]);
+
+    sts = MFX_ERR_NONE;
+    for (mfxU16 n = 0; n < numStreams; n++) {
+        streams[n].thread.join();
+        if (MFX_ERR_NONE != streams[n].sts)
+            sts = streams[n].sts;
+        framenum += streams[n].framenum;
     }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-    if (bitstream.Data)
-        free(bitstream.Data);
+    if (sts == MFX_ERR_NONE) {
+        for (mfxU16 n = 0; n < numStreams; n++) {
+            printf("Decode and VPP processed %d frames of %s in %.2f s (%.1f fps)\n",
+                   streams[n].framenum,
+                   streams[n].params.inFileName,
+                   streams[n].seconds,
+                   streams[n].seconds > 0 ? streams[n].framenum / streams[n].seconds : 0);
+            DisplayDecVPPSummary(&streams[n].params);
+        }
+        if (numStreams > 1) {
+            printf("Decode and VPP processed %d frames of %d inputs in %.2f s (%.1f fps)\n",
+                   framenum,
+                   numStreams,
+                   seconds,
+                   seconds > 0 ? framenum / seconds : 0);
+        }
+    }
+
+end:
+
+    // Clean up resources - It is recommended to close components first, before
+    // releasing allocated surfaces, since some surfaces may still be locked by
+    // internal resources.
+    if (streams) {
+        // the sessions of the other streams use the device of the first one, it's closed last
+        for (int n = numStreams - 1; n >= 0; n--) {
+            DecVPPStream *stream = &streams[n];
+
+            delete stream->writer;
+            if (stream->session) {
+                MFXVideoDECODE_VPP_Close(stream->session);
+                MFXClose(stream->session);
+            }
+
+            if (stream->source)
+                fclose(stream->source);
+            if (stream->sinkDec)
+                fclose(stream->sinkDec);
+            for (FILE *sink : stream->sinkVPP) {
+                if (sink)
+                    fclose(sink);
+            }
+        }
+        delete[] streams;
+    }
 
     FreeAcceleratorHandle(accelHandle, accel_fd);
     accelHandle = NULL;
@@ -77,6 +77,7 @@ const struct {
 
 #define MAX_VPP_NUM   1024
 #define MAX_VPP_PARAM 4096
+#define MAX_INPUT_NUM 64
 
 #define VERIFY(x, y)       \
     if (!(x)) {            \
@@ -130,7 +131,9 @@ typedef struct _Params {
     mfxVariant implValue;
 #endif
 
-    const char *inFileName;
+    const char *inFileName; // first of inFileNames
+    const char *inFileNames[MAX_INPUT_NUM];
+    mfxU16 inNum;
     const char *inModelName;
     const char *decOutFileName;
 
@@ -435,10 +438,17 @@ bool ParseArgsAndValidate(int argc, char *argv[], Params *params, ParamGroup gro
 
         // search for match
         if (IS_ARG_EQ(s, "i")) {
-            params->inFileName = ValidateFileName(argv[idx++]);
-            if (!params->inFileName) {
+            // each -i adds an input decoded on its own thread
+            if (params->inNum == MAX_INPUT_NUM) {
+                printf("ERROR - Number of inputs is over the limit (%d)\n", MAX_INPUT_NUM);
                 return false;
             }
+            params->inFileNames[params->inNum] = ValidateFileName(argv[idx++]);
+            if (!params->inFileNames[params->inNum]) {
+                return false;
+            }
+            params->inFileName = params->inFileNames[0];
+            params->inNum++;
         }
         else if (IS_ARG_EQ(s, "m")) {
             params->inModelName = ValidateFileName(argv[idx++]);
@@ -593,6 +603,20 @@ mfxStatus InitAcceleratorHandle(mfxSession session, int *fd) {
     return sts;
 }
 
+// Sets the device handle of a session to the one of another session, so that all the sessions of
+// the process run on one VA display
+mfxStatus ShareAcceleratorHandle(mfxSession from, mfxSession to) {
+#if defined(__linux)
+    #ifdef LIBVA_SUPPORT
+    mfxHDL va_dpy = NULL;
+    if (MFX_ERR_NONE == MFXVideoCORE_GetHandle(from, MFX_HANDLE_VA_DISPLAY, &va_dpy))
+        return MFXVideoCORE_SetHandle(to, MFX_HANDLE_VA_DISPLAY, va_dpy);
+    #endif
+#endif
+
+    return MFX_ERR_NONE;
+}
+
 void FreeAcceleratorHandle(void *accelHandle, int fd) {
 #if defined(__linux)
     #ifdef LIBVA_SUPPORT
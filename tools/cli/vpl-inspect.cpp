@@ -231,31 +231,466 @@ const char *_print_ProfileType(mfxU32 fourcc, mfxU32 type) {
     return "<unknown codec format>";
 }
 
-int main(int argc, char *argv[]) {
-    mfxLoader loader = MFXLoad();
-    if (loader == NULL) {
-        printf("Error - MFXLoad() returned null - no libraries found\n");
-        return -1;
+// Capability classes printed, selected with -filter
+enum {
+    INSPECT_IMPL = 0x01, // implementation, acceleration mode, pool policy and device descriptions
+    INSPECT_DEC  = 0x02,
+    INSPECT_ENC  = 0x04,
+    INSPECT_VPP  = 0x08,
+    INSPECT_FUNC = 0x10, // MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS, queried on demand
+    INSPECT_EX   = 0x20, // MFX_IMPLCAPS_DEVICE_ID_EXTENDED, queried on demand
+};
+
+struct InspectClass {
+    const char *name;
+    mfxU32 mask;
+};
+
+const InspectClass inspectClasses[] = {
+    { "impl", INSPECT_IMPL },
+    { "dec", INSPECT_DEC },
+    { "enc", INSPECT_ENC },
+    { "vpp", INSPECT_VPP },
+    { "func", INSPECT_FUNC },
+#ifdef ONEVPL_EXPERIMENTAL
+    { "ex", INSPECT_EX },
+#endif
+};
+
+// comma separated list of -filter, 0 if a class is unknown
+mfxU32 _parse_filter(const std::string &list) {
+    mfxU32 mask  = 0;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string name(list, begin, end - begin);
+        mfxU32 classMask = 0;
+        for (const InspectClass &c : inspectClasses) {
+            if (name == c.name)
+                classMask = c.mask;
+        }
+        if (!classMask)
+            return 0;
+
+        mask |= classMask;
+        begin = end + 1;
+    }
+    return mask;
+}
+
+std::string _print_filter(mfxU32 mask) {
+    std::string list;
+    for (const InspectClass &c : inspectClasses) {
+        if (mask & c.mask) {
+            if (!list.empty())
+                list += ',';
+            list += c.name;
+        }
+    }
+    return list;
+}
+
+// Compact JSON written to a string, so that it can be stored in the -cache file as well
+class JsonWriter {
+public:
+    JsonWriter() : m_out(), m_bFirst(true) {}
+
+    void BeginObject(const char *key = nullptr) {
+        Key(key);
+        m_out += '{';
+        m_bFirst = true;
+    }
+    void EndObject() {
+        m_out += '}';
+        m_bFirst = false;
+    }
+    void BeginArray(const char *key = nullptr) {
+        Key(key);
+        m_out += '[';
+        m_bFirst = true;
+    }
+    void EndArray() {
+        m_out += ']';
+        m_bFirst = false;
     }
 
-    bool bPrintImplementedFunctions = false;
-    bool bFullInfo                  = true;
-    bool bPrintExtendedDeviceID     = false;
-    bool bRequireD3D9               = false;
+    void String(const char *key, const char *value) {
+        Key(key);
+        Quote(value ? value : "");
+    }
+    void Number(const char *key, mfxU64 value) {
+        Key(key);
+        m_out += std::to_string(value);
+    }
+    void Version(const char *key, mfxU16 major, mfxU16 minor) {
+        String(key, (std::to_string(major) + "." + std::to_string(minor)).c_str());
+    }
+    void Null(const char *key) {
+        Key(key);
+        m_out += "null";
+    }
+
+    const std::string &GetString() const {
+        return m_out;
+    }
+
+private:
+    void Key(const char *key) {
+        if (!m_bFirst)
+            m_out += ',';
+        m_bFirst = false;
+        if (key) {
+            Quote(key);
+            m_out += ':';
+        }
+    }
+
+    void Quote(const char *str) {
+        m_out += '"';
+        for (const char *c = str; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                m_out += '\\';
+                m_out += *c;
+            }
+            else if ((unsigned char)*c < 0x20) {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", (unsigned char)*c);
+                m_out += escape;
+            }
+            else {
+                m_out += *c;
+            }
+        }
+        m_out += '"';
+    }
+
+    std::string m_out;
+    bool m_bFirst; // no comma before the next value
+};
+
+void _json_Range(JsonWriter &json, const char *key, const mfxRange32U &range) {
+    json.BeginObject(key);
+    json.Number("Min", range.Min);
+    json.Number("Max", range.Max);
+    json.Number("Step", range.Step);
+    json.EndObject();
+}
+
+// decoder and encoder memory descriptions have the same fields
+template <typename T>
+void _json_CodecMemDesc(JsonWriter &json, const T &mem) {
+    json.BeginObject();
+    json.String("MemHandleType", _print_ResourceType(mem.MemHandleType));
+    _json_Range(json, "Width", mem.Width);
+    _json_Range(json, "Height", mem.Height);
+    json.BeginArray("ColorFormats");
+    for (int colorformat = 0; colorformat < mem.NumColorFormats; colorformat++)
+        json.String(nullptr, _print_fourcc(mem.ColorFormats[colorformat]));
+    json.EndArray();
+    json.EndObject();
+}
+
+template <typename T>
+void _json_CodecProfiles(JsonWriter &json, const T &codec) {
+    json.BeginArray("Profiles");
+    for (int profile = 0; profile < codec.NumProfiles; profile++) {
+        json.BeginObject();
+        json.String("Profile", _print_ProfileType(codec.CodecID, codec.Profiles[profile].Profile));
+        json.BeginArray("MemDesc");
+        for (int memtype = 0; memtype < codec.Profiles[profile].NumMemTypes; memtype++)
+            _json_CodecMemDesc(json, codec.Profiles[profile].MemDesc[memtype]);
+        json.EndArray();
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+// JSON object of implementation i with the classes of the mask, the member names are the ones of
+// the API structures
+void _json_Implementation(JsonWriter &json,
+                          mfxLoader loader,
+                          int i,
+                          const mfxImplDescription *idesc,
+                          mfxU32 caps) {
+    json.BeginObject();
+    json.Number("Index", i);
+    json.String("ImplName", idesc->ImplName);
+
+    if (caps & INSPECT_IMPL) {
+        mfxHDL hImplPath = nullptr;
+        if (MFX_ERR_NONE == MFXEnumImplementations(loader, i, MFX_IMPLCAPS_IMPLPATH, &hImplPath)) {
+            if (hImplPath) {
+                json.String("LibraryPath", reinterpret_cast<mfxChar *>(hImplPath));
+                MFXDispReleaseImplDescription(loader, hImplPath);
+            }
+        }
+
+        json.String("AccelerationMode", _print_AccelMode(idesc->AccelerationMode));
+        json.Version("ApiVersion", idesc->ApiVersion.Major, idesc->ApiVersion.Minor);
+        json.String("Impl", _print_Impl(idesc->Impl));
+        json.Number("VendorImplID", idesc->VendorImplID);
+        json.String("License", idesc->License);
+        json.Version("Version", idesc->Version.Major, idesc->Version.Minor);
+        json.String("Keywords", idesc->Keywords);
+        json.Number("VendorID", idesc->VendorID);
+        json.Number("NumExtParam", idesc->NumExtParam);
+
+        const mfxAccelerationModeDescription *accel = &idesc->AccelerationModeDescription;
+        json.BeginObject("AccelerationModeDescription");
+        json.Version("Version", accel->Version.Major, accel->Version.Minor);
+        json.BeginArray("Mode");
+        for (int mode = 0; mode < accel->NumAccelerationModes; mode++)
+            json.String(nullptr, _print_AccelMode(accel->Mode[mode]));
+        json.EndArray();
+        json.EndObject();
+
+        if (idesc->Version.Version >= MFX_STRUCT_VERSION(1, 2)) {
+            const mfxPoolPolicyDescription *poolPolicies = &idesc->PoolPolicies;
+            json.BeginObject("PoolPolicies");
+            json.Version("Version", poolPolicies->Version.Major, poolPolicies->Version.Minor);
+            json.BeginArray("Policy");
+            for (int policy = 0; policy < poolPolicies->NumPoolPolicies; policy++)
+                json.String(nullptr, _print_PoolPolicy(poolPolicies->Policy[policy]));
+            json.EndArray();
+            json.EndObject();
+        }
+
+        const mfxDeviceDescription *dev = &idesc->Dev;
+        json.BeginObject("Dev");
+        json.Version("Version", dev->Version.Major, dev->Version.Minor);
+        if (dev->Version.Version >= MFX_STRUCT_VERSION(1, 1)) {
+            json.String("MediaAdapterType",
+                        _print_MediaAdapterType((mfxMediaAdapterType)dev->MediaAdapterType));
+        }
+        json.String("DeviceID", dev->DeviceID);
+        json.BeginArray("SubDevices");
+        for (int subdevice = 0; subdevice < dev->NumSubDevices; subdevice++) {
+            json.BeginObject();
+            json.Number("Index", dev->SubDevices[subdevice].Index);
+            json.String("SubDeviceID", dev->SubDevices[subdevice].SubDeviceID);
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+    }
+
+    if (caps & INSPECT_DEC) {
+        const mfxDecoderDescription *dec = &idesc->Dec;
+        json.BeginObject("Dec");
+        json.Version("Version", dec->Version.Major, dec->Version.Minor);
+        json.BeginArray("Codecs");
+        for (int codec = 0; codec < dec->NumCodecs; codec++) {
+            json.BeginObject();
+            json.String("CodecID", _print_fourcc(dec->Codecs[codec].CodecID));
+            json.Number("MaxcodecLevel", dec->Codecs[codec].MaxcodecLevel);
+            _json_CodecProfiles(json, dec->Codecs[codec]);
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+    }
+
+    if (caps & INSPECT_ENC) {
+        const mfxEncoderDescription *enc = &idesc->Enc;
+        json.BeginObject("Enc");
+        json.Version("Version", enc->Version.Major, enc->Version.Minor);
+        json.BeginArray("Codecs");
+        for (int codec = 0; codec < enc->NumCodecs; codec++) {
+            json.BeginObject();
+            json.String("CodecID", _print_fourcc(enc->Codecs[codec].CodecID));
+            json.Number("MaxcodecLevel", enc->Codecs[codec].MaxcodecLevel);
+            json.Number("BiDirectionalPrediction", enc->Codecs[codec].BiDirectionalPrediction);
+#ifdef ONEVPL_EXPERIMENTAL
+            // valid from API 2.7, see the text output
+            mfxVersion reqApiVersionReportedStats = {};
+            reqApiVersionReportedStats.Major      = 2;
+            reqApiVersionReportedStats.Minor      = 7;
+            if (idesc->ApiVersion.Version >= reqApiVersionReportedStats.Version) {
+                json.BeginArray("ReportedStats");
+                for (mfxU16 statMask = 1; statMask != 0; statMask <<= 1) {
+                    if (enc->Codecs[codec].ReportedStats & statMask)
+                        json.String(nullptr, _print_EncodeStatsType(statMask));
+                }
+                json.EndArray();
+            }
+#endif
+            _json_CodecProfiles(json, enc->Codecs[codec]);
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+    }
+
+    if (caps & INSPECT_VPP) {
+        const mfxVPPDescription *vpp = &idesc->VPP;
+        json.BeginObject("VPP");
+        json.Version("Version", vpp->Version.Major, vpp->Version.Minor);
+        json.BeginArray("Filters");
+        for (int filter = 0; filter < vpp->NumFilters; filter++) {
+            const mfxVPPDescription::filter &f = vpp->Filters[filter];
+            json.BeginObject();
+            json.String("FilterFourCC", _print_fourcc(f.FilterFourCC));
+            json.Number("MaxDelayInFrames", f.MaxDelayInFrames);
+            json.BeginArray("MemDesc");
+            for (int memtype = 0; memtype < f.NumMemTypes; memtype++) {
+                json.BeginObject();
+                json.String("MemHandleType", _print_ResourceType(f.MemDesc[memtype].MemHandleType));
+                _json_Range(json, "Width", f.MemDesc[memtype].Width);
+                _json_Range(json, "Height", f.MemDesc[memtype].Height);
+                json.BeginArray("Formats");
+                for (int informat = 0; informat < f.MemDesc[memtype].NumInFormats; informat++) {
+                    const mfxVPPDescription::filter::memdesc::format &format =
+                        f.MemDesc[memtype].Formats[informat];
+                    json.BeginObject();
+                    json.String("InFormat", _print_fourcc(format.InFormat));
+                    json.BeginArray("OutFormats");
+                    for (int outformat = 0; outformat < format.NumOutFormat; outformat++)
+                        json.String(nullptr, _print_fourcc(format.OutFormats[outformat]));
+                    json.EndArray();
+                    json.EndObject();
+                }
+                json.EndArray();
+                json.EndObject();
+            }
+            json.EndArray();
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+    }
+
+    // null when the implementation doesn't support the query
+    if (caps & INSPECT_FUNC) {
+        mfxImplementedFunctions *fdesc;
+        if (MFX_ERR_NONE == MFXEnumImplementations(loader,
+                                                   i,
+                                                   MFX_IMPLCAPS_IMPLEMENTEDFUNCTIONS,
+                                                   reinterpret_cast<mfxHDL *>(&fdesc))) {
+            json.BeginArray("ImplementedFunctions");
+            for (mfxU16 f = 0; f < fdesc->NumFunctions; f++)
+                json.String(nullptr, fdesc->FunctionsName[f]);
+            json.EndArray();
+            MFXDispReleaseImplDescription(loader, fdesc);
+        }
+        else {
+            json.Null("ImplementedFunctions");
+        }
+    }
+
+#ifdef ONEVPL_EXPERIMENTAL
+    if (caps & INSPECT_EX) {
+        mfxExtendedDeviceId *idescDevice;
+        if (MFX_ERR_NONE == MFXEnumImplementations(loader,
+                                                   i,
+                                                   MFX_IMPLCAPS_DEVICE_ID_EXTENDED,
+                                                   reinterpret_cast<mfxHDL *>(&idescDevice))) {
+            json.BeginObject("ExtendedDeviceId");
+            json.Number("VendorID", idescDevice->VendorID);
+            json.Number("DeviceID", idescDevice->DeviceID);
+            json.Number("PCIDomain", idescDevice->PCIDomain);
+            json.Number("PCIBus", idescDevice->PCIBus);
+            json.Number("PCIDevice", idescDevice->PCIDevice);
+            json.Number("PCIFunction", idescDevice->PCIFunction);
+            if (idescDevice->LUIDValid) {
+                char luid[17];
+                for (mfxU32 idx = 0; idx < 8; idx++)
+                    snprintf(luid + 2 * idx, 3, "%02x", idescDevice->DeviceLUID[7 - idx]);
+                json.String("DeviceLUID", luid);
+                json.Number("LUIDDeviceNodeMask", idescDevice->LUIDDeviceNodeMask);
+            }
+            json.Number("LUIDValid", idescDevice->LUIDValid);
+            json.Number("DRMRenderNodeNum", idescDevice->DRMRenderNodeNum);
+            json.Number("DRMPrimaryNodeNum", idescDevice->DRMPrimaryNodeNum);
+            json.String("DeviceName", idescDevice->DeviceName);
+            json.EndObject();
+            MFXDispReleaseImplDescription(loader, idescDevice);
+        }
+        else {
+            json.Null("ExtendedDeviceId");
+        }
+    }
+#endif
+
+    json.EndObject();
+}
+
+// The -cache file holds the JSON output, it's only reused for the same -filter, the classes are
+// the first member of the object
+std::string _json_CachePrefix(mfxU32 caps) {
+    return "{\"Filter\":\"" + _print_filter(caps) + "\",";
+}
+
+bool _read_cache(const std::string &fileName, mfxU32 caps, std::string &output) {
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if (!f)
+        return false;
+
+    char buf[4096];
+    size_t n;
+    output.clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        output.append(buf, n);
+    fclose(f);
+
+    return output.compare(0, _json_CachePrefix(caps).size(), _json_CachePrefix(caps)) == 0;
+}
+
+// written to a temporary file first, so that a concurrent reader never sees a partial cache
+bool _write_cache(const std::string &fileName, const std::string &output) {
+    std::string tmpName = fileName + ".tmp";
+    FILE *f             = fopen(tmpName.c_str(), "wb");
+    if (!f)
+        return false;
+
+    bool bWritten = (fwrite(output.data(), 1, output.size(), f) == output.size());
+    bWritten      = (fclose(f) == 0) && bWritten;
+    if (bWritten) {
+#if defined(_WIN32) || defined(_WIN64)
+        // rename doesn't replace an existing file on Windows
+        remove(fileName.c_str());
+#endif
+        bWritten = (rename(tmpName.c_str(), fileName.c_str()) == 0);
+    }
+    if (!bWritten)
+        remove(tmpName.c_str());
+    return bWritten;
+}
+
+int main(int argc, char *argv[]) {
+    mfxU32 caps       = INSPECT_IMPL | INSPECT_DEC | INSPECT_ENC | INSPECT_VPP;
+    bool bRequireD3D9 = false;
+    bool bJson        = false;
+    std::string cacheFile;
 
     for (int argIdx = 1; argIdx < argc; argIdx++) {
         std::string nextArg(argv[argIdx]);
 
         if (nextArg == "-f") {
-            bPrintImplementedFunctions = true;
+            caps |= INSPECT_FUNC;
         }
 #ifdef ONEVPL_EXPERIMENTAL
         else if (nextArg == "-ex") {
-            bPrintExtendedDeviceID = true;
+            caps |= INSPECT_EX;
         }
 #endif
         else if (nextArg == "-b") {
-            bFullInfo = false;
+            caps &= ~(INSPECT_DEC | INSPECT_ENC | INSPECT_VPP);
+        }
+        else if (nextArg == "-filter" && argIdx + 1 < argc) {
+            caps = _parse_filter(argv[++argIdx]);
+            if (!caps) {
+                printf("Error - unknown capability class in -filter %s\n", argv[argIdx]);
+                return -1;
+            }
+        }
+        else if (nextArg == "-json") {
+            bJson = true;
+        }
+        else if (nextArg == "-cache" && argIdx + 1 < argc) {
+            cacheFile = argv[++argIdx];
         }
         else if (nextArg == "-d3d9") {
             bRequireD3D9 = true;
@@ -266,8 +701,29 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (!cacheFile.empty()) {
+        if (!bJson) {
+            printf("Error - -cache requires -json\n");
+            return -1;
+        }
+
+        // the D3D9 filter isn't part of the cache key
+        std::string output;
+        if (!bRequireD3D9 && _read_cache(cacheFile, caps, output)) {
+            fputs(output.c_str(), stdout);
+            return 0;
+        }
+    }
+
+    mfxLoader loader = MFXLoad();
+    if (loader == NULL) {
+        printf("Error - MFXLoad() returned null - no libraries found\n");
+        return -1;
+    }
+
     if (bRequireD3D9) {
-        printf("Warning - Enumerating D3D9 implementations ONLY\n");
+        if (!bJson)
+            printf("Warning - Enumerating D3D9 implementations ONLY\n");
         mfxConfig cfg = MFXCreateConfig(loader);
         if (!cfg) {
             printf("Error - MFXCreateConfig() returned null\n");
@@ -291,68 +747,100 @@ int main(int argc, char *argv[]) {
 
     int i = 0;
     mfxImplDescription *idesc;
+
+    if (bJson) {
+        JsonWriter json;
+        json.BeginObject();
+        json.String("Filter", _print_filter(caps).c_str());
+        json.BeginArray("Implementations");
+        while (MFX_ERR_NONE == MFXEnumImplementations(loader,
+                                                      i,
+                                                      MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
+                                                      reinterpret_cast<mfxHDL *>(&idesc))) {
+            _json_Implementation(json, loader, i, idesc, caps);
+            MFXDispReleaseImplDescription(loader, idesc);
+            i++;
+        }
+        json.EndArray();
+        json.EndObject();
+        MFXUnload(loader);
+
+        std::string output = json.GetString() + "\n";
+        fputs(output.c_str(), stdout);
+        if (!cacheFile.empty() && !bRequireD3D9 && !_write_cache(cacheFile, output)) {
+            fprintf(stderr, "Warning - cannot write %s\n", cacheFile.c_str());
+        }
+        return 0;
+    }
+
     while (MFX_ERR_NONE == MFXEnumImplementations(loader,
                                                   i,
                                                   MFX_IMPLCAPS_IMPLDESCSTRUCTURE,
                                                   reinterpret_cast<mfxHDL *>(&idesc))) {
         printf("\nImplementation #%d: %s\n", i, idesc->ImplName);
 
-        // get path if supported (available starting with API 2.4)
-        mfxHDL hImplPath = nullptr;
-        if (MFX_ERR_NONE == MFXEnumImplementations(loader, i, MFX_IMPLCAPS_IMPLPATH, &hImplPath)) {
-            if (hImplPath) {
-                printf("%2sLibrary path: %s\n", "", reinterpret_cast<mfxChar *>(hImplPath));
-                MFXDispReleaseImplDescription(loader, hImplPath);
+        if (caps & INSPECT_IMPL) {
+            // get path if supported (available starting with API 2.4)
+            mfxHDL hImplPath = nullptr;
+            if (MFX_ERR_NONE ==
+                MFXEnumImplementations(loader, i, MFX_IMPLCAPS_IMPLPATH, &hImplPath)) {
+                if (hImplPath) {
+                    printf("%2sLibrary path: %s\n", "", reinterpret_cast<mfxChar *>(hImplPath));
+                    MFXDispReleaseImplDescription(loader, hImplPath);
+                }
             }
-        }
 
-        printf("%2sAccelerationMode: %s\n", "", _print_AccelMode(idesc->AccelerationMode));
-        printf("%2sApiVersion: %hu.%hu\n", "", idesc->ApiVersion.Major, idesc->ApiVersion.Minor);
-        printf("%2sImpl: %s\n", "", _print_Impl(idesc->Impl));
-        printf("%2sVendorImplID: 0x%04X\n", "", idesc->VendorImplID);
-        printf("%2sImplName: %s\n", "", idesc->ImplName);
-        printf("%2sLicense: %s\n", "", idesc->License);
-        printf("%2sVersion: %hu.%hu\n", "", idesc->Version.Major, idesc->Version.Minor);
-        printf("%2sKeywords: %s\n", "", idesc->Keywords);
-        printf("%2sVendorID: 0x%04X\n", "", idesc->VendorID);
-
-        /* mfxAccelerationModeDescription */
-        mfxAccelerationModeDescription *accel = &idesc->AccelerationModeDescription;
-        printf("%2smfxAccelerationModeDescription:\n", "");
-        printf("%4sVersion: %hu.%hu\n", "", accel->Version.Major, accel->Version.Minor);
-        for (int mode = 0; mode < accel->NumAccelerationModes; mode++) {
-            printf("%4sMode: %s\n", "", _print_AccelMode(accel->Mode[mode]));
-        }
-
-        /* mfxPoolPolicyDescription */
-        if (idesc->Version.Version >= MFX_STRUCT_VERSION(1, 2)) {
-            mfxPoolPolicyDescription *poolPolicies = &idesc->PoolPolicies;
-            printf("%2smfxPoolPolicyDescription:\n", "");
-            printf("%4sVersion: %hu.%hu\n",
+            printf("%2sAccelerationMode: %s\n", "", _print_AccelMode(idesc->AccelerationMode));
+            printf("%2sApiVersion: %hu.%hu\n",
                    "",
-                   poolPolicies->Version.Major,
-                   poolPolicies->Version.Minor);
-            for (int policy = 0; policy < poolPolicies->NumPoolPolicies; policy++) {
-                printf("%4sPolicy: %s\n", "", _print_PoolPolicy(poolPolicies->Policy[policy]));
+                   idesc->ApiVersion.Major,
+                   idesc->ApiVersion.Minor);
+            printf("%2sImpl: %s\n", "", _print_Impl(idesc->Impl));
+            printf("%2sVendorImplID: 0x%04X\n", "", idesc->VendorImplID);
+            printf("%2sImplName: %s\n", "", idesc->ImplName);
+            printf("%2sLicense: %s\n", "", idesc->License);
+            printf("%2sVersion: %hu.%hu\n", "", idesc->Version.Major, idesc->Version.Minor);
+            printf("%2sKeywords: %s\n", "", idesc->Keywords);
+            printf("%2sVendorID: 0x%04X\n", "", idesc->VendorID);
+
+            /* mfxAccelerationModeDescription */
+            mfxAccelerationModeDescription *accel = &idesc->AccelerationModeDescription;
+            printf("%2smfxAccelerationModeDescription:\n", "");
+            printf("%4sVersion: %hu.%hu\n", "", accel->Version.Major, accel->Version.Minor);
+            for (int mode = 0; mode < accel->NumAccelerationModes; mode++) {
+                printf("%4sMode: %s\n", "", _print_AccelMode(accel->Mode[mode]));
             }
-        }
 
-        /* mfxDeviceDescription */
-        mfxDeviceDescription *dev = &idesc->Dev;
-        printf("%2smfxDeviceDescription:\n", "");
-        if (dev->Version.Version >= MFX_STRUCT_VERSION(1, 1)) {
-            printf("%4sMediaAdapterType: %s\n",
-                   "",
-                   _print_MediaAdapterType((mfxMediaAdapterType)dev->MediaAdapterType));
-        }
-        printf("%4sDeviceID: %s\n", "", dev->DeviceID);
-        printf("%4sVersion: %hu.%hu\n", "", dev->Version.Major, dev->Version.Minor);
-        for (int subdevice = 0; subdevice < dev->NumSubDevices; subdevice++) {
-            printf("%4sIndex: %u\n", "", dev->SubDevices[subdevice].Index);
-            printf("%4sSubDeviceID: %s\n", "", dev->SubDevices[subdevice].SubDeviceID);
+            /* mfxPoolPolicyDescription */
+            if (idesc->Version.Version >= MFX_STRUCT_VERSION(1, 2)) {
+                mfxPoolPolicyDescription *poolPolicies = &idesc->PoolPolicies;
+                printf("%2smfxPoolPolicyDescription:\n", "");
+                printf("%4sVersion: %hu.%hu\n",
+                       "",
+                       poolPolicies->Version.Major,
+                       poolPolicies->Version.Minor);
+                for (int policy = 0; policy < poolPolicies->NumPoolPolicies; policy++) {
+                    printf("%4sPolicy: %s\n", "", _print_PoolPolicy(poolPolicies->Policy[policy]));
+                }
+            }
+
+            /* mfxDeviceDescription */
+            mfxDeviceDescription *dev = &idesc->Dev;
+            printf("%2smfxDeviceDescription:\n", "");
+            if (dev->Version.Version >= MFX_STRUCT_VERSION(1, 1)) {
+                printf("%4sMediaAdapterType: %s\n",
+                       "",
+                       _print_MediaAdapterType((mfxMediaAdapterType)dev->MediaAdapterType));
+            }
+            printf("%4sDeviceID: %s\n", "", dev->DeviceID);
+            printf("%4sVersion: %hu.%hu\n", "", dev->Version.Major, dev->Version.Minor);
+            for (int subdevice = 0; subdevice < dev->NumSubDevices; subdevice++) {
+                printf("%4sIndex: %u\n", "", dev->SubDevices[subdevice].Index);
+                printf("%4sSubDeviceID: %s\n", "", dev->SubDevices[subdevice].SubDeviceID);
+            }
         }
 
-        if (bFullInfo) {
+        if (caps & INSPECT_DEC) {
             /* mfxDecoderDescription */
             mfxDecoderDescription *dec = &idesc->Dec;
             printf("%2smfxDecoderDescription:\n", "");
@@ -409,7 +897,9 @@ int main(int argc, char *argv[]) {
                     }
                 }
             }
+        }
 
+        if (caps & INSPECT_ENC) {
             /* mfxEncoderDescription */
             mfxEncoderDescription *enc = &idesc->Enc;
             printf("%2smfxEncoderDescription:\n", "");
@@ -492,7 +982,9 @@ int main(int argc, char *argv[]) {
                     }
                 }
             }
+        }
 
+        if (caps & INSPECT_VPP) {
             /* mfxVPPDescription */
             mfxVPPDescription *vpp = &idesc->VPP;
             printf("%2smfxVPPDescription:\n", "");
@@ -550,13 +1042,15 @@ int main(int argc, char *argv[]) {
                     }
                 }
             }
+        }
 
+        if (caps & INSPECT_IMPL) {
             printf("%2sNumExtParam: %d\n", "", idesc->NumExtParam);
         }
 
         MFXDispReleaseImplDescription(loader, idesc);
 
-        if (bPrintImplementedFunctions) {
+        if (caps & INSPECT_FUNC) {
             mfxImplementedFunctions *fdesc;
 
             mfxStatus sts = MFXEnumImplementations(loader,
@@ -581,7 +1075,7 @@ int main(int argc, char *argv[]) {
         }
 
 #ifdef ONEVPL_EXPERIMENTAL
-        if (bPrintExtendedDeviceID) {
+        if (caps & INSPECT_EX) {
             mfxExtendedDeviceId *idescDevice;
 
             mfxStatus sts = MFXEnumImplementations(loader,
@@ -115,6 +115,138 @@ void CTTMetrics_Close();
 */
 cttStatus CTTMetrics_GetValue(unsigned int count, float* out_metric_values);
 
+/*
+    Per device metrics. Unlike CTTMetrics_Init() these functions have no global state, so several
+    devices (like integrated and discrete GPUs) can be sampled at the same time, and every engine
+    instance is reported separately (VCS0, VCS1, VECS0, ...). Only i915 PMU is supported.
+*/
+
+/*
+    Engine classes, values match i915 engine classes
+*/
+typedef enum {
+    CTT_ENGINE_RENDER        = 0, // RCS
+    CTT_ENGINE_COPY          = 1, // BCS
+    CTT_ENGINE_VIDEO         = 2, // VCS, VDBOX
+    CTT_ENGINE_VIDEO_ENHANCE = 3, // VECS, VEBOX
+    CTT_ENGINE_COMPUTE       = 4, // CCS
+    CTT_ENGINE_CLASS_COUNT   = CTT_ENGINE_COMPUTE + 1
+} cttEngineClass;
+
+#define CTT_MAX_ENGINE_INSTANCE_COUNT 8
+#define CTT_MAX_ENGINE_COUNT          (CTT_ENGINE_CLASS_COUNT * CTT_MAX_ENGINE_INSTANCE_COUNT)
+
+typedef struct {
+    cttEngineClass engine_class;
+    unsigned int engine_instance;
+} cttEngine;
+
+typedef struct cttDevice cttDevice;
+
+/*
+    Opens the device and its i915 PMU counters.
+
+    device - Path to the device (like /dev/dri/card* or /dev/dri/renderD*).
+             If NULL, i915 render node device with smallest number is used.
+    out_device - Pointer to the opened device. Must be closed with CTTMetrics_Device_Close().
+*/
+cttStatus CTTMetrics_Device_Open(const char* device, cttDevice** out_device);
+
+/*
+    Closes the device opened with CTTMetrics_Device_Open().
+*/
+void CTTMetrics_Device_Close(cttDevice* device);
+
+/*
+    Returns the number of engine instances available on the device.
+
+    out_count - Pointer to the number of engines.
+*/
+cttStatus CTTMetrics_Device_GetEngineCount(cttDevice* device, unsigned int* out_count);
+
+/*
+    Returns engine instances available on the device, ordered by class and instance.
+
+    count - Number of elements in *out_engines* array.
+    out_engines - Output array of engines. Must be allocated and de-allocated by app.
+*/
+cttStatus CTTMetrics_Device_GetEngineInfo(cttDevice* device,
+                                          unsigned int count,
+                                          cttEngine* out_engines);
+
+/*
+    Samples all devices over the same period, blocks for *in_period* milliseconds.
+    All counters of a device are read with a single syscall.
+
+    num_devices - Number of devices in *devices* array.
+    devices - Input array of opened devices.
+    in_period - Sampling period in milliseconds. Valid range 10..1000.
+*/
+cttStatus CTTMetrics_Device_Sample(unsigned int num_devices,
+                                   cttDevice** devices,
+                                   unsigned int in_period);
+
+/*
+    Returns values of the last CTTMetrics_Device_Sample() call for the device.
+
+    count - Number of elements in *out_engine_values* array.
+    out_engine_values - Output array of engine usages in percents. out_engine_values[i] corresponds
+                        to out_engines[i] in CTTMetrics_Device_GetEngineInfo().
+    out_gt_freq - Pointer to the average GT frequency in MHz, negative if frequency is not
+                  available. May be NULL.
+*/
+cttStatus CTTMetrics_Device_GetValue(cttDevice* device,
+                                     unsigned int count,
+                                     float* out_engine_values,
+                                     float* out_gt_freq);
+
+/*
+    Returns energy consumed by the device in joules. Energy is accumulated from the first reading
+    of the counter, which is taken by CTTMetrics_Device_Open() when the counter is readable.
+    Discrete cards report energy of the card (hwmon), integrated GPU reports energy of the uncore
+    domain (RAPL). Returns CTT_ERR_UNSUPPORTED if the device has no energy counter and
+    CTT_ERR_NO_ROOT_PRIVILEDGES if the counter is readable only by root.
+
+    out_energy - Pointer to the consumed energy in joules.
+*/
+cttStatus CTTMetrics_Device_GetEnergy(cttDevice* device, double* out_energy);
+
+typedef enum {
+    CTT_ENERGY_PACKAGE      = 0, // CPU packages with cores, uncore and integrated GPU
+    CTT_ENERGY_DRAM         = 1, // memory attached to the packages
+    CTT_ENERGY_DOMAIN_COUNT = CTT_ENERGY_DRAM + 1
+} cttEnergyDomain;
+
+#define CTT_MAX_PACKAGE_COUNT 8
+
+typedef struct cttEnergyMeter cttEnergyMeter;
+
+/*
+    Opens RAPL energy counters of the host (/sys/class/powercap/intel-rapl) and takes their first
+    reading. Doesn't need the library or a device to be initialized. Returns CTT_ERR_UNSUPPORTED
+    if the host has no package domain.
+
+    out_meter - Pointer to the opened meter. Must be closed with CTTMetrics_Energy_Close().
+*/
+cttStatus CTTMetrics_Energy_Open(cttEnergyMeter** out_meter);
+
+/*
+    Closes the meter opened with CTTMetrics_Energy_Open().
+*/
+void CTTMetrics_Energy_Close(cttEnergyMeter* meter);
+
+/*
+    Returns energy consumed in the domain by all packages in joules since the first reading.
+    Returns CTT_ERR_UNSUPPORTED if the domain has no counters and CTT_ERR_NO_ROOT_PRIVILEDGES if
+    counters are readable only by root, which is the default of recent kernels.
+
+    domain - Energy domain.
+    out_energy - Pointer to the consumed energy in joules.
+*/
+cttStatus CTTMetrics_Energy_Get(cttEnergyMeter* meter,
+                                cttEnergyDomain domain,
+                                double* out_energy);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -20,6 +20,8 @@
 #define MAX_NUMSAMPLES     1000
 #define DEFAULT_NUMSAMPLES 100
 
+#define MAX_DEVICES 16
+
 volatile sig_atomic_t run = 1;
 
 void signal_handler(int signo) {
@@ -39,7 +41,9 @@ static void usage(const char* appname) {
         "\t[-s <num>]    Number of metric samples to collect during sampling period(valid range %u..%u, default %u).\n"
         "\t[-p <ms>]     Sampling period in milliseconds(valid range %u..%u, default %u).\n"
         "\t[-d <path>]   Path to gfx device (like /dev/dri/card* or /dev/dri/renderD*).\n"
-        "\t              If device is not set, the tool uses i915 render node device with smallest number."
+        "\t              If device is not set, the tool uses i915 render node device with smallest number.\n"
+        "\t[-e]          Report every engine instance (rcs0, vcs0, vcs1, vecs0, ...) separately.\n"
+        "\t              In this mode -d can be repeated up to %u times to monitor several devices."
         "\n",
         appname,
         MIN_NUMSAMPLES,
@@ -47,7 +51,68 @@ static void usage(const char* appname) {
         DEFAULT_NUMSAMPLES,
         MIN_PERIOD_MS,
         MAX_PERIOD_MS,
-        DEFAULT_PERIOD_MS);
+        DEFAULT_PERIOD_MS,
+        MAX_DEVICES);
+}
+
+static int monitor_engines(char** device_paths, unsigned int num_devices, unsigned int period_ms) {
+    static const char* class_names[CTT_ENGINE_CLASS_COUNT] = { "rcs", "bcs", "vcs", "vecs", "ccs" };
+
+    cttDevice* devices[MAX_DEVICES]                      = {};
+    cttEngine engines[MAX_DEVICES][CTT_MAX_ENGINE_COUNT] = {};
+    unsigned int engine_cnt[MAX_DEVICES]                 = {};
+    float engine_values[CTT_MAX_ENGINE_COUNT]            = {};
+    cttStatus status                                     = CTT_ERR_NONE;
+    unsigned int i, j;
+
+    if (!num_devices)
+        device_paths[num_devices++] = NULL; // i915 render node device with smallest number
+
+    for (i = 0; i < num_devices && CTT_ERR_NONE == status; ++i) {
+        status = CTTMetrics_Device_Open(device_paths[i], &devices[i]);
+        if (CTT_ERR_NONE == status)
+            status = CTTMetrics_Device_GetEngineCount(devices[i], &engine_cnt[i]);
+        if (CTT_ERR_NONE == status)
+            status = CTTMetrics_Device_GetEngineInfo(devices[i], engine_cnt[i], engines[i]);
+        if (CTT_ERR_NONE != status)
+            fprintf(stderr,
+                    "ERROR: Failed to open device %s, error code %d\n",
+                    device_paths[i] ? device_paths[i] : "(default)",
+                    (int)status);
+    }
+
+    while (run && CTT_ERR_NONE == status) {
+        status = CTTMetrics_Device_Sample(num_devices, devices, period_ms);
+        if (CTT_ERR_NONE != status) {
+            fprintf(stderr, "ERROR: Failed to sample devices, error code %d\n", (int)status);
+            break;
+        }
+
+        for (i = 0; i < num_devices && CTT_ERR_NONE == status; ++i) {
+            float freq = 0;
+            status =
+                CTTMetrics_Device_GetValue(devices[i], engine_cnt[i], engine_values, &freq);
+            if (CTT_ERR_NONE != status) {
+                fprintf(stderr, "ERROR: Failed to get metrics, error code %d\n", (int)status);
+                break;
+            }
+
+            printf("%s:", device_paths[i] ? device_paths[i] : "default");
+            for (j = 0; j < engine_cnt[i]; ++j)
+                printf("\t%s%u usage: %3.2f",
+                       class_names[engines[i][j].engine_class],
+                       engines[i][j].engine_instance,
+                       engine_values[j]);
+            if (freq >= 0)
+                printf("\tGT Freq: %4.2f", freq);
+            printf("\n");
+        }
+    }
+
+    for (i = 0; i < num_devices; ++i)
+        CTTMetrics_Device_Close(devices[i]);
+
+    return (CTT_ERR_NONE == status) ? 0 : 1;
 }
 
 int main(int argc, char* argv[]) {
@@ -61,14 +126,24 @@ int main(int argc, char* argv[]) {
 
     unsigned int num_samples = DEFAULT_NUMSAMPLES;
     unsigned int period_ms   = DEFAULT_PERIOD_MS;
-    char* device_path        = NULL;
+    char* device_paths[MAX_DEVICES] = {};
+    unsigned int num_devices        = 0;
+    bool per_engine                 = false;
     int ch;
 
     /* Parse options */
-    while ((ch = getopt(argc, argv, "d:s:p:h")) != -1) {
+    while ((ch = getopt(argc, argv, "d:s:p:eh")) != -1) {
         switch (ch) {
             case 'd':
-                device_path = optarg;
+                if (num_devices == MAX_DEVICES) {
+                    fprintf(stderr, "Too many devices, at most %u are supported\n\n", MAX_DEVICES);
+                    usage(argv[0]);
+                    exit(1);
+                }
+                device_paths[num_devices++] = optarg;
+                break;
+            case 'e':
+                per_engine = true;
                 break;
             case 's':
                 num_samples = atoi(optarg);
@@ -97,7 +172,10 @@ int main(int argc, char* argv[]) {
 
     signal(SIGINT, signal_handler);
 
-    status = CTTMetrics_Init(device_path);
+    if (per_engine)
+        return monitor_engines(device_paths, num_devices, period_ms);
+
+    status = CTTMetrics_Init(device_paths[0]);
     if (CTT_ERR_NONE != status) {
         fprintf(stderr,
                 "ERROR: Failed to initialize metrics monitor, error code %d\n",
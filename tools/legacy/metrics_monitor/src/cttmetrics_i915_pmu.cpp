@@ -6,9 +6,11 @@
 
 #include "cttmetrics_utils.h"
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <i915_drm.h>
+#include <limits.h>
 #include <linux/perf_event.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -171,7 +173,8 @@ struct metrics_group {
 };
 
 struct pmu_metrics {
-    int fd;
+    int fd; /* group leader */
+    int* fds; /* all opened counters including the leader */
     int read_format;
     uint64_t num_metrics;
     uint64_t num_groups;
@@ -204,7 +207,8 @@ static int perf_init(struct i915_pmu_collector_ctx_t* ctx, int num_configs, int
     ctx->pm.fd          = -1;
     ctx->pm.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_GROUP;
     ctx->pm.groups      = (struct metrics_group*)calloc(num_configs, sizeof(struct metrics_group));
-    if (!ctx->pm.groups)
+    ctx->pm.fds         = (int*)calloc(num_configs, sizeof(int));
+    if (!ctx->pm.groups || !ctx->pm.fds)
         return -1;
 
     if (!num_configs)
@@ -225,7 +229,9 @@ static int perf_init(struct i915_pmu_collector_ctx_t* ctx, int num_configs, int
 
         int config_id = is_engine_config(configs[i]) ? get_engine_id(configs[i]) : configs[i];
         if (prev_config_id != config_id) {
-            ctx->pm.num_groups++;
+            /* group stays in place if none of its counters was opened */
+            if (ctx->pm.groups[ctx->pm.num_groups].num_metrics)
+                ctx->pm.num_groups++;
             prev_config_id = config_id;
         }
 
@@ -234,6 +240,7 @@ static int perf_init(struct i915_pmu_collector_ctx_t* ctx, int num_configs, int
         else
             res = perf_i915_open(ctx->gem_fd, configs[i], ctx->pm.fd, ctx->pm.read_format);
         if (res >= 0) {
+            ctx->pm.fds[ctx->pm.num_metrics] = res;
             if (is_engine_config(configs[i])) {
                 int sample_type = I915_PMU_SAMPLE_MASK & configs[i];
                 if (sample_type >= I915_ENGINE_SAMPLE_COUNT) {
@@ -252,17 +259,21 @@ static int perf_init(struct i915_pmu_collector_ctx_t* ctx, int num_configs, int
         }
     }
 
-    if (res >= 0)
+    if (ctx->pm.groups[ctx->pm.num_groups].num_metrics)
         ctx->pm.num_groups++; /* For last config in the list */
 
     return 0;
 }
 
 static void perf_close(struct pmu_metrics* pm) {
-    if (pm->fd != -1) {
-        close(pm->fd);
-        pm->fd = -1;
+    /* group members are not closed with the leader */
+    if (pm->fds) {
+        for (uint64_t i = 0; i < pm->num_metrics; ++i)
+            close(pm->fds[i]);
+        free(pm->fds);
+        pm->fds = NULL;
     }
+    pm->fd = -1;
     if (pm->groups) {
         free(pm->groups);
         pm->groups = NULL;
@@ -317,6 +328,47 @@ static uint64_t perf_elapsed_time(struct metric* m) {
     return m->end.time - m->start.time;
 }
 
+/* Returns engine usage in % or frequency in MHz for the last sampling period */
+static double perf_group_value(struct metrics_group* group, bool is_freq) {
+    double value = perf_elapsed(&group->metrics[I915_SAMPLE_BUSY]);
+    double time  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_BUSY]);
+
+    double value_sema = 0, value_wait = 0;
+    double time_sema = 0, time_wait = 0;
+    bool is_sema_and_wait_available =
+        is_engine_config(group->metrics[I915_SAMPLE_BUSY].config) && (3 == group->num_metrics);
+
+    if (is_sema_and_wait_available) {
+        value_sema = perf_elapsed(&group->metrics[I915_SAMPLE_SEMA]);
+        time_sema  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_SEMA]);
+
+        value_wait = perf_elapsed(&group->metrics[I915_SAMPLE_WAIT]);
+        time_wait  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_WAIT]);
+    }
+
+    if (is_freq) {
+        value *= 1000000000; // to compensate time in ns
+    }
+    else {
+        value *= 100; // we need %
+        value_sema *= 100;
+        value_wait *= 100;
+    }
+
+    value /= time;
+    if (is_sema_and_wait_available) {
+        value_sema /= time_sema;
+        value_wait /= time_wait;
+        // due to sampling nature of sema counter, very frequently we get (sema value) > (busy value)
+        // and there is no other decisions besides of clamping sema to busy
+        value_sema = (value_sema > value) ? value : value_sema;
+
+        value -= value_sema + value_wait; // Substract sema and wait from busy metric
+    }
+
+    return value;
+}
+
 static i915_pmu_collector_ctx_t g_ctx = {
     .initialized = false,
 };
@@ -507,7 +559,6 @@ extern "C" cttStatus CTTMetrics_PMU_GetValue(unsigned int count, float* out_metr
 
     unsigned int metric_idx, pm_metric_idx;
     double value;
-    double time;
 
     if (g_ctx.pm.num_groups && 0 != perf_read(&g_ctx.pm))
         return CTT_ERR_DRIVER_NO_INSTRUMENTATION;
@@ -526,49 +577,389 @@ extern "C" cttStatus CTTMetrics_PMU_GetValue(unsigned int count, float* out_metr
             pm_metric_idx = g_ctx.pm_idx_map[metric_idx];
             group         = &g_ctx.pm.groups[pm_metric_idx];
 
-            value = perf_elapsed(&group->metrics[I915_SAMPLE_BUSY]);
-            time  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_BUSY]);
+            value = perf_group_value(group, g_ctx.metrics[metric_idx] == CTT_AVG_GT_FREQ);
+        }
+        else {
+            value = 0.0; // not subscribed/unavailable metrics are always idle
+        }
+
+        out_metric_values[i] = value;
+    }
+
+    return CTT_ERR_NONE;
+}
 
-            double value_sema = 0, value_wait = 0;
-            double time_sema = 0, time_wait = 0;
-            bool is_sema_and_wait_available =
-                is_engine_config(group->metrics[I915_SAMPLE_BUSY].config) &&
-                (3 == group->num_metrics);
+/* sysfs energy counter in microjoules, empty path if there is no counter */
+struct energy_counter {
+    char path[PATH_MAX];
+    uint64_t range; /* counter wraps around at this value, 0 if it doesn't wrap */
+    uint64_t last;
+    uint64_t total;
+    bool read;
+};
 
-            if (is_sema_and_wait_available) {
-                value_sema = perf_elapsed(&group->metrics[I915_SAMPLE_SEMA]);
-                time_sema  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_SEMA]);
+struct cttDevice {
+    i915_pmu_collector_ctx_t ctx;
+    bool sampled;
 
-                value_wait = perf_elapsed(&group->metrics[I915_SAMPLE_WAIT]);
-                time_wait  = (double)perf_elapsed_time(&group->metrics[I915_SAMPLE_WAIT]);
-            }
+    /* pm.groups[i] holds counters of engines[i], frequency group goes after the engines */
+    unsigned int engines_count;
+    cttEngine engines[CTT_MAX_ENGINE_COUNT];
+    bool has_freq;
 
-            if (g_ctx.metrics[metric_idx] == CTT_AVG_GT_FREQ) {
-                value *= 1000000000; // to compensate time in ns
-            }
-            else {
-                value *= 100; // we need %
-                value_sema *= 100;
-                value_wait *= 100;
-            }
+    energy_counter energy;
+};
 
-            value /= time;
-            if (is_sema_and_wait_available) {
-                value_sema /= time_sema;
-                value_wait /= time_wait;
-                // due to sampling nature of sema counter, very frequently we get (sema value) > (busy value)
-                // and there is no other decisions besides of clamping sema to busy
-                value_sema = (value_sema > value) ? value : value_sema;
+static int read_sysfs(const char* path, char* buf, size_t buflen) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
 
-                value -= value_sema + value_wait; // Substract sema and wait from busy metric
-            }
+    ssize_t ret = read(fd, buf, buflen - 1);
+    int err     = errno;
+    close(fd);
+    if (ret < 0)
+        return -err;
+
+    buf[ret] = '\0';
+    return 0;
+}
+
+static int read_sysfs_u64(const char* path, uint64_t* value) {
+    char buf[32];
+    int ret = read_sysfs(path, buf, sizeof(buf));
+    if (ret)
+        return ret;
+
+    char* end = NULL;
+    *value    = strtoull(buf, &end, 10);
+    return end != buf ? 0 : -EINVAL;
+}
+
+/* takes the first reading, counter reading fails later if it isn't readable by the user */
+static void energy_init(energy_counter* counter, const char* dir_path) {
+    char range_path[PATH_MAX];
+    snprintf(counter->path, sizeof(counter->path), "%s/energy_uj", dir_path);
+    snprintf(range_path, sizeof(range_path), "%s/max_energy_range_uj", dir_path);
+    if (read_sysfs_u64(range_path, &counter->range))
+        counter->range = 0;
+    counter->read = (0 == read_sysfs_u64(counter->path, &counter->last));
+}
+
+/* accumulates the counter with wraparound */
+static int energy_read(energy_counter* counter) {
+    uint64_t value = 0;
+    int ret        = read_sysfs_u64(counter->path, &value);
+    if (ret)
+        return ret;
+
+    if (counter->read) {
+        counter->total += (value >= counter->last) ? value - counter->last
+                                                   : value + counter->range - counter->last;
+    }
+    counter->last = value;
+    counter->read = true;
+    return 0;
+}
+
+static cttStatus energy_status(int ret) {
+    if (-EACCES == ret || -EPERM == ret)
+        return CTT_ERR_NO_ROOT_PRIVILEDGES;
+    return ret ? CTT_ERR_NO_DATA : CTT_ERR_NONE;
+}
+
+static void energy_find(cttDevice* dev) {
+    char dir_path[PATH_MAX / 2]; /* leaves room for the hwmon entry in the counter path */
+    struct stat st = {};
+    if (fstat(dev->ctx.gem_fd, &st) || !S_ISCHR(st.st_mode))
+        return;
+
+    /* discrete cards have hwmon of the PCI device */
+    snprintf(dir_path,
+             sizeof(dir_path),
+             "/sys/dev/char/%d:%d/device/hwmon",
+             major(st.st_rdev),
+             minor(st.st_rdev));
+    DIR* dir = opendir(dir_path);
+    if (dir) {
+        struct dirent* entry = NULL;
+        while (!dev->energy.path[0] && (entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "hwmon", strlen("hwmon")))
+                continue;
+
+            snprintf(dev->energy.path,
+                     sizeof(dev->energy.path),
+                     "%s/%s/energy1_input",
+                     dir_path,
+                     entry->d_name);
+            if (access(dev->energy.path, F_OK))
+                dev->energy.path[0] = '\0';
         }
-        else {
-            value = 0.0; // not subscribed/unavailable metrics are always idle
+        closedir(dir);
+        if (dev->energy.path[0])
+            dev->energy.read = (0 == read_sysfs_u64(dev->energy.path, &dev->energy.last));
+    }
+
+    /* integrated GPU is the uncore domain of the package RAPL */
+    char address[PATH_MAX];
+    if (!dev->energy.path[0] && bus_address(dev->ctx.gem_fd, address, sizeof(address)) &&
+        strcmp(address, "0000:00:02.0") == 0) {
+        for (int i = 0; i < 8 && !dev->energy.path[0]; ++i) {
+            char name[32];
+            snprintf(dir_path, sizeof(dir_path), "/sys/class/powercap/intel-rapl:0:%d/name", i);
+            if (read_sysfs(dir_path, name, sizeof(name)) || strncmp(name, "uncore", 6))
+                continue;
+
+            snprintf(dir_path, sizeof(dir_path), "/sys/class/powercap/intel-rapl:0:%d", i);
+            energy_init(&dev->energy, dir_path);
         }
+    }
+}
 
-        out_metric_values[i] = value;
+static bool perf_i915_probe(int gem_fd, int config) {
+    int fd = perf_i915_open(gem_fd, config, -1, PERF_FORMAT_TOTAL_TIME_ENABLED);
+    if (fd < 0)
+        return false;
+    close(fd);
+    return true;
+}
+
+extern "C" cttStatus CTTMetrics_Device_Open(const char* device, cttDevice** out_device) {
+    if (!out_device)
+        return CTT_ERR_NULL_PTR;
+
+    cttDevice* dev = (cttDevice*)calloc(1, sizeof(cttDevice));
+    if (!dev)
+        return CTT_ERR_UNKNOWN;
+
+    dev->ctx.pm.fd = -1;
+
+    dev->ctx.gem_fd =
+        device ? open(device, O_RDWR) : drmOpenWithType("i915", NULL, DRM_NODE_RENDER);
+    if (dev->ctx.gem_fd < 0) {
+        free(dev);
+        return CTT_ERR_DRIVER_NOT_FOUND;
+    }
+    dev->ctx.has_semaphores = has_param(dev->ctx.gem_fd, I915_PARAM_HAS_SEMAPHORES);
+    dev->ctx.has_preemption = has_param(dev->ctx.gem_fd, I915_SCHEDULER_CAP_PREEMPTION);
+
+    /* Instances may be fused off, so every instance is probed instead of stopping at the first
+     * missing one. Only engines with BUSY counter go to the group, so perf_init() keeps one
+     * group per engine in the probing order. */
+    int configs[CTT_MAX_ENGINE_COUNT * I915_ENGINE_SAMPLE_COUNT + 1];
+    int num_configs = 0;
+    for (int engine_class = 0; engine_class < CTT_ENGINE_CLASS_COUNT; ++engine_class) {
+        for (int instance = 0; instance < CTT_MAX_ENGINE_INSTANCE_COUNT; ++instance) {
+            if (!perf_i915_probe(dev->ctx.gem_fd, I915_PMU_ENGINE_BUSY(engine_class, instance)))
+                continue;
+
+            cttEngine* engine       = &dev->engines[dev->engines_count++];
+            engine->engine_class    = (cttEngineClass)engine_class;
+            engine->engine_instance = instance;
+
+            configs[num_configs++] = I915_PMU_ENGINE_BUSY(engine_class, instance);
+            configs[num_configs++] = I915_PMU_ENGINE_WAIT(engine_class, instance);
+            configs[num_configs++] = I915_PMU_ENGINE_SEMA(engine_class, instance);
+        }
+    }
+    dev->has_freq = perf_i915_probe(dev->ctx.gem_fd, I915_PMU_ACTUAL_FREQUENCY);
+    if (dev->has_freq)
+        configs[num_configs++] = I915_PMU_ACTUAL_FREQUENCY;
+
+    if (!num_configs || 0 != perf_init(&dev->ctx, num_configs, configs) ||
+        dev->ctx.pm.num_groups != dev->engines_count + (dev->has_freq ? 1 : 0)) {
+        CTTMetrics_Device_Close(dev);
+        return CTT_ERR_DRIVER_NO_INSTRUMENTATION;
+    }
+
+    energy_find(dev);
+
+    *out_device = dev;
+    return CTT_ERR_NONE;
+}
+
+extern "C" void CTTMetrics_Device_Close(cttDevice* device) {
+    if (!device)
+        return;
+
+    perf_close(&device->ctx.pm);
+    if (device->ctx.gem_fd != -1)
+        close(device->ctx.gem_fd);
+    free(device);
+}
+
+extern "C" cttStatus CTTMetrics_Device_GetEngineCount(cttDevice* device, unsigned int* out_count) {
+    if (!device || !out_count)
+        return CTT_ERR_NULL_PTR;
+
+    *out_count = device->engines_count;
+    return CTT_ERR_NONE;
+}
+
+extern "C" cttStatus CTTMetrics_Device_GetEngineInfo(cttDevice* device,
+                                                     unsigned int count,
+                                                     cttEngine* out_engines) {
+    if (!device || !out_engines)
+        return CTT_ERR_NULL_PTR;
+
+    if (count > device->engines_count)
+        return CTT_ERR_OUT_OF_RANGE;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        out_engines[i] = device->engines[i];
+    }
+
+    return CTT_ERR_NONE;
+}
+
+extern "C" cttStatus CTTMetrics_Device_Sample(unsigned int num_devices,
+                                              cttDevice** devices,
+                                              unsigned int in_period) {
+    if (!devices)
+        return CTT_ERR_NULL_PTR;
+
+    if (in_period > 1000 || in_period < 10)
+        return CTT_ERR_OUT_OF_RANGE;
+
+    for (unsigned int i = 0; i < num_devices; ++i) {
+        if (!devices[i])
+            return CTT_ERR_NULL_PTR;
+        devices[i]->sampled = false;
+    }
+
+    /* Start and end of the period are taken with one read per device, so all devices and
+     * engines are sampled over the same time window */
+    for (unsigned int i = 0; i < num_devices; ++i) {
+        if (0 != perf_read(&devices[i]->ctx.pm))
+            return CTT_ERR_DRIVER_NO_INSTRUMENTATION;
+    }
+
+    usleep(in_period * 1000);
+
+    for (unsigned int i = 0; i < num_devices; ++i) {
+        if (0 != perf_read(&devices[i]->ctx.pm))
+            return CTT_ERR_DRIVER_NO_INSTRUMENTATION;
+        devices[i]->sampled = true;
+    }
+
+    return CTT_ERR_NONE;
+}
+
+extern "C" cttStatus CTTMetrics_Device_GetValue(cttDevice* device,
+                                                unsigned int count,
+                                                float* out_engine_values,
+                                                float* out_gt_freq) {
+    if (!device || (count && !out_engine_values))
+        return CTT_ERR_NULL_PTR;
+
+    if (count > device->engines_count)
+        return CTT_ERR_OUT_OF_RANGE;
+
+    if (!device->sampled)
+        return CTT_ERR_NO_DATA;
+
+    for (unsigned int i = 0; i < count; ++i) {
+        out_engine_values[i] = perf_group_value(&device->ctx.pm.groups[i], false);
+    }
+
+    if (out_gt_freq) {
+        *out_gt_freq = device->has_freq
+                           ? perf_group_value(&device->ctx.pm.groups[device->engines_count], true)
+                           : -1.0f;
+    }
+
+    return CTT_ERR_NONE;
+}
+
+extern "C" cttStatus CTTMetrics_Device_GetEnergy(cttDevice* device, double* out_energy) {
+    if (!device || !out_energy)
+        return CTT_ERR_NULL_PTR;
+
+    if (!device->energy.path[0])
+        return CTT_ERR_UNSUPPORTED;
+
+    cttStatus sts = energy_status(energy_read(&device->energy));
+    if (CTT_ERR_NONE != sts)
+        return sts;
+
+    *out_energy = device->energy.total / 1000000.0;
+    return CTT_ERR_NONE;
+}
+
+struct cttEnergyMeter {
+    /* counters of the domain in all packages */
+    unsigned int counts[CTT_ENERGY_DOMAIN_COUNT];
+    energy_counter counters[CTT_ENERGY_DOMAIN_COUNT][CTT_MAX_PACKAGE_COUNT];
+};
+
+extern "C" cttStatus CTTMetrics_Energy_Open(cttEnergyMeter** out_meter) {
+    if (!out_meter)
+        return CTT_ERR_NULL_PTR;
+    *out_meter = NULL;
+
+    cttEnergyMeter* meter = (cttEnergyMeter*)calloc(1, sizeof(cttEnergyMeter));
+    if (!meter)
+        return CTT_ERR_UNKNOWN;
+
+    /* intel-rapl:N is the package zone, intel-rapl:N:M are its subzones, psys (platform) zone
+     * has the same layout and is skipped */
+    for (int i = 0; i < CTT_MAX_PACKAGE_COUNT; ++i) {
+        char dir_path[PATH_MAX / 2];
+        char path[PATH_MAX];
+        char name[32];
+        snprintf(dir_path, sizeof(dir_path), "/sys/class/powercap/intel-rapl:%d", i);
+        snprintf(path, sizeof(path), "%s/name", dir_path);
+        if (read_sysfs(path, name, sizeof(name)) || strncmp(name, "package", 7))
+            continue;
+
+        unsigned int& packages = meter->counts[CTT_ENERGY_PACKAGE];
+        energy_init(&meter->counters[CTT_ENERGY_PACKAGE][packages++], dir_path);
+
+        for (int j = 0; j < 8; ++j) {
+            snprintf(path, sizeof(path), "%s/intel-rapl:%d:%d/name", dir_path, i, j);
+            if (read_sysfs(path, name, sizeof(name)) || strncmp(name, "dram", 4))
+                continue;
+
+            snprintf(path, sizeof(path), "%s/intel-rapl:%d:%d", dir_path, i, j);
+            unsigned int& drams = meter->counts[CTT_ENERGY_DRAM];
+            energy_init(&meter->counters[CTT_ENERGY_DRAM][drams++], path);
+            break;
+        }
+    }
+
+    if (!meter->counts[CTT_ENERGY_PACKAGE]) {
+        free(meter);
+        return CTT_ERR_UNSUPPORTED;
+    }
+
+    *out_meter = meter;
+    return CTT_ERR_NONE;
+}
+
+extern "C" void CTTMetrics_Energy_Close(cttEnergyMeter* meter) {
+    free(meter);
+}
+
+extern "C" cttStatus CTTMetrics_Energy_Get(cttEnergyMeter* meter,
+                                           cttEnergyDomain domain,
+                                           double* out_energy) {
+    if (!meter || !out_energy)
+        return CTT_ERR_NULL_PTR;
+
+    if (domain < 0 || domain >= CTT_ENERGY_DOMAIN_COUNT)
+        return CTT_ERR_OUT_OF_RANGE;
+
+    if (!meter->counts[domain])
+        return CTT_ERR_UNSUPPORTED;
+
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < meter->counts[domain]; ++i) {
+        cttStatus sts = energy_status(energy_read(&meter->counters[domain][i]));
+        if (CTT_ERR_NONE != sts)
+            return sts;
+        total += meter->counters[domain][i].total;
     }
 
+    *out_energy = total / 1000000.0;
     return CTT_ERR_NONE;
 }
@@ -4,6 +4,7 @@
   # SPDX-License-Identifier: MIT
   ############################################################################*/
 
+#include <unistd.h>
 #include "cttmetrics.h"
 #include "cttmetrics_utils.h"
 #include "device_info.h"
@@ -310,6 +311,135 @@ TEST(cttMetricsRobustness, setSamplePeriod) {
     }
 }
 
+TEST(cttMetricsRobustness, deviceEngineReport) {
+    // INITIALIZATION
+
+    const float epsilon = 1.0f;
+    const float value   = 0.0f;
+
+    unsigned int engine_cnt  = 0;
+    unsigned int num_repeats = 5;
+
+    cttDevice* device = NULL;
+    cttEngine engines[CTT_MAX_ENGINE_COUNT];
+    float engine_values[CTT_MAX_ENGINE_COUNT];
+    float freq = 0.0f;
+
+    // TEST
+
+    ASSERT_EQ(CTT_ERR_NONE, CTTMetrics_Device_Open(NULL, &device));
+    EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Device_GetEngineCount(device, &engine_cnt));
+    EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Device_GetEngineInfo(device, engine_cnt, engines));
+    EXPECT_EQ(CTT_ERR_OUT_OF_RANGE,
+              CTTMetrics_Device_GetEngineInfo(device, engine_cnt + 1, engines));
+
+    // every i915 device has render engine, engines are ordered by class
+    ASSERT_GT(engine_cnt, 0u);
+    EXPECT_EQ(CTT_ENGINE_RENDER, engines[0].engine_class);
+
+    EXPECT_EQ(CTT_ERR_NO_DATA,
+              CTTMetrics_Device_GetValue(device, engine_cnt, engine_values, &freq));
+    EXPECT_EQ(CTT_ERR_OUT_OF_RANGE, CTTMetrics_Device_Sample(1, &device, 0));
+
+    // device API doesn't interfere with the library state
+    EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Init(NULL));
+
+    for (unsigned int repeat = 0; repeat < num_repeats; repeat++) {
+        EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Device_Sample(1, &device, 100));
+        EXPECT_EQ(CTT_ERR_NONE,
+                  CTTMetrics_Device_GetValue(device, engine_cnt, engine_values, &freq));
+
+        for (unsigned int i = 0; i < engine_cnt; i++) {
+            EXPECT_GE(engine_values[i], value)
+                << "engine_values[" << i << "] : " << engine_values[i];
+            EXPECT_LE(engine_values[i], value + epsilon)
+                << "engine_values[" << i << "] : " << engine_values[i];
+        }
+    }
+
+    CTTMetrics_Close();
+    CTTMetrics_Device_Close(device);
+}
+
+TEST(cttMetricsRobustness, deviceEnergyReport) {
+    // INITIALIZATION
+
+    unsigned int num_repeats = 5;
+
+    cttDevice* device = NULL;
+    double energy      = 0.0;
+    double last_energy = 0.0;
+
+    // TEST
+
+    EXPECT_EQ(CTT_ERR_NULL_PTR, CTTMetrics_Device_GetEnergy(NULL, &energy));
+
+    ASSERT_EQ(CTT_ERR_NONE, CTTMetrics_Device_Open(NULL, &device));
+    EXPECT_EQ(CTT_ERR_NULL_PTR, CTTMetrics_Device_GetEnergy(device, NULL));
+
+    cttStatus sts = CTTMetrics_Device_GetEnergy(device, &last_energy);
+    if (CTT_ERR_UNSUPPORTED == sts || CTT_ERR_NO_ROOT_PRIVILEDGES == sts) {
+        CTTMetrics_Device_Close(device);
+        GTEST_SKIP() << "energy counter is not available, status : " << sts;
+    }
+    ASSERT_EQ(CTT_ERR_NONE, sts);
+    EXPECT_GE(last_energy, 0.0);
+
+    // counter doesn't go back even if it wraps around
+    for (unsigned int repeat = 0; repeat < num_repeats; repeat++) {
+        usleep(100 * 1000);
+        EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Device_GetEnergy(device, &energy));
+        EXPECT_GE(energy, last_energy);
+        last_energy = energy;
+    }
+
+    CTTMetrics_Device_Close(device);
+}
+
+TEST(cttMetricsRobustness, hostEnergyReport) {
+    // INITIALIZATION
+
+    unsigned int num_repeats = 5;
+
+    cttEnergyMeter* meter = NULL;
+    double energy         = 0.0;
+    double last_energy    = 0.0;
+
+    // TEST
+
+    EXPECT_EQ(CTT_ERR_NULL_PTR, CTTMetrics_Energy_Open(NULL));
+    EXPECT_EQ(CTT_ERR_NULL_PTR, CTTMetrics_Energy_Get(NULL, CTT_ENERGY_PACKAGE, &energy));
+
+    cttStatus sts = CTTMetrics_Energy_Open(&meter);
+    if (CTT_ERR_UNSUPPORTED == sts)
+        GTEST_SKIP() << "RAPL is not available";
+    ASSERT_EQ(CTT_ERR_NONE, sts);
+    EXPECT_EQ(CTT_ERR_NULL_PTR, CTTMetrics_Energy_Get(meter, CTT_ENERGY_PACKAGE, NULL));
+    EXPECT_EQ(CTT_ERR_OUT_OF_RANGE,
+              CTTMetrics_Energy_Get(meter, CTT_ENERGY_DOMAIN_COUNT, &energy));
+
+    sts = CTTMetrics_Energy_Get(meter, CTT_ENERGY_PACKAGE, &last_energy);
+    if (CTT_ERR_NO_ROOT_PRIVILEDGES == sts) {
+        CTTMetrics_Energy_Close(meter);
+        GTEST_SKIP() << "RAPL counters are readable only by root";
+    }
+    ASSERT_EQ(CTT_ERR_NONE, sts);
+    EXPECT_GE(last_energy, 0.0);
+
+    // package consumes energy all the time, counter doesn't go back even if it wraps around
+    for (unsigned int repeat = 0; repeat < num_repeats; repeat++) {
+        usleep(100 * 1000);
+        EXPECT_EQ(CTT_ERR_NONE, CTTMetrics_Energy_Get(meter, CTT_ENERGY_PACKAGE, &energy));
+        EXPECT_GT(energy, last_energy);
+        last_energy = energy;
+    }
+
+    sts = CTTMetrics_Energy_Get(meter, CTT_ENERGY_DRAM, &energy);
+    EXPECT_TRUE(CTT_ERR_NONE == sts || CTT_ERR_UNSUPPORTED == sts) << "status : " << sts;
+
+    CTTMetrics_Energy_Close(meter);
+}
+
 // cttMetricsFrequencyReport test set is designed to check frequency reporting correctness
 
 TEST(cttMetricsFrequencyReport, setAndCheckFrequency) {
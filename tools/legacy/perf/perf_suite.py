@@ -0,0 +1,392 @@
+#!/usr/bin/env python3
+###############################################################################
+# Copyright (C) Intel Corporation
+#
+# SPDX-License-Identifier: MIT
+###############################################################################
+"""
+Performance regression suite of the legacy tools, run by ctest (-L perf).
+
+  content  - synthesize raw NV12 input of a resolution and encode a H.265
+             stream from it once, both are kept in <work-dir>/content
+  run      - run one tool in its benchmark mode on the content and write
+             fps, latency percentiles, CPU time and peak RSS to
+             <work-dir>/results/<tool>.<resolution>.json, with --baseline
+             the metrics are compared and the run fails on a regression
+  baseline - merge all results of <work-dir> into a baseline file, its
+             "thresholds" map of metric to relative change is kept
+
+With --simrt the tools run on the latency simulating test runtime, so the
+numbers depend on the pipeline code of the tools rather than on a device.
+"""
+
+import argparse
+import glob
+import json
+import math
+import os
+import re
+import subprocess
+import sys
+import time
+
+TOOLS = ('decode', 'encode', 'vpp', 'transcode')
+
+# frames preloaded by the benchmark modes which take raw input
+PRELOAD_FRAMES = 8
+
+# all metrics but fps are better when lower
+METRICS = ('fps', 'latency_p50_ms', 'latency_p90_ms', 'latency_p99_ms',
+           'latency_max_ms', 'cpu_time_s', 'peak_rss_mb')
+HIGHER_IS_BETTER = ('fps', )
+# the latency tail is a few samples of a run, it fails only if the baseline
+# has a threshold for it
+REPORTED_METRICS = ('latency_p99_ms', 'latency_max_ms')
+# CPU time includes startup of the tool, which varies more than --threshold
+NOISY_THRESHOLDS = {'cpu_time_s': 0.25}
+
+# bytes of a simulated frame, the same for encode and decode so a stream of
+# N encoded frames decodes to N frames
+SIMRT_FRAME_BYTES = 4096
+
+
+def parse_resolution(text):
+    """Parse WxH"""
+    match = re.fullmatch(r'(\d+)x(\d+)', text)
+    if not match:
+        raise argparse.ArgumentTypeError('resolution must be WxH: ' + text)
+    return int(match.group(1)), int(match.group(2))
+
+
+def content_paths(args):
+    """Raw input and encoded stream of the resolution"""
+    name = '%dx%d' % args.resolution
+    content_dir = os.path.join(args.work_dir, 'content')
+    return (os.path.join(content_dir, name + '.nv12'),
+            os.path.join(content_dir, name + '.h265'))
+
+
+def tool_path(args, name):
+    """Path of a tool executable"""
+    if os.name == 'nt':
+        name += '.exe'
+    return os.path.join(args.tools_dir, name)
+
+
+def impl_option(args):
+    """Implementation option of the tools"""
+    return '-sw' if args.simrt else '-' + args.impl
+
+
+def tool_env(args):
+    """Environment of the tools, which selects the simulation runtime"""
+    env = dict(os.environ)
+    if args.simrt:
+        # the priority path wins over the runtimes next to the tools
+        env['ONEVPL_PRIORITY_PATH'] = args.simrt
+        env['ONEVPL_SIMRT_RESOLUTION'] = '%dx%d' % args.resolution
+        env['ONEVPL_SIMRT_DEC_FRAME_BYTES'] = str(SIMRT_FRAME_BYTES)
+        env['ONEVPL_SIMRT_ENC_FRAME_BYTES'] = str(SIMRT_FRAME_BYTES)
+    return env
+
+
+def run_process(cmd, env, log_path):
+    """Run cmd with output to log_path, returns exit code and resource usage"""
+    print(' '.join(cmd))
+    sys.stdout.flush()
+    usage = {'wall_time_s': None, 'cpu_time_s': None, 'peak_rss_mb': None}
+    with open(log_path, 'w') as log:
+        start = time.perf_counter()
+        # pylint: disable=consider-using-with
+        proc = subprocess.Popen(cmd,
+                                stdout=log,
+                                stderr=subprocess.STDOUT,
+                                env=env)
+        if hasattr(os, 'wait4'):
+            # resource usage of this child only
+            _, status, rusage = os.wait4(proc.pid, 0)
+            if os.WIFEXITED(status):
+                proc.returncode = os.WEXITSTATUS(status)
+            else:
+                proc.returncode = -os.WTERMSIG(status)
+            usage['cpu_time_s'] = rusage.ru_utime + rusage.ru_stime
+            # kilobytes on Linux, bytes on macOS
+            rss_scale = 1024 * 1024 if sys.platform == 'darwin' else 1024
+            usage['peak_rss_mb'] = rusage.ru_maxrss / rss_scale
+        else:
+            proc.wait()
+        usage['wall_time_s'] = time.perf_counter() - start
+
+    with open(log_path) as log:
+        output = log.read()
+    if proc.returncode != 0:
+        print(output)
+        print('error: exit code %d' % proc.returncode)
+    return proc.returncode, output, usage
+
+
+def write_nv12(path, width, height):
+    """Write PRELOAD_FRAMES frames of moving gradients"""
+    luma_base = bytes(range(256)) * (width // 256 + 2)
+    chroma_base = bytes(range(64, 192)) * (width // 128 + 2)
+    with open(path + '.tmp', 'wb') as file:
+        for frame in range(PRELOAD_FRAMES):
+            for row in range(height):
+                offset = (row + 4 * frame) % 256
+                file.write(luma_base[offset:offset + width])
+            for row in range(height // 2):
+                offset = (row + 2 * frame) % 128
+                file.write(chroma_base[offset:offset + width])
+    os.replace(path + '.tmp', path)
+
+
+def cmd_content(args):
+    """Synthesize raw input and encode the stream once"""
+    width, height = args.resolution
+    raw_path, stream_path = content_paths(args)
+    os.makedirs(os.path.dirname(raw_path), exist_ok=True)
+
+    if not os.path.exists(raw_path):
+        write_nv12(raw_path, width, height)
+
+    if os.path.exists(stream_path):
+        return 0
+
+    # the raw input is looped until the stream has --frames frames
+    cmd = [
+        tool_path(args, 'sample_encode'), 'h265', '-i', raw_path, '-nv12',
+        '-w',
+        str(width), '-h',
+        str(height),
+        impl_option(args), '-o', stream_path + '.tmp', '-n',
+        str(args.frames), '-timeout', '3600', '-uncut'
+    ]
+    code, _, _ = run_process(cmd, tool_env(args), stream_path + '.log')
+    if code != 0:
+        return 1
+    os.replace(stream_path + '.tmp', stream_path)
+    return 0
+
+
+def tool_command(args):
+    """Benchmark command line of --tool"""
+    width, height = args.resolution
+    raw_path, stream_path = content_paths(args)
+    impl = impl_option(args)
+
+    if args.tool == 'decode':
+        return [
+            tool_path(args, 'sample_decode'), 'h265', '-i', stream_path, impl,
+            '-bench', '1'
+        ]
+    if args.tool == 'encode':
+        return [
+            tool_path(args, 'sample_encode'), 'h265', '-i', raw_path, '-nv12',
+            '-w',
+            str(width), '-h',
+            str(height), impl, '-bench',
+            str(PRELOAD_FRAMES), '-n',
+            str(args.frames)
+        ]
+    if args.tool == 'vpp':
+        passes = max(1, math.ceil(args.frames / PRELOAD_FRAMES))
+        return [
+            tool_path(args, 'sample_vpp'), '-lib', impl[1:], '-sw',
+            str(width), '-sh',
+            str(height), '-scc', 'nv12', '-dw',
+            str(width // 2), '-dh',
+            str(height // 2), '-dcc', 'rgb4', '-i', raw_path, '-o',
+            os.devnull, '-perf_opt',
+            str(PRELOAD_FRAMES),
+            str(passes)
+        ]
+    return [
+        tool_path(args, 'sample_multi_transcode'), '-latency_stat', '3600',
+        '-i::h265', stream_path, '-o::h264', 'null', impl
+    ]
+
+
+def search(pattern, output, count=1):
+    """Float groups of the last match of pattern, or None"""
+    matches = re.findall(pattern, output)
+    if not matches:
+        return [None] * count
+    last = matches[-1] if count > 1 else (matches[-1], )
+    return [float(value) for value in last]
+
+
+def parse_metrics(tool, output):
+    """Metrics printed by the benchmark mode of the tool"""
+    metrics = dict.fromkeys(METRICS)
+    if tool in ('decode', 'encode'):
+        metrics['frames'], metrics['fps'] = search(
+            r'Benchmark: frames: (\d+), fps: ([\d.]+)', output, 2)
+    if tool == 'decode':
+        (metrics['latency_p50_ms'], metrics['latency_p90_ms'],
+         metrics['latency_p99_ms']) = search(
+             r'P50=([\d.]+) ms, P90=([\d.]+) ms, P99=([\d.]+) ms', output, 3)
+        metrics['latency_max_ms'], = search(r'MAX=([\d.]+) ms', output)
+    elif tool == 'encode':
+        (metrics['latency_p50_ms'], metrics['latency_p90_ms'],
+         metrics['latency_p99_ms'], metrics['latency_max_ms']) = search(
+             r'Encode latency: P50=([\d.]+) ms, P90=([\d.]+) ms, '
+             r'P99=([\d.]+) ms, MAX=([\d.]+) ms', output, 4)
+    elif tool == 'vpp':
+        # processing is asynchronous without per-frame latency
+        metrics['frames'], = search(r'Total frames (\d+)', output)
+        metrics['fps'], = search(r'Frames per second ([\d.]+) fps', output)
+    else:
+        metrics['frames'], metrics['fps'] = search(
+            r'PASSED \(MFX_ERR_NONE\) [\d.]+ sec, (\d+) frames, ([\d.]+) fps',
+            output, 2)
+        (metrics['latency_p50_ms'], metrics['latency_p90_ms'],
+         metrics['latency_p99_ms'], metrics['latency_max_ms']) = search(
+             r'latency\[total\] session 0: frames=\d+ p50=([\d.]+) '
+             r'p90=([\d.]+) p99=([\d.]+) max=([\d.]+) ms', output, 4)
+    return metrics
+
+
+def compare(name, metrics, baseline, default_threshold):
+    """Print the change of every metric, returns False on a regression"""
+    if baseline.get('runtime') != metrics['runtime']:
+        print('warning: baseline is of runtime %s, not compared' %
+              baseline.get('runtime'))
+        return True
+    reference = baseline.get('cases', {}).get(name)
+    if not reference:
+        print('warning: %s is not in the baseline, not compared' % name)
+        return True
+
+    thresholds = dict(NOISY_THRESHOLDS)
+    thresholds.update(baseline.get('thresholds', {}))
+    passed = True
+    print('%-16s %12s %12s %9s' % ('metric', 'baseline', 'current', 'change'))
+    for metric in METRICS:
+        base = reference.get(metric)
+        value = metrics.get(metric)
+        if base is None or value is None or base <= 0:
+            continue
+        change = (value - base) / base
+        threshold = thresholds.get(metric, default_threshold)
+        if metric in HIGHER_IS_BETTER:
+            regressed = change < -threshold
+        else:
+            regressed = change > threshold
+        if metric in REPORTED_METRICS and metric not in thresholds:
+            status = '  (reported only)'
+            regressed = False
+        else:
+            status = '  REGRESSION' if regressed else ''
+        print('%-16s %12.3f %12.3f %+8.1f%%%s' %
+              (metric, base, value, change * 100, status))
+        passed = passed and not regressed
+    return passed
+
+
+def cmd_run(args):
+    """Run one benchmark and compare it with the baseline"""
+    name = '%s.%dx%d' % ((args.tool, ) + args.resolution)
+    results_dir = os.path.join(args.work_dir, 'results')
+    os.makedirs(results_dir, exist_ok=True)
+
+    code, output, usage = run_process(tool_command(args), tool_env(args),
+                                      os.path.join(results_dir, name + '.log'))
+    if code != 0:
+        return 1
+
+    metrics = parse_metrics(args.tool, output)
+    if metrics['fps'] is None:
+        print(output)
+        print('error: benchmark summary not found in the output')
+        return 1
+    metrics.update(usage)
+    metrics['runtime'] = 'sim' if args.simrt else 'system'
+    with open(os.path.join(results_dir, name + '.json'), 'w') as file:
+        json.dump(metrics, file, indent=2)
+
+    if not args.baseline:
+        print(json.dumps(metrics, indent=2))
+        return 0
+    if not os.path.exists(args.baseline):
+        print('warning: baseline %s does not exist, run the perf-baseline '
+              'target to create it' % args.baseline)
+        return 0
+    with open(args.baseline) as file:
+        baseline = json.load(file)
+    return 0 if compare(name, metrics, baseline, args.threshold) else 1
+
+
+def cmd_baseline(args):
+    """Merge the results into a baseline, thresholds of it are kept"""
+    baseline = {'version': 1, 'thresholds': {}, 'cases': {}}
+    if os.path.exists(args.output):
+        with open(args.output) as file:
+            baseline.update(json.load(file))
+
+    results = sorted(glob.glob(os.path.join(args.work_dir, 'results',
+                                            '*.json')))
+    if not results:
+        print('error: no results in %s, run ctest -L perf first' %
+              args.work_dir)
+        return 1
+    for path in results:
+        with open(path) as file:
+            metrics = json.load(file)
+        if baseline.get('runtime', metrics['runtime']) != metrics['runtime']:
+            baseline['cases'] = {}
+        baseline['runtime'] = metrics['runtime']
+        name = os.path.splitext(os.path.basename(path))[0]
+        baseline['cases'][name] = {
+            metric: metrics.get(metric)
+            for metric in METRICS
+        }
+
+    with open(args.output, 'w') as file:
+        json.dump(baseline, file, indent=2, sort_keys=True)
+    print('%d cases written to %s' % (len(results), args.output))
+    return 0
+
+
+def main():
+    """Entry point"""
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    subparsers = parser.add_subparsers(dest='command', required=True)
+
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument('--work-dir', required=True)
+
+    tools = argparse.ArgumentParser(add_help=False, parents=[common])
+    tools.add_argument('--tools-dir', required=True)
+    tools.add_argument('--resolution', type=parse_resolution, required=True)
+    tools.add_argument('--frames', type=int, default=300)
+    tools.add_argument('--simrt', help='directory of the simulation runtime')
+    tools.add_argument('--impl',
+                       choices=('hw', 'sw'),
+                       default='hw',
+                       help='implementation without --simrt')
+
+    subparsers.add_parser('content', parents=[tools])
+
+    run = subparsers.add_parser('run', parents=[tools])
+    run.add_argument('--tool', choices=TOOLS, required=True)
+    run.add_argument('--baseline')
+    run.add_argument('--threshold',
+                     type=float,
+                     default=0.1,
+                     help='relative change which fails, if the baseline '
+                     'has none for the metric')
+
+    baseline = subparsers.add_parser('baseline', parents=[common])
+    baseline.add_argument('--output', required=True)
+
+    args = parser.parse_args()
+    commands = {
+        'content': cmd_content,
+        'run': cmd_run,
+        'baseline': cmd_baseline
+    }
+    return commands[args.command](args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
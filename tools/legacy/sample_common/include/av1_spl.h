@@ -0,0 +1,53 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef _AV1_SPL_H__
+#define _AV1_SPL_H__
+
+#include <vector>
+
+#include "abstract_splitter.h"
+
+namespace ProtectedLibrary {
+
+// Splits AV1 low overhead bitstream format (OBUs with size fields, like .obu files) to temporal
+// units. A temporal unit ends before the next temporal delimiter, frame header, frame and tile
+// group OBUs are reported as slices.
+class AV1_Spl : public AbstractSplitter {
+public:
+    AV1_Spl();
+
+    virtual ~AV1_Spl();
+
+    virtual mfxStatus Reset();
+
+    virtual mfxStatus GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame);
+
+    virtual mfxStatus PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum);
+
+    virtual void ResetCurrentState();
+
+protected:
+    void CompleteFrame();
+
+    // bytes of the OBU being read which aren't appended to the temporal unit yet
+    mfxU64 m_obuBytesLeft;
+
+    // temporal unit being collected
+    std::vector<mfxU8> m_temporalUnit;
+    std::vector<SliceSplitterInfo> m_temporalUnitSlices;
+    bool m_bTemporalUnitHasFrame;
+    mfxU64 m_temporalUnitTimeStamp;
+
+    // temporal unit returned last
+    std::vector<mfxU8> m_frameData;
+    std::vector<SliceSplitterInfo> m_slices;
+    FrameSplitterInfo m_frame;
+};
+
+} // namespace ProtectedLibrary
+
+#endif // _AV1_SPL_H__
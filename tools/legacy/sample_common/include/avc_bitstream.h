@@ -119,32 +119,27 @@ private:
 
 void SetDefaultScalingLists(AVCSeqParamSet* sps);
 
-extern const mfxU32 bits_data[];
-
-#define _avcGetBits(current_data, offset, nbits, data) \
-    {                                                  \
-        mfxU32 x;                                      \
-                                                       \
-        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32);   \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);    \
-                                                       \
-        offset -= (nbits);                             \
-                                                       \
-        if (offset >= 0) {                             \
-            x = current_data[0] >> (offset + 1);       \
-        }                                              \
-        else {                                         \
-            offset += 32;                              \
-                                                       \
-            x = current_data[1] >> (offset);           \
-            x >>= 1;                                   \
-            x += current_data[0] << (31 - offset);     \
-            current_data++;                            \
-        }                                              \
-                                                       \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);    \
-                                                       \
-        (data) = x & bits_data[nbits];                 \
+// Next 32 bits of the stream taken from the 64-bit window of the current and the next dword.
+// The buffer has to be readable one dword past its end, AVC_Spl keeps 8 bytes of padding there.
+inline mfxU32 avcShowBits32(const mfxU32* current_data, mfxI32 offset) {
+    mfxU64 window = ((mfxU64)current_data[0] << 32) | current_data[1];
+    return (mfxU32)(window >> (offset + 1));
+}
+
+#define _avcGetBits(current_data, offset, nbits, data)                  \
+    {                                                                   \
+        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32);                    \
+        SAMPLE_ASSERT(offset >= 0 && offset <= 31);                     \
+                                                                        \
+        (data) = avcShowBits32(current_data, offset) >> (32 - (nbits)); \
+                                                                        \
+        offset -= (nbits);                                              \
+        if (offset < 0) {                                               \
+            offset += 32;                                               \
+            current_data++;                                             \
+        }                                                               \
+                                                                        \
+        SAMPLE_ASSERT(offset >= 0 && offset <= 31);                     \
     }
 
 #define avcGetBits1(current_data, offset, data)     \
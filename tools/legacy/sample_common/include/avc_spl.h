@@ -75,6 +75,11 @@ public:
 
     void ResetCurrentState();
 
+    // size of the NAL unit of the next frame read while completing the frame returned last
+    mfxU32 GetPendingNalUnitSize() const {
+        return m_lastNalUnit ? m_lastNalUnit->DataLength : 0;
+    }
+
 protected:
     std::unique_ptr<NALUnitSplitter> m_pNALSplitter;
 
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include "vpl/mfxvideo.h"
@@ -40,6 +41,11 @@ public:
     virtual mfxStatus GetFrameHDL(mfxMemId mid, mfxHDL* handle)    = 0;
     virtual mfxStatus FreeFrames(mfxFrameAllocResponse* response)  = 0;
 
+protected:
+    // Lock and Unlock calls through the callbacks are timed if set
+    bool m_bTimeLocks;
+    virtual void CountLatency(bool bUnlock, mfxU64 us) {}
+
 private:
     static mfxStatus MFX_CDECL Alloc_(mfxHDL pthis,
                                       mfxFrameAllocRequest* request,
@@ -50,6 +56,32 @@ private:
     static mfxStatus MFX_CDECL Free_(mfxHDL pthis, mfxFrameAllocResponse* response);
 };
 
+// Counters of a frame allocator. Bytes of video memory frames are estimated from their format,
+// the driver may add padding and metadata.
+struct FrameAllocatorStatistics {
+    enum { SYSTEM_MEMORY = 0, VIDEO_MEMORY = 1, MEMORY_TYPES = 2 };
+    // bucket i counts the calls taking less than 2^i us, the last one all the longer calls
+    static const mfxU32 LATENCY_BUCKETS = 16;
+
+    struct Memory {
+        mfxU64 numAllocs; // allocation calls reaching the memory, reused frames aren't counted
+        mfxU64 numFrames; // held now
+        mfxU64 bytes;
+        mfxU64 peakBytes;
+    };
+    struct Latency {
+        mfxU64 count;
+        mfxU64 totalUs;
+        mfxU64 maxUs;
+        mfxU64 histogram[LATENCY_BUCKETS];
+    };
+
+    Memory memory[MEMORY_TYPES];
+    mfxU64 peakBytes; // of all the memory types at once
+    Latency lock;
+    Latency unlock;
+};
+
 // This class implements basic logic of memory allocator
 // Manages responses for different components according to allocation request type
 // External frames of a particular component-related type are allocated in one call
@@ -73,6 +105,22 @@ public:
                                    mfxMemId* midOut);
     virtual mfxStatus FreeFrames(mfxFrameAllocResponse* response);
 
+    // Freed frames are kept for the following requests of the same FourCC, size and type, so the
+    // resets of components keeping the resolution don't allocate them again. Must be set before
+    // the allocations, the kept frames are released by Close.
+    void SetFrameReuse(bool bReuse) {
+        m_bReuseFrames = bReuse;
+    }
+    // the frames allocated so far aren't reused, e.g. they are lost with the device
+    void InvalidateReusableFrames();
+
+    // memory is always counted, the latencies of Lock and Unlock once this is set
+    void SetLockTiming(bool bTime) {
+        m_bTimeLocks = bTime;
+    }
+    FrameAllocatorStatistics GetStatistics();
+    void PrintStatistics();
+
 protected:
     std::mutex mtx;
     typedef std::list<mfxFrameAllocResponse>::iterator Iter;
@@ -150,6 +198,39 @@ protected:
         }
     };
 
+    struct ReusableResponse {
+        mfxFrameAllocResponse response;
+        mfxU32 fourCC;
+        mfxU16 width;
+        mfxU16 height;
+        mfxU16 type;
+        mfxU32 generation; // of InvalidateReusableFrames calls
+    };
+
+    // allocates frames or takes the kept ones matching the request
+    mfxStatus AllocOrReuse(mfxFrameAllocRequest* request, mfxFrameAllocResponse* response);
+    // AllocImpl and ReleaseResponse counting the memory held
+    mfxStatus AllocCounted(mfxFrameAllocRequest* request, mfxFrameAllocResponse* response);
+    mfxStatus ReleaseCounted(mfxFrameAllocResponse* response);
+    virtual void CountLatency(bool bUnlock, mfxU64 us);
+    static mfxU64 GetFrameBytes(const mfxFrameInfo& info);
+    // releases frames or keeps them for reuse, called under mtx
+    mfxStatus ReleaseOrKeep(mfxFrameAllocResponse* response);
+
+    bool m_bReuseFrames;
+    mfxU32 m_generation;
+    std::list<ReusableResponse> m_ReusableResponses; // allocated while reuse is on and in use
+    std::list<ReusableResponse> m_KeptResponses;
+
+    struct HeldFrames {
+        mfxU32 memory;
+        mfxU32 numFrames;
+        mfxU64 bytes;
+    };
+    std::mutex m_StatisticsMutex;
+    FrameAllocatorStatistics m_Statistics;
+    std::map<mfxMemId*, HeldFrames> m_HeldFrames; // by mids of the responses
+
     // checks if request is supported
     virtual mfxStatus CheckRequestType(mfxFrameAllocRequest* request);
 
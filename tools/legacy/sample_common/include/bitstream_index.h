@@ -0,0 +1,100 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __BITSTREAM_INDEX_H__
+#define __BITSTREAM_INDEX_H__
+
+#include <vector>
+#include "sample_defs.h"
+#include "sample_utils.h"
+#include "vpl/mfxstructures.h"
+
+// Offsets of the frames of an IVF file (VP8, VP9, AV1) or an H.264/HEVC Annex-B stream found in
+// one pass over the file. A frame is a random access point when the decoding of the stream can
+// start at it: IDR access units with their parameter sets for H.264 and HEVC, key frames for VP8
+// and VP9 and temporal units with a sequence header and a key frame for AV1. A key frame is
+// decoded without other frames once the decoder has the parameter sets: random access points and
+// also IDR and IRAP access units without parameter sets. The index of a file kept in a sidecar is
+// loaded instead of parsing the file again while the file size is the same.
+class CBitstreamIndex {
+public:
+    struct Frame {
+        mfxU64 Offset; // of the IVF frame header or the first NAL unit of the access unit
+        mfxU32 Size;
+        bool bRandomAccess;
+        bool bKeyFrame;
+    };
+    // bytes and frames of the stream starting at a random access point
+    struct Segment {
+        mfxU64 Begin;
+        mfxU64 End;
+        mfxU32 FirstFrame;
+        mfxU32 NumFrames;
+    };
+
+    CBitstreamIndex();
+
+    mfxStatus Build(const msdk_char* strFileName, mfxU32 codecId);
+    mfxStatus Save(const msdk_char* strIndexFile) const;
+    // MFX_ERR_NOT_FOUND if the sidecar is missing or made for another file or codec
+    mfxStatus Load(const msdk_char* strIndexFile, const msdk_char* strFileName, mfxU32 codecId);
+    // loads the sidecar if it matches the file, otherwise builds the index and saves it
+    mfxStatus LoadOrBuild(const msdk_char* strIndexFile,
+                          const msdk_char* strFileName,
+                          mfxU32 codecId);
+
+    // up to nSegments segments of about the same number of frames, they cover the whole file
+    std::vector<Segment> Split(mfxU32 nSegments) const;
+
+    const std::vector<Frame>& GetFrames() const {
+        return m_Frames;
+    }
+
+protected:
+    static mfxStatus GetFileSize(const msdk_char* strFileName, mfxU64& size);
+
+    mfxStatus IndexIVF(const mfxU8* pData, size_t nSize);
+    mfxStatus IndexAnnexB(const mfxU8* pData, size_t nSize);
+    bool IsRandomAccessIVF(const mfxU8* pData, mfxU32 nSize);
+
+    mfxU32 m_CodecId;
+    mfxU64 m_nFileSize;
+    std::vector<Frame> m_Frames;
+    // AV1 frame headers are parsed with the flag of the last sequence header
+    bool m_bReducedStillPictureHeader;
+};
+
+// reads only the key frames of the file, one complete frame per ReadNextFrame(). A key frame
+// closer than the interval to the last one read is skipped, so the decoder gets about one frame
+// per interval instead of the whole stream. Live streams aren't supported: the file is indexed
+class CKeyFrameReader : public CSmplBitstreamReader {
+public:
+    explicit CKeyFrameReader(mfxU32 codecId);
+
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+    // minimal distance in frames between the key frames read, 0 - every key frame is read
+    void SetInterval(mfxU32 nFrames) {
+        m_nInterval = nFrames;
+    }
+
+protected:
+    mfxU32 m_CodecId;
+    CBitstreamIndex m_Index;
+    mfxU32 m_nInterval;
+    // frame the search of the next key frame starts at
+    size_t m_nNextFrame;
+    // last key frame read, the interval counts from it
+    size_t m_nLastKeyFrame;
+    bool m_bKeyFrameRead;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CKeyFrameReader);
+};
+
+#endif // __BITSTREAM_INDEX_H__
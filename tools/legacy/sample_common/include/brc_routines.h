@@ -178,6 +178,8 @@ struct BRC_Ctx {
     mfxF64
         eRateSH; // eRate of last encoded scene change frame, this parameter is used for scene change calculation
 };
+// Sizes of the last frames in a ring buffer of the window size. Sums of the whole window are
+// kept up to date on every update, so the window sums used per frame don't loop over it.
 class AVGBitrate {
 public:
     AVGBitrate(mfxU32 windowSize, mfxU32 maxBitPerFrame, mfxU32 avgBitPerFrame)
@@ -185,14 +187,16 @@ public:
               m_maxWinBitsLim(0),
               m_avgBitPerFrame(std::min(avgBitPerFrame, maxBitPerFrame)),
               m_currPosInWindow(windowSize - 1),
-              m_lastFrameOrder(mfxU32(-1))
+              m_lastFrameOrder(mfxU32(-1)),
+              m_winBits(0),
+              m_winBitsNoSkip(0)
 
     {
         windowSize = windowSize > 0 ? windowSize : 1; // kw
-        m_slidingWindow.resize(windowSize);
-        for (mfxU32 i = 0; i < windowSize; i++) {
-            m_slidingWindow[i] = maxBitPerFrame / 3; //initial value to prevent big first frames
-        }
+        //initial value to prevent big first frames
+        m_slidingWindow.assign(windowSize, maxBitPerFrame / 3);
+        m_winBits       = windowSize * (maxBitPerFrame / 3);
+        m_winBitsNoSkip = windowSize * NoSkipBits(maxBitPerFrame / 3);
         m_maxWinBitsLim = GetMaxWinBitsLim();
     }
     virtual ~AVGBitrate() {}
@@ -208,7 +212,7 @@ public:
             m_lastFrameOrder  = FrameOrder;
             m_currPosInWindow = (m_currPosInWindow + 1) % windowSize;
         }
-        m_slidingWindow[m_currPosInWindow] = sizeInBits;
+        SetFrameBits(m_currPosInWindow, sizeInBits);
 
         if (bNextFrame) {
             if (bPanic || bSH) {
@@ -259,17 +263,31 @@ protected:
     mfxU32 m_currPosInWindow;
     mfxU32 m_lastFrameOrder;
     std::vector<mfxU32> m_slidingWindow;
+    // sums of the window, sizes of skipped frames are counted as m_avgBitPerFrame / 3 in the second
+    mfxU32 m_winBits;
+    mfxU32 m_winBitsNoSkip;
+
+    mfxU32 NoSkipBits(mfxU32 frameBits) const {
+        return std::max(frameBits, m_avgBitPerFrame / 3);
+    }
+    void SetFrameBits(mfxU32 pos, mfxU32 frameBits) {
+        m_winBits += frameBits - m_slidingWindow[pos];
+        m_winBitsNoSkip += NoSkipBits(frameBits) - NoSkipBits(m_slidingWindow[pos]);
+        m_slidingWindow[pos] = frameBits;
+    }
 
+    // sum of the last numFrames frames, the BRC asks for the whole window or all but the oldest
     mfxU32 GetLastFrameBits(mfxU32 numFrames, bool bCheckSkip) {
-        mfxU32 size = 0;
-        numFrames = numFrames < m_slidingWindow.size() ? numFrames : (mfxU32)m_slidingWindow.size();
-        for (mfxU32 i = 0; i < numFrames; i++) {
-            mfxU32 frame_size = m_slidingWindow[(m_currPosInWindow + m_slidingWindow.size() - i) %
-                                                m_slidingWindow.size()];
-            if (bCheckSkip && (frame_size < m_avgBitPerFrame / 3))
-                frame_size = m_avgBitPerFrame / 3;
-            size += frame_size;
-            //printf("GetLastFrames: %d) %d sum %d\n",i,m_slidingWindow[(m_currPosInWindow + m_slidingWindow.size() - i) % m_slidingWindow.size() ], size);
+        mfxU32 windowSize = GetWindowSize();
+        mfxU32 size       = bCheckSkip ? m_winBitsNoSkip : m_winBits;
+        if (numFrames >= windowSize)
+            return size;
+
+        // the oldest frames are the next ones after the current position
+        mfxU32 pos = m_currPosInWindow;
+        for (mfxU32 i = numFrames; i < windowSize; i++) {
+            pos = (pos + 1 == windowSize) ? 0 : pos + 1;
+            size -= bCheckSkip ? NoSkipBits(m_slidingWindow[pos]) : m_slidingWindow[pos];
         }
         return size;
     }
@@ -0,0 +1,110 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __COMPRESSED_YUV_READER_H__
+#define __COMPRESSED_YUV_READER_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sample_defs.h"
+#include "sample_utils.h"
+#include "vm/so_defs.h"
+
+// Raw input compressed picture by picture with LZ4 or zstd. The container is little-endian:
+//   header: "VPLZ", u32 version (1), u32 codec (1 - LZ4, 2 - zstd), u32 picture size,
+//           u32 number of pictures, u64 offset of the index
+//   one compressed block per picture
+//   index: u64 offset and u32 size of the block of each picture
+// The decompressed pictures are the frames of the raw file, so any frame is found through the
+// index without reading the preceding ones.
+//
+// The first input is checked for the container on Init, other inputs and plain raw files are read
+// as CAsyncYUVReader does. Pictures are decompressed ahead of the caller on the worker threads into
+// a ring of as many pictures as the chunks of SetReadAhead, without the read ahead they are
+// decompressed on the caller's thread. The codec libraries are loaded when a container is opened.
+class CCompressedYUVReader : public CAsyncYUVReader {
+public:
+    explicit CCompressedYUVReader(mfxU32 nThreads = 0);
+    virtual ~CCompressedYUVReader();
+
+    // takes effect on the next Init, 0 takes up to 4 threads by the number of CPUs
+    void SetDecompressThreads(mfxU32 nThreads);
+
+    virtual void Close();
+    virtual mfxStatus Init(std::list<msdk_string> inputs,
+                           mfxU32 ColorFormat,
+                           bool shouldShiftP010 = false);
+    virtual mfxStatus SkipNframesFromBeginning(mfxU16 w, mfxU16 h, mfxU32 viewId, mfxU32 nframes);
+    virtual void Reset();
+
+    bool IsCompressed() const {
+        return m_Codec != CODEC_NONE;
+    }
+
+protected:
+    enum { CODEC_NONE = 0, CODEC_LZ4 = 1, CODEC_ZSTD = 2 };
+
+    typedef int (*LZ4DecompressSafe)(const char* src, char* dst, int srcSize, int dstCapacity);
+    typedef size_t (*ZSTDDecompress)(void* dst,
+                                     size_t dstCapacity,
+                                     const void* src,
+                                     size_t srcSize);
+    typedef unsigned (*ZSTDIsError)(size_t code);
+
+    struct IndexEntry {
+        mfxU64 Offset;
+        mfxU32 Size;
+    };
+    struct Picture {
+        std::vector<mfxU8> Data;
+        mfxU32 Index;
+        bool bReady;
+        mfxStatus Sts;
+    };
+
+    virtual size_t ReadData(void* pDst, size_t size, size_t count, mfxU32 vid);
+
+    // MFX_ERR_NOT_FOUND for the files without the container header
+    mfxStatus OpenContainer(FILE* f);
+    mfxStatus LoadCodec(mfxU32 codec);
+    void FreeCodec();
+    mfxStatus DecompressPicture(mfxU32 index, std::vector<mfxU8>& block, Picture& picture);
+    bool NextPicture();
+    void StartDecompression(mfxU32 first);
+    void StopDecompression();
+    void WorkerRoutine();
+
+    mfxU32 m_nThreads;
+    mfxU32 m_Codec;
+    mfxU32 m_nPictureSize;
+    std::vector<IndexEntry> m_Index;
+
+    msdk_so_handle m_hCodecLib;
+    LZ4DecompressSafe m_LZ4DecompressSafe;
+    ZSTDDecompress m_ZSTDDecompress;
+    ZSTDIsError m_ZSTDIsError;
+
+    // picture i is decompressed into m_Ring[i % m_Ring.size()]
+    std::vector<Picture> m_Ring;
+    mfxU32 m_nCurPicture; // being read by the caller
+    size_t m_nPictureOffset;
+    bool m_bHavePicture;
+    mfxU32 m_nNextToDecompress;
+    std::vector<mfxU8> m_Block; // of the caller's thread
+    std::vector<std::thread> m_Workers;
+    std::mutex m_ringMutex;
+    std::mutex m_fileMutex;
+    std::condition_variable m_cvSlot;
+    std::condition_variable m_cvDecompressed;
+    bool m_bStopWorkers;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CCompressedYUVReader);
+};
+
+#endif // __COMPRESSED_YUV_READER_H__
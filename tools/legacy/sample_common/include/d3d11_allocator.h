@@ -118,6 +118,12 @@ public:
     virtual mfxStatus UnlockFrame(mfxMemId mid, mfxFrameData* ptr);
     virtual mfxStatus GetFrameHDL(mfxMemId mid, mfxHDL* handle);
 
+    // Starts copying of the frame into its staging texture and returns without waiting, so the
+    // copies of several frames run on the GPU while the CPU reads the previous ones. The next
+    // LockFrame of the frame maps the copy instead of making another one. The frame must be then
+    // locked before the library writes it again.
+    mfxStatus StartReadback(mfxMemId mid);
+
 protected:
     static DXGI_FORMAT ConverColortFormat(mfxU32 fourcc);
     virtual mfxStatus CheckRequestType(mfxFrameAllocRequest* request);
@@ -135,9 +141,15 @@ protected:
         std::vector<mfxMemId> outerMids;
         std::vector<ID3D11Texture2D*> textures;
         std::vector<ID3D11Texture2D*> stagingTexture;
+        std::vector<mfxU8> readbackPending; // per staging texture, copy started by StartReadback
         bool bAlloc;
 
-        TextureResource() : outerMids(), textures(), stagingTexture(), bAlloc(true) {}
+        TextureResource()
+                : outerMids(),
+                  textures(),
+                  stagingTexture(),
+                  readbackPending(),
+                  bAlloc(true) {}
 
         static bool isAllocated(TextureResource& that) {
             return that.bAlloc;
@@ -165,6 +177,7 @@ protected:
                 stagingTexture[i]->Release();
             }
             stagingTexture.clear();
+            readbackPending.clear();
 
             //marking texture as deallocated
             bAlloc = false;
@@ -175,25 +188,34 @@ protected:
         ID3D11Texture2D* m_pTexture;
         ID3D11Texture2D* m_pStaging;
         UINT m_subResource;
+        ptrdiff_t m_idx;
 
     public:
         TextureSubResource(TextureResource* pTarget = NULL, mfxMemId id = 0)
                 : m_pTarget(pTarget),
                   m_pTexture(),
                   m_subResource(),
-                  m_pStaging(NULL) {
+                  m_pStaging(NULL),
+                  m_idx(0) {
             if (NULL != m_pTarget && !m_pTarget->outerMids.empty()) {
-                ptrdiff_t idx =
+                m_idx =
                     (uintptr_t)MFXReadWriteMid(id).raw() - (uintptr_t)m_pTarget->outerMids.front();
-                m_pTexture    = m_pTarget->textures[idx % m_pTarget->textures.size()];
-                m_subResource = (UINT)(idx / m_pTarget->textures.size());
+                m_pTexture    = m_pTarget->textures[m_idx % m_pTarget->textures.size()];
+                m_subResource = (UINT)(m_idx / m_pTarget->textures.size());
                 m_pStaging =
-                    m_pTarget->stagingTexture.empty() ? NULL : m_pTarget->stagingTexture[idx];
+                    m_pTarget->stagingTexture.empty() ? NULL : m_pTarget->stagingTexture[m_idx];
             }
         }
         ID3D11Texture2D* GetStaging() const {
             return m_pStaging;
         }
+        bool IsReadbackPending() const {
+            return m_pStaging && m_pTarget->readbackPending[m_idx];
+        }
+        void SetReadbackPending(bool bPending) {
+            if (m_pStaging)
+                m_pTarget->readbackPending[m_idx] = bPending;
+        }
         ID3D11Texture2D* GetTexture() const {
             return m_pTexture;
         }
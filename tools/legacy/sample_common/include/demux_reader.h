@@ -0,0 +1,120 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __DEMUX_READER_H__
+#define __DEMUX_READER_H__
+
+#include <vector>
+
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+enum DemuxContainer {
+    DEMUX_NONE = 0, // elementary stream
+    DEMUX_MP4,
+    DEMUX_MKV,
+    DEMUX_MPEG_TS
+};
+
+// container of the input file by its first bytes, DEMUX_NONE for elementary streams and streams
+// (see stream_defs.h), which can't be mapped
+DemuxContainer GetDemuxContainer(const msdk_char* strFileName);
+
+// Reads complete AVC or HEVC access units of the first video track of MP4 (also fragmented),
+// Matroska or MPEG-TS file, one per ReadNextFrame(), with the parameter sets of the track before
+// the first one. The file is mapped to memory, samples of MP4 and Matroska are indexed in Init().
+// In zero-copy mode ReadNextFrame() points mfxBitstream::Data to the access unit in the mapping,
+// 4 bytes NAL unit lengths are replaced with start codes in place. Access units which have to be
+// assembled, e.g. from transport stream packets, are given from the buffer of the reader. Otherwise
+// the access unit is appended to the caller's bitstream.
+class CDemuxBitstreamReader : public CSmplBitstreamReader {
+public:
+    explicit CDemuxBitstreamReader(bool bZeroCopy = false);
+    virtual ~CDemuxBitstreamReader();
+
+    virtual void Close();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+    // MFX_CODEC_AVC or MFX_CODEC_HEVC of the track
+    mfxU32 GetCodecId() const {
+        return m_nCodecId;
+    }
+
+protected:
+    struct Sample {
+        size_t Offset;
+        mfxU32 Size;
+        mfxU64 TimeStamp; // 90 kHz
+        bool bAnnexB; // NAL unit lengths are replaced in the mapping already
+    };
+
+    // payload of the transport stream packet
+    struct Piece {
+        size_t Offset;
+        mfxU32 Size;
+    };
+
+    // tables of the MP4 track as offsets of their box payloads in the file, 0 if absent
+    struct MP4Track {
+        mfxU32 TrackId;
+        mfxU32 Timescale;
+        mfxU32 Handler;
+        mfxU32 CodecId;
+        size_t Config;
+        size_t ConfigSize;
+        size_t Stsz, StszSize;
+        size_t Stsc, StscSize;
+        size_t Stco, StcoSize;
+        bool bCo64;
+        size_t Stts, SttsSize;
+        size_t Ctts, CttsSize;
+    };
+
+    mfxStatus IndexMP4();
+    void ParseMP4Boxes(size_t begin, size_t end, MP4Track& track);
+    mfxStatus IndexMP4Samples(const MP4Track& track);
+    void IndexMP4Fragment(size_t moof, size_t end);
+    mfxStatus IndexMKV();
+    mfxStatus InitTS();
+    mfxStatus ReadTSFrame(mfxU64& timeStamp);
+
+    // takes parameter sets and NAL unit length size from AVC or HEVC decoder configuration record
+    mfxStatus SetDecoderConfig(const mfxU8* pConfig, size_t size);
+    mfxU32 GetAnnexBSize(const Sample& sample) const;
+    void CopyAnnexB(const Sample* pSample, mfxU8* pDst) const;
+
+    bool m_bZeroCopy;
+    DemuxContainer m_Container;
+    CSmplFileMapping m_Mapping;
+    mfxU32 m_nCodecId;
+    mfxU32 m_nLengthSize;
+    std::vector<mfxU8> m_Header; // parameter sets with start codes
+    std::vector<Sample> m_Samples;
+    size_t m_nSample;
+    mfxU64 m_nFrames; // given since the reset
+    std::vector<mfxU8> m_Buffer;
+
+    // MP4 fragments
+    mfxU32 m_nTrackId;
+    mfxU32 m_nTrackTimescale;
+    mfxU32 m_nTrexDuration;
+    mfxU32 m_nTrexSize;
+    mfxU64 m_nFragmentTime; // decode time after the last fragment
+
+    // transport stream
+    size_t m_nPacketSize;
+    size_t m_nPacketPrefix; // 4 bytes of time code in M2TS
+    mfxU16 m_nVideoPid;
+    size_t m_nTSOffset;
+    std::vector<Piece> m_Pieces;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CDemuxBitstreamReader);
+};
+
+#endif //__DEMUX_READER_H__
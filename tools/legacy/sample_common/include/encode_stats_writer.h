@@ -0,0 +1,75 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __ENCODE_STATS_WRITER_H__
+#define __ENCODE_STATS_WRITER_H__
+
+#ifdef ONEVPL_EXPERIMENTAL
+
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+    #include "sample_defs.h"
+    #include "sample_utils.h"
+
+// Frame level statistics of the encoder copied from mfxEncodeStatsContainer
+struct EncodeFrameStat {
+    mfxU32 DisplayOrder;
+    mfxU16 FrameType;
+    mfxU32 Size; // bytes
+    mfxF32 Qp;
+    mfxF32 PSNRLuma;
+    mfxF32 PSNRCb;
+    mfxF32 PSNRCr;
+    mfxU64 SADLuma;
+    mfxU32 NumIntraBlock;
+    mfxU32 NumInterBlock;
+    mfxU32 NumSkippedBlock;
+};
+
+// Requests frame level statistics with mfxExtEncodeStatsOutput attached to the output bitstreams
+// and writes them to a CSV file, one line per frame in order of output. Formatting and writing is
+// done by a background thread, so the encode thread only copies the statistics.
+class CEncodeStatsWriter {
+public:
+    CEncodeStatsWriter();
+    ~CEncodeStatsWriter();
+
+    mfxStatus Open(const msdk_char* fileName);
+    void Close();
+    bool IsOpen() const {
+        return m_thread.joinable();
+    }
+
+    // attaches the request to the bitstream for the next encode calls with it, a container left
+    // in the bitstream is released
+    static void Request(mfxBitstreamWrapper& bs);
+    // releases the container which is left in the bitstream by a frame that wasn't synchronized
+    static void Release(mfxBitstreamWrapper& bs);
+
+    // queues statistics of the synchronized bitstream and releases their container, may be called
+    // from several threads
+    void Add(mfxBitstreamWrapper& bs);
+
+protected:
+    void WriterRoutine();
+
+    FILE* m_file;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cvQueued;
+    std::vector<EncodeFrameStat> m_Queue;
+    bool m_bStop;
+    mfxU32 m_nMissing; // frames output without statistics
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CEncodeStatsWriter);
+};
+
+#endif // ONEVPL_EXPERIMENTAL
+
+#endif //__ENCODE_STATS_WRITER_H__
@@ -0,0 +1,63 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __ENGINE_UTILIZATION_H__
+#define __ENGINE_UTILIZATION_H__
+
+#include <mutex>
+#include <thread>
+#include "sample_defs.h"
+
+// Busy percentages of GPU engines and GT frequency, negative values are not available
+struct EngineUtilization {
+    // sampling periods the values are averaged over, 0 if nothing was sampled yet
+    mfxU32 NumPeriods;
+    mfxF64 Render; // RCS
+    mfxF64 Video; // VDBOX
+    mfxF64 Video2; // second VDBOX
+    mfxF64 VideoEnhance; // VEBOX
+    mfxF64 Frequency; // MHz
+    mfxF64 Power; // W, needs energy counter of the device readable by the user
+    mfxF64 PackagePower; // W of CPU packages (RAPL), includes integrated GPU
+    mfxF64 DramPower; // W of memory (RAPL)
+};
+
+// Samples utilization of GPU engines with the metrics_monitor library in a background thread.
+// The library is a process-wide singleton, so only one sampler may be started at a time. Builds
+// without the library (no libdrm or not Linux) return MFX_ERR_UNSUPPORTED from Start().
+class CEngineUtilizationSampler {
+public:
+    CEngineUtilizationSampler();
+    ~CEngineUtilizationSampler();
+
+    // device is a path to the DRM node, NULL selects i915 render node with the smallest number
+    mfxStatus Start(const char* device = NULL, mfxU32 periodMs = 500);
+    void Stop();
+
+    // values of the last sampling period
+    EngineUtilization GetLast();
+    // values averaged over all periods since Start()
+    EngineUtilization GetAverage();
+
+    static msdk_string ToString(const EngineUtilization& utilization);
+    // joules per frame of every power domain for the session which had the average power for
+    // given seconds, empty if power isn't available
+    static msdk_string ToEnergyString(const EngineUtilization& utilization,
+                                      mfxF64 seconds,
+                                      mfxU64 frames);
+
+protected:
+    std::mutex m_mutex;
+    std::thread m_thread;
+    bool m_bStop;
+    EngineUtilization m_Last;
+    EngineUtilization m_Sum;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CEngineUtilizationSampler);
+};
+
+#endif //__ENGINE_UTILIZATION_H__
@@ -0,0 +1,76 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __FRAME_BAND_EXECUTOR_H__
+#define __FRAME_BAND_EXECUTOR_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+// Runs a CPU filter over a frame split into bands of rows on a pool of worker threads, the
+// template of the CPU processing inserted before a GPU component. Submit() returns at once, so
+// the caller submits earlier frames to the GPU while the bands are processed, and Wait() takes
+// the remaining bands on the caller's thread too. One job is processed at a time.
+class CFrameBandExecutor {
+public:
+    // processes rows [first, last) of the job, called concurrently for different bands
+    typedef std::function<void(mfxU32 first, mfxU32 last)> BandFunction;
+
+    CFrameBandExecutor();
+    ~CFrameBandExecutor();
+
+    // 0 takes the number of CPUs, 1 processes the job on the caller's thread in Wait()
+    mfxStatus Init(mfxU32 nThreads = 0);
+    void Close();
+
+    mfxU32 GetThreadCount() const {
+        return (mfxU32)m_Workers.size() + 1;
+    }
+
+    // waits for the previous job and splits rows of the new one into bands
+    void Submit(mfxU32 rows, BandFunction function);
+    void Wait();
+
+    void Run(mfxU32 rows, BandFunction function) {
+        Submit(rows, std::move(function));
+        Wait();
+    }
+
+protected:
+    // takes the next band of the job, false if all bands are taken, called with the mutex held
+    bool NextBand(mfxU32& first, mfxU32& last);
+    void RunBands(std::unique_lock<std::mutex>& lock);
+    void WorkerRoutine();
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_mutex;
+    std::condition_variable m_cvJob;
+    std::condition_variable m_cvDone;
+    BandFunction m_Function;
+    mfxU32 m_nRows;
+    mfxU32 m_nBands;
+    mfxU32 m_nNextBand;
+    mfxU32 m_nDoneBands;
+    bool m_bStop;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CFrameBandExecutor);
+};
+
+// rotates the crop rectangle of NV12 src by 180 degrees into the crop rectangle of dst (of the
+// same size) on the executor threads, AVX2 is used if the CPU has it. Surfaces must be locked.
+// Submits the job only, rotation is complete after executor.Wait().
+mfxStatus SubmitRotateNV12(CFrameBandExecutor& executor,
+                           const mfxFrameSurface1& src,
+                           mfxFrameSurface1& dst);
+
+#endif //__FRAME_BAND_EXECUTOR_H__
@@ -10,8 +10,11 @@
 #include "base_allocator.h"
 #include "sample_utils.h"
 
+#include <future>
 #include <map>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class SysMemFrameAllocator;
 
@@ -25,6 +28,30 @@ public:
     virtual mfxStatus Init(mfxAllocatorParams* pParams);
     virtual mfxStatus Close();
 
+    // NUMA node for system memory surfaces, must be set before Init
+    void SetNumaNode(mfxI32 node) {
+        m_NumaNode = node;
+    }
+    // system memory surfaces from the pool of huge pages, must be set before Init
+    void SetPooledSysMem(bool bPooled) {
+        m_bPooledSysMem = bPooled;
+    }
+
+    // starts reading of a video memory frame back to the CPU ahead of its locking, supported by
+    // the D3D11 allocator only
+    mfxStatus StartReadback(mfxMemId mid);
+
+    // Copies frames of the same format between any memory types. Frames without the data pointers
+    // are locked by their MemId for the copy. Large frames are written with non-temporal stores,
+    // which keep the source data the pipeline is going to process in the cache.
+    mfxStatus CopyFrame(mfxFrameSurface1* pDst, mfxFrameSurface1* pSrc);
+    // pairs of destination and source frames
+    mfxStatus CopyFrames(
+        const std::vector<std::pair<mfxFrameSurface1*, mfxFrameSurface1*>>& frames);
+    // the same in a thread of its own, the frames must be kept till the result is got
+    std::future<mfxStatus> CopyFramesAsync(
+        std::vector<std::pair<mfxFrameSurface1*, mfxFrameSurface1*>> frames);
+
 protected:
     virtual mfxStatus LockFrame(mfxMemId mid, mfxFrameData* ptr);
     virtual mfxStatus UnlockFrame(mfxMemId mid, mfxFrameData* ptr);
@@ -43,6 +70,8 @@ protected:
     std::map<mfxHDL, bool> m_Mids;
     std::unique_ptr<BaseFrameAllocator> m_D3DAllocator;
     std::unique_ptr<SysMemFrameAllocator> m_SYSAllocator;
+    mfxI32 m_NumaNode    = -1;
+    bool m_bPooledSysMem = false;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(GeneralAllocator);
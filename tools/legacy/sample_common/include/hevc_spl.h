@@ -0,0 +1,54 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef _HEVC_SPL_H__
+#define _HEVC_SPL_H__
+
+#include <vector>
+
+#include "abstract_splitter.h"
+
+namespace ProtectedLibrary {
+
+// Splits H.265 Annex B byte stream to access units. NAL units are copied with their start codes,
+// an access unit ends before the first prefix NAL unit or the first slice of the next picture.
+class HEVC_Spl : public AbstractSplitter {
+public:
+    HEVC_Spl();
+
+    virtual ~HEVC_Spl();
+
+    virtual mfxStatus Reset();
+
+    virtual mfxStatus GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame);
+
+    virtual mfxStatus PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum);
+
+    virtual void ResetCurrentState();
+
+protected:
+    void CompleteNalUnit();
+    void CompleteFrame();
+
+    // data of the NAL unit being read is appended to the access unit
+    bool m_bInNalUnit;
+    bool m_bNalUnitIsSlice;
+
+    // access unit being collected
+    std::vector<mfxU8> m_accessUnit;
+    std::vector<SliceSplitterInfo> m_accessUnitSlices;
+    bool m_bAccessUnitHasSlices;
+    mfxU64 m_accessUnitTimeStamp;
+
+    // access unit returned last
+    std::vector<mfxU8> m_frameData;
+    std::vector<SliceSplitterInfo> m_slices;
+    FrameSplitterInfo m_frame;
+};
+
+} // namespace ProtectedLibrary
+
+#endif // _HEVC_SPL_H__
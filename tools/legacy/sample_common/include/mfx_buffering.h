@@ -8,6 +8,7 @@
 #define __MFX_BUFFERING_H__
 
 #include <stdio.h>
+#include <atomic>
 #include <mutex>
 
 #include "vpl/mfxstructures.h"
@@ -55,16 +56,61 @@ struct msdkOutputSurface {
 
 class CBuffering;
 
-// LIFO list of frame surfaces
+/** \brief Lock-free LIFO list (Treiber stack) of items linked through their 'next' field.
+ *
+ * @note Items may be pushed from any number of threads, but only one thread at a time may pop
+ * them. With concurrent pops an item could be popped and pushed back between reading of the head
+ * and its replacement, so the head would be replaced with a stale 'next' pointer (ABA problem).
+ */
+template <class T>
+class msdkLockFreeStack {
+public:
+    msdkLockFreeStack() : m_pHead(NULL) {}
+
+    inline void Push(T* item) {
+        T* head = m_pHead.load(std::memory_order_relaxed);
+        do {
+            item->next = head;
+        } while (!m_pHead.compare_exchange_weak(head,
+                                                item,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+    }
+    inline T* Pop() {
+        T* head = m_pHead.load(std::memory_order_acquire);
+        while (head && !m_pHead.compare_exchange_weak(head,
+                                                      head->next,
+                                                      std::memory_order_acquire,
+                                                      std::memory_order_acquire)) {
+        }
+        return head;
+    }
+    /** \brief Detaches all items at once, the returned list starts from the youngest item.
+     */
+    inline T* PopAll() {
+        return m_pHead.exchange(NULL, std::memory_order_acquire);
+    }
+    /** \brief Replaces the list, not thread-safe.
+     */
+    inline void Reset(T* head) {
+        m_pHead.store(head, std::memory_order_relaxed);
+    }
+
+protected:
+    std::atomic<T*> m_pHead;
+
+private:
+    msdkLockFreeStack(const msdkLockFreeStack&);
+    void operator=(const msdkLockFreeStack&);
+};
+
+// LIFO list of frame surfaces, surfaces may be added from any thread but taken from one
 class msdkFreeSurfacesPool {
     friend class CBuffering;
 
 public:
-    msdkFreeSurfacesPool(std::mutex& mutex) : m_pSurfaces(NULL), m_rMutex(mutex) {}
+    msdkFreeSurfacesPool() : m_Surfaces() {}
 
-    ~msdkFreeSurfacesPool() {
-        m_pSurfaces = NULL;
-    }
     /** \brief The function adds free surface to the free surfaces array.
      *
      * @note That's caller responsibility to pass valid surface.
@@ -72,46 +118,27 @@ public:
      * will be actually used we have good chance to avoid actual allocation of the surface memory.
      */
     inline void AddSurface(msdkFrameSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        AddSurfaceUnsafe(surface);
+        MSDK_SELF_CHECK(surface);
+        MSDK_SELF_CHECK(!surface->prev);
+        MSDK_SELF_CHECK(!surface->next);
+
+        m_Surfaces.Push(surface);
     }
     /** \brief The function gets the next free surface from the free surfaces array.
      *
      * @note Surface is detached from the free surfaces array.
      */
     inline msdkFrameSurface* GetSurface() {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        return GetSurfaceUnsafe();
-    }
-
-private:
-    inline void AddSurfaceUnsafe(msdkFrameSurface* surface) {
-        msdkFrameSurface* head;
-
-        MSDK_SELF_CHECK(surface);
-        MSDK_SELF_CHECK(!surface->prev);
-        MSDK_SELF_CHECK(!surface->next);
+        msdkFrameSurface* surface = m_Surfaces.Pop();
 
-        head              = m_pSurfaces;
-        m_pSurfaces       = surface;
-        m_pSurfaces->next = head;
-    }
-    inline msdkFrameSurface* GetSurfaceUnsafe() {
-        msdkFrameSurface* surface = NULL;
-
-        if (m_pSurfaces) {
-            surface       = m_pSurfaces;
-            m_pSurfaces   = m_pSurfaces->next;
+        if (surface) {
             surface->prev = surface->next = NULL;
-            MSDK_SELF_CHECK(!surface->prev);
-            MSDK_SELF_CHECK(!surface->next);
         }
         return surface;
     }
 
 protected:
-    msdkFrameSurface* m_pSurfaces;
-    std::mutex& m_rMutex;
+    msdkLockFreeStack<msdkFrameSurface> m_Surfaces;
 
 private:
     msdkFreeSurfacesPool(const msdkFreeSurfacesPool&);
@@ -208,16 +235,20 @@ private:
     void operator=(const msdkUsedSurfacesPool&);
 };
 
-// FIFO list of surfaces
+/** \brief FIFO list of surfaces, surfaces may be added from any thread but taken from one.
+ *
+ * Added surfaces are pushed to the lock-free stack. The taking thread detaches the whole stack
+ * when its own list runs out and appends it in reverse, i.e. in the order of addition.
+ */
 class msdkOutputSurfacesPool {
     friend class CBuffering;
 
 public:
-    msdkOutputSurfacesPool(std::mutex& mutex)
+    msdkOutputSurfacesPool()
             : m_pSurfacesHead(NULL),
               m_pSurfacesTail(NULL),
-              m_SurfacesCount(0),
-              m_rMutex(mutex) {}
+              m_AddedSurfaces(),
+              m_SurfacesCount(0) {}
 
     ~msdkOutputSurfacesPool() {
         m_pSurfacesHead = NULL;
@@ -225,36 +256,18 @@ public:
     }
 
     inline void AddSurface(msdkOutputSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        AddSurfaceUnsafe(surface);
-    }
-    inline msdkOutputSurface* GetSurface() {
-        std::lock_guard<std::mutex> lock(m_rMutex);
-        return GetSurfaceUnsafe();
-    }
-
-    inline mfxU32 GetSurfaceCount() {
-        return m_SurfacesCount;
-    }
-
-private:
-    inline void AddSurfaceUnsafe(msdkOutputSurface* surface) {
         MSDK_SELF_CHECK(surface);
         MSDK_SELF_CHECK(!surface->next);
-        surface->next = NULL;
 
-        if (m_pSurfacesTail) {
-            m_pSurfacesTail->next = surface;
-            m_pSurfacesTail       = m_pSurfacesTail->next;
-        }
-        else {
-            m_pSurfacesHead = m_pSurfacesTail = surface;
-        }
+        m_AddedSurfaces.Push(surface);
         ++m_SurfacesCount;
     }
-    inline msdkOutputSurface* GetSurfaceUnsafe() {
+    inline msdkOutputSurface* GetSurface() {
         msdkOutputSurface* surface = NULL;
 
+        if (!m_pSurfacesHead) {
+            TakeAddedSurfaces();
+        }
         if (m_pSurfacesHead) {
             surface         = m_pSurfacesHead;
             m_pSurfacesHead = m_pSurfacesHead->next;
@@ -269,11 +282,30 @@ private:
         return surface;
     }
 
+    inline mfxU32 GetSurfaceCount() {
+        return m_SurfacesCount;
+    }
+
+private:
+    inline void TakeAddedSurfaces() {
+        msdkOutputSurface* added = m_AddedSurfaces.PopAll();
+
+        if (added) {
+            m_pSurfacesTail = added;
+        }
+        while (added) {
+            msdkOutputSurface* next = added->next;
+            added->next             = m_pSurfacesHead;
+            m_pSurfacesHead         = added;
+            added                   = next;
+        }
+    }
+
 protected:
-    msdkOutputSurface* m_pSurfacesHead; // oldest surface
-    msdkOutputSurface* m_pSurfacesTail; // youngest surface
-    mfxU32 m_SurfacesCount;
-    std::mutex& m_rMutex;
+    msdkOutputSurface* m_pSurfacesHead; // oldest surface, owned by the taking thread
+    msdkOutputSurface* m_pSurfacesTail; // youngest surface of m_pSurfacesHead list
+    msdkLockFreeStack<msdkOutputSurface> m_AddedSurfaces; // surfaces not taken yet, youngest first
+    std::atomic<mfxU32> m_SurfacesCount;
 
 private:
     msdkOutputSurfacesPool(const msdkOutputSurfacesPool&);
@@ -311,39 +343,25 @@ protected: // functions
         return (msdkFrameSurface*)(frame);
     }
 
-    inline void AddFreeOutputSurfaceUnsafe(msdkOutputSurface* surface) {
-        msdkOutputSurface* head = m_pFreeOutputSurfaces;
-
+    inline void AddFreeOutputSurface(msdkOutputSurface* surface) {
         MSDK_SELF_CHECK(surface);
         MSDK_SELF_CHECK(!surface->next);
-        m_pFreeOutputSurfaces       = surface;
-        m_pFreeOutputSurfaces->next = head;
-    }
-    inline void AddFreeOutputSurface(msdkOutputSurface* surface) {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        AddFreeOutputSurfaceUnsafe(surface);
-    }
 
-    inline msdkOutputSurface* GetFreeOutputSurfaceUnsafe(std::unique_lock<std::mutex>& lock) {
-        msdkOutputSurface* surface = NULL;
+        m_FreeOutputSurfaces.Push(surface);
+    }
+    inline msdkOutputSurface* GetFreeOutputSurface() {
+        msdkOutputSurface* surface = m_FreeOutputSurfaces.Pop();
 
-        if (!m_pFreeOutputSurfaces) {
-            lock.unlock();
+        if (!surface) {
             AllocOutputBuffer();
-            lock.lock();
+            surface = m_FreeOutputSurfaces.Pop();
         }
-        if (m_pFreeOutputSurfaces) {
-            surface               = m_pFreeOutputSurfaces;
-            m_pFreeOutputSurfaces = m_pFreeOutputSurfaces->next;
-            surface->next         = NULL;
+        if (surface) {
+            surface->next = NULL;
             MSDK_SELF_CHECK(!surface->next);
         }
         return surface;
     }
-    inline msdkOutputSurface* GetFreeOutputSurface() {
-        std::unique_lock<std::mutex> lock(m_Mutex);
-        return GetFreeOutputSurfaceUnsafe(lock);
-    }
 
     /** \brief Function returns surface data to the corresponding buffers.
      */
@@ -365,7 +383,7 @@ protected: // variables
     mfxU32 m_OutputSurfacesNumber;
     msdkFrameSurface* m_pSurfaces;
     msdkFrameSurface* m_pVppSurfaces;
-    std::mutex m_Mutex;
+    std::mutex m_Mutex; // guards used surfaces pools, other pools are lock-free
 
     // LIFO list of frame surfaces
     msdkFreeSurfacesPool m_FreeSurfacesPool;
@@ -376,7 +394,7 @@ protected: // variables
     msdkUsedSurfacesPool m_UsedVppSurfacesPool;
 
     // LIFO list of output surfaces
-    msdkOutputSurface* m_pFreeOutputSurfaces;
+    msdkLockFreeStack<msdkOutputSurface> m_FreeOutputSurfaces;
 
     // FIFO list of surfaces
     msdkOutputSurfacesPool m_OutputSurfacesPool;
@@ -23,13 +23,12 @@ static inline __itt_domain* mfx_itt_get_domain() {
 
 class MFX_ITT_Tracer {
 public:
-    MFX_ITT_Tracer(const char* trace_name) {
+    MFX_ITT_Tracer(const char* trace_name)
+            : MFX_ITT_Tracer(__itt_string_handle_create(trace_name)) {}
+    MFX_ITT_Tracer(__itt_string_handle* trace_name) {
         m_domain = mfx_itt_get_domain();
         if (m_domain)
-            __itt_task_begin(m_domain,
-                             __itt_null,
-                             __itt_null,
-                             __itt_string_handle_create(trace_name));
+            __itt_task_begin(m_domain, __itt_null, __itt_null, trace_name);
     }
     ~MFX_ITT_Tracer() {
         if (m_domain)
@@ -39,10 +38,35 @@ public:
 private:
     __itt_domain* m_domain;
 };
-    #define MFX_ITT_TASK(x) MFX_ITT_Tracer __mfx_itt_tracer(x);
+
+// 64-bit counter of the MFX_SAMPLES domain shown next to the tasks
+class MFX_ITT_Counter {
+public:
+    MFX_ITT_Counter(const char* counter_name) {
+        m_counter = __itt_counter_create(counter_name, "MFX_SAMPLES");
+    }
+    void Set(unsigned long long value) {
+        if (m_counter)
+            __itt_counter_set_value(m_counter, &value);
+    }
+
+private:
+    __itt_counter m_counter;
+};
+
+    // names are literals, their handles are created once per call site
+    #define MFX_ITT_TASK(x)                                                         \
+        static __itt_string_handle* __mfx_itt_name = __itt_string_handle_create(x); \
+        MFX_ITT_Tracer __mfx_itt_tracer(__mfx_itt_name);
+    #define MFX_ITT_COUNTER(x, value)                           \
+        {                                                       \
+            static MFX_ITT_Counter __mfx_itt_counter(x);        \
+            __mfx_itt_counter.Set((unsigned long long)(value)); \
+        }
 
 #else
     #define MFX_ITT_TASK(x)
+    #define MFX_ITT_COUNTER(x, value)
 #endif
 
 #endif //__MFX_ITT_TRACE_H__
@@ -0,0 +1,178 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __MUX_WRITER_H__
+#define __MUX_WRITER_H__
+
+#include <vector>
+
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+enum MuxContainer {
+    MUX_NONE = 0, // elementary stream
+    MUX_MPEG_TS,
+    MUX_FMP4
+};
+
+// container of the output file by its extension: .ts for MPEG-TS, .mp4 for fragmented MP4
+MuxContainer GetMuxContainer(const msdk_char* strFileName);
+
+// Writes AVC or HEVC access units of the encoder into a container in process. Time stamps of
+// the bitstream are used (90 kHz), they are generated from the frame rate if the encoder doesn't
+// deliver them. Output is collected in memory and written once per segment, which starts at
+// every random access point, or once the buffered data exceeds the flush size.
+class CMuxWriter : public CSmplBitstreamWriter {
+public:
+    CMuxWriter();
+
+    using CSmplBitstreamWriter::Init;
+    virtual mfxStatus Init(const msdk_char* strFileName,
+                           mfxU32 codecId,
+                           mfxU32 frameRateExtN,
+                           mfxU32 frameRateExtD);
+    virtual mfxStatus WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                     bool isPrint         = true,
+                                     bool isCompleteFrame = true);
+    virtual mfxStatus Reset();
+    virtual void Close();
+
+protected:
+    struct NalUnit {
+        mfxU32 offset; // payload after the start code
+        mfxU32 size;
+        mfxU8 type;
+    };
+
+    virtual mfxStatus WriteAccessUnit(const mfxU8* pData,
+                                      mfxU32 size,
+                                      mfxI64 pts,
+                                      mfxI64 dts,
+                                      bool bKey) = 0;
+    // called on close and reset to complete pending segment of the container
+    virtual mfxStatus FinishSegment() = 0;
+    virtual void ResetState();
+
+    mfxStatus MuxAccessUnit(const mfxU8* pData, mfxU32 size, mfxU64 timeStamp, mfxI64 dts);
+    void ParseNalUnits(const mfxU8* pData, mfxU32 size);
+    bool IsParameterSet(mfxU8 type) const;
+
+    void Put8(mfxU8 value) {
+        m_out.push_back(value);
+    }
+    void Put16(mfxU16 value);
+    void Put32(mfxU32 value);
+    void Put64(mfxU64 value);
+    void PutBytes(const mfxU8* pData, size_t size) {
+        m_out.insert(m_out.end(), pData, pData + size);
+    }
+    mfxStatus Flush();
+
+    mfxU32 m_codecId;
+    mfxI64 m_frameDuration;
+    std::vector<NalUnit> m_nals;
+    std::vector<mfxU8> m_out;
+    mfxU64 m_firstTimeStamp;
+    bool m_bGenerateTimeStamps;
+    mfxI64 m_lastDts;
+    mfxU64 m_nAccessUnits;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CMuxWriter);
+};
+
+// ISO/IEC 13818-1 transport stream of one video program, PAT and PMT are repeated and PCR is sent
+// at every random access point
+class CTSMuxWriter : public CMuxWriter {
+public:
+    CTSMuxWriter();
+    virtual ~CTSMuxWriter();
+
+protected:
+    virtual mfxStatus WriteAccessUnit(const mfxU8* pData,
+                                      mfxU32 size,
+                                      mfxI64 pts,
+                                      mfxI64 dts,
+                                      bool bKey);
+    virtual mfxStatus FinishSegment();
+    virtual void ResetState();
+
+    void WriteSection(mfxU16 pid, const mfxU8* pSection, mfxU32 size);
+    void WritePES(const mfxU8* pPesHeader,
+                  mfxU32 headerSize,
+                  const mfxU8* pData,
+                  mfxU32 size,
+                  mfxI64 pcr,
+                  bool bKey);
+    mfxU8 NextCounter(mfxU16 pid);
+
+    mfxU8 m_ccPAT;
+    mfxU8 m_ccPMT;
+    mfxU8 m_ccVideo;
+    std::vector<mfxU8> m_pes; // access unit with AUD inserted
+};
+
+// ISO/IEC 14496-12 fragmented MP4 with one video track, init segment is written on the first
+// access unit from its parameter sets and then every segment is a moof and mdat pair
+class CMP4FragmentWriter : public CMuxWriter {
+public:
+    CMP4FragmentWriter();
+    virtual ~CMP4FragmentWriter();
+
+protected:
+    // sequence parameters needed for the sample entry
+    struct SequenceInfo {
+        mfxU16 width;
+        mfxU16 height;
+        mfxU32 chromaFormat;
+        mfxU32 bitDepthLuma;
+        mfxU32 bitDepthChroma;
+        // general profile_tier_level of HEVC
+        mfxU8 profile;
+        mfxU32 compatibility;
+        mfxU8 constraints[6];
+        mfxU8 level;
+        mfxU32 maxSubLayersMinus1;
+        mfxU32 temporalIdNesting;
+    };
+
+    struct Sample {
+        mfxU32 size;
+        mfxI64 pts;
+        mfxI64 dts;
+        bool bKey;
+    };
+
+    virtual mfxStatus WriteAccessUnit(const mfxU8* pData,
+                                      mfxU32 size,
+                                      mfxI64 pts,
+                                      mfxI64 dts,
+                                      bool bKey);
+    virtual mfxStatus FinishSegment();
+    virtual void ResetState();
+
+    mfxStatus WriteInitSegment(const mfxU8* pData);
+    void ParseAVCSequence(const mfxU8* pSps, mfxU32 size);
+    void ParseHEVCSequence(const mfxU8* pSps, mfxU32 size);
+    void WriteSampleEntry(const mfxU8* pData);
+    mfxStatus WriteFragment(mfxI64 nextDts);
+
+    size_t BeginBox(const char* type);
+    size_t BeginFullBox(const char* type, mfxU8 version, mfxU32 flags);
+    void EndBox(size_t start);
+
+    bool m_bInitSegment;
+    SequenceInfo m_seq;
+    mfxU32 m_nFragments;
+    mfxI64 m_baseDts; // decode time of the first sample is 0 in the track
+    std::vector<Sample> m_samples;
+    std::vector<mfxU8> m_mdat; // samples of the fragment with length prefixed NAL units
+};
+
+// creates writer of the container, NULL for MUX_NONE
+CMuxWriter* CreateMuxWriter(MuxContainer container);
+
+#endif //__MUX_WRITER_H__
@@ -4,10 +4,18 @@
   # SPDX-License-Identifier: MIT
   ############################################################################*/
 
+#include <vector>
 #include "sample_defs.h"
 
 #pragma once
-enum EPresetModes { PRESET_DEFAULT, PRESET_DSS, PRESET_CONF, PRESET_GAMING, PRESET_MAX_MODES };
+enum EPresetModes {
+    PRESET_DEFAULT,
+    PRESET_DSS,
+    PRESET_CONF,
+    PRESET_GAMING,
+    PRESET_FAST_START,
+    PRESET_MAX_MODES
+};
 
 enum EPresetCodecs { PRESET_AVC, PRESET_HEVC, PRESET_MAX_CODECS };
 
@@ -35,6 +43,8 @@ struct CPresetParameters {
     bool EnableBPyramid;
     bool EnablePPyramid;
     //    bool EnableLTR;
+
+    mfxU16 LowPower;
 };
 
 struct CDependentPresetParameters {
@@ -85,6 +95,7 @@ public:
 
     static CPresetManager Inst;
     static EPresetModes PresetNameToMode(const msdk_char* name);
+    static msdk_string PresetModeToName(EPresetModes mode);
 
 protected:
     CPresetManager();
@@ -92,6 +103,42 @@ protected:
     static msdk_string modesName[PRESET_MAX_MODES];
 };
 
+// Throughput of a preset with the target usage measured on a device
+struct CPresetMeasurement {
+    msdk_string Device; // implementation and device ID, no spaces
+    mfxU32 CodecId;
+    EPresetModes Mode;
+    mfxU16 TargetUsage;
+    mfxU32 Width;
+    mfxU32 Height;
+    mfxF64 Fps;
+    mfxF64 LatencyP99; // ms
+};
+
+// Measurements of the presets kept in a text file, one line per measurement. The preset for a
+// throughput target is selected from them, quality of the presets is ranked by target usage.
+class CPresetProfile {
+public:
+    // MFX_ERR_NOT_FOUND is returned if there is no file
+    mfxStatus Load(const msdk_char* fileName);
+    mfxStatus Save(const msdk_char* fileName) const;
+
+    // replaces the measurement of the same preset, target usage and resolution on the device
+    void Add(const CPresetMeasurement& measurement);
+
+    // the best quality measurement reaching the fps with the resolution, throughput is scaled by
+    // the number of pixels from the measured resolution
+    bool Select(const msdk_string& device,
+                mfxU32 codecId,
+                mfxU32 width,
+                mfxU32 height,
+                mfxF64 fps,
+                CPresetMeasurement& result) const;
+
+protected:
+    std::vector<CPresetMeasurement> m_Measurements;
+};
+
 #define MODIFY_AND_PRINT_PARAM(paramName, presetName, shouldPrintPresetInfo)             \
     if (!paramName) {                                                                    \
         paramName = presetParams.presetName;                                             \
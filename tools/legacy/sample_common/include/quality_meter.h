@@ -0,0 +1,110 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __QUALITY_METER_H__
+#define __QUALITY_METER_H__
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_band_executor.h"
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+// Measures objective quality of the encoded output in the pipeline. The output bitstream is decoded
+// again in the session given to Open() and every decoded frame is compared with the copy of the
+// encoder input of the same display order: PSNR of Y, U and V and SSIM of Y over 8x8 blocks.
+// Decoding, comparison and writing of the per frame CSV file are done by a background thread, the
+// comparison is split into bands over the CPU threads, so the transcoding thread only copies frames
+// and bitstreams. 8 bit 4:2:0 (NV12) input is supported, decoding needs API 2.0 internal memory.
+class CQualityMeter {
+public:
+    // averages over the compared frames
+    struct Summary {
+        mfxU32 Frames;
+        mfxF64 PSNRY;
+        mfxF64 PSNRU;
+        mfxF64 PSNRV;
+        mfxF64 SSIMY;
+    };
+
+    CQualityMeter();
+    ~CQualityMeter();
+
+    // the session is used by the background thread only and must outlive Close()
+    mfxStatus Open(const msdk_char* fileName, MFXVideoSession* pSession, mfxU32 codecId);
+    void Close();
+    bool IsOpen() const {
+        return m_thread.joinable();
+    }
+
+    // copies the frame submitted to the encoder, the surface must be mapped
+    mfxStatus AddSource(const mfxFrameSurface1& surface);
+    // copies encoded data of the synchronized bitstream
+    void AddBitstream(const mfxBitstream& bs);
+    // decodes the frames buffered in the decoder and waits until all frames given so far are
+    // compared, the next bitstream is decoded from a new header
+    void Flush();
+
+    Summary GetSummary() const;
+
+protected:
+    // NV12 planes of the crop rectangle without padding
+    struct Frame {
+        mfxU16 Width;
+        mfxU16 Height;
+        std::vector<mfxU8> Y;
+        std::vector<mfxU8> UV; // (Width + 1) / 2 pairs per row
+    };
+
+    // sums of a band of 8 luma rows
+    struct BandSums {
+        mfxU64 SSE[3];
+        mfxF64 SSIM;
+        mfxU32 Blocks;
+    };
+
+    void WorkerRoutine();
+    void Decode(bool bDrain);
+    void Compare(const mfxFrameSurface1& decoded);
+    void CompareBand(const Frame& src,
+                     const mfxFrameSurface1& decoded,
+                     mfxU32 band,
+                     BandSums& sums) const;
+
+    FILE* m_file;
+    mfxU32 m_nCodecId;
+    MFXVideoSession* m_pSession;
+    std::unique_ptr<MFXVideoDECODE> m_pDEC;
+    bool m_bDecoderInit;
+    mfxBitstreamWrapper m_Bitstream; // used by the background thread
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvQueued;
+    std::condition_variable m_cvFlushed;
+    std::vector<mfxU8> m_Queue; // encoded data not given to the decoder yet
+    std::deque<std::unique_ptr<Frame>> m_Sources;
+    mfxU64 m_nFlushRequests;
+    mfxU64 m_nFlushes;
+    bool m_bStop;
+
+    CFrameBandExecutor m_Executor;
+    std::vector<BandSums> m_Bands;
+
+    Summary m_Totals; // sums of the per frame values
+    mfxU32 m_nMissing; // decoded frames without source and vice versa
+    mfxU32 m_nErrors;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CQualityMeter);
+};
+
+#endif //__QUALITY_METER_H__
@@ -0,0 +1,64 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __ROUNDING_OFFSET_READER_H__
+#define __ROUNDING_OFFSET_READER_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+// Reads per-field AVC rounding offsets of the rounding offset file on a dedicated thread into
+// a ring of preallocated records, so encode submission only copies them into the encode control
+// of the frame. Every field is EnableRoundingIntra, RoundingOffsetIntra, EnableRoundingInter and
+// RoundingOffsetInter as mfxU16, 2 fields per frame for interlaced encoding.
+class CAsyncRoundingOffsetReader {
+public:
+    CAsyncRoundingOffsetReader();
+    ~CAsyncRoundingOffsetReader();
+
+    // offsets of up to nFrames frames are read ahead of the caller
+    mfxStatus Init(const msdk_char* strFileName, mfxU32 nFrames);
+    void Close();
+
+    bool IsOpen() const {
+        return m_file != nullptr;
+    }
+
+    // waits for the offsets of the next numFields fields and sets them to the
+    // mfxExtAVCRoundingOffset buffers of ctrl, MFX_ERR_MORE_DATA at the end of file
+    mfxStatus GetNextFrame(mfxEncodeCtrlWrap& ctrl, mfxU32 numFields);
+
+protected:
+    struct FieldOffsets {
+        mfxU16 EnableRoundingIntra;
+        mfxU16 RoundingOffsetIntra;
+        mfxU16 EnableRoundingInter;
+        mfxU16 RoundingOffsetInter;
+    };
+
+    void ReaderRoutine();
+
+    FILE* m_file;
+    std::vector<FieldOffsets> m_ring;
+    mfxU64 m_nRead; // fields taken by the caller
+    mfxU64 m_nReady; // fields read from the file
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    std::condition_variable m_cvReady;
+    std::thread m_thread;
+    bool m_bStop;
+    bool m_bEOS;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CAsyncRoundingOffsetReader);
+};
+
+#endif //__ROUNDING_OFFSET_READER_H__
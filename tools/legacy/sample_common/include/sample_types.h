@@ -10,9 +10,11 @@
 #ifdef UNICODE
     #define msdk_cout std::wcout
     #define msdk_err  std::wcerr
+    #define msdk_cin  std::wcin
 #else
     #define msdk_cout std::cout
     #define msdk_err  std::cerr
+    #define msdk_cin  std::cin
 #endif
 
 typedef std::basic_string<msdk_char> msdk_string;
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <algorithm>
+#include <deque>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -26,6 +27,7 @@
 #include "mfxdeprecated.h"
 #include "mfxplugin.h"
 #include "vpl/mfxbrc.h"
+#include "vpl/mfxencodestats.h"
 #include "vpl/mfxjpeg.h"
 #include "vpl/mfxmvc.h"
 #include "vpl/mfxstructures.h"
@@ -34,6 +36,7 @@
 
 #include "vm/atomic_defs.h"
 #include "vm/file_defs.h"
+#include "vm/stream_defs.h"
 #include "vm/strings_defs.h"
 #include "vm/thread_defs.h"
 #include "vm/time_defs.h"
@@ -41,10 +44,12 @@
 #include "sample_types.h"
 
 #include "abstract_splitter.h"
+#include "av1_spl.h"
 #include "avc_bitstream.h"
 #include "avc_headers.h"
 #include "avc_nal_spl.h"
 #include "avc_spl.h"
+#include "hevc_spl.h"
 #include "vpl_implementation_loader.h"
 
 #include "vpl/mfxsurfacepool.h"
@@ -438,6 +443,10 @@ struct mfx_ext_buffer_id<mfxExtVPPColorFill> {
     enum { id = MFX_EXTBUFF_VPP_COLORFILL };
 };
 template <>
+struct mfx_ext_buffer_id<mfxExtVPP3DLut> {
+    enum { id = MFX_EXTBUFF_VPP_3DLUT };
+};
+template <>
 struct mfx_ext_buffer_id<mfxExtVPPRotation> {
     enum { id = MFX_EXTBUFF_VPP_ROTATION };
 };
@@ -458,9 +467,19 @@ struct mfx_ext_buffer_id<mfxExtHyperModeParam> {
     enum { id = MFX_EXTBUFF_HYPER_MODE_PARAM };
 };
 template <>
+struct mfx_ext_buffer_id<mfxExtAVCEncodedFrameInfo> {
+    enum { id = MFX_EXTBUFF_ENCODED_FRAME_INFO };
+};
+template <>
 struct mfx_ext_buffer_id<mfxExtAllocationHints> {
     enum { id = MFX_EXTBUFF_ALLOCATION_HINTS };
 };
+#ifdef ONEVPL_EXPERIMENTAL
+template <>
+struct mfx_ext_buffer_id<mfxExtEncodeStatsOutput> {
+    enum { id = MFX_EXTBUFF_ENCODESTATS };
+};
+#endif
 
 constexpr uint16_t max_num_ext_buffers =
     63 * 2; // '*2' is for max estimation if all extBuffer were 'paired'
@@ -778,12 +797,62 @@ public:
     mfxU32 m_ColorFormat; // color format of input YUV data, YUV420 or NV12
 
 protected:
+    // all file data of the frames is read here, returns number of complete items like fread
+    virtual size_t ReadData(void* pDst, size_t size, size_t count, mfxU32 vid);
+
     std::vector<FILE*> m_files;
+    std::vector<mfxU8> m_ChromaBuffer; // planar chroma of the file to interleave into NV12
 
     bool shouldShift10BitsHigh;
     bool m_bInited;
 };
 
+// reads the first input ahead of the caller on a dedicated thread into a ring of chunks, frames
+// are converted into surfaces from the chunks on the caller's thread
+class CAsyncYUVReader : public CSmplYUVReader {
+public:
+    explicit CAsyncYUVReader(mfxU32 nChunkSize = 4 * 1024 * 1024, mfxU32 nChunks = 4);
+    virtual ~CAsyncYUVReader();
+
+    // takes effect on the next Init, 0 chunks disables the reading thread
+    void SetReadAhead(mfxU32 nChunkSize, mfxU32 nChunks);
+
+    virtual void Close();
+    virtual mfxStatus Init(std::list<msdk_string> inputs,
+                           mfxU32 ColorFormat,
+                           bool shouldShiftP010 = false);
+    virtual mfxStatus SkipNframesFromBeginning(mfxU16 w, mfxU16 h, mfxU32 viewId, mfxU32 nframes);
+    virtual void Reset();
+
+protected:
+    virtual size_t ReadData(void* pDst, size_t size, size_t count, mfxU32 vid);
+    bool NextChunk();
+    void StartReading();
+    void StopReading();
+    void ReaderRoutine();
+
+    struct Chunk {
+        std::vector<mfxU8> Data;
+        size_t Size;
+    };
+
+    mfxU32 m_nChunkSize;
+    mfxU32 m_nChunks;
+    Chunk m_CurChunk;
+    size_t m_nCurOffset;
+    std::vector<std::vector<mfxU8>> m_FreeChunks;
+    std::deque<Chunk> m_ReadyChunks;
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    std::condition_variable m_cvReady;
+    std::thread m_thread;
+    bool m_bStop;
+    bool m_bEOS;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CAsyncYUVReader);
+};
+
 class CSmplBitstreamWriter {
 public:
     CSmplBitstreamWriter();
@@ -803,6 +872,9 @@ protected:
     FILE* m_fSource;
     bool m_bInited;
     msdk_string m_sFile;
+    // partial output of the current frame is written as soon as it is given, the encoder appends
+    // the next parts to the same bitstream, so only bytes after the written ones are new
+    mfxU32 m_nPartialBytes;
 };
 
 class CSmplYUVWriter {
@@ -819,13 +891,70 @@ public:
     void SetMultiView() {
         m_bIsMultiView = true;
     }
+    // frames are read with SSE4.1 streaming loads if the CPU has them, for surfaces locked from
+    // video memory, their mappings are write-combined or uncached and slow to read otherwise
+    void SetStreamingLoads(bool bStreamingLoads);
 
 protected:
+    // frame is converted plane by plane into the staging buffer and written with one call
+    void StagePlane(const mfxU8* pSrc, mfxU32 pitch, mfxU32 rowBytes, mfxU32 rows);
+    // 16-bit samples are shifted right to the lower bits
+    void StagePlaneShifted(const mfxU8* pSrc,
+                           mfxU32 pitch,
+                           mfxU32 rowSamples,
+                           mfxU32 rows,
+                           mfxU32 shift);
+    // every second byte of the rows starting from the first one
+    void StagePlaneDeinterleaved(const mfxU8* pSrc, mfxU32 pitch, mfxU32 rowSamples, mfxU32 rows);
+    mfxU8* ReserveStaging(size_t size);
+    // the row itself or its copy in m_Row made with streaming loads
+    const mfxU8* FetchRow(const mfxU8* pSrc, size_t size);
+    virtual mfxStatus WriteStaged(FILE* dstFile);
+
     FILE *m_fDest, **m_fDestMVC;
     bool m_bInited, m_bIsMultiView;
     mfxU32 m_numCreatedFiles;
     msdk_string m_sFile;
     mfxU32 m_nViews;
+    std::vector<mfxU8> m_Staging;
+    size_t m_nStaged;
+    bool m_bStreamingLoads;
+    std::vector<mfxU8> m_Row;
+};
+
+// writes staged frames on a dedicated thread while the caller converts the next ones, write
+// errors are returned by the following calls
+class CAsyncYUVWriter : public CSmplYUVWriter {
+public:
+    explicit CAsyncYUVWriter(mfxU32 nBuffers = 3);
+    virtual ~CAsyncYUVWriter();
+
+    virtual void Close();
+    virtual mfxStatus Init(const msdk_char* strFileName, const mfxU32 numViews);
+
+protected:
+    virtual mfxStatus WriteStaged(FILE* dstFile);
+    void StartWriting();
+    void StopWriting();
+    void WriterRoutine();
+
+    struct StagedFrame {
+        FILE* pFile;
+        std::vector<mfxU8> Data;
+        size_t Size;
+    };
+
+    std::vector<std::vector<mfxU8>> m_FreeBuffers;
+    std::deque<StagedFrame> m_ReadyFrames;
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    std::condition_variable m_cvReady;
+    std::thread m_thread;
+    bool m_bStop;
+    mfxStatus m_WriteSts;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CAsyncYUVWriter);
 };
 
 class CSmplBitstreamReader {
@@ -833,28 +962,158 @@ public:
     CSmplBitstreamReader();
     virtual ~CSmplBitstreamReader();
 
-    //resets position to file begin
+    //resets position to file begin, streams (see stream_defs.h) aren't rewound
     virtual void Reset();
     virtual void Close();
     virtual mfxStatus Init(const msdk_char* strFileName);
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+    // only the bytes [nBegin, nEnd) of the file are read from now on and after resets, nEnd 0
+    // reads to the end of file. Supported by this reader and CIVFFrameReader, whose ranges begin
+    // at frame headers.
+    virtual mfxStatus SetRange(mfxU64 nBegin, mfxU64 nEnd);
 
 protected:
     FILE* m_fSource;
     bool m_bInited;
+    bool m_bStream;
+    mfxU64 m_nRangeBegin;
+    mfxU64 m_nRangeEnd;
+};
+
+// reads bitstream ahead on a dedicated thread: the next chunks of the file are ready
+// in memory when the caller needs more data
+class CPrefetchBitstreamReader : public CSmplBitstreamReader {
+public:
+    explicit CPrefetchBitstreamReader(mfxU32 nChunkSize = 1024 * 1024, mfxU32 nChunks = 8);
+    virtual ~CPrefetchBitstreamReader();
+
+    virtual void Close();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+protected:
+    bool NextChunk(bool bWait, bool& bEndOfStream);
+    void StartReading();
+    void StopReading();
+    void ReaderRoutine();
+
+    mfxU32 m_nChunkSize;
+    std::vector<mfxU8> m_CurChunk;
+    size_t m_nCurOffset;
+    std::vector<std::vector<mfxU8>> m_FreeChunks;
+    std::deque<std::vector<mfxU8>> m_ReadyChunks;
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    std::condition_variable m_cvReady;
+    std::thread m_thread;
+    bool m_bStop;
+    bool m_bEndOfFile;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CPrefetchBitstreamReader);
+};
+
+// loads the whole file to memory in Init(), so reading and looping of the input cost no file I/O
+class CMemoryBitstreamReader : public CSmplBitstreamReader {
+public:
+    CMemoryBitstreamReader();
+    virtual ~CMemoryBitstreamReader();
+
+    virtual void Close();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+protected:
+    std::vector<mfxU8> m_Data;
+    size_t m_nOffset;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CMemoryBitstreamReader);
+};
+
+// maps the whole file to memory, pages are loaded on the first access. The mapping is private:
+// writes to it are not propagated to the file
+class CSmplFileMapping {
+public:
+    CSmplFileMapping();
+    ~CSmplFileMapping();
+
+    mfxStatus Map(FILE* pFile);
+    void Unmap();
+
+    mfxU8* GetData() const {
+        return m_pData;
+    }
+    size_t GetSize() const {
+        return m_nSize;
+    }
+
+protected:
+    mfxU8* m_pData;
+    size_t m_nSize;
+#if defined(_WIN32) || defined(_WIN64)
+    void* m_hMapping;
+#endif
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CSmplFileMapping);
+};
+
+// zero-copy reader: ReadNextFrame() points mfxBitstream::Data to the mapped file and only moves
+// the window of data handed out, the caller's buffer isn't used. Data is kept between calls only
+// while the bitstream refers to the last window, e.g. data left in the bitstream when the reader
+// is reset is dropped
+class CMappedBitstreamReader : public CSmplBitstreamReader {
+public:
+    explicit CMappedBitstreamReader(mfxU32 nWindowSize = 16 * 1024 * 1024);
+    virtual ~CMappedBitstreamReader();
+
+    virtual void Close();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+protected:
+    CSmplFileMapping m_Mapping;
+    mfxU32 m_nWindowSize;
+    // end of the data handed out
+    size_t m_nOffset;
+    // last window handed out and its position in the file
+    mfxU8* m_pView;
+    size_t m_nViewOffset;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CMappedBitstreamReader);
 };
 
 class CH264FrameReader : public CSmplBitstreamReader {
 public:
-    CH264FrameReader();
+    // in indexed mode the file is mapped to memory and frame boundaries are found in Init(), so
+    // ReadNextFrame() points mfxBitstream::Data to the next frame in the mapping without copying
+    explicit CH264FrameReader(bool bIndexFrames = false);
     virtual ~CH264FrameReader();
 
     /** Free resources.*/
     virtual void Close();
+    virtual void Reset();
     virtual mfxStatus Init(const msdk_char* strFileName);
     virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
 
+protected:
+    // splitter of elementary stream to frames, indexed mode works only with AVC_Spl
+    virtual AbstractSplitter* CreateSplitter();
+
 private:
+    mfxStatus BuildFrameIndex();
+
+    bool m_bIndexFrames;
+    CSmplFileMapping m_Mapping;
+    // offsets of frame beginnings in the file, the last one is the end of the last frame
+    std::vector<size_t> m_FrameOffsets;
+    size_t m_nFrame;
+
     mfxBitstream* m_processedBS;
     // input bit stream
     mfxBitstreamWrapper m_originalBS;
@@ -871,6 +1130,18 @@ private:
     mfxBitstream m_outBS;
 };
 
+// provides complete H.265 access units
+class CHEVCFrameReader : public CH264FrameReader {
+protected:
+    virtual AbstractSplitter* CreateSplitter();
+};
+
+// provides complete AV1 temporal units of OBU stream, IVF files are read by CIVFFrameReader
+class CAV1FrameReader : public CH264FrameReader {
+protected:
+    virtual AbstractSplitter* CreateSplitter();
+};
+
 //provides output bistream with at least 1 frame, reports about error
 class CJPEGFrameReader : public CSmplBitstreamReader {
     enum JPEGMarker { SOI = 0xD8FF, EOI = 0xD9FF };
@@ -882,6 +1153,67 @@ protected:
     mfxU32 FindMarker(mfxBitstream* pBS, mfxU32 startOffset, JPEGMarker marker);
 };
 
+// reads a batch of JPEG files listed one per line in the file given to Init(), one complete image
+// per ReadNextFrame(). Images come grouped by chroma subsampling and size instead of in the list
+// order, so the decoder is reset once per group. Files are read ahead on a dedicated thread while
+// the images before them are decoded
+class CJPEGBatchReader : public CSmplBitstreamReader {
+public:
+    explicit CJPEGBatchReader(mfxU32 nPrefetch = 8);
+    virtual ~CJPEGBatchReader();
+
+    virtual void Close();
+    virtual void Reset();
+    virtual mfxStatus Init(const msdk_char* strListFile);
+    virtual mfxStatus ReadNextFrame(mfxBitstream* pBS);
+
+    // of the largest image and file of the batch
+    mfxU16 GetMaxWidth() const {
+        return m_nMaxWidth;
+    }
+    mfxU16 GetMaxHeight() const {
+        return m_nMaxHeight;
+    }
+    mfxU32 GetMaxFileSize() const {
+        return m_nMaxFileSize;
+    }
+
+protected:
+    struct Image {
+        msdk_string FileName;
+        mfxU32 Size;
+        mfxU16 Width;
+        mfxU16 Height;
+        // number of the components and their sampling factors from the frame header
+        mfxU32 Sampling;
+    };
+
+    // parses markers up to the frame header, the entropy-coded data isn't read
+    static mfxStatus ReadImageInfo(Image& image);
+    static mfxStatus ReadImage(const Image& image, std::vector<mfxU8>& data);
+
+    void StartReading();
+    void StopReading();
+    void ReaderRoutine();
+
+    std::vector<Image> m_Images;
+    mfxU32 m_nPrefetch;
+    size_t m_nNextImage; // read next by the reading thread
+    std::deque<std::vector<mfxU8>> m_ReadyImages;
+    std::mutex m_mutex;
+    std::condition_variable m_cvFree;
+    std::condition_variable m_cvReady;
+    std::thread m_thread;
+    bool m_bStop;
+    bool m_bEndOfBatch;
+    mfxU16 m_nMaxWidth;
+    mfxU16 m_nMaxHeight;
+    mfxU32 m_nMaxFileSize;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CJPEGBatchReader);
+};
+
 //appends output bistream with exactly 1 frame, reports about error
 class CIVFFrameReader : public CSmplBitstreamReader {
 public:
@@ -917,20 +1249,101 @@ protected:
     mfxStatus ReadHeader();
 };
 
-// writes bitstream to duplicate-file & supports joining
-// (for ViewOutput encoder mode)
+// writes bitstream to duplicate-files & supports joining
+// (for ViewOutput encoder mode and tee outputs)
+// The file of Init is written on the caller's thread, every duplicate is written from a thread of
+// its own. A frame is copied once and the copy is shared by the queues of all the duplicates, so
+// a slow duplicate holds up the caller only if it blocks when its queue is full.
 class CSmplBitstreamDuplicateWriter : public CSmplBitstreamWriter {
 public:
+    enum Backpressure {
+        BACKPRESSURE_BLOCK, // the caller waits for room in the queue
+        BACKPRESSURE_DROP // the frames are dropped until an I frame finds room in the queue
+    };
+
     CSmplBitstreamDuplicateWriter();
+    virtual ~CSmplBitstreamDuplicateWriter();
 
+    // strDst is a file name or "pipe:<command>" to write to the standard input of the command
+    virtual mfxStatus AddDuplicate(const msdk_char* strDst,
+                                   Backpressure policy = BACKPRESSURE_BLOCK,
+                                   mfxU32 nQueueFrames = 64);
+    // replaces the duplicates with the file
     virtual mfxStatus InitDuplicate(const msdk_char* strFileName);
+    // frames of both writers go to the duplicates of pJoinee in the order they are written
     virtual mfxStatus JoinDuplicate(CSmplBitstreamDuplicateWriter* pJoinee);
-    virtual mfxStatus WriteNextFrame(mfxBitstream* pMfxBitstream, bool isPrint = true);
+    virtual mfxStatus WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                     bool isPrint         = true,
+                                     bool isCompleteFrame = true);
+    virtual void Close();
+
+protected:
+    typedef std::shared_ptr<const std::vector<mfxU8>> FrameData;
+
+    // closed with the last writer sharing it, after all queued frames are written
+    struct sDuplicate {
+        sDuplicate();
+        ~sDuplicate();
+
+        mfxStatus Open(const msdk_char* strDst, Backpressure backpressure, mfxU32 nQueue);
+        mfxStatus Push(const FrameData& frame, mfxU16 frameType);
+        void WriterRoutine();
+
+        msdk_string name;
+        FILE* file;
+        bool bStream;
+        Backpressure policy;
+        mfxU32 nQueueFrames;
+        bool bDropping;
+        mfxU32 nDroppedFrames;
+        std::deque<FrameData> queue;
+        std::mutex mutex;
+        std::condition_variable cvQueued;
+        std::condition_variable cvWritten;
+        std::thread thread;
+        bool bStop;
+        mfxStatus status;
+    };
+
+    std::vector<std::shared_ptr<sDuplicate>> m_Duplicates;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CSmplBitstreamDuplicateWriter);
+};
+
+// writes bitstream from a dedicated thread: frames are copied into large chunks,
+// so the caller waits for the disk only when all chunks are queued for writing
+class CAsyncBitstreamWriter : public CSmplBitstreamWriter {
+public:
+    explicit CAsyncBitstreamWriter(mfxU32 nChunkSize = 4 * 1024 * 1024, mfxU32 nChunks = 8);
+    virtual ~CAsyncBitstreamWriter();
+
+    virtual mfxStatus Init(const msdk_char* strFileName);
+    virtual mfxStatus WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                     bool isPrint         = true,
+                                     bool isCompleteFrame = true);
     virtual void Close();
+    // waits until all written frames reach the file
+    virtual mfxStatus Flush();
 
 protected:
-    FILE* m_fSourceDuplicate;
-    bool m_bJoined;
+    mfxStatus SubmitChunk();
+    void WriterRoutine();
+
+    mfxU32 m_nChunkSize;
+    std::vector<mfxU8> m_CurChunk;
+    std::vector<std::vector<mfxU8>> m_FreeChunks;
+    std::deque<std::vector<mfxU8>> m_QueuedChunks;
+    std::mutex m_mutex;
+    std::condition_variable m_cvQueued;
+    std::condition_variable m_cvWritten;
+    std::thread m_thread;
+    bool m_bStop;
+    bool m_bWriting;
+    mfxStatus m_WriterStatus;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CAsyncBitstreamWriter);
 };
 
 //timeinterval calculation helper
@@ -974,7 +1387,7 @@ public:
             return 0.0;
 
         if (0.0 != g_Freq) {
-            m_start = MSDK_GET_TIME(msdk_time_get_tick(), m_StartTick, g_Freq);
+            m_start = MSDK_GET_TIME(msdk_time_get_precise_tick(), m_StartTick, g_Freq);
         }
         return m_start;
     }
@@ -989,9 +1402,9 @@ public:
 private:
     void Initialize() {
         if (0.0 == g_Freq) {
-            g_Freq = (double)msdk_time_get_frequency();
+            g_Freq = (double)msdk_time_get_precise_frequency();
         }
-        m_StartTick = msdk_time_get_tick();
+        m_StartTick = msdk_time_get_precise_tick();
     }
 };
 
@@ -1343,6 +1756,12 @@ inline mfxStatus msdk_opt_read(const msdk_string& string, T& value) {
     return msdk_opt_read(string.c_str(), value);
 }
 
+// parses list of CPUs in form "0-7,16,18-23"
+mfxStatus msdk_parse_cpu_list(const msdk_char* string, std::vector<mfxU32>& cpus);
+
+// the CPU and the OS support AVX2, false if the build isn't for x86
+bool IsAVX2Supported();
+
 mfxStatus StrFormatToCodecFormatFourCC(msdk_char* strInput, mfxU32& codecFormat);
 msdk_string StatusToString(mfxStatus sts);
 mfxI32 getMonitorType(msdk_char* str);
@@ -1353,27 +1772,37 @@ void WaitForDeviceToBecomeFree(MFXVideoSession& session,
 
 mfxU16 FourCCToChroma(mfxU32 fourCC);
 
+// Frame n is let through at the n-th period from the first one, so the oversleeping for a frame
+// isn't carried over to the next ones and the rate holds at hundreds of fps.
 class FPSLimiter {
 public:
     FPSLimiter()  = default;
     ~FPSLimiter() = default;
     void Reset(mfxU32 fps) {
-        m_delayTicks = fps ? msdk_time_get_frequency() / fps : 0;
+        m_fps       = fps;
+        m_numFrames = 0;
     }
     void Work() {
+        if (!m_fps)
+            return;
+
+        msdk_tick frequency    = msdk_time_get_frequency();
         msdk_tick current_tick = msdk_time_get_tick();
-        while (m_delayTicks && (m_startTick + m_delayTicks > current_tick)) {
-            msdk_tick left_tick = m_startTick + m_delayTicks - current_tick;
-            uint32_t sleepTime  = (uint32_t)(left_tick * 1000 / msdk_time_get_frequency());
-            MSDK_SLEEP(sleepTime);
-            current_tick = msdk_time_get_tick();
-        };
-        m_startTick = msdk_time_get_tick();
+        msdk_tick deadline     = m_startTick + (msdk_tick)(m_numFrames * frequency / m_fps);
+        // short delays are caught up, after a stall the frames aren't let through in a burst
+        if (!m_numFrames || current_tick > deadline + frequency / 10) {
+            m_startTick = current_tick;
+            m_numFrames = 1;
+            return;
+        }
+        msdk_time_wait_until(deadline);
+        m_numFrames++;
     }
 
 protected:
-    msdk_tick m_startTick  = 0;
-    msdk_tick m_delayTicks = 0;
+    mfxU32 m_fps          = 0;
+    mfxU64 m_numFrames    = 0;
+    msdk_tick m_startTick = 0;
 };
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -1391,28 +1820,31 @@ private:
     std::vector<mfxFrameSurface1*> m_Surfaces;
     const mfxU16 m_NumFrameForAlloc;
 
-    bool QueryFree() {
-        std::lock_guard<std::mutex> lock(m_mutexSurface);
-        if (m_Surfaces.size() < m_NumFrameForAlloc) {
-            return true;
-        }
-        else {
-            for (std::vector<mfxFrameSurface1*>::iterator it = m_Surfaces.begin();
-                 it != m_Surfaces.end();
-                 it++) {
-                mfxU32 refCount = -1;
-                mfxStatus sts   = (*it)->FrameInterface->GetRefCounter((*it), &refCount);
-                // 2 means that only library and synchronizer have control over surface
-                // and all components don't use it now
-                if (sts == MFX_ERR_NONE && refCount <= 2 && (*it)->Data.Locked == 0) {
-                    (*it)->FrameInterface->Release((*it));
-                    m_Surfaces.erase(it);
-                    return true;
-                }
+    // Gives the surfaces no component uses anymore back to the library pool, so the pool reuses
+    // them rather than allocating new ones; m_mutexSurface must be held.
+    void ReleaseIdle() {
+        for (std::vector<mfxFrameSurface1*>::iterator it = m_Surfaces.begin();
+             it != m_Surfaces.end();) {
+            mfxU32 refCount = -1;
+            mfxStatus sts   = (*it)->FrameInterface->GetRefCounter((*it), &refCount);
+            // 2 means that only library and synchronizer have control over surface
+            // and all components don't use it now
+            if (sts == MFX_ERR_NONE && refCount <= 2 && (*it)->Data.Locked == 0) {
+                (*it)->FrameInterface->Release((*it));
+                it = m_Surfaces.erase(it);
+            }
+            else {
+                it++;
             }
         }
+    }
 
-        return false;
+    bool QueryFree() {
+        std::lock_guard<std::mutex> lock(m_mutexSurface);
+        if (m_Surfaces.size() >= m_NumFrameForAlloc)
+            ReleaseIdle();
+
+        return m_Surfaces.size() < m_NumFrameForAlloc;
     }
 
 public:
@@ -1428,6 +1860,7 @@ public:
         }
         sts = surface->FrameInterface->AddRef(surface);
         if (sts == MFX_ERR_NONE) {
+            ReleaseIdle();
             m_Surfaces.push_back(surface);
         }
         return sts;
@@ -0,0 +1,52 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SCENE_CHANGE_DETECTOR_H__
+#define __SCENE_CHANGE_DETECTOR_H__
+
+#include "sample_defs.h"
+
+// Detects scene changes of the input by histograms of luma sampled on a sparse grid. A frame starts
+// a new scene if the share of samples that moved to other bins since the previous frame exceeds
+// the threshold and is well above the average of the current scene, so motion and fades inside
+// a scene aren't taken as cuts.
+class CSceneChangeDetector {
+public:
+    CSceneChangeDetector();
+
+    // minDistance is a number of frames after a change in which no other change is reported,
+    // threshold is a share of samples moved to other bins
+    void Init(mfxU32 minDistance, mfxF64 threshold = 0.3);
+    void Reset();
+
+    // planar formats with 8-bit luma are supported
+    static bool IsSupported(mfxU32 fourCC);
+
+    // data of the surface must be accessible by CPU
+    bool IsSceneChange(const mfxFrameSurface1& surface);
+
+    mfxU32 GetNumChanges() const {
+        return m_nChanges;
+    }
+
+protected:
+    static const mfxU32 NUM_BINS   = 64;
+    static const mfxU32 GRID_STEP  = 4; // every GRID_STEP pixel of every GRID_STEP row
+    static const mfxU32 AVG_PERIOD = 16; // frames the average distance is taken over
+    static const mfxU32 AVG_FACTOR = 3; // change is this many times above the average distance
+
+    mfxU32 m_Histogram[2][NUM_BINS];
+    mfxU32 m_nCurrent; // index of the histogram of the last frame
+    mfxU32 m_nSamples; // of the last frame, 0 before the first one
+    mfxF64 m_avgDistance;
+
+    mfxU32 m_minDistance;
+    mfxF64 m_threshold;
+    mfxU32 m_nFramesSinceChange;
+    mfxU32 m_nChanges;
+};
+
+#endif //__SCENE_CHANGE_DETECTOR_H__
@@ -0,0 +1,99 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SURFACE_POOL_SERVICE_H__
+#define __SURFACE_POOL_SERVICE_H__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "base_allocator.h"
+#include "sample_defs.h"
+#include "sample_utils.h"
+
+// Pools of frames shared by the sessions of one device. Consumers with the same frame parameters
+// take frames from one pool, each up to its quota at a time, and the pool grows on demand up to
+// the sum of the quotas. So the pool holds as many frames as the consumers use at once rather than
+// the sum of their worst cases. The pool shrinks again to the most frames in use at once over a
+// window of acquisitions, and frees the frames of the consumers which leave, so the memory serves
+// the current mix of consumers. All the sessions taking frames must use the allocator of the
+// service, as the library gets the handles of the frames from the allocator of its session.
+class CSurfacePoolService {
+public:
+    CSurfacePoolService();
+    ~CSurfacePoolService();
+
+    mfxStatus Init(MFXFrameAllocator* pAllocator);
+    // frees all the frames, they must not be used by the library anymore
+    void Close();
+
+    // the consumer takes up to quota frames of the request at a time, its pool is allocated to
+    // the largest of the quotas right away
+    mfxStatus RegisterConsumer(const mfxFrameAllocRequest& request,
+                               mfxU16 quota,
+                               mfxU32* pConsumerId);
+    void UnregisterConsumer(mfxU32 consumerId);
+
+    // A free frame of the consumer's pool, NULL if the consumer holds its quota of frames or all
+    // the frames of the pool are in use. A frame is held while it's locked, the returned frame is
+    // also reserved for the consumer till its next call, so it isn't lost before the first lock.
+    mfxFrameSurface1* AcquireSurface(mfxU32 consumerId);
+    // frame handoff: the frame counts against the quota of the consumer receiving it from now on
+    mfxStatus TransferSurface(mfxFrameSurface1* pSurface, mfxU32 consumerId);
+
+    // frames the consumer may acquire now
+    mfxU32 GetFreeSurfacesCount(mfxU32 consumerId);
+
+    void PrintStatistics();
+
+protected:
+    static const mfxU32 NO_CONSUMER = 0xFFFFFFFF;
+    // acquisitions from the pool between checks for idle frames
+    static const mfxU32 TRIM_WINDOW = 256;
+
+    struct sFrame {
+        std::unique_ptr<mfxFrameSurfaceWrap> pSurface;
+        mfxFrameAllocResponse response;
+        mfxU32 owner;
+        bool bReserved;
+    };
+    struct sPool {
+        mfxFrameAllocRequest request;
+        std::vector<sFrame> frames;
+        mfxU32 maxFrames; // sum of the quotas
+        mfxU32 peakFrames; // in use at once
+        mfxU32 windowPeak; // in use at once since the last check
+        mfxU32 windowAcquires;
+        mfxU32 allocatedFrames;
+        mfxU32 releasedFrames;
+    };
+    struct sConsumer {
+        mfxU32 pool;
+        mfxU16 quota;
+        mfxI32 reserved; // frame index
+        bool bRegistered;
+    };
+
+    static bool IsSameFrames(const mfxFrameAllocRequest& l, const mfxFrameAllocRequest& r);
+    // frames are allocated one by one, so any of them can be freed with its response
+    mfxStatus AddFrame(sPool& pool);
+    // frees the free frames of the pool above the number to keep
+    void TrimPool(mfxU32 poolIndex, mfxU32 keepFrames);
+    bool IsFree(const sFrame& frame) const {
+        return !frame.bReserved && !frame.pSurface->Data.Locked;
+    }
+    mfxU32 GetHeldCount(const sPool& pool, mfxU32 consumerId) const;
+
+    MFXFrameAllocator* m_pAllocator;
+    std::vector<std::unique_ptr<sPool>> m_Pools;
+    std::vector<sConsumer> m_Consumers;
+    std::mutex m_mutex;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CSurfacePoolService);
+};
+
+#endif // __SURFACE_POOL_SERVICE_H__
@@ -8,6 +8,8 @@
 #define __SYSMEM_ALLOCATOR_H__
 
 #include <stdlib.h>
+#include <map>
+#include <mutex>
 #include <vector>
 #include "base_allocator.h"
 
@@ -15,6 +17,8 @@ struct sBuffer {
     mfxU32 id;
     mfxU32 nbytes;
     mfxU16 type;
+    mfxU32 offset; // of the data from the header
+    mfxU32 capacity; // of the pooled pages, 0 for calloc'ed buffers
 };
 
 struct sFrame {
@@ -23,8 +27,16 @@ struct sFrame {
 };
 
 struct SysMemAllocatorParams : mfxAllocatorParams {
-    SysMemAllocatorParams() : mfxAllocatorParams(), pBufferAllocator(NULL) {}
+    SysMemAllocatorParams()
+            : mfxAllocatorParams(),
+              pBufferAllocator(NULL),
+              NumaNode(-1),
+              bPooledBuffers(false) {}
     MFXBufferAllocator* pBufferAllocator;
+    // NUMA node for frames allocated by own buffer allocator, -1 - default policy
+    mfxI32 NumaNode;
+    // own buffer allocator takes memory from the pool of huge pages, see SysMemBufferAllocator
+    bool bPooledBuffers;
 };
 
 class SysMemFrameAllocator : public BaseFrameAllocator {
@@ -57,12 +69,24 @@ protected:
 
 class SysMemBufferAllocator : public MFXBufferAllocator {
 public:
-    SysMemBufferAllocator();
+    // Pooled buffers are backed by pages (2 MB huge pages for buffers of 2 MB and more, where the
+    // system allows) which aren't zeroed, and freed buffers are kept for allocations of the same
+    // size class till the allocator is destroyed, so resets and reallocations of frames don't
+    // fault in fresh pages.
+    SysMemBufferAllocator(mfxI32 numaNode = -1, bool bPooled = false);
     virtual ~SysMemBufferAllocator();
     virtual mfxStatus AllocBuffer(mfxU32 nbytes, mfxU16 type, mfxMemId* mid);
     virtual mfxStatus LockBuffer(mfxMemId mid, mfxU8** ptr);
     virtual mfxStatus UnlockBuffer(mfxMemId mid);
     virtual mfxStatus FreeBuffer(mfxMemId mid);
+
+protected:
+    mfxU32 GetPoolSizeClass(mfxU32 nbytes) const;
+
+    mfxI32 m_NumaNode;
+    bool m_bPooled;
+    std::multimap<mfxU32, sBuffer*> m_FreeBuffers; // by capacity
+    std::mutex m_PoolMutex;
 };
 
 #endif // __SYSMEM_ALLOCATOR_H__
\ No newline at end of file
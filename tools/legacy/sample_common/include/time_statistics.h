@@ -7,12 +7,132 @@
 #pragma once
 
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include "math.h"
 #include "vm/strings_defs.h"
 #include "vm/time_defs.h"
 #include "vpl/mfxstructures.h"
 
+// Log-linear histogram of latencies in microseconds. Each power of two is split into
+// SUB_BUCKETS linear buckets, so percentiles have relative error below 1/SUB_BUCKETS with
+// a fixed number of counters. One thread records values, another may collect them periodically;
+// counters are relaxed atomics, so recording is never blocked.
+class CLatencyHistogram {
+public:
+    struct Summary {
+        mfxU64 Count;
+        mfxU64 P50;
+        mfxU64 P90;
+        mfxU64 P99;
+        mfxU64 Max;
+    };
+
+    CLatencyHistogram() : m_Counts(), m_Max(0), m_TotalCounts(), m_TotalMax(0) {}
+
+    void Record(mfxU64 value) {
+        m_Counts[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        if (value > m_Max.load(std::memory_order_relaxed))
+            m_Max.store(value, std::memory_order_relaxed);
+    }
+
+    // Moves values recorded since the previous call to the totals and summarizes them.
+    // Must be called from one thread only.
+    Summary Collect() {
+        mfxU64 counts[NUM_BUCKETS];
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            counts[i] = m_Counts[i].exchange(0, std::memory_order_relaxed);
+            m_TotalCounts[i] += counts[i];
+        }
+        mfxU64 max = m_Max.exchange(0, std::memory_order_relaxed);
+        m_TotalMax = std::max(m_TotalMax, max);
+        return Summarize(counts, max);
+    }
+
+    // Summary of all values passed Collect() so far
+    Summary GetTotal() const {
+        return Summarize(m_TotalCounts, m_TotalMax);
+    }
+
+    // forgets all values, no values may be recorded meanwhile
+    void Reset() {
+        for (size_t i = 0; i < NUM_BUCKETS; i++) {
+            m_Counts[i].store(0, std::memory_order_relaxed);
+            m_TotalCounts[i] = 0;
+        }
+        m_Max.store(0, std::memory_order_relaxed);
+        m_TotalMax = 0;
+    }
+
+private:
+    static const mfxU32 SUB_BUCKET_BITS = 4;
+    static const mfxU64 SUB_BUCKETS     = 1 << SUB_BUCKET_BITS;
+    // values up to 2^32 us (more than an hour) are told apart, larger ones go to the last bucket
+    static const size_t NUM_BUCKETS = SUB_BUCKETS * (32 - SUB_BUCKET_BITS + 1);
+
+    static size_t GetBucket(mfxU64 value) {
+        if (value < SUB_BUCKETS)
+            return (size_t)value;
+        mfxU32 exp = SUB_BUCKET_BITS;
+        while (exp < 31 && (value >> (exp + 1)))
+            exp++;
+        size_t sub = (size_t)((value >> (exp - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+        return std::min((size_t)((exp - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub),
+                        NUM_BUCKETS - 1);
+    }
+
+    // middle of the value range covered by the bucket
+    static mfxU64 GetBucketValue(size_t bucket) {
+        if (bucket < SUB_BUCKETS)
+            return bucket;
+        mfxU32 exp   = (mfxU32)(bucket / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+        mfxU64 width = (mfxU64)1 << (exp - SUB_BUCKET_BITS);
+        return ((SUB_BUCKETS + bucket % SUB_BUCKETS) * width) + width / 2;
+    }
+
+    static Summary Summarize(const mfxU64* counts, mfxU64 max) {
+        Summary summary = {};
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+            summary.Count += counts[i];
+        summary.Max = max;
+        if (!summary.Count)
+            return summary;
+
+        const mfxU64 rank50 = (summary.Count * 50 + 99) / 100;
+        const mfxU64 rank90 = (summary.Count * 90 + 99) / 100;
+        const mfxU64 rank99 = (summary.Count * 99 + 99) / 100;
+
+        mfxU64 seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS && seen < rank99; i++) {
+            if (!counts[i])
+                continue;
+            mfxU64 prev = seen;
+            seen += counts[i];
+            // percentile can't exceed the exact maximum, which the bucket middle may do
+            mfxU64 value = std::min(GetBucketValue(i), max);
+            if (prev < rank50 && seen >= rank50)
+                summary.P50 = value;
+            if (prev < rank90 && seen >= rank90)
+                summary.P90 = value;
+            if (seen >= rank99)
+                summary.P99 = value;
+        }
+        return summary;
+    }
+
+    std::atomic<mfxU64> m_Counts[NUM_BUCKETS];
+    std::atomic<mfxU64> m_Max;
+    mfxU64 m_TotalCounts[NUM_BUCKETS];
+    mfxU64 m_TotalMax;
+
+    CLatencyHistogram(const CLatencyHistogram&);
+    CLatencyHistogram& operator=(const CLatencyHistogram&);
+};
+
+// Mean and variance are updated per measurement (Welford's method) and percentiles come from
+// a histogram, so the memory doesn't grow with the number of measurements unless they are dumped.
+// Intervals are measured with msdk_time_get_precise_tick.
 class CTimeStatisticsReal {
 public:
     CTimeStatisticsReal() {
@@ -32,14 +152,20 @@ public:
         return MSDK_GET_TIME(elapsed, 0, GetFrequency());
     }
 
+    static msdk_tick GetPreciseFrequency() {
+        if (!preciseFrequency) {
+            preciseFrequency = msdk_time_get_precise_frequency();
+        }
+        return preciseFrequency;
+    }
+
     inline void StartTimeMeasurement() {
-        start = msdk_time_get_tick();
+        start = msdk_time_get_precise_tick();
     }
 
     inline void StopTimeMeasurement() {
         mfxF64 delta = GetDeltaTime();
         totalTime += delta;
-        totalTimeSquares += delta * delta;
         // dump in ms:
         if (m_bNeedDumping)
             m_time_deltas.push_back(delta * 1000);
@@ -52,6 +178,11 @@ public:
             maxTime = delta;
         }
         numMeasurements++;
+
+        mfxF64 diff = delta - meanTime;
+        meanTime += diff / numMeasurements;
+        m2Time += diff * (delta - meanTime);
+        histogram.Record((mfxU64)(delta * 1000000));
     }
 
     inline void StopTimeMeasurementWithCheck() {
@@ -61,7 +192,7 @@ public:
     }
 
     inline mfxF64 GetDeltaTime() {
-        return MSDK_GET_TIME(msdk_time_get_tick(), start, GetFrequency());
+        return MSDK_GET_TIME(msdk_time_get_precise_tick(), start, GetPreciseFrequency());
     }
 
     inline mfxF64 GetDeltaTimeInMiliSeconds() {
@@ -79,14 +210,16 @@ public:
     inline void PrintStatistics(const msdk_char* prefix) {
         msdk_printf(
             MSDK_STRING(
-                "%s Total:%.3lfms(%llu smpls),Avg %.3lfms,StdDev:%.3lfms,Min:%.3lfms,Max:%.3lfms\n"),
+                "%s Total:%.3lfms(%llu smpls),Avg %.3lfms,StdDev:%.3lfms,Min:%.3lfms,Max:%.3lfms,P50:%.3lfms,P99:%.3lfms\n"),
             prefix,
-            (double)totalTime,
+            (double)GetTotalTime(false),
             (unsigned long long int)numMeasurements,
             (double)GetAvgTime(false),
             (double)GetTimeStdDev(false),
             (double)GetMinTime(false),
-            (double)GetMaxTime(false));
+            (double)GetMaxTime(false),
+            (double)GetTimePercentile(50, false),
+            (double)GetTimePercentile(99, false));
     }
 
     inline mfxU64 GetNumMeasurements() {
@@ -103,12 +236,22 @@ public:
     }
 
     inline mfxF64 GetTimeStdDev(bool inSeconds = true) {
-        mfxF64 avg = GetAvgTime();
-        mfxF64 ftmp =
-            (numMeasurements ? sqrt(totalTimeSquares / numMeasurements - avg * avg) : 0.0);
+        mfxF64 ftmp = (numMeasurements ? sqrt(m2Time / numMeasurements) : 0.0);
         return inSeconds ? ftmp : ftmp * 1000;
     }
 
+    // 50, 90 or 99 percentile, estimated within 1/16 of the value
+    inline mfxF64 GetTimePercentile(mfxU32 percentile, bool inSeconds = true) {
+        histogram.Collect();
+        CLatencyHistogram::Summary summary = histogram.GetTotal();
+        mfxU64 us                          = summary.P50;
+        if (percentile >= 99)
+            us = summary.P99;
+        else if (percentile >= 90)
+            us = summary.P90;
+        return inSeconds ? us / 1000000.0 : us / 1000.0;
+    }
+
     inline mfxF64 GetMinTime(bool inSeconds = true) {
         return inSeconds ? minTime : minTime * 1000;
     }
@@ -122,24 +265,29 @@ public:
     }
 
     inline void ResetStatistics() {
-        totalTime        = 0;
-        totalTimeSquares = 0;
-        minTime          = 1E100;
-        maxTime          = -1;
-        numMeasurements  = 0;
+        totalTime       = 0;
+        meanTime        = 0;
+        m2Time          = 0;
+        minTime         = 1E100;
+        maxTime         = -1;
+        numMeasurements = 0;
+        histogram.Reset();
         m_time_deltas.clear();
         TurnOffDumping();
     }
 
 protected:
     static msdk_tick frequency;
+    static msdk_tick preciseFrequency;
 
     msdk_tick start;
     mfxF64 totalTime;
-    mfxF64 totalTimeSquares;
+    mfxF64 meanTime;
+    mfxF64 m2Time; // sum of squared differences from the mean
     mfxF64 minTime;
     mfxF64 maxTime;
     mfxU64 numMeasurements;
+    CLatencyHistogram histogram;
     std::vector<mfxF64> m_time_deltas;
     bool m_bNeedDumping;
 };
@@ -189,6 +337,10 @@ public:
         return 0;
     }
 
+    inline mfxF64 GetTimePercentile(mfxU32, bool) {
+        return 0;
+    }
+
     inline mfxF64 GetMinTime(bool) {
         return 0;
     }
@@ -39,10 +39,16 @@
 
 enum AtomISPMode { NONE = 0, PREVIEW, STILL, VIDEO, CONTINUOUS };
 
-enum V4L2PixelFormat { NO_FORMAT = 0, UYVY, YUY2 };
+enum V4L2PixelFormat { NO_FORMAT = 0, UYVY, YUY2, NV12 };
 
+#ifndef DRM_FORMAT_MOD_LINEAR
+    #define DRM_FORMAT_MOD_LINEAR 0
+#endif
+
+// DMA-BUF the device captures into, the memory of an exported surface
 typedef struct _Buffer {
     int fd, index;
+    uint32_t length;
 } Buffer;
 
 extern Buffer* buffers;
@@ -67,8 +73,15 @@ public:
               enum AtomISPMode MipiMode,
               int m_MipiPort);
 
+    // pitch of the DMA-BUFs the frames are captured into, must be set before Init
+    void SetDmaBufPitch(uint32_t bytesperline) {
+        m_bytesperline = bytesperline;
+    }
+
     void V4L2Init();
     void V4L2Alloc();
+    // closes the DMA-BUFs of the buffers and frees them
+    void V4L2Free();
     int blockIOCTL(int handle, int request, void* args);
     int GetAtomISPModes(enum AtomISPMode mode);
     void V4L2QueueBuffer(Buffer* buffer);
@@ -77,6 +90,8 @@ public:
     void V4L2StopCapture();
     int GetV4L2TerminationSignal();
     void PutOnQ(int x);
+    // index of the next captured buffer, the buffer is given back to the device by V4L2QueueBuffer
+    // once the frame is consumed
     int GetOffQ();
     int ConvertToMFXFourCC(enum V4L2PixelFormat v4l2Format);
     int ConvertToV4L2FourCC();
@@ -93,6 +108,7 @@ protected:
     uint32_t m_width;
     uint32_t m_num_buffers;
     struct v4l2_pix_format m_format;
+    uint32_t m_bytesperline;
     int m_MipiPort;
     enum AtomISPMode m_MipiMode;
     enum V4L2PixelFormat m_v4l2Format;
@@ -10,6 +10,8 @@
 #if defined(LIBVA_SUPPORT)
 
     #include <stdlib.h>
+    #include <list>
+    #include <memory>
     #include <va/va.h>
     #include <va/va_drmcommon.h>
 
@@ -28,6 +30,8 @@ struct vaapiMemId {
     VABufferInfo m_buffer_info;
     // pointer to private export data
     void* m_custom;
+    // m_image kept mapped between locks in persistent mapping mode, NULL if not mapped
+    mfxU8* m_mapped_buffer;
 };
 
 namespace MfxLoader {
@@ -51,11 +55,19 @@ struct vaapiAllocatorParams : mfxAllocatorParams {
         virtual void release(mfxMemId mid, void* hdl) = 0;
     };
 
-    vaapiAllocatorParams() : m_dpy(NULL), m_export_mode(DONOT_EXPORT), m_exporter(NULL) {}
+    vaapiAllocatorParams()
+            : m_dpy(NULL),
+              m_export_mode(DONOT_EXPORT),
+              m_exporter(NULL),
+              m_persistent_mapping(false) {}
 
     VADisplay m_dpy;
     mfxU32 m_export_mode;
     Exporter* m_exporter;
+    // Images derived by LockFrame stay mapped after UnlockFrame and are reused by the next locks of
+    // the surface till it's reallocated or released. Only for drivers mapping the surface memory
+    // itself rather than a copy of it. Ignored with native export, which keeps images of its own.
+    bool m_persistent_mapping;
 };
 
 class vaapiFrameAllocator : public BaseFrameAllocator {
@@ -66,9 +78,29 @@ public:
     virtual mfxStatus Init(mfxAllocatorParams* pParams);
     virtual mfxStatus Close();
 
+    #if VA_CHECK_VERSION(1, 1, 0)
+    // Exports the surface as DMA-BUF objects with the layout and format modifiers of its planes,
+    // flags are VA_EXPORT_SURFACE_*. The caller owns the returned file descriptors and closes them.
+    // GetFrameHDL keeps returning VASurfaceID* as the library expects it.
+    mfxStatus ExportDmaBuf(mfxMemId mid, mfxU32 flags, VADRMPRIMESurfaceDescriptor* pDesc);
+    // Wraps the external DMA-BUF frame (V4L2 capture buffer, frame of another process) into a
+    // surface which can be passed to the sessions sharing the allocator, e.g. as encoder input.
+    // File descriptors of the descriptor stay owned by the caller.
+    mfxStatus ImportDmaBuf(const VADRMPRIMESurfaceDescriptor& desc,
+                           const mfxFrameInfo& info,
+                           mfxMemId* mid);
+    // destroys the surface of the imported frame once the library doesn't use it
+    mfxStatus ReleaseImportedFrame(mfxMemId mid);
+    #endif
+
 protected:
     DISALLOW_COPY_AND_ASSIGN(vaapiFrameAllocator);
 
+    struct vaapiImportedFrame {
+        vaapiMemId mid;
+        VASurfaceID surface;
+    };
+
     virtual mfxStatus LockFrame(mfxMemId mid, mfxFrameData* ptr);
     virtual mfxStatus UnlockFrame(mfxMemId mid, mfxFrameData* ptr);
     virtual mfxStatus GetFrameHDL(mfxMemId mid, mfxHDL* handle);
@@ -81,10 +113,14 @@ protected:
                                   mfxU16 memType,
                                   mfxMemId* midOut);
 
+    void ReleasePersistentMapping(vaapiMemId* vaapi_mid);
+
     VADisplay m_dpy;
     MfxLoader::VA_Proxy* m_libva;
     mfxU32 m_export_mode;
     vaapiAllocatorParams::Exporter* m_exporter;
+    bool m_persistent_mapping;
+    std::list<std::unique_ptr<vaapiImportedFrame>> m_imported;
 };
 
 #endif //#if defined(LIBVA_SUPPORT)
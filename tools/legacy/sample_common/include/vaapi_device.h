@@ -131,9 +131,7 @@ public:
     virtual ~CVAAPIDeviceWayland(void);
 
     virtual mfxStatus Init(mfxHDL hWindow, mfxU16 nViews, mfxU32 nAdapterNum);
-    virtual mfxStatus Reset(void) {
-        return MFX_ERR_NONE;
-    }
+    virtual mfxStatus Reset(void);
     virtual void Close(void);
 
     virtual mfxStatus SetHandle(mfxHandleType type, mfxHDL hdl) {
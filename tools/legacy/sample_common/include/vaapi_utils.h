@@ -106,6 +106,13 @@ public:
                                              VAContextID* context);
     typedef VAStatus (*vaDestroyConfig_type)(VADisplay dpy, VAConfigID config_id);
     typedef VAStatus (*vaDestroyContext_type)(VADisplay dpy, VAContextID context);
+        #if VA_CHECK_VERSION(1, 1, 0)
+    typedef VAStatus (*vaExportSurfaceHandle_type)(VADisplay dpy,
+                                                   VASurfaceID surface_id,
+                                                   uint32_t mem_type,
+                                                   uint32_t flags,
+                                                   void* descriptor);
+        #endif
 
     VA_Proxy();
     ~VA_Proxy();
@@ -131,6 +138,9 @@ public:
     const vaCreateContext_type vaCreateContext;
     const vaDestroyConfig_type vaDestroyConfig;
     const vaDestroyContext_type vaDestroyContext;
+        #if VA_CHECK_VERSION(1, 1, 0)
+    const vaExportSurfaceHandle_type vaExportSurfaceHandle;
+        #endif
 };
     #endif
 
@@ -9,16 +9,55 @@
 
 #include "vpl/mfxdefs.h"
 
+#if defined(_WIN32) || defined(_WIN64)
+    #include <intrin.h>
+
+    #pragma intrinsic(_InterlockedIncrement16)
+    #pragma intrinsic(_InterlockedDecrement16)
+    #pragma intrinsic(_InterlockedIncrement)
+    #pragma intrinsic(_InterlockedDecrement)
+#endif
+
+// The counters are the fields of the library structures (Data.Locked and the like), so they are
+// updated in place with the operations std::atomic is built on. Incrementing is relaxed, as a
+// reference is taken by the one holding the object already. Decrementing releases the writes made
+// to the object under the reference and acquires the ones of the other holders, so the one
+// dropping the count to 0 may reuse the object. Both return the new value.
+
 /* Thread-safe 16-bit variable incrementing */
-mfxU16 msdk_atomic_inc16(volatile mfxU16* pVariable);
+inline mfxU16 msdk_atomic_inc16(volatile mfxU16* pVariable) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _InterlockedIncrement16((volatile short*)pVariable);
+#else
+    return __atomic_add_fetch(pVariable, 1, __ATOMIC_RELAXED);
+#endif
+}
 
 /* Thread-safe 16-bit variable decrementing */
-mfxU16 msdk_atomic_dec16(volatile mfxU16* pVariable);
+inline mfxU16 msdk_atomic_dec16(volatile mfxU16* pVariable) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _InterlockedDecrement16((volatile short*)pVariable);
+#else
+    return __atomic_sub_fetch(pVariable, 1, __ATOMIC_ACQ_REL);
+#endif
+}
 
 /* Thread-safe 32-bit variable incrementing */
-mfxU32 msdk_atomic_inc32(volatile mfxU32* pVariable);
+inline mfxU32 msdk_atomic_inc32(volatile mfxU32* pVariable) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _InterlockedIncrement((volatile long*)pVariable);
+#else
+    return __atomic_add_fetch(pVariable, 1, __ATOMIC_RELAXED);
+#endif
+}
 
 /* Thread-safe 32-bit variable decrementing */
-mfxU32 msdk_atomic_dec32(volatile mfxU32* pVariable);
+inline mfxU32 msdk_atomic_dec32(volatile mfxU32* pVariable) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _InterlockedDecrement((volatile long*)pVariable);
+#else
+    return __atomic_sub_fetch(pVariable, 1, __ATOMIC_ACQ_REL);
+#endif
+}
 
 #endif // #ifndef __ATOMIC_DEFS_H__
@@ -0,0 +1,34 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __STREAM_DEFS_H__
+#define __STREAM_DEFS_H__
+
+#include <stdio.h>
+#include "strings_defs.h"
+#include "vpl/mfxdefs.h"
+
+// Inputs and outputs which can't seek, they are named in place of files:
+//   "-"                 the standard input, the standard output carries the log
+//   "pipe:<command>"    the standard output or input of the command
+//   "tcp://host:port"   a connection to the host
+//   "tcp://:port"       the first connection accepted on the port
+//   "udp://host:port"   datagrams sent to the host
+//   "udp://:port"       datagrams received on the port, host binds to a local address
+// Sockets are supported on Linux only. The pipe and socket buffers of the kernel are enlarged to
+// MSDK_STREAM_BUFFER_SIZE, so the producer isn't stopped and datagrams aren't lost while the
+// reader is busy for a while.
+#define MSDK_STREAM_BUFFER_SIZE (4 * 1024 * 1024)
+
+bool msdk_is_stream(const msdk_char* name);
+// input streams are unbuffered but datagrams, which are buffered whole
+FILE* msdk_stream_open(const msdk_char* name, bool bWrite);
+// up to size bytes available in the stream, waits only for the first one, 0 at the end of stream
+size_t msdk_stream_read(FILE* stream, void* buffer, size_t size);
+// closes streams as well as files, the standard input is left open
+void msdk_stream_close(FILE* stream);
+
+#endif // #ifndef __STREAM_DEFS_H__
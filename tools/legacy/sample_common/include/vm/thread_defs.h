@@ -7,6 +7,9 @@
 #ifndef __THREAD_DEFS_H__
 #define __THREAD_DEFS_H__
 
+#include <atomic>
+#include <vector>
+
 #include "vm/strings_defs.h"
 #include "vpl/mfxdefs.h"
 
@@ -21,10 +24,6 @@ struct msdkSemaphoreHandle {
     void* m_semaphore;
 };
 
-struct msdkEventHandle {
-    void* m_event;
-};
-
 struct msdkThreadHandle {
     void* m_thread;
 };
@@ -44,15 +43,6 @@ struct msdkSemaphoreHandle {
     pthread_mutex_t m_mutex;
 };
 
-struct msdkEventHandle {
-    msdkEventHandle(bool manual, bool state) : m_manual(manual), m_state(state) {}
-
-    bool m_manual;
-    bool m_state;
-    pthread_cond_t m_event;
-    pthread_mutex_t m_mutex;
-};
-
 class MSDKEvent;
 
 struct msdkThreadHandle {
@@ -70,6 +60,19 @@ struct msdkThreadHandle {
 
 #endif // #if defined(_WIN32) || defined(_WIN64)
 
+// The state is the word waited on with futex on Linux and WaitOnAddress on Windows. Signal only
+// enters the kernel when there are waiters, Wait only when the event isn't signaled yet.
+struct msdkEventHandle {
+    msdkEventHandle(bool manual, bool state)
+            : m_manual(manual),
+              m_state(state ? 1 : 0),
+              m_waiters(0) {}
+
+    bool m_manual;
+    std::atomic<mfxU32> m_state; // 1 - signaled
+    std::atomic<mfxU32> m_waiters;
+};
+
 class MSDKSemaphore : public msdkSemaphoreHandle {
 public:
     MSDKSemaphore(mfxStatus& sts, mfxU32 count = 0);
@@ -94,6 +97,13 @@ public:
     mfxStatus TimedWait(mfxU32 msec);
 
 private:
+    // takes the state of an auto-reset event
+    bool TryWait() {
+        mfxU32 signaled = 1;
+        return m_manual ? m_state.load(std::memory_order_acquire) == 1
+                        : m_state.compare_exchange_strong(signaled, 0, std::memory_order_acquire);
+    }
+
     MSDKEvent(const MSDKEvent&);
     void operator=(const MSDKEvent&);
 };
@@ -121,4 +131,22 @@ mfxStatus msdk_setrlimit_vmem(mfxU64 size);
 mfxStatus msdk_thread_get_schedtype(const msdk_char*, mfxI32& type);
 void msdk_thread_printf_scheduling_help();
 
+// CPU affinity of the calling thread, threads created by it inherit the affinity
+mfxStatus msdk_thread_get_affinity(std::vector<mfxU32>& cpus);
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus);
+// preferred NUMA node for memory first touched by the calling thread, -1 resets to default policy
+mfxStatus msdk_thread_set_numa_node(mfxI32 node);
+
+mfxStatus msdk_numa_get_node_cpus(mfxI32 node, std::vector<mfxU32>& cpus);
+// moves pages of the allocated memory to the node and binds future page faults to it
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxI32 node);
+// NUMA node the device is attached to, -1 if unknown
+mfxI32 msdk_numa_get_pci_device_node(mfxU32 domain, mfxU32 bus, mfxU32 device, mfxU32 function);
+mfxI32 msdk_numa_get_device_node(const msdk_char* devicePath);
+
+// page aligned memory, not zeroed on reuse by the caller; with bHugePages huge pages are used where
+// the system provides them, size should be a multiple of 2 MB then
+void* msdk_alloc_pages(size_t size, bool bHugePages);
+void msdk_free_pages(void* ptr, size_t size);
+
 #endif //__THREAD_DEFS_H__
@@ -50,6 +50,12 @@ typedef mfxI64 msdk_tick;
 
 msdk_tick msdk_time_get_tick(void);
 msdk_tick msdk_time_get_frequency(void);
+// ticks of the finest clock for measuring intervals, the TSC if its rate is invariant,
+// they aren't comparable with the ticks of msdk_time_get_tick
+msdk_tick msdk_time_get_precise_tick(void);
+msdk_tick msdk_time_get_precise_frequency(void);
+// returns at the tick, the thread sleeps till shortly before it and spins the rest
+void msdk_time_wait_until(msdk_tick deadline);
 mfxU64 rdtsc(void);
 
 #endif // #ifndef __TIME_DEFS_H__
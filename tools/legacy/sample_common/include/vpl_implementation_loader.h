@@ -61,6 +61,8 @@ public:
     mfxStatus ConfigureImplementation(mfxIMPL impl);
     mfxStatus ConfigureAccelerationMode(mfxAccelerationMode accelerationMode, mfxIMPL impl);
     mfxStatus ConfigureVersion(mfxVersion const version);
+    // worker threads of the CPU implementation, zero values keep the implementation defaults
+    mfxStatus ConfigureThreads(mfxU16 numThread, mfxI32 schedulingType, mfxI32 priority);
     void SetAdapterType(mfxU16 adapterType);
     void SetDiscreteAdapterIndex(mfxI32 dGfxIdx);
     void SetAdapterNum(mfxI32 adapterNum);
@@ -73,6 +75,8 @@ public:
     std::string GetImplName() const;
     mfxVersion GetVersion() const;
     std::pair<mfxI16, mfxI32> GetDeviceIDAndAdapter() const;
+    // adapter numbers of all implementations matching the configuration, in ascending order
+    std::vector<mfxI32> GetAdapterNumbers() const;
     mfxU16 GetAdapterType() const;
     void SetMinVersion(mfxVersion const& version);
 #ifdef ONEVPL_EXPERIMENTAL
@@ -0,0 +1,155 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <algorithm>
+#include <limits>
+
+#include "av1_spl.h"
+#include "sample_defs.h"
+
+namespace ProtectedLibrary {
+
+enum {
+    AV1_OBU_TEMPORAL_DELIMITER = 2,
+    AV1_OBU_FRAME_HEADER       = 3,
+    AV1_OBU_TILE_GROUP         = 4,
+    AV1_OBU_FRAME              = 6,
+    AV1_MAX_LEB128_BYTES       = 8
+};
+
+static void MoveBitstream(mfxBitstream* bs, mfxU32 size) {
+    bs->DataOffset += size;
+    bs->DataLength -= size;
+}
+
+AV1_Spl::AV1_Spl()
+        : m_obuBytesLeft(0),
+          m_temporalUnit(),
+          m_temporalUnitSlices(),
+          m_bTemporalUnitHasFrame(false),
+          m_temporalUnitTimeStamp(0),
+          m_frameData(),
+          m_slices(),
+          m_frame() {}
+
+AV1_Spl::~AV1_Spl() {}
+
+mfxStatus AV1_Spl::Reset() {
+    m_obuBytesLeft = 0;
+    m_temporalUnit.clear();
+    m_temporalUnitSlices.clear();
+    m_bTemporalUnitHasFrame = false;
+    ResetCurrentState();
+    return MFX_ERR_NONE;
+}
+
+void AV1_Spl::ResetCurrentState() {
+    m_frame.DataLength         = 0;
+    m_frame.SliceNum           = 0;
+    m_frame.FirstFieldSliceNum = 0;
+}
+
+mfxStatus AV1_Spl::PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum) {
+    UNREFERENCED_PARAMETER(frame);
+    UNREFERENCED_PARAMETER(sliceNum);
+    return MFX_ERR_NONE;
+}
+
+void AV1_Spl::CompleteFrame() {
+    m_frameData.swap(m_temporalUnit);
+    m_slices.swap(m_temporalUnitSlices);
+    m_temporalUnit.clear();
+    m_temporalUnitSlices.clear();
+    m_bTemporalUnitHasFrame = false;
+
+    m_frame.Data               = m_frameData.data();
+    m_frame.DataLength         = (mfxU32)m_frameData.size();
+    m_frame.Slice              = m_slices.data();
+    m_frame.SliceNum           = (mfxU32)m_slices.size();
+    m_frame.FirstFieldSliceNum = m_frame.SliceNum;
+    m_frame.TimeStamp          = m_temporalUnitTimeStamp;
+}
+
+mfxStatus AV1_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
+    MSDK_CHECK_POINTER(frame, MFX_ERR_NULL_PTR);
+    *frame = 0;
+
+    // end of stream completes the last temporal unit
+    if (!bs_in) {
+        m_obuBytesLeft = 0;
+        if (!m_bTemporalUnitHasFrame) {
+            m_temporalUnit.clear();
+            m_temporalUnitSlices.clear();
+            return MFX_ERR_MORE_DATA;
+        }
+        CompleteFrame();
+        *frame = &m_frame;
+        return MFX_ERR_NONE;
+    }
+
+    for (;;) {
+        mfxU8* pData = bs_in->Data + bs_in->DataOffset;
+
+        if (m_obuBytesLeft) {
+            mfxU32 nBytes = (mfxU32)std::min<mfxU64>(m_obuBytesLeft, bs_in->DataLength);
+            m_temporalUnit.insert(m_temporalUnit.end(), pData, pData + nBytes);
+            MoveBitstream(bs_in, nBytes);
+            m_obuBytesLeft -= nBytes;
+            if (m_obuBytesLeft)
+                return MFX_ERR_MORE_DATA;
+            continue;
+        }
+
+        // OBU header, its extension and leb128 obu_size are needed to know where OBU ends
+        if (!bs_in->DataLength)
+            return MFX_ERR_MORE_DATA;
+        mfxU32 obuType    = (pData[0] >> 3) & 0xF;
+        mfxU32 nHeader    = (pData[0] & 0x4) ? 2 : 1;
+        bool bHasSize     = 0 != (pData[0] & 0x2);
+        mfxU64 obuSize    = 0;
+        mfxU32 nSizeBytes = 0;
+        // Annex B length delimited format has no obu_size
+        if (!bHasSize)
+            return MFX_ERR_UNSUPPORTED;
+        for (;;) {
+            if (nHeader + nSizeBytes >= bs_in->DataLength)
+                return MFX_ERR_MORE_DATA;
+            mfxU8 byte = pData[nHeader + nSizeBytes];
+            obuSize |= (mfxU64)(byte & 0x7F) << (7 * nSizeBytes);
+            nSizeBytes++;
+            if (!(byte & 0x80))
+                break;
+            if (AV1_MAX_LEB128_BYTES == nSizeBytes)
+                return MFX_ERR_UNSUPPORTED;
+        }
+        mfxU64 nObuBytes = nHeader + nSizeBytes + obuSize;
+        if (nObuBytes > std::numeric_limits<mfxU32>::max() - m_temporalUnit.size())
+            return MFX_ERR_UNSUPPORTED;
+
+        if (AV1_OBU_TEMPORAL_DELIMITER == obuType && m_bTemporalUnitHasFrame) {
+            CompleteFrame();
+            *frame = &m_frame;
+            return MFX_ERR_NONE;
+        }
+
+        if (m_temporalUnit.empty())
+            m_temporalUnitTimeStamp = bs_in->TimeStamp;
+        if (AV1_OBU_FRAME_HEADER == obuType || AV1_OBU_TILE_GROUP == obuType ||
+            AV1_OBU_FRAME == obuType) {
+            SliceSplitterInfo slice = {};
+            slice.DataOffset        = (mfxU32)m_temporalUnit.size();
+            slice.DataLength        = (mfxU32)nObuBytes;
+            slice.HeaderLength      = nHeader + nSizeBytes;
+            slice.SliceType         = TYPE_UNKNOWN;
+            m_temporalUnitSlices.push_back(slice);
+            m_bTemporalUnitHasFrame = true;
+        }
+
+        m_obuBytesLeft = nObuBytes;
+    }
+}
+
+} // namespace ProtectedLibrary
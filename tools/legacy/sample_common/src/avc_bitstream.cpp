@@ -8,6 +8,10 @@
 #include <algorithm>
 #include "sample_defs.h"
 
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
 namespace ProtectedLibrary {
 
 mfxStatus DecodeExpGolombOne(mfxU32** ppBitStream,
@@ -17,20 +21,6 @@ mfxStatus DecodeExpGolombOne(mfxU32** ppBitStream,
 
 enum { SCLFLAT16 = 0, SCLDEFAULT = 1, SCLREDEFINED = 2 };
 
-const mfxU32 bits_data[] = {
-    (((mfxU32)0x01 << (0)) - 1),  (((mfxU32)0x01 << (1)) - 1),  (((mfxU32)0x01 << (2)) - 1),
-    (((mfxU32)0x01 << (3)) - 1),  (((mfxU32)0x01 << (4)) - 1),  (((mfxU32)0x01 << (5)) - 1),
-    (((mfxU32)0x01 << (6)) - 1),  (((mfxU32)0x01 << (7)) - 1),  (((mfxU32)0x01 << (8)) - 1),
-    (((mfxU32)0x01 << (9)) - 1),  (((mfxU32)0x01 << (10)) - 1), (((mfxU32)0x01 << (11)) - 1),
-    (((mfxU32)0x01 << (12)) - 1), (((mfxU32)0x01 << (13)) - 1), (((mfxU32)0x01 << (14)) - 1),
-    (((mfxU32)0x01 << (15)) - 1), (((mfxU32)0x01 << (16)) - 1), (((mfxU32)0x01 << (17)) - 1),
-    (((mfxU32)0x01 << (18)) - 1), (((mfxU32)0x01 << (19)) - 1), (((mfxU32)0x01 << (20)) - 1),
-    (((mfxU32)0x01 << (21)) - 1), (((mfxU32)0x01 << (22)) - 1), (((mfxU32)0x01 << (23)) - 1),
-    (((mfxU32)0x01 << (24)) - 1), (((mfxU32)0x01 << (25)) - 1), (((mfxU32)0x01 << (26)) - 1),
-    (((mfxU32)0x01 << (27)) - 1), (((mfxU32)0x01 << (28)) - 1), (((mfxU32)0x01 << (29)) - 1),
-    (((mfxU32)0x01 << (30)) - 1), (((mfxU32)0x01 << (31)) - 1), ((mfxU32)0xFFFFFFFF),
-};
-
 const mfxU8 default_intra_scaling_list4x4[16] = { 6,  13, 20, 28, 13, 20, 28, 32,
                                                   20, 28, 32, 37, 28, 32, 37, 42 };
 const mfxU8 default_inter_scaling_list4x4[16] = { 10, 14, 20, 24, 14, 20, 24, 27,
@@ -133,31 +123,25 @@ const mfxI32 hp_scan8x8[2][64] = {
         }                                            \
     }
 
-#define avcNextBits(current_data, bp, nbits, data)   \
-    {                                                \
-        mfxU32 x;                                    \
-                                                     \
-        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32); \
-        SAMPLE_ASSERT(nbits >= 0 && nbits <= 31);    \
-                                                     \
-        mfxI32 offset = bp - (nbits);                \
-                                                     \
-        if (offset >= 0) {                           \
-            x = current_data[0] >> (offset + 1);     \
-        }                                            \
-        else {                                       \
-            offset += 32;                            \
-                                                     \
-            x = current_data[1] >> (offset);         \
-            x >>= 1;                                 \
-            x += current_data[0] << (31 - offset);   \
-        }                                            \
-                                                     \
-        SAMPLE_ASSERT(offset >= 0 && offset <= 31);  \
-                                                     \
-        (data) = x & bits_data[nbits];               \
+#define avcNextBits(current_data, bp, nbits, data)                  \
+    {                                                               \
+        SAMPLE_ASSERT((nbits) > 0 && (nbits) <= 32);                \
+        SAMPLE_ASSERT(bp >= 0 && bp <= 31);                         \
+                                                                    \
+        (data) = avcShowBits32(current_data, bp) >> (32 - (nbits)); \
     }
 
+// x must be nonzero
+inline mfxU32 avcCountLeadingZeros(mfxU32 x) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return 31 - index;
+#else
+    return __builtin_clz(x);
+#endif
+}
+
 inline void FillFlatScalingList4x4(AVCScalingList4x4* scl) {
     for (mfxI32 i = 0; i < 16; i++)
         scl->ScalingListCoeffs[i] = 16;
@@ -1693,42 +1677,24 @@ mfxStatus DecodeExpGolombOne(mfxU32** ppBitStream,
                              mfxI32* pDst,
                              mfxI32 isSigned) {
     mfxU32 code;
-    mfxU32 info             = 0;
-    mfxI32 length           = 1; /* for first bit read above*/
-    mfxU32 thisChunksLength = 0;
+    mfxU32 info = 0;
+    mfxU32 length;
     mfxU32 sval;
 
-    /* Fast check for element = 0 */
-    avcGetNBits((*ppBitStream), (*pBitOffset), 1, code);
-    if (code) {
-        *pDst = 0;
-        return MFX_ERR_NONE;
-    }
-
-    avcGetNBits((*ppBitStream), (*pBitOffset), 8, code);
-    length += 8;
-
-    /* find nonzero byte */
-    while (code == 0) {
-        avcGetNBits((*ppBitStream), (*pBitOffset), 8, code);
-        length += 8;
-    }
-
-    /* find leading '1' */
-    while ((code & 0x80) == 0) {
-        code <<= 1;
-        thisChunksLength++;
-    }
-    length -= 8 - thisChunksLength;
+    /* leading zeros of the codeword, 32-bit elements have at most 31 of them */
+    code = avcShowBits32(*ppBitStream, *pBitOffset);
+    if (0 == code)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
 
-    avcUngetNBits((*ppBitStream), (*pBitOffset), 8 - (thisChunksLength + 1));
+    length = avcCountLeadingZeros(code);
+    avcSkipNBits((*ppBitStream), (*pBitOffset), length + 1);
 
     /* Get info portion of codeword */
     if (length) {
         avcGetNBits((*ppBitStream), (*pBitOffset), length, info);
     }
 
-    sval = (1 << length) + info - 1;
+    sval = ((mfxU32)1 << length) + info - 1;
     if (isSigned) {
         if (sval & 1)
             *pDst = (mfxI32)((sval + 1) >> 1);
@@ -1796,7 +1762,9 @@ mfxI32 AVCHeadersBitstream::GetSEI(const HeaderSet<AVCSeqParamSet>& sps,
 
     mfxI32 ret = GetSEIPayload(sps, current_sps, spl);
 
-    for (mfxU32 i = 0; i < spl->payLoadSize; i++) {
+    // whole dwords of the payload are skipped at once
+    pbs += spl->payLoadSize / 4;
+    for (mfxU32 i = 0; i < spl->payLoadSize % 4; i++) {
         avcSkipNBits(pbs, bitOffset, 8);
     }
 
@@ -1819,9 +1787,8 @@ mfxI32 AVCHeadersBitstream::GetSEIPayload(const HeaderSet<AVCSeqParamSet>& sps,
 
 mfxI32 AVCHeadersBitstream::reserved_sei_message(const HeaderSet<AVCSeqParamSet>&,
                                                  mfxI32 current_sps,
-                                                 AVCSEIPayLoad* spl) {
-    for (mfxU32 i = 0; i < spl->payLoadSize; i++)
-        avcSkipNBits(m_pbs, m_bitOffset, 8) AlignPointerRight();
+                                                 AVCSEIPayLoad*) {
+    // GetSEI moves past the payload
     return current_sps;
 }
 
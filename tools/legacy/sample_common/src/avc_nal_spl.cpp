@@ -5,6 +5,7 @@
   ############################################################################*/
 
 #include "avc_nal_spl.h"
+#include <string.h>
 #include <algorithm>
 #include "avc_structures.h"
 #include "sample_defs.h"
@@ -36,19 +37,24 @@ inline bool IsVLCCode(mfxI32 iCode) {
            (NAL_UT_AUXILIARY == (iCode & AVC_NAL_UNITTYPE_BITS_MASK));
 }
 
+// start codes are found by the rare 0x01 byte, memchr of C runtimes scans with SIMD instructions
 static mfxI32 FindStartCode(mfxU8*(&pb), mfxU32& nSize) {
     // there is no data
     if (nSize < 4)
         return 0;
 
-    // find start code
-    while ((4 <= nSize) && ((0 != pb[0]) || (0 != pb[1]) || (1 != pb[2]))) {
-        pb += 1;
-        nSize -= 1;
+    // find start code followed by at least one byte
+    mfxU8* pEnd = pb + nSize;
+    for (mfxU8* p = pb + 2; p + 1 < pEnd && (p = (mfxU8*)memchr(p, 1, pEnd - 1 - p)); p++) {
+        if (0 == p[-1] && 0 == p[-2]) {
+            nSize -= (mfxU32)(p - 2 - pb);
+            pb = p - 2;
+            return ((pb[0] << 24) | (pb[1] << 16) | (pb[2] << 8) | (pb[3]));
+        }
     }
 
-    if (4 <= nSize)
-        return ((pb[0] << 24) | (pb[1] << 16) | (pb[2] << 8) | (pb[3]));
+    pb    = pEnd - 3;
+    nSize = 3;
 
     return 0;
 }
@@ -236,41 +242,37 @@ mfxI32 StartCodeIterator::EndOfStream(mfxBitstream* dst) {
 }
 
 mfxI32 StartCodeIterator::FindStartCode(mfxU8*(&pb), mfxU32& size, mfxI32& startCodeSize) {
-    mfxU32 zeroCount = 0;
-
-    for (mfxU32 i = 0; i < (mfxU32)size; i++, pb++) {
-        switch (pb[0]) {
-            case 0x00:
-                zeroCount++;
-                break;
-            case 0x01:
-                if (zeroCount >= 2) {
-                    startCodeSize = std::min(zeroCount + 1, 4u);
-                    size -= i + 1;
-                    pb++; // remove 0x01 symbol
-                    zeroCount = 0;
-                    if (size >= 1) {
-                        return pb[0] & AVC_NAL_UNITTYPE_BITS_MASK;
-                    }
-                    else {
-                        pb -= startCodeSize;
-                        size += startCodeSize;
-                        startCodeSize = 0;
-                        return 0;
-                    }
-                }
-                zeroCount = 0;
-                break;
-            default:
-                zeroCount = 0;
-                break;
+    mfxU8* pBegin = pb;
+    mfxU8* pEnd   = pb + size;
+
+    for (mfxU8* p = pBegin; p < pEnd && (p = (mfxU8*)memchr(p, 1, pEnd - p)); p++) {
+        // zeros before 0x01 inside the data, up to 3 of them belong to start code
+        mfxU32 zeroCount = 0;
+        while (zeroCount < 3 && p - zeroCount > pBegin && 0 == p[-(mfxI32)zeroCount - 1])
+            zeroCount++;
+
+        if (zeroCount >= 2) {
+            startCodeSize = zeroCount + 1;
+            pb            = p + 1; // remove 0x01 symbol
+            size          = (mfxU32)(pEnd - pb);
+            if (size >= 1) {
+                return pb[0] & AVC_NAL_UNITTYPE_BITS_MASK;
+            }
+            else {
+                pb -= startCodeSize;
+                size += startCodeSize;
+                startCodeSize = 0;
+                return 0;
+            }
         }
     }
 
-    zeroCount = std::min(zeroCount, 3u);
-    pb -= zeroCount;
-    size += zeroCount;
-    zeroCount     = 0;
+    // trailing zeros may be a part of start code in the next data
+    mfxU32 zeroCount = 0;
+    while (zeroCount < 3 && pEnd - zeroCount > pBegin && 0 == pEnd[-(mfxI32)zeroCount - 1])
+        zeroCount++;
+    pb            = pEnd - zeroCount;
+    size          = zeroCount;
     startCodeSize = 0;
     return 0;
 }
@@ -7,15 +7,25 @@
 #include "base_allocator.h"
 #include <assert.h>
 #include <algorithm>
+#include "sample_defs.h"
 #include "vm/thread_defs.h"
+#include "vm/time_defs.h"
+
+namespace {
+mfxU64 GetMicroseconds(msdk_tick ticks) {
+    static const msdk_tick frequency = msdk_time_get_frequency();
+    return (mfxU64)(ticks * 1000000 / frequency);
+}
+} // namespace
 
 MFXFrameAllocator::MFXFrameAllocator() {
-    pthis  = this;
-    Alloc  = Alloc_;
-    Lock   = Lock_;
-    Free   = Free_;
-    Unlock = Unlock_;
-    GetHDL = GetHDL_;
+    pthis        = this;
+    Alloc        = Alloc_;
+    Lock         = Lock_;
+    Free         = Free_;
+    Unlock       = Unlock_;
+    GetHDL       = GetHDL_;
+    m_bTimeLocks = false;
 }
 
 MFXFrameAllocator::~MFXFrameAllocator() {}
@@ -35,18 +45,34 @@ mfxStatus MFXFrameAllocator::Lock_(mfxHDL pthis, mfxMemId mid, mfxFrameData* ptr
     if (0 == pthis)
         return MFX_ERR_MEMORY_ALLOC;
 
+    MFX_ITT_TASK("LockFrame");
+
     MFXFrameAllocator& self = *(MFXFrameAllocator*)pthis;
 
-    return self.LockFrame(mid, ptr);
+    if (!self.m_bTimeLocks)
+        return self.LockFrame(mid, ptr);
+
+    msdk_tick start = msdk_time_get_tick();
+    mfxStatus sts   = self.LockFrame(mid, ptr);
+    self.CountLatency(false, GetMicroseconds(msdk_time_get_tick() - start));
+    return sts;
 }
 
 mfxStatus MFXFrameAllocator::Unlock_(mfxHDL pthis, mfxMemId mid, mfxFrameData* ptr) {
     if (0 == pthis)
         return MFX_ERR_MEMORY_ALLOC;
 
+    MFX_ITT_TASK("UnlockFrame");
+
     MFXFrameAllocator& self = *(MFXFrameAllocator*)pthis;
 
-    return self.UnlockFrame(mid, ptr);
+    if (!self.m_bTimeLocks)
+        return self.UnlockFrame(mid, ptr);
+
+    msdk_tick start = msdk_time_get_tick();
+    mfxStatus sts   = self.UnlockFrame(mid, ptr);
+    self.CountLatency(true, GetMicroseconds(msdk_time_get_tick() - start));
+    return sts;
 }
 
 mfxStatus MFXFrameAllocator::Free_(mfxHDL pthis, mfxFrameAllocResponse* response) {
@@ -67,7 +93,14 @@ mfxStatus MFXFrameAllocator::GetHDL_(mfxHDL pthis, mfxMemId mid, mfxHDL* handle)
     return self.GetFrameHDL(mid, handle);
 }
 
-BaseFrameAllocator::BaseFrameAllocator() {}
+BaseFrameAllocator::BaseFrameAllocator()
+        : m_bReuseFrames(false),
+          m_generation(0),
+          m_ReusableResponses(),
+          m_KeptResponses(),
+          m_StatisticsMutex(),
+          m_Statistics(),
+          m_HeldFrames() {}
 
 BaseFrameAllocator::~BaseFrameAllocator() {}
 
@@ -124,7 +157,7 @@ mfxStatus BaseFrameAllocator::AllocFrames(mfxFrameAllocRequest* request,
         }
 
         if (!foundInCache) {
-            sts = AllocImpl(request, response);
+            sts = AllocOrReuse(request, response);
             if (sts == MFX_ERR_NONE) {
                 response->AllocId = request->AllocId;
                 m_ExtResponses.push_back(
@@ -141,7 +174,7 @@ mfxStatus BaseFrameAllocator::AllocFrames(mfxFrameAllocRequest* request,
         // reserve space before allocation to avoid memory leak
         m_responses.push_back(mfxFrameAllocResponse());
 
-        sts = AllocImpl(request, response);
+        sts = AllocOrReuse(request, response);
         if (sts == MFX_ERR_NONE) {
             m_responses.back() = *response;
         }
@@ -168,7 +201,7 @@ mfxStatus BaseFrameAllocator::FreeFrames(mfxFrameAllocResponse* response) {
 
     if (i != m_ExtResponses.end()) {
         if ((--i->m_refCount) == 0) {
-            sts = ReleaseResponse(response);
+            sts = ReleaseOrKeep(response);
             m_ExtResponses.erase(i);
         }
         return sts;
@@ -179,7 +212,7 @@ mfxStatus BaseFrameAllocator::FreeFrames(mfxFrameAllocResponse* response) {
         std::find_if(m_responses.begin(), m_responses.end(), std::bind1st(IsSame(), *response));
 
     if (i2 != m_responses.end()) {
-        sts = ReleaseResponse(response);
+        sts = ReleaseOrKeep(response);
         m_responses.erase(i2);
         return sts;
     }
@@ -193,18 +226,236 @@ mfxStatus BaseFrameAllocator::Close() {
 
     std::list<UniqueResponse>::iterator i;
     for (i = m_ExtResponses.begin(); i != m_ExtResponses.end(); i++) {
-        ReleaseResponse(&*i);
+        ReleaseCounted(&*i);
     }
     m_ExtResponses.clear();
 
     std::list<mfxFrameAllocResponse>::iterator i2;
     for (i2 = m_responses.begin(); i2 != m_responses.end(); i2++) {
-        ReleaseResponse(&*i2);
+        ReleaseCounted(&*i2);
+    }
+
+    for (ReusableResponse& kept : m_KeptResponses) {
+        ReleaseCounted(&kept.response);
     }
+    m_KeptResponses.clear();
+    m_ReusableResponses.clear();
 
     return MFX_ERR_NONE;
 }
 
+void BaseFrameAllocator::InvalidateReusableFrames() {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    m_generation++;
+    for (ReusableResponse& kept : m_KeptResponses) {
+        ReleaseCounted(&kept.response);
+    }
+    m_KeptResponses.clear();
+}
+
+mfxStatus BaseFrameAllocator::AllocOrReuse(mfxFrameAllocRequest* request,
+                                           mfxFrameAllocResponse* response) {
+    if (!m_bReuseFrames)
+        return AllocCounted(request, response);
+
+    ReusableResponse frames = {};
+    frames.fourCC           = request->Info.FourCC;
+    frames.width            = request->Info.Width;
+    frames.height           = request->Info.Height;
+    frames.type             = request->Type;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        frames.generation = m_generation;
+
+        std::list<ReusableResponse>::iterator it = m_KeptResponses.begin();
+        while (it != m_KeptResponses.end()) {
+            if (it->type != frames.type) {
+                ++it;
+                continue;
+            }
+            if (it->fourCC == frames.fourCC && it->width == frames.width &&
+                it->height == frames.height &&
+                it->response.NumFrameActual >= request->NumFrameSuggested) {
+                *response = it->response;
+                m_ReusableResponses.splice(m_ReusableResponses.end(), m_KeptResponses, it);
+                return MFX_ERR_NONE;
+            }
+            // frames of the same use with other parameters are superseded by the new ones
+            ReleaseCounted(&it->response);
+            it = m_KeptResponses.erase(it);
+        }
+    }
+
+    mfxStatus sts = AllocCounted(request, response);
+    if (MFX_ERR_NONE == sts) {
+        frames.response = *response;
+        std::lock_guard<std::mutex> lock(mtx);
+        m_ReusableResponses.push_back(frames);
+    }
+    return sts;
+}
+
+mfxStatus BaseFrameAllocator::ReleaseOrKeep(mfxFrameAllocResponse* response) {
+    std::list<ReusableResponse>::iterator it = m_ReusableResponses.begin();
+    for (; it != m_ReusableResponses.end(); ++it) {
+        if (IsSame()(it->response, *response))
+            break;
+    }
+
+    if (it != m_ReusableResponses.end()) {
+        if (it->generation == m_generation) {
+            m_KeptResponses.splice(m_KeptResponses.end(), m_ReusableResponses, it);
+            return MFX_ERR_NONE;
+        }
+        m_ReusableResponses.erase(it);
+    }
+    return ReleaseCounted(response);
+}
+
+mfxStatus BaseFrameAllocator::AllocCounted(mfxFrameAllocRequest* request,
+                                           mfxFrameAllocResponse* response) {
+    mfxStatus sts = AllocImpl(request, response);
+    if (MFX_ERR_NONE != sts || !response->mids)
+        return sts;
+
+    HeldFrames frames;
+    frames.memory = (request->Type & (MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET |
+                                      MFX_MEMTYPE_VIDEO_MEMORY_PROCESSOR_TARGET))
+                        ? FrameAllocatorStatistics::VIDEO_MEMORY
+                        : FrameAllocatorStatistics::SYSTEM_MEMORY;
+    frames.numFrames = response->NumFrameActual;
+    frames.bytes     = GetFrameBytes(request->Info) * response->NumFrameActual;
+
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    FrameAllocatorStatistics::Memory& memory = m_Statistics.memory[frames.memory];
+    memory.numAllocs++;
+    memory.numFrames += frames.numFrames;
+    memory.bytes += frames.bytes;
+    memory.peakBytes = (std::max)(memory.peakBytes, memory.bytes);
+
+    mfxU64 bytes = 0;
+    for (const FrameAllocatorStatistics::Memory& m : m_Statistics.memory)
+        bytes += m.bytes;
+    m_Statistics.peakBytes = (std::max)(m_Statistics.peakBytes, bytes);
+
+    m_HeldFrames[response->mids] = frames;
+    return sts;
+}
+
+mfxStatus BaseFrameAllocator::ReleaseCounted(mfxFrameAllocResponse* response) {
+    {
+        // before the release, the mids may be allocated again right after it
+        std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+        std::map<mfxMemId*, HeldFrames>::iterator it = m_HeldFrames.find(response->mids);
+        if (it != m_HeldFrames.end()) {
+            FrameAllocatorStatistics::Memory& memory = m_Statistics.memory[it->second.memory];
+            memory.numFrames -= it->second.numFrames;
+            memory.bytes -= it->second.bytes;
+            m_HeldFrames.erase(it);
+        }
+    }
+    return ReleaseResponse(response);
+}
+
+void BaseFrameAllocator::CountLatency(bool bUnlock, mfxU64 us) {
+    mfxU32 bucket = 0;
+    while (bucket < FrameAllocatorStatistics::LATENCY_BUCKETS - 1 && (1ULL << bucket) <= us)
+        bucket++;
+
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    FrameAllocatorStatistics::Latency& latency = bUnlock ? m_Statistics.unlock : m_Statistics.lock;
+    latency.count++;
+    latency.totalUs += us;
+    latency.maxUs = (std::max)(latency.maxUs, us);
+    latency.histogram[bucket]++;
+}
+
+mfxU64 BaseFrameAllocator::GetFrameBytes(const mfxFrameInfo& info) {
+    mfxU64 pixels = (mfxU64)info.Width * info.Height;
+    switch (info.FourCC) {
+        case MFX_FOURCC_P8:
+        case MFX_FOURCC_P8_TEXTURE:
+            return pixels;
+        case MFX_FOURCC_NV12:
+        case MFX_FOURCC_NV21:
+        case MFX_FOURCC_YV12:
+        case MFX_FOURCC_IYUV:
+            return pixels * 3 / 2;
+        case MFX_FOURCC_NV16:
+        case MFX_FOURCC_YUY2:
+        case MFX_FOURCC_UYVY:
+        case MFX_FOURCC_I422:
+        case MFX_FOURCC_RGB565:
+        case MFX_FOURCC_R16:
+            return pixels * 2;
+        case MFX_FOURCC_P010:
+        case MFX_FOURCC_P016:
+        case MFX_FOURCC_I010:
+        case MFX_FOURCC_RGBP:
+        case MFX_FOURCC_BGRP:
+            return pixels * 3;
+        case MFX_FOURCC_ARGB16:
+        case MFX_FOURCC_ABGR16:
+        case MFX_FOURCC_Y416:
+            return pixels * 8;
+        default:
+            // P210, I210, Y210, Y216, Y410 and the 32-bit RGB and AYUV formats
+            return pixels * 4;
+    }
+}
+
+FrameAllocatorStatistics BaseFrameAllocator::GetStatistics() {
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    return m_Statistics;
+}
+
+void BaseFrameAllocator::PrintStatistics() {
+    FrameAllocatorStatistics statistics = GetStatistics();
+    const msdk_char* names[FrameAllocatorStatistics::MEMORY_TYPES] = { MSDK_STRING("system"),
+                                                                        MSDK_STRING("video") };
+
+    msdk_printf(MSDK_STRING("Frame allocator: %.1f MB at most\n"),
+                statistics.peakBytes / (1024.0 * 1024.0));
+    for (mfxU32 i = 0; i < FrameAllocatorStatistics::MEMORY_TYPES; i++) {
+        const FrameAllocatorStatistics::Memory& memory = statistics.memory[i];
+        if (!memory.numAllocs)
+            continue;
+        msdk_printf(MSDK_STRING("  %s memory: %llu allocations, %.1f MB at most, %llu frames of "
+                                "%.1f MB held\n"),
+                    names[i],
+                    (unsigned long long)memory.numAllocs,
+                    memory.peakBytes / (1024.0 * 1024.0),
+                    (unsigned long long)memory.numFrames,
+                    memory.bytes / (1024.0 * 1024.0));
+    }
+
+    const FrameAllocatorStatistics::Latency* latencies[2] = { &statistics.lock,
+                                                              &statistics.unlock };
+    for (mfxU32 i = 0; i < 2; i++) {
+        const FrameAllocatorStatistics::Latency& latency = *latencies[i];
+        if (!latency.count)
+            continue;
+        msdk_printf(MSDK_STRING("  %s: %llu calls, %.1f us average, %llu us max\n"),
+                    i ? MSDK_STRING("Unlock") : MSDK_STRING("Lock"),
+                    (unsigned long long)latency.count,
+                    (double)latency.totalUs / latency.count,
+                    (unsigned long long)latency.maxUs);
+        for (mfxU32 b = 0; b < FrameAllocatorStatistics::LATENCY_BUCKETS; b++) {
+            if (!latency.histogram[b])
+                continue;
+            if (b < FrameAllocatorStatistics::LATENCY_BUCKETS - 1)
+                msdk_printf(MSDK_STRING("    < %llu us: %llu\n"),
+                            1ULL << b,
+                            (unsigned long long)latency.histogram[b]);
+            else
+                msdk_printf(MSDK_STRING("    >= %llu us: %llu\n"),
+                            1ULL << (b - 1),
+                            (unsigned long long)latency.histogram[b]);
+        }
+    }
+}
+
 MFXBufferAllocator::MFXBufferAllocator() {
     pthis  = this;
     Alloc  = Alloc_;
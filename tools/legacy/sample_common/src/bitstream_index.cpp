@@ -0,0 +1,461 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "bitstream_index.h"
+
+#include <string.h>
+#include <algorithm>
+#include "sample_utils.h"
+#include "vm/file_defs.h"
+#include "vpl/mfxvp8.h"
+
+static const char INDEX_SIGNATURE[] = "VPLINDEX";
+static const mfxU32 INDEX_VERSION   = 2;
+
+static const mfxU32 IVF_FRAME_HEADER_SIZE = 12;
+
+static mfxU32 GetU32(const mfxU8* p) {
+    return (mfxU32)p[0] | ((mfxU32)p[1] << 8) | ((mfxU32)p[2] << 16) | ((mfxU32)p[3] << 24);
+}
+
+// position of the next 00 00 01 start code at or after nFrom, nSize if there's none
+static size_t FindStartCode(const mfxU8* pData, size_t nSize, size_t nFrom) {
+    for (size_t i = nFrom; i + 2 < nSize; i++) {
+        if (pData[i + 2] > 1)
+            i += 2;
+        else if (!pData[i] && !pData[i + 1] && 1 == pData[i + 2])
+            return i;
+    }
+    return nSize;
+}
+
+CBitstreamIndex::CBitstreamIndex()
+        : m_CodecId(0),
+          m_nFileSize(0),
+          m_Frames(),
+          m_bReducedStillPictureHeader(false) {}
+
+mfxStatus CBitstreamIndex::GetFileSize(const msdk_char* strFileName, mfxU64& size) {
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strFileName, MSDK_STRING("rb"));
+    MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+
+    mfxI64 end = -1;
+    if (0 == MSDK_FSEEK64(f, 0, SEEK_END))
+        end = MSDK_FTELL64(f);
+    fclose(f);
+
+    MSDK_CHECK_ERROR(end < 0, true, MFX_ERR_UNKNOWN);
+    size = (mfxU64)end;
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CBitstreamIndex::Build(const msdk_char* strFileName, mfxU32 codecId) {
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+
+    if (codecId != MFX_CODEC_AVC && codecId != MFX_CODEC_HEVC && codecId != MFX_CODEC_VP8 &&
+        codecId != MFX_CODEC_VP9 && codecId != MFX_CODEC_AV1)
+        return MFX_ERR_UNSUPPORTED;
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strFileName, MSDK_STRING("rb"));
+    MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+
+    // the file is parsed in place, pages are loaded once
+    CSmplFileMapping mapping;
+    mfxStatus sts = mapping.Map(f);
+    fclose(f);
+    MSDK_CHECK_STATUS(sts, "mapping.Map failed");
+
+    m_CodecId                    = codecId;
+    m_nFileSize                  = mapping.GetSize();
+    m_bReducedStillPictureHeader = false;
+    m_Frames.clear();
+
+    if (codecId == MFX_CODEC_AVC || codecId == MFX_CODEC_HEVC)
+        sts = IndexAnnexB(mapping.GetData(), mapping.GetSize());
+    else
+        sts = IndexIVF(mapping.GetData(), mapping.GetSize());
+
+    return sts;
+}
+
+mfxStatus CBitstreamIndex::IndexIVF(const mfxU8* pData, size_t nSize) {
+    // see CIVFFrameReader for the layout of the headers
+    if (nSize < 32 || memcmp(pData, "DKIF", 4))
+        return MFX_ERR_UNSUPPORTED;
+
+    size_t nOffset = (size_t)pData[6] | ((size_t)pData[7] << 8);
+    while (nOffset + IVF_FRAME_HEADER_SIZE <= nSize) {
+        mfxU32 nBytesInFrame = GetU32(pData + nOffset);
+        if (nBytesInFrame > nSize - nOffset - IVF_FRAME_HEADER_SIZE)
+            break; // truncated frame is dropped, as CIVFFrameReader does
+
+        Frame frame;
+        frame.Offset        = nOffset;
+        frame.Size          = IVF_FRAME_HEADER_SIZE + nBytesInFrame;
+        frame.bRandomAccess = IsRandomAccessIVF(pData + nOffset + IVF_FRAME_HEADER_SIZE,
+                                                nBytesInFrame);
+        frame.bKeyFrame     = frame.bRandomAccess;
+        m_Frames.push_back(frame);
+
+        nOffset += frame.Size;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+bool CBitstreamIndex::IsRandomAccessIVF(const mfxU8* pData, mfxU32 nSize) {
+    if (!nSize)
+        return false;
+
+    if (m_CodecId == MFX_CODEC_VP8)
+        return !(pData[0] & 1); // frame tag: 0 - key frame
+
+    if (m_CodecId == MFX_CODEC_VP9) {
+        // uncompressed header: frame_marker(2), profile_low_bit, profile_high_bit,
+        // reserved_zero for profile 3, show_existing_frame, frame_type (0 - key frame)
+        mfxU32 bits = ((mfxU32)pData[0] << 8) | (nSize > 1 ? pData[1] : 0);
+        if ((bits >> 14) != 2)
+            return false;
+        mfxU32 profile = ((bits >> 13) & 1) | (((bits >> 12) & 1) << 1);
+        mfxU32 pos     = (profile == 3) ? 10 : 11;
+        return !((bits >> pos) & 1) && !((bits >> (pos - 1)) & 1);
+    }
+
+    // AV1 temporal unit: sequence header and a key frame header
+    bool bSequenceHeader = false;
+    bool bKeyFrame       = false;
+    size_t pos           = 0;
+    while (pos < nSize) {
+        mfxU8 header  = pData[pos];
+        mfxU32 type   = (header >> 3) & 0xF;
+        bool bHasSize = (header >> 1) & 1;
+        pos += 1 + ((header >> 2) & 1);
+
+        mfxU64 obuSize = nSize - std::min<size_t>(pos, nSize);
+        if (bHasSize) {
+            // leb128
+            obuSize = 0;
+            for (mfxU32 i = 0; i < 8 && pos < nSize; i++) {
+                mfxU8 byte = pData[pos++];
+                obuSize |= (mfxU64)(byte & 0x7F) << (7 * i);
+                if (!(byte & 0x80))
+                    break;
+            }
+        }
+        if (pos > nSize || obuSize > nSize - pos)
+            break;
+
+        if (type == 1 && obuSize) {
+            // seq_profile(3), still_picture, reduced_still_picture_header
+            bSequenceHeader              = true;
+            m_bReducedStillPictureHeader = (pData[pos] >> 3) & 1;
+        }
+        else if ((type == 3 || type == 6) && obuSize) {
+            // show_existing_frame, frame_type(2) (0 - key frame)
+            bool bShowExisting = (pData[pos] >> 7) & 1;
+            mfxU32 frameType   = (pData[pos] >> 5) & 3;
+            bKeyFrame |= m_bReducedStillPictureHeader || (!bShowExisting && !frameType);
+        }
+        pos += (size_t)obuSize;
+    }
+
+    return bSequenceHeader && bKeyFrame;
+}
+
+mfxStatus CBitstreamIndex::IndexAnnexB(const mfxU8* pData, size_t nSize) {
+    const bool bAVC = m_CodecId == MFX_CODEC_AVC;
+
+    // access units begin at the first parameter set, SEI, delimiter or first slice of a picture
+    // following the slices of the previous picture
+    Frame frame      = { 0, 0, false, false };
+    bool bSlices     = false;
+    bool bIDR        = false;
+    bool bIRAP       = false;
+    mfxU32 paramSets = 0;
+    size_t nStart    = FindStartCode(pData, nSize, 0);
+    while (nStart < nSize) {
+        size_t nHeader = nStart + 3;
+        size_t nNext   = FindStartCode(pData, nSize, nHeader);
+        // zero_byte of 4-byte start codes belongs to the NAL unit
+        size_t nBegin = (nStart && !pData[nStart - 1]) ? nStart - 1 : nStart;
+
+        bool bSlice      = false;
+        bool bFirstSlice = false;
+        bool bAUStart    = false;
+        bool bSliceIDR   = false;
+        bool bSliceIRAP  = false;
+        mfxU32 paramSet  = 0;
+        if (bAVC && nHeader + 1 < nNext) {
+            mfxU32 type = pData[nHeader] & 0x1F;
+            bSlice      = type >= 1 && type <= 5;
+            bFirstSlice = bSlice && (pData[nHeader + 1] & 0x80); // first_mb_in_slice 0
+            bAUStart    = (type >= 6 && type <= 9) || (type >= 14 && type <= 18);
+            bSliceIDR   = type == 5;
+            bSliceIRAP  = bSliceIDR;
+            paramSet    = (type == 7) ? 1 : (type == 8) ? 2 : 0;
+        }
+        else if (!bAVC && nHeader + 2 < nNext) {
+            mfxU32 type = (pData[nHeader] >> 1) & 0x3F;
+            bSlice      = type < 32;
+            bFirstSlice = bSlice && (pData[nHeader + 2] & 0x80); // first_slice_segment_in_pic
+            bAUStart    = (type >= 32 && type <= 35) || type == 39 || (type >= 41 && type <= 44) ||
+                       (type >= 48 && type <= 55);
+            bSliceIDR   = type == 19 || type == 20;
+            bSliceIRAP  = type >= 16 && type <= 21; // BLA, IDR and CRA
+            paramSet    = (type == 32) ? 1 : (type == 33) ? 2 : (type == 34) ? 4 : 0;
+        }
+
+        if (bSlices && (bAUStart || bFirstSlice)) {
+            frame.Size          = (mfxU32)(nBegin - frame.Offset);
+            frame.bRandomAccess = bIDR && paramSets == (bAVC ? 3u : 7u);
+            frame.bKeyFrame     = bIRAP;
+            m_Frames.push_back(frame);
+
+            frame.Offset = nBegin;
+            bSlices      = false;
+            bIDR         = false;
+            bIRAP        = false;
+            paramSets    = 0;
+        }
+        bSlices |= bSlice;
+        bIDR |= bSliceIDR;
+        bIRAP |= bSliceIRAP;
+        paramSets |= paramSet;
+
+        nStart = nNext;
+    }
+    if (bSlices) {
+        frame.Size          = (mfxU32)(nSize - frame.Offset);
+        frame.bRandomAccess = bIDR && paramSets == (bAVC ? 3u : 7u);
+        frame.bKeyFrame     = bIRAP;
+        m_Frames.push_back(frame);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CBitstreamIndex::Save(const msdk_char* strIndexFile) const {
+    MSDK_CHECK_POINTER(strIndexFile, MFX_ERR_NULL_PTR);
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strIndexFile, MSDK_STRING("w"));
+    MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
+
+    // text, one frame per line
+    fprintf(f,
+            "%s %u\ncodec %u size %llu frames %u\n",
+            INDEX_SIGNATURE,
+            INDEX_VERSION,
+            m_CodecId,
+            (unsigned long long)m_nFileSize,
+            (mfxU32)m_Frames.size());
+    for (const Frame& frame : m_Frames) {
+        fprintf(f,
+                "%llu %u %d %d\n",
+                (unsigned long long)frame.Offset,
+                frame.Size,
+                frame.bRandomAccess ? 1 : 0,
+                frame.bKeyFrame ? 1 : 0);
+    }
+
+    bool bWritten = !ferror(f);
+    fclose(f);
+    return bWritten ? MFX_ERR_NONE : MFX_ERR_UNKNOWN;
+}
+
+mfxStatus CBitstreamIndex::Load(const msdk_char* strIndexFile,
+                                const msdk_char* strFileName,
+                                mfxU32 codecId) {
+    MSDK_CHECK_POINTER(strIndexFile, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+
+    mfxU64 nFileSize = 0;
+    mfxStatus sts    = GetFileSize(strFileName, nFileSize);
+    MSDK_CHECK_STATUS(sts, "GetFileSize failed");
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, strIndexFile, MSDK_STRING("r"));
+    if (!f)
+        return MFX_ERR_NOT_FOUND;
+
+    char signature[16]           = {};
+    unsigned version             = 0;
+    unsigned codec               = 0;
+    unsigned long long indexSize = 0;
+    unsigned numFrames           = 0;
+    bool bValid = 5 == fscanf(f,
+                              "%15s %u codec %u size %llu frames %u",
+                              signature,
+                              &version,
+                              &codec,
+                              &indexSize,
+                              &numFrames) &&
+                  !strcmp(signature, INDEX_SIGNATURE) && version == INDEX_VERSION &&
+                  codec == codecId && indexSize == nFileSize;
+
+    std::vector<Frame> frames;
+    for (unsigned i = 0; bValid && i < numFrames; i++) {
+        unsigned long long offset = 0;
+        unsigned size             = 0;
+        int bRandomAccess         = 0;
+        int bKeyFrame             = 0;
+        bValid = 4 == fscanf(f, "%llu %u %d %d", &offset, &size, &bRandomAccess, &bKeyFrame) &&
+                 offset + size <= nFileSize;
+
+        Frame frame;
+        frame.Offset        = offset;
+        frame.Size          = size;
+        frame.bRandomAccess = bRandomAccess != 0;
+        frame.bKeyFrame     = bKeyFrame != 0;
+        frames.push_back(frame);
+    }
+    fclose(f);
+
+    if (!bValid)
+        return MFX_ERR_NOT_FOUND;
+
+    m_CodecId   = codecId;
+    m_nFileSize = nFileSize;
+    m_Frames    = std::move(frames);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CBitstreamIndex::LoadOrBuild(const msdk_char* strIndexFile,
+                                       const msdk_char* strFileName,
+                                       mfxU32 codecId) {
+    mfxStatus sts = Load(strIndexFile, strFileName, codecId);
+    if (MFX_ERR_NOT_FOUND != sts)
+        return sts;
+
+    sts = Build(strFileName, codecId);
+    MSDK_CHECK_STATUS(sts, "Build failed");
+
+    // the index is still usable if the sidecar can't be written
+    if (MFX_ERR_NONE != Save(strIndexFile))
+        msdk_printf(MSDK_STRING("WARNING: index file %s isn't written\n"), strIndexFile);
+
+    return MFX_ERR_NONE;
+}
+
+std::vector<CBitstreamIndex::Segment> CBitstreamIndex::Split(mfxU32 nSegments) const {
+    std::vector<Segment> segments;
+    if (m_Frames.empty() || !nSegments)
+        return segments;
+
+    std::vector<mfxU32> points;
+    for (mfxU32 i = 1; i < m_Frames.size(); i++) {
+        if (m_Frames[i].bRandomAccess)
+            points.push_back(i);
+    }
+
+    // each segment begins at the random access point closest to its share of the frames
+    std::vector<mfxU32> firstFrames(1, 0);
+    mfxU32 numFrames = (mfxU32)m_Frames.size();
+    for (mfxU32 s = 1; s < nSegments; s++) {
+        mfxU32 target = (mfxU32)((mfxU64)numFrames * s / nSegments);
+        auto it       = std::lower_bound(points.begin(), points.end(), target);
+        if (it != points.begin() && (it == points.end() || target - *(it - 1) < *it - target))
+            it--;
+        if (it != points.end() && *it > firstFrames.back())
+            firstFrames.push_back(*it);
+    }
+
+    for (size_t s = 0; s < firstFrames.size(); s++) {
+        bool bLast = s + 1 == firstFrames.size();
+
+        Segment segment;
+        segment.FirstFrame = firstFrames[s];
+        segment.NumFrames  = (bLast ? numFrames : firstFrames[s + 1]) - firstFrames[s];
+        segment.Begin      = m_Frames[segment.FirstFrame].Offset;
+        segment.End        = bLast ? m_nFileSize : m_Frames[firstFrames[s + 1]].Offset;
+        segments.push_back(segment);
+    }
+
+    return segments;
+}
+
+CKeyFrameReader::CKeyFrameReader(mfxU32 codecId)
+        : CSmplBitstreamReader(),
+          m_CodecId(codecId),
+          m_Index(),
+          m_nInterval(0),
+          m_nNextFrame(0),
+          m_nLastKeyFrame(0),
+          m_bKeyFrameRead(false) {}
+
+void CKeyFrameReader::Reset() {
+    m_nNextFrame    = 0;
+    m_nLastKeyFrame = 0;
+    m_bKeyFrameRead = false;
+}
+
+mfxStatus CKeyFrameReader::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+    if (m_bStream)
+        return MFX_ERR_UNSUPPORTED;
+
+    sts = m_Index.Build(strFileName, m_CodecId);
+    MSDK_CHECK_STATUS(sts, "m_Index.Build failed");
+
+    const std::vector<CBitstreamIndex::Frame>& frames = m_Index.GetFrames();
+    if (std::none_of(frames.begin(), frames.end(), [](const CBitstreamIndex::Frame& frame) {
+            return frame.bKeyFrame;
+        })) {
+        msdk_printf(MSDK_STRING("ERROR: no key frames found in %s\n"), strFileName);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    Reset();
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CKeyFrameReader::ReadNextFrame(mfxBitstream* pBS) {
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+    pBS->DataOffset = 0;
+    pBS->DataFlag   = MFX_BITSTREAM_COMPLETE_FRAME;
+
+    const std::vector<CBitstreamIndex::Frame>& frames = m_Index.GetFrames();
+
+    size_t i = m_nNextFrame;
+    if (m_bKeyFrameRead)
+        i = std::max<size_t>(i, m_nLastKeyFrame + m_nInterval);
+    while (i < frames.size() && !frames[i].bKeyFrame)
+        i++;
+    if (i >= frames.size()) {
+        m_nNextFrame = frames.size();
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+        return MFX_ERR_MORE_DATA;
+    }
+
+    // IVF frames are passed without their headers
+    bool bIVF      = m_CodecId != MFX_CODEC_AVC && m_CodecId != MFX_CODEC_HEVC;
+    mfxU32 nHeader = bIVF ? IVF_FRAME_HEADER_SIZE : 0;
+    mfxU32 nSize   = frames[i].Size - nHeader;
+    if (nSize > pBS->MaxLength - pBS->DataLength)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    MSDK_CHECK_NOT_EQUAL(MSDK_FSEEK64(m_fSource, frames[i].Offset + nHeader, SEEK_SET),
+                         0,
+                         MFX_ERR_UNSUPPORTED);
+    size_t nBytesRead = fread(pBS->Data + pBS->DataLength, 1, nSize, m_fSource);
+    MSDK_CHECK_NOT_EQUAL(nBytesRead, nSize, MFX_ERR_MORE_DATA);
+    pBS->DataLength += nSize;
+
+    m_nLastKeyFrame = i;
+    m_nNextFrame    = i + 1;
+    m_bKeyFrameRead = true;
+    return MFX_ERR_NONE;
+}
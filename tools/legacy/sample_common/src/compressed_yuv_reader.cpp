@@ -0,0 +1,387 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "compressed_yuv_reader.h"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+static const mfxU8 CONTAINER_MAGIC[4] = { 'V', 'P', 'L', 'Z' };
+static const mfxU32 CONTAINER_VERSION = 1;
+static const size_t HEADER_SIZE       = 28;
+static const size_t INDEX_ENTRY_SIZE  = 12;
+
+static mfxU32 GetU32(const mfxU8* p) {
+    return (mfxU32)p[0] | ((mfxU32)p[1] << 8) | ((mfxU32)p[2] << 16) | ((mfxU32)p[3] << 24);
+}
+
+static mfxU64 GetU64(const mfxU8* p) {
+    return (mfxU64)GetU32(p) | ((mfxU64)GetU32(p + 4) << 32);
+}
+
+static int SeekFile(FILE* f, mfxU64 offset) {
+#if defined(_WIN32) || defined(_WIN64)
+    return _fseeki64(f, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static bool IsContainerFile(const msdk_string& name) {
+    // the header can't be read back from a stream
+    if (msdk_is_stream(name.c_str()))
+        return false;
+
+    FILE* f = NULL;
+    MSDK_FOPEN(f, name.c_str(), MSDK_STRING("rb"));
+    if (!f)
+        return false;
+
+    mfxU8 magic[sizeof(CONTAINER_MAGIC)] = {};
+    bool bContainer = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                      !memcmp(magic, CONTAINER_MAGIC, sizeof(magic));
+    fclose(f);
+    return bContainer;
+}
+
+CCompressedYUVReader::CCompressedYUVReader(mfxU32 nThreads)
+        : CAsyncYUVReader(),
+          m_nThreads(nThreads),
+          m_Codec(CODEC_NONE),
+          m_nPictureSize(0),
+          m_Index(),
+          m_hCodecLib(NULL),
+          m_LZ4DecompressSafe(NULL),
+          m_ZSTDDecompress(NULL),
+          m_ZSTDIsError(NULL),
+          m_Ring(),
+          m_nCurPicture(0),
+          m_nPictureOffset(0),
+          m_bHavePicture(false),
+          m_nNextToDecompress(0),
+          m_Block(),
+          m_Workers(),
+          m_ringMutex(),
+          m_fileMutex(),
+          m_cvSlot(),
+          m_cvDecompressed(),
+          m_bStopWorkers(false) {}
+
+CCompressedYUVReader::~CCompressedYUVReader() {
+    Close();
+}
+
+void CCompressedYUVReader::SetDecompressThreads(mfxU32 nThreads) {
+    m_nThreads = nThreads;
+}
+
+void CCompressedYUVReader::Close() {
+    StopDecompression();
+    m_Ring.clear();
+    m_Index.clear();
+    m_Codec        = CODEC_NONE;
+    m_nPictureSize = 0;
+    FreeCodec();
+
+    CAsyncYUVReader::Close();
+}
+
+mfxStatus CCompressedYUVReader::Init(std::list<msdk_string> inputs,
+                                     mfxU32 ColorFormat,
+                                     bool shouldShiftP010) {
+    Close();
+
+    if (inputs.empty() || !IsContainerFile(inputs.front()))
+        return CAsyncYUVReader::Init(inputs, ColorFormat, shouldShiftP010);
+
+    mfxStatus sts = CSmplYUVReader::Init(inputs, ColorFormat, shouldShiftP010);
+    MSDK_CHECK_STATUS(sts, "CSmplYUVReader::Init failed");
+
+    sts = OpenContainer(m_files[0]);
+    MSDK_CHECK_STATUS(sts, "OpenContainer failed");
+
+    sts = LoadCodec(m_Codec);
+    MSDK_CHECK_STATUS(sts, "LoadCodec failed");
+
+    StartDecompression(0);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CCompressedYUVReader::SkipNframesFromBeginning(mfxU16 w,
+                                                         mfxU16 h,
+                                                         mfxU32 viewId,
+                                                         mfxU32 nframes) {
+    if (viewId || !IsCompressed())
+        return CAsyncYUVReader::SkipNframesFromBeginning(w, h, viewId, nframes);
+
+    mfxU32 frameLength;
+    if (MFX_ERR_NONE != GetFrameLength(w, h, m_ColorFormat, frameLength)) {
+        msdk_printf(MSDK_STRING("Input color format %s is unsupported in qpfile mode\n"),
+                    ColorFormatToStr(m_ColorFormat));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    // the position in the decompressed data, the pictures before it aren't read at all
+    mfxU64 position = (mfxU64)frameLength * nframes;
+    mfxU64 picture  = position / m_nPictureSize;
+    if (picture > m_Index.size())
+        return MFX_ERR_MORE_DATA;
+
+    StopDecompression();
+    StartDecompression((mfxU32)picture);
+    m_nPictureOffset = (size_t)(position % m_nPictureSize);
+
+    return MFX_ERR_NONE;
+}
+
+void CCompressedYUVReader::Reset() {
+    if (!IsCompressed()) {
+        CAsyncYUVReader::Reset();
+        return;
+    }
+
+    StopDecompression();
+    CSmplYUVReader::Reset();
+    StartDecompression(0);
+}
+
+size_t CCompressedYUVReader::ReadData(void* pDst, size_t size, size_t count, mfxU32 vid) {
+    if (vid || !IsCompressed())
+        return CAsyncYUVReader::ReadData(pDst, size, count, vid);
+
+    mfxU8* pOut  = (mfxU8*)pDst;
+    size_t total = size * count;
+    size_t done  = 0;
+    while (done < total) {
+        if (!m_bHavePicture && !NextPicture())
+            break;
+
+        Picture& picture = m_Ring[m_nCurPicture % m_Ring.size()];
+        size_t n         = std::min(total - done, picture.Data.size() - m_nPictureOffset);
+        memcpy(pOut + done, picture.Data.data() + m_nPictureOffset, n);
+        done += n;
+        m_nPictureOffset += n;
+
+        // the slot is given to the workers for the picture m_Ring.size() ahead
+        if (m_nPictureOffset == picture.Data.size()) {
+            {
+                std::lock_guard<std::mutex> lock(m_ringMutex);
+                picture.bReady = false;
+                m_nCurPicture++;
+            }
+            m_cvSlot.notify_all();
+            m_nPictureOffset = 0;
+            m_bHavePicture   = false;
+        }
+    }
+
+    // incomplete item at the end of file is dropped, as fread does
+    return size ? done / size : 0;
+}
+
+mfxStatus CCompressedYUVReader::OpenContainer(FILE* f) {
+    mfxU8 header[HEADER_SIZE] = {};
+    if (0 != SeekFile(f, 0) || fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)))
+        return MFX_ERR_NOT_FOUND;
+
+    mfxU32 version     = GetU32(header + 4);
+    mfxU32 codec       = GetU32(header + 8);
+    mfxU32 pictureSize = GetU32(header + 12);
+    mfxU32 numPictures = GetU32(header + 16);
+    mfxU64 indexOffset = GetU64(header + 20);
+    if (version != CONTAINER_VERSION || (codec != CODEC_LZ4 && codec != CODEC_ZSTD) ||
+        !pictureSize || (codec == CODEC_LZ4 && pictureSize > INT_MAX)) {
+        msdk_printf(MSDK_STRING("ERROR: unsupported compressed input, version %u, codec %u\n"),
+                    version,
+                    codec);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    std::vector<mfxU8> index((size_t)numPictures * INDEX_ENTRY_SIZE);
+    if (0 != SeekFile(f, indexOffset) || fread(index.data(), 1, index.size(), f) != index.size()) {
+        msdk_printf(MSDK_STRING("ERROR: index of the compressed input is truncated\n"));
+        return MFX_ERR_MORE_DATA;
+    }
+
+    m_Index.resize(numPictures);
+    for (mfxU32 i = 0; i < numPictures; i++) {
+        m_Index[i].Offset = GetU64(&index[i * INDEX_ENTRY_SIZE]);
+        m_Index[i].Size   = GetU32(&index[i * INDEX_ENTRY_SIZE + 8]);
+    }
+    m_Codec        = codec;
+    m_nPictureSize = pictureSize;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CCompressedYUVReader::LoadCodec(mfxU32 codec) {
+#if defined(_WIN32) || defined(_WIN64)
+    const msdk_char* libName =
+        (codec == CODEC_LZ4) ? MSDK_STRING("liblz4.dll") : MSDK_STRING("libzstd.dll");
+#else
+    const msdk_char* libName =
+        (codec == CODEC_LZ4) ? MSDK_STRING("liblz4.so.1") : MSDK_STRING("libzstd.so.1");
+#endif
+
+    FreeCodec();
+    m_hCodecLib = msdk_so_load(libName);
+    if (m_hCodecLib) {
+        if (codec == CODEC_LZ4) {
+            m_LZ4DecompressSafe =
+                (LZ4DecompressSafe)msdk_so_get_addr(m_hCodecLib, "LZ4_decompress_safe");
+        }
+        else {
+            m_ZSTDDecompress = (ZSTDDecompress)msdk_so_get_addr(m_hCodecLib, "ZSTD_decompress");
+            m_ZSTDIsError    = (ZSTDIsError)msdk_so_get_addr(m_hCodecLib, "ZSTD_isError");
+        }
+    }
+
+    if (!m_LZ4DecompressSafe && (!m_ZSTDDecompress || !m_ZSTDIsError)) {
+        msdk_printf(MSDK_STRING("ERROR: %s is needed to read the compressed input\n"), libName);
+        FreeCodec();
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+void CCompressedYUVReader::FreeCodec() {
+    if (m_hCodecLib)
+        msdk_so_free(m_hCodecLib);
+    m_hCodecLib         = NULL;
+    m_LZ4DecompressSafe = NULL;
+    m_ZSTDDecompress    = NULL;
+    m_ZSTDIsError       = NULL;
+}
+
+mfxStatus CCompressedYUVReader::DecompressPicture(mfxU32 index,
+                                                  std::vector<mfxU8>& block,
+                                                  Picture& picture) {
+    const IndexEntry& entry = m_Index[index];
+
+    block.resize(entry.Size);
+    {
+        // blocks are read one at a time, the decompression runs in parallel
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        if (0 != SeekFile(m_files[0], entry.Offset) ||
+            fread(block.data(), 1, block.size(), m_files[0]) != block.size())
+            return MFX_ERR_MORE_DATA;
+    }
+
+    bool bDecompressed = false;
+    if (m_Codec == CODEC_LZ4) {
+        int size = m_LZ4DecompressSafe((const char*)block.data(),
+                                       (char*)picture.Data.data(),
+                                       (int)block.size(),
+                                       (int)picture.Data.size());
+        bDecompressed = size >= 0 && (size_t)size == picture.Data.size();
+    }
+    else {
+        size_t size   = m_ZSTDDecompress(picture.Data.data(),
+                                       picture.Data.size(),
+                                       block.data(),
+                                       block.size());
+        bDecompressed = !m_ZSTDIsError(size) && size == picture.Data.size();
+    }
+
+    return bDecompressed ? MFX_ERR_NONE : MFX_ERR_UNKNOWN;
+}
+
+bool CCompressedYUVReader::NextPicture() {
+    if (m_nCurPicture >= m_Index.size())
+        return false;
+
+    Picture& picture = m_Ring[m_nCurPicture % m_Ring.size()];
+    if (m_Workers.empty()) {
+        picture.Sts = DecompressPicture(m_nCurPicture, m_Block, picture);
+    }
+    else {
+        std::unique_lock<std::mutex> lock(m_ringMutex);
+        m_cvDecompressed.wait(lock, [this, &picture] {
+            return picture.bReady && picture.Index == m_nCurPicture;
+        });
+    }
+
+    if (MFX_ERR_NONE != picture.Sts) {
+        msdk_printf(MSDK_STRING("ERROR: picture %u of the compressed input is corrupted\n"),
+                    m_nCurPicture);
+        // no more data, as at the end of file
+        StopDecompression();
+        m_nCurPicture = (mfxU32)m_Index.size();
+        return false;
+    }
+
+    m_bHavePicture = true;
+    return true;
+}
+
+void CCompressedYUVReader::StartDecompression(mfxU32 first) {
+    m_nCurPicture       = first;
+    m_nPictureOffset    = 0;
+    m_bHavePicture      = false;
+    m_nNextToDecompress = first;
+    m_bStopWorkers      = false;
+
+    // without the read ahead the caller decompresses one picture at a time
+    m_Ring.resize(std::max<mfxU32>(m_nChunks, 1));
+    for (Picture& picture : m_Ring) {
+        picture.Data.resize(m_nPictureSize);
+        picture.bReady = false;
+    }
+    if (!m_nChunks)
+        return;
+
+    mfxU32 nThreads = m_nThreads;
+    if (!nThreads)
+        nThreads = std::min(std::max(std::thread::hardware_concurrency(), 1u), 4u);
+    nThreads = std::min(nThreads, (mfxU32)m_Ring.size());
+    for (mfxU32 i = 0; i < nThreads; i++)
+        m_Workers.push_back(std::thread(&CCompressedYUVReader::WorkerRoutine, this));
+}
+
+void CCompressedYUVReader::StopDecompression() {
+    if (!m_Workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(m_ringMutex);
+            m_bStopWorkers = true;
+        }
+        m_cvSlot.notify_all();
+        for (std::thread& worker : m_Workers)
+            worker.join();
+        m_Workers.clear();
+    }
+    m_bHavePicture = false;
+}
+
+void CCompressedYUVReader::WorkerRoutine() {
+    std::vector<mfxU8> block;
+
+    std::unique_lock<std::mutex> lock(m_ringMutex);
+    for (;;) {
+        // a slot is free once the caller is done with the picture m_Ring.size() behind
+        m_cvSlot.wait(lock, [this] {
+            return m_bStopWorkers || (m_nNextToDecompress < m_Index.size() &&
+                                      m_nNextToDecompress < m_nCurPicture + m_Ring.size());
+        });
+        if (m_bStopWorkers)
+            break;
+
+        mfxU32 index     = m_nNextToDecompress++;
+        Picture& picture = m_Ring[index % m_Ring.size()];
+        lock.unlock();
+
+        mfxStatus sts = DecompressPicture(index, block, picture);
+
+        lock.lock();
+        picture.Index  = index;
+        picture.Sts    = sts;
+        picture.bReady = true;
+        m_cvDecompressed.notify_one();
+    }
+} // void CCompressedYUVReader::WorkerRoutine()
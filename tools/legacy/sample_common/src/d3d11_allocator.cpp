@@ -123,7 +123,8 @@ mfxStatus D3D11FrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
 
             //coping data only in case user wants to read from stored surface
             {
-                if (MFXReadWriteMid(mid, MFXReadWriteMid::reuse).isRead()) {
+                if (MFXReadWriteMid(mid, MFXReadWriteMid::reuse).isRead() &&
+                    !sr.IsReadbackPending()) {
                     m_pDeviceContext->CopySubresourceRegion(sr.GetStaging(),
                                                             0,
                                                             0,
@@ -133,6 +134,7 @@ mfxStatus D3D11FrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
                                                             sr.GetSubResource(),
                                                             NULL);
                 }
+                sr.SetReadbackPending(false);
 
                 do {
                     hRes =
@@ -141,6 +143,9 @@ mfxStatus D3D11FrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
                         msdk_printf(MSDK_STRING("ERROR: m_pDeviceContext->Map = 0x%08lx\n"),
                                     (unsigned long int)hRes);
                     }
+                    // the copy is in progress, other threads may use the context meanwhile
+                    if (DXGI_ERROR_WAS_STILL_DRAWING == hRes)
+                        MSDK_SLEEP(0);
                 } while (DXGI_ERROR_WAS_STILL_DRAWING == hRes);
             }
         }
@@ -292,6 +297,31 @@ mfxStatus D3D11FrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData* ptr) {
     return MFX_ERR_NONE;
 }
 
+mfxStatus D3D11FrameAllocator::StartReadback(mfxMemId mid) {
+    TextureSubResource sr = GetResourceFromMid(mid);
+    if (!sr.GetTexture())
+        return MFX_ERR_INVALID_HANDLE;
+    // buffers are mapped directly
+    if (!sr.GetStaging())
+        return MFX_ERR_UNSUPPORTED;
+
+    if (!sr.IsReadbackPending()) {
+        m_pDeviceContext->CopySubresourceRegion(sr.GetStaging(),
+                                                0,
+                                                0,
+                                                0,
+                                                0,
+                                                sr.GetTexture(),
+                                                sr.GetSubResource(),
+                                                NULL);
+        // submitted to the GPU now rather than at the Map
+        m_pDeviceContext->Flush();
+        sr.SetReadbackPending(true);
+    }
+
+    return MFX_ERR_NONE;
+}
+
 mfxStatus D3D11FrameAllocator::GetFrameHDL(mfxMemId mid, mfxHDL* handle) {
     if (NULL == handle)
         return MFX_ERR_INVALID_HANDLE;
@@ -463,6 +493,7 @@ mfxStatus D3D11FrameAllocator::AllocImpl(mfxFrameAllocRequest* request,
             }
             newTexture.stagingTexture.push_back(pTexture2D);
         }
+        newTexture.readbackPending.resize(newTexture.stagingTexture.size(), 0);
     }
 
     // mapping to self created handles array, starting from zero or from last assigned handle + 1
@@ -0,0 +1,942 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "demux_reader.h"
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const size_t DEMUX_PROBE_SIZE = 4 + 192 + 1;
+
+const mfxU8 START_CODE[4] = { 0, 0, 0, 1 };
+
+const size_t TS_PACKET_SIZE = 188;
+
+// MP4 box types
+const mfxU32 BOX_MOOV = 0x6D6F6F76; // 'moov'
+const mfxU32 BOX_MOOF = 0x6D6F6F66; // 'moof'
+const mfxU32 BOX_TRAK = 0x7472616B; // 'trak'
+const mfxU32 BOX_TKHD = 0x746B6864; // 'tkhd'
+const mfxU32 BOX_MDIA = 0x6D646961; // 'mdia'
+const mfxU32 BOX_MDHD = 0x6D646864; // 'mdhd'
+const mfxU32 BOX_HDLR = 0x68646C72; // 'hdlr'
+const mfxU32 BOX_MINF = 0x6D696E66; // 'minf'
+const mfxU32 BOX_STBL = 0x7374626C; // 'stbl'
+const mfxU32 BOX_STSD = 0x73747364; // 'stsd'
+const mfxU32 BOX_STSZ = 0x7374737A; // 'stsz'
+const mfxU32 BOX_STSC = 0x73747363; // 'stsc'
+const mfxU32 BOX_STCO = 0x7374636F; // 'stco'
+const mfxU32 BOX_CO64 = 0x636F3634; // 'co64'
+const mfxU32 BOX_STTS = 0x73747473; // 'stts'
+const mfxU32 BOX_CTTS = 0x63747473; // 'ctts'
+const mfxU32 BOX_MVEX = 0x6D766578; // 'mvex'
+const mfxU32 BOX_TREX = 0x74726578; // 'trex'
+const mfxU32 BOX_TRAF = 0x74726166; // 'traf'
+const mfxU32 BOX_TFHD = 0x74666864; // 'tfhd'
+const mfxU32 BOX_TFDT = 0x74666474; // 'tfdt'
+const mfxU32 BOX_TRUN = 0x7472756E; // 'trun'
+const mfxU32 BOX_AVC1 = 0x61766331; // 'avc1'
+const mfxU32 BOX_AVC3 = 0x61766333; // 'avc3'
+const mfxU32 BOX_HVC1 = 0x68766331; // 'hvc1'
+const mfxU32 BOX_HEV1 = 0x68657631; // 'hev1'
+const mfxU32 BOX_AVCC = 0x61766343; // 'avcC'
+const mfxU32 BOX_HVCC = 0x68766343; // 'hvcC'
+const mfxU32 HDLR_VIDE = 0x76696465; // 'vide'
+
+// Matroska element ids with their length markers
+const mfxU32 MKV_EBML           = 0x1A45DFA3;
+const mfxU32 MKV_SEGMENT        = 0x18538067;
+const mfxU32 MKV_INFO           = 0x1549A966;
+const mfxU32 MKV_TIMECODE_SCALE = 0x2AD7B1;
+const mfxU32 MKV_TRACKS         = 0x1654AE6B;
+const mfxU32 MKV_TRACK_ENTRY    = 0xAE;
+const mfxU32 MKV_TRACK_NUMBER   = 0xD7;
+const mfxU32 MKV_TRACK_TYPE     = 0x83;
+const mfxU32 MKV_CODEC_ID       = 0x86;
+const mfxU32 MKV_CODEC_PRIVATE  = 0x63A2;
+const mfxU32 MKV_CLUSTER        = 0x1F43B675;
+const mfxU32 MKV_TIMECODE       = 0xE7;
+const mfxU32 MKV_BLOCK_GROUP    = 0xA0;
+const mfxU32 MKV_BLOCK          = 0xA1;
+const mfxU32 MKV_SIMPLE_BLOCK   = 0xA3;
+const mfxU64 MKV_UNKNOWN_SIZE   = std::numeric_limits<mfxU64>::max();
+
+inline mfxU32 Read16(const mfxU8* p) {
+    return (p[0] << 8) | p[1];
+}
+
+inline mfxU32 Read32(const mfxU8* p) {
+    return ((mfxU32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+inline mfxU64 Read64(const mfxU8* p) {
+    return ((mfxU64)Read32(p) << 32) | Read32(p + 4);
+}
+
+inline mfxU64 ReadPTS(const mfxU8* p) {
+    return ((mfxU64)(p[0] & 0x0E) << 29) | (p[1] << 22) | ((p[2] & 0xFE) << 14) | (p[3] << 7) |
+           (p[4] >> 1);
+}
+
+DemuxContainer DetectContainer(const mfxU8* p, size_t size) {
+    if (size >= 8) {
+        switch (Read32(p + 4)) {
+            case 0x66747970: // 'ftyp'
+            case 0x73747970: // 'styp'
+            case BOX_MOOV:
+            case 0x6D646174: // 'mdat'
+            case 0x66726565: // 'free'
+            case 0x736B6970: // 'skip'
+            case 0x77696465: // 'wide'
+                return DEMUX_MP4;
+            default:
+                break;
+        }
+    }
+    if (size >= 4 && Read32(p) == MKV_EBML)
+        return DEMUX_MKV;
+    if (size > TS_PACKET_SIZE && p[0] == 0x47 && p[TS_PACKET_SIZE] == 0x47)
+        return DEMUX_MPEG_TS;
+    // M2TS packets are prefixed with the time code
+    if (size > TS_PACKET_SIZE + 8 && p[4] == 0x47 && p[TS_PACKET_SIZE + 8] == 0x47)
+        return DEMUX_MPEG_TS;
+    return DEMUX_NONE;
+}
+
+// parses box header at pos, false if the box doesn't fit into [pos, end)
+bool ReadBox(const mfxU8* pData,
+             size_t pos,
+             size_t end,
+             mfxU32& type,
+             size_t& payload,
+             size_t& boxEnd) {
+    if (end < pos + 8)
+        return false;
+
+    mfxU64 size = Read32(pData + pos);
+    type        = Read32(pData + pos + 4);
+    payload     = pos + 8;
+    if (size == 1) {
+        if (end < pos + 16)
+            return false;
+        size    = Read64(pData + pos + 8);
+        payload = pos + 16;
+    }
+    else if (size == 0) {
+        size = end - pos;
+    }
+
+    if (size < payload - pos || size > end - pos)
+        return false;
+    boxEnd = pos + (size_t)size;
+    return true;
+}
+
+// EBML variable size integer, the length marker is kept for ids
+bool ReadVint(const mfxU8* pData, size_t& pos, size_t end, bool bId, mfxU64& value) {
+    if (pos >= end || !pData[pos])
+        return false;
+
+    mfxU32 length = 1;
+    while (!(pData[pos] & (0x80 >> (length - 1))))
+        length++;
+    if (end - pos < length || (bId && length > 4))
+        return false;
+
+    value         = bId ? pData[pos] : pData[pos] & (0xFF >> length);
+    bool bUnknown = value == (mfxU64)(0xFF >> length);
+    for (mfxU32 i = 1; i < length; i++) {
+        value = (value << 8) | pData[pos + i];
+        bUnknown &= pData[pos + i] == 0xFF;
+    }
+    pos += length;
+
+    if (!bId && bUnknown)
+        value = MKV_UNKNOWN_SIZE;
+    return true;
+}
+
+mfxU64 ReadUInt(const mfxU8* p, size_t size) {
+    mfxU64 value = 0;
+    for (size_t i = 0; i < size && i < 8; i++)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+mfxU64 To90kHz(mfxI64 time, mfxU64 timescale) {
+    if (time < 0 || !timescale)
+        return 0;
+    return (mfxU64)time * 90000 / timescale;
+}
+
+} // namespace
+
+DemuxContainer GetDemuxContainer(const msdk_char* strFileName) {
+    if (!strFileName || !msdk_strlen(strFileName) || msdk_is_stream(strFileName))
+        return DEMUX_NONE;
+
+    FILE* pFile = NULL;
+    MSDK_FOPEN(pFile, strFileName, MSDK_STRING("rb"));
+    if (!pFile)
+        return DEMUX_NONE;
+
+    mfxU8 probe[DEMUX_PROBE_SIZE];
+    size_t size = fread(probe, 1, sizeof(probe), pFile);
+    fclose(pFile);
+
+    return DetectContainer(probe, size);
+}
+
+CDemuxBitstreamReader::CDemuxBitstreamReader(bool bZeroCopy)
+        : CSmplBitstreamReader(),
+          m_bZeroCopy(bZeroCopy),
+          m_Container(DEMUX_NONE),
+          m_Mapping(),
+          m_nCodecId(0),
+          m_nLengthSize(4),
+          m_Header(),
+          m_Samples(),
+          m_nSample(0),
+          m_nFrames(0),
+          m_Buffer(),
+          m_nTrackId(0),
+          m_nTrackTimescale(0),
+          m_nTrexDuration(0),
+          m_nTrexSize(0),
+          m_nFragmentTime(0),
+          m_nPacketSize(TS_PACKET_SIZE),
+          m_nPacketPrefix(0),
+          m_nVideoPid(0),
+          m_nTSOffset(0),
+          m_Pieces() {}
+
+CDemuxBitstreamReader::~CDemuxBitstreamReader() {
+    Close();
+}
+
+void CDemuxBitstreamReader::Close() {
+    m_Mapping.Unmap();
+    m_Container   = DEMUX_NONE;
+    m_nCodecId    = 0;
+    m_nLengthSize = 4;
+    m_nVideoPid   = 0;
+    m_Header.clear();
+    m_Samples.clear();
+    m_Buffer.clear();
+    m_Pieces.clear();
+    Reset();
+    CSmplBitstreamReader::Close();
+}
+
+void CDemuxBitstreamReader::Reset() {
+    m_nSample   = 0;
+    m_nFrames   = 0;
+    m_nTSOffset = 0;
+}
+
+mfxStatus CDemuxBitstreamReader::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+
+    sts = m_Mapping.Map(m_fSource);
+    MSDK_CHECK_STATUS(sts, "m_Mapping.Map failed");
+
+    m_Container = DetectContainer(m_Mapping.GetData(), m_Mapping.GetSize());
+    switch (m_Container) {
+        case DEMUX_MP4:
+            sts = IndexMP4();
+            break;
+        case DEMUX_MKV:
+            sts = IndexMKV();
+            break;
+        case DEMUX_MPEG_TS:
+            sts = InitTS();
+            break;
+        default:
+            sts = MFX_ERR_UNSUPPORTED;
+            break;
+    }
+    MSDK_CHECK_STATUS(sts, "no AVC or HEVC track in the container");
+
+    Reset();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CDemuxBitstreamReader::SetDecoderConfig(const mfxU8* pConfig, size_t size) {
+    m_Header.clear();
+
+    // AVCDecoderConfigurationRecord and HEVCDecoderConfigurationRecord list parameter sets as
+    // 16-bit size and NAL unit, once for AVC SPS and PPS and per array of NAL unit type for HEVC
+    size_t pos = 0, nLists = 0;
+    if (m_nCodecId == MFX_CODEC_AVC) {
+        if (size < 7)
+            return MFX_ERR_UNSUPPORTED;
+        m_nLengthSize = (pConfig[4] & 3) + 1;
+        pos           = 5;
+        nLists        = 2;
+    }
+    else {
+        if (size < 23)
+            return MFX_ERR_UNSUPPORTED;
+        m_nLengthSize = (pConfig[21] & 3) + 1;
+        nLists        = pConfig[22];
+        pos           = 23;
+    }
+
+    for (size_t list = 0; list < nLists && pos < size; list++) {
+        size_t count = 0;
+        if (m_nCodecId == MFX_CODEC_AVC) {
+            count = list ? pConfig[pos] : pConfig[pos] & 0x1F;
+            pos++;
+        }
+        else {
+            if (size < pos + 3)
+                return MFX_ERR_UNSUPPORTED;
+            count = Read16(pConfig + pos + 1);
+            pos += 3;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (size < pos + 2 || size - pos - 2 < Read16(pConfig + pos))
+                return MFX_ERR_UNSUPPORTED;
+            size_t nalSize = Read16(pConfig + pos);
+            m_Header.insert(m_Header.end(), START_CODE, START_CODE + sizeof(START_CODE));
+            m_Header.insert(m_Header.end(), pConfig + pos + 2, pConfig + pos + 2 + nalSize);
+            pos += 2 + nalSize;
+        }
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CDemuxBitstreamReader::IndexMP4() {
+    MP4Track track  = {};
+    m_nTrexDuration = 0;
+    m_nTrexSize     = 0;
+    m_nFragmentTime = 0;
+
+    // the first track is indexed from moov, its fragments are added as moof boxes come
+    ParseMP4Boxes(0, m_Mapping.GetSize(), track);
+
+    return m_nCodecId && !m_Samples.empty() ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+void CDemuxBitstreamReader::ParseMP4Boxes(size_t begin, size_t end, MP4Track& track) {
+    const mfxU8* pData = m_Mapping.GetData();
+
+    mfxU32 type    = 0;
+    size_t payload = 0, boxEnd = 0;
+    for (size_t pos = begin; ReadBox(pData, pos, end, type, payload, boxEnd); pos = boxEnd) {
+        size_t size = boxEnd - payload;
+        switch (type) {
+            case BOX_MOOV:
+            case BOX_MDIA:
+            case BOX_MINF:
+            case BOX_STBL:
+            case BOX_MVEX:
+                ParseMP4Boxes(payload, boxEnd, track);
+                break;
+            case BOX_TRAK:
+                if (!m_nCodecId) {
+                    MP4Track trak = {};
+                    ParseMP4Boxes(payload, boxEnd, trak);
+                    if (trak.Handler == HDLR_VIDE && trak.CodecId) {
+                        track      = trak;
+                        m_nCodecId = trak.CodecId;
+                        if (SetDecoderConfig(pData + trak.Config, trak.ConfigSize) !=
+                                MFX_ERR_NONE ||
+                            IndexMP4Samples(trak) != MFX_ERR_NONE) {
+                            m_nCodecId = 0;
+                            m_Samples.clear();
+                        }
+                    }
+                }
+                break;
+            case BOX_TKHD:
+                if (size >= 24)
+                    track.TrackId = Read32(pData + payload + (pData[payload] == 1 ? 20 : 12));
+                break;
+            case BOX_MDHD:
+                if (size >= 24)
+                    track.Timescale = Read32(pData + payload + (pData[payload] == 1 ? 20 : 12));
+                break;
+            case BOX_HDLR:
+                if (size >= 12)
+                    track.Handler = Read32(pData + payload + 8);
+                break;
+            case BOX_STSD:
+                // the first sample entry is a VisualSampleEntry of 78 bytes and then its boxes
+                if (size >= 16 + 78) {
+                    size_t entry = payload + 8, entryPayload = 0, entryEnd = 0;
+                    mfxU32 entryType = 0;
+                    if (!ReadBox(pData, entry, boxEnd, entryType, entryPayload, entryEnd))
+                        break;
+
+                    mfxU32 codecId = 0, configType = 0;
+                    if (entryType == BOX_AVC1 || entryType == BOX_AVC3) {
+                        codecId    = MFX_CODEC_AVC;
+                        configType = BOX_AVCC;
+                    }
+                    else if (entryType == BOX_HVC1 || entryType == BOX_HEV1) {
+                        codecId    = MFX_CODEC_HEVC;
+                        configType = BOX_HVCC;
+                    }
+
+                    mfxU32 childType = 0;
+                    size_t childPayload = 0, childEnd = 0;
+                    for (size_t child = entryPayload + 78;
+                         codecId &&
+                         ReadBox(pData, child, entryEnd, childType, childPayload, childEnd);
+                         child = childEnd) {
+                        if (childType == configType) {
+                            track.CodecId    = codecId;
+                            track.Config     = childPayload;
+                            track.ConfigSize = childEnd - childPayload;
+                            break;
+                        }
+                    }
+                }
+                break;
+            case BOX_STSZ:
+                track.Stsz     = payload;
+                track.StszSize = size;
+                break;
+            case BOX_STSC:
+                track.Stsc     = payload;
+                track.StscSize = size;
+                break;
+            case BOX_STCO:
+            case BOX_CO64:
+                track.Stco     = payload;
+                track.StcoSize = size;
+                track.bCo64    = type == BOX_CO64;
+                break;
+            case BOX_STTS:
+                track.Stts     = payload;
+                track.SttsSize = size;
+                break;
+            case BOX_CTTS:
+                track.Ctts     = payload;
+                track.CttsSize = size;
+                break;
+            case BOX_TREX:
+                if (size >= 24 && m_nCodecId && Read32(pData + payload + 4) == track.TrackId) {
+                    m_nTrexDuration = Read32(pData + payload + 12);
+                    m_nTrexSize     = Read32(pData + payload + 16);
+                }
+                break;
+            case BOX_MOOF:
+                if (m_nCodecId)
+                    IndexMP4Fragment(pos, boxEnd);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+mfxStatus CDemuxBitstreamReader::IndexMP4Samples(const MP4Track& track) {
+    const mfxU8* pData = m_Mapping.GetData();
+    m_nTrackId         = track.TrackId;
+    m_nTrackTimescale  = track.Timescale;
+    m_Samples.clear();
+
+    // no tables or empty ones in the init segment of a fragmented file
+    if (!track.Stsz || track.StszSize < 12)
+        return MFX_ERR_NONE;
+
+    const mfxU8* stsz  = pData + track.Stsz;
+    mfxU32 sampleSize  = Read32(stsz + 4);
+    size_t sampleCount = Read32(stsz + 8);
+    if (!sampleSize && (track.StszSize - 12) / 4 < sampleCount)
+        return MFX_ERR_UNSUPPORTED;
+    if (!sampleCount)
+        return MFX_ERR_NONE;
+
+    if (!track.Stco || track.StcoSize < 8 || !track.Stsc || track.StscSize < 8)
+        return MFX_ERR_UNSUPPORTED;
+    const mfxU8* stco   = pData + track.Stco;
+    const mfxU8* stsc   = pData + track.Stsc;
+    size_t chunkSize    = track.bCo64 ? 8 : 4;
+    size_t nChunks      = std::min<size_t>(Read32(stco + 4), (track.StcoSize - 8) / chunkSize);
+    size_t nStscEntries = std::min<size_t>(Read32(stsc + 4), (track.StscSize - 8) / 12);
+
+    m_Samples.reserve(sampleCount);
+    size_t entry = 0;
+    for (size_t chunk = 0; chunk < nChunks && m_Samples.size() < sampleCount; chunk++) {
+        // stsc runs start at 1-based chunk numbers
+        while (entry + 1 < nStscEntries && Read32(stsc + 8 + (entry + 1) * 12) <= chunk + 1)
+            entry++;
+        if (!nStscEntries)
+            break;
+
+        mfxU64 offset = track.bCo64 ? Read64(stco + 8 + chunk * 8) : Read32(stco + 8 + chunk * 4);
+        size_t samplesPerChunk = Read32(stsc + 8 + entry * 12 + 4);
+        for (size_t i = 0; i < samplesPerChunk && m_Samples.size() < sampleCount; i++) {
+            Sample sample;
+            sample.Size =
+                sampleSize ? sampleSize : Read32(stsz + 12 + 4 * m_Samples.size());
+            sample.Offset    = (size_t)offset;
+            sample.TimeStamp = 0;
+            sample.bAnnexB   = false;
+            if (offset + sample.Size > m_Mapping.GetSize())
+                return MFX_ERR_UNSUPPORTED;
+
+            m_Samples.push_back(sample);
+            offset += sample.Size;
+        }
+    }
+
+    // decode times with composition offsets, offsets of version 0 are treated as signed too
+    mfxU64 dts = 0;
+    size_t n   = 0;
+    if (track.Stts && track.SttsSize >= 8) {
+        const mfxU8* stts = pData + track.Stts;
+        size_t nEntries   = std::min<size_t>(Read32(stts + 4), (track.SttsSize - 8) / 8);
+        for (size_t i = 0; i < nEntries; i++) {
+            mfxU32 count = Read32(stts + 8 + i * 8), delta = Read32(stts + 12 + i * 8);
+            for (mfxU32 j = 0; j < count && n < m_Samples.size(); j++, n++) {
+                m_Samples[n].TimeStamp = dts;
+                dts += delta;
+            }
+        }
+    }
+    m_nFragmentTime = dts;
+
+    n = 0;
+    if (track.Ctts && track.CttsSize >= 8) {
+        const mfxU8* ctts = pData + track.Ctts;
+        size_t nEntries   = std::min<size_t>(Read32(ctts + 4), (track.CttsSize - 8) / 8);
+        for (size_t i = 0; i < nEntries; i++) {
+            mfxU32 count = Read32(ctts + 8 + i * 8);
+            mfxI32 cto   = (mfxI32)Read32(ctts + 12 + i * 8);
+            for (mfxU32 j = 0; j < count && n < m_Samples.size(); j++, n++)
+                m_Samples[n].TimeStamp += cto;
+        }
+    }
+
+    for (Sample& sample : m_Samples)
+        sample.TimeStamp = To90kHz((mfxI64)sample.TimeStamp, m_nTrackTimescale);
+
+    return MFX_ERR_NONE;
+}
+
+void CDemuxBitstreamReader::IndexMP4Fragment(size_t moof, size_t end) {
+    const mfxU8* pData = m_Mapping.GetData();
+
+    mfxU32 type    = 0;
+    size_t payload = 0, trafEnd = 0;
+    for (size_t traf = moof + 8; ReadBox(pData, traf, end, type, payload, trafEnd);
+         traf        = trafEnd) {
+        if (type != BOX_TRAF)
+            continue;
+
+        // data offsets of trun are relative to moof unless tfhd gives the base
+        mfxU64 base = moof, dataOffset = moof, dts = m_nFragmentTime;
+        mfxU32 defaultDuration = m_nTrexDuration, defaultSize = m_nTrexSize;
+        bool bTrack = false;
+
+        size_t boxPayload = 0, boxEnd = 0;
+        for (size_t box = payload; ReadBox(pData, box, trafEnd, type, boxPayload, boxEnd);
+             box        = boxEnd) {
+            const mfxU8* p = pData + boxPayload;
+            size_t size    = boxEnd - boxPayload;
+
+            if (type == BOX_TFHD && size >= 8) {
+                mfxU32 flags = Read32(p) & 0xFFFFFF;
+                bTrack       = Read32(p + 4) == m_nTrackId;
+                size_t field = 8;
+                if ((flags & 0x1) && size >= field + 8) {
+                    base = Read64(p + field);
+                    field += 8;
+                }
+                if (flags & 0x2)
+                    field += 4;
+                if ((flags & 0x8) && size >= field + 4) {
+                    defaultDuration = Read32(p + field);
+                    field += 4;
+                }
+                if ((flags & 0x10) && size >= field + 4)
+                    defaultSize = Read32(p + field);
+                dataOffset = base;
+            }
+            else if (type == BOX_TFDT && bTrack && size >= 8) {
+                dts = p[0] == 1 && size >= 12 ? Read64(p + 4) : Read32(p + 4);
+            }
+            else if (type == BOX_TRUN && bTrack && size >= 8) {
+                mfxU32 flags = Read32(p) & 0xFFFFFF;
+                mfxU32 count = Read32(p + 4);
+                size_t field = 8;
+                if (flags & 0x1) {
+                    if (size < field + 4)
+                        break;
+                    dataOffset = base + (mfxI64)(mfxI32)Read32(p + field);
+                    field += 4;
+                }
+                if (flags & 0x4)
+                    field += 4;
+
+                size_t sampleFields = 0;
+                for (mfxU32 bit = 0x100; bit <= 0x800; bit <<= 1)
+                    sampleFields += (flags & bit) ? 4 : 0;
+                if (size < field || (sampleFields && (size - field) / sampleFields < count))
+                    break;
+
+                for (mfxU32 i = 0; i < count; i++) {
+                    mfxU32 duration = defaultDuration, sampleSize = defaultSize;
+                    mfxI32 cto = 0;
+                    if (flags & 0x100) {
+                        duration = Read32(p + field);
+                        field += 4;
+                    }
+                    if (flags & 0x200) {
+                        sampleSize = Read32(p + field);
+                        field += 4;
+                    }
+                    if (flags & 0x400)
+                        field += 4;
+                    if (flags & 0x800) {
+                        cto = (mfxI32)Read32(p + field);
+                        field += 4;
+                    }
+                    if (dataOffset + sampleSize > m_Mapping.GetSize())
+                        break;
+
+                    Sample sample;
+                    sample.Offset    = (size_t)dataOffset;
+                    sample.Size      = sampleSize;
+                    sample.TimeStamp = To90kHz((mfxI64)dts + cto, m_nTrackTimescale);
+                    sample.bAnnexB   = false;
+                    m_Samples.push_back(sample);
+
+                    dataOffset += sampleSize;
+                    dts += duration;
+                }
+            }
+        }
+
+        if (bTrack)
+            m_nFragmentTime = dts;
+    }
+}
+
+mfxStatus CDemuxBitstreamReader::IndexMKV() {
+    const mfxU8* pData = m_Mapping.GetData();
+    size_t fileSize    = m_Mapping.GetSize();
+
+    mfxU64 timecodeScale = 1000000, clusterTime = 0, trackNumber = 0;
+    m_Samples.clear();
+
+    // the EBML header and segments are walked at one level, master elements holding blocks are
+    // entered in place which handles their unknown sizes in live streams too. Tracks precede
+    // clusters in files of all common muxers.
+    size_t pos = 0;
+    while (pos < fileSize) {
+        mfxU64 id = 0, size = 0;
+        if (!ReadVint(pData, pos, fileSize, true, id) ||
+            !ReadVint(pData, pos, fileSize, false, size))
+            break;
+
+        if (id == MKV_SEGMENT || id == MKV_TRACKS || id == MKV_CLUSTER || id == MKV_BLOCK_GROUP)
+            continue;
+        if (size == MKV_UNKNOWN_SIZE || size > fileSize - pos)
+            break;
+
+        const mfxU8* p = pData + pos;
+        if (id == MKV_TIMECODE) {
+            clusterTime = ReadUInt(p, (size_t)size);
+        }
+        else if (id == MKV_INFO || id == MKV_TRACK_ENTRY) {
+            size_t child = 0, end = (size_t)size;
+            mfxU64 number = 0, trackType = 0;
+            const mfxU8 *pCodec = NULL, *pPrivate = NULL;
+            size_t codecSize = 0, privateSize = 0;
+
+            while (child < end) {
+                mfxU64 childId = 0, childSize = 0;
+                if (!ReadVint(p, child, end, true, childId) ||
+                    !ReadVint(p, child, end, false, childSize) || childSize > end - child)
+                    break;
+
+                const mfxU8* pChild = p + child;
+                if (childId == MKV_TIMECODE_SCALE)
+                    timecodeScale = ReadUInt(pChild, (size_t)childSize);
+                else if (childId == MKV_TRACK_NUMBER)
+                    number = ReadUInt(pChild, (size_t)childSize);
+                else if (childId == MKV_TRACK_TYPE)
+                    trackType = ReadUInt(pChild, (size_t)childSize);
+                else if (childId == MKV_CODEC_ID) {
+                    pCodec    = pChild;
+                    codecSize = (size_t)childSize;
+                }
+                else if (childId == MKV_CODEC_PRIVATE) {
+                    pPrivate    = pChild;
+                    privateSize = (size_t)childSize;
+                }
+                child += (size_t)childSize;
+            }
+
+            // video track with the decoder configuration record as codec private data
+            mfxU32 codecId = 0;
+            if (pCodec && codecSize >= 15 && !memcmp(pCodec, "V_MPEG4/ISO/AVC", 15))
+                codecId = MFX_CODEC_AVC;
+            else if (pCodec && codecSize >= 16 && !memcmp(pCodec, "V_MPEGH/ISO/HEVC", 16))
+                codecId = MFX_CODEC_HEVC;
+            if (id == MKV_TRACK_ENTRY && !m_nCodecId && trackType == 1 && codecId && pPrivate) {
+                m_nCodecId = codecId;
+                if (SetDecoderConfig(pPrivate, privateSize) != MFX_ERR_NONE)
+                    m_nCodecId = 0;
+                else
+                    trackNumber = number;
+            }
+        }
+        else if ((id == MKV_SIMPLE_BLOCK || id == MKV_BLOCK) && m_nCodecId) {
+            // track number, relative time code and flags, laced blocks aren't used for video
+            size_t header = 0;
+            mfxU64 number = 0;
+            if (ReadVint(p, header, (size_t)size, false, number) && number == trackNumber &&
+                size >= header + 3 && !(p[header + 2] & 0x06)) {
+                mfxI64 time = (mfxI64)clusterTime + (mfxI16)Read16(p + header);
+                header += 3;
+
+                Sample sample;
+                sample.Offset    = pos + header;
+                sample.Size      = (mfxU32)(size - header);
+                sample.TimeStamp = To90kHz(time * (mfxI64)timecodeScale, 1000000000);
+                sample.bAnnexB   = false;
+                m_Samples.push_back(sample);
+            }
+        }
+
+        pos += (size_t)size;
+    }
+
+    return m_nCodecId && !m_Samples.empty() ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus CDemuxBitstreamReader::InitTS() {
+    const mfxU8* pData = m_Mapping.GetData();
+    size_t fileSize    = m_Mapping.GetSize();
+
+    m_nPacketPrefix = pData[0] == 0x47 ? 0 : 4;
+    m_nPacketSize   = TS_PACKET_SIZE + m_nPacketPrefix;
+
+    // the first program of PAT and its first AVC or HEVC stream, null PID never carries PMT
+    mfxU32 pmtPid = 0x1FFF;
+    for (size_t pos = 0; pos + m_nPacketSize <= fileSize && !m_nCodecId; pos += m_nPacketSize) {
+        const mfxU8* p = pData + pos + m_nPacketPrefix;
+        mfxU32 pid     = ((p[1] & 0x1F) << 8) | p[2];
+        if (p[0] != 0x47 || !(p[1] & 0x40) || (pid != 0 && pid != pmtPid) || !(p[3] & 0x10))
+            continue;
+
+        size_t q = 4 + ((p[3] & 0x20) ? 1 + p[4] : 0);
+        if (q >= TS_PACKET_SIZE || (q += 1 + p[q]) + 3 > TS_PACKET_SIZE)
+            continue;
+
+        // section without CRC, sections spanning several packets aren't expected for PAT and PMT
+        size_t sectionLength = ((p[q + 1] & 0x0F) << 8) | p[q + 2];
+        size_t end           = std::min(q + 3 + sectionLength, TS_PACKET_SIZE);
+        end                  = end >= 4 ? end - 4 : 0;
+
+        if (pid == 0 && p[q] == 0x00) {
+            for (size_t e = q + 8; e + 4 <= end; e += 4) {
+                if (Read16(p + e)) {
+                    pmtPid = Read16(p + e + 2) & 0x1FFF;
+                    break;
+                }
+            }
+        }
+        else if (pid == pmtPid && p[q] == 0x02 && q + 12 <= end) {
+            for (size_t e = q + 12 + (Read16(p + q + 10) & 0x0FFF); e + 5 <= end;
+                 e += 5 + (Read16(p + e + 3) & 0x0FFF)) {
+                if (p[e] == 0x1B)
+                    m_nCodecId = MFX_CODEC_AVC;
+                else if (p[e] == 0x24)
+                    m_nCodecId = MFX_CODEC_HEVC;
+                if (m_nCodecId) {
+                    m_nVideoPid = Read16(p + e + 1) & 0x1FFF;
+                    break;
+                }
+            }
+        }
+    }
+
+    return m_nCodecId ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+}
+
+mfxStatus CDemuxBitstreamReader::ReadTSFrame(mfxU64& timeStamp) {
+    const mfxU8* pData = m_Mapping.GetData();
+    size_t fileSize    = m_Mapping.GetSize();
+
+    // payloads of the PES up to the next one are collected without copying
+    m_Pieces.clear();
+    timeStamp     = (mfxU64)MFX_TIMESTAMP_UNKNOWN;
+    bool bStarted = false;
+    for (; m_nTSOffset + m_nPacketSize <= fileSize; m_nTSOffset += m_nPacketSize) {
+        size_t packet  = m_nTSOffset + m_nPacketPrefix;
+        const mfxU8* p = pData + packet;
+        if (p[0] != 0x47 || (mfxU32)(((p[1] & 0x1F) << 8) | p[2]) != m_nVideoPid)
+            continue;
+
+        bool bStart = (p[1] & 0x40) != 0;
+        if (bStart && bStarted)
+            break;
+
+        size_t q = 4 + ((p[3] & 0x20) ? 1 + p[4] : 0);
+        if (!(p[3] & 0x10) || q >= TS_PACKET_SIZE)
+            continue;
+
+        if (bStart) {
+            if (q + 9 > TS_PACKET_SIZE || p[q] || p[q + 1] || p[q + 2] != 1)
+                continue;
+            if ((p[q + 7] & 0x80) && q + 14 <= TS_PACKET_SIZE)
+                timeStamp = ReadPTS(p + q + 9);
+            q += 9 + p[q + 8];
+            bStarted = true;
+        }
+        if (!bStarted || q >= TS_PACKET_SIZE)
+            continue;
+
+        Piece piece = { packet + q, (mfxU32)(TS_PACKET_SIZE - q) };
+        if (!m_Pieces.empty() && m_Pieces.back().Offset + m_Pieces.back().Size == piece.Offset)
+            m_Pieces.back().Size += piece.Size;
+        else
+            m_Pieces.push_back(piece);
+    }
+
+    return bStarted ? MFX_ERR_NONE : MFX_ERR_MORE_DATA;
+}
+
+mfxU32 CDemuxBitstreamReader::GetAnnexBSize(const Sample& sample) const {
+    if (sample.bAnnexB || m_nLengthSize == 4)
+        return sample.Size;
+
+    const mfxU8* p = m_Mapping.GetData() + sample.Offset;
+    mfxU64 size    = 0;
+    for (size_t pos = 0; pos + m_nLengthSize <= sample.Size;) {
+        size_t nalSize = (size_t)ReadUInt(p + pos, m_nLengthSize);
+        pos += m_nLengthSize;
+        nalSize = std::min<size_t>(nalSize, sample.Size - pos);
+        size += sizeof(START_CODE) + nalSize;
+        pos += nalSize;
+    }
+    return (mfxU32)std::min<mfxU64>(size, std::numeric_limits<mfxU32>::max());
+}
+
+void CDemuxBitstreamReader::CopyAnnexB(const Sample* pSample, mfxU8* pDst) const {
+    const mfxU8* pData = m_Mapping.GetData();
+
+    if (!pSample) {
+        for (const Piece& piece : m_Pieces) {
+            memcpy(pDst, pData + piece.Offset, piece.Size);
+            pDst += piece.Size;
+        }
+        return;
+    }
+
+    const mfxU8* p = pData + pSample->Offset;
+    if (pSample->bAnnexB) {
+        memcpy(pDst, p, pSample->Size);
+        return;
+    }
+
+    for (size_t pos = 0; pos + m_nLengthSize <= pSample->Size;) {
+        size_t nalSize = (size_t)ReadUInt(p + pos, m_nLengthSize);
+        pos += m_nLengthSize;
+        nalSize = std::min<size_t>(nalSize, pSample->Size - pos);
+        memcpy(pDst, START_CODE, sizeof(START_CODE));
+        memcpy(pDst + sizeof(START_CODE), p + pos, nalSize);
+        pDst += sizeof(START_CODE) + nalSize;
+        pos += nalSize;
+    }
+}
+
+mfxStatus CDemuxBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    // position in the transport stream is restored if the frame doesn't fit into the bitstream
+    size_t nTSOffset = m_nTSOffset;
+    Sample* pSample  = NULL;
+    mfxU64 timeStamp = 0;
+    mfxU64 frameSize = 0;
+    if (m_Container == DEMUX_MPEG_TS) {
+        mfxStatus sts = ReadTSFrame(timeStamp);
+        if (sts != MFX_ERR_NONE)
+            return sts;
+        for (const Piece& piece : m_Pieces)
+            frameSize += piece.Size;
+    }
+    else {
+        if (m_nSample >= m_Samples.size())
+            return MFX_ERR_MORE_DATA;
+        pSample   = &m_Samples[m_nSample];
+        timeStamp = pSample->TimeStamp;
+        frameSize = GetAnnexBSize(*pSample);
+    }
+
+    // parameter sets of the track come with the first access unit
+    size_t headerSize = m_nFrames ? 0 : m_Header.size();
+    if (headerSize + frameSize > std::numeric_limits<mfxU32>::max()) {
+        m_nTSOffset = nTSOffset;
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+    }
+    mfxU32 size = (mfxU32)(headerSize + frameSize);
+
+    if (m_bZeroCopy) {
+        mfxU8* pData = NULL;
+        if (pSample && !headerSize && m_nLengthSize == 4) {
+            // 4 bytes lengths are start codes of the same size, the mapping is copy-on-write
+            pData = m_Mapping.GetData() + pSample->Offset;
+            for (size_t pos = 0; !pSample->bAnnexB && pos + 4 <= pSample->Size;) {
+                size_t nalSize = Read32(pData + pos);
+                memcpy(pData + pos, START_CODE, sizeof(START_CODE));
+                pos += 4 + std::min<size_t>(nalSize, pSample->Size - pos - 4);
+            }
+            pSample->bAnnexB = true;
+        }
+        else {
+            m_Buffer.resize(size);
+            std::copy(m_Header.begin(), m_Header.begin() + headerSize, m_Buffer.begin());
+            CopyAnnexB(pSample, m_Buffer.data() + headerSize);
+            pData = m_Buffer.data();
+        }
+
+        pBS->Data       = pData;
+        pBS->DataOffset = 0;
+        pBS->DataLength = size;
+        pBS->MaxLength  = size;
+        pBS->DataFlag |= MFX_BITSTREAM_COMPLETE_FRAME;
+    }
+    else {
+        memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+        pBS->DataOffset = 0;
+        if (size > pBS->MaxLength - pBS->DataLength) {
+            m_nTSOffset = nTSOffset;
+            return MFX_ERR_NOT_ENOUGH_BUFFER;
+        }
+
+        mfxU8* pDst = pBS->Data + pBS->DataLength;
+        std::copy(m_Header.begin(), m_Header.begin() + headerSize, pDst);
+        CopyAnnexB(pSample, pDst + headerSize);
+        pBS->DataLength += size;
+    }
+
+    pBS->TimeStamp = timeStamp;
+    m_nSample += pSample ? 1 : 0;
+    m_nFrames++;
+
+    return MFX_ERR_NONE;
+}
@@ -0,0 +1,167 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "encode_stats_writer.h"
+
+#ifdef ONEVPL_EXPERIMENTAL
+
+CEncodeStatsWriter::CEncodeStatsWriter()
+        : m_file(NULL),
+          m_thread(),
+          m_mutex(),
+          m_cvQueued(),
+          m_Queue(),
+          m_bStop(false),
+          m_nMissing(0) {}
+
+CEncodeStatsWriter::~CEncodeStatsWriter() {
+    Close();
+}
+
+mfxStatus CEncodeStatsWriter::Open(const msdk_char* fileName) {
+    MSDK_CHECK_POINTER(fileName, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(IsOpen(), true, MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    MSDK_FOPEN(m_file, fileName, MSDK_STRING("w"));
+    if (!m_file) {
+        msdk_printf(MSDK_STRING("error: can't open encode statistics file \"%s\"\n"), fileName);
+        return MFX_ERR_ABORTED;
+    }
+    msdk_fprintf(
+        m_file,
+        MSDK_STRING(
+            "display_order,frame_type,size,qp,psnr_y,psnr_cb,psnr_cr,sad_luma,intra_blocks,inter_blocks,skipped_blocks\n"));
+
+    m_bStop    = false;
+    m_nMissing = 0;
+    m_thread   = std::thread(&CEncodeStatsWriter::WriterRoutine, this);
+
+    return MFX_ERR_NONE;
+}
+
+void CEncodeStatsWriter::Close() {
+    if (!IsOpen())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvQueued.notify_one();
+    m_thread.join();
+
+    fclose(m_file);
+    m_file = NULL;
+
+    if (m_nMissing)
+        msdk_printf(MSDK_STRING("WARNING: encoder returned no statistics for %u frames\n"),
+                    m_nMissing);
+}
+
+void CEncodeStatsWriter::Request(mfxBitstreamWrapper& bs) {
+    Release(bs);
+
+    auto output = bs.GetExtBuffer<mfxExtEncodeStatsOutput>();
+    if (!output)
+        output = bs.AddExtBuffer<mfxExtEncodeStatsOutput>();
+    output->EncodeStatsFlags = MFX_ENCODESTATS_LEVEL_FRAME;
+    output->Mode             = MFX_ENCODESTATS_MODE_DEFAULT;
+}
+
+void CEncodeStatsWriter::Release(mfxBitstreamWrapper& bs) {
+    auto output = bs.GetExtBuffer<mfxExtEncodeStatsOutput>();
+    if (!output || !output->EncodeStatsContainer)
+        return;
+
+    mfxRefInterface& ref = output->EncodeStatsContainer->RefInterface;
+    if (ref.Release)
+        ref.Release(&ref);
+    output->EncodeStatsContainer = NULL;
+}
+
+void CEncodeStatsWriter::Add(mfxBitstreamWrapper& bs) {
+    auto output                        = bs.GetExtBuffer<mfxExtEncodeStatsOutput>();
+    mfxEncodeStatsContainer* container = output ? output->EncodeStatsContainer : NULL;
+
+    if (!container || !container->EncodeFrameStats) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_nMissing++;
+    }
+    else {
+        const mfxEncodeFrameStats& frame = *container->EncodeFrameStats;
+
+        EncodeFrameStat stat = {};
+        stat.DisplayOrder    = container->DisplayOrder;
+        stat.FrameType       = bs.FrameType;
+        stat.Size            = bs.DataLength;
+        stat.Qp              = frame.Qp;
+        stat.PSNRLuma        = frame.PSNRLuma;
+        stat.PSNRCb          = frame.PSNRCb;
+        stat.PSNRCr          = frame.PSNRCr;
+        stat.SADLuma         = frame.SADLuma;
+        stat.NumIntraBlock   = frame.NumIntraBlock;
+        stat.NumInterBlock   = frame.NumInterBlock;
+        stat.NumSkippedBlock = frame.NumSkippedBlock;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_Queue.push_back(stat);
+        }
+        m_cvQueued.notify_one();
+    }
+
+    Release(bs);
+}
+
+static const msdk_char* FrameTypeName(mfxU16 frameType) {
+    if (frameType & MFX_FRAMETYPE_IDR)
+        return MSDK_STRING("IDR");
+    if (frameType & MFX_FRAMETYPE_I)
+        return MSDK_STRING("I");
+    if (frameType & MFX_FRAMETYPE_P)
+        return MSDK_STRING("P");
+    if (frameType & MFX_FRAMETYPE_B)
+        return MSDK_STRING("B");
+    return MSDK_STRING("?");
+}
+
+void CEncodeStatsWriter::WriterRoutine() {
+    std::vector<EncodeFrameStat> stats;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvQueued.wait(lock, [this]() {
+            return m_bStop || !m_Queue.empty();
+        });
+        // everything queued before Close() is written
+        bool bStop = m_bStop;
+        stats.swap(m_Queue);
+        lock.unlock();
+
+        for (const EncodeFrameStat& stat : stats) {
+            msdk_fprintf(m_file,
+                         MSDK_STRING("%u,%s,%u,%.2f,%.3f,%.3f,%.3f,%llu,%u,%u,%u\n"),
+                         stat.DisplayOrder,
+                         FrameTypeName(stat.FrameType),
+                         stat.Size,
+                         stat.Qp,
+                         stat.PSNRLuma,
+                         stat.PSNRCb,
+                         stat.PSNRCr,
+                         (unsigned long long)stat.SADLuma,
+                         stat.NumIntraBlock,
+                         stat.NumInterBlock,
+                         stat.NumSkippedBlock);
+        }
+        stats.clear();
+
+        lock.lock();
+        if (bStop && m_Queue.empty())
+            break;
+    }
+}
+
+#endif // ONEVPL_EXPERIMENTAL
@@ -0,0 +1,258 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "engine_utilization.h"
+#include <iomanip>
+
+#if defined(ENGINE_UTILIZATION_SUPPORT)
+    #include <chrono>
+    #include <vector>
+    #include "cttmetrics.h"
+#endif
+
+static const EngineUtilization EmptyUtilization = { 0, -1, -1, -1, -1, -1, -1, -1, -1 };
+
+CEngineUtilizationSampler::CEngineUtilizationSampler()
+        : m_mutex(),
+          m_thread(),
+          m_bStop(false),
+          m_Last(EmptyUtilization),
+          m_Sum(EmptyUtilization) {}
+
+CEngineUtilizationSampler::~CEngineUtilizationSampler() {
+    Stop();
+}
+
+#if defined(ENGINE_UTILIZATION_SUPPORT)
+mfxStatus CEngineUtilizationSampler::Start(const char* device, mfxU32 periodMs) {
+    MSDK_CHECK_ERROR(m_thread.joinable(), true, MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    cttStatus sts = CTTMetrics_Init(device);
+    if (CTT_ERR_NONE != sts) {
+        msdk_printf(MSDK_STRING("WARNING: metrics monitor initialization failed, error code %d\n"),
+                    (int)sts);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    unsigned int count                        = 0;
+    cttMetric available[CTT_MAX_METRIC_COUNT] = {};
+    sts                                       = CTTMetrics_GetMetricCount(&count);
+    if (CTT_ERR_NONE == sts)
+        sts = CTTMetrics_GetMetricInfo(count, available);
+
+    // the library requires ids in increasing order, which is the order of the enum
+    std::vector<cttMetric> ids;
+    for (cttMetric id : { CTT_USAGE_RENDER,
+                          CTT_USAGE_VIDEO,
+                          CTT_USAGE_VIDEO_ENHANCEMENT,
+                          CTT_USAGE_VIDEO2,
+                          CTT_AVG_GT_FREQ }) {
+        if (std::find(available, available + count, id) != available + count)
+            ids.push_back(id);
+    }
+
+    if (CTT_ERR_NONE == sts && ids.empty())
+        sts = CTT_ERR_UNSUPPORTED;
+    if (CTT_ERR_NONE == sts)
+        sts = CTTMetrics_Subscribe((unsigned int)ids.size(), ids.data());
+    if (CTT_ERR_NONE == sts)
+        sts = CTTMetrics_SetSamplePeriod(periodMs);
+    if (CTT_ERR_NONE != sts) {
+        msdk_printf(MSDK_STRING("WARNING: metrics monitor subscription failed, error code %d\n"),
+                    (int)sts);
+        CTTMetrics_Close();
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    // power is optional, the device API reads the energy counter without the library state
+    cttDevice* energyDevice = NULL;
+    double energy           = 0.0;
+    if (CTT_ERR_NONE != CTTMetrics_Device_Open(device, &energyDevice) ||
+        CTT_ERR_NONE != CTTMetrics_Device_GetEnergy(energyDevice, &energy)) {
+        CTTMetrics_Device_Close(energyDevice);
+        energyDevice = NULL;
+    }
+
+    // domains of the host, a domain without readable counter stays unavailable
+    cttEnergyMeter* energyMeter = NULL;
+    double hostEnergy[CTT_ENERGY_DOMAIN_COUNT];
+    bool hasHostEnergy[CTT_ENERGY_DOMAIN_COUNT] = {};
+    if (CTT_ERR_NONE == CTTMetrics_Energy_Open(&energyMeter)) {
+        for (int i = 0; i < CTT_ENERGY_DOMAIN_COUNT; i++)
+            hasHostEnergy[i] = (CTT_ERR_NONE ==
+                                CTTMetrics_Energy_Get(energyMeter,
+                                                      (cttEnergyDomain)i,
+                                                      &hostEnergy[i]));
+    }
+
+    m_bStop  = false;
+    m_Last   = EmptyUtilization;
+    m_Sum    = EmptyUtilization;
+    m_thread = std::thread([=]() mutable {
+        std::vector<float> values(ids.size());
+        auto energyTime = std::chrono::steady_clock::now();
+        for (;;) {
+            // blocks for the sampling period
+            if (CTT_ERR_NONE != CTTMetrics_GetValue((unsigned int)values.size(), values.data()))
+                break;
+
+            EngineUtilization last = EmptyUtilization;
+            last.NumPeriods        = 1;
+            for (size_t i = 0; i < ids.size(); i++) {
+                switch (ids[i]) {
+                    case CTT_USAGE_RENDER:
+                        last.Render = values[i];
+                        break;
+                    case CTT_USAGE_VIDEO:
+                        last.Video = values[i];
+                        break;
+                    case CTT_USAGE_VIDEO_ENHANCEMENT:
+                        last.VideoEnhance = values[i];
+                        break;
+                    case CTT_USAGE_VIDEO2:
+                        last.Video2 = values[i];
+                        break;
+                    case CTT_AVG_GT_FREQ:
+                        last.Frequency = values[i];
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            // all counters are read at once for the same period
+            auto lastTime  = std::chrono::steady_clock::now();
+            mfxF64 seconds = std::chrono::duration<mfxF64>(lastTime - energyTime).count();
+            energyTime     = lastTime;
+
+            double lastEnergy = 0.0;
+            if (energyDevice &&
+                CTT_ERR_NONE == CTTMetrics_Device_GetEnergy(energyDevice, &lastEnergy)) {
+                if (seconds > 0)
+                    last.Power = (lastEnergy - energy) / seconds;
+                energy = lastEnergy;
+            }
+
+            mfxF64* hostPower[CTT_ENERGY_DOMAIN_COUNT] = { &last.PackagePower, &last.DramPower };
+            for (int i = 0; i < CTT_ENERGY_DOMAIN_COUNT; i++) {
+                if (hasHostEnergy[i] &&
+                    CTT_ERR_NONE ==
+                        CTTMetrics_Energy_Get(energyMeter, (cttEnergyDomain)i, &lastEnergy)) {
+                    if (seconds > 0)
+                        *hostPower[i] = (lastEnergy - hostEnergy[i]) / seconds;
+                    hostEnergy[i] = lastEnergy;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_bStop)
+                break;
+            m_Last = last;
+            if (!m_Sum.NumPeriods) {
+                m_Sum = last;
+            }
+            else {
+                m_Sum.NumPeriods++;
+                m_Sum.Render += last.Render;
+                m_Sum.Video += last.Video;
+                m_Sum.Video2 += last.Video2;
+                m_Sum.VideoEnhance += last.VideoEnhance;
+                m_Sum.Frequency += last.Frequency;
+                m_Sum.Power += last.Power;
+                m_Sum.PackagePower += last.PackagePower;
+                m_Sum.DramPower += last.DramPower;
+            }
+        }
+        CTTMetrics_Device_Close(energyDevice);
+        CTTMetrics_Energy_Close(energyMeter);
+    });
+
+    return MFX_ERR_NONE;
+} // mfxStatus CEngineUtilizationSampler::Start()
+
+void CEngineUtilizationSampler::Stop() {
+    if (!m_thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    // sampler leaves after the current period at most
+    m_thread.join();
+    CTTMetrics_Close();
+} // void CEngineUtilizationSampler::Stop()
+#else
+mfxStatus CEngineUtilizationSampler::Start(const char* /*device*/, mfxU32 /*periodMs*/) {
+    msdk_printf(
+        MSDK_STRING("WARNING: engine utilization is not supported, metrics_monitor isn't built\n"));
+    return MFX_ERR_UNSUPPORTED;
+}
+
+void CEngineUtilizationSampler::Stop() {}
+#endif
+
+EngineUtilization CEngineUtilizationSampler::GetLast() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_Last;
+}
+
+EngineUtilization CEngineUtilizationSampler::GetAverage() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EngineUtilization average = m_Sum;
+    if (average.NumPeriods) {
+        // unavailable metrics stay negative
+        average.Render /= average.NumPeriods;
+        average.Video /= average.NumPeriods;
+        average.Video2 /= average.NumPeriods;
+        average.VideoEnhance /= average.NumPeriods;
+        average.Frequency /= average.NumPeriods;
+        average.Power /= average.NumPeriods;
+        average.PackagePower /= average.NumPeriods;
+        average.DramPower /= average.NumPeriods;
+    }
+    return average;
+}
+
+msdk_string CEngineUtilizationSampler::ToString(const EngineUtilization& utilization) {
+    if (!utilization.NumPeriods)
+        return msdk_string(MSDK_STRING("no samples"));
+
+    msdk_stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    auto add = [&ss](const msdk_char* name, mfxF64 value, const msdk_char* unit) {
+        if (value >= 0)
+            ss << (ss.tellp() > 0 ? MSDK_STRING(", ") : MSDK_STRING("")) << name
+               << MSDK_STRING(" ") << value << unit;
+    };
+    add(MSDK_STRING("RCS"), utilization.Render, MSDK_STRING("%"));
+    add(MSDK_STRING("VDBOX"), utilization.Video, MSDK_STRING("%"));
+    add(MSDK_STRING("VDBOX2"), utilization.Video2, MSDK_STRING("%"));
+    add(MSDK_STRING("VEBOX"), utilization.VideoEnhance, MSDK_STRING("%"));
+    add(MSDK_STRING("GT"), utilization.Frequency, MSDK_STRING(" MHz"));
+    add(MSDK_STRING("Power"), utilization.Power, MSDK_STRING(" W"));
+    add(MSDK_STRING("Package"), utilization.PackagePower, MSDK_STRING(" W"));
+    add(MSDK_STRING("DRAM"), utilization.DramPower, MSDK_STRING(" W"));
+    return ss.str();
+}
+
+msdk_string CEngineUtilizationSampler::ToEnergyString(const EngineUtilization& utilization,
+                                                      mfxF64 seconds,
+                                                      mfxU64 frames) {
+    msdk_stringstream ss;
+    if (!utilization.NumPeriods || !frames)
+        return ss.str();
+
+    ss << std::fixed << std::setprecision(3);
+    auto add = [&](const msdk_char* name, mfxF64 power) {
+        if (power >= 0)
+            ss << (ss.tellp() > 0 ? MSDK_STRING(", ") : MSDK_STRING("")) << name
+               << MSDK_STRING(" ") << power * seconds / frames << MSDK_STRING(" J");
+    };
+    add(MSDK_STRING("GPU"), utilization.Power);
+    add(MSDK_STRING("package"), utilization.PackagePower);
+    add(MSDK_STRING("DRAM"), utilization.DramPower);
+    return ss.str();
+}
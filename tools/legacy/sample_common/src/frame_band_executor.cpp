@@ -0,0 +1,201 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "frame_band_executor.h"
+
+// reversal of rows: AVX2 on x86 if the CPU has it
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h>
+    #define MSDK_ROTATE_AVX2 1
+    #define MSDK_TARGET_AVX2
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define MSDK_ROTATE_AVX2 1
+    #define MSDK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+CFrameBandExecutor::CFrameBandExecutor()
+        : m_Workers(),
+          m_mutex(),
+          m_cvJob(),
+          m_cvDone(),
+          m_Function(),
+          m_nRows(0),
+          m_nBands(0),
+          m_nNextBand(0),
+          m_nDoneBands(0),
+          m_bStop(false) {}
+
+CFrameBandExecutor::~CFrameBandExecutor() {
+    Close();
+}
+
+mfxStatus CFrameBandExecutor::Init(mfxU32 nThreads) {
+    Close();
+
+    if (!nThreads)
+        nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    m_bStop = false;
+    // the caller's thread takes bands in Wait()
+    for (mfxU32 i = 1; i < nThreads; i++)
+        m_Workers.emplace_back(&CFrameBandExecutor::WorkerRoutine, this);
+
+    return MFX_ERR_NONE;
+}
+
+void CFrameBandExecutor::Close() {
+    Wait();
+    if (m_Workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvJob.notify_all();
+    for (std::thread& worker : m_Workers)
+        worker.join();
+    m_Workers.clear();
+}
+
+void CFrameBandExecutor::Submit(mfxU32 rows, BandFunction function) {
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // a few bands per thread even out the bands which take longer
+        m_Function   = std::move(function);
+        m_nRows      = rows;
+        m_nBands     = std::min(rows, GetThreadCount() * 4);
+        m_nNextBand  = 0;
+        m_nDoneBands = 0;
+    }
+    m_cvJob.notify_all();
+}
+
+void CFrameBandExecutor::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    RunBands(lock);
+    m_cvDone.wait(lock, [this] {
+        return m_nDoneBands == m_nBands;
+    });
+}
+
+bool CFrameBandExecutor::NextBand(mfxU32& first, mfxU32& last) {
+    if (m_nNextBand >= m_nBands)
+        return false;
+
+    first = (mfxU32)((mfxU64)m_nRows * m_nNextBand / m_nBands);
+    m_nNextBand++;
+    last = (mfxU32)((mfxU64)m_nRows * m_nNextBand / m_nBands);
+    return true;
+}
+
+void CFrameBandExecutor::RunBands(std::unique_lock<std::mutex>& lock) {
+    mfxU32 first = 0, last = 0;
+    while (NextBand(first, last)) {
+        lock.unlock();
+        m_Function(first, last);
+        lock.lock();
+
+        if (++m_nDoneBands == m_nBands)
+            m_cvDone.notify_all();
+    }
+}
+
+void CFrameBandExecutor::WorkerRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvJob.wait(lock, [this] {
+            return m_bStop || m_nNextBand < m_nBands;
+        });
+        if (m_bStop)
+            break;
+        RunBands(lock);
+    }
+}
+
+namespace {
+#ifdef MSDK_ROTATE_AVX2
+// reverses order of elements of n bytes, mask reverses the elements within a 128 bit lane
+MSDK_TARGET_AVX2 size_t ReverseAVX2(mfxU8* pDst, const mfxU8* pSrc, size_t n, bool bPairs) {
+    const __m256i bytes = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                           15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i pairs = _mm256_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1,
+                                           14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+    const __m256i mask  = bPairs ? pairs : bytes;
+
+    size_t j = 0;
+    for (; j + 32 <= n; j += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(pSrc + n - j - 32));
+        x         = _mm256_shuffle_epi8(x, mask);
+        // swaps the lanes
+        _mm256_storeu_si256((__m256i*)(pDst + j), _mm256_permute4x64_epi64(x, 0x4E));
+    }
+    return j;
+}
+#endif
+
+// row of n bytes in reverse order of single bytes (luma) or of byte pairs (interleaved chroma)
+void ReverseRow(mfxU8* pDst, const mfxU8* pSrc, size_t n, bool bPairs) {
+    size_t j = 0;
+#ifdef MSDK_ROTATE_AVX2
+    static const bool bAVX2 = IsAVX2Supported();
+    if (bAVX2)
+        j = ReverseAVX2(pDst, pSrc, n, bPairs);
+#endif
+    if (bPairs) {
+        for (; j + 2 <= n; j += 2) {
+            pDst[j]     = pSrc[n - j - 2];
+            pDst[j + 1] = pSrc[n - j - 1];
+        }
+    }
+    else {
+        for (; j < n; j++)
+            pDst[j] = pSrc[n - j - 1];
+    }
+}
+} // namespace
+
+mfxStatus SubmitRotateNV12(CFrameBandExecutor& executor,
+                           const mfxFrameSurface1& src,
+                           mfxFrameSurface1& dst) {
+    const mfxFrameInfo& info = src.Info;
+    if (info.FourCC != MFX_FOURCC_NV12 || dst.Info.FourCC != MFX_FOURCC_NV12)
+        return MFX_ERR_UNSUPPORTED;
+    if (info.CropW != dst.Info.CropW || info.CropH != dst.Info.CropH)
+        return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+    MSDK_CHECK_POINTER(src.Data.Y, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(src.Data.UV, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(dst.Data.Y, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(dst.Data.UV, MFX_ERR_NOT_INITIALIZED);
+
+    size_t srcPitch = ((size_t)src.Data.PitchHigh << 16) + src.Data.PitchLow;
+    size_t dstPitch = ((size_t)dst.Data.PitchHigh << 16) + dst.Data.PitchLow;
+    size_t width    = info.CropW;
+    size_t widthUV  = (width + 1) & ~(size_t)1; // bytes of the chroma pairs
+    mfxU32 height   = info.CropH;
+
+    const mfxU8* pSrcY  = src.Data.Y + info.CropY * srcPitch + info.CropX;
+    const mfxU8* pSrcUV = src.Data.UV + info.CropY / 2 * srcPitch + (info.CropX & ~1);
+    mfxU8* pDstY        = dst.Data.Y + dst.Info.CropY * dstPitch + dst.Info.CropX;
+    mfxU8* pDstUV       = dst.Data.UV + dst.Info.CropY / 2 * dstPitch + (dst.Info.CropX & ~1);
+
+    // a band row is 2 luma rows and the chroma row they share
+    executor.Submit((height + 1) / 2, [=](mfxU32 first, mfxU32 last) {
+        for (mfxU32 r = first; r < last; r++) {
+            for (mfxU32 y = 2 * r; y < std::min(2 * r + 2, height); y++)
+                ReverseRow(pDstY + y * dstPitch, pSrcY + (height - 1 - y) * srcPitch, width, false);
+            ReverseRow(pDstUV + r * dstPitch,
+                       pSrcUV + ((height + 1) / 2 - 1 - r) * srcPitch,
+                       widthUV,
+                       true);
+        }
+    });
+
+    return MFX_ERR_NONE;
+}
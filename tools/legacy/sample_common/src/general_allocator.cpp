@@ -21,6 +21,117 @@
 
 #include "sample_defs.h"
 
+#include <string.h>
+#include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define MSDK_STREAMING_STORES 1
+#endif
+
+namespace {
+// frames from this size on are copied with non-temporal stores
+const size_t STREAMING_COPY_THRESHOLD = 1 << 20;
+
+struct sPlane {
+    mfxU8* pData;
+    mfxU32 pitch;
+    mfxU32 rowBytes;
+    mfxU32 rows;
+};
+
+// rows of the planes of the frame, returns the number of planes or 0 for unsupported formats
+mfxU32 GetPlanes(const mfxFrameInfo& info, const mfxFrameData& data, sPlane planes[3]) {
+    mfxU32 pitch  = ((mfxU32)data.PitchHigh << 16) + data.PitchLow;
+    mfxU32 width  = info.Width;
+    mfxU32 height = info.Height;
+
+    switch (info.FourCC) {
+        case MFX_FOURCC_NV12:
+        case MFX_FOURCC_P010:
+        case MFX_FOURCC_P016: {
+            mfxU32 bytes = (MFX_FOURCC_NV12 == info.FourCC) ? 1 : 2;
+            planes[0]    = { data.Y, pitch, width * bytes, height };
+            planes[1]    = { (std::min)(data.U, data.V),
+                          pitch,
+                          MSDK_ALIGN(width, 2) * bytes,
+                          (height + 1) / 2 };
+            return 2;
+        }
+        case MFX_FOURCC_YV12:
+        case MFX_FOURCC_I420: {
+            // chroma planes have half the pitch
+            planes[0] = { data.Y, pitch, width, height };
+            planes[1] = { data.U, pitch / 2, (width + 1) / 2, (height + 1) / 2 };
+            planes[2] = { data.V, pitch / 2, (width + 1) / 2, (height + 1) / 2 };
+            return 3;
+        }
+        case MFX_FOURCC_YUY2:
+        case MFX_FOURCC_RGB4:
+        case MFX_FOURCC_BGR4:
+        case MFX_FOURCC_AYUV:
+        case MFX_FOURCC_A2RGB10:
+        case MFX_FOURCC_Y210:
+        case MFX_FOURCC_Y216:
+        case MFX_FOURCC_Y410:
+        case MFX_FOURCC_Y416:
+        case MFX_FOURCC_ARGB16:
+        case MFX_FOURCC_ABGR16: {
+            mfxU32 bytes = 4;
+            if (MFX_FOURCC_YUY2 == info.FourCC)
+                bytes = 2;
+            else if (MFX_FOURCC_Y416 == info.FourCC || MFX_FOURCC_ARGB16 == info.FourCC ||
+                     MFX_FOURCC_ABGR16 == info.FourCC)
+                bytes = 8;
+
+            // the channels are interleaved, the first of them starts the plane
+            mfxU8* pBase = NULL;
+            for (mfxU8* p : { data.Y, data.U, data.V, data.A }) {
+                if (p && (!pBase || p < pBase))
+                    pBase = p;
+            }
+            planes[0] = { pBase, pitch, width * bytes, height };
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+void CopyPlane(const sPlane& dst, const sPlane& src, bool bStreaming) {
+    mfxU32 rowBytes = (std::min)(dst.rowBytes, src.rowBytes);
+    mfxU32 rows     = (std::min)(dst.rows, src.rows);
+
+    mfxU8* pDst       = dst.pData;
+    const mfxU8* pSrc = src.pData;
+    for (mfxU32 i = 0; i < rows; i++, pDst += dst.pitch, pSrc += src.pitch) {
+#ifdef MSDK_STREAMING_STORES
+        if (bStreaming) {
+            // stores need 16 byte aligned destination, the rest of the row is copied as is
+            size_t head = (16 - ((uintptr_t)pDst & 15)) & 15;
+            if (head > rowBytes)
+                head = rowBytes;
+            memcpy(pDst, pSrc, head);
+
+            size_t j = head;
+            for (; j + 64 <= rowBytes; j += 64) {
+                __m128i x0 = _mm_loadu_si128((const __m128i*)(pSrc + j));
+                __m128i x1 = _mm_loadu_si128((const __m128i*)(pSrc + j + 16));
+                __m128i x2 = _mm_loadu_si128((const __m128i*)(pSrc + j + 32));
+                __m128i x3 = _mm_loadu_si128((const __m128i*)(pSrc + j + 48));
+                _mm_stream_si128((__m128i*)(pDst + j), x0);
+                _mm_stream_si128((__m128i*)(pDst + j + 16), x1);
+                _mm_stream_si128((__m128i*)(pDst + j + 32), x2);
+                _mm_stream_si128((__m128i*)(pDst + j + 48), x3);
+            }
+            memcpy(pDst + j, pSrc + j, rowBytes - j);
+            continue;
+        }
+#endif
+        memcpy(pDst, pSrc, rowBytes);
+    }
+}
+} // namespace
+
 // Wrapper on standard allocator for concurrent allocation of
 // D3D and system surfaces
 GeneralAllocator::GeneralAllocator(){};
@@ -50,8 +161,12 @@ mfxStatus GeneralAllocator::Init(mfxAllocatorParams* pParams) {
         MSDK_CHECK_STATUS(sts, "m_D3DAllocator.get failed");
     }
 
+    SysMemAllocatorParams sysParams;
+    sysParams.NumaNode       = m_NumaNode;
+    sysParams.bPooledBuffers = m_bPooledSysMem;
+
     m_SYSAllocator.reset(new SysMemFrameAllocator());
-    sts = m_SYSAllocator->Init(0);
+    sts = m_SYSAllocator->Init(&sysParams);
     MSDK_CHECK_STATUS(sts, "m_SYSAllocator.get failed");
 
     return sts;
@@ -139,6 +254,87 @@ void GeneralAllocator::StoreFrameMids(bool isD3DFrames, mfxFrameAllocResponse* r
     for (mfxU32 i = 0; i < response->NumFrameActual; i++)
         m_Mids.insert(std::pair<mfxHDL, bool>(response->mids[i], isD3DFrames));
 }
+mfxStatus GeneralAllocator::StartReadback(mfxMemId mid) {
+#if defined(_WIN32) || defined(_WIN64)
+    #if MFX_D3D11_SUPPORT
+    D3D11FrameAllocator* pD3D11Allocator =
+        dynamic_cast<D3D11FrameAllocator*>(m_D3DAllocator.get());
+    if (isD3DMid(mid) && pD3D11Allocator)
+        return pD3D11Allocator->StartReadback(mid);
+    #endif
+#endif
+    return MFX_ERR_UNSUPPORTED;
+}
+mfxStatus GeneralAllocator::CopyFrame(mfxFrameSurface1* pDst, mfxFrameSurface1* pSrc) {
+    MSDK_CHECK_POINTER(pDst, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pSrc, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_NOT_EQUAL(pDst->Info.FourCC, pSrc->Info.FourCC, MFX_ERR_INCOMPATIBLE_VIDEO_PARAM);
+
+    mfxFrameSurface1* pSurfaces[2] = { pDst, pSrc };
+    mfxFrameData data[2]           = { pDst->Data, pSrc->Data };
+    bool bLocked[2]                = { false, false };
+
+    mfxStatus sts = MFX_ERR_NONE;
+    for (int i = 0; i < 2 && MFX_ERR_NONE == sts; i++) {
+        bool bMapped = data[i].Y || data[i].U || data[i].V || data[i].A;
+        if (!bMapped && data[i].MemId) {
+            sts        = LockFrame(data[i].MemId, &data[i]);
+            bLocked[i] = (MFX_ERR_NONE == sts);
+        }
+    }
+
+    if (MFX_ERR_NONE == sts) {
+        sPlane dstPlanes[3], srcPlanes[3];
+        mfxU32 numPlanes = GetPlanes(pDst->Info, data[0], dstPlanes);
+        GetPlanes(pSrc->Info, data[1], srcPlanes);
+
+        size_t frameSize = 0;
+        for (mfxU32 i = 0; i < numPlanes; i++)
+            frameSize += (size_t)dstPlanes[i].rowBytes * dstPlanes[i].rows;
+        bool bStreaming = frameSize >= STREAMING_COPY_THRESHOLD;
+
+        if (!numPlanes)
+            sts = MFX_ERR_UNSUPPORTED;
+        for (mfxU32 i = 0; i < numPlanes && MFX_ERR_NONE == sts; i++) {
+            if (!dstPlanes[i].pData || !srcPlanes[i].pData)
+                sts = MFX_ERR_NULL_PTR;
+            else
+                CopyPlane(dstPlanes[i], srcPlanes[i], bStreaming);
+        }
+#ifdef MSDK_STREAMING_STORES
+        // the stores are made visible to the other threads and devices
+        if (bStreaming)
+            _mm_sfence();
+#endif
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (bLocked[i]) {
+            mfxStatus unlockSts = UnlockFrame(pSurfaces[i]->Data.MemId, &data[i]);
+            if (MFX_ERR_NONE == sts)
+                sts = unlockSts;
+        }
+    }
+
+    return sts;
+}
+
+mfxStatus GeneralAllocator::CopyFrames(
+    const std::vector<std::pair<mfxFrameSurface1*, mfxFrameSurface1*>>& frames) {
+    for (const std::pair<mfxFrameSurface1*, mfxFrameSurface1*>& frame : frames) {
+        mfxStatus sts = CopyFrame(frame.first, frame.second);
+        MSDK_CHECK_STATUS(sts, "CopyFrame failed");
+    }
+    return MFX_ERR_NONE;
+}
+
+std::future<mfxStatus> GeneralAllocator::CopyFramesAsync(
+    std::vector<std::pair<mfxFrameSurface1*, mfxFrameSurface1*>> frames) {
+    return std::async(std::launch::async, [this, frames]() {
+        return CopyFrames(frames);
+    });
+}
+
 bool GeneralAllocator::isD3DMid(mfxHDL mid) {
     std::map<mfxHDL, bool>::iterator it;
     it = m_Mids.find(mid);
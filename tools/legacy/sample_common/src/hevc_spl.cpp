@@ -0,0 +1,177 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <string.h>
+#include <algorithm>
+
+#include "hevc_spl.h"
+#include "sample_defs.h"
+
+namespace ProtectedLibrary {
+
+enum {
+    HEVC_NAL_UT_VPS               = 32,
+    HEVC_NAL_UT_AUD               = 35,
+    HEVC_NAL_UT_PREFIX_SEI        = 39,
+    HEVC_NAL_UT_RSV_NVCL41        = 41,
+    HEVC_NAL_UT_RSV_NVCL44        = 44,
+    HEVC_NAL_UT_UNSPEC48          = 48,
+    HEVC_NAL_UT_UNSPEC55          = 55,
+    HEVC_NAL_UNIT_HEADER_SIZE     = 2,
+    HEVC_START_CODE_PREFIX_SIZE   = 3,
+    HEVC_MIN_SLICE_NAL_UNIT_BYTES = HEVC_START_CODE_PREFIX_SIZE + HEVC_NAL_UNIT_HEADER_SIZE + 1
+};
+
+// returns offset of 00 00 01 or size if there is none
+static mfxU32 FindStartCode(const mfxU8* pData, mfxU32 size) {
+    const mfxU8* pEnd = pData + size;
+    for (const mfxU8* p = pData + 2; p < pEnd && (p = (const mfxU8*)memchr(p, 1, pEnd - p)); p++) {
+        if (0 == p[-1] && 0 == p[-2])
+            return (mfxU32)(p - 2 - pData);
+    }
+    return size;
+}
+
+// NAL units which precede the first slice of a picture begin a new access unit (7.4.2.4.4)
+static bool IsAccessUnitPrefix(mfxU32 nalType) {
+    return (nalType >= HEVC_NAL_UT_VPS && nalType <= HEVC_NAL_UT_AUD) ||
+           nalType == HEVC_NAL_UT_PREFIX_SEI ||
+           (nalType >= HEVC_NAL_UT_RSV_NVCL41 && nalType <= HEVC_NAL_UT_RSV_NVCL44) ||
+           (nalType >= HEVC_NAL_UT_UNSPEC48 && nalType <= HEVC_NAL_UT_UNSPEC55);
+}
+
+static void MoveBitstream(mfxBitstream* bs, mfxU32 size) {
+    bs->DataOffset += size;
+    bs->DataLength -= size;
+}
+
+HEVC_Spl::HEVC_Spl()
+        : m_bInNalUnit(false),
+          m_bNalUnitIsSlice(false),
+          m_accessUnit(),
+          m_accessUnitSlices(),
+          m_bAccessUnitHasSlices(false),
+          m_accessUnitTimeStamp(0),
+          m_frameData(),
+          m_slices(),
+          m_frame() {}
+
+HEVC_Spl::~HEVC_Spl() {}
+
+mfxStatus HEVC_Spl::Reset() {
+    m_bInNalUnit      = false;
+    m_bNalUnitIsSlice = false;
+    m_accessUnit.clear();
+    m_accessUnitSlices.clear();
+    m_bAccessUnitHasSlices = false;
+    ResetCurrentState();
+    return MFX_ERR_NONE;
+}
+
+void HEVC_Spl::ResetCurrentState() {
+    m_frame.DataLength         = 0;
+    m_frame.SliceNum           = 0;
+    m_frame.FirstFieldSliceNum = 0;
+}
+
+mfxStatus HEVC_Spl::PostProcessing(FrameSplitterInfo* frame, mfxU32 sliceNum) {
+    UNREFERENCED_PARAMETER(frame);
+    UNREFERENCED_PARAMETER(sliceNum);
+    return MFX_ERR_NONE;
+}
+
+void HEVC_Spl::CompleteNalUnit() {
+    if (m_bInNalUnit && m_bNalUnitIsSlice) {
+        SliceSplitterInfo& slice = m_accessUnitSlices.back();
+        slice.DataLength         = (mfxU32)m_accessUnit.size() - slice.DataOffset;
+    }
+    m_bInNalUnit = false;
+}
+
+void HEVC_Spl::CompleteFrame() {
+    m_frameData.swap(m_accessUnit);
+    m_slices.swap(m_accessUnitSlices);
+    m_accessUnit.clear();
+    m_accessUnitSlices.clear();
+    m_bAccessUnitHasSlices = false;
+
+    m_frame.Data               = m_frameData.data();
+    m_frame.DataLength         = (mfxU32)m_frameData.size();
+    m_frame.Slice              = m_slices.data();
+    m_frame.SliceNum           = (mfxU32)m_slices.size();
+    m_frame.FirstFieldSliceNum = m_frame.SliceNum;
+    m_frame.TimeStamp          = m_accessUnitTimeStamp;
+}
+
+mfxStatus HEVC_Spl::GetFrame(mfxBitstream* bs_in, FrameSplitterInfo** frame) {
+    MSDK_CHECK_POINTER(frame, MFX_ERR_NULL_PTR);
+    *frame = 0;
+
+    // end of stream completes the last access unit
+    if (!bs_in) {
+        CompleteNalUnit();
+        if (!m_bAccessUnitHasSlices) {
+            m_accessUnit.clear();
+            return MFX_ERR_MORE_DATA;
+        }
+        CompleteFrame();
+        *frame = &m_frame;
+        return MFX_ERR_NONE;
+    }
+
+    for (;;) {
+        mfxU8* pData      = bs_in->Data + bs_in->DataOffset;
+        mfxU32 nStartCode = FindStartCode(pData, bs_in->DataLength);
+        bool bNoStartCode = nStartCode == bs_in->DataLength;
+        // up to 2 zeros at the end may begin a start code, NAL units don't end with zero byte
+        mfxU32 nBytes = nStartCode;
+        while (bNoStartCode && nBytes && nStartCode - nBytes < 2 && 0 == pData[nBytes - 1])
+            nBytes--;
+
+        if (m_bInNalUnit)
+            m_accessUnit.insert(m_accessUnit.end(), pData, pData + nBytes);
+        MoveBitstream(bs_in, nBytes);
+        if (bNoStartCode)
+            return MFX_ERR_MORE_DATA;
+
+        CompleteNalUnit();
+
+        // NAL unit header and first_slice_segment_in_pic_flag tell where access unit begins
+        pData = bs_in->Data + bs_in->DataOffset;
+        if (bs_in->DataLength < HEVC_START_CODE_PREFIX_SIZE + HEVC_NAL_UNIT_HEADER_SIZE)
+            return MFX_ERR_MORE_DATA;
+        mfxU32 nalType = (pData[HEVC_START_CODE_PREFIX_SIZE] >> 1) & 0x3F;
+        bool bSlice    = nalType < HEVC_NAL_UT_VPS;
+        if (bSlice && bs_in->DataLength < HEVC_MIN_SLICE_NAL_UNIT_BYTES)
+            return MFX_ERR_MORE_DATA;
+
+        bool bFirstInAccessUnit =
+            bSlice ? 0 != (pData[HEVC_MIN_SLICE_NAL_UNIT_BYTES - 1] & 0x80)
+                   : IsAccessUnitPrefix(nalType);
+        if (bFirstInAccessUnit && m_bAccessUnitHasSlices) {
+            CompleteFrame();
+            *frame = &m_frame;
+            return MFX_ERR_NONE;
+        }
+
+        if (m_accessUnit.empty())
+            m_accessUnitTimeStamp = bs_in->TimeStamp;
+        if (bSlice) {
+            SliceSplitterInfo slice = {};
+            slice.DataOffset        = (mfxU32)m_accessUnit.size();
+            slice.SliceType         = TYPE_UNKNOWN;
+            m_accessUnitSlices.push_back(slice);
+            m_bAccessUnitHasSlices = true;
+        }
+
+        m_accessUnit.insert(m_accessUnit.end(), pData, pData + HEVC_START_CODE_PREFIX_SIZE);
+        MoveBitstream(bs_in, HEVC_START_CODE_PREFIX_SIZE);
+        m_bInNalUnit      = true;
+        m_bNalUnitIsSlice = bSlice;
+    }
+}
+
+} // namespace ProtectedLibrary
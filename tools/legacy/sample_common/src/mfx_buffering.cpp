@@ -15,13 +15,13 @@ CBuffering::CBuffering()
           m_OutputSurfacesNumber(0),
           m_pSurfaces(NULL),
           m_pVppSurfaces(NULL),
-          m_FreeSurfacesPool(m_Mutex),
-          m_FreeVppSurfacesPool(m_Mutex),
+          m_FreeSurfacesPool(),
+          m_FreeVppSurfacesPool(),
           m_UsedSurfacesPool(m_Mutex),
           m_UsedVppSurfacesPool(m_Mutex),
-          m_pFreeOutputSurfaces(NULL),
-          m_OutputSurfacesPool(m_Mutex),
-          m_DeliveredSurfacesPool(m_Mutex) {}
+          m_FreeOutputSurfaces(),
+          m_OutputSurfacesPool(),
+          m_DeliveredSurfacesPool() {}
 
 CBuffering::~CBuffering() {}
 
@@ -38,21 +38,13 @@ mfxStatus CBuffering::AllocBuffers(mfxU32 SurfaceNumber) {
     if (!m_pSurfaces)
         return MFX_ERR_MEMORY_ALLOC;
 
-    msdkOutputSurface* p    = NULL;
-    msdkOutputSurface* tail = NULL;
+    msdkOutputSurface* p = NULL;
 
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
-    if (!m_pFreeOutputSurfaces)
-        return MFX_ERR_MEMORY_ALLOC;
-
-    tail = m_pFreeOutputSurfaces;
-
-    for (mfxU32 i = 1; i < m_OutputSurfacesNumber; ++i) {
+    for (mfxU32 i = 0; i < m_OutputSurfacesNumber; ++i) {
         p = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
         if (!p)
             return MFX_ERR_MEMORY_ALLOC;
-        tail->next = p;
-        tail       = p;
+        m_FreeOutputSurfaces.Push(p);
     }
 
     ResetBuffers();
@@ -70,12 +62,12 @@ mfxStatus CBuffering::AllocVppBuffers(mfxU32 VppSurfaceNumber) {
 }
 
 void CBuffering::AllocOutputBuffer() {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-
-    m_pFreeOutputSurfaces = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
+    msdkOutputSurface* p = (msdkOutputSurface*)calloc(1, sizeof(msdkOutputSurface));
+    if (p)
+        m_FreeOutputSurfaces.Push(p);
 }
 
-static void FreeList(msdkOutputSurface*& head) {
+static void FreeList(msdkOutputSurface* head) {
     msdkOutputSurface* next;
     while (head) {
         next = head->next;
@@ -84,6 +76,13 @@ static void FreeList(msdkOutputSurface*& head) {
     }
 }
 
+static void FreeList(msdkOutputSurfacesPool& pool) {
+    msdkOutputSurface* next;
+    while ((next = pool.GetSurface()) != NULL) {
+        free(next);
+    }
+}
+
 void CBuffering::FreeBuffers() {
     if (m_pSurfaces) {
         free(m_pSurfaces);
@@ -95,24 +94,22 @@ void CBuffering::FreeBuffers() {
         m_pVppSurfaces = NULL;
     }
 
-    FreeList(m_pFreeOutputSurfaces);
-    FreeList(m_OutputSurfacesPool.m_pSurfacesHead);
-    FreeList(m_DeliveredSurfacesPool.m_pSurfacesHead);
+    FreeList(m_FreeOutputSurfaces.PopAll());
+    FreeList(m_OutputSurfacesPool);
+    FreeList(m_DeliveredSurfacesPool);
 
     m_UsedSurfacesPool.m_pSurfacesHead    = NULL;
     m_UsedSurfacesPool.m_pSurfacesTail    = NULL;
     m_UsedVppSurfacesPool.m_pSurfacesHead = NULL;
     m_UsedVppSurfacesPool.m_pSurfacesTail = NULL;
-    m_OutputSurfacesPool.m_pSurfacesHead  = NULL;
-    m_OutputSurfacesPool.m_pSurfacesTail  = NULL;
 
-    m_FreeSurfacesPool.m_pSurfaces    = NULL;
-    m_FreeVppSurfacesPool.m_pSurfaces = NULL;
+    m_FreeSurfacesPool.m_Surfaces.Reset(NULL);
+    m_FreeVppSurfacesPool.m_Surfaces.Reset(NULL);
 }
 
 void CBuffering::ResetBuffers() {
     mfxU32 i;
-    msdkFrameSurface* pFreeSurf = m_FreeSurfacesPool.m_pSurfaces = m_pSurfaces;
+    msdkFrameSurface* pFreeSurf = m_pSurfaces;
 
     for (i = 0; i < m_SurfacesNumber; ++i) {
         if (i < (m_SurfacesNumber - 1)) {
@@ -120,11 +117,12 @@ void CBuffering::ResetBuffers() {
             pFreeSurf[i + 1].prev = &(pFreeSurf[i]);
         }
     }
+    m_FreeSurfacesPool.m_Surfaces.Reset(pFreeSurf);
 }
 
 void CBuffering::ResetVppBuffers() {
     mfxU32 i;
-    msdkFrameSurface* pFreeVppSurf = m_FreeVppSurfacesPool.m_pSurfaces = m_pVppSurfaces;
+    msdkFrameSurface* pFreeVppSurf = m_pVppSurfaces;
 
     for (i = 0; i < m_OutputSurfacesNumber; ++i) {
         if (i < (m_OutputSurfacesNumber - 1)) {
@@ -132,6 +130,7 @@ void CBuffering::ResetVppBuffers() {
             pFreeVppSurf[i + 1].prev = &(pFreeVppSurf[i]);
         }
     }
+    m_FreeVppSurfacesPool.m_Surfaces.Reset(pFreeVppSurf);
 }
 
 void CBuffering::SyncFrameSurfaces() {
@@ -146,8 +145,9 @@ void CBuffering::SyncFrameSurfaces() {
         }
         else {
             // frame was unlocked: moving it to the free surfaces array
+            next = cur->next;
             m_UsedSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeSurfacesPool.AddSurfaceUnsafe(cur);
+            m_FreeSurfacesPool.AddSurface(cur);
 
             cur = next;
         }
@@ -166,8 +166,9 @@ void CBuffering::SyncVppFrameSurfaces() {
         }
         else {
             // frame was unlocked: moving it to the free surfaces array
+            next = cur->next;
             m_UsedVppSurfacesPool.DetachSurfaceUnsafe(cur);
-            m_FreeVppSurfacesPool.AddSurfaceUnsafe(cur);
+            m_FreeVppSurfacesPool.AddSurface(cur);
 
             cur = next;
         }
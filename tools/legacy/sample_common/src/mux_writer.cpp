@@ -0,0 +1,985 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "mux_writer.h"
+
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// output is written once it exceeds this size, if no random access point comes earlier
+const size_t MUX_FLUSH_SIZE = 4 * 1024 * 1024;
+
+const mfxU32 TS_PACKET_SIZE = 188;
+const mfxU16 TS_PID_PAT     = 0x0000;
+const mfxU16 TS_PID_PMT     = 0x1000;
+const mfxU16 TS_PID_VIDEO   = 0x0100;
+// PTS and DTS are ahead of PCR, so decoder has the access unit before it is due
+const mfxI64 TS_DELAY      = 63000;
+const mfxU64 TS_TIME_MASK  = (1ull << 33) - 1;
+const mfxU32 MP4_TIMESCALE = 90000;
+
+mfxU32 CRC32MPEG2(const mfxU8* pData, mfxU32 size) {
+    mfxU32 crc = 0xFFFFFFFF;
+    for (mfxU32 i = 0; i < size; i++) {
+        crc ^= (mfxU32)pData[i] << 24;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+    return crc;
+}
+
+// PTS and DTS fields of the PES header, prefix is 0010 for PTS only, 0011 and 0001 for both
+mfxU8* PutPESTime(mfxU8* p, mfxU8 prefix, mfxU64 t) {
+    p[0] = (mfxU8)((prefix << 4) | ((t >> 29) & 0x0E) | 1);
+    p[1] = (mfxU8)(t >> 22);
+    p[2] = (mfxU8)(((t >> 14) & 0xFE) | 1);
+    p[3] = (mfxU8)(t >> 7);
+    p[4] = (mfxU8)(((t << 1) & 0xFE) | 1);
+    return p + 5;
+}
+
+// reads syntax elements of the parameter set payload with emulation prevention bytes removed
+class RbspReader {
+public:
+    RbspReader(const mfxU8* pData, mfxU32 size) : m_rbsp(), m_bitPos(0) {
+        m_rbsp.reserve(size);
+        for (mfxU32 i = 0; i < size; i++) {
+            if (i >= 2 && pData[i] == 0x03 && pData[i - 1] == 0 && pData[i - 2] == 0)
+                continue;
+            m_rbsp.push_back(pData[i]);
+        }
+    }
+
+    // bits beyond the end are read as 0
+    mfxU32 GetBits(mfxU32 n) {
+        mfxU32 value = 0;
+        for (mfxU32 i = 0; i < n; i++, m_bitPos++) {
+            mfxU32 bit = 0;
+            if (m_bitPos / 8 < m_rbsp.size())
+                bit = (m_rbsp[m_bitPos / 8] >> (7 - m_bitPos % 8)) & 1;
+            value = (value << 1) | bit;
+        }
+        return value;
+    }
+
+    mfxU32 GetUE() {
+        mfxU32 zeros = 0;
+        while (!GetBits(1) && zeros < 32)
+            zeros++;
+        return ((1u << zeros) - 1) + GetBits(zeros);
+    }
+
+    mfxI32 GetSE() {
+        mfxU32 code = GetUE();
+        return (code & 1) ? (mfxI32)((code + 1) / 2) : -(mfxI32)(code / 2);
+    }
+
+private:
+    std::vector<mfxU8> m_rbsp;
+    size_t m_bitPos;
+};
+
+} // namespace
+
+MuxContainer GetMuxContainer(const msdk_char* strFileName) {
+    if (!strFileName)
+        return MUX_NONE;
+
+    msdk_string name(strFileName);
+    size_t dot = name.rfind(MSDK_CHAR('.'));
+    if (dot == msdk_string::npos)
+        return MUX_NONE;
+
+    const msdk_char* ext = name.c_str() + dot;
+    if (!msdk_stricmp(ext, MSDK_STRING(".ts")))
+        return MUX_MPEG_TS;
+    if (!msdk_stricmp(ext, MSDK_STRING(".mp4")))
+        return MUX_FMP4;
+    return MUX_NONE;
+}
+
+CMuxWriter* CreateMuxWriter(MuxContainer container) {
+    switch (container) {
+        case MUX_MPEG_TS:
+            return new CTSMuxWriter;
+        case MUX_FMP4:
+            return new CMP4FragmentWriter;
+        default:
+            return NULL;
+    }
+}
+
+CMuxWriter::CMuxWriter()
+        : CSmplBitstreamWriter(),
+          m_codecId(0),
+          m_frameDuration(0),
+          m_nals(),
+          m_out(),
+          m_firstTimeStamp(0),
+          m_bGenerateTimeStamps(false),
+          m_lastDts(0),
+          m_nAccessUnits(0) {}
+
+mfxStatus CMuxWriter::Init(const msdk_char* strFileName,
+                           mfxU32 codecId,
+                           mfxU32 frameRateExtN,
+                           mfxU32 frameRateExtD) {
+    MSDK_CHECK_ERROR(codecId == MFX_CODEC_AVC || codecId == MFX_CODEC_HEVC,
+                     false,
+                     MFX_ERR_UNSUPPORTED);
+
+    mfxStatus sts = CSmplBitstreamWriter::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamWriter::Init failed");
+
+    m_codecId = codecId;
+    // 30 fps if the frame rate is not known
+    m_frameDuration = (frameRateExtN && frameRateExtD)
+                          ? (mfxI64)MP4_TIMESCALE * frameRateExtD / frameRateExtN
+                          : MP4_TIMESCALE / 30;
+    m_out.reserve(MUX_FLUSH_SIZE + TS_PACKET_SIZE);
+    ResetState();
+
+    return MFX_ERR_NONE;
+}
+
+void CMuxWriter::ResetState() {
+    m_out.clear();
+    m_firstTimeStamp      = 0;
+    m_bGenerateTimeStamps = false;
+    m_lastDts             = 0;
+    m_nAccessUnits        = 0;
+}
+
+mfxStatus CMuxWriter::Reset() {
+    if (m_bInited && msdk_is_stream(m_sFile.c_str()))
+        return MFX_ERR_NONE;
+
+    // container starts over in the reopened file
+    Close();
+    mfxStatus sts = CSmplBitstreamWriter::Init(m_sFile.c_str());
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamWriter::Init failed");
+    ResetState();
+
+    return MFX_ERR_NONE;
+}
+
+void CMuxWriter::Close() {
+    if (m_bInited && m_fSource) {
+        FinishSegment();
+        Flush();
+    }
+    CSmplBitstreamWriter::Close();
+}
+
+mfxStatus CMuxWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                     bool isPrint,
+                                     bool isCompleteFrame) {
+    MFX_ITT_TASK("WriteNextFrame");
+    if (m_bSkipWriting)
+        return MFX_ERR_NONE;
+
+    MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
+
+    // partial output stays in the bitstream until the frame is complete
+    if (!isCompleteFrame || !pMfxBitstream->DataLength)
+        return MFX_ERR_NONE;
+
+    mfxStatus sts = MuxAccessUnit(pMfxBitstream->Data + pMfxBitstream->DataOffset,
+                                  pMfxBitstream->DataLength,
+                                  pMfxBitstream->TimeStamp,
+                                  pMfxBitstream->DecodeTimeStamp);
+    MSDK_CHECK_STATUS(sts, "MuxAccessUnit failed");
+
+    pMfxBitstream->DataLength = 0;
+    pMfxBitstream->DataOffset = 0;
+
+    m_nProcessedFramesNum++;
+    if (isPrint && (1 == m_nProcessedFramesNum || (0 == (m_nProcessedFramesNum % 100)))) {
+        msdk_printf(MSDK_STRING("Frame number: %u\r"), (unsigned int)m_nProcessedFramesNum);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CMuxWriter::MuxAccessUnit(const mfxU8* pData,
+                                    mfxU32 size,
+                                    mfxU64 timeStamp,
+                                    mfxI64 dts) {
+    // time stamps are generated if the encoder passes through input time stamps which weren't set
+    const mfxU64 unknown = (mfxU64)MFX_TIMESTAMP_UNKNOWN;
+    if (!m_nAccessUnits) {
+        m_firstTimeStamp      = timeStamp == unknown ? 0 : timeStamp;
+        m_bGenerateTimeStamps = timeStamp == unknown;
+    }
+    else if (timeStamp == unknown || timeStamp == m_firstTimeStamp) {
+        m_bGenerateTimeStamps = true;
+    }
+
+    mfxI64 pts = (mfxI64)timeStamp;
+    if (m_bGenerateTimeStamps)
+        pts = dts = (mfxI64)m_firstTimeStamp + (mfxI64)m_nAccessUnits * m_frameDuration;
+    if (dts > pts)
+        dts = pts;
+    if (m_nAccessUnits && dts <= m_lastDts)
+        dts = m_lastDts + 1;
+    if (pts < dts)
+        pts = dts;
+
+    ParseNalUnits(pData, size);
+    bool bKey = false;
+    for (const NalUnit& nal : m_nals) {
+        if (m_codecId == MFX_CODEC_AVC)
+            bKey |= nal.type == 5;
+        else
+            bKey |= nal.type >= 16 && nal.type <= 21; // IRAP pictures
+    }
+
+    mfxStatus sts = WriteAccessUnit(pData, size, pts, dts, bKey);
+    MSDK_CHECK_STATUS(sts, "WriteAccessUnit failed");
+
+    m_lastDts = dts;
+    m_nAccessUnits++;
+
+    if (m_out.size() >= MUX_FLUSH_SIZE)
+        return Flush();
+    return MFX_ERR_NONE;
+}
+
+void CMuxWriter::ParseNalUnits(const mfxU8* pData, mfxU32 size) {
+    m_nals.clear();
+
+    mfxU32 i = 0;
+    while (i + 3 <= size) {
+        if (pData[i + 2] > 1) {
+            i += 3;
+        }
+        else if (pData[i] || pData[i + 1] || pData[i + 2] != 1) {
+            i++;
+        }
+        else {
+            if (!m_nals.empty())
+                m_nals.back().size = i - m_nals.back().offset;
+            m_nals.push_back({ i + 3, 0, 0 });
+            i += 3;
+        }
+    }
+    if (!m_nals.empty())
+        m_nals.back().size = size - m_nals.back().offset;
+
+    for (NalUnit& nal : m_nals) {
+        // zero bytes before the next start code don't belong to the NAL unit
+        while (nal.size && !pData[nal.offset + nal.size - 1])
+            nal.size--;
+        if (nal.size) {
+            mfxU8 header = pData[nal.offset];
+            nal.type     = m_codecId == MFX_CODEC_AVC ? (header & 0x1F) : ((header >> 1) & 0x3F);
+        }
+    }
+}
+
+bool CMuxWriter::IsParameterSet(mfxU8 type) const {
+    if (m_codecId == MFX_CODEC_AVC)
+        return type == 7 || type == 8;
+    return type >= 32 && type <= 34;
+}
+
+void CMuxWriter::Put16(mfxU16 value) {
+    Put8((mfxU8)(value >> 8));
+    Put8((mfxU8)value);
+}
+
+void CMuxWriter::Put32(mfxU32 value) {
+    Put16((mfxU16)(value >> 16));
+    Put16((mfxU16)value);
+}
+
+void CMuxWriter::Put64(mfxU64 value) {
+    Put32((mfxU32)(value >> 32));
+    Put32((mfxU32)value);
+}
+
+mfxStatus CMuxWriter::Flush() {
+    if (m_out.empty())
+        return MFX_ERR_NONE;
+
+    size_t nBytesWritten = fwrite(m_out.data(), 1, m_out.size(), m_fSource);
+    MSDK_CHECK_NOT_EQUAL(nBytesWritten, m_out.size(), MFX_ERR_UNDEFINED_BEHAVIOR);
+    m_out.clear();
+
+    return MFX_ERR_NONE;
+}
+
+CTSMuxWriter::CTSMuxWriter() : CMuxWriter(), m_ccPAT(0), m_ccPMT(0), m_ccVideo(0), m_pes() {}
+
+CTSMuxWriter::~CTSMuxWriter() {
+    Close();
+}
+
+void CTSMuxWriter::ResetState() {
+    CMuxWriter::ResetState();
+    m_ccPAT   = 0;
+    m_ccPMT   = 0;
+    m_ccVideo = 0;
+}
+
+mfxU8 CTSMuxWriter::NextCounter(mfxU16 pid) {
+    mfxU8& cc   = pid == TS_PID_PAT ? m_ccPAT : (pid == TS_PID_PMT ? m_ccPMT : m_ccVideo);
+    mfxU8 value = cc;
+    cc          = (cc + 1) & 0x0F;
+    return value;
+}
+
+mfxStatus CTSMuxWriter::WriteAccessUnit(const mfxU8* pData,
+                                        mfxU32 size,
+                                        mfxI64 pts,
+                                        mfxI64 dts,
+                                        bool bKey) {
+    // every random access point begins a segment with the program tables
+    if (bKey || !m_nAccessUnits) {
+        mfxStatus sts = Flush();
+        MSDK_CHECK_STATUS(sts, "Flush failed");
+
+        mfxU8 pat[] = { 0x00, 0xB0, 13, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01,
+                        (mfxU8)(0xE0 | (TS_PID_PMT >> 8)), (mfxU8)TS_PID_PMT,
+                        0, 0, 0, 0 };
+        mfxU8 pmt[] = { 0x02, 0xB0, 18, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                        (mfxU8)(0xE0 | (TS_PID_VIDEO >> 8)), (mfxU8)TS_PID_VIDEO,
+                        0xF0, 0x00,
+                        (mfxU8)(m_codecId == MFX_CODEC_AVC ? 0x1B : 0x24),
+                        (mfxU8)(0xE0 | (TS_PID_VIDEO >> 8)), (mfxU8)TS_PID_VIDEO,
+                        0xF0, 0x00,
+                        0, 0, 0, 0 };
+        WriteSection(TS_PID_PAT, pat, sizeof(pat));
+        WriteSection(TS_PID_PMT, pmt, sizeof(pmt));
+    }
+
+    mfxU8 header[9 + 10 + 7];
+    mfxU8* p = header;
+    *p++     = 0x00;
+    *p++     = 0x00;
+    *p++     = 0x01;
+    *p++     = 0xE0; // video stream
+    *p++     = 0x00; // unbounded packet length
+    *p++     = 0x00;
+    *p++     = 0x80;
+    *p++     = (pts != dts) ? 0xC0 : 0x80;
+    *p++     = (pts != dts) ? 10 : 5;
+    if (pts != dts) {
+        p = PutPESTime(p, 0x3, (mfxU64)(pts + TS_DELAY) & TS_TIME_MASK);
+        p = PutPESTime(p, 0x1, (mfxU64)(dts + TS_DELAY) & TS_TIME_MASK);
+    }
+    else {
+        p = PutPESTime(p, 0x2, (mfxU64)(pts + TS_DELAY) & TS_TIME_MASK);
+    }
+
+    // access unit in the transport stream begins with the delimiter
+    const mfxU8 audType = m_codecId == MFX_CODEC_AVC ? 9 : 35;
+    if (m_nals.empty() || m_nals[0].type != audType) {
+        const mfxU8 avcAUD[]  = { 0x00, 0x00, 0x00, 0x01, 0x09, 0xF0 };
+        const mfxU8 hevcAUD[] = { 0x00, 0x00, 0x00, 0x01, 0x46, 0x01, 0x50 };
+        if (m_codecId == MFX_CODEC_AVC) {
+            memcpy(p, avcAUD, sizeof(avcAUD));
+            p += sizeof(avcAUD);
+        }
+        else {
+            memcpy(p, hevcAUD, sizeof(hevcAUD));
+            p += sizeof(hevcAUD);
+        }
+    }
+
+    WritePES(header, (mfxU32)(p - header), pData, size, dts, bKey);
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CTSMuxWriter::FinishSegment() {
+    return MFX_ERR_NONE;
+}
+
+void CTSMuxWriter::WriteSection(mfxU16 pid, const mfxU8* pSection, mfxU32 size) {
+    size_t pos = m_out.size();
+    m_out.resize(pos + TS_PACKET_SIZE, 0xFF);
+    mfxU8* p = m_out.data() + pos;
+
+    p[0] = 0x47;
+    p[1] = (mfxU8)(0x40 | (pid >> 8));
+    p[2] = (mfxU8)pid;
+    p[3] = 0x10 | NextCounter(pid);
+    p[4] = 0x00; // pointer field
+    memcpy(p + 5, pSection, size);
+
+    // CRC takes the last 4 bytes of the section
+    mfxU32 crc      = CRC32MPEG2(p + 5, size - 4);
+    p[5 + size - 4] = (mfxU8)(crc >> 24);
+    p[5 + size - 3] = (mfxU8)(crc >> 16);
+    p[5 + size - 2] = (mfxU8)(crc >> 8);
+    p[5 + size - 1] = (mfxU8)crc;
+}
+
+void CTSMuxWriter::WritePES(const mfxU8* pPesHeader,
+                            mfxU32 headerSize,
+                            const mfxU8* pData,
+                            mfxU32 size,
+                            mfxI64 pcr,
+                            bool bKey) {
+    const mfxU32 total = headerSize + size;
+    mfxU32 written     = 0;
+
+    // packets are formatted in place in the output buffer
+    size_t pos = m_out.size();
+    m_out.resize(pos + (total / 184 + 2) * TS_PACKET_SIZE);
+
+    while (written < total) {
+        mfxU8* p        = m_out.data() + pos;
+        bool bFirst     = !written;
+        mfxU32 remained = total - written;
+
+        // adaptation field size with its length byte, PCR is sent in the first packet
+        mfxU32 afSize = bFirst ? 8 : 0;
+        if (remained < 184 - afSize)
+            afSize = 184 - remained;
+        mfxU32 payload = 184 - afSize;
+
+        p[0] = 0x47;
+        p[1] = (mfxU8)((bFirst ? 0x40 : 0x00) | (TS_PID_VIDEO >> 8));
+        p[2] = (mfxU8)TS_PID_VIDEO;
+        p[3] = (mfxU8)((afSize ? 0x30 : 0x10) | NextCounter(TS_PID_VIDEO));
+
+        mfxU8* q = p + 4;
+        if (afSize) {
+            *q++ = (mfxU8)(afSize - 1);
+            if (afSize > 1) {
+                *q++ = (mfxU8)((bFirst ? 0x10 : 0x00) | (bFirst && bKey ? 0x40 : 0x00));
+                if (bFirst) {
+                    mfxU64 base = (mfxU64)pcr & TS_TIME_MASK;
+                    *q++        = (mfxU8)(base >> 25);
+                    *q++        = (mfxU8)(base >> 17);
+                    *q++        = (mfxU8)(base >> 9);
+                    *q++        = (mfxU8)(base >> 1);
+                    *q++        = (mfxU8)(((base & 1) << 7) | 0x7E);
+                    *q++        = 0x00;
+                }
+                memset(q, 0xFF, p + 4 + afSize - q);
+                q = p + 4 + afSize;
+            }
+        }
+
+        // payload continues from the PES header into the access unit
+        mfxU32 n = 0;
+        if (written < headerSize) {
+            n = std::min(payload, headerSize - written);
+            memcpy(q, pPesHeader + written, n);
+        }
+        if (n < payload)
+            memcpy(q + n, pData + (written + n - headerSize), payload - n);
+
+        written += payload;
+        pos += TS_PACKET_SIZE;
+    }
+    m_out.resize(pos);
+}
+
+CMP4FragmentWriter::CMP4FragmentWriter()
+        : CMuxWriter(),
+          m_bInitSegment(false),
+          m_seq(),
+          m_nFragments(0),
+          m_baseDts(0),
+          m_samples(),
+          m_mdat() {}
+
+CMP4FragmentWriter::~CMP4FragmentWriter() {
+    Close();
+}
+
+void CMP4FragmentWriter::ResetState() {
+    CMuxWriter::ResetState();
+    m_bInitSegment = false;
+    m_seq          = SequenceInfo();
+    m_nFragments   = 0;
+    m_baseDts      = 0;
+    m_samples.clear();
+    m_mdat.clear();
+}
+
+size_t CMP4FragmentWriter::BeginBox(const char* type) {
+    size_t start = m_out.size();
+    Put32(0);
+    PutBytes((const mfxU8*)type, 4);
+    return start;
+}
+
+size_t CMP4FragmentWriter::BeginFullBox(const char* type, mfxU8 version, mfxU32 flags) {
+    size_t start = BeginBox(type);
+    Put32(((mfxU32)version << 24) | flags);
+    return start;
+}
+
+void CMP4FragmentWriter::EndBox(size_t start) {
+    mfxU32 size      = (mfxU32)(m_out.size() - start);
+    m_out[start]     = (mfxU8)(size >> 24);
+    m_out[start + 1] = (mfxU8)(size >> 16);
+    m_out[start + 2] = (mfxU8)(size >> 8);
+    m_out[start + 3] = (mfxU8)size;
+}
+
+mfxStatus CMP4FragmentWriter::WriteAccessUnit(const mfxU8* pData,
+                                              mfxU32 size,
+                                              mfxI64 pts,
+                                              mfxI64 dts,
+                                              bool bKey) {
+    (void)size;
+
+    if (!m_bInitSegment) {
+        mfxStatus sts = WriteInitSegment(pData);
+        MSDK_CHECK_STATUS(sts, "WriteInitSegment failed");
+        m_bInitSegment = true;
+        m_baseDts      = dts;
+    }
+
+    // fragment is completed by the next random access point or once it gets too large
+    if (!m_samples.empty() && (bKey || m_mdat.size() >= MUX_FLUSH_SIZE)) {
+        mfxStatus sts = WriteFragment(dts);
+        MSDK_CHECK_STATUS(sts, "WriteFragment failed");
+    }
+
+    // parameter sets are kept in the sample entry, delimiters aren't used in MP4
+    const mfxU8 audType = m_codecId == MFX_CODEC_AVC ? 9 : 35;
+    size_t start        = m_mdat.size();
+    for (const NalUnit& nal : m_nals) {
+        if (!nal.size || nal.type == audType || IsParameterSet(nal.type))
+            continue;
+        mfxU8 length[4] = { (mfxU8)(nal.size >> 24),
+                            (mfxU8)(nal.size >> 16),
+                            (mfxU8)(nal.size >> 8),
+                            (mfxU8)nal.size };
+        m_mdat.insert(m_mdat.end(), length, length + 4);
+        m_mdat.insert(m_mdat.end(), pData + nal.offset, pData + nal.offset + nal.size);
+    }
+    m_samples.push_back({ (mfxU32)(m_mdat.size() - start), pts, dts, bKey });
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CMP4FragmentWriter::FinishSegment() {
+    if (m_samples.empty())
+        return MFX_ERR_NONE;
+
+    // last sample lasts as long as the one before it
+    size_t n        = m_samples.size();
+    mfxI64 duration = n > 1 ? m_samples[n - 1].dts - m_samples[n - 2].dts : m_frameDuration;
+    return WriteFragment(m_samples[n - 1].dts + duration);
+}
+
+mfxStatus CMP4FragmentWriter::WriteInitSegment(const mfxU8* pData) {
+    bool bSPS = false, bPPS = false, bVPS = m_codecId == MFX_CODEC_AVC;
+    for (const NalUnit& nal : m_nals) {
+        if (m_codecId == MFX_CODEC_AVC) {
+            bSPS |= nal.type == 7 && nal.size >= 4;
+            bPPS |= nal.type == 8;
+        }
+        else {
+            bVPS |= nal.type == 32;
+            bSPS |= nal.type == 33 && nal.size >= 15;
+            bPPS |= nal.type == 34;
+        }
+    }
+    if (!bSPS || !bPPS || !bVPS) {
+        msdk_printf(MSDK_STRING("ERROR: first access unit has no parameter sets for MP4\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    for (const NalUnit& nal : m_nals) {
+        if (m_codecId == MFX_CODEC_AVC && nal.type == 7) {
+            ParseAVCSequence(pData + nal.offset, nal.size);
+            break;
+        }
+        if (m_codecId == MFX_CODEC_HEVC && nal.type == 33) {
+            ParseHEVCSequence(pData + nal.offset, nal.size);
+            break;
+        }
+    }
+
+    size_t ftyp = BeginBox("ftyp");
+    PutBytes((const mfxU8*)"isom", 4);
+    Put32(0x200);
+    PutBytes((const mfxU8*)"isomiso6mp41", 12);
+    EndBox(ftyp);
+
+    const mfxU32 matrix[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+
+    size_t moov = BeginBox("moov");
+    {
+        size_t mvhd = BeginFullBox("mvhd", 0, 0);
+        Put32(0); // creation time
+        Put32(0); // modification time
+        Put32(MP4_TIMESCALE);
+        Put32(0); // duration is in fragments
+        Put32(0x00010000); // rate
+        Put16(0x0100); // volume
+        Put16(0);
+        Put64(0);
+        for (mfxU32 value : matrix)
+            Put32(value);
+        for (int i = 0; i < 6; i++)
+            Put32(0);
+        Put32(2); // next track ID
+        EndBox(mvhd);
+
+        size_t trak = BeginBox("trak");
+        {
+            size_t tkhd = BeginFullBox("tkhd", 0, 3); // enabled, in movie
+            Put32(0);
+            Put32(0);
+            Put32(1); // track ID
+            Put32(0);
+            Put32(0); // duration
+            Put64(0);
+            Put16(0); // layer
+            Put16(0); // alternate group
+            Put16(0); // volume
+            Put16(0);
+            for (mfxU32 value : matrix)
+                Put32(value);
+            Put32((mfxU32)m_seq.width << 16);
+            Put32((mfxU32)m_seq.height << 16);
+            EndBox(tkhd);
+
+            size_t mdia = BeginBox("mdia");
+            {
+                size_t mdhd = BeginFullBox("mdhd", 0, 0);
+                Put32(0);
+                Put32(0);
+                Put32(MP4_TIMESCALE);
+                Put32(0);
+                Put16(0x55C4); // und
+                Put16(0);
+                EndBox(mdhd);
+
+                size_t hdlr = BeginFullBox("hdlr", 0, 0);
+                Put32(0);
+                PutBytes((const mfxU8*)"vide", 4);
+                Put32(0);
+                Put32(0);
+                Put32(0);
+                PutBytes((const mfxU8*)"VideoHandler", 13);
+                EndBox(hdlr);
+
+                size_t minf = BeginBox("minf");
+                {
+                    size_t vmhd = BeginFullBox("vmhd", 0, 1);
+                    Put64(0); // graphics mode and opcolor
+                    EndBox(vmhd);
+
+                    size_t dinf = BeginBox("dinf");
+                    size_t dref = BeginFullBox("dref", 0, 0);
+                    Put32(1);
+                    size_t url = BeginFullBox("url ", 0, 1); // media is in the same file
+                    EndBox(url);
+                    EndBox(dref);
+                    EndBox(dinf);
+
+                    size_t stbl = BeginBox("stbl");
+                    {
+                        size_t stsd = BeginFullBox("stsd", 0, 0);
+                        Put32(1);
+                        WriteSampleEntry(pData);
+                        EndBox(stsd);
+
+                        // samples are described in fragments
+                        const char* tables[] = { "stts", "stsc", "stco" };
+                        for (const char* type : tables) {
+                            size_t table = BeginFullBox(type, 0, 0);
+                            Put32(0);
+                            EndBox(table);
+                        }
+                        size_t stsz = BeginFullBox("stsz", 0, 0);
+                        Put32(0);
+                        Put32(0);
+                        EndBox(stsz);
+                    }
+                    EndBox(stbl);
+                }
+                EndBox(minf);
+            }
+            EndBox(mdia);
+        }
+        EndBox(trak);
+
+        size_t mvex = BeginBox("mvex");
+        size_t trex = BeginFullBox("trex", 0, 0);
+        Put32(1); // track ID
+        Put32(1); // sample description index
+        Put32(0);
+        Put32(0);
+        Put32(0);
+        EndBox(trex);
+        EndBox(mvex);
+    }
+    EndBox(moov);
+
+    return Flush();
+}
+
+void CMP4FragmentWriter::ParseAVCSequence(const mfxU8* pSps, mfxU32 size) {
+    RbspReader r(pSps + 1, size - 1);
+    mfxU32 profile = r.GetBits(8);
+    r.GetBits(16); // constraint flags and level
+    r.GetUE(); // seq_parameter_set_id
+
+    m_seq.chromaFormat   = 1;
+    bool bSeparatePlanes = false;
+    const mfxU32 high[]  = { 100, 110, 122, 244, 44, 83, 86, 118, 128, 138, 139, 134, 135 };
+    if (std::find(std::begin(high), std::end(high), profile) != std::end(high)) {
+        m_seq.chromaFormat = r.GetUE();
+        if (m_seq.chromaFormat == 3)
+            bSeparatePlanes = r.GetBits(1) != 0;
+        m_seq.bitDepthLuma   = r.GetUE();
+        m_seq.bitDepthChroma = r.GetUE();
+        r.GetBits(1); // qpprime_y_zero_transform_bypass_flag
+        if (r.GetBits(1)) { // seq_scaling_matrix_present_flag
+            for (mfxU32 i = 0; i < (m_seq.chromaFormat != 3 ? 8u : 12u); i++) {
+                if (!r.GetBits(1))
+                    continue;
+                mfxI32 lastScale = 8, nextScale = 8;
+                for (mfxU32 j = 0; j < (i < 6 ? 16u : 64u) && nextScale; j++) {
+                    nextScale = (lastScale + r.GetSE() + 256) % 256;
+                    lastScale = nextScale ? nextScale : lastScale;
+                }
+            }
+        }
+    }
+
+    r.GetUE(); // log2_max_frame_num_minus4
+    mfxU32 pocType = r.GetUE();
+    if (pocType == 0) {
+        r.GetUE();
+    }
+    else if (pocType == 1) {
+        r.GetBits(1);
+        r.GetSE();
+        r.GetSE();
+        mfxU32 numRefFrames = r.GetUE();
+        for (mfxU32 i = 0; i < numRefFrames; i++)
+            r.GetSE();
+    }
+    r.GetUE(); // max_num_ref_frames
+    r.GetBits(1);
+    mfxU32 widthInMbs   = r.GetUE() + 1;
+    mfxU32 heightInMaps = r.GetUE() + 1;
+    mfxU32 frameMbsOnly = r.GetBits(1);
+    if (!frameMbsOnly)
+        r.GetBits(1);
+    r.GetBits(1); // direct_8x8_inference_flag
+
+    mfxU32 width  = widthInMbs * 16;
+    mfxU32 height = (2 - frameMbsOnly) * heightInMaps * 16;
+    if (r.GetBits(1)) { // frame_cropping_flag
+        mfxU32 cropX = 1, cropY = 2 - frameMbsOnly;
+        if (!bSeparatePlanes && m_seq.chromaFormat) {
+            cropX = m_seq.chromaFormat == 3 ? 1 : 2;
+            cropY *= m_seq.chromaFormat == 1 ? 2 : 1;
+        }
+        mfxU32 left = r.GetUE(), right = r.GetUE(), top = r.GetUE(), bottom = r.GetUE();
+        width -= cropX * (left + right);
+        height -= cropY * (top + bottom);
+    }
+    m_seq.width  = (mfxU16)width;
+    m_seq.height = (mfxU16)height;
+}
+
+void CMP4FragmentWriter::ParseHEVCSequence(const mfxU8* pSps, mfxU32 size) {
+    RbspReader r(pSps + 2, size - 2);
+    r.GetBits(4); // sps_video_parameter_set_id
+    m_seq.maxSubLayersMinus1 = r.GetBits(3);
+    m_seq.temporalIdNesting  = r.GetBits(1);
+    m_seq.profile            = (mfxU8)r.GetBits(8);
+    m_seq.compatibility      = r.GetBits(32);
+    for (mfxU8& value : m_seq.constraints)
+        value = (mfxU8)r.GetBits(8);
+    m_seq.level = (mfxU8)r.GetBits(8);
+
+    mfxU32 subLayers     = m_seq.maxSubLayersMinus1;
+    mfxU32 subLayerFlags = r.GetBits(2 * subLayers);
+    if (subLayers)
+        r.GetBits(2 * (8 - subLayers));
+    for (mfxU32 i = 0; i < subLayers; i++) {
+        mfxU32 flags = subLayerFlags >> (2 * (subLayers - 1 - i));
+        if (flags & 2)
+            r.GetBits(88);
+        if (flags & 1)
+            r.GetBits(8);
+    }
+
+    r.GetUE(); // sps_seq_parameter_set_id
+    m_seq.chromaFormat   = r.GetUE();
+    bool bSeparatePlanes = m_seq.chromaFormat == 3 && r.GetBits(1);
+    mfxU32 width         = r.GetUE();
+    mfxU32 height        = r.GetUE();
+    if (r.GetBits(1)) { // conformance_window_flag
+        mfxU32 subWidth = 1, subHeight = 1;
+        if (!bSeparatePlanes && (m_seq.chromaFormat == 1 || m_seq.chromaFormat == 2))
+            subWidth = 2;
+        if (!bSeparatePlanes && m_seq.chromaFormat == 1)
+            subHeight = 2;
+        mfxU32 left = r.GetUE(), right = r.GetUE(), top = r.GetUE(), bottom = r.GetUE();
+        width -= subWidth * (left + right);
+        height -= subHeight * (top + bottom);
+    }
+    m_seq.bitDepthLuma   = r.GetUE();
+    m_seq.bitDepthChroma = r.GetUE();
+    m_seq.width          = (mfxU16)width;
+    m_seq.height         = (mfxU16)height;
+}
+
+void CMP4FragmentWriter::WriteSampleEntry(const mfxU8* pData) {
+    const bool bAVC = m_codecId == MFX_CODEC_AVC;
+
+    size_t entry = BeginBox(bAVC ? "avc1" : "hvc1");
+    for (int i = 0; i < 6; i++)
+        Put8(0);
+    Put16(1); // data reference index
+    Put16(0);
+    Put16(0);
+    Put32(0);
+    Put32(0);
+    Put32(0);
+    Put16(m_seq.width);
+    Put16(m_seq.height);
+    Put32(0x00480000); // 72 dpi
+    Put32(0x00480000);
+    Put32(0);
+    Put16(1); // frame count
+    for (int i = 0; i < 32; i++) // compressor name
+        Put8(0);
+    Put16(0x0018); // depth
+    Put16(0xFFFF);
+
+    if (bAVC) {
+        const NalUnit* sps = NULL;
+        mfxU8 numPPS       = 0;
+        for (const NalUnit& nal : m_nals) {
+            if (nal.type == 7 && !sps)
+                sps = &nal;
+            numPPS += nal.type == 8;
+        }
+        const mfxU8* p = pData + sps->offset;
+
+        size_t avcC = BeginBox("avcC");
+        Put8(1);
+        Put8(p[1]); // profile
+        Put8(p[2]); // constraint flags
+        Put8(p[3]); // level
+        Put8(0xFF); // 4 bytes NAL unit length
+        Put8(0xE1);
+        Put16((mfxU16)sps->size);
+        PutBytes(p, sps->size);
+        Put8(numPPS);
+        for (const NalUnit& nal : m_nals) {
+            if (nal.type != 8)
+                continue;
+            Put16((mfxU16)nal.size);
+            PutBytes(pData + nal.offset, nal.size);
+        }
+        if (p[1] == 100 || p[1] == 110 || p[1] == 122 || p[1] == 144) {
+            Put8((mfxU8)(0xFC | m_seq.chromaFormat));
+            Put8((mfxU8)(0xF8 | m_seq.bitDepthLuma));
+            Put8((mfxU8)(0xF8 | m_seq.bitDepthChroma));
+            Put8(0);
+        }
+        EndBox(avcC);
+    }
+    else {
+        size_t hvcC = BeginBox("hvcC");
+        Put8(1);
+        Put8(m_seq.profile);
+        Put32(m_seq.compatibility);
+        PutBytes(m_seq.constraints, sizeof(m_seq.constraints));
+        Put8(m_seq.level);
+        Put16(0xF000); // min spatial segmentation
+        Put8(0xFC); // parallelism type
+        Put8((mfxU8)(0xFC | m_seq.chromaFormat));
+        Put8((mfxU8)(0xF8 | m_seq.bitDepthLuma));
+        Put8((mfxU8)(0xF8 | m_seq.bitDepthChroma));
+        Put16(0); // average frame rate
+        Put8((mfxU8)(((m_seq.maxSubLayersMinus1 + 1) << 3) | (m_seq.temporalIdNesting << 2) | 3));
+        Put8(3);
+        for (mfxU8 type = 32; type <= 34; type++) {
+            mfxU16 count = 0;
+            for (const NalUnit& nal : m_nals)
+                count += nal.type == type;
+            Put8(0x80 | type); // all parameter sets of the type are here
+            Put16(count);
+            for (const NalUnit& nal : m_nals) {
+                if (nal.type != type)
+                    continue;
+                Put16((mfxU16)nal.size);
+                PutBytes(pData + nal.offset, nal.size);
+            }
+        }
+        EndBox(hvcC);
+    }
+
+    EndBox(entry);
+}
+
+mfxStatus CMP4FragmentWriter::WriteFragment(mfxI64 nextDts) {
+    size_t moof = BeginBox("moof");
+    size_t mfhd = BeginFullBox("mfhd", 0, 0);
+    Put32(++m_nFragments);
+    EndBox(mfhd);
+
+    size_t traf = BeginBox("traf");
+    size_t tfhd = BeginFullBox("tfhd", 0, 0x020000); // data offsets are from moof
+    Put32(1);
+    EndBox(tfhd);
+
+    size_t tfdt = BeginFullBox("tfdt", 1, 0);
+    Put64((mfxU64)(m_samples[0].dts - m_baseDts));
+    EndBox(tfdt);
+
+    // data offset, duration, size, flags and composition time offset of every sample
+    size_t trun = BeginFullBox("trun", 1, 0x000F01);
+    Put32((mfxU32)m_samples.size());
+    size_t dataOffset = m_out.size();
+    Put32(0);
+    for (size_t i = 0; i < m_samples.size(); i++) {
+        const Sample& sample = m_samples[i];
+        mfxI64 next          = i + 1 < m_samples.size() ? m_samples[i + 1].dts : nextDts;
+        Put32((mfxU32)(next - sample.dts));
+        Put32(sample.size);
+        // key samples don't depend on others, the rest are not sync samples
+        Put32(sample.bKey ? 0x02000000 : 0x01010000);
+        Put32((mfxU32)(mfxI32)(sample.pts - sample.dts));
+    }
+    EndBox(trun);
+    EndBox(traf);
+    EndBox(moof);
+
+    mfxU32 offset         = (mfxU32)(m_out.size() - moof) + 8;
+    m_out[dataOffset]     = (mfxU8)(offset >> 24);
+    m_out[dataOffset + 1] = (mfxU8)(offset >> 16);
+    m_out[dataOffset + 2] = (mfxU8)(offset >> 8);
+    m_out[dataOffset + 3] = (mfxU8)offset;
+
+    Put32((mfxU32)(8 + m_mdat.size()));
+    PutBytes((const mfxU8*)"mdat", 4);
+
+    // samples are written from their own buffer right after the boxes
+    mfxStatus sts = Flush();
+    MSDK_CHECK_STATUS(sts, "Flush failed");
+    size_t nBytesWritten = fwrite(m_mdat.data(), 1, m_mdat.size(), m_fSource);
+    MSDK_CHECK_NOT_EQUAL(nBytesWritten, m_mdat.size(), MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    m_samples.clear();
+    m_mdat.clear();
+
+    return MFX_ERR_NONE;
+}
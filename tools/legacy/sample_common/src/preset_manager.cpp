@@ -15,10 +15,12 @@ msdk_string CPresetManager::modesName[PRESET_MAX_MODES] = {
     MSDK_STRING("DSS"),
     MSDK_STRING("Conference"),
     MSDK_STRING("Gaming"),
+    MSDK_STRING("FastStart"),
 };
 
 //GopRefDist, TargetUsage, RateControlMethod, ExtBRCType, AsyncDepth, BRefType, EncTools
 // AdaptiveMaxFrameSize, LowDelayBRC, IntRefType, IntRefCycleSize, IntRefQPDelta, IntRefCycleDist, WeightedPred, WeightedBiPred, EnableBPyramid, EnablePPyramid
+// LowPower
 
 CPresetParameters CPresetManager::presets[PRESET_MAX_MODES][PRESET_MAX_CODECS] = {
     // Default
@@ -166,6 +168,45 @@ CPresetParameters CPresetManager::presets[PRESET_MAX_MODES][PRESET_MAX_CODECS] =
           MFX_WEIGHTED_PRED_UNKNOWN,
           0,
           0 },
+    },
+    // FastStart: time to the first packet is short, one frame in flight and no lookahead
+    {
+        { 1,
+          MFX_TARGETUSAGE_BEST_SPEED,
+          MFX_RATECONTROL_VBR,
+          EXTBRC_DEFAULT,
+          1,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          MFX_WEIGHTED_PRED_UNKNOWN,
+          MFX_WEIGHTED_PRED_UNKNOWN,
+          0,
+          0,
+          MFX_CODINGOPTION_ON },
+        { 1,
+          MFX_TARGETUSAGE_BEST_SPEED,
+          MFX_RATECONTROL_VBR,
+          EXTBRC_DEFAULT,
+          1,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          0,
+          MFX_WEIGHTED_PRED_UNKNOWN,
+          MFX_WEIGHTED_PRED_UNKNOWN,
+          0,
+          0,
+          MFX_CODINGOPTION_ON },
     }
 };
 
@@ -239,8 +280,11 @@ CDependentPresetParameters CPresetManager::GetDependentPresetParameters(EPresetM
     if (codecFourCC == MFX_CODEC_AVC || codecFourCC == MFX_CODEC_HEVC) {
         // Calculating dependent preset values
         retVal.MaxKbps = (mode == PRESET_GAMING ? (mfxU16)(1.2 * retVal.TargetKbps) : 0);
-        retVal.GopPicSize =
-            (mode == PRESET_GAMING || mode == PRESET_DEFAULT ? 0 : (mfxU16)(2 * fps));
+        if (mode == PRESET_FAST_START)
+            retVal.GopPicSize = (mfxU16)(fps / 2); // a joining client waits for an IDR
+        else
+            retVal.GopPicSize =
+                (mode == PRESET_GAMING || mode == PRESET_DEFAULT ? 0 : (mfxU16)(2 * fps));
         retVal.BufferSizeInKB =
             (mode == PRESET_DEFAULT ? 0 : retVal.TargetKbps); // 1 second buffers
         retVal.LookAheadDepth = 0; // Enable this setting if LA BRC will be enabled
@@ -257,3 +301,122 @@ EPresetModes CPresetManager::PresetNameToMode(const msdk_char* name) {
     }
     return PRESET_MAX_MODES;
 }
+
+msdk_string CPresetManager::PresetModeToName(EPresetModes mode) {
+    return mode >= 0 && mode < PRESET_MAX_MODES ? modesName[mode] : msdk_string();
+}
+
+static const msdk_char* ProfileCodecName(mfxU32 codecId) {
+    return codecId == MFX_CODEC_HEVC ? MSDK_STRING("h265") : MSDK_STRING("h264");
+}
+
+mfxStatus CPresetProfile::Load(const msdk_char* fileName) {
+    MSDK_CHECK_POINTER(fileName, MFX_ERR_NULL_PTR);
+
+    FILE* file = NULL;
+    MSDK_FOPEN(file, fileName, MSDK_STRING("r"));
+    if (!file)
+        return MFX_ERR_NOT_FOUND;
+
+    mfxStatus sts = MFX_ERR_NONE;
+    m_Measurements.clear();
+    msdk_char line[1024];
+    for (int nLine = 1; MFX_ERR_NONE == sts && msdk_fgets(line, MSDK_ARRAY_LEN(line), file);
+         nLine++) {
+        msdk_stringstream lineStream(line);
+        msdk_string codec, preset;
+        CPresetMeasurement measurement = {};
+        if (!(lineStream >> measurement.Device) || MSDK_CHAR('#') == measurement.Device[0])
+            continue;
+
+        lineStream >> codec >> preset >> measurement.TargetUsage >> measurement.Width >>
+            measurement.Height >> measurement.Fps >> measurement.LatencyP99;
+        bool bHEVC          = codec == ProfileCodecName(MFX_CODEC_HEVC);
+        measurement.CodecId = bHEVC ? MFX_CODEC_HEVC : MFX_CODEC_AVC;
+        measurement.Mode    = CPresetManager::PresetNameToMode(preset.c_str());
+
+        if (lineStream.fail() || PRESET_MAX_MODES == measurement.Mode ||
+            (!bHEVC && codec != ProfileCodecName(MFX_CODEC_AVC))) {
+            msdk_printf(MSDK_STRING("error: invalid line %d of preset profile \"%s\"\n"),
+                        nLine,
+                        fileName);
+            sts = MFX_ERR_UNSUPPORTED;
+            break;
+        }
+        m_Measurements.push_back(measurement);
+    }
+    fclose(file);
+
+    return sts;
+}
+
+mfxStatus CPresetProfile::Save(const msdk_char* fileName) const {
+    MSDK_CHECK_POINTER(fileName, MFX_ERR_NULL_PTR);
+
+    FILE* file = NULL;
+    MSDK_FOPEN(file, fileName, MSDK_STRING("w"));
+    if (!file) {
+        msdk_printf(MSDK_STRING("error: can't open preset profile \"%s\"\n"), fileName);
+        return MFX_ERR_ABORTED;
+    }
+
+    msdk_fprintf(file,
+                 MSDK_STRING("# device codec preset target_usage width height fps latency_p99\n"));
+    for (const CPresetMeasurement& m : m_Measurements) {
+        msdk_fprintf(file,
+                     MSDK_STRING("%s %s %s %u %u %u %.2f %.3f\n"),
+                     m.Device.c_str(),
+                     ProfileCodecName(m.CodecId),
+                     CPresetManager::PresetModeToName(m.Mode).c_str(),
+                     m.TargetUsage,
+                     m.Width,
+                     m.Height,
+                     m.Fps,
+                     m.LatencyP99);
+    }
+    fclose(file);
+
+    return MFX_ERR_NONE;
+}
+
+void CPresetProfile::Add(const CPresetMeasurement& measurement) {
+    for (CPresetMeasurement& m : m_Measurements) {
+        if (m.Device == measurement.Device && m.CodecId == measurement.CodecId &&
+            m.Mode == measurement.Mode && m.TargetUsage == measurement.TargetUsage &&
+            m.Width == measurement.Width && m.Height == measurement.Height) {
+            m = measurement;
+            return;
+        }
+    }
+    m_Measurements.push_back(measurement);
+}
+
+bool CPresetProfile::Select(const msdk_string& device,
+                            mfxU32 codecId,
+                            mfxU32 width,
+                            mfxU32 height,
+                            mfxF64 fps,
+                            CPresetMeasurement& result) const {
+    if (!width || !height)
+        return false;
+
+    bool bFound    = false;
+    mfxF64 bestFps = 0;
+    for (const CPresetMeasurement& m : m_Measurements) {
+        if (m.Device != device || m.CodecId != codecId)
+            continue;
+
+        mfxF64 scaledFps = m.Fps * m.Width * m.Height / ((mfxF64)width * height);
+        if (scaledFps < fps)
+            continue;
+
+        // of presets with the same target usage the fastest one is taken
+        if (!bFound || m.TargetUsage < result.TargetUsage ||
+            (m.TargetUsage == result.TargetUsage && scaledFps > bestFps)) {
+            result  = m;
+            bestFps = scaledFps;
+            bFound  = true;
+        }
+    }
+    return bFound;
+}
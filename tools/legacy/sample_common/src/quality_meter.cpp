@@ -0,0 +1,411 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "quality_meter.h"
+
+#include <math.h>
+#include <string.h>
+
+// PSNR of identical planes
+#define QUALITY_MAX_PSNR 100.0
+
+CQualityMeter::CQualityMeter()
+        : m_file(NULL),
+          m_nCodecId(0),
+          m_pSession(NULL),
+          m_pDEC(),
+          m_bDecoderInit(false),
+          m_Bitstream(),
+          m_thread(),
+          m_mutex(),
+          m_cvQueued(),
+          m_cvFlushed(),
+          m_Queue(),
+          m_Sources(),
+          m_nFlushRequests(0),
+          m_nFlushes(0),
+          m_bStop(false),
+          m_Executor(),
+          m_Bands(),
+          m_Totals(),
+          m_nMissing(0),
+          m_nErrors(0) {}
+
+CQualityMeter::~CQualityMeter() {
+    Close();
+}
+
+mfxStatus CQualityMeter::Open(const msdk_char* fileName,
+                              MFXVideoSession* pSession,
+                              mfxU32 codecId) {
+    MSDK_CHECK_POINTER(fileName, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pSession, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(IsOpen(), true, MFX_ERR_UNDEFINED_BEHAVIOR);
+
+    MSDK_FOPEN(m_file, fileName, MSDK_STRING("w"));
+    if (!m_file) {
+        msdk_printf(MSDK_STRING("error: can't open quality file \"%s\"\n"), fileName);
+        return MFX_ERR_ABORTED;
+    }
+    msdk_fprintf(m_file, MSDK_STRING("frame,psnr_y,psnr_u,psnr_v,ssim_y\n"));
+
+    mfxStatus sts = m_Executor.Init();
+    MSDK_CHECK_STATUS(sts, "m_Executor.Init failed");
+
+    m_nCodecId = codecId;
+    m_pSession = pSession;
+    m_pDEC.reset(new MFXVideoDECODE(*pSession));
+    m_bDecoderInit         = false;
+    m_Bitstream.DataOffset = 0;
+    m_Bitstream.DataLength = 0;
+    m_nFlushRequests       = 0;
+    m_nFlushes             = 0;
+    m_bStop                = false;
+    m_Totals               = Summary();
+    m_nMissing             = 0;
+    m_nErrors              = 0;
+
+    m_thread = std::thread(&CQualityMeter::WorkerRoutine, this);
+
+    return MFX_ERR_NONE;
+}
+
+void CQualityMeter::Close() {
+    if (!IsOpen())
+        return;
+
+    Flush();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvQueued.notify_one();
+    m_thread.join();
+
+    m_pDEC.reset();
+    m_pSession = NULL;
+    m_Executor.Close();
+    m_Sources.clear();
+
+    fclose(m_file);
+    m_file = NULL;
+
+    if (m_nMissing)
+        msdk_printf(MSDK_STRING("WARNING: quality isn't measured for %u frames\n"), m_nMissing);
+    if (m_nErrors)
+        msdk_printf(MSDK_STRING("WARNING: decoding for quality measurement failed %u times\n"),
+                    m_nErrors);
+}
+
+mfxStatus CQualityMeter::AddSource(const mfxFrameSurface1& surface) {
+    const mfxFrameInfo& info = surface.Info;
+    if (info.FourCC != MFX_FOURCC_NV12)
+        return MFX_ERR_UNSUPPORTED;
+    MSDK_CHECK_POINTER(surface.Data.Y, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(surface.Data.UV, MFX_ERR_NOT_INITIALIZED);
+
+    std::unique_ptr<Frame> frame(new Frame);
+    frame->Width  = info.CropW ? info.CropW : info.Width;
+    frame->Height = info.CropH ? info.CropH : info.Height;
+
+    size_t pitch    = ((size_t)surface.Data.PitchHigh << 16) + surface.Data.PitchLow;
+    size_t width    = frame->Width;
+    size_t widthUV  = (width + 1) & ~(size_t)1;
+    size_t heightUV = (frame->Height + 1) / 2;
+    frame->Y.resize(width * frame->Height);
+    frame->UV.resize(widthUV * heightUV);
+
+    const mfxU8* pY  = surface.Data.Y + info.CropY * pitch + info.CropX;
+    const mfxU8* pUV = surface.Data.UV + info.CropY / 2 * pitch + (info.CropX & ~1);
+    for (size_t y = 0; y < frame->Height; y++)
+        memcpy(&frame->Y[y * width], pY + y * pitch, width);
+    for (size_t y = 0; y < heightUV; y++)
+        memcpy(&frame->UV[y * widthUV], pUV + y * pitch, widthUV);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_Sources.push_back(std::move(frame));
+    return MFX_ERR_NONE;
+}
+
+void CQualityMeter::AddBitstream(const mfxBitstream& bs) {
+    if (!bs.DataLength)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_Queue.insert(m_Queue.end(),
+                       bs.Data + bs.DataOffset,
+                       bs.Data + bs.DataOffset + bs.DataLength);
+    }
+    m_cvQueued.notify_one();
+}
+
+void CQualityMeter::Flush() {
+    if (!IsOpen())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    mfxU64 request = ++m_nFlushRequests;
+    m_cvQueued.notify_one();
+    m_cvFlushed.wait(lock, [this, request]() {
+        return m_nFlushes >= request;
+    });
+}
+
+CQualityMeter::Summary CQualityMeter::GetSummary() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Summary summary = m_Totals;
+    if (summary.Frames) {
+        summary.PSNRY /= summary.Frames;
+        summary.PSNRU /= summary.Frames;
+        summary.PSNRV /= summary.Frames;
+        summary.SSIMY /= summary.Frames;
+    }
+    return summary;
+}
+
+void CQualityMeter::WorkerRoutine() {
+    std::vector<mfxU8> data;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvQueued.wait(lock, [this]() {
+            return m_bStop || !m_Queue.empty() || m_nFlushes < m_nFlushRequests;
+        });
+        // Close() flushes first, so nothing is left here
+        if (m_bStop)
+            break;
+
+        // data queued before the flush request is decoded before the flush
+        data.swap(m_Queue);
+        mfxU64 flushes = m_nFlushRequests;
+        bool bFlush    = m_nFlushes < flushes;
+        lock.unlock();
+
+        if (!data.empty()) {
+            mfxU32 length = m_Bitstream.DataLength;
+            if (m_Bitstream.DataOffset) {
+                memmove(m_Bitstream.Data, m_Bitstream.Data + m_Bitstream.DataOffset, length);
+                m_Bitstream.DataOffset = 0;
+            }
+            m_Bitstream.Extend(length + (mfxU32)data.size());
+            memcpy(m_Bitstream.Data + length, data.data(), data.size());
+            m_Bitstream.DataLength = length + (mfxU32)data.size();
+            data.clear();
+
+            Decode(false);
+        }
+
+        if (bFlush) {
+            Decode(true);
+            // the next data starts a new stream, e.g. after reset of the encoder
+            if (m_bDecoderInit)
+                m_pDEC->Close();
+            m_bDecoderInit         = false;
+            m_Bitstream.DataOffset = 0;
+            m_Bitstream.DataLength = 0;
+        }
+
+        lock.lock();
+        if (bFlush) {
+            // frames which weren't decoded can't be matched with the next stream
+            m_nMissing += (mfxU32)m_Sources.size();
+            m_Sources.clear();
+            m_nFlushes = flushes;
+            m_cvFlushed.notify_all();
+        }
+    }
+}
+
+void CQualityMeter::Decode(bool bDrain) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    if (!m_bDecoderInit) {
+        if (bDrain)
+            return;
+
+        mfxVideoParam par = {};
+        par.mfx.CodecId   = m_nCodecId;
+        sts               = m_pDEC->DecodeHeader(&m_Bitstream, &par);
+        if (MFX_ERR_MORE_DATA == sts)
+            return;
+
+        if (MFX_ERR_NONE <= sts) {
+            par.IOPattern  = MFX_IOPATTERN_OUT_SYSTEM_MEMORY;
+            par.AsyncDepth = 1;
+            sts            = m_pDEC->Init(&par);
+        }
+        if (MFX_ERR_NONE > sts) {
+            m_nErrors++;
+            m_Bitstream.DataLength = 0;
+            return;
+        }
+        m_bDecoderInit = true;
+    }
+
+    for (;;) {
+        mfxFrameSurface1* pOut = NULL;
+        mfxSyncPoint syncp     = NULL;
+
+        // surfaces are allocated by the library
+        sts = m_pDEC->DecodeFrameAsync(bDrain ? NULL : &m_Bitstream, NULL, &pOut, &syncp);
+        if (MFX_WRN_DEVICE_BUSY == sts) {
+            MSDK_SLEEP(1);
+            continue;
+        }
+        if (MFX_ERR_MORE_DATA == sts)
+            break;
+        if (MFX_ERR_NONE > sts) {
+            m_nErrors++;
+            if (!bDrain)
+                m_Bitstream.DataLength = 0;
+            break;
+        }
+        if (!syncp)
+            continue;
+
+        sts = m_pSession->SyncOperation(syncp, MSDK_WAIT_INTERVAL);
+        if (MFX_ERR_NONE == sts)
+            sts = pOut->FrameInterface->Map(pOut, MFX_MAP_READ);
+        if (MFX_ERR_NONE == sts) {
+            Compare(*pOut);
+            pOut->FrameInterface->Unmap(pOut);
+        }
+        else {
+            m_nErrors++;
+        }
+        pOut->FrameInterface->Release(pOut);
+    }
+}
+
+void CQualityMeter::Compare(const mfxFrameSurface1& decoded) {
+    std::unique_ptr<Frame> src;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_Sources.empty()) {
+            src = std::move(m_Sources.front());
+            m_Sources.pop_front();
+        }
+    }
+
+    const mfxFrameInfo& info = decoded.Info;
+    if (!src || info.FourCC != MFX_FOURCC_NV12 || info.CropW != src->Width ||
+        info.CropH != src->Height) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_nMissing++;
+        return;
+    }
+
+    // a band is a row of 8x8 SSIM blocks
+    mfxU32 bands = (src->Height + 7) / 8;
+    m_Bands.assign(bands, BandSums());
+    m_Executor.Run(bands, [&](mfxU32 first, mfxU32 last) {
+        for (mfxU32 band = first; band < last; band++)
+            CompareBand(*src, decoded, band, m_Bands[band]);
+    });
+
+    BandSums sums = {};
+    for (const BandSums& band : m_Bands) {
+        for (int i = 0; i < 3; i++)
+            sums.SSE[i] += band.SSE[i];
+        sums.SSIM += band.SSIM;
+        sums.Blocks += band.Blocks;
+    }
+
+    mfxF64 samples[3];
+    samples[0] = (mfxF64)src->Width * src->Height;
+    samples[1] = samples[2] = (mfxF64)((src->Width + 1) / 2) * ((src->Height + 1) / 2);
+
+    mfxF64 psnr[3];
+    for (int i = 0; i < 3; i++) {
+        mfxF64 mse = sums.SSE[i] / samples[i];
+        psnr[i]    = mse > 0 ? std::min(10 * log10(255.0 * 255.0 / mse), QUALITY_MAX_PSNR)
+                             : QUALITY_MAX_PSNR;
+    }
+    mfxF64 ssim = sums.Blocks ? sums.SSIM / sums.Blocks : 1.0;
+
+    mfxU32 frame;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        frame = m_Totals.Frames++;
+        m_Totals.PSNRY += psnr[0];
+        m_Totals.PSNRU += psnr[1];
+        m_Totals.PSNRV += psnr[2];
+        m_Totals.SSIMY += ssim;
+    }
+    msdk_fprintf(m_file,
+                 MSDK_STRING("%u,%.3f,%.3f,%.3f,%.5f\n"),
+                 frame,
+                 psnr[0],
+                 psnr[1],
+                 psnr[2],
+                 ssim);
+}
+
+void CQualityMeter::CompareBand(const Frame& src,
+                                const mfxFrameSurface1& decoded,
+                                mfxU32 band,
+                                BandSums& sums) const {
+    // constants of SSIM for 8 bit samples: (0.01 * 255)^2 and (0.03 * 255)^2
+    const mfxF64 C1 = 6.5025, C2 = 58.5225;
+
+    const mfxFrameInfo& info = decoded.Info;
+    size_t pitch             = ((size_t)decoded.Data.PitchHigh << 16) + decoded.Data.PitchLow;
+    size_t width             = src.Width;
+    size_t widthUV           = (width + 1) & ~(size_t)1;
+    const mfxU8* pY          = decoded.Data.Y + info.CropY * pitch + info.CropX;
+    const mfxU8* pUV         = decoded.Data.UV + info.CropY / 2 * pitch + (info.CropX & ~1);
+
+    mfxU32 y0 = band * 8;
+    mfxU32 y1 = std::min<mfxU32>(y0 + 8, src.Height);
+    for (mfxU32 y = y0; y < y1; y++) {
+        const mfxU8* a = &src.Y[y * width];
+        const mfxU8* b = pY + y * pitch;
+        for (size_t x = 0; x < width; x++) {
+            int d = a[x] - b[x];
+            sums.SSE[0] += d * d;
+        }
+    }
+
+    mfxU32 heightUV = (src.Height + 1) / 2;
+    for (mfxU32 y = band * 4; y < std::min<mfxU32>(band * 4 + 4, heightUV); y++) {
+        const mfxU8* a = &src.UV[y * widthUV];
+        const mfxU8* b = pUV + y * pitch;
+        for (size_t x = 0; x < widthUV; x += 2) {
+            int du = a[x] - b[x];
+            int dv = a[x + 1] - b[x + 1];
+            sums.SSE[1] += du * du;
+            sums.SSE[2] += dv * dv;
+        }
+    }
+
+    // SSIM of the complete blocks only
+    if (y1 - y0 < 8)
+        return;
+    for (size_t x0 = 0; x0 + 8 <= width; x0 += 8) {
+        mfxU32 sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+        for (mfxU32 y = y0; y < y1; y++) {
+            const mfxU8* a = &src.Y[y * width + x0];
+            const mfxU8* b = pY + y * pitch + x0;
+            for (int x = 0; x < 8; x++) {
+                sa += a[x];
+                sb += b[x];
+                saa += a[x] * a[x];
+                sbb += b[x] * b[x];
+                sab += a[x] * b[x];
+            }
+        }
+
+        mfxF64 ma  = sa / 64.0;
+        mfxF64 mb  = sb / 64.0;
+        mfxF64 va  = saa / 64.0 - ma * ma;
+        mfxF64 vb  = sbb / 64.0 - mb * mb;
+        mfxF64 cov = sab / 64.0 - ma * mb;
+        sums.SSIM += ((2 * ma * mb + C1) * (2 * cov + C2)) /
+                     ((ma * ma + mb * mb + C1) * (va + vb + C2));
+        sums.Blocks++;
+    }
+}
@@ -0,0 +1,117 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "rounding_offset_reader.h"
+
+#include <algorithm>
+
+CAsyncRoundingOffsetReader::CAsyncRoundingOffsetReader()
+        : m_file(nullptr),
+          m_ring(),
+          m_nRead(0),
+          m_nReady(0),
+          m_mutex(),
+          m_cvFree(),
+          m_cvReady(),
+          m_thread(),
+          m_bStop(false),
+          m_bEOS(false) {}
+
+CAsyncRoundingOffsetReader::~CAsyncRoundingOffsetReader() {
+    Close();
+}
+
+mfxStatus CAsyncRoundingOffsetReader::Init(const msdk_char* strFileName, mfxU32 nFrames) {
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+
+    Close();
+
+    MSDK_FOPEN(m_file, strFileName, MSDK_CHAR("rb"));
+    MSDK_CHECK_POINTER(m_file, MFX_ERR_NULL_PTR);
+
+    // records are allocated once, for interlaced frames of two fields
+    m_ring.resize(2 * std::max<mfxU32>(nFrames, 1));
+    m_nRead  = 0;
+    m_nReady = 0;
+    m_bStop  = false;
+    m_bEOS   = false;
+    m_thread = std::thread(&CAsyncRoundingOffsetReader::ReaderRoutine, this);
+
+    return MFX_ERR_NONE;
+}
+
+void CAsyncRoundingOffsetReader::Close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cvFree.notify_one();
+        m_thread.join();
+    }
+
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_ring.clear();
+}
+
+mfxStatus CAsyncRoundingOffsetReader::GetNextFrame(mfxEncodeCtrlWrap& ctrl, mfxU32 numFields) {
+    MSDK_CHECK_ERROR(m_thread.joinable(), false, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_ERROR(numFields && numFields <= m_ring.size(), false, MFX_ERR_UNSUPPORTED);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cvReady.wait(lock, [&] { return m_nReady - m_nRead >= numFields || m_bEOS; });
+        if (m_nReady - m_nRead < numFields)
+            return MFX_ERR_MORE_DATA;
+    }
+
+    // the reading thread doesn't touch records until they are released below
+    ctrl.AddExtBuffer<mfxExtAVCRoundingOffset>();
+    for (mfxU32 fieldId = 0; fieldId < numFields; ++fieldId) {
+        auto ro = ctrl.GetExtBuffer<mfxExtAVCRoundingOffset>(fieldId);
+        MSDK_CHECK_POINTER(ro, MFX_ERR_NULL_PTR);
+
+        const FieldOffsets& field = m_ring[(m_nRead + fieldId) % m_ring.size()];
+        ro->EnableRoundingIntra   = field.EnableRoundingIntra;
+        ro->RoundingOffsetIntra   = field.RoundingOffsetIntra;
+        ro->EnableRoundingInter   = field.EnableRoundingInter;
+        ro->RoundingOffsetInter   = field.RoundingOffsetInter;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_nRead += numFields;
+    }
+    m_cvFree.notify_one();
+
+    return MFX_ERR_NONE;
+}
+
+void CAsyncRoundingOffsetReader::ReaderRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_bEOS) {
+        m_cvFree.wait(lock, [this] { return m_bStop || m_nReady - m_nRead < m_ring.size(); });
+        if (m_bStop)
+            break;
+
+        // all free records up to the end of the ring are read at once
+        size_t pos   = (size_t)(m_nReady % m_ring.size());
+        size_t count =
+            std::min((size_t)(m_ring.size() - (m_nReady - m_nRead)), m_ring.size() - pos);
+
+        lock.unlock();
+        size_t n = fread(&m_ring[pos], sizeof(FieldOffsets), count, m_file);
+        lock.lock();
+
+        m_nReady += n;
+        if (n < count)
+            m_bEOS = true;
+        m_cvReady.notify_one();
+    }
+}
@@ -29,6 +29,7 @@
 #if defined(_WIN32) || defined(_WIN64)
 
     #include <DXGI.h>
+    #include <io.h>
     #include <psapi.h>
     #include <tchar.h>
     #include <windows.h>
@@ -39,7 +40,10 @@
 
 #else
 
+    #include <fcntl.h>
     #include <link.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
     #include <string>
 
     #if defined(__x86_64__)
@@ -50,8 +54,148 @@
 
 #endif // #if defined(_WIN32) || defined(_WIN64)
 
-msdk_tick CTimer::frequency              = 0;
-msdk_tick CTimeStatisticsReal::frequency = 0;
+// SSE4.1 streaming loads are compiled for x86 only and used if the CPU has them
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #include <smmintrin.h>
+    #define MSDK_STREAMING_LOADS 1
+    #define MSDK_TARGET_SSE41
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <smmintrin.h>
+    #define MSDK_STREAMING_LOADS 1
+    #define MSDK_TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+
+// shifts of 16 bit samples and interleaving of chroma: AVX2 on x86 if the CPU has it, NEON on ARM
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h>
+    #define MSDK_SHIFT_AVX2 1
+    #define MSDK_TARGET_AVX2
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define MSDK_SHIFT_AVX2 1
+    #define MSDK_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define MSDK_SHIFT_NEON 1
+#endif
+
+bool IsAVX2Supported() {
+#if defined(MSDK_SHIFT_AVX2) && defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    // the OS must save the YMM registers
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(MSDK_SHIFT_AVX2)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+namespace {
+#ifdef MSDK_SHIFT_AVX2
+MSDK_TARGET_AVX2 size_t ShiftSamplesLeftAVX2(mfxU16* p, size_t n, mfxU32 shift) {
+    const __m128i count = _mm_cvtsi32_si128((int)shift);
+    size_t j            = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + j));
+        _mm256_storeu_si256((__m256i*)(p + j), _mm256_sll_epi16(x, count));
+    }
+    return j;
+}
+
+MSDK_TARGET_AVX2 size_t ShiftSamplesRightAVX2(mfxU16* pDst,
+                                              const mfxU16* pSrc,
+                                              size_t n,
+                                              mfxU32 shift) {
+    const __m128i count = _mm_cvtsi32_si128((int)shift);
+    size_t j            = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(pSrc + j));
+        _mm256_storeu_si256((__m256i*)(pDst + j), _mm256_srl_epi16(x, count));
+    }
+    return j;
+}
+#endif
+
+// MSB aligned samples of P010, P210, Y210 and the like from the LSB aligned ones of the file
+void ShiftSamplesLeft(mfxU16* p, size_t n, mfxU32 shift) {
+    size_t j = 0;
+#if defined(MSDK_SHIFT_AVX2)
+    static const bool bAVX2 = IsAVX2Supported();
+    if (bAVX2)
+        j = ShiftSamplesLeftAVX2(p, n, shift);
+#elif defined(MSDK_SHIFT_NEON)
+    const int16x8_t count = vdupq_n_s16((int16_t)shift);
+    for (; j + 8 <= n; j += 8)
+        vst1q_u16(p + j, vshlq_u16(vld1q_u16(p + j), count));
+#endif
+    for (; j < n; j++)
+        p[j] <<= shift;
+}
+
+void ShiftSamplesRight(mfxU16* pDst, const mfxU16* pSrc, size_t n, mfxU32 shift) {
+    size_t j = 0;
+#if defined(MSDK_SHIFT_AVX2)
+    static const bool bAVX2 = IsAVX2Supported();
+    if (bAVX2)
+        j = ShiftSamplesRightAVX2(pDst, pSrc, n, shift);
+#elif defined(MSDK_SHIFT_NEON)
+    // NEON shifts right by a negative count
+    const int16x8_t count = vdupq_n_s16(-(int16_t)shift);
+    for (; j + 8 <= n; j += 8)
+        vst1q_u16(pDst + j, vshlq_u16(vld1q_u16(pSrc + j), count));
+#endif
+    for (; j < n; j++)
+        pDst[j] = pSrc[j] >> shift;
+}
+
+#ifdef MSDK_SHIFT_AVX2
+MSDK_TARGET_AVX2 size_t InterleaveChromaAVX2(mfxU8* pDst,
+                                             const mfxU8* pU,
+                                             const mfxU8* pV,
+                                             size_t n) {
+    size_t j = 0;
+    for (; j + 32 <= n; j += 32) {
+        __m256i u  = _mm256_loadu_si256((const __m256i*)(pU + j));
+        __m256i v  = _mm256_loadu_si256((const __m256i*)(pV + j));
+        __m256i lo = _mm256_unpacklo_epi8(u, v);
+        __m256i hi = _mm256_unpackhi_epi8(u, v);
+        // unpacking works within 128 bit lanes, so the lanes are put in order
+        _mm256_storeu_si256((__m256i*)(pDst + 2 * j), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(pDst + 2 * j + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    return j;
+}
+#endif
+
+// UV pairs of an NV12 row from n samples of U and V each
+void InterleaveChroma(mfxU8* pDst, const mfxU8* pU, const mfxU8* pV, size_t n) {
+    size_t j = 0;
+#if defined(MSDK_SHIFT_AVX2)
+    static const bool bAVX2 = IsAVX2Supported();
+    if (bAVX2)
+        j = InterleaveChromaAVX2(pDst, pU, pV, n);
+#elif defined(MSDK_SHIFT_NEON)
+    for (; j + 16 <= n; j += 16) {
+        uint8x16x2_t uv = { { vld1q_u8(pU + j), vld1q_u8(pV + j) } };
+        vst2q_u8(pDst + 2 * j, uv);
+    }
+#endif
+    for (; j < n; j++) {
+        pDst[2 * j]     = pU[j];
+        pDst[2 * j + 1] = pV[j];
+    }
+}
+} // namespace
+
+msdk_tick CTimer::frequency                     = 0;
+msdk_tick CTimeStatisticsReal::frequency        = 0;
+msdk_tick CTimeStatisticsReal::preciseFrequency = 0;
 
 mfxStatus CopyBitstream2(mfxBitstream* dest, mfxBitstream* src) {
     if (!dest || !src)
@@ -104,6 +248,7 @@ mfxStatus GetFrameLength(mfxU16 width, mfxU16 height, mfxU32 ColorFormat, mfxU32
 CSmplYUVReader::CSmplYUVReader()
         : m_ColorFormat(MFX_FOURCC_YV12),
           m_files(),
+          m_ChromaBuffer(),
           shouldShift10BitsHigh(false),
           m_bInited(false) {}
 
@@ -136,7 +281,10 @@ mfxStatus CSmplYUVReader::Init(std::list<msdk_string> inputs,
     for (ls_iterator it = inputs.begin(); it != inputs.end(); it++) {
         m_files.push_back(NULL);
         auto& f = m_files.back();
-        MSDK_FOPEN(f, (*it).c_str(), MSDK_STRING("rb"));
+        if (msdk_is_stream((*it).c_str()))
+            f = msdk_stream_open((*it).c_str(), false);
+        else
+            MSDK_FOPEN(f, (*it).c_str(), MSDK_STRING("rb"));
         MSDK_CHECK_POINTER(f, MFX_ERR_NULL_PTR);
     }
 
@@ -153,7 +301,7 @@ CSmplYUVReader::~CSmplYUVReader() {
 
 void CSmplYUVReader::Close() {
     for (mfxU32 i = 0; i < m_files.size(); i++) {
-        fclose(m_files[i]);
+        msdk_stream_close(m_files[i]);
     }
     m_files.clear();
     m_bInited = false;
@@ -185,6 +333,7 @@ mfxStatus CSmplYUVReader::SkipNframesFromBeginning(mfxU16 w,
 }
 
 mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
+    MFX_ITT_TASK("LoadNextFrame");
     // check if reader is initialized
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
@@ -234,7 +383,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                 ptr   = ptr + pInfo.CropX * 4 + pInfo.CropY * pData.Pitch;
 
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr + i * pitch, 1, 4 * w, vid);
 
                     if ((mfxU32)4 * w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -249,7 +398,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                           : pData.U + pInfo.CropX + pInfo.CropY * pData.Pitch;
 
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 2, w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr + i * pitch, 2, w, vid);
 
                     if ((mfxU32)w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -266,7 +415,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                       pInfo.CropX * 4 + pInfo.CropY * pData.Pitch;
 
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr + i * pitch, 1, 4 * w, vid);
 
                     if ((mfxU32)4 * w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -274,10 +423,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
 
                     if ((MFX_FOURCC_Y210 == pInfo.FourCC || MFX_FOURCC_Y216 == pInfo.FourCC) &&
                         shouldShift10BitsHigh) {
-                        mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                        for (int idx = 0; idx < w * 2; idx++) {
-                            shortPtr[idx] <<= shiftSizeLuma;
-                        }
+                        ShiftSamplesLeft((mfxU16*)(ptr + i * pitch), (size_t)w * 2, shiftSizeLuma);
                     }
                 }
                 break;
@@ -295,7 +441,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, nBytesPerPixel, w, m_files[vid]);
+            nBytesRead = (mfxU32)ReadData(ptr + i * pitch, nBytesPerPixel, w, vid);
 
             if (w != nBytesRead) {
                 return MFX_ERR_MORE_DATA;
@@ -305,10 +451,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
             if ((MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
                  MFX_FOURCC_P016 == pInfo.FourCC) &&
                 shouldShift10BitsHigh) {
-                mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                for (int idx = 0; idx < w; idx++) {
-                    shortPtr[idx] <<= shiftSizeLuma;
-                }
+                ShiftSamplesLeft((mfxU16*)(ptr + i * pitch), w, shiftSizeLuma);
             }
         }
 
@@ -318,50 +461,33 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
             case MFX_FOURCC_I420:
             case MFX_FOURCC_YV12:
                 switch (pInfo.FourCC) {
-                    case MFX_FOURCC_NV12:
-                        mfxU32 j, dstOffset[2];
+                    case MFX_FOURCC_NV12: {
                         w /= 2;
                         h /= 2;
                         ptr = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
 
-                        if (m_ColorFormat == MFX_FOURCC_I420) {
-                            dstOffset[0] = 0;
-                            dstOffset[1] = 1;
-                        }
-                        else {
-                            dstOffset[0] = 1;
-                            dstOffset[1] = 0;
-                        }
-
-                        // load first chroma plane: U (input == I420) or V (input == YV12)
+                        // both chroma planes are read at once and interleaved row by row
+                        size_t planeSize = (size_t)w * h;
                         try {
-                            std::vector<mfxU8> buf(w);
-                            for (i = 0; i < h; i++) {
-                                nBytesRead = (mfxU32)fread(&buf[0], 1, w, m_files[vid]);
-                                if (w != nBytesRead) {
-                                    return MFX_ERR_MORE_DATA;
-                                }
-                                for (j = 0; j < w; j++) {
-                                    ptr[i * pitch + j * 2 + dstOffset[0]] = buf[j];
-                                }
-                            }
-
-                            // load second chroma plane: V (input == I420) or U (input == YV12)
-                            for (i = 0; i < h; i++) {
-                                nBytesRead = (mfxU32)fread(&buf[0], 1, w, m_files[vid]);
-
-                                if (w != nBytesRead) {
-                                    return MFX_ERR_MORE_DATA;
-                                }
-                                for (j = 0; j < w; j++) {
-                                    ptr[i * pitch + j * 2 + dstOffset[1]] = buf[j];
-                                }
-                            }
+                            if (m_ChromaBuffer.size() < 2 * planeSize)
+                                m_ChromaBuffer.resize(2 * planeSize);
                         }
                         catch (...) {
                             return MFX_ERR_MEMORY_ALLOC;
                         }
+                        if (2 * planeSize != ReadData(m_ChromaBuffer.data(), 1, 2 * planeSize, vid))
+                            return MFX_ERR_MORE_DATA;
+
+                        // first plane is U (input == I420) or V (input == YV12)
+                        const mfxU8* pU = m_ChromaBuffer.data();
+                        const mfxU8* pV = pU + planeSize;
+                        if (m_ColorFormat == MFX_FOURCC_YV12)
+                            std::swap(pU, pV);
+
+                        for (i = 0; i < h; i++)
+                            InterleaveChroma(ptr + i * pitch, pU + i * w, pV + i * w, w);
                         break;
+                    }
                     case MFX_FOURCC_YV12:
                     case MFX_FOURCC_I420:
                         w /= 2;
@@ -378,14 +504,14 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                         }
 
                         for (i = 0; i < h; i++) {
-                            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_files[vid]);
+                            nBytesRead = (mfxU32)ReadData(ptr + i * pitch, 1, w, vid);
 
                             if (w != nBytesRead) {
                                 return MFX_ERR_MORE_DATA;
                             }
                         }
                         for (i = 0; i < h; i++) {
-                            nBytesRead = (mfxU32)fread(ptr2 + i * pitch, 1, w, m_files[vid]);
+                            nBytesRead = (mfxU32)ReadData(ptr2 + i * pitch, 1, w, vid);
 
                             if (w != nBytesRead) {
                                 return MFX_ERR_MORE_DATA;
@@ -405,14 +531,14 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                 ptr2 = pData.V + (pInfo.CropX / 2) + (pInfo.CropY / 2) * pitch;
 
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr + i * pitch, 1, w, vid);
 
                     if (w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
                     }
                 }
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr2 + i * pitch, 1, w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr2 + i * pitch, 1, w, vid);
 
                     if (w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -428,7 +554,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                 }
                 ptr = pData.UV + pInfo.CropX + (pInfo.CropY / 2) * pitch;
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, nBytesPerPixel, w, m_files[vid]);
+                    nBytesRead = (mfxU32)ReadData(ptr + i * pitch, nBytesPerPixel, w, vid);
 
                     if (w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -438,10 +564,7 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
                     if ((MFX_FOURCC_P010 == pInfo.FourCC || MFX_FOURCC_P210 == pInfo.FourCC ||
                          MFX_FOURCC_P016 == pInfo.FourCC) &&
                         shouldShift10BitsHigh) {
-                        mfxU16* shortPtr = (mfxU16*)(ptr + i * pitch);
-                        for (int idx = 0; idx < w; idx++) {
-                            shortPtr[idx] <<= shiftSizeChroma;
-                        }
+                        ShiftSamplesLeft((mfxU16*)(ptr + i * pitch), w, shiftSizeChroma);
                     }
                 }
 
@@ -457,12 +580,13 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface) {
 mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface,
                                         int bytes_to_read,
                                         mfxU8* buf_read) {
+    MFX_ITT_TASK("LoadNextFrame");
     // check if reader is initialized
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
 
     mfxU32 vid = pSurface->Info.FrameId.ViewId;
 
-    int nBytesRead = static_cast<int>(fread(buf_read, 1, bytes_to_read, m_files[vid]));
+    int nBytesRead = static_cast<int>(ReadData(buf_read, 1, bytes_to_read, vid));
 
     if (bytes_to_read != nBytesRead) {
         return MFX_ERR_MORE_DATA;
@@ -506,12 +630,185 @@ mfxStatus CSmplYUVReader::LoadNextFrame(mfxFrameSurface1* pSurface,
     return MFX_ERR_NONE;
 }
 
+size_t CSmplYUVReader::ReadData(void* pDst, size_t size, size_t count, mfxU32 vid) {
+    return fread(pDst, size, count, m_files[vid]);
+}
+
+CAsyncYUVReader::CAsyncYUVReader(mfxU32 nChunkSize, mfxU32 nChunks)
+        : CSmplYUVReader(),
+          m_nChunkSize(nChunkSize ? nChunkSize : 1),
+          m_nChunks(nChunks),
+          m_CurChunk(),
+          m_nCurOffset(0),
+          m_FreeChunks(),
+          m_ReadyChunks(),
+          m_mutex(),
+          m_cvFree(),
+          m_cvReady(),
+          m_thread(),
+          m_bStop(false),
+          m_bEOS(false) {}
+
+CAsyncYUVReader::~CAsyncYUVReader() {
+    Close();
+}
+
+void CAsyncYUVReader::SetReadAhead(mfxU32 nChunkSize, mfxU32 nChunks) {
+    m_nChunkSize = nChunkSize ? nChunkSize : 1;
+    m_nChunks    = nChunks;
+}
+
+void CAsyncYUVReader::Close() {
+    StopReading();
+    m_FreeChunks.clear();
+
+    CSmplYUVReader::Close();
+}
+
+mfxStatus CAsyncYUVReader::Init(std::list<msdk_string> inputs,
+                                mfxU32 ColorFormat,
+                                bool shouldShiftP010) {
+    Close();
+
+    mfxStatus sts = CSmplYUVReader::Init(inputs, ColorFormat, shouldShiftP010);
+    MSDK_CHECK_STATUS(sts, "CSmplYUVReader::Init failed");
+
+    // file is read in whole chunks, additional copy to the stdio buffer isn't needed
+    if (m_nChunks)
+        setvbuf(m_files[0], NULL, _IONBF, 0);
+    StartReading();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CAsyncYUVReader::SkipNframesFromBeginning(mfxU16 w,
+                                                    mfxU16 h,
+                                                    mfxU32 viewId,
+                                                    mfxU32 nframes) {
+    if (viewId)
+        return CSmplYUVReader::SkipNframesFromBeginning(w, h, viewId, nframes);
+
+    // data read ahead is dropped, reading continues from the new position
+    StopReading();
+    mfxStatus sts = CSmplYUVReader::SkipNframesFromBeginning(w, h, viewId, nframes);
+    StartReading();
+
+    return sts;
+}
+
+void CAsyncYUVReader::Reset() {
+    StopReading();
+    CSmplYUVReader::Reset();
+    StartReading();
+}
+
+size_t CAsyncYUVReader::ReadData(void* pDst, size_t size, size_t count, mfxU32 vid) {
+    if (vid || !m_thread.joinable())
+        return CSmplYUVReader::ReadData(pDst, size, count, vid);
+
+    mfxU8* pOut  = (mfxU8*)pDst;
+    size_t total = size * count;
+    size_t done  = 0;
+    while (done < total) {
+        if (m_nCurOffset == m_CurChunk.Size && !NextChunk())
+            break;
+
+        size_t n = std::min(total - done, m_CurChunk.Size - m_nCurOffset);
+        memcpy(pOut + done, m_CurChunk.Data.data() + m_nCurOffset, n);
+        done += n;
+        m_nCurOffset += n;
+    }
+
+    // incomplete item at the end of file is dropped, as fread does
+    return size ? done / size : 0;
+}
+
+bool CAsyncYUVReader::NextChunk() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_CurChunk.Data.empty()) {
+        m_FreeChunks.push_back(std::move(m_CurChunk.Data));
+        m_CurChunk.Data.clear();
+        m_cvFree.notify_one();
+    }
+    m_CurChunk.Size = 0;
+    m_nCurOffset    = 0;
+
+    m_cvReady.wait(lock, [this] { return !m_ReadyChunks.empty() || m_bEOS; });
+    if (m_ReadyChunks.empty())
+        return false;
+
+    m_CurChunk = std::move(m_ReadyChunks.front());
+    m_ReadyChunks.pop_front();
+
+    return true;
+}
+
+void CAsyncYUVReader::StartReading() {
+    if (!m_bInited || m_files.empty() || !m_nChunks || m_thread.joinable())
+        return;
+
+    // chunks are allocated once and recycled until Close
+    while (m_FreeChunks.size() < m_nChunks)
+        m_FreeChunks.push_back(std::vector<mfxU8>(m_nChunkSize));
+
+    m_bStop  = false;
+    m_bEOS   = false;
+    m_thread = std::thread(&CAsyncYUVReader::ReaderRoutine, this);
+}
+
+void CAsyncYUVReader::StopReading() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cvFree.notify_one();
+        m_thread.join();
+    }
+
+    if (!m_CurChunk.Data.empty())
+        m_FreeChunks.push_back(std::move(m_CurChunk.Data));
+    m_CurChunk.Data.clear();
+    m_CurChunk.Size = 0;
+    m_nCurOffset    = 0;
+
+    for (auto& chunk : m_ReadyChunks)
+        m_FreeChunks.push_back(std::move(chunk.Data));
+    m_ReadyChunks.clear();
+}
+
+void CAsyncYUVReader::ReaderRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_bEOS) {
+        m_cvFree.wait(lock, [this] { return m_bStop || !m_FreeChunks.empty(); });
+        if (m_bStop)
+            break;
+
+        Chunk chunk;
+        chunk.Data = std::move(m_FreeChunks.back());
+        m_FreeChunks.pop_back();
+        lock.unlock();
+
+        chunk.Size = fread(chunk.Data.data(), 1, chunk.Data.size(), m_files[0]);
+
+        lock.lock();
+        if (chunk.Size < chunk.Data.size())
+            m_bEOS = true;
+        if (chunk.Size)
+            m_ReadyChunks.push_back(std::move(chunk));
+        else
+            m_FreeChunks.push_back(std::move(chunk.Data));
+        m_cvReady.notify_one();
+    }
+} // void CAsyncYUVReader::ReaderRoutine()
+
 CSmplBitstreamWriter::CSmplBitstreamWriter()
         : m_nProcessedFramesNum(0),
           m_bSkipWriting(false),
           m_fSource(NULL),
           m_bInited(false),
-          m_sFile() {}
+          m_sFile(),
+          m_nPartialBytes(0) {}
 
 CSmplBitstreamWriter::~CSmplBitstreamWriter() {
     Close();
@@ -519,11 +816,12 @@ CSmplBitstreamWriter::~CSmplBitstreamWriter() {
 
 void CSmplBitstreamWriter::Close() {
     if (m_fSource) {
-        fclose(m_fSource);
+        msdk_stream_close(m_fSource);
         m_fSource = NULL;
     }
 
-    m_bInited = false;
+    m_bInited       = false;
+    m_nPartialBytes = 0;
 }
 
 mfxStatus CSmplBitstreamWriter::Init(const msdk_char* strFileName) {
@@ -534,7 +832,10 @@ mfxStatus CSmplBitstreamWriter::Init(const msdk_char* strFileName) {
     Close();
 
     //init file to write encoded data
-    MSDK_FOPEN(m_fSource, strFileName, MSDK_STRING("wb+"));
+    if (msdk_is_stream(strFileName))
+        m_fSource = msdk_stream_open(strFileName, true);
+    else
+        MSDK_FOPEN(m_fSource, strFileName, MSDK_STRING("wb+"));
     MSDK_CHECK_POINTER(m_fSource, MFX_ERR_NULL_PTR);
 
     m_sFile = msdk_string(strFileName);
@@ -548,12 +849,17 @@ void CSmplBitstreamWriter::ForceInitStatus(bool status) {
 }
 
 mfxStatus CSmplBitstreamWriter::Reset() {
+    // the stream goes on, the peer may not reconnect
+    if (m_bInited && msdk_is_stream(m_sFile.c_str()))
+        return MFX_ERR_NONE;
+
     return Init(m_sFile.c_str());
 }
 
 mfxStatus CSmplBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
                                                bool isPrint,
                                                bool isCompleteFrame) {
+    MFX_ITT_TASK("WriteNextFrame");
     if (m_bSkipWriting)
         return MFX_ERR_NONE;
 
@@ -561,15 +867,31 @@ mfxStatus CSmplBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
 
-    if (isCompleteFrame && pMfxBitstream->DataLength) {
+    bool bPartial        = m_nPartialBytes > 0;
+    mfxU32 nWritten      = std::min(m_nPartialBytes, pMfxBitstream->DataLength);
+    mfxU32 nBytesToWrite = pMfxBitstream->DataLength - nWritten;
+    if (nBytesToWrite) {
         mfxU32 nBytesWritten = 0;
 
-        nBytesWritten = (mfxU32)fwrite(pMfxBitstream->Data + pMfxBitstream->DataOffset,
+        nBytesWritten = (mfxU32)fwrite(pMfxBitstream->Data + pMfxBitstream->DataOffset + nWritten,
                                        1,
-                                       pMfxBitstream->DataLength,
+                                       nBytesToWrite,
                                        m_fSource);
-        MSDK_CHECK_NOT_EQUAL(nBytesWritten, pMfxBitstream->DataLength, MFX_ERR_UNDEFINED_BEHAVIOR);
+        MSDK_CHECK_NOT_EQUAL(nBytesWritten, nBytesToWrite, MFX_ERR_UNDEFINED_BEHAVIOR);
+    }
+
+    if (!isCompleteFrame) {
+        // the part goes to the sink now, not with the next stdio buffer
+        m_nPartialBytes = pMfxBitstream->DataLength;
+        fflush(m_fSource);
+        return MFX_ERR_NONE;
+    }
+
+    m_nPartialBytes = 0;
+    if (bPartial)
+        fflush(m_fSource);
 
+    if (pMfxBitstream->DataLength) {
         // mark that we don't need bit stream data any more
         pMfxBitstream->DataLength = 0;
         pMfxBitstream->DataOffset = 0;
@@ -581,73 +903,346 @@ mfxStatus CSmplBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
             msdk_printf(MSDK_STRING("Frame number: %u\r"), (unsigned int)m_nProcessedFramesNum);
         }
     }
-    else {
-        // append new chunk of partial output to output buffer
+
+    return MFX_ERR_NONE;
+}
+
+CSmplBitstreamDuplicateWriter::sDuplicate::sDuplicate()
+        : name(),
+          file(NULL),
+          bStream(false),
+          policy(BACKPRESSURE_BLOCK),
+          nQueueFrames(0),
+          bDropping(false),
+          nDroppedFrames(0),
+          queue(),
+          mutex(),
+          cvQueued(),
+          cvWritten(),
+          thread(),
+          bStop(false),
+          status(MFX_ERR_NONE) {}
+
+CSmplBitstreamDuplicateWriter::sDuplicate::~sDuplicate() {
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bStop = true;
+        }
+        cvQueued.notify_one();
+        thread.join();
     }
 
+    msdk_stream_close(file);
+
+    if (MFX_ERR_NONE != status)
+        msdk_printf(MSDK_STRING("[ERROR] failed to write to %s\n"), name.c_str());
+    if (nDroppedFrames)
+        msdk_printf(MSDK_STRING("[WARNING] %u frames were dropped for %s\n"),
+                    (unsigned int)nDroppedFrames,
+                    name.c_str());
+}
+
+mfxStatus CSmplBitstreamDuplicateWriter::sDuplicate::Open(const msdk_char* strDst,
+                                                          Backpressure backpressure,
+                                                          mfxU32 nQueue) {
+    name    = strDst;
+    bStream = msdk_is_stream(strDst);
+    if (bStream)
+        file = msdk_stream_open(strDst, true);
+    else
+        MSDK_FOPEN(file, strDst, MSDK_STRING("wb+"));
+    MSDK_CHECK_POINTER(file, MFX_ERR_NULL_PTR);
+
+    policy       = backpressure;
+    nQueueFrames = nQueue ? nQueue : 1;
+    thread       = std::thread(&sDuplicate::WriterRoutine, this);
+
     return MFX_ERR_NONE;
 }
 
-CSmplBitstreamDuplicateWriter::CSmplBitstreamDuplicateWriter() : CSmplBitstreamWriter() {
-    m_fSourceDuplicate = NULL;
-    m_bJoined          = false;
+mfxStatus CSmplBitstreamDuplicateWriter::sDuplicate::Push(const FrameData& frame,
+                                                          mfxU16 frameType) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (MFX_ERR_NONE != status)
+        return status;
+
+    if (BACKPRESSURE_DROP == policy) {
+        // the output stays decodable: after a drop the frames up to an I frame are not written
+        if (bDropping && frameType && !(frameType & (MFX_FRAMETYPE_I | MFX_FRAMETYPE_xI))) {
+            nDroppedFrames++;
+            return MFX_ERR_NONE;
+        }
+        bDropping = queue.size() >= nQueueFrames;
+        if (bDropping) {
+            nDroppedFrames++;
+            return MFX_ERR_NONE;
+        }
+    }
+    else {
+        cvWritten.wait(lock, [this] {
+            return queue.size() < nQueueFrames || MFX_ERR_NONE != status;
+        });
+        if (MFX_ERR_NONE != status)
+            return status;
+    }
+
+    queue.push_back(frame);
+    lock.unlock();
+    cvQueued.notify_one();
+
+    return MFX_ERR_NONE;
 }
 
-mfxStatus CSmplBitstreamDuplicateWriter::InitDuplicate(const msdk_char* strFileName) {
-    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
-    MSDK_CHECK_ERROR(msdk_strlen(strFileName), 0, MFX_ERR_NOT_INITIALIZED);
+void CSmplBitstreamDuplicateWriter::sDuplicate::WriterRoutine() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        cvQueued.wait(lock, [this] { return bStop || !queue.empty(); });
+        if (queue.empty())
+            break;
 
-    if (m_fSourceDuplicate) {
-        fclose(m_fSourceDuplicate);
-        m_fSourceDuplicate = NULL;
+        // the frame stays in the queue while it's written, so the queue holds up to nQueueFrames
+        FrameData frame = queue.front();
+        lock.unlock();
+
+        size_t nBytesWritten = frame->size();
+        if (MFX_ERR_NONE == status)
+            nBytesWritten = fwrite(frame->data(), 1, frame->size(), file);
+        // a stream delivers the frame to the peer as soon as it's written
+        if (bStream)
+            fflush(file);
+
+        lock.lock();
+        queue.pop_front();
+        if (nBytesWritten != frame->size())
+            status = MFX_ERR_UNDEFINED_BEHAVIOR;
+        cvWritten.notify_all();
     }
-    MSDK_FOPEN(m_fSourceDuplicate, strFileName, MSDK_STRING("wb+"));
-    MSDK_CHECK_POINTER(m_fSourceDuplicate, MFX_ERR_NULL_PTR);
+}
+
+CSmplBitstreamDuplicateWriter::CSmplBitstreamDuplicateWriter()
+        : CSmplBitstreamWriter(),
+          m_Duplicates() {}
+
+CSmplBitstreamDuplicateWriter::~CSmplBitstreamDuplicateWriter() {
+    Close();
+}
 
-    m_bJoined = false; // mark we own the file handle
+mfxStatus CSmplBitstreamDuplicateWriter::AddDuplicate(const msdk_char* strDst,
+                                                      Backpressure policy,
+                                                      mfxU32 nQueueFrames) {
+    MSDK_CHECK_POINTER(strDst, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(msdk_strlen(strDst), 0, MFX_ERR_NOT_INITIALIZED);
+
+    auto duplicate = std::make_shared<sDuplicate>();
+    mfxStatus sts  = duplicate->Open(strDst, policy, nQueueFrames);
+    MSDK_CHECK_STATUS(sts, "sDuplicate::Open failed");
+
+    m_Duplicates.push_back(duplicate);
 
     return MFX_ERR_NONE;
 }
 
+mfxStatus CSmplBitstreamDuplicateWriter::InitDuplicate(const msdk_char* strFileName) {
+    m_Duplicates.clear();
+
+    return AddDuplicate(strFileName);
+}
+
 mfxStatus CSmplBitstreamDuplicateWriter::JoinDuplicate(CSmplBitstreamDuplicateWriter* pJoinee) {
     MSDK_CHECK_POINTER(pJoinee, MFX_ERR_NULL_PTR);
-    MSDK_CHECK_ERROR(pJoinee->m_fSourceDuplicate, NULL, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_ERROR(pJoinee->m_Duplicates.empty(), true, MFX_ERR_NOT_INITIALIZED);
 
-    m_fSourceDuplicate = pJoinee->m_fSourceDuplicate;
-    m_bJoined          = true; // mark we do not own the file handle
+    m_Duplicates = pJoinee->m_Duplicates;
 
     return MFX_ERR_NONE;
 }
 
-mfxStatus CSmplBitstreamDuplicateWriter::WriteNextFrame(mfxBitstream* pMfxBitstream, bool isPrint) {
-    MSDK_CHECK_ERROR(m_fSourceDuplicate, NULL, MFX_ERR_NOT_INITIALIZED);
+mfxStatus CSmplBitstreamDuplicateWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                                        bool isPrint,
+                                                        bool isCompleteFrame) {
+    MFX_ITT_TASK("WriteNextFrame");
+    MSDK_CHECK_ERROR(m_Duplicates.empty(), true, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
 
-    mfxU32 nBytesWritten = (mfxU32)fwrite(pMfxBitstream->Data + pMfxBitstream->DataOffset,
-                                          1,
-                                          pMfxBitstream->DataLength,
-                                          m_fSourceDuplicate);
-    MSDK_CHECK_NOT_EQUAL(nBytesWritten, pMfxBitstream->DataLength, MFX_ERR_UNDEFINED_BEHAVIOR);
+    if (isCompleteFrame && pMfxBitstream->DataLength) {
+        // the bitstream is reused by the encoder once the frame is written to the file of Init
+        const mfxU8* pData = pMfxBitstream->Data + pMfxBitstream->DataOffset;
+        FrameData frame =
+            std::make_shared<std::vector<mfxU8>>(pData, pData + pMfxBitstream->DataLength);
+
+        for (auto& duplicate : m_Duplicates) {
+            mfxStatus sts = duplicate->Push(frame, pMfxBitstream->FrameType);
+            MSDK_CHECK_STATUS(sts, "sDuplicate::Push failed");
+        }
+    }
+
+    return CSmplBitstreamWriter::WriteNextFrame(pMfxBitstream, isPrint, isCompleteFrame);
+}
+
+void CSmplBitstreamDuplicateWriter::Close() {
+    // frames queued for a duplicate are written when its last writer releases it
+    m_Duplicates.clear();
+
+    CSmplBitstreamWriter::Close();
+}
+
+CAsyncBitstreamWriter::CAsyncBitstreamWriter(mfxU32 nChunkSize, mfxU32 nChunks)
+        : CSmplBitstreamWriter(),
+          m_nChunkSize(nChunkSize),
+          m_CurChunk(),
+          m_FreeChunks(nChunks > 1 ? nChunks - 1 : 1),
+          m_QueuedChunks(),
+          m_mutex(),
+          m_cvQueued(),
+          m_cvWritten(),
+          m_thread(),
+          m_bStop(false),
+          m_bWriting(false),
+          m_WriterStatus(MFX_ERR_NONE) {}
+
+CAsyncBitstreamWriter::~CAsyncBitstreamWriter() {
+    Close();
+}
+
+mfxStatus CAsyncBitstreamWriter::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamWriter::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamWriter::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+
+    // chunks are large enough, additional copy to the stdio buffer isn't needed
+    setvbuf(m_fSource, NULL, _IONBF, 0);
 
-    CSmplBitstreamWriter::WriteNextFrame(pMfxBitstream, isPrint);
+    m_WriterStatus = MFX_ERR_NONE;
+    m_bStop        = false;
+    m_thread       = std::thread(&CAsyncBitstreamWriter::WriterRoutine, this);
 
     return MFX_ERR_NONE;
 }
 
-void CSmplBitstreamDuplicateWriter::Close() {
-    if (m_fSourceDuplicate && !m_bJoined) {
-        fclose(m_fSourceDuplicate);
+mfxStatus CAsyncBitstreamWriter::WriteNextFrame(mfxBitstream* pMfxBitstream,
+                                                bool isPrint,
+                                                bool isCompleteFrame) {
+    MFX_ITT_TASK("WriteNextFrame");
+    if (m_bSkipWriting)
+        return MFX_ERR_NONE;
+
+    // check if writer is initialized
+    MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
+
+    if (!isCompleteFrame || !pMfxBitstream->DataLength)
+        return MFX_ERR_NONE;
+
+    if (!m_CurChunk.empty() && m_CurChunk.size() + pMfxBitstream->DataLength > m_nChunkSize) {
+        mfxStatus sts = SubmitChunk();
+        MSDK_CHECK_STATUS(sts, "SubmitChunk failed");
     }
 
-    m_fSourceDuplicate = NULL;
-    m_bJoined          = false;
+    // frame larger than the chunk is queued as one bigger chunk
+    const mfxU8* pData = pMfxBitstream->Data + pMfxBitstream->DataOffset;
+    m_CurChunk.insert(m_CurChunk.end(), pData, pData + pMfxBitstream->DataLength);
+
+    // mark that we don't need bit stream data any more
+    pMfxBitstream->DataLength = 0;
+    pMfxBitstream->DataOffset = 0;
+
+    m_nProcessedFramesNum++;
+
+    if (isPrint && (1 == m_nProcessedFramesNum || (0 == (m_nProcessedFramesNum % 100)))) {
+        msdk_printf(MSDK_STRING("Frame number: %u\r"), (unsigned int)m_nProcessedFramesNum);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CAsyncBitstreamWriter::Flush() {
+    if (!m_thread.joinable())
+        return MFX_ERR_NONE;
+
+    if (!m_CurChunk.empty()) {
+        mfxStatus sts = SubmitChunk();
+        MSDK_CHECK_STATUS(sts, "SubmitChunk failed");
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvWritten.wait(lock, [this] {
+        return (m_QueuedChunks.empty() && !m_bWriting) || MFX_ERR_NONE != m_WriterStatus;
+    });
+
+    return m_WriterStatus;
+}
+
+void CAsyncBitstreamWriter::Close() {
+    if (m_thread.joinable()) {
+        mfxStatus sts = Flush();
+        MSDK_CHECK_STATUS_NO_RET(sts, "CAsyncBitstreamWriter::Flush failed");
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cvQueued.notify_one();
+        m_thread.join();
+    }
+    m_CurChunk.clear();
 
     CSmplBitstreamWriter::Close();
 }
 
+mfxStatus CAsyncBitstreamWriter::SubmitChunk() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // all chunks are queued when the disk is slower than the caller
+    m_cvWritten.wait(lock,
+                     [this] { return !m_FreeChunks.empty() || MFX_ERR_NONE != m_WriterStatus; });
+    if (MFX_ERR_NONE != m_WriterStatus)
+        return m_WriterStatus;
+
+    m_QueuedChunks.push_back(std::move(m_CurChunk));
+    m_CurChunk = std::move(m_FreeChunks.back());
+    m_FreeChunks.pop_back();
+    m_CurChunk.clear();
+    lock.unlock();
+
+    m_cvQueued.notify_one();
+    m_CurChunk.reserve(m_nChunkSize);
+
+    return MFX_ERR_NONE;
+}
+
+void CAsyncBitstreamWriter::WriterRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvQueued.wait(lock, [this] { return m_bStop || !m_QueuedChunks.empty(); });
+        if (m_QueuedChunks.empty())
+            break;
+
+        std::vector<mfxU8> chunk = std::move(m_QueuedChunks.front());
+        m_QueuedChunks.pop_front();
+        m_bWriting = true;
+        lock.unlock();
+
+        size_t nBytesWritten = chunk.size();
+        if (MFX_ERR_NONE == m_WriterStatus)
+            nBytesWritten = fwrite(chunk.data(), 1, chunk.size(), m_fSource);
+
+        lock.lock();
+        m_bWriting = false;
+        if (nBytesWritten != chunk.size())
+            m_WriterStatus = MFX_ERR_UNDEFINED_BEHAVIOR;
+        chunk.clear();
+        m_FreeChunks.push_back(std::move(chunk));
+        m_cvWritten.notify_all();
+    }
+} // void CAsyncBitstreamWriter::WriterRoutine()
+
 CSmplBitstreamReader::CSmplBitstreamReader() {
-    m_fSource = NULL;
-    m_bInited = false;
+    m_fSource     = NULL;
+    m_bInited     = false;
+    m_bStream     = false;
+    m_nRangeBegin = 0;
+    m_nRangeEnd   = 0;
 }
 
 CSmplBitstreamReader::~CSmplBitstreamReader() {
@@ -656,95 +1251,777 @@ CSmplBitstreamReader::~CSmplBitstreamReader() {
 
 void CSmplBitstreamReader::Close() {
     if (m_fSource) {
-        fclose(m_fSource);
+        msdk_stream_close(m_fSource);
         m_fSource = NULL;
     }
 
-    m_bInited = false;
+    m_bInited     = false;
+    m_bStream     = false;
+    m_nRangeBegin = 0;
+    m_nRangeEnd   = 0;
+}
+
+void CSmplBitstreamReader::Reset() {
+    if (!m_bInited || m_bStream)
+        return;
+
+    MSDK_FSEEK64(m_fSource, m_nRangeBegin, SEEK_SET);
+}
+
+mfxStatus CSmplBitstreamReader::SetRange(mfxU64 nBegin, mfxU64 nEnd) {
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+    if (nEnd && nEnd < nBegin)
+        return MFX_ERR_UNSUPPORTED;
+
+    MSDK_CHECK_NOT_EQUAL(MSDK_FSEEK64(m_fSource, nBegin, SEEK_SET), 0, MFX_ERR_UNSUPPORTED);
+    m_nRangeBegin = nBegin;
+    m_nRangeEnd   = nEnd;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CSmplBitstreamReader::Init(const msdk_char* strFileName) {
+    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
+    if (!msdk_strlen(strFileName))
+        return MFX_ERR_NONE;
+
+    Close();
+
+    //open file to read input stream
+    m_bStream = msdk_is_stream(strFileName);
+    if (m_bStream)
+        m_fSource = msdk_stream_open(strFileName, false);
+    else
+        MSDK_FOPEN(m_fSource, strFileName, MSDK_STRING("rb"));
+    MSDK_CHECK_POINTER(m_fSource, MFX_ERR_NULL_PTR);
+
+    m_bInited = true;
+    return MFX_ERR_NONE;
+}
+
+#define CHECK_SET_EOS(pBitstream)                  \
+    if (feof(m_fSource)) {                         \
+        pBitstream->DataFlag |= MFX_BITSTREAM_EOS; \
+    }
+
+mfxStatus CSmplBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    // Not enough memory to read new chunk of data
+    if (pBS->MaxLength == pBS->DataLength)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+    pBS->DataOffset = 0;
+
+    mfxU32 nBytesToRead = pBS->MaxLength - pBS->DataLength;
+    mfxU64 nPosition    = 0;
+    if (m_nRangeEnd) {
+        nPosition    = (mfxU64)std::max<mfxI64>(MSDK_FTELL64(m_fSource), 0);
+        nBytesToRead = (nPosition < m_nRangeEnd)
+                           ? (mfxU32)std::min<mfxU64>(nBytesToRead, m_nRangeEnd - nPosition)
+                           : 0;
+    }
+    mfxU32 nBytesRead = 0;
+    if (m_bStream) {
+        // data of a live stream is passed on as it comes
+        nBytesRead = (mfxU32)msdk_stream_read(m_fSource, pBS->Data + pBS->DataLength, nBytesToRead);
+        if (!nBytesRead)
+            pBS->DataFlag |= MFX_BITSTREAM_EOS;
+    }
+    else {
+        nBytesRead = (mfxU32)fread(pBS->Data + pBS->DataLength, 1, nBytesToRead, m_fSource);
+    }
+
+    CHECK_SET_EOS(pBS);
+    if (m_nRangeEnd && nPosition + nBytesRead >= m_nRangeEnd)
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+
+    if (0 == nBytesRead) {
+        return MFX_ERR_MORE_DATA;
+    }
+
+    pBS->DataLength += nBytesRead;
+
+    return MFX_ERR_NONE;
+}
+
+CPrefetchBitstreamReader::CPrefetchBitstreamReader(mfxU32 nChunkSize, mfxU32 nChunks)
+        : CSmplBitstreamReader(),
+          m_nChunkSize(nChunkSize),
+          m_CurChunk(),
+          m_nCurOffset(0),
+          m_FreeChunks(nChunks ? nChunks : 1),
+          m_ReadyChunks(),
+          m_mutex(),
+          m_cvFree(),
+          m_cvReady(),
+          m_thread(),
+          m_bStop(false),
+          m_bEndOfFile(false) {}
+
+CPrefetchBitstreamReader::~CPrefetchBitstreamReader() {
+    Close();
+}
+
+void CPrefetchBitstreamReader::Close() {
+    StopReading();
+    CSmplBitstreamReader::Close();
+}
+
+void CPrefetchBitstreamReader::Reset() {
+    if (!m_bInited)
+        return;
+
+    StopReading();
+    CSmplBitstreamReader::Reset();
+    StartReading();
+}
+
+mfxStatus CPrefetchBitstreamReader::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+
+    // file is read in large chunks, stdio buffer would only add a copy
+    setvbuf(m_fSource, NULL, _IONBF, 0);
+#if !defined(_WIN32) && !defined(_WIN64)
+    posix_fadvise(fileno(m_fSource), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    StartReading();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CPrefetchBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    // Not enough memory to read new chunk of data
+    if (pBS->MaxLength == pBS->DataLength)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    // data is moved to the beginning only when less than a half of the free space is at the end
+    mfxU32 nFreeSpace = pBS->MaxLength - pBS->DataLength;
+    if (pBS->MaxLength - pBS->DataOffset - pBS->DataLength < nFreeSpace / 2) {
+        memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+        pBS->DataOffset = 0;
+    }
+
+    mfxU8* pDst       = pBS->Data + pBS->DataOffset + pBS->DataLength;
+    mfxU32 nSpace     = pBS->MaxLength - pBS->DataOffset - pBS->DataLength;
+    mfxU32 nBytesRead = 0;
+    bool bEndOfStream = false;
+    while (nBytesRead < nSpace) {
+        // waits for the reading thread only when nothing is copied yet
+        if (m_nCurOffset == m_CurChunk.size() && !NextChunk(0 == nBytesRead, bEndOfStream))
+            break;
+
+        mfxU32 nBytes =
+            (mfxU32)std::min<size_t>(nSpace - nBytesRead, m_CurChunk.size() - m_nCurOffset);
+        memcpy(pDst + nBytesRead, m_CurChunk.data() + m_nCurOffset, nBytes);
+        m_nCurOffset += nBytes;
+        nBytesRead += nBytes;
+    }
+
+    if (bEndOfStream)
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+
+    if (0 == nBytesRead) {
+        return MFX_ERR_MORE_DATA;
+    }
+
+    pBS->DataLength += nBytesRead;
+
+    return MFX_ERR_NONE;
+}
+
+bool CPrefetchBitstreamReader::NextChunk(bool bWait, bool& bEndOfStream) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_CurChunk.size()) {
+        m_FreeChunks.push_back(std::move(m_CurChunk));
+        m_CurChunk.clear();
+        m_cvFree.notify_one();
+    }
+    m_nCurOffset = 0;
+
+    if (bWait)
+        m_cvReady.wait(lock, [this] { return !m_ReadyChunks.empty() || m_bEndOfFile; });
+
+    if (m_ReadyChunks.empty()) {
+        bEndOfStream = m_bEndOfFile;
+        return false;
+    }
+
+    m_CurChunk = std::move(m_ReadyChunks.front());
+    m_ReadyChunks.pop_front();
+
+    return true;
+}
+
+void CPrefetchBitstreamReader::StartReading() {
+    m_bStop      = false;
+    m_bEndOfFile = false;
+    m_thread     = std::thread(&CPrefetchBitstreamReader::ReaderRoutine, this);
+}
+
+void CPrefetchBitstreamReader::StopReading() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cvFree.notify_one();
+        m_thread.join();
+    }
+
+    // prefetched data is dropped
+    if (m_CurChunk.size())
+        m_FreeChunks.push_back(std::move(m_CurChunk));
+    m_CurChunk.clear();
+    m_nCurOffset = 0;
+    while (!m_ReadyChunks.empty()) {
+        m_FreeChunks.push_back(std::move(m_ReadyChunks.front()));
+        m_ReadyChunks.pop_front();
+    }
+}
+
+void CPrefetchBitstreamReader::ReaderRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvFree.wait(lock, [this] { return m_bStop || !m_FreeChunks.empty(); });
+        if (m_bStop)
+            break;
+
+        std::vector<mfxU8> chunk = std::move(m_FreeChunks.back());
+        m_FreeChunks.pop_back();
+        lock.unlock();
+
+        // chunks keep their size while reused, so they are zero-filled only once
+        chunk.resize(m_nChunkSize);
+        size_t nBytesRead = fread(chunk.data(), 1, m_nChunkSize, m_fSource);
+        chunk.resize(nBytesRead);
+
+        lock.lock();
+        if (nBytesRead)
+            m_ReadyChunks.push_back(std::move(chunk));
+        else
+            m_FreeChunks.push_back(std::move(chunk));
+        m_bEndOfFile = nBytesRead < m_nChunkSize;
+        m_cvReady.notify_one();
+        if (m_bEndOfFile)
+            break;
+    }
+} // void CPrefetchBitstreamReader::ReaderRoutine()
+
+CMemoryBitstreamReader::CMemoryBitstreamReader()
+        : CSmplBitstreamReader(),
+          m_Data(),
+          m_nOffset(0) {}
+
+CMemoryBitstreamReader::~CMemoryBitstreamReader() {
+    Close();
+}
+
+void CMemoryBitstreamReader::Close() {
+    m_Data.clear();
+    m_Data.shrink_to_fit();
+    m_nOffset = 0;
+    CSmplBitstreamReader::Close();
+}
+
+void CMemoryBitstreamReader::Reset() {
+    m_nOffset = 0;
+}
+
+mfxStatus CMemoryBitstreamReader::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+
+    std::vector<mfxU8> chunk(1024 * 1024);
+    size_t nBytesRead = 0;
+    while ((nBytesRead = fread(chunk.data(), 1, chunk.size(), m_fSource)) > 0) {
+        m_Data.insert(m_Data.end(), chunk.begin(), chunk.begin() + nBytesRead);
+    }
+    MSDK_CHECK_NOT_EQUAL(ferror(m_fSource), 0, MFX_ERR_ABORTED);
+
+    // the file isn't needed anymore
+    msdk_stream_close(m_fSource);
+    m_fSource = NULL;
+    m_nOffset = 0;
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CMemoryBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    // Not enough memory to read new chunk of data
+    if (pBS->MaxLength == pBS->DataLength)
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
+    pBS->DataOffset = 0;
+
+    mfxU32 nBytesRead =
+        (mfxU32)std::min<size_t>(pBS->MaxLength - pBS->DataLength, m_Data.size() - m_nOffset);
+    if (nBytesRead) {
+        memcpy(pBS->Data + pBS->DataLength, m_Data.data() + m_nOffset, nBytesRead);
+        m_nOffset += nBytesRead;
+    }
+
+    if (m_nOffset == m_Data.size()) {
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+    }
+
+    if (0 == nBytesRead) {
+        return MFX_ERR_MORE_DATA;
+    }
+
+    pBS->DataLength += nBytesRead;
+
+    return MFX_ERR_NONE;
+}
+
+CSmplFileMapping::CSmplFileMapping()
+        : m_pData(NULL),
+          m_nSize(0)
+#if defined(_WIN32) || defined(_WIN64)
+          ,
+          m_hMapping(NULL)
+#endif
+{
+}
+
+CSmplFileMapping::~CSmplFileMapping() {
+    Unmap();
+}
+
+mfxStatus CSmplFileMapping::Map(FILE* pFile) {
+    MSDK_CHECK_POINTER(pFile, MFX_ERR_NULL_PTR);
+
+    Unmap();
+
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(pFile));
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size))
+        return MFX_ERR_UNSUPPORTED;
+    // empty file can't be mapped, there is just nothing to read
+    if (!size.QuadPart)
+        return MFX_ERR_NONE;
+
+    m_hMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    MSDK_CHECK_POINTER(m_hMapping, MFX_ERR_UNSUPPORTED);
+    m_pData = (mfxU8*)MapViewOfFile(m_hMapping, FILE_MAP_COPY, 0, 0, 0);
+    if (!m_pData) {
+        Unmap();
+        return MFX_ERR_UNSUPPORTED;
+    }
+    m_nSize = (size_t)size.QuadPart;
+#else
+    struct stat st;
+    if (fstat(fileno(pFile), &st) || !S_ISREG(st.st_mode))
+        return MFX_ERR_UNSUPPORTED;
+    // empty file can't be mapped, there is just nothing to read
+    if (!st.st_size)
+        return MFX_ERR_NONE;
+
+    void* pData =
+        mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(pFile), 0);
+    if (MAP_FAILED == pData)
+        return MFX_ERR_UNSUPPORTED;
+    madvise(pData, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    m_pData = (mfxU8*)pData;
+    m_nSize = (size_t)st.st_size;
+#endif
+
+    return MFX_ERR_NONE;
+}
+
+void CSmplFileMapping::Unmap() {
+#if defined(_WIN32) || defined(_WIN64)
+    if (m_pData)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping)
+        CloseHandle(m_hMapping);
+    m_hMapping = NULL;
+#else
+    if (m_pData)
+        munmap(m_pData, m_nSize);
+#endif
+    m_pData = NULL;
+    m_nSize = 0;
+}
+
+CMappedBitstreamReader::CMappedBitstreamReader(mfxU32 nWindowSize)
+        : CSmplBitstreamReader(),
+          m_Mapping(),
+          m_nWindowSize(nWindowSize ? nWindowSize : 1),
+          m_nOffset(0),
+          m_pView(NULL),
+          m_nViewOffset(0) {}
+
+CMappedBitstreamReader::~CMappedBitstreamReader() {
+    Close();
+}
+
+void CMappedBitstreamReader::Close() {
+    m_Mapping.Unmap();
+    Reset();
+    CSmplBitstreamReader::Close();
+}
+
+void CMappedBitstreamReader::Reset() {
+    m_nOffset     = 0;
+    m_pView       = NULL;
+    m_nViewOffset = 0;
+}
+
+mfxStatus CMappedBitstreamReader::Init(const msdk_char* strFileName) {
+    mfxStatus sts = CSmplBitstreamReader::Init(strFileName);
+    MSDK_CHECK_STATUS(sts, "CSmplBitstreamReader::Init failed");
+    if (!m_bInited)
+        return MFX_ERR_NONE;
+
+    sts = m_Mapping.Map(m_fSource);
+    MSDK_CHECK_STATUS(sts, "m_Mapping.Map failed");
+
+    Reset();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CMappedBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    if (!m_bInited)
+        return MFX_ERR_NOT_INITIALIZED;
+
+    MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
+
+    // not consumed data is kept only if it's the tail of the last window
+    size_t nBegin = m_nOffset;
+    if (m_pView && pBS->Data == m_pView &&
+        m_nViewOffset + pBS->DataOffset + pBS->DataLength == m_nOffset) {
+        nBegin = m_nViewOffset + pBS->DataOffset;
+    }
+
+    size_t nBytesRead = std::min<size_t>(m_nWindowSize, m_Mapping.GetSize() - m_nOffset);
+    if (m_nOffset - nBegin + nBytesRead > std::numeric_limits<mfxU32>::max())
+        return MFX_ERR_NOT_ENOUGH_BUFFER;
+
+    if (nBytesRead) {
+        m_nOffset += nBytesRead;
+        m_pView       = m_Mapping.GetData() + nBegin;
+        m_nViewOffset = nBegin;
+
+        pBS->Data       = m_pView;
+        pBS->DataOffset = 0;
+        pBS->DataLength = (mfxU32)(m_nOffset - nBegin);
+        pBS->MaxLength  = pBS->DataLength;
+    }
+
+    if (m_nOffset == m_Mapping.GetSize()) {
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+    }
+
+    if (0 == nBytesRead) {
+        return MFX_ERR_MORE_DATA;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxU32 CJPEGFrameReader::FindMarker(mfxBitstream* pBS,
+                                    mfxU32 startOffset,
+                                    CJPEGFrameReader::JPEGMarker marker) {
+    // marker is searched by its 0xFF byte with memchr, C runtimes scan it with SIMD instructions
+    mfxU8* pEnd = pBS->Data + pBS->DataLength;
+    for (mfxU8* p = pBS->Data + startOffset;
+         p + 1 < pEnd && (p = (mfxU8*)memchr(p, 0xFF, pEnd - 1 - p));
+         p++) {
+        if (*(mfxU16*)p == (mfxU16)marker) {
+            return (mfxU32)(p - pBS->Data);
+        }
+    }
+    return 0xFFFFFFFF;
+}
+
+mfxStatus CJPEGFrameReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
+    mfxStatus sts    = MFX_ERR_NONE;
+    mfxU32 offsetSOI = 0xFFFFFFFF;
+
+    pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
+
+    while ((offsetSOI = FindMarker(pBS, pBS->DataOffset, CJPEGFrameReader::SOI)) == 0xFFFFFFFF &&
+           sts == MFX_ERR_NONE) {
+        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
+    }
+
+    //--- Finding EOI of frame, to make sure that it is complete
+    while (FindMarker(pBS, offsetSOI, CJPEGFrameReader::EOI) == 0xFFFFFFFF && sts == MFX_ERR_NONE) {
+        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
+    }
+
+    return sts;
+}
+
+CJPEGBatchReader::CJPEGBatchReader(mfxU32 nPrefetch)
+        : CSmplBitstreamReader(),
+          m_Images(),
+          m_nPrefetch(nPrefetch ? nPrefetch : 1),
+          m_nNextImage(0),
+          m_ReadyImages(),
+          m_mutex(),
+          m_cvFree(),
+          m_cvReady(),
+          m_thread(),
+          m_bStop(false),
+          m_bEndOfBatch(false),
+          m_nMaxWidth(0),
+          m_nMaxHeight(0),
+          m_nMaxFileSize(0) {}
+
+CJPEGBatchReader::~CJPEGBatchReader() {
+    Close();
+}
+
+void CJPEGBatchReader::Close() {
+    StopReading();
+    m_Images.clear();
+    m_nMaxWidth    = 0;
+    m_nMaxHeight   = 0;
+    m_nMaxFileSize = 0;
+    CSmplBitstreamReader::Close();
 }
 
-void CSmplBitstreamReader::Reset() {
+void CJPEGBatchReader::Reset() {
     if (!m_bInited)
         return;
 
-    fseek(m_fSource, 0, SEEK_SET);
+    StopReading();
+    StartReading();
 }
 
-mfxStatus CSmplBitstreamReader::Init(const msdk_char* strFileName) {
-    MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
-    if (!msdk_strlen(strFileName))
-        return MFX_ERR_NONE;
+mfxStatus CJPEGBatchReader::Init(const msdk_char* strListFile) {
+    MSDK_CHECK_POINTER(strListFile, MFX_ERR_NULL_PTR);
 
     Close();
 
-    //open file to read input stream
-    MSDK_FOPEN(m_fSource, strFileName, MSDK_STRING("rb"));
-    MSDK_CHECK_POINTER(m_fSource, MFX_ERR_NULL_PTR);
+    msdk_fstream list(strListFile, std::ios_base::in);
+    if (!list.is_open()) {
+        msdk_printf(MSDK_STRING("ERROR: can't open list of JPEG files %s\n"), strListFile);
+        return MFX_ERR_NOT_FOUND;
+    }
+
+    for (msdk_string line; std::getline(list, line);) {
+        if (!line.empty() && line.back() == MSDK_CHAR('\r'))
+            line.pop_back();
+        if (line.empty())
+            continue;
+
+        Image image    = {};
+        image.FileName = line;
+        if (MFX_ERR_NONE != ReadImageInfo(image)) {
+            msdk_printf(
+                MSDK_STRING("WARNING: %s is skipped, it can't be opened or isn't a JPEG file\n"),
+                image.FileName.c_str());
+            continue;
+        }
+        m_nMaxWidth    = std::max(m_nMaxWidth, image.Width);
+        m_nMaxHeight   = std::max(m_nMaxHeight, image.Height);
+        m_nMaxFileSize = std::max(m_nMaxFileSize, image.Size);
+        m_Images.push_back(image);
+    }
+    if (m_Images.empty()) {
+        msdk_printf(MSDK_STRING("ERROR: no JPEG files in %s\n"), strListFile);
+        return MFX_ERR_NOT_FOUND;
+    }
+
+    std::stable_sort(m_Images.begin(), m_Images.end(), [](const Image& a, const Image& b) {
+        if (a.Sampling != b.Sampling)
+            return a.Sampling < b.Sampling;
+        if (a.Width != b.Width)
+            return a.Width < b.Width;
+        return a.Height < b.Height;
+    });
 
     m_bInited = true;
+    StartReading();
+
     return MFX_ERR_NONE;
 }
 
-#define CHECK_SET_EOS(pBitstream)                  \
-    if (feof(m_fSource)) {                         \
-        pBitstream->DataFlag |= MFX_BITSTREAM_EOS; \
+mfxStatus CJPEGBatchReader::ReadImageInfo(Image& image) {
+    FILE* f = NULL;
+    MSDK_FOPEN(f, image.FileName.c_str(), MSDK_STRING("rb"));
+    if (!f)
+        return MFX_ERR_NOT_FOUND;
+
+    std::unique_ptr<FILE, int (*)(FILE*)> file(f, fclose);
+    mfxI64 size = -1;
+    if (0 == MSDK_FSEEK64(f, 0, SEEK_END))
+        size = MSDK_FTELL64(f);
+    if (size <= 0 || size > 0xFFFFFFFF || 0 != MSDK_FSEEK64(f, 0, SEEK_SET))
+        return MFX_ERR_UNSUPPORTED;
+    image.Size = (mfxU32)size;
+
+    mfxU8 hdr[8] = {};
+    if (2 != fread(hdr, 1, 2, f) || hdr[0] != 0xFF || hdr[1] != 0xD8)
+        return MFX_ERR_UNSUPPORTED;
+
+    for (;;) {
+        int marker = fgetc(f);
+        if (marker != 0xFF)
+            return MFX_ERR_UNSUPPORTED;
+        while (marker == 0xFF) // fill bytes
+            marker = fgetc(f);
+        if (marker == EOF)
+            return MFX_ERR_UNSUPPORTED;
+        // standalone markers are followed by the next one, the others by the segment length
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+            continue;
+        if (2 != fread(hdr, 1, 2, f))
+            return MFX_ERR_UNSUPPORTED;
+        mfxU32 length = ((mfxU32)hdr[0] << 8) | hdr[1];
+        if (length < 2)
+            return MFX_ERR_UNSUPPORTED;
+
+        // SOF0..SOF15 except DHT, JPG and DAC
+        bool bFrameHeader = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                            marker != 0xC8 && marker != 0xCC;
+        if (bFrameHeader) {
+            // precision, height, width and number of components
+            if (length < 8 || 6 != fread(hdr, 1, 6, f))
+                return MFX_ERR_UNSUPPORTED;
+            image.Height       = (mfxU16)(((mfxU32)hdr[1] << 8) | hdr[2]);
+            image.Width        = (mfxU16)(((mfxU32)hdr[3] << 8) | hdr[4]);
+            mfxU32 nComponents = hdr[5];
+            image.Sampling     = nComponents << 24;
+            // component id, sampling factors and quantization table of up to 3 components
+            for (mfxU32 i = 0; i < nComponents && i < 3; i++) {
+                if (3 != fread(hdr, 1, 3, f))
+                    return MFX_ERR_UNSUPPORTED;
+                image.Sampling |= (mfxU32)hdr[1] << (16 - 8 * i);
+            }
+            return (image.Width && image.Height) ? MFX_ERR_NONE : MFX_ERR_UNSUPPORTED;
+        }
+        if (marker == 0xD9 || marker == 0xDA) // no frame header before the image data
+            return MFX_ERR_UNSUPPORTED;
+        if (0 != MSDK_FSEEK64(f, length - 2, SEEK_CUR))
+            return MFX_ERR_UNSUPPORTED;
     }
+}
 
-mfxStatus CSmplBitstreamReader::ReadNextFrame(mfxBitstream* pBS) {
+mfxStatus CJPEGBatchReader::ReadImage(const Image& image, std::vector<mfxU8>& data) {
+    FILE* f = NULL;
+    MSDK_FOPEN(f, image.FileName.c_str(), MSDK_STRING("rb"));
+    if (!f)
+        return MFX_ERR_NOT_FOUND;
+
+    data.resize(image.Size);
+    size_t nBytesRead = fread(data.data(), 1, data.size(), f);
+    fclose(f);
+    return (nBytesRead == data.size()) ? MFX_ERR_NONE : MFX_ERR_MORE_DATA;
+}
+
+mfxStatus CJPEGBatchReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
     if (!m_bInited)
         return MFX_ERR_NOT_INITIALIZED;
 
     MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
 
-    // Not enough memory to read new chunk of data
-    if (pBS->MaxLength == pBS->DataLength)
-        return MFX_ERR_NOT_ENOUGH_BUFFER;
-
     memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
     pBS->DataOffset = 0;
-    mfxU32 nBytesRead =
-        (mfxU32)fread(pBS->Data + pBS->DataLength, 1, pBS->MaxLength - pBS->DataLength, m_fSource);
+    pBS->DataFlag   = MFX_BITSTREAM_COMPLETE_FRAME;
 
-    CHECK_SET_EOS(pBS);
+    std::vector<mfxU8> data;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cvReady.wait(lock, [this] { return !m_ReadyImages.empty() || m_bEndOfBatch; });
+        if (m_ReadyImages.empty()) {
+            pBS->DataFlag |= MFX_BITSTREAM_EOS;
+            return MFX_ERR_MORE_DATA;
+        }
+        if (m_ReadyImages.front().size() > pBS->MaxLength - pBS->DataLength)
+            return MFX_ERR_NOT_ENOUGH_BUFFER;
 
-    if (0 == nBytesRead) {
-        return MFX_ERR_MORE_DATA;
+        data = std::move(m_ReadyImages.front());
+        m_ReadyImages.pop_front();
+        m_cvFree.notify_one();
     }
 
-    pBS->DataLength += nBytesRead;
+    memcpy(pBS->Data + pBS->DataLength, data.data(), data.size());
+    pBS->DataLength += (mfxU32)data.size();
 
     return MFX_ERR_NONE;
 }
 
-mfxU32 CJPEGFrameReader::FindMarker(mfxBitstream* pBS,
-                                    mfxU32 startOffset,
-                                    CJPEGFrameReader::JPEGMarker marker) {
-    for (mfxU32 i = startOffset; i + sizeof(mfxU16) <= pBS->DataLength; i++) {
-        if (*(mfxU16*)(pBS->Data + i) == (mfxU16)marker) {
-            return i;
+void CJPEGBatchReader::StartReading() {
+    m_bStop       = false;
+    m_bEndOfBatch = false;
+    m_nNextImage  = 0;
+    m_thread      = std::thread(&CJPEGBatchReader::ReaderRoutine, this);
+}
+
+void CJPEGBatchReader::StopReading() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
         }
+        m_cvFree.notify_one();
+        m_thread.join();
     }
-    return 0xFFFFFFFF;
+
+    // prefetched images are dropped
+    m_ReadyImages.clear();
 }
 
-mfxStatus CJPEGFrameReader::ReadNextFrame(mfxBitstream* pBS) {
-    mfxStatus sts    = MFX_ERR_NONE;
-    mfxU32 offsetSOI = 0xFFFFFFFF;
+void CJPEGBatchReader::ReaderRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_nNextImage < m_Images.size()) {
+        m_cvFree.wait(lock, [this] { return m_bStop || m_ReadyImages.size() < m_nPrefetch; });
+        if (m_bStop)
+            break;
 
-    pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
+        const Image& image = m_Images[m_nNextImage++];
+        lock.unlock();
 
-    while ((offsetSOI = FindMarker(pBS, pBS->DataOffset, CJPEGFrameReader::SOI)) == 0xFFFFFFFF &&
-           sts == MFX_ERR_NONE) {
-        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
-    }
+        std::vector<mfxU8> data;
+        mfxStatus sts = ReadImage(image, data);
+        if (MFX_ERR_NONE != sts)
+            msdk_printf(MSDK_STRING("WARNING: %s is skipped, it can't be read\n"),
+                        image.FileName.c_str());
 
-    //--- Finding EOI of frame, to make sure that it is complete
-    while (FindMarker(pBS, offsetSOI, CJPEGFrameReader::EOI) == 0xFFFFFFFF && sts == MFX_ERR_NONE) {
-        sts = CSmplBitstreamReader::ReadNextFrame(pBS);
+        lock.lock();
+        if (MFX_ERR_NONE == sts) {
+            m_ReadyImages.push_back(std::move(data));
+            m_cvReady.notify_one();
+        }
     }
-
-    return sts;
-}
+    m_bEndOfBatch = true;
+    m_cvReady.notify_one();
+} // void CJPEGBatchReader::ReaderRoutine()
 
 CIVFFrameReader::CIVFFrameReader() {
     MSDK_ZERO_MEMORY(m_hdr);
@@ -769,13 +2046,21 @@ mfxStatus CIVFFrameReader::ReadHeader() {
     READ_BYTES(&m_hdr.time_scale, sizeof(m_hdr.time_scale));
     READ_BYTES(&m_hdr.num_frames, sizeof(m_hdr.num_frames));
     READ_BYTES(&m_hdr.unused, sizeof(m_hdr.unused));
+    if (m_bStream) {
+        // streams can't seek, the rest of a longer header is read out
+        for (mfxU32 i = 32; i < m_hdr.header_len; i++)
+            MSDK_CHECK_NOT_EQUAL(fgetc(m_fSource), EOF, MFX_ERR_UNSUPPORTED);
+        return MFX_ERR_NONE;
+    }
     MSDK_CHECK_NOT_EQUAL(fseek(m_fSource, m_hdr.header_len, SEEK_SET), 0, MFX_ERR_UNSUPPORTED);
     return MFX_ERR_NONE;
 }
 
 void CIVFFrameReader::Reset() {
     CSmplBitstreamReader::Reset();
-    std::ignore = ReadHeader();
+    // the header is skipped unless the range begins after it
+    if (!m_nRangeBegin && !m_bStream)
+        std::ignore = ReadHeader();
 }
 
 mfxStatus CIVFFrameReader::Init(const msdk_char* strFileName) {
@@ -798,12 +2083,18 @@ mfxStatus CIVFFrameReader::Init(const msdk_char* strFileName) {
 
 // reads a complete frame into given bitstream
 mfxStatus CIVFFrameReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
     MSDK_CHECK_POINTER(pBS, MFX_ERR_NULL_PTR);
 
     memmove(pBS->Data, pBS->Data + pBS->DataOffset, pBS->DataLength);
     pBS->DataOffset = 0;
     pBS->DataFlag   = MFX_BITSTREAM_COMPLETE_FRAME;
 
+    if (m_nRangeEnd && MSDK_FTELL64(m_fSource) >= (mfxI64)m_nRangeEnd) {
+        pBS->DataFlag |= MFX_BITSTREAM_EOS;
+        return MFX_ERR_MORE_DATA;
+    }
+
     /*bytes pos-(pos+3)                       size of frame in bytes (not including the 12-byte header)
       bytes (pos+4)-(pos+11)                  64-bit presentation timestamp
       bytes (pos+12)-(pos+12+nBytesInFrame)   frame data
@@ -858,13 +2149,17 @@ mfxStatus CIVFFrameWriter::WriteFrameHeader() {
 }
 
 void CIVFFrameWriter::UpdateNumberOfFrames() {
-    if (m_fSource) {
+    // the header already sent to a stream keeps 0 frames, which means unknown
+    if (m_fSource && !msdk_is_stream(m_sFile.c_str())) {
         fseek(m_fSource, 24, SEEK_SET);
         fwrite(&m_frameNum, 1, sizeof(mfxU32), m_fSource);
     }
 }
 
 mfxStatus CIVFFrameWriter::Reset() {
+    if (m_bInited && msdk_is_stream(m_sFile.c_str()))
+        return MFX_ERR_NONE;
+
     mfxStatus sts = CSmplBitstreamWriter::Reset();
     MSDK_CHECK_STATUS(sts, "CSmplBitstreamWriter::Reset() failed");
     sts = WriteStreamHeader();
@@ -897,6 +2192,7 @@ mfxStatus CIVFFrameWriter::Init(const msdk_char* strFileName,
 
 // write a complete frame into given bitstream
 mfxStatus CIVFFrameWriter::WriteNextFrame(mfxBitstream* pMfxBitstream, bool isPrint) {
+    MFX_ITT_TASK("WriteNextFrame");
     MSDK_CHECK_ERROR(m_fSource, NULL, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pMfxBitstream, MFX_ERR_NULL_PTR);
 
@@ -920,6 +2216,44 @@ void CIVFFrameWriter::Close() {
     CSmplBitstreamWriter::Close();
 }
 
+namespace {
+#ifdef MSDK_STREAMING_LOADS
+bool IsStreamingLoadSupported() {
+    #if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+    #else
+    return __builtin_cpu_supports("sse4.1");
+    #endif
+}
+
+// MOVNTDQA reads write-combined memory a cache line at a time instead of a word per bus
+// transaction, the loads need 16 byte aligned source, the rest of the row is copied as is
+MSDK_TARGET_SSE41 void StreamingLoadCopy(mfxU8* pDst, const mfxU8* pSrc, size_t size) {
+    size_t head = (16 - ((uintptr_t)pSrc & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(pDst, pSrc, head);
+
+    size_t j = head;
+    for (; j + 64 <= size; j += 64) {
+        __m128i x0 = _mm_stream_load_si128((__m128i*)(pSrc + j));
+        __m128i x1 = _mm_stream_load_si128((__m128i*)(pSrc + j + 16));
+        __m128i x2 = _mm_stream_load_si128((__m128i*)(pSrc + j + 32));
+        __m128i x3 = _mm_stream_load_si128((__m128i*)(pSrc + j + 48));
+        _mm_storeu_si128((__m128i*)(pDst + j), x0);
+        _mm_storeu_si128((__m128i*)(pDst + j + 16), x1);
+        _mm_storeu_si128((__m128i*)(pDst + j + 32), x2);
+        _mm_storeu_si128((__m128i*)(pDst + j + 48), x3);
+    }
+    for (; j + 16 <= size; j += 16)
+        _mm_storeu_si128((__m128i*)(pDst + j), _mm_stream_load_si128((__m128i*)(pSrc + j)));
+    memcpy(pDst + j, pSrc + j, size - j);
+}
+#endif
+} // namespace
+
 CSmplYUVWriter::CSmplYUVWriter()
         : m_fDest(NULL),
           m_fDestMVC(NULL),
@@ -927,7 +2261,20 @@ CSmplYUVWriter::CSmplYUVWriter()
           m_bIsMultiView(false),
           m_numCreatedFiles(0),
           m_sFile(),
-          m_nViews(0){};
+          m_nViews(0),
+          m_Staging(),
+          m_nStaged(0),
+          m_bStreamingLoads(false),
+          m_Row(){};
+
+void CSmplYUVWriter::SetStreamingLoads(bool bStreamingLoads) {
+#ifdef MSDK_STREAMING_LOADS
+    static const bool bSupported = IsStreamingLoadSupported();
+    m_bStreamingLoads            = bStreamingLoads && bSupported;
+#else
+    (void)bStreamingLoads;
+#endif
+}
 
 mfxStatus CSmplYUVWriter::Init(const msdk_char* strFileName, const mfxU32 numViews) {
     MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
@@ -941,7 +2288,10 @@ mfxStatus CSmplYUVWriter::Init(const msdk_char* strFileName, const mfxU32 numVie
     //open file to write decoded data
 
     if (!m_bIsMultiView) {
-        MSDK_FOPEN(m_fDest, m_sFile.c_str(), MSDK_STRING("wb"));
+        if (msdk_is_stream(strFileName))
+            m_fDest = msdk_stream_open(strFileName, true);
+        else
+            MSDK_FOPEN(m_fDest, m_sFile.c_str(), MSDK_STRING("wb"));
         MSDK_CHECK_POINTER(m_fDest, MFX_ERR_NULL_PTR);
         ++m_numCreatedFiles;
     }
@@ -966,7 +2316,7 @@ mfxStatus CSmplYUVWriter::Init(const msdk_char* strFileName, const mfxU32 numVie
 }
 
 mfxStatus CSmplYUVWriter::Reset() {
-    if (!m_bInited)
+    if (!m_bInited || (!m_bIsMultiView && msdk_is_stream(m_sFile.c_str())))
         return MFX_ERR_NONE;
 
     return Init(m_sFile.c_str(), m_nViews);
@@ -978,7 +2328,7 @@ CSmplYUVWriter::~CSmplYUVWriter() {
 
 void CSmplYUVWriter::Close() {
     if (m_fDest) {
-        fclose(m_fDest);
+        msdk_stream_close(m_fDest);
         m_fDest = NULL;
     }
 
@@ -1058,20 +2408,88 @@ mfxStatus GetChromaSize(const mfxFrameInfo& pInfo, mfxU32& ChromaW, mfxU32& Chro
     return MFX_ERR_NONE;
 }
 
+void CSmplYUVWriter::StagePlane(const mfxU8* pSrc, mfxU32 pitch, mfxU32 rowBytes, mfxU32 rows) {
+    mfxU8* pDst = ReserveStaging((size_t)rowBytes * rows);
+#ifdef MSDK_STREAMING_LOADS
+    if (m_bStreamingLoads) {
+        for (mfxU32 i = 0; i < rows; i++, pSrc += pitch, pDst += rowBytes)
+            StreamingLoadCopy(pDst, pSrc, rowBytes);
+        return;
+    }
+#endif
+    for (mfxU32 i = 0; i < rows; i++, pSrc += pitch, pDst += rowBytes)
+        memcpy(pDst, pSrc, rowBytes);
+}
+
+const mfxU8* CSmplYUVWriter::FetchRow(const mfxU8* pSrc, size_t size) {
+#ifdef MSDK_STREAMING_LOADS
+    if (m_bStreamingLoads) {
+        if (m_Row.size() < size)
+            m_Row.resize(size);
+        StreamingLoadCopy(m_Row.data(), pSrc, size);
+        return m_Row.data();
+    }
+#endif
+    (void)size;
+    return pSrc;
+}
+
+void CSmplYUVWriter::StagePlaneShifted(const mfxU8* pSrc,
+                                       mfxU32 pitch,
+                                       mfxU32 rowSamples,
+                                       mfxU32 rows,
+                                       mfxU32 shift) {
+    mfxU16* pDst = (mfxU16*)ReserveStaging((size_t)rowSamples * rows * sizeof(mfxU16));
+    for (mfxU32 i = 0; i < rows; i++, pSrc += pitch, pDst += rowSamples) {
+        const mfxU16* pRow = (const mfxU16*)FetchRow(pSrc, (size_t)rowSamples * sizeof(mfxU16));
+        ShiftSamplesRight(pDst, pRow, rowSamples, shift);
+    }
+}
+
+void CSmplYUVWriter::StagePlaneDeinterleaved(const mfxU8* pSrc,
+                                             mfxU32 pitch,
+                                             mfxU32 rowSamples,
+                                             mfxU32 rows) {
+    mfxU8* pDst = ReserveStaging((size_t)rowSamples * rows);
+    for (mfxU32 i = 0; i < rows; i++, pSrc += pitch, pDst += rowSamples) {
+        const mfxU8* pRow = rowSamples ? FetchRow(pSrc, (size_t)rowSamples * 2 - 1) : pSrc;
+        for (mfxU32 j = 0; j < rowSamples; j++)
+            pDst[j] = pRow[2 * j];
+    }
+}
+
+mfxU8* CSmplYUVWriter::ReserveStaging(size_t size) {
+    // buffer keeps its size between frames, so it is zero-filled only once
+    if (m_Staging.size() < m_nStaged + size)
+        m_Staging.resize(m_nStaged + size);
+
+    mfxU8* pDst = m_Staging.data() + m_nStaged;
+    m_nStaged += size;
+    return pDst;
+}
+
+mfxStatus CSmplYUVWriter::WriteStaged(FILE* dstFile) {
+    size_t nStaged = m_nStaged;
+    m_nStaged      = 0;
+
+    MSDK_CHECK_NOT_EQUAL(fwrite(m_Staging.data(), 1, nStaged, dstFile),
+                         nStaged,
+                         MFX_ERR_UNDEFINED_BEHAVIOR);
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
+    MFX_ITT_TASK("WriteNextFrame");
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
 
     mfxFrameInfo& pInfo = pSurface->Info;
     mfxFrameData& pData = pSurface->Data;
 
-    mfxU32 i;
     mfxU32 vid = pInfo.FrameId.ViewId;
 
     mfxU32 shiftSizeLuma   = 16 - pInfo.BitDepthLuma;
     mfxU32 shiftSizeChroma = 16 - pInfo.BitDepthChroma;
-    // Temporary buffer to convert MS to no-MS format
-    std::vector<mfxU16> tmp;
 
     if (!m_bIsMultiView) {
         MSDK_CHECK_POINTER(m_fDest, MFX_ERR_NULL_PTR);
@@ -1087,127 +2505,83 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
     if (MFX_ERR_NONE != GetChromaSize(pInfo, ChromaW, ChromaH))
         return MFX_ERR_UNSUPPORTED;
 
+    // whole frame is converted into the staging buffer and written at once
+    m_nStaged = 0;
+
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12:
         case MFX_FOURCC_NV12:
         case MFX_FOURCC_I420:
         case MFX_FOURCC_I422:
         case MFX_FOURCC_NV16:
-            for (i = 0; i < pInfo.CropH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                           1,
-                           pInfo.CropW,
-                           dstFile),
-                    pInfo.CropW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX),
+                       pData.Pitch,
+                       pInfo.CropW,
+                       pInfo.CropH);
             break;
         case MFX_FOURCC_Y210:
         case MFX_FOURCC_Y216: // Luma and chroma will be filled below
         {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU8* pBuffer = ((mfxU8*)pData.Y) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4) +
-                                 i * pData.Pitch;
-                if (pInfo.Shift) {
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pInfo.CropW * 2);
-
-                    for (int idx = 0; idx < pInfo.CropW * 2; idx++) {
-                        tmp[idx] = ((mfxU16*)pBuffer)[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(((const mfxU8*)tmp.data()), 4, pInfo.CropW, dstFile),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(pBuffer, 4, pInfo.CropW, dstFile),
-                                         pInfo.CropW,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = ((mfxU8*)pData.Y) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4);
+            if (pInfo.Shift) {
+                // Bits will be shifted to the lower position
+                StagePlaneShifted(pBuffer,
+                                  pData.Pitch,
+                                  (mfxU32)pInfo.CropW * 2,
+                                  pInfo.CropH,
+                                  shiftSizeLuma);
             }
-            return MFX_ERR_NONE;
+            else {
+                StagePlane(pBuffer, pData.Pitch, (mfxU32)pInfo.CropW * 4, pInfo.CropH);
+            }
+            return WriteStaged(dstFile);
         } break;
         case MFX_FOURCC_Y410: // Luma and chroma will be filled below
         {
             mfxU8* pBuffer = (mfxU8*)pData.Y410;
-            for (i = 0; i < pInfo.CropH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(
-                        pBuffer + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4) + i * pData.Pitch,
-                        4,
-                        pInfo.CropW,
-                        dstFile),
-                    pInfo.CropW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            return MFX_ERR_NONE;
+            StagePlane(pBuffer + (pInfo.CropY * pData.Pitch + pInfo.CropX * 4),
+                       pData.Pitch,
+                       (mfxU32)pInfo.CropW * 4,
+                       pInfo.CropH);
+            return WriteStaged(dstFile);
         } break;
 #if (MFX_VERSION >= MFX_VERSION_NEXT)
         case MFX_FOURCC_Y416: // Luma and chroma will be filled below
         {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU8* pBuffer = ((mfxU8*)pData.U) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 8) +
-                                 i * pData.Pitch;
-                if (pInfo.Shift) {
-                    tmp.resize(pInfo.CropW * 4);
-
-                    for (int idx = 0; idx < pInfo.CropW * 4; idx++) {
-                        tmp[idx] = ((mfxU16*)pBuffer)[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(((const mfxU8*)tmp.data()), 8, pInfo.CropW, dstFile),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(pBuffer, 8, pInfo.CropW, dstFile),
-                                         pInfo.CropW,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = ((mfxU8*)pData.U) + (pInfo.CropY * pData.Pitch + pInfo.CropX * 8);
+            if (pInfo.Shift) {
+                StagePlaneShifted(pBuffer,
+                                  pData.Pitch,
+                                  (mfxU32)pInfo.CropW * 4,
+                                  pInfo.CropH,
+                                  shiftSizeLuma);
             }
-            return MFX_ERR_NONE;
+            else {
+                StagePlane(pBuffer, pData.Pitch, (mfxU32)pInfo.CropW * 8, pInfo.CropH);
+            }
+            return WriteStaged(dstFile);
         } break;
 #endif
         case MFX_FOURCC_I010:
         case MFX_FOURCC_I210:
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU16* shortPtr = (mfxU16*)(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) +
-                                             i * pData.Pitch);
-                MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                     (mfxU32)pInfo.CropW * 2,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX),
+                       pData.Pitch,
+                       (mfxU32)pInfo.CropW * 2,
+                       pInfo.CropH);
             break;
         case MFX_FOURCC_P010:
 #if (MFX_VERSION >= MFX_VERSION_NEXT)
         case MFX_FOURCC_P016:
 #endif
         case MFX_FOURCC_P210: {
-            for (i = 0; i < pInfo.CropH; i++) {
-                mfxU16* shortPtr = (mfxU16*)(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) +
-                                             i * pData.Pitch);
-                if (pInfo.Shift) {
-                    // Convert MS-P*1* to P*1* and write
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pData.Pitch);
-
-                    for (int idx = 0; idx < pInfo.CropW; idx++) {
-                        tmp[idx] = shortPtr[idx] >> shiftSizeLuma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(fwrite(&tmp[0], 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                         (mfxU32)pInfo.CropW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, (mfxU32)pInfo.CropW * 2, dstFile),
-                                         (mfxU32)pInfo.CropW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX);
+            if (pInfo.Shift) {
+                // Convert MS-P*1* to P*1* and write
+                // Bits will be shifted to the lower position
+                StagePlaneShifted(pBuffer, pData.Pitch, pInfo.CropW, pInfo.CropH, shiftSizeLuma);
+            }
+            else {
+                StagePlane(pBuffer, pData.Pitch, (mfxU32)pInfo.CropW * 2, pInfo.CropH);
             }
 
             break;
@@ -1224,75 +2598,40 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
     }
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch,
+                       ChromaW,
+                       ChromaH);
+            StagePlane(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch / 2,
+                       ChromaW,
+                       ChromaH);
             break;
         }
         case MFX_FOURCC_I420:
         case MFX_FOURCC_I422: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                               i * pData.Pitch / 2,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch / 2,
+                       ChromaW,
+                       ChromaH);
+            StagePlane(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch / 2,
+                       ChromaW,
+                       ChromaH);
             break;
         }
         case MFX_FOURCC_NV12: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                           1,
-                           ChromaW,
-                           dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX),
+                       pData.Pitch,
+                       ChromaW,
+                       ChromaH);
             break;
         }
         case MFX_FOURCC_NV16: {
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(
-                    fwrite(
-                        pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) + i * pData.Pitch,
-                        1,
-                        ChromaW,
-                        dstFile),
-                    ChromaW,
-                    MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX),
+                       pData.Pitch,
+                       ChromaW,
+                       ChromaH);
             break;
         }
         case MFX_FOURCC_I010:
@@ -1300,19 +2639,8 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
             mfxU16 chPitch = pData.Pitch / 2;
             mfxU32 basePtr = (pInfo.CropY * chPitch + pInfo.CropX / 2);
 
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(pData.U + basePtr + i * chPitch, 1, ChromaW, dstFile),
-                                     ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-
-            basePtr = (pInfo.CropY * chPitch + pInfo.CropX / 2);
-
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(pData.V + basePtr + i * chPitch, 1, ChromaW, dstFile),
-                                     ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
+            StagePlane(pData.U + basePtr, chPitch, ChromaW, ChromaH);
+            StagePlane(pData.V + basePtr, chPitch, ChromaW, ChromaH);
             break;
         }
         case MFX_FOURCC_P010:
@@ -1320,28 +2648,14 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
         case MFX_FOURCC_P016:
 #endif
         case MFX_FOURCC_P210: {
-            for (i = 0; i < ChromaH; i++) {
-                mfxU16* shortPtr =
-                    (mfxU16*)(pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX * 2) +
-                              i * pData.Pitch);
-                if (pInfo.Shift) {
-                    // Convert MS-P*1* to P*1* and write
-                    // Bits will be shifted to the lower position
-                    tmp.resize(pData.Pitch);
-
-                    for (mfxU32 idx = 0; idx < ChromaW; idx++) {
-                        tmp[idx] = shortPtr[idx] >> shiftSizeChroma;
-                    }
-
-                    MSDK_CHECK_NOT_EQUAL(fwrite(&tmp[0], 1, ChromaW * 2, dstFile),
-                                         (mfxU32)ChromaW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(fwrite(shortPtr, 1, ChromaW * 2, dstFile),
-                                         ChromaW * 2,
-                                         MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
+            mfxU8* pBuffer = pData.UV + (pInfo.CropY * pData.Pitch + pInfo.CropX * 2);
+            if (pInfo.Shift) {
+                // Convert MS-P*1* to P*1* and write
+                // Bits will be shifted to the lower position
+                StagePlaneShifted(pBuffer, pData.Pitch, ChromaW, ChromaH, shiftSizeChroma);
+            }
+            else {
+                StagePlane(pBuffer, pData.Pitch, ChromaW * 2, ChromaH);
             }
             break;
         }
@@ -1354,12 +2668,7 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
             ptr = std::min({ pData.R, pData.G, pData.B });
             ptr = ptr + pInfo.CropX + pInfo.CropY * pData.Pitch;
 
-            for (i = 0; i < ChromaH; i++) {
-                MSDK_CHECK_NOT_EQUAL(fwrite(ptr + i * pData.Pitch, 1, 4 * ChromaW, dstFile),
-                                     4 * ChromaW,
-                                     MFX_ERR_UNDEFINED_BEHAVIOR);
-            }
-            fflush(dstFile);
+            StagePlane(ptr, pData.Pitch, 4 * ChromaW, ChromaH);
             break;
         }
 
@@ -1367,17 +2676,17 @@ mfxStatus CSmplYUVWriter::WriteNextFrame(mfxFrameSurface1* pSurface) {
             return MFX_ERR_UNSUPPORTED;
     }
 
-    return MFX_ERR_NONE;
+    return WriteStaged(dstFile);
 }
 
 mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
+    MFX_ITT_TASK("WriteNextFrame");
     MSDK_CHECK_ERROR(m_bInited, false, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
 
     mfxFrameInfo& pInfo = pSurface->Info;
     mfxFrameData& pData = pSurface->Data;
 
-    mfxU32 i, j;
     mfxU32 vid = pInfo.FrameId.ViewId;
 
     if (!m_bIsMultiView) {
@@ -1388,36 +2697,22 @@ mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
         MSDK_CHECK_POINTER(m_fDestMVC[vid], MFX_ERR_NULL_PTR);
     }
 
+    FILE* dstFile = m_bIsMultiView ? m_fDestMVC[vid] : m_fDest;
+
     mfxU32 ChromaW, ChromaH;
     if (MFX_ERR_NONE != GetChromaSize(pInfo, ChromaW, ChromaH))
         return MFX_ERR_UNSUPPORTED;
 
+    m_nStaged = 0;
+
     // Write Y
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12:
         case MFX_FOURCC_NV12: {
-            for (i = 0; i < pInfo.CropH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(
-                            pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                            1,
-                            pInfo.CropW,
-                            m_fDest),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(
-                            pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX) + i * pData.Pitch,
-                            1,
-                            pInfo.CropW,
-                            m_fDestMVC[vid]),
-                        pInfo.CropW,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
+            StagePlane(pData.Y + (pInfo.CropY * pData.Pitch + pInfo.CropX),
+                       pData.Pitch,
+                       pInfo.CropW,
+                       pInfo.CropH);
             break;
         }
         default: {
@@ -1429,101 +2724,21 @@ mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
     // Write U and V
     switch (pInfo.FourCC) {
         case MFX_FOURCC_YV12: {
-            for (i = 0; i < ChromaH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDest),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDestMVC[vid]),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
-            for (i = 0; i < ChromaH; i++) {
-                if (!m_bIsMultiView) {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDest),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-                else {
-                    MSDK_CHECK_NOT_EQUAL(
-                        fwrite(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2) +
-                                   i * pData.Pitch / 2,
-                               1,
-                               ChromaW,
-                               m_fDestMVC[vid]),
-                        (mfxU32)pInfo.CropW / 2,
-                        MFX_ERR_UNDEFINED_BEHAVIOR);
-                }
-            }
+            StagePlane(pData.U + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch / 2,
+                       ChromaW,
+                       ChromaH);
+            StagePlane(pData.V + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX / 2),
+                       pData.Pitch / 2,
+                       ChromaW,
+                       ChromaH);
             break;
         }
         case MFX_FOURCC_NV12: {
-            for (i = 0; i < ChromaH; i++) {
-                for (j = 0; j < ChromaW; j += 2) {
-                    if (!m_bIsMultiView) {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDest),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                    else {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDestMVC[vid]),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                }
-            }
-            for (i = 0; i < ChromaH; i++) {
-                for (j = 1; j < ChromaW; j += 2) {
-                    if (!m_bIsMultiView) {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDest),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                    else {
-                        MSDK_CHECK_NOT_EQUAL(
-                            fwrite(pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX) +
-                                       i * pData.Pitch + j,
-                                   1,
-                                   1,
-                                   m_fDestMVC[vid]),
-                            1,
-                            MFX_ERR_UNDEFINED_BEHAVIOR);
-                    }
-                }
-            }
+            // even bytes of interleaved chroma are U, odd ones are V
+            mfxU8* pBuffer = pData.UV + (pInfo.CropY * pData.Pitch / 2 + pInfo.CropX);
+            StagePlaneDeinterleaved(pBuffer, pData.Pitch, (ChromaW + 1) / 2, ChromaH);
+            StagePlaneDeinterleaved(pBuffer + 1, pData.Pitch, ChromaW / 2, ChromaH);
             break;
         }
         default: {
@@ -1532,9 +2747,95 @@ mfxStatus CSmplYUVWriter::WriteNextFrameI420(mfxFrameSurface1* pSurface) {
         }
     }
 
+    return WriteStaged(dstFile);
+}
+
+CAsyncYUVWriter::CAsyncYUVWriter(mfxU32 nBuffers)
+        : CSmplYUVWriter(),
+          m_FreeBuffers(nBuffers ? nBuffers : 1),
+          m_ReadyFrames(),
+          m_mutex(),
+          m_cvFree(),
+          m_cvReady(),
+          m_thread(),
+          m_bStop(false),
+          m_WriteSts(MFX_ERR_NONE) {}
+
+CAsyncYUVWriter::~CAsyncYUVWriter() {
+    Close();
+}
+
+void CAsyncYUVWriter::Close() {
+    StopWriting();
+    CSmplYUVWriter::Close();
+}
+
+mfxStatus CAsyncYUVWriter::Init(const msdk_char* strFileName, const mfxU32 numViews) {
+    mfxStatus sts = CSmplYUVWriter::Init(strFileName, numViews);
+    MSDK_CHECK_STATUS(sts, "CSmplYUVWriter::Init failed");
+
+    StartWriting();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CAsyncYUVWriter::WriteStaged(FILE* dstFile) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cvFree.wait(lock, [this] { return !m_FreeBuffers.empty(); });
+    MSDK_CHECK_STATUS(m_WriteSts, "writing of a frame failed");
+
+    // staging buffer is handed over to the writer, a free one is staged next
+    StagedFrame frame = { dstFile, std::move(m_Staging), m_nStaged };
+    m_Staging         = std::move(m_FreeBuffers.back());
+    m_FreeBuffers.pop_back();
+    m_nStaged = 0;
+
+    m_ReadyFrames.push_back(std::move(frame));
+    m_cvReady.notify_one();
+
     return MFX_ERR_NONE;
 }
 
+void CAsyncYUVWriter::StartWriting() {
+    m_bStop    = false;
+    m_WriteSts = MFX_ERR_NONE;
+    m_thread   = std::thread(&CAsyncYUVWriter::WriterRoutine, this);
+}
+
+void CAsyncYUVWriter::StopWriting() {
+    if (!m_thread.joinable())
+        return;
+
+    // staged frames are written before the files are closed
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvReady.notify_one();
+    m_thread.join();
+}
+
+void CAsyncYUVWriter::WriterRoutine() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvReady.wait(lock, [this] { return m_bStop || !m_ReadyFrames.empty(); });
+        if (m_ReadyFrames.empty())
+            break;
+
+        StagedFrame frame = std::move(m_ReadyFrames.front());
+        m_ReadyFrames.pop_front();
+        lock.unlock();
+
+        bool bWritten = frame.Size == fwrite(frame.Data.data(), 1, frame.Size, frame.pFile);
+
+        lock.lock();
+        if (!bWritten)
+            m_WriteSts = MFX_ERR_UNDEFINED_BEHAVIOR;
+        m_FreeBuffers.push_back(std::move(frame.Data));
+        m_cvFree.notify_one();
+    }
+} // void CAsyncYUVWriter::WriterRoutine()
+
 void QPFile::Reader::ResetState() {
     ResetState(READER_ERR_NOT_INITIALIZED);
 }
@@ -1704,6 +3005,7 @@ void FreeSurfacePool(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize) {
 }
 
 mfxU16 GetFreeSurface(mfxFrameSurface1* pSurfacesPool, mfxU16 nPoolSize) {
+    MFX_ITT_TASK("GetFreeSurface");
     mfxU32 SleepInterval = 10; // milliseconds
 
     mfxU16 idx = MSDK_INVALID_SURF_IDX;
@@ -2350,6 +3652,39 @@ mfxStatus msdk_opt_read(const msdk_char* string, mfxPriority& value) {
 
 mfxStatus msdk_opt_read(msdk_char* string, mfxPriority& value);
 
+mfxStatus msdk_parse_cpu_list(const msdk_char* string, std::vector<mfxU32>& cpus) {
+    cpus.clear();
+    if (!string)
+        return MFX_ERR_NULL_PTR;
+
+    const msdk_char* ptr = string;
+    while (*ptr && *ptr != '\n') {
+        msdk_char* stopCharacter;
+        mfxU32 first = (mfxU32)msdk_strtol(ptr, &stopCharacter, 10);
+        if (stopCharacter == ptr)
+            return MFX_ERR_UNKNOWN;
+
+        mfxU32 last = first;
+        ptr         = stopCharacter;
+        if (*ptr == '-') {
+            last = (mfxU32)msdk_strtol(++ptr, &stopCharacter, 10);
+            if (stopCharacter == ptr || last < first)
+                return MFX_ERR_UNKNOWN;
+            ptr = stopCharacter;
+        }
+
+        for (mfxU32 cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+
+        if (*ptr == ',')
+            ptr++;
+        else if (*ptr && *ptr != '\n')
+            return MFX_ERR_UNKNOWN;
+    }
+
+    return cpus.empty() ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+}
+
 bool IsDecodeCodecSupported(mfxU32 codecFormat) {
     switch (codecFormat) {
         case MFX_CODEC_MPEG2:
@@ -2568,8 +3903,12 @@ mfxI32 getMonitorType(msdk_char* str) {
     return MFX_MONITOR_MAXNUMBER;
 }
 
-CH264FrameReader::CH264FrameReader()
+CH264FrameReader::CH264FrameReader(bool bIndexFrames)
         : CSmplBitstreamReader(),
+          m_bIndexFrames(bIndexFrames),
+          m_Mapping(),
+          m_FrameOffsets(),
+          m_nFrame(0),
           m_processedBS(0),
           m_originalBS(),
           m_isEndOfStream(false),
@@ -2582,6 +3921,9 @@ CH264FrameReader::CH264FrameReader()
 CH264FrameReader::~CH264FrameReader() {}
 
 void CH264FrameReader::Close() {
+    m_Mapping.Unmap();
+    m_FrameOffsets.clear();
+    m_nFrame = 0;
     CSmplBitstreamReader::Close();
 
     if (NULL != m_plainBuffer) {
@@ -2598,12 +3940,20 @@ mfxStatus CH264FrameReader::Init(const msdk_char* strFileName) {
     if (sts != MFX_ERR_NONE)
         return sts;
 
+    if (m_bIndexFrames && m_bInited) {
+        sts = m_Mapping.Map(m_fSource);
+        MSDK_CHECK_STATUS(sts, "m_Mapping.Map failed");
+        sts = BuildFrameIndex();
+        MSDK_CHECK_STATUS(sts, "BuildFrameIndex failed");
+        return sts;
+    }
+
     m_isEndOfStream = false;
     m_processedBS   = NULL;
 
     m_originalBS.Extend(1024 * 1024);
 
-    m_pNALSplitter.reset(new ProtectedLibrary::AVC_Spl());
+    m_pNALSplitter.reset(CreateSplitter());
 
     m_frame           = 0;
     m_plainBuffer     = 0;
@@ -2612,9 +3962,86 @@ mfxStatus CH264FrameReader::Init(const msdk_char* strFileName) {
     return sts;
 }
 
+void CH264FrameReader::Reset() {
+    if (m_bIndexFrames)
+        m_nFrame = 0;
+    else
+        CSmplBitstreamReader::Reset();
+}
+
+mfxStatus CH264FrameReader::BuildFrameIndex() {
+    ProtectedLibrary::AVC_Spl splitter;
+    FrameSplitterInfo* frame = NULL;
+    mfxU8* pData             = m_Mapping.GetData();
+    size_t nSize             = m_Mapping.GetSize();
+
+    // splitter parses the mapping in place, files over 4 GB are fed in several parts
+    mfxBitstream bs   = {};
+    bs.Data           = pData;
+    bool bEndOfStream = false;
+
+    m_FrameOffsets.assign(1, 0);
+    m_nFrame = 0;
+
+    for (;;) {
+        mfxStatus sts = splitter.GetFrame(bEndOfStream ? NULL : &bs, &frame);
+        size_t nParsed = (size_t)(bs.Data - pData) + bs.DataOffset;
+
+        if (MFX_ERR_MORE_DATA == sts) {
+            if (bEndOfStream)
+                break;
+
+            // the rest of the file is parsed, the splitter flushes the last frame
+            bEndOfStream = nParsed + bs.DataLength == nSize;
+            if (!bEndOfStream) {
+                bs.Data       = pData + nParsed;
+                bs.DataOffset = 0;
+                bs.DataLength = (mfxU32)std::min<size_t>(nSize - nParsed,
+                                                         std::numeric_limits<mfxU32>::max());
+                bs.MaxLength  = bs.DataLength;
+            }
+            continue;
+        }
+        MSDK_CHECK_STATUS(sts, "AVC_Spl::GetFrame failed");
+
+        // the frame ends where the start code of the next frame's slice begins
+        size_t nEnd = nSize;
+        if (splitter.GetPendingNalUnitSize()) {
+            nEnd = nParsed - splitter.GetPendingNalUnitSize();
+            if (nEnd >= 3 && 1 == pData[nEnd - 1] && !pData[nEnd - 2] && !pData[nEnd - 3]) {
+                nEnd -= 3;
+                if (nEnd && !pData[nEnd - 1])
+                    nEnd--;
+            }
+        }
+        if (nEnd > m_FrameOffsets.back())
+            m_FrameOffsets.push_back(nEnd);
+
+        splitter.ResetCurrentState();
+    }
+
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
+    MFX_ITT_TASK("ReadNextFrame");
     mfxStatus sts = MFX_ERR_NONE;
     pBS->DataFlag = MFX_BITSTREAM_COMPLETE_FRAME;
+
+    if (m_bIndexFrames) {
+        if (!m_bInited)
+            return MFX_ERR_NOT_INITIALIZED;
+        if (m_nFrame + 1 >= m_FrameOffsets.size())
+            return MFX_ERR_MORE_DATA;
+
+        pBS->Data       = m_Mapping.GetData() + m_FrameOffsets[m_nFrame];
+        pBS->DataOffset = 0;
+        pBS->DataLength = (mfxU32)(m_FrameOffsets[m_nFrame + 1] - m_FrameOffsets[m_nFrame]);
+        pBS->MaxLength  = pBS->DataLength;
+        m_nFrame++;
+
+        return MFX_ERR_NONE;
+    }
     //read bit stream from source
     while (!m_originalBS.DataLength) {
         sts = CSmplBitstreamReader::ReadNextFrame(&m_originalBS);
@@ -2655,6 +4082,18 @@ mfxStatus CH264FrameReader::ReadNextFrame(mfxBitstream* pBS) {
     return sts;
 }
 
+AbstractSplitter* CH264FrameReader::CreateSplitter() {
+    return new ProtectedLibrary::AVC_Spl();
+}
+
+AbstractSplitter* CHEVCFrameReader::CreateSplitter() {
+    return new ProtectedLibrary::HEVC_Spl();
+}
+
+AbstractSplitter* CAV1FrameReader::CreateSplitter() {
+    return new ProtectedLibrary::AV1_Spl();
+}
+
 mfxStatus CH264FrameReader::PrepareNextFrame(mfxBitstream* in, mfxBitstream** out) {
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -0,0 +1,96 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "scene_change_detector.h"
+
+#include <algorithm>
+
+CSceneChangeDetector::CSceneChangeDetector()
+        : m_Histogram(),
+          m_nCurrent(0),
+          m_nSamples(0),
+          m_avgDistance(0),
+          m_minDistance(1),
+          m_threshold(0.3),
+          m_nFramesSinceChange(0),
+          m_nChanges(0) {}
+
+void CSceneChangeDetector::Init(mfxU32 minDistance, mfxF64 threshold) {
+    m_minDistance = minDistance;
+    m_threshold   = threshold;
+    Reset();
+}
+
+void CSceneChangeDetector::Reset() {
+    m_nSamples           = 0;
+    m_avgDistance        = 0;
+    m_nFramesSinceChange = 0;
+    m_nChanges           = 0;
+}
+
+bool CSceneChangeDetector::IsSupported(mfxU32 fourCC) {
+    switch (fourCC) {
+        case MFX_FOURCC_NV12:
+        case MFX_FOURCC_NV16:
+        case MFX_FOURCC_YV12:
+        case MFX_FOURCC_I420:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool CSceneChangeDetector::IsSceneChange(const mfxFrameSurface1& surface) {
+    const mfxFrameInfo& info = surface.Info;
+    const mfxFrameData& data = surface.Data;
+    if (!data.Y || !IsSupported(info.FourCC))
+        return false;
+
+    mfxU32 pitch  = ((mfxU32)data.PitchHigh << 16) | data.PitchLow;
+    mfxU32 width  = info.CropW ? info.CropW : info.Width;
+    mfxU32 height = info.CropH ? info.CropH : info.Height;
+
+    const mfxU32 start = GRID_STEP / 2;
+    mfxU32 cols        = width > start ? (width - start - 1) / GRID_STEP + 1 : 0;
+    mfxU32 rows        = height > start ? (height - start - 1) / GRID_STEP + 1 : 0;
+    mfxU32 nSamples    = cols * rows;
+
+    mfxU32 next  = m_nCurrent ^ 1;
+    mfxU32* hist = m_Histogram[next];
+    std::fill(hist, hist + NUM_BINS, 0);
+    for (mfxU32 y = start; y < height; y += GRID_STEP) {
+        const mfxU8* row = data.Y + (size_t)(info.CropY + y) * pitch + info.CropX;
+        for (mfxU32 x = start; x < width; x += GRID_STEP)
+            hist[row[x] / (256 / NUM_BINS)]++;
+    }
+
+    bool bChange = false;
+    m_nFramesSinceChange++;
+    // histograms of frames with different sizes aren't compared
+    if (nSamples && nSamples == m_nSamples) {
+        const mfxU32* prev = m_Histogram[m_nCurrent];
+        mfxU32 diff        = 0;
+        for (mfxU32 i = 0; i < NUM_BINS; i++)
+            diff += hist[i] > prev[i] ? hist[i] - prev[i] : prev[i] - hist[i];
+        // each moved sample is counted in two bins
+        mfxF64 distance = diff / (2.0 * nSamples);
+
+        bChange = distance > m_threshold && distance > AVG_FACTOR * m_avgDistance &&
+                  m_nFramesSinceChange >= m_minDistance;
+        if (bChange) {
+            m_nChanges++;
+            m_nFramesSinceChange = 0;
+            m_avgDistance        = 0;
+        }
+        else {
+            m_avgDistance += (distance - m_avgDistance) / AVG_PERIOD;
+        }
+    }
+
+    m_nCurrent = next;
+    m_nSamples = nSamples;
+    return bChange;
+}
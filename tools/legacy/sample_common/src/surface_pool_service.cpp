@@ -0,0 +1,268 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "surface_pool_service.h"
+
+CSurfacePoolService::CSurfacePoolService()
+        : m_pAllocator(NULL),
+          m_Pools(),
+          m_Consumers(),
+          m_mutex() {}
+
+CSurfacePoolService::~CSurfacePoolService() {
+    Close();
+}
+
+mfxStatus CSurfacePoolService::Init(MFXFrameAllocator* pAllocator) {
+    MSDK_CHECK_POINTER(pAllocator, MFX_ERR_NULL_PTR);
+
+    Close();
+    m_pAllocator = pAllocator;
+    return MFX_ERR_NONE;
+}
+
+void CSurfacePoolService::Close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (std::unique_ptr<sPool>& pPool : m_Pools) {
+        for (sFrame& frame : pPool->frames)
+            m_pAllocator->Free(m_pAllocator->pthis, &frame.response);
+    }
+    m_Pools.clear();
+    m_Consumers.clear();
+}
+
+bool CSurfacePoolService::IsSameFrames(const mfxFrameAllocRequest& l,
+                                       const mfxFrameAllocRequest& r) {
+    const mfxU16 memoryMask = MFX_MEMTYPE_SYSTEM_MEMORY | MFX_MEMTYPE_VIDEO_MEMORY_DECODER_TARGET |
+                              MFX_MEMTYPE_VIDEO_MEMORY_PROCESSOR_TARGET;
+
+    return l.Info.FourCC == r.Info.FourCC && l.Info.ChromaFormat == r.Info.ChromaFormat &&
+           l.Info.Width == r.Info.Width && l.Info.Height == r.Info.Height &&
+           l.Info.BitDepthLuma == r.Info.BitDepthLuma && l.Info.Shift == r.Info.Shift &&
+           (l.Type & memoryMask) == (r.Type & memoryMask);
+}
+
+mfxStatus CSurfacePoolService::RegisterConsumer(const mfxFrameAllocRequest& request,
+                                                mfxU16 quota,
+                                                mfxU32* pConsumerId) {
+    MSDK_CHECK_POINTER(pConsumerId, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(m_pAllocator, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_ERROR(quota, 0, MFX_ERR_INVALID_VIDEO_PARAM);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    mfxU32 poolIndex = 0;
+    for (; poolIndex < m_Pools.size(); poolIndex++) {
+        if (IsSameFrames(m_Pools[poolIndex]->request, request))
+            break;
+    }
+    if (poolIndex == m_Pools.size()) {
+        std::unique_ptr<sPool> pPool(new sPool());
+        pPool->request                   = request;
+        pPool->request.NumFrameMin       = 1;
+        pPool->request.NumFrameSuggested = 1;
+        pPool->maxFrames                 = 0;
+        pPool->peakFrames                = 0;
+        pPool->windowPeak                = 0;
+        pPool->windowAcquires            = 0;
+        pPool->allocatedFrames           = 0;
+        pPool->releasedFrames            = 0;
+        m_Pools.push_back(std::move(pPool));
+    }
+
+    sPool& pool = *m_Pools[poolIndex];
+    // frames serve all the components the consumers feed them to
+    pool.request.Type |= request.Type;
+    pool.maxFrames += quota;
+    while (pool.frames.size() < quota) {
+        mfxStatus sts = AddFrame(pool);
+        MSDK_CHECK_STATUS(sts, "AddFrame failed");
+    }
+
+    sConsumer consumer;
+    consumer.pool        = poolIndex;
+    consumer.quota       = quota;
+    consumer.reserved    = -1;
+    consumer.bRegistered = true;
+    m_Consumers.push_back(consumer);
+
+    *pConsumerId = (mfxU32)(m_Consumers.size() - 1);
+    return MFX_ERR_NONE;
+}
+
+void CSurfacePoolService::UnregisterConsumer(mfxU32 consumerId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (consumerId >= m_Consumers.size() || !m_Consumers[consumerId].bRegistered)
+        return;
+
+    // frames still held by the library are left to the pool, they are free once unlocked
+    sConsumer& consumer = m_Consumers[consumerId];
+    sPool& pool         = *m_Pools[consumer.pool];
+    for (sFrame& frame : pool.frames) {
+        if (frame.owner == consumerId) {
+            frame.owner     = NO_CONSUMER;
+            frame.bReserved = false;
+        }
+    }
+    pool.maxFrames -= consumer.quota;
+    consumer.bRegistered = false;
+
+    // the quotas of the remaining consumers keep the frames they may take at once
+    TrimPool(consumer.pool, pool.maxFrames);
+}
+
+mfxStatus CSurfacePoolService::AddFrame(sPool& pool) {
+    mfxFrameAllocResponse response = {};
+    mfxStatus sts = m_pAllocator->Alloc(m_pAllocator->pthis, &pool.request, &response);
+    MSDK_CHECK_STATUS(sts, "m_pAllocator->Alloc failed");
+
+    sFrame frame;
+    frame.pSurface.reset(new mfxFrameSurfaceWrap());
+    frame.pSurface->Info       = pool.request.Info;
+    frame.pSurface->Data.MemId = response.mids[0];
+    frame.response             = response;
+    frame.owner                = NO_CONSUMER;
+    frame.bReserved            = false;
+    pool.frames.push_back(std::move(frame));
+    pool.allocatedFrames++;
+
+    return MFX_ERR_NONE;
+}
+
+void CSurfacePoolService::TrimPool(mfxU32 poolIndex, mfxU32 keepFrames) {
+    sPool& pool = *m_Pools[poolIndex];
+
+    // frames at the end are taken last, so they are the idle ones
+    for (mfxU32 i = (mfxU32)pool.frames.size(); i-- > 0 && pool.frames.size() > keepFrames;) {
+        if (!IsFree(pool.frames[i]))
+            continue;
+
+        m_pAllocator->Free(m_pAllocator->pthis, &pool.frames[i].response);
+        pool.frames.erase(pool.frames.begin() + i);
+        pool.releasedFrames++;
+
+        for (sConsumer& consumer : m_Consumers) {
+            if (consumer.pool == poolIndex && consumer.reserved > (mfxI32)i)
+                consumer.reserved--;
+        }
+    }
+}
+
+mfxU32 CSurfacePoolService::GetHeldCount(const sPool& pool, mfxU32 consumerId) const {
+    mfxU32 held = 0;
+    for (const sFrame& frame : pool.frames) {
+        if (frame.owner == consumerId && !IsFree(frame))
+            held++;
+    }
+    return held;
+}
+
+mfxFrameSurface1* CSurfacePoolService::AcquireSurface(mfxU32 consumerId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (consumerId >= m_Consumers.size() || !m_Consumers[consumerId].bRegistered)
+        return NULL;
+
+    sConsumer& consumer = m_Consumers[consumerId];
+    sPool& pool         = *m_Pools[consumer.pool];
+
+    // the frame of the previous call is locked by now if it's in use
+    if (consumer.reserved >= 0) {
+        pool.frames[consumer.reserved].bReserved = false;
+        consumer.reserved                        = -1;
+    }
+
+    // the pool is trimmed to the most frames in use at once over the window, it grows again on
+    // demand below
+    if (++pool.windowAcquires >= TRIM_WINDOW) {
+        TrimPool(consumer.pool, pool.windowPeak);
+        pool.windowAcquires = 0;
+        pool.windowPeak     = 0;
+    }
+
+    if (GetHeldCount(pool, consumerId) >= consumer.quota)
+        return NULL;
+
+    mfxU32 numFrames = (mfxU32)pool.frames.size();
+    mfxU32 index     = numFrames;
+    mfxU32 inUse     = 0;
+    for (mfxU32 i = 0; i < numFrames; i++) {
+        if (!IsFree(pool.frames[i]))
+            inUse++;
+        else if (index == numFrames)
+            index = i;
+    }
+    // all the frames are in use, the pool grows while the quotas allow
+    if (index == numFrames) {
+        if (numFrames >= pool.maxFrames || MFX_ERR_NONE != AddFrame(pool))
+            return NULL;
+    }
+
+    sFrame& frame     = pool.frames[index];
+    frame.owner       = consumerId;
+    frame.bReserved   = true;
+    consumer.reserved = (mfxI32)index;
+
+    pool.peakFrames = (std::max)(pool.peakFrames, inUse + 1);
+    pool.windowPeak = (std::max)(pool.windowPeak, inUse + 1);
+    return frame.pSurface.get();
+}
+
+mfxStatus CSurfacePoolService::TransferSurface(mfxFrameSurface1* pSurface, mfxU32 consumerId) {
+    MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (consumerId >= m_Consumers.size() || !m_Consumers[consumerId].bRegistered)
+        return MFX_ERR_NOT_FOUND;
+
+    sPool& pool = *m_Pools[m_Consumers[consumerId].pool];
+    for (sFrame& frame : pool.frames) {
+        if (frame.pSurface.get() == pSurface) {
+            frame.owner = consumerId;
+            return MFX_ERR_NONE;
+        }
+    }
+    // frame of another pool
+    return MFX_ERR_NOT_FOUND;
+}
+
+mfxU32 CSurfacePoolService::GetFreeSurfacesCount(mfxU32 consumerId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (consumerId >= m_Consumers.size() || !m_Consumers[consumerId].bRegistered)
+        return 0;
+
+    const sConsumer& consumer = m_Consumers[consumerId];
+    const sPool& pool         = *m_Pools[consumer.pool];
+
+    mfxU32 held      = GetHeldCount(pool, consumerId);
+    mfxU32 numFrames = (mfxU32)pool.frames.size();
+    mfxU32 free      = (numFrames < pool.maxFrames) ? pool.maxFrames - numFrames : 0;
+    for (const sFrame& frame : pool.frames) {
+        if (IsFree(frame))
+            free++;
+    }
+    return (std::min)(free, held < consumer.quota ? consumer.quota - held : 0);
+}
+
+void CSurfacePoolService::PrintStatistics() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (mfxU32 i = 0; i < m_Pools.size(); i++) {
+        const sPool& pool = *m_Pools[i];
+        msdk_printf(MSDK_STRING("Shared pool %d (%dx%d): %d frames allocated, %d released, "
+                                "%d in use at most\n"),
+                    (int)i,
+                    (int)pool.request.Info.Width,
+                    (int)pool.request.Info.Height,
+                    (int)pool.allocatedFrames,
+                    (int)pool.releasedFrames,
+                    (int)pool.peakFrames);
+    }
+}
@@ -12,6 +12,13 @@
 #define ID_BUFFER       MFX_MAKEFOURCC('B', 'U', 'F', 'F')
 #define ID_FRAME        MFX_MAKEFOURCC('F', 'R', 'M', 'E')
 
+// data of pooled buffers is cache line aligned
+#define POOLED_DATA_OFFSET 64
+#define POOL_PAGE_SIZE     (4 * 1024)
+#define POOL_HUGE_PAGE     (2 * 1024 * 1024)
+// keeps planes of pooled buffers cache line aligned as well
+#define FRAME_HEADER_SIZE (((mfxU32)sizeof(sFrame) + 63) & (~(mfxU32)63))
+
 SysMemFrameAllocator::SysMemFrameAllocator()
         : m_pBufferAllocator(0),
           m_bOwnBufferAllocator(false) {}
@@ -21,6 +28,9 @@ SysMemFrameAllocator::~SysMemFrameAllocator() {
 }
 
 mfxStatus SysMemFrameAllocator::Init(mfxAllocatorParams* pParams) {
+    mfxI32 numaNode = -1;
+    bool bPooled    = false;
+
     // check if any params passed from application
     if (pParams) {
         SysMemAllocatorParams* pSysMemParams = 0;
@@ -30,11 +40,13 @@ mfxStatus SysMemFrameAllocator::Init(mfxAllocatorParams* pParams) {
 
         m_pBufferAllocator    = pSysMemParams->pBufferAllocator;
         m_bOwnBufferAllocator = false;
+        numaNode              = pSysMemParams->NumaNode;
+        bPooled               = pSysMemParams->bPooledBuffers;
     }
 
     // if buffer allocator wasn't passed from application create own
     if (!m_pBufferAllocator) {
-        m_pBufferAllocator = new SysMemBufferAllocator;
+        m_pBufferAllocator = new SysMemBufferAllocator(numaNode, bPooled);
         if (!m_pBufferAllocator)
             return MFX_ERR_MEMORY_ALLOC;
 
@@ -78,7 +90,7 @@ mfxStatus SysMemFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
 
     mfxU16 Width2  = (mfxU16)MSDK_ALIGN32(fs->info.Width);
     mfxU16 Height2 = (mfxU16)MSDK_ALIGN32(fs->info.Height);
-    ptr->B = ptr->Y = (mfxU8*)fs + MSDK_ALIGN32(sizeof(sFrame));
+    ptr->B = ptr->Y = (mfxU8*)fs + FRAME_HEADER_SIZE;
 
     switch (fs->info.FourCC) {
         case MFX_FOURCC_NV12:
@@ -366,7 +378,7 @@ mfxStatus SysMemFrameAllocator::ReallocImpl(mfxMemId mid,
         return sts;
 
     sts = m_pBufferAllocator->Alloc(m_pBufferAllocator->pthis,
-                                    MSDK_ALIGN32(nbytes) + MSDK_ALIGN32(sizeof(sFrame)),
+                                    MSDK_ALIGN32(nbytes) + FRAME_HEADER_SIZE,
                                     MFX_MEMTYPE_SYSTEM_MEMORY,
                                     pmid);
     if (MFX_ERR_NONE != sts)
@@ -403,7 +415,7 @@ mfxStatus SysMemFrameAllocator::AllocImpl(mfxFrameAllocRequest* request,
     // allocate frames
     for (numAllocated = 0; numAllocated < request->NumFrameSuggested; numAllocated++) {
         mfxStatus sts = m_pBufferAllocator->Alloc(m_pBufferAllocator->pthis,
-                                                  nbytes + MSDK_ALIGN32(sizeof(sFrame)),
+                                                  nbytes + FRAME_HEADER_SIZE,
                                                   request->Type,
                                                   &(mids[numAllocated]));
 
@@ -462,9 +474,22 @@ mfxStatus SysMemFrameAllocator::ReleaseResponse(mfxFrameAllocResponse* response)
     return sts;
 }
 
-SysMemBufferAllocator::SysMemBufferAllocator() {}
+SysMemBufferAllocator::SysMemBufferAllocator(mfxI32 numaNode, bool bPooled)
+        : m_NumaNode(numaNode),
+          m_bPooled(bPooled),
+          m_FreeBuffers(),
+          m_PoolMutex() {}
+
+SysMemBufferAllocator::~SysMemBufferAllocator() {
+    for (auto& it : m_FreeBuffers)
+        msdk_free_pages(it.second, it.first);
+    m_FreeBuffers.clear();
+}
 
-SysMemBufferAllocator::~SysMemBufferAllocator() {}
+mfxU32 SysMemBufferAllocator::GetPoolSizeClass(mfxU32 nbytes) const {
+    mfxU32 align = (nbytes >= POOL_HUGE_PAGE) ? POOL_HUGE_PAGE : POOL_PAGE_SIZE;
+    return (nbytes + align - 1) & ~(align - 1);
+}
 
 mfxStatus SysMemBufferAllocator::AllocBuffer(mfxU32 nbytes, mfxU16 type, mfxMemId* mid) {
     if (!mid)
@@ -473,17 +498,56 @@ mfxStatus SysMemBufferAllocator::AllocBuffer(mfxU32 nbytes, mfxU16 type, mfxMemI
     if (0 == (type & MFX_MEMTYPE_SYSTEM_MEMORY))
         return MFX_ERR_UNSUPPORTED;
 
+    if (m_bPooled) {
+        if (nbytes > 0xFFFFFFFF - POOLED_DATA_OFFSET - POOL_HUGE_PAGE)
+            return MFX_ERR_MEMORY_ALLOC;
+        mfxU32 capacity = GetPoolSizeClass(POOLED_DATA_OFFSET + nbytes);
+
+        sBuffer* bs = NULL;
+        {
+            std::lock_guard<std::mutex> lock(m_PoolMutex);
+            auto it = m_FreeBuffers.find(capacity);
+            if (it != m_FreeBuffers.end()) {
+                bs = it->second;
+                m_FreeBuffers.erase(it);
+            }
+        }
+        if (!bs) {
+            bs = (sBuffer*)msdk_alloc_pages(capacity, capacity >= POOL_HUGE_PAGE);
+            if (!bs)
+                return MFX_ERR_MEMORY_ALLOC;
+            // pages are not touched yet
+            if (m_NumaNode >= 0)
+                std::ignore = msdk_numa_bind_memory(bs, capacity, m_NumaNode);
+        }
+
+        bs->id       = ID_BUFFER;
+        bs->type     = type;
+        bs->nbytes   = nbytes;
+        bs->offset   = POOLED_DATA_OFFSET;
+        bs->capacity = capacity;
+        *mid         = (mfxHDL)bs;
+        return MFX_ERR_NONE;
+    }
+
     mfxU32 header_size = MSDK_ALIGN32(sizeof(sBuffer));
     mfxU8* buffer_ptr  = (mfxU8*)calloc(header_size + nbytes + 32, 1);
 
     if (!buffer_ptr)
         return MFX_ERR_MEMORY_ALLOC;
 
-    sBuffer* bs = (sBuffer*)buffer_ptr;
-    bs->id      = ID_BUFFER;
-    bs->type    = type;
-    bs->nbytes  = nbytes;
-    *mid        = (mfxHDL)bs;
+    // large buffers are not touched by calloc yet, so their pages get allocated on the node
+    if (m_NumaNode >= 0)
+        std::ignore = msdk_numa_bind_memory(buffer_ptr, header_size + nbytes + 32, m_NumaNode);
+
+    sBuffer* bs  = (sBuffer*)buffer_ptr;
+    bs->id       = ID_BUFFER;
+    bs->type     = type;
+    bs->nbytes   = nbytes;
+    bs->offset   = (mfxU32)(((size_t)(buffer_ptr + header_size + 31) & (~((size_t)31))) -
+                          (size_t)buffer_ptr);
+    bs->capacity = 0;
+    *mid         = (mfxHDL)bs;
     return MFX_ERR_NONE;
 }
 
@@ -498,7 +562,7 @@ mfxStatus SysMemBufferAllocator::LockBuffer(mfxMemId mid, mfxU8** ptr) {
     if (ID_BUFFER != bs->id)
         return MFX_ERR_INVALID_HANDLE;
 
-    *ptr = (mfxU8*)((size_t)((mfxU8*)bs + MSDK_ALIGN32(sizeof(sBuffer)) + 31) & (~((size_t)31)));
+    *ptr = (mfxU8*)bs + bs->offset;
     return MFX_ERR_NONE;
 }
 
@@ -516,6 +580,14 @@ mfxStatus SysMemBufferAllocator::FreeBuffer(mfxMemId mid) {
     if (!bs || ID_BUFFER != bs->id)
         return MFX_ERR_INVALID_HANDLE;
 
+    if (bs->capacity) {
+        // stale handles of the buffer are rejected till it's reused
+        bs->id = 0;
+        std::lock_guard<std::mutex> lock(m_PoolMutex);
+        m_FreeBuffers.insert(std::make_pair(bs->capacity, bs));
+        return MFX_ERR_NONE;
+    }
+
     free(bs);
     return MFX_ERR_NONE;
 }
@@ -20,7 +20,7 @@
 /* Global Declaration */
 Buffer *buffers, *CurBuffers;
 bool CtrlFlag = false;
-int m_q[5], m_first = 0, m_last = 0, m_numInQ = 0;
+int m_q[VIDEO_MAX_FRAME], m_first = 0, m_last = 0, m_numInQ = 0;
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t empty = PTHREAD_MUTEX_INITIALIZER;
 
@@ -34,6 +34,8 @@ v4l2Device::v4l2Device(const char* devname,
           m_height(height),
           m_width(width),
           m_num_buffers(num_buffers),
+          m_format(),
+          m_bytesperline(0),
           m_MipiPort(0),
           m_MipiMode(MipiMode),
           m_v4l2Format(v4l2Format),
@@ -76,6 +78,8 @@ int v4l2Device::ConvertToMFXFourCC(enum V4L2PixelFormat v4l2Format) {
             return MFX_FOURCC_UYVY;
         case YUY2:
             return MFX_FOURCC_YUY2;
+        case NV12:
+            return MFX_FOURCC_NV12;
         case NO_FORMAT:
 
         default:
@@ -90,6 +94,8 @@ int v4l2Device::ConvertToV4L2FourCC() {
             return V4L2_PIX_FMT_UYVY;
         case YUY2:
             return V4L2_PIX_FMT_YUYV;
+        case NV12:
+            return V4L2_PIX_FMT_NV12;
         case NO_FORMAT:
 
         default:
@@ -114,9 +120,10 @@ void v4l2Device::Init(const char* devname,
     (m_MipiPort != MipiPort) ? m_MipiPort          = MipiPort : m_MipiPort;
 
     memset(&m_format, 0, sizeof m_format);
-    m_format.width       = m_width;
-    m_format.height      = m_height;
-    m_format.pixelformat = ConvertToV4L2FourCC();
+    m_format.width        = m_width;
+    m_format.height       = m_height;
+    m_format.pixelformat  = ConvertToV4L2FourCC();
+    m_format.bytesperline = m_bytesperline;
 
     V4L2Init();
 }
@@ -201,6 +208,10 @@ void v4l2Device::V4L2Init() {
                 fmt.fmt.pix.height,
                 (char*)&fmt.fmt.pix.pixelformat,
                 fmt.fmt.pix.bytesperline);
+    // the frames are written into the surfaces as they are laid out
+    BYE_ON(m_bytesperline && fmt.fmt.pix.bytesperline != m_bytesperline,
+           "video node doesn't support pitch %u of the surfaces\n",
+           m_bytesperline);
 
     CLEAR(rqbufs);
     rqbufs.count  = m_num_buffers;
@@ -219,7 +230,19 @@ void v4l2Device::V4L2Init() {
 }
 
 void v4l2Device::V4L2Alloc() {
-    buffers = (Buffer*)malloc(sizeof(Buffer) * (int)m_num_buffers);
+    buffers = (Buffer*)calloc(m_num_buffers, sizeof(Buffer));
+}
+
+void v4l2Device::V4L2Free() {
+    if (!buffers)
+        return;
+
+    for (uint32_t i = 0; i < m_num_buffers; i++) {
+        if (buffers[i].fd > 0)
+            close(buffers[i].fd);
+    }
+    free(buffers);
+    buffers = NULL;
 }
 
 void v4l2Device::V4L2QueueBuffer(Buffer* buffer) {
@@ -231,6 +254,7 @@ void v4l2Device::V4L2QueueBuffer(Buffer* buffer) {
     buf.memory = V4L2_MEMORY_DMABUF;
     buf.index  = buffer->index;
     buf.m.fd   = buffer->fd;
+    buf.length = buffer->length;
 
     ret = blockIOCTL(m_fd, VIDIOC_QBUF, &buf);
     BYE_ON(ret < 0,
@@ -275,7 +299,7 @@ void v4l2Device::V4L2StopCapture() {
 void v4l2Device::PutOnQ(int x) {
     pthread_mutex_lock(&mutex);
     m_q[m_first] = x;
-    m_first      = (m_first + 1) % 5;
+    m_first      = (m_first + 1) % VIDEO_MAX_FRAME;
     m_numInQ++;
     pthread_mutex_unlock(&mutex);
     pthread_mutex_unlock(&empty);
@@ -290,7 +314,7 @@ int v4l2Device::GetOffQ() {
 
     pthread_mutex_lock(&mutex);
     thing  = m_q[m_last];
-    m_last = (m_last + 1) % 5;
+    m_last = (m_last + 1) % VIDEO_MAX_FRAME;
     m_numInQ--;
     pthread_mutex_unlock(&mutex);
 
@@ -321,14 +345,13 @@ void* PollingThread(void* data) {
     while (1) {
         if (poll(&fd, 1, 5000) > 0) {
             if (fd.revents & POLLIN) {
+                // the buffer is queued again by the consumer when the library is done with the
+                // surface, so the device never writes into a frame being processed
                 CurBuffers = v4l2->V4L2DeQueueBuffer(buffers);
                 v4l2->PutOnQ(CurBuffers->index);
 
                 if (CtrlFlag)
                     break;
-
-                if (CurBuffers)
-                    v4l2->V4L2QueueBuffer(&buffers[CurBuffers->index]);
             }
         }
     }
@@ -80,7 +80,9 @@ vaapiFrameAllocator::vaapiFrameAllocator()
         : m_dpy(0),
           m_libva(new MfxLoader::VA_Proxy),
           m_export_mode(vaapiAllocatorParams::DONOT_EXPORT),
-          m_exporter(NULL) {}
+          m_exporter(NULL),
+          m_persistent_mapping(false),
+          m_imported() {}
 
 vaapiFrameAllocator::~vaapiFrameAllocator() {
     Close();
@@ -104,6 +106,9 @@ mfxStatus vaapiFrameAllocator::Init(mfxAllocatorParams* pParams) {
     m_dpy         = p_vaapiParams->m_dpy;
     m_export_mode = p_vaapiParams->m_export_mode;
     m_exporter    = p_vaapiParams->m_exporter;
+    m_persistent_mapping =
+        p_vaapiParams->m_persistent_mapping &&
+        !(p_vaapiParams->m_export_mode & vaapiAllocatorParams::NATIVE_EXPORT_MASK);
     return MFX_ERR_NONE;
 }
 
@@ -120,6 +125,12 @@ mfxStatus vaapiFrameAllocator::CheckRequestType(mfxFrameAllocRequest* request) {
 }
 
 mfxStatus vaapiFrameAllocator::Close() {
+    for (std::unique_ptr<vaapiImportedFrame>& pFrame : m_imported) {
+        ReleasePersistentMapping(&pFrame->mid);
+        m_libva->vaDestroySurfaces(m_dpy, &pFrame->surface, 1);
+    }
+    m_imported.clear();
+
     return BaseFrameAllocator::Close();
 }
 
@@ -171,6 +182,7 @@ mfxStatus vaapiFrameAllocator::ReallocImpl(mfxMemId mid,
     VASurfaceAttrib attrib[2];
     vaapiMemId* vaapiMid = (vaapiMemId*)mid;
     surfaces[0]          = *vaapiMid->m_surface;
+    ReleasePersistentMapping(vaapiMid);
     m_libva->vaDestroySurfaces(m_dpy, surfaces, 1);
 
     unsigned int format;
@@ -421,6 +433,7 @@ mfxStatus vaapiFrameAllocator::ReleaseResponse(mfxFrameAllocResponse* response)
                 m_libva->vaDestroyBuffer(m_dpy, surfaces[i]);
             else if (vaapi_mids[i].m_sys_buffer)
                 free(vaapi_mids[i].m_sys_buffer);
+            ReleasePersistentMapping(&vaapi_mids[i]);
             if (m_export_mode != vaapiAllocatorParams::DONOT_EXPORT) {
                 if (m_exporter && vaapi_mids[i].m_custom) {
                     m_exporter->release(&vaapi_mids[i], vaapi_mids[i].m_custom);
@@ -473,12 +486,26 @@ mfxStatus vaapiFrameAllocator::LockFrame(mfxMemId mid, mfxFrameData* ptr) {
     }
     else // Image processing
     {
-        va_res  = m_libva->vaDeriveImage(m_dpy, *(vaapi_mid->m_surface), &(vaapi_mid->m_image));
-        mfx_res = va_to_mfx_status(va_res);
+        if (vaapi_mid->m_mapped_buffer) {
+            // the image is still mapped, only the work on the surface has to be waited for
+            if (VA_STATUS_SUCCESS == m_libva->vaSyncSurface(m_dpy, *(vaapi_mid->m_surface)))
+                pBuffer = vaapi_mid->m_mapped_buffer;
+            else
+                ReleasePersistentMapping(vaapi_mid);
+        }
 
-        if (MFX_ERR_NONE == mfx_res) {
-            va_res  = m_libva->vaMapBuffer(m_dpy, vaapi_mid->m_image.buf, (void**)&pBuffer);
+        if (!pBuffer) {
+            va_res  = m_libva->vaDeriveImage(m_dpy,
+                                            *(vaapi_mid->m_surface),
+                                            &(vaapi_mid->m_image));
             mfx_res = va_to_mfx_status(va_res);
+
+            if (MFX_ERR_NONE == mfx_res) {
+                va_res  = m_libva->vaMapBuffer(m_dpy, vaapi_mid->m_image.buf, (void**)&pBuffer);
+                mfx_res = va_to_mfx_status(va_res);
+            }
+            if (MFX_ERR_NONE == mfx_res && m_persistent_mapping)
+                vaapi_mid->m_mapped_buffer = pBuffer;
         }
         if (MFX_ERR_NONE == mfx_res) {
             switch (vaapi_mid->m_image.format.fourcc) {
@@ -666,8 +693,10 @@ mfxStatus vaapiFrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData* ptr) {
     }
     else // Image processing
     {
-        m_libva->vaUnmapBuffer(m_dpy, vaapi_mid->m_image.buf);
-        m_libva->vaDestroyImage(m_dpy, vaapi_mid->m_image.image_id);
+        if (!vaapi_mid->m_mapped_buffer) {
+            m_libva->vaUnmapBuffer(m_dpy, vaapi_mid->m_image.buf);
+            m_libva->vaDestroyImage(m_dpy, vaapi_mid->m_image.image_id);
+        }
 
         if (NULL != ptr) {
             ptr->PitchLow  = 0;
@@ -681,6 +710,126 @@ mfxStatus vaapiFrameAllocator::UnlockFrame(mfxMemId mid, mfxFrameData* ptr) {
     return MFX_ERR_NONE;
 }
 
+void vaapiFrameAllocator::ReleasePersistentMapping(vaapiMemId* vaapi_mid) {
+    if (!vaapi_mid->m_mapped_buffer)
+        return;
+
+    m_libva->vaUnmapBuffer(m_dpy, vaapi_mid->m_image.buf);
+    m_libva->vaDestroyImage(m_dpy, vaapi_mid->m_image.image_id);
+    vaapi_mid->m_mapped_buffer = NULL;
+}
+
+    #if VA_CHECK_VERSION(1, 1, 0)
+mfxStatus vaapiFrameAllocator::ExportDmaBuf(mfxMemId mid,
+                                            mfxU32 flags,
+                                            VADRMPRIMESurfaceDescriptor* pDesc) {
+    vaapiMemId* vaapi_mid = (vaapiMemId*)mid;
+
+    if (!pDesc)
+        return MFX_ERR_NULL_PTR;
+    if (!vaapi_mid || !(vaapi_mid->m_surface))
+        return MFX_ERR_INVALID_HANDLE;
+    if (MFX_FOURCC_P8 == ConvertVP8FourccToMfxFourcc(vaapi_mid->m_fourcc))
+        return MFX_ERR_UNSUPPORTED;
+
+    // the consumer accesses the memory directly, so the work on the surface has to be completed
+    VAStatus va_res = m_libva->vaSyncSurface(m_dpy, *(vaapi_mid->m_surface));
+    if (VA_STATUS_SUCCESS == va_res)
+        va_res = m_libva->vaExportSurfaceHandle(m_dpy,
+                                                *(vaapi_mid->m_surface),
+                                                VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                                flags,
+                                                pDesc);
+    return va_to_mfx_status(va_res);
+}
+
+static mfxStatus GetVARTFormat(mfxU32 fourcc, unsigned int& va_rt_format) {
+    switch (fourcc) {
+        case MFX_FOURCC_NV12:
+            va_rt_format = VA_RT_FORMAT_YUV420;
+            break;
+        case MFX_FOURCC_P010:
+            va_rt_format = VA_RT_FORMAT_YUV420_10;
+            break;
+        case MFX_FOURCC_YUY2:
+        case MFX_FOURCC_UYVY:
+            va_rt_format = VA_RT_FORMAT_YUV422;
+            break;
+        case MFX_FOURCC_RGB4:
+        case MFX_FOURCC_BGR4:
+            va_rt_format = VA_RT_FORMAT_RGB32;
+            break;
+        case MFX_FOURCC_A2RGB10:
+            va_rt_format = VA_RT_FORMAT_RGB32_10BPP;
+            break;
+        default:
+            return MFX_ERR_UNSUPPORTED;
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus vaapiFrameAllocator::ImportDmaBuf(const VADRMPRIMESurfaceDescriptor& desc,
+                                            const mfxFrameInfo& info,
+                                            mfxMemId* mid) {
+    if (!mid)
+        return MFX_ERR_NULL_PTR;
+
+    unsigned int va_fourcc    = 0;
+    unsigned int va_rt_format = 0;
+    mfxStatus mfx_res         = GetVAFourcc(info.FourCC, va_fourcc);
+    if (MFX_ERR_NONE == mfx_res)
+        mfx_res = GetVARTFormat(info.FourCC, va_rt_format);
+    if (MFX_ERR_NONE != mfx_res)
+        return mfx_res;
+
+    if (desc.fourcc != va_fourcc || desc.width < info.Width || desc.height < info.Height)
+        return MFX_ERR_INCOMPATIBLE_VIDEO_PARAM;
+
+    VASurfaceAttrib attrib[2] = {};
+    attrib[0].type            = VASurfaceAttribMemoryType;
+    attrib[0].flags           = VA_SURFACE_ATTRIB_SETTABLE;
+    attrib[0].value.type      = VAGenericValueTypeInteger;
+    attrib[0].value.value.i   = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2;
+    attrib[1].type            = VASurfaceAttribExternalBufferDescriptor;
+    attrib[1].flags           = VA_SURFACE_ATTRIB_SETTABLE;
+    attrib[1].value.type      = VAGenericValueTypePointer;
+    attrib[1].value.value.p   = (void*)&desc;
+
+    std::unique_ptr<vaapiImportedFrame> pFrame(new vaapiImportedFrame());
+    VAStatus va_res = m_libva->vaCreateSurfaces(m_dpy,
+                                                va_rt_format,
+                                                desc.width,
+                                                desc.height,
+                                                &pFrame->surface,
+                                                1,
+                                                attrib,
+                                                2);
+    mfx_res         = va_to_mfx_status(va_res);
+    if (MFX_ERR_NONE != mfx_res)
+        return mfx_res;
+
+    pFrame->mid.m_surface = &pFrame->surface;
+    pFrame->mid.m_fourcc  = info.FourCC;
+    *mid                  = &pFrame->mid;
+    m_imported.push_back(std::move(pFrame));
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus vaapiFrameAllocator::ReleaseImportedFrame(mfxMemId mid) {
+    for (auto it = m_imported.begin(); it != m_imported.end(); it++) {
+        if (&(*it)->mid != mid)
+            continue;
+
+        ReleasePersistentMapping(&(*it)->mid);
+        m_libva->vaDestroySurfaces(m_dpy, &(*it)->surface, 1);
+        m_imported.erase(it);
+        return MFX_ERR_NONE;
+    }
+    return MFX_ERR_INVALID_HANDLE;
+}
+    #endif
+
 mfxStatus vaapiFrameAllocator::GetFrameHDL(mfxMemId mid, mfxHDL* handle) {
     vaapiMemId* vaapi_mid = (vaapiMemId*)mid;
 
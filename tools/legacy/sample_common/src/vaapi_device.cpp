@@ -407,12 +407,13 @@ mfxStatus CVAAPIDeviceWayland::RenderFrame(mfxFrameSurface1* pSurface,
     pitches[0]  = memId->m_image.pitches[0];
     pitches[1]  = memId->m_image.pitches[1];
     pitches[2]  = memId->m_image.pitches[2];
-    m_wl_buffer = m_Wayland->CreatePrimeBuffer(memId->m_buffer_info.handle,
-                                               pSurface->Info.CropW,
-                                               pSurface->Info.CropH,
-                                               drm_format,
-                                               offsets,
-                                               pitches);
+    m_wl_buffer = m_Wayland->GetCachedPrimeBuffer(pSurface->Data.MemId,
+                                                  memId->m_buffer_info.handle,
+                                                  pSurface->Info.CropW,
+                                                  pSurface->Info.CropH,
+                                                  drm_format,
+                                                  offsets,
+                                                  pitches);
     if (NULL == m_wl_buffer) {
         msdk_printf("\nCan't wrap flink to wl_buffer\n");
         mfx_res = MFX_ERR_UNKNOWN;
@@ -424,7 +425,15 @@ mfxStatus CVAAPIDeviceWayland::RenderFrame(mfxFrameSurface1* pSurface,
     return mfx_res;
 }
 
+mfxStatus CVAAPIDeviceWayland::Reset(void) {
+    // the surface pool is recreated after reset
+    if (m_Wayland)
+        m_Wayland->DestroyBufferCache();
+    return MFX_ERR_NONE;
+}
+
 void CVAAPIDeviceWayland::Close(void) {
+    m_Wayland->DestroyBufferCache();
     m_Wayland->FreeSurface();
 }
 
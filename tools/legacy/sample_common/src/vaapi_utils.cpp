@@ -80,7 +80,12 @@ VA_Proxy::VA_Proxy()
           SIMPLE_LOADER_FUNCTION(vaCreateConfig),
           SIMPLE_LOADER_FUNCTION(vaCreateContext),
           SIMPLE_LOADER_FUNCTION(vaDestroyConfig),
-          SIMPLE_LOADER_FUNCTION(vaDestroyContext) {
+          SIMPLE_LOADER_FUNCTION(vaDestroyContext)
+        #if VA_CHECK_VERSION(1, 1, 0)
+          ,
+          SIMPLE_LOADER_FUNCTION(vaExportSurfaceHandle)
+        #endif
+{
 }
 
 VA_Proxy::~VA_Proxy() {}
@@ -0,0 +1,84 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "mfx_samples_config.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    #include <fcntl.h>
+    #include <io.h>
+    #include <limits.h>
+    #include <algorithm>
+    #include <mutex>
+    #include <vector>
+    #include "vm/stream_defs.h"
+
+namespace {
+std::mutex g_pipesMutex;
+std::vector<FILE*> g_pipes; // opened with _tpopen, they are closed with _pclose
+} // namespace
+
+bool msdk_is_stream(const msdk_char* name) {
+    if (!name)
+        return false;
+    return !_tcscmp(name, _T("-")) || !_tcsncmp(name, _T("pipe:"), 5) ||
+           !_tcsncmp(name, _T("tcp://"), 6) || !_tcsncmp(name, _T("udp://"), 6);
+}
+
+FILE* msdk_stream_open(const msdk_char* name, bool bWrite) {
+    if (!name)
+        return NULL;
+
+    if (!_tcscmp(name, _T("-"))) {
+        if (bWrite) {
+            _tprintf(_T("[ERROR] the standard output carries the log, it can't be an output\n"));
+            return NULL;
+        }
+        _setmode(_fileno(stdin), _O_BINARY);
+        setvbuf(stdin, NULL, _IONBF, 0);
+        return stdin;
+    }
+
+    if (!_tcsncmp(name, _T("pipe:"), 5)) {
+        FILE* f = _tpopen(name + 5, bWrite ? _T("wb") : _T("rb"));
+        if (f) {
+            if (!bWrite)
+                setvbuf(f, NULL, _IONBF, 0);
+            std::lock_guard<std::mutex> lock(g_pipesMutex);
+            g_pipes.push_back(f);
+        }
+        return f;
+    }
+
+    _tprintf(_T("[ERROR] %s: sockets are supported on Linux only\n"), name);
+    return NULL;
+}
+
+size_t msdk_stream_read(FILE* stream, void* buffer, size_t size) {
+    if (!stream || !size)
+        return 0;
+
+    int n = _read(_fileno(stream), buffer, (unsigned int)std::min<size_t>(size, INT_MAX));
+    return n > 0 ? (size_t)n : 0;
+}
+
+void msdk_stream_close(FILE* stream) {
+    if (!stream || stream == stdin)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(g_pipesMutex);
+        auto it = std::find(g_pipes.begin(), g_pipes.end(), stream);
+        if (it != g_pipes.end()) {
+            g_pipes.erase(it);
+            _pclose(stream);
+            return;
+        }
+    }
+    fclose(stream);
+}
+
+#endif // #if defined(_WIN32) || defined(_WIN64)
@@ -0,0 +1,201 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <string.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #include <list>
+    #include <mutex>
+    #include <string>
+    #include <vector>
+    #include "vm/stream_defs.h"
+
+    // larger datagrams aren't sent over UDP
+    #define MSDK_MAX_DATAGRAM_SIZE (64 * 1024)
+
+namespace {
+struct Stream {
+    FILE* file;
+    bool bPipe; // opened with popen, closed with pclose
+    std::vector<char> buffer;
+};
+std::mutex g_streamsMutex;
+std::list<Stream> g_streams;
+
+FILE* AddStream(FILE* f, bool bPipe, bool bWrite, bool bDatagrams) {
+    if (!f)
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(g_streamsMutex);
+    g_streams.push_back(Stream());
+    Stream& stream = g_streams.back();
+    stream.file    = f;
+    stream.bPipe   = bPipe;
+    // a read of a datagram drops the part which doesn't fit
+    if (bDatagrams && !bWrite) {
+        stream.buffer.resize(MSDK_MAX_DATAGRAM_SIZE);
+        setvbuf(f, stream.buffer.data(), _IOFBF, stream.buffer.size());
+    }
+    else if (!bWrite) {
+        setvbuf(f, NULL, _IONBF, 0);
+    }
+    return f;
+}
+
+void EnlargePipe(int fd) {
+    #ifdef F_SETPIPE_SZ
+    // limited by /proc/sys/fs/pipe-max-size, 1 MB by default
+    for (int size = MSDK_STREAM_BUFFER_SIZE; size >= 64 * 1024; size /= 2) {
+        if (fcntl(fd, F_SETPIPE_SZ, size) >= 0)
+            break;
+    }
+    #else
+    (void)fd;
+    #endif
+}
+
+// "host:port" to a socket bound or connected to it, -1 on failure
+int OpenSocket(const char* address, int type, bool bWrite) {
+    std::string host(address);
+    size_t colon = host.rfind(':');
+    if (colon == std::string::npos) {
+        printf("[ERROR] %s: port is missing\n", address);
+        return -1;
+    }
+    std::string port = host.substr(colon + 1);
+    host.resize(colon);
+    // the socket waits for the peer unless it sends datagrams
+    bool bListen = host.empty() || (SOCK_DGRAM == type && !bWrite);
+
+    struct addrinfo hints = {};
+    hints.ai_family       = AF_UNSPEC;
+    hints.ai_socktype     = type;
+    hints.ai_flags        = bListen ? AI_PASSIVE : 0;
+    struct addrinfo* info = NULL;
+
+    int err = getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(), &hints, &info);
+    if (err) {
+        printf("[ERROR] %s: %s\n", address, gai_strerror(err));
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = info; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        int size = MSDK_STREAM_BUFFER_SIZE;
+        setsockopt(fd, SOL_SOCKET, bWrite ? SO_SNDBUF : SO_RCVBUF, &size, sizeof(size));
+
+        bool bOk = false;
+        if (!bListen) {
+            bOk = !connect(fd, ai->ai_addr, ai->ai_addrlen);
+        }
+        else {
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            bOk = !bind(fd, ai->ai_addr, ai->ai_addrlen);
+            if (bOk && SOCK_STREAM == type) {
+                // one peer is served, the listening socket isn't needed after it connects
+                int peer = -1;
+                if (!listen(fd, 1))
+                    peer = accept(fd, NULL, NULL);
+                close(fd);
+                fd  = peer;
+                bOk = fd >= 0;
+                if (bOk)
+                    setsockopt(fd, SOL_SOCKET, bWrite ? SO_SNDBUF : SO_RCVBUF, &size, sizeof(size));
+            }
+        }
+        if (!bOk && fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(info);
+
+    if (fd < 0)
+        printf("[ERROR] %s: %s\n", address, strerror(errno));
+    return fd;
+}
+} // namespace
+
+bool msdk_is_stream(const msdk_char* name) {
+    if (!name)
+        return false;
+    return !strcmp(name, "-") || !strncmp(name, "pipe:", 5) || !strncmp(name, "tcp://", 6) ||
+           !strncmp(name, "udp://", 6);
+}
+
+FILE* msdk_stream_open(const msdk_char* name, bool bWrite) {
+    if (!name)
+        return NULL;
+
+    if (!strcmp(name, "-")) {
+        if (bWrite) {
+            printf("[ERROR] the standard output carries the log, it can't be an output\n");
+            return NULL;
+        }
+        EnlargePipe(fileno(stdin));
+        setvbuf(stdin, NULL, _IONBF, 0);
+        return stdin;
+    }
+
+    if (!strncmp(name, "pipe:", 5)) {
+        FILE* f = popen(name + 5, bWrite ? "w" : "r");
+        if (f)
+            EnlargePipe(fileno(f));
+        return AddStream(f, true, bWrite, false);
+    }
+
+    int type = !strncmp(name, "tcp://", 6) ? SOCK_STREAM : SOCK_DGRAM;
+    int fd   = OpenSocket(name + 6, type, bWrite);
+    if (fd < 0)
+        return NULL;
+
+    FILE* f = fdopen(fd, bWrite ? "wb" : "rb");
+    if (!f)
+        close(fd);
+    return AddStream(f, false, bWrite, SOCK_DGRAM == type);
+}
+
+size_t msdk_stream_read(FILE* stream, void* buffer, size_t size) {
+    if (!stream || !size)
+        return 0;
+
+    ssize_t n = 0;
+    do {
+        n = read(fileno(stream), buffer, size);
+    } while (n < 0 && EINTR == errno);
+    return n > 0 ? (size_t)n : 0;
+}
+
+void msdk_stream_close(FILE* stream) {
+    if (!stream || stream == stdin)
+        return;
+
+    std::lock_guard<std::mutex> lock(g_streamsMutex);
+    for (auto it = g_streams.begin(); it != g_streams.end(); ++it) {
+        if (it->file == stream) {
+            if (it->bPipe)
+                pclose(stream);
+            else
+                fclose(stream);
+            // the buffer is freed after the stream
+            g_streams.erase(it);
+            return;
+        }
+    }
+    fclose(stream);
+}
+
+#endif // #if !defined(_WIN32) && !defined(_WIN64)
@@ -6,10 +6,16 @@
 
 #if !defined(_WIN32) && !defined(_WIN64)
 
+    #include <linux/futex.h>
+    #include <linux/mempolicy.h>
     #include <sched.h>
     #include <stdio.h> // setrlimit
+    #include <string.h>
+    #include <sys/mman.h>
     #include <sys/syscall.h>
+    #include <time.h>
     #include <unistd.h>
+    #include <climits>
     #include <new> // std::bad_alloc
 
     #include "sample_utils.h"
@@ -82,130 +88,87 @@ mfxStatus MSDKSemaphore::Wait(void) {
 
 /* ****************************************************************************** */
 
-MSDKEvent::MSDKEvent(mfxStatus& sts, bool manual, bool state) : msdkEventHandle(manual, state) {
-    sts = MFX_ERR_NONE;
-    //initialize m_event condition variable
-    int res = pthread_cond_init(&m_event, NULL);
-
-    //zero result indicates success
-    if (!res) {
-        //if successful, initialize the mutex
-        res = pthread_mutex_init(&m_mutex, NULL);
+// waits while the word is expected, up to the deadline of CLOCK_MONOTONIC if any
+static void msdk_futex_wait(std::atomic<mfxU32>* word,
+                            mfxU32 expected,
+                            const struct timespec* deadline) {
+    std::ignore = syscall(SYS_futex,
+                          reinterpret_cast<mfxU32*>(word),
+                          FUTEX_WAIT_BITSET_PRIVATE,
+                          expected,
+                          deadline,
+                          NULL,
+                          FUTEX_BITSET_MATCH_ANY);
+}
 
-        //zero result indicates success
-        //if not successful, destroy m_event
-        if (res) {
-            if (!pthread_cond_destroy(&m_event)) {
-                // do nothing
-            }
-        }
-    }
-    else {
-        //non-zero means something is wrong, throw bad_alloc
-        throw std::bad_alloc();
-    }
+static void msdk_futex_wake(std::atomic<mfxU32>* word, int count) {
+    std::ignore = syscall(SYS_futex,
+                          reinterpret_cast<mfxU32*>(word),
+                          FUTEX_WAKE_PRIVATE,
+                          count,
+                          NULL,
+                          NULL,
+                          0);
 }
 
-MSDKEvent::~MSDKEvent(void) {
-    if (!pthread_mutex_destroy(&m_mutex)) {
-        // do nothing
-    }
-    if (!pthread_cond_destroy(&m_event)) {
-        // do nothing
-    }
+MSDKEvent::MSDKEvent(mfxStatus& sts, bool manual, bool state) : msdkEventHandle(manual, state) {
+    sts = MFX_ERR_NONE;
 }
 
+MSDKEvent::~MSDKEvent(void) {}
+
 mfxStatus MSDKEvent::Signal(void) {
-    int res = pthread_mutex_lock(&m_mutex);
-    if (!res) {
-        if (!m_state) {
-            m_state = true;
-            if (m_manual)
-                res = pthread_cond_broadcast(&m_event);
-            else
-                res = pthread_cond_signal(&m_event);
-            if (!res) {
-                // do nothing
-            }
-        }
-        int sts = pthread_mutex_unlock(&m_mutex);
-        if (!sts) {
-            // do nothing
-        }
-        if (!res)
-            res = sts;
-    }
-    return (res) ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+    // the waiters are counted before they check the state, so either they see it set or they
+    // are seen here
+    if (!m_state.exchange(1) && m_waiters.load())
+        msdk_futex_wake(&m_state, m_manual ? INT_MAX : 1);
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::Reset(void) {
-    int res = pthread_mutex_lock(&m_mutex);
-    if (!res) {
-        if (m_state)
-            m_state = false;
-        res = pthread_mutex_unlock(&m_mutex);
-    }
-    return (res) ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+    m_state.store(0, std::memory_order_relaxed);
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::Wait(void) {
-    int res = pthread_mutex_lock(&m_mutex);
-    if (!res) {
-        while (!m_state) {
-            res = pthread_cond_wait(&m_event, &m_mutex);
-            if (!res) {
-                // do nothing
-            }
-        }
-        if (!m_manual)
-            m_state = false;
-        int sts = pthread_mutex_unlock(&m_mutex);
-        if (!sts) {
-            // do nothing
-        }
-        if (!res)
-            res = sts;
+    while (!TryWait()) {
+        m_waiters.fetch_add(1);
+        msdk_futex_wait(&m_state, 0, NULL);
+        m_waiters.fetch_sub(1);
     }
-    return (res) ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::TimedWait(mfxU32 msec) {
     if (MFX_INFINITE == msec)
         return MFX_ERR_UNSUPPORTED;
-    mfxStatus mfx_res = MFX_ERR_NOT_INITIALIZED;
+    if (TryWait())
+        return MFX_ERR_NONE;
 
-    int res = pthread_mutex_lock(&m_mutex);
-    if (!res) {
-        if (!m_state) {
-            struct timeval tval;
-            struct timespec tspec;
-            mfxI32 res;
-
-            gettimeofday(&tval, NULL);
-            msec          = 1000 * msec + tval.tv_usec;
-            tspec.tv_sec  = tval.tv_sec + msec / 1000000;
-            tspec.tv_nsec = (msec % 1000000) * 1000;
-            res           = pthread_cond_timedwait(&m_event, &m_mutex, &tspec);
-            if (!res)
-                mfx_res = MFX_ERR_NONE;
-            else if (ETIMEDOUT == res)
-                mfx_res = MFX_TASK_WORKING;
-            else
-                mfx_res = MFX_ERR_UNKNOWN;
-        }
-        else
-            mfx_res = MFX_ERR_NONE;
-        if (!m_manual)
-            m_state = false;
-
-        res = pthread_mutex_unlock(&m_mutex);
-        if (res)
-            mfx_res = MFX_ERR_UNKNOWN;
+    struct timespec deadline;
+    if (clock_gettime(CLOCK_MONOTONIC, &deadline))
+        return MFX_ERR_UNKNOWN;
+    deadline.tv_sec += msec / 1000;
+    deadline.tv_nsec += (long)(msec % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
     }
-    else
-        mfx_res = MFX_ERR_UNKNOWN;
 
-    return mfx_res;
+    for (;;) {
+        m_waiters.fetch_add(1);
+        msdk_futex_wait(&m_state, 0, &deadline);
+        m_waiters.fetch_sub(1);
+        if (TryWait())
+            return MFX_ERR_NONE;
+
+        struct timespec now;
+        if (clock_gettime(CLOCK_MONOTONIC, &now))
+            return MFX_ERR_UNKNOWN;
+        if (now.tv_sec > deadline.tv_sec ||
+            (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+            return MFX_TASK_WORKING;
+    }
 }
 
 /* ****************************************************************************** */
@@ -327,4 +290,168 @@ mfxU32 msdk_get_current_pid() {
     return syscall(SYS_getpid);
 }
 
+mfxStatus msdk_thread_get_affinity(std::vector<mfxU32>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set))
+        return MFX_ERR_UNKNOWN;
+
+    cpus.clear();
+    for (mfxU32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus) {
+    if (cpus.empty())
+        return MFX_ERR_NONE;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (mfxU32 cpu : cpus) {
+        if (cpu >= CPU_SETSIZE)
+            return MFX_ERR_UNSUPPORTED;
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) ? MFX_ERR_UNKNOWN
+                                                                     : MFX_ERR_NONE;
+}
+
+    #define MSDK_NUMA_MAX_NODES 1024
+
+static void msdk_numa_fill_mask(mfxI32 node, unsigned long* mask) {
+    const size_t bits = 8 * sizeof(unsigned long);
+    memset(mask, 0, MSDK_NUMA_MAX_NODES / 8);
+    mask[node / bits] = 1UL << (node % bits);
+}
+
+mfxStatus msdk_thread_set_numa_node(mfxI32 node) {
+    if (node >= MSDK_NUMA_MAX_NODES)
+        return MFX_ERR_UNSUPPORTED;
+
+    if (node < 0)
+        return syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0) ? MFX_ERR_UNKNOWN
+                                                                 : MFX_ERR_NONE;
+
+    unsigned long mask[MSDK_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+    msdk_numa_fill_mask(node, mask);
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MSDK_NUMA_MAX_NODES) ? MFX_ERR_UNKNOWN
+                                                                                 : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_get_node_cpus(mfxI32 node, std::vector<mfxU32>& cpus) {
+    if (node < 0)
+        return MFX_ERR_UNSUPPORTED;
+
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return MFX_ERR_NOT_FOUND;
+
+    char line[4096] = {};
+    char* res       = fgets(line, sizeof(line), file);
+    fclose(file);
+    if (!res)
+        return MFX_ERR_UNKNOWN;
+
+    return msdk_parse_cpu_list(line, cpus);
+}
+
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxI32 node) {
+    if (!ptr)
+        return MFX_ERR_NULL_PTR;
+    if (node < 0 || node >= MSDK_NUMA_MAX_NODES)
+        return MFX_ERR_UNSUPPORTED;
+
+    // only whole pages of the range can be bound, partial ones may be shared with other allocations
+    size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = ((size_t)ptr + page - 1) & ~(page - 1);
+    size_t end   = ((size_t)ptr + size) & ~(page - 1);
+    if (end <= begin)
+        return MFX_ERR_NONE;
+
+    unsigned long mask[MSDK_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+    msdk_numa_fill_mask(node, mask);
+    return syscall(SYS_mbind,
+                   (void*)begin,
+                   end - begin,
+                   MPOL_PREFERRED,
+                   mask,
+                   MSDK_NUMA_MAX_NODES,
+                   MPOL_MF_MOVE)
+               ? MFX_ERR_UNKNOWN
+               : MFX_ERR_NONE;
+}
+
+static mfxI32 msdk_numa_read_node(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return -1;
+
+    int node = -1;
+    if (1 != fscanf(file, "%d", &node))
+        node = -1;
+    fclose(file);
+    return node;
+}
+
+mfxI32 msdk_numa_get_pci_device_node(mfxU32 domain, mfxU32 bus, mfxU32 device, mfxU32 function) {
+    char path[128];
+    snprintf(path,
+             sizeof(path),
+             "/sys/bus/pci/devices/%04x:%02x:%02x.%x/numa_node",
+             domain,
+             bus,
+             device,
+             function);
+    return msdk_numa_read_node(path);
+}
+
+mfxI32 msdk_numa_get_device_node(const msdk_char* devicePath) {
+    if (!devicePath)
+        return -1;
+
+    // /dev/dri/renderD128 -> /sys/class/drm/renderD128/device/numa_node
+    const char* name = strrchr(devicePath, '/');
+    name             = name ? name + 1 : devicePath;
+
+    char path[256];
+    snprintf(path, sizeof(path), "/sys/class/drm/%s/device/numa_node", name);
+    return msdk_numa_read_node(path);
+}
+
+void* msdk_alloc_pages(size_t size, bool bHugePages) {
+    void* ptr = MAP_FAILED;
+    #ifdef MAP_HUGETLB
+    // reserved huge pages first, there may be none configured
+    if (bHugePages)
+        ptr = mmap(NULL,
+                   size,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                   -1,
+                   0);
+    #endif
+    if (MAP_FAILED == ptr) {
+        ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == ptr)
+            return NULL;
+    #ifdef MADV_HUGEPAGE
+        // transparent huge pages otherwise
+        if (bHugePages)
+            std::ignore = madvise(ptr, size, MADV_HUGEPAGE);
+    #endif
+    }
+    return ptr;
+}
+
+void msdk_free_pages(void* ptr, size_t size) {
+    if (ptr)
+        std::ignore = munmap(ptr, size);
+}
+
 #endif // #if !defined(_WIN32) && !defined(_WIN64)
@@ -33,44 +33,58 @@ mfxStatus MSDKSemaphore::Wait(void) {
 
 /* ****************************************************************************** */
 
-MSDKEvent::MSDKEvent(mfxStatus& sts, bool manual, bool state) {
-    sts     = MFX_ERR_NONE;
-    m_event = CreateEvent(NULL, manual, state, NULL);
-    if (!m_event)
-        throw std::bad_alloc();
+MSDKEvent::MSDKEvent(mfxStatus& sts, bool manual, bool state) : msdkEventHandle(manual, state) {
+    sts = MFX_ERR_NONE;
 }
 
-MSDKEvent::~MSDKEvent(void) {
-    CloseHandle(m_event);
-}
+MSDKEvent::~MSDKEvent(void) {}
 
 mfxStatus MSDKEvent::Signal(void) {
-    return (SetEvent(m_event) == false) ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+    // the waiters are counted before they check the state, so either they see it set or they
+    // are seen here
+    if (!m_state.exchange(1) && m_waiters.load()) {
+        if (m_manual)
+            WakeByAddressAll(&m_state);
+        else
+            WakeByAddressSingle(&m_state);
+    }
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::Reset(void) {
-    return (ResetEvent(m_event) == false) ? MFX_ERR_UNKNOWN : MFX_ERR_NONE;
+    m_state.store(0, std::memory_order_relaxed);
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::Wait(void) {
-    return (WaitForSingleObject(m_event, INFINITE) != WAIT_OBJECT_0) ? MFX_ERR_UNKNOWN
-                                                                     : MFX_ERR_NONE;
+    mfxU32 unsignaled = 0;
+    while (!TryWait()) {
+        m_waiters.fetch_add(1);
+        WaitOnAddress(&m_state, &unsignaled, sizeof(unsignaled), INFINITE);
+        m_waiters.fetch_sub(1);
+    }
+    return MFX_ERR_NONE;
 }
 
 mfxStatus MSDKEvent::TimedWait(mfxU32 msec) {
     if (MFX_INFINITE == msec)
         return MFX_ERR_UNSUPPORTED;
-    mfxStatus mfx_res = MFX_ERR_NOT_INITIALIZED;
-    DWORD res         = WaitForSingleObject(m_event, msec);
+    if (TryWait())
+        return MFX_ERR_NONE;
 
-    if (WAIT_OBJECT_0 == res)
-        mfx_res = MFX_ERR_NONE;
-    else if (WAIT_TIMEOUT == res)
-        mfx_res = MFX_TASK_WORKING;
-    else
-        mfx_res = MFX_ERR_UNKNOWN;
+    mfxU32 unsignaled = 0;
+    ULONGLONG start   = GetTickCount64();
+    for (;;) {
+        ULONGLONG elapsed = GetTickCount64() - start;
+        if (elapsed >= msec)
+            return MFX_TASK_WORKING;
 
-    return mfx_res;
+        m_waiters.fetch_add(1);
+        WaitOnAddress(&m_state, &unsignaled, sizeof(unsignaled), (DWORD)(msec - elapsed));
+        m_waiters.fetch_sub(1);
+        if (TryWait())
+            return MFX_ERR_NONE;
+    }
 }
 
 MSDKThread::MSDKThread(mfxStatus& sts, msdk_thread_callback func, void* arg) {
@@ -127,4 +141,79 @@ mfxU32 msdk_get_current_pid() {
     return GetCurrentProcessId();
 }
 
+mfxStatus msdk_thread_get_affinity(std::vector<mfxU32>& cpus) {
+    // thread mask can't be queried directly, process mask is an upper bound of it
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+        return MFX_ERR_UNKNOWN;
+
+    cpus.clear();
+    for (mfxU32 cpu = 0; cpu < 8 * sizeof(DWORD_PTR); cpu++) {
+        if (processMask & ((DWORD_PTR)1 << cpu))
+            cpus.push_back(cpu);
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_thread_set_affinity(const std::vector<mfxU32>& cpus) {
+    if (cpus.empty())
+        return MFX_ERR_NONE;
+
+    // only the first processor group is supported
+    DWORD_PTR mask = 0;
+    for (mfxU32 cpu : cpus) {
+        if (cpu >= 8 * sizeof(DWORD_PTR))
+            return MFX_ERR_UNSUPPORTED;
+        mask |= (DWORD_PTR)1 << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) ? MFX_ERR_NONE : MFX_ERR_UNKNOWN;
+}
+
+mfxStatus msdk_thread_set_numa_node(mfxI32 node) {
+    // Windows allocates pages from the node of the processor the thread runs on,
+    // so pinning of the thread is enough
+    return MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_get_node_cpus(mfxI32 node, std::vector<mfxU32>& cpus) {
+    ULONGLONG mask = 0;
+    if (node < 0 || node > MAXUCHAR || !GetNumaNodeProcessorMask((UCHAR)node, &mask))
+        return MFX_ERR_UNSUPPORTED;
+
+    cpus.clear();
+    for (mfxU32 cpu = 0; cpu < 8 * sizeof(ULONGLONG); cpu++) {
+        if (mask & (1ULL << cpu))
+            cpus.push_back(cpu);
+    }
+    return cpus.empty() ? MFX_ERR_NOT_FOUND : MFX_ERR_NONE;
+}
+
+mfxStatus msdk_numa_bind_memory(void* ptr, size_t size, mfxI32 node) {
+    return MFX_ERR_UNSUPPORTED;
+}
+
+mfxI32 msdk_numa_get_pci_device_node(mfxU32 domain, mfxU32 bus, mfxU32 device, mfxU32 function) {
+    return -1;
+}
+
+mfxI32 msdk_numa_get_device_node(const msdk_char* devicePath) {
+    return -1;
+}
+
+void* msdk_alloc_pages(size_t size, bool bHugePages) {
+    void* ptr = NULL;
+    // large pages need SeLockMemoryPrivilege, without it the allocation fails
+    SIZE_T largePage = GetLargePageMinimum();
+    if (bHugePages && largePage && !(size % largePage))
+        ptr = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!ptr)
+        ptr = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    return ptr;
+}
+
+void msdk_free_pages(void* ptr, size_t /*size*/) {
+    if (ptr)
+        VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
 #endif // #if defined(_WIN32) || defined(_WIN64)
@@ -24,6 +24,44 @@ msdk_tick msdk_time_get_frequency(void) {
     return t1.QuadPart;
 }
 
+// QPC is derived from the TSC already where the TSC is invariant
+msdk_tick msdk_time_get_precise_tick(void) {
+    return msdk_time_get_tick();
+}
+
+msdk_tick msdk_time_get_precise_frequency(void) {
+    return msdk_time_get_frequency();
+}
+
+    #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+    #endif
+
+void msdk_time_wait_until(msdk_tick deadline) {
+    msdk_tick frequency = msdk_time_get_frequency();
+    // high resolution timers wake up within half a millisecond, Sleep within the scheduler tick
+    msdk_tick spin = frequency / 2000;
+
+    msdk_tick left = deadline - msdk_time_get_tick();
+    if (left > spin) {
+        // timers of this kind are available from Windows 10 1803
+        HANDLE timer = CreateWaitableTimerExW(NULL,
+                                              NULL,
+                                              CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                              TIMER_ALL_ACCESS);
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)((left - spin) * 10000000 / frequency);
+        if (timer && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE))
+            WaitForSingleObject(timer, INFINITE);
+        else if (left > frequency / 500)
+            Sleep((DWORD)((left - frequency / 500) * 1000 / frequency));
+        if (timer)
+            CloseHandle(timer);
+    }
+    while (msdk_time_get_tick() < deadline)
+        YieldProcessor();
+}
+
 mfxU64 rdtsc() {
     return __rdtsc();
 }
@@ -7,9 +7,16 @@
 #if !defined(_WIN32) && !defined(_WIN64)
 
     #include <sys/time.h>
+    #include <time.h>
     #include "vm/time_defs.h"
 
+    #if defined(__x86_64__) || defined(__i386__)
+        #include <cpuid.h>
+    #endif
+
     #define MSDK_TIME_MHZ 1000000
+    // sleeps overshoot by up to the timer slack of the thread, 50 us by default
+    #define MSDK_WAIT_SPIN_US 100
 
 msdk_tick msdk_time_get_tick(void) {
     struct timeval tv;
@@ -22,6 +29,73 @@ msdk_tick msdk_time_get_frequency(void) {
     return (msdk_tick)MSDK_TIME_MHZ;
 }
 
+namespace {
+struct PreciseClock {
+    bool bTSC;
+    msdk_tick frequency;
+};
+
+PreciseClock InitPreciseClock() {
+    PreciseClock clock = { false, 1000000000 }; // CLOCK_MONOTONIC in ns
+    #if defined(__x86_64__) || defined(__i386__)
+    // invariant TSC runs at the same rate in all power states and on all cores
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+        return clock;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    if (!(edx & (1 << 8)))
+        return clock;
+
+    // the rate is counted against the monotonic clock once
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    mfxU64 tsc0 = rdtsc();
+    usleep(10000);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    mfxU64 tsc1 = rdtsc();
+
+    mfxI64 ns = (mfxI64)(t1.tv_sec - t0.tv_sec) * 1000000000 + (t1.tv_nsec - t0.tv_nsec);
+    if (ns > 0 && tsc1 > tsc0) {
+        clock.bTSC      = true;
+        clock.frequency = (msdk_tick)((mfxF64)(tsc1 - tsc0) * 1000000000 / ns);
+    }
+    #endif
+    return clock;
+}
+
+const PreciseClock& GetPreciseClock() {
+    static const PreciseClock clock = InitPreciseClock();
+    return clock;
+}
+} // namespace
+
+msdk_tick msdk_time_get_precise_tick(void) {
+    if (GetPreciseClock().bTSC)
+        return (msdk_tick)rdtsc();
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (msdk_tick)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+msdk_tick msdk_time_get_precise_frequency(void) {
+    return GetPreciseClock().frequency;
+}
+
+void msdk_time_wait_until(msdk_tick deadline) {
+    // ticks are of the wall clock, so the sleeps are relative to not follow its adjustments
+    msdk_tick left = deadline - msdk_time_get_tick();
+    while (left > MSDK_WAIT_SPIN_US) {
+        struct timespec sleepTime;
+        sleepTime.tv_sec  = (time_t)((left - MSDK_WAIT_SPIN_US) / MSDK_TIME_MHZ);
+        sleepTime.tv_nsec = (long)((left - MSDK_WAIT_SPIN_US) % MSDK_TIME_MHZ) * 1000;
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &sleepTime, NULL);
+        left = deadline - msdk_time_get_tick();
+    }
+    while (msdk_time_get_tick() < deadline) {
+    }
+}
+
 mfxU64 rdtsc(void) {
     unsigned int lo, hi;
     __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
@@ -196,6 +196,30 @@ mfxStatus VPLImplementationLoader::ConfigureVersion(mfxVersion const version) {
     return sts;
 }
 
+mfxStatus VPLImplementationLoader::ConfigureThreads(mfxU16 numThread,
+                                                    mfxI32 schedulingType,
+                                                    mfxI32 priority) {
+    if (!numThread && !schedulingType && !priority)
+        return MFX_ERR_NONE;
+
+    // dispatcher keeps a copy of the buffer and attaches it to the sessions it creates
+    mfxExtThreadsParam threadsPar = {};
+    threadsPar.Header.BufferId    = MFX_EXTBUFF_THREADS_PARAM;
+    threadsPar.Header.BufferSz    = sizeof(threadsPar);
+    threadsPar.NumThread          = numThread;
+    threadsPar.SchedulingType     = schedulingType;
+    threadsPar.Priority           = priority;
+
+    mfxConfig cfg = MFXCreateConfig(m_Loader);
+    mfxVariant variant;
+    variant.Type     = MFX_VARIANT_TYPE_PTR;
+    variant.Data.Ptr = mfxHDL(&threadsPar);
+    mfxStatus sts    = MFXSetConfigFilterProperty(cfg, (mfxU8*)"ExtBuffer", variant);
+    MSDK_CHECK_STATUS(sts, "MFXSetConfigFilterProperty(ExtBuffer) failed");
+
+    return sts;
+}
+
 #ifdef ONEVPL_EXPERIMENTAL
     #if defined(_WIN32)
 mfxStatus VPLImplementationLoader::SetupLUID(LUID luid) {
@@ -530,6 +554,31 @@ std::pair<mfxI16, mfxI32> VPLImplementationLoader::GetDeviceIDAndAdapter() const
     return result;
 }
 
+std::vector<mfxI32> VPLImplementationLoader::GetAdapterNumbers() const {
+    std::vector<mfxI32> adapters;
+    mfxImplDescription* idesc = nullptr;
+
+    for (mfxU32 impl = 0;
+         MFXEnumImplementations(m_Loader, impl, MFX_IMPLCAPS_IMPLDESCSTRUCTURE, (mfxHDL*)&idesc) ==
+         MFX_ERR_NONE;
+         impl++) {
+        if (!idesc)
+            break;
+
+        mfxI32 adapterNum = GetAdapterNumber(idesc->Dev.DeviceID);
+        if (!(idesc->ApiVersion < m_MinVersion) && idesc->Impl == MFX_IMPL_TYPE_HARDWARE &&
+            adapterNum >= 0 &&
+            std::find(adapters.begin(), adapters.end(), adapterNum) == adapters.end())
+            adapters.push_back(adapterNum);
+
+        MFXDispReleaseImplDescription(m_Loader, idesc);
+        idesc = nullptr;
+    }
+
+    std::sort(adapters.begin(), adapters.end());
+    return adapters;
+}
+
 mfxU16 VPLImplementationLoader::GetAdapterType() const {
     return m_idesc ? m_idesc->Dev.MediaAdapterType : mfxMediaAdapterType::MFX_MEDIA_UNKNOWN;
 }
@@ -15,13 +15,17 @@
     #include <dxva2api.h>
 #endif
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include "decode_render.h"
+#include "demux_reader.h"
 #include "hw_device.h"
 #include "mfx_buffering.h"
 
 #include "base_allocator.h"
+#include "bitstream_index.h"
 #include "sample_utils.h"
 #include "vpl_implementation_loader.h"
 
@@ -83,6 +87,7 @@ struct sInputParams {
     mfxU16 nThreadsNum;
     mfxI32 SchedulingType;
     mfxI32 Priority;
+    std::vector<mfxU32> CpuAffinity; // CPUs of the application and runtime threads
 
     mfxU16 Width;
     mfxU16 Height;
@@ -95,6 +100,15 @@ struct sInputParams {
     bool outI420;
 
     bool bPerfMode;
+    bool bEngineUtilization;
+    bool bAllocStatistics;
+    mfxU32 nStreams; // number of decode pipelines running in parallel on one device
+    mfxU32 nDeliveryThreads; // threads writing output file in parallel with decoding
+    mfxU32 nBenchLoops; // throughput benchmark: input is preloaded and decoded this many times
+    bool bMappedInput; // input file is mapped to memory and not copied to the bitstream
+    bool bKeyFrames; // only key frames are decoded, about one per dKeyFrameInterval seconds
+    mfxF64 dKeyFrameInterval;
+    bool bInputList; // strSrcFile lists JPEG files decoded in one session
     bool bRenderWin;
     mfxU32 nRenderWinX;
     mfxU32 nRenderWinY;
@@ -173,6 +187,8 @@ public:
     virtual void Close();
     virtual mfxStatus ResetDecoder(sInputParams* pParams);
     virtual mfxStatus ResetDevice();
+    // next Init() uses loader and device of the pipeline, it must outlive this one
+    void ShareDevice(const CDecodingPipeline& pipeline);
 
     void SetMultiView();
     virtual void PrintInfo();
@@ -227,6 +243,9 @@ protected: // functions
      */
     virtual mfxStatus SyncOutputSurface(mfxU32 wait);
     virtual mfxStatus DeliverOutput(mfxFrameSurface1* frame);
+    // maps frame in parallel with other delivery threads, but writes it in the sync order
+    virtual mfxStatus DeliverOutputInOrder(mfxFrameSurface1* frame, mfxU32 order);
+    mfxStatus WriteOutput(mfxFrameSurface1* frame);
     virtual void PrintPerFrameStat(bool force = false);
 
     virtual void DeliverLoop();
@@ -234,12 +253,15 @@ protected: // functions
     virtual mfxStatus ReallocCurrentSurface(const mfxFrameInfo& info);
 
 protected: // variables
-    CSmplYUVWriter m_FileWriter;
+    CAsyncYUVWriter m_FileWriter;
     std::unique_ptr<CSmplBitstreamReader> m_FileReader;
+    CKeyFrameReader* m_pKeyFrameReader; // m_FileReader in key frames mode, NULL otherwise
+    CJPEGBatchReader* m_pJPEGBatchReader; // m_FileReader of -i_list, NULL otherwise
+    CDemuxBitstreamReader* m_pDemuxReader; // m_FileReader of container input, NULL otherwise
     mfxBitstreamWrapper m_mfxBS; // contains encoded data
     mfxU64 totalBytesProcessed;
 
-    std::unique_ptr<VPLImplementationLoader> m_pLoader;
+    std::shared_ptr<VPLImplementationLoader> m_pLoader;
     MainVideoSession m_mfxSession;
     mfxIMPL m_impl;
     MFXVideoDECODE* m_pmfxDEC;
@@ -265,6 +287,12 @@ protected: // variables
     MSDKEvent* m_pDeliveredEvent; // to signal when output surfaces will be processed
     mfxStatus m_error; // error returned by DeliverOutput method
     bool m_bStopDeliverLoop;
+    mfxU32 m_nDeliveryThreads; // number of DeliverLoop threads, 0 - deliver from decoding thread
+    mfxU32 m_nDeliveryQueueDepth; // max number of synced frames waiting for delivery
+    std::mutex m_DeliverMutex;
+    std::condition_variable m_DeliverTurn; // signals when next frame in order may be written
+    mfxU32 m_nDeliverTicket; // order of the next surface taken from delivered surfaces pool
+    mfxU32 m_nWriteTicket; // order of the next surface to be written
 
     eWorkMode m_eWorkMode; // work mode for the pipeline
     bool m_bIsMVC; // enables MVC mode (need to support several files as an output)
@@ -272,7 +300,11 @@ protected: // variables
     bool m_bIsCompleteFrame;
     mfxU32 m_fourcc; // color format of vpp out, i420 by default
     bool m_bPrintLatency;
+    mfxU32 m_nBenchLoops; // number of input loops in benchmark mode, 0 if benchmark is off
+    mfxU32 m_nBenchLoop;
+    bool m_bMappedInput; // bitstream refers to the mapped input file and can't be extended
     bool m_bOutI420;
+    bool m_bAllocStatistics; // printed when the allocator is deleted
 
     mfxU16 m_vppOutWidth;
     mfxU16 m_vppOutHeight;
@@ -296,6 +328,7 @@ protected: // variables
     std::string m_strDevicePath; //path to device for processing
 #endif
     CHWDevice* m_hwdev;
+    bool m_bSharedDevice; // loader and device belong to another pipeline
 #if D3D_SURFACES_SUPPORT
     CDecodeD3DRender m_d3dRender;
 #endif
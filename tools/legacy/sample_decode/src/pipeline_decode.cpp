@@ -15,6 +15,7 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <thread>
 #include "pipeline_decode.h"
@@ -49,6 +50,9 @@
 CDecodingPipeline::CDecodingPipeline()
         : m_FileWriter(),
           m_FileReader(),
+          m_pKeyFrameReader(NULL),
+          m_pJPEGBatchReader(NULL),
+          m_pDemuxReader(NULL),
           m_mfxBS(8 * 1024 * 1024),
           totalBytesProcessed(0),
           m_pLoader(),
@@ -73,13 +77,23 @@ CDecodingPipeline::CDecodingPipeline()
           m_pDeliveredEvent(NULL),
           m_error(MFX_ERR_NONE),
           m_bStopDeliverLoop(false),
+          m_nDeliveryThreads(0),
+          m_nDeliveryQueueDepth(0),
+          m_DeliverMutex(),
+          m_DeliverTurn(),
+          m_nDeliverTicket(0),
+          m_nWriteTicket(0),
           m_eWorkMode(MODE_PERFORMANCE),
           m_bIsMVC(false),
           m_bIsVideoWall(false),
           m_bIsCompleteFrame(false),
           m_fourcc(0),
           m_bPrintLatency(false),
+          m_nBenchLoops(0),
+          m_nBenchLoop(0),
+          m_bMappedInput(false),
           m_bOutI420(false),
+          m_bAllocStatistics(false),
           m_vppOutWidth(0),
           m_vppOutHeight(0),
           m_nTimeout(0),
@@ -97,6 +111,7 @@ CDecodingPipeline::CDecodingPipeline()
           m_strDevicePath(),
 #endif
           m_hwdev(NULL),
+          m_bSharedDevice(false),
 #if D3D_SURFACES_SUPPORT
           m_d3dRender(),
 #endif
@@ -201,7 +216,7 @@ mfxStatus CDecodingPipeline::GetImpl(const sInputParams& params, mfxIMPL& impl)
     for (mfxU32 i = 0;; ++i) {
         sts = m_FileReader->ReadNextFrame(&dummy_stream);
 
-        if (MFX_ERR_MORE_DATA == sts && i < realloc_limit &&
+        if (MFX_ERR_MORE_DATA == sts && i < realloc_limit && !params.bMappedInput &&
             dummy_stream.MaxLength == dummy_stream.DataLength) {
             // Ignore the error now and alloc more data for bitstream
 
@@ -269,10 +284,34 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
     // prepare input stream file reader
     // for VP8 complete and single frame reader is a requirement
     // create reader that supports completeframe mode for latency oriented scenarios
-    if (pParams->bLowLat || pParams->bCalLat) {
+    if (pParams->bKeyFrames) {
+        // the other frames don't reach the decoder
+        m_pKeyFrameReader = new CKeyFrameReader(pParams->videoType);
+        m_FileReader.reset(m_pKeyFrameReader);
+        m_bIsCompleteFrame = true;
+    }
+    else if (pParams->bInputList) {
+        m_pJPEGBatchReader = new CJPEGBatchReader();
+        m_FileReader.reset(m_pJPEGBatchReader);
+        m_bIsCompleteFrame = true;
+    }
+    else if ((MFX_CODEC_AVC == pParams->videoType || MFX_CODEC_HEVC == pParams->videoType) &&
+             DEMUX_NONE != GetDemuxContainer(pParams->strSrcFile)) {
+        // access units of the container are given from the mapped file
+        m_pDemuxReader = new CDemuxBitstreamReader(true);
+        m_FileReader.reset(m_pDemuxReader);
+        m_bIsCompleteFrame = true;
+        m_bPrintLatency    = pParams->bCalLat;
+    }
+    else if (pParams->bLowLat || pParams->bCalLat) {
         switch (pParams->videoType) {
             case MFX_CODEC_AVC:
-                m_FileReader.reset(new CH264FrameReader());
+                m_FileReader.reset(new CH264FrameReader(pParams->bMappedInput));
+                m_bIsCompleteFrame = true;
+                m_bPrintLatency    = pParams->bCalLat;
+                break;
+            case MFX_CODEC_HEVC:
+                m_FileReader.reset(new CHEVCFrameReader());
                 m_bIsCompleteFrame = true;
                 m_bPrintLatency    = pParams->bCalLat;
                 break;
@@ -289,7 +328,7 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
                 m_bPrintLatency    = pParams->bCalLat;
                 break;
             default:
-                return MFX_ERR_UNSUPPORTED; // latency mode is supported only for H.264 and JPEG codecs
+                return MFX_ERR_UNSUPPORTED; // latency mode is supported only for the codecs above
         }
     }
     else {
@@ -300,10 +339,19 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
                 m_FileReader.reset(new CIVFFrameReader());
                 break;
             default:
-                m_FileReader.reset(new CSmplBitstreamReader());
+                if (pParams->bMappedInput)
+                    m_FileReader.reset(new CMappedBitstreamReader());
+                else if (pParams->nBenchLoops)
+                    m_FileReader.reset(new CMemoryBitstreamReader());
+                else
+                    m_FileReader.reset(new CSmplBitstreamReader());
                 break;
         }
     }
+    m_nBenchLoops      = pParams->nBenchLoops;
+    m_nBenchLoop       = 0;
+    m_bMappedInput     = pParams->bMappedInput || m_pDemuxReader;
+    m_bAllocStatistics = pParams->bAllocStatistics;
 
     if (pParams->fourcc)
         m_fourcc = pParams->fourcc;
@@ -356,11 +404,22 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
     // Initializing file reader
     totalBytesProcessed = 0;
     sts                 = m_FileReader->Init(pParams->strSrcFile);
-    if (sts == MFX_ERR_UNSUPPORTED && pParams->videoType == MFX_CODEC_AV1) {
-        m_FileReader.reset(new CSmplBitstreamReader());
+    if (sts == MFX_ERR_UNSUPPORTED && pParams->videoType == MFX_CODEC_AV1 && !m_pKeyFrameReader) {
+        // OBU stream, complete frames are split out of it in latency mode
+        if (m_bIsCompleteFrame)
+            m_FileReader.reset(new CAV1FrameReader());
+        else
+            m_FileReader.reset(new CSmplBitstreamReader());
         msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, default reader\n"));
+        sts = m_FileReader->Init(pParams->strSrcFile);
     }
     MSDK_CHECK_STATUS(sts, "m_FileReader->Init failed");
+    if (m_pDemuxReader && m_pDemuxReader->GetCodecId() != pParams->videoType) {
+        msdk_printf(MSDK_STRING("error: codec of the container track doesn't match input codec\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+    if (m_pJPEGBatchReader && m_mfxBS.MaxLength < m_pJPEGBatchReader->GetMaxFileSize())
+        m_mfxBS.Extend(m_pJPEGBatchReader->GetMaxFileSize());
 
     mfxInitParamlWrap initPar;
     auto threadsPar = initPar.AddExtBuffer<mfxExtThreadsParam>();
@@ -395,6 +454,14 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
 
     m_eWorkMode = pParams->mode;
 
+    // rendering is always done by one delivery thread, file output may use several of them
+    if (m_eWorkMode == MODE_RENDERING)
+        m_nDeliveryThreads = 1;
+    else if (m_eWorkMode == MODE_FILE_DUMP)
+        m_nDeliveryThreads = pParams->nDeliveryThreads;
+    else
+        m_nDeliveryThreads = 0;
+
     m_monitorType = pParams->monitorType;
     // create device and allocator
 #if defined(LIBVA_SUPPORT)
@@ -403,6 +470,12 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
 
     m_verSessionInit = pParams->verSessionInit;
 
+    // threads of the CPU implementation inherit the affinity of the thread creating the session
+    if (!pParams->CpuAffinity.empty()) {
+        sts = msdk_thread_set_affinity(pParams->CpuAffinity);
+        MSDK_CHECK_STATUS(sts, "msdk_thread_set_affinity failed");
+    }
+
     if (m_verSessionInit == API_1X) {
         initPar.Version.Major = 1;
         initPar.Version.Minor = 0;
@@ -413,6 +486,13 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
         sts = m_mfxSession.InitEx(initPar);
         MSDK_CHECK_STATUS(sts, "m_mfxSession.InitEx failed");
     }
+    else if (m_bSharedDevice) {
+        initPar.Implementation = pParams->bUseHWLib ? MFX_IMPL_HARDWARE : MFX_IMPL_SOFTWARE;
+
+        // implementation is already selected by the pipeline owning the loader
+        sts = m_mfxSession.CreateSession(m_pLoader.get());
+        MSDK_CHECK_STATUS(sts, "m_mfxSession.CreateSession failed");
+    }
     else {
         initPar.Implementation = pParams->bUseHWLib ? MFX_IMPL_HARDWARE : MFX_IMPL_SOFTWARE;
 
@@ -426,6 +506,11 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
         if (pParams->adapterNum >= 0)
             m_pLoader->SetAdapterNum(pParams->adapterNum);
 
+        sts = m_pLoader->ConfigureThreads(threadsPar->NumThread,
+                                          threadsPar->SchedulingType,
+                                          threadsPar->Priority);
+        MSDK_CHECK_STATUS(sts, "m_pLoader->ConfigureThreads failed");
+
 #ifdef ONEVPL_EXPERIMENTAL
         if (pParams->PCIDeviceSetup)
             m_pLoader->SetPCIDevice(pParams->PCIDomain,
@@ -563,6 +648,7 @@ mfxStatus CDecodingPipeline::Init(sInputParams* pParams) {
         // prepare YUV file writer
         sts = m_FileWriter.Init(pParams->strDstFile, pParams->numViews);
         MSDK_CHECK_STATUS(sts, "m_FileWriter.Init failed");
+        m_FileWriter.SetStreamingLoads(m_memType != SYSTEM_MEMORY);
     }
     else if ((m_eWorkMode != MODE_PERFORMANCE) && (m_eWorkMode != MODE_RENDERING)) {
         msdk_printf(MSDK_STRING("error: unsupported work mode\n"));
@@ -751,7 +837,7 @@ mfxStatus CDecodingPipeline::InitMfxParams(sInputParams* pParams) {
         }
 
         if (MFX_ERR_MORE_DATA == sts) {
-            if (m_mfxBS.MaxLength == m_mfxBS.DataLength) {
+            if (!m_bMappedInput && m_mfxBS.MaxLength == m_mfxBS.DataLength) {
                 m_mfxBS.Extend(m_mfxBS.MaxLength * 2);
             }
             // read a portion of data
@@ -826,6 +912,18 @@ mfxStatus CDecodingPipeline::InitMfxParams(sInputParams* pParams) {
         m_mfxVideoParams.mfx.FrameInfo.FrameRateExtN = 30;
         m_mfxVideoParams.mfx.FrameInfo.FrameRateExtD = 1;
     }
+    if (m_pKeyFrameReader) {
+        mfxF64 frameRate = (mfxF64)m_mfxVideoParams.mfx.FrameInfo.FrameRateExtN /
+                           m_mfxVideoParams.mfx.FrameInfo.FrameRateExtD;
+        m_pKeyFrameReader->SetInterval((mfxU32)(pParams->dKeyFrameInterval * frameRate + 0.5));
+    }
+    if (m_pJPEGBatchReader) {
+        // surfaces fit every image of the batch, a smaller image doesn't reallocate them
+        m_mfxVideoParams.mfx.FrameInfo.Width = MSDK_ALIGN16(
+            std::max(m_mfxVideoParams.mfx.FrameInfo.Width, m_pJPEGBatchReader->GetMaxWidth()));
+        m_mfxVideoParams.mfx.FrameInfo.Height = MSDK_ALIGN16(
+            std::max(m_mfxVideoParams.mfx.FrameInfo.Height, m_pJPEGBatchReader->GetMaxHeight()));
+    }
     if (!m_mfxVideoParams.mfx.FrameInfo.AspectRatioW ||
         !m_mfxVideoParams.mfx.FrameInfo.AspectRatioH) {
         msdk_printf(MSDK_STRING("pretending that aspect ratio is 1:1\n"));
@@ -1088,6 +1186,11 @@ mfxStatus CDecodingPipeline::InitVppParams() {
 }
 
 mfxStatus CDecodingPipeline::CreateHWDevice() {
+    if (m_bSharedDevice) {
+        MSDK_CHECK_POINTER(m_hwdev, MFX_ERR_NULL_PTR);
+        return MFX_ERR_NONE;
+    }
+
 #if D3D_SURFACES_SUPPORT
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -1153,6 +1256,14 @@ mfxStatus CDecodingPipeline::CreateHWDevice() {
 }
 
 mfxStatus CDecodingPipeline::ResetDevice() {
+    // other pipelines keep working with the device
+    if (m_bSharedDevice)
+        return MFX_ERR_UNSUPPORTED;
+
+    // the frames are lost with the device
+    if (m_pGeneralAllocator)
+        m_pGeneralAllocator->InvalidateReusableFrames();
+
     if (m_hwdev)
         return m_hwdev->Reset();
 
@@ -1426,6 +1537,10 @@ mfxStatus CDecodingPipeline::CreateAllocator() {
         m_bExternalAlloc = true;
     }
 
+    // resets keeping the resolution reallocate the same frames
+    m_pGeneralAllocator->SetFrameReuse(true);
+    m_pGeneralAllocator->SetLockTiming(m_bAllocStatistics);
+
     // initialize memory allocator
     sts = m_pGeneralAllocator->Init(m_pmfxAllocatorParams);
     MSDK_CHECK_STATUS(sts, "m_pGeneralAllocator->Init failed");
@@ -1450,10 +1565,22 @@ void CDecodingPipeline::DeleteFrames() {
 }
 
 void CDecodingPipeline::DeleteAllocator() {
+    if (m_bAllocStatistics && m_pGeneralAllocator)
+        m_pGeneralAllocator->PrintStatistics();
+
     // delete allocator
     MSDK_SAFE_DELETE(m_pGeneralAllocator);
     MSDK_SAFE_DELETE(m_pmfxAllocatorParams);
-    MSDK_SAFE_DELETE(m_hwdev);
+    if (m_bSharedDevice)
+        m_hwdev = NULL;
+    else
+        MSDK_SAFE_DELETE(m_hwdev);
+}
+
+void CDecodingPipeline::ShareDevice(const CDecodingPipeline& pipeline) {
+    m_pLoader       = pipeline.m_pLoader;
+    m_hwdev         = pipeline.m_hwdev;
+    m_bSharedDevice = true;
 }
 
 void CDecodingPipeline::SetMultiView() {
@@ -1563,20 +1690,13 @@ mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame) {
         return MFX_ERR_NULL_PTR;
     }
 
-    if (m_bResetFileWriter) {
-        sts = m_FileWriter.Reset();
-        MSDK_CHECK_STATUS(sts, "");
-        m_bResetFileWriter = false;
-    }
-
     if (m_bExternalAlloc) {
         if (m_eWorkMode == MODE_FILE_DUMP) {
             res = m_pGeneralAllocator->Lock(m_pGeneralAllocator->pthis,
                                             frame->Data.MemId,
                                             &(frame->Data));
             if (MFX_ERR_NONE == res) {
-                res = m_bOutI420 ? m_FileWriter.WriteNextFrameI420(frame)
-                                 : m_FileWriter.WriteNextFrame(frame);
+                res = WriteOutput(frame);
                 sts = m_pGeneralAllocator->Unlock(m_pGeneralAllocator->pthis,
                                                   frame->Data.MemId,
                                                   &(frame->Data));
@@ -1594,8 +1714,7 @@ mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame) {
         }
     }
     else {
-        res = m_bOutI420 ? m_FileWriter.WriteNextFrameI420(frame)
-                         : m_FileWriter.WriteNextFrame(frame);
+        res = WriteOutput(frame);
     }
 
     m_fpsLimiter.Work();
@@ -1603,6 +1722,60 @@ mfxStatus CDecodingPipeline::DeliverOutput(mfxFrameSurface1* frame) {
     return res;
 }
 
+mfxStatus CDecodingPipeline::DeliverOutputInOrder(mfxFrameSurface1* frame, mfxU32 order) {
+    mfxStatus res = MFX_ERR_NONE, sts = MFX_ERR_NONE;
+    bool bLocked  = false;
+
+    if (!frame) {
+        res = MFX_ERR_NULL_PTR;
+    }
+    else if (m_bExternalAlloc) {
+        res     = m_pGeneralAllocator->Lock(m_pGeneralAllocator->pthis,
+                                            frame->Data.MemId,
+                                            &(frame->Data));
+        bLocked = (MFX_ERR_NONE == res);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_DeliverMutex);
+        m_DeliverTurn.wait(lock, [this, order] { return m_nWriteTicket == order; });
+    }
+
+    // frames after the failed one are dropped to not leave a gap in the output file
+    if ((MFX_ERR_NONE == res) && (MFX_ERR_NONE == m_error)) {
+        CAutoTimer timer_fwrite(m_tick_fwrite);
+        res = WriteOutput(frame);
+        m_fpsLimiter.Work();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_DeliverMutex);
+        ++m_nWriteTicket;
+    }
+    m_DeliverTurn.notify_all();
+
+    if (bLocked) {
+        sts = m_pGeneralAllocator->Unlock(m_pGeneralAllocator->pthis,
+                                          frame->Data.MemId,
+                                          &(frame->Data));
+    }
+    if ((MFX_ERR_NONE == res) && (MFX_ERR_NONE != sts)) {
+        res = sts;
+    }
+
+    return res;
+}
+
+mfxStatus CDecodingPipeline::WriteOutput(mfxFrameSurface1* frame) {
+    if (m_bResetFileWriter) {
+        mfxStatus sts = m_FileWriter.Reset();
+        MSDK_CHECK_STATUS(sts, "");
+        m_bResetFileWriter = false;
+    }
+
+    return m_bOutI420 ? m_FileWriter.WriteNextFrameI420(frame) : m_FileWriter.WriteNextFrame(frame);
+}
+
 void CDecodingPipeline::DeliverLoop(void) {
     while (!m_bStopDeliverLoop) {
         m_pDeliverOutputSemaphore->Wait();
@@ -1612,14 +1785,27 @@ void CDecodingPipeline::DeliverLoop(void) {
         if (MFX_ERR_NONE != m_error) {
             continue;
         }
-        msdkOutputSurface* pCurrentDeliveredSurface = m_DeliveredSurfacesPool.GetSurface();
+        msdkOutputSurface* pCurrentDeliveredSurface = NULL;
+        mfxU32 order                                = 0;
+        {
+            // the pool allows only one taking thread at a time
+            std::lock_guard<std::mutex> lock(m_DeliverMutex);
+            pCurrentDeliveredSurface = m_DeliveredSurfacesPool.GetSurface();
+            if (pCurrentDeliveredSurface) {
+                order = m_nDeliverTicket++;
+            }
+        }
         if (!pCurrentDeliveredSurface) {
             m_error = MFX_ERR_NULL_PTR;
             continue;
         }
         mfxFrameSurface1* frame = &(pCurrentDeliveredSurface->surface->frame);
 
-        m_error = DeliverOutput(frame);
+        mfxStatus sts = (m_eWorkMode == MODE_FILE_DUMP) ? DeliverOutputInOrder(frame, order)
+                                                        : DeliverOutput(frame);
+        if (MFX_ERR_NONE != sts) {
+            m_error = sts;
+        }
         ReturnSurfaceToBuffers(pCurrentDeliveredSurface);
 
         pCurrentDeliveredSurface = NULL;
@@ -1666,7 +1852,11 @@ mfxStatus CDecodingPipeline::SyncOutputSurface(mfxU32 wait) {
         return MFX_ERR_MORE_DATA;
     }
 
-    mfxStatus sts = m_mfxSession.SyncOperation(m_pCurrentOutputSurface->syncp, wait);
+    mfxStatus sts;
+    {
+        MFX_ITT_TASK("SyncOperation");
+        sts = m_mfxSession.SyncOperation(m_pCurrentOutputSurface->syncp, wait);
+    }
 
     if (MFX_ERR_GPU_HANG == sts && m_bSoftRobustFlag) {
         msdk_printf(MSDK_STRING("GPU hang happened\n"));
@@ -1678,10 +1868,16 @@ mfxStatus CDecodingPipeline::SyncOutputSurface(mfxU32 wait) {
     if (MFX_WRN_IN_EXECUTION == sts) {
         return sts;
     }
+    if ((MFX_ERR_NONE == sts) && m_nDeliveryThreads && (m_synced_count >= m_nFrames)) {
+        // delivery lags behind, frames over the limit must not reach the output
+        ReturnSurfaceToBuffers(m_pCurrentOutputSurface);
+        m_pCurrentOutputSurface = NULL;
+        return sts;
+    }
     if (MFX_ERR_NONE == sts) {
         // we got completely decoded frame - pushing it to the delivering thread...
         ++m_synced_count;
-        if (m_bPrintLatency) {
+        if (m_bPrintLatency || m_nBenchLoops) {
             m_vLatency.push_back(m_timer_overall.Sync() - m_pCurrentOutputSurface->surface->submit);
         }
         else {
@@ -1693,6 +1889,22 @@ mfxStatus CDecodingPipeline::SyncOutputSurface(mfxU32 wait) {
             m_fpsLimiter.Work();
             ReturnSurfaceToBuffers(m_pCurrentOutputSurface);
         }
+        else if (m_nDeliveryThreads) {
+            // the copy to the CPU runs while the delivery threads write the previous frames
+            if ((m_eWorkMode == MODE_FILE_DUMP) && (m_memType == D3D11_MEMORY)) {
+                m_pGeneralAllocator->StartReadback(
+                    m_pCurrentOutputSurface->surface->frame.Data.MemId);
+            }
+            m_DeliveredSurfacesPool.AddSurface(m_pCurrentOutputSurface);
+            m_pDeliveredEvent->Reset();
+            m_pDeliverOutputSemaphore->Post();
+
+            // backpressure: don't let decoding run too far ahead of the delivery threads
+            while ((m_synced_count - m_output_count > m_nDeliveryQueueDepth) &&
+                   (MFX_ERR_NONE == m_error)) {
+                m_pDeliveredEvent->TimedWait(MSDK_DEC_WAIT_INTERVAL);
+            }
+        }
         else if (m_eWorkMode == MODE_FILE_DUMP) {
             sts = DeliverOutput(&(m_pCurrentOutputSurface->surface->frame));
             if (MFX_ERR_NONE != sts) {
@@ -1703,11 +1915,6 @@ mfxStatus CDecodingPipeline::SyncOutputSurface(mfxU32 wait) {
             }
             ReturnSurfaceToBuffers(m_pCurrentOutputSurface);
         }
-        else if (m_eWorkMode == MODE_RENDERING) {
-            m_DeliveredSurfacesPool.AddSurface(m_pCurrentOutputSurface);
-            m_pDeliveredEvent->Reset();
-            m_pDeliverOutputSemaphore->Post();
-        }
         m_pCurrentOutputSurface = NULL;
     }
 
@@ -1721,13 +1928,21 @@ mfxStatus CDecodingPipeline::RunDecoding() {
     bool bErrIncompatibleVideoParams = false;
     CTimeInterval<> decodeTimer(m_bIsCompleteFrame);
     time_t start_time = time(0);
-    std::thread deliverThread;
+    std::vector<std::thread> deliverThreads;
 
-    if (m_eWorkMode == MODE_RENDERING) {
+    if (m_nDeliveryThreads) {
         m_pDeliverOutputSemaphore = new MSDKSemaphore(sts);
         m_pDeliveredEvent         = new MSDKEvent(sts, false, false);
-
-        deliverThread = std::thread(&CDecodingPipeline::DeliverLoop, this);
+        m_error                   = MFX_ERR_NONE;
+        m_bStopDeliverLoop        = false;
+        m_nDeliverTicket          = 0;
+        m_nWriteTicket            = 0;
+        m_nDeliveryQueueDepth =
+            std::max<mfxU32>(m_mfxVideoParams.AsyncDepth, m_nDeliveryThreads);
+
+        for (mfxU32 i = 0; i < m_nDeliveryThreads; i++) {
+            deliverThreads.push_back(std::thread(&CDecodingPipeline::DeliverLoop, this));
+        }
     }
 
     while (((sts == MFX_ERR_NONE) || (MFX_ERR_MORE_DATA == sts) || (MFX_ERR_MORE_SURFACE == sts)) &&
@@ -1741,13 +1956,17 @@ mfxStatus CDecodingPipeline::RunDecoding() {
             ((MFX_ERR_MORE_DATA == sts) || (m_bIsCompleteFrame && !pBitstream->DataLength))) {
             CAutoTimer timer_fread(m_tick_fread);
             sts = m_FileReader->ReadNextFrame(pBitstream); // read more data to input bit stream
+            MFX_ITT_COUNTER("DecodeBitstreamBytes", pBitstream->DataLength);
 
             if (MFX_ERR_MORE_DATA == sts) {
                 sts = MFX_ERR_NONE;
                 // Timeout has expired or videowall mode
                 m_timer_overall.Sync();
+                bool bRepeatInput = m_nBenchLoops && (m_nBenchLoop + 1 < m_nBenchLoops);
+                if (bRepeatInput)
+                    m_nBenchLoop++;
                 if (((CTimer::ConvertToSeconds(m_tick_overall) < m_nTimeout) && m_nTimeout) ||
-                    m_bIsVideoWall) {
+                    m_bIsVideoWall || bRepeatInput) {
                     m_FileReader->Reset();
                     m_bResetFileWriter = true;
 
@@ -1797,16 +2016,11 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                 // we stuck with no free surface available, now we will sync...
                 sts = SyncOutputSurface(MSDK_DEC_WAIT_INTERVAL);
                 if (MFX_ERR_MORE_DATA == sts) {
-                    if ((m_eWorkMode == MODE_PERFORMANCE) || (m_eWorkMode == MODE_FILE_DUMP)) {
-                        sts = MFX_ERR_NOT_FOUND;
+                    if (m_nDeliveryThreads && (m_synced_count != m_output_count)) {
+                        sts = m_pDeliveredEvent->TimedWait(MSDK_DEC_WAIT_INTERVAL);
                     }
-                    else if (m_eWorkMode == MODE_RENDERING) {
-                        if (m_synced_count != m_output_count) {
-                            sts = m_pDeliveredEvent->TimedWait(MSDK_DEC_WAIT_INTERVAL);
-                        }
-                        else {
-                            sts = MFX_ERR_NOT_FOUND;
-                        }
+                    else {
+                        sts = MFX_ERR_NOT_FOUND;
                     }
                     if (MFX_ERR_NOT_FOUND == sts) {
                         msdk_printf(
@@ -1847,14 +2061,17 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                                                                pBitstream->NumExtParam,
                                                                MFX_EXTBUFF_DECODE_ERROR_REPORT);
                 }
-                sts = m_pmfxDEC->DecodeFrameAsync(pBitstream,
-                                                  &(m_pCurrentFreeSurface->frame),
-                                                  &pOutSurface,
-                                                  &(m_pCurrentFreeOutputSurface->syncp));
+                {
+                    MFX_ITT_TASK("DecodeFrameAsync");
+                    sts = m_pmfxDEC->DecodeFrameAsync(pBitstream,
+                                                      &(m_pCurrentFreeSurface->frame),
+                                                      &pOutSurface,
+                                                      &(m_pCurrentFreeOutputSurface->syncp));
+                }
 
                 PrintDecodeErrorReport(errorReport);
 
-                if (pBitstream && MFX_ERR_MORE_DATA == sts &&
+                if (pBitstream && MFX_ERR_MORE_DATA == sts && !m_bMappedInput &&
                     pBitstream->MaxLength == pBitstream->DataLength) {
                     m_mfxBS.Extend(pBitstream->MaxLength * 2);
                 }
@@ -1910,8 +2127,8 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                 if (sts)
                     MSDK_PRINT_WRN_MSG(sts, "SyncOutputSurface failed")
 
-                while (m_synced_count != m_output_count) {
-                    m_pDeliveredEvent->Wait();
+                while ((m_synced_count != m_output_count) && (MFX_ERR_NONE == m_error)) {
+                    m_pDeliveredEvent->TimedWait(MSDK_DEC_WAIT_INTERVAL);
                 }
                 break;
             }
@@ -1982,10 +2199,14 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                         // WA: RunFrameVPPAsync doesn't copy ViewId from input to output
                         m_pCurrentFreeVppSurface->frame.Info.FrameId.ViewId =
                             pOutSurface->Info.FrameId.ViewId;
-                        sts = m_pmfxVPP->RunFrameVPPAsync(pOutSurface,
-                                                          &(m_pCurrentFreeVppSurface->frame),
-                                                          NULL,
-                                                          &(m_pCurrentFreeOutputSurface->syncp));
+                        {
+                            MFX_ITT_TASK("RunFrameVPPAsync");
+                            sts = m_pmfxVPP->RunFrameVPPAsync(
+                                pOutSurface,
+                                &(m_pCurrentFreeVppSurface->frame),
+                                NULL,
+                                &(m_pCurrentFreeOutputSurface->syncp));
+                        }
 
                         if (MFX_WRN_DEVICE_BUSY == sts) {
                             MSDK_SLEEP(
@@ -2006,6 +2227,8 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                     msdk_atomic_inc16(&(m_pCurrentFreeVppSurface->render_lock));
 
                     m_pCurrentFreeOutputSurface->surface = m_pCurrentFreeVppSurface;
+                    if (m_nBenchLoops)
+                        m_pCurrentFreeVppSurface->submit = m_timer_overall.Sync();
                     m_OutputSurfacesPool.AddSurface(m_pCurrentFreeOutputSurface);
 
                     m_pCurrentFreeOutputSurface = NULL;
@@ -2018,6 +2241,9 @@ mfxStatus CDecodingPipeline::RunDecoding() {
                 msdk_atomic_inc16(&(surface->render_lock));
 
                 m_pCurrentFreeOutputSurface->surface = surface;
+                // benchmark measures latency of the sync, from the output till its completion
+                if (m_nBenchLoops)
+                    surface->submit = m_timer_overall.Sync();
                 m_OutputSurfacesPool.AddSurface(m_pCurrentFreeOutputSurface);
                 m_pCurrentFreeOutputSurface = NULL;
             }
@@ -2036,17 +2262,19 @@ mfxStatus CDecodingPipeline::RunDecoding() {
 
     PrintPerFrameStat(true);
 
-    if (m_bPrintLatency && m_vLatency.size() > 0) {
+    if ((m_bPrintLatency || m_nBenchLoops) && m_vLatency.size() > 0) {
         unsigned int frame_idx = 0;
         msdk_tick sum          = 0;
         for (std::vector<msdk_tick>::iterator it = m_vLatency.begin(); it != m_vLatency.end();
              ++it) {
             sum += *it;
-            msdk_printf(MSDK_STRING("Frame %4d, latency=%5.5f ms\n"),
-                        ++frame_idx,
-                        (double)(CTimer::ConvertToSeconds(*it) * 1000));
+            if (m_bPrintLatency)
+                msdk_printf(MSDK_STRING("Frame %4d, latency=%5.5f ms\n"),
+                            ++frame_idx,
+                            (double)(CTimer::ConvertToSeconds(*it) * 1000));
         }
-        msdk_printf(MSDK_STRING("\nLatency summary:\n"));
+        msdk_printf(m_bPrintLatency ? MSDK_STRING("\nLatency summary:\n")
+                                    : MSDK_STRING("\nSync latency summary:\n"));
         msdk_printf(
             MSDK_STRING("\nAVG=%5.5f ms, MAX=%5.5f ms, MIN=%5.5f ms"),
             (double)CTimer::ConvertToSeconds((msdk_tick)((mfxF64)sum / m_vLatency.size())) * 1000,
@@ -2056,14 +2284,38 @@ mfxStatus CDecodingPipeline::RunDecoding() {
             (double)CTimer::ConvertToSeconds(
                 *std::min_element(m_vLatency.begin(), m_vLatency.end())) *
                 1000);
+
+        // tail of the distribution for benchmark comparisons
+        if (m_nBenchLoops) {
+            std::vector<msdk_tick> sorted = m_vLatency;
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&sorted](mfxF64 p) {
+                size_t rank = (size_t)std::ceil(p * sorted.size());
+                return (double)CTimer::ConvertToSeconds(sorted[std::max<size_t>(rank, 1) - 1]) *
+                       1000;
+            };
+            msdk_printf(MSDK_STRING("\nP50=%5.5f ms, P90=%5.5f ms, P99=%5.5f ms"),
+                        percentile(0.5),
+                        percentile(0.9),
+                        percentile(0.99));
+        }
     }
 
-    if (m_eWorkMode == MODE_RENDERING) {
+    if (m_nDeliveryThreads) {
         m_bStopDeliverLoop = true;
-        m_pDeliverOutputSemaphore->Post();
+        for (size_t i = 0; i < deliverThreads.size(); i++) {
+            m_pDeliverOutputSemaphore->Post();
+        }
+
+        for (std::thread& deliverThread : deliverThreads) {
+            if (deliverThread.joinable())
+                deliverThread.join();
+        }
 
-        if (deliverThread.joinable())
-            deliverThread.join();
+        if ((MFX_ERR_NONE == sts) && (MFX_ERR_NONE != m_error)) {
+            msdk_printf(MSDK_STRING("DeliverOutput return error = %d\n"), (int)m_error);
+            sts = m_error;
+        }
     }
 
     MSDK_SAFE_DELETE(m_pDeliverOutputSemaphore);
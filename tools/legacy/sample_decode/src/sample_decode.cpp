@@ -6,8 +6,11 @@
 
 #include "mfx_samples_config.h"
 
+#include <memory>
 #include <regex>
 #include <sstream>
+#include <thread>
+#include "engine_utilization.h"
 #include "pipeline_decode.h"
 #include "version.h"
 
@@ -26,6 +29,12 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage) {
     msdk_printf(MSDK_STRING("   or: %s <codecid> [<options>] -i InputBitstream -r\n"), strAppName);
     msdk_printf(MSDK_STRING("   or: %s <codecid> [<options>] -i InputBitstream -o OutputYUVFile\n"),
                 strAppName);
+    msdk_printf(MSDK_STRING(
+        "   Inputs and outputs may be streams: - (stdin), pipe:<command>, tcp://[host]:port, udp://[host]:port\n"));
+    msdk_printf(MSDK_STRING(
+        "   MP4, Matroska and MPEG-TS input files of h264 and h265 are demuxed, access units of the first video\n"));
+    msdk_printf(MSDK_STRING(
+        "   track are given to the decoder as complete frames from the file mapped to memory\n"));
     msdk_printf(MSDK_STRING("\n"));
     msdk_printf(MSDK_STRING("Supported codecs (<codecid>):\n"));
     msdk_printf(
@@ -96,7 +105,7 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage) {
     msdk_printf(MSDK_STRING("   [-jpeg_rgb] - RGB Chroma Type\n"));
     msdk_printf(MSDK_STRING("Output format parameters:\n"));
     msdk_printf(
-        MSDK_STRING("   [-i420] - pipeline output format: NV12, output file format: I420\n"));
+        MSDK_STRING("   [-i420] - pipeline output format: YV12 (converted by vpp), output file format: I420\n"));
     msdk_printf(
         MSDK_STRING("   [-nv12] - pipeline output format: NV12, output file format: NV12\n"));
     msdk_printf(
@@ -152,9 +161,37 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage) {
         MSDK_STRING("   [-window x y w h]         - set render window position and size\n"));
 #endif
     msdk_printf(MSDK_STRING(
-        "   [-low_latency]            - configures decoder for low latency mode (supported only for H.264 and JPEG codec)\n"));
+        "   [-low_latency]            - configures decoder for low latency mode (supported only for H.264, H.265, AV1 and JPEG codec)\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-calc_latency]           - calculates latency during decoding and prints log (supported only for H.264, H.265, AV1 and JPEG codec)\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-engine_util]            - sample GPU engine utilization while decoding and print average at the end\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-alloc_stat]             - print memory held by the frame allocator and latencies of its Lock and Unlock at the end\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-streams n]              - decode the input in n pipelines in parallel on one device and print fps of\n"));
+    msdk_printf(MSDK_STRING(
+        "                               each stream and in total, performance mode only\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-bench n]                - decode throughput benchmark: input preloaded to memory is decoded n times,\n"));
+    msdk_printf(MSDK_STRING(
+        "                               output is synced only, prints fps, fps per watt, energy per frame and sync latency\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-mmap]                   - map input file to memory and give the decoder parts of the mapping without copying,\n"));
+    msdk_printf(MSDK_STRING(
+        "                               with -low_latency H.264 frames are indexed before decoding\n"));
     msdk_printf(MSDK_STRING(
-        "   [-calc_latency]           - calculates latency during decoding and prints log (supported only for H.264 and JPEG codec)\n"));
+        "   [-i_list file]            - decode in one session jpeg files listed in file one per line, images of the same\n"));
+    msdk_printf(MSDK_STRING(
+        "                               subsampling and size are decoded one after another and files are read ahead\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-key_frames sec]         - decode only key frames, at most one per sec seconds of the stream (0 - all of them),\n"));
+    msdk_printf(MSDK_STRING(
+        "                               the other frames are skipped in the input. With -w and -h for thumbnails\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-delivery_threads n]     - map and write output frames from n threads in parallel with decoding,\n"));
+    msdk_printf(MSDK_STRING(
+        "                               frames are written in order, by default output is written from decoding thread\n"));
     msdk_printf(MSDK_STRING(
         "   [-async]                  - depth of asynchronous pipeline. default value is 4. must be between 1 and 20\n"));
     msdk_printf(MSDK_STRING("   [-gpucopy::<on,off>] Enable or disable GPU copy mode\n"));
@@ -180,6 +217,8 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage) {
     msdk_printf(MSDK_STRING("\n"));
     msdk_thread_printf_scheduling_help();
 #endif
+    msdk_printf(MSDK_STRING(
+        "   [-cpu_affinity <cpu-list>] - run decoding and the threads of the CPU implementation on given CPUs, e.g. 0-7,16-23\n"));
 #if defined(_WIN32) || defined(_WIN64)
     msdk_printf(MSDK_STRING("   [-jpeg_rotate n]          - rotate jpeg frame n degrees \n"));
     msdk_printf(MSDK_STRING("       n(90,180,270)         - number of degrees \n"));
@@ -348,6 +387,7 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
             switch (pParams->videoType) {
                 case MFX_CODEC_HEVC:
                 case MFX_CODEC_AVC:
+                case MFX_CODEC_AV1:
                 case MFX_CODEC_JPEG: {
                     pParams->bLowLat = true;
                     if (!pParams->bIsMVC)
@@ -356,7 +396,7 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 default: {
                     PrintHelp(strInput[0],
                               MSDK_STRING(
-                                  "-low_latency mode is suppoted only for H.264 and JPEG codecs"));
+                                  "-low_latency mode is suppoted only for H.264, H.265, AV1 and JPEG codecs"));
                     return MFX_ERR_UNSUPPORTED;
                 }
             }
@@ -378,10 +418,74 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-engine_util"))) {
+            pParams->bEngineUtilization = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-alloc_stat"))) {
+            pParams->bAllocStatistics = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-streams"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -streams key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nStreams) ||
+                !pParams->nStreams) {
+                PrintHelp(strInput[0], MSDK_STRING("number of streams is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-bench"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -bench key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nBenchLoops) ||
+                !pParams->nBenchLoops) {
+                PrintHelp(strInput[0], MSDK_STRING("number of benchmark loops is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-i_list"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -i_list key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            msdk_opt_read(strInput[++i], pParams->strSrcFile);
+            pParams->bInputList = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-key_frames"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -key_frames key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->dKeyFrameInterval) ||
+                pParams->dKeyFrameInterval < 0) {
+                PrintHelp(strInput[0], MSDK_STRING("key frame interval is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            pParams->bKeyFrames = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-mmap"))) {
+            pParams->bMappedInput = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-delivery_threads"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0],
+                          MSDK_STRING("Not enough parameters for -delivery_threads key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nDeliveryThreads) ||
+                !pParams->nDeliveryThreads) {
+                PrintHelp(strInput[0], MSDK_STRING("number of delivery threads is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-calc_latency"))) {
             switch (pParams->videoType) {
                 case MFX_CODEC_HEVC:
                 case MFX_CODEC_AVC:
+                case MFX_CODEC_AV1:
                 case MFX_CODEC_JPEG: {
                     pParams->bCalLat = true;
                     if (!pParams->bIsMVC)
@@ -390,7 +494,7 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 default: {
                     PrintHelp(strInput[0],
                               MSDK_STRING(
-                                  "-calc_latency mode is suppoted only for H.264 and JPEG codecs"));
+                                  "-calc_latency mode is suppoted only for H.264, H.265, AV1 and JPEG codecs"));
                     return MFX_ERR_UNSUPPORTED;
                 }
             }
@@ -625,6 +729,16 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
             }
         }
 #endif // #if !defined(_WIN32) && !defined(_WIN64)
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-cpu_affinity"))) {
+            if (i + 1 >= nArgNum) {
+                PrintHelp(strInput[0], MSDK_STRING("Not enough parameters for -cpu_affinity key"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            if (MFX_ERR_NONE != msdk_parse_cpu_list(strInput[++i], pParams->CpuAffinity)) {
+                PrintHelp(strInput[0], MSDK_STRING("cpu_affinity is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-dec_postproc"))) {
             if (i + 1 >= nArgNum) {
                 PrintHelp(
@@ -695,7 +809,9 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
             }
         }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-i420"))) {
-            pParams->fourcc  = MFX_FOURCC_NV12;
+            // planar output is produced by vpp on the device, so the file writer only has to
+            // copy the planes instead of deinterleaving NV12 chroma on the CPU
+            pParams->fourcc  = MFX_FOURCC_YV12;
             pParams->outI420 = true;
         }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-nv12"))) {
@@ -806,6 +922,77 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         return MFX_ERR_UNSUPPORTED;
     }
 
+    if (pParams->nStreams > 1 && pParams->mode != MODE_PERFORMANCE) {
+        PrintHelp(strInput[0], MSDK_STRING("-streams supports only performance mode"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    if (pParams->nBenchLoops) {
+        if (pParams->mode != MODE_PERFORMANCE) {
+            PrintHelp(strInput[0], MSDK_STRING("-bench doesn't support -o and -r"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (pParams->bLowLat || pParams->bCalLat) {
+            PrintHelp(strInput[0],
+                      MSDK_STRING("-bench doesn't support -low_latency and -calc_latency"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        // IVF frame reader works with the file
+        if (MFX_CODEC_VP8 == pParams->videoType || MFX_CODEC_VP9 == pParams->videoType ||
+            MFX_CODEC_AV1 == pParams->videoType) {
+            PrintHelp(strInput[0], MSDK_STRING("-bench supports only elementary streams"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->bMappedInput) {
+        // IVF and JPEG frame readers work with the file
+        if (MFX_CODEC_VP8 == pParams->videoType || MFX_CODEC_VP9 == pParams->videoType ||
+            MFX_CODEC_AV1 == pParams->videoType) {
+            PrintHelp(strInput[0], MSDK_STRING("-mmap supports only elementary streams"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if ((pParams->bLowLat || pParams->bCalLat) && MFX_CODEC_AVC != pParams->videoType) {
+            PrintHelp(strInput[0], MSDK_STRING("-mmap with -low_latency supports only H.264"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->bKeyFrames) {
+        if (MFX_CODEC_AVC != pParams->videoType && MFX_CODEC_HEVC != pParams->videoType &&
+            MFX_CODEC_VP8 != pParams->videoType && MFX_CODEC_VP9 != pParams->videoType &&
+            MFX_CODEC_AV1 != pParams->videoType) {
+            PrintHelp(strInput[0],
+                      MSDK_STRING("-key_frames supports only h264, h265, vp8, vp9 and av1"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (pParams->bIsMVC || pParams->bLowLat || pParams->bCalLat || pParams->nBenchLoops ||
+            pParams->bMappedInput) {
+            PrintHelp(
+                strInput[0],
+                MSDK_STRING("-key_frames doesn't support MVC, latency modes, -bench and -mmap"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->bInputList) {
+        if (MFX_CODEC_JPEG != pParams->videoType) {
+            PrintHelp(strInput[0], MSDK_STRING("-i_list supports only jpeg"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (pParams->bLowLat || pParams->bCalLat || pParams->nBenchLoops ||
+            pParams->bMappedInput || pParams->bKeyFrames) {
+            PrintHelp(strInput[0],
+                      MSDK_STRING("-i_list doesn't support latency, -bench, -mmap, -key_frames"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->nDeliveryThreads && pParams->mode != MODE_FILE_DUMP) {
+        PrintHelp(strInput[0], MSDK_STRING("-delivery_threads requires output file (-o)"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
     if (pParams->nAsyncDepth == 0) {
         pParams->nAsyncDepth = 4; //set by default;
     }
@@ -824,6 +1011,168 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
     return MFX_ERR_NONE;
 }
 
+// Runs decoding, recovers the pipeline from incompatible parameters and lost device. The device
+// shared by several pipelines can't be reset under them, its loss finishes decoding
+mfxStatus RunDecodingWithRecovery(CDecodingPipeline& Pipeline,
+                                  sInputParams& Params,
+                                  bool bResetDevice) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    mfxU64 prevResetBytesCount = 0xFFFFFFFFFFFFFFFF;
+    for (;;) {
+        sts = Pipeline.RunDecoding();
+
+        if (MFX_ERR_INCOMPATIBLE_VIDEO_PARAM == sts || MFX_ERR_DEVICE_LOST == sts ||
+            MFX_ERR_DEVICE_FAILED == sts) {
+            if (prevResetBytesCount == Pipeline.GetTotalBytesProcessed()) {
+                msdk_printf(MSDK_STRING(
+                    "\nERROR: No input data was consumed since last reset. Quitting to avoid looping forever.\n"));
+                break;
+            }
+            prevResetBytesCount = Pipeline.GetTotalBytesProcessed();
+
+            if (MFX_ERR_INCOMPATIBLE_VIDEO_PARAM == sts) {
+                msdk_printf(MSDK_STRING(
+                    "\nERROR: Incompatible video parameters detected. Recovering...\n"));
+            }
+            else if (!bResetDevice) {
+                msdk_printf(MSDK_STRING(
+                    "\nERROR: Hardware device shared by streams was lost or returned unexpected error.\n"));
+                return MFX_ERR_DEVICE_FAILED;
+            }
+            else {
+                msdk_printf(MSDK_STRING(
+                    "\nERROR: Hardware device was lost or returned unexpected error. Recovering...\n"));
+                sts = Pipeline.ResetDevice();
+                MSDK_CHECK_STATUS(sts, "Pipeline.ResetDevice failed");
+            }
+
+            sts = Pipeline.ResetDecoder(&Params);
+            MSDK_CHECK_STATUS(sts, "Pipeline.ResetDecoder failed");
+            continue;
+        }
+        else {
+            MSDK_CHECK_STATUS(sts, "Pipeline.RunDecoding failed");
+            break;
+        }
+    }
+
+    return MFX_ERR_NONE;
+
+}
+
+// Frames per watt need power of the GPU, which is sampled with metrics_monitor
+void PrintBenchmarkResult(mfxU64 frames, mfxF64 seconds, const EngineUtilization& utilization) {
+    mfxF64 fps = seconds > 0 ? frames / seconds : 0.0;
+
+    msdk_printf(MSDK_STRING("Benchmark: frames: %lld, fps: %0.3f"), (long long)frames, fps);
+    if (utilization.NumPeriods && utilization.Power > 0)
+        msdk_printf(MSDK_STRING(", power: %0.1f W, fps per watt: %0.3f\n"),
+                    utilization.Power,
+                    fps / utilization.Power);
+    else
+        msdk_printf(MSDK_STRING(", power is not available\n"));
+
+    msdk_string energy = CEngineUtilizationSampler::ToEnergyString(utilization, seconds, frames);
+    if (!energy.empty())
+        msdk_printf(MSDK_STRING("Benchmark: energy per frame: %s\n"), energy.c_str());
+}
+
+// Decodes the input in several pipelines sharing loader and device of the first one, each
+// pipeline runs in its own thread
+mfxStatus RunMultiStreamDecoding(sInputParams& Params) {
+    std::vector<sInputParams> params(Params.nStreams, Params);
+    // owner of the device is destroyed after the pipelines using it
+    CDecodingPipeline Owner;
+    std::vector<std::unique_ptr<CDecodingPipeline>> pipelines;
+    std::vector<CDecodingPipeline*> streams = { &Owner };
+
+    mfxStatus sts = Owner.Init(&params[0]);
+    MSDK_CHECK_STATUS(sts, "Pipeline.Init failed");
+
+    for (mfxU32 i = 1; i < Params.nStreams; i++) {
+        pipelines.emplace_back(new CDecodingPipeline);
+        pipelines.back()->ShareDevice(Owner);
+
+        sts = pipelines.back()->Init(&params[i]);
+        MSDK_CHECK_STATUS(sts, "Pipeline.Init failed");
+        streams.push_back(pipelines.back().get());
+    }
+
+    // print stream info
+    Owner.PrintInfo();
+
+    msdk_printf(MSDK_STRING("Decoding of %d streams started\n"), (int)Params.nStreams);
+
+    CEngineUtilizationSampler engineSampler;
+    if (Params.bEngineUtilization || Params.nBenchLoops)
+        engineSampler.Start();
+
+    CTimer timer;
+    timer.Start();
+
+    std::vector<mfxStatus> results(streams.size(), MFX_ERR_NONE);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < streams.size(); i++) {
+        threads.emplace_back([&, i]() {
+            results[i] = RunDecodingWithRecovery(*streams[i], params[i], false);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    mfxF64 elapsed = timer.GetTime();
+
+    msdk_printf(MSDK_STRING("\nDecoding finished\n"));
+
+    mfxU64 totalFrames = 0;
+    for (size_t i = 0; i < streams.size(); i++) {
+        mfxF64 seconds = CTimer::ConvertToSeconds(streams[i]->m_tick_overall);
+        msdk_printf(MSDK_STRING("Stream %d: frames: %d, fps: %0.3f%s\n"),
+                    (int)i,
+                    (int)streams[i]->m_output_count,
+                    seconds > 0 ? streams[i]->m_output_count / seconds : 0.0,
+                    results[i] < MFX_ERR_NONE ? MSDK_STRING(", failed") : MSDK_STRING(""));
+        totalFrames += streams[i]->m_output_count;
+
+        if (results[i] < MFX_ERR_NONE)
+            sts = results[i];
+    }
+    msdk_printf(MSDK_STRING("Total: streams: %d, frames: %lld, fps: %0.3f\n"),
+                (int)streams.size(),
+                (long long)totalFrames,
+                elapsed > 0 ? totalFrames / elapsed : 0.0);
+
+    engineSampler.Stop();
+    if (Params.nBenchLoops) {
+        EngineUtilization utilization = engineSampler.GetAverage();
+        PrintBenchmarkResult(totalFrames, elapsed, utilization);
+
+        // energy of the run is shared by the streams in proportion to their decoding time
+        mfxF64 streamSeconds = 0;
+        for (CDecodingPipeline* stream : streams)
+            streamSeconds += CTimer::ConvertToSeconds(stream->m_tick_overall);
+        for (size_t i = 0; i < streams.size() && streamSeconds > 0; i++) {
+            mfxF64 share = elapsed * CTimer::ConvertToSeconds(streams[i]->m_tick_overall) /
+                           streamSeconds;
+            msdk_string energy =
+                CEngineUtilizationSampler::ToEnergyString(utilization,
+                                                          share,
+                                                          streams[i]->m_output_count);
+            if (!energy.empty())
+                msdk_printf(MSDK_STRING("Stream %d: energy per frame: %s\n"),
+                            (int)i,
+                            energy.c_str());
+        }
+    }
+    if (Params.bEngineUtilization) {
+        msdk_printf(MSDK_STRING("Engine utilization: %s\n"),
+                    CEngineUtilizationSampler::ToString(engineSampler.GetAverage()).c_str());
+    }
+
+    return sts;
+}
+
 #if defined(_WIN32) || defined(_WIN64)
 int _tmain(int argc, TCHAR* argv[])
 #else
@@ -850,6 +1199,10 @@ int main(int argc, char* argv[])
         Params.fourcc  = MFX_FOURCC_I420;
         Params.outI420 = false;
     }
+
+    if (Params.nStreams > 1)
+        return RunMultiStreamDecoding(Params);
+
     sts = Pipeline.Init(&Params);
     MSDK_CHECK_STATUS(sts, "Pipeline.Init failed");
 
@@ -858,41 +1211,26 @@ int main(int argc, char* argv[])
 
     msdk_printf(MSDK_STRING("Decoding started\n"));
 
-    mfxU64 prevResetBytesCount = 0xFFFFFFFFFFFFFFFF;
-    for (;;) {
-        sts = Pipeline.RunDecoding();
+    CEngineUtilizationSampler engineSampler;
+    if (Params.bEngineUtilization || Params.nBenchLoops)
+        engineSampler.Start();
 
-        if (MFX_ERR_INCOMPATIBLE_VIDEO_PARAM == sts || MFX_ERR_DEVICE_LOST == sts ||
-            MFX_ERR_DEVICE_FAILED == sts) {
-            if (prevResetBytesCount == Pipeline.GetTotalBytesProcessed()) {
-                msdk_printf(MSDK_STRING(
-                    "\nERROR: No input data was consumed since last reset. Quitting to avoid looping forever.\n"));
-                break;
-            }
-            prevResetBytesCount = Pipeline.GetTotalBytesProcessed();
+    sts = RunDecodingWithRecovery(Pipeline, Params, true);
+    if (sts < MFX_ERR_NONE)
+        return sts;
 
-            if (MFX_ERR_INCOMPATIBLE_VIDEO_PARAM == sts) {
-                msdk_printf(MSDK_STRING(
-                    "\nERROR: Incompatible video parameters detected. Recovering...\n"));
-            }
-            else {
-                msdk_printf(MSDK_STRING(
-                    "\nERROR: Hardware device was lost or returned unexpected error. Recovering...\n"));
-                sts = Pipeline.ResetDevice();
-                MSDK_CHECK_STATUS(sts, "Pipeline.ResetDevice failed");
-            }
+    msdk_printf(MSDK_STRING("\nDecoding finished\n"));
 
-            sts = Pipeline.ResetDecoder(&Params);
-            MSDK_CHECK_STATUS(sts, "Pipeline.ResetDecoder failed");
-            continue;
-        }
-        else {
-            MSDK_CHECK_STATUS(sts, "Pipeline.RunDecoding failed");
-            break;
-        }
+    engineSampler.Stop();
+    if (Params.nBenchLoops) {
+        PrintBenchmarkResult(Pipeline.m_output_count,
+                             CTimer::ConvertToSeconds(Pipeline.m_tick_overall),
+                             engineSampler.GetAverage());
+    }
+    if (Params.bEngineUtilization) {
+        msdk_printf(MSDK_STRING("Engine utilization: %s\n"),
+                    CEngineUtilizationSampler::ToString(engineSampler.GetAverage()).c_str());
     }
-
-    msdk_printf(MSDK_STRING("\nDecoding finished\n"));
 
     return 0;
 }
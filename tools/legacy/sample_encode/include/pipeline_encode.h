@@ -15,7 +15,12 @@
 #endif
 
 #include "base_allocator.h"
+#include "compressed_yuv_reader.h"
+#include "encode_stats_writer.h"
+#include "mux_writer.h"
+#include "rounding_offset_reader.h"
 #include "sample_utils.h"
+#include "scene_change_detector.h"
 #include "time_statistics.h"
 
 #include "mfxplugin.h"
@@ -27,7 +32,11 @@
 
 #include "plugin_utils.h"
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "preset_manager.h"
@@ -46,13 +55,6 @@
     #error MFX_VERSION not defined
 #endif
 
-#define SAFE_FREAD(PTR, SZ, COUNT, FPTR, ERR)                 \
-    {                                                         \
-        if (FPTR && (fread(PTR, SZ, COUNT, FPTR) != COUNT)) { \
-            return ERR;                                       \
-        }                                                     \
-    }
-
 msdk_tick time_get_tick(void);
 msdk_tick time_get_frequency(void);
 
@@ -141,11 +143,20 @@ struct sInputParams {
     mfxI32 adapterNum;
     bool dispFullSearch;
 
+    mfxU16 nThreadsNum; // threads of the CPU implementation
+    mfxI32 SchedulingType;
+    mfxI32 Priority;
+    std::vector<mfxU32> CpuAffinity; // CPUs of the application and runtime threads
+
     std::list<msdk_string> InputFiles;
 
     sPluginParams pluginParams;
 
     std::vector<msdk_char*> dstFileBuff;
+    // duplicates of the output written from threads of their own
+    std::vector<msdk_char*> teeFileBuff;
+    std::vector<bool> teeDropWhenFull;
+    mfxU32 nTeeQueueFrames;
 
     mfxU32 HEVCPluginVersion;
     mfxU8 nRotationAngle; // if specified, enables rotation plugin in mfx pipeline
@@ -183,18 +194,27 @@ struct sInputParams {
     bool enableQSVFF;
 
     bool bSoftRobustFlag;
+    bool bEngineUtilization;
+    bool bAllocStatistics;
 
     bool QPFileMode;
     bool TCBRCFileMode;
 
     mfxU32 nTimeout;
     mfxU16 nPerfOpt; // size of pre-load buffer which used for loop encode
+    bool bBenchmark; // preloaded frames are encoded without output, frame statistics are printed
+    bool bFrameStat; // latency of every frame is collected, implied by bBenchmark
+    bool bSyncThread; // tasks are synchronized and written by a thread of the task pool
+    bool bStartupStat; // durations of Init phases and time to the first packet are printed
+    bool bSceneChangeIDR; // IDR is inserted at scene changes of the input
+    bool bPlanarVppInput; // I420 input is uploaded as YV12 and converted to NV12 by VPP
     mfxU16 nMaxFPS; // limits overall fps
 
     mfxU32 nSyncOpTimeout; // SyncOperation timeout in msec
 
     mfxU16 nNumSlice;
     bool UseRegionEncode;
+    std::vector<mfxI32> RegionAdapters; // hardware adapter of every region, repeated cyclically
 
     bool isV4L2InputEnabled;
 
@@ -255,10 +275,14 @@ struct sInputParams {
     mfxU16 TargetBitDepthLuma;
     mfxU16 TargetBitDepthChroma;
     msdk_char DumpFileName[MSDK_MAX_FILENAME_LEN];
+    msdk_char EncodeStatsFile[MSDK_MAX_FILENAME_LEN]; // CSV file of frame level encode statistics
     msdk_char uSEI[MSDK_MAX_USER_DATA_UNREG_SEI_LEN];
 
     EPresetModes PresetMode;
     bool shouldPrintPresets;
+    mfxF64 dAutoPresetFps; // preset is selected from the profile for the throughput
+    bool bCalibratePresets; // presets are benchmarked on the device and saved to the profile
+    msdk_char PresetProfile[MSDK_MAX_FILENAME_LEN];
 
 #if defined(ENABLE_V4L2_SUPPORT)
     msdk_char DeviceName[MSDK_MAX_FILENAME_LEN];
@@ -276,6 +300,23 @@ struct sInputParams {
     bool bReadByFrame;
 };
 
+// frames completed by the encoder, latency is counted from submission of the frame
+struct sEncodeStat {
+    mfxU64 nFrames;
+    mfxU64 nBytes;
+    mfxF64 fSeconds; // run time of the pipeline
+    // nearest-rank percentiles in ms, 0 if latency was not collected
+    mfxF64 fLatencyP50;
+    mfxF64 fLatencyP90;
+    mfxF64 fLatencyP99;
+    mfxF64 fLatencyMax;
+    // -PartialOutput parts written before completion of their frames and latency of the first
+    // output of a frame, which is the whole frame if the encoder gave no parts
+    mfxU64 nPartialOutputs;
+    mfxF64 fFirstOutputP50;
+    mfxF64 fFirstOutputP99;
+};
+
 struct sTask {
     mfxBitstreamWrapper mfxBS;
     mfxEncodeCtrlWrap encCtrl;
@@ -284,6 +325,7 @@ struct sTask {
     std::list<mfxSyncPoint> DependentVppTasks;
     void* pWriter;
     mfxU32 codecID;
+    msdk_tick submitTime; // when EncodeFrameAsync was called
 
     sTask();
     mfxStatus WriteBitstream(bool isCompleteFrame = true);
@@ -317,11 +359,35 @@ public:
     virtual void SetGpuHangRecoveryFlag();
     virtual void ClearTasks();
 
+    // After the start, tasks are synchronized and their bitstreams are written by a thread in
+    // order of submission. GetFreeTask() takes a task from the queue of completed ones and waits
+    // only if all tasks are in execution, the task it returned before is queued for the thread
+    // if it got a sync point. SynchronizeFirstTask() waits for completion of the oldest task.
+    // GPU hang recovery isn't supported, statistics of file writing aren't collected.
+    virtual mfxStatus StartSyncThread(mfxU32 syncOpTimeout);
+    virtual void StopSyncThread();
+
     msdk_tick firstOut_total;
     msdk_tick firstOut_start;
     msdk_tick lastOut_total;
     msdk_tick lastOut_start;
 
+    // collected for completed frames when bCollectFrameStat is set
+    bool bCollectFrameStat;
+    std::vector<msdk_tick> frameLatency; // from submission of the frame to completion of its sync
+    std::vector<msdk_tick> firstOutputLatency; // from submission to the first part of the frame
+    mfxU64 outputBytes;
+    mfxU64 partialOutputs;
+
+    // submission and completion of the first synchronized task, 0 before it
+    msdk_tick firstSubmitTime;
+    msdk_tick firstPacketTime;
+
+#ifdef ONEVPL_EXPERIMENTAL
+    // set before Init, statistics of every frame are requested and passed to the writer
+    CEncodeStatsWriter* pEncodeStats;
+#endif
+
 protected:
     sTask* m_pTasks;
     mfxU32 m_nPoolSize;
@@ -334,6 +400,21 @@ protected:
     CTimeStatistics m_statOverall;
     CTimeStatistics m_statFile;
     virtual mfxU32 GetFreeTaskIndex();
+
+    void QueuePendingTask(bool bKeepUnsubmitted);
+    void SyncThreadRoutine(mfxU32 syncOpTimeout);
+
+    bool m_bSyncThread;
+    std::thread m_SyncThread;
+    std::mutex m_mutex;
+    std::condition_variable m_cvSubmitted; // a task is queued for sync or the thread is stopped
+    std::condition_variable m_cvCompleted; // a task is completed or sync failed
+    std::deque<sTask*> m_FreeTasks;
+    std::deque<sTask*> m_SubmittedTasks; // in order of submission
+    sTask* m_pPendingTask; // returned by GetFreeTask() last
+    mfxU64 m_nCompletedTasks;
+    mfxStatus m_SyncStatus; // error of the thread, no task is synchronized after it
+    bool m_bStopSync;
 };
 
 /* This class implements a pipeline with 2 mfx components: vpp (video preprocessing) and encode */
@@ -347,15 +428,24 @@ public:
     virtual void Close();
     virtual mfxStatus ResetMFXComponents(sInputParams* pParams);
     virtual mfxStatus ResetDevice();
+    // next Init() uses loader and device of the pipeline, it must outlive this one
+    void ShareDevice(const CEncodingPipeline& pipeline);
+    // selects the implementation before Init, which creates the loader itself otherwise
+    mfxStatus CreateLoader(sInputParams* pParams);
+    // implementation and ID of the device selected by the loader
+    msdk_string GetDeviceKey() const;
+    virtual sEncodeStat GetEncodeStat();
 
     void SetNumView(mfxU32 numViews) {
         m_nNumView = numViews;
     }
     virtual void PrintInfo();
 
-    void InitV4L2Pipeline(sInputParams* pParams);
+    mfxStatus InitV4L2Pipeline(sInputParams* pParams);
     mfxStatus CaptureStartV4L2Pipeline();
     void CaptureStopV4L2Pipeline();
+    // gives the captured buffers back to the device once the library released their surfaces
+    void RequeueReleasedV4L2Buffers();
 
     static void InsertIDR(mfxEncodeCtrl& ctrl, bool forceIDR);
 
@@ -366,16 +456,19 @@ public:
 #if defined(ENABLE_V4L2_SUPPORT)
     v4l2Device v4l2Pipeline;
     pthread_t m_PollThread;
+    // surfaces captured into are the input of VPP if it's used, of the encoder otherwise
+    mfxFrameSurface1* m_pV4L2Surfaces;
+    std::vector<int> m_V4L2BuffersInUse;
 #endif
 
 protected:
     std::pair<CSmplBitstreamWriter*, CSmplBitstreamWriter*> m_FileWriters;
-    CSmplYUVReader m_FileReader;
+    CCompressedYUVReader m_FileReader;
     CEncTaskPool m_TaskPool;
     QPFile::Reader m_QPFileReader;
     TCBRCTestFile::Reader m_TCBRCFileReader;
 
-    std::unique_ptr<VPLImplementationLoader> m_pLoader;
+    std::shared_ptr<VPLImplementationLoader> m_pLoader;
     MainVideoSession m_mfxSession;
     MFXVideoENCODE* m_pmfxENC;
     MFXVideoVPP* m_pmfxVPP;
@@ -412,13 +505,15 @@ protected:
     std::vector<mfxPayload*> m_UserDataUnregSEI;
 
     CHWDevice* m_hwdev;
+    bool m_bSharedDevice; // loader and device belong to another pipeline
 
     bool m_bQPFileMode;
     bool m_bTCBRCFileMode;
 
     bool isV4L2InputEnabled;
-    FILE* m_round_in;
+    CAsyncRoundingOffsetReader m_RoundingOffsetReader;
     bool m_bSoftRobustFlag;
+    bool m_bAllocStatistics; // printed when the allocator is deleted
 
     mfxU32 m_nTimeout;
 
@@ -430,9 +525,24 @@ protected:
     bool m_bInsertIDR;
     bool m_bTimeOutExceed;
 
+    bool m_bSceneChangeIDR;
+    CSceneChangeDetector m_SceneChange;
+    bool m_bPlanarVppInput;
+
     bool m_bIsFieldSplitting;
     bool m_bSingleTexture;
     bool m_bPartialOutput;
+    bool m_bBenchmark;
+
+    // end of Init phases starting from the beginning of Init, recorded while marking is on
+    void MarkStartupPhase(const msdk_char* name);
+    void PrintStartupStat();
+    bool m_bStartupMarking;
+    std::vector<std::pair<const msdk_char*, msdk_tick>> m_StartupMarks;
+
+#ifdef ONEVPL_EXPERIMENTAL
+    CEncodeStatsWriter m_EncodeStats;
+#endif
 
     CTimeStatisticsReal m_statOverall;
     CTimeStatisticsReal m_statFile;
@@ -481,6 +591,9 @@ protected:
     virtual mfxU32 GetSufficientBufferSize();
     virtual mfxStatus AllocateSufficientBuffer(mfxBitstreamWrapper& bs);
     virtual mfxStatus FillBuffers();
+    // waits for the encoder to release a preloaded surface before it is submitted again
+    virtual mfxStatus WaitForPreloadedSurface(mfxFrameSurface1* pSurf);
+    virtual void PrintBenchmarkStat();
     virtual mfxStatus LoadNextFrame(mfxFrameSurface1* pSurf);
     virtual mfxStatus LoadNextFrame(mfxFrameSurface1* pSurf, int bytes_to_read, mfxU8* buf_read);
     virtual void LoadNextControl(mfxEncodeCtrl*& pCtrl, mfxU32 encSurfIdx);
@@ -7,6 +7,8 @@
 #ifndef __PIPELINE_REGION_ENCODE_H__
 #define __PIPELINE_REGION_ENCODE_H__
 
+#include <map>
+
 #include "pipeline_encode.h"
 
 #ifndef MFX_VERSION
@@ -15,11 +17,12 @@
 
 class CMSDKResource {
 public:
-    CMSDKResource() : Session(), pEncoder(NULL), TaskPool() {}
+    CMSDKResource() : Session(), pEncoder(NULL), TaskPool(), AdapterNum(-1) {}
 
     MainVideoSession Session;
     MFXVideoENCODE* pEncoder;
     CEncTaskPool TaskPool;
+    mfxI32 AdapterNum; // -1 if the session isn't bound to an adapter
 };
 
 class CResourcesPool {
@@ -40,6 +43,11 @@ public:
 
     mfxStatus Init(int size, mfxIMPL impl, mfxVersion* pVer);
     mfxStatus Init(int size, VPLImplementationLoader* Loader, mfxU32 nSyncOpTimeout);
+    // session i is created on the hardware adapter adapters[i % adapters.size()]
+    mfxStatus Init(int size,
+                   const std::vector<mfxI32>& adapters,
+                   mfxAccelerationMode accelerationMode,
+                   mfxU32 nSyncOpTimeout);
     mfxStatus InitTaskPools(CSmplBitstreamWriter* pWriter,
                             mfxU32 nPoolSize,
                             mfxU32 nBufferSize,
@@ -56,6 +64,7 @@ protected:
     CMSDKResource* m_resources = nullptr;
     int m_size                 = 0;
     mfxU32 m_nSyncOpTimeout    = 0; // SyncOperation timeout in msec
+    std::map<mfxI32, std::unique_ptr<VPLImplementationLoader>> m_loaders; // by adapter number
 
 private:
     CResourcesPool(const CResourcesPool& src) {
@@ -90,6 +99,11 @@ protected:
     virtual mfxStatus InitMfxEncParams(sInputParams* pParams);
 
     virtual mfxStatus CreateAllocator();
+#ifdef LIBVA_SUPPORT
+    mfxStatus SetAdapterDeviceHandles();
+
+    std::map<mfxI32, std::unique_ptr<CHWDevice>> m_adapterDevices; // by adapter number
+#endif
 
     virtual MFXVideoSession& GetFirstSession() {
         return m_resources[0].Session;
@@ -7,6 +7,7 @@
 #ifndef __PIPELINE_USER_H__
 #define __PIPELINE_USER_H__
 
+#include "frame_band_executor.h"
 #include "pipeline_encode.h"
 #include "rotate_plugin_api.h"
 #include "vm/so_defs.h"
@@ -38,9 +39,17 @@ protected:
 
     mfxU32 m_nSyncOpTimeout; // SyncOperation timeout in msec
 
+    CFrameBandExecutor m_RotateExecutor; // rotates frames on the CPU threads
+
     virtual mfxStatus InitRotateParam(sInputParams* pParams);
     virtual mfxStatus AllocFrames();
     virtual void DeleteFrames();
+
+    // rotation input and output are mapped while the rotation runs, surfaces in system memory
+    // are mapped since the allocation
+    mfxStatus LockRotateSurfaces(mfxFrameSurface1* pIn, mfxFrameSurface1* pOut);
+    mfxStatus UnlockRotateSurfaces(mfxFrameSurface1* pIn, mfxFrameSurface1* pOut);
+    mfxStatus EncodeOneFrame(sTask* pTask, mfxFrameSurface1* pSurface);
 };
 
 #endif // __PIPELINE_USER_H__
@@ -27,11 +27,13 @@
 
 #if defined(ENABLE_V4L2_SUPPORT)
     #include <pthread.h>
+    #include <unistd.h>
 #endif
 
 #include "version.h"
 
 #include <algorithm>
+#include <cmath>
 #include <memory>
 
 #ifndef MFX_VERSION
@@ -78,12 +80,27 @@ CEncTaskPool::CEncTaskPool()
         : firstOut_total(0),
           firstOut_start(0),
           lastOut_total(0),
-          lastOut_start(0) {
+          lastOut_start(0),
+          bCollectFrameStat(false),
+          frameLatency(),
+          firstOutputLatency(),
+          outputBytes(0),
+          partialOutputs(0),
+          firstSubmitTime(0),
+          firstPacketTime(0) {
     m_pTasks           = NULL;
     m_pmfxSession      = NULL;
     m_nTaskBufferStart = 0;
     m_nPoolSize        = 0;
     m_bGpuHangRecovery = false;
+    m_bSyncThread      = false;
+    m_pPendingTask     = NULL;
+    m_nCompletedTasks  = 0;
+    m_SyncStatus       = MFX_ERR_NONE;
+    m_bStopSync        = false;
+#ifdef ONEVPL_EXPERIMENTAL
+    pEncodeStats = NULL;
+#endif
 }
 
 CEncTaskPool::~CEncTaskPool() {
@@ -97,7 +114,8 @@ sTask::sTask()
           EncSyncP(0),
           DependentVppTasks(),
           pWriter(NULL),
-          codecID(0) {}
+          codecID(0),
+          submitTime(0) {}
 
 mfxStatus CEncTaskPool::Init(MFXVideoSession* pmfxSession,
                              void* pWriter,
@@ -138,10 +156,33 @@ mfxStatus CEncTaskPool::Init(MFXVideoSession* pmfxSession,
         }
     }
 
+#ifdef ONEVPL_EXPERIMENTAL
+    if (pEncodeStats) {
+        for (mfxU32 i = 0; i < m_nPoolSize; i++)
+            CEncodeStatsWriter::Request(m_pTasks[i].mfxBS);
+    }
+#endif
+
     return MFX_ERR_NONE;
 }
 
 mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
+    if (m_bSyncThread) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // the caller may still fill the pending task if it has no sync point
+        QueuePendingTask(true);
+        if (MFX_ERR_NONE != m_SyncStatus)
+            return m_SyncStatus;
+        if (m_SubmittedTasks.empty())
+            return MFX_ERR_NOT_FOUND;
+
+        mfxU64 nCompletedTasks = m_nCompletedTasks;
+        m_cvCompleted.wait(lock, [this, nCompletedTasks]() {
+            return m_nCompletedTasks != nCompletedTasks || MFX_ERR_NONE != m_SyncStatus;
+        });
+        return m_SyncStatus;
+    }
+
     m_statOverall.StartTimeMeasurement();
     MSDK_CHECK_POINTER(m_pTasks, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(m_pmfxSession, MFX_ERR_NOT_INITIALIZED);
@@ -153,13 +194,19 @@ mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
     if (NULL != m_pTasks[m_nTaskBufferStart].EncSyncP) {
         int iteration = 0;
         do {
-            sts =
-                m_pmfxSession->SyncOperation(m_pTasks[m_nTaskBufferStart].EncSyncP, syncOpTimeout);
+            {
+                MFX_ITT_TASK("SyncOperation");
+                sts = m_pmfxSession->SyncOperation(m_pTasks[m_nTaskBufferStart].EncSyncP,
+                                                   syncOpTimeout);
+            }
 
             msdk_tick stop = time_get_tick();
 
             if (iteration == 0)
                 firstOut_total += stop - firstOut_start;
+            if (iteration == 0 && bCollectFrameStat &&
+                (MFX_ERR_NONE == sts || MFX_ERR_NONE_PARTIAL_OUTPUT == sts))
+                firstOutputLatency.push_back(stop - m_pTasks[m_nTaskBufferStart].submitTime);
 
             if (sts == MFX_ERR_GPU_HANG && m_bGpuHangRecovery) {
                 bGpuHang = true;
@@ -180,11 +227,25 @@ mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
             if (MFX_ERR_NONE == sts) {
                 lastOut_total += stop - lastOut_start;
 
+                if (bCollectFrameStat) {
+                    frameLatency.push_back(stop - m_pTasks[m_nTaskBufferStart].submitTime);
+                    outputBytes += m_pTasks[m_nTaskBufferStart].mfxBS.DataLength;
+                }
+                if (!firstPacketTime) {
+                    firstSubmitTime = m_pTasks[m_nTaskBufferStart].submitTime;
+                    firstPacketTime = stop;
+                }
+
                 m_statFile.StartTimeMeasurement();
                 sts = m_pTasks[m_nTaskBufferStart].WriteBitstream();
                 m_statFile.StopTimeMeasurement();
                 MSDK_CHECK_STATUS(sts, "m_pTasks[m_nTaskBufferStart].WriteBitstream failed");
 
+#ifdef ONEVPL_EXPERIMENTAL
+                if (pEncodeStats)
+                    pEncodeStats->Add(m_pTasks[m_nTaskBufferStart].mfxBS);
+#endif
+
                 sts = m_pTasks[m_nTaskBufferStart].Reset();
                 MSDK_CHECK_STATUS(sts, "m_pTasks[m_nTaskBufferStart].Reset failed");
 
@@ -198,6 +259,7 @@ mfxStatus CEncTaskPool::SynchronizeFirstTask(mfxU32 syncOpTimeout) {
                 }
             }
             else if (MFX_ERR_NONE_PARTIAL_OUTPUT == sts) {
+                partialOutputs++;
                 m_statFile.StartTimeMeasurement();
                 mfxStatus sts1 = m_pTasks[m_nTaskBufferStart].WriteBitstream(false);
                 m_statFile.StopTimeMeasurement();
@@ -257,6 +319,21 @@ mfxStatus CEncTaskPool::GetFreeTask(sTask** ppTask) {
     MSDK_CHECK_POINTER(ppTask, MFX_ERR_NULL_PTR);
     MSDK_CHECK_POINTER(m_pTasks, MFX_ERR_NOT_INITIALIZED);
 
+    if (m_bSyncThread) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        QueuePendingTask(false);
+        m_cvCompleted.wait(lock, [this]() {
+            return !m_FreeTasks.empty() || MFX_ERR_NONE != m_SyncStatus;
+        });
+        if (MFX_ERR_NONE != m_SyncStatus)
+            return m_SyncStatus;
+
+        m_pPendingTask = m_FreeTasks.front();
+        m_FreeTasks.pop_front();
+        *ppTask = m_pPendingTask;
+        return MFX_ERR_NONE;
+    }
+
     mfxU32 index = GetFreeTaskIndex();
 
     if (index >= m_nPoolSize) {
@@ -269,7 +346,124 @@ mfxStatus CEncTaskPool::GetFreeTask(sTask** ppTask) {
     return MFX_ERR_NONE;
 }
 
+void CEncTaskPool::QueuePendingTask(bool bKeepUnsubmitted) {
+    if (!m_pPendingTask)
+        return;
+
+    if (m_pPendingTask->EncSyncP) {
+        m_SubmittedTasks.push_back(m_pPendingTask);
+        m_cvSubmitted.notify_one();
+    }
+    else if (bKeepUnsubmitted) {
+        return;
+    }
+    else {
+        // the encoder buffered the frame, the task is returned again
+        m_FreeTasks.push_front(m_pPendingTask);
+    }
+    m_pPendingTask = NULL;
+}
+
+mfxStatus CEncTaskPool::StartSyncThread(mfxU32 syncOpTimeout) {
+    MSDK_CHECK_POINTER(m_pTasks, MFX_ERR_NOT_INITIALIZED);
+    if (m_bSyncThread)
+        return MFX_ERR_UNDEFINED_BEHAVIOR;
+
+    // the tasks are taken in the same order as without the thread, so in case of 2 output
+    // bitstreams these still alternate
+    m_FreeTasks.clear();
+    for (mfxU32 i = 0; i < m_nPoolSize; i++) {
+        if (m_pTasks[i].EncSyncP)
+            return MFX_ERR_UNDEFINED_BEHAVIOR;
+        m_FreeTasks.push_back(&m_pTasks[i]);
+    }
+
+    m_bSyncThread = true;
+    m_SyncThread  = std::thread(&CEncTaskPool::SyncThreadRoutine, this, syncOpTimeout);
+
+    return MFX_ERR_NONE;
+}
+
+void CEncTaskPool::StopSyncThread() {
+    if (!m_bSyncThread)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStopSync = true;
+    }
+    m_cvSubmitted.notify_one();
+    m_SyncThread.join();
+
+    m_FreeTasks.clear();
+    m_SubmittedTasks.clear();
+    m_pPendingTask    = NULL;
+    m_nCompletedTasks = 0;
+    m_SyncStatus      = MFX_ERR_NONE;
+    m_bStopSync       = false;
+    m_bSyncThread     = false;
+}
+
+void CEncTaskPool::SyncThreadRoutine(mfxU32 syncOpTimeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_cvSubmitted.wait(lock, [this]() {
+            return m_bStopSync || !m_SubmittedTasks.empty();
+        });
+        if (m_bStopSync)
+            break;
+
+        // the task stays queued while it is synchronized, the submitter doesn't touch it
+        sTask* pTask = m_SubmittedTasks.front();
+        lock.unlock();
+
+        mfxStatus sts;
+        {
+            MFX_ITT_TASK("SyncOperation");
+            sts = m_pmfxSession->SyncOperation(pTask->EncSyncP, syncOpTimeout);
+        }
+        msdk_tick stop = time_get_tick();
+        MSDK_CHECK_NOERROR_STATUS_NO_RET(sts, "SyncOperation fail or timeout");
+
+        if (MFX_ERR_NONE == sts) {
+            sts = pTask->WriteBitstream();
+            MSDK_CHECK_NOERROR_STATUS_NO_RET(sts, "pTask->WriteBitstream failed");
+        }
+#ifdef ONEVPL_EXPERIMENTAL
+        if (MFX_ERR_NONE == sts && pEncodeStats)
+            pEncodeStats->Add(pTask->mfxBS);
+#endif
+
+        lock.lock();
+        if (MFX_ERR_NONE == sts) {
+            if (bCollectFrameStat) {
+                frameLatency.push_back(stop - pTask->submitTime);
+                outputBytes += pTask->mfxBS.DataLength;
+            }
+            if (!firstPacketTime) {
+                firstSubmitTime = pTask->submitTime;
+                firstPacketTime = stop;
+            }
+            pTask->Reset();
+
+            m_SubmittedTasks.pop_front();
+            m_FreeTasks.push_back(pTask);
+            m_nCompletedTasks++;
+        }
+        else {
+            // a timed out task isn't waited for again
+            m_SyncStatus = (MFX_ERR_NONE < sts) ? MFX_ERR_ABORTED : sts;
+        }
+        m_cvCompleted.notify_all();
+
+        if (MFX_ERR_NONE != m_SyncStatus)
+            break;
+    }
+}
+
 void CEncTaskPool::Close() {
+    StopSyncThread();
+
     if (m_pTasks) {
         for (mfxU32 i = 0; i < m_nPoolSize; i++) {
             m_pTasks[i].Close();
@@ -310,6 +504,9 @@ mfxStatus sTask::Init(mfxU32 nBufferSize, mfxU32 nCodecID, void* pwriter, bool b
 mfxStatus sTask::Close() {
     EncSyncP = 0;
     DependentVppTasks.clear();
+#ifdef ONEVPL_EXPERIMENTAL
+    CEncodeStatsWriter::Release(mfxBS);
+#endif
 
     return MFX_ERR_NONE;
 }
@@ -330,6 +527,10 @@ mfxStatus sTask::Reset() {
     // prepare bit stream
     mfxBS.DataOffset = 0;
     mfxBS.DataLength = 0;
+#ifdef ONEVPL_EXPERIMENTAL
+    // statistics of a dropped frame
+    CEncodeStatsWriter::Release(mfxBS);
+#endif
 
     DependentVppTasks.clear();
 
@@ -433,6 +634,9 @@ mfxStatus CEncodingPipeline::InitMfxEncParams(sInputParams* pInParams) {
     m_mfxEncParams.mfx.GopPicSize        = pInParams->nGopPicSize;
     m_mfxEncParams.mfx.NumRefFrame       = pInParams->nNumRefFrame;
     m_mfxEncParams.mfx.IdrInterval       = pInParams->nIdrInterval;
+    // GOPs follow the scenes, only long scenes are split
+    if (pInParams->bSceneChangeIDR && !pInParams->nGopPicSize)
+        m_mfxEncParams.mfx.GopPicSize = (mfxU16)std::min(10 * pInParams->dFrameRate, 65535.0);
 
     m_mfxEncParams.mfx.CodecProfile       = pInParams->CodecProfile;
     m_mfxEncParams.mfx.CodecLevel         = pInParams->CodecLevel;
@@ -787,9 +991,9 @@ mfxStatus CEncodingPipeline::InitMfxEncParams(sInputParams* pInParams) {
 }
 
 mfxU32 CEncodingPipeline::FileFourCC2EncFourCC(mfxU32 fcc) {
-    // File reader automatically converts I420 and YV12 to NV12
+    // File reader automatically converts I420 and YV12 to NV12, unless VPP converts them
     if (fcc == MFX_FOURCC_I420 || fcc == MFX_FOURCC_YV12)
-        return MFX_FOURCC_NV12;
+        return m_bPlanarVppInput ? MFX_FOURCC_YV12 : MFX_FOURCC_NV12;
     else
         return fcc;
 }
@@ -877,6 +1081,11 @@ mfxStatus CEncodingPipeline::InitMfxVppParams(sInputParams* pInParams) {
 }
 
 mfxStatus CEncodingPipeline::CreateHWDevice() {
+    if (m_bSharedDevice) {
+        MSDK_CHECK_POINTER(m_hwdev, MFX_ERR_NULL_PTR);
+        return MFX_ERR_NONE;
+    }
+
     mfxStatus sts = MFX_ERR_NONE;
 #if D3D_SURFACES_SUPPORT
     #if MFX_D3D11_SUPPORT
@@ -913,7 +1122,15 @@ mfxStatus CEncodingPipeline::CreateHWDevice() {
 }
 
 mfxStatus CEncodingPipeline::ResetDevice() {
+    // other pipelines keep working with the device
+    if (m_bSharedDevice)
+        return MFX_ERR_UNSUPPORTED;
+
     if (D3D9_MEMORY == m_memType || D3D11_MEMORY == m_memType) {
+        // the frames are lost with the device
+        BaseFrameAllocator* pBaseAllocator = dynamic_cast<BaseFrameAllocator*>(m_pMFXAllocator);
+        if (pBaseAllocator)
+            pBaseAllocator->InvalidateReusableFrames();
         return m_hwdev->Reset();
     }
     return MFX_ERR_NONE;
@@ -1001,12 +1218,6 @@ mfxStatus CEncodingPipeline::AllocFrames() {
         VppRequest[0].NumFrameSuggested = VppRequest[0].NumFrameMin = nVppSurfNum;
         MSDK_MEMCPY_VAR(VppRequest[0].Info, &(m_mfxVppParams.vpp.In), sizeof(mfxFrameInfo));
 
-#if defined(ENABLE_V4L2_SUPPORT)
-        if (isV4L2InputEnabled) {
-            VppRequest[0].Type |= MFX_MEMTYPE_EXPORT_FRAME;
-        }
-#endif
-
         sts = m_pMFXAllocator->Alloc(m_pMFXAllocator->pthis, &(VppRequest[0]), &m_VppResponse);
         MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Alloc failed");
     }
@@ -1147,9 +1358,6 @@ mfxStatus CEncodingPipeline::CreateAllocator() {
         MSDK_CHECK_POINTER(p_vaapiAllocParams, MFX_ERR_MEMORY_ALLOC);
 
         p_vaapiAllocParams->m_dpy = (VADisplay)hdl;
-    #ifdef ENABLE_V4L2_SUPPORT
-        p_vaapiAllocParams->m_export_mode = vaapiAllocatorParams::PRIME;
-    #endif
         m_pmfxAllocatorParams = p_vaapiAllocParams;
 
         /* In case of video memory we must provide MediaSDK with external allocator
@@ -1187,6 +1395,13 @@ mfxStatus CEncodingPipeline::CreateAllocator() {
         We use system memory allocator simply as a memory manager for application*/
     }
 
+    // resets after device errors reallocate the same frames
+    BaseFrameAllocator* pBaseAllocator = dynamic_cast<BaseFrameAllocator*>(m_pMFXAllocator);
+    if (pBaseAllocator) {
+        pBaseAllocator->SetFrameReuse(true);
+        pBaseAllocator->SetLockTiming(m_bAllocStatistics);
+    }
+
     // initialize memory allocator
     sts = m_pMFXAllocator->Init(m_pmfxAllocatorParams);
     MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Init failed");
@@ -1207,10 +1422,17 @@ void CEncodingPipeline::DeleteFrames() {
 }
 
 void CEncodingPipeline::DeleteHWDevice() {
-    MSDK_SAFE_DELETE(m_hwdev);
+    if (m_bSharedDevice)
+        m_hwdev = NULL;
+    else
+        MSDK_SAFE_DELETE(m_hwdev);
 }
 
 void CEncodingPipeline::DeleteAllocator() {
+    BaseFrameAllocator* pBaseAllocator = dynamic_cast<BaseFrameAllocator*>(m_pMFXAllocator);
+    if (m_bAllocStatistics && pBaseAllocator)
+        pBaseAllocator->PrintStatistics();
+
     // delete allocator
     MSDK_SAFE_DELETE(m_pMFXAllocator);
     MSDK_SAFE_DELETE(m_pmfxAllocatorParams);
@@ -1222,6 +1444,8 @@ CEncodingPipeline::CEncodingPipeline()
         :
 #if defined(ENABLE_V4L2_SUPPORT)
           v4l2Pipeline(),
+          m_pV4L2Surfaces(NULL),
+          m_V4L2BuffersInUse(),
           m_PollThread(),
 #endif
           m_FileWriters(NULL, NULL),
@@ -1254,11 +1478,13 @@ CEncodingPipeline::CEncodingPipeline()
 #endif
           m_UserDataUnregSEI(),
           m_hwdev(NULL),
+          m_bSharedDevice(false),
           m_bQPFileMode(false),
           m_bTCBRCFileMode(false),
           isV4L2InputEnabled(false),
-          m_round_in(nullptr),
+          m_RoundingOffsetReader(),
           m_bSoftRobustFlag(false),
+          m_bAllocStatistics(false),
           m_nTimeout(0),
           m_nSyncOpTimeout(MSDK_WAIT_INTERVAL),
           m_bFileWriterReset(false),
@@ -1266,9 +1492,18 @@ CEncodingPipeline::CEncodingPipeline()
           m_bCutOutput(false),
           m_bInsertIDR(false),
           m_bTimeOutExceed(false),
+          m_bSceneChangeIDR(false),
+          m_SceneChange(),
+          m_bPlanarVppInput(false),
           m_bIsFieldSplitting(false),
           m_bSingleTexture(false),
           m_bPartialOutput(false),
+          m_bBenchmark(false),
+          m_bStartupMarking(false),
+          m_StartupMarks(),
+#ifdef ONEVPL_EXPERIMENTAL
+          m_EncodeStats(),
+#endif
           m_statOverall(),
           m_statFile(),
           m_fpsLimiter(),
@@ -1395,6 +1630,39 @@ mfxStatus CEncodingPipeline::InitFileWriters(sInputParams* pParams) {
         m_FileWriters.first  = first.release();
         m_FileWriters.second = second.release();
     }
+    // not ViewOutput mode, output is duplicated to -tee destinations
+    else if (pParams->teeFileBuff.size() && !m_bNoOutFile) {
+        auto writer = std::make_unique<CSmplBitstreamDuplicateWriter>();
+        sts         = writer->Init(pParams->dstFileBuff[0]);
+        MSDK_CHECK_STATUS(sts, "writer->Init failed");
+
+        mfxU32 nQueueFrames = pParams->nTeeQueueFrames ? pParams->nTeeQueueFrames : 64;
+        for (size_t i = 0; i < pParams->teeFileBuff.size(); i++) {
+            sts = writer->AddDuplicate(pParams->teeFileBuff[i],
+                                       pParams->teeDropWhenFull[i]
+                                           ? CSmplBitstreamDuplicateWriter::BACKPRESSURE_DROP
+                                           : CSmplBitstreamDuplicateWriter::BACKPRESSURE_BLOCK,
+                                       nQueueFrames);
+            MSDK_CHECK_STATUS(sts, "writer->AddDuplicate failed");
+        }
+
+        MSDK_SAFE_DELETE(m_FileWriters.first);
+        m_FileWriters.first = writer.release();
+    }
+    // not ViewOutput mode, AVC and HEVC are muxed into .ts and .mp4 files
+    else if (!m_bNoOutFile &&
+             (pParams->CodecId == MFX_CODEC_AVC || pParams->CodecId == MFX_CODEC_HEVC) &&
+             GetMuxContainer(pParams->dstFileBuff[0]) != MUX_NONE) {
+        std::unique_ptr<CMuxWriter> writer(
+            CreateMuxWriter(GetMuxContainer(pParams->dstFileBuff[0])));
+        mfxU32 frameRateExtN = 0, frameRateExtD = 0;
+        ConvertFrameRate(pParams->dFrameRate, &frameRateExtN, &frameRateExtD);
+        sts = writer->Init(pParams->dstFileBuff[0], pParams->CodecId, frameRateExtN, frameRateExtD);
+        MSDK_CHECK_STATUS(sts, "writer->Init failed");
+
+        MSDK_SAFE_DELETE(m_FileWriters.first);
+        m_FileWriters.first = writer.release();
+    }
     // not ViewOutput mode
     else {
         sts = InitFileWriter(&m_FileWriters.first, pParams->dstFileBuff[0], m_bNoOutFile);
@@ -1567,11 +1835,83 @@ mfxStatus CEncodingPipeline::GetImpl(const sInputParams& params, mfxIMPL& impl)
     return MFX_ERR_NONE;
 }
 
+mfxStatus CEncodingPipeline::CreateLoader(sInputParams* pParams) {
+    MSDK_CHECK_POINTER(pParams, MFX_ERR_NULL_PTR);
+
+    mfxIMPL impl = pParams->bUseHWLib ? MFX_IMPL_HARDWARE : MFX_IMPL_SOFTWARE;
+
+    m_pLoader.reset(new VPLImplementationLoader);
+
+    if (pParams->dGfxIdx >= 0)
+        m_pLoader->SetDiscreteAdapterIndex(pParams->dGfxIdx);
+    else
+        m_pLoader->SetAdapterType(pParams->adapterType);
+
+    if (pParams->adapterNum >= 0)
+        m_pLoader->SetAdapterNum(pParams->adapterNum);
+
+    mfxStatus sts = m_pLoader->ConfigureThreads(pParams->nThreadsNum,
+                                                pParams->SchedulingType,
+                                                pParams->Priority);
+    MSDK_CHECK_STATUS(sts, "m_pLoader->ConfigureThreads failed");
+
+#ifdef ONEVPL_EXPERIMENTAL
+    if (pParams->PCIDeviceSetup)
+        m_pLoader->SetPCIDevice(pParams->PCIDomain,
+                                pParams->PCIBus,
+                                pParams->PCIDevice,
+                                pParams->PCIFunction);
+
+    #if (defined(_WIN64) || defined(_WIN32))
+    if (pParams->luid.HighPart > 0 || pParams->luid.LowPart > 0)
+        m_pLoader->SetupLUID(pParams->luid);
+    #else
+    m_pLoader->SetupDRMRenderNodeNum(pParams->DRMRenderNodeNum);
+    #endif
+#endif
+
+    if (!pParams->accelerationMode && pParams->bUseHWLib) {
+#if D3D_SURFACES_SUPPORT
+        pParams->accelerationMode = MFX_ACCEL_MODE_VIA_D3D11;
+#elif defined(LIBVA_SUPPORT)
+        pParams->accelerationMode = MFX_ACCEL_MODE_VIA_VAAPI;
+#endif
+    }
+
+    bool bLowLatencyMode = !pParams->dispFullSearch;
+
+    sts = m_pLoader->ConfigureAndEnumImplementations(impl,
+                                                     pParams->accelerationMode,
+                                                     bLowLatencyMode);
+    MSDK_CHECK_STATUS(sts, "m_mfxSession.EnumImplementations failed");
+
+    return MFX_ERR_NONE;
+}
+
+msdk_string CEncodingPipeline::GetDeviceKey() const {
+    if (!m_pLoader)
+        return msdk_string();
+
+    msdk_stringstream key;
+    key << m_pLoader->GetImplName().c_str();
+    mfxI16 deviceID = m_pLoader->GetDeviceIDAndAdapter().first;
+    if (deviceID >= 0)
+        key << MSDK_STRING("/") << std::hex << deviceID;
+
+    msdk_string result = key.str();
+    std::replace(result.begin(), result.end(), MSDK_CHAR(' '), MSDK_CHAR('_'));
+    return result;
+}
+
 mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
     MSDK_CHECK_POINTER(pParams, MFX_ERR_NULL_PTR);
 
     mfxStatus sts = MFX_ERR_NONE;
 
+    m_bStartupMarking = pParams->bStartupStat;
+    m_StartupMarks.clear();
+    MarkStartupPhase(MSDK_STRING("start"));
+
 #if defined ENABLE_V4L2_SUPPORT
     isV4L2InputEnabled = pParams->isV4L2InputEnabled;
 #endif
@@ -1579,9 +1919,12 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
     m_MVCflags = pParams->MVC_flags;
 
     // FileReader can convert yv12->nv12 without vpp, when hw impl
+    // with -planar_vpp the planes are copied as they are to YV12 surfaces, VPP interleaves chroma
+    m_bPlanarVppInput = pParams->bPlanarVppInput && pParams->bUseHWLib;
     if (pParams->bUseHWLib) {
-        m_InputFourCC = (pParams->FileInputFourCC == MFX_FOURCC_I420) ? MFX_FOURCC_NV12
-                                                                      : pParams->FileInputFourCC;
+        m_InputFourCC = (pParams->FileInputFourCC == MFX_FOURCC_I420)
+                            ? FileFourCC2EncFourCC(pParams->FileInputFourCC)
+                            : pParams->FileInputFourCC;
 
         pParams->EncodeFourCC =
             (pParams->EncodeFourCC == MFX_FOURCC_I420) ? MFX_FOURCC_NV12 : pParams->EncodeFourCC;
@@ -1602,9 +1945,33 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
     initPar.GPUCopy  = pParams->gpuCopy;
     m_bSingleTexture = pParams->bSingleTexture;
 
+    if (pParams->nThreadsNum || pParams->SchedulingType || pParams->Priority) {
+        auto threadsPar = initPar.AddExtBuffer<mfxExtThreadsParam>();
+        MSDK_CHECK_POINTER(threadsPar, MFX_ERR_MEMORY_ALLOC);
+        threadsPar->NumThread      = pParams->nThreadsNum;
+        threadsPar->SchedulingType = pParams->SchedulingType;
+        threadsPar->Priority       = pParams->Priority;
+    }
+
+    // threads of the CPU implementation inherit the affinity of the thread creating the session
+    if (!pParams->CpuAffinity.empty()) {
+        sts = msdk_thread_set_affinity(pParams->CpuAffinity);
+        MSDK_CHECK_STATUS(sts, "msdk_thread_set_affinity failed");
+    }
+
     m_verSessionInit = pParams->verSessionInit;
     m_bReadByFrame   = pParams->bReadByFrame;
 
+    m_bSceneChangeIDR = pParams->bSceneChangeIDR;
+    if (m_bSceneChangeIDR) {
+        if (!CSceneChangeDetector::IsSupported(m_InputFourCC)) {
+            msdk_printf(MSDK_STRING("error: scene change detection needs 8-bit planar input\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        // later cuts in half a second are mostly flashes, not worth an IDR
+        m_SceneChange.Init(std::max<mfxU32>(1, (mfxU32)(pParams->dFrameRate / 2)));
+    }
+
     if (m_verSessionInit == API_1X) {
         initPar.Version.Major = 1;
         initPar.Version.Minor = 0;
@@ -1615,52 +1982,22 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
         sts = m_mfxSession.InitEx(initPar);
         MSDK_CHECK_STATUS(sts, "m_mfxSession.InitEx failed");
     }
+    else if (m_bSharedDevice) {
+        // implementation is already selected by the pipeline owning the loader
+        sts = m_mfxSession.CreateSession(m_pLoader.get());
+        MSDK_CHECK_STATUS(sts, "m_mfxSession.CreateSession failed");
+    }
     else {
-        initPar.Implementation = pParams->bUseHWLib ? MFX_IMPL_HARDWARE : MFX_IMPL_SOFTWARE;
-
-        m_pLoader.reset(new VPLImplementationLoader);
-
-        if (pParams->dGfxIdx >= 0)
-            m_pLoader->SetDiscreteAdapterIndex(pParams->dGfxIdx);
-        else
-            m_pLoader->SetAdapterType(pParams->adapterType);
-
-        if (pParams->adapterNum >= 0)
-            m_pLoader->SetAdapterNum(pParams->adapterNum);
-
-#ifdef ONEVPL_EXPERIMENTAL
-        if (pParams->PCIDeviceSetup)
-            m_pLoader->SetPCIDevice(pParams->PCIDomain,
-                                    pParams->PCIBus,
-                                    pParams->PCIDevice,
-                                    pParams->PCIFunction);
-
-    #if (defined(_WIN64) || defined(_WIN32))
-        if (pParams->luid.HighPart > 0 || pParams->luid.LowPart > 0)
-            m_pLoader->SetupLUID(pParams->luid);
-    #else
-        m_pLoader->SetupDRMRenderNodeNum(pParams->DRMRenderNodeNum);
-    #endif
-#endif
-
-        if (!pParams->accelerationMode && pParams->bUseHWLib) {
-#if D3D_SURFACES_SUPPORT
-            pParams->accelerationMode = MFX_ACCEL_MODE_VIA_D3D11;
-#elif defined(LIBVA_SUPPORT)
-            pParams->accelerationMode = MFX_ACCEL_MODE_VIA_VAAPI;
-#endif
+        // the loader may be already created to look up the device before presets are applied
+        if (!m_pLoader) {
+            sts = CreateLoader(pParams);
+            MSDK_CHECK_STATUS(sts, "CreateLoader failed");
         }
 
-        bool bLowLatencyMode = !pParams->dispFullSearch;
-
-        sts = m_pLoader->ConfigureAndEnumImplementations(initPar.Implementation,
-                                                         pParams->accelerationMode,
-                                                         bLowLatencyMode);
-        MSDK_CHECK_STATUS(sts, "m_mfxSession.EnumImplementations failed");
-
         sts = m_mfxSession.CreateSession(m_pLoader.get());
         MSDK_CHECK_STATUS(sts, "m_mfxSession.CreateSession failed");
     }
+    MarkStartupPhase(MSDK_STRING("session"));
 
     mfxVersion version;
     sts = m_mfxSession.QueryVersion(&version);
@@ -1760,6 +2097,17 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
 
     // Preparing readers and writers
     if (!isV4L2InputEnabled) {
+        // raw frames are read ahead of the encoder by AsyncDepth frames; qp file mode seeks
+        // before every frame and -perf_opt reads the frames only once, so they read in place
+        mfxU32 frameLength = 0;
+        if (MFX_ERR_NONE != GetFrameLength(pParams->nWidth,
+                                           pParams->nHeight,
+                                           pParams->FileInputFourCC,
+                                           frameLength))
+            frameLength = 4 * pParams->nWidth * pParams->nHeight;
+        bool bReadAhead = !pParams->QPFileMode && !pParams->nPerfOpt;
+        m_FileReader.SetReadAhead(frameLength, bReadAhead ? pParams->nAsyncDepth + 1 : 0);
+
         // prepare input file reader
         sts = m_FileReader.Init(pParams->InputFiles, pParams->FileInputFourCC, readerShift);
         MSDK_CHECK_STATUS(sts, "m_FileReader.Init failed");
@@ -1767,17 +2115,27 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
 
     sts = InitFileWriters(pParams);
     MSDK_CHECK_STATUS(sts, "InitFileWriters failed");
+#ifdef ONEVPL_EXPERIMENTAL
+    if (*pParams->EncodeStatsFile && !m_EncodeStats.IsOpen()) {
+        sts = m_EncodeStats.Open(pParams->EncodeStatsFile);
+        MSDK_CHECK_STATUS(sts, "m_EncodeStats.Open failed");
+    }
+#endif
+    MarkStartupPhase(MSDK_STRING("reader and writers"));
 
     // set memory type
     m_memType  = pParams->memType;
-    m_nPerfOpt = pParams->nPerfOpt;
+    m_nPerfOpt   = pParams->nPerfOpt;
+    m_bBenchmark = pParams->bBenchmark;
     m_fpsLimiter.Reset(pParams->nMaxFPS);
 
-    m_bSoftRobustFlag = pParams->bSoftRobustFlag;
+    m_bSoftRobustFlag  = pParams->bSoftRobustFlag;
+    m_bAllocStatistics = pParams->bAllocStatistics;
 
     // create and init frame allocator
     sts = CreateAllocator();
     MSDK_CHECK_STATUS(sts, "CreateAllocator failed");
+    MarkStartupPhase(MSDK_STRING("allocator"));
 
     sts = InitMfxEncParams(pParams);
     MSDK_CHECK_STATUS(sts, "InitMfxEncParams failed");
@@ -1790,6 +2148,7 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
         auto mvcBuffer = m_mfxEncParams.AddExtBuffer<mfxExtMVCSeqDesc>();
         InitExtMVCBuffers(mvcBuffer);
     }
+    MarkStartupPhase(MSDK_STRING("parameters"));
 
     sts = ResetMFXComponents(pParams);
     MSDK_CHECK_STATUS(sts, "ResetMFXComponents failed");
@@ -1797,7 +2156,8 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
     sts = OpenRoundingOffsetFile(pParams);
     MSDK_CHECK_STATUS(sts, "Failed to open file");
 
-    InitV4L2Pipeline(pParams);
+    sts = InitV4L2Pipeline(pParams);
+    MSDK_CHECK_STATUS(sts, "InitV4L2Pipeline failed");
 
     m_nFramesToProcess = pParams->nNumFrames;
 
@@ -1815,32 +2175,94 @@ mfxStatus CEncodingPipeline::Init(sInputParams* pParams) {
                                                     &m_mfxEncParams);
     }
 
+    // device loss resets the components again, it isn't a part of the startup
+    MarkStartupPhase(MSDK_STRING("other"));
+    m_bStartupMarking = false;
+
     return MFX_ERR_NONE;
 }
 
-void CEncodingPipeline::InitV4L2Pipeline(sInputParams* pParams) {
+mfxStatus CEncodingPipeline::InitV4L2Pipeline(sInputParams* pParams) {
     (void)pParams;
 #if defined(ENABLE_V4L2_SUPPORT)
     if (isV4L2InputEnabled) {
-        int i;
+        // the device captures into the input surfaces of the pipeline, so NV12 frames of the size
+        // of the stream go to the encoder without any copy or conversion
+        m_pV4L2Surfaces = m_pmfxVPP ? m_pVppSurfaces : m_pEncSurfaces;
+        mfxU16 numSurfaces =
+            m_pmfxVPP ? m_VppResponse.NumFrameActual : m_EncResponse.NumFrameActual;
+        MSDK_CHECK_ERROR(numSurfaces > VIDEO_MAX_FRAME, true, MFX_ERR_UNSUPPORTED);
+
+        vaapiFrameAllocator* pAllocator = dynamic_cast<vaapiFrameAllocator*>(m_pMFXAllocator);
+        MSDK_CHECK_POINTER(pAllocator, MFX_ERR_UNSUPPORTED);
+
+        std::vector<VADRMPRIMESurfaceDescriptor> descs;
+        mfxStatus sts = MFX_ERR_NONE;
+        for (mfxU16 i = 0; i < numSurfaces && MFX_ERR_NONE == sts; i++) {
+            VADRMPRIMESurfaceDescriptor desc = {};
+            sts                              = pAllocator->ExportDmaBuf(
+                m_pV4L2Surfaces[i].Data.MemId,
+                VA_EXPORT_SURFACE_WRITE_ONLY | VA_EXPORT_SURFACE_COMPOSED_LAYERS,
+                &desc);
+            if (MFX_ERR_NONE != sts)
+                break;
+            descs.push_back(desc);
+
+            // single-planar V4L2 formats have linear planes following each other in one buffer
+            const mfxU32 pitch = desc.layers[0].pitch[0];
+            bool bCapturable   = desc.num_objects == 1 && desc.num_layers == 1 &&
+                               desc.objects[0].drm_format_modifier == DRM_FORMAT_MOD_LINEAR &&
+                               desc.layers[0].offset[0] == 0 &&
+                               pitch == descs[0].layers[0].pitch[0];
+            if (bCapturable && desc.layers[0].num_planes > 1)
+                bCapturable = desc.layers[0].offset[1] == pitch * pParams->nHeight &&
+                              desc.layers[0].pitch[1] == pitch;
+            if (!bCapturable) {
+                msdk_printf(MSDK_STRING(
+                    "ERROR: surfaces can't be captured into: they aren't linear or the planes aren't contiguous\n"));
+                sts = MFX_ERR_UNSUPPORTED;
+            }
+        }
+        if (MFX_ERR_NONE != sts) {
+            for (const VADRMPRIMESurfaceDescriptor& desc : descs) {
+                for (mfxU32 k = 0; k < desc.num_objects; k++)
+                    close(desc.objects[k].fd);
+            }
+            return sts;
+        }
+
+        v4l2Pipeline.SetDmaBufPitch(descs[0].layers[0].pitch[0]);
         v4l2Pipeline.Init(pParams->DeviceName,
                           pParams->nWidth,
                           pParams->nHeight,
-                          m_VppResponse.NumFrameActual,
+                          numSurfaces,
                           pParams->v4l2Format,
                           pParams->MipiMode,
                           pParams->MipiPort);
 
         v4l2Pipeline.V4L2Alloc();
 
-        for (i = 0; i < m_VppResponse.NumFrameActual; i++) {
-            buffers[i].index         = i;
-            struct vaapiMemId* vaapi = (struct vaapiMemId*)m_pVppSurfaces[i].Data.MemId;
-
-            buffers[i].fd = vaapi->m_buffer_info.handle;
+        for (mfxU16 i = 0; i < numSurfaces; i++) {
+            buffers[i].index  = i;
+            buffers[i].fd     = descs[i].objects[0].fd;
+            buffers[i].length = descs[i].objects[0].size;
             v4l2Pipeline.V4L2QueueBuffer(&buffers[i]);
         }
     }
+#endif
+    return MFX_ERR_NONE;
+}
+
+void CEncodingPipeline::RequeueReleasedV4L2Buffers() {
+#if defined(ENABLE_V4L2_SUPPORT)
+    for (auto it = m_V4L2BuffersInUse.begin(); it != m_V4L2BuffersInUse.end();) {
+        if (m_pV4L2Surfaces[*it].Data.Locked) {
+            it++;
+            continue;
+        }
+        v4l2Pipeline.V4L2QueueBuffer(&buffers[*it]);
+        it = m_V4L2BuffersInUse.erase(it);
+    }
 #endif
 }
 
@@ -1866,6 +2288,8 @@ void CEncodingPipeline::CaptureStopV4L2Pipeline() {
     if (isV4L2InputEnabled) {
         pthread_join(m_PollThread, NULL);
         v4l2Pipeline.V4L2StopCapture();
+        v4l2Pipeline.V4L2Free();
+        m_V4L2BuffersInUse.clear();
     }
 #endif
 }
@@ -1879,21 +2303,13 @@ mfxStatus CEncodingPipeline::InitEncFrameParams(sTask* pTask) {
     MSDK_CHECK_POINTER(pTask, MFX_ERR_NULL_PTR);
 
     mfxEncodeCtrlWrap& ctrl = pTask->encCtrl;
-    if (m_round_in) {
-        ctrl.AddExtBuffer<mfxExtAVCRoundingOffset>();
-
-        auto numFields =
+    if (m_RoundingOffsetReader.IsOpen()) {
+        mfxU32 numFields =
             m_mfxEncParams.mfx.FrameInfo.PicStruct == MFX_PICSTRUCT_PROGRESSIVE ? 1 : 2;
 
-        for (auto fieldId = 0; fieldId < numFields; ++fieldId) {
-            auto ro = ctrl.GetExtBuffer<mfxExtAVCRoundingOffset>(fieldId);
-            MSDK_CHECK_POINTER(ro, MFX_ERR_NULL_PTR);
-
-            SAFE_FREAD(&ro->EnableRoundingIntra, sizeof(mfxU16), 1, m_round_in, MFX_ERR_MORE_DATA);
-            SAFE_FREAD(&ro->RoundingOffsetIntra, sizeof(mfxU16), 1, m_round_in, MFX_ERR_MORE_DATA);
-            SAFE_FREAD(&ro->EnableRoundingInter, sizeof(mfxU16), 1, m_round_in, MFX_ERR_MORE_DATA);
-            SAFE_FREAD(&ro->RoundingOffsetInter, sizeof(mfxU16), 1, m_round_in, MFX_ERR_MORE_DATA);
-        }
+        mfxStatus sts = m_RoundingOffsetReader.GetNextFrame(ctrl, numFields);
+        if (sts != MFX_ERR_NONE)
+            return sts;
     }
 
     ctrl.Payload    = m_UserDataUnregSEI.data();
@@ -1903,7 +2319,12 @@ mfxStatus CEncodingPipeline::InitEncFrameParams(sTask* pTask) {
 }
 
 void CEncodingPipeline::Close() {
-    if (m_FileWriters.first) {
+    PrintStartupStat();
+
+    if (m_bBenchmark) {
+        PrintBenchmarkStat();
+    }
+    else if (m_FileWriters.first) {
         msdk_printf(MSDK_STRING("Frame number: %u\r\n"),
                     m_FileWriters.first->m_nProcessedFramesNum);
         mfxF64 ProcDeltaTime = m_statOverall.GetDeltaTime() - m_statFile.GetDeltaTime() -
@@ -1921,6 +2342,9 @@ void CEncodingPipeline::Close() {
                         (1000.0 * m_TaskPool.lastOut_total) /
                             (freq * m_FileWriters.first->m_nProcessedFramesNum));
         }
+
+        if (m_bSceneChangeIDR)
+            msdk_printf(MSDK_STRING("Scene changes: %u\n"), m_SceneChange.GetNumChanges());
     }
 
     std::for_each(m_UserDataUnregSEI.begin(), m_UserDataUnregSEI.end(), [](mfxPayload* payload) {
@@ -1942,15 +2366,15 @@ void CEncodingPipeline::Close() {
     DeleteFrames();
 
     m_TaskPool.Close();
+#ifdef ONEVPL_EXPERIMENTAL
+    m_EncodeStats.Close();
+#endif
     m_mfxSession.Close();
 
     m_FileReader.Close();
     FreeFileWriters();
 
-    if (m_round_in) {
-        fclose(m_round_in);
-        m_round_in = nullptr;
-    }
+    m_RoundingOffsetReader.Close();
     // allocator if used as external for MediaSDK must be deleted after SDK components
     DeleteAllocator();
 }
@@ -1973,23 +2397,149 @@ mfxStatus CEncodingPipeline::FillBuffers() {
     if (m_nPerfOpt) {
         for (mfxU32 i = 0; i < m_nPerfOpt; i++) {
             mfxFrameSurface1* surface = m_pmfxVPP ? &m_pVppSurfaces[i] : &m_pEncSurfaces[i];
+            mfxStatus sts             = MFX_ERR_NONE;
+
+            // surfaces of the internal allocator stay mapped since allocation
+            if (m_bExternalAlloc) {
+                sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis,
+                                            surface->Data.MemId,
+                                            &surface->Data);
+                MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Lock failed");
+            }
 
-            mfxStatus sts =
-                m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, surface->Data.MemId, &surface->Data);
-            MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Lock failed");
             sts = m_FileReader.LoadNextFrame(surface);
             MSDK_CHECK_STATUS(sts, "m_FileReader.LoadNextFrame failed");
 
-            sts = m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis,
-                                          surface->Data.MemId,
-                                          &surface->Data);
-            MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
+            if (m_bExternalAlloc) {
+                sts = m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis,
+                                              surface->Data.MemId,
+                                              &surface->Data);
+                MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
+            }
         }
     }
 
     return MFX_ERR_NONE;
 }
 
+mfxStatus CEncodingPipeline::WaitForPreloadedSurface(mfxFrameSurface1* pSurf) {
+    // the surface may still be held if the encoder buffers more frames than were preloaded, it
+    // is submitted again while locked only when there is no task left to wait for
+    while (pSurf->Data.Locked) {
+        mfxStatus sts = m_TaskPool.SynchronizeFirstTask(m_nSyncOpTimeout);
+        if (MFX_ERR_NOT_FOUND == sts)
+            break;
+        MSDK_CHECK_STATUS(sts, "m_TaskPool.SynchronizeFirstTask failed");
+    }
+
+    return MFX_ERR_NONE;
+}
+
+sEncodeStat CEncodingPipeline::GetEncodeStat() {
+    std::vector<msdk_tick> latency = m_TaskPool.frameLatency;
+
+    sEncodeStat stat = {};
+    stat.nFrames     = latency.size();
+    stat.nBytes      = m_TaskPool.outputBytes;
+    stat.fSeconds    = m_statOverall.GetTotalTime();
+    if (latency.empty())
+        return stat;
+
+    std::sort(latency.begin(), latency.end());
+    const mfxF64 freq = (mfxF64)time_get_frequency();
+    auto percentile   = [freq](const std::vector<msdk_tick>& sorted, mfxF64 p) {
+        size_t rank = (size_t)std::ceil(p * sorted.size());
+        return 1000.0 * sorted[std::max<size_t>(rank, 1) - 1] / freq;
+    };
+    stat.fLatencyP50 = percentile(latency, 0.5);
+    stat.fLatencyP90 = percentile(latency, 0.9);
+    stat.fLatencyP99 = percentile(latency, 0.99);
+    stat.fLatencyMax = 1000.0 * latency.back() / freq;
+
+    std::vector<msdk_tick> firstOutput = m_TaskPool.firstOutputLatency;
+    stat.nPartialOutputs               = m_TaskPool.partialOutputs;
+    if (!firstOutput.empty()) {
+        std::sort(firstOutput.begin(), firstOutput.end());
+        stat.fFirstOutputP50 = percentile(firstOutput, 0.5);
+        stat.fFirstOutputP99 = percentile(firstOutput, 0.99);
+    }
+
+    return stat;
+}
+
+void CEncodingPipeline::PrintBenchmarkStat() {
+    sEncodeStat stat = GetEncodeStat();
+
+    // bitrate of the stream played at its frame rate
+    const mfxFrameInfo& info = m_mfxEncParams.mfx.FrameInfo;
+    mfxF64 frameRate = info.FrameRateExtD ? (mfxF64)info.FrameRateExtN / info.FrameRateExtD : 0;
+    mfxF64 kbps      = stat.nFrames ? 8.0 * stat.nBytes * frameRate / (1000.0 * stat.nFrames) : 0;
+
+    msdk_printf(MSDK_STRING("Benchmark: frames: %lld, fps: %0.3f, bitrate: %0.1f kbps\n"),
+                (long long)stat.nFrames,
+                stat.fSeconds > 0 ? stat.nFrames / stat.fSeconds : 0.0,
+                kbps);
+    if (!stat.nFrames)
+        return;
+
+    msdk_printf(
+        MSDK_STRING("Encode latency: P50=%0.3f ms, P90=%0.3f ms, P99=%0.3f ms, MAX=%0.3f ms\n"),
+        stat.fLatencyP50,
+        stat.fLatencyP90,
+        stat.fLatencyP99,
+        stat.fLatencyMax);
+    if (stat.nPartialOutputs)
+        msdk_printf(MSDK_STRING("Partial output: %lld parts, first output latency: P50=%0.3f ms, "
+                                "P99=%0.3f ms\n"),
+                    (long long)stat.nPartialOutputs,
+                    stat.fFirstOutputP50,
+                    stat.fFirstOutputP99);
+}
+
+void CEncodingPipeline::MarkStartupPhase(const msdk_char* name) {
+    if (m_bStartupMarking)
+        m_StartupMarks.push_back(std::make_pair(name, time_get_tick()));
+}
+
+void CEncodingPipeline::PrintStartupStat() {
+    // nothing is printed if Init failed
+    if (m_StartupMarks.empty() || m_bStartupMarking)
+        return;
+
+    const mfxF64 freq     = (mfxF64)time_get_frequency();
+    const msdk_tick start = m_StartupMarks.front().second;
+    auto ms               = [freq](msdk_tick delta) {
+        return 1000.0 * delta / freq;
+    };
+
+    msdk_printf(MSDK_STRING("Startup:\n"));
+    for (size_t i = 1; i < m_StartupMarks.size(); i++)
+        msdk_printf(MSDK_STRING("  %s: %0.3f ms\n"),
+                    m_StartupMarks[i].first,
+                    ms(m_StartupMarks[i].second - m_StartupMarks[i - 1].second));
+    msdk_printf(MSDK_STRING("  Init total: %0.3f ms\n"), ms(m_StartupMarks.back().second - start));
+
+    if (m_TaskPool.firstPacketTime) {
+        msdk_printf(MSDK_STRING("  first frame submitted: %0.3f ms after Init start\n"),
+                    ms(m_TaskPool.firstSubmitTime - start));
+        msdk_printf(MSDK_STRING("Time to first packet: %0.3f ms, first frame encode: %0.3f ms\n"),
+                    ms(m_TaskPool.firstPacketTime - start),
+                    ms(m_TaskPool.firstPacketTime - m_TaskPool.firstSubmitTime));
+    }
+    else {
+        msdk_printf(MSDK_STRING("Time to first packet: no packet was output\n"));
+    }
+
+    // the pipeline is closed again by the destructor
+    m_StartupMarks.clear();
+}
+
+void CEncodingPipeline::ShareDevice(const CEncodingPipeline& pipeline) {
+    m_pLoader       = pipeline.m_pLoader;
+    m_hwdev         = pipeline.m_hwdev;
+    m_bSharedDevice = true;
+}
+
 mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
     MSDK_CHECK_POINTER(pParams, MFX_ERR_NULL_PTR);
     MSDK_CHECK_POINTER(m_pmfxENC, MFX_ERR_NOT_INITIALIZED);
@@ -2013,6 +2563,7 @@ mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
 
     sts = AllocFrames();
     MSDK_CHECK_STATUS(sts, "AllocFrames failed");
+    MarkStartupPhase(MSDK_STRING("frames"));
 
     m_mfxEncParams.mfx.FrameInfo.FourCC       = m_mfxVppParams.vpp.Out.FourCC;
     m_mfxEncParams.mfx.FrameInfo.ChromaFormat = m_mfxVppParams.vpp.Out.ChromaFormat;
@@ -2048,6 +2599,7 @@ mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
         }
         MSDK_CHECK_STATUS(sts, "m_pmfxVPP->Init failed");
     }
+    MarkStartupPhase(MSDK_STRING("components init"));
 
     mfxU32 nEncodedDataBufferSize = GetSufficientBufferSize();
     if (nEncodedDataBufferSize == 0)
@@ -2056,6 +2608,9 @@ mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
     void* fw_First  = m_FileWriters.first;
     void* fw_Second = m_FileWriters.second;
 
+#ifdef ONEVPL_EXPERIMENTAL
+    m_TaskPool.pEncodeStats = m_EncodeStats.IsOpen() ? &m_EncodeStats : NULL;
+#endif
     sts = m_TaskPool.Init(&m_mfxSession,
                           fw_First,
                           m_mfxEncParams.AsyncDepth,
@@ -2068,9 +2623,17 @@ mfxStatus CEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
 
     if (m_bSoftRobustFlag)
         m_TaskPool.SetGpuHangRecoveryFlag();
+    m_TaskPool.bCollectFrameStat = m_bBenchmark || pParams->bFrameStat;
+
+    if (pParams->bSyncThread) {
+        sts = m_TaskPool.StartSyncThread(m_nSyncOpTimeout);
+        MSDK_CHECK_STATUS(sts, "m_TaskPool.StartSyncThread failed");
+    }
+    MarkStartupPhase(MSDK_STRING("task pool"));
 
     sts = FillBuffers();
     MSDK_CHECK_STATUS(sts, "FillBuffers failed");
+    MarkStartupPhase(MSDK_STRING("preload"));
 
     return MFX_ERR_NONE;
 }
@@ -2080,9 +2643,11 @@ mfxStatus CEncodingPipeline::OpenRoundingOffsetFile(sInputParams* pInParams) {
 
     bool enableRoundingOffset =
         pInParams->RoundingOffsetFile && pInParams->CodecId == MFX_CODEC_AVC;
-    if (enableRoundingOffset && m_round_in == nullptr) {
-        MSDK_FOPEN(m_round_in, pInParams->RoundingOffsetFile, MSDK_CHAR("rb"));
-        if (m_round_in == nullptr) {
+    if (enableRoundingOffset && !m_RoundingOffsetReader.IsOpen()) {
+        // offsets are read ahead by as many frames as the encoder may have in flight
+        mfxStatus sts = m_RoundingOffsetReader.Init(pInParams->RoundingOffsetFile,
+                                                    pInParams->nAsyncDepth + 1);
+        if (sts != MFX_ERR_NONE) {
             msdk_printf(MSDK_STRING("ERROR: Can't open file %s\n"), pInParams->RoundingOffsetFile);
             return MFX_ERR_UNSUPPORTED;
         }
@@ -2251,7 +2816,16 @@ mfxStatus CEncodingPipeline::Run() {
         // find free surface for encoder input
         if (m_nPerfOpt && !m_pmfxVPP) {
             nEncSurfIdx %= m_nPerfOpt;
+            sts = WaitForPreloadedSurface(&m_pEncSurfaces[nEncSurfIdx]);
+            MSDK_BREAK_ON_ERROR(sts);
         }
+#if defined(ENABLE_V4L2_SUPPORT)
+        else if (isV4L2InputEnabled && !m_pmfxVPP) {
+            RequeueReleasedV4L2Buffers();
+            nEncSurfIdx = v4l2Pipeline.GetOffQ();
+            m_V4L2BuffersInUse.push_back(nEncSurfIdx);
+        }
+#endif
         else {
             nEncSurfIdx = GetFreeSurface(m_pEncSurfaces, m_EncResponse.NumFrameActual);
         }
@@ -2267,17 +2841,21 @@ mfxStatus CEncodingPipeline::Run() {
                 if (m_pmfxVPP) {
 #if defined(ENABLE_V4L2_SUPPORT)
                     if (isV4L2InputEnabled) {
+                        RequeueReleasedV4L2Buffers();
                         nVppSurfIdx = v4l2Pipeline.GetOffQ();
+                        m_V4L2BuffersInUse.push_back(nVppSurfIdx);
                     }
-#else
+                    else
+#endif
                     // find free surface for vpp input
                     if (m_nPerfOpt) {
                         nVppSurfIdx = nVppSurfIdx % m_nPerfOpt;
+                        sts         = WaitForPreloadedSurface(&m_pVppSurfaces[nVppSurfIdx]);
+                        MSDK_BREAK_ON_ERROR(sts);
                     }
                     else {
                         nVppSurfIdx = GetFreeSurface(m_pVppSurfaces, m_VppResponse.NumFrameActual);
                     }
-#endif
                     MSDK_CHECK_ERROR(nVppSurfIdx, MSDK_INVALID_SURF_IDX, MFX_ERR_MEMORY_ALLOC);
 
                     // point pSurf to vpp surface
@@ -2318,11 +2896,14 @@ mfxStatus CEncodingPipeline::Run() {
         if (m_pmfxVPP) {
             bVppMultipleOutput = false; // reset the flag before a call to VPP
             for (;;) {
-                sts = m_pmfxVPP->RunFrameVPPAsync(
-                    skipLoadingNextFrame ? NULL : &m_pVppSurfaces[nVppSurfIdx],
-                    &m_pEncSurfaces[nEncSurfIdx],
-                    NULL,
-                    &VppSyncPoint);
+                {
+                    MFX_ITT_TASK("RunFrameVPPAsync");
+                    sts = m_pmfxVPP->RunFrameVPPAsync(
+                        skipLoadingNextFrame ? NULL : &m_pVppSurfaces[nVppSurfIdx],
+                        &m_pEncSurfaces[nEncSurfIdx],
+                        NULL,
+                        &VppSyncPoint);
+                }
 
                 if (MFX_ERR_NONE < sts && !VppSyncPoint) // repeat the call if warning and no output
                 {
@@ -2377,10 +2958,14 @@ mfxStatus CEncodingPipeline::Run() {
 
             // at this point surface for encoder contains either a frame from file or a frame processed by vpp
             m_TaskPool.firstOut_start = m_TaskPool.lastOut_start = time_get_tick();
-            sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
-                                              &m_pEncSurfaces[nEncSurfIdx],
-                                              &pCurrentTask->mfxBS,
-                                              &pCurrentTask->EncSyncP);
+            pCurrentTask->submitTime  = m_TaskPool.firstOut_start;
+            {
+                MFX_ITT_TASK("EncodeFrameAsync");
+                sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
+                                                  &m_pEncSurfaces[nEncSurfIdx],
+                                                  &pCurrentTask->mfxBS,
+                                                  &pCurrentTask->EncSyncP);
+            }
 
             if (MFX_ERR_NONE < sts &&
                 !pCurrentTask->EncSyncP) // repeat the call if warning and no output
@@ -2426,10 +3011,13 @@ mfxStatus CEncodingPipeline::Run() {
             MSDK_CHECK_ERROR(nEncSurfIdx, MSDK_INVALID_SURF_IDX, MFX_ERR_MEMORY_ALLOC);
 
             for (;;) {
-                sts = m_pmfxVPP->RunFrameVPPAsync(NULL,
-                                                  &m_pEncSurfaces[nEncSurfIdx],
-                                                  NULL,
-                                                  &VppSyncPoint);
+                {
+                    MFX_ITT_TASK("RunFrameVPPAsync");
+                    sts = m_pmfxVPP->RunFrameVPPAsync(NULL,
+                                                      &m_pEncSurfaces[nEncSurfIdx],
+                                                      NULL,
+                                                      &VppSyncPoint);
+                }
 
                 if (MFX_ERR_NONE < sts && !VppSyncPoint) // repeat the call if warning and no output
                 {
@@ -2466,10 +3054,14 @@ mfxStatus CEncodingPipeline::Run() {
                     InsertIDR(pCurrentTask->encCtrl, m_bInsertIDR);
                 m_bInsertIDR = false;
 
-                sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
-                                                  &m_pEncSurfaces[nEncSurfIdx],
-                                                  &pCurrentTask->mfxBS,
-                                                  &pCurrentTask->EncSyncP);
+                pCurrentTask->submitTime = time_get_tick();
+                {
+                    MFX_ITT_TASK("EncodeFrameAsync");
+                    sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
+                                                      &m_pEncSurfaces[nEncSurfIdx],
+                                                      &pCurrentTask->mfxBS,
+                                                      &pCurrentTask->EncSyncP);
+                }
 
                 if (MFX_ERR_NONE < sts &&
                     !pCurrentTask->EncSyncP) // repeat the call if warning and no output
@@ -2511,10 +3103,14 @@ mfxStatus CEncodingPipeline::Run() {
                 InsertIDR(pCurrentTask->encCtrl, m_bInsertIDR);
             m_bInsertIDR = false;
 
-            sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
-                                              NULL,
-                                              &pCurrentTask->mfxBS,
-                                              &pCurrentTask->EncSyncP);
+            pCurrentTask->submitTime = time_get_tick();
+            {
+                MFX_ITT_TASK("EncodeFrameAsync");
+                sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
+                                                  NULL,
+                                                  &pCurrentTask->mfxBS,
+                                                  &pCurrentTask->EncSyncP);
+            }
 
             if (MFX_ERR_NONE < sts &&
                 !pCurrentTask->EncSyncP) // repeat the call if warning and no output
@@ -2606,6 +3202,8 @@ mfxStatus CEncodingPipeline::LoadNextFrame(mfxFrameSurface1* pSurf) {
             }
 
             sts = m_FileReader.LoadNextFrame(pSurf);
+            if (MFX_ERR_NONE == sts && m_bSceneChangeIDR)
+                m_bInsertIDR |= m_SceneChange.IsSceneChange(*pSurf);
 
             sts1 =
                 m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis, pSurf->Data.MemId, &(pSurf->Data));
@@ -2625,6 +3223,8 @@ mfxStatus CEncodingPipeline::LoadNextFrame(mfxFrameSurface1* pSurf) {
             }
 
             sts = m_FileReader.LoadNextFrame(pSurf);
+            if (MFX_ERR_NONE == sts && m_bSceneChangeIDR)
+                m_bInsertIDR |= m_SceneChange.IsSceneChange(*pSurf);
         }
 
         if ((MFX_ERR_MORE_DATA == sts) && !m_bTimeOutExceed) {
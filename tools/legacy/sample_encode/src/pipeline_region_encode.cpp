@@ -68,6 +68,36 @@ mfxStatus CResourcesPool::Init(int sz, VPLImplementationLoader* Loader, mfxU32 n
     return MFX_ERR_NONE;
 }
 
+mfxStatus CResourcesPool::Init(int sz,
+                               const std::vector<mfxI32>& adapters,
+                               mfxAccelerationMode accelerationMode,
+                               mfxU32 nSyncOpTimeout) {
+    MSDK_CHECK_NOT_EQUAL(m_resources, NULL, MFX_ERR_INVALID_HANDLE);
+    MSDK_CHECK_ERROR(adapters.empty(), true, MFX_ERR_NOT_INITIALIZED);
+    m_size           = sz;
+    m_resources      = new CMSDKResource[sz];
+    m_nSyncOpTimeout = nSyncOpTimeout;
+
+    for (int i = 0; i < sz; i++) {
+        mfxI32 adapterNum = adapters[i % adapters.size()];
+
+        std::unique_ptr<VPLImplementationLoader>& loader = m_loaders[adapterNum];
+        if (!loader) {
+            loader.reset(new VPLImplementationLoader);
+            loader->SetAdapterNum(adapterNum);
+
+            mfxStatus sts = loader->ConfigureAndEnumImplementations(MFX_IMPL_HARDWARE,
+                                                                    accelerationMode);
+            MSDK_CHECK_STATUS(sts, "loader->ConfigureAndEnumImplementations failed");
+        }
+
+        mfxStatus sts = m_resources[i].Session.CreateSession(loader.get());
+        MSDK_CHECK_STATUS(sts, "m_resources[i].Session.CreateSession failed");
+        m_resources[i].AdapterNum = adapterNum;
+    }
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CResourcesPool::InitTaskPools(CSmplBitstreamWriter* pWriter,
                                         mfxU32 nPoolSize,
                                         mfxU32 nBufferSize,
@@ -233,7 +263,11 @@ mfxStatus CRegionEncodingPipeline::CreateAllocator() {
         mfxIMPL impl;
         m_resources[0].Session.QueryIMPL(&impl);
 
-        if (MFX_IMPL_HARDWARE == MFX_IMPL_BASETYPE(impl)) {
+        if (m_resources[0].AdapterNum >= 0) {
+            sts = SetAdapterDeviceHandles();
+            MSDK_CHECK_STATUS(sts, "SetAdapterDeviceHandles failed");
+        }
+        else if (MFX_IMPL_HARDWARE == MFX_IMPL_BASETYPE(impl)) {
             sts = CreateHWDevice();
             MSDK_CHECK_STATUS(sts, "CreateHWDevice failed");
 
@@ -263,6 +297,33 @@ mfxStatus CRegionEncodingPipeline::CreateAllocator() {
     return MFX_ERR_NONE;
 }
 
+#ifdef LIBVA_SUPPORT
+mfxStatus CRegionEncodingPipeline::SetAdapterDeviceHandles() {
+    for (int i = 0; i < m_resources.GetSize(); i++) {
+        mfxI32 adapterNum = m_resources[i].AdapterNum;
+
+        std::unique_ptr<CHWDevice>& device = m_adapterDevices[adapterNum];
+        if (!device) {
+            // adapters of the library are numbered in order of render nodes from renderD128
+            device.reset(CreateVAAPIDevice("/dev/dri/renderD" + std::to_string(128 + adapterNum)));
+            MSDK_CHECK_POINTER(device.get(), MFX_ERR_MEMORY_ALLOC);
+
+            mfxStatus sts = device->Init(NULL, 0, adapterNum);
+            MSDK_CHECK_STATUS(sts, "device->Init failed");
+        }
+
+        mfxHDL hdl    = NULL;
+        mfxStatus sts = device->GetHandle(MFX_HANDLE_VA_DISPLAY, &hdl);
+        MSDK_CHECK_STATUS(sts, "device->GetHandle failed");
+
+        sts = m_resources[i].Session.SetHandle(MFX_HANDLE_VA_DISPLAY, hdl);
+        MSDK_CHECK_STATUS(sts, "m_resources[i].Session.SetHandle failed");
+    }
+
+    return MFX_ERR_NONE;
+}
+#endif
+
 CRegionEncodingPipeline::CRegionEncodingPipeline() : CEncodingPipeline() {
     m_timeAll = 0;
 }
@@ -294,7 +355,29 @@ mfxStatus CRegionEncodingPipeline::Init(sInputParams* pParams) {
         pParams->nNumSlice = 1;
 
     // Init session
-    if (pParams->bUseHWLib) {
+    if (!pParams->RegionAdapters.empty()) {
+        // regions are encoded on several adapters from surfaces in system memory
+        if (!pParams->bUseHWLib || SYSTEM_MEMORY != pParams->memType) {
+            msdk_printf(MSDK_STRING(
+                "Region adapters need hardware library and system memory in Region Encoding mode\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+
+        if (!pParams->accelerationMode) {
+#if D3D_SURFACES_SUPPORT
+            pParams->accelerationMode = MFX_ACCEL_MODE_VIA_D3D11;
+#elif defined(LIBVA_SUPPORT)
+            pParams->accelerationMode = MFX_ACCEL_MODE_VIA_VAAPI;
+#endif
+        }
+
+        sts = m_resources.Init(pParams->nNumSlice,
+                               pParams->RegionAdapters,
+                               pParams->accelerationMode,
+                               pParams->nSyncOpTimeout);
+        MSDK_CHECK_STATUS(sts, "m_resources.Init failed");
+    }
+    else if (pParams->bUseHWLib) {
         msdk_printf(MSDK_STRING("Hardware library is unsupported in Region Encoding mode\n"));
         return MFX_ERR_UNSUPPORTED;
     }
@@ -409,6 +492,9 @@ void CRegionEncodingPipeline::Close() {
 
     // allocator if used as external for MediaSDK must be deleted after SDK components
     DeleteAllocator();
+#ifdef LIBVA_SUPPORT
+    m_adapterDevices.clear();
+#endif
 }
 
 mfxStatus CRegionEncodingPipeline::ResetMFXComponents(sInputParams* pParams) {
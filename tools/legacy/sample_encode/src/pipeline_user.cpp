@@ -217,6 +217,10 @@ mfxStatus CUserPipeline::Init(sInputParams* pParams) {
 
         sts = m_pLoader->ConfigureImplementation(impl);
         MSDK_CHECK_STATUS(sts, "m_mfxSession.ConfigureImplementation failed");
+        sts = m_pLoader->ConfigureThreads(pParams->nThreadsNum,
+                                          pParams->SchedulingType,
+                                          pParams->Priority);
+        MSDK_CHECK_STATUS(sts, "m_pLoader->ConfigureThreads failed");
         sts = m_pLoader->ConfigureAccelerationMode(pParams->accelerationMode, impl);
         MSDK_CHECK_STATUS(sts, "m_mfxSession.ConfigureAccelerationMode failed");
         sts = m_pLoader->EnumImplementations();
@@ -253,10 +257,14 @@ mfxStatus CUserPipeline::Init(sInputParams* pParams) {
     sts = ResetMFXComponents(pParams);
     MSDK_CHECK_STATUS(sts, "ResetMFXComponents failed");
 
+    sts = m_RotateExecutor.Init();
+    MSDK_CHECK_STATUS(sts, "m_RotateExecutor.Init failed");
+
     return MFX_ERR_NONE;
 }
 
 void CUserPipeline::Close() {
+    m_RotateExecutor.Close();
     CEncodingPipeline::Close();
     if (m_PluginModule) {
         msdk_so_free(m_PluginModule);
@@ -287,6 +295,9 @@ mfxStatus CUserPipeline::ResetMFXComponents(sInputParams* pParams) {
 
     mfxU32 nEncodedDataBufferSize =
         m_mfxEncParams.mfx.FrameInfo.Width * m_mfxEncParams.mfx.FrameInfo.Height * 4;
+#ifdef ONEVPL_EXPERIMENTAL
+    m_TaskPool.pEncodeStats = m_EncodeStats.IsOpen() ? &m_EncodeStats : NULL;
+#endif
     sts = m_TaskPool.Init(&m_mfxSession,
                           m_FileWriters.first,
                           m_mfxEncParams.AsyncDepth,
@@ -297,12 +308,75 @@ mfxStatus CUserPipeline::ResetMFXComponents(sInputParams* pParams) {
 
     MSDK_CHECK_STATUS(sts, "m_TaskPool.Init failed");
 
+    if (pParams->bSyncThread) {
+        sts = m_TaskPool.StartSyncThread(m_nSyncOpTimeout);
+        MSDK_CHECK_STATUS(sts, "m_TaskPool.StartSyncThread failed");
+    }
+
     sts = FillBuffers();
     MSDK_CHECK_STATUS(sts, "FillBuffers failed");
 
     return MFX_ERR_NONE;
 }
 
+mfxStatus CUserPipeline::LockRotateSurfaces(mfxFrameSurface1* pIn, mfxFrameSurface1* pOut) {
+    if (SYSTEM_MEMORY != m_memType) {
+        mfxStatus sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, pIn->Data.MemId, &pIn->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Lock failed");
+        sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, pOut->Data.MemId, &pOut->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Lock failed");
+    }
+    // keeps the surfaces from being taken as free ones
+    msdk_atomic_inc16((volatile mfxU16*)&pIn->Data.Locked);
+    msdk_atomic_inc16((volatile mfxU16*)&pOut->Data.Locked);
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CUserPipeline::UnlockRotateSurfaces(mfxFrameSurface1* pIn, mfxFrameSurface1* pOut) {
+    msdk_atomic_dec16((volatile mfxU16*)&pIn->Data.Locked);
+    msdk_atomic_dec16((volatile mfxU16*)&pOut->Data.Locked);
+    if (SYSTEM_MEMORY != m_memType) {
+        mfxStatus sts =
+            m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis, pIn->Data.MemId, &pIn->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
+        sts = m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis, pOut->Data.MemId, &pOut->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CUserPipeline::EncodeOneFrame(sTask* pTask, mfxFrameSurface1* pSurface) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    for (;;) {
+        InsertIDR(pTask->encCtrl, m_bInsertIDR);
+        m_bInsertIDR = false;
+
+        sts = m_pmfxENC->EncodeFrameAsync(&pTask->encCtrl,
+                                          pSurface,
+                                          &pTask->mfxBS,
+                                          &pTask->EncSyncP);
+
+        if (MFX_ERR_NONE < sts && !pTask->EncSyncP) // repeat the call if warning and no output
+        {
+            if (MFX_WRN_DEVICE_BUSY == sts)
+                MSDK_SLEEP(1); // wait if device is busy
+        }
+        else if (MFX_ERR_NONE < sts && pTask->EncSyncP) {
+            sts = MFX_ERR_NONE; // ignore warnings if output is available
+            break;
+        }
+        else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+            sts = AllocateSufficientBuffer(pTask->mfxBS);
+            MSDK_CHECK_STATUS(sts, "AllocateSufficientBuffer failed");
+        }
+        else {
+            break;
+        }
+    }
+    return sts;
+}
+
 mfxStatus CUserPipeline::Run() {
     m_statOverall.StartTimeMeasurement();
     MSDK_CHECK_POINTER(m_pmfxENC, MFX_ERR_NOT_INITIALIZED);
@@ -311,9 +385,12 @@ mfxStatus CUserPipeline::Run() {
 
     sTask* pCurrentTask   = NULL; // a pointer to the current task
     mfxU16 nEncSurfIdx    = 0; // index of free surface for encoder input
-    mfxU16 nRotateSurfIdx = 0; // ~ for rotation plugin input
+    mfxU16 nRotateSurfIdx = 0; // ~ for rotation input
 
-    mfxSyncPoint RotateSyncPoint = NULL; // ~ with rotation plugin call
+    // the frame is rotated on the CPU threads while the previous one is given to the encoder
+    // and the next one is read
+    mfxFrameSurface1* pPendingIn  = NULL;
+    mfxFrameSurface1* pPendingOut = NULL;
 
     sts = MFX_ERR_NONE;
 
@@ -342,38 +419,39 @@ mfxStatus CUserPipeline::Run() {
         nEncSurfIdx = GetFreeSurface(m_pEncSurfaces, m_EncResponse.NumFrameActual);
         MSDK_CHECK_ERROR(nEncSurfIdx, MSDK_INVALID_SURF_IDX, MFX_ERR_MEMORY_ALLOC);
 
-        // save the id of preceding rotate task which will produce input data for the encode task
-        if (RotateSyncPoint) {
-            pCurrentTask->DependentVppTasks.push_back(RotateSyncPoint);
-            RotateSyncPoint = NULL;
+        // the rotation of the previous frame was running while this one was read
+        m_RotateExecutor.Wait();
+        if (pPendingIn) {
+            sts = UnlockRotateSurfaces(pPendingIn, pPendingOut);
+            MSDK_CHECK_STATUS(sts, "UnlockRotateSurfaces failed");
         }
 
-        for (;;) {
-            InsertIDR(pCurrentTask->encCtrl, m_bInsertIDR);
-            m_bInsertIDR = false;
-
-            sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
-                                              &m_pEncSurfaces[nEncSurfIdx],
-                                              &pCurrentTask->mfxBS,
-                                              &pCurrentTask->EncSyncP);
-
-            if (MFX_ERR_NONE < sts &&
-                !pCurrentTask->EncSyncP) // repeat the call if warning and no output
-            {
-                if (MFX_WRN_DEVICE_BUSY == sts)
-                    MSDK_SLEEP(1); // wait if device is busy
-            }
-            else if (MFX_ERR_NONE < sts && pCurrentTask->EncSyncP) {
-                sts = MFX_ERR_NONE; // ignore warnings if output is available
-                break;
-            }
-            else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
-                sts = AllocateSufficientBuffer(pCurrentTask->mfxBS);
-                MSDK_CHECK_STATUS(sts, "AllocateSufficientBuffer failed");
-            }
-            else {
-                break;
-            }
+        mfxFrameSurface1* pIn  = &m_pPluginSurfaces[nRotateSurfIdx];
+        mfxFrameSurface1* pOut = &m_pEncSurfaces[nEncSurfIdx];
+        sts                    = LockRotateSurfaces(pIn, pOut);
+        MSDK_CHECK_STATUS(sts, "LockRotateSurfaces failed");
+        pOut->Data.TimeStamp = pIn->Data.TimeStamp;
+        sts                  = SubmitRotateNV12(m_RotateExecutor, *pIn, *pOut);
+        MSDK_CHECK_STATUS(sts, "SubmitRotateNV12 failed");
+
+        // MFX_ERR_MORE_DATA of the encoder keeps the loop running
+        if (pPendingOut)
+            sts = EncodeOneFrame(pCurrentTask, pPendingOut);
+        pPendingIn  = pIn;
+        pPendingOut = pOut;
+    }
+
+    // the last rotated frame
+    m_RotateExecutor.Wait();
+    if (pPendingIn) {
+        mfxStatus sts1 = UnlockRotateSurfaces(pPendingIn, pPendingOut);
+        MSDK_CHECK_STATUS(sts1, "UnlockRotateSurfaces failed");
+
+        if (MFX_ERR_MORE_DATA == sts) {
+            sts = GetFreeTask(&pCurrentTask);
+            MSDK_CHECK_STATUS(sts, "GetFreeTask failed");
+            sts = EncodeOneFrame(pCurrentTask, pPendingOut);
+            MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
         }
     }
 
@@ -382,40 +460,14 @@ mfxStatus CUserPipeline::Run() {
     // exit in case of other errors
     MSDK_CHECK_STATUS(sts, "m_pmfENC->EncodeFrameAsync failed");
 
-    // rotate plugin doesn't buffer frames
+    // rotation doesn't buffer frames
     // loop to get buffered frames from encoder
     while (MFX_ERR_NONE <= sts) {
         // get a free task (bit stream and sync point for encoder)
         sts = GetFreeTask(&pCurrentTask);
         MSDK_BREAK_ON_ERROR(sts);
 
-        for (;;) {
-            InsertIDR(pCurrentTask->encCtrl, m_bInsertIDR);
-            m_bInsertIDR = false;
-
-            sts = m_pmfxENC->EncodeFrameAsync(&pCurrentTask->encCtrl,
-                                              NULL,
-                                              &pCurrentTask->mfxBS,
-                                              &pCurrentTask->EncSyncP);
-
-            if (MFX_ERR_NONE < sts &&
-                !pCurrentTask->EncSyncP) // repeat the call if warning and no output
-            {
-                if (MFX_WRN_DEVICE_BUSY == sts)
-                    MSDK_SLEEP(1); // wait if device is busy
-            }
-            else if (MFX_ERR_NONE < sts && pCurrentTask->EncSyncP) {
-                sts = MFX_ERR_NONE; // ignore warnings if output is available
-                break;
-            }
-            else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
-                sts = AllocateSufficientBuffer(pCurrentTask->mfxBS);
-                MSDK_CHECK_STATUS(sts, "AllocateSufficientBuffer failed");
-            }
-            else {
-                break;
-            }
-        }
+        sts = EncodeOneFrame(pCurrentTask, NULL);
         MSDK_BREAK_ON_ERROR(sts);
     }
 
@@ -459,7 +511,8 @@ mfxStatus CUserPipeline::FillBuffers() {
 }
 
 void CUserPipeline::PrintInfo() {
-    msdk_printf(MSDK_STRING("\nPipeline with rotation plugin"));
+    msdk_printf(MSDK_STRING("\nPipeline with rotation on %u CPU threads"),
+                m_RotateExecutor.GetThreadCount());
     msdk_printf(MSDK_STRING(
         "\nNOTE: Some of command line options may have been ignored as non-supported for this pipeline. For details see readme-encode.rtf.\n\n"));
 
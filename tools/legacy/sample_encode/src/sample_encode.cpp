@@ -11,6 +11,9 @@
 #include <memory>
 #include <regex>
 #include <string>
+#include <thread>
+#include <vector>
+#include "engine_utilization.h"
 #include "pipeline_encode.h"
 #include "pipeline_region_encode.h"
 #include "pipeline_user.h"
@@ -56,6 +59,25 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         MSDK_STRING(
             "Usage: %s <msdk-codecid> [<options>] -i InputYUVFile -o OutputEncodedFile -w width -h height\n"),
         strAppName);
+    msdk_printf(MSDK_STRING(
+        "   Inputs and outputs may be streams: - (stdin), pipe:<command>, tcp://[host]:port, udp://[host]:port\n"));
+    msdk_printf(MSDK_STRING(
+        "   h264 and h265 output to .ts or .mp4 file is muxed into MPEG-TS or fragmented MP4\n"));
+    msdk_printf(MSDK_STRING("   or: %s -par_streams ListFile [-engine_util]\n"), strAppName);
+    msdk_printf(MSDK_STRING("\n"));
+    msdk_printf(MSDK_STRING(
+        "   -par_streams ListFile    - encode several streams in parallel on one device, every line of ListFile\n"));
+    msdk_printf(MSDK_STRING(
+        "                              holds the options of one stream separated by spaces, lines starting\n"));
+    msdk_printf(MSDK_STRING(
+        "                              with # are skipped. Frames, fps and latency of every stream and\n"));
+    msdk_printf(MSDK_STRING(
+        "                              the aggregate fps are printed at the end\n"));
+    msdk_printf(MSDK_STRING("\n"));
+    msdk_printf(MSDK_STRING(
+        "   InputYUVFile may be compressed picture by picture with LZ4 or zstd (VPLZ container), the pictures\n"));
+    msdk_printf(MSDK_STRING(
+        "                              are decompressed ahead of the encoder on worker threads\n"));
     msdk_printf(MSDK_STRING("\n"));
     msdk_printf(MSDK_STRING("Supported codecs, <msdk-codecid>:\n"));
     msdk_printf(
@@ -84,6 +106,8 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
     #endif
     msdk_printf(MSDK_STRING("   [-pci domain:bus:device.function] - setup device with PCI \n"));
     msdk_printf(MSDK_STRING("                                 For example: \"0:3:0.0\"  \n"));
+    msdk_printf(MSDK_STRING(
+        "   [-enc_stats fileName]    - write frame level encode statistics (QP, PSNR, block counts) to the CSV file\n"));
 #endif
     msdk_printf(MSDK_STRING(
         "   [-dGfx] - preffer processing on dGfx (by default system decides), also can be set with index, for example: '-dGfx 1' \n"));
@@ -95,6 +119,14 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         "   [-dispatcher:fullSearch]  - enable search for all available implementations in oneVPL dispatcher\n"));
     msdk_printf(MSDK_STRING(
         "   [-dispatcher:lowLatency]  - enable limited implementation search and query in oneVPL dispatcher\n"));
+#if !defined(_WIN32) && !defined(_WIN64)
+    msdk_printf(MSDK_STRING("   [-threads_num]            - number of mediasdk task threads\n"));
+    msdk_printf(
+        MSDK_STRING("   [-threads_schedtype]      - scheduling type of mediasdk task threads\n"));
+    msdk_printf(MSDK_STRING("   [-threads_priority]       - priority of mediasdk task threads\n"));
+#endif
+    msdk_printf(MSDK_STRING(
+        "   [-cpu_affinity <cpu-list>] - run encoding and the threads of the CPU implementation on given CPUs, e.g. 0-7,16-23\n"));
 #ifdef MOD_ENC
     MOD_ENC_PRINT_HELP;
 #endif
@@ -229,6 +261,10 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         "   [-BitrateLimit:<on,off>] - Turn this flag ON to set bitrate limitations imposed by the SDK encoder. Off by default.\n"));
     msdk_printf(MSDK_STRING(
         "   [-re]                    - enable region encode mode. Works only with h265 encoder\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-re_adapters n0,n1,...] - encode regions on the hardware adapters with the numbers, region i uses the adapter i modulo\n"));
+    msdk_printf(MSDK_STRING(
+        "                              the count of the list. Input surfaces must be in system memory\n"));
     msdk_printf(MSDK_STRING("   [-trows rows]            - Number of rows for tiled encoding\n"));
     msdk_printf(
         MSDK_STRING("   [-tcols cols]            - Number of columns for tiled encoding\n"));
@@ -256,10 +292,10 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
     msdk_printf(MSDK_STRING(
         "   [-LowDelayBRC]           - strictly obey average frame size set by MaxKbps\n"));
 
-#if defined(_WIN64) || defined(_WIN32)
     msdk_printf(MSDK_STRING(
         "   [-PartialOutput <mode> <<block_size>>]         - specify partial output mode [0 - slice, 1 - block <blocksize>B, 2 - any]\n"));
-#endif
+    msdk_printf(MSDK_STRING(
+        "                              parts are written and flushed to the output as soon as the encoder gives them\n"));
 
     msdk_printf(MSDK_STRING(
         "   [-signal:tm ]            - represents transfer matrix coefficients for mfxExtVideoSignalInfo. 0 - unknown, 1 - BT709, 2 - BT601\n"));
@@ -273,11 +309,39 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         MSDK_STRING("   [-syncop_timeout]        - SyncOperation timeout in milliseconds\n"));
     msdk_printf(MSDK_STRING(
         "   [-perf_opt n]            - sets number of prefetched frames. In performance mode app preallocates buffer and loads first n frames\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-bench n]               - encoder benchmark: first n frames are preloaded to the input surfaces and encoded in cycle\n"));
+    msdk_printf(MSDK_STRING(
+        "                              for -timeout seconds or -n frames without output, prints fps, latency percentiles and bitrate\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-sync_thread]           - synchronize tasks and write bitstreams in a separate thread, submission of frames doesn't wait for output\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-tee dst]               - also write the output to dst from a separate thread, dst is a file or pipe:<command>; can be repeated\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-tee::drop dst]         - same as -tee, but when the queue of dst is full its frames are dropped until the next I frame\n"));
+    msdk_printf(MSDK_STRING(
+        "                              instead of waiting, so a slow destination doesn't stall the others\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-tee_queue N]           - frames queued for each -tee destination, default is 64\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-startup_stat]          - print durations of initialization phases and time to the first encoded frame, see -preset faststart\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-sc_idr]                - insert IDR frames at scene changes detected by luma histograms of the input frames,\n"));
+    msdk_printf(MSDK_STRING(
+        "                              GOP size defaults to 10 seconds of frames, so GOPs follow the scenes\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-planar_vpp]            - copy planes of I420 input as they are to YV12 surfaces and convert them to NV12 with VPP\n"));
+    msdk_printf(MSDK_STRING(
+        "                              rather than interleaving chroma on CPU (hw lib only)\n"));
     msdk_printf(MSDK_STRING("   [-fps]                   - limits overall fps of pipeline\n"));
     msdk_printf(MSDK_STRING(
         "   [-uncut]                 - do not cut output file in looped mode (in case of -timeout option)\n"));
     msdk_printf(MSDK_STRING(
         "   [-dump fileName]         - dump MSDK components configuration to the file in text form\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-engine_util]           - sample GPU engine utilization while encoding and print average at the end\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-alloc_stat]            - print memory held by the frame allocator and latencies of its Lock and Unlock at the end\n"));
     msdk_printf(MSDK_STRING(
         "   [-qpfile <filepath>]     - if specified, the encoder will take frame parameters (frame number, QP, frame type) from text file\n"));
     msdk_printf(MSDK_STRING(
@@ -332,7 +396,15 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
     msdk_printf(
         MSDK_STRING("   [-ExtBrcAdaptiveLTR:<on,off>] - Set AdaptiveLTR for implicit extbrc\n"));
     msdk_printf(MSDK_STRING(
-        "   [-preset <default,dss,conference,gaming>] - Use particular preset for encoding parameters\n"));
+        "   [-preset <default,dss,conference,gaming,faststart>] - Use particular preset for encoding parameters\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-preset auto:fps=<n>]   - Use the best quality preset reaching n fps on the device according to the preset profile\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-calibrate_presets]     - Benchmark the presets with target usages 1, 4 and 7 on the device and save them to the preset profile,\n"));
+    msdk_printf(MSDK_STRING(
+        "                              runs -bench 60 -n 600 unless -bench is set\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-preset_profile file]   - Preset profile of -preset auto and -calibrate_presets, sample_encode_presets.txt by default\n"));
     msdk_printf(MSDK_STRING("   [-pp] - Print preset parameters\n"));
     msdk_printf(MSDK_STRING("   [-ivf:<on,off>] - Turn IVF header on/off\n"));
     msdk_printf(MSDK_STRING(
@@ -371,6 +443,8 @@ void PrintHelp(msdk_char* strAppName, const msdk_char* strErrorMessage, ...) {
         MSDK_STRING("   [-uyvy]                        - Input Raw format types V4L2 Encode\n"));
     msdk_printf(
         MSDK_STRING("   [-YUY2]                        - Input Raw format types V4L2 Encode\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-nv12]                        - Input Raw format types V4L2 Encode, frames are captured into encoder surfaces directly if no resizing is needed\n"));
     msdk_printf(MSDK_STRING("   [-i::v4l2]                        - To enable v4l2 option\n"));
     msdk_printf(
         MSDK_STRING(
@@ -756,6 +830,13 @@ mfxStatus ParseAdditionalParams(msdk_char* strInput[],
         }
     }
     #endif
+    else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-enc_stats"))) {
+        VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+        if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->EncodeStatsFile)) {
+            PrintHelp(strInput[0], MSDK_STRING("File name of encode statistics is invalid"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
 #endif
     else {
         return MFX_ERR_NOT_FOUND;
@@ -870,6 +951,36 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+#if !defined(_WIN32) && !defined(_WIN64)
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_num"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nThreadsNum)) {
+                PrintHelp(strInput[0], MSDK_STRING("threads_num is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_schedtype"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_thread_get_schedtype(strInput[++i], pParams->SchedulingType)) {
+                PrintHelp(strInput[0], MSDK_STRING("threads_schedtype is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_priority"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->Priority)) {
+                PrintHelp(strInput[0], MSDK_STRING("threads_priority is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+#endif
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-cpu_affinity"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_parse_cpu_list(strInput[++i], pParams->CpuAffinity)) {
+                PrintHelp(strInput[0], MSDK_STRING("cpu_affinity is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-trows"))) {
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
             if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nEncTileRows)) {
@@ -899,6 +1010,9 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
             pParams->FileInputFourCC = MFX_FOURCC_YUY2;
         }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-nv12"))) {
+#if defined(ENABLE_V4L2_SUPPORT)
+            pParams->v4l2Format = NV12;
+#endif
             pParams->FileInputFourCC = MFX_FOURCC_NV12;
         }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-i420"))) {
@@ -1231,6 +1345,12 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-engine_util"))) {
+            pParams->bEngineUtilization = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-alloc_stat"))) {
+            pParams->bAllocStatistics = true;
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-perf_opt"))) {
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
 
@@ -1239,6 +1359,16 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-bench"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nPerfOpt) ||
+                !pParams->nPerfOpt) {
+                PrintHelp(strInput[0], MSDK_STRING("number of benchmark frames is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            pParams->bBenchmark = true;
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-WeightedPred:default"))) {
             pParams->WeightedPred = MFX_WEIGHTED_PRED_DEFAULT;
         }
@@ -1359,12 +1489,34 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 return MFX_ERR_UNSUPPORTED;
             }
 
-            pParams->PresetMode = CPresetManager::PresetNameToMode(presetName);
-            if (pParams->PresetMode == PRESET_MAX_MODES) {
-                PrintHelp(strInput[0], MSDK_STRING("Preset Name is invalid"));
+            if (1 == msdk_sscanf(presetName,
+                                 MSDK_STRING("auto:fps=%lf"),
+                                 &pParams->dAutoPresetFps)) {
+                if (pParams->dAutoPresetFps <= 0) {
+                    PrintHelp(strInput[0], MSDK_STRING("fps of auto preset is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+                // the preset is selected once the device is known
+                pParams->PresetMode = PRESET_DEFAULT;
+            }
+            else {
+                pParams->PresetMode = CPresetManager::PresetNameToMode(presetName);
+                if (pParams->PresetMode == PRESET_MAX_MODES) {
+                    PrintHelp(strInput[0], MSDK_STRING("Preset Name is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+            }
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-preset_profile"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->PresetProfile)) {
+                PrintHelp(strInput[0], MSDK_STRING("Preset profile file name is invalid"));
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-calibrate_presets"))) {
+            pParams->bCalibratePresets = true;
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-amfs:on"))) {
             pParams->nAdaptiveMaxFrameSize = MFX_CODINGOPTION_ON;
         }
@@ -1383,6 +1535,18 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-robust:soft"))) {
             pParams->bSoftRobustFlag = true;
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-sync_thread"))) {
+            pParams->bSyncThread = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-startup_stat"))) {
+            pParams->bStartupStat = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-sc_idr"))) {
+            pParams->bSceneChangeIDR = true;
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-planar_vpp"))) {
+            pParams->bPlanarVppInput = true;
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-num_slice"))) {
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
             if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nNumSlice)) {
@@ -1454,6 +1618,21 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
             pParams->dstFileBuff.push_back(strInput[++i]);
         }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-tee")) ||
+                 0 == msdk_strcmp(strInput[i], MSDK_STRING("-tee::drop"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            pParams->teeDropWhenFull.push_back(
+                0 == msdk_strcmp(strInput[i], MSDK_STRING("-tee::drop")));
+            pParams->teeFileBuff.push_back(strInput[++i]);
+        }
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-tee_queue"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+            if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nTeeQueueFrames) ||
+                !pParams->nTeeQueueFrames) {
+                PrintHelp(strInput[0], MSDK_STRING("-tee_queue is invalid"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-p"))) {
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
             pParams->pluginParams = ParsePluginGuid(strInput[++i]);
@@ -1481,7 +1660,24 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-re"))) {
             pParams->UseRegionEncode = true;
         }
-#if defined(_WIN64) || defined(_WIN32)
+        else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-re_adapters"))) {
+            VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
+
+            msdk_stringstream adapters(strInput[++i]);
+            pParams->RegionAdapters.clear();
+            for (msdk_string adapter; std::getline(adapters, adapter, MSDK_CHAR(','));) {
+                mfxI32 adapterNum = -1;
+                if (MFX_ERR_NONE != msdk_opt_read(adapter.c_str(), adapterNum) || adapterNum < 0) {
+                    PrintHelp(strInput[0], MSDK_STRING("region adapter number is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+                pParams->RegionAdapters.push_back(adapterNum);
+            }
+            if (pParams->RegionAdapters.empty()) {
+                PrintHelp(strInput[0], MSDK_STRING("region adapters are not specified"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
         else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-PartialOutput"))) {
             VAL_CHECK(i + 1 >= nArgNum, i, strInput[i]);
             if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->PartialOutputMode)) {
@@ -1501,7 +1697,6 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
                 }
             }
         }
-#endif
 #ifdef MOD_ENC
         MOD_ENC_PARSE_INPUT
 #endif
@@ -1756,11 +1951,21 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         return MFX_ERR_UNSUPPORTED;
     }
 
-    // Ignoring user-defined Async Depth for LA
-    if (pParams->nAsyncDepth == 0 || pParams->nMaxSliceSize) {
+    // Ignoring user-defined Async Depth for LA, the default one is set after presets
+    if (pParams->nMaxSliceSize) {
         pParams->nAsyncDepth = 4;
     }
 
+    if (pParams->UseRegionEncode && *pParams->EncodeStatsFile) {
+        PrintHelp(strInput[0], MSDK_STRING("-enc_stats isn't supported with -re"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    if (!pParams->UseRegionEncode && !pParams->RegionAdapters.empty()) {
+        PrintHelp(strInput[0], MSDK_STRING("-re_adapters requires -re"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
     if (pParams->UseRegionEncode) {
         if (pParams->CodecId != MFX_CODEC_HEVC) {
             msdk_printf(MSDK_STRING(
@@ -1775,6 +1980,72 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         }
     }
 
+    if (pParams->bCalibratePresets || pParams->dAutoPresetFps) {
+        // presets are applied to h264 and h265 in the hw lib only
+        if ((pParams->CodecId != MFX_CODEC_AVC && pParams->CodecId != MFX_CODEC_HEVC) ||
+            !pParams->bUseHWLib || pParams->UseRegionEncode || API_1X == pParams->verSessionInit) {
+            PrintHelp(
+                strInput[0],
+                MSDK_STRING(
+                    "-preset auto and -calibrate_presets support h264 and h265 in hw lib only, without -re and -api_ver_init::1x"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (!*pParams->PresetProfile)
+            msdk_strcopy(pParams->PresetProfile, MSDK_STRING("sample_encode_presets.txt"));
+    }
+
+    if (pParams->bCalibratePresets && !pParams->bBenchmark) {
+        // throughput is measured in the benchmark mode
+        pParams->bBenchmark = true;
+        if (!pParams->nPerfOpt)
+            pParams->nPerfOpt = 60;
+        if (!pParams->nNumFrames && !pParams->nTimeout)
+            pParams->nNumFrames = 600;
+    }
+
+    if (pParams->bBenchmark) {
+        if (pParams->dstFileBuff.size()) {
+            PrintHelp(strInput[0], MSDK_STRING("-bench doesn't support -o"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        // these modes read the input file while encoding
+        if (pParams->QPFileMode || pParams->bReadByFrame || pParams->isV4L2InputEnabled) {
+            PrintHelp(strInput[0],
+                      MSDK_STRING("-bench doesn't support -qpfile, -rbf and v4l2 input"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->bSceneChangeIDR) {
+        // these modes don't load every frame from the file in display order before encoding
+        if (pParams->QPFileMode || pParams->bReadByFrame || pParams->nPerfOpt ||
+            pParams->isV4L2InputEnabled) {
+            PrintHelp(strInput[0],
+                      MSDK_STRING("-sc_idr doesn't support -qpfile, -rbf, -perf_opt, -bench and "
+                                  "v4l2 input"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->bSyncThread) {
+        // these modes need the output of a frame before the next one is submitted
+        if (pParams->bSoftRobustFlag || pParams->nMaxFPS || pParams->PartialOutputMode ||
+            pParams->UseRegionEncode) {
+            PrintHelp(
+                strInput[0],
+                MSDK_STRING(
+                    "-sync_thread doesn't support -robust:soft, -fps, -PartialOutput and -re"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    if (pParams->teeFileBuff.size()) {
+        if (pParams->dstFileBuff.empty() || (MVC_VIEWOUTPUT & pParams->MVC_flags)) {
+            PrintHelp(strInput[0], MSDK_STRING("-tee requires -o and doesn't support -viewoutput"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
     if (pParams->dstFileBuff.size() == 0) {
         msdk_printf(MSDK_STRING("File output is disabled as -o option isn't specified\n"));
     }
@@ -1828,12 +2099,20 @@ mfxStatus ParseInputString(msdk_char* strInput[], mfxU8 nArgNum, sInputParams* p
         return MFX_ERR_UNSUPPORTED;
     }
 
+    if (pParams->bPlanarVppInput && pParams->FileInputFourCC != MFX_FOURCC_I420) {
+        PrintHelp(strInput[0], MSDK_STRING("-planar_vpp requires I420 input"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
     return MFX_ERR_NONE;
 }
 
 void ModifyParamsUsingPresets(sInputParams& params) {
-    if (!params.bUseHWLib)
+    if (!params.bUseHWLib) {
+        if (!params.nAsyncDepth)
+            params.nAsyncDepth = 4;
         return;
+    }
 
     COutputPresetParameters presetParams = CPresetManager::Inst.GetPreset(params.PresetMode,
                                                                           params.CodecId,
@@ -1884,9 +2163,16 @@ void ModifyParamsUsingPresets(sInputParams& params) {
     MODIFY_AND_PRINT_PARAM(params.nTargetUsage, TargetUsage, params.shouldPrintPresets);
     MODIFY_AND_PRINT_PARAM(params.WeightedBiPred, WeightedBiPred, params.shouldPrintPresets);
     MODIFY_AND_PRINT_PARAM(params.WeightedPred, WeightedPred, params.shouldPrintPresets);
+    MODIFY_AND_PRINT_PARAM_EXT(params.enableQSVFF,
+                               LowPower,
+                               presetParams.LowPower == MFX_CODINGOPTION_ON,
+                               params.shouldPrintPresets);
     if (params.shouldPrintPresets) {
         msdk_printf(MSDK_STRING("\n"));
     }
+
+    if (!params.nAsyncDepth)
+        params.nAsyncDepth = 4;
 }
 
 CEncodingPipeline* CreatePipeline(const sInputParams& params) {
@@ -1904,6 +2190,247 @@ CEncodingPipeline* CreatePipeline(const sInputParams& params) {
     }
 }
 
+// Benchmarks every preset with best quality, balanced and best speed target usages on the device
+// and saves the measurements to the preset profile, a preset failed on the device is skipped
+mfxStatus CalibratePresets(const sInputParams& cmdParams) {
+    const mfxU16 targetUsages[] = { MFX_TARGETUSAGE_BEST_QUALITY,
+                                    MFX_TARGETUSAGE_BALANCED,
+                                    MFX_TARGETUSAGE_BEST_SPEED };
+
+    // measurements of other devices and resolutions are kept
+    CPresetProfile profile;
+    mfxStatus sts = profile.Load(cmdParams.PresetProfile);
+    MSDK_IGNORE_MFX_STS(sts, MFX_ERR_NOT_FOUND);
+    MSDK_CHECK_STATUS(sts, "profile.Load failed");
+
+    for (int mode = PRESET_DEFAULT; mode < PRESET_MAX_MODES; mode++) {
+        for (mfxU16 targetUsage : targetUsages) {
+            sInputParams params = cmdParams;
+            params.PresetMode   = (EPresetModes)mode;
+            params.nTargetUsage = targetUsage;
+            ModifyParamsUsingPresets(params);
+
+            msdk_string presetName = CPresetManager::PresetModeToName(params.PresetMode);
+            msdk_printf(MSDK_STRING("\nCalibrating preset %s, target usage %d\n"),
+                        presetName.c_str(),
+                        targetUsage);
+
+            std::unique_ptr<CEncodingPipeline> pipeline(CreatePipeline(params));
+            MSDK_CHECK_POINTER(pipeline.get(), MFX_ERR_MEMORY_ALLOC);
+
+            sts = pipeline->Init(&params);
+            if (MFX_ERR_NONE == sts)
+                sts = pipeline->Run();
+            sEncodeStat stat = pipeline->GetEncodeStat();
+            msdk_string device = pipeline->GetDeviceKey();
+            pipeline->Close();
+
+            if (sts < MFX_ERR_NONE || !stat.nFrames || stat.fSeconds <= 0) {
+                msdk_printf(MSDK_STRING("Preset %s, target usage %d failed, it isn't saved\n"),
+                            presetName.c_str(),
+                            targetUsage);
+                continue;
+            }
+
+            CPresetMeasurement measurement = {};
+            measurement.Device             = device;
+            measurement.CodecId            = params.CodecId;
+            measurement.Mode               = params.PresetMode;
+            measurement.TargetUsage        = targetUsage;
+            measurement.Width              = params.nDstWidth;
+            measurement.Height             = params.nDstHeight;
+            measurement.Fps                = stat.nFrames / stat.fSeconds;
+            measurement.LatencyP99         = stat.fLatencyP99;
+            profile.Add(measurement);
+        }
+    }
+
+    sts = profile.Save(cmdParams.PresetProfile);
+    MSDK_CHECK_STATUS(sts, "profile.Save failed");
+    msdk_printf(MSDK_STRING("\nPreset profile is saved to %s\n"), cmdParams.PresetProfile);
+
+    return MFX_ERR_NONE;
+}
+
+// Selects the preset of -preset auto from the profile of the device the pipeline's loader selects
+mfxStatus SelectAutoPreset(CEncodingPipeline& pipeline, sInputParams& params) {
+    mfxStatus sts = pipeline.CreateLoader(&params);
+    MSDK_CHECK_STATUS(sts, "pipeline.CreateLoader failed");
+
+    CPresetProfile profile;
+    sts = profile.Load(params.PresetProfile);
+    if (MFX_ERR_NOT_FOUND == sts)
+        msdk_printf(MSDK_STRING("error: preset profile %s not found, see -calibrate_presets\n"),
+                    params.PresetProfile);
+    MSDK_CHECK_STATUS(sts, "profile.Load failed");
+
+    msdk_string device = pipeline.GetDeviceKey();
+    CPresetMeasurement measurement;
+    if (!profile.Select(device,
+                        params.CodecId,
+                        params.nDstWidth,
+                        params.nDstHeight,
+                        params.dAutoPresetFps,
+                        measurement)) {
+        msdk_printf(MSDK_STRING("error: no preset of profile %s reaches %.2f fps on %s\n"),
+                    params.PresetProfile,
+                    params.dAutoPresetFps,
+                    device.c_str());
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    params.PresetMode = measurement.Mode;
+    if (!params.nTargetUsage)
+        params.nTargetUsage = measurement.TargetUsage;
+    msdk_printf(MSDK_STRING("Preset %s with target usage %d is selected, %.2f fps at %ux%u\n"),
+                CPresetManager::PresetModeToName(measurement.Mode).c_str(),
+                measurement.TargetUsage,
+                measurement.Fps,
+                measurement.Width,
+                measurement.Height);
+
+    return MFX_ERR_NONE;
+}
+
+// Reads options of the streams from the list file, every non-empty line that doesn't start with #
+// is parsed as the command line of one stream
+mfxStatus ParseStreamsParFile(msdk_char* strAppName,
+                              const msdk_char* strFileName,
+                              std::vector<sInputParams>& params) {
+    FILE* parFile = NULL;
+    MSDK_FOPEN(parFile, strFileName, MSDK_STRING("r"));
+    if (NULL == parFile) {
+        msdk_printf(MSDK_STRING("error: list file \"%s\" not found\n"), strFileName);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxStatus sts = MFX_ERR_NONE;
+    msdk_char line[4096];
+    while (MFX_ERR_NONE == sts && msdk_fgets(line, MSDK_ARRAY_LEN(line), parFile)) {
+        std::vector<msdk_string> tokens;
+        msdk_stringstream lineStream(line);
+        for (msdk_string token; lineStream >> token;)
+            tokens.push_back(token);
+        if (tokens.empty() || MSDK_CHAR('#') == tokens[0][0])
+            continue;
+
+        std::vector<msdk_char*> argv = { strAppName };
+        for (msdk_string& token : tokens)
+            argv.push_back(&token[0]);
+        if (argv.size() > std::numeric_limits<mfxU8>::max()) {
+            msdk_printf(MSDK_STRING("error: too many options of stream %d\n"), (int)params.size());
+            sts = MFX_ERR_UNSUPPORTED;
+            break;
+        }
+
+        sInputParams streamParams = {};
+        sts = ParseInputString(argv.data(), (mfxU8)argv.size(), &streamParams);
+        if (MFX_ERR_NONE != sts)
+            break;
+        ModifyParamsUsingPresets(streamParams);
+
+        // the base pipeline on a device selected by the first stream is supported only
+        if (streamParams.UseRegionEncode || streamParams.nRotationAngle ||
+            streamParams.isV4L2InputEnabled || API_1X == streamParams.verSessionInit ||
+            streamParams.dAutoPresetFps || streamParams.bCalibratePresets) {
+            msdk_printf(MSDK_STRING(
+                "error: stream %d: region encode, rotation, v4l2 input, API 1.x sessions and preset profiles are not supported with -par_streams\n"),
+                        (int)params.size());
+            sts = MFX_ERR_UNSUPPORTED;
+            break;
+        }
+        streamParams.bFrameStat = true;
+        params.push_back(streamParams);
+    }
+    fclose(parFile);
+    MSDK_CHECK_STATUS(sts, "ParseStreamsParFile failed");
+
+    if (params.empty()) {
+        msdk_printf(MSDK_STRING("error: list file \"%s\" has no streams\n"), strFileName);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    return MFX_ERR_NONE;
+}
+
+// Encodes the streams in pipelines sharing loader and device of the first one, each pipeline
+// runs in its own thread
+mfxStatus RunMultiStreamEncoding(std::vector<sInputParams>& params, bool bEngineUtilization) {
+    // owner of the device is destroyed after the pipelines using it
+    CEncodingPipeline Owner;
+    std::vector<std::unique_ptr<CEncodingPipeline>> pipelines;
+    std::vector<CEncodingPipeline*> streams = { &Owner };
+
+    mfxStatus sts = Owner.Init(&params[0]);
+    MSDK_CHECK_STATUS(sts, "Pipeline.Init failed");
+
+    for (size_t i = 1; i < params.size(); i++) {
+        pipelines.emplace_back(new CEncodingPipeline);
+        pipelines.back()->ShareDevice(Owner);
+
+        sts = pipelines.back()->Init(&params[i]);
+        MSDK_CHECK_STATUS(sts, "Pipeline.Init failed");
+        streams.push_back(pipelines.back().get());
+    }
+
+    for (CEncodingPipeline* stream : streams)
+        stream->PrintInfo();
+
+    msdk_printf(MSDK_STRING("Encoding of %d streams started\n"), (int)streams.size());
+
+    CEngineUtilizationSampler engineSampler;
+    if (bEngineUtilization)
+        engineSampler.Start();
+
+    CTimer timer;
+    timer.Start();
+
+    // a device shared by the streams is not reset, losing it finishes the stream
+    std::vector<mfxStatus> results(streams.size(), MFX_ERR_NONE);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < streams.size(); i++) {
+        threads.emplace_back([&, i]() {
+            results[i] = streams[i]->Run();
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    mfxF64 elapsed = timer.GetTime();
+
+    msdk_printf(MSDK_STRING("\nEncoding finished\n"));
+
+    mfxU64 totalFrames = 0;
+    for (size_t i = 0; i < streams.size(); i++) {
+        sEncodeStat stat = streams[i]->GetEncodeStat();
+        msdk_printf(MSDK_STRING(
+            "Stream %d: frames: %lld, fps: %0.3f, latency: P50=%0.3f ms, P99=%0.3f ms, MAX=%0.3f ms%s\n"),
+                    (int)i,
+                    (long long)stat.nFrames,
+                    stat.fSeconds > 0 ? stat.nFrames / stat.fSeconds : 0.0,
+                    stat.fLatencyP50,
+                    stat.fLatencyP99,
+                    stat.fLatencyMax,
+                    results[i] < MFX_ERR_NONE ? MSDK_STRING(", failed") : MSDK_STRING(""));
+        totalFrames += stat.nFrames;
+
+        if (results[i] < MFX_ERR_NONE)
+            sts = results[i];
+    }
+    msdk_printf(MSDK_STRING("Total: streams: %d, frames: %lld, fps: %0.3f\n"),
+                (int)streams.size(),
+                (long long)totalFrames,
+                elapsed > 0 ? totalFrames / elapsed : 0.0);
+
+    if (bEngineUtilization) {
+        engineSampler.Stop();
+        msdk_printf(MSDK_STRING("Engine utilization: %s\n"),
+                    CEngineUtilizationSampler::ToString(engineSampler.GetAverage()).c_str());
+    }
+
+    return sts;
+}
+
 #if defined(_WIN32) || defined(_WIN64)
 int _tmain(int argc, msdk_char* argv[])
 #else
@@ -1915,18 +2442,51 @@ int main(int argc, char* argv[])
 
     mfxStatus sts = MFX_ERR_NONE; // return value check
 
+    if (argc > 1 && 0 == msdk_strcmp(argv[1], MSDK_STRING("-par_streams"))) {
+        bool bEngineUtilization =
+            argc == 4 && 0 == msdk_strcmp(argv[3], MSDK_STRING("-engine_util"));
+        if (argc < 3 || (argc > 3 && !bEngineUtilization)) {
+            PrintHelp(argv[0],
+                      MSDK_STRING("-par_streams takes the list file and -engine_util only"));
+            return 1;
+        }
+
+        std::vector<sInputParams> params;
+        sts = ParseStreamsParFile(argv[0], argv[2], params);
+        MSDK_CHECK_PARSE_RESULT(sts, MFX_ERR_NONE, 1);
+
+        sts = RunMultiStreamEncoding(params, bEngineUtilization);
+        MSDK_CHECK_STATUS(sts, "RunMultiStreamEncoding failed");
+
+        msdk_printf(MSDK_STRING("\nProcessing finished\n"));
+        return 0;
+    }
+
     // Parsing Input stream workign with presets
     sts = ParseInputString(argv, (mfxU8)argc, &Params);
 
-    ModifyParamsUsingPresets(Params);
-
     MSDK_CHECK_PARSE_RESULT(sts, MFX_ERR_NONE, 1);
 
+    if (Params.bCalibratePresets) {
+        sts = CalibratePresets(Params);
+        MSDK_CHECK_STATUS(sts, "CalibratePresets failed");
+
+        msdk_printf(MSDK_STRING("\nProcessing finished\n"));
+        return 0;
+    }
+
     // Choosing which pipeline to use
     pPipeline.reset(CreatePipeline(Params));
 
     MSDK_CHECK_POINTER(pPipeline.get(), MFX_ERR_MEMORY_ALLOC);
 
+    if (Params.dAutoPresetFps) {
+        sts = SelectAutoPreset(*pPipeline, Params);
+        MSDK_CHECK_STATUS(sts, "SelectAutoPreset failed");
+    }
+
+    ModifyParamsUsingPresets(Params);
+
     if (MVC_ENABLED & Params.MVC_flags) {
         pPipeline->SetNumView(Params.numViews);
     }
@@ -1938,6 +2498,10 @@ int main(int argc, char* argv[])
 
     msdk_printf(MSDK_STRING("Processing started\n"));
 
+    CEngineUtilizationSampler engineSampler;
+    if (Params.bEngineUtilization)
+        engineSampler.Start();
+
     if (pPipeline->CaptureStartV4L2Pipeline() != MFX_ERR_NONE) {
         msdk_printf(MSDK_STRING("V4l2 failure terminating the program\n"));
         return 0;
@@ -1966,6 +2530,12 @@ int main(int argc, char* argv[])
 
     pPipeline->Close();
 
+    if (Params.bEngineUtilization) {
+        engineSampler.Stop();
+        msdk_printf(MSDK_STRING("Engine utilization: %s\n"),
+                    CEngineUtilizationSampler::ToString(engineSampler.GetAverage()).c_str());
+    }
+
     msdk_printf(MSDK_STRING("\nProcessing finished\n"));
 
     return 0;
@@ -15,6 +15,7 @@ extern "C" {
     #include <poll.h>
     #include <wayland-client.h>
     #include <list>
+    #include <map>
     #include "mfx_buffering.h"
     #include "sample_defs.h"
     #include "vpl/mfxstructures.h"
@@ -25,6 +26,17 @@ extern "C" {
 
 typedef struct buffer wld_buffer;
 
+/* wl_buffer kept for a surface of the pool with the parameters it was created with */
+struct CachedBuffer {
+    struct wl_buffer* buffer;
+    uint32_t name;
+    int32_t width;
+    int32_t height;
+    uint32_t format;
+    int32_t offsets[3];
+    int32_t pitches[3];
+};
+
 /* ShmPool Struct */
 struct ShmPool {
     int fd;
@@ -68,6 +80,19 @@ public:
                                                 uint32_t format,
                                                 int32_t offsets[3],
                                                 int32_t pitches[3]);
+    /* Returns the wl_buffer created for the surface mid by an earlier call or creates it with
+     * CreatePrimeBuffer(). The buffer is reused for every presentation of the surface until
+     * DestroyBufferCache() is called, it is recreated if the export parameters change. */
+    virtual struct wl_buffer* GetCachedPrimeBuffer(mfxMemId mid,
+                                                   uint32_t name,
+                                                   int32_t width,
+                                                   int32_t height,
+                                                   uint32_t format,
+                                                   int32_t offsets[3],
+                                                   int32_t pitches[3]);
+    bool IsCachedBuffer(struct wl_buffer* buffer) const;
+    /* Destroys the cached wl_buffers, must be called when the surface pool is destroyed */
+    virtual void DestroyBufferCache();
     struct wl_display* GetDisplay() {
         return m_display;
     }
@@ -165,6 +190,7 @@ private:
     char* m_device_name;
     int m_x, m_y;
     bool m_perf_mode;
+    std::map<mfxMemId, CachedBuffer> m_buffer_cache;
 
 protected:
     std::list<wld_buffer*> m_buffers_list;
@@ -158,7 +158,9 @@ void Wayland::RenderBuffer(struct wl_buffer* buffer, mfxFrameSurface1* surface)
     wl_proxy_set_queue((struct wl_proxy*)buffer, m_event_queue);
 
     AddBufferToList(m_buffer);
-    wl_buffer_add_listener(buffer, &buffer_listener, this);
+    // cached buffers keep the listener added on the first presentation
+    if (NULL == wl_proxy_get_listener((struct wl_proxy*)buffer))
+        wl_buffer_add_listener(buffer, &buffer_listener, this);
     m_pending_frame = 1;
     if (m_perf_mode)
         m_callback = wl_display_sync(m_display);
@@ -340,7 +342,65 @@ struct wl_buffer* Wayland::CreatePrimeBuffer(uint32_t name,
     return buffer;
 }
 
+struct wl_buffer* Wayland::GetCachedPrimeBuffer(mfxMemId mid,
+                                                uint32_t name,
+                                                int32_t width,
+                                                int32_t height,
+                                                uint32_t format,
+                                                int32_t offsets[3],
+                                                int32_t pitches[3]) {
+    std::map<mfxMemId, CachedBuffer>::iterator it = m_buffer_cache.find(mid);
+    if (it != m_buffer_cache.end()) {
+        const CachedBuffer& cached = it->second;
+        if (cached.name == name && cached.width == width && cached.height == height &&
+            cached.format == format &&
+            0 == std::memcmp(cached.offsets, offsets, sizeof(cached.offsets)) &&
+            0 == std::memcmp(cached.pitches, pitches, sizeof(cached.pitches)))
+            return cached.buffer;
+
+        // the memory id was reused by a new surface
+        wl_buffer_destroy(cached.buffer);
+        m_buffer_cache.erase(it);
+    }
+
+    struct wl_buffer* buffer = CreatePrimeBuffer(name, width, height, format, offsets, pitches);
+    if (NULL == buffer)
+        return NULL;
+
+    CachedBuffer cached;
+    cached.buffer = buffer;
+    cached.name   = name;
+    cached.width  = width;
+    cached.height = height;
+    cached.format = format;
+    std::memcpy(cached.offsets, offsets, sizeof(cached.offsets));
+    std::memcpy(cached.pitches, pitches, sizeof(cached.pitches));
+    m_buffer_cache[mid] = cached;
+    return buffer;
+}
+
+bool Wayland::IsCachedBuffer(struct wl_buffer* buffer) const {
+    std::map<mfxMemId, CachedBuffer>::const_iterator it;
+    for (it = m_buffer_cache.begin(); it != m_buffer_cache.end(); ++it) {
+        if (it->second.buffer == buffer)
+            return true;
+    }
+    return false;
+}
+
+void Wayland::DestroyBufferCache() {
+    // release events of destroyed buffers are not delivered, so unlock the surfaces now
+    if (0 != m_buffers_list.size())
+        DestroyBufferList();
+
+    std::map<mfxMemId, CachedBuffer>::iterator it;
+    for (it = m_buffer_cache.begin(); it != m_buffer_cache.end(); ++it)
+        wl_buffer_destroy(it->second.buffer);
+    m_buffer_cache.clear();
+}
+
 Wayland::~Wayland() {
+    DestroyBufferCache();
     if (NULL != m_shell)
         wl_shell_destroy(m_shell);
     if (NULL != m_shm)
@@ -9,14 +9,20 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <ctime>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "base_allocator.h"
@@ -24,9 +30,11 @@
 #include "rotate_plugin_api.h"
 #include "sample_defs.h"
 #include "sample_utils.h"
+#include "surface_pool_service.h"
 #include "sysmem_allocator.h"
 
 #include "brc_routines.h"
+#include "encode_stats_writer.h"
 #include "hw_device.h"
 #include "mfxdeprecated.h"
 #include "mfxjpeg.h"
@@ -35,6 +43,7 @@
 #include "mfxvp8.h"
 #include "plugin_utils.h"
 #include "preset_manager.h"
+#include "quality_meter.h"
 #include "sample_defs.h"
 #include "smt_tracer.h"
 #include "vpl/mfxdispatcher.h"
@@ -58,6 +67,12 @@
 
 #define MAX_PREF_LEN 256
 
+// declared by mfxdeprecated.h for MFX_ONEVPL builds only
+template <>
+struct mfx_ext_buffer_id<mfxExtMultiFrameParam> {
+    enum { id = MFX_EXTBUFF_MULTI_FRAME_PARAM };
+};
+
 #ifndef MFX_VERSION
     #error MFX_VERSION not defined
 #endif
@@ -150,6 +165,12 @@ enum MemoryModel {
 // it is located at 0
 enum eAPIVersion { API_2X, API_1X };
 
+// values of sInputParams::NumaNode besides explicit node number
+enum NumaNodeSelection {
+    NUMA_NODE_AUTO = -1, // node the adapter is attached to
+    NUMA_NODE_OFF  = -2 // threads and memory are not placed
+};
+
 struct __sInputParams {
     mfxU32 TargetID    = 0;
     bool CascadeScaler = false;
@@ -175,10 +196,8 @@ struct __sInputParams {
     mfxU32 PCIFunction  = 0;
     bool PCIDeviceSetup = false;
 
-#if (defined(_WIN64) || defined(_WIN32))
     bool isDualMode;
     mfxHyperMode hyperMode;
-#endif
 #if (defined(_WIN32) || defined(_WIN64))
     //Adapter type
     bool bPrefferiGfx;
@@ -195,6 +214,8 @@ struct __sInputParams {
     bool dispFullSearch = DEF_DISP_FULLSEARCH;
 
     mfxU16 nThreadsNum; // number of internal session threads number
+    mfxI32 SchedulingType = 0; // scheduling policy of internal session threads
+    mfxI32 Priority       = 0; // priority of internal session threads
     bool bRobustFlag; // Robust transcoding mode. Allows auto-recovery after hardware errors
     bool bSoftRobustFlag;
 
@@ -204,6 +225,9 @@ struct __sInputParams {
     msdk_char strSrcFile[MSDK_MAX_FILENAME_LEN]; // source bitstream file
     msdk_char strDstFile[MSDK_MAX_FILENAME_LEN]; // destination bitstream file
     msdk_char strDumpVppCompFile[MSDK_MAX_FILENAME_LEN]; // VPP composition output dump file
+    msdk_char strLatencyLogFile[MSDK_MAX_FILENAME_LEN]; // per-frame latency log
+    msdk_char strEncodeStatsFile[MSDK_MAX_FILENAME_LEN]; // frame level encode statistics
+    msdk_char strQualityFile[MSDK_MAX_FILENAME_LEN]; // per-frame PSNR/SSIM of the output
     msdk_char strMfxParamsDumpFile[MSDK_MAX_FILENAME_LEN];
 
     msdk_char strTCBRCFilePath[MSDK_MAX_FILENAME_LEN];
@@ -235,6 +259,8 @@ struct __sInputParams {
     mfxU16 ScalingMode;
 
     mfxU16 nAsyncDepth; // asyncronous queue
+    mfxU16 nAsyncDepthMin; // lower bound of adaptive async depth, 0 if depth is fixed
+    bool bLowLatency; // one frame in flight, synced as soon as it's submitted
 
     PipelineMode eMode;
     PipelineMode eModeExt;
@@ -324,6 +350,9 @@ struct __sInputParams {
     mfxU16 nVppCompSrcW;
     mfxU16 nVppCompSrcH;
     mfxU16 nVppCompTileId;
+    // grid the composed streams without explicit destination are placed into, 0 if not set
+    mfxU16 nVppCompGridCols;
+    mfxU16 nVppCompGridRows;
 
     mfxU32 DecoderFourCC;
     mfxU32 EncoderFourCC;
@@ -331,6 +360,9 @@ struct __sInputParams {
     sVppCompDstRect* pVppCompDstRects;
 
     bool bForceSysMem;
+    bool bAsyncWriter; // output file is written from a dedicated thread
+    bool bPrefetchInput; // input file is read ahead on a dedicated thread
+    bool bNoSharedDecode; // session doesn't share decode of the same input with other sessions
     mfxU16 DecOutPattern;
     mfxU16 VppOutPattern;
     mfxU16 nGpuCopyMode;
@@ -359,6 +391,7 @@ struct __sInputParams {
     mfxU16 numMFEFrames;
     mfxU16 MFMode;
     mfxU32 mfeTimeout;
+    mfxI32 MFEGroupLeader; // session joined by this one in -mfe_auto group, own index for itself
 
     mfxU16 TargetBitDepthLuma;
     mfxU16 TargetBitDepthChroma;
@@ -392,6 +425,30 @@ struct __sInputParams {
 
     bool IsSourceMSB      = false;
     mfxU32 nSyncOpTimeout = MSDK_WAIT_INTERVAL; // SyncOperation timeout in msec
+    // size of lock-free ring between joined sessions, 0 - mutex protected list is used
+    mfxU32 nSurfBufferRingSize = 0;
+
+    // CPUs to run session threads on, empty - CPUs of NumaNode
+    std::vector<mfxU32> CpuAffinity;
+    // node for session threads and system memory surfaces, see NumaNodeSelection
+    mfxI32 NumaNode = NUMA_NODE_AUTO;
+    // system memory surfaces from the pool of huge pages of the session allocator
+    bool bSysMemPool = false;
+    // encoder surfaces from the pool shared by the sessions of the device
+    bool bSharedSurfacePool = false;
+    // counters of the session allocator are printed at the end
+    bool bAllocStatistics = false;
+    // input is split at random access points into segments transcoded by parallel sessions
+    mfxU32 nSegments = 0;
+    // bytes of the input file the session reads, 0 end - to the end of file
+    mfxU64 nInputBegin = 0;
+    mfxU64 nInputEnd   = 0;
+    // rendition of 1_to_N ladder sharing one lookahead pass, see LaQPExchange
+    bool bLaShare = false;
+    // decoder skips frames dropped downstream by -FRC::PT, see UpdateDecodeSkip
+    bool bDecSkip = false;
+    // composition reuses the last frame of a stream without a new one, see Encode
+    bool bVppCompDirty = false;
 
     bool TCBRCFileMode;
 };
@@ -399,6 +456,8 @@ struct __sInputParams {
 struct sInputParams : public __sInputParams {
     sInputParams();
     msdk_string DumpLogFileName;
+    // sidecar with the frame index of the input for -segments
+    msdk_string IndexFile;
 
     std::vector<mfxExtEncoderROI> m_ROIData;
 
@@ -442,6 +501,7 @@ public:
         mfxU16 SurfaceWidth  = 0; //not aligned
         mfxU16 SurfaceHeight = 0;
         mfxU16 Size          = 20;
+        mfxU32 SharedPoolID  = 0; //pool which surfaces are used by this one, 0 if it owns them
 
         mfxFrameAllocRequest AllocReq{};
         mfxFrameAllocResponse AllocResp{};
@@ -450,9 +510,17 @@ public:
     TargetDescriptor GetDesc(mfxU32 id);
     void PropagateCascadeParameters();
     void CreatePoolList();
+    // chooses cascade stages for the targets in their order: every target scales from the last
+    // stage before it, a stage is chosen if it takes load from the decoder output and the targets
+    // after it need no more than maxScale times downscaling per dimension, no upscaling and the
+    // same FRC and DI output; FRC and DI shared by the targets are done once by the first stage
+    void PlanCascade(double maxScale);
+    // ID of the pool which owns surfaces of the given pool
+    mfxU32 GetSurfacePoolID(mfxU32 poolID);
 
     bool ParFileImported       = false;
     bool CascadeScalerRequired = false;
+    bool SharePools            = false; //pools with the same surfaces are allocated once
 
     std::vector<TargetDescriptor> Targets;
     std::map<mfxU32, PoolDescritpor> Pools; //key is pool ID
@@ -463,6 +531,7 @@ public:
     CascadeScalerConfig()
             : ParFileImported(false),
               CascadeScalerRequired(false),
+              SharePools(false),
               Targets(),
               Pools(),
               InParams(),
@@ -483,6 +552,8 @@ struct ExtendedSurface {
     PreEncAuxBuffer* pAuxCtrl;
     mfxEncodeCtrl* pEncCtrl;
     mfxSyncPoint Syncp;
+    // time the frame was requested from the decoder, start point of pipeline latency
+    msdk_tick SubmitTick;
 };
 
 struct ExtendedBS {
@@ -579,35 +650,154 @@ protected:
     msdk_char bufDir[MAX_PREF_LEN];
 };
 
+// Counters of the pipeline published by the metrics exporter. Pipeline thread updates them and
+// supervisor thread reads, so all of them are relaxed atomics.
+struct PipelineCounters {
+    PipelineCounters()
+            : OutputFrames(0),
+              OutputBytes(0),
+              FramesInFlight(0),
+              DecBusy(0),
+              VppBusy(0),
+              EncBusy(0),
+              SyncWaitUs(0),
+              FreeDecSurfaces(-1),
+              FreeEncSurfaces(-1),
+              AsyncDepth(0) {}
+
+    std::atomic<mfxU64> OutputFrames;
+    std::atomic<mfxU64> OutputBytes;
+    // frames submitted to the encoder and not written yet
+    std::atomic<mfxU64> FramesInFlight;
+    // MFX_WRN_DEVICE_BUSY retries of each component
+    std::atomic<mfxU64> DecBusy;
+    std::atomic<mfxU64> VppBusy;
+    std::atomic<mfxU64> EncBusy;
+    // time spent waiting for encoded frames
+    std::atomic<mfxU64> SyncWaitUs;
+    // free surfaces seen by the last search in the pool, -1 until the pool is used
+    std::atomic<mfxI64> FreeDecSurfaces;
+    std::atomic<mfxI64> FreeEncSurfaces;
+    // bitstreams kept in flight before the oldest one is synced
+    std::atomic<mfxU64> AsyncDepth;
+
+    DISALLOW_COPY_AND_ASSIGN(PipelineCounters);
+};
+
+// Chooses number of encoded frames kept in flight between Min and Max, where Max is AsyncDepth
+// the components and surface pools are initialized with. Decision is made once per WINDOW
+// output frames: device busy retries mean GPU queue is already full, so depth shrinks; waiting
+// for the oldest frame means GPU is behind and can overlap more work, so depth grows; frames
+// ready by the time they are synced mean depth only adds latency, so it shrinks. Batch sessions
+// settle at high depth while frame rate limited live sessions settle low.
+class CAsyncDepthController {
+public:
+    CAsyncDepthController()
+            : m_Min(1),
+              m_Max(1),
+              m_Depth(1),
+              m_Frames(0),
+              m_WaitUs(0),
+              m_BusyRetries(0),
+              m_LastBusyRetries(0) {}
+
+    void Init(mfxU16 minDepth, mfxU16 maxDepth) {
+        m_Max             = std::max<mfxU16>(maxDepth, 1);
+        m_Min             = std::min<mfxU16>(std::max<mfxU16>(minDepth, 1), m_Max);
+        m_Depth           = m_Max;
+        m_Frames          = 0;
+        m_WaitUs          = 0;
+        m_BusyRetries     = 0;
+        m_LastBusyRetries = 0;
+    }
+
+    bool IsAdaptive() const {
+        return m_Min != m_Max;
+    }
+
+    mfxU16 GetDepth() const {
+        return m_Depth;
+    }
+
+    // waitUs is time the oldest frame was synced for, busyRetries is the running total of device
+    // busy retries of all components
+    void Update(mfxU64 waitUs, mfxU64 busyRetries) {
+        if (!IsAdaptive())
+            return;
+
+        m_WaitUs += waitUs;
+        m_BusyRetries += busyRetries - m_LastBusyRetries;
+        m_LastBusyRetries = busyRetries;
+        if (++m_Frames < WINDOW)
+            return;
+
+        mfxU64 avgWaitUs = m_WaitUs / m_Frames;
+        if (m_BusyRetries || avgWaitUs <= SHRINK_WAIT_US)
+            m_Depth = std::max<mfxU16>(m_Depth - 1, m_Min);
+        else if (avgWaitUs >= GROW_WAIT_US)
+            m_Depth = std::min<mfxU16>(m_Depth + 1, m_Max);
+
+        m_Frames      = 0;
+        m_WaitUs      = 0;
+        m_BusyRetries = 0;
+    }
+
+private:
+    static const mfxU32 WINDOW = 32;
+    // gap between the thresholds keeps depth from oscillating
+    static const mfxU64 SHRINK_WAIT_US = 100;
+    static const mfxU64 GROW_WAIT_US   = 1000;
+
+    mfxU16 m_Min;
+    mfxU16 m_Max;
+    mfxU16 m_Depth;
+    mfxU32 m_Frames;
+    mfxU64 m_WaitUs;
+    mfxU64 m_BusyRetries;
+    mfxU64 m_LastBusyRetries;
+
+    DISALLOW_COPY_AND_ASSIGN(CAsyncDepthController);
+};
+
+// Output bitstreams of the pipeline. Free bitstreams are kept in a LIFO list, so GetNext and
+// Release don't scan the store and recently used buffers, which are already allocated, are reused
+// first. Store is accessed by the pipeline thread only and needs no locking.
 class ExtendedBSStore {
 public:
-    explicit ExtendedBSStore(mfxU32 size) {
-        m_pExtBS.resize(size);
+    explicit ExtendedBSStore(mfxU32 size)
+            : m_pExtBS(size),
+              m_FreeBS(),
+              m_PeakFrameSize(0),
+              m_bFullSizeRequired(false) {
+        m_FreeBS.reserve(size);
+        ReleaseAll();
     }
     virtual ~ExtendedBSStore() {
+        m_FreeBS.clear();
         m_pExtBS.clear();
     }
     ExtendedBS* GetNext() {
-        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
-            if (m_pExtBS[i].IsFree) {
-                m_pExtBS[i].IsFree = false;
-                return &m_pExtBS[i];
-            }
-        }
-        return NULL;
+        if (m_FreeBS.empty())
+            return NULL;
+        ExtendedBS* pBS = m_FreeBS.back();
+        m_FreeBS.pop_back();
+        pBS->IsFree = false;
+        return pBS;
     }
     void Release(ExtendedBS* pBS) {
-        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
-            if (&m_pExtBS[i] == pBS) {
-                m_pExtBS[i].IsFree = true;
-                return;
-            }
-        }
+        if (!pBS || m_pExtBS.empty() || pBS < &m_pExtBS.front() || pBS > &m_pExtBS.back() ||
+            pBS->IsFree)
+            return;
+        pBS->IsFree = true;
+        m_FreeBS.push_back(pBS);
         return;
     }
     void ReleaseAll() {
-        for (mfxU32 i = 0; i < m_pExtBS.size(); i++) {
-            m_pExtBS[i].IsFree = true;
+        m_FreeBS.clear();
+        // fill in reverse order, so bitstreams are taken from the beginning of the store
+        for (auto it = m_pExtBS.rbegin(); it != m_pExtBS.rend(); ++it) {
+            it->IsFree = true;
+            m_FreeBS.push_back(&*it);
         }
         return;
     }
@@ -619,13 +809,128 @@ public:
         return;
     }
 
+    // Size of encoded frames seen so far, used to size new buffers
+    void ReportFrameSize(mfxU32 size) {
+        m_PeakFrameSize = std::max(m_PeakFrameSize, size);
+    }
+    // Encoder rejected the right-sized buffer: it wants the worst-case free space in the bitstream,
+    // so all following buffers are allocated with the worst-case size
+    void ReportInsufficientBuffer() {
+        m_bFullSizeRequired = true;
+    }
+    // Returns size of a new buffer: twice the peak observed frame or the initial estimate, rounded
+    // up to a power of two size class, but not above the worst-case size reported by the encoder
+    mfxU32 GetBufferSize(mfxU32 estimate, mfxU32 worstCase) const {
+        if (m_bFullSizeRequired || (!estimate && !m_PeakFrameSize))
+            return worstCase;
+
+        mfxU64 size      = std::max<mfxU64>(estimate, 2ull * m_PeakFrameSize);
+        mfxU64 sizeClass = MIN_SIZE_CLASS;
+        while (sizeClass < size)
+            sizeClass <<= 1;
+
+        return (worstCase && sizeClass > worstCase) ? worstCase : (mfxU32)sizeClass;
+    }
+
 protected:
+    static const mfxU32 MIN_SIZE_CLASS = 64 * 1024;
+
     std::vector<ExtendedBS> m_pExtBS;
+    std::vector<ExtendedBS*> m_FreeBS;
+    mfxU32 m_PeakFrameSize;
+    bool m_bFullSizeRequired;
 
 private:
     DISALLOW_COPY_AND_ASSIGN(ExtendedBSStore);
 };
 
+// Wakes up threads waiting for a free surface instead of sleep-polling the pools.
+// Signaled when the sample drops the last lock of a surface and after sync operations,
+// which release locks held by the library. Other unlocks done by the library are not
+// reported, so waiters re-scan pools at least once per wait timeout.
+class SurfaceUnlockNotifier {
+public:
+    static SurfaceUnlockNotifier& Instance() {
+        static SurfaceUnlockNotifier notifier;
+        return notifier;
+    }
+
+    // Generation must be taken before scanning the pools, so unlock happened during
+    // the scan is not missed by the following Wait
+    mfxU64 GetGeneration() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_generation;
+    }
+
+    void Notify() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_generation++;
+        }
+        m_cv.notify_all();
+    }
+
+    void Wait(mfxU64 generation, mfxU32 msec) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait_for(lock, std::chrono::milliseconds(msec), [&] {
+            return m_generation != generation;
+        });
+    }
+
+private:
+    SurfaceUnlockNotifier() : m_mutex(), m_cv(), m_generation(0) {}
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    mfxU64 m_generation;
+
+    DISALLOW_COPY_AND_ASSIGN(SurfaceUnlockNotifier);
+};
+
+// Lookahead shared by the -la_share renditions of 1_to_N ladder. The rendition with lookahead
+// BRC (leader) publishes QP of every encoded frame, the other renditions (followers) encode
+// in CQP mode with the leader's QP of the same frame plus own offset tracking the target bitrate.
+// Frames are identified by display order of the encoder input, so all renditions must encode
+// the same frames.
+class LaQPExchange {
+public:
+    // QP of the frame isn't reported by the leader's encoder
+    enum { NoQP = 0xFFFF };
+
+    // lag is number of frames the leader holds before output of the frame
+    explicit LaQPExchange(mfxU32 lag);
+
+    // the leader runs bitrate driven lookahead BRC
+    static bool IsLeader(const sInputParams& params) {
+        return params.nRateControlMethod == MFX_RATECONTROL_LA ||
+               params.nRateControlMethod == MFX_RATECONTROL_LA_HRD;
+    }
+
+    mfxU32 GetLag() const {
+        return m_Lag;
+    }
+
+    // bits per pixel of the leader, the initial QP offset of followers is derived from it
+    void SetLeaderRate(mfxF64 bitsPerPixel);
+    mfxF64 GetLeaderRate();
+
+    void Publish(mfxU32 frameOrder, mfxU16 qp);
+    // the leader doesn't publish more frames, waiting followers are released
+    void Finish();
+    // waits until QP of the frame is published, NoQP if the leader is finished without it
+    mfxU16 Wait(mfxU32 frameOrder);
+
+private:
+    const mfxU32 m_Lag;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<mfxU16> m_QP; // indexed by frame order
+    mfxF64 m_LeaderRate;
+    bool m_bFinished;
+
+    DISALLOW_COPY_AND_ASSIGN(LaQPExchange);
+};
+
 class CTranscodingPipeline;
 // thread safety buffer heterogeneous pipeline
 // only for join sessions
@@ -643,21 +948,21 @@ public:
     SafetySurfaceBuffer(SafetySurfaceBuffer* pNext);
     virtual ~SafetySurfaceBuffer();
 
-    mfxU32 GetLength();
-    mfxStatus WaitForSurfaceRelease(mfxU32 msec);
-    mfxStatus WaitForSurfaceInsertion(mfxU32 msec);
-    void AddSurface(ExtendedSurface Surf);
-    mfxStatus GetSurface(ExtendedSurface& Surf);
-    mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf);
-    mfxStatus ReleaseSurfaceAll();
-    void CancelBuffering();
+    virtual mfxU32 GetLength();
+    virtual mfxStatus WaitForSurfaceRelease(mfxU32 msec);
+    virtual mfxStatus WaitForSurfaceInsertion(mfxU32 msec);
+    virtual void AddSurface(ExtendedSurface Surf);
+    virtual mfxStatus GetSurface(ExtendedSurface& Surf);
+    virtual mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf);
+    virtual mfxStatus ReleaseSurfaceAll();
+    virtual void CancelBuffering();
 
     SafetySurfaceBuffer* m_pNext;
 
 protected:
     std::mutex m_mutex;
     std::list<SurfaceDescriptor> m_SList;
-    bool m_IsBufferingAllowed;
+    std::atomic<bool> m_IsBufferingAllowed;
     MSDKEvent* pRelEvent;
     MSDKEvent* pInsEvent;
 
@@ -665,6 +970,37 @@ private:
     DISALLOW_COPY_AND_ASSIGN(SafetySurfaceBuffer);
 };
 
+// bounded lock-free variant of SafetySurfaceBuffer with preallocated descriptors
+// every joined buffer has exactly one producer and one consumer thread:
+// 1_to_N sink or N_to_1 source owns its buffer, so head is moved by consumer only, tail by producer only
+// producer still may peek the front surface (GetSurface) to sync it
+class SafetySurfaceRing : public SafetySurfaceBuffer {
+public:
+    SafetySurfaceRing(SafetySurfaceBuffer* pNext, mfxU32 size);
+    virtual ~SafetySurfaceRing();
+
+    virtual mfxU32 GetLength() override;
+    virtual mfxStatus WaitForSurfaceRelease(mfxU32 msec) override;
+    virtual mfxStatus WaitForSurfaceInsertion(mfxU32 msec) override;
+    virtual void AddSurface(ExtendedSurface Surf) override;
+    virtual mfxStatus GetSurface(ExtendedSurface& Surf) override;
+    virtual mfxStatus ReleaseSurface(mfxFrameSurface1* pSurf) override;
+    virtual mfxStatus ReleaseSurfaceAll() override;
+
+protected:
+    std::vector<SurfaceDescriptor> m_Ring;
+    mfxU32 m_Mask;
+    // free running counters, slot index is counter & m_Mask
+    alignas(64) std::atomic<mfxU32> m_Head;
+    alignas(64) std::atomic<mfxU32> m_Tail;
+    // events are signaled only if other side waits for them
+    std::atomic<bool> m_IsProducerWaiting;
+    std::atomic<bool> m_IsConsumerWaiting;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(SafetySurfaceRing);
+};
+
 class FileBitstreamProcessor {
 public:
     FileBitstreamProcessor();
@@ -677,6 +1013,8 @@ public:
     virtual mfxStatus ProcessOutputBitstream(mfxBitstreamWrapper* pBitstream);
     virtual mfxStatus ResetInput();
     virtual mfxStatus ResetOutput();
+    // writes the rest of the output and closes the file, nothing is written after it
+    virtual void CloseOutput();
     virtual bool IsNulOutput();
 
 protected:
@@ -716,6 +1054,13 @@ public:
     virtual mfxStatus Reset(VPLImplementationLoader* mfxLoader);
     virtual mfxStatus Join(MFXVideoSession* pChildSession);
     virtual mfxStatus Run();
+    // Step-wise transcoding for the task pool: BeginStepRun(), then RunStep() while it returns
+    // MFX_ERR_NONE. Run() status is returned at the end.
+    virtual bool IsStepRunSupported();
+    virtual void BeginStepRun();
+    virtual mfxStatus RunStep();
+    // next step would wait for the encoder
+    virtual bool IsStepBlocked();
     virtual mfxStatus FlushLastFrames() {
         return MFX_ERR_NONE;
     }
@@ -747,8 +1092,28 @@ public:
     size_t GetRobustFlag();
     eAPIVersion GetVersionOfSessionInitAPI();
 
+    // decode request to encoded frame latency, always collected
+    CLatencyHistogram& GetLatencyHistogram() {
+        return m_LatencyHistogram;
+    }
+    // quality of the encoded output, collected with -quality
+    CQualityMeter::Summary GetQualitySummary() const {
+        return m_QualityMeter.GetSummary();
+    }
+
+    // free surfaces are counted only on request, as it takes a pass over the pool
+    void EnableCounters() {
+        m_bCountFreeSurfaces = true;
+    }
+    const PipelineCounters& GetCounters() const {
+        return m_Counters;
+    }
+
     msdk_string GetSessionText() {
         msdk_stringstream ss;
+        // session is released by Close()
+        if (!m_pmfxSession)
+            return msdk_string();
         ss << m_pmfxSession->operator mfxSession();
 
         return ss.str();
@@ -767,6 +1132,18 @@ public:
     void SetSyncOpTimeout(mfxU32 syncOpTimeout = MSDK_WAIT_INTERVAL) {
         m_nSyncOpTimeout = syncOpTimeout;
     };
+    // the pool of the encoder surfaces, must be set before Init with the allocator of the service
+    void SetSurfacePoolService(CSurfacePoolService* pSurfacePoolService) {
+        m_pSurfacePoolService = pSurfacePoolService;
+    };
+    // lookahead of -la_share ladder, must be set before Init
+    void SetLaQPExchange(LaQPExchange* pLaQPExchange) {
+        m_pLaQPExchange = pLaQPExchange;
+    };
+    // frame rate kept downstream of the -dec_skip decoder, 0 disables skipping
+    void SetDecodeSkipFramerate(mfxF64 framerate) {
+        m_DecSkipOutFramerate = framerate;
+    };
 
     mfxU16 GetAdapterType() const {
         return m_adapterType;
@@ -802,6 +1179,9 @@ protected:
     virtual mfxStatus Decode();
     virtual mfxStatus Encode();
     virtual mfxStatus Transcode();
+    virtual void BeginTranscode();
+    virtual mfxStatus TranscodeStep();
+    virtual mfxStatus CompleteTranscode(mfxStatus sts);
     virtual mfxStatus DecodeOneFrame(ExtendedSurface* pExtSurface);
     virtual mfxStatus DecodeLastFrame(ExtendedSurface* pExtSurface);
     virtual mfxStatus VPPOneFrame(ExtendedSurface* pSurfaceIn,
@@ -838,6 +1218,12 @@ protected:
 
     mfxFrameSurface1* GetFreeSurface(bool isDec, mfxU64 timeout);
     mfxFrameSurface1* GetFreeSurfaceForCS(bool isDec, mfxU64 timeout, mfxU32 ID);
+    mfxFrameSurface1* AcquireFreeSurface(SurfPointersArray& workArray,
+                                         mfxU32& nextFree,
+                                         SMTTracer::ThreadType thType,
+                                         mfxU32 thID,
+                                         mfxU64 timeout);
+    mfxFrameSurface1* AcquireSharedSurface(mfxU64 timeout);
     mfxU32 GetFreeSurfacesCount(bool isDec);
     PreEncAuxBuffer* GetFreePreEncAuxBuffer();
     void SetEncCtrlRT(ExtendedSurface& extSurface, bool bInsertIDR);
@@ -849,6 +1235,7 @@ protected:
     mfxStatus InitPluginMfxParams(sInputParams* pInParams);
     virtual mfxU32 FileFourCC2EncFourCC(mfxU32 fcc);
     void FillFrameInfoForEncoding(mfxFrameInfo& info, sInputParams* pInParams);
+    void PrintHyperModeInfo(mfxHyperMode requested);
 
     mfxStatus AllocAndInitVppDoNotUse(MfxVideoParamsWrapper& par, sInputParams* pInParams);
     mfxStatus AllocMVCSeqDesc();
@@ -857,9 +1244,12 @@ protected:
     void FreeMVCSeqDesc();
 
     mfxStatus AllocateSufficientBuffer(mfxBitstreamWrapper* pBS);
+    mfxStatus SyncBS(ExtendedBS* pBitstreamEx, bool bPoll);
     mfxStatus PutBS();
 
     mfxStatus DumpSurface2File(mfxFrameSurface1* pSurface);
+    mfxStatus AddQualitySource(mfxFrameSurface1* pSurface);
+    mfxStatus InitQualityMeter(sInputParams* pParams, VPLImplementationLoader* mfxLoader);
     mfxStatus Surface2BS(ExtendedSurface* pSurf, mfxBitstreamWrapper* pBS, mfxU32 fourCC);
     mfxStatus NV12toBS(mfxFrameSurface1* pSurface, mfxBitstreamWrapper* pBS);
     mfxStatus I420toBS(mfxFrameSurface1* pSurface, mfxBitstreamWrapper* pBS);
@@ -877,7 +1267,10 @@ protected:
     void SetNumFramesForReset(mfxU32 nFrames);
 
     void HandlePossibleGpuHang(mfxStatus& sts);
+    // re-initializes components on the same session, surface pools and device are kept
+    mfxStatus ResetComponents();
 
+    static mfxHandleType GetHandleType(mfxIMPL impl);
     mfxStatus SetAllocatorAndHandleIfRequired();
     mfxStatus LoadGenericPlugin();
 
@@ -917,20 +1310,43 @@ protected:
 
     SurfPointersArray m_pSurfaceDecPool;
     SurfPointersArray m_pSurfaceEncPool;
+    // pool positions to start the next free surface search from
+    mfxU32 m_DecPoolNextFree;
+    mfxU32 m_EncPoolNextFree;
 
     mfxFrameAllocRequest m_DecOutAllocReques;
     mfxFrameAllocRequest m_VPPOutAllocReques;
 
     std::map<mfxU32, SurfPointersArray> m_CSSurfacePools;
+    std::map<mfxU32, mfxU32> m_CSPoolNextFree;
 
     mfxU16 m_EncSurfaceType; // actual type of encoder surface pool
     mfxU16 m_DecSurfaceType; // actual type of decoder surface pool
 
+    // encoder surfaces are taken from the service instead of m_pSurfaceEncPool if registered
+    CSurfacePoolService* m_pSurfacePoolService;
+    mfxU32 m_SharedPoolConsumer;
+    bool m_bSharedEncPool;
+
     PreEncAuxArray m_pPreEncAuxPool;
 
     // transcoding pipeline specific
     BSList m_BSPool;
 
+    // state of the Transcode() cycle kept between the steps
+    struct TranscodeState {
+        ExtendedSurface DecExtSurface = {};
+        ExtendedSurface VppExtSurface = {};
+        bool bNeedDecodedFrames       = true; // indicates if we need to decode frames
+        bool bEndOfFile               = false;
+        bool bLastCycle               = false;
+        bool shouldReadNextFrame      = true;
+        time_t start                  = 0;
+    };
+    TranscodeState m_TranscodeState;
+    // pipeline is run by the task pool
+    bool m_bStepRun;
+
     mfxInitParamlWrap m_initPar;
 
     volatile bool m_bForceStop;
@@ -970,6 +1386,7 @@ protected:
 
     mfxU32 m_nID;
     mfxU16 m_AsyncDepth;
+    CAsyncDepthController m_AsyncDepthController;
     mfxU32 m_nProcessedFramesNum;
 
     bool m_bIsJoinSession;
@@ -1001,6 +1418,8 @@ protected:
     bool isHEVCSW;
 
     bool m_bInsertIDR;
+    // components are re-initialized by the next transcode step after a GPU hang
+    bool m_bResetComponents;
 
     bool m_rawInput;
     bool m_shouldUseShifted10BitEnc;
@@ -1022,6 +1441,20 @@ protected:
     CIOStat inputStatistics;
     CIOStat outputStatistics;
 
+    // submit ticks of frames passed to the encoder, in order of their submission
+    std::deque<msdk_tick> m_LatencyTicks;
+    CLatencyHistogram m_LatencyHistogram;
+    FILE* m_pLatencyLog;
+#ifdef ONEVPL_EXPERIMENTAL
+    CEncodeStatsWriter m_EncodeStats; // kept open over Reset like the latency log
+#endif
+    // decodes the output again, the meter is closed before its session
+    std::unique_ptr<MainVideoSession> m_pQualitySession;
+    CQualityMeter m_QualityMeter;
+
+    PipelineCounters m_Counters;
+    bool m_bCountFreeSurfaces;
+
     bool shouldUseGreedyFormula;
 
     // ROI data
@@ -1049,6 +1482,35 @@ protected:
 
     void FillMBQPBuffer(mfxExtMBQP& qpMap, mfxU16 pictStruct);
 
+    // -la_share: the leader publishes QP of output frames, followers take it for input ones
+    LaQPExchange* m_pLaQPExchange = nullptr;
+    bool m_bLaLeader              = false;
+    mfxF64 m_LaTargetBitsPerFrame = 0;
+    mfxF64 m_LaQPOffset           = 0;
+    bool m_bLaQPOffsetSet         = false;
+    mfxU16 m_LaLastQP             = 0;
+    mfxU64 m_LaWindowBits         = 0;
+    mfxU32 m_LaWindowFrames       = 0;
+    mfxU32 m_LaWindowSize         = 0;
+
+    void InitLaShare(sInputParams* pInParams);
+    void SetLaSharedQP(mfxEncodeCtrl& ctrl);
+    void UpdateLaShare(mfxBitstreamWrapper& bs);
+
+    // -dec_skip: the decoder skips as many frames as FRC drops, checked once per second of frames
+    mfxF64 m_DecSkipOutFramerate = 0;
+    mfxF64 m_DecSkipRatio        = 0;
+    mfxU32 m_DecSkipWindowSize   = 0;
+    mfxU32 m_DecSkipWindowFrames = 0;
+    mfxU32 m_DecSkipLevel        = 0;
+    mfxU32 m_DecSkipMaxLevel     = 0;
+    mfxDecodeStat m_DecSkipStat  = {};
+
+    // -vpp_comp_dirty: composition doesn't wait for streams without new frames
+    bool m_bVppCompDirty = false;
+
+    void UpdateDecodeSkip();
+
     TCBRCTestFile::Reader m_TCBRCFileReader;
     bool m_bTCBRCFileMode;
     mfxStatus ConfigTCBRCTest(mfxFrameSurface1* pSurf);
@@ -1079,6 +1541,83 @@ private:
     DISALLOW_COPY_AND_ASSIGN(CTranscodingPipeline);
 };
 
+struct SupervisorEvent {
+    enum Type {
+        // transcoding routine of the session returned
+        SESSION_COMPLETED,
+        // line received from the control channel
+        CONTROL_COMMAND,
+        // control channel reached end of input
+        CONTROL_CLOSED,
+        // no events arrived before the deadline
+        TIMEOUT
+    };
+
+    SupervisorEvent(Type type_, size_t id_ = 0, const msdk_string& command_ = msdk_string())
+            : type(type_),
+              id(id_),
+              command(command_) {}
+
+    Type type;
+    size_t id;
+    msdk_string command;
+};
+
+// Events handled by the launcher supervisor loop, in order of their arrival
+class SupervisorEventQueue {
+public:
+    SupervisorEventQueue() : m_mutex(), m_cv(), m_Events() {}
+
+    void Push(const SupervisorEvent& event) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_Events.push_back(event);
+        }
+        m_cv.notify_one();
+    }
+
+    // blocks until some event arrives
+    SupervisorEvent Pop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] {
+            return !m_Events.empty();
+        });
+        SupervisorEvent event = m_Events.front();
+        m_Events.pop_front();
+        return event;
+    }
+
+    // returns TIMEOUT event if nothing arrived until the deadline
+    SupervisorEvent Pop(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_cv.wait_until(lock, deadline, [this] {
+                return !m_Events.empty();
+            }))
+            return SupervisorEvent(SupervisorEvent::TIMEOUT);
+        SupervisorEvent event = m_Events.front();
+        m_Events.pop_front();
+        return event;
+    }
+
+    // drops completions left from the previous run, control commands are kept
+    void ClearCompletions() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_Events.erase(std::remove_if(m_Events.begin(),
+                                      m_Events.end(),
+                                      [](const SupervisorEvent& event) {
+                                          return event.type == SupervisorEvent::SESSION_COMPLETED;
+                                      }),
+                       m_Events.end());
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<SupervisorEvent> m_Events;
+
+    DISALLOW_COPY_AND_ASSIGN(SupervisorEventQueue);
+};
+
 struct ThreadTranscodeContext {
     // Pointer to the session's pipeline
     std::unique_ptr<CTranscodingPipeline> pPipeline;
@@ -1100,11 +1639,20 @@ struct ThreadTranscodeContext {
     // Thread handle
     std::future<void> handle;
 
+    // CPUs and NUMA node to run the session thread on
+    std::vector<mfxU32> cpuAffinity;
+    mfxI32 numaNode = NUMA_NODE_OFF;
+
     void TranscodeRoutine() {
         using namespace std::chrono;
         MSDK_CHECK_POINTER_NO_RET(pPipeline);
         transcodingSts = MFX_ERR_NONE;
 
+        // bitstreams reallocated by the thread are also placed on the node
+        std::ignore = msdk_thread_set_affinity(cpuAffinity);
+        if (numaNode >= 0)
+            std::ignore = msdk_thread_set_numa_node(numaNode);
+
         auto start_time = system_clock::now();
         while (MFX_ERR_NONE == transcodingSts) {
             transcodingSts = pPipeline->Run();
@@ -1114,6 +1662,70 @@ struct ThreadTranscodeContext {
         MSDK_IGNORE_MFX_STS(transcodingSts, MFX_WRN_VALUE_NOT_CHANGED);
         numTransFrames = pPipeline->GetProcessFrames();
     }
+
+    // Task pool alternative of TranscodeRoutine
+    std::chrono::system_clock::time_point taskStartTime;
+
+    void BeginTranscodeTask() {
+        transcodingSts = MFX_ERR_NONE;
+        taskStartTime  = std::chrono::system_clock::now();
+        pPipeline->BeginStepRun();
+    }
+
+    // returns false once the session is completed
+    bool TranscodeStep() {
+        using namespace std::chrono;
+        transcodingSts = pPipeline->RunStep();
+        if (MFX_ERR_NONE == transcodingSts)
+            return true;
+
+        working_time = duration_cast<duration<mfxF64>>(system_clock::now() - taskStartTime).count();
+
+        MSDK_IGNORE_MFX_STS(transcodingSts, MFX_WRN_VALUE_NOT_CHANGED);
+        numTransFrames = pPipeline->GetProcessFrames();
+        return false;
+    }
+};
+
+// Fixed number of threads running steps of many sessions. Each worker serves its own queue
+// round-robin and steals from the others when it runs out of tasks. Steps which would wait
+// for the encoder are postponed, so threads are only blocked when all their tasks wait.
+class TranscodeTaskPool {
+public:
+    typedef std::function<void(std::exception_ptr)> CompletionCallback;
+
+    explicit TranscodeTaskPool(mfxU32 numThreads);
+    ~TranscodeTaskPool();
+
+    // callback is invoked by the worker once the session is completed
+    void Submit(ThreadTranscodeContext* pContext, CompletionCallback onComplete);
+
+private:
+    struct Task {
+        ThreadTranscodeContext* pContext = nullptr;
+        CompletionCallback onComplete;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    bool PopTask(mfxU32 idxWorker, Task& task);
+    // returns number of tasks in the queue of the worker
+    size_t PushTask(mfxU32 idxWorker, Task&& task);
+    void WorkerRoutine(mfxU32 idxWorker);
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::atomic<mfxU32> m_NextWorker;
+    // number of queued tasks, idle workers wait for it to become non-zero
+    size_t m_NumQueued;
+    bool m_bStop;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+
+    DISALLOW_COPY_AND_ASSIGN(TranscodeTaskPool);
 };
 } // namespace TranscodingSample
 
@@ -12,11 +12,19 @@
     #include "mfxadapter.h"
 #endif
 
+#include "bitstream_index.h"
+#include "engine_utilization.h"
+#include "demux_reader.h"
+#include "mux_writer.h"
 #include "pipeline_transcode.h"
 #include "sample_utils.h"
 #include "transcode_utils.h"
 #include "vpl_implementation_loader.h"
 
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include "d3d11_allocator.h"
 #include "d3d11_device.h"
@@ -55,12 +63,56 @@ protected:
 #endif
     mfxStatus CheckAndFixAdapterDependency(mfxU32 idxSession,
                                            CTranscodingPipeline* pParentPipeline);
+    virtual void ShareDuplicateDecodes();
+    // replaces each -segments session with the sessions of its segments
+    virtual mfxStatus SplitSegmentedSessions();
+    // concatenates the outputs of the segments once all of them are transcoded
+    virtual mfxStatus JoinSegmentOutputs();
+    // assigns adapters to sessions without explicit one, requires loader with enumerated adapters
+    virtual void ShardSessionsAcrossAdapters();
+    // joins compatible encode sessions into multi-frame encode groups for -mfe_auto
+    virtual void GroupMFESessions();
+    // places composed streams without explicit destination into cells of -vpp_comp_grid
+    virtual mfxStatus LayOutCompositionGrid();
     virtual mfxStatus VerifyCrossSessionsOptions();
+    // checks -la_share renditions and creates their lookahead exchange
+    virtual mfxStatus CreateLaQPExchange();
+    // frame rate the -dec_skip sink has to keep for its sources, 0 if they need all frames
+    mfxF64 GetDecodeSkipFramerate() const;
+    // runs Init of the independent session, up to -init_threads ones at once
+    mfxStatus SubmitPipelineInit(std::function<mfxStatus()> init);
+    // waits for the submitted Init calls, returns the first error
+    mfxStatus WaitPipelineInits();
     virtual mfxStatus CreateSafetyBuffers();
+    virtual SafetySurfaceBuffer* CreateSafetyBuffer(const sInputParams& params,
+                                                    SafetySurfaceBuffer* pNext);
+    virtual void ResolveSessionPlacement(mfxU32 idxSession);
+    void SetThreadPlacement(const sInputParams* pParams);
+    virtual mfxStatus InitBitstreamProcessor(FileBitstreamProcessor* pProcessor,
+                                             const sInputParams& params);
     CascadeScalerConfig& CreateCascadeScalerConfig();
+    void RunTranscodeRoutine(size_t idxSession);
     virtual void DoTranscoding();
     virtual void DoRobustTranscoding();
 
+    // runtime control of the sessions
+    void StartControlChannel();
+    // prints latency percentiles of sessions collected since the previous call or in total
+    virtual void PrintLatencyStatistics(bool bTotal);
+    // replaces metrics file with the current counters of sessions
+    virtual void WriteMetrics();
+    virtual void ProcessControlCommand(const msdk_string& command);
+    virtual mfxStatus AddSession(const msdk_string& line);
+    virtual mfxStatus CreateAddedSession(mfxU32 idxSession);
+    // allocator of the shared surface pool, created by the first session using it
+    mfxStatus GetSharedPoolAllocator(const sInputParams& params,
+                                     mfxAllocatorParams* pAllocParams,
+                                     GeneralAllocator** ppAllocator);
+    virtual void ReleaseAddedSession(size_t idxSession);
+    // gives the session device and allocator parameters of the device created for its adapter
+    bool ShareAdapterDevice(mfxU32 adapterNum, bool bSingleTexture);
+
+
     virtual void Close();
 
     // command line parser
@@ -69,23 +121,62 @@ protected:
     std::vector<std::unique_ptr<ThreadTranscodeContext>> m_pThreadContextArray;
     // allocator for each session
     std::vector<std::unique_ptr<GeneralAllocator>> m_pAllocArray;
+    // allocator and encoder surfaces of the -shared_pool sessions, they run on one device
+    std::unique_ptr<GeneralAllocator> m_pSharedPoolAllocator;
+    std::unique_ptr<CSurfacePoolService> m_pSurfacePoolService;
+    mfxAllocatorParams* m_pSharedPoolAllocParams;
     // input parameters for each session
     std::vector<sInputParams> m_InputParamsArray;
     // safety buffers
     // needed for heterogeneous pipeline
     std::vector<std::unique_ptr<SafetySurfaceBuffer>> m_pBufferArray;
+    // lookahead shared by -la_share renditions
+    std::unique_ptr<LaQPExchange> m_pLaQPExchange;
+    // Init of the sessions running concurrently
+    std::deque<std::future<mfxStatus>> m_InitTasks;
 
     std::vector<std::unique_ptr<FileBitstreamProcessor>> m_pExtBSProcArray;
     std::vector<std::shared_ptr<mfxAllocatorParams>> m_pAllocParams;
+    std::vector<mfxHDL> m_hdls;
     std::vector<std::unique_ptr<CHWDevice>> m_hwdevs;
+    // index of m_hdls with the device created for adapter (and d3d11 single texture mode)
+    std::map<std::pair<mfxU32, bool>, size_t> m_AdapterDevices;
     msdk_tick m_StartTime;
     // need to work with HW pipeline
     mfxHandleType m_eDevType;
     mfxAccelerationMode m_accelerationMode;
     std::unique_ptr<VPLImplementationLoader> m_pLoader;
+    // affinity to restore after sessions initialization
+    std::vector<mfxU32> m_MainThreadAffinity;
+    // session completions and control commands, shared with the detached control thread
+    std::shared_ptr<SupervisorEventQueue> m_pEventQueue;
+    // control channel accepts commands
+    bool m_bControlOpen;
+    // sessions of the par file, the following ones are added at runtime
+    mfxU32 m_nParSessions;
+    // runs sessions instead of dedicated threads if enabled
+    std::unique_ptr<TranscodeTaskPool> m_pTaskPool;
+    // output frames and bytes of sessions at the previous metrics update, for fps and bitrate
+    std::vector<std::pair<mfxU64, mfxU64>> m_MetricsLast;
+    std::chrono::steady_clock::time_point m_MetricsTime;
+    CEngineUtilizationSampler m_EngineSampler;
 
     std::vector<sVppCompDstRect> m_VppDstRects;
 
+    struct sSegmentedOutput {
+        msdk_string DstFile;
+        // outputs of the sessions FirstSession, FirstSession + 1, ...
+        std::vector<msdk_string> SegmentFiles;
+        // input frames of the segments, the outputs are checked to have them all
+        std::vector<mfxU32> SegmentFrames;
+        mfxU32 FirstSession;
+        // frame rate conversion changes the number of the output frames
+        bool bFrameRateConversion;
+    };
+    std::vector<sSegmentedOutput> m_SegmentedOutputs;
+    // segments are spread across the adapters
+    bool m_bSegmentedSessions;
+
     CascadeScalerConfig m_CSConfig;
     SMTTracer m_Tracer;
 
@@ -8,11 +8,15 @@
 #define __SMT_TRACER_H__
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "vpl/mfxdefs.h"
@@ -35,7 +39,7 @@ public:
         mfxU32 EvID; //unique event ID
         mfxU64 InID; //unique dependency ID, e.g. surface pointer
         mfxU64 OutID;
-        mfxU64 TS; //time stamp
+        mfxU64 TS; //time stamp in ns
     };
     using EventIt = std::vector<Event>::iterator;
 
@@ -58,7 +62,24 @@ public:
                          const EventName name,
                          const mfxU64 counter);
 
+    bool IsEnabled() const {
+        return Enabled;
+    }
+
 private:
+    //events of one thread, written by this thread and read by the drainer without locks
+    class EventRing {
+    public:
+        explicit EventRing(size_t size) : Events(size), Head(0), Tail(0) {}
+        bool Push(const Event& ev);
+        void Drain(std::vector<Event>& out);
+
+    private:
+        std::vector<Event> Events;
+        std::atomic<size_t> Head;
+        std::atomic<size_t> Tail;
+    };
+
     //runtime functions
     void AddEvent(const EventType evType,
                   const ThreadType thType,
@@ -67,9 +88,14 @@ private:
                   const void* inID,
                   const void* outID);
     mfxU64 GetCurrentTS();
+    EventRing* GetThreadRing();
+    void DrainerRoutine();
+    void DrainEvents();
 
     //log generation functions
-    void SaveTrace(mfxU32 FileID);
+    void OpenTrace(mfxU32 FileID);
+    void SaveTrace();
+    void IndexEvents();
 
     void AddFlowEvents();
     void AddFlowEvent(const Event a, const Event b);
@@ -101,12 +127,25 @@ private:
     void WriteEvID(std::ofstream& trace_file, const Event ev);
     void WriteComma(std::ofstream& trace_file);
 
-    const static mfxU32 TraceBufferSizeInMBytes = 7;
+    const static size_t RingSizeInEvents = 32 * 1024;
+    const static mfxU32 DrainPeriodInMs  = 20;
+    const static size_t NoMatch          = static_cast<size_t>(-1);
 
     bool Enabled = false;
     mfxU32 EvID  = 0;
     std::vector<Event> Log;
     std::vector<Event> AddonLog;
+    //for end of duration event - index of its beginning, for beginning - index of the end of
+    //previous event in dependency chain
+    std::vector<size_t> Match;
+    std::vector<std::unique_ptr<EventRing>> Rings;
+    std::mutex RingsMutex;
+    std::atomic<mfxU64> NumOfDropped;
+    std::thread Drainer;
+    std::condition_variable DrainerCV;
+    bool StopDrainer = false;
+    std::ofstream TraceFile;
+    std::string TraceFileName;
     std::map<mfxU32, std::vector<mfxU64>> E2ELatency;
     std::map<mfxU32, std::vector<mfxU64>> EncLatency;
     mfxU32 NumOfErrors = 0;
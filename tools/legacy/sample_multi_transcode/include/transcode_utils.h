@@ -60,6 +60,42 @@ public:
     };
     void PrintParFileName();
     msdk_string GetLine(mfxU32 n);
+    // keeps lines aligned with sessions inserted by the launcher
+    void InsertLine(mfxU32 n, const msdk_string& line);
+    bool IsControlStdinEnabled() {
+        return m_bControlStdin;
+    };
+    mfxU32 GetTaskPoolThreads() {
+        return m_nTaskPoolThreads;
+    };
+    mfxU32 GetInitThreads() {
+        return m_nInitThreads;
+    };
+    mfxU32 GetLatencyStatInterval() {
+        return m_nLatencyStatInterval;
+    };
+    const msdk_string& GetMetricsFile() {
+        return m_MetricsFile;
+    };
+    bool IsEngineUtilizationEnabled() {
+        return m_bEngineUtilization;
+    };
+    bool IsCSPoolSharingEnabled() {
+        return m_bCSPoolSharing;
+    };
+    mfxF64 GetCSAutoMaxScale() {
+        return m_dCSAutoMaxScale;
+    };
+    bool IsMFEAutoEnabled() {
+        return m_bMFEAuto;
+    };
+    bool IsAdapterShardingEnabled() {
+        return m_bAdapterSharding;
+    };
+    // parses session received at runtime, it's appended after sessions of the par file
+    mfxStatus ParseSessionLine(const msdk_string& line,
+                               TranscodingSample::sInputParams& InputParams);
+    void RemoveLastSession();
 
 protected:
     mfxStatus ParseParFile(FILE* file);
@@ -87,6 +123,18 @@ protected:
     bool bRobustFlag;
     bool bSoftRobustFlag;
     bool shouldUseGreedyFormula;
+    std::vector<mfxU32> m_CpuAffinity;
+    mfxI32 m_NumaNode;
+    bool m_bControlStdin;
+    mfxU32 m_nTaskPoolThreads;
+    mfxU32 m_nInitThreads;
+    mfxU32 m_nLatencyStatInterval;
+    msdk_string m_MetricsFile;
+    bool m_bEngineUtilization;
+    bool m_bCSPoolSharing;
+    mfxF64 m_dCSAutoMaxScale;
+    bool m_bMFEAuto;
+    bool m_bAdapterSharding;
     std::vector<msdk_string> m_lines;
 
 private:
@@ -12,6 +12,7 @@
 
 #include <assert.h>
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <memory>
 #include <set>
@@ -102,6 +103,8 @@ sInputParams::sInputParams()
     bPrefferiGfx = false;
     bPrefferdGfx = false;
 #endif
+    isDualMode = false;
+    hyperMode  = MFX_HYPERMODE_OFF;
 
     //Adapter type
     adapterType = mfxMediaAdapterType::MFX_MEDIA_UNKNOWN;
@@ -114,9 +117,10 @@ sInputParams::sInputParams()
     DenoiseLevel     = -1;
     DetailLevel      = -1;
 
-    MFMode       = MFX_MF_DEFAULT;
-    numMFEFrames = 0;
-    mfeTimeout   = 0;
+    MFMode         = MFX_MF_DEFAULT;
+    numMFEFrames   = 0;
+    mfeTimeout     = 0;
+    MFEGroupLeader = -1;
 
     forceSyncAllSession = MFX_CODINGOPTION_UNKNOWN;
 
@@ -146,13 +150,21 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_hwdev4Rendering(NULL),
           m_pSurfaceDecPool(),
           m_pSurfaceEncPool(),
+          m_DecPoolNextFree(0),
+          m_EncPoolNextFree(0),
           m_DecOutAllocReques({ 0 }),
           m_VPPOutAllocReques({ 0 }),
           m_CSSurfacePools(),
+          m_CSPoolNextFree(),
           m_EncSurfaceType(0),
           m_DecSurfaceType(0),
+          m_pSurfacePoolService(NULL),
+          m_SharedPoolConsumer(0),
+          m_bSharedEncPool(false),
           m_pPreEncAuxPool(),
           m_BSPool(),
+          m_TranscodeState(),
+          m_bStepRun(false),
           m_initPar(),
           m_bForceStop(false),
           m_forceSyncAllSession(false),
@@ -199,6 +211,7 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_bSoftGpuHangRecovery(false),
           isHEVCSW(false),
           m_bInsertIDR(false),
+          m_bResetComponents(false),
           m_rawInput(false),
           m_shouldUseShifted10BitEnc(false),
           m_pBSStore(),
@@ -211,6 +224,13 @@ CTranscodingPipeline::CTranscodingPipeline()
           m_nOutputFramesNum(0),
           inputStatistics(),
           outputStatistics(),
+          m_LatencyTicks(),
+          m_LatencyHistogram(),
+          m_pLatencyLog(NULL),
+          m_pQualitySession(),
+          m_QualityMeter(),
+          m_Counters(),
+          m_bCountFreeSurfaces(false),
           shouldUseGreedyFormula(false),
           m_ROIData(),
           m_nSubmittedFramesNum(0),
@@ -247,6 +267,11 @@ CTranscodingPipeline::CTranscodingPipeline()
 
 CTranscodingPipeline::~CTranscodingPipeline() {
     Close();
+    // log is kept open over Reset, which closes and initializes the pipeline again
+    if (m_pLatencyLog)
+        fclose(m_pLatencyLog);
+    m_QualityMeter.Close();
+    m_pQualitySession.reset();
 } //CTranscodingPipeline::CTranscodingPipeline()
 
 mfxStatus CTranscodingPipeline::CheckRequiredAPIVersion(mfxVersion& version,
@@ -521,6 +546,7 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
     mfxStatus sts                 = MFX_ERR_MORE_SURFACE;
     mfxFrameSurface1* pmfxSurface = NULL;
     pExtSurface->pSurface         = NULL;
+    pExtSurface->SubmitTick       = msdk_time_get_tick();
 
     //--- Time measurements
     if (statisticsWindowSize) {
@@ -560,6 +586,7 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                 return sts;
         }
         else if (MFX_WRN_DEVICE_BUSY == sts) {
+            m_Counters.DecBusy.fetch_add(1, std::memory_order_relaxed);
             m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::DEC,
                                               0,
                                               SMTTracer::EventName::BUSY,
@@ -627,10 +654,13 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
                                               SMTTracer::EventName::UNDEF,
                                               nullptr,
                                               nullptr);
-            sts = m_pmfxDEC->DecodeFrameAsync(m_pmfxBS,
-                                              pmfxSurface,
-                                              &pExtSurface->pSurface,
-                                              &pExtSurface->Syncp);
+            {
+                MFX_ITT_TASK("DecodeFrameAsync");
+                sts = m_pmfxDEC->DecodeFrameAsync(m_pmfxBS,
+                                                  pmfxSurface,
+                                                  &pExtSurface->pSurface,
+                                                  &pExtSurface->Syncp);
+            }
             m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::DEC,
                                             0,
                                             SMTTracer::EventName::UNDEF,
@@ -658,19 +688,65 @@ mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface* pExtSurface) {
 
     } //while processing
 
+    if (MFX_ERR_NONE == sts && m_DecSkipOutFramerate > 0)
+        UpdateDecodeSkip();
+
     // HEVC SW requires additional synchronization
     if (MFX_ERR_NONE == sts && isHEVCSW) {
         sts = m_pmfxSession->SyncOperation(pExtSurface->Syncp, GetSyncOpTimeout());
+        SurfaceUnlockNotifier::Instance().Notify();
         HandlePossibleGpuHang(sts);
         MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "Decode: SyncOperation failed");
     }
     return sts;
 
 } // mfxStatus CTranscodingPipeline::DecodeOneFrame(ExtendedSurface *pExtSurface)
+
+void CTranscodingPipeline::UpdateDecodeSkip() {
+    if (!m_DecSkipWindowSize) {
+        const mfxFrameInfo& info = m_mfxDecParams.mfx.FrameInfo;
+        if (!info.FrameRateExtN || !info.FrameRateExtD) {
+            m_DecSkipOutFramerate = 0;
+            return;
+        }
+        mfxF64 decFramerate = (mfxF64)info.FrameRateExtN / info.FrameRateExtD;
+        m_DecSkipRatio      = std::min(m_DecSkipOutFramerate / decFramerate, 1.0);
+        m_DecSkipWindowSize = std::max<mfxU32>((mfxU32)(decFramerate + 0.5), 1);
+        m_DecSkipMaxLevel   = (mfxU32)-1;
+    }
+    if (++m_DecSkipWindowFrames < m_DecSkipWindowSize)
+        return;
+    m_DecSkipWindowFrames = 0;
+
+    mfxDecodeStat stat = {};
+    if (MFX_ERR_NONE != m_pmfxDEC->GetDecodeStat(&stat))
+        return;
+    mfxU32 decoded = stat.NumFrame - m_DecSkipStat.NumFrame;
+    mfxU32 skipped = stat.NumSkippedFrame - m_DecSkipStat.NumSkippedFrame;
+    m_DecSkipStat  = stat;
+    if (!decoded)
+        return;
+
+    // once the decoder skips more than FRC drops, the level below is the last one tried
+    if ((mfxF64)decoded / (decoded + skipped) < m_DecSkipRatio) {
+        if (m_DecSkipLevel && MFX_ERR_NONE == m_pmfxDEC->SetSkipMode(MFX_SKIPMODE_LESS))
+            m_DecSkipLevel--;
+        m_DecSkipMaxLevel = m_DecSkipLevel;
+    }
+    else if (m_DecSkipLevel < m_DecSkipMaxLevel) {
+        // MFX_WRN_VALUE_NOT_CHANGED means the decoder skips all it can
+        if (MFX_ERR_NONE == m_pmfxDEC->SetSkipMode(MFX_SKIPMODE_MORE))
+            m_DecSkipLevel++;
+        else
+            m_DecSkipMaxLevel = m_DecSkipLevel;
+    }
+} // void CTranscodingPipeline::UpdateDecodeSkip()
+
 mfxStatus CTranscodingPipeline::DecodeLastFrame(ExtendedSurface* pExtSurface) {
     MFX_ITT_TASK("DecodeLastFrame");
     mfxFrameSurface1* pmfxSurface = NULL;
     mfxStatus sts                 = MFX_ERR_MORE_SURFACE;
+    pExtSurface->SubmitTick       = msdk_time_get_tick();
 
     //--- Time measurements
     if (statisticsWindowSize) {
@@ -687,6 +763,7 @@ mfxStatus CTranscodingPipeline::DecodeLastFrame(ExtendedSurface* pExtSurface) {
             sts                   = m_pBSProcessor->GetInputFrame(pExtSurface->pSurface);
         }
         else if (MFX_WRN_DEVICE_BUSY == sts) {
+            m_Counters.DecBusy.fetch_add(1, std::memory_order_relaxed);
             WaitForDeviceToBecomeFree(*m_pmfxSession, m_LastDecSyncPoint, sts);
         }
 
@@ -731,6 +808,7 @@ mfxStatus CTranscodingPipeline::DecodeLastFrame(ExtendedSurface* pExtSurface) {
     // HEVC SW requires additional synchronization
     if (MFX_ERR_NONE == sts && isHEVCSW) {
         sts = m_pmfxSession->SyncOperation(pExtSurface->Syncp, GetSyncOpTimeout());
+        SurfaceUnlockNotifier::Instance().Notify();
         HandlePossibleGpuHang(sts);
         MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "Decode: SyncOperation failed");
     }
@@ -746,6 +824,10 @@ mfxStatus CTranscodingPipeline::VPPOneFrame(ExtendedSurface* pSurfaceIn,
     mfxFrameSurface1* out_surface = NULL;
     mfxStatus sts                 = MFX_ERR_NONE;
 
+    // frames drained from VPP keep the tick of the last input
+    if (pSurfaceIn && pSurfaceIn->pSurface)
+        pExtSurface->SubmitTick = pSurfaceIn->SubmitTick;
+
     if (m_MemoryModel == GENERAL_ALLOC || m_MemoryModel == VISIBLE_INT_ALLOC) {
         if (m_MemoryModel == GENERAL_ALLOC) {
             // find/wait for a free working surface
@@ -824,10 +906,13 @@ mfxStatus CTranscodingPipeline::VPPOneFrame(ExtendedSurface* pSurfaceIn,
                                                   SMTTracer::EventName::UNDEF,
                                                   pSurfaceIn->pSurface,
                                                   out_surface);
-                sts = m_pmfxVPP->RunFrameVPPAsync(pSurfaceIn->pSurface,
-                                                  out_surface,
-                                                  NULL,
-                                                  &pExtSurface->Syncp);
+                {
+                    MFX_ITT_TASK("RunFrameVPPAsync");
+                    sts = m_pmfxVPP->RunFrameVPPAsync(pSurfaceIn->pSurface,
+                                                      out_surface,
+                                                      NULL,
+                                                      &pExtSurface->Syncp);
+                }
                 m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::VPP,
                                                 TargetID,
                                                 SMTTracer::EventName::UNDEF,
@@ -845,6 +930,7 @@ mfxStatus CTranscodingPipeline::VPPOneFrame(ExtendedSurface* pSurfaceIn,
                  !out_surface)) // repeat the call if warning and no output
             {
                 if (MFX_WRN_DEVICE_BUSY == sts) {
+                    m_Counters.VppBusy.fetch_add(1, std::memory_order_relaxed);
                     if (TargetID == DecoderTargetID && desc.CascadeScaler) {
                         m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::CSVPP,
                                                           desc.PoolID,
@@ -900,6 +986,31 @@ mfxStatus CTranscodingPipeline::EncodeOneFrame(ExtendedSurface* pExtSurface,
         MSDK_CHECK_STATUS(sts, "AllocateSufficientBuffer failed");
     }
 
+    // encoder may reorder frames, so latency is taken between N-th submitted and N-th output frame
+    if (pExtSurface->pSurface) {
+        m_LatencyTicks.push_back(pExtSurface->SubmitTick);
+        m_Counters.FramesInFlight.store(m_LatencyTicks.size(), std::memory_order_relaxed);
+    }
+
+    if (pExtSurface->pSurface && m_QualityMeter.IsOpen()) {
+        sts = AddQualitySource(pExtSurface->pSurface);
+        MSDK_CHECK_STATUS(sts, "AddQualitySource failed");
+    }
+
+#ifdef ONEVPL_EXPERIMENTAL
+    // bitstreams are reused, so the request is renewed for every frame
+    if (m_EncodeStats.IsOpen())
+        CEncodeStatsWriter::Request(*pBS);
+#endif
+
+    // the leader reports QP of every output frame to -la_share followers, drained ones included
+    if (m_bLaLeader) {
+        auto info = pBS->GetExtBuffer<mfxExtAVCEncodedFrameInfo>();
+        if (!info)
+            info = pBS->AddExtBuffer<mfxExtAVCEncodedFrameInfo>();
+        info->FrameOrder = (mfxU32)MFX_FRAMEORDER_UNKNOWN;
+    }
+
     for (;;) {
         if (m_bTCBRCFileMode && pExtSurface->pSurface) {
             sts = ConfigTCBRCTest(pExtSurface->pSurface);
@@ -912,10 +1023,13 @@ mfxStatus CTranscodingPipeline::EncodeOneFrame(ExtendedSurface* pExtSurface,
                                           SMTTracer::EventName::UNDEF,
                                           pExtSurface->pSurface,
                                           nullptr);
-        sts = m_pmfxENC->EncodeFrameAsync(pExtSurface->pEncCtrl,
-                                          pExtSurface->pSurface,
-                                          pBS,
-                                          &pExtSurface->Syncp);
+        {
+            MFX_ITT_TASK("EncodeFrameAsync");
+            sts = m_pmfxENC->EncodeFrameAsync(pExtSurface->pEncCtrl,
+                                              pExtSurface->pSurface,
+                                              pBS,
+                                              &pExtSurface->Syncp);
+        }
         m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::ENC,
                                         TargetID,
                                         SMTTracer::EventName::UNDEF,
@@ -925,6 +1039,7 @@ mfxStatus CTranscodingPipeline::EncodeOneFrame(ExtendedSurface* pExtSurface,
         if (MFX_ERR_NONE < sts && !pExtSurface->Syncp) // repeat the call if warning and no output
         {
             if (MFX_WRN_DEVICE_BUSY == sts) {
+                m_Counters.EncBusy.fetch_add(1, std::memory_order_relaxed);
                 m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::ENC,
                                                   TargetID,
                                                   SMTTracer::EventName::BUSY,
@@ -943,6 +1058,8 @@ mfxStatus CTranscodingPipeline::EncodeOneFrame(ExtendedSurface* pExtSurface,
             break;
         }
         else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
+            if (m_pBSStore)
+                m_pBSStore->ReportInsufficientBuffer();
             sts = AllocateSufficientBuffer(pBS);
             MSDK_CHECK_STATUS(sts, "AllocateSufficientBuffer failed");
         }
@@ -1140,9 +1257,10 @@ mfxStatus CTranscodingPipeline::Decode() {
                             sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
                         }
                         else {
-                            VppExtSurface.pSurface = DecExtSurface.pSurface;
-                            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-                            VppExtSurface.Syncp    = DecExtSurface.Syncp;
+                            VppExtSurface.pSurface   = DecExtSurface.pSurface;
+                            VppExtSurface.pAuxCtrl   = DecExtSurface.pAuxCtrl;
+                            VppExtSurface.Syncp      = DecExtSurface.Syncp;
+                            VppExtSurface.SubmitTick = DecExtSurface.SubmitTick;
                         }
                     }
                     else {
@@ -1195,8 +1313,9 @@ mfxStatus CTranscodingPipeline::Decode() {
         }
         else // no VPP - just copy pointers
         {
-            VppExtSurface.pSurface = DecExtSurface.pSurface;
-            VppExtSurface.Syncp    = DecExtSurface.Syncp;
+            VppExtSurface.pSurface   = DecExtSurface.pSurface;
+            VppExtSurface.Syncp      = DecExtSurface.Syncp;
+            VppExtSurface.SubmitTick = DecExtSurface.SubmitTick;
         }
 
         //--- Sometimes VPP may return 2 surfaces on output, for the first one it'll return status MFX_ERR_MORE_SURFACE - we have to call VPPOneFrame again in this case
@@ -1218,8 +1337,9 @@ mfxStatus CTranscodingPipeline::Decode() {
         MSDK_BREAK_ON_ERROR(sts);
 
         {
-            PreEncExtSurface.pSurface = VppExtSurface.pSurface;
-            PreEncExtSurface.Syncp    = VppExtSurface.Syncp;
+            PreEncExtSurface.pSurface   = VppExtSurface.pSurface;
+            PreEncExtSurface.Syncp      = VppExtSurface.Syncp;
+            PreEncExtSurface.SubmitTick = VppExtSurface.SubmitTick;
         }
 
         if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
@@ -1254,6 +1374,7 @@ mfxStatus CTranscodingPipeline::Decode() {
         if ((!m_bIsJoinSession && m_pParentPipeline)) {
             MFX_ITT_TASK("SyncOperation");
             sts = m_pmfxSession->SyncOperation(PreEncExtSurface.Syncp, GetSyncOpTimeout());
+            SurfaceUnlockNotifier::Instance().Notify();
             HandlePossibleGpuHang(sts);
             PreEncExtSurface.Syncp = NULL;
             MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "PreEnc: SyncOperation failed");
@@ -1321,6 +1442,7 @@ mfxStatus CTranscodingPipeline::Decode() {
                                                   frontSurface.pSurface,
                                                   nullptr);
                 sts = m_pmfxSession->SyncOperation(frontSurface.Syncp, GetSyncOpTimeout());
+                SurfaceUnlockNotifier::Instance().Notify();
                 m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::DEC,
                                                 0,
                                                 SMTTracer::EventName::SYNC,
@@ -1370,16 +1492,54 @@ mfxStatus CTranscodingPipeline::Encode() {
     int nFramesAlreadyPut          = 0;
     SafetySurfaceBuffer* curBuffer = m_pBuffer;
 
+    // with -vpp_comp_dirty the last composed frame of every stream stays at the front of its
+    // buffer and is composed again until the decoder puts a new one behind it
+    bool bCompDirty = m_nVPPCompMode > 0 && m_bVppCompDirty;
+    std::map<SafetySurfaceBuffer*, ExtendedSurface> compHeldSurfaces;
+    auto hasNewCompSurface = [&]() {
+        for (SafetySurfaceBuffer* buf = m_pBuffer; buf != NULL; buf = buf->m_pNext) {
+            if (!compHeldSurfaces.count(buf) || buf->GetLength() > 1)
+                return true;
+        }
+        return false;
+    };
+
     bool shouldReadNextFrame = true;
     while (MFX_ERR_NONE == sts || MFX_ERR_MORE_DATA == sts) {
         msdk_tick nBeginTime = msdk_time_get_tick(); // microseconds
         if (shouldReadNextFrame) {
+            auto held = compHeldSurfaces.end();
+            if (bCompDirty && !isQuit) {
+                // compose only when at least one of the streams has changed
+                mfxU32 waitTime = 0;
+                while (curBuffer == m_pBuffer && !hasNewCompSurface()) {
+                    if (waitTime >= MSDK_SURFACE_WAIT_INTERVAL / 1000) {
+                        msdk_printf(
+                            MSDK_STRING("ERROR: timed out waiting surface from upstream component\n"));
+                        return MFX_ERR_NOT_FOUND;
+                    }
+                    MSDK_SLEEP(TIME_TO_SLEEP);
+                    waitTime += TIME_TO_SLEEP;
+                }
+
+                held = compHeldSurfaces.find(curBuffer);
+                if (held != compHeldSurfaces.end() && curBuffer->GetLength() > 1) {
+                    curBuffer->ReleaseSurface(held->second.pSurface);
+                    compHeldSurfaces.erase(held);
+                    held = compHeldSurfaces.end();
+                }
+            }
+
             if (isQuit) {
                 // We're here because one of decoders has reported that there're no any more frames ready.
                 //So, let's pass null surface to extract data from the VPP and encoder caches.
 
                 MSDK_ZERO_MEMORY(DecExtSurface);
             }
+            else if (held != compHeldSurfaces.end()) {
+                // stream is static or late, its last frame is already synchronized
+                DecExtSurface = held->second;
+            }
             else {
                 while (MFX_ERR_MORE_SURFACE == curBuffer->GetSurface(DecExtSurface)) {
                     mfxU32 tempTimestamp        = 0;
@@ -1415,6 +1575,7 @@ mfxStatus CTranscodingPipeline::Encode() {
                     MFX_ITT_TASK("SyncOperation");
                     sts = m_pParentPipeline->m_pmfxSession->SyncOperation(DecExtSurface.Syncp,
                                                                           GetSyncOpTimeout());
+                    SurfaceUnlockNotifier::Instance().Notify();
                     HandlePossibleGpuHang(sts);
                     MSDK_CHECK_ERR_NONE_STATUS(sts,
                                                MFX_ERR_ABORTED,
@@ -1431,6 +1592,10 @@ mfxStatus CTranscodingPipeline::Encode() {
             if (NULL == DecExtSurface.pSurface) {
                 isQuit = true;
             }
+            else if (bCompDirty && held == compHeldSurfaces.end()) {
+                compHeldSurfaces[curBuffer]        = DecExtSurface;
+                compHeldSurfaces[curBuffer].Syncp = NULL;
+            }
         }
 
         if (m_pmfxVPP.get()) {
@@ -1439,9 +1604,10 @@ mfxStatus CTranscodingPipeline::Encode() {
         }
         else // no VPP - just copy pointers
         {
-            VppExtSurface.pSurface = DecExtSurface.pSurface;
-            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-            VppExtSurface.Syncp    = DecExtSurface.Syncp;
+            VppExtSurface.pSurface   = DecExtSurface.pSurface;
+            VppExtSurface.pAuxCtrl   = DecExtSurface.pAuxCtrl;
+            VppExtSurface.Syncp      = DecExtSurface.Syncp;
+            VppExtSurface.SubmitTick = DecExtSurface.SubmitTick;
         }
 
         if (MFX_ERR_MORE_SURFACE == sts) {
@@ -1459,7 +1625,8 @@ mfxStatus CTranscodingPipeline::Encode() {
                 sts                    = MFX_ERR_NONE;
             }
             else {
-                curBuffer->ReleaseSurface(DecExtSurface.pSurface);
+                if (!bCompDirty)
+                    curBuffer->ReleaseSurface(DecExtSurface.pSurface);
 
                 //--- We should switch to another buffer ONLY in case of Composition
                 if (curBuffer->m_pNext != NULL && m_nVPPCompMode > 0) {
@@ -1475,7 +1642,7 @@ mfxStatus CTranscodingPipeline::Encode() {
 
         MSDK_CHECK_STATUS(sts, "Unexpected error!!");
 
-        if (m_nVPPCompMode > 0)
+        if (m_nVPPCompMode > 0 && !bCompDirty)
             curBuffer->ReleaseSurface(DecExtSurface.pSurface);
 
         // Do RenderFrame before Encode to improves on-screen performance
@@ -1484,6 +1651,7 @@ mfxStatus CTranscodingPipeline::Encode() {
             if (VppExtSurface.pSurface) {
                 // Sync to ensure VPP is completed to avoid flicker
                 sts = m_pmfxSession->SyncOperation(VppExtSurface.Syncp, GetSyncOpTimeout());
+                SurfaceUnlockNotifier::Instance().Notify();
                 HandlePossibleGpuHang(sts);
                 MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "VPP: SyncOperation failed");
                 if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
@@ -1554,8 +1722,8 @@ mfxStatus CTranscodingPipeline::Encode() {
             }
         }
 
-        if (shouldReadNextFrame) // Release current decoded surface only if we're going to read next one during next iteration
-        {
+        // Release current decoded surface only if we're going to read next one during next iteration
+        if (shouldReadNextFrame && !bCompDirty) {
             m_pBuffer->ReleaseSurface(DecExtSurface.pSurface);
         }
 
@@ -1634,13 +1802,13 @@ mfxStatus CTranscodingPipeline::Encode() {
         }
 
         if ((m_nVPPCompMode != VppCompOnly) || (m_nVPPCompMode == VppCompOnlyEncode)) {
-            if (m_BSPool.size() == m_AsyncDepth) {
+            if (m_BSPool.size() < m_AsyncDepthController.GetDepth())
+                continue;
+            // adaptive depth may have shrunk below the pool size
+            while (m_BSPool.size() >= m_AsyncDepthController.GetDepth()) {
                 sts = PutBS();
                 MSDK_CHECK_STATUS(sts, "PutBS failed");
             }
-            else {
-                continue;
-            }
         } // if (m_nVPPCompMode != VppCompOnly)
 
         msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
@@ -1814,6 +1982,8 @@ void CTranscodingPipeline::SetEncCtrlRT(ExtendedSurface& extSurface, bool bInser
             ctrl = *extSurface.pEncCtrl;
         }
 
+        SetLaSharedQP(ctrl);
+
         // Copy all extended buffer pointers from pExtSurface.pAuxCtrl.encCtrl
         m_extBuffPtrStorage[keyId].clear();
         if (extSurface.pAuxCtrl) {
@@ -1858,221 +2028,336 @@ void CTranscodingPipeline::SetEncCtrlRT(ExtendedSurface& extSurface, bool bInser
     }
 }
 
+void CTranscodingPipeline::InitLaShare(sInputParams* pInParams) {
+    if (!m_pLaQPExchange)
+        return;
+
+    const mfxFrameInfo& info = m_mfxEncParams.mfx.FrameInfo;
+    mfxF64 frameRate         = (mfxF64)info.FrameRateExtN / info.FrameRateExtD;
+    mfxF64 kbps              = pInParams->nBitRate;
+    if (!kbps)
+        kbps = CalculateDefaultBitrate(pInParams->EncodeId,
+                                       pInParams->nTargetUsage,
+                                       info.Width,
+                                       info.Height,
+                                       frameRate);
+    if (pInParams->nBitRateMultiplier)
+        kbps *= pInParams->nBitRateMultiplier;
+    mfxF64 bitsPerFrame = kbps * 1000 / frameRate;
+
+    m_bLaLeader = LaQPExchange::IsLeader(*pInParams);
+    if (m_bLaLeader) {
+        m_pLaQPExchange->SetLeaderRate(bitsPerFrame / (info.CropW * info.CropH));
+        return;
+    }
+
+    // follower's QP comes from the leader, the bitrate is kept by the offset to it
+    m_LaTargetBitsPerFrame        = bitsPerFrame;
+    m_LaWindowSize                = std::max<mfxU32>((mfxU32)(frameRate + 0.5), 1);
+    pInParams->nRateControlMethod = MFX_RATECONTROL_CQP;
+    if (!pInParams->nQPI)
+        pInParams->nQPI = 26;
+    if (!pInParams->nQPP)
+        pInParams->nQPP = pInParams->nQPI;
+    if (!pInParams->nQPB)
+        pInParams->nQPB = pInParams->nQPP;
+    m_LaLastQP = pInParams->nQPP;
+} // void CTranscodingPipeline::InitLaShare(sInputParams* pInParams)
+
+void CTranscodingPipeline::SetLaSharedQP(mfxEncodeCtrl& ctrl) {
+    if (!m_pLaQPExchange || m_bLaLeader)
+        return;
+
+    mfxU16 qp = m_pLaQPExchange->Wait(m_nSubmittedFramesNum);
+    if (qp == LaQPExchange::NoQP) {
+        ctrl.QP = m_LaLastQP;
+        return;
+    }
+
+    // bitrate halves every 6 QP, initial offset is taken from bits per pixel of the renditions
+    mfxF64 leaderRate = m_pLaQPExchange->GetLeaderRate();
+    if (!m_bLaQPOffsetSet && leaderRate > 0) {
+        const mfxFrameInfo& info = m_mfxEncParams.mfx.FrameInfo;
+        m_LaQPOffset = 6 * std::log2(leaderRate * info.CropW * info.CropH / m_LaTargetBitsPerFrame);
+        m_bLaQPOffsetSet = true;
+    }
+
+    mfxI32 followerQP = qp + (mfxI32)std::lround(m_LaQPOffset);
+    m_LaLastQP        = (mfxU16)std::min(std::max(followerQP, 1), 51);
+    ctrl.QP           = m_LaLastQP;
+} // void CTranscodingPipeline::SetLaSharedQP(mfxEncodeCtrl& ctrl)
+
+void CTranscodingPipeline::UpdateLaShare(mfxBitstreamWrapper& bs) {
+    if (!m_pLaQPExchange)
+        return;
+
+    if (m_bLaLeader) {
+        auto info = bs.GetExtBuffer<mfxExtAVCEncodedFrameInfo>();
+        if (info && info->FrameOrder != (mfxU32)MFX_FRAMEORDER_UNKNOWN)
+            m_pLaQPExchange->Publish(info->FrameOrder, info->QP);
+        else
+            m_pLaQPExchange->Publish(m_nOutputFramesNum - 1, LaQPExchange::NoQP);
+        return;
+    }
+
+    m_LaWindowBits += (mfxU64)bs.DataLength * 8;
+    if (++m_LaWindowFrames < m_LaWindowSize)
+        return;
+
+    // half of the bitrate error is corrected per window, so encoder delay doesn't oscillate it
+    mfxF64 ratio = m_LaWindowBits / (m_LaWindowFrames * m_LaTargetBitsPerFrame);
+    if (ratio > 0)
+        m_LaQPOffset = std::min(std::max(m_LaQPOffset + 3 * std::log2(ratio), -24.0), 24.0);
+    m_LaWindowBits   = 0;
+    m_LaWindowFrames = 0;
+} // void CTranscodingPipeline::UpdateLaShare(mfxBitstreamWrapper& bs)
+
 mfxStatus CTranscodingPipeline::Transcode() {
-    mfxStatus sts                 = MFX_ERR_NONE;
-    ExtendedSurface DecExtSurface = { 0 };
-    ExtendedSurface VppExtSurface = { 0 };
-    ExtendedBS* pBS               = NULL;
-    bool bNeedDecodedFrames       = true; // indicates if we need to decode frames
-    bool bEndOfFile               = false;
-    bool bLastCycle               = false;
-    bool shouldReadNextFrame      = true;
-
-    time_t start = time(0);
+    mfxStatus sts = MFX_ERR_NONE;
+
+    BeginTranscode();
     while (MFX_ERR_NONE == sts) {
-        msdk_tick nBeginTime = msdk_time_get_tick(); // microseconds.
+        sts = TranscodeStep();
+    }
 
-        if (time(0) - start >= m_nTimeout)
-            bLastCycle = true;
-        if (m_MaxFramesForTranscode == m_nProcessedFramesNum) {
-            DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
-            bNeedDecodedFrames     = false; // no more decoded frames needed
-        }
+    return CompleteTranscode(sts);
+} // mfxStatus CTranscodingPipeline::Transcode()
 
-        // if need more decoded frames
-        // decode a frame
-        if (bNeedDecodedFrames && shouldReadNextFrame) {
-            if (!bEndOfFile) {
-                sts = DecodeOneFrame(&DecExtSurface);
-                if (MFX_ERR_MORE_DATA == sts) {
-                    if (!bLastCycle) {
-                        m_bInsertIDR = true;
+void CTranscodingPipeline::BeginTranscode() {
+    m_TranscodeState       = TranscodeState();
+    m_TranscodeState.start = time(0);
+} // void CTranscodingPipeline::BeginTranscode()
 
-                        m_pBSProcessor->ResetInput();
-                        m_pBSProcessor->ResetOutput();
-                        bNeedDecodedFrames = true;
+mfxStatus CTranscodingPipeline::TranscodeStep() {
+    mfxStatus sts                  = MFX_ERR_NONE;
+    ExtendedSurface& DecExtSurface = m_TranscodeState.DecExtSurface;
+    ExtendedSurface& VppExtSurface = m_TranscodeState.VppExtSurface;
+    ExtendedBS* pBS                = NULL;
+    bool& bNeedDecodedFrames       = m_TranscodeState.bNeedDecodedFrames;
+    bool& bEndOfFile               = m_TranscodeState.bEndOfFile;
+    bool& bLastCycle               = m_TranscodeState.bLastCycle;
+    bool& shouldReadNextFrame      = m_TranscodeState.shouldReadNextFrame;
 
-                        bEndOfFile = false;
-                        sts        = MFX_ERR_NONE;
-                        continue;
-                    }
-                    else {
-                        bEndOfFile = true;
-                    }
-                }
-            }
+    if (m_bResetComponents) {
+        m_bResetComponents = false;
+        sts                = ResetComponents();
+        MSDK_CHECK_STATUS(sts, "ResetComponents failed");
+    }
 
-            if (bEndOfFile) {
-                sts = DecodeLastFrame(&DecExtSurface);
-            }
+    // bitstream pool is left full by the previous step of the task pool
+    while (m_BSPool.size() >= m_AsyncDepthController.GetDepth()) {
+        sts = PutBS();
+        MSDK_CHECK_STATUS(sts, "PutBS failed");
+    }
 
-            if (sts == MFX_ERR_MORE_DATA) {
-                DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
-                sts                    = MFX_ERR_NONE;
+    msdk_tick nBeginTime = msdk_time_get_tick(); // microseconds.
+
+    if (time(0) - m_TranscodeState.start >= m_nTimeout)
+        bLastCycle = true;
+    if (m_MaxFramesForTranscode == m_nProcessedFramesNum) {
+        DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
+        bNeedDecodedFrames     = false; // no more decoded frames needed
+    }
+
+    // if need more decoded frames
+    // decode a frame
+    if (bNeedDecodedFrames && shouldReadNextFrame) {
+        if (!bEndOfFile) {
+            sts = DecodeOneFrame(&DecExtSurface);
+            if (MFX_ERR_MORE_DATA == sts) {
+                if (!bLastCycle) {
+                    m_bInsertIDR = true;
+
+                    m_pBSProcessor->ResetInput();
+                    m_pBSProcessor->ResetOutput();
+                    bNeedDecodedFrames = true;
+
+                    bEndOfFile = false;
+                    return MFX_ERR_NONE;
+                }
+                else {
+                    bEndOfFile = true;
+                }
             }
-            MSDK_CHECK_STATUS(sts, "Decode<One|Last>Frame failed");
-        }
-        if (m_bIsFieldWeaving && DecExtSurface.pSurface != NULL) {
-            m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
         }
-        if (m_bIsFieldSplitting && DecExtSurface.pSurface != NULL) {
-            m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+
+        if (bEndOfFile) {
+            sts = DecodeLastFrame(&DecExtSurface);
         }
-        // pre-process a frame
-        if (m_pmfxVPP.get() && bNeedDecodedFrames && !m_rawInput) {
-            if (m_bIsFieldWeaving) {
-                // In case of field weaving output surface's parameters for ODD calls to VPPOneFrame will be ignored (because VPP will return ERR_MORE_DATA).
-                // So, we need to set output surface picstruct properly for EVEN calls (no matter what will be set for ODD calls).
-                // We might have 2 cases: decoder gives us pairs (TF BF)... or (BF)(TF). In first case we should set TFF for output, in second - BFF.
-                // So, if even input surface is BF, we set TFF for output and vise versa. For odd input surface - no matter what we set.
-                if (DecExtSurface.pSurface) {
-                    if ((DecExtSurface.pSurface->Info.PicStruct &
-                         MFX_PICSTRUCT_FIELD_TFF)) // Incoming Top Field in a single surface
-                    {
-                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_BFF;
-                    }
-                    if (DecExtSurface.pSurface->Info.PicStruct &
-                        MFX_PICSTRUCT_FIELD_BFF) // Incoming Bottom Field in a single surface
-                    {
-                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_TFF;
-                    }
+
+        if (sts == MFX_ERR_MORE_DATA) {
+            DecExtSurface.pSurface = NULL; // to get buffered VPP or ENC frames
+            sts                    = MFX_ERR_NONE;
+        }
+        MSDK_CHECK_STATUS(sts, "Decode<One|Last>Frame failed");
+    }
+    if (m_bIsFieldWeaving && DecExtSurface.pSurface != NULL) {
+        m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+    }
+    if (m_bIsFieldSplitting && DecExtSurface.pSurface != NULL) {
+        m_mfxDecParams.mfx.FrameInfo.PicStruct = DecExtSurface.pSurface->Info.PicStruct;
+    }
+    // pre-process a frame
+    if (m_pmfxVPP.get() && bNeedDecodedFrames && !m_rawInput) {
+        if (m_bIsFieldWeaving) {
+            // In case of field weaving output surface's parameters for ODD calls to VPPOneFrame will be ignored (because VPP will return ERR_MORE_DATA).
+            // So, we need to set output surface picstruct properly for EVEN calls (no matter what will be set for ODD calls).
+            // We might have 2 cases: decoder gives us pairs (TF BF)... or (BF)(TF). In first case we should set TFF for output, in second - BFF.
+            // So, if even input surface is BF, we set TFF for output and vise versa. For odd input surface - no matter what we set.
+            if (DecExtSurface.pSurface) {
+                if ((DecExtSurface.pSurface->Info.PicStruct &
+                     MFX_PICSTRUCT_FIELD_TFF)) // Incoming Top Field in a single surface
+                {
+                    m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_BFF;
+                }
+                if (DecExtSurface.pSurface->Info.PicStruct &
+                    MFX_PICSTRUCT_FIELD_BFF) // Incoming Bottom Field in a single surface
+                {
+                    m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_TFF;
                 }
-                sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
             }
-            else {
-                if (m_bIsFieldSplitting) {
-                    if (DecExtSurface.pSurface) {
-                        if (DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_TFF ||
-                            DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_BFF) {
-                            m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_SINGLE;
-                            sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
-                        }
-                        else {
-                            VppExtSurface.pSurface = DecExtSurface.pSurface;
-                            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-                            VppExtSurface.Syncp    = DecExtSurface.Syncp;
-                        }
+            sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
+        }
+        else {
+            if (m_bIsFieldSplitting) {
+                if (DecExtSurface.pSurface) {
+                    if (DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_TFF ||
+                        DecExtSurface.pSurface->Info.PicStruct & MFX_PICSTRUCT_FIELD_BFF) {
+                        m_mfxVppParams.vpp.Out.PicStruct = MFX_PICSTRUCT_FIELD_SINGLE;
+                        sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
                     }
                     else {
-                        sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
+                        VppExtSurface.pSurface   = DecExtSurface.pSurface;
+                        VppExtSurface.pAuxCtrl   = DecExtSurface.pAuxCtrl;
+                        VppExtSurface.Syncp      = DecExtSurface.Syncp;
+                        VppExtSurface.SubmitTick = DecExtSurface.SubmitTick;
                     }
                 }
                 else {
                     sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
                 }
             }
-            // check for interlaced stream
-
-            if (m_MemoryModel != GENERAL_ALLOC && DecExtSurface.pSurface) {
-                mfxStatus sts_release =
-                    DecExtSurface.pSurface->FrameInterface->Release(DecExtSurface.pSurface);
-                MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
+            else {
+                sts = VPPOneFrame(&DecExtSurface, &VppExtSurface);
             }
         }
-        else // no VPP - just copy pointers
-        {
-            VppExtSurface.pSurface = DecExtSurface.pSurface;
-            VppExtSurface.pAuxCtrl = DecExtSurface.pAuxCtrl;
-            VppExtSurface.Syncp    = DecExtSurface.Syncp;
+        // check for interlaced stream
+
+        if (m_MemoryModel != GENERAL_ALLOC && DecExtSurface.pSurface) {
+            mfxStatus sts_release =
+                DecExtSurface.pSurface->FrameInterface->Release(DecExtSurface.pSurface);
+            MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
         }
+    }
+    else // no VPP - just copy pointers
+    {
+        VppExtSurface.pSurface   = DecExtSurface.pSurface;
+        VppExtSurface.pAuxCtrl   = DecExtSurface.pAuxCtrl;
+        VppExtSurface.Syncp      = DecExtSurface.Syncp;
+        VppExtSurface.SubmitTick = DecExtSurface.SubmitTick;
+    }
 
-        if (MFX_ERR_MORE_SURFACE == sts) {
-            shouldReadNextFrame = false;
-            sts                 = MFX_ERR_NONE;
+    if (MFX_ERR_MORE_SURFACE == sts) {
+        shouldReadNextFrame = false;
+        sts                 = MFX_ERR_NONE;
+    }
+    else {
+        shouldReadNextFrame = true;
+    }
+
+    if (sts == MFX_ERR_MORE_DATA) {
+        sts = MFX_ERR_NONE;
+        if (NULL == DecExtSurface.pSurface) // there are no more buffered frames in VPP
+        {
+            VppExtSurface.pSurface = NULL; // to get buffered ENC frames
         }
         else {
-            shouldReadNextFrame = true;
-        }
-
-        if (sts == MFX_ERR_MORE_DATA) {
-            sts = MFX_ERR_NONE;
-            if (NULL == DecExtSurface.pSurface) // there are no more buffered frames in VPP
-            {
-                VppExtSurface.pSurface = NULL; // to get buffered ENC frames
-            }
-            else {
-                continue; // go get next frame from Decode
-            }
+            return MFX_ERR_NONE; // go get next frame from Decode
         }
+    }
 
-        MSDK_CHECK_STATUS(sts, "Unexpected error!!");
+    MSDK_CHECK_STATUS(sts, "Unexpected error!!");
 
-        // encode frame
-        pBS = m_pBSStore->GetNext();
-        if (!pBS)
-            return MFX_ERR_NOT_FOUND;
+    // encode frame
+    pBS = m_pBSStore->GetNext();
+    if (!pBS)
+        return MFX_ERR_NOT_FOUND;
 
-        m_BSPool.push_back(pBS);
+    m_BSPool.push_back(pBS);
 
-        // Set Encoding control if it is required.
+    // Set Encoding control if it is required.
 
-        SetEncCtrlRT(VppExtSurface, m_bInsertIDR);
-        m_bInsertIDR = false;
+    SetEncCtrlRT(VppExtSurface, m_bInsertIDR);
+    m_bInsertIDR = false;
 
-        if (DecExtSurface.pSurface)
-            m_nProcessedFramesNum++;
+    if (DecExtSurface.pSurface)
+        m_nProcessedFramesNum++;
 
-        if (m_mfxEncParams.mfx.CodecId != MFX_CODEC_DUMP) {
-            sts = EncodeOneFrame(&VppExtSurface, &m_BSPool.back()->Bitstream);
-        }
-        else {
-            sts = Surface2BS(&VppExtSurface, &m_BSPool.back()->Bitstream, m_encoderFourCC);
-        }
+    if (m_mfxEncParams.mfx.CodecId != MFX_CODEC_DUMP) {
+        sts = EncodeOneFrame(&VppExtSurface, &m_BSPool.back()->Bitstream);
+    }
+    else {
+        sts = Surface2BS(&VppExtSurface, &m_BSPool.back()->Bitstream, m_encoderFourCC);
+    }
 
-        if (m_MemoryModel != GENERAL_ALLOC && VppExtSurface.pSurface) {
-            mfxStatus sts_release =
-                VppExtSurface.pSurface->FrameInterface->Release(VppExtSurface.pSurface);
-            MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
-        }
+    if (m_MemoryModel != GENERAL_ALLOC && VppExtSurface.pSurface) {
+        mfxStatus sts_release =
+            VppExtSurface.pSurface->FrameInterface->Release(VppExtSurface.pSurface);
+        MSDK_CHECK_STATUS(sts_release, "FrameInterface->Release failed");
+    }
 
-        // check if we need one more frame from decode
-        if (MFX_ERR_MORE_DATA == sts) {
-            // the task in not in Encode queue
-            m_BSPool.pop_back();
-            m_pBSStore->Release(pBS);
+    // check if we need one more frame from decode
+    if (MFX_ERR_MORE_DATA == sts) {
+        // the task in not in Encode queue
+        m_BSPool.pop_back();
+        m_pBSStore->Release(pBS);
 
-            if (NULL == VppExtSurface.pSurface) // there are no more buffered frames in encoder
-            {
-                break;
-            }
-            sts = MFX_ERR_NONE;
-            continue;
+        if (NULL == VppExtSurface.pSurface) // there are no more buffered frames in encoder
+        {
+            return MFX_ERR_MORE_DATA;
         }
+        return MFX_ERR_NONE;
+    }
 
-        // check encoding result
-        MSDK_CHECK_STATUS(sts, "<EncodeOneFrame|Surface2BS> failed");
+    // check encoding result
+    MSDK_CHECK_STATUS(sts, "<EncodeOneFrame|Surface2BS> failed");
 
-        if (statisticsWindowSize) {
-            if ((statisticsWindowSize && m_nOutputFramesNum &&
-                 0 == m_nProcessedFramesNum % statisticsWindowSize) ||
-                (statisticsWindowSize && (m_nProcessedFramesNum >= m_MaxFramesForTranscode))) {
-                inputStatistics.PrintStatistics(GetPipelineID());
-                outputStatistics.PrintStatistics(
-                    GetPipelineID(),
-                    (m_mfxEncParams.mfx.FrameInfo.FrameRateExtD)
-                        ? (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtN /
-                              (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtD
-                        : -1);
-                inputStatistics.ResetStatistics();
-                outputStatistics.ResetStatistics();
-            }
-        }
-        else if (0 == (m_nProcessedFramesNum - 1) % 100) {
-            msdk_printf(MSDK_STRING("."));
+    if (statisticsWindowSize) {
+        if ((statisticsWindowSize && m_nOutputFramesNum &&
+             0 == m_nProcessedFramesNum % statisticsWindowSize) ||
+            (statisticsWindowSize && (m_nProcessedFramesNum >= m_MaxFramesForTranscode))) {
+            inputStatistics.PrintStatistics(GetPipelineID());
+            outputStatistics.PrintStatistics(
+                GetPipelineID(),
+                (m_mfxEncParams.mfx.FrameInfo.FrameRateExtD)
+                    ? (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtN /
+                          (mfxF64)m_mfxEncParams.mfx.FrameInfo.FrameRateExtD
+                    : -1);
+            inputStatistics.ResetStatistics();
+            outputStatistics.ResetStatistics();
         }
+    }
+    else if (0 == (m_nProcessedFramesNum - 1) % 100) {
+        msdk_printf(MSDK_STRING("."));
+    }
 
-        m_BSPool.back()->Syncp = VppExtSurface.Syncp;
+    m_BSPool.back()->Syncp = VppExtSurface.Syncp;
 
-        if (m_BSPool.size() == m_AsyncDepth) {
-            sts = PutBS();
-            MSDK_CHECK_STATUS(sts, "PutBS failed");
-        }
+    // task pool puts the bitstream in the next step, once it's ready
+    while (m_BSPool.size() >= m_AsyncDepthController.GetDepth() && !m_bStepRun) {
+        sts = PutBS();
+        MSDK_CHECK_STATUS(sts, "PutBS failed");
+    }
 
-        msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
-        if (nFrameTime < m_nReqFrameTime) {
-            MSDK_USLEEP((mfxU32)(m_nReqFrameTime - nFrameTime));
-        }
+    msdk_tick nFrameTime = msdk_time_get_tick() - nBeginTime;
+    if (nFrameTime < m_nReqFrameTime) {
+        MSDK_USLEEP((mfxU32)(m_nReqFrameTime - nFrameTime));
     }
+
+    return sts;
+} // mfxStatus CTranscodingPipeline::TranscodeStep()
+
+mfxStatus CTranscodingPipeline::CompleteTranscode(mfxStatus sts) {
     MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
 
     // need to get buffered bitstream
@@ -2083,46 +2368,119 @@ mfxStatus CTranscodingPipeline::Transcode() {
         }
     }
 
+    // the next stream after Reset starts with a new header
+    if (m_QualityMeter.IsOpen())
+        m_QualityMeter.Flush();
+
     if (MFX_ERR_NONE == sts)
         sts = MFX_WRN_VALUE_NOT_CHANGED;
 
     return sts;
-} // mfxStatus CTranscodingPipeline::Transcode()
+} // mfxStatus CTranscodingPipeline::CompleteTranscode()
 
-mfxStatus CTranscodingPipeline::PutBS() {
-    mfxStatus sts            = MFX_ERR_NONE;
-    ExtendedBS* pBitstreamEx = m_BSPool.front();
+mfxStatus CTranscodingPipeline::SyncBS(ExtendedBS* pBitstreamEx, bool bPoll) {
     MSDK_CHECK_POINTER(pBitstreamEx, MFX_ERR_NULL_PTR);
+    if (!pBitstreamEx->Syncp)
+        return MFX_ERR_NONE;
 
-    // get result coded stream, synchronize only if we still have sync point
-    if (pBitstreamEx->Syncp) {
+    // polling doesn't produce trace events
+    if (!bPoll) {
         m_ScalerConfig.Tracer->BeginEvent(SMTTracer::ThreadType::ENC,
                                           TargetID,
                                           SMTTracer::EventName::SYNC,
                                           pBitstreamEx->Syncp,
                                           nullptr);
-        sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, GetSyncOpTimeout());
+    }
+    mfxU32 wait          = bPoll ? 0 : GetSyncOpTimeout();
+    msdk_tick nBeginTime = msdk_time_get_tick();
+    mfxStatus sts;
+    {
+        MFX_ITT_TASK("SyncOperation");
+        sts = m_pmfxSession->SyncOperation(pBitstreamEx->Syncp, wait);
+    }
+    if (bPoll && MFX_WRN_IN_EXECUTION == sts)
+        return sts;
+    SurfaceUnlockNotifier::Instance().Notify();
+    m_Counters.SyncWaitUs.fetch_add(
+        (mfxU64)(CTimeStatisticsReal::ConvertToSeconds(msdk_time_get_tick() - nBeginTime) *
+                 1000000),
+        std::memory_order_relaxed);
 
+    if (!bPoll) {
         m_ScalerConfig.Tracer->EndEvent(SMTTracer::ThreadType::ENC,
                                         TargetID,
                                         SMTTracer::EventName::SYNC,
                                         pBitstreamEx->Syncp,
                                         nullptr);
-        HandlePossibleGpuHang(sts);
-        MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "Encode: SyncOperation failed");
-        if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
-            m_pSurfaceUtilizationSynchronizer->NotifyFreeCome();
-        }
+    }
+    HandlePossibleGpuHang(sts);
+    MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "Encode: SyncOperation failed");
+    if (m_pSurfaceUtilizationSynchronizer && m_MemoryModel != GENERAL_ALLOC) {
+        m_pSurfaceUtilizationSynchronizer->NotifyFreeCome();
+    }
+
+    pBitstreamEx->Syncp = NULL;
+    return MFX_ERR_NONE;
+} //mfxStatus CTranscodingPipeline::SyncBS()
+
+mfxStatus CTranscodingPipeline::PutBS() {
+    mfxStatus sts            = MFX_ERR_NONE;
+    ExtendedBS* pBitstreamEx = m_BSPool.front();
+    MSDK_CHECK_POINTER(pBitstreamEx, MFX_ERR_NULL_PTR);
+
+    // get result coded stream, synchronize only if we still have sync point
+    mfxU64 waitUs = m_Counters.SyncWaitUs.load(std::memory_order_relaxed);
+    sts           = SyncBS(pBitstreamEx, false);
+    MSDK_CHECK_STATUS(sts, "SyncBS failed");
+
+#ifdef ONEVPL_EXPERIMENTAL
+    if (m_EncodeStats.IsOpen())
+        m_EncodeStats.Add(pBitstreamEx->Bitstream);
+#endif
+    if (m_QualityMeter.IsOpen())
+        m_QualityMeter.AddBitstream(pBitstreamEx->Bitstream);
+
+    if (m_AsyncDepthController.IsAdaptive()) {
+        waitUs = m_Counters.SyncWaitUs.load(std::memory_order_relaxed) - waitUs;
+        m_AsyncDepthController.Update(waitUs,
+                                      m_Counters.DecBusy.load(std::memory_order_relaxed) +
+                                          m_Counters.VppBusy.load(std::memory_order_relaxed) +
+                                          m_Counters.EncBusy.load(std::memory_order_relaxed));
+        m_Counters.AsyncDepth.store(m_AsyncDepthController.GetDepth(), std::memory_order_relaxed);
     }
 
     m_nOutputFramesNum++;
 
+    UpdateLaShare(pBitstreamEx->Bitstream);
+
     //--- Time measurements
     if (statisticsWindowSize) {
         outputStatistics.StopTimeMeasurementWithCheck();
         outputStatistics.StartTimeMeasurement();
     }
 
+    if (!m_LatencyTicks.empty()) {
+        msdk_tick submitTick = m_LatencyTicks.front();
+        m_LatencyTicks.pop_front();
+        msdk_tick elapsed = msdk_time_get_tick() - submitTick;
+        if (submitTick && elapsed >= 0) {
+            mfxU64 latencyUs = (mfxU64)(CTimeStatisticsReal::ConvertToSeconds(elapsed) * 1000000);
+            m_LatencyHistogram.Record(latencyUs);
+            if (m_pLatencyLog)
+                msdk_fprintf(m_pLatencyLog,
+                             MSDK_STRING("%u\t%llu\n"),
+                             m_nOutputFramesNum,
+                             (unsigned long long)latencyUs);
+        }
+    }
+
+    m_Counters.FramesInFlight.store(m_LatencyTicks.size(), std::memory_order_relaxed);
+    m_Counters.OutputFrames.fetch_add(1, std::memory_order_relaxed);
+    m_Counters.OutputBytes.fetch_add(pBitstreamEx->Bitstream.DataLength,
+                                     std::memory_order_relaxed);
+
+    m_pBSStore->ReportFrameSize(pBitstreamEx->Bitstream.DataLength);
+
     sts = m_pBSProcessor->ProcessOutputBitstream(&pBitstreamEx->Bitstream);
     MSDK_CHECK_STATUS(sts, "m_pBSProcessor->ProcessOutputBitstream failed");
 
@@ -2158,12 +2516,73 @@ mfxStatus CTranscodingPipeline::DumpSurface2File(mfxFrameSurface1* pSurf) {
         MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
     }
     else {
-        sts = pSurf->FrameInterface->Unmap(pSurf);
-        MSDK_CHECK_STATUS(sts, "FrameInterface->Unmap failed");
+        sts = pSurf->FrameInterface->Unmap(pSurf);
+        MSDK_CHECK_STATUS(sts, "FrameInterface->Unmap failed");
+    }
+
+    return sts;
+} // mfxStatus CTranscodingPipeline::DumpSurface2File(ExtendedSurface* pSurf)
+
+mfxStatus CTranscodingPipeline::AddQualitySource(mfxFrameSurface1* pSurf) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    if (m_MemoryModel == GENERAL_ALLOC) {
+        sts = m_pMFXAllocator->Lock(m_pMFXAllocator->pthis, pSurf->Data.MemId, &pSurf->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Lock failed");
+    }
+    else {
+        sts = pSurf->FrameInterface->Map(pSurf, MFX_MAP_READ);
+        MSDK_CHECK_STATUS(sts, "FrameInterface->Map failed");
+    }
+
+    mfxStatus addSts = m_QualityMeter.AddSource(*pSurf);
+
+    if (m_MemoryModel == GENERAL_ALLOC) {
+        sts = m_pMFXAllocator->Unlock(m_pMFXAllocator->pthis, pSurf->Data.MemId, &pSurf->Data);
+        MSDK_CHECK_STATUS(sts, "m_pMFXAllocator->Unlock failed");
+    }
+    else {
+        sts = pSurf->FrameInterface->Unmap(pSurf);
+        MSDK_CHECK_STATUS(sts, "FrameInterface->Unmap failed");
+    }
+
+    MSDK_CHECK_STATUS(addSts, "m_QualityMeter.AddSource failed");
+    return sts;
+} // mfxStatus CTranscodingPipeline::AddQualitySource(mfxFrameSurface1* pSurf)
+
+mfxStatus CTranscodingPipeline::InitQualityMeter(sInputParams* pParams,
+                                                 VPLImplementationLoader* mfxLoader) {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    // the output is decoded to internally allocated system memory surfaces
+    if (m_Version.Major < 2) {
+        msdk_printf(MSDK_STRING("error: -quality requires API 2.0 or later\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    m_pQualitySession.reset(new MainVideoSession);
+    if (m_verSessionInit == API_1X) {
+        sts = m_pQualitySession->InitEx(m_initPar);
+        MSDK_CHECK_STATUS(sts, "m_pQualitySession->InitEx failed");
+    }
+    else {
+        sts = m_pQualitySession->CreateSession(mfxLoader);
+        MSDK_CHECK_STATUS(sts, "m_pQualitySession->CreateSession failed");
     }
 
+    // the decoder shares the device of the pipeline
+    if (m_hdl) {
+        mfxIMPL impl = 0;
+        m_pQualitySession->QueryIMPL(&impl);
+        sts = m_pQualitySession->SetHandle(GetHandleType(impl), m_hdl);
+        MSDK_CHECK_STATUS(sts, "m_pQualitySession->SetHandle failed");
+    }
+
+    sts = m_QualityMeter.Open(pParams->strQualityFile, m_pQualitySession.get(), pParams->EncodeId);
+    MSDK_CHECK_STATUS(sts, "m_QualityMeter.Open failed");
+
     return sts;
-} // mfxStatus CTranscodingPipeline::DumpSurface2File(ExtendedSurface* pSurf)
+} // mfxStatus CTranscodingPipeline::InitQualityMeter()
 
 mfxStatus CTranscodingPipeline::Surface2BS(ExtendedSurface* pSurf,
                                            mfxBitstreamWrapper* pBS,
@@ -2173,9 +2592,12 @@ mfxStatus CTranscodingPipeline::Surface2BS(ExtendedSurface* pSurf,
     if (!pSurf->pSurface) {
         return MFX_ERR_MORE_DATA;
     }
+    m_LatencyTicks.push_back(pSurf->SubmitTick);
+    m_Counters.FramesInFlight.store(m_LatencyTicks.size(), std::memory_order_relaxed);
 
     if (pSurf->Syncp) {
         sts = m_pmfxSession->SyncOperation(pSurf->Syncp, GetSyncOpTimeout());
+        SurfaceUnlockNotifier::Instance().Notify();
         HandlePossibleGpuHang(sts);
         MSDK_CHECK_ERR_NONE_STATUS(sts, MFX_ERR_ABORTED, "SyncOperation failed");
         pSurf->Syncp = 0;
@@ -2556,6 +2978,8 @@ mfxStatus CTranscodingPipeline::InitEncMfxParams(sInputParams* pInParams) {
 
     m_mfxEncParams.mfx.FrameInfo.Shift = m_shouldUseShifted10BitEnc;
 
+    InitLaShare(pInParams);
+
     { m_mfxEncParams.mfx.RateControlMethod = pInParams->nRateControlMethod; }
     m_mfxEncParams.mfx.NumSlice = pInParams->nSlices;
 
@@ -2781,6 +3205,12 @@ mfxStatus CTranscodingPipeline::InitEncMfxParams(sInputParams* pInParams) {
     if (pInParams->bIsMVC)
         m_mfxEncParams.AddExtBuffer<mfxExtMVCSeqDesc>();
 
+    if (pInParams->numMFEFrames > 1 || pInParams->MFMode >= MFX_MF_AUTO) {
+        auto mfe          = m_mfxEncParams.AddExtBuffer<mfxExtMultiFrameParam>();
+        mfe->MFMode       = pInParams->MFMode;
+        mfe->MaxNumFrames = pInParams->numMFEFrames;
+    }
+
     if (pInParams->TargetBitDepthLuma) {
         auto co3                = m_mfxEncParams.AddExtBuffer<mfxExtCodingOption3>();
         co3->TargetBitDepthLuma = pInParams->TargetBitDepthLuma;
@@ -2835,12 +3265,10 @@ mfxStatus CTranscodingPipeline::InitEncMfxParams(sInputParams* pInParams) {
         m_mfxEncParams.mfx.BRCParamMultiplier = pInParams->nBitRateMultiplier;
     }
 
-#if (defined(_WIN64) || defined(_WIN32))
     if (pInParams->isDualMode) {
         auto hyperEncodeParam  = m_mfxEncParams.AddExtBuffer<mfxExtHyperModeParam>();
         hyperEncodeParam->Mode = pInParams->hyperMode;
     }
-#endif
 
     if (pInParams->nIVFHeader) {
         if (MFX_CODEC_AV1 == pInParams->EncodeId) {
@@ -3284,10 +3712,48 @@ mfxStatus CTranscodingPipeline::AllocFramesForCS() {
         return MFX_ERR_MEMORY_ALLOC;
     }
 
+    // Surfaces are reference counted, so targets may take them from one pool as long as they are
+    // interchangeable. Each component request already holds surfaces it needs for reordering,
+    // every additional user of the pool adds only its frames in flight.
+    for (auto& p : m_ScalerConfig.Pools) {
+        auto& PoolDesc        = p.second;
+        PoolDesc.SharedPoolID = 0;
+
+        if (PoolDesc.ID == DecoderPoolID || !m_ScalerConfig.SharePools) {
+            continue;
+        }
+
+        for (auto& o : m_ScalerConfig.Pools) {
+            auto& OwnerDesc = o.second;
+            if (OwnerDesc.ID == PoolDesc.ID) {
+                break;
+            }
+            if (OwnerDesc.ID == DecoderPoolID || OwnerDesc.SharedPoolID ||
+                OwnerDesc.AllocReq.Type != PoolDesc.AllocReq.Type ||
+                OwnerDesc.AllocReq.Info.Width != PoolDesc.AllocReq.Info.Width ||
+                OwnerDesc.AllocReq.Info.Height != PoolDesc.AllocReq.Info.Height ||
+                OwnerDesc.AllocReq.Info.FourCC != PoolDesc.AllocReq.Info.FourCC ||
+                OwnerDesc.AllocReq.Info.ChromaFormat != PoolDesc.AllocReq.Info.ChromaFormat) {
+                continue;
+            }
+
+            mfxFrameAllocRequest& OwnerReq = OwnerDesc.AllocReq;
+            PoolDesc.SharedPoolID          = OwnerDesc.ID;
+            OwnerReq.NumFrameSuggested =
+                std::max(OwnerReq.NumFrameSuggested, PoolDesc.AllocReq.NumFrameSuggested) +
+                m_AsyncDepth;
+            OwnerReq.NumFrameMin = OwnerReq.NumFrameSuggested;
+            msdk_printf(MSDK_STRING("Cascade scaler pool %u shares surfaces of pool %u\n"),
+                        PoolDesc.ID,
+                        OwnerDesc.ID);
+            break;
+        }
+    }
+
     for (auto& p : m_ScalerConfig.Pools) {
         auto& PoolDesc = p.second;
 
-        if (PoolDesc.ID == DecoderPoolID) {
+        if (PoolDesc.ID == DecoderPoolID || PoolDesc.SharedPoolID) {
             continue;
         }
 
@@ -3403,8 +3869,22 @@ mfxStatus CTranscodingPipeline::SetupSurfacePool(mfxU32 preallocateNum) {
             m_VPPOutAllocReques.Type |= MFX_MEMTYPE_EXPORT_FRAME;
         }
 #endif
+        // composition and raw output keep the surfaces, raw input keeps them locked
+        bool bSharedPool = m_pSurfacePoolService && !m_nVPPCompMode && !m_rawInput &&
+                           m_mfxEncParams.mfx.CodecId != MFX_CODEC_DUMP &&
+                           !(m_VPPOutAllocReques.Type & MFX_MEMTYPE_EXPORT_FRAME);
         if (!m_forceSyncAllSession) {
-            if (m_MemoryModel == GENERAL_ALLOC) {
+            if (m_MemoryModel == GENERAL_ALLOC && bSharedPool) {
+                msdk_printf(MSDK_STRING("Pipeline surfaces number (EncPool): %d, shared\n"),
+                            (int)m_VPPOutAllocReques.NumFrameSuggested);
+                sts = m_pSurfacePoolService->RegisterConsumer(m_VPPOutAllocReques,
+                                                              m_VPPOutAllocReques.NumFrameSuggested,
+                                                              &m_SharedPoolConsumer);
+                MSDK_CHECK_STATUS(sts, "m_pSurfacePoolService->RegisterConsumer failed");
+                m_bSharedEncPool = true;
+                m_EncSurfaceType = m_VPPOutAllocReques.Type;
+            }
+            else if (m_MemoryModel == GENERAL_ALLOC) {
                 sts = AllocFrames(&m_VPPOutAllocReques, false);
                 MSDK_CHECK_STATUS(sts, "AllocFrames failed");
             }
@@ -3452,6 +3932,12 @@ mfxStatus CTranscodingPipeline::SetupSurfacePool(mfxU32 preallocateNum) {
                 m_DecOutAllocReques.NumFrameMin       = 2;
             }
 
+            // last composed frame stays locked in the composition buffer until a new one comes
+            if (m_nVPPCompMode && m_bVppCompDirty) {
+                m_DecOutAllocReques.NumFrameSuggested++;
+                m_DecOutAllocReques.NumFrameMin++;
+            }
+
             if (!m_forceSyncAllSession) {
                 if (m_MemoryModel == GENERAL_ALLOC) {
                     sts = AllocFrames(&m_DecOutAllocReques, true);
@@ -3471,6 +3957,12 @@ mfxStatus CTranscodingPipeline::SetupSurfacePool(mfxU32 preallocateNum) {
             }
         }
         else {
+            // -la_share followers keep decoded frames until the leader outputs them
+            if (m_pLaQPExchange && !m_bLaLeader) {
+                m_DecOutAllocReques.NumFrameSuggested =
+                    (mfxU16)(m_DecOutAllocReques.NumFrameSuggested + m_pLaQPExchange->GetLag());
+                m_DecOutAllocReques.NumFrameMin = m_DecOutAllocReques.NumFrameSuggested;
+            }
             if ((m_pParentPipeline) && (0 == m_nVPPCompMode) /* case if 1_to_N  */) {
                 m_pParentPipeline->CorrectNumberOfAllocatedFrames(&m_DecOutAllocReques, TargetID);
             }
@@ -3646,6 +4138,11 @@ void CTranscodingPipeline::FreeFrames() {
     });
     m_pSurfaceEncPool.clear();
 
+    if (m_bSharedEncPool) {
+        m_pSurfacePoolService->UnregisterConsumer(m_SharedPoolConsumer);
+        m_bSharedEncPool = false;
+    }
+
     if (m_pMFXAllocator) {
         m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxEncResponse);
         m_pMFXAllocator->Free(m_pMFXAllocator->pthis, &m_mfxDecResponse);
@@ -3654,7 +4151,7 @@ void CTranscodingPipeline::FreeFrames() {
     for (auto& p : m_ScalerConfig.Pools) {
         auto& PoolDesc = p.second;
 
-        if (PoolDesc.ID == DecoderPoolID) {
+        if (PoolDesc.ID == DecoderPoolID || PoolDesc.SharedPoolID) {
             continue;
         }
 
@@ -3700,6 +4197,9 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
     m_nTimeout = pParams->nTimeout;
 
     m_AsyncDepth            = (0 == pParams->nAsyncDepth) ? 1 : pParams->nAsyncDepth;
+    m_AsyncDepthController.Init(pParams->nAsyncDepthMin ? pParams->nAsyncDepthMin : m_AsyncDepth,
+                                m_AsyncDepth);
+    m_Counters.AsyncDepth.store(m_AsyncDepthController.GetDepth(), std::memory_order_relaxed);
     m_FrameNumberPreference = pParams->FrameNumberPreference;
     m_numEncoders           = 0;
     m_bUseOverlay           = pParams->DecodeId == MFX_CODEC_RGB4 ? true : false;
@@ -3749,6 +4249,16 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
         0 == statisticsWindowSize)
         statisticsWindowSize = m_MaxFramesForTranscode;
 
+    if (0 != msdk_strlen(pParams->strLatencyLogFile) && !m_pLatencyLog) {
+        MSDK_FOPEN(m_pLatencyLog, pParams->strLatencyLogFile, MSDK_STRING("w"));
+        if (!m_pLatencyLog) {
+            msdk_printf(MSDK_STRING("error: can't open latency log \"%s\"\n"),
+                        pParams->strLatencyLogFile);
+            return MFX_ERR_UNSUPPORTED;
+        }
+        msdk_fprintf(m_pLatencyLog, MSDK_STRING("frame\tlatency_us\n"));
+    }
+
     if (m_bEncodeEnable) {
         m_pBSStore.reset(new ExtendedBSStore(m_AsyncDepth));
     }
@@ -3813,7 +4323,16 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
     if ((VppComp == pParams->eModeExt) || (VppCompOnly == pParams->eModeExt)) {
         if (m_nVPPCompMode != VppCompOnlyEncode)
             m_nVPPCompMode = pParams->eModeExt;
+        m_bVppCompDirty = pParams->bVppCompDirty;
+    }
+
+#ifdef ONEVPL_EXPERIMENTAL
+    if (0 != msdk_strlen(pParams->strEncodeStatsFile) && m_bEncodeEnable &&
+        !m_EncodeStats.IsOpen()) {
+        sts = m_EncodeStats.Open(pParams->strEncodeStatsFile);
+        MSDK_CHECK_STATUS(sts, "m_EncodeStats.Open failed");
     }
+#endif
 
 #ifdef LIBVA_SUPPORT
     m_libvaBackend = pParams->libvaBackend;
@@ -3826,9 +4345,11 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
 
     m_initPar.Implementation = pParams->libType;
 
-    if (pParams->nThreadsNum) {
-        auto threadsPar       = m_initPar.AddExtBuffer<mfxExtThreadsParam>();
-        threadsPar->NumThread = pParams->nThreadsNum;
+    if (pParams->nThreadsNum || pParams->SchedulingType || pParams->Priority) {
+        auto threadsPar            = m_initPar.AddExtBuffer<mfxExtThreadsParam>();
+        threadsPar->NumThread      = pParams->nThreadsNum;
+        threadsPar->SchedulingType = pParams->SchedulingType;
+        threadsPar->Priority       = pParams->Priority;
     }
 
     //--- GPU Copy settings
@@ -3925,6 +4446,10 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
         else
             MSDK_CHECK_STATUS(sts, "DecodePreInit failed");
 
+        // Sink sessions get the frame rate of their sources from the launcher
+        if (pParams->bDecSkip && Native == pParams->eMode)
+            m_DecSkipOutFramerate = pParams->dVPPOutFramerate;
+
         if (TargetID == DecoderTargetID && !CSConfig.Targets.empty()) {
             CSConfig.Targets[0].SrcWidth  = m_mfxDecParams.mfx.FrameInfo.CropW;
             CSConfig.Targets[0].SrcHeight = m_mfxDecParams.mfx.FrameInfo.CropH;
@@ -4042,6 +4567,9 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
         sts = m_pmfxENC->Init(&m_mfxEncParams);
         MSDK_CHECK_STATUS(sts, "m_pmfxENC->Init failed");
 
+        if (pParams->isDualMode && pParams->hyperMode != MFX_HYPERMODE_OFF)
+            PrintHyperModeInfo(pParams->hyperMode);
+
         if (pParams->bExtMBQP) {
             m_bUseQPMap = true;
         }
@@ -4081,11 +4609,44 @@ mfxStatus CTranscodingPipeline::Init(sInputParams* pParams,
                                                     &m_mfxEncParams);
     }
 
+    // kept open over Reset like the latency log
+    if (0 != msdk_strlen(pParams->strQualityFile) && m_bEncodeEnable &&
+        !m_QualityMeter.IsOpen()) {
+        sts = InitQualityMeter(pParams, mfxLoader);
+        MSDK_CHECK_STATUS(sts, "InitQualityMeter failed");
+    }
+
     m_bIsInit = true;
 
     return sts;
 } //mfxStatus CTranscodingPipeline::Init(sInputParams *pParams)
 
+static const msdk_char* HyperModeToString(mfxHyperMode mode) {
+    switch (mode) {
+        case MFX_HYPERMODE_OFF:
+            return MSDK_STRING("off");
+        case MFX_HYPERMODE_ON:
+            return MSDK_STRING("on");
+        case MFX_HYPERMODE_ADAPTIVE:
+            return MSDK_STRING("adaptive");
+        default:
+            return MSDK_STRING("unknown");
+    }
+}
+
+// With adaptive mode the runtime falls back to a single adapter without an error, so the mode in
+// use is queried from the initialized encoder
+void CTranscodingPipeline::PrintHyperModeInfo(mfxHyperMode requested) {
+    MfxVideoParamsWrapper par;
+    auto hyperParam = par.AddExtBuffer<mfxExtHyperModeParam>();
+
+    mfxStatus sts = m_pmfxENC->GetVideoParam(&par);
+    msdk_printf(MSDK_STRING("Session [%s]: HyperMode requested %s, in use %s\n"),
+                GetSessionText().c_str(),
+                HyperModeToString(requested),
+                sts >= MFX_ERR_NONE ? HyperModeToString(hyperParam->Mode) : MSDK_STRING("unknown"));
+}
+
 mfxStatus CTranscodingPipeline::CompleteInit() {
     mfxStatus sts = MFX_ERR_NONE;
 
@@ -4169,7 +4730,38 @@ mfxStatus CTranscodingPipeline::CompleteInit() {
     return sts;
 } // mfxStatus CTranscodingPipeline::CompleteInit()
 mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec, mfxU64 timeout) {
-    mfxFrameSurface1* pSurf = NULL;
+    MFX_ITT_TASK("GetFreeSurface");
+    if (!isDec && m_bSharedEncPool)
+        return AcquireSharedSurface(timeout);
+
+    return AcquireFreeSurface(isDec ? m_pSurfaceDecPool : m_pSurfaceEncPool,
+                              isDec ? m_DecPoolNextFree : m_EncPoolNextFree,
+                              isDec ? SMTTracer::ThreadType::DEC : SMTTracer::ThreadType::ENC,
+                              TargetID,
+                              timeout);
+} // mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec)
+
+mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 timeout, mfxU32 ID) {
+    if (ID == 0) {
+        return GetFreeSurface(isDec, timeout);
+    }
+
+    auto desc         = m_ScalerConfig.GetDesc(ID);
+    mfxU32 surfPoolID = m_ScalerConfig.GetSurfacePoolID(desc.PoolID);
+    return AcquireFreeSurface(m_CSSurfacePools[surfPoolID],
+                              m_CSPoolNextFree[surfPoolID],
+                              SMTTracer::ThreadType::CSVPP,
+                              desc.PoolID,
+                              timeout);
+}
+
+mfxFrameSurface1* CTranscodingPipeline::AcquireFreeSurface(SurfPointersArray& workArray,
+                                                           mfxU32& nextFree,
+                                                           SMTTracer::ThreadType thType,
+                                                           mfxU32 thID,
+                                                           mfxU64 timeout) {
+    mfxFrameSurface1* pSurf         = NULL;
+    SurfaceUnlockNotifier& notifier = SurfaceUnlockNotifier::Instance();
 
     CTimer t;
     t.Start();
@@ -4183,21 +4775,31 @@ mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec, mfxU64 timeou
             }
         }
 
-        SurfPointersArray& workArray = isDec ? m_pSurfaceDecPool : m_pSurfaceEncPool;
-
-        int available =
-            (int)std::count_if(workArray.begin(), workArray.end(), [](mfxFrameSurface1* s) {
-                return s->Data.Locked == 0;
-            });
-        m_ScalerConfig.Tracer->AddCounterEvent(
-            isDec ? SMTTracer::ThreadType::DEC : SMTTracer::ThreadType::ENC,
-            TargetID,
-            SMTTracer::EventName::UNDEF,
-            available);
-
-        for (mfxU32 i = 0; i < workArray.size(); i++) {
-            if (!workArray[i]->Data.Locked) {
-                pSurf = workArray[i];
+        mfxU64 generation = notifier.GetGeneration();
+
+        if (m_ScalerConfig.Tracer->IsEnabled() || m_bCountFreeSurfaces) {
+            int available =
+                (int)std::count_if(workArray.begin(), workArray.end(), [](mfxFrameSurface1* s) {
+                    return s->Data.Locked == 0;
+                });
+            m_ScalerConfig.Tracer->AddCounterEvent(thType,
+                                                   thID,
+                                                   SMTTracer::EventName::UNDEF,
+                                                   available);
+            if (&workArray == &m_pSurfaceDecPool)
+                m_Counters.FreeDecSurfaces.store(available, std::memory_order_relaxed);
+            else if (&workArray == &m_pSurfaceEncPool)
+                m_Counters.FreeEncSurfaces.store(available, std::memory_order_relaxed);
+        }
+
+        // surfaces are taken and returned in order, so search from the position after the last
+        // taken surface finds a free one in a step or two
+        mfxU32 size = (mfxU32)workArray.size();
+        for (mfxU32 i = 0; i < size; i++) {
+            mfxU32 idx = (nextFree + i) % size;
+            if (!workArray[idx]->Data.Locked) {
+                pSurf    = workArray[idx];
+                nextFree = (idx + 1) % size;
                 break;
             }
         }
@@ -4205,19 +4807,16 @@ mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec, mfxU64 timeou
             break;
         }
         else {
-            MSDK_SLEEP(TIME_TO_SLEEP);
+            notifier.Wait(generation, TIME_TO_SLEEP);
         }
     } while (t.GetTime() < timeout / 1000);
 
     return pSurf;
-} // mfxFrameSurface1* CTranscodingPipeline::GetFreeSurface(bool isDec)
-
-mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 timeout, mfxU32 ID) {
-    if (ID == 0) {
-        return GetFreeSurface(isDec, timeout);
-    }
+}
 
-    mfxFrameSurface1* pSurf = NULL;
+mfxFrameSurface1* CTranscodingPipeline::AcquireSharedSurface(mfxU64 timeout) {
+    mfxFrameSurface1* pSurf         = NULL;
+    SurfaceUnlockNotifier& notifier = SurfaceUnlockNotifier::Instance();
 
     CTimer t;
     t.Start();
@@ -4231,36 +4830,21 @@ mfxFrameSurface1* CTranscodingPipeline::GetFreeSurfaceForCS(bool isDec, mfxU64 t
             }
         }
 
-        auto desc                    = m_ScalerConfig.GetDesc(ID);
-        SurfPointersArray& workArray = m_CSSurfacePools[desc.PoolID];
-
-        int available =
-            (int)std::count_if(workArray.begin(), workArray.end(), [](mfxFrameSurface1* s) {
-                return s->Data.Locked == 0;
-            });
-        m_ScalerConfig.Tracer->AddCounterEvent(SMTTracer::ThreadType::CSVPP,
-                                               desc.PoolID,
-                                               SMTTracer::EventName::UNDEF,
-                                               available);
-
-        for (mfxU32 i = 0; i < workArray.size(); i++) {
-            if (!workArray[i]->Data.Locked) {
-                pSurf = workArray[i];
-                break;
-            }
-        }
-        if (pSurf) {
+        // surfaces are unlocked by other sessions too, the notifier is process-wide
+        mfxU64 generation = notifier.GetGeneration();
+        pSurf             = m_pSurfacePoolService->AcquireSurface(m_SharedPoolConsumer);
+        if (pSurf)
             break;
-        }
-        else {
-            MSDK_SLEEP(TIME_TO_SLEEP);
-        }
+        notifier.Wait(generation, TIME_TO_SLEEP);
     } while (t.GetTime() < timeout / 1000);
 
     return pSurf;
 }
 
 mfxU32 CTranscodingPipeline::GetFreeSurfacesCount(bool isDec) {
+    if (!isDec && m_bSharedEncPool)
+        return m_pSurfacePoolService->GetFreeSurfacesCount(m_SharedPoolConsumer);
+
     SurfPointersArray& workArray = isDec ? m_pSurfaceDecPool : m_pSurfaceEncPool;
     mfxU32 count                 = 0;
     for (mfxU32 i = 0; i < workArray.size(); i++) {
@@ -4308,21 +4892,21 @@ void CTranscodingPipeline::HandlePossibleGpuHang(mfxStatus& sts) {
         msdk_printf(MSDK_STRING(
             "[WARNING] GPU hang happened. Inserting an IDR and continuing transcoding.\n"));
         m_bInsertIDR = true;
+        // contexts of the components may be lost with the hang, sessions exchanging surfaces
+        // with others can't drop their frames and only insert the IDR
+        m_bResetComponents = IsStepRunSupported() && !m_ScalerConfig.CascadeScalerRequired;
         for (BSList::iterator it = m_BSPool.begin(); it != m_BSPool.end(); it++) {
-            (*it)->IsFree               = true;
             (*it)->Bitstream.DataOffset = 0;
             (*it)->Bitstream.DataLength = 0;
+            m_pBSStore->Release(*it);
         }
         m_BSPool.clear();
+        m_LatencyTicks.clear();
         sts = MFX_ERR_NONE;
     }
 }
 
-mfxStatus CTranscodingPipeline::SetAllocatorAndHandleIfRequired() {
-    mfxStatus sts = MFX_ERR_NONE;
-    mfxIMPL impl  = 0;
-    m_pmfxSession->QueryIMPL(&impl);
-
+mfxHandleType CTranscodingPipeline::GetHandleType(mfxIMPL impl) {
     mfxHandleType handleType = (mfxHandleType)0;
 
     if (MFX_IMPL_VIA_D3D11 == MFX_IMPL_VIA_MASK(impl)) {
@@ -4337,6 +4921,16 @@ mfxStatus CTranscodingPipeline::SetAllocatorAndHandleIfRequired() {
     }
 #endif
 
+    return handleType;
+}
+
+mfxStatus CTranscodingPipeline::SetAllocatorAndHandleIfRequired() {
+    mfxStatus sts = MFX_ERR_NONE;
+    mfxIMPL impl  = 0;
+    m_pmfxSession->QueryIMPL(&impl);
+
+    mfxHandleType handleType = GetHandleType(impl);
+
     bool ext_allocator_exists = m_MemoryModel == GENERAL_ALLOC;
     if (m_hdl && (m_bIsInterOrJoined || ext_allocator_exists)) {
         sts = m_pmfxSession->SetHandle(handleType, m_hdl);
@@ -4371,6 +4965,57 @@ mfxStatus CTranscodingPipeline::SetAllocatorAndHandleIfRequired() {
     return sts;
 }
 
+mfxStatus CTranscodingPipeline::ResetComponents() {
+    mfxStatus sts = MFX_ERR_NONE;
+
+    if (m_pmfxDEC.get()) {
+        m_pmfxDEC->Close();
+        sts = m_pmfxDEC->Init(&m_mfxDecParams);
+        MSDK_CHECK_STATUS(sts, "m_pmfxDEC->Init failed");
+    }
+
+    if (m_pmfxVPP.get()) {
+        m_pmfxVPP->Close();
+        if (m_bIsPlugin && m_bIsVpp) {
+            mfxFrameAllocRequest request[2] = {};
+            sts = m_pmfxVPP->QueryIOSurfMulti(&m_mfxPluginParams, request, &m_mfxVppParams);
+            MSDK_CHECK_STATUS(sts, "m_pmfxVPP->QueryIOSurf failed");
+
+            sts = m_pmfxVPP->InitMulti(&m_mfxPluginParams, &m_mfxVppParams);
+        }
+        else if (m_bIsPlugin)
+            sts = m_pmfxVPP->Init(&m_mfxPluginParams);
+        else
+            sts = m_pmfxVPP->Init(&m_mfxVppParams);
+        MSDK_CHECK_STATUS(sts, "m_pmfxVPP->Init failed");
+    }
+
+    if (m_pmfxENC.get()) {
+        m_pmfxENC->Close();
+        sts = m_pmfxENC->Init(&m_mfxEncParams);
+        MSDK_CHECK_STATUS(sts, "m_pmfxENC->Init failed");
+    }
+
+    // frames of the lost tasks are never unlocked by the library
+    for (size_t i = 0; i < m_pSurfaceDecPool.size(); i++) {
+        m_pSurfaceDecPool[i]->Data.Locked = 0;
+    }
+    for (size_t i = 0; i < m_pSurfaceEncPool.size(); i++) {
+        m_pSurfaceEncPool[i]->Data.Locked = 0;
+    }
+    m_TranscodeState.DecExtSurface.pSurface = NULL;
+    m_TranscodeState.DecExtSurface.Syncp    = NULL;
+    m_TranscodeState.VppExtSurface.pSurface = NULL;
+    m_TranscodeState.VppExtSurface.Syncp    = NULL;
+    m_TranscodeState.bNeedDecodedFrames     = true;
+
+    // decoder skips frames up to the next random access point of the bitstream
+    msdk_printf(
+        MSDK_STRING("[WARNING] Components are re-initialized, resuming from the next IDR.\n"));
+
+    return sts;
+} // mfxStatus CTranscodingPipeline::ResetComponents()
+
 size_t CTranscodingPipeline::GetRobustFlag() {
     return m_bRobustFlag;
 }
@@ -4388,8 +5033,10 @@ void CTranscodingPipeline::Close() {
     FreeMVCSeqDesc();
 
     mfxExtVPPComposite* vppCompPar = m_mfxVppParams;
-    if (vppCompPar && vppCompPar->InputStream)
+    if (vppCompPar && vppCompPar->InputStream) {
         free(vppCompPar->InputStream);
+        vppCompPar->InputStream = NULL;
+    }
 
     if (m_bIsJoinSession) {
         //m_pmfxSession->DisjoinSession();
@@ -4459,6 +5106,7 @@ mfxStatus CTranscodingPipeline::Reset() {
 
     // Release output bitstram pools
     m_BSPool.clear();
+    m_LatencyTicks.clear();
     m_pBSStore->ReleaseAll();
     m_pBSStore->FlushAll();
 
@@ -4552,6 +5200,7 @@ mfxStatus CTranscodingPipeline::Reset(VPLImplementationLoader* mfxLoader) {
 
     // Release output bitstram pools
     m_BSPool.clear();
+    m_LatencyTicks.clear();
     m_pBSStore->ReleaseAll();
     m_pBSStore->FlushAll();
 
@@ -4654,6 +5303,23 @@ mfxStatus CTranscodingPipeline::AllocateSufficientBuffer(mfxBitstreamWrapper* pB
             par.mfx.BRCParamMultiplier == 0 ? 1 : par.mfx.BRCParamMultiplier;
         new_size = par.mfx.BufferSizeInKB * tempBRCParamMultiplier * 1000u;
     }
+
+    // The first allocation of a bitstream is sized by the frames observed so far instead of the
+    // worst case, starting from a few average frames of the target bitrate. Buffer grows to the
+    // worst-case size on MFX_ERR_NOT_ENOUGH_BUFFER.
+    if (!pBS->Data && m_pBSStore) {
+        mfxU32 estimate = 0;
+        mfxU32 kbps     = std::max(par.mfx.TargetKbps, par.mfx.MaxKbps);
+        if (par.mfx.CodecId != MFX_CODEC_JPEG && par.mfx.RateControlMethod != MFX_RATECONTROL_CQP &&
+            kbps && par.mfx.FrameInfo.FrameRateExtN && par.mfx.FrameInfo.FrameRateExtD) {
+            mfxU16 tempBRCParamMultiplier =
+                par.mfx.BRCParamMultiplier == 0 ? 1 : par.mfx.BRCParamMultiplier;
+            mfxU64 avgFrameSize = (mfxU64)kbps * tempBRCParamMultiplier * 125u *
+                                  par.mfx.FrameInfo.FrameRateExtD / par.mfx.FrameInfo.FrameRateExtN;
+            estimate = (mfxU32)std::min<mfxU64>(avgFrameSize * 4, new_size);
+        }
+        new_size = m_pBSStore->GetBufferSize(estimate, new_size);
+    }
     pBS->Extend(new_size);
 
     return MFX_ERR_NONE;
@@ -4685,6 +5351,9 @@ mfxStatus CTranscodingPipeline::Run() {
     }
     else if (m_bEncodeEnable) {
         sts = Encode();
+        // followers waiting for QP are released however the leader ends
+        if (m_bLaLeader)
+            m_pLaQPExchange->Finish();
         ss << MSDK_STRING("CTranscodingPipeline::Run::Encode() [") << GetSessionText()
            << MSDK_STRING("] failed");
         MSDK_CHECK_STATUS(sts, ss.str());
@@ -4695,6 +5364,33 @@ mfxStatus CTranscodingPipeline::Run() {
     return sts;
 }
 
+bool CTranscodingPipeline::IsStepRunSupported() {
+    // decode-only and encode-only sessions wait for each other on shared buffers
+    return m_bDecodeEnable && m_bEncodeEnable && !m_bUseOverlay;
+}
+
+void CTranscodingPipeline::BeginStepRun() {
+    m_bStepRun = true;
+    BeginTranscode();
+}
+
+mfxStatus CTranscodingPipeline::RunStep() {
+    mfxStatus sts = TranscodeStep();
+    if (MFX_ERR_NONE == sts)
+        return sts;
+
+    m_bStepRun = false;
+    return CompleteTranscode(sts);
+}
+
+bool CTranscodingPipeline::IsStepBlocked() {
+    // next step starts from putting the oldest bitstream
+    if (m_BSPool.size() < m_AsyncDepthController.GetDepth())
+        return false;
+
+    return MFX_WRN_IN_EXECUTION == SyncBS(m_BSPool.front(), true);
+}
+
 void IncreaseReference(mfxFrameSurface1& surf) {
     msdk_atomic_inc16((volatile mfxU16*)(&surf.Data.Locked));
     if (surf.FrameInterface) {
@@ -4704,9 +5400,61 @@ void IncreaseReference(mfxFrameSurface1& surf) {
 
 void DecreaseReference(mfxFrameSurface1& surf) {
     msdk_atomic_dec16((volatile mfxU16*)&surf.Data.Locked);
+    // surface may be destroyed by Release, so check the lock before
+    bool unlocked = (surf.Data.Locked == 0);
     if (surf.FrameInterface) {
         std::ignore = surf.FrameInterface->Release(&surf);
     }
+    if (unlocked) {
+        SurfaceUnlockNotifier::Instance().Notify();
+    }
+}
+
+LaQPExchange::LaQPExchange(mfxU32 lag)
+        : m_Lag(lag),
+          m_mutex(),
+          m_cv(),
+          m_QP(),
+          m_LeaderRate(0),
+          m_bFinished(false) {}
+
+void LaQPExchange::SetLeaderRate(mfxF64 bitsPerPixel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_LeaderRate = bitsPerPixel;
+}
+
+mfxF64 LaQPExchange::GetLeaderRate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_LeaderRate;
+}
+
+void LaQPExchange::Publish(mfxU32 frameOrder, mfxU16 qp) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // frames are output in encoded order, so the gaps are filled later
+        if (m_QP.size() <= frameOrder)
+            m_QP.resize(frameOrder + 1, NoQP);
+        m_QP[frameOrder] = qp;
+    }
+    m_cv.notify_all();
+}
+
+void LaQPExchange::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bFinished = true;
+    }
+    m_cv.notify_all();
+}
+
+mfxU16 LaQPExchange::Wait(mfxU32 frameOrder) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // frame missed by the leader is given up once a frame later by more than the lag is output
+    m_cv.wait(lock, [&] {
+        return m_bFinished || (m_QP.size() > frameOrder && m_QP[frameOrder] != NoQP) ||
+               m_QP.size() > frameOrder + m_Lag;
+    });
+    return m_QP.size() > frameOrder ? m_QP[frameOrder] : NoQP;
 }
 
 SafetySurfaceBuffer::SafetySurfaceBuffer(SafetySurfaceBuffer* pNext)
@@ -4822,6 +5570,242 @@ void SafetySurfaceBuffer::CancelBuffering() {
     m_IsBufferingAllowed = false;
 }
 
+SafetySurfaceRing::SafetySurfaceRing(SafetySurfaceBuffer* pNext, mfxU32 size)
+        : SafetySurfaceBuffer(pNext),
+          m_Ring(),
+          m_Mask(0),
+          m_Head(0),
+          m_Tail(0),
+          m_IsProducerWaiting(false),
+          m_IsConsumerWaiting(false) {
+    // round up to power of 2 to get slot index by mask
+    mfxU32 capacity = 1;
+    while (capacity < size && capacity < 0x80000000)
+        capacity <<= 1;
+
+    m_Ring.resize(capacity);
+    m_Mask = capacity - 1;
+} // SafetySurfaceRing::SafetySurfaceRing
+
+SafetySurfaceRing::~SafetySurfaceRing() {} // SafetySurfaceRing::~SafetySurfaceRing()
+
+mfxU32 SafetySurfaceRing::GetLength() {
+    return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+}
+
+mfxStatus SafetySurfaceRing::WaitForSurfaceRelease(mfxU32 msec) {
+    m_IsProducerWaiting.store(true);
+    // re-check after the flag is published, otherwise release may pass without signal
+    if (m_Tail.load(std::memory_order_relaxed) - m_Head.load() < m_Ring.size()) {
+        m_IsProducerWaiting.store(false);
+        return MFX_ERR_NONE;
+    }
+    return pRelEvent->TimedWait(msec);
+}
+
+mfxStatus SafetySurfaceRing::WaitForSurfaceInsertion(mfxU32 msec) {
+    m_IsConsumerWaiting.store(true);
+    if (m_Tail.load() != m_Head.load(std::memory_order_relaxed)) {
+        m_IsConsumerWaiting.store(false);
+        return MFX_ERR_NONE;
+    }
+    return pInsEvent->TimedWait(msec);
+}
+
+void SafetySurfaceRing::AddSurface(ExtendedSurface Surf) {
+    while (m_IsBufferingAllowed) {
+        mfxU32 tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail - m_Head.load(std::memory_order_acquire) >= m_Ring.size()) {
+            // ring is full, wait for consumer
+            WaitForSurfaceRelease(MSDK_SURFACE_WAIT_INTERVAL / 1000);
+            continue;
+        }
+
+        SurfaceDescriptor& sDescriptor = m_Ring[tail & m_Mask];
+        // Locked is used to signal when we can free surface
+        sDescriptor.Locked     = 1;
+        sDescriptor.ExtSurface = Surf;
+
+        if (Surf.pSurface) {
+            IncreaseReference(*Surf.pSurface);
+        }
+
+        m_Tail.store(tail + 1);
+        if (m_IsConsumerWaiting.exchange(false)) {
+            pInsEvent->Signal();
+        }
+        return;
+    }
+} // SafetySurfaceRing::AddSurface(mfxFrameSurface1 *pSurf)
+
+mfxStatus SafetySurfaceRing::GetSurface(ExtendedSurface& Surf) {
+    mfxU32 head = m_Head.load(std::memory_order_acquire);
+
+    // no ready surfaces
+    if (head == m_Tail.load(std::memory_order_acquire)) {
+        MSDK_ZERO_MEMORY(Surf)
+        return MFX_ERR_MORE_SURFACE;
+    }
+
+    Surf = m_Ring[head & m_Mask].ExtSurface;
+
+    return MFX_ERR_NONE;
+
+} // SafetySurfaceRing::GetSurface()
+
+mfxStatus SafetySurfaceRing::ReleaseSurface(mfxFrameSurface1* pSurf) {
+    mfxU32 head = m_Head.load(std::memory_order_relaxed);
+    if (head == m_Tail.load(std::memory_order_acquire))
+        return MFX_ERR_UNKNOWN;
+
+    // consumer always releases the oldest surface
+    SurfaceDescriptor& sDescriptor = m_Ring[head & m_Mask];
+    if (pSurf != sDescriptor.ExtSurface.pSurface)
+        return MFX_ERR_UNKNOWN;
+
+    sDescriptor.Locked--;
+    if (sDescriptor.ExtSurface.pSurface)
+        DecreaseReference(*sDescriptor.ExtSurface.pSurface);
+    if (0 == sDescriptor.Locked) {
+        m_Head.store(head + 1);
+        if (m_IsProducerWaiting.exchange(false)) {
+            pRelEvent->Signal();
+        }
+    }
+
+    return MFX_ERR_NONE;
+} // mfxStatus SafetySurfaceRing::ReleaseSurface(mfxFrameSurface1* pSurf)
+
+mfxStatus SafetySurfaceRing::ReleaseSurfaceAll() {
+    // called on reset when both pipelines are stopped
+    m_Head.store(m_Tail.load());
+    m_IsBufferingAllowed = true;
+    return MFX_ERR_NONE;
+
+} // mfxStatus SafetySurfaceRing::ReleaseSurfaceAll()
+
+// time to let the hardware progress when all tasks of the worker wait for the encoder
+const std::chrono::microseconds TASK_POOL_BACKOFF(200);
+
+TranscodeTaskPool::TranscodeTaskPool(mfxU32 numThreads)
+        : m_Workers(),
+          m_NextWorker(0),
+          m_NumQueued(0),
+          m_bStop(false),
+          m_mutex(),
+          m_cv() {
+    for (mfxU32 i = 0; i < std::max<mfxU32>(numThreads, 1); i++)
+        m_Workers.push_back(std::make_unique<Worker>());
+
+    // threads are started once all the queues exist, as any of them can be stolen from
+    for (mfxU32 i = 0; i < m_Workers.size(); i++)
+        m_Workers[i]->thread = std::thread(&TranscodeTaskPool::WorkerRoutine, this, i);
+} // TranscodeTaskPool::TranscodeTaskPool()
+
+TranscodeTaskPool::~TranscodeTaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto& worker : m_Workers)
+        worker->thread.join();
+} // TranscodeTaskPool::~TranscodeTaskPool()
+
+void TranscodeTaskPool::Submit(ThreadTranscodeContext* pContext, CompletionCallback onComplete) {
+    MSDK_CHECK_POINTER_NO_RET(pContext);
+
+    pContext->BeginTranscodeTask();
+    PushTask(m_NextWorker++ % (mfxU32)m_Workers.size(), Task{ pContext, std::move(onComplete) });
+} // void TranscodeTaskPool::Submit()
+
+bool TranscodeTaskPool::PopTask(mfxU32 idxWorker, Task& task) {
+    mfxU32 numWorkers = (mfxU32)m_Workers.size();
+
+    for (mfxU32 i = 0; i < numWorkers; i++) {
+        Worker& worker = *m_Workers[(idxWorker + i) % numWorkers];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty())
+                continue;
+
+            // own queue is served in order, others are stolen from the tail which they reach last
+            if (0 == i) {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+            else {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_NumQueued--;
+        return true;
+    }
+
+    return false;
+} // bool TranscodeTaskPool::PopTask()
+
+size_t TranscodeTaskPool::PushTask(mfxU32 idxWorker, Task&& task) {
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Workers[idxWorker]->mutex);
+        m_Workers[idxWorker]->tasks.push_back(std::move(task));
+        size = m_Workers[idxWorker]->tasks.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_NumQueued++;
+    }
+    m_cv.notify_one();
+
+    return size;
+} // size_t TranscodeTaskPool::PushTask()
+
+void TranscodeTaskPool::WorkerRoutine(mfxU32 idxWorker) {
+    size_t numBlocked = 0;
+
+    for (;;) {
+        Task task;
+        if (!PopTask(idxWorker, task)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] {
+                return m_bStop || m_NumQueued > 0;
+            });
+            if (m_bStop)
+                return;
+            continue;
+        }
+
+        if (task.pContext->pPipeline->IsStepBlocked()) {
+            // sleep only when the whole queue was found waiting
+            if (PushTask(idxWorker, std::move(task)) <= ++numBlocked) {
+                numBlocked = 0;
+                std::this_thread::sleep_for(TASK_POOL_BACKOFF);
+            }
+            continue;
+        }
+        numBlocked = 0;
+
+        bool bCompleted = true;
+        std::exception_ptr error;
+        try {
+            bCompleted = !task.pContext->TranscodeStep();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+
+        if (bCompleted)
+            task.onComplete(error);
+        else
+            PushTask(idxWorker, std::move(task));
+    }
+} // void TranscodeTaskPool::WorkerRoutine()
+
 FileBitstreamProcessor::FileBitstreamProcessor() {
     m_Bitstream.TimeStamp = (mfxU64)-1;
 }
@@ -4899,6 +5883,11 @@ mfxStatus FileBitstreamProcessor::ResetOutput() {
     return MFX_ERR_NONE;
 }
 
+void FileBitstreamProcessor::CloseOutput() {
+    if (m_pFileWriter.get())
+        m_pFileWriter->Close();
+}
+
 bool FileBitstreamProcessor::IsNulOutput() {
     return !m_pFileWriter.get();
 }
@@ -4959,6 +5948,10 @@ void CTranscodingPipeline::ModifyParamsUsingPresets(sInputParams& params,
 
     MODIFY_AND_PRINT_PARAM(params.nMaxFrameSize, MaxFrameSize, params.shouldPrintPresets);
     MODIFY_AND_PRINT_PARAM(params.nLADepth, LookAheadDepth, params.shouldPrintPresets);
+    MODIFY_AND_PRINT_PARAM_EXT(params.enableQSVFF,
+                               LowPower,
+                               presetParams.LowPower == MFX_CODINGOPTION_ON,
+                               params.shouldPrintPresets);
     if (params.shouldPrintPresets) {
         msdk_printf(MSDK_STRING("\n"));
     }
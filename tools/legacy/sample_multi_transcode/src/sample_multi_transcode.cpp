@@ -19,9 +19,12 @@
     #error MFX_VERSION not defined
 #endif
 
+#include <algorithm>
 #include <future>
 #include <iomanip>
+#include <iostream>
 #include <memory>
+#include <thread>
 
 using namespace std;
 using namespace TranscodingSample;
@@ -80,16 +83,33 @@ Launcher::Launcher()
         : m_parser(),
           m_pThreadContextArray(),
           m_pAllocArray(),
+          m_pSharedPoolAllocator(),
+          m_pSurfacePoolService(),
+          m_pSharedPoolAllocParams(NULL),
           m_InputParamsArray(),
           m_pBufferArray(),
+          m_pLaQPExchange(),
+          m_InitTasks(),
           m_pExtBSProcArray(),
           m_pAllocParams(),
+          m_hdls(),
           m_hwdevs(),
+          m_AdapterDevices(),
           m_StartTime(0),
           m_eDevType(static_cast<mfxHandleType>(0)),
           m_accelerationMode(MFX_ACCEL_MODE_NA),
           m_pLoader(),
+          m_MainThreadAffinity(),
+          m_pEventQueue(std::make_shared<SupervisorEventQueue>()),
+          m_bControlOpen(false),
+          m_nParSessions(0),
+          m_pTaskPool(),
+          m_MetricsLast(),
+          m_MetricsTime(),
+          m_EngineSampler(),
           m_VppDstRects(),
+          m_SegmentedOutputs(),
+          m_bSegmentedSessions(false),
           m_CSConfig(),
 #if (defined(_WIN32) || defined(_WIN64))
           m_Tracer(),
@@ -121,7 +141,6 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     mfxHDL hdl               = NULL;
     bool bNeedToCreateDevice = true;
 #endif
-    std::vector<mfxHDL> hdls;
     sInputParams InputParams;
     bool lowLatencyMode = true;
 
@@ -147,10 +166,25 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
     m_CSConfig.Tracer = &m_Tracer;
 
+    ShareDuplicateDecodes();
+
+    sts = SplitSegmentedSessions();
+    MSDK_CHECK_STATUS(sts, "SplitSegmentedSessions failed");
+
+    sts = LayOutCompositionGrid();
+    MSDK_CHECK_STATUS(sts, "LayOutCompositionGrid failed");
+
+    if (m_parser.IsMFEAutoEnabled())
+        GroupMFESessions();
+
     // check correctness of input parameters
     sts = VerifyCrossSessionsOptions();
     MSDK_CHECK_STATUS(sts, "VerifyCrossSessionsOptions failed");
 
+    std::ignore = msdk_thread_get_affinity(m_MainThreadAffinity);
+    for (i = 0; i < m_InputParamsArray.size(); i++)
+        ResolveSessionPlacement(i);
+
     if (InputParams.verSessionInit == API_1X) {
 #if (defined(_WIN32) || defined(_WIN64))
         // check available adapters
@@ -167,7 +201,9 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     else {
         m_pLoader.reset(new VPLImplementationLoader);
 
-        if (m_InputParamsArray[0].dispFullSearch == true)
+        // sharding needs all adapters enumerated, dispatcher's low-latency mode reports one
+        if (m_InputParamsArray[0].dispFullSearch == true || m_parser.IsAdapterShardingEnabled() ||
+            m_bSegmentedSessions)
             lowLatencyMode = false;
 
         // new memory models are suppotred in lib with version >2.0 and not supported SetHandle, so lowLatencyMode need to turn off
@@ -181,6 +217,20 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         m_pLoader->SetAdapterType(m_InputParamsArray[0].adapterType);
 
+        // the loader attaches the same mfxExtThreadsParam to all the sessions it creates
+        const sInputParams& first = m_InputParamsArray[0];
+        for (const auto& params : m_InputParamsArray) {
+            if (params.nThreadsNum != first.nThreadsNum ||
+                params.SchedulingType != first.SchedulingType ||
+                params.Priority != first.Priority) {
+                msdk_printf(MSDK_STRING(
+                    "warning: thread settings of the first session are used for all sessions\n"));
+                break;
+            }
+        }
+        sts = m_pLoader->ConfigureThreads(first.nThreadsNum, first.SchedulingType, first.Priority);
+        MSDK_CHECK_STATUS(sts, "ConfigureThreads failed");
+
 #ifdef ONEVPL_EXPERIMENTAL
         if (m_InputParamsArray[0].PCIDeviceSetup)
             m_pLoader->SetPCIDevice(m_InputParamsArray[0].PCIDomain,
@@ -201,6 +251,11 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                                                          m_accelerationMode,
                                                          lowLatencyMode);
         MSDK_CHECK_STATUS(sts, "EnumImplementations failed");
+
+        // segments of -segments sessions go to all the adapters
+        if (m_parser.IsAdapterShardingEnabled() ||
+            (m_bSegmentedSessions && m_pLoader->GetAdapterNumbers().size() > 1))
+            ShardSessionsAcrossAdapters();
     }
 
     for (i = 0; i < m_InputParamsArray.size(); i++) {
@@ -208,7 +263,17 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
          * In the case of a shared buffer, need to create device only for decode */
 #if defined(_WIN32) || defined(_WIN64) || defined(LIBVA_X11_SUPPORT) || \
     defined(LIBVA_DRM_SUPPORT) || defined(ANDROID)
-        if ((m_InputParamsArray[i].bIsJoin && i != 0) || m_InputParamsArray[i].eMode == Source)
+        // -mfe_auto groups may be on different adapters, the group members use device of the first
+        mfxI32 leader = m_InputParamsArray[i].MFEGroupLeader;
+        if (leader >= 0 && leader != (mfxI32)i && (size_t)leader < m_hdls.size()) {
+            m_pAllocParams.push_back(m_pAllocParams[leader]);
+            m_hdls.push_back(m_hdls[leader]);
+            continue;
+        }
+        if (leader == (mfxI32)i)
+            bNeedToCreateDevice = true;
+        else if ((m_InputParamsArray[i].bIsJoin && i != 0) ||
+                 m_InputParamsArray[i].eMode == Source)
             bNeedToCreateDevice = false;
 #endif
 
@@ -249,6 +314,8 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                               0,
                               MFX_IMPL_VIA_D3D9 | MFX_IMPL_BASETYPE(m_InputParamsArray[i].libType))
                         : MSDKAdapter::GetNumber(m_pLoader.get());
+                if (ShareAdapterDevice(adapterNum, false))
+                    continue;
 
                 /* The last param set in vector always describe VPP+ENCODE or Only VPP
                  * So, if we want to do rendering we need to do pass HWDev to CTranscodingPipeline */
@@ -267,14 +334,15 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                 // set Device Manager to external dx9 allocator
                 pD3DParams->pManager = (IDirect3DDeviceManager9*)hdl;
 
+                m_AdapterDevices[std::make_pair(adapterNum, false)] = m_hdls.size();
                 m_pAllocParams.push_back(pAllocParam);
                 m_hwdevs.push_back(std::move(hwdev));
-                hdls.push_back(hdl);
+                m_hdls.push_back(hdl);
             }
             else {
-                if (!m_pAllocParams.empty() && !hdls.empty()) {
+                if (!m_pAllocParams.empty() && !m_hdls.empty()) {
                     m_pAllocParams.push_back(m_pAllocParams.back());
-                    hdls.push_back(hdls.back());
+                    m_hdls.push_back(m_hdls.back());
                 }
                 else {
                     msdk_printf(MSDK_STRING("error: failed to initialize alloc parameters\n"));
@@ -296,6 +364,8 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                               0,
                               MFX_IMPL_VIA_D3D11 | MFX_IMPL_BASETYPE(m_InputParamsArray[i].libType))
                         : MSDKAdapter::GetNumber(m_pLoader.get());
+                if (ShareAdapterDevice(adapterNum, m_InputParamsArray[i].bSingleTexture))
+                    continue;
 
                 /* The last param set in vector always describe VPP+ENCODE or Only VPP
                  * So, if we want to do rendering we need to do pass HWDev to CTranscodingPipeline */
@@ -316,14 +386,16 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                 // set Device to external dx11 allocator
                 pD3D11Params->pDevice = (ID3D11Device*)hdl;
 
+                m_AdapterDevices[std::make_pair(adapterNum, pD3D11Params->bUseSingleTexture)] =
+                    m_hdls.size();
                 m_pAllocParams.push_back(pAllocParam);
                 m_hwdevs.push_back(std::move(hwdev));
-                hdls.push_back(hdl);
+                m_hdls.push_back(hdl);
             }
             else {
-                if (!m_pAllocParams.empty() && !hdls.empty()) {
+                if (!m_pAllocParams.empty() && !m_hdls.empty()) {
                     m_pAllocParams.push_back(m_pAllocParams.back());
-                    hdls.push_back(hdls.back());
+                    m_hdls.push_back(m_hdls.back());
                 }
                 else {
                     msdk_printf(MSDK_STRING("error: failed to initialize alloc parameters\n"));
@@ -335,6 +407,12 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 #elif defined(LIBVA_X11_SUPPORT) || defined(LIBVA_DRM_SUPPORT) || defined(ANDROID)
         if (m_eDevType == MFX_HANDLE_VA_DISPLAY) {
             if (bNeedToCreateDevice) {
+                mfxU32 adapterNum = (m_InputParamsArray[i].verSessionInit == API_1X)
+                                        ? MSDKAdapter::GetNumber(0, 0)
+                                        : MSDKAdapter::GetNumber(m_pLoader.get());
+                if (ShareAdapterDevice(adapterNum, false))
+                    continue;
+
                 mfxI32 libvaBackend = 0;
                 mfxAllocatorParams* pAllocParam(new vaapiAllocatorParams);
                 std::unique_ptr<CHWDevice> hwdev;
@@ -354,10 +432,6 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                         return MFX_ERR_DEVICE_FAILED;
                     }
 
-                    mfxU32 adapterNum = (m_InputParamsArray[i].verSessionInit == API_1X)
-                                            ? MSDKAdapter::GetNumber(0, 0)
-                                            : MSDKAdapter::GetNumber(m_pLoader.get());
-
                     sts = hwdev->Init(&params.monitorType, 1, adapterNum);
     #if defined(LIBVA_DRM_SUPPORT)
                     if (params.libvaBackend == MFX_LIBVA_DRM_MODESET) {
@@ -408,10 +482,6 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                         return MFX_ERR_DEVICE_FAILED;
                     }
 
-                    mfxU32 adapterNum = (m_InputParamsArray[i].verSessionInit == API_1X)
-                                            ? MSDKAdapter::GetNumber(0, 0)
-                                            : MSDKAdapter::GetNumber(m_pLoader.get());
-
                     sts = hwdev->Init(NULL, 0, adapterNum);
                 }
                 if (libvaBackend != MFX_LIBVA_WAYLAND) {
@@ -422,14 +492,15 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                     pVAAPIParams->m_dpy = (VADisplay)hdl;
                 }
 
+                m_AdapterDevices[std::make_pair(adapterNum, false)] = m_hdls.size();
                 m_pAllocParams.push_back(std::shared_ptr<mfxAllocatorParams>(pAllocParam));
                 m_hwdevs.push_back(std::move(hwdev));
-                hdls.push_back(hdl);
+                m_hdls.push_back(hdl);
             }
             else {
-                if (!m_pAllocParams.empty() && !hdls.empty()) {
+                if (!m_pAllocParams.empty() && !m_hdls.empty()) {
                     m_pAllocParams.push_back(m_pAllocParams.back());
-                    hdls.push_back(hdls.back());
+                    m_hdls.push_back(m_hdls.back());
                 }
                 else {
                     msdk_printf(MSDK_STRING("error: failed to initialize alloc parameters\n"));
@@ -441,11 +512,11 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     }
     if (m_pAllocParams.empty()) {
         m_pAllocParams.push_back(std::make_shared<mfxAllocatorParams>());
-        hdls.push_back(NULL);
+        m_hdls.push_back(NULL);
 
         for (i = 1; i < m_InputParamsArray.size(); i++) {
             m_pAllocParams.push_back(m_pAllocParams.back());
-            hdls.push_back(NULL);
+            m_hdls.push_back(NULL);
         }
     }
 
@@ -453,6 +524,9 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     sts = CreateSafetyBuffers();
     MSDK_CHECK_STATUS(sts, "CreateSafetyBuffers failed");
 
+    sts = CreateLaQPExchange();
+    MSDK_CHECK_STATUS(sts, "CreateLaQPExchange failed");
+
     /* One more hint. Example you have 3 dec + 1 enc sessions
     * (enc means vpp_comp call invoked. m_InputParamsArray.size() is 4.
     * You don't need take vpp comp params from last one session as it is enc session.
@@ -473,8 +547,14 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     // create sessions, allocators
     for (i = 0; i < m_InputParamsArray.size(); i++) {
         msdk_printf(MSDK_STRING("Session %d:\n"), (int)i);
+        // library threads inherit affinity of the main thread, buffers allocated here are touched by it
+        SetThreadPlacement(&m_InputParamsArray[i]);
+
         auto pAllocator = std::make_unique<GeneralAllocator>();
-        sts             = pAllocator->Init(m_pAllocParams[i].get());
+        pAllocator->SetNumaNode(m_InputParamsArray[i].NumaNode);
+        pAllocator->SetPooledSysMem(m_InputParamsArray[i].bSysMemPool);
+        pAllocator->SetLockTiming(m_InputParamsArray[i].bAllocStatistics);
+        sts = pAllocator->Init(m_pAllocParams[i].get());
         MSDK_CHECK_STATUS(sts, "pAllocator->Init failed");
 
         m_pAllocArray.push_back(std::move(pAllocator));
@@ -501,52 +581,8 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         pThreadPipeline->pBSProcessor = m_pExtBSProcArray.back().get();
 
-        std::unique_ptr<CSmplBitstreamReader> reader;
-        std::unique_ptr<CSmplYUVReader> yuvreader;
-        if (m_InputParamsArray[i].DecodeId == MFX_CODEC_VP9 ||
-            m_InputParamsArray[i].DecodeId == MFX_CODEC_VP8 ||
-            m_InputParamsArray[i].DecodeId == MFX_CODEC_AV1) {
-            reader.reset(new CIVFFrameReader());
-        }
-        else if (m_InputParamsArray[i].DecodeId == MFX_CODEC_RGB4 ||
-                 m_InputParamsArray[i].DecodeId == MFX_CODEC_I420 ||
-                 m_InputParamsArray[i].DecodeId == MFX_CODEC_NV12 ||
-                 m_InputParamsArray[i].DecodeId == MFX_CODEC_P010) {
-            // YUV reader for RGB4 overlay and raw input
-            yuvreader.reset(new CSmplYUVReader());
-        }
-        else {
-            reader.reset(new CSmplBitstreamReader());
-        }
-
-        if (reader.get()) {
-            sts = reader->Init(m_InputParamsArray[i].strSrcFile);
-            if (sts == MFX_ERR_UNSUPPORTED && m_InputParamsArray[i].DecodeId == MFX_CODEC_AV1) {
-                reader.reset(new CSmplBitstreamReader());
-                msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, default reader\n"));
-            }
-            MSDK_CHECK_STATUS(sts, "reader->Init failed");
-            sts = m_pExtBSProcArray.back()->SetReader(reader);
-            MSDK_CHECK_STATUS(sts, "m_pExtBSProcArray.back()->SetReader failed");
-        }
-        else if (yuvreader.get()) {
-            std::list<msdk_string> input;
-            input.push_back(m_InputParamsArray[i].strSrcFile);
-            sts = yuvreader->Init(input, m_InputParamsArray[i].DecodeId);
-            MSDK_CHECK_STATUS(sts, "m_YUVReader->Init failed");
-            sts = m_pExtBSProcArray.back()->SetReader(yuvreader);
-            MSDK_CHECK_STATUS(sts, "m_pExtBSProcArray.back()->SetReader failed");
-        }
-
-        if (msdk_strncmp(MSDK_STRING("null"),
-                         m_InputParamsArray[i].strDstFile,
-                         msdk_strlen(MSDK_STRING("null")))) {
-            auto writer = std::make_unique<CSmplBitstreamWriter>();
-            sts         = writer->Init(m_InputParamsArray[i].strDstFile);
-
-            sts = m_pExtBSProcArray.back()->SetWriter(writer);
-            MSDK_CHECK_STATUS(sts, "m_pExtBSProcArray.back()->SetWriter failed");
-        }
+        sts = InitBitstreamProcessor(m_pExtBSProcArray.back().get(), m_InputParamsArray[i]);
+        MSDK_CHECK_STATUS(sts, "InitBitstreamProcessor failed");
 
         if (Sink == m_InputParamsArray[i].eMode) {
             /* N_to_1 mode */
@@ -588,6 +624,9 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
         sts = MFX_ERR_MORE_DATA;
 
         auto pipeline = Source == m_InputParamsArray[i].eMode ? pSinkPipeline : pParentPipeline;
+        mfxI32 leader = m_InputParamsArray[i].MFEGroupLeader;
+        if (leader >= 0)
+            pipeline = leader == (mfxI32)i ? NULL : m_pThreadContextArray[leader]->pPipeline.get();
         if (m_InputParamsArray[i].verSessionInit == API_1X) {
 #if (defined(_WIN32) || defined(_WIN64))
             sts = CheckAndFixAdapterDependency_1X(i, pipeline);
@@ -604,6 +643,10 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
             if ((sts == MFX_WRN_VIDEO_PARAM_CHANGED || m_InputParamsArray[i].dGfxIdx >= 0 ||
                  m_InputParamsArray[i].adapterNum >= 0) &&
                 (m_InputParamsArray[i].libType != MFX_IMPL_SOFTWARE)) {
+                // sessions being initialized create their library sessions from the loader
+                sts = WaitPipelineInits();
+                MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->Init failed");
+
                 if (m_InputParamsArray[i].dGfxIdx >= 0)
                     m_pLoader->SetDiscreteAdapterIndex(m_InputParamsArray[i].dGfxIdx);
                 else
@@ -618,26 +661,74 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
                 MSDK_CHECK_STATUS(sts, "ConfigureAndEnumImplementations failed");
             }
         }
-        sts = pThreadPipeline->pPipeline->Init(&m_InputParamsArray[i],
-                                               m_pAllocArray[i].get(),
-                                               hdls[i],
-                                               pipeline,
-                                               pBuffer,
-                                               m_pExtBSProcArray.back().get(),
-                                               m_pLoader.get(),
-                                               CreateCascadeScalerConfig());
-
-        MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->Init failed");
-
-        if (!pParentPipeline && m_InputParamsArray[i].bIsJoin)
-            pParentPipeline = pThreadPipeline->pPipeline.get();
+        GeneralAllocator* pSessionAllocator = m_pAllocArray[i].get();
+        if (m_InputParamsArray[i].bSharedSurfacePool) {
+            sts = GetSharedPoolAllocator(m_InputParamsArray[i],
+                                         m_pAllocParams[i].get(),
+                                         &pSessionAllocator);
+            MSDK_CHECK_STATUS(sts, "GetSharedPoolAllocator failed");
+            pThreadPipeline->pPipeline->SetSurfacePoolService(m_pSurfacePoolService.get());
+        }
+        if (m_InputParamsArray[i].bLaShare)
+            pThreadPipeline->pPipeline->SetLaQPExchange(m_pLaQPExchange.get());
+        if (m_InputParamsArray[i].bDecSkip && Sink == m_InputParamsArray[i].eMode)
+            pThreadPipeline->pPipeline->SetDecodeSkipFramerate(GetDecodeSkipFramerate());
+        // decoders of the -vpp_comp_dirty composition need a surface for its last frame
+        if (Sink == m_InputParamsArray[i].eMode &&
+            (VppComp == m_InputParamsArray[i].eModeExt ||
+             VppCompOnly == m_InputParamsArray[i].eModeExt))
+            m_InputParamsArray[i].bVppCompDirty = m_InputParamsArray.back().bVppCompDirty;
+
+        CTranscodingPipeline* pSessionPipeline = pThreadPipeline->pPipeline.get();
+        FileBitstreamProcessor* pBSProcessor   = m_pExtBSProcArray.back().get();
+        CascadeScalerConfig& scalerConfig      = CreateCascadeScalerConfig();
 
         // set the session's start status (like it is waiting)
         pThreadPipeline->startStatus = MFX_WRN_DEVICE_BUSY;
         // set other session's parameters
-        pThreadPipeline->implType = m_InputParamsArray[i].libType;
+        pThreadPipeline->cpuAffinity = m_InputParamsArray[i].CpuAffinity;
+        pThreadPipeline->numaNode    = m_InputParamsArray[i].NumaNode;
         m_pThreadContextArray.push_back(std::move(pThreadPipeline));
 
+        // sessions which don't use other sessions are initialized concurrently
+        if (m_parser.GetInitThreads() > 1 && Native == m_InputParamsArray[i].eMode &&
+            !m_InputParamsArray[i].bIsJoin && !m_InputParamsArray[i].bSharedSurfacePool) {
+            sts = SubmitPipelineInit([=, &scalerConfig]() {
+                SetThreadPlacement(&m_InputParamsArray[i]);
+                return pSessionPipeline->Init(&m_InputParamsArray[i],
+                                              pSessionAllocator,
+                                              m_hdls[i],
+                                              NULL,
+                                              NULL,
+                                              pBSProcessor,
+                                              m_pLoader.get(),
+                                              scalerConfig);
+            });
+        }
+        else {
+            sts = pSessionPipeline->Init(&m_InputParamsArray[i],
+                                         pSessionAllocator,
+                                         m_hdls[i],
+                                         pipeline,
+                                         pBuffer,
+                                         pBSProcessor,
+                                         m_pLoader.get(),
+                                         scalerConfig);
+        }
+        MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->Init failed");
+
+        if (!pParentPipeline && m_InputParamsArray[i].bIsJoin &&
+            m_InputParamsArray[i].MFEGroupLeader < 0)
+            pParentPipeline = pSessionPipeline;
+    }
+
+    sts = WaitPipelineInits();
+    MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->Init failed");
+
+    for (i = 0; i < m_InputParamsArray.size(); i++) {
+        // implementation is known once the session is created
+        m_pThreadContextArray[i]->implType = m_InputParamsArray[i].libType;
+
         mfxVersion ver = { { 0, 0 } };
         sts            = m_pThreadContextArray[i]->pPipeline->QueryMFXVersion(&ver);
         MSDK_CHECK_STATUS(sts, "m_pThreadContextArray[i]->pPipeline->QueryMFXVersion failed");
@@ -646,6 +737,7 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
     }
 
     for (i = 0; i < m_InputParamsArray.size(); i++) {
+        SetThreadPlacement(&m_InputParamsArray[i]);
         sts = m_pThreadContextArray[i]->pPipeline->CompleteInit();
         MSDK_CHECK_STATUS(sts, "m_pThreadContextArray[i]->pPipeline->CompleteInit failed");
 
@@ -656,6 +748,8 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 
         m_pThreadContextArray[i]->pPipeline->SetPipelineID(i);
     }
+    SetThreadPlacement(NULL);
+    m_nParSessions = (mfxU32)m_InputParamsArray.size();
 
     if (m_InputParamsArray[0].forceSyncAllSession == MFX_CODINGOPTION_ON) {
         auto it = std::max_element(std::begin(m_pThreadContextArray),
@@ -683,110 +777,201 @@ mfxStatus Launcher::Init(int argc, msdk_char* argv[]) {
 void Launcher::Run() {
     msdk_printf(MSDK_STRING("Transcoding started\n"));
 
+    if (m_parser.GetTaskPoolThreads()) {
+        msdk_printf(MSDK_STRING("Task pool of %d threads is used\n"),
+                    (int)m_parser.GetTaskPoolThreads());
+        m_pTaskPool.reset(new TranscodeTaskPool(m_parser.GetTaskPoolThreads()));
+    }
+
+    if (!m_parser.GetMetricsFile().empty()) {
+        for (const auto& context : m_pThreadContextArray)
+            context->pPipeline->EnableCounters();
+        m_MetricsTime = std::chrono::steady_clock::now();
+    }
+
+    if (m_parser.IsEngineUtilizationEnabled())
+        m_EngineSampler.Start();
+
     // mark start time
     m_StartTime = GetTick();
 
     // Robust flag is applied to every seession if enabled in one
     if (m_pThreadContextArray[0]->pPipeline->GetRobustFlag()) {
+        if (m_parser.IsControlStdinEnabled())
+            msdk_printf(MSDK_STRING("[WARNING] Control channel is ignored in robust mode\n"));
         DoRobustTranscoding();
     }
+    else if (m_parser.IsControlStdinEnabled()) {
+        StartControlChannel();
+        DoTranscoding();
+    }
     else {
         DoTranscoding();
     }
 
+    // all sessions are completed, workers are joined
+    m_pTaskPool.reset();
+    m_EngineSampler.Stop();
+
+    if (!m_parser.GetMetricsFile().empty())
+        WriteMetrics();
+
     msdk_printf(MSDK_STRING("\nTranscoding finished\n"));
 
 } // mfxStatus Launcher::Init()
 
-void Launcher::DoTranscoding() {
-    auto RunTranscodeRoutine = [](ThreadTranscodeContext* context) {
-        context->handle = std::async(std::launch::async, [context]() {
-            context->TranscodeRoutine();
+void Launcher::RunTranscodeRoutine(size_t idxSession) {
+    ThreadTranscodeContext* context             = m_pThreadContextArray[idxSession].get();
+    std::shared_ptr<SupervisorEventQueue> queue = m_pEventQueue;
+
+    if (m_pTaskPool && context->pPipeline->IsStepRunSupported()) {
+        auto pDone      = std::make_shared<std::promise<void>>();
+        context->handle = pDone->get_future();
+        m_pTaskPool->Submit(context, [pDone, queue, idxSession](std::exception_ptr error) {
+            if (error)
+                pDone->set_exception(error);
+            else
+                pDone->set_value();
+            queue->Push(SupervisorEvent(SupervisorEvent::SESSION_COMPLETED, idxSession));
         });
+        return;
+    }
+
+    // completion is reported even if the routine throws, otherwise supervisor would wait forever
+    context->handle = std::async(std::launch::async, [context, queue, idxSession]() {
+        try {
+            context->TranscodeRoutine();
+        }
+        catch (...) {
+            queue->Push(SupervisorEvent(SupervisorEvent::SESSION_COMPLETED, idxSession));
+            throw;
+        }
+        queue->Push(SupervisorEvent(SupervisorEvent::SESSION_COMPLETED, idxSession));
+    });
+} // void Launcher::RunTranscodeRoutine()
+
+void Launcher::DoTranscoding() {
+    auto HasAliveNonOverlaySessions = [this]() {
+        for (const auto& context : m_pThreadContextArray) {
+            if (context->handle.valid() && !context->pPipeline->IsOverlayUsed())
+                return true;
+        }
+        return false;
     };
 
+    // overlay sessions of the previous run may have reported completion
+    m_pEventQueue->ClearCompletions();
+
     bool isOverlayUsed = false;
-    for (const auto& context : m_pThreadContextArray) {
+    for (size_t i = 0; i < m_pThreadContextArray.size(); ++i) {
+        const auto& context = m_pThreadContextArray[i];
         MSDK_CHECK_POINTER_NO_RET(context);
-        RunTranscodeRoutine(context.get());
+        RunTranscodeRoutine(i);
 
         MSDK_CHECK_POINTER_NO_RET(context->pPipeline);
         isOverlayUsed = isOverlayUsed || context->pPipeline->IsOverlayUsed();
     }
 
-    // Transcoding threads waiting cycle
-    bool aliveNonOverlaySessions = true;
-    while (aliveNonOverlaySessions) {
-        aliveNonOverlaySessions = false;
-
-        for (size_t i = 0; i < m_pThreadContextArray.size(); ++i) {
-            if (!m_pThreadContextArray[i]->handle.valid())
-                continue;
+    const std::chrono::seconds latencyInterval(m_parser.GetLatencyStatInterval());
+    const std::chrono::seconds metricsInterval(m_parser.GetMetricsFile().empty() ? 0 : 1);
+    auto nextLatencyReport = std::chrono::steady_clock::now() + latencyInterval;
+    auto nextMetricsUpdate = std::chrono::steady_clock::now() + metricsInterval;
+
+    // Transcoding threads waiting cycle: sessions are handled in order of their completion
+    // Control channel keeps the cycle running until it's closed
+    while (HasAliveNonOverlaySessions() || m_bControlOpen) {
+        SupervisorEvent event(SupervisorEvent::TIMEOUT);
+        if (latencyInterval.count() && metricsInterval.count())
+            event = m_pEventQueue->Pop(std::min(nextLatencyReport, nextMetricsUpdate));
+        else if (latencyInterval.count())
+            event = m_pEventQueue->Pop(nextLatencyReport);
+        else if (metricsInterval.count())
+            event = m_pEventQueue->Pop(nextMetricsUpdate);
+        else
+            event = m_pEventQueue->Pop();
 
-            //Payslip interval to check the state of working threads:
-            //such interval is usually a realtime, i.e. for 30 fps this would be 33ms,
-            //66ms typically mean either 1/fps or 2/fps payslip checks.
-            auto waitSts = m_pThreadContextArray[i]->handle.wait_for(std::chrono::milliseconds(66));
-            if (waitSts == std::future_status::ready) {
-                // Invoke get() of the handle just to reset the valid state.
-                // This allows to skip already processed sessions
-                m_pThreadContextArray[i]->handle.get();
-
-                // Session is completed, let's check for its status
-                if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
-                    // Stop all the sessions if an error happened in one
-                    // But do not stop in robust mode when gpu hang's happened
-                    if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
-                        !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
-                        msdk_stringstream ss;
-                        ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                           << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                           << MSDK_STRING("] failed with status ")
-                           << StatusToString(m_pThreadContextArray[i]->transcodingSts)
-                           << MSDK_STRING(" shutting down the application...") << std::endl
-                           << std::endl;
-                        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-
-                        for (const auto& context : m_pThreadContextArray) {
-                            context->pPipeline->StopSession();
-                        }
-                    }
-                }
-                else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
-                    msdk_stringstream ss;
-                    ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
-                       << m_pThreadContextArray[i]->pPipeline->GetSessionText()
-                       << MSDK_STRING("] returned warning status ")
-                       << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
-                       << std::endl;
-                    msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
-                }
+        if (SupervisorEvent::TIMEOUT == event.type) {
+            auto now = std::chrono::steady_clock::now();
+            if (latencyInterval.count() && now >= nextLatencyReport) {
+                PrintLatencyStatistics(false);
+                nextLatencyReport += latencyInterval;
             }
-            else {
-                aliveNonOverlaySessions = aliveNonOverlaySessions ||
-                                          !m_pThreadContextArray[i]->pPipeline->IsOverlayUsed();
+            if (metricsInterval.count() && now >= nextMetricsUpdate) {
+                WriteMetrics();
+                nextMetricsUpdate += metricsInterval;
             }
+            continue;
         }
+        else if (SupervisorEvent::CONTROL_CLOSED == event.type) {
+            m_bControlOpen = false;
+            continue;
+        }
+        else if (SupervisorEvent::CONTROL_COMMAND == event.type) {
+            if (m_bControlOpen)
+                ProcessControlCommand(event.command);
+            continue;
+        }
+
+        size_t i = event.id;
+
+        // Invoke get() of the handle just to reset the valid state.
+        // This allows to skip already processed sessions
+        m_pThreadContextArray[i]->handle.get();
 
-        // Stop overlay sessions
-        // Note: Overlay sessions never stop themselves so they should be forcibly stopped
-        // after stopping of all non-overlay sessions
-        if (!aliveNonOverlaySessions && isOverlayUsed) {
-            // Sending stop message
-            for (const auto& context : m_pThreadContextArray) {
-                if (context->pPipeline->IsOverlayUsed()) {
+        // Session is completed, let's check for its status
+        if (i >= m_nParSessions) {
+            // Failure of the added session doesn't affect others
+            ReleaseAddedSession(i);
+        }
+        else if (m_pThreadContextArray[i]->transcodingSts < MFX_ERR_NONE) {
+            // Stop all the sessions if an error happened in one
+            // But do not stop in robust mode when gpu hang's happened
+            if (m_pThreadContextArray[i]->transcodingSts != MFX_ERR_GPU_HANG ||
+                !m_pThreadContextArray[i]->pPipeline->GetRobustFlag()) {
+                msdk_stringstream ss;
+                ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+                   << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+                   << MSDK_STRING("] failed with status ")
+                   << StatusToString(m_pThreadContextArray[i]->transcodingSts)
+                   << MSDK_STRING(" shutting down the application...") << std::endl
+                   << std::endl;
+                msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+
+                for (const auto& context : m_pThreadContextArray) {
                     context->pPipeline->StopSession();
                 }
+                m_bControlOpen = false;
             }
+        }
+        else if (m_pThreadContextArray[i]->transcodingSts > MFX_ERR_NONE) {
+            msdk_stringstream ss;
+            ss << MSDK_STRING("\n\n session ") << i << MSDK_STRING(" [")
+               << m_pThreadContextArray[i]->pPipeline->GetSessionText()
+               << MSDK_STRING("] returned warning status ")
+               << StatusToString(m_pThreadContextArray[i]->transcodingSts) << std::endl
+               << std::endl;
+            msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+        }
+    }
 
-            // Waiting for them to be stopped
-            for (const auto& context : m_pThreadContextArray) {
-                if (!context->handle.valid())
-                    continue;
-
-                context->handle.wait();
+    // Stop overlay sessions
+    // Note: Overlay sessions never stop themselves so they should be forcibly stopped
+    // after stopping of all non-overlay sessions
+    if (isOverlayUsed) {
+        // Sending stop message
+        for (const auto& context : m_pThreadContextArray) {
+            if (context->pPipeline->IsOverlayUsed()) {
+                context->pPipeline->StopSession();
             }
         }
+
+        // Waiting for them to be stopped
+        for (const auto& context : m_pThreadContextArray) {
+            if (!context->handle.valid())
+                continue;
+
+            context->handle.wait();
+        }
     }
 }
 
@@ -828,6 +1013,410 @@ void Launcher::DoRobustTranscoding() {
     }
 }
 
+void Launcher::PrintLatencyStatistics(bool bTotal) {
+    for (size_t i = 0; i < m_pThreadContextArray.size(); i++) {
+        CLatencyHistogram& histogram = m_pThreadContextArray[i]->pPipeline->GetLatencyHistogram();
+        CLatencyHistogram::Summary summary = bTotal ? histogram.GetTotal() : histogram.Collect();
+        if (!summary.Count)
+            continue;
+
+        msdk_stringstream ss;
+        ss << MSDK_STRING("latency") << (bTotal ? MSDK_STRING("[total]") : MSDK_STRING(""))
+           << MSDK_STRING(" session ") << i << MSDK_STRING(": frames=") << summary.Count
+           << std::fixed << std::setprecision(3) << MSDK_STRING(" p50=") << summary.P50 / 1000.0
+           << MSDK_STRING(" p90=") << summary.P90 / 1000.0 << MSDK_STRING(" p99=")
+           << summary.P99 / 1000.0 << MSDK_STRING(" max=") << summary.Max / 1000.0
+           << MSDK_STRING(" ms") << std::endl;
+        msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+    }
+} // void Launcher::PrintLatencyStatistics()
+
+void Launcher::WriteMetrics() {
+    auto now      = std::chrono::steady_clock::now();
+    mfxF64 period = std::chrono::duration<mfxF64>(now - m_MetricsTime).count();
+    m_MetricsTime = now;
+    m_MetricsLast.resize(m_pThreadContextArray.size());
+
+    msdk_stringstream ss;
+    ss << std::setprecision(15);
+
+    auto header = [&ss](const msdk_char* name, const msdk_char* type, const msdk_char* help) {
+        ss << MSDK_STRING("# HELP ") << name << MSDK_STRING(" ") << help << std::endl
+           << MSDK_STRING("# TYPE ") << name << MSDK_STRING(" ") << type << std::endl;
+    };
+    // negative values are unknown and skipped
+    auto samples = [this, &ss](const msdk_char* name,
+                               const msdk_char* label,
+                               std::function<mfxF64(const PipelineCounters&, size_t)> value) {
+        for (size_t i = 0; i < m_pThreadContextArray.size(); i++) {
+            mfxF64 v = value(m_pThreadContextArray[i]->pPipeline->GetCounters(), i);
+            if (v < 0)
+                continue;
+            ss << name << MSDK_STRING("{session=\"") << i << MSDK_STRING("\"") << label
+               << MSDK_STRING("} ") << v << std::endl;
+        }
+    };
+
+    std::vector<mfxF64> fps(m_pThreadContextArray.size());
+    std::vector<mfxF64> bitrate(m_pThreadContextArray.size());
+    for (size_t i = 0; i < m_pThreadContextArray.size(); i++) {
+        const PipelineCounters& counters = m_pThreadContextArray[i]->pPipeline->GetCounters();
+        std::pair<mfxU64, mfxU64> current(counters.OutputFrames.load(std::memory_order_relaxed),
+                                          counters.OutputBytes.load(std::memory_order_relaxed));
+        if (period > 0) {
+            fps[i]     = (current.first - m_MetricsLast[i].first) / period;
+            bitrate[i] = (current.second - m_MetricsLast[i].second) * 8 / period;
+        }
+        m_MetricsLast[i] = current;
+    }
+
+    header(MSDK_STRING("smt_output_frames_total"),
+           MSDK_STRING("counter"),
+           MSDK_STRING("Frames written to the output of the session."));
+    samples(MSDK_STRING("smt_output_frames_total"),
+            MSDK_STRING(""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.OutputFrames.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_output_bytes_total"),
+           MSDK_STRING("counter"),
+           MSDK_STRING("Bytes written to the output of the session."));
+    samples(MSDK_STRING("smt_output_bytes_total"),
+            MSDK_STRING(""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.OutputBytes.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_fps"),
+           MSDK_STRING("gauge"),
+           MSDK_STRING("Output frame rate since the previous update."));
+    samples(MSDK_STRING("smt_fps"), MSDK_STRING(""), [&fps](const PipelineCounters&, size_t i) {
+        return fps[i];
+    });
+    header(MSDK_STRING("smt_bitrate_bits_per_second"),
+           MSDK_STRING("gauge"),
+           MSDK_STRING("Output bitrate since the previous update."));
+    samples(MSDK_STRING("smt_bitrate_bits_per_second"),
+            MSDK_STRING(""),
+            [&bitrate](const PipelineCounters&, size_t i) {
+                return bitrate[i];
+            });
+    header(MSDK_STRING("smt_frames_in_flight"),
+           MSDK_STRING("gauge"),
+           MSDK_STRING("Frames submitted to the encoder and not written yet."));
+    samples(MSDK_STRING("smt_frames_in_flight"),
+            MSDK_STRING(""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.FramesInFlight.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_async_depth"),
+           MSDK_STRING("gauge"),
+           MSDK_STRING("Encoded frames kept in flight before the oldest one is synced."));
+    samples(MSDK_STRING("smt_async_depth"),
+            MSDK_STRING(""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.AsyncDepth.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_free_surfaces"),
+           MSDK_STRING("gauge"),
+           MSDK_STRING("Free surfaces seen by the last search in the pool."));
+    samples(MSDK_STRING("smt_free_surfaces"),
+            MSDK_STRING(",pool=\"dec\""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.FreeDecSurfaces.load(std::memory_order_relaxed);
+            });
+    samples(MSDK_STRING("smt_free_surfaces"),
+            MSDK_STRING(",pool=\"enc\""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.FreeEncSurfaces.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_device_busy_retries_total"),
+           MSDK_STRING("counter"),
+           MSDK_STRING("Calls repeated because the component returned MFX_WRN_DEVICE_BUSY."));
+    samples(MSDK_STRING("smt_device_busy_retries_total"),
+            MSDK_STRING(",component=\"dec\""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.DecBusy.load(std::memory_order_relaxed);
+            });
+    samples(MSDK_STRING("smt_device_busy_retries_total"),
+            MSDK_STRING(",component=\"vpp\""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.VppBusy.load(std::memory_order_relaxed);
+            });
+    samples(MSDK_STRING("smt_device_busy_retries_total"),
+            MSDK_STRING(",component=\"enc\""),
+            [](const PipelineCounters& c, size_t) {
+                return (mfxF64)c.EncBusy.load(std::memory_order_relaxed);
+            });
+    header(MSDK_STRING("smt_sync_wait_seconds_total"),
+           MSDK_STRING("counter"),
+           MSDK_STRING("Time spent waiting for encoded frames."));
+    samples(MSDK_STRING("smt_sync_wait_seconds_total"),
+            MSDK_STRING(""),
+            [](const PipelineCounters& c, size_t) {
+                return c.SyncWaitUs.load(std::memory_order_relaxed) / 1000000.0;
+            });
+
+    EngineUtilization engines = m_EngineSampler.GetLast();
+    if (engines.NumPeriods) {
+        header(MSDK_STRING("smt_engine_busy_percent"),
+               MSDK_STRING("gauge"),
+               MSDK_STRING("Busy time of the GPU engine in the last sampling period."));
+        std::pair<const msdk_char*, mfxF64> busy[] = { { MSDK_STRING("rcs"), engines.Render },
+                                                       { MSDK_STRING("vdbox"), engines.Video },
+                                                       { MSDK_STRING("vdbox2"), engines.Video2 },
+                                                       { MSDK_STRING("vebox"),
+                                                         engines.VideoEnhance } };
+        for (const auto& engine : busy) {
+            if (engine.second >= 0)
+                ss << MSDK_STRING("smt_engine_busy_percent{engine=\"") << engine.first
+                   << MSDK_STRING("\"} ") << engine.second << std::endl;
+        }
+        if (engines.Frequency >= 0) {
+            header(MSDK_STRING("smt_gt_frequency_mhz"),
+                   MSDK_STRING("gauge"),
+                   MSDK_STRING("Average GT frequency in the last sampling period."));
+            ss << MSDK_STRING("smt_gt_frequency_mhz ") << engines.Frequency << std::endl;
+        }
+    }
+
+    // the file is written aside and renamed, so readers never see it partially written
+    msdk_string file    = m_parser.GetMetricsFile();
+    msdk_string tmpFile = file + MSDK_STRING(".tmp");
+    FILE* pFile         = NULL;
+    MSDK_FOPEN(pFile, tmpFile.c_str(), MSDK_STRING("w"));
+    if (!pFile) {
+        msdk_printf(MSDK_STRING("error: metrics file \"%s\" can't be written\n"), tmpFile.c_str());
+        return;
+    }
+    msdk_fprintf(pFile, MSDK_STRING("%s"), ss.str().c_str());
+    fclose(pFile);
+#if (defined(_WIN32) || defined(_WIN64))
+    MoveFileEx(tmpFile.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+    rename(tmpFile.c_str(), file.c_str());
+#endif
+} // void Launcher::WriteMetrics()
+
+void Launcher::StartControlChannel() {
+    m_bControlOpen = true;
+
+    // reading of stdin can't be interrupted, so thread is detached and keeps the queue alive
+    std::thread([queue = m_pEventQueue]() {
+        msdk_string line;
+        while (std::getline(msdk_cin, line))
+            queue->Push(SupervisorEvent(SupervisorEvent::CONTROL_COMMAND, 0, line));
+        queue->Push(SupervisorEvent(SupervisorEvent::CONTROL_CLOSED));
+    }).detach();
+} // void Launcher::StartControlChannel()
+
+void Launcher::ProcessControlCommand(const msdk_string& command) {
+    msdk_stringstream ss(command);
+    msdk_string name;
+    ss >> name;
+
+    if (name.empty()) {
+        return;
+    }
+    else if (name == MSDK_STRING("add")) {
+        msdk_string options;
+        std::getline(ss, options);
+
+        mfxStatus sts = AddSession(options);
+        if (sts != MFX_ERR_NONE) {
+            msdk_stringstream err;
+            err << MSDK_STRING("error: session wasn't added, status ") << StatusToString(sts)
+                << std::endl;
+            msdk_printf(MSDK_STRING("%s"), err.str().c_str());
+        }
+    }
+    else if (name == MSDK_STRING("stop")) {
+        size_t i = 0;
+        if (!(ss >> i) || i >= m_pThreadContextArray.size()) {
+            msdk_printf(MSDK_STRING("error: invalid session number in \"%s\"\n"), command.c_str());
+        }
+        else if (!m_pThreadContextArray[i]->handle.valid()) {
+            msdk_printf(MSDK_STRING("error: session %d is not running\n"), (int)i);
+        }
+        else {
+            msdk_printf(MSDK_STRING("Stopping session %d\n"), (int)i);
+            m_pThreadContextArray[i]->pPipeline->StopSession();
+        }
+    }
+    else if (name == MSDK_STRING("list")) {
+        for (size_t i = 0; i < m_pThreadContextArray.size(); i++) {
+            msdk_printf(MSDK_STRING("Session %d %s: %s\n"),
+                        (int)i,
+                        m_pThreadContextArray[i]->handle.valid() ? MSDK_STRING("running")
+                                                                 : MSDK_STRING("completed"),
+                        m_parser.GetLine((mfxU32)i).c_str());
+        }
+    }
+    else if (name == MSDK_STRING("quit")) {
+        msdk_printf(MSDK_STRING("Control channel is closed, waiting for sessions to complete\n"));
+        m_bControlOpen = false;
+    }
+    else {
+        msdk_printf(MSDK_STRING("error: unknown control command \"%s\"\n"), name.c_str());
+    }
+} // void Launcher::ProcessControlCommand()
+
+mfxStatus Launcher::AddSession(const msdk_string& line) {
+    sInputParams params;
+    mfxStatus sts = m_parser.ParseSessionLine(line, params);
+    MSDK_CHECK_STATUS(sts, "m_parser.ParseSessionLine failed");
+
+    // added session works on its own, device and loader of session 0 are reused
+    if (Native != params.eMode || Native != params.eModeExt || params.bIsJoin ||
+        MFX_CODEC_RGB4 == params.DecodeId || API_1X == params.verSessionInit || !m_pLoader ||
+        params.libType != m_InputParamsArray[0].libType) {
+        msdk_printf(MSDK_STRING(
+            "error: only not joined 2.x API sessions without shared buffers and with implementation of session 0 can be added\n"));
+        m_parser.RemoveLastSession();
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxU32 i        = (mfxU32)m_InputParamsArray.size();
+    params.TargetID = m_InputParamsArray.back().TargetID + 1;
+    m_InputParamsArray.push_back(params);
+    ResolveSessionPlacement(i);
+
+    msdk_printf(MSDK_STRING("Session %d:\n"), (int)i);
+    SetThreadPlacement(&m_InputParamsArray[i]);
+    sts = CreateAddedSession(i);
+    SetThreadPlacement(NULL);
+
+    if (sts != MFX_ERR_NONE) {
+        m_InputParamsArray.pop_back();
+        m_parser.RemoveLastSession();
+        return sts;
+    }
+
+    RunTranscodeRoutine(i);
+    msdk_printf(MSDK_STRING("Session %d was added\n"), (int)i);
+
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::AddSession()
+
+mfxStatus Launcher::CreateAddedSession(mfxU32 idxSession) {
+    sInputParams& params = m_InputParamsArray[idxSession];
+
+    // objects are moved to the launcher arrays only if initialization succeeds
+    auto pAllocator = std::make_unique<GeneralAllocator>();
+    pAllocator->SetNumaNode(params.NumaNode);
+    pAllocator->SetPooledSysMem(params.bSysMemPool);
+    pAllocator->SetLockTiming(params.bAllocStatistics);
+    mfxStatus sts = pAllocator->Init(m_pAllocParams[0].get());
+    MSDK_CHECK_STATUS(sts, "pAllocator->Init failed");
+
+    auto pBSProcessor = std::make_unique<FileBitstreamProcessor>();
+    sts               = InitBitstreamProcessor(pBSProcessor.get(), params);
+    MSDK_CHECK_STATUS(sts, "InitBitstreamProcessor failed");
+
+    auto pThreadPipeline = std::make_unique<ThreadTranscodeContext>();
+    pThreadPipeline->pPipeline.reset(CreatePipeline());
+    pThreadPipeline->pPipeline->SetAdapterType(m_pLoader->GetAdapterType());
+    pThreadPipeline->pPipeline->SetPrefferdGfx(params.dGfxIdx);
+    pThreadPipeline->pPipeline->SetAdapterNum(m_pLoader->GetDeviceIDAndAdapter().second);
+    pThreadPipeline->pPipeline->SetSyncOpTimeout(params.nSyncOpTimeout);
+    if (!m_parser.GetMetricsFile().empty())
+        pThreadPipeline->pPipeline->EnableCounters();
+    pThreadPipeline->pBSProcessor = pBSProcessor.get();
+
+    GeneralAllocator* pSessionAllocator = pAllocator.get();
+    if (params.bSharedSurfacePool) {
+        sts = GetSharedPoolAllocator(params, m_pAllocParams[0].get(), &pSessionAllocator);
+        MSDK_CHECK_STATUS(sts, "GetSharedPoolAllocator failed");
+        pThreadPipeline->pPipeline->SetSurfacePoolService(m_pSurfacePoolService.get());
+    }
+    sts = pThreadPipeline->pPipeline->Init(&params,
+                                           pSessionAllocator,
+                                           m_hdls[0],
+                                           NULL,
+                                           NULL,
+                                           pBSProcessor.get(),
+                                           m_pLoader.get(),
+                                           CreateCascadeScalerConfig());
+    MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->Init failed");
+
+    sts = pThreadPipeline->pPipeline->CompleteInit();
+    MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->CompleteInit failed");
+    pThreadPipeline->pPipeline->SetPipelineID(idxSession);
+
+    mfxVersion ver = { { 0, 0 } };
+    sts            = pThreadPipeline->pPipeline->QueryMFXVersion(&ver);
+    MSDK_CHECK_STATUS(sts, "pThreadPipeline->pPipeline->QueryMFXVersion failed");
+    PrintInfo(idxSession, &params, &ver);
+
+    pThreadPipeline->startStatus = MFX_WRN_DEVICE_BUSY;
+    pThreadPipeline->implType    = params.libType;
+    pThreadPipeline->cpuAffinity = params.CpuAffinity;
+    pThreadPipeline->numaNode    = params.NumaNode;
+
+    m_pAllocArray.push_back(std::move(pAllocator));
+    m_pExtBSProcArray.push_back(std::move(pBSProcessor));
+    m_pAllocParams.push_back(m_pAllocParams[0]);
+    m_hdls.push_back(m_hdls[0]);
+    m_pThreadContextArray.push_back(std::move(pThreadPipeline));
+
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::CreateAddedSession()
+
+bool Launcher::ShareAdapterDevice(mfxU32 adapterNum, bool bSingleTexture) {
+    // one device per adapter saves its init and lets the sessions exchange surfaces
+    auto it = m_AdapterDevices.find(std::make_pair(adapterNum, bSingleTexture));
+    if (it == m_AdapterDevices.end())
+        return false;
+
+    m_pAllocParams.push_back(m_pAllocParams[it->second]);
+    m_hdls.push_back(m_hdls[it->second]);
+    return true;
+} // bool Launcher::ShareAdapterDevice()
+
+mfxStatus Launcher::GetSharedPoolAllocator(const sInputParams& params,
+                                           mfxAllocatorParams* pAllocParams,
+                                           GeneralAllocator** ppAllocator) {
+    if (!m_pSharedPoolAllocator) {
+        auto pAllocator = std::make_unique<GeneralAllocator>();
+        pAllocator->SetNumaNode(params.NumaNode);
+        pAllocator->SetPooledSysMem(params.bSysMemPool);
+        pAllocator->SetLockTiming(params.bAllocStatistics);
+        mfxStatus sts = pAllocator->Init(pAllocParams);
+        MSDK_CHECK_STATUS(sts, "pAllocator->Init failed");
+
+        auto pService = std::make_unique<CSurfacePoolService>();
+        sts           = pService->Init(pAllocator.get());
+        MSDK_CHECK_STATUS(sts, "pService->Init failed");
+
+        m_pSharedPoolAllocator   = std::move(pAllocator);
+        m_pSurfacePoolService    = std::move(pService);
+        m_pSharedPoolAllocParams = pAllocParams;
+    }
+    else if (m_pSharedPoolAllocParams != pAllocParams) {
+        // frames of the pool are resources of one device
+        msdk_printf(MSDK_STRING("ERROR: sessions with -shared_pool must use one device\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    *ppAllocator = m_pSharedPoolAllocator.get();
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::GetSharedPoolAllocator()
+
+void Launcher::ReleaseAddedSession(size_t idxSession) {
+    const auto& context = m_pThreadContextArray[idxSession];
+
+    msdk_stringstream ss;
+    ss << MSDK_STRING("Session ") << idxSession << MSDK_STRING(" [")
+       << context->pPipeline->GetSessionText() << MSDK_STRING("] completed with status ")
+       << StatusToString(context->transcodingSts) << MSDK_STRING(", ") << context->numTransFrames
+       << MSDK_STRING(" frames") << std::endl;
+    msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
+
+    // free components and surfaces right away, output file is closed with the processor
+    context->pPipeline->Close();
+    context->pBSProcessor = nullptr;
+    m_pExtBSProcArray[idxSession].reset();
+} // void Launcher::ReleaseAddedSession()
+
 mfxStatus Launcher::ProcessResult() {
     FILE* pPerfFile = m_parser.GetPerformanceFile();
 
@@ -838,11 +1427,24 @@ mfxStatus Launcher::ProcessResult() {
 
     m_parser.PrintParFileName();
 
+    if (m_parser.IsEngineUtilizationEnabled()) {
+        ssTranscodingTime << MSDK_STRING("Engine utilization: ")
+                          << CEngineUtilizationSampler::ToString(m_EngineSampler.GetAverage())
+                          << std::endl;
+    }
+
     msdk_printf(MSDK_STRING("%s"), ssTranscodingTime.str().c_str());
     if (pPerfFile) {
         msdk_fprintf(pPerfFile, MSDK_STRING("%s"), ssTranscodingTime.str().c_str());
     }
 
+    // energy of the run is shared by the sessions in proportion to their working time
+    EngineUtilization utilization = m_EngineSampler.GetAverage();
+    mfxF64 energySeconds          = GetTime(m_StartTime);
+    mfxF64 sessionSeconds         = 0;
+    for (const auto& context : m_pThreadContextArray)
+        sessionSeconds += context->working_time;
+
     mfxStatus FinalSts = MFX_ERR_NONE;
     msdk_printf(MSDK_STRING(
         "-------------------------------------------------------------------------------\n"));
@@ -864,9 +1466,24 @@ mfxStatus Launcher::ProcessResult() {
            << SessionStsStr << MSDK_STRING(" (") << StatusToString(transcodingSts)
            << MSDK_STRING(") ") << workTime << MSDK_STRING(" sec, ") << framesNum
            << MSDK_STRING(" frames, ") << std::fixed << std::setprecision(3) << framesNum / workTime
-           << MSDK_STRING(" fps") << std::endl
-           << m_parser.GetLine(i) << std::endl
-           << std::endl;
+           << MSDK_STRING(" fps") << std::endl;
+        if (m_parser.IsEngineUtilizationEnabled() && sessionSeconds > 0) {
+            msdk_string energy = CEngineUtilizationSampler::ToEnergyString(
+                utilization,
+                energySeconds * workTime / sessionSeconds,
+                framesNum);
+            if (!energy.empty())
+                ss << MSDK_STRING("energy per frame: ") << energy << std::endl;
+        }
+        CQualityMeter::Summary quality = m_pThreadContextArray[i]->pPipeline->GetQualitySummary();
+        if (quality.Frames) {
+            ss << MSDK_STRING("quality: PSNR Y/U/V ") << std::setprecision(2) << quality.PSNRY
+               << MSDK_STRING("/") << quality.PSNRU << MSDK_STRING("/") << quality.PSNRV
+               << MSDK_STRING(" dB, SSIM Y ") << std::setprecision(4) << quality.SSIMY
+               << MSDK_STRING(" over ") << quality.Frames << MSDK_STRING(" frames")
+               << std::setprecision(3) << std::endl;
+        }
+        ss << m_parser.GetLine(i) << std::endl << std::endl;
 
         msdk_printf(MSDK_STRING("%s"), ss.str().c_str());
         if (pPerfFile) {
@@ -876,6 +1493,16 @@ mfxStatus Launcher::ProcessResult() {
     msdk_printf(MSDK_STRING(
         "-------------------------------------------------------------------------------\n"));
 
+    if (m_parser.GetLatencyStatInterval()) {
+        // values recorded after the last periodic report are added to the totals first
+        PrintLatencyStatistics(false);
+        PrintLatencyStatistics(true);
+    }
+
+    mfxStatus joinSts = JoinSegmentOutputs();
+    if (!FinalSts)
+        FinalSts = joinSts;
+
     msdk_stringstream ssTest;
     ssTest << std::endl
            << MSDK_STRING("The test ")
@@ -1082,6 +1709,523 @@ mfxStatus Launcher::CheckAndFixAdapterDependency(mfxU32 idxSession,
     return MFX_ERR_NONE;
 }
 
+// Relative cost of coding a pixel with the codec, raw input and output cost nothing
+static mfxF64 GetCodecCost(mfxU32 codecId) {
+    switch (codecId) {
+    case MFX_CODEC_HEVC:
+    case MFX_CODEC_AV1:
+    case MFX_CODEC_VP9:
+        return 1.5;
+    case MFX_CODEC_AVC:
+        return 1.0;
+    case MFX_CODEC_MPEG2:
+    case MFX_CODEC_VC1:
+        return 0.5;
+    case MFX_CODEC_JPEG:
+        return 0.3;
+    default:
+        return 0.;
+    }
+}
+
+// Mpixels per second weighted by codec cost, resolution and frame rate of streams are not known
+// before their headers are parsed, so unspecified ones are assumed to be 1080p30
+static mfxF64 EstimatePixelRate(const sInputParams& params) {
+    mfxF64 width  = params.nDstWidth ? params.nDstWidth : 1920;
+    mfxF64 height = params.nDstHeight ? params.nDstHeight : 1080;
+    mfxF64 fps    = 30.;
+    if (params.dEncoderFrameRateOverride)
+        fps = params.dEncoderFrameRateOverride;
+    else if (params.dDecoderFrameRateOverride)
+        fps = params.dDecoderFrameRateOverride;
+
+    return width * height * fps / 1e6;
+}
+
+static mfxF64 EstimateSessionLoad(const sInputParams& params) {
+    return EstimatePixelRate(params) *
+           (GetCodecCost(params.DecodeId) + GetCodecCost(params.EncodeId));
+}
+
+void Launcher::ShardSessionsAcrossAdapters() {
+    for (const sInputParams& params : m_InputParamsArray) {
+        // joined and composed sessions must run on one device
+        if (params.bIsJoin || Native != params.eModeExt) {
+            msdk_printf(MSDK_STRING(
+                "warning: -adapter_shard is ignored for joined sessions and composition\n"));
+            return;
+        }
+    }
+
+    std::vector<mfxI32> adapters = m_pLoader->GetAdapterNumbers();
+    if (adapters.size() < 2) {
+        msdk_printf(MSDK_STRING("warning: -adapter_shard found %d adapter(s), nothing to shard\n"),
+                    (int)adapters.size());
+        return;
+    }
+
+    // a sink and its sources exchange surfaces, so the group is placed as a whole
+    struct SessionGroup {
+        std::vector<mfxU32> Sessions;
+        mfxF64 Load       = 0.;
+        mfxF64 SpreadLoad = 0.;
+        bool Pinned       = false;
+        mfxI32 AdapterNum = -1;
+    };
+    std::vector<SessionGroup> groups;
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        const sInputParams& params = m_InputParamsArray[i];
+        if (Source != params.eMode || groups.empty())
+            groups.emplace_back();
+
+        SessionGroup& group = groups.back();
+        group.Sessions.push_back(i);
+        group.Load += EstimateSessionLoad(params);
+        // HyperMode encoder spreads its frames across the adapters itself
+        if (params.isDualMode && params.hyperMode != MFX_HYPERMODE_OFF) {
+            mfxF64 encodeLoad = EstimatePixelRate(params) * GetCodecCost(params.EncodeId);
+            group.Load -= encodeLoad;
+            group.SpreadLoad += encodeLoad;
+            msdk_printf(
+                MSDK_STRING("Session %d: HyperMode encode load %.1f spread across %d adapters\n"),
+                (int)i,
+                encodeLoad,
+                (int)adapters.size());
+        }
+        if (params.adapterNum >= 0 || params.dGfxIdx >= 0 ||
+            params.adapterType != mfxMediaAdapterType::MFX_MEDIA_UNKNOWN ||
+            params.PCIDeviceSetup || params.DRMRenderNodeNum ||
+            MFX_IMPL_BASETYPE(params.libType) == MFX_IMPL_SOFTWARE) {
+            group.Pinned = true;
+            if (params.adapterNum >= 0)
+                group.AdapterNum = params.adapterNum;
+        }
+    }
+
+    // explicitly placed sessions load their adapters first
+    std::vector<mfxF64> adapterLoad(adapters.size(), 0.);
+    std::vector<SessionGroup*> unpinned;
+    for (SessionGroup& group : groups) {
+        for (mfxF64& load : adapterLoad)
+            load += group.SpreadLoad / adapters.size();
+        if (!group.Pinned) {
+            unpinned.push_back(&group);
+            continue;
+        }
+        auto it = std::find(adapters.begin(), adapters.end(), group.AdapterNum);
+        if (it != adapters.end())
+            adapterLoad[std::distance(adapters.begin(), it)] += group.Load;
+    }
+
+    // the heaviest group goes to the least loaded adapter
+    std::stable_sort(unpinned.begin(),
+                     unpinned.end(),
+                     [](const SessionGroup* l, const SessionGroup* r) {
+                         return l->Load > r->Load;
+                     });
+    for (SessionGroup* group : unpinned) {
+        size_t idx = std::distance(adapterLoad.begin(),
+                                   std::min_element(adapterLoad.begin(), adapterLoad.end()));
+        adapterLoad[idx] += group->Load;
+
+        for (mfxU32 idxSession : group->Sessions) {
+            m_InputParamsArray[idxSession].adapterNum = adapters[idx];
+            msdk_printf(MSDK_STRING("Session %d: adapter %d, estimated load %.1f\n"),
+                        (int)idxSession,
+                        adapters[idx],
+                        EstimateSessionLoad(m_InputParamsArray[idxSession]));
+        }
+    }
+
+    for (size_t idx = 0; idx < adapters.size(); idx++)
+        msdk_printf(MSDK_STRING("Adapter %d: estimated load %.1f\n"),
+                    adapters[idx],
+                    adapterLoad[idx]);
+} // void Launcher::ShardSessionsAcrossAdapters()
+
+// Sessions decoding the same input with the same decoder options are turned into one decoding
+// session feeding their encoders, the same way as written by hand with -o::sink and -i::source
+void Launcher::ShareDuplicateDecodes() {
+    for (const sInputParams& params : m_InputParamsArray) {
+        // par file already defines its topology
+        if (Native != params.eMode || Native != params.eModeExt || params.bIsJoin ||
+            params.numMFEFrames > 1 || params.MFMode >= MFX_MF_AUTO)
+            return;
+    }
+
+    auto isShareable = [](const sInputParams& p) {
+        return !p.bNoSharedDecode && p.nSegments < 2 && !p.rawInput && !p.bIsMVC &&
+               MFX_CODEC_RGB4 != p.DecodeId && API_2X == p.verSessionInit &&
+               !p.bDecoderPostProcessing && !p.CascadeScaler && !p.nRotationAngle;
+    };
+    auto isSameDecode = [](const sInputParams& a, const sInputParams& b) {
+        return 0 == msdk_strcmp(a.strSrcFile, b.strSrcFile) && a.DecodeId == b.DecodeId &&
+               a.libType == b.libType && a.nMemoryModel == b.nMemoryModel &&
+               a.bForceSysMem == b.bForceSysMem && a.DecoderFourCC == b.DecoderFourCC &&
+               a.dDecoderFrameRateOverride == b.dDecoderFrameRateOverride &&
+               a.adapterType == b.adapterType && a.dGfxIdx == b.dGfxIdx &&
+               a.adapterNum == b.adapterNum && a.MaxFrameNumber == b.MaxFrameNumber &&
+               a.nTimeout == b.nTimeout && a.nFPS == b.nFPS &&
+               AreGuidsEqual(a.decoderPluginParams.pluginGuid, b.decoderPluginParams.pluginGuid) &&
+               0 == strcmp(a.decoderPluginParams.strPluginPath,
+                           b.decoderPluginParams.strPluginPath);
+    };
+
+    // 1->N surface buffers support one decoding session, the largest group gets it
+    std::vector<mfxU32> group;
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        if (!isShareable(m_InputParamsArray[i]))
+            continue;
+
+        std::vector<mfxU32> candidates;
+        for (mfxU32 j = i; j < m_InputParamsArray.size(); j++) {
+            if (isShareable(m_InputParamsArray[j]) &&
+                isSameDecode(m_InputParamsArray[i], m_InputParamsArray[j]))
+                candidates.push_back(j);
+        }
+        if (candidates.size() > group.size())
+            group = candidates;
+    }
+    if (group.size() < 2)
+        return;
+
+    // decoding session takes decoder options and drops VPP and encoder ones
+    sInputParams sink         = m_InputParamsArray[group[0]];
+    sink.eMode                = Sink;
+    sink.EncodeId             = 0;
+    sink.EncoderFourCC        = 0;
+    sink.strDstFile[0]        = 0;
+    sink.nDstWidth            = 0;
+    sink.nDstHeight           = 0;
+    sink.bEnableDeinterlacing = false;
+    sink.DenoiseLevel         = -1;
+    sink.DetailLevel          = -1;
+    sink.FRCAlgorithm         = 0;
+    sink.dVPPOutFramerate     = 0;
+    sink.fieldProcessingMode  = FC_NONE;
+#ifdef ENABLE_MCTF
+    sink.mctfParam.mode = VPP_FILTER_DISABLED;
+#endif
+    if (!sink.nAsyncDepth)
+        sink.nAsyncDepth = 4;
+
+    msdk_stringstream ss;
+    for (mfxU32 idx : group) {
+        sInputParams& source = m_InputParamsArray[idx];
+        source.eMode         = Source;
+        source.DecodeId      = 0;
+        source.strSrcFile[0] = 0;
+        // numbers after the decoding session is inserted
+        ss << MSDK_STRING(" ") << idx + 1;
+    }
+    msdk_printf(MSDK_STRING("Sessions%s decode the same input, they share decoding session 0\n"),
+                ss.str().c_str());
+
+    // decoding session goes first, so it gets DecoderTargetID
+    m_InputParamsArray.insert(m_InputParamsArray.begin(), sink);
+    m_parser.InsertLine(0, MSDK_STRING("shared decoding of") + ss.str());
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++)
+        m_InputParamsArray[i].TargetID = DecoderTargetID + i;
+} // void Launcher::ShareDuplicateDecodes()
+
+// Number of frames of one multi-frame encode batch, small frames leave room for more of them.
+// Resolution of streams without -w and -h is not known before their headers are parsed.
+static mfxU16 GetMFEMaxFrames(const sInputParams& params) {
+    mfxU32 area = (mfxU32)params.nDstWidth * params.nDstHeight;
+    if (!area)
+        return 0;
+    if (area <= 1280 * 720)
+        return 4;
+    if (area <= 1920 * 1088)
+        return 2;
+    return 0;
+}
+
+// Native AVC encode sessions on hardware are joined in the order of the par file, sessions of a
+// group have the same resolution class and adapter and join the first session of the group
+void Launcher::GroupMFESessions() {
+    for (const sInputParams& params : m_InputParamsArray) {
+        // par file already arranges MFE and joining
+        if (params.bIsJoin || params.numMFEFrames > 1 || params.MFMode != MFX_MF_DEFAULT) {
+            msdk_printf(
+                MSDK_STRING("warning: -mfe_auto is ignored for par file with MFE or joining\n"));
+            return;
+        }
+    }
+
+    auto isCandidate = [](const sInputParams& p) {
+        return Native == p.eMode && Native == p.eModeExt && MFX_CODEC_AVC == p.EncodeId &&
+               MFX_IMPL_BASETYPE(p.libType) != MFX_IMPL_SOFTWARE && GetMFEMaxFrames(p);
+    };
+    auto isSameGroup = [](const sInputParams& a, const sInputParams& b) {
+        return GetMFEMaxFrames(a) == GetMFEMaxFrames(b) &&
+               MFX_IMPL_BASETYPE(a.libType) == MFX_IMPL_BASETYPE(b.libType) &&
+               a.verSessionInit == b.verSessionInit && a.adapterType == b.adapterType &&
+               a.dGfxIdx == b.dGfxIdx && a.adapterNum == b.adapterNum;
+    };
+
+    std::vector<bool> grouped(m_InputParamsArray.size(), false);
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        if (grouped[i] || !isCandidate(m_InputParamsArray[i]))
+            continue;
+
+        std::vector<mfxU32> sessions;
+        for (mfxU32 j = i; j < m_InputParamsArray.size(); j++) {
+            if (!grouped[j] && isCandidate(m_InputParamsArray[j]) &&
+                isSameGroup(m_InputParamsArray[i], m_InputParamsArray[j])) {
+                grouped[j] = true;
+                sessions.push_back(j);
+            }
+        }
+
+        // the class is split into groups of at most max frames, the last one may stay alone
+        mfxU16 maxFrames = GetMFEMaxFrames(m_InputParamsArray[i]);
+        for (size_t first = 0; first + 1 < sessions.size(); first += maxFrames) {
+            size_t last      = std::min(sessions.size(), first + maxFrames);
+            mfxI32 leader    = (mfxI32)sessions[first];
+            mfxU16 numFrames = (mfxU16)(last - first);
+            msdk_stringstream ss;
+            ss << MSDK_STRING("MFE group of ") << numFrames << MSDK_STRING(" frames: sessions");
+            for (size_t k = first; k < last; k++) {
+                sInputParams& params  = m_InputParamsArray[sessions[k]];
+                params.bIsJoin        = true;
+                params.numMFEFrames   = numFrames;
+                params.MFMode         = MFX_MF_AUTO;
+                params.MFEGroupLeader = leader;
+                ss << MSDK_STRING(" ") << sessions[k];
+            }
+            msdk_printf(MSDK_STRING("%s\n"), ss.str().c_str());
+        }
+    }
+} // void Launcher::GroupMFESessions()
+
+mfxStatus Launcher::SplitSegmentedSessions() {
+    bool bSplit = false;
+    for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        const sInputParams params = m_InputParamsArray[i];
+        if (params.nSegments < 2)
+            continue;
+
+        // elementary streams of the segments are joined by concatenation
+        bool bNullOutput = 0 == msdk_strncmp(MSDK_STRING("null"),
+                                             params.strDstFile,
+                                             msdk_strlen(MSDK_STRING("null")));
+        bool bInput = params.DecodeId == MFX_CODEC_AVC || params.DecodeId == MFX_CODEC_HEVC ||
+                      params.DecodeId == MFX_CODEC_VP8 || params.DecodeId == MFX_CODEC_VP9 ||
+                      params.DecodeId == MFX_CODEC_AV1;
+        bool bOutput = bNullOutput || params.EncodeId == MFX_CODEC_AVC ||
+                       params.EncodeId == MFX_CODEC_HEVC || params.EncodeId == MFX_CODEC_MPEG2;
+        if (Native != params.eMode || Native != params.eModeExt || !bInput || !bOutput) {
+            PrintError(MSDK_STRING("-segments of session %d needs h264, h265 or IVF input and "
+                                   "h264, h265, mpeg2 or null output"),
+                       (int)i);
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (params.MaxFrameNumber != MFX_INFINITE) {
+            PrintError(MSDK_STRING("-n can't be used with -segments in session %d"), (int)i);
+            return MFX_ERR_UNSUPPORTED;
+        }
+
+        CBitstreamIndex index;
+        mfxStatus sts = params.IndexFile.empty()
+                            ? index.Build(params.strSrcFile, params.DecodeId)
+                            : index.LoadOrBuild(params.IndexFile.c_str(),
+                                                params.strSrcFile,
+                                                params.DecodeId);
+        MSDK_CHECK_STATUS(sts, "index of the input failed");
+
+        std::vector<CBitstreamIndex::Segment> segments = index.Split(params.nSegments);
+        if (segments.empty()) {
+            PrintError(MSDK_STRING("no frames are found in the input of session %d"), (int)i);
+            return MFX_ERR_UNSUPPORTED;
+        }
+        msdk_printf(MSDK_STRING("Session %d: input of %d frames is split into %d segments\n"),
+                    (int)i,
+                    (int)index.GetFrames().size(),
+                    (int)segments.size());
+
+        sSegmentedOutput output;
+        output.DstFile              = params.strDstFile;
+        output.FirstSession         = i;
+        output.bFrameRateConversion = params.dVPPOutFramerate || params.FRCAlgorithm;
+
+        msdk_string line = m_parser.GetLine(i);
+        for (mfxU32 s = 0; s < segments.size(); s++) {
+            sInputParams segment    = params;
+            segment.nSegments       = 0;
+            segment.nInputBegin     = segments[s].Begin;
+            segment.nInputEnd       = segments[s].End;
+            segment.bNoSharedDecode = true;
+            // the prefetching reader reads the whole file
+            segment.bPrefetchInput = false;
+            // every segment starts with an IDR frame, so the joined stream is valid when no GOP
+            // refers to the frames of the previous one
+            segment.GopOptFlag |= MFX_GOP_CLOSED;
+
+            if (!bNullOutput) {
+                msdk_stringstream ss;
+                ss << params.strDstFile << MSDK_STRING(".seg") << s;
+                if (ss.str().size() >= MSDK_MAX_FILENAME_LEN) {
+                    PrintError(MSDK_STRING("output file name of session %d is too long"), (int)i);
+                    return MFX_ERR_UNSUPPORTED;
+                }
+                msdk_strncopy_s(segment.strDstFile,
+                                MSDK_MAX_FILENAME_LEN,
+                                ss.str().c_str(),
+                                MSDK_MAX_FILENAME_LEN - 1);
+                output.SegmentFiles.push_back(ss.str());
+                output.SegmentFrames.push_back(segments[s].NumFrames);
+            }
+
+            msdk_printf(MSDK_STRING("    session %d: frames %d-%d\n"),
+                        (int)(i + s),
+                        (int)segments[s].FirstFrame,
+                        (int)(segments[s].FirstFrame + segments[s].NumFrames - 1));
+
+            if (!s) {
+                m_InputParamsArray[i] = segment;
+            }
+            else {
+                m_InputParamsArray.insert(m_InputParamsArray.begin() + i + s, segment);
+                m_parser.InsertLine(i + s, line);
+            }
+        }
+
+        if (!bNullOutput)
+            m_SegmentedOutputs.push_back(output);
+        i += (mfxU32)segments.size() - 1;
+        bSplit = true;
+    }
+
+    m_bSegmentedSessions = bSplit;
+    if (bSplit) {
+        for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++)
+            m_InputParamsArray[i].TargetID = DecoderTargetID + i;
+    }
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::SplitSegmentedSessions()
+
+mfxStatus Launcher::JoinSegmentOutputs() {
+    mfxStatus sts = MFX_ERR_NONE;
+    std::vector<mfxU8> buffer;
+
+    for (const sSegmentedOutput& output : m_SegmentedOutputs) {
+        bool bCompleted = true;
+        for (mfxU32 s = 0; s < output.SegmentFiles.size(); s++) {
+            size_t idx = output.FirstSession + s;
+            if (idx >= m_pThreadContextArray.size() || m_pThreadContextArray[idx]->transcodingSts) {
+                bCompleted = false;
+                continue;
+            }
+            m_pExtBSProcArray[idx]->CloseOutput();
+
+            // e.g. leading pictures of open GOPs are dropped by the decoder
+            mfxU32 numFrames = m_pThreadContextArray[idx]->numTransFrames;
+            if (!output.bFrameRateConversion && numFrames != output.SegmentFrames[s]) {
+                msdk_printf(MSDK_STRING(
+                                "[WARNING] segment %d of %s has %d frames of %d input frames\n"),
+                            (int)s,
+                            output.DstFile.c_str(),
+                            (int)numFrames,
+                            (int)output.SegmentFrames[s]);
+            }
+        }
+        if (!bCompleted) {
+            msdk_printf(MSDK_STRING("[WARNING] segments of %s are left as is, some failed\n"),
+                        output.DstFile.c_str());
+            continue;
+        }
+
+        FILE* pDst = NULL;
+        MSDK_FOPEN(pDst, output.DstFile.c_str(), MSDK_STRING("wb"));
+        bool bJoined = pDst != NULL;
+
+        buffer.resize(4 * 1024 * 1024);
+        for (const msdk_string& file : output.SegmentFiles) {
+            FILE* pSrc = NULL;
+            if (bJoined)
+                MSDK_FOPEN(pSrc, file.c_str(), MSDK_STRING("rb"));
+            bJoined = bJoined && pSrc;
+
+            size_t n = 0;
+            while (bJoined && (n = fread(buffer.data(), 1, buffer.size(), pSrc)) > 0)
+                bJoined = fwrite(buffer.data(), 1, n, pDst) == n;
+
+            if (pSrc)
+                fclose(pSrc);
+            if (bJoined)
+                msdk_remove(file.c_str());
+        }
+        if (pDst)
+            bJoined = 0 == fclose(pDst) && bJoined;
+
+        if (!bJoined) {
+            msdk_printf(MSDK_STRING("[ERROR] segments aren't joined into %s\n"),
+                        output.DstFile.c_str());
+            sts = MFX_ERR_UNKNOWN;
+            continue;
+        }
+        msdk_printf(MSDK_STRING("%d segments are joined into %s\n"),
+                    (int)output.SegmentFiles.size(),
+                    output.DstFile.c_str());
+    }
+
+    return sts;
+} // mfxStatus Launcher::JoinSegmentOutputs()
+
+mfxStatus Launcher::LayOutCompositionGrid() {
+    if (m_InputParamsArray.empty())
+        return MFX_ERR_NONE;
+
+    // composition session is the last one, all the others are its sources
+    const sInputParams& comp = m_InputParamsArray.back();
+    if (!comp.nVppCompGridCols || !comp.nVppCompGridRows)
+        return MFX_ERR_NONE;
+
+    if (comp.eMode != Source || (comp.eModeExt != VppComp && comp.eModeExt != VppCompOnly)) {
+        PrintError(MSDK_STRING(
+            "-vpp_comp_grid should be used in session with -vpp_comp or -vpp_comp_only\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+    if (!comp.nDstWidth || !comp.nDstHeight) {
+        PrintError(MSDK_STRING("-vpp_comp_grid requires -w and -h of composed stream\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    mfxU32 numSources = (mfxU32)m_InputParamsArray.size() - 1;
+    mfxU32 numCells   = (mfxU32)comp.nVppCompGridCols * comp.nVppCompGridRows;
+    if (numCells < numSources) {
+        PrintError(MSDK_STRING("-vpp_comp_grid %dx%d has less cells than %d sources\n"),
+                   (int)comp.nVppCompGridCols,
+                   (int)comp.nVppCompGridRows,
+                   (int)numSources);
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    // even cell sizes keep chroma of 4:2:0 surfaces aligned
+    mfxU16 cellW = (mfxU16)((comp.nDstWidth / comp.nVppCompGridCols) & ~1);
+    mfxU16 cellH = (mfxU16)((comp.nDstHeight / comp.nVppCompGridRows) & ~1);
+    if (!cellW || !cellH) {
+        PrintError(MSDK_STRING("-vpp_comp_grid cells are empty\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    for (mfxU32 i = 0; i < numSources; i++) {
+        sInputParams& src = m_InputParamsArray[i];
+        if (src.nVppCompDstW || src.nVppCompDstH)
+            continue;
+
+        src.nVppCompDstX = (mfxU16)((i % comp.nVppCompGridCols) * cellW);
+        src.nVppCompDstY = (mfxU16)((i / comp.nVppCompGridCols) * cellH);
+        src.nVppCompDstW = cellW;
+        src.nVppCompDstH = cellH;
+        if (src.eModeExt == Native)
+            src.eModeExt = VppComp;
+    }
+
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::LayOutCompositionGrid()
+
 mfxStatus Launcher::VerifyCrossSessionsOptions() {
     bool isSinkPresence     = false;
     bool isSourcePresence   = false;
@@ -1104,6 +2248,9 @@ mfxStatus Launcher::VerifyCrossSessionsOptions() {
     bool isForceSyncAllSession = false;
 
     for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
+        // -mfe_auto groups are consistent by construction and differ from each other
+        if (m_InputParamsArray[i].MFEGroupLeader >= 0)
+            continue;
         // loop over all sessions and check mfe-specific params
         // for mfe is required to have sessions joined, HW impl
         if (m_InputParamsArray[i].numMFEFrames > 1) {
@@ -1352,6 +2499,155 @@ mfxStatus Launcher::VerifyCrossSessionsOptions() {
 
 } // mfxStatus Launcher::VerifyCrossSessionsOptions()
 
+SafetySurfaceBuffer* Launcher::CreateSafetyBuffer(const sInputParams& params,
+                                                  SafetySurfaceBuffer* pNext) {
+    if (params.nSurfBufferRingSize)
+        return new SafetySurfaceRing(pNext, params.nSurfBufferRingSize);
+
+    return new SafetySurfaceBuffer(pNext);
+}
+
+void Launcher::ResolveSessionPlacement(mfxU32 idxSession) {
+    sInputParams& params = m_InputParamsArray[idxSession];
+
+    if (NUMA_NODE_AUTO == params.NumaNode) {
+        params.NumaNode = NUMA_NODE_OFF;
+        if (MFX_IMPL_BASETYPE(params.libType) != MFX_IMPL_SOFTWARE) {
+            mfxI32 node = -1;
+            if (params.PCIDeviceSetup) {
+                node = msdk_numa_get_pci_device_node(params.PCIDomain,
+                                                     params.PCIBus,
+                                                     params.PCIDevice,
+                                                     params.PCIFunction);
+            }
+#if defined(LINUX32) || defined(LINUX64)
+            else if (!params.strDevicePath.empty()) {
+                node = msdk_numa_get_device_node(params.strDevicePath.c_str());
+            }
+            else {
+                // VA display is created on the first render node by default
+                std::string device = "renderD" + std::to_string(params.DRMRenderNodeNum
+                                                                    ? params.DRMRenderNodeNum
+                                                                    : 128);
+                node               = msdk_numa_get_device_node(device.c_str());
+            }
+#endif
+            if (node >= 0)
+                params.NumaNode = node;
+        }
+    }
+
+    if (params.NumaNode >= 0 && params.CpuAffinity.empty()) {
+        if (MFX_ERR_NONE != msdk_numa_get_node_cpus(params.NumaNode, params.CpuAffinity)) {
+            msdk_printf(MSDK_STRING("[WARNING] Session %d: CPUs of NUMA node %d not found\n"),
+                        (int)idxSession,
+                        params.NumaNode);
+        }
+    }
+} // void Launcher::ResolveSessionPlacement()
+
+void Launcher::SetThreadPlacement(const sInputParams* pParams) {
+    if (!pParams) {
+        std::ignore = msdk_thread_set_affinity(m_MainThreadAffinity);
+        std::ignore = msdk_thread_set_numa_node(-1);
+        return;
+    }
+
+    std::ignore = msdk_thread_set_affinity(pParams->CpuAffinity.empty() ? m_MainThreadAffinity
+                                                                        : pParams->CpuAffinity);
+    std::ignore = msdk_thread_set_numa_node(pParams->NumaNode >= 0 ? pParams->NumaNode : -1);
+} // void Launcher::SetThreadPlacement()
+
+mfxStatus Launcher::InitBitstreamProcessor(FileBitstreamProcessor* pProcessor,
+                                           const sInputParams& params) {
+    MSDK_CHECK_POINTER(pProcessor, MFX_ERR_NULL_PTR);
+
+    mfxStatus sts = MFX_ERR_NONE;
+
+    std::unique_ptr<CSmplBitstreamReader> reader;
+    std::unique_ptr<CSmplYUVReader> yuvreader;
+    CDemuxBitstreamReader* pDemuxReader = NULL;
+    if (params.DecodeId == MFX_CODEC_VP9 || params.DecodeId == MFX_CODEC_VP8 ||
+        params.DecodeId == MFX_CODEC_AV1) {
+        reader.reset(new CIVFFrameReader());
+    }
+    else if (params.DecodeId == MFX_CODEC_RGB4 || params.DecodeId == MFX_CODEC_I420 ||
+             params.DecodeId == MFX_CODEC_NV12 || params.DecodeId == MFX_CODEC_P010) {
+        // YUV reader for RGB4 overlay and raw input
+        yuvreader.reset(new CSmplYUVReader());
+    }
+    else if ((params.DecodeId == MFX_CODEC_AVC || params.DecodeId == MFX_CODEC_HEVC) &&
+             GetDemuxContainer(params.strSrcFile) != DEMUX_NONE) {
+        // access units of the container are appended to the decoder bitstream
+        pDemuxReader = new CDemuxBitstreamReader();
+        reader.reset(pDemuxReader);
+    }
+    else if (params.bPrefetchInput) {
+        reader.reset(new CPrefetchBitstreamReader());
+    }
+    else {
+        reader.reset(new CSmplBitstreamReader());
+    }
+
+    if (reader.get()) {
+        sts = reader->Init(params.strSrcFile);
+        if (sts == MFX_ERR_UNSUPPORTED && params.DecodeId == MFX_CODEC_AV1) {
+            reader.reset(new CSmplBitstreamReader());
+            msdk_printf(MSDK_STRING("WARNING: Stream is not IVF, default reader\n"));
+        }
+        MSDK_CHECK_STATUS(sts, "reader->Init failed");
+        if (pDemuxReader && pDemuxReader->GetCodecId() != params.DecodeId) {
+            msdk_printf(MSDK_STRING("error: codec of the container track doesn't match -i\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (params.nInputEnd) {
+            sts = reader->SetRange(params.nInputBegin, params.nInputEnd);
+            MSDK_CHECK_STATUS(sts, "reader->SetRange failed");
+        }
+        sts = pProcessor->SetReader(reader);
+        MSDK_CHECK_STATUS(sts, "pProcessor->SetReader failed");
+    }
+    else if (yuvreader.get()) {
+        std::list<msdk_string> input;
+        input.push_back(params.strSrcFile);
+        sts = yuvreader->Init(input, params.DecodeId);
+        MSDK_CHECK_STATUS(sts, "m_YUVReader->Init failed");
+        sts = pProcessor->SetReader(yuvreader);
+        MSDK_CHECK_STATUS(sts, "pProcessor->SetReader failed");
+    }
+
+    if (msdk_strncmp(MSDK_STRING("null"), params.strDstFile, msdk_strlen(MSDK_STRING("null")))) {
+        std::unique_ptr<CSmplBitstreamWriter> writer;
+        MuxContainer container = GetMuxContainer(params.strDstFile);
+        if (container != MUX_NONE &&
+            (params.EncodeId == MFX_CODEC_AVC || params.EncodeId == MFX_CODEC_HEVC)) {
+            // encoder frame rate, time stamps are generated with it if the stream has none
+            mfxF64 frameRate = params.dEncoderFrameRateOverride ? params.dEncoderFrameRateOverride
+                                                                : params.dVPPOutFramerate;
+            mfxU32 frameRateExtN = 0, frameRateExtD = 0;
+            if (frameRate)
+                ConvertFrameRate(frameRate, &frameRateExtN, &frameRateExtD);
+
+            std::unique_ptr<CMuxWriter> muxWriter(CreateMuxWriter(container));
+            sts = muxWriter->Init(params.strDstFile, params.EncodeId, frameRateExtN, frameRateExtD);
+            MSDK_CHECK_STATUS(sts, "muxWriter->Init failed");
+            writer = std::move(muxWriter);
+        }
+        else {
+            if (params.bAsyncWriter)
+                writer.reset(new CAsyncBitstreamWriter());
+            else
+                writer.reset(new CSmplBitstreamWriter());
+            sts = writer->Init(params.strDstFile);
+        }
+
+        sts = pProcessor->SetWriter(writer);
+        MSDK_CHECK_STATUS(sts, "pProcessor->SetWriter failed");
+    }
+
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::InitBitstreamProcessor()
+
 mfxStatus Launcher::CreateSafetyBuffers() {
     SafetySurfaceBuffer* pBuffer     = NULL;
     SafetySurfaceBuffer* pPrevBuffer = NULL;
@@ -1359,7 +2655,7 @@ mfxStatus Launcher::CreateSafetyBuffers() {
     for (mfxU32 i = 0; i < m_InputParamsArray.size(); i++) {
         /* this is for 1 to N case*/
         if ((Source == m_InputParamsArray[i].eMode) && (Native == m_InputParamsArray[0].eModeExt)) {
-            pBuffer           = new SafetySurfaceBuffer(pPrevBuffer);
+            pBuffer           = CreateSafetyBuffer(m_InputParamsArray[i], pPrevBuffer);
             pBuffer->TargetID = m_InputParamsArray[i].TargetID;
             pPrevBuffer       = pBuffer;
             m_pBufferArray.push_back((std::unique_ptr<SafetySurfaceBuffer>(pBuffer)));
@@ -1370,7 +2666,7 @@ mfxStatus Launcher::CreateSafetyBuffers() {
         if ((Source != m_InputParamsArray[i].eMode) &&
             ((VppComp == m_InputParamsArray[0].eModeExt) ||
              (VppCompOnly == m_InputParamsArray[0].eModeExt))) {
-            pBuffer     = new SafetySurfaceBuffer(pPrevBuffer);
+            pBuffer     = CreateSafetyBuffer(m_InputParamsArray[i], pPrevBuffer);
             pPrevBuffer = pBuffer;
             m_pBufferArray.push_back(std::unique_ptr<SafetySurfaceBuffer>(pBuffer));
         }
@@ -1379,6 +2675,105 @@ mfxStatus Launcher::CreateSafetyBuffers() {
 
 } // mfxStatus Launcher::CreateSafetyBuffers
 
+mfxStatus Launcher::SubmitPipelineInit(std::function<mfxStatus()> init) {
+    mfxStatus sts = MFX_ERR_NONE;
+    if (m_InitTasks.size() >= m_parser.GetInitThreads()) {
+        sts = m_InitTasks.front().get();
+        m_InitTasks.pop_front();
+    }
+    if (sts < MFX_ERR_NONE) {
+        std::ignore = WaitPipelineInits();
+        return sts;
+    }
+
+    m_InitTasks.push_back(std::async(std::launch::async, std::move(init)));
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::SubmitPipelineInit()
+
+mfxStatus Launcher::WaitPipelineInits() {
+    mfxStatus sts = MFX_ERR_NONE;
+    while (!m_InitTasks.empty()) {
+        mfxStatus taskSts = m_InitTasks.front().get();
+        m_InitTasks.pop_front();
+        if (sts >= MFX_ERR_NONE && taskSts < MFX_ERR_NONE)
+            sts = taskSts;
+    }
+    return sts;
+} // mfxStatus Launcher::WaitPipelineInits()
+
+mfxStatus Launcher::CreateLaQPExchange() {
+    const sInputParams* pLeader = NULL;
+    mfxU32 nRenditions          = 0;
+
+    for (const auto& params : m_InputParamsArray) {
+        if (!params.bLaShare)
+            continue;
+
+        if (params.eMode != Source || params.eModeExt != Native) {
+            PrintError(MSDK_STRING(
+                "-la_share is supported only by -i::source sessions of 1_to_N pipeline\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (LaQPExchange::IsLeader(params)) {
+            if (pLeader) {
+                PrintError(MSDK_STRING("-la_share allows only one session with lookahead BRC\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            pLeader = &params;
+        }
+        nRenditions++;
+    }
+
+    if (!nRenditions)
+        return MFX_ERR_NONE;
+
+    if (!pLeader || nRenditions < 2) {
+        PrintError(
+            MSDK_STRING("-la_share requires one session with -la and at least one without\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+    if (!pLeader->nLADepth) {
+        PrintError(MSDK_STRING("-la_share requires -lad for the session with lookahead BRC\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    // lookahead, reordering and async depth of the leader delay output of the frame
+    mfxU32 lag = pLeader->nLADepth + std::max<mfxU32>(pLeader->GopRefDist, 1) +
+                 std::max<mfxU32>(pLeader->nAsyncDepth, 1);
+
+    for (const auto& params : m_InputParamsArray) {
+        if (params.bLaShare && params.nSurfBufferRingSize && params.nSurfBufferRingSize < lag) {
+            PrintError(
+                MSDK_STRING("-surf_buffer::ring of -la_share session must be at least %u\n"),
+                lag);
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
+    m_pLaQPExchange.reset(new LaQPExchange(lag));
+    msdk_printf(MSDK_STRING("Lookahead is shared by %u renditions, lag %u frames\n"),
+                nRenditions,
+                lag);
+    return MFX_ERR_NONE;
+} // mfxStatus Launcher::CreateLaQPExchange()
+
+mfxF64 Launcher::GetDecodeSkipFramerate() const {
+    mfxF64 framerate = 0;
+    for (const auto& params : m_InputParamsArray) {
+        if (params.eMode != Source)
+            continue;
+        // a rendition without FRC needs all the decoded frames
+        if (params.eModeExt != Native ||
+            MFX_FRCALGM_PRESERVE_TIMESTAMP != params.FRCAlgorithm || !params.dVPPOutFramerate) {
+            msdk_printf(MSDK_STRING(
+                "WARNING: -dec_skip is ignored, not all -i::source sessions use -FRC::PT and -f\n"));
+            return 0;
+        }
+        framerate = std::max(framerate, params.dVPPOutFramerate);
+    }
+    return framerate;
+} // mfxF64 Launcher::GetDecodeSkipFramerate() const
+
 CascadeScalerConfig::TargetDescriptor CascadeScalerConfig::GetDesc(mfxU32 id) {
     auto itr = std::find_if(Targets.begin(), Targets.end(), [id](TargetDescriptor& d) {
         return d.TargetID == id;
@@ -1432,6 +2827,10 @@ CascadeScalerConfig& Launcher::CreateCascadeScalerConfig() {
     }
 
     cfg.ParFileImported = true;
+    cfg.SharePools      = m_parser.IsCSPoolSharingEnabled();
+    if (!cfg.CascadeScalerRequired && m_parser.GetCSAutoMaxScale() > 0 && cfg.Targets.size() > 1) {
+        cfg.PlanCascade(m_parser.GetCSAutoMaxScale());
+    }
     cfg.CreatePoolList();
 
     return m_CSConfig;
@@ -1522,17 +2921,166 @@ void TranscodingSample::CascadeScalerConfig::CreatePoolList() {
     }
 }
 
+//frame size of the decoder output is not known yet, so any conversion of it costs more than
+//conversion of a stage output, plans with equal cost are compared by the number of stages
+void TranscodingSample::CascadeScalerConfig::PlanCascade(double maxScale) {
+    struct Plan {
+        bool Valid     = false;
+        mfxU32 Decoder = 0; //conversions of the decoder output
+        mfxU64 Pixels  = 0; //pixels read by conversions of the stage outputs
+        std::vector<bool> Stages;
+
+        bool IsBetter(const Plan& other) const {
+            if (!other.Valid) {
+                return true;
+            }
+            if (Decoder != other.Decoder) {
+                return Decoder < other.Decoder;
+            }
+            if (Pixels != other.Pixels) {
+                return Pixels < other.Pixels;
+            }
+            return std::count(Stages.begin(), Stages.end(), true) <
+                   std::count(other.Stages.begin(), other.Stages.end(), true);
+        }
+    };
+
+    auto canFeed = [maxScale](const TargetDescriptor& src, const TargetDescriptor& dst) {
+        if (!dst.DstWidth || !dst.DstHeight || dst.DstWidth > src.DstWidth ||
+            dst.DstHeight > src.DstHeight) {
+            return false;
+        }
+        if (src.DstWidth > maxScale * dst.DstWidth || src.DstHeight > maxScale * dst.DstHeight) {
+            return false;
+        }
+        if (src.FRC && (!dst.FRC || src.DstFrameRate != dst.DstFrameRate)) {
+            return false;
+        }
+        return !src.DI || dst.DI;
+    };
+
+    //plans[0] keeps the decoder output as the current source, plans[i + 1] uses target i
+    std::vector<Plan> plans(Targets.size() + 1);
+    plans[0].Valid = true;
+    plans[0].Stages.assign(Targets.size(), false);
+
+    for (size_t i = 0; i < Targets.size(); i++) {
+        const TargetDescriptor& desc = Targets[i];
+        std::vector<Plan> next(plans.size());
+
+        for (size_t src = 0; src < plans.size(); src++) {
+            Plan plan = plans[src];
+            if (!plan.Valid) {
+                continue;
+            }
+
+            mfxU32 FRC = desc.FRC ? 1 : 0;
+            mfxU32 DI  = desc.DI ? 1 : 0;
+            if (src == 0) {
+                plan.Decoder += 1 + FRC + DI;
+            }
+            else {
+                const TargetDescriptor& stage = Targets[src - 1];
+                if (!canFeed(stage, desc)) {
+                    continue;
+                }
+                //FRC and DI of the stage are not repeated
+                mfxU32 work = 1 + (stage.FRC ? 0 : FRC) + (stage.DI ? 0 : DI);
+                plan.Pixels += (mfxU64)stage.DstWidth * stage.DstHeight * work;
+            }
+
+            if (plan.IsBetter(next[src])) {
+                next[src] = plan;
+            }
+            if (desc.DstWidth && desc.DstHeight) {
+                plan.Stages[i] = true;
+                if (plan.IsBetter(next[i + 1])) {
+                    next[i + 1] = plan;
+                }
+            }
+        }
+        plans = std::move(next);
+    }
+
+    const Plan* best = &plans[0];
+    for (const Plan& plan : plans) {
+        if (plan.Valid && plan.IsBetter(*best)) {
+            best = &plan;
+        }
+    }
+
+    msdk_printf(MSDK_STRING("Cascade scaler plan:\n"));
+    mfxU32 SrcID = 0;
+    for (size_t i = 0; i < Targets.size(); i++) {
+        TargetDescriptor& desc = Targets[i];
+        desc.CascadeScaler     = best->Stages[i];
+        if (SrcID) {
+            msdk_printf(MSDK_STRING("    target %u %ux%u from target %u%s\n"),
+                        desc.TargetID,
+                        desc.DstWidth,
+                        desc.DstHeight,
+                        SrcID,
+                        desc.CascadeScaler ? MSDK_STRING(", stage") : MSDK_STRING(""));
+        }
+        else {
+            msdk_printf(MSDK_STRING("    target %u %ux%u from decoder%s\n"),
+                        desc.TargetID,
+                        desc.DstWidth,
+                        desc.DstHeight,
+                        desc.CascadeScaler ? MSDK_STRING(", stage") : MSDK_STRING(""));
+        }
+        if (desc.CascadeScaler) {
+            CascadeScalerRequired = true;
+            SrcID                 = desc.TargetID;
+        }
+    }
+}
+
+mfxU32 TranscodingSample::CascadeScalerConfig::GetSurfacePoolID(mfxU32 poolID) {
+    auto it = Pools.find(poolID);
+    if (it == Pools.end() || !it->second.SharedPoolID) {
+        return poolID;
+    }
+    return it->second.SharedPoolID;
+}
+
 void Launcher::Close() {
+    // Init may fail while other sessions are still initialized
+    std::ignore = WaitPipelineInits();
+    m_pTaskPool.reset();
+
     while (m_pThreadContextArray.size()) {
         m_pThreadContextArray[m_pThreadContextArray.size() - 1].reset();
         m_pThreadContextArray.pop_back();
     }
 
+    bool bAllocStatistics = false;
+    for (size_t i = 0; i < m_pAllocArray.size() && i < m_InputParamsArray.size(); i++) {
+        if (m_InputParamsArray[i].bAllocStatistics) {
+            msdk_printf(MSDK_STRING("Session %d "), (int)i);
+            m_pAllocArray[i]->PrintStatistics();
+            bAllocStatistics = true;
+        }
+    }
+    if (m_pSurfacePoolService) {
+        m_pSurfacePoolService->PrintStatistics();
+        if (bAllocStatistics) {
+            msdk_printf(MSDK_STRING("Shared pool "));
+            m_pSharedPoolAllocator->PrintStatistics();
+        }
+    }
+    m_pSurfacePoolService.reset();
+    m_pSharedPoolAllocator.reset();
+    m_pSharedPoolAllocParams = NULL;
+
     m_pAllocArray.clear();
     m_pBufferArray.clear();
+    m_pLaQPExchange.reset();
     m_pExtBSProcArray.clear();
     m_pAllocParams.clear();
+    m_hdls.clear();
     m_hwdevs.clear();
+    m_AdapterDevices.clear();
 
 } // void Launcher::Close()
 
@@ -6,9 +6,28 @@
 
 #include "smt_tracer.h"
 
+#include <iomanip>
+#include <tuple>
+#include <unordered_map>
+
 namespace TranscodingSample {
 
-SMTTracer::SMTTracer() : Log(), AddonLog(), E2ELatency(), EncLatency(), TracerFileMutex() {
+const size_t SMTTracer::NoMatch;
+
+SMTTracer::SMTTracer()
+        : Log(),
+          AddonLog(),
+          Match(),
+          Rings(),
+          RingsMutex(),
+          NumOfDropped(0),
+          Drainer(),
+          DrainerCV(),
+          TraceFile(),
+          TraceFileName(),
+          E2ELatency(),
+          EncLatency(),
+          TracerFileMutex() {
     TimeBase = std::chrono::steady_clock::now();
 }
 
@@ -16,9 +35,23 @@ SMTTracer::~SMTTracer() {
     if (!Enabled)
         return;
 
+    {
+        std::lock_guard<std::mutex> guard(TracerFileMutex);
+        StopDrainer = true;
+    }
+    DrainerCV.notify_one();
+    Drainer.join();
+    DrainEvents();
+
+    //events from different threads are drained in batches, restore the global order
+    std::stable_sort(Log.begin(), Log.end(), [](const Event& a, const Event& b) {
+        return a.TS < b.TS;
+    });
+    IndexEvents();
+
     //these functions are intentionally called from destructor to try to save traces in case of a crash
     AddFlowEvents();
-    SaveTrace(0xffffff & GetCurrentTS());
+    SaveTrace();
 
     ComputeE2ELatency();
     PrintE2ELatency();
@@ -32,7 +65,10 @@ void SMTTracer::Init() {
         return;
     }
     Enabled = true;
-    Log.reserve(TraceBufferSizeInMBytes * 1024 * 1024 / sizeof(Event));
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    OpenTrace(0xffffff & std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    Drainer = std::thread(&SMTTracer::DrainerRoutine, this);
 }
 
 void SMTTracer::BeginEvent(const ThreadType thType,
@@ -64,29 +100,49 @@ void SMTTracer::AddCounterEvent(const ThreadType thType,
     AddEvent(EventType::Counter, thType, thID, name, reinterpret_cast<void*>(counter), nullptr);
 }
 
-void SMTTracer::SaveTrace(mfxU32 FileID) {
-    std::string FileName = "smt_trace_" + std::to_string(FileID) + ".json";
-    std::ofstream trace_file(FileName, std::ios::out);
-    if (!trace_file) {
+void SMTTracer::OpenTrace(mfxU32 FileID) {
+    TraceFileName = "smt_trace_" + std::to_string(FileID) + ".json";
+    TraceFile.open(TraceFileName, std::ios::out);
+    if (!TraceFile) {
         return;
     }
 
-    printf("\n### trace buffer usage [%d/%d] %.2f%%\n",
-           (int)Log.size(),
-           (int)Log.capacity(),
-           100. * Log.size() / Log.capacity());
-    printf("trace file name %s\n", FileName.c_str());
-
-    trace_file << "[" << std::endl;
+    TraceFile << "[" << std::endl;
+}
 
-    for (const Event ev : Log) {
-        WriteEvent(trace_file, ev);
+void SMTTracer::SaveTrace() {
+    if (!TraceFile) {
+        return;
     }
+
+    //events are already streamed by the drainer, only generated ones are left
     for (const Event ev : AddonLog) {
-        WriteEvent(trace_file, ev);
+        WriteEvent(TraceFile, ev);
+    }
+    TraceFile.close();
+
+    printf("\n### trace events %d, dropped %d\n", (int)Log.size(), (int)NumOfDropped.load());
+    printf("trace file name %s\n", TraceFileName.c_str());
+}
+
+bool SMTTracer::EventRing::Push(const Event& ev) {
+    size_t head = Head.load(std::memory_order_relaxed);
+    if (head - Tail.load(std::memory_order_acquire) == Events.size()) {
+        return false;
     }
 
-    trace_file.close();
+    Events[head % Events.size()] = ev;
+    Head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void SMTTracer::EventRing::Drain(std::vector<Event>& out) {
+    size_t tail = Tail.load(std::memory_order_relaxed);
+    size_t head = Head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+        out.push_back(Events[tail % Events.size()]);
+    }
+    Tail.store(tail, std::memory_order_release);
 }
 
 void SMTTracer::AddEvent(const EventType evType,
@@ -104,17 +160,80 @@ void SMTTracer::AddEvent(const EventType evType,
     ev.OutID  = reinterpret_cast<mfxU64>(outID);
     ev.TS     = GetCurrentTS();
 
-    if (Log.size() == Log.capacity()) {
-        return;
+    // ring is full only if the drainer is stalled
+    if (!GetThreadRing()->Push(ev)) {
+        NumOfDropped++;
+    }
+}
+
+SMTTracer::EventRing* SMTTracer::GetThreadRing() {
+    thread_local const SMTTracer* owner = nullptr;
+    thread_local EventRing* ring        = nullptr;
+    if (owner == this) {
+        return ring;
     }
 
-    std::lock_guard<std::mutex> guard(TracerFileMutex);
-    Log.push_back(ev);
+    std::lock_guard<std::mutex> guard(RingsMutex);
+    Rings.emplace_back(new EventRing(RingSizeInEvents));
+    owner = this;
+    ring  = Rings.back().get();
+    return ring;
+}
+
+void SMTTracer::DrainerRoutine() {
+    std::unique_lock<std::mutex> lock(TracerFileMutex);
+    while (!StopDrainer) {
+        DrainerCV.wait_for(lock, std::chrono::milliseconds(DrainPeriodInMs));
+        lock.unlock();
+        DrainEvents();
+        lock.lock();
+    }
+}
+
+void SMTTracer::DrainEvents() {
+    size_t first = Log.size();
+    {
+        std::lock_guard<std::mutex> guard(RingsMutex);
+        for (auto& ring : Rings) {
+            ring->Drain(Log);
+        }
+    }
+
+    if (TraceFile) {
+        for (size_t i = first; i < Log.size(); i++) {
+            WriteEvent(TraceFile, Log[i]);
+        }
+    }
 }
 
 mfxU64 SMTTracer::GetCurrentTS() {
     std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
-    return std::chrono::duration_cast<std::chrono::microseconds>(time - TimeBase).count();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - TimeBase).count();
+}
+
+void SMTTracer::IndexEvents() {
+    //log is walked once, the last event of each kind is remembered by its key
+    std::map<std::tuple<ThreadType, mfxU32, EventName>, size_t> lastBegin;
+    std::unordered_map<mfxU64, size_t> lastEndByOutID;
+
+    Match.assign(Log.size(), NoMatch);
+    for (size_t i = 0; i < Log.size(); i++) {
+        const Event& ev = Log[i];
+        if (ev.EvType == EventType::DurationStart) {
+            auto it = lastEndByOutID.find(ev.InID);
+            if (it != lastEndByOutID.end()) {
+                Match[i] = it->second;
+            }
+            lastBegin[std::make_tuple(ev.ThType, ev.ThID, ev.Name)] = i;
+        }
+        else if (ev.EvType == EventType::DurationEnd) {
+            auto it = lastBegin.find(std::make_tuple(ev.ThType, ev.ThID, ev.Name));
+            if (it != lastBegin.end()) {
+                Match[i] = it->second;
+            }
+            lastEndByOutID[ev.OutID] = i;
+        }
+    }
 }
 
 void SMTTracer::AddFlowEvents() {
@@ -127,12 +246,8 @@ void SMTTracer::AddFlowEvents() {
             continue;
         }
 
-        auto itc = std::reverse_iterator<decltype(it)>(it);
-
-        auto itp = find_if(itc, Log.rend(), [&it](Event ev) {
-            return ev.EvType == EventType::DurationEnd && it->InID == ev.OutID;
-        });
-        if (itp == Log.rend()) {
+        auto itp = FindEndOfPreviosDurationEvent(it);
+        if (itp == Log.end()) {
             continue;
         }
 
@@ -168,7 +283,7 @@ void SMTTracer::PrintE2ELatency() {
         printf("\n    enc%d number of frame %d\n", v.first, int(v.second.size()));
         printf("        per frame latency ms : ");
         for (mfxU64 t : v.second) {
-            printf(" %.2f,", t / 1000.);
+            printf(" %.2f,", t / 1000000.);
         }
         printf("\n");
     }
@@ -205,7 +320,7 @@ void SMTTracer::PrintEncLatency() {
         printf("\n    enc%d number of frame %d\n", v.first, int(v.second.size()));
         printf("        per frame latency ms : ");
         for (mfxU64 t : v.second) {
-            printf(" %.2f,", t / 1000.);
+            printf(" %.2f,", t / 1000000.);
         }
         printf("\n");
     }
@@ -232,36 +347,22 @@ SMTTracer::EventIt SMTTracer::FindBeginningOfDependencyChain(EventIt it) {
 
 SMTTracer::EventIt SMTTracer::FindBeginningOfDurationEvent(EventIt it) {
     //"it" should point to the end of duration event
-    if (it == Log.begin() || it == Log.end() || it->EvType != EventType::DurationEnd) {
+    if (it == Log.end() || it->EvType != EventType::DurationEnd) {
         return Log.end();
     }
 
-    EventIt itc = it;
-    for (; itc != Log.begin();) {
-        --itc;
-        if (itc->EvType == EventType::DurationStart && itc->ThType == it->ThType &&
-            itc->ThID == it->ThID && itc->Name == it->Name) {
-            return itc;
-        }
-    }
-
-    return Log.end();
+    size_t match = Match[it - Log.begin()];
+    return match == NoMatch ? Log.end() : Log.begin() + match;
 }
 
 SMTTracer::EventIt SMTTracer::FindEndOfPreviosDurationEvent(EventIt it) {
     //"it" should point to the beginnig of duration event
-    if (it == Log.begin() || it == Log.end() || it->EvType != EventType::DurationStart) {
+    if (it == Log.end() || it->EvType != EventType::DurationStart) {
         return Log.end();
     }
 
-    EventIt itc = it;
-    for (; itc != Log.begin();) {
-        --itc;
-        if (itc->EvType == EventType::DurationEnd && itc->OutID == it->InID) {
-            return itc;
-        }
-    }
-    return Log.end();
+    size_t match = Match[it - Log.begin()];
+    return match == NoMatch ? Log.end() : Log.begin() + match;
 }
 
 void SMTTracer::AddFlowEvent(const Event a, const Event b) {
@@ -386,7 +487,9 @@ void SMTTracer::WriteEventTID(std::ofstream& trace_file, const Event ev) {
 }
 
 void SMTTracer::WriteEventTS(std::ofstream& trace_file, const Event ev) {
-    trace_file << "\"ts\":" << ev.TS;
+    //trace format expects microseconds
+    trace_file << "\"ts\":" << ev.TS / 1000 << "." << std::setw(3) << std::setfill('0')
+               << ev.TS % 1000 << std::setfill(' ');
 }
 
 void SMTTracer::WriteEventPhase(std::ofstream& trace_file, const Event ev) {
@@ -36,6 +36,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace TranscodingSample;
@@ -99,6 +100,42 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING("\n"));
     msdk_printf(MSDK_STRING("  -stat <N>\n"));
     msdk_printf(MSDK_STRING("                Output statistic every N transcoding cycles\n"));
+    msdk_printf(MSDK_STRING("  -latency_stat <seconds>\n"));
+    msdk_printf(MSDK_STRING(
+        "                Every N seconds output latency from decode request to encoded frame of each session\n"));
+    msdk_printf(MSDK_STRING(
+        "                as p50/p90/p99/max over the interval, totals are printed at the end\n"));
+    msdk_printf(MSDK_STRING("  -metrics <name>\n"));
+    msdk_printf(MSDK_STRING(
+        "                Every second replace the file with session counters in Prometheus text format: fps, bitrate,\n"));
+    msdk_printf(MSDK_STRING(
+        "                frames in flight, free surfaces of pools, device busy retries and sync wait time. The file\n"));
+    msdk_printf(MSDK_STRING("                can be published by the textfile collector of node_exporter\n"));
+    msdk_printf(MSDK_STRING("  -engine_util\n"));
+    msdk_printf(MSDK_STRING(
+        "                Sample utilization of GPU engines (RCS, VDBOX, VEBOX) while transcoding, print the average\n"));
+    msdk_printf(MSDK_STRING(
+        "                at the end and publish the last values with -metrics. Requires metrics_monitor library\n"));
+    msdk_printf(MSDK_STRING(
+        "                Energy per frame of GPU, CPU packages and DRAM is printed per session if RAPL is readable\n"));
+    msdk_printf(MSDK_STRING("  -cs_share_pools\n"));
+    msdk_printf(MSDK_STRING(
+        "                Cascade scaler targets with the same resolution and color format use one surface pool\n"));
+    msdk_printf(MSDK_STRING("  -cs_auto <max scale>\n"));
+    msdk_printf(MSDK_STRING(
+        "                Plan cascade scaler if no target uses -cs: rungs of the ladder scale from the smallest\n"));
+    msdk_printf(MSDK_STRING(
+        "                larger rung with the same FRC and DI output, at most <max scale> times per dimension\n"));
+    msdk_printf(MSDK_STRING("  -mfe_auto\n"));
+    msdk_printf(MSDK_STRING(
+        "                Join AVC encode sessions with the same resolution class and adapter into multi-frame\n"));
+    msdk_printf(MSDK_STRING(
+        "                encode groups, up to 4 sessions up to 720p or 2 up to 1080p, if par file has no MFE\n"));
+    msdk_printf(MSDK_STRING("  -adapter_shard\n"));
+    msdk_printf(MSDK_STRING(
+        "                Distribute sessions without explicit adapter over all hardware adapters balancing estimated\n"));
+    msdk_printf(MSDK_STRING(
+        "                load (resolution x frame rate x codec cost), sink and its source sessions use one adapter\n"));
     msdk_printf(MSDK_STRING("  -stat-log <name>\n"));
     msdk_printf(MSDK_STRING(
         "                Output statistic to the specified file (opened in append mode)\n"));
@@ -118,10 +155,42 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING("  -greedy \n"));
     msdk_printf(
         MSDK_STRING("                Use greedy formula to calculate number of surfaces\n"));
+    msdk_printf(MSDK_STRING("  -cpu_affinity <cpu-list>\n"));
+    msdk_printf(MSDK_STRING("  -numa_node <node>|auto|off\n"));
+    msdk_printf(MSDK_STRING(
+        "                Default thread placement for all sessions, see pipeline options below\n"));
+    msdk_printf(MSDK_STRING("  -task_pool <threads>|auto\n"));
+    msdk_printf(MSDK_STRING(
+        "                Run sessions which decode and encode as tasks on the fixed number of threads instead of\n"));
+    msdk_printf(MSDK_STRING(
+        "                thread per session, auto means number of logical CPUs. Thread placement options are not\n"));
+    msdk_printf(MSDK_STRING("                applied to such sessions\n"));
+    msdk_printf(MSDK_STRING("  -init_threads <threads>|auto\n"));
+    msdk_printf(MSDK_STRING(
+        "                Initialize independent sessions on up to the number of threads concurrently, 1 by default.\n"));
+    msdk_printf(MSDK_STRING(
+        "                Sessions of 1_to_N and N_to_1 pipelines, joined sessions and -shared_pool ones are\n"));
+    msdk_printf(MSDK_STRING("                initialized in the order of par file\n"));
+    msdk_printf(MSDK_STRING("  -control::stdin\n"));
+    msdk_printf(MSDK_STRING(
+        "                Read control commands from stdin while transcoding. Sessions of the par file are started first,\n"));
+    msdk_printf(MSDK_STRING(
+        "                the application exits after 'quit' command or end of input once all sessions are completed:\n"));
+    msdk_printf(MSDK_STRING(
+        "                  add <session options> - start new session with options in par file format\n"));
+    msdk_printf(MSDK_STRING("                  stop <N>              - stop session N\n"));
+    msdk_printf(
+        MSDK_STRING("                  list                  - print state of the sessions\n"));
+    msdk_printf(
+        MSDK_STRING("                  quit                  - do not accept new commands\n"));
+    msdk_printf(MSDK_STRING(
+        "                Added sessions must not be joined or use shared buffers, they reuse device of session 0\n"));
     msdk_printf(MSDK_STRING("\n"));
     msdk_printf(MSDK_STRING("Pipeline description (general options):\n"));
     msdk_printf(MSDK_STRING("  -i::h265|h264|mpeg2|vc1|mvc|jpeg|vp9|av1 <file-name>\n"));
     msdk_printf(MSDK_STRING("                 Set input file and decoder type\n"));
+    msdk_printf(MSDK_STRING(
+        "                 h264 and h265 in MP4, Matroska or MPEG-TS file is demuxed, the first video track is decoded\n"));
     msdk_printf(MSDK_STRING("  -i::i420|nv12|p010 <file-name>\n"));
     msdk_printf(MSDK_STRING("                 Set raw input file and color format\n"));
     msdk_printf(MSDK_STRING(
@@ -131,8 +200,16 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING("                LSB data placement is expected by default.\n"));
     msdk_printf(MSDK_STRING("  -o::h265|h264|mpeg2|mvc|jpeg|vp9|av1|raw <file-name>|null\n"));
     msdk_printf(MSDK_STRING("                Set output file and encoder type\n"));
+    msdk_printf(MSDK_STRING(
+        "                h264 and h265 output to .ts or .mp4 file is muxed into MPEG-TS or fragmented MP4\n"));
     msdk_printf(MSDK_STRING(
         "                \'null\' keyword as file-name disables output file writing \n"));
+    msdk_printf(MSDK_STRING("  -read_ahead    Read input bitstream ahead on a dedicated thread\n"));
+    msdk_printf(
+        MSDK_STRING("                in large chunks, so decoding doesn't wait for the disk\n"));
+    msdk_printf(MSDK_STRING("  -async_write   Write output file from a dedicated thread\n"));
+    msdk_printf(
+        MSDK_STRING("                in large chunks, so encoding doesn't wait for the disk\n"));
     msdk_printf(MSDK_STRING("  -sw|-hw|-hw_d3d11|-hw_d3d9\n"));
     msdk_printf(MSDK_STRING("                SDK implementation to use: \n"));
     msdk_printf(MSDK_STRING(
@@ -150,10 +227,10 @@ void TranscodingSample::PrintHelp() {
     msdk_printf(MSDK_STRING(
         "                              If not specified, defaults to the first Intel device found on the system\n"));
 #endif
-#if (defined(_WIN64) || defined(_WIN32))
     msdk_printf(MSDK_STRING(
         "   [-dual_gfx::<on,off,adaptive>] - prefer encode processing on both iGfx and dGfx simultaneously\n"));
-#endif
+    msdk_printf(MSDK_STRING(
+        "                              (HyperMode). Frames are kept in video memory, the runtime shares them between adapters\n"));
 #ifdef ONEVPL_EXPERIMENTAL
     #if (defined(_WIN64) || defined(_WIN32))
     msdk_printf(MSDK_STRING("   -luid <HighPart:LowPart> - setup adapter by LUID  \n"));
@@ -221,14 +298,44 @@ void TranscodingSample::PrintHelp() {
 
     msdk_printf(MSDK_STRING(
         "  -robust       Recover from gpu hang errors as they come (by resetting components)\n"));
-    msdk_printf(MSDK_STRING("  -robust:soft  Recover from gpu hang errors by inserting an IDR\n"));
+    msdk_printf(MSDK_STRING(
+        "  -robust:soft  Recover from gpu hang errors by inserting an IDR, transcoding sessions re-initialize\n"));
+    msdk_printf(MSDK_STRING(
+        "                components keeping surface pools and device, and resume from the next IDR\n"));
 
     msdk_printf(MSDK_STRING("  -async        Depth of asynchronous pipeline. default value 1\n"));
+    msdk_printf(MSDK_STRING(
+        "  -async_adaptive <min>\n"
+        "                Adapt number of encoded frames in flight between <min> and -async at runtime:\n"
+        "                depth grows while GPU is behind and shrinks when it only adds latency\n"));
+    msdk_printf(MSDK_STRING(
+        "  -low_latency  Keep one frame in flight and sync it as soon as it's submitted, no B-frames\n"
+        "                and lookahead. Use -preset gaming for low delay rate control\n"));
+    msdk_printf(MSDK_STRING(
+        "  -latency_log <file>\n"
+        "                Write latency of every output frame, from reading input to encoded result\n"));
+    msdk_printf(MSDK_STRING(
+        "  -quality <file>\n"
+        "                Decode the output again and write PSNR (Y, U, V) and SSIM (Y) of every\n"
+        "                frame to CSV file, NV12 encoder input and API 2.0 only\n"));
+#ifdef ONEVPL_EXPERIMENTAL
+    msdk_printf(MSDK_STRING(
+        "  -enc_stats <file>\n"
+        "                Write frame level encode statistics (QP, PSNR, blocks) to CSV file\n"));
+#endif
     msdk_printf(MSDK_STRING(
         "  -join         Join session with other session(s), by default sessions are not joined\n"));
     msdk_printf(MSDK_STRING(
         "  -priority     Use priority for join sessions. 0 - Low, 1 - Normal, 2 - High. Normal by default\n"));
     msdk_printf(MSDK_STRING("  -threads num  Number of session internal threads to create\n"));
+#if !defined(_WIN32) && !defined(_WIN64)
+    msdk_printf(MSDK_STRING("  -threads_schedtype <type>\n"));
+    msdk_printf(MSDK_STRING("                Scheduling type of session internal threads\n"));
+    msdk_printf(MSDK_STRING("  -threads_priority <priority>\n"));
+    msdk_printf(MSDK_STRING("                Priority of session internal threads\n"));
+#endif
+    msdk_printf(MSDK_STRING(
+        "                Thread settings of the first session are used by all 2.x API sessions\n"));
     msdk_printf(
         MSDK_STRING("  -n            Number of frames to transcode\n") MSDK_STRING(
             "                  (session ends after this number of frames is reached). \n")
@@ -329,6 +436,12 @@ void TranscodingSample::PrintHelp() {
         MSDK_STRING("                May be 1 in the case when -mss option is specified \n"));
     msdk_printf(MSDK_STRING(
         "  -la_ext       Use external LA plugin (compatible with h264 & hevc encoders)\n"));
+    msdk_printf(MSDK_STRING(
+        "  -la_share     Share one lookahead pass between -i::source renditions of 1_to_N pipeline.\n"));
+    msdk_printf(MSDK_STRING(
+        "                The rendition with -la and -lad runs the lookahead, the other -la_share ones\n"));
+    msdk_printf(MSDK_STRING(
+        "                encode with its per-frame QP adjusted to own -b bitrate instead of own BRC\n"));
     msdk_printf(MSDK_STRING("  -vbr          Variable bitrate control\n"));
     msdk_printf(MSDK_STRING("  -cbr          Constant bitrate control\n"));
     msdk_printf(MSDK_STRING("  -vcm          Video Conferencing Mode (VCM) bitrate control\n"));
@@ -450,6 +563,12 @@ void TranscodingSample::PrintHelp() {
         MSDK_STRING("  -FRC::DT      Enables FRC filter with Distributed Timestamp algorithm\n"));
     msdk_printf(
         MSDK_STRING("  -FRC::INTERP  Enables FRC filter with Frame Interpolation algorithm\n"));
+    msdk_printf(MSDK_STRING(
+        "  -dec_skip     Decoder skips frames which -FRC::PT drops to -f rate. For -o::sink session\n"));
+    msdk_printf(MSDK_STRING(
+        "                all the -i::source ones must use -FRC::PT. Skipped frames and decoding\n"));
+    msdk_printf(MSDK_STRING(
+        "                with the skip level of the decoder may lower quality of the kept frames\n"));
     msdk_printf(MSDK_STRING("  -scaling_mode <mode> Specifies scaling mode (lowpower/quality)\n"));
     msdk_printf(MSDK_STRING(
         "  -ec::nv12|rgb4|yuy2|nv16|p010|p210|y210|y410|p016|y216   Forces encoder input to use provided chroma mode\n"));
@@ -511,16 +630,24 @@ void TranscodingSample::PrintHelp() {
         "  -vpp_comp_src_w             Width of this stream in composed stream (should be used in decoder session)\n"));
     msdk_printf(MSDK_STRING(
         "  -vpp_comp_tile_id           Tile_id for current channel of composition (should be used in decoder session)\n"));
+    msdk_printf(MSDK_STRING(
+        "  -vpp_comp_grid <cols> <rows> Lay out streams without -vpp_comp_dst_* in a grid of equal cells covering -w x -h\n"));
+    msdk_printf(MSDK_STRING(
+        "                              of the composed stream, in session order (should be used in composition session)\n"));
     msdk_printf(MSDK_STRING(
         "  -vpp_comp_dump <file-name>  Dump of VPP Composition's output into file. Valid if with -vpp_comp* options\n"));
     msdk_printf(MSDK_STRING(
         "  -vpp_comp_dump null_render  Disabling rendering after VPP Composition. This is for performance measurements\n"));
+    msdk_printf(MSDK_STRING(
+        "  -vpp_comp_dirty             Compose when any stream has a new frame, reusing the last frame of the others\n"));
+    msdk_printf(MSDK_STRING(
+        "                              (should be used in composition session)\n"));
     msdk_printf(MSDK_STRING(
         "  -dec_postproc               Resize after decoder using direct pipe (should be used in decoder session)\n"));
     msdk_printf(
         MSDK_STRING("  -single_texture_d3d11       single texture mode for d3d11 allocator \n"));
     msdk_printf(MSDK_STRING(
-        "  -preset <default,dss,conference,gaming> Use particular preset for encoding parameters\n"));
+        "  -preset <default,dss,conference,gaming,faststart> Use particular preset for encoding parameters\n"));
     msdk_printf(MSDK_STRING("  -pp                         Print preset parameters\n"));
     msdk_printf(MSDK_STRING(
         "  -forceSyncAllSession:<on,off>         Enable across-session synchronization \n"));
@@ -553,6 +680,38 @@ void TranscodingSample::PrintHelp() {
 #endif
     msdk_printf(
         MSDK_STRING("   -syncop_timeout          - SyncOperation timeout in milliseconds\n"));
+    msdk_printf(MSDK_STRING(
+        "   -surf_buffer::list       - pass surfaces between joined sessions via mutex protected list (default)\n"));
+    msdk_printf(MSDK_STRING(
+        "   -surf_buffer::ring <size> - pass surfaces between joined sessions via lock-free ring of <size> surfaces.\n"));
+    msdk_printf(MSDK_STRING(
+        "                              Set on sink sessions for 1->N and on source sessions for N->1 pipelines\n"));
+    msdk_printf(MSDK_STRING(
+        "   -cpu_affinity <cpu-list> - run session threads on given CPUs, e.g. 0-7,16-23. CPUs of NUMA node by default\n"));
+    msdk_printf(MSDK_STRING(
+        "   -numa_node <node>|auto|off - run session threads and allocate system memory surfaces on NUMA node.\n"));
+    msdk_printf(MSDK_STRING(
+        "                              auto (default) - node the adapter is attached to, off - no placement\n"));
+    msdk_printf(MSDK_STRING(
+        "   -sys_mem_pool            - allocate system memory surfaces from huge pages, not zeroed, and reuse freed ones\n"));
+    msdk_printf(MSDK_STRING(
+        "   -alloc_stat              - print memory held by the session allocator and latencies of its Lock and Unlock at the end\n"));
+    msdk_printf(MSDK_STRING(
+        "   -shared_pool             - take encoder surfaces from a pool shared by the sessions of the device, sized to their peak use\n"));
+    msdk_printf(MSDK_STRING(
+        "   -no_shared_decode        - decode input in the session itself. By default sessions with the same input and\n"));
+    msdk_printf(MSDK_STRING(
+        "                              decoder options share one decoding session as with -o::sink and -i::source\n"));
+    msdk_printf(MSDK_STRING(
+        "   -segments <K>            - split input into K segments at random access points (IDR or key frames), transcode them\n"));
+    msdk_printf(MSDK_STRING(
+        "                              in K parallel sessions and join the outputs. Input is h264, h265 or IVF, output is\n"));
+    msdk_printf(MSDK_STRING(
+        "                              h264, h265, mpeg2 or null. Segments are encoded with closed GOPs and spread across\n"));
+    msdk_printf(MSDK_STRING(
+        "                              the adapters as with -adapter_shard\n"));
+    msdk_printf(MSDK_STRING(
+        "   -index_file <file>       - frame index of the input for -segments, built and written to the file once\n"));
     msdk_printf(MSDK_STRING("\n"));
     msdk_printf(MSDK_STRING("ParFile format:\n"));
     msdk_printf(MSDK_STRING(
@@ -646,6 +805,17 @@ CmdProcessor::CmdProcessor() {
     shouldUseGreedyFormula = false;
     bRobustFlag            = false;
     bSoftRobustFlag        = false;
+    m_NumaNode             = NUMA_NODE_AUTO;
+    m_bControlStdin        = false;
+    m_nTaskPoolThreads     = 0;
+    m_nInitThreads         = 1;
+    m_nLatencyStatInterval = 0;
+    m_MetricsFile.clear();
+    m_bEngineUtilization = false;
+    m_bCSPoolSharing     = false;
+    m_dCSAutoMaxScale    = 0;
+    m_bMFEAuto           = false;
+    m_bAdapterSharding   = false;
 
 } //CmdProcessor::CmdProcessor()
 
@@ -672,6 +842,23 @@ msdk_string CmdProcessor::GetLine(mfxU32 n) {
     return msdk_string();
 }
 
+void CmdProcessor::InsertLine(mfxU32 n, const msdk_string& line) {
+    m_lines.insert(m_lines.begin() + std::min<size_t>(n, m_lines.size()), line);
+}
+
+mfxStatus ParseNumaNode(const msdk_char* strInput, mfxI32& node) {
+    if (0 == msdk_strcmp(strInput, MSDK_STRING("auto"))) {
+        node = NUMA_NODE_AUTO;
+    }
+    else if (0 == msdk_strcmp(strInput, MSDK_STRING("off"))) {
+        node = NUMA_NODE_OFF;
+    }
+    else if (MFX_ERR_NONE != msdk_opt_read(strInput, node) || node < 0) {
+        return MFX_ERR_UNSUPPORTED;
+    }
+    return MFX_ERR_NONE;
+}
+
 mfxStatus CmdProcessor::ParseCmdLine(int argc, msdk_char* argv[]) {
     FILE* parFile = NULL;
     mfxStatus sts = MFX_ERR_UNSUPPORTED;
@@ -717,6 +904,88 @@ mfxStatus CmdProcessor::ParseCmdLine(int argc, msdk_char* argv[]) {
         else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-greedy"))) {
             shouldUseGreedyFormula = true;
         }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-cpu_affinity"))) {
+            --argc;
+            ++argv;
+            if (!argv[0] || MFX_ERR_NONE != msdk_parse_cpu_list(argv[0], m_CpuAffinity)) {
+                msdk_printf(MSDK_STRING("error: -cpu_affinity is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-numa_node"))) {
+            --argc;
+            ++argv;
+            if (!argv[0] || MFX_ERR_NONE != ParseNumaNode(argv[0], m_NumaNode)) {
+                msdk_printf(MSDK_STRING("error: -numa_node is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-task_pool"))) {
+            --argc;
+            ++argv;
+            if (argv[0] && 0 == msdk_strcmp(argv[0], MSDK_STRING("auto"))) {
+                m_nTaskPoolThreads = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            else if (!argv[0] || MFX_ERR_NONE != msdk_opt_read(argv[0], m_nTaskPoolThreads) ||
+                     !m_nTaskPoolThreads) {
+                msdk_printf(MSDK_STRING("error: -task_pool is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-init_threads"))) {
+            --argc;
+            ++argv;
+            if (argv[0] && 0 == msdk_strcmp(argv[0], MSDK_STRING("auto"))) {
+                m_nInitThreads = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            else if (!argv[0] || MFX_ERR_NONE != msdk_opt_read(argv[0], m_nInitThreads) ||
+                     !m_nInitThreads) {
+                msdk_printf(MSDK_STRING("error: -init_threads is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-control::stdin"))) {
+            m_bControlStdin = true;
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-latency_stat"))) {
+            --argc;
+            ++argv;
+            if (!argv[0] || MFX_ERR_NONE != msdk_opt_read(argv[0], m_nLatencyStatInterval) ||
+                !m_nLatencyStatInterval) {
+                msdk_printf(MSDK_STRING("error: -latency_stat is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-metrics"))) {
+            --argc;
+            ++argv;
+            if (!argv[0]) {
+                msdk_printf(MSDK_STRING("error: no argument given for 'metrics' option\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+            m_MetricsFile = argv[0];
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-engine_util"))) {
+            m_bEngineUtilization = true;
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-cs_share_pools"))) {
+            m_bCSPoolSharing = true;
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-cs_auto"))) {
+            --argc;
+            ++argv;
+            if (!argv[0] || MFX_ERR_NONE != msdk_opt_read(argv[0], m_dCSAutoMaxScale) ||
+                m_dCSAutoMaxScale < 1) {
+                msdk_printf(MSDK_STRING("error: -cs_auto is invalid\n"));
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-mfe_auto"))) {
+            m_bMFEAuto = true;
+        }
+        else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-adapter_shard"))) {
+            m_bAdapterSharding = true;
+        }
         else if (0 == msdk_strcmp(argv[0], MSDK_STRING("-p"))) {
             if (m_PerfFILE) {
                 msdk_printf(MSDK_STRING("error: only one performance file is supported"));
@@ -1439,6 +1708,12 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
              0 == msdk_strcmp(argv[i], MSDK_STRING("-MemType::system"))) {
         InputParams.bForceSysMem = true;
     }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-read_ahead"))) {
+        InputParams.bPrefetchInput = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-async_write"))) {
+        InputParams.bAsyncWriter = true;
+    }
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-opaq")) ||
              0 == msdk_strcmp(argv[i], MSDK_STRING("-MemType::opaque"))) {
         msdk_printf(MSDK_STRING(
@@ -1507,7 +1782,6 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-trace"))) {
         InputParams.EnableTracing = true;
     }
-#if (defined(_WIN64) || defined(_WIN32))
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-dual_gfx::on"))) {
         InputParams.isDualMode = true;
         InputParams.hyperMode  = MFX_HYPERMODE_ON;
@@ -1520,7 +1794,6 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
         InputParams.isDualMode = true;
         InputParams.hyperMode  = MFX_HYPERMODE_ADAPTIVE;
     }
-#endif
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-idr_interval"))) {
         VAL_CHECK(i + 1 >= argc, i, argv[i]);
         if (MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.nIdrInterval)) {
@@ -1652,6 +1925,12 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
         }
     }
     #endif
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-enc_stats"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        i++;
+        SIZE_CHECK((msdk_strlen(argv[i]) + 1) > MSDK_ARRAY_LEN(InputParams.strEncodeStatsFile));
+        msdk_opt_read(argv[i], InputParams.strEncodeStatsFile);
+    }
 #endif
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-ivf:on"))) {
         InputParams.nIVFHeader = MFX_CODINGOPTION_ON;
@@ -1669,6 +1948,64 @@ mfxStatus ParseAdditionalParams(msdk_char* argv[],
             return MFX_ERR_UNSUPPORTED;
         }
     }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-cpu_affinity"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        if (MFX_ERR_NONE != msdk_parse_cpu_list(argv[++i], InputParams.CpuAffinity)) {
+            PrintError(MSDK_STRING("cpu_affinity \"%s\" is invalid"), argv[i]);
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-numa_node"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        if (MFX_ERR_NONE != ParseNumaNode(argv[++i], InputParams.NumaNode)) {
+            PrintError(MSDK_STRING("numa_node \"%s\" is invalid"), argv[i]);
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-sys_mem_pool"))) {
+        InputParams.bSysMemPool = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-alloc_stat"))) {
+        InputParams.bAllocStatistics = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-shared_pool"))) {
+        InputParams.bSharedSurfacePool = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-segments"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        if (MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.nSegments) ||
+            0 == InputParams.nSegments) {
+            PrintError(MSDK_STRING("segments number is invalid"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-index_file"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        InputParams.IndexFile = argv[++i];
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-surf_buffer::list"))) {
+        InputParams.nSurfBufferRingSize = 0;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-surf_buffer::ring"))) {
+        VAL_CHECK(i + 1 == argc, i, argv[i]);
+        if (MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.nSurfBufferRingSize) ||
+            0 == InputParams.nSurfBufferRingSize) {
+            PrintError(MSDK_STRING("surf_buffer::ring size is invalid"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-no_shared_decode"))) {
+        InputParams.bNoSharedDecode = true;
+    }
+    else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-vpp_comp_grid"))) {
+        VAL_CHECK(i + 2 >= argc, i, argv[i]);
+        if (MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.nVppCompGridCols) ||
+            MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.nVppCompGridRows) ||
+            0 == InputParams.nVppCompGridCols || 0 == InputParams.nVppCompGridRows) {
+            PrintError(MSDK_STRING("vpp_comp_grid is invalid"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
     else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-api_ver_init::1x"))) {
         InputParams.verSessionInit = API_1X;
     }
@@ -1880,6 +2217,8 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
         InputParams.bSoftRobustFlag = true;
 
     InputParams.shouldUseGreedyFormula = shouldUseGreedyFormula;
+    InputParams.CpuAffinity            = m_CpuAffinity;
+    InputParams.NumaNode               = m_NumaNode;
 
     InputParams.statisticsWindowSize = statisticsWindowSize;
     InputParams.statisticsLogFile    = statisticsLogFile;
@@ -2048,6 +2387,22 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+#if !defined(_WIN32) && !defined(_WIN64)
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-threads_schedtype"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            if (MFX_ERR_NONE != msdk_thread_get_schedtype(argv[++i], InputParams.SchedulingType)) {
+                PrintError(MSDK_STRING("threads_schedtype \"%s\" is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-threads_priority"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            if (MFX_ERR_NONE != msdk_opt_read(argv[++i], InputParams.Priority)) {
+                PrintError(MSDK_STRING("threads_priority \"%s\" is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+#endif
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-f"))) {
             VAL_CHECK(i + 1 == argc, i, argv[i]);
             i++;
@@ -2282,6 +2637,30 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
                 return MFX_ERR_UNSUPPORTED;
             }
         }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-async_adaptive"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            if (MFX_ERR_NONE != msdk_opt_read(argv[i], InputParams.nAsyncDepthMin) ||
+                !InputParams.nAsyncDepthMin) {
+                PrintError(MSDK_STRING("async_adaptive \"%s\" is invalid"), argv[i]);
+                return MFX_ERR_UNSUPPORTED;
+            }
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-low_latency"))) {
+            InputParams.bLowLatency = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-latency_log"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            SIZE_CHECK((msdk_strlen(argv[i]) + 1) > MSDK_ARRAY_LEN(InputParams.strLatencyLogFile));
+            msdk_opt_read(argv[i], InputParams.strLatencyLogFile);
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-quality"))) {
+            VAL_CHECK(i + 1 == argc, i, argv[i]);
+            i++;
+            SIZE_CHECK((msdk_strlen(argv[i]) + 1) > MSDK_ARRAY_LEN(InputParams.strQualityFile));
+            msdk_opt_read(argv[i], InputParams.strQualityFile);
+        }
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-join"))) {
             InputParams.bIsJoin = true;
         }
@@ -2338,6 +2717,9 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
             if (InputParams.eModeExt == Native)
                 InputParams.eModeExt = VppCompOnly;
         }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-vpp_comp_dirty"))) {
+            InputParams.bVppCompDirty = true;
+        }
         else if (0 == msdk_strncmp(MSDK_STRING("-vpp_comp_dump"),
                                    argv[i],
                                    msdk_strlen(MSDK_STRING("-vpp_comp_dump")))) {
@@ -2544,6 +2926,12 @@ mfxStatus CmdProcessor::ParseParamsForOneSession(mfxU32 argc, msdk_char* argv[])
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-la_ext"))) {
             InputParams.bEnableExtLA = true;
         }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-la_share"))) {
+            InputParams.bLaShare = true;
+        }
+        else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-dec_skip"))) {
+            InputParams.bDecSkip = true;
+        }
         else if (0 == msdk_strcmp(argv[i], MSDK_STRING("-la"))) {
             InputParams.bLABRC             = true;
             InputParams.nRateControlMethod = MFX_RATECONTROL_LA;
@@ -2885,6 +3273,32 @@ mfxStatus CmdProcessor::VerifyAndCorrectInputParams(TranscodingSample::sInputPar
         return MFX_ERR_UNSUPPORTED;
     }
 
+    if ((InputParams.FRCAlgorithm || InputParams.bEnableDeinterlacing) && InputParams.bLaShare) {
+        PrintError(MSDK_STRING("-la_share can't be used with FRC and deinterlace options\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    if (InputParams.bVppCompDirty &&
+        (Source != InputParams.eMode ||
+         (VppComp != InputParams.eModeExt && VppCompOnly != InputParams.eModeExt))) {
+        PrintError(MSDK_STRING(
+            "-vpp_comp_dirty should be used in session with -i::source and -vpp_comp or -vpp_comp_only\n"));
+        return MFX_ERR_UNSUPPORTED;
+    }
+
+    if (InputParams.bDecSkip) {
+        if (Source == InputParams.eMode) {
+            PrintError(MSDK_STRING("-dec_skip can't be used with -i::source\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (Native == InputParams.eMode &&
+            (MFX_FRCALGM_PRESERVE_TIMESTAMP != InputParams.FRCAlgorithm ||
+             !InputParams.dVPPOutFramerate)) {
+            PrintError(MSDK_STRING("-dec_skip requires -FRC::PT and -f\n"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+    }
+
     if (InputParams.nQuality && InputParams.EncodeId && (MFX_CODEC_JPEG != InputParams.EncodeId)) {
         PrintError(MSDK_STRING("-q option is supported only for JPEG encoder\n"));
         return MFX_ERR_UNSUPPORTED;
@@ -2910,6 +3324,28 @@ mfxStatus CmdProcessor::VerifyAndCorrectInputParams(TranscodingSample::sInputPar
         InputParams.nAsyncDepth = 1;
     }
 
+    if (InputParams.bLowLatency) {
+        if (InputParams.nAsyncDepth > 1 || InputParams.nAsyncDepthMin) {
+            PrintError(MSDK_STRING("-low_latency can't be used with -async and -async_adaptive"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (InputParams.GopRefDist > 1) {
+            PrintError(MSDK_STRING("-low_latency doesn't support B-frames, -dist must be 1"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        if (InputParams.bLABRC || InputParams.nLADepth || InputParams.bEnableExtLA ||
+            InputParams.nRateControlMethod == MFX_RATECONTROL_LA ||
+            InputParams.nRateControlMethod == MFX_RATECONTROL_LA_EXT ||
+            InputParams.nRateControlMethod == MFX_RATECONTROL_LA_ICQ ||
+            InputParams.nRateControlMethod == MFX_RATECONTROL_LA_HRD) {
+            PrintError(MSDK_STRING("-low_latency can't be used with lookahead"));
+            return MFX_ERR_UNSUPPORTED;
+        }
+        // presets don't override parameters which are set already
+        InputParams.nAsyncDepth = 1;
+        InputParams.GopRefDist  = 1;
+    }
+
     // For decoder session of inter-session case, let's set AsyncDepth to 4 by default
     if (InputParams.eMode == Sink && !InputParams.nAsyncDepth) {
         InputParams.nAsyncDepth = 4;
@@ -3028,6 +3464,28 @@ mfxStatus CmdProcessor::VerifyAndCorrectInputParams(TranscodingSample::sInputPar
             "WARNING: forceSyncAllSession option is not valid for general memory type, this parameter will be ignored.\n"));
     }
 
+    // with system memory the frames would be uploaded to every adapter through CPU
+    if (InputParams.isDualMode && InputParams.hyperMode != MFX_HYPERMODE_OFF) {
+        if (InputParams.bForceSysMem ||
+            InputParams.DecOutPattern == MFX_IOPATTERN_OUT_SYSTEM_MEMORY ||
+            InputParams.VppOutPattern == MFX_IOPATTERN_OUT_SYSTEM_MEMORY) {
+            msdk_printf(MSDK_STRING(
+                "WARNING: HyperMode shares video memory between adapters, system memory options will be ignored.\n"));
+            InputParams.bForceSysMem = false;
+            if (InputParams.DecOutPattern == MFX_IOPATTERN_OUT_SYSTEM_MEMORY)
+                InputParams.DecOutPattern = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+            if (InputParams.VppOutPattern == MFX_IOPATTERN_OUT_SYSTEM_MEMORY)
+                InputParams.VppOutPattern = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
+        }
+#if (defined(_WIN32) || defined(_WIN64))
+        if (MFX_IMPL_VIA_MASK(InputParams.libType) == MFX_IMPL_VIA_D3D9) {
+            msdk_printf(
+                MSDK_STRING("WARNING: HyperMode requires D3D11, -hw_d3d9 will be ignored.\n"));
+            InputParams.libType = MFX_IMPL_HARDWARE_ANY | MFX_IMPL_VIA_D3D11;
+        }
+#endif
+    }
+
 #if (defined(_WIN32) || defined(_WIN64))
     if (InputParams.bPrefferiGfx && InputParams.bPrefferdGfx) {
         msdk_printf(MSDK_STRING("WARNING: both dGfx and iGfx flags set. iGfx will be preffered\n"));
@@ -3083,3 +3541,42 @@ bool CmdProcessor::GetNextSessionParams(TranscodingSample::sInputParams& InputPa
     return true;
 
 } //bool  CmdProcessor::GetNextSessionParams(TranscodingSample::sInputParams &InputParams)
+
+mfxStatus CmdProcessor::ParseSessionLine(const msdk_string& line,
+                                         TranscodingSample::sInputParams& InputParams) {
+    size_t numLines    = m_lines.size();
+    size_t numSessions = m_SessionArray.size();
+
+    std::vector<msdk_char> buf(line.begin(), line.end());
+    buf.push_back(0);
+
+    mfxStatus sts = TokenizeLine(buf.data(), (mfxU32)line.length());
+    if (sts == MFX_ERR_NONE && m_SessionArray.size() == numSessions) {
+        PrintError(MSDK_STRING("No session options given"));
+        sts = MFX_ERR_UNSUPPORTED;
+    }
+
+    if (sts != MFX_ERR_NONE) {
+        // keep lines aligned with sessions, they are printed in the results
+        m_lines.resize(numLines);
+        m_SessionArray.resize(numSessions);
+        return sts;
+    }
+
+    InputParams      = m_SessionArray.back();
+    m_SessionParamId = (mfxU32)m_SessionArray.size();
+
+    return MFX_ERR_NONE;
+
+} //mfxStatus CmdProcessor::ParseSessionLine()
+
+void CmdProcessor::RemoveLastSession() {
+    if (m_SessionArray.empty())
+        return;
+
+    m_SessionArray.pop_back();
+    if (!m_lines.empty())
+        m_lines.pop_back();
+    m_SessionParamId = (mfxU32)m_SessionArray.size();
+
+} //void CmdProcessor::RemoveLastSession()
@@ -0,0 +1,59 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SAMPLE_VPP_FANOUT_H
+#define __SAMPLE_VPP_FANOUT_H
+
+#include <list>
+#include <memory>
+#include <vector>
+#include "sample_vpp_utils.h"
+
+// Produces additional outputs of other sizes from the input frames of the main VPP. Each output
+// is scaled by a VPP of its own session cloned from the main one, the sessions share the allocator,
+// so an input frame is read and uploaded once for all outputs.
+class CVPPFanOut {
+public:
+    CVPPFanOut();
+    ~CVPPFanOut();
+
+    // pMainParams are the parameters the main VPP is initialized with
+    mfxStatus Init(sAppResources* pResources, const mfxVideoParam* pMainParams);
+    void Close();
+
+    // submits the input frame to all outputs, frames are written once asyncDepth of them are in
+    // processing
+    mfxStatus Process(mfxFrameSurfaceWrap* pInSurface);
+    // writes the frames left in processing
+    mfxStatus Flush();
+
+    void PrintStatistics() const;
+
+protected:
+    struct sOutput {
+        mfxSession session;
+        std::unique_ptr<MFXVideoVPP> pVPP;
+        MfxVideoParamsWrapper params;
+        mfxFrameAllocResponse response;
+        std::unique_ptr<mfxFrameSurfaceWrap[]> pSurfaces; // response.NumFrameActual of them
+        GeneralWriter writer;
+        std::list<std::pair<mfxSyncPoint, mfxFrameSurfaceWrap*>> syncPoints;
+        mfxU32 nFrames;
+    };
+
+    mfxStatus InitOutput(sOutput& output, const sFanOutParam& fanOutParam);
+    // writes frames in processing but the nPending submitted last
+    mfxStatus WriteFrames(sOutput& output, size_t nPending);
+
+    sAppResources* m_pResources;
+    std::vector<std::unique_ptr<sOutput>> m_Outputs;
+    mfxVideoParam m_MainParams;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CVPPFanOut);
+};
+
+#endif /* __SAMPLE_VPP_FANOUT_H */
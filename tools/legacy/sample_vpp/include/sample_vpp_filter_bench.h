@@ -0,0 +1,21 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SAMPLE_VPP_FILTER_BENCH_H
+#define __SAMPLE_VPP_FILTER_BENCH_H
+
+#include "sample_vpp_utils.h"
+
+// Measures the cost of each filter of the chain. The preloaded input is processed by the chain
+// with the filters added one at a time, starting with none of them (scaling and color conversion
+// only), and throughput of every run is printed with its increment over the previous run.
+// pParams are the parameters of the whole chain the VPP is initialized with.
+mfxStatus RunFilterBenchmark(sAppResources* pResources,
+                             CRawVideoReader* pReader,
+                             mfxFrameInfo* pInFrameInfo,
+                             mfxVideoParam* pParams);
+
+#endif /* __SAMPLE_VPP_FILTER_BENCH_H */
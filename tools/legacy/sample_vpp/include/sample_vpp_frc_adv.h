@@ -10,8 +10,10 @@
 #include <stdio.h>
 #include <list>
 #include <memory>
+#include <vector>
 
 #include "sample_vpp_frc.h"
+#include "vm/strings_defs.h"
 #include "vpl/mfxvideo.h"
 
 #ifndef MFX_VERSION
@@ -53,4 +55,49 @@ private:
     std::list<mfxU64> m_ptsList;
 };
 
+// Converts frames with time stamps of a variable frame rate source to a constant frame rate as
+// the advanced FRC does. Every frame is dropped or output once per time slot of the output it
+// covers right when it comes, so nothing but the frame itself is held.
+class FRCStreamingConverter {
+public:
+    FRCStreamingConverter();
+
+    // algorithm - MFX_FRCALGM_PRESERVE_TIMESTAMP or MFX_FRCALGM_DISTRIBUTED_TIMESTAMP
+    mfxStatus Init(mfxU32 frameRateExtN, mfxU32 frameRateExtD, mfxU16 algorithm);
+
+    // returns number of output frames of the frame, 0 if it's dropped
+    mfxU32 PutFrame(mfxU64 timeStamp);
+
+    // time stamp of output frame copyIndex of the last frame
+    mfxU64 GetOutputTimeStamp(mfxU32 copyIndex) const;
+
+    void PrintStatistics() const;
+
+private:
+    mfxU64 GetSlotTimeStamp(mfxU32 slot) const;
+
+    mfxU32 m_FRateExtN;
+    mfxU32 m_FRateExtD;
+    mfxU16 m_algorithm;
+
+    // half of output frame period, input frames are moved to the time slots by it at most
+    mfxU64 m_minDeltaTime;
+
+    bool m_bIsSetTimeOffset;
+    // time stamp of output slot m_baseSlot, set again on time stamp discontinuity
+    mfxU64 m_timeOffset;
+    mfxU32 m_baseSlot;
+    mfxU32 m_numSlots;
+
+    mfxU64 m_lastTimeStamp;
+    mfxU32 m_lastFirstSlot;
+
+    mfxU32 m_numInputFrames;
+    mfxU32 m_numDropped;
+    mfxU32 m_numRepeated;
+};
+
+// reads time stamps in milliseconds, one per line (Matroska timecode format v2), to 90 kHz units
+mfxStatus LoadTimeCodes(const msdk_char* fileName, std::vector<mfxU64>& timeStamps);
+
 #endif /* __SAMPLE_VPP_PTS_ADV_H*/
@@ -0,0 +1,61 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SAMPLE_VPP_INPUT_LOADER_H
+#define __SAMPLE_VPP_INPUT_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "sample_vpp_utils.h"
+
+// Loads frames of the composition inputs in parallel, each input by a thread of its own which keeps
+// up to RING_SIZE frames loaded ahead of processing. Surfaces are locked by the threads, so the
+// allocator must allow it from several threads.
+class CParallelInputLoader {
+public:
+    static const mfxU16 RING_SIZE = 2;
+
+    CParallelInputLoader();
+    ~CParallelInputLoader();
+
+    mfxStatus Init(sMemoryAllocator* pAllocator,
+                   CRawVideoReader* pReaders,
+                   mfxFrameInfo* pFrameInfos,
+                   mfxU16 numStreams);
+    void Close();
+
+    // waits for the next frame of the stream, returns MFX_ERR_MORE_DATA at the end of it. The
+    // surface isn't reused for loading till the next call for the stream.
+    mfxStatus GetNextInputFrame(mfxU16 streamIndex, mfxFrameSurfaceWrap** ppSurface);
+
+protected:
+    struct sStream {
+        CRawVideoReader* pReader;
+        mfxFrameInfo* pFrameInfo;
+        std::thread thread;
+        std::deque<mfxFrameSurfaceWrap*> loaded;
+        mfxFrameSurfaceWrap* pCurrent; // returned by the last GetNextInputFrame
+        mfxStatus sts; // loading stopped with
+    };
+
+    void LoaderRoutine(mfxU16 streamIndex);
+
+    sMemoryAllocator* m_pAllocator;
+    std::vector<std::unique_ptr<sStream>> m_Streams;
+    std::mutex m_mutex;
+    std::condition_variable m_cvLoaded; // a frame is loaded or loading stopped
+    std::condition_variable m_cvTaken; // a frame is taken from a ring
+    bool m_bStop;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(CParallelInputLoader);
+};
+
+#endif /* __SAMPLE_VPP_INPUT_LOADER_H */
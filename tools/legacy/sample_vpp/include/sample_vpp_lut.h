@@ -0,0 +1,50 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#ifndef __SAMPLE_VPP_LUT_H
+#define __SAMPLE_VPP_LUT_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "sample_defs.h"
+#include "vpl/mfxvideo.h"
+
+// 3D LUTs read from files. A file is read once, and the tables of the same size and contents are
+// kept in memory once, so all the VPP parameters using a table (resets, sessions of the process)
+// point the library to the same buffer of it.
+class C3DLutCache {
+public:
+    C3DLutCache();
+
+    // fills the system buffer of pLut with the table of size^3 nodes from the file, the nodes are
+    // 16-bit triples of the 3 channels
+    mfxStatus Get3DLut(const msdk_tstring& strFile, mfxU32 size, mfxExtVPP3DLut* pLut);
+
+    void Clear();
+
+    void PrintStatistics() const;
+
+protected:
+    struct sTable {
+        mfxU32 size;
+        mfxU64 hash;
+        std::vector<mfxU16> channels[3];
+    };
+
+    mfxStatus LoadTable(const msdk_tstring& strFile, mfxU32 size, std::shared_ptr<sTable>& pTable);
+
+    std::map<msdk_tstring, std::shared_ptr<sTable>> m_TablesByFile;
+    std::multimap<mfxU64, std::shared_ptr<sTable>> m_TablesByHash;
+
+    mfxU32 m_numRequests;
+    mfxU32 m_numFilesRead;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(C3DLutCache);
+};
+
+#endif /* __SAMPLE_VPP_LUT_H */
@@ -131,6 +131,21 @@ typedef struct _filtersParam {
     sColorFillParam* pColorfillParam;
 } sFiltersParam;
 
+// additional output scaled from the input frames, see -fanout
+struct sFanOutParam {
+    mfxU16 nWidth;
+    mfxU16 nHeight;
+    msdk_tstring strDstFile;
+};
+
+// 3D LUT from a file, see -3dlut
+struct s3DLutParam {
+    FilterConfig mode;
+    mfxU32 size;
+    msdk_tstring strFile;
+    s3DLutParam() : mode(VPP_FILTER_DISABLED), size(0), strFile() {}
+};
+
 struct sInputParams {
     /* smart filters defined by mismatch btw src & dst */
     std::vector<sOwnFrameInfo> frameInfoIn; // [0] - in, [1] - out
@@ -190,6 +205,11 @@ struct sInputParams {
     mfxI32 adapterNum;
     bool dispFullSearch;
 
+    mfxU16 nThreadsNum; // threads of the CPU implementation
+    mfxI32 SchedulingType;
+    mfxI32 Priority;
+    std::vector<mfxU32> CpuAffinity; // CPUs of the application and runtime threads
+
     #if (defined(_WIN64) || defined(_WIN32)) && (MFX_VERSION >= 1031)
     bool bPrefferdGfx;
     bool bPrefferiGfx;
@@ -199,6 +219,7 @@ struct sInputParams {
     mfxU32 vaType;
 
     std::vector<mfxU16> rotate;
+    std::vector<s3DLutParam> lut3DParam;
 
     bool bScaling;
     mfxU16 scalingMode;
@@ -220,6 +241,10 @@ struct sInputParams {
     bool ptsAdvanced;
     mfxF64 ptsFR;
 
+    /* streaming FRC of variable frame rate input */
+    msdk_tstring strFRCTimeCodesFile;
+    mfxU16 frcStreamAlgorithm;
+
     /* roi checking parameters */
     sROICheckParam roiCheckParam;
 
@@ -243,6 +268,7 @@ struct sInputParams {
     /* ********************** */
     msdk_char strSrcFile[MSDK_MAX_FILENAME_LEN];
     std::vector<msdk_tstring> strDstFiles;
+    std::vector<sFanOutParam> fanOut;
 
     msdk_char strPerfFile[MSDK_MAX_FILENAME_LEN];
     mfxU32 forcedOutputFourcc;
@@ -258,6 +284,12 @@ struct sInputParams {
     mfxU32 fccSource;
     eAPIVersion verSessionInit;
     bool bReadByFrame;
+    mfxU32 readChunkFrames;
+    bool bDirectIO;
+    bool bFilterBench;
+    bool bParallelLoad;
+    bool bPersistentMapping;
+    bool bAllocStatistics;
 
     sInputParams() {
         IOPattern           = 0;
@@ -277,6 +309,7 @@ struct sInputParams {
         ptsJump             = false;
         ptsAdvanced         = false;
         ptsFR               = 0;
+        frcStreamAlgorithm  = 0;
         forcedOutputFourcc  = 0;
         numStreams          = 0;
 
@@ -290,6 +323,7 @@ struct sInputParams {
         MSDK_ZERO_MEMORY(strSrcFile);
         MSDK_ZERO_MEMORY(strPerfFile);
         strDstFiles.clear();
+        fanOut.clear();
         uChromaSiting = 0;
         bChromaSiting = false;
         fccSource     = 0;
@@ -309,10 +343,20 @@ struct sInputParams {
         dGfxIdx        = -1;
         adapterNum     = -1;
         dispFullSearch = DEF_DISP_FULLSEARCH;
+        nThreadsNum    = 0;
+        SchedulingType = 0;
+        Priority       = 0;
         frameInfoIn.clear(); //redundant, for the benefit of picky static analyzers
         frameInfoOut.clear();
         verSessionInit = API_2X;
-        bReadByFrame   = false;
+        bReadByFrame    = false;
+        readChunkFrames = 0;
+        bDirectIO       = false;
+        bFilterBench    = false;
+        bParallelLoad   = false;
+
+        bPersistentMapping = false;
+        bAllocStatistics   = false;
     }
 };
 
@@ -331,6 +375,7 @@ struct sMemoryAllocator {
     MFXFrameAllocator* pMfxAllocator;
     mfxAllocatorParams* pAllocatorParams;
     bool bUsedAsExternalAllocator;
+    bool bPrintStatistics; // of the allocator when it's deleted
 
     mfxFrameSurfaceWrap* pSurfacesIn[MAX_INPUT_STREAMS]; // SINGLE_IN/OUT/MULTIPLE_INs
     mfxFrameSurfaceWrap* pSurfacesOut;
@@ -365,11 +410,19 @@ public:
 
     void Close();
 
-    mfxStatus Init(const msdk_char* strFileName, PTSMaker* pPTSMaker, mfxU32 fcc);
+    // with chunkSize the file is read by blocks of the size instead of a call to the OS per row,
+    // with bDirectIO (Linux only) the blocks bypass the page cache
+    mfxStatus Init(const msdk_char* strFileName,
+                   PTSMaker* pPTSMaker,
+                   mfxU32 fcc,
+                   mfxU32 chunkSize = 0,
+                   bool bDirectIO   = false);
 
     mfxStatus PreAllocateFrameChunk(mfxVideoParam* pVideoParam,
                                     sInputParams* pParams,
                                     MFXFrameAllocator* pAllocator);
+    // restarts output of the preallocated frames for nRepeat more passes
+    void RewindPreAllocFrames(mfxU16 nRepeat);
 
     mfxStatus GetNextInputFrame(sMemoryAllocator* pAllocator,
                                 mfxFrameInfo* pInfo,
@@ -385,8 +438,17 @@ public:
 
 private:
     mfxStatus GetPreAllocFrame(mfxFrameSurfaceWrap** pSurface);
+    // returns the number of bytes read
+    mfxU32 Read(mfxU8* pDst, mfxU32 size);
+    bool FillChunk();
 
     FILE* m_fSrc;
+    int m_fdDirect; // file opened for direct IO, -1 if none
+    std::vector<mfxU8> m_ChunkBuffer;
+    mfxU8* m_pChunk; // in m_ChunkBuffer aligned for direct IO
+    mfxU32 m_chunkSize;
+    mfxU32 m_chunkFilled;
+    mfxU32 m_chunkPos;
     std::list<mfxFrameSurfaceWrap>::iterator m_it;
     std::list<mfxFrameSurfaceWrap> m_SurfacesList;
     bool m_isPerfMode;
@@ -460,6 +522,11 @@ public:
     std::list<SyncPair> m_SyncPoints;
 };
 
+class CVPPFanOut;
+class CParallelInputLoader;
+class FRCStreamingConverter;
+class C3DLutCache;
+
 struct sAppResources {
     CRawVideoReader* pSrcFileReaders[MAX_INPUT_STREAMS];
     mfxU16 numSrcFiles;
@@ -473,6 +540,10 @@ struct sAppResources {
     sMemoryAllocator* pAllocator;
     sInputParams* pParams;
     SurfaceVPPStore* pSurfStore;
+    CVPPFanOut* pFanOut;
+    CParallelInputLoader* pInputLoader;
+    FRCStreamingConverter* pFRCStreamer;
+    C3DLutCache* p3DLutCache;
 
     // number of video enhancement filters (denoise, procamp, detail, video_analysis, multi_view, ste, istab, tcc, ace, svc)
     constexpr static uint32_t ENH_FILTERS_COUNT = 20;
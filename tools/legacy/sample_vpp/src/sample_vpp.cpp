@@ -4,6 +4,10 @@
   # SPDX-License-Identifier: MIT
   ############################################################################*/
 
+#include "sample_vpp_fanout.h"
+#include "sample_vpp_filter_bench.h"
+#include "sample_vpp_input_loader.h"
+#include "sample_vpp_lut.h"
 #include "sample_vpp_pts.h"
 #include "sample_vpp_roi.h"
 #include "sample_vpp_utils.h"
@@ -92,6 +96,8 @@ static void vppDefaultInitParams(sInputParams* pParams, sFiltersParam* pDefaultF
     pParams->vaType      = ALLOC_IMPL_VIA_SYS;
     pParams->rotate.clear();
     pParams->rotate.push_back(0);
+    pParams->lut3DParam.clear();
+    pParams->lut3DParam.push_back(s3DLutParam());
     pParams->bScaling            = false;
     pParams->scalingMode         = MFX_SCALING_MODE_DEFAULT;
     pParams->interpolationMethod = MFX_INTERPOLATION_DEFAULT;
@@ -170,18 +176,23 @@ void SaveRealInfoForSvcOut(sSVCLayerDescr in[8], mfxFrameInfo out[8], mfxU32 fou
 
 } // void SaveRealInfoForSvcOut(sSVCLayerDescr in[8], mfxFrameInfo out[8])
 
+// nPending frames submitted last are left in processing
 mfxStatus OutputProcessFrame(sAppResources Resources,
                              mfxFrameInfo* pOutFrameInfo,
                              mfxU32& nFrames,
-                             mfxU32 paramID) {
+                             mfxU32 paramID,
+                             size_t nPending = 0) {
     mfxStatus sts;
     mfxFrameSurfaceWrap* pProcessedSurface;
 
-    for (; !Resources.pSurfStore->m_SyncPoints.empty();
+    for (; Resources.pSurfStore->m_SyncPoints.size() > nPending;
          Resources.pSurfStore->m_SyncPoints.pop_front()) {
-        sts = Resources.pProcessor->mfxSession.SyncOperation(
-            Resources.pSurfStore->m_SyncPoints.front().first,
-            MSDK_VPP_WAIT_INTERVAL);
+        {
+            MFX_ITT_TASK("SyncOperation");
+            sts = Resources.pProcessor->mfxSession.SyncOperation(
+                Resources.pSurfStore->m_SyncPoints.front().first,
+                MSDK_VPP_WAIT_INTERVAL);
+        }
         if (sts == MFX_WRN_IN_EXECUTION) {
             msdk_printf(MSDK_STRING("SyncOperation wait interval exceeded\n"));
         }
@@ -189,7 +200,15 @@ mfxStatus OutputProcessFrame(sAppResources Resources,
 
         pProcessedSurface = Resources.pSurfStore->m_SyncPoints.front().second.pSurface;
 
-        if (!Resources.pParams->strDstFiles.empty()) {
+        mfxU32 nCopies = Resources.pFRCStreamer
+                             ? Resources.pFRCStreamer->PutFrame(pProcessedSurface->Data.TimeStamp)
+                             : 1;
+        for (mfxU32 i = 0; i < nCopies && MFX_ERR_NONE == sts; i++) {
+            if (Resources.pFRCStreamer)
+                pProcessedSurface->Data.TimeStamp = Resources.pFRCStreamer->GetOutputTimeStamp(i);
+            if (Resources.pParams->strDstFiles.empty())
+                continue;
+
             GeneralWriter* writer = (1 == Resources.dstFileWritersN)
                                         ? &Resources.pDstFileWriters[0]
                                         : &Resources.pDstFileWriters[paramID];
@@ -206,7 +225,7 @@ mfxStatus OutputProcessFrame(sAppResources Resources,
             msdk_printf(MSDK_STRING("Failed to write frame to disk\n"));
         MSDK_CHECK_NOT_EQUAL(sts, MFX_ERR_NONE, MFX_ERR_ABORTED);
 
-        nFrames++;
+        nFrames += nCopies;
 
         //VPP progress
         if (!Resources.pParams->bPerf) {
@@ -221,6 +240,25 @@ mfxStatus OutputProcessFrame(sAppResources Resources,
 
 } // mfxStatus OutputProcessFrame(
 
+// Outputs the oldest frames in processing while the pool has no free surface. The library unlocks
+// surfaces of a frame once it's processed, so the sync returns as soon as a surface is released
+// and GetFreeSurface doesn't sleep on the pool.
+mfxStatus WaitForFreeSurface(sAppResources& Resources,
+                             mfxFrameSurfaceWrap* pSurfacesPool,
+                             mfxU16 nPoolSize,
+                             mfxFrameInfo* pOutFrameInfo,
+                             mfxU32& nFrames,
+                             mfxU32 paramID) {
+    std::list<SurfaceVPPStore::SyncPair>& syncPoints = Resources.pSurfStore->m_SyncPoints;
+    while (!syncPoints.empty() &&
+           MSDK_INVALID_SURF_IDX == GetFreeSurfaceIndex(pSurfacesPool, nPoolSize)) {
+        mfxStatus sts =
+            OutputProcessFrame(Resources, pOutFrameInfo, nFrames, paramID, syncPoints.size() - 1);
+        MSDK_CHECK_STATUS(sts, "OutputProcessFrame failed");
+    }
+    return MFX_ERR_NONE;
+}
+
 void ownToMfxFrameInfo(sOwnFrameInfo* in, mfxFrameInfo* out, bool copyCropParams = false) {
     out->Width  = in->nWidth;
     out->Height = in->nHeight;
@@ -304,9 +342,15 @@ int main(int argc, msdk_char* argv[])
     mfxU32 numGetFrames = 0;
 
     SurfaceVPPStore surfStore;
+    CVPPFanOut fanOut;
+    CParallelInputLoader inputLoader;
+    C3DLutCache lutCache;
 
     unique_ptr<PTSMaker> ptsMaker;
 
+    FRCStreamingConverter frcStreamer;
+    std::vector<mfxU64> inputTimeStamps;
+
     /* generators for ROI testing */
     ROIGenerator inROIGenerator;
     ROIGenerator outROIGenerator;
@@ -387,11 +431,12 @@ int main(int argc, msdk_char* argv[])
         Resources.pSrcFileReaders[i] = &yuvReaders[i];
     }
 
-    Resources.pProcessor = &frameProcessor;
-    Resources.pAllocator = &allocator;
-    Resources.pVppParams = &mfxParamsVideo;
-    Resources.pParams    = &Params;
-    Resources.pSurfStore = &surfStore;
+    Resources.pProcessor  = &frameProcessor;
+    Resources.pAllocator  = &allocator;
+    Resources.pVppParams  = &mfxParamsVideo;
+    Resources.pParams     = &Params;
+    Resources.pSurfStore  = &surfStore;
+    Resources.p3DLutCache = &lutCache;
 
     vppDefaultInitParams(&Params, &defaultFiltersParam);
 
@@ -434,9 +479,15 @@ int main(int argc, msdk_char* argv[])
         for (int i = 0; i < Resources.numSrcFiles; i++) {
             ownToMfxFrameInfo(&(Params.inFrameInfo[i]), &(realFrameInfoIn[i]), true);
             // Set ptsMaker for the first stream only - it will store PTSes
+            mfxU32 chunkSize = Params.readChunkFrames * GetSurfaceSize(realFrameInfoIn[i].FourCC,
+                                                                       realFrameInfoIn[i].CropW,
+                                                                       realFrameInfoIn[i].CropH);
+
             sts = yuvReaders[i].Init(Params.compositionParam.streamInfo[i].streamName,
                                      i == 0 ? ptsMaker.get() : NULL,
-                                     realFrameInfoIn[i].FourCC);
+                                     realFrameInfoIn[i].FourCC,
+                                     chunkSize,
+                                     Params.bDirectIO);
 
             // In-place conversion check - I420 and YV12+D3D11 should be converted in reader and processed as NV12
             bool shouldConvert = false;
@@ -467,7 +518,15 @@ int main(int argc, msdk_char* argv[])
         }
 
         ownToMfxFrameInfo(&(Params.frameInfoIn[0]), &realFrameInfoIn[0]);
-        sts = yuvReaders[VPP_IN].Init(Params.strSrcFile, ptsMaker.get(), Params.fccSource);
+        mfxU32 chunkSize = Params.readChunkFrames * GetSurfaceSize(Params.fccSource,
+                                                                   realFrameInfoIn[0].CropW,
+                                                                   realFrameInfoIn[0].CropH);
+
+        sts = yuvReaders[VPP_IN].Init(Params.strSrcFile,
+                                      ptsMaker.get(),
+                                      Params.fccSource,
+                                      chunkSize,
+                                      Params.bDirectIO);
         MSDK_CHECK_STATUS(sts, "yuvReaders[VPP_IN].Init failed");
     }
     ownToMfxFrameInfo(&(Params.frameInfoOut[0]), &realFrameInfoOut);
@@ -502,6 +561,25 @@ int main(int argc, msdk_char* argv[])
         WipeParams(&Params);
     });
 
+    // VPP keeps the input frame rate, the output one is made by dropping and repeating frames
+    if (!Params.strFRCTimeCodesFile.empty()) {
+        sts = LoadTimeCodes(Params.strFRCTimeCodesFile.c_str(), inputTimeStamps);
+        MSDK_CHECK_STATUS_SAFE(sts, "LoadTimeCodes failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+        sts = frcStreamer.Init(mfxParamsVideo.vpp.Out.FrameRateExtN,
+                               mfxParamsVideo.vpp.Out.FrameRateExtD,
+                               Params.frcStreamAlgorithm);
+        MSDK_CHECK_STATUS_SAFE(sts, "frcStreamer.Init failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+        mfxParamsVideo.vpp.Out.FrameRateExtN = mfxParamsVideo.vpp.In.FrameRateExtN;
+        mfxParamsVideo.vpp.Out.FrameRateExtD = mfxParamsVideo.vpp.In.FrameRateExtD;
+        Resources.pFRCStreamer               = &frcStreamer;
+    }
+
     // prepare pts Checker
     if (ptsMaker.get()) {
         sts = ptsMaker.get()->Init(&mfxParamsVideo, Params.asyncNum - 1, Params.ptsAdvanced);
@@ -552,6 +630,24 @@ int main(int argc, msdk_char* argv[])
         Params.bPartialAccel = false;
     }
 
+    if (!Params.fanOut.empty()) {
+        Resources.pFanOut = &fanOut;
+        sts               = fanOut.Init(&Resources, &mfxParamsVideo);
+        MSDK_CHECK_STATUS_SAFE(sts, "fanOut.Init failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+    }
+
+    if (Params.bParallelLoad) {
+        Resources.pInputLoader = &inputLoader;
+        sts = inputLoader.Init(&allocator, yuvReaders, realFrameInfoIn, Resources.numSrcFiles);
+        MSDK_CHECK_STATUS_SAFE(sts, "inputLoader.Init failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+    }
+
     if (Params.bPerf) {
         for (int i = 0; i < Resources.numSrcFiles; i++) {
             sts = yuvReaders[i].PreAllocateFrameChunk(&mfxParamsVideo,
@@ -571,6 +667,21 @@ int main(int argc, msdk_char* argv[])
     PrintInfo(&Params, &mfxParamsVideo, &Resources.pProcessor->mfxSession);
     PrintDllInfo();
 
+    if (Params.bFilterBench) {
+        sts = RunFilterBenchmark(&Resources,
+                                 &yuvReaders[VPP_IN],
+                                 &realFrameInfoIn[0],
+                                 &mfxParamsVideo);
+        MSDK_CHECK_STATUS_SAFE(sts, "RunFilterBenchmark failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+
+        WipeResources(&Resources);
+        WipeParams(&Params);
+        return 0;
+    }
+
     sts     = MFX_ERR_NONE;
     nFrames = 0;
 
@@ -710,7 +821,20 @@ int main(int argc, msdk_char* argv[])
                                                                      frame_size,
                                                                      buf_read.data());
                 }
+                else if (Resources.pInputLoader) {
+                    sts = Resources.pInputLoader->GetNextInputFrame(nInStreamInd,
+                                                                    &pInSurf[nInStreamInd]);
+                }
                 else {
+                    if (!Params.bPerf) {
+                        sts = WaitForFreeSurface(Resources,
+                                                 allocator.pSurfacesIn[nInStreamInd],
+                                                 allocator.responseIn[nInStreamInd].NumFrameActual,
+                                                 &realFrameInfoOut,
+                                                 nFrames,
+                                                 paramID);
+                        MSDK_BREAK_ON_ERROR(sts);
+                    }
                     // if we share allocator with mediasdk we need to call Lock to access surface data and after we're done call Unlock
                     sts = yuvReaders[nInStreamInd].GetNextInputFrame(&allocator,
                                                                      &realFrameInfoIn[nInStreamInd],
@@ -723,6 +847,16 @@ int main(int argc, msdk_char* argv[])
                 mfxU64 expectedPTS =
                     (((mfxU64)(numGetFrames)*mfxParamsVideo.vpp.In.FrameRateExtD * 90000) /
                      mfxParamsVideo.vpp.In.FrameRateExtN);
+                // or from time codes, frames after the last one go at the input frame rate
+                if (numGetFrames < inputTimeStamps.size()) {
+                    expectedPTS = inputTimeStamps[numGetFrames];
+                }
+                else if (!inputTimeStamps.empty()) {
+                    mfxU64 nOver = numGetFrames - inputTimeStamps.size() + 1;
+                    expectedPTS  = inputTimeStamps.back() +
+                                  (nOver * mfxParamsVideo.vpp.In.FrameRateExtD * 90000) /
+                                      mfxParamsVideo.vpp.In.FrameRateExtN;
+                }
                 pInSurf[nInStreamInd]->Data.TimeStamp = expectedPTS;
 
                 if (bMultiView) {
@@ -733,6 +867,11 @@ int main(int argc, msdk_char* argv[])
                     sts = MFX_ERR_MORE_DATA;
                     break;
                 }
+
+                if (Resources.pFanOut) {
+                    sts = Resources.pFanOut->Process(pInSurf[nInStreamInd]);
+                    MSDK_BREAK_ON_ERROR(sts);
+                }
             }
 
             // VPP processing
@@ -742,6 +881,13 @@ int main(int argc, msdk_char* argv[])
                 sts = frameProcessor.mfxSession.GetSurfaceForVPPOut((mfxFrameSurface1**)&pOutSurf);
             }
             else {
+                sts = WaitForFreeSurface(Resources,
+                                         allocator.pSurfacesOut,
+                                         allocator.responseOut.NumFrameActual,
+                                         &realFrameInfoOut,
+                                         nFrames,
+                                         paramID);
+                MSDK_BREAK_ON_ERROR(sts);
                 sts = GetFreeSurface(allocator.pSurfacesOut,
                                      allocator.responseOut.NumFrameActual,
                                      &pOutSurf);
@@ -792,10 +938,13 @@ int main(int argc, msdk_char* argv[])
             nOutFrames++;
 #endif
 
-            sts = frameProcessor.pmfxVPP->RunFrameVPPAsync(pInSurf[nInStreamInd],
-                                                           pOutSurf,
-                                                           NULL,
-                                                           &syncPoint);
+            {
+                MFX_ITT_TASK("RunFrameVPPAsync");
+                sts = frameProcessor.pmfxVPP->RunFrameVPPAsync(pInSurf[nInStreamInd],
+                                                               pOutSurf,
+                                                               NULL,
+                                                               &syncPoint);
+            }
 
             nInStreamInd++;
             if (nInStreamInd == Resources.numSrcFiles)
@@ -918,16 +1067,30 @@ int main(int argc, msdk_char* argv[])
             nOutFrames++;
 #endif
 
-            sts = frameProcessor.pmfxVPP->RunFrameVPPAsync(NULL, pOutSurf, NULL, &syncPoint);
+            {
+                MFX_ITT_TASK("RunFrameVPPAsync");
+                sts = frameProcessor.pmfxVPP->RunFrameVPPAsync(NULL, pOutSurf, NULL, &syncPoint);
+            }
 
             MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_SURFACE);
             MSDK_BREAK_ON_ERROR(sts);
 
-            sts = Resources.pProcessor->mfxSession.SyncOperation(syncPoint, MSDK_VPP_WAIT_INTERVAL);
+            {
+                MFX_ITT_TASK("SyncOperation");
+                sts = Resources.pProcessor->mfxSession.SyncOperation(syncPoint,
+                                                                     MSDK_VPP_WAIT_INTERVAL);
+            }
             if (sts)
                 msdk_printf(MSDK_STRING("SyncOperation wait interval exceeded\n"));
             MSDK_BREAK_ON_ERROR(sts);
-            if (!Resources.pParams->strDstFiles.empty()) {
+            mfxU32 nCopies =
+                Resources.pFRCStreamer ? frcStreamer.PutFrame(pOutSurf->Data.TimeStamp) : 1;
+            for (mfxU32 i = 0; i < nCopies; i++) {
+                if (Resources.pFRCStreamer)
+                    pOutSurf->Data.TimeStamp = frcStreamer.GetOutputTimeStamp(i);
+                if (Resources.pParams->strDstFiles.empty())
+                    continue;
+
                 GeneralWriter* writer = (1 == Resources.dstFileWritersN)
                                             ? &Resources.pDstFileWriters[0]
                                             : &Resources.pDstFileWriters[paramID];
@@ -936,7 +1099,7 @@ int main(int argc, msdk_char* argv[])
                     msdk_printf(MSDK_STRING("Failed to write frame to disk\n"));
                 MSDK_CHECK_NOT_EQUAL(sts, MFX_ERR_NONE, MFX_ERR_ABORTED);
             }
-            nFrames++;
+            nFrames += nCopies;
 
             //VPP progress
             if (!Params.bPerf)
@@ -948,6 +1111,14 @@ int main(int argc, msdk_char* argv[])
         }
     } while (bNeedReset);
 
+    if (Resources.pFanOut && MFX_ERR_MORE_DATA == sts) {
+        sts = Resources.pFanOut->Flush();
+        MSDK_CHECK_STATUS_SAFE(sts, "Resources.pFanOut->Flush failed", {
+            WipeResources(&Resources);
+            WipeParams(&Params);
+        });
+    }
+
     statTimer.StopTimeMeasurement();
 
     MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
@@ -964,6 +1135,11 @@ int main(int argc, msdk_char* argv[])
     msdk_printf(MSDK_STRING("Total frames %d \n"), nFrames);
     msdk_printf(MSDK_STRING("Total time %.2f sec \n"), statTimer.GetTotalTime());
     msdk_printf(MSDK_STRING("Frames per second %.3f fps \n"), nFrames / statTimer.GetTotalTime());
+    if (Resources.pFanOut)
+        Resources.pFanOut->PrintStatistics();
+    if (Resources.pFRCStreamer)
+        frcStreamer.PrintStatistics();
+    lutCache.PrintStatistics();
 
     PutPerformanceToFile(Params, nFrames / statTimer.GetTotalTime());
 
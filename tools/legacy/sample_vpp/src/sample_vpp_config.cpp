@@ -4,6 +4,7 @@
   # SPDX-License-Identifier: MIT
   ############################################################################*/
 
+#include "sample_vpp_lut.h"
 #include "sample_vpp_utils.h"
 
 #ifndef MFX_VERSION
@@ -95,6 +96,15 @@ mfxStatus ConfigVideoEnhancementFilters(sInputParams* pParams,
         mirroringConfig->Type = pParams->mirroringParam[paramID].Type;
     }
 
+    if (VPP_FILTER_ENABLED_CONFIGURED == pParams->lut3DParam[paramID].mode) {
+        MSDK_CHECK_POINTER(pResources->p3DLutCache, MFX_ERR_NULL_PTR);
+        auto lutConfig = pVppParam->AddExtBuffer<mfxExtVPP3DLut>();
+        mfxStatus sts  = pResources->p3DLutCache->Get3DLut(pParams->lut3DParam[paramID].strFile,
+                                                          pParams->lut3DParam[paramID].size,
+                                                          lutConfig);
+        MSDK_CHECK_STATUS(sts, "pResources->p3DLutCache->Get3DLut failed");
+    }
+
     if (VPP_FILTER_ENABLED_CONFIGURED == pParams->colorfillParam[paramID].mode) {
         auto colorfillConfig = pVppParam->AddExtBuffer<mfxExtVPPColorFill>();
         colorfillConfig      = &pParams->colorfillParam[paramID];
@@ -0,0 +1,214 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "sample_vpp_fanout.h"
+#include "vm/atomic_defs.h"
+
+CVPPFanOut::CVPPFanOut() : m_pResources(NULL), m_Outputs(), m_MainParams() {}
+
+CVPPFanOut::~CVPPFanOut() {
+    Close();
+}
+
+mfxStatus CVPPFanOut::Init(sAppResources* pResources, const mfxVideoParam* pMainParams) {
+    MSDK_CHECK_POINTER(pResources, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pMainParams, MFX_ERR_NULL_PTR);
+
+    Close();
+
+    m_pResources = pResources;
+    m_MainParams = *pMainParams;
+    // filters are applied to the main output only
+    m_MainParams.NumExtParam = 0;
+    m_MainParams.ExtParam    = NULL;
+
+    for (const sFanOutParam& fanOutParam : pResources->pParams->fanOut) {
+        m_Outputs.emplace_back(new sOutput());
+        mfxStatus sts = InitOutput(*m_Outputs.back(), fanOutParam);
+        MSDK_CHECK_STATUS_SAFE(sts, "InitOutput failed", Close());
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CVPPFanOut::InitOutput(sOutput& output, const sFanOutParam& fanOutParam) {
+    MFXVideoSession& mainSession     = m_pResources->pProcessor->mfxSession;
+    MFXFrameAllocator* pMfxAllocator = m_pResources->pAllocator->pMfxAllocator;
+
+    mfxStatus sts = mainSession.CloneSession(&output.session);
+    MSDK_CHECK_STATUS(sts, "mainSession.CloneSession failed");
+
+    // cloned session doesn't inherit the device and the allocator of the main one
+    const mfxHandleType handleTypes[] = { MFX_HANDLE_D3D9_DEVICE_MANAGER,
+                                          MFX_HANDLE_D3D11_DEVICE,
+                                          MFX_HANDLE_VA_DISPLAY };
+    for (mfxHandleType type : handleTypes) {
+        mfxHDL hdl = NULL;
+        if (MFX_ERR_NONE == mainSession.GetHandle(type, &hdl) && hdl) {
+            sts = MFXVideoCORE_SetHandle(output.session, type, hdl);
+            MSDK_CHECK_STATUS(sts, "MFXVideoCORE_SetHandle failed");
+        }
+    }
+    sts = MFXVideoCORE_SetFrameAllocator(output.session, pMfxAllocator);
+    MSDK_CHECK_STATUS(sts, "MFXVideoCORE_SetFrameAllocator failed");
+
+    // the output keeps color format of the main one and structure and rate of the input
+    output.params.IOPattern  = m_MainParams.IOPattern;
+    output.params.AsyncDepth = m_MainParams.AsyncDepth;
+    output.params.vpp.In     = m_MainParams.vpp.In;
+    output.params.vpp.Out    = m_MainParams.vpp.Out;
+
+    mfxFrameInfo& out = output.params.vpp.Out;
+    out.PicStruct     = m_MainParams.vpp.In.PicStruct;
+    out.FrameRateExtN = m_MainParams.vpp.In.FrameRateExtN;
+    out.FrameRateExtD = m_MainParams.vpp.In.FrameRateExtD;
+    out.Width         = (mfxU16)MSDK_ALIGN16(fanOutParam.nWidth);
+    out.Height        = (MFX_PICSTRUCT_PROGRESSIVE == out.PicStruct)
+                            ? (mfxU16)MSDK_ALIGN16(fanOutParam.nHeight)
+                            : (mfxU16)MSDK_ALIGN32(fanOutParam.nHeight);
+    out.CropX         = 0;
+    out.CropY         = 0;
+    out.CropW         = fanOutParam.nWidth;
+    out.CropH         = fanOutParam.nHeight;
+
+    output.pVPP.reset(new MFXVideoVPP(output.session));
+
+    mfxFrameAllocRequest request[2] = {}; // [0] - in, [1] - out
+
+    sts = output.pVPP->QueryIOSurf(&output.params, request);
+    MSDK_IGNORE_MFX_STS(sts, MFX_WRN_PARTIAL_ACCELERATION);
+    MSDK_CHECK_STATUS(sts, "output.pVPP->QueryIOSurf failed");
+
+    sts = pMfxAllocator->Alloc(pMfxAllocator->pthis, &request[VPP_OUT], &output.response);
+    MSDK_CHECK_STATUS(sts, "pMfxAllocator->Alloc failed");
+
+    output.pSurfaces.reset(new mfxFrameSurfaceWrap[output.response.NumFrameActual]);
+    for (mfxU16 i = 0; i < output.response.NumFrameActual; i++) {
+        output.pSurfaces[i].Info       = request[VPP_OUT].Info;
+        output.pSurfaces[i].Data.MemId = output.response.mids[i];
+    }
+
+    sts = output.pVPP->Init(&output.params);
+    MSDK_IGNORE_MFX_STS(sts, MFX_WRN_PARTIAL_ACCELERATION);
+    MSDK_CHECK_STATUS(sts, "output.pVPP->Init failed");
+
+    sts = output.writer.Init(fanOutParam.strDstFile.c_str(),
+                             NULL,
+                             NULL,
+                             m_pResources->pParams->forcedOutputFourcc);
+    MSDK_CHECK_STATUS(sts, "output.writer.Init failed");
+
+    return MFX_ERR_NONE;
+}
+
+void CVPPFanOut::Close() {
+    for (std::unique_ptr<sOutput>& pOutput : m_Outputs) {
+        sOutput& output = *pOutput;
+
+        output.writer.Close();
+        output.syncPoints.clear();
+
+        if (output.pVPP) {
+            output.pVPP->Close();
+            output.pVPP.reset();
+        }
+
+        if (output.response.NumFrameActual && m_pResources->pAllocator->pMfxAllocator) {
+            MFXFrameAllocator* pMfxAllocator = m_pResources->pAllocator->pMfxAllocator;
+            pMfxAllocator->Free(pMfxAllocator->pthis, &output.response);
+        }
+        output.pSurfaces.reset();
+
+        if (output.session) {
+            MFXDisjoinSession(output.session);
+            MFXClose(output.session);
+            output.session = NULL;
+        }
+    }
+    m_Outputs.clear();
+}
+
+mfxStatus CVPPFanOut::Process(mfxFrameSurfaceWrap* pInSurface) {
+    MSDK_CHECK_POINTER(pInSurface, MFX_ERR_NULL_PTR);
+
+    for (std::unique_ptr<sOutput>& pOutput : m_Outputs) {
+        sOutput& output  = *pOutput;
+        mfxU16 nPoolSize = output.response.NumFrameActual;
+        mfxStatus sts    = MFX_ERR_NONE;
+
+        while (!output.syncPoints.empty() &&
+               MSDK_INVALID_SURF_IDX == GetFreeSurfaceIndex(output.pSurfaces.get(), nPoolSize)) {
+            sts = WriteFrames(output, output.syncPoints.size() - 1);
+            MSDK_CHECK_STATUS(sts, "WriteFrames failed");
+        }
+
+        mfxFrameSurfaceWrap* pOutSurface = NULL;
+
+        sts = GetFreeSurface(output.pSurfaces.get(), nPoolSize, &pOutSurface);
+        MSDK_CHECK_STATUS(sts, "GetFreeSurface failed");
+
+        mfxSyncPoint syncPoint = NULL;
+
+        sts = output.pVPP->RunFrameVPPAsync(pInSurface, pOutSurface, NULL, &syncPoint);
+        if (MFX_ERR_MORE_DATA == sts)
+            continue;
+        MSDK_CHECK_STATUS(sts, "output.pVPP->RunFrameVPPAsync failed");
+
+        output.syncPoints.push_back(std::make_pair(syncPoint, pOutSurface));
+        msdk_atomic_inc16((volatile mfxU16*)&pOutSurface->Data.Locked);
+        if (output.syncPoints.size() == (size_t)m_pResources->pParams->asyncNum) {
+            sts = WriteFrames(output, 0);
+            MSDK_CHECK_STATUS(sts, "WriteFrames failed");
+        }
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CVPPFanOut::Flush() {
+    for (std::unique_ptr<sOutput>& pOutput : m_Outputs) {
+        mfxStatus sts = WriteFrames(*pOutput, 0);
+        MSDK_CHECK_STATUS(sts, "WriteFrames failed");
+    }
+    return MFX_ERR_NONE;
+}
+
+mfxStatus CVPPFanOut::WriteFrames(sOutput& output, size_t nPending) {
+    for (; output.syncPoints.size() > nPending; output.syncPoints.pop_front()) {
+        mfxStatus sts = MFXVideoCORE_SyncOperation(output.session,
+                                                   output.syncPoints.front().first,
+                                                   MSDK_VPP_WAIT_INTERVAL);
+        if (sts == MFX_WRN_IN_EXECUTION) {
+            msdk_printf(MSDK_STRING("SyncOperation wait interval exceeded\n"));
+        }
+        MSDK_CHECK_NOT_EQUAL(sts, MFX_ERR_NONE, sts);
+
+        mfxFrameSurfaceWrap* pSurface = output.syncPoints.front().second;
+
+        sts = output.writer.PutNextFrame(m_pResources->pAllocator,
+                                         &output.params.vpp.Out,
+                                         pSurface);
+        msdk_atomic_dec16((volatile mfxU16*)&pSurface->Data.Locked);
+
+        if (sts)
+            msdk_printf(MSDK_STRING("Failed to write frame to disk\n"));
+        MSDK_CHECK_NOT_EQUAL(sts, MFX_ERR_NONE, MFX_ERR_ABORTED);
+
+        output.nFrames++;
+    }
+    return MFX_ERR_NONE;
+}
+
+void CVPPFanOut::PrintStatistics() const {
+    for (size_t i = 0; i < m_Outputs.size(); i++) {
+        const mfxFrameInfo& out = m_Outputs[i]->params.vpp.Out;
+        msdk_printf(MSDK_STRING("Fan-out output %d: %dx%d, %d frames\n"),
+                    (int)i,
+                    out.CropW,
+                    out.CropH,
+                    m_Outputs[i]->nFrames);
+    }
+}
@@ -0,0 +1,260 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include <list>
+#include <vector>
+#include "sample_vpp_filter_bench.h"
+
+#define TIME_STATS 1
+#include "time_statistics.h"
+
+struct sFilterStep {
+    const msdk_char* name;
+    mfxExtBuffer* pConfig; // NULL if the filter is enabled with default parameters by doUseAlg
+    mfxU32 doUseAlg;
+};
+
+static const msdk_char* FilterName(mfxU32 bufferId) {
+    switch (bufferId) {
+        case MFX_EXTBUFF_VPP_DENOISE:
+        case MFX_EXTBUFF_VPP_DENOISE2:
+            return MSDK_STRING("denoise");
+#ifdef ENABLE_MCTF
+        case MFX_EXTBUFF_VPP_MCTF:
+            return MSDK_STRING("mctf");
+#endif
+        case MFX_EXTBUFF_VPP_PROCAMP:
+            return MSDK_STRING("procamp");
+        case MFX_EXTBUFF_VPP_DETAIL:
+            return MSDK_STRING("detail");
+        case MFX_EXTBUFF_VPP_IMAGE_STABILIZATION:
+            return MSDK_STRING("istab");
+        case MFX_EXTBUFF_VPP_DEINTERLACING:
+            return MSDK_STRING("deinterlace");
+        case MFX_EXTBUFF_VPP_FRAME_RATE_CONVERSION:
+            return MSDK_STRING("frc");
+        case MFX_EXTBUFF_VPP_ROTATION:
+            return MSDK_STRING("rotate");
+        case MFX_EXTBUFF_VPP_MIRRORING:
+            return MSDK_STRING("mirror");
+        case MFX_EXTBUFF_VPP_SCALING:
+            return MSDK_STRING("scaling_mode");
+        case MFX_EXTBUFF_VPP_COLOR_CONVERSION:
+            return MSDK_STRING("chroma_siting");
+        case MFX_EXTBUFF_VPP_VIDEO_SIGNAL_INFO:
+            return MSDK_STRING("video_signal_info");
+        case MFX_EXTBUFF_VPP_COLORFILL:
+            return MSDK_STRING("colorfill");
+        case MFX_EXTBUFF_VPP_3DLUT:
+            return MSDK_STRING("3dlut");
+        default:
+            return MSDK_STRING("unknown");
+    }
+}
+
+static mfxStatus SyncOldest(MFXVideoSession& session, std::list<mfxSyncPoint>& syncPoints) {
+    mfxStatus sts = session.SyncOperation(syncPoints.front(), MSDK_VPP_WAIT_INTERVAL);
+    syncPoints.pop_front();
+    MSDK_CHECK_NOT_EQUAL(sts, MFX_ERR_NONE, sts);
+    return MFX_ERR_NONE;
+}
+
+// submits pInSurface (NULL to get the buffered frames) till VPP needs more input
+static mfxStatus SubmitFrame(sAppResources* pResources,
+                             mfxFrameSurfaceWrap* pInSurface,
+                             std::list<mfxSyncPoint>& syncPoints) {
+    MFXVideoVPP* pVPP         = pResources->pProcessor->pmfxVPP;
+    sMemoryAllocator* pMemory = pResources->pAllocator;
+    mfxU16 nPoolSize          = pMemory->responseOut.NumFrameActual;
+    mfxStatus sts             = MFX_ERR_NONE;
+
+    for (;;) {
+        mfxU16 index = GetFreeSurfaceIndex(pMemory->pSurfacesOut, nPoolSize);
+        while (MSDK_INVALID_SURF_IDX == index && !syncPoints.empty()) {
+            sts = SyncOldest(pResources->pProcessor->mfxSession, syncPoints);
+            MSDK_CHECK_STATUS(sts, "SyncOldest failed");
+            index = GetFreeSurfaceIndex(pMemory->pSurfacesOut, nPoolSize);
+        }
+        MSDK_CHECK_ERROR(index, MSDK_INVALID_SURF_IDX, MFX_ERR_NOT_ENOUGH_BUFFER);
+
+        mfxSyncPoint syncPoint = NULL;
+
+        sts = pVPP->RunFrameVPPAsync(pInSurface, &pMemory->pSurfacesOut[index], NULL, &syncPoint);
+        if (MFX_WRN_DEVICE_BUSY == sts) {
+            MSDK_SLEEP(1);
+            continue;
+        }
+        if (MFX_ERR_MORE_DATA == sts)
+            return sts;
+
+        // more output of the same input, e.g. with frame rate conversion
+        bool bMoreOutput = (MFX_ERR_MORE_SURFACE == sts);
+        if (!bMoreOutput)
+            MSDK_CHECK_STATUS(sts, "pVPP->RunFrameVPPAsync failed");
+        MSDK_CHECK_POINTER(syncPoint, MFX_ERR_UNDEFINED_BEHAVIOR);
+        syncPoints.push_back(syncPoint);
+        if (!bMoreOutput)
+            return MFX_ERR_NONE;
+    }
+}
+
+// processes all preloaded frames, returns time of processing in seconds
+static mfxStatus RunChain(sAppResources* pResources,
+                          CRawVideoReader* pReader,
+                          mfxFrameInfo* pInFrameInfo,
+                          mfxVideoParam* pParams,
+                          mfxU32& nFrames,
+                          mfxF64& time) {
+    MFXVideoVPP* pVPP      = pResources->pProcessor->pmfxVPP;
+    sInputParams* pInParam = pResources->pParams;
+
+    mfxStatus sts = pVPP->Close();
+    MSDK_IGNORE_MFX_STS(sts, MFX_ERR_NOT_INITIALIZED);
+    MSDK_CHECK_STATUS(sts, "pVPP->Close failed");
+
+    sts = pVPP->Init(pParams);
+    if (MFX_WRN_FILTER_SKIPPED == sts)
+        msdk_printf(MSDK_STRING("VPP_WRN: some filter(s) skipped\n"));
+    MSDK_CHECK_STATUS(sts, "pVPP->Init failed");
+
+    std::list<mfxSyncPoint> syncPoints;
+    CTimeStatistics timer;
+
+    pReader->RewindPreAllocFrames(pInParam->numRepeat);
+    nFrames = 0;
+    timer.StartTimeMeasurement();
+
+    for (;;) {
+        mfxFrameSurfaceWrap* pInSurface = NULL;
+
+        sts = pReader->GetNextInputFrame(pResources->pAllocator, pInFrameInfo, &pInSurface, 0);
+        // preloaded frame is still in processing
+        while (MFX_ERR_ABORTED == sts && !syncPoints.empty()) {
+            sts = SyncOldest(pResources->pProcessor->mfxSession, syncPoints);
+            MSDK_CHECK_STATUS(sts, "SyncOldest failed");
+            sts = pReader->GetNextInputFrame(pResources->pAllocator, pInFrameInfo, &pInSurface, 0);
+        }
+        if (MFX_ERR_MORE_DATA == sts)
+            break;
+        MSDK_CHECK_STATUS(sts, "pReader->GetNextInputFrame failed");
+
+        sts = SubmitFrame(pResources, pInSurface, syncPoints);
+        MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
+        MSDK_CHECK_STATUS(sts, "SubmitFrame failed");
+        nFrames++;
+
+        while (syncPoints.size() > pInParam->asyncNum) {
+            sts = SyncOldest(pResources->pProcessor->mfxSession, syncPoints);
+            MSDK_CHECK_STATUS(sts, "SyncOldest failed");
+        }
+    }
+
+    sts = SubmitFrame(pResources, NULL, syncPoints);
+    while (MFX_ERR_NONE == sts)
+        sts = SubmitFrame(pResources, NULL, syncPoints);
+    MSDK_IGNORE_MFX_STS(sts, MFX_ERR_MORE_DATA);
+    MSDK_CHECK_STATUS(sts, "SubmitFrame failed");
+
+    while (!syncPoints.empty()) {
+        sts = SyncOldest(pResources->pProcessor->mfxSession, syncPoints);
+        MSDK_CHECK_STATUS(sts, "SyncOldest failed");
+    }
+
+    timer.StopTimeMeasurement();
+    time = timer.GetTotalTime();
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus RunFilterBenchmark(sAppResources* pResources,
+                             CRawVideoReader* pReader,
+                             mfxFrameInfo* pInFrameInfo,
+                             mfxVideoParam* pParams) {
+    MSDK_CHECK_POINTER(pResources, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pReader, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pParams, MFX_ERR_NULL_PTR);
+
+    // configured filters first, the ones enabled with default parameters are taken from DoUse
+    std::vector<sFilterStep> steps;
+    mfxExtVPPDoUse* pDoUse = NULL;
+    for (mfxU16 i = 0; i < pParams->NumExtParam; i++) {
+        mfxExtBuffer* pBuffer = pParams->ExtParam[i];
+        if (MFX_EXTBUFF_VPP_DOUSE == pBuffer->BufferId)
+            pDoUse = (mfxExtVPPDoUse*)pBuffer;
+        else
+            steps.push_back({ FilterName(pBuffer->BufferId), pBuffer, 0 });
+    }
+    for (mfxU32 i = 0; pDoUse && i < pDoUse->NumAlg; i++) {
+        const msdk_char* name = FilterName(pDoUse->AlgList[i]);
+        bool bConfigured      = false;
+        for (const sFilterStep& step : steps)
+            bConfigured |= (0 == msdk_strcmp(step.name, name));
+        if (!bConfigured)
+            steps.push_back({ name, NULL, pDoUse->AlgList[i] });
+    }
+
+    const mfxFrameInfo& in  = pParams->vpp.In;
+    const mfxFrameInfo& out = pParams->vpp.Out;
+    msdk_printf(MSDK_STRING("\nFilter benchmark %dx%d -> %dx%d, the first run has no filters\n"),
+                in.CropW,
+                in.CropH,
+                out.CropW,
+                out.CropH);
+    msdk_printf(MSDK_STRING("%-20s %10s %12s %12s\n"),
+                MSDK_STRING("filter added"),
+                MSDK_STRING("fps"),
+                MSDK_STRING("us/frame"),
+                MSDK_STRING("+us/frame"));
+
+    mfxF64 prevFrameTime = 0;
+    for (size_t nSteps = 0; nSteps <= steps.size(); nSteps++) {
+        std::vector<mfxExtBuffer*> extParams;
+        std::vector<mfxU32> doUseAlgs;
+        for (size_t i = 0; i < nSteps; i++) {
+            if (steps[i].pConfig)
+                extParams.push_back(steps[i].pConfig);
+            else
+                doUseAlgs.push_back(steps[i].doUseAlg);
+        }
+
+        mfxExtVPPDoUse doUse = {};
+        if (!doUseAlgs.empty()) {
+            doUse.Header.BufferId = MFX_EXTBUFF_VPP_DOUSE;
+            doUse.Header.BufferSz = sizeof(doUse);
+            doUse.NumAlg          = (mfxU32)doUseAlgs.size();
+            doUse.AlgList         = doUseAlgs.data();
+            extParams.push_back(&doUse.Header);
+        }
+
+        mfxVideoParam stepParams = *pParams;
+        stepParams.NumExtParam   = (mfxU16)extParams.size();
+        stepParams.ExtParam      = extParams.empty() ? NULL : extParams.data();
+
+        mfxU32 nFrames = 0;
+        mfxF64 time    = 0;
+        mfxStatus sts  = RunChain(pResources, pReader, pInFrameInfo, &stepParams, nFrames, time);
+        MSDK_CHECK_STATUS(sts, "RunChain failed");
+        MSDK_CHECK_ERROR(nFrames, 0, MFX_ERR_MORE_DATA);
+
+        mfxF64 frameTime      = time * 1000000 / nFrames;
+        const msdk_char* name = nSteps ? steps[nSteps - 1].name : MSDK_STRING("none");
+        if (nSteps)
+            msdk_printf(MSDK_STRING("%-20s %10.2f %12.1f %+12.1f\n"),
+                        name,
+                        nFrames / time,
+                        frameTime,
+                        frameTime - prevFrameTime);
+        else
+            msdk_printf(MSDK_STRING("%-20s %10.2f %12.1f %12s\n"),
+                        name,
+                        nFrames / time,
+                        frameTime,
+                        MSDK_STRING("-"));
+        prevFrameTime = frameTime;
+    }
+
+    return MFX_ERR_NONE;
+}
@@ -7,6 +7,7 @@
 #include "sample_vpp_frc_adv.h"
 #include <math.h>
 #include <algorithm>
+#include "vm/file_defs.h"
 #include "vm/strings_defs.h"
 
 #ifndef MFX_VERSION
@@ -15,6 +16,9 @@
 
 static const mfxU32 MFX_TIME_STAMP_FREQUENCY = 90000; // will go to mfxdefs.h
 
+// bigger gaps between input frames are taken as time stamp discontinuity, not as frames lost
+static const mfxU64 MAX_TIME_STAMP_GAP = MFX_TIME_STAMP_FREQUENCY;
+
 bool FRCAdvancedChecker::IsTimeStampsNear(mfxU64 timeStampRef, mfxU64 timeStampTst, mfxU64 eps) {
     mfxU32 absDiff = abs((mfxI32)(timeStampTst - (timeStampRef)));
     if (absDiff <= eps) {
@@ -184,4 +188,111 @@ mfxU64 FRCAdvancedChecker::GetExpectedPTS(mfxU32 frameNumber, mfxU64 timeOffset,
 
 } // mfxU64  FRCAdvancedChecker::GetExpectedPTS( mfxU32 frameNumber, mfxU64 timeOffset, mfxU64 timeJump )
 
+FRCStreamingConverter::FRCStreamingConverter()
+        : m_FRateExtN(0),
+          m_FRateExtD(1),
+          m_algorithm(MFX_FRCALGM_PRESERVE_TIMESTAMP),
+          m_minDeltaTime(0),
+          m_bIsSetTimeOffset(false),
+          m_timeOffset(0),
+          m_baseSlot(0),
+          m_numSlots(0),
+          m_lastTimeStamp(0),
+          m_lastFirstSlot(0),
+          m_numInputFrames(0),
+          m_numDropped(0),
+          m_numRepeated(0) {}
+
+mfxStatus FRCStreamingConverter::Init(mfxU32 frameRateExtN,
+                                      mfxU32 frameRateExtD,
+                                      mfxU16 algorithm) {
+    if (!frameRateExtN || !frameRateExtD)
+        return MFX_ERR_INVALID_VIDEO_PARAM;
+    if (MFX_FRCALGM_PRESERVE_TIMESTAMP != algorithm &&
+        MFX_FRCALGM_DISTRIBUTED_TIMESTAMP != algorithm)
+        return MFX_ERR_UNSUPPORTED;
+
+    *this = FRCStreamingConverter();
+
+    m_FRateExtN    = frameRateExtN;
+    m_FRateExtD    = frameRateExtD;
+    m_algorithm    = algorithm;
+    m_minDeltaTime = ((mfxU64)m_FRateExtD * MFX_TIME_STAMP_FREQUENCY) / (2 * (mfxU64)m_FRateExtN);
+
+    return MFX_ERR_NONE;
+} // mfxStatus FRCStreamingConverter::Init(mfxU32 frameRateExtN, ...)
+
+mfxU32 FRCStreamingConverter::PutFrame(mfxU64 timeStamp) {
+    m_numInputFrames++;
+
+    // a frame without time stamp takes the next slot
+    if ((mfxU64)MFX_TIMESTAMP_UNKNOWN == timeStamp)
+        timeStamp = m_bIsSetTimeOffset ? GetSlotTimeStamp(m_numSlots) : 0;
+
+    if (!m_bIsSetTimeOffset || timeStamp + m_minDeltaTime < m_lastTimeStamp ||
+        timeStamp > m_lastTimeStamp + MAX_TIME_STAMP_GAP) {
+        m_bIsSetTimeOffset = true;
+        m_timeOffset       = timeStamp;
+        m_baseSlot         = m_numSlots;
+    }
+    m_lastTimeStamp = timeStamp;
+    m_lastFirstSlot = m_numSlots;
+
+    // the frame fills all slots up to it: it's repeated if the previous frames left some of them
+    // empty and dropped if the slot near it is filled already
+    while (GetSlotTimeStamp(m_numSlots) <= timeStamp + m_minDeltaTime)
+        m_numSlots++;
+
+    mfxU32 numCopies = m_numSlots - m_lastFirstSlot;
+    if (!numCopies)
+        m_numDropped++;
+    else
+        m_numRepeated += numCopies - 1;
+
+    return numCopies;
+} // mfxU32 FRCStreamingConverter::PutFrame(mfxU64 timeStamp)
+
+mfxU64 FRCStreamingConverter::GetOutputTimeStamp(mfxU32 copyIndex) const {
+    if (MFX_FRCALGM_DISTRIBUTED_TIMESTAMP == m_algorithm)
+        return GetSlotTimeStamp(m_lastFirstSlot + copyIndex);
+
+    // repeated frames have no time stamps of their own as with the library FRC
+    return copyIndex ? (mfxU64)MFX_TIMESTAMP_UNKNOWN : m_lastTimeStamp;
+}
+
+void FRCStreamingConverter::PrintStatistics() const {
+    msdk_printf(MSDK_STRING("Streaming FRC: %d input frames, %d output frames, %d dropped, %d "
+                            "repeated\n"),
+                m_numInputFrames,
+                m_numSlots,
+                m_numDropped,
+                m_numRepeated);
+}
+
+mfxU64 FRCStreamingConverter::GetSlotTimeStamp(mfxU32 slot) const {
+    return m_timeOffset + ((mfxU64)(slot - m_baseSlot) * m_FRateExtD * MFX_TIME_STAMP_FREQUENCY) /
+                              m_FRateExtN;
+}
+
+mfxStatus LoadTimeCodes(const msdk_char* fileName, std::vector<mfxU64>& timeStamps) {
+    FILE* fTimeCodes = NULL;
+    MSDK_FOPEN(fTimeCodes, fileName, MSDK_STRING("r"));
+    if (!fTimeCodes)
+        return MFX_ERR_NOT_FOUND;
+
+    timeStamps.clear();
+
+    char line[256];
+    while (fgets(line, sizeof(line), fTimeCodes)) {
+        mfxF64 timeCode = 0;
+        // format header and comments
+        if ('#' == line[0] || 1 != sscanf(line, "%lf", &timeCode))
+            continue;
+        timeStamps.push_back((mfxU64)(timeCode * MFX_TIME_STAMP_FREQUENCY / 1000 + .5));
+    }
+    fclose(fTimeCodes);
+
+    return timeStamps.empty() ? MFX_ERR_NOT_FOUND : MFX_ERR_NONE;
+}
+
 /* EOF */
\ No newline at end of file
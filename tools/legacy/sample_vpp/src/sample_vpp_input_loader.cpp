@@ -0,0 +1,143 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "sample_vpp_input_loader.h"
+#include "vm/atomic_defs.h"
+
+CParallelInputLoader::CParallelInputLoader()
+        : m_pAllocator(NULL),
+          m_Streams(),
+          m_mutex(),
+          m_cvLoaded(),
+          m_cvTaken(),
+          m_bStop(false) {}
+
+CParallelInputLoader::~CParallelInputLoader() {
+    Close();
+}
+
+mfxStatus CParallelInputLoader::Init(sMemoryAllocator* pAllocator,
+                                     CRawVideoReader* pReaders,
+                                     mfxFrameInfo* pFrameInfos,
+                                     mfxU16 numStreams) {
+    MSDK_CHECK_POINTER(pAllocator, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pReaders, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_POINTER(pFrameInfos, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(numStreams > MAX_INPUT_STREAMS, true, MFX_ERR_UNSUPPORTED);
+
+    Close();
+
+    m_pAllocator = pAllocator;
+    m_bStop      = false;
+
+    for (mfxU16 i = 0; i < numStreams; i++) {
+        std::unique_ptr<sStream> pStream(new sStream());
+        pStream->pReader    = &pReaders[i];
+        pStream->pFrameInfo = &pFrameInfos[i];
+        pStream->pCurrent   = NULL;
+        pStream->sts        = MFX_ERR_NONE;
+        m_Streams.push_back(std::move(pStream));
+    }
+    for (mfxU16 i = 0; i < numStreams; i++) {
+        m_Streams[i]->thread = std::thread(&CParallelInputLoader::LoaderRoutine, this, i);
+    }
+
+    return MFX_ERR_NONE;
+}
+
+void CParallelInputLoader::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_cvTaken.notify_all();
+
+    for (std::unique_ptr<sStream>& pStream : m_Streams) {
+        if (pStream->thread.joinable())
+            pStream->thread.join();
+
+        // surfaces are left for the library only
+        for (mfxFrameSurfaceWrap* pSurface : pStream->loaded)
+            msdk_atomic_dec16((volatile mfxU16*)&pSurface->Data.Locked);
+        if (pStream->pCurrent)
+            msdk_atomic_dec16((volatile mfxU16*)&pStream->pCurrent->Data.Locked);
+    }
+    m_Streams.clear();
+}
+
+mfxStatus CParallelInputLoader::GetNextInputFrame(mfxU16 streamIndex,
+                                                  mfxFrameSurfaceWrap** ppSurface) {
+    MSDK_CHECK_POINTER(ppSurface, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(streamIndex >= m_Streams.size(), true, MFX_ERR_NOT_INITIALIZED);
+
+    sStream& stream = *m_Streams[streamIndex];
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // the previous frame is held by the library now if it's still in processing
+        if (stream.pCurrent) {
+            msdk_atomic_dec16((volatile mfxU16*)&stream.pCurrent->Data.Locked);
+            stream.pCurrent = NULL;
+        }
+
+        m_cvLoaded.wait(lock, [&stream]() {
+            return !stream.loaded.empty() || MFX_ERR_NONE != stream.sts;
+        });
+        if (stream.loaded.empty())
+            return stream.sts;
+
+        stream.pCurrent = stream.loaded.front();
+        stream.loaded.pop_front();
+    }
+    m_cvTaken.notify_all();
+
+    *ppSurface = stream.pCurrent;
+    return MFX_ERR_NONE;
+}
+
+void CParallelInputLoader::LoaderRoutine(mfxU16 streamIndex) {
+    sStream& stream                = *m_Streams[streamIndex];
+    mfxFrameSurfaceWrap* pSurfaces = m_pAllocator->pSurfacesIn[streamIndex];
+    mfxU16 nPoolSize               = m_pAllocator->responseIn[streamIndex].NumFrameActual;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvTaken.wait(lock, [this, &stream]() {
+                return m_bStop || stream.loaded.size() < RING_SIZE;
+            });
+            if (m_bStop)
+                return;
+        }
+
+        // surfaces are released by the library asynchronously, so the pool is polled
+        if (MSDK_INVALID_SURF_IDX == GetFreeSurfaceIndex(pSurfaces, nPoolSize)) {
+            MSDK_SLEEP(1);
+            continue;
+        }
+
+        // only this thread takes surfaces of the stream, so the free one is taken by the reader
+        mfxFrameSurfaceWrap* pSurface = NULL;
+        mfxStatus sts                 = stream.pReader->GetNextInputFrame(m_pAllocator,
+                                                          stream.pFrameInfo,
+                                                          &pSurface,
+                                                          streamIndex);
+        if (MFX_ERR_NONE == sts)
+            msdk_atomic_inc16((volatile mfxU16*)&pSurface->Data.Locked);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (MFX_ERR_NONE == sts)
+                stream.loaded.push_back(pSurface);
+            else
+                stream.sts = sts;
+        }
+        m_cvLoaded.notify_all();
+
+        if (MFX_ERR_NONE != sts)
+            return;
+    }
+}
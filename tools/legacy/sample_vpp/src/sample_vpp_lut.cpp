@@ -0,0 +1,118 @@
+/*############################################################################
+  # Copyright (C) 2022 Intel Corporation
+  #
+  # SPDX-License-Identifier: MIT
+  ############################################################################*/
+
+#include "sample_vpp_lut.h"
+#include "vm/file_defs.h"
+
+C3DLutCache::C3DLutCache()
+        : m_TablesByFile(),
+          m_TablesByHash(),
+          m_numRequests(0),
+          m_numFilesRead(0) {}
+
+mfxStatus C3DLutCache::Get3DLut(const msdk_tstring& strFile, mfxU32 size, mfxExtVPP3DLut* pLut) {
+    MSDK_CHECK_POINTER(pLut, MFX_ERR_NULL_PTR);
+    MSDK_CHECK_ERROR(size, 0, MFX_ERR_INVALID_VIDEO_PARAM);
+
+    m_numRequests++;
+
+    std::shared_ptr<sTable>& pTable = m_TablesByFile[strFile];
+    if (!pTable) {
+        mfxStatus sts = LoadTable(strFile, size, pTable);
+        if (MFX_ERR_NONE != sts) {
+            m_TablesByFile.erase(strFile);
+            return sts;
+        }
+    }
+    MSDK_CHECK_NOT_EQUAL(pTable->size, size, MFX_ERR_INVALID_VIDEO_PARAM);
+
+    pLut->BufferType = MFX_RESOURCE_SYSTEM_SURFACE;
+    for (mfxU32 i = 0; i < 3; i++) {
+        mfxChannel& channel = pLut->SystemBuffer.Channel[i];
+        channel.DataType    = MFX_DATA_TYPE_U16;
+        channel.Size        = pTable->size;
+        channel.Data16      = pTable->channels[i].data();
+    }
+
+    return MFX_ERR_NONE;
+}
+
+mfxStatus C3DLutCache::LoadTable(const msdk_tstring& strFile,
+                                 mfxU32 size,
+                                 std::shared_ptr<sTable>& pTable) {
+    FILE* fLut = NULL;
+    MSDK_FOPEN(fLut, strFile.c_str(), MSDK_STRING("rb"));
+    if (!fLut) {
+        msdk_printf(MSDK_STRING("ERROR: Can't open 3D LUT file %s\n"), strFile.c_str());
+        return MFX_ERR_NOT_FOUND;
+    }
+
+    size_t numNodes = (size_t)size * size * size;
+    std::vector<mfxU16> nodes(numNodes * 3);
+    size_t numRead = fread(nodes.data(), sizeof(mfxU16), nodes.size(), fLut);
+    fclose(fLut);
+    m_numFilesRead++;
+
+    if (numRead != nodes.size()) {
+        msdk_printf(MSDK_STRING("ERROR: 3D LUT file %s is shorter than %dx%dx%d nodes\n"),
+                    strFile.c_str(),
+                    size,
+                    size,
+                    size);
+        return MFX_ERR_MORE_DATA;
+    }
+
+    // FNV-1a
+    mfxU64 hash = 14695981039346656037ULL;
+    for (mfxU16 value : nodes) {
+        hash = (hash ^ (value & 0xFF)) * 1099511628211ULL;
+        hash = (hash ^ (value >> 8)) * 1099511628211ULL;
+    }
+
+    // another file with the same table
+    auto range = m_TablesByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++) {
+        const sTable& table = *it->second;
+        if (table.size != size)
+            continue;
+        bool bEqual = true;
+        for (size_t i = 0; i < numNodes && bEqual; i++) {
+            bEqual = table.channels[0][i] == nodes[3 * i] &&
+                     table.channels[1][i] == nodes[3 * i + 1] &&
+                     table.channels[2][i] == nodes[3 * i + 2];
+        }
+        if (bEqual) {
+            pTable = it->second;
+            return MFX_ERR_NONE;
+        }
+    }
+
+    pTable.reset(new sTable());
+    pTable->size = size;
+    pTable->hash = hash;
+    for (mfxU32 c = 0; c < 3; c++) {
+        pTable->channels[c].resize(numNodes);
+        for (size_t i = 0; i < numNodes; i++)
+            pTable->channels[c][i] = nodes[3 * i + c];
+    }
+    m_TablesByHash.insert(std::make_pair(hash, pTable));
+
+    return MFX_ERR_NONE;
+}
+
+void C3DLutCache::Clear() {
+    m_TablesByFile.clear();
+    m_TablesByHash.clear();
+}
+
+void C3DLutCache::PrintStatistics() const {
+    if (!m_numRequests)
+        return;
+    msdk_printf(MSDK_STRING("3D LUT: %d uses, %d files read, %d tables in memory\n"),
+                m_numRequests,
+                m_numFilesRead,
+                (int)m_TablesByHash.size());
+}
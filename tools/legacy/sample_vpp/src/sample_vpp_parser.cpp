@@ -63,6 +63,15 @@ void vppPrintHelp(const msdk_char* strAppName, const msdk_char* strErrorMessage)
         "   [-dispatcher:fullSearch]    - enable search for all available implementations in oneVPL dispatcher\n"));
     msdk_printf(MSDK_STRING(
         "   [-dispatcher:lowLatency]    - enable limited implementation search and query in oneVPL dispatcher\n"));
+#if !defined(_WIN32) && !defined(_WIN64)
+    msdk_printf(MSDK_STRING("   [-threads_num]              - number of mediasdk task threads\n"));
+    msdk_printf(
+        MSDK_STRING("   [-threads_schedtype]        - scheduling type of mediasdk task threads\n"));
+    msdk_printf(
+        MSDK_STRING("   [-threads_priority]         - priority of mediasdk task threads\n"));
+#endif
+    msdk_printf(MSDK_STRING(
+        "   [-cpu_affinity <cpu-list>]  - run processing and the threads of the CPU implementation on given CPUs, e.g. 0-7,16-23\n"));
 #if defined(D3D_SURFACES_SUPPORT)
     msdk_printf(MSDK_STRING("   [-d3d]                      - use d3d9 surfaces\n\n"));
 #endif
@@ -371,6 +380,8 @@ void vppPrintHelp(const msdk_char* strAppName, const msdk_char* strErrorMessage)
     msdk_printf(MSDK_STRING(
         "   [-dsinr (id)]         - specify YUV nominal range for output surface.\n\n"));
     msdk_printf(MSDK_STRING("   [-mirror (mode)]      - mirror image using specified mode.\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-3dlut size file]    - apply 3D LUT of size^3 nodes from file, a node is three 16-bit values of the output channels. A file is read once, all the parameter sets with the same table share it\n"));
 
     msdk_printf(MSDK_STRING("   [-n frames] - number of frames to VPP process\n\n"));
 
@@ -386,6 +397,8 @@ void vppPrintHelp(const msdk_char* strAppName, const msdk_char* strErrorMessage)
     msdk_printf(MSDK_STRING(
         "   [-pts_fr ]   - input frame rate which used for pts. Default frame_rate = sf \n"));
     msdk_printf(MSDK_STRING("   [-pts_advanced]   - enable FRC checking mode based on PTS \n"));
+    msdk_printf(MSDK_STRING(
+        "   [-frc:stream file] - convert variable frame rate input to -dF frame rate by input time stamps in file (in ms, one per line, Matroska timecode format v2). Frames are dropped or repeated as they come, time stamps of output are distributed with -frc:advanced and kept otherwise. Not supported with -frc:interp, -pts_check, -composite, multi-view, -reset_start, -fanout and -filter_bench\n"));
     msdk_printf(MSDK_STRING(
         "   [-pf file for performance data] -  file to save performance data. Default is off \n\n\n"));
 
@@ -421,6 +434,20 @@ void vppPrintHelp(const msdk_char* strAppName, const msdk_char* strErrorMessage)
     msdk_printf(MSDK_STRING(
         "   [-api_ver_init::<1x,2x>]  - select the api version for the session initialization\n"));
     msdk_printf(MSDK_STRING("   [-rbf] - read frame-by-frame from the input (sw lib only)\n\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-filter_bench] - measure cost of every filter: the preloaded input is processed with the filters added one at a time, fps and us/frame of every run are printed instead of writing output. Requires -perf_opt\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-read_chunk n] - read the input by blocks of n frames instead of row by row\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-alloc_stat] - print memory held by the frame allocator and latencies of its Lock and Unlock at the end\n"));
+#if defined(__linux__)
+    msdk_printf(MSDK_STRING(
+        "   [-direct_io] - read the input bypassing the page cache (O_DIRECT) to measure uncached input, uses -read_chunk 16 if it isn't set\n\n"));
+    msdk_printf(MSDK_STRING(
+        "   [-persistent_map] - keep video memory surfaces mapped between locks instead of deriving and mapping an image on every lock. Only for drivers mapping the surface memory itself\n\n"));
+#endif
+    msdk_printf(MSDK_STRING(
+        "   [-fanout width height file] - additional output of the input frames scaled to the size in color format of -dcc. Input is read and uploaded once for all outputs, filters are applied to the main output only. May be repeated. Not supported with -composite, multi-view, -reset_start, -rbf and -roi_check\n\n"));
     msdk_printf(MSDK_STRING("\n"));
 
     msdk_printf(
@@ -784,6 +811,7 @@ mfxStatus vppParseResetPar(msdk_char* strInput[],
     pParams->videoSignalInfoParam.push_back(*pDefaultFiltersParam->pVideoSignalInfo);
     pParams->mirroringParam.push_back(*pDefaultFiltersParam->pMirroringParam);
     pParams->rotate.push_back(0);
+    pParams->lut3DParam.push_back(s3DLutParam());
     pParams->colorfillParam.push_back(*pDefaultFiltersParam->pColorfillParam);
 
     mfxU32 readData;
@@ -852,6 +880,13 @@ mfxStatus vppParseResetPar(msdk_char* strInput[],
                             MSDK_STRING("%hu"),
                             &pParams->mirroringParam[paramID].Type);
             }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-3dlut"))) {
+                VAL_CHECK(2 + i >= nArgNum);
+                s3DLutParam& lutParam = pParams->lut3DParam[paramID];
+                lutParam.mode         = VPP_FILTER_ENABLED_CONFIGURED;
+                msdk_sscanf(strInput[++i], MSDK_STRING("%u"), &lutParam.size);
+                lutParam.strFile = strInput[++i];
+            }
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-sw"))) {
                 VAL_CHECK(1 + i == nArgNum);
                 i++;
@@ -1278,6 +1313,13 @@ mfxStatus vppParseInputString(msdk_char* strInput[],
                 i++;
                 msdk_sscanf(strInput[i], MSDK_STRING("%hu"), &pParams->mirroringParam[0].Type);
             }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-3dlut"))) {
+                VAL_CHECK(2 + i >= nArgNum);
+                s3DLutParam& lutParam = pParams->lut3DParam[0];
+                lutParam.mode         = VPP_FILTER_ENABLED_CONFIGURED;
+                msdk_sscanf(strInput[++i], MSDK_STRING("%u"), &lutParam.size);
+                lutParam.strFile = strInput[++i];
+            }
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-sw"))) {
                 VAL_CHECK(1 + i == nArgNum);
                 i++;
@@ -1533,6 +1575,10 @@ mfxStatus vppParseInputString(msdk_char* strInput[],
                 pParams->frcParam[0].mode      = VPP_FILTER_ENABLED_CONFIGURED;
                 pParams->frcParam[0].algorithm = MFX_FRCALGM_FRAME_INTERPOLATION;
             }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-frc:stream"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                pParams->strFRCTimeCodesFile = strInput[++i];
+            }
             //---------------------------------------------
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-pa_hue"))) {
                 pParams->procampParam[0].mode = VPP_FILTER_ENABLED_CONFIGURED;
@@ -1743,6 +1789,14 @@ mfxStatus vppParseInputString(msdk_char* strInput[],
                 pParams->strDstFiles.push_back(strInput[i]);
                 pParams->isOutput = true;
             }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-fanout"))) {
+                VAL_CHECK(3 + i >= nArgNum);
+                sFanOutParam fanOutParam = {};
+                msdk_sscanf(strInput[++i], MSDK_STRING("%hu"), &fanOutParam.nWidth);
+                msdk_sscanf(strInput[++i], MSDK_STRING("%hu"), &fanOutParam.nHeight);
+                fanOutParam.strDstFile = strInput[++i];
+                pParams->fanOut.push_back(fanOutParam);
+            }
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-pf"))) {
                 VAL_CHECK(1 + i == nArgNum);
                 i++;
@@ -1948,6 +2002,37 @@ mfxStatus vppParseInputString(msdk_char* strInput[],
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-dispatcher:lowLatency"))) {
                 pParams->dispFullSearch = false;
             }
+#if !defined(_WIN32) && !defined(_WIN64)
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_num"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->nThreadsNum)) {
+                    vppPrintHelp(strInput[0], MSDK_STRING("threads_num is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+            }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_schedtype"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                if (MFX_ERR_NONE !=
+                    msdk_thread_get_schedtype(strInput[++i], pParams->SchedulingType)) {
+                    vppPrintHelp(strInput[0], MSDK_STRING("threads_schedtype is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+            }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-threads_priority"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                if (MFX_ERR_NONE != msdk_opt_read(strInput[++i], pParams->Priority)) {
+                    vppPrintHelp(strInput[0], MSDK_STRING("threads_priority is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+            }
+#endif
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-cpu_affinity"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                if (MFX_ERR_NONE != msdk_parse_cpu_list(strInput[++i], pParams->CpuAffinity)) {
+                    vppPrintHelp(strInput[0], MSDK_STRING("cpu_affinity is invalid"));
+                    return MFX_ERR_UNSUPPORTED;
+                }
+            }
 #if defined(D3D_SURFACES_SUPPORT)
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-d3d"))) {
                 pParams->IOPattern = MFX_IOPATTERN_IN_VIDEO_MEMORY | MFX_IOPATTERN_OUT_VIDEO_MEMORY;
@@ -2040,6 +2125,25 @@ mfxStatus vppParseInputString(msdk_char* strInput[],
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-api_ver_init::2x"))) {
                 pParams->verSessionInit = API_2X;
             }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-filter_bench"))) {
+                pParams->bFilterBench = true;
+            }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-alloc_stat"))) {
+                pParams->bAllocStatistics = true;
+            }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-read_chunk"))) {
+                VAL_CHECK(1 + i == nArgNum);
+                i++;
+                msdk_sscanf(strInput[i], MSDK_STRING("%u"), &pParams->readChunkFrames);
+            }
+#if defined(__linux__)
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-direct_io"))) {
+                pParams->bDirectIO = true;
+            }
+            else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-persistent_map"))) {
+                pParams->bPersistentMapping = true;
+            }
+#endif
             else if (0 == msdk_strcmp(strInput[i], MSDK_STRING("-rbf"))) {
                 pParams->bReadByFrame = true;
             }
@@ -2186,6 +2290,76 @@ bool CheckInputParams(msdk_char* strInput[], sInputParams* pParams) {
         return false;
     }
 
+    if (pParams->bFilterBench &&
+        (!pParams->bPerf || pParams->compositionParam.mode == VPP_FILTER_ENABLED_CONFIGURED ||
+         pParams->multiViewParam[0].mode == VPP_FILTER_ENABLED_CONFIGURED ||
+         !pParams->resetFrmNums.empty() || !pParams->fanOut.empty())) {
+        vppPrintHelp(
+            strInput[0],
+            MSDK_STRING(
+                "-filter_bench requires -perf_opt and isn't supported with -composite, multi-view, -reset_start and -fanout\n"));
+        return false;
+    }
+
+    if (pParams->bDirectIO && !pParams->readChunkFrames) {
+        pParams->readChunkFrames = 16;
+    }
+
+    for (const s3DLutParam& lutParam : pParams->lut3DParam) {
+        if (VPP_FILTER_DISABLED != lutParam.mode && lutParam.size != 17 && lutParam.size != 33 &&
+            lutParam.size != 65) {
+            vppPrintHelp(strInput[0], MSDK_STRING("Invalid -3dlut size: supported 17, 33, 65\n"));
+            return false;
+        }
+    }
+
+    for (const sFanOutParam& fanOutParam : pParams->fanOut) {
+        if (!fanOutParam.nWidth || !fanOutParam.nHeight) {
+            vppPrintHelp(strInput[0], MSDK_STRING("Invalid -fanout size\n"));
+            return false;
+        }
+    }
+
+    if (!pParams->fanOut.empty() &&
+        (pParams->compositionParam.mode == VPP_FILTER_ENABLED_CONFIGURED ||
+         pParams->multiViewParam[0].mode == VPP_FILTER_ENABLED_CONFIGURED ||
+         !pParams->resetFrmNums.empty() || pParams->bReadByFrame ||
+         pParams->roiCheckParam.mode != ROI_FIX_TO_FIX)) {
+        vppPrintHelp(
+            strInput[0],
+            MSDK_STRING(
+                "-fanout is not supported with -composite, multi-view, -reset_start, -rbf and -roi_check\n"));
+        return false;
+    }
+
+    if (!pParams->strFRCTimeCodesFile.empty()) {
+        bool bAdvanced = pParams->frcParam[0].mode == VPP_FILTER_ENABLED_CONFIGURED;
+        if ((bAdvanced && MFX_FRCALGM_DISTRIBUTED_TIMESTAMP != pParams->frcParam[0].algorithm) ||
+            pParams->ptsCheck ||
+            pParams->compositionParam.mode == VPP_FILTER_ENABLED_CONFIGURED ||
+            pParams->multiViewParam[0].mode == VPP_FILTER_ENABLED_CONFIGURED ||
+            !pParams->resetFrmNums.empty() || !pParams->fanOut.empty() || pParams->bFilterBench) {
+            vppPrintHelp(
+                strInput[0],
+                MSDK_STRING(
+                    "-frc:stream is not supported with -frc:interp, -pts_check, -composite, multi-view, -reset_start, -fanout and -filter_bench\n"));
+            return false;
+        }
+        // frames are dropped and repeated by the application, VPP processes them one to one
+        pParams->frcStreamAlgorithm =
+            bAdvanced ? MFX_FRCALGM_DISTRIBUTED_TIMESTAMP : MFX_FRCALGM_PRESERVE_TIMESTAMP;
+        pParams->frcParam[0].mode = VPP_FILTER_DISABLED;
+    }
+
+    // each input of the composition is loaded by a thread of its own where the allocator allows
+    // locking surfaces concurrently, PTS of the frames are checked in loading order
+    pParams->bParallelLoad =
+        pParams->compositionParam.mode == VPP_FILTER_ENABLED_CONFIGURED &&
+        pParams->numStreams > 1 && !pParams->bPerf && !pParams->bReadByFrame &&
+        !pParams->ptsCheck && pParams->resetFrmNums.empty() &&
+        (!(pParams->IOPattern & MFX_IOPATTERN_IN_VIDEO_MEMORY) ||
+         (pParams->ImpLib & IMPL_VIA_MASK) == MFX_IMPL_VIA_VAAPI);
+
     return true;
 } // bool CheckInputParams(msdk_char* strInput[], sInputVppParams* pParams )
 
@@ -10,6 +10,8 @@
 #include "vpl/mfxvideo++.h"
 #include "vpl_implementation_loader.h"
 
+#include "sample_vpp_fanout.h"
+#include "sample_vpp_input_loader.h"
 #include "sample_vpp_pts.h"
 
 #include "sysmem_allocator.h"
@@ -30,6 +32,11 @@
 
 #endif
 
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
 #include <algorithm>
 #include "general_allocator.h"
 #include "vpl/mfxdispatcher.h"
@@ -227,6 +234,15 @@ void PrintInfo(sInputParams* pParams, mfxVideoParam* pMfxParams, MFXVideoSession
             msdk_printf(MSDK_STRING("FRC:\t\tON\n"));
         }
     }
+    if (VPP_FILTER_DISABLED != pParams->lut3DParam[0].mode) {
+        msdk_printf(MSDK_STRING("3DLut\t\t%s\n"), pParams->lut3DParam[0].strFile.c_str());
+    }
+    if (!pParams->strFRCTimeCodesFile.empty()) {
+        msdk_printf(MSDK_STRING("FRC:Stream\t%s\n"),
+                    (MFX_FRCALGM_DISTRIBUTED_TIMESTAMP == pParams->frcStreamAlgorithm)
+                        ? MSDK_STRING("AdvancedPTS")
+                        : MSDK_STRING("ON"));
+    }
     //msdk_printf(MSDK_STRING("FRC:Advanced\t%s\n"),   (VPP_FILTER_DISABLED != pParams->frcParam.mode)  ? MSDK_STRING("ON"): MSDK_STRING("OFF"));
     // MSDK 3.0
     msdk_printf(MSDK_STRING("GamutMapping \t%s\n"),
@@ -537,6 +553,12 @@ mfxStatus CreateFrameProcessor(sFrameProcessor* pProcessor,
 
     WipeFrameProcessor(pProcessor);
 
+    // threads of the CPU implementation inherit the affinity of the thread creating the session
+    if (!pInParams->CpuAffinity.empty()) {
+        sts = msdk_thread_set_affinity(pInParams->CpuAffinity);
+        MSDK_CHECK_STATUS(sts, "msdk_thread_set_affinity failed");
+    }
+
     //MFX session
     if (pInParams->verSessionInit == API_1X) {
 #if (defined(_WIN64) || defined(_WIN32)) && (MFX_VERSION >= 1031)
@@ -550,7 +572,14 @@ mfxStatus CreateFrameProcessor(sFrameProcessor* pProcessor,
         initParams.Implementation  = impl;
         initParams.Version         = version;
         initParams.NumExtParam     = 0;
-        sts                        = pProcessor->mfxSession.InitEx(initParams);
+        if (pInParams->nThreadsNum || pInParams->SchedulingType || pInParams->Priority) {
+            auto threadsPar = initParams.AddExtBuffer<mfxExtThreadsParam>();
+            MSDK_CHECK_POINTER(threadsPar, MFX_ERR_MEMORY_ALLOC);
+            threadsPar->NumThread      = pInParams->nThreadsNum;
+            threadsPar->SchedulingType = pInParams->SchedulingType;
+            threadsPar->Priority       = pInParams->Priority;
+        }
+        sts = pProcessor->mfxSession.InitEx(initParams);
 
         MSDK_CHECK_STATUS_SAFE(sts, "pProcessor->mfxSession.Init failed", {
             WipeFrameProcessor(pProcessor);
@@ -567,6 +596,11 @@ mfxStatus CreateFrameProcessor(sFrameProcessor* pProcessor,
         if (pInParams->adapterNum >= 0)
             pProcessor->pLoader->SetAdapterNum(pInParams->adapterNum);
 
+        sts = pProcessor->pLoader->ConfigureThreads(pInParams->nThreadsNum,
+                                                    pInParams->SchedulingType,
+                                                    pInParams->Priority);
+        MSDK_CHECK_STATUS(sts, "pLoader->ConfigureThreads failed");
+
 #ifdef ONEVPL_EXPERIMENTAL
         if (pInParams->PCIDeviceSetup)
             pProcessor->pLoader->SetPCIDevice(pInParams->PCIDomain,
@@ -663,7 +697,10 @@ mfxStatus InitMemoryAllocator(sFrameProcessor* pProcessor,
 
     MSDK_ZERO_MEMORY(request);
 
-    pAllocator->pMfxAllocator = new GeneralAllocator;
+    GeneralAllocator* pGeneralAllocator = new GeneralAllocator;
+    pGeneralAllocator->SetLockTiming(pInParams->bAllocStatistics);
+    pAllocator->pMfxAllocator    = pGeneralAllocator;
+    pAllocator->bPrintStatistics = pInParams->bAllocStatistics;
 
     bool isHWLib = (MFX_IMPL_HARDWARE & pInParams->ImpLib) ? true : false;
 
@@ -756,8 +793,9 @@ mfxStatus InitMemoryAllocator(sFrameProcessor* pProcessor,
             // prepare allocator
             vaapiAllocatorParams* pVaapiAllocParams = new vaapiAllocatorParams;
 
-            pVaapiAllocParams->m_dpy     = (VADisplay)hdl;
-            pAllocator->pAllocatorParams = pVaapiAllocParams;
+            pVaapiAllocParams->m_dpy                = (VADisplay)hdl;
+            pVaapiAllocParams->m_persistent_mapping = pInParams->bPersistentMapping;
+            pAllocator->pAllocatorParams            = pVaapiAllocParams;
 
 #endif
         }
@@ -821,13 +859,21 @@ mfxStatus InitMemoryAllocator(sFrameProcessor* pProcessor,
     // If we have only one input stream - allocate as many surfaces as were requested. Otherwise (in case of composition) - allocate 1 surface per input
     // Modify frame info as well
     if (pInParams->compositionParam.mode != VPP_FILTER_ENABLED_CONFIGURED) {
+        // input frames are also held by the fan-out outputs until their frames are written
+        if (!pInParams->fanOut.empty())
+            request[VPP_IN].NumFrameSuggested += pInParams->asyncNum;
+
         sts = InitSurfaces(pAllocator, &(request[VPP_IN]), true, 0);
         MSDK_CHECK_STATUS_SAFE(sts, "InitSurfaces failed", WipeMemoryAllocator(pAllocator));
     }
     else {
         for (int i = 0; i < pInParams->numStreams; i++) {
             ownToMfxFrameInfo(&pInParams->inFrameInfo[i], &request[VPP_IN].Info, true);
-            request[VPP_IN].NumFrameSuggested = 1;
+            // parallel loading keeps frames loaded ahead of the ones in processing
+            request[VPP_IN].NumFrameSuggested =
+                pInParams->bParallelLoad
+                    ? (mfxU16)(CParallelInputLoader::RING_SIZE + pInParams->asyncNum + 1)
+                    : 1;
             request[VPP_IN].NumFrameMin       = request[VPP_IN].NumFrameSuggested;
             sts = InitSurfaces(pAllocator, &(request[VPP_IN]), true, i);
             MSDK_CHECK_STATUS_SAFE(sts, "InitSurfaces failed", WipeMemoryAllocator(pAllocator));
@@ -917,6 +963,11 @@ void WipeMemoryAllocator(sMemoryAllocator* pAllocator) {
         }
     }
 
+    BaseFrameAllocator* pBaseAllocator =
+        dynamic_cast<BaseFrameAllocator*>(pAllocator->pMfxAllocator);
+    if (pAllocator->bPrintStatistics && pBaseAllocator)
+        pBaseAllocator->PrintStatistics();
+
     // delete allocator
     MSDK_SAFE_DELETE(pAllocator->pMfxAllocator);
     MSDK_SAFE_DELETE(pAllocator->pDevice);
@@ -936,6 +987,14 @@ void WipeConfigParam(sAppResources* pResources) {
 void WipeResources(sAppResources* pResources) {
     MSDK_CHECK_POINTER_NO_RET(pResources);
 
+    // sessions of the fan-out are cloned from the main one and use its allocator
+    if (pResources->pFanOut)
+        pResources->pFanOut->Close();
+
+    // loader threads lock surfaces of the allocator
+    if (pResources->pInputLoader)
+        pResources->pInputLoader->Close();
+
     WipeFrameProcessor(pResources->pProcessor);
 
     WipeMemoryAllocator(pResources->pAllocator);
@@ -975,8 +1034,17 @@ void WipeParams(sInputParams* pParams) {
 
 /* ******************************************************************* */
 
+// direct IO needs the buffer, the size and the file offset of reads aligned to the block size
+static const mfxU32 READ_CHUNK_ALIGNMENT = 4096;
+
 CRawVideoReader::CRawVideoReader()
         : m_fSrc(NULL),
+          m_fdDirect(-1),
+          m_ChunkBuffer(),
+          m_pChunk(NULL),
+          m_chunkSize(0),
+          m_chunkFilled(0),
+          m_chunkPos(0),
           m_it(),
           m_SurfacesList(),
           m_isPerfMode(false),
@@ -984,13 +1052,37 @@ CRawVideoReader::CRawVideoReader()
           m_pPTSMaker(NULL),
           m_initFcc(0) {}
 
-mfxStatus CRawVideoReader::Init(const msdk_char* strFileName, PTSMaker* pPTSMaker, mfxU32 fcc) {
+mfxStatus CRawVideoReader::Init(const msdk_char* strFileName,
+                                PTSMaker* pPTSMaker,
+                                mfxU32 fcc,
+                                mfxU32 chunkSize,
+                                bool bDirectIO) {
     Close();
 
     MSDK_CHECK_POINTER(strFileName, MFX_ERR_NULL_PTR);
 
-    MSDK_FOPEN(m_fSrc, strFileName, MSDK_STRING("rb"));
-    MSDK_CHECK_POINTER(m_fSrc, MFX_ERR_ABORTED);
+    if (bDirectIO) {
+#if defined(__linux__)
+        MSDK_CHECK_ERROR(chunkSize, 0, MFX_ERR_INVALID_VIDEO_PARAM);
+        m_fdDirect = open(strFileName, O_RDONLY | O_DIRECT);
+        if (m_fdDirect < 0) {
+            msdk_printf(MSDK_STRING("error: can't open \"%s\" for direct IO\n"), strFileName);
+            return MFX_ERR_ABORTED;
+        }
+#else
+        return MFX_ERR_UNSUPPORTED;
+#endif
+    }
+    else {
+        MSDK_FOPEN(m_fSrc, strFileName, MSDK_STRING("rb"));
+        MSDK_CHECK_POINTER(m_fSrc, MFX_ERR_ABORTED);
+    }
+
+    if (chunkSize) {
+        m_chunkSize = (mfxU32)MSDK_ALIGN(chunkSize, READ_CHUNK_ALIGNMENT);
+        m_ChunkBuffer.resize(m_chunkSize + READ_CHUNK_ALIGNMENT);
+        m_pChunk = (mfxU8*)(MSDK_ALIGN((size_t)m_ChunkBuffer.data(), READ_CHUNK_ALIGNMENT));
+    }
 
     m_pPTSMaker = pPTSMaker;
     m_initFcc   = fcc;
@@ -1006,9 +1098,52 @@ void CRawVideoReader::Close() {
         fclose(m_fSrc);
         m_fSrc = 0;
     }
+#if defined(__linux__)
+    if (m_fdDirect >= 0) {
+        close(m_fdDirect);
+        m_fdDirect = -1;
+    }
+#endif
+    m_ChunkBuffer.clear();
+    m_pChunk      = NULL;
+    m_chunkSize   = 0;
+    m_chunkFilled = 0;
+    m_chunkPos    = 0;
     m_SurfacesList.clear();
 }
 
+mfxU32 CRawVideoReader::Read(mfxU8* pDst, mfxU32 size) {
+    if (!m_chunkSize)
+        return (mfxU32)fread(pDst, 1, size, m_fSrc);
+
+    mfxU32 nRead = 0;
+    while (nRead < size) {
+        if (m_chunkPos == m_chunkFilled && !FillChunk())
+            break;
+
+        mfxU32 nCopy = std::min(size - nRead, m_chunkFilled - m_chunkPos);
+        memcpy(pDst + nRead, m_pChunk + m_chunkPos, nCopy);
+        m_chunkPos += nCopy;
+        nRead += nCopy;
+    }
+    return nRead;
+}
+
+bool CRawVideoReader::FillChunk() {
+    m_chunkPos    = 0;
+    m_chunkFilled = 0;
+#if defined(__linux__)
+    if (m_fdDirect >= 0) {
+        ssize_t nRead = read(m_fdDirect, m_pChunk, m_chunkSize);
+        if (nRead > 0)
+            m_chunkFilled = (mfxU32)nRead;
+        return m_chunkFilled > 0;
+    }
+#endif
+    m_chunkFilled = (mfxU32)fread(m_pChunk, 1, m_chunkSize, m_fSrc);
+    return m_chunkFilled > 0;
+}
+
 mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInfo) {
     MSDK_CHECK_POINTER(pData, MFX_ERR_NOT_INITIALIZED);
     MSDK_CHECK_POINTER(pInfo, MFX_ERR_NOT_INITIALIZED);
@@ -1040,7 +1175,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1051,14 +1186,14 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = (pInfo->FourCC == MFX_FOURCC_I420 ? pData->U : pData->V) + (pInfo->CropX >> 1) +
               (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V/U
         ptr = (pInfo->FourCC == MFX_FOURCC_I420 ? pData->V : pData->U) + (pInfo->CropX >> 1) +
               (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1067,7 +1202,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1076,7 +1211,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1085,13 +1220,13 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         // load U
         ptr = pData->U + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V
         ptr = pData->V + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1100,7 +1235,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1109,13 +1244,13 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         // load U
         ptr = pData->U + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V
         ptr = pData->V + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1124,7 +1259,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1133,13 +1268,13 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         // load U
         ptr = pData->U + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V
         ptr = pData->V + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1148,20 +1283,20 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
         // load U
         ptr = pData->U + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V
         ptr = pData->V + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1170,7 +1305,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1180,7 +1315,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
                 h >>= 1;
                 ptr = pData->UV + pInfo->CropX + (pInfo->CropY >> 1) * pitch;
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+                    nBytesRead = Read(ptr + i * pitch, w);
                     IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
                 }
                 break;
@@ -1207,7 +1342,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
                 // load first chroma plane: U (input == I420) or V (input == YV12)
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(buf, 1, w, m_fSrc);
+                    nBytesRead = Read(buf, w);
                     if (w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
                     }
@@ -1218,7 +1353,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
                 // load second chroma plane: V (input == I420) or U (input == YV12)
                 for (i = 0; i < h; i++) {
-                    nBytesRead = (mfxU32)fread(buf, 1, w, m_fSrc);
+                    nBytesRead = Read(buf, w);
 
                     if (w != nBytesRead) {
                         return MFX_ERR_MORE_DATA;
@@ -1236,14 +1371,14 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
         // load UV
         ptr = pData->UV + pInfo->CropX + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1252,7 +1387,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w * 2, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w * 2);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w * 2, MFX_ERR_MORE_DATA);
         }
 
@@ -1262,14 +1397,14 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         // load U
         ptr = pData->U;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
         // load V
         ptr = pData->V;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1278,7 +1413,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w * 2, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w * 2);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w * 2, MFX_ERR_MORE_DATA);
         }
 
@@ -1286,7 +1421,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         h >>= 1;
         ptr = pData->UV + pInfo->CropX + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w * 2, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w * 2);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w * 2, MFX_ERR_MORE_DATA);
         }
     }
@@ -1295,14 +1430,14 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w * 2, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w * 2);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w * 2, MFX_ERR_MORE_DATA);
         }
 
         // load UV
         ptr = pData->UV + pInfo->CropX + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w * 2, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w * 2);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w * 2, MFX_ERR_MORE_DATA);
         }
     }
@@ -1315,7 +1450,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = ptr + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 2 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 2 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 2 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1328,7 +1463,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = ptr + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 3 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 3 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 3 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1343,7 +1478,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = ptr + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 4 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 4 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1351,7 +1486,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = pData->Y + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 2 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 2 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 2 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1359,7 +1494,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = pData->U + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 2 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 2 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 2 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1368,7 +1503,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
 
         // read luminance plane
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
 
@@ -1377,13 +1512,13 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         // load U
         ptr = pData->V + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
         // load V
         ptr = pData->U + (pInfo->CropX >> 1) + (pInfo->CropY >> 1) * pitch;
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1392,7 +1527,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = ptr + pInfo->CropX + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 4 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 4 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1401,7 +1536,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = (mfxU8*)(pData->Y16 + pInfo->CropX * 2) + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 4 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 4 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1409,7 +1544,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = (mfxU8*)(pData->Y410 + pInfo->CropX) + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 4 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 4 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 4 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1417,7 +1552,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameData* pData, mfxFrameInfo* pInf
         ptr = (mfxU8*)(pData->U16 + pInfo->CropX * 4) + pInfo->CropY * pitch;
 
         for (i = 0; i < h; i++) {
-            nBytesRead = (mfxU32)fread(ptr + i * pitch, 1, 8 * w, m_fSrc);
+            nBytesRead = Read(ptr + i * pitch, 8 * w);
             IOSTREAM_MSDK_CHECK_NOT_EQUAL(nBytesRead, 8 * w, MFX_ERR_MORE_DATA);
         }
     }
@@ -1434,7 +1569,7 @@ mfxStatus CRawVideoReader::LoadNextFrame(mfxFrameSurface1* pSurface,
     // check if reader is initialized
     MSDK_CHECK_POINTER(pSurface, MFX_ERR_NULL_PTR);
 
-    int nBytesRead = static_cast<int>(fread(buf_read, 1, bytes_to_read, m_fSrc));
+    int nBytesRead = static_cast<int>(Read(buf_read, bytes_to_read));
 
     if (bytes_to_read != nBytesRead) {
         return MFX_ERR_MORE_DATA;
@@ -1565,6 +1700,11 @@ mfxStatus CRawVideoReader::GetPreAllocFrame(mfxFrameSurfaceWrap** pSurface) {
     return MFX_ERR_NONE;
 }
 
+void CRawVideoReader::RewindPreAllocFrames(mfxU16 nRepeat) {
+    m_it     = m_SurfacesList.begin();
+    m_Repeat = nRepeat;
+}
+
 mfxStatus CRawVideoReader::PreAllocateFrameChunk(mfxVideoParam* pVideoParam,
                                                  sInputParams* pParams,
                                                  MFXFrameAllocator* pAllocator) {